@@ -0,0 +1,262 @@
+#!/usr/bin/python
+
+
+#
+# This source file is part of appleseed.
+# Visit https://appleseedhq.net/ for additional information and resources.
+#
+# This software is released under the MIT license.
+#
+# Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+
+from __future__ import print_function
+import argparse
+import glob
+import os
+import re
+import subprocess
+import sys
+import xml.dom.minidom as xml
+
+
+# -------------------------------------------------------------------------------------------------
+# Constants.
+# -------------------------------------------------------------------------------------------------
+
+VERSION = "1.0"
+RENDERS_DIR = "_renders"
+FRAGMENT_INFIX = ".fragment-"
+DEFAULT_TOOL_FILENAME = "oiiotool.exe" if os.name == "nt" else "oiiotool"
+
+
+# -------------------------------------------------------------------------------------------------
+# Utility functions.
+# -------------------------------------------------------------------------------------------------
+
+def fatal(msg):
+    print("error: {0}".format(msg))
+    sys.exit(1)
+
+
+def get_frame_element(document):
+    frames = document.getElementsByTagName("frame")
+    if len(frames) == 0:
+        fatal("project has no frame.")
+    return frames[0]
+
+
+def get_parameter(element, name):
+    for child in element.childNodes:
+        if child.nodeType == xml.Node.ELEMENT_NODE and child.tagName == "parameter" and \
+           child.getAttribute("name") == name:
+            return child
+    return None
+
+
+def set_parameter(document, element, name, value):
+    parameter = get_parameter(element, name)
+    if parameter is None:
+        parameter = document.createElement("parameter")
+        parameter.setAttribute("name", name)
+        element.appendChild(parameter)
+    parameter.setAttribute("value", value)
+
+
+def fragment_filepath(project_filepath, fragment_index):
+    base, extension = os.path.splitext(project_filepath)
+    return "{0}{1}{2:04}{3}".format(base, FRAGMENT_INFIX, fragment_index, extension)
+
+
+# -------------------------------------------------------------------------------------------------
+# Splitting logic.
+# -------------------------------------------------------------------------------------------------
+
+def compute_tile_windows(crop_window, tile_count_x, tile_count_y):
+    min_x, min_y, max_x, max_y = crop_window
+    width = max_x - min_x + 1
+    height = max_y - min_y + 1
+
+    windows = []
+
+    for ty in range(tile_count_y):
+        y0 = min_y + ty * height // tile_count_y
+        y1 = min_y + (ty + 1) * height // tile_count_y - 1
+        for tx in range(tile_count_x):
+            x0 = min_x + tx * width // tile_count_x
+            x1 = min_x + (tx + 1) * width // tile_count_x - 1
+            if x0 <= x1 and y0 <= y1:
+                windows.append((x0, y0, x1, y1))
+
+    return windows
+
+
+def split_project(args):
+    with open(args.project, "r") as file:
+        contents = file.read()
+
+    document = xml.parseString(contents)
+    frame = get_frame_element(document)
+
+    resolution = get_parameter(frame, "resolution")
+    if resolution is None:
+        fatal("frame has no resolution.")
+    width, height = [int(x) for x in resolution.getAttribute("value").split()]
+
+    # Fragments never render outside of the existing crop window.
+    crop_window_parameter = get_parameter(frame, "crop_window")
+    if crop_window_parameter is not None:
+        crop_window = tuple(int(x) for x in crop_window_parameter.getAttribute("value").split())
+    else:
+        crop_window = (0, 0, width - 1, height - 1)
+
+    noise_seed_parameter = get_parameter(frame, "noise_seed")
+    base_noise_seed = int(noise_seed_parameter.getAttribute("value")) if noise_seed_parameter is not None else 0
+
+    if args.seeds is not None:
+        # Every fragment renders the whole frame with a different noise seed.
+        fragments = [(crop_window, base_noise_seed + i) for i in range(args.seeds)]
+    else:
+        tile_count_x, tile_count_y = args.tiles
+        fragments = [(window, base_noise_seed)
+                     for window in compute_tile_windows(crop_window, tile_count_x, tile_count_y)]
+
+    # Fragments are written next to the original project so that relative asset paths remain valid.
+    for fragment_index, (window, noise_seed) in enumerate(fragments):
+        set_parameter(document, frame, "crop_window", " ".join(str(x) for x in window))
+        set_parameter(document, frame, "noise_seed", str(noise_seed))
+
+        filepath = fragment_filepath(args.project, fragment_index)
+        with open(filepath + ".tmp", "w") as file:
+            file.write(document.toxml())
+
+        # Render nodes only pick up .appleseed files: make each fragment visible atomically.
+        if os.path.exists(filepath):
+            os.remove(filepath)
+        os.rename(filepath + ".tmp", filepath)
+
+    print("split {0} into {1} fragment(s).".format(args.project, len(fragments)))
+
+
+# -------------------------------------------------------------------------------------------------
+# Merging logic.
+# -------------------------------------------------------------------------------------------------
+
+def merge_fragments(args):
+    stem = os.path.splitext(os.path.basename(args.project))[0]
+    pattern = os.path.join(args.renders_directory, stem + FRAGMENT_INFIX + "*." + args.format)
+    fragment_regex = re.compile(re.escape(stem + FRAGMENT_INFIX) + r"(\d+)\." + re.escape(args.format) + "$")
+
+    # Sort fragments by index so that the merge is deterministic.
+    fragment_files = []
+    for filepath in glob.glob(pattern):
+        match = fragment_regex.match(os.path.basename(filepath))
+        if match:
+            fragment_files.append((int(match.group(1)), filepath))
+    fragment_files.sort()
+
+    if len(fragment_files) == 0:
+        fatal("no rendered fragment found matching {0}.".format(pattern))
+
+    if args.expected is not None and len(fragment_files) != args.expected:
+        fatal("found {0} rendered fragment(s), expected {1}.".format(len(fragment_files), args.expected))
+
+    # Tile fragments are black outside of their crop window: summing them reassembles the frame.
+    # Seed fragments are independent estimates of the whole frame: their average is the result.
+    command = [args.tool_path, fragment_files[0][1]]
+    for _, filepath in fragment_files[1:]:
+        command += [filepath, "--add"]
+    if args.average:
+        command += ["--divc", str(len(fragment_files))]
+    command += ["-o", args.output]
+
+    if subprocess.call(command) != 0:
+        fatal("failed to merge fragments into {0}.".format(args.output))
+
+    print("merged {0} fragment(s) into {1}.".format(len(fragment_files), args.output))
+
+
+# -------------------------------------------------------------------------------------------------
+# Entry point.
+# -------------------------------------------------------------------------------------------------
+
+def parse_tiles(value):
+    match = re.match(r"^(\d+)x(\d+)$", value)
+    if not match or int(match.group(1)) == 0 or int(match.group(2)) == 0:
+        raise argparse.ArgumentTypeError("tile grid must be of the form COLUMNSxROWS (e.g. 4x4)")
+    return int(match.group(1)), int(match.group(2))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="split a single frame into fragments rendered by "
+                                     "multiple render nodes (see rendernode.py), then merge the "
+                                     "rendered fragments back into a single image.")
+    subparsers = parser.add_subparsers(dest="command")
+
+    split_parser = subparsers.add_parser("split", help="write one project file per fragment, "
+                                         "next to the original project file")
+    group = split_parser.add_mutually_exclusive_group()
+    group.add_argument("-t", "--tiles", metavar="COLUMNSxROWS", type=parse_tiles, default=(4, 4),
+                       help="split the frame into a grid of crop windows (default: 4x4)")
+    group.add_argument("-s", "--seeds", metavar="COUNT", type=int,
+                       help="render the whole frame COUNT times with distinct noise seeds "
+                       "(divide the sample count accordingly)")
+    split_parser.add_argument("project", help="project file to split")
+
+    merge_parser = subparsers.add_parser("merge", help="merge rendered fragments into a single image")
+    merge_parser.add_argument("-t", "--tool-path", metavar="tool-path",
+                              help="set the path to the oiiotool tool")
+    merge_parser.add_argument("-r", "--renders", dest="renders_directory", metavar="DIR",
+                              help="directory containing the rendered fragments "
+                              "(default: " + RENDERS_DIR + " next to the project file)")
+    merge_parser.add_argument("-f", "--format", metavar="FORMAT", default="exr",
+                              help="format of the rendered fragments (default: exr)")
+    merge_parser.add_argument("-a", "--average", action="store_true",
+                              help="average the fragments (for fragments created with --seeds)")
+    merge_parser.add_argument("-e", "--expected", metavar="COUNT", type=int,
+                              help="fail unless exactly COUNT fragments have been rendered")
+    merge_parser.add_argument("-o", "--output", metavar="FILE", required=True,
+                              help="set the path to the merged image")
+    merge_parser.add_argument("project", help="original (unsplit) project file")
+
+    args = parser.parse_args()
+
+    if args.command == "split":
+        if args.seeds is not None and args.seeds <= 0:
+            fatal("the number of seeds must be positive.")
+        split_project(args)
+    elif args.command == "merge":
+        # If no tool path is provided, search for the tool in the same directory as this script.
+        if args.tool_path is None:
+            script_directory = os.path.dirname(os.path.realpath(__file__))
+            args.tool_path = os.path.join(script_directory, DEFAULT_TOOL_FILENAME)
+            print("setting tool path to {0}.".format(args.tool_path))
+
+        if args.renders_directory is None:
+            args.renders_directory = os.path.join(os.path.dirname(os.path.abspath(args.project)), RENDERS_DIR)
+
+        merge_fragments(args)
+    else:
+        parser.print_help()
+
+
+if __name__ == "__main__":
+    main()
@@ -69,12 +69,24 @@ CommandLineHandler::CommandLineHandler()
             .set_flags(OptionHandler::Repeatable)
             .set_exact_value_count(1));
 
+    parser().add_option_handler(
+        &m_texture_cache
+            .add_name("--texture-cache")
+            .set_description("convert untiled or unmipmapped texture files to tiled, mipmapped files stored in this directory")
+            .set_syntax("directory")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_search_path_cache
+            .add_name("--search-path-cache")
+            .set_description("resolve project files from directory listings cached next to the project file"));
+
     parser().add_option_handler(
         &m_threads
             .add_name("--threads")
             .add_name("-t")
-            .set_description("set the number of rendering threads")
-            .set_syntax("n")
+            .set_description("set the number of rendering threads, optionally followed by the thread affinity (core or numa)")
+            .set_syntax("n[:core|:numa]")
             .set_exact_value_count(1));
 
     parser().add_option_handler(
@@ -136,6 +148,27 @@ CommandLineHandler::CommandLineHandler()
             .set_syntax("regex")
             .set_exact_value_count(1));
 
+    parser().add_option_handler(
+        &m_frames
+            .add_name("--frames")
+            .set_description("render a sequence of frames in a single session; '#' characters in the project and output file names are replaced by the frame number")
+            .set_syntax("first last")
+            .set_exact_value_count(2));
+
+    parser().add_option_handler(
+        &m_server
+            .add_name("--server")
+            .set_description("run as a render server accepting render requests on a local port")
+            .set_syntax("port")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_server_memory_budget
+            .add_name("--server-memory-budget")
+            .set_description("release least recently rendered projects when the server uses more memory than this")
+            .set_syntax("megabytes")
+            .set_exact_value_count(1));
+
     parser().add_option_handler(
         &m_output.add_name("--output")
             .add_name("-o")
@@ -171,6 +204,13 @@ CommandLineHandler::CommandLineHandler()
             .add_name("--to-stdout")
             .set_description("send render to standard output"));
 
+    parser().add_option_handler(
+        &m_send_to_shared_memory
+            .add_name("--to-shared-memory")
+            .set_description("publish render into a named shared memory framebuffer")
+            .set_syntax("name")
+            .set_exact_value_count(1));
+
     parser().add_option_handler(
         &m_save_light_paths
             .add_name("--save-light-paths")
@@ -178,6 +218,20 @@ CommandLineHandler::CommandLineHandler()
             .set_syntax("filename")
             .set_exact_value_count(1));
 
+    parser().add_option_handler(
+        &m_save_trace
+            .add_name("--save-trace")
+            .set_description("record a trace of per-thread render phases and save it to disk in Chrome trace format")
+            .set_syntax("filename")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_metrics
+            .add_name("--metrics")
+            .set_description("periodically write live rendering metrics to disk in Prometheus text format")
+            .set_syntax("filename")
+            .set_exact_value_count(1));
+
     parser().add_option_handler(
         &m_disable_autosave
             .add_name("--disable-autosave")
@@ -209,6 +263,27 @@ CommandLineHandler::CommandLineHandler()
         &m_benchmark_mode
             .add_name("--benchmark-mode")
             .set_description("enable benchmark mode"));
+
+    parser().add_option_handler(
+        &m_benchmark_scenes
+            .add_name("--benchmark-scenes")
+            .set_description("render each project and report per-phase timings, ray throughput and peak memory usage")
+            .set_syntax("project.appleseed...")
+            .set_min_value_count(1));
+
+    parser().add_option_handler(
+        &m_benchmark_baseline
+            .add_name("--benchmark-baseline")
+            .set_description("compare scene benchmark render times against a previous scene benchmark results file")
+            .set_syntax("filename")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_benchmark_tolerance
+            .add_name("--benchmark-tolerance")
+            .set_description("set the slowdown, in percents, above which a scene benchmark is considered to have regressed (default is 5)")
+            .set_syntax("percent")
+            .set_exact_value_count(1));
 }
 
 void CommandLineHandler::print_program_usage(
@@ -59,6 +59,8 @@ class CommandLineHandler
     // General options.
     foundation::ValueOptionHandler<std::string>         m_configuration;
     foundation::ValueOptionHandler<std::string>         m_params;
+    foundation::ValueOptionHandler<std::string>         m_texture_cache;
+    foundation::FlagOptionHandler                       m_search_path_cache;
 
     // Aliases for rendering options.
     foundation::ValueOptionHandler<std::string>         m_threads;  // std::string because we need to handle 'auto'
@@ -71,6 +73,13 @@ class CommandLineHandler
     foundation::ValueOptionHandler<std::string>         m_show_object_instances;
     foundation::ValueOptionHandler<std::string>         m_hide_object_instances;
 
+    // Sequence options.
+    foundation::ValueOptionHandler<int>                 m_frames;
+
+    // Server options.
+    foundation::ValueOptionHandler<int>                 m_server;
+    foundation::ValueOptionHandler<int>                 m_server_memory_budget;
+
     // Output options.
     foundation::ValueOptionHandler<std::string>         m_output;
 #if defined __APPLE__ || defined _WIN32
@@ -79,14 +88,20 @@ class CommandLineHandler
     foundation::ValueOptionHandler<std::string>         m_checkpoint_create;
     foundation::ValueOptionHandler<std::string>         m_checkpoint_resume;
     foundation::FlagOptionHandler                       m_send_to_stdout;
+    foundation::ValueOptionHandler<std::string>         m_send_to_shared_memory;
     foundation::FlagOptionHandler                       m_disable_autosave;
     foundation::ValueOptionHandler<std::string>         m_save_light_paths;
+    foundation::ValueOptionHandler<std::string>         m_save_trace;
+    foundation::ValueOptionHandler<std::string>         m_metrics;
 
     // Developer-oriented options.
     foundation::ValueOptionHandler<std::string>         m_run_unit_tests;
     foundation::ValueOptionHandler<std::string>         m_run_unit_benchmarks;
     foundation::FlagOptionHandler                       m_verbose_unit_tests;
     foundation::FlagOptionHandler                       m_benchmark_mode;
+    foundation::ValueOptionHandler<std::string>         m_benchmark_scenes;
+    foundation::ValueOptionHandler<std::string>         m_benchmark_baseline;
+    foundation::ValueOptionHandler<double>              m_benchmark_tolerance;
 
     // Constructor.
     CommandLineHandler();
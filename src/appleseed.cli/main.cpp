@@ -29,6 +29,8 @@
 
 // appleseed.cli headers.
 #include "commandlinehandler.h"
+#include "metricsfilewriter.h"
+#include "renderserver.h"
 #include "stdouttilecallback.h"
 
 // appleseed.common headers.
@@ -37,6 +39,7 @@
 #include "application/superlogger.h"
 
 // appleseed.renderer headers.
+#include "renderer/api/camera.h"
 #include "renderer/api/frame.h"
 #include "renderer/api/lighting.h"
 #include "renderer/api/log.h"
@@ -48,16 +51,24 @@
 #include "renderer/api/utility.h"
 
 // appleseed.foundation headers.
+#include "foundation/containers/dictionary.h"
+#include "foundation/core/appleseed.h"
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/log/log.h"
 #include "foundation/memory/autoreleaseptr.h"
 #include "foundation/platform/console.h"
 #include "foundation/platform/debugger.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/thread.h"
+#include "foundation/platform/timers.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/benchmark.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/filter.h"
 #include "foundation/utility/searchpaths.h"
+#include "foundation/utility/stopwatch.h"
 #include "foundation/utility/test.h"
+#include "foundation/utility/uid.h"
 
 // appleseed.main headers.
 #include "main/allocator.h"
@@ -67,12 +78,16 @@
 #include "boost/filesystem/path.hpp"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <memory>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 using namespace appleseed::cli;
 using namespace appleseed::common;
@@ -257,9 +272,30 @@ namespace
 
         if (g_cl.m_threads.is_set())
         {
+            // The value has the form n[:affinity], e.g. "auto:numa" or "16:core".
+            const std::string& value = g_cl.m_threads.value();
+            const std::string::size_type sep = value.find(':');
+
             params.insert_path(
                 "rendering_threads",
-                g_cl.m_threads.value());
+                value.substr(0, sep));
+
+            if (sep != std::string::npos)
+            {
+                const std::string affinity = value.substr(sep + 1);
+
+                if (affinity == "core")
+                    params.insert_path("rendering_thread_affinity", "core");
+                else if (affinity == "numa")
+                    params.insert_path("rendering_thread_affinity", "numa_node");
+                else
+                {
+                    LOG_ERROR(
+                        g_logger,
+                        "invalid thread affinity \"%s\", threads will not be pinned.",
+                        affinity.c_str());
+                }
+            }
         }
 
         if (g_cl.m_samples.is_set())
@@ -482,7 +518,9 @@ namespace
 
 #endif
 
-    auto_release_ptr<Project> load_project(const std::string& project_filepath)
+    auto_release_ptr<Project> load_project(
+        const std::string&  project_filepath,
+        const int           options = ProjectFileReader::Defaults)
     {
         // Construct the schema file path.
         const bf::path schema_filepath =
@@ -492,10 +530,22 @@ namespace
 
         // Load the project from disk.
         ProjectFileReader reader;
-        return
+        auto_release_ptr<Project> project(
             reader.read(
                 project_filepath.c_str(),
-                schema_filepath.string().c_str());
+                schema_filepath.string().c_str(),
+                g_cl.m_search_path_cache.is_set()
+                    ? options | ProjectFileReader::UseSearchPathCache
+                    : options));
+
+        // Convert texture files that would be slow to sample.
+        if (project.get() && g_cl.m_texture_cache.is_set())
+        {
+            if (!convert_untiled_textures(project.ref(), g_cl.m_texture_cache.value().c_str()))
+                LOG_WARNING(g_logger, "some texture files could not be converted and will be used as is.");
+        }
+
+        return project;
     }
 
     bool configure_project(Project& project, ParamArray& params)
@@ -537,27 +587,25 @@ namespace
         return value == "progressive";
     }
 
-    bool render(const std::string& project_filename)
+    std::unique_ptr<ITileCallbackFactory> create_tile_callback_factory(
+        const Project&      project,
+        const ParamArray&   params)
     {
-        // Load the project.
-        auto_release_ptr<Project> project = load_project(project_filename);
-        if (project.get() == nullptr)
-            return false;
-
-        // Retrieve the rendering parameters.
-        ParamArray params;
-        if (!configure_project(project.ref(), params))
-            return false;
-
-        // Create the tile callback factory.
         std::unique_ptr<ITileCallbackFactory> tile_callback_factory;
+
         if (g_cl.m_send_to_stdout.is_set())
         {
             tile_callback_factory.reset(
                 new StdOutTileCallbackFactory(
                     StdOutTileCallbackFactory::TileOutputOptions::AllAOVs));
         }
-        else if (project->get_display() == nullptr)
+        else if (g_cl.m_send_to_shared_memory.is_set())
+        {
+            tile_callback_factory.reset(
+                new SharedMemoryTileCallbackFactory(
+                    g_cl.m_send_to_shared_memory.value().c_str()));
+        }
+        else if (project.get_display() == nullptr)
         {
             // Create a default tile callback if needed.
             if (params.get_optional<std::string>("frame_renderer", "") != "progressive")
@@ -569,6 +617,56 @@ namespace
             }
         }
 
+        return tile_callback_factory;
+    }
+
+    bool write_frame(const Frame& frame, const char* file_path)
+    {
+        bool success = true;
+
+        if (!frame.write_main_image(file_path))
+            success = false;
+
+        if (!frame.write_aov_images(file_path))
+            success = false;
+
+        return success;
+    }
+
+    // Optionally write live rendering metrics to disk while rendering.
+    std::unique_ptr<MetricsFileWriter> create_metrics_file_writer()
+    {
+        if (!g_cl.m_metrics.is_set())
+            return std::unique_ptr<MetricsFileWriter>();
+
+        const char* file_path = g_cl.m_metrics.value().c_str();
+        LOG_INFO(g_logger, "writing rendering metrics to %s...", file_path);
+
+        const double MetricsInterval = 1.0;     // in seconds
+        return std::unique_ptr<MetricsFileWriter>(
+            new MetricsFileWriter(g_logger, file_path, MetricsInterval));
+    }
+
+    bool render(const std::string& project_filename)
+    {
+        // Optionally record a trace of render phases.
+        if (g_cl.m_save_trace.is_set())
+            global_event_tracer().set_enabled(true);
+
+        // Load the project.
+        auto_release_ptr<Project> project = load_project(project_filename);
+        if (project.get() == nullptr)
+            return false;
+
+        // Retrieve the rendering parameters.
+        ParamArray params;
+        if (!configure_project(project.ref(), params))
+            return false;
+
+        // Create the tile callback factory.
+        std::unique_ptr<ITileCallbackFactory> tile_callback_factory =
+            create_tile_callback_factory(project.ref(), params);
+
         SearchPaths resource_search_paths;
         Application::initialize_resource_search_paths(resource_search_paths);
 
@@ -580,6 +678,9 @@ namespace
             resource_search_paths,
             tile_callback_factory.get());
 
+        const std::unique_ptr<MetricsFileWriter> metrics_file_writer =
+            create_metrics_file_writer();
+
         // Render the frame.
         LOG_INFO(g_logger, "rendering frame...");
         MasterRenderer::RenderingResult rendering_result;
@@ -623,10 +724,7 @@ namespace
         // Optionally write the frame to disk.
         if (g_cl.m_output.is_set())
         {
-            const char* file_path = g_cl.m_output.value().c_str();
-            if (!project->get_frame()->write_main_image(file_path))
-                success = false;
-            if (!project->get_frame()->write_aov_images(file_path))
+            if (!write_frame(*project->get_frame(), g_cl.m_output.value().c_str()))
                 success = false;
         }
         else
@@ -660,9 +758,375 @@ namespace
                 success = false;
         }
 
+        // Optionally save the trace of render phases to disk.
+        if (g_cl.m_save_trace.is_set())
+        {
+            global_event_tracer().set_enabled(false);
+
+            const char* file_path = g_cl.m_save_trace.value().c_str();
+            LOG_INFO(g_logger, "writing trace file %s...", file_path);
+            if (!global_event_tracer().write_chrome_trace(file_path))
+            {
+                LOG_ERROR(g_logger, "failed to write trace file %s.", file_path);
+                success = false;
+            }
+        }
+
         return success;
     }
 
+    //
+    // Sequence rendering.
+    //
+    // A single master renderer is kept alive for the whole sequence so that acceleration
+    // structures, textures, shaders and light trees are only rebuilt when the scene change
+    // tracker reports that the corresponding entities changed between two frames.
+    //
+
+    // Replace the first run of '#' characters of a path by the zero-padded frame number.
+    std::string expand_frame_number(const std::string& pattern, const int frame)
+    {
+        const std::string::size_type begin = pattern.find('#');
+        if (begin == std::string::npos)
+            return pattern;
+
+        std::string::size_type end = pattern.find_first_not_of('#', begin);
+        if (end == std::string::npos)
+            end = pattern.size();
+
+        std::string number = foundation::to_string(frame);
+        if (number.size() < end - begin)
+            number.insert(0, end - begin - number.size(), '0');
+
+        return pattern.substr(0, begin) + number + pattern.substr(end);
+    }
+
+    // Make sure every frame of the sequence is written to its own file.
+    std::string make_output_pattern(const std::string& file_path)
+    {
+        if (file_path.find('#') != std::string::npos)
+            return file_path;
+
+        const bf::path path(file_path);
+        return (path.parent_path() / (path.stem().string() + ".####" + path.extension().string())).string();
+    }
+
+    bool are_equal(const TransformSequence& lhs, const TransformSequence& rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+
+        for (size_t i = 0, e = lhs.size(); i < e; ++i)
+        {
+            float lhs_time, rhs_time;
+            Transformd lhs_transform, rhs_transform;
+            lhs.get_transform(i, lhs_time, lhs_transform);
+            rhs.get_transform(i, rhs_time, rhs_transform);
+
+            if (lhs_time != rhs_time || lhs_transform != rhs_transform)
+                return false;
+        }
+
+        return true;
+    }
+
+    template <typename EntityType>
+    bool update_transform_sequence(EntityType& entity, const EntityType& new_entity)
+    {
+        if (are_equal(entity.transform_sequence(), new_entity.transform_sequence()))
+            return false;
+
+        entity.transform_sequence() = new_entity.transform_sequence();
+        entity.bump_version_id();
+
+        return true;
+    }
+
+    size_t update_assembly_instance_transforms(BaseGroup& base_group, const BaseGroup& new_base_group)
+    {
+        size_t updated_count = 0;
+
+        for (AssemblyInstance& assembly_instance : base_group.assembly_instances())
+        {
+            const AssemblyInstance* new_assembly_instance =
+                new_base_group.assembly_instances().get_by_name(assembly_instance.get_name());
+
+            if (new_assembly_instance != nullptr &&
+                update_transform_sequence(assembly_instance, *new_assembly_instance))
+                ++updated_count;
+        }
+
+        for (Assembly& assembly : base_group.assemblies())
+        {
+            const Assembly* new_assembly = new_base_group.assemblies().get_by_name(assembly.get_name());
+
+            if (new_assembly != nullptr)
+            {
+                const size_t assembly_updated_count =
+                    update_assembly_instance_transforms(assembly, *new_assembly);
+
+                if (assembly_updated_count > 0)
+                {
+                    assembly.bump_version_id();
+                    updated_count += assembly_updated_count;
+                }
+            }
+        }
+
+        return updated_count;
+    }
+
+    // Bring the project being rendered to the state of a project loaded for another frame.
+    // Only camera and assembly instance transforms are picked up; entities are matched by name.
+    void update_animated_entities(Project& project, const Project& new_project)
+    {
+        Scene& scene = *project.get_scene();
+        const Scene& new_scene = *new_project.get_scene();
+
+        size_t camera_count = 0;
+        for (Camera& camera : scene.cameras())
+        {
+            const Camera* new_camera = new_scene.cameras().get_by_name(camera.get_name());
+
+            if (new_camera != nullptr && update_transform_sequence(camera, *new_camera))
+                ++camera_count;
+        }
+
+        const size_t assembly_instance_count = update_assembly_instance_transforms(scene, new_scene);
+        if (assembly_instance_count > 0)
+            scene.bump_version_id();
+
+        LOG_DEBUG(
+            g_logger,
+            "%s camera(s) and %s assembly instance(s) moved since the previous frame.",
+            pretty_uint(camera_count).c_str(),
+            pretty_uint(assembly_instance_count).c_str());
+    }
+
+    // Write frames to disk on a background thread, so that writing a frame overlaps
+    // with loading and preparing the next one.
+    class FrameWriter
+      : public NonCopyable
+    {
+      public:
+        ~FrameWriter()
+        {
+            wait();
+        }
+
+        void write(const Frame& frame, const std::string& file_path)
+        {
+            wait();
+
+            m_thread =
+                std::thread(
+                    [this, &frame, file_path]()
+                    {
+                        if (!write_frame(frame, file_path.c_str()))
+                            m_success = false;
+                    });
+        }
+
+        // Wait until the pending write, if any, is complete.
+        void wait()
+        {
+            if (m_thread.joinable())
+                m_thread.join();
+        }
+
+        // Return false if any write failed so far.
+        bool succeeded() const
+        {
+            return m_success;
+        }
+
+      private:
+        std::thread     m_thread;
+        bool            m_success = true;
+    };
+
+    class SequenceRendererController
+      : public DefaultRendererController
+    {
+      public:
+        explicit SequenceRendererController(FrameWriter& frame_writer)
+          : m_frame_writer(frame_writer)
+        {
+        }
+
+        void on_frame_begin() override
+        {
+            // The frame is about to be cleared: the previous one must be on disk by now.
+            m_frame_writer.wait();
+
+            DefaultRendererController::on_frame_begin();
+        }
+
+      private:
+        FrameWriter& m_frame_writer;
+    };
+
+    bool render_sequence(const std::string& project_filename)
+    {
+        const int first_frame = g_cl.m_frames.values()[0];
+        const int last_frame = g_cl.m_frames.values()[1];
+
+        if (first_frame < 0 || last_frame < first_frame)
+        {
+            LOG_ERROR(g_logger, "invalid frame range %d-%d.", first_frame, last_frame);
+            return false;
+        }
+
+        if (g_cl.m_checkpoint_create.is_set() || g_cl.m_checkpoint_resume.is_set())
+        {
+            LOG_ERROR(g_logger, "checkpoints are not supported when rendering a sequence of frames.");
+            return false;
+        }
+
+        const bool is_animated_project = project_filename.find('#') != std::string::npos;
+        if (!is_animated_project)
+            LOG_WARNING(g_logger, "project file name has no '#' characters, all frames will show the same scene.");
+
+        // Load the project of the first frame.
+        auto_release_ptr<Project> project =
+            load_project(expand_frame_number(project_filename, first_frame));
+        if (project.get() == nullptr)
+            return false;
+
+        // Retrieve the rendering parameters.
+        ParamArray params;
+        if (!configure_project(project.ref(), params))
+            return false;
+
+        // Figure out where to write frames.
+        const std::string output_filename =
+            g_cl.m_output.is_set()
+                ? g_cl.m_output.value()
+                : project->get_frame()->get_parameters().get_optional<std::string>("output_filename");
+        if (output_filename.empty())
+        {
+            LOG_ERROR(g_logger, "an output file must be specified when rendering a sequence of frames.");
+            return false;
+        }
+        const std::string output_pattern = make_output_pattern(output_filename);
+
+        std::unique_ptr<ITileCallbackFactory> tile_callback_factory =
+            create_tile_callback_factory(project.ref(), params);
+
+        SearchPaths resource_search_paths;
+        Application::initialize_resource_search_paths(resource_search_paths);
+
+        // Create the master renderer, shared by all frames.
+        FrameWriter frame_writer;
+        SequenceRendererController renderer_controller(frame_writer);
+        MasterRenderer renderer(
+            project.ref(),
+            params,
+            resource_search_paths,
+            tile_callback_factory.get());
+
+        const std::unique_ptr<MetricsFileWriter> metrics_file_writer =
+            create_metrics_file_writer();
+
+        std::unique_ptr<ProcessPriorityContext> background_context;
+        if (params.get_optional<bool>("background_mode", true))
+            background_context.reset(new ProcessPriorityContext(ProcessPriorityLow, &g_logger));
+
+        for (int frame = first_frame; frame <= last_frame; ++frame)
+        {
+            if (frame > first_frame && is_animated_project)
+            {
+                // Meshes are not needed since only transforms are picked up from subsequent frames.
+                auto_release_ptr<Project> frame_project =
+                    load_project(
+                        expand_frame_number(project_filename, frame),
+                        ProjectFileReader::OmitReadingMeshFiles);
+                if (frame_project.get() == nullptr)
+                    return false;
+
+                update_animated_entities(project.ref(), frame_project.ref());
+            }
+
+            LOG_INFO(g_logger, "rendering frame %d...", frame);
+            const auto rendering_result = renderer.render(renderer_controller);
+            if (rendering_result.m_status != MasterRenderer::RenderingResult::Succeeded)
+                return false;
+
+            LOG_INFO(
+                g_logger,
+                "frame %d rendered in %s.",
+                frame,
+                pretty_time(project->get_rendering_timer().get_seconds(), 3).c_str());
+
+            frame_writer.write(*project->get_frame(), expand_frame_number(output_pattern, frame));
+        }
+
+        frame_writer.wait();
+
+        return frame_writer.succeeded();
+    }
+
+    bool run_render_server()
+    {
+        const int port = g_cl.m_server.value();
+        if (port <= 0 || port > 65535)
+        {
+            LOG_ERROR(g_logger, "invalid render server port %d.", port);
+            return false;
+        }
+
+        const std::uint64_t memory_budget =
+            g_cl.m_server_memory_budget.is_set()
+                ? static_cast<std::uint64_t>(std::max(g_cl.m_server_memory_budget.value(), 0)) * 1024 * 1024
+                : 0;
+
+        SearchPaths resource_search_paths;
+        Application::initialize_resource_search_paths(resource_search_paths);
+
+        RenderServer server(
+            g_logger,
+            static_cast<std::uint16_t>(port),
+            memory_budget,
+            resource_search_paths,
+            [](const std::string& project_filepath)
+            {
+                return load_project(project_filepath);
+            },
+            configure_project);
+
+        return server.run();
+    }
+
+    // Format the phases recorded in a frame's render info as a single-line JSON object.
+    std::string make_phase_report(const ParamArray& phases)
+    {
+        std::string report = "{";
+
+        for (const_each<DictionaryDictionary> i = phases.dictionaries(); i; ++i)
+        {
+            const Dictionary& phase = i->value();
+
+            if (report.size() > 1)
+                report += ",";
+
+            report += "\"";
+            report += i->key();
+            report += "\":{\"wall_time\":";
+            report += phase.get("wall_time");
+            report += ",\"cpu_time\":";
+            report += phase.get("cpu_time");
+            report += ",\"peak_memory\":";
+            report += phase.get("peak_memory");
+            report += ",\"thread_utilization\":";
+            report += phase.get("thread_utilization");
+            report += "}";
+        }
+
+        report += "}";
+
+        return report;
+    }
+
     bool benchmark_render(const std::string& project_filename)
     {
         // Configure our logger.
@@ -678,9 +1142,12 @@ namespace
         global_logger().reset_format(LogMessage::Fatal);
 
         // Load the project.
+        ParamArray phase_info;
+        PhaseTimer project_loading_timer;
         auto_release_ptr<Project> project = load_project(project_filename);
         if (project.get() == nullptr)
             return false;
+        project_loading_timer.record(phase_info, "project_loading");
 
         // Figure out the rendering parameters.
         ParamArray params;
@@ -708,6 +1175,9 @@ namespace
                 return false;
             total_time_seconds = project->get_rendering_timer().get_seconds();
 
+            // Keep the phases of the first render since it includes all setup work.
+            phase_info.push("phases").merge(project->get_frame()->render_info().child("phases"));
+
             // Render a second time.
             result = renderer.render(renderer_controller);
             if (result.m_status != MasterRenderer::RenderingResult::Succeeded)
@@ -718,9 +1188,11 @@ namespace
         // Write the frame to disk.
         if (g_cl.m_output.is_set())
         {
+            PhaseTimer output_timer;
             const char* file_path = g_cl.m_output.value().c_str();
             project->get_frame()->write_main_image(file_path);
             project->get_frame()->write_aov_images(file_path);
+            output_timer.record(phase_info, "output");
         }
 
         // Print benchmark results.
@@ -728,9 +1200,299 @@ namespace
         LOG_INFO(g_logger, "total_time=%.6f", total_time_seconds);
         LOG_INFO(g_logger, "setup_time=%.6f", total_time_seconds - render_time_seconds);
         LOG_INFO(g_logger, "render_time=%.6f", render_time_seconds);
+        LOG_INFO(g_logger, "phases=%s", make_phase_report(phase_info.child("phases")).c_str());
 
         return true;
     }
+
+    //
+    // Scene benchmarks.
+    //
+
+    // A benchmark case standing for one scene. Scenes are rendered by run_scene_benchmarks(),
+    // not by the benchmark case itself, since they must not be timed repeatedly like unit benchmarks.
+    class SceneBenchmarkCase
+      : public IBenchmarkCase
+    {
+      public:
+        explicit SceneBenchmarkCase(const std::string& name)
+          : m_name(name)
+        {
+        }
+
+        const char* get_name() const override
+        {
+            return m_name.c_str();
+        }
+
+        void run() override
+        {
+        }
+
+      private:
+        const std::string m_name;
+    };
+
+    struct SceneBenchmarkMetrics
+    {
+        double          m_load_time;
+        double          m_scene_preparation_time;
+        double          m_osl_preparation_time;
+        double          m_acceleration_structure_build_time;
+        double          m_render_time;
+        std::uint64_t   m_ray_count;
+        std::uint64_t   m_shading_point_count;
+        std::uint64_t   m_peak_memory;
+    };
+
+    bool benchmark_scene(const std::string& project_filename, SceneBenchmarkMetrics& metrics)
+    {
+        // Load the project.
+        Stopwatch<DefaultWallclockTimer> stopwatch;
+        stopwatch.start();
+        auto_release_ptr<Project> project = load_project(project_filename);
+        if (project.get() == nullptr)
+            return false;
+        stopwatch.measure();
+        metrics.m_load_time = stopwatch.get_seconds();
+
+        // Figure out the rendering parameters.
+        ParamArray params;
+        if (!configure_project(project.ref(), params))
+            return false;
+
+        SearchPaths resource_search_paths;
+        Application::initialize_resource_search_paths(resource_search_paths);
+
+        // Render the frame.
+        DefaultRendererController renderer_controller;
+        MasterRenderer renderer(
+            project.ref(),
+            params,
+            resource_search_paths);
+        {
+            // Raise the process priority to reduce interruptions.
+            ProcessPriorityContext benchmark_context(ProcessPriorityHigh, &g_logger);
+
+            const auto result = renderer.render(renderer_controller);
+            if (result.m_status != MasterRenderer::RenderingResult::Succeeded)
+                return false;
+        }
+
+        // Collect the measurements made by the renderer.
+        const ParamArray& render_info = project->get_frame()->render_info();
+        metrics.m_scene_preparation_time = render_info.get_optional<double>("scene_preparation_time", 0.0);
+        metrics.m_osl_preparation_time = render_info.get_optional<double>("osl_preparation_time", 0.0);
+        metrics.m_acceleration_structure_build_time = render_info.get_optional<double>("acceleration_structure_build_time", 0.0);
+        metrics.m_render_time = render_info.get_optional<double>("render_time", 0.0);
+        metrics.m_ray_count = render_info.get_optional<std::uint64_t>("ray_count", 0);
+        metrics.m_shading_point_count = render_info.get_optional<std::uint64_t>("shading_point_count", 0);
+        metrics.m_peak_memory = System::get_peak_process_virtual_memory_size();
+
+        return true;
+    }
+
+    void write_scene_benchmark_metrics(
+        BenchmarkResult&                result,
+        const BenchmarkSuite&           suite,
+        const IBenchmarkCase&           benchmark_case,
+        const SceneBenchmarkMetrics&    metrics)
+    {
+        // The render time is reported as a timing result so that it is picked up by BenchmarkAggregator.
+        TimingResult timing_result;
+        timing_result.m_iteration_count = 1;
+        timing_result.m_measurement_count = 1;
+        timing_result.m_frequency = 1.0e6;
+        timing_result.m_ticks = metrics.m_render_time * timing_result.m_frequency;
+        result.write(suite, benchmark_case, __FILE__, __LINE__, timing_result);
+
+        const double render_time = std::max(metrics.m_render_time, 1.0e-6);
+        const ValueResult values[] =
+        {
+            { "load_time", "s", metrics.m_load_time },
+            { "scene_preparation_time", "s", metrics.m_scene_preparation_time },
+            { "osl_preparation_time", "s", metrics.m_osl_preparation_time },
+            { "acceleration_structure_build_time", "s", metrics.m_acceleration_structure_build_time },
+            { "render_time", "s", metrics.m_render_time },
+            { "rays_per_second", "rays/s", metrics.m_ray_count / render_time },
+            { "shading_points_per_second", "points/s", metrics.m_shading_point_count / render_time },
+            { "peak_memory", "MB", metrics.m_peak_memory / (1024.0 * 1024.0) }
+        };
+
+        for (const ValueResult& value : values)
+            result.write(suite, benchmark_case, __FILE__, __LINE__, value);
+    }
+
+    typedef std::vector<std::pair<std::string, double>> SceneRenderTimes;
+
+    // Compare render times against a baseline results file. Return false if any scene regressed.
+    bool compare_scene_benchmarks_to_baseline(
+        const char*                 suite_name,
+        const SceneRenderTimes&     render_times)
+    {
+        const std::string& baseline_path = g_cl.m_benchmark_baseline.value();
+
+        BenchmarkAggregator aggregator;
+        if (!aggregator.scan_file(baseline_path.c_str()))
+        {
+            LOG_ERROR(g_logger, "failed to read scene benchmark baseline %s.", baseline_path.c_str());
+            return false;
+        }
+
+        const Dictionary& benchmarks = aggregator.get_benchmarks();
+        const char* configuration = Appleseed::get_lib_configuration();
+        if (!benchmarks.dictionaries().exist(configuration) ||
+            !benchmarks.dictionaries().get(configuration).dictionaries().exist(suite_name))
+        {
+            LOG_ERROR(
+                g_logger,
+                "scene benchmark baseline %s has no results for the %s configuration.",
+                baseline_path.c_str(),
+                configuration);
+            return false;
+        }
+
+        const Dictionary& cases = benchmarks.dictionaries().get(configuration).dictionaries().get(suite_name);
+        const double tolerance =
+            g_cl.m_benchmark_tolerance.is_set() ? g_cl.m_benchmark_tolerance.value() : 5.0;
+
+        bool success = true;
+
+        for (const auto& render_time : render_times)
+        {
+            const char* case_name = render_time.first.c_str();
+
+            if (!cases.strings().exist(case_name))
+            {
+                LOG_WARNING(g_logger, "scene benchmark baseline has no results for %s.", case_name);
+                continue;
+            }
+
+            const BenchmarkSeries& series = aggregator.get_series(cases.get<UniqueID>(case_name));
+            if (series.empty())
+                continue;
+
+            // Render times are stored in microseconds.
+            const double baseline_time = series[series.size() - 1].get_ticks() * 1.0e-6;
+            const double change = 100.0 * (render_time.second - baseline_time) / baseline_time;
+
+            if (change > tolerance)
+            {
+                LOG_ERROR(
+                    g_logger,
+                    "%s regressed: render time went from %s to %s (%+.1f%%).",
+                    case_name,
+                    pretty_time(baseline_time, 3).c_str(),
+                    pretty_time(render_time.second, 3).c_str(),
+                    change);
+                success = false;
+            }
+            else
+            {
+                LOG_INFO(
+                    g_logger,
+                    "%s: render time went from %s to %s (%+.1f%%).",
+                    case_name,
+                    pretty_time(baseline_time, 3).c_str(),
+                    pretty_time(render_time.second, 3).c_str(),
+                    change);
+            }
+        }
+
+        return success;
+    }
+
+    bool run_scene_benchmarks()
+    {
+        // Configure the renderer's logger: mute all log messages except warnings and errors.
+        SaveLogFormatterConfig save_global_logger_config(global_logger());
+        global_logger().set_all_formats(std::string());
+        global_logger().reset_format(LogMessage::Warning);
+        global_logger().reset_format(LogMessage::Error);
+        global_logger().reset_format(LogMessage::Fatal);
+
+        BenchmarkResult result;
+
+        // Add a benchmark listener that outputs to the logger.
+        auto_release_ptr<IBenchmarkListener>
+            logger_listener(create_logger_benchmark_listener(g_logger));
+        result.add_listener(logger_listener.get());
+
+        // Try to add a benchmark listener that outputs to a XML file.
+        auto_release_ptr<XMLFileBenchmarkListener> xmlfile_listener(
+            create_xmlfile_benchmark_listener());
+        const std::string xmlfile_name = "benchmark." + get_time_stamp_string() + ".xml";
+        const bf::path xmlfile_path =
+              bf::path(Application::get_tests_root_path())
+            / "scene benchmarks" / "results" / xmlfile_name;
+        boost::system::error_code ec;
+        bf::create_directories(xmlfile_path.parent_path(), ec);
+        if (xmlfile_listener->open(xmlfile_path.string().c_str()))
+        {
+            LOG_INFO(g_logger, "writing scene benchmark results to %s...", xmlfile_path.string().c_str());
+            result.add_listener(xmlfile_listener.get());
+        }
+        else
+        {
+            LOG_WARNING(
+                g_logger,
+                "automatic benchmark results archiving to %s failed: i/o error.",
+                xmlfile_path.string().c_str());
+        }
+
+        const BenchmarkSuite suite("Scenes");
+        result.begin_suite(suite);
+        result.signal_suite_execution();
+
+        SceneRenderTimes render_times;
+
+        for (const std::string& project_filename : g_cl.m_benchmark_scenes.values())
+        {
+            const SceneBenchmarkCase benchmark_case(bf::path(project_filename).stem().string());
+
+            result.begin_case(suite, benchmark_case);
+            result.signal_case_execution();
+
+            SceneBenchmarkMetrics metrics;
+            if (benchmark_scene(project_filename, metrics))
+            {
+                write_scene_benchmark_metrics(result, suite, benchmark_case, metrics);
+                render_times.emplace_back(benchmark_case.get_name(), metrics.m_render_time);
+            }
+            else
+            {
+                result.write(
+                    suite,
+                    benchmark_case,
+                    __FILE__,
+                    __LINE__,
+                    "failed to render %s.",
+                    project_filename.c_str());
+                result.signal_case_failure();
+            }
+
+            result.end_case(suite, benchmark_case);
+        }
+
+        if (result.get_case_failure_count() > 0)
+            result.signal_suite_failure();
+
+        result.end_suite(suite);
+
+        // Close the results file before it is possibly used as a future baseline.
+        xmlfile_listener->close();
+
+        LOG_INFO(g_logger, "scene benchmarking summary:");
+        print_suite_case_result(result);
+
+        bool success = result.get_case_failure_count() == 0;
+
+        // Optionally gate on render time regressions.
+        if (g_cl.m_benchmark_baseline.is_set())
+            success = compare_scene_benchmarks_to_baseline(suite.get_name(), render_times) && success;
+
+        return success;
+    }
 }
 
 
@@ -775,6 +1537,14 @@ int main(int argc, char* argv[])
     if (g_cl.m_run_unit_benchmarks.is_set())
         run_unit_benchmarks();
 
+    // Run scene benchmarks.
+    if (g_cl.m_benchmark_scenes.is_set())
+        success = run_scene_benchmarks() && success;
+
+    // Serve render requests.
+    if (g_cl.m_server.is_set())
+        success = run_render_server() && success;
+
     // Render the specified project.
     if (!g_cl.m_filename.values().empty())
     {
@@ -782,6 +1552,8 @@ int main(int argc, char* argv[])
 
         if (g_cl.m_benchmark_mode.is_set())
             success = success && benchmark_render(project_filename);
+        else if (g_cl.m_frames.is_set())
+            success = success && render_sequence(project_filename);
         else success = success && render(project_filename);
     }
 
@@ -0,0 +1,252 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "metricsfilewriter.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/rendering.h"
+
+// appleseed.foundation headers.
+#include "foundation/log/log.h"
+#include "foundation/memory/memorytracker.h"
+#include "foundation/platform/system.h"
+
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+#include "boost/system/error_code.hpp"
+
+// Standard headers.
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+using namespace foundation;
+using namespace renderer;
+namespace bf = boost::filesystem;
+
+namespace appleseed {
+namespace cli {
+
+namespace
+{
+    void write_metric(
+        std::ofstream&          file,
+        const char*             name,
+        const char*             type,
+        const char*             help,
+        const double            value)
+    {
+        file << "# HELP " << name << ' ' << help << '\n';
+        file << "# TYPE " << name << ' ' << type << '\n';
+        file << name << ' ' << value << '\n';
+    }
+
+    // Return the rate of change of a counter, which is reset at the beginning of each frame.
+    double compute_rate(
+        const std::uint64_t     value,
+        const std::uint64_t     previous_value,
+        const double            elapsed)
+    {
+        return value >= previous_value && elapsed > 0.0
+            ? static_cast<double>(value - previous_value) / elapsed
+            : 0.0;
+    }
+}
+
+struct MetricsFileWriter::Impl
+{
+    Logger&                     m_logger;
+    const std::string           m_filepath;
+    const std::chrono::duration<double> m_interval;
+
+    std::mutex                  m_mutex;
+    std::condition_variable     m_stop_event;
+    bool                        m_stop;
+    std::thread                 m_thread;
+
+    RenderingMetrics::Snapshot  m_previous_snapshot;
+    std::chrono::steady_clock::time_point m_previous_time;
+
+    Impl(
+        Logger&                 logger,
+        const std::string&      filepath,
+        const double            interval)
+      : m_logger(logger)
+      , m_filepath(filepath)
+      , m_interval(interval)
+      , m_stop(false)
+      , m_previous_snapshot(global_rendering_metrics().get_snapshot())
+      , m_previous_time(std::chrono::steady_clock::now())
+    {
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (!m_stop)
+        {
+            m_stop_event.wait_for(lock, m_interval);
+            write();
+        }
+    }
+
+    void write()
+    {
+        const RenderingMetrics::Snapshot snapshot = global_rendering_metrics().get_snapshot();
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        const double elapsed = std::chrono::duration<double>(now - m_previous_time).count();
+
+        const std::string tmp_filepath = m_filepath + ".tmp";
+
+        {
+            std::ofstream file(tmp_filepath.c_str(), std::ios_base::out | std::ios_base::trunc);
+
+            if (!file.is_open())
+            {
+                LOG_ERROR(m_logger, "failed to write metrics file %s.", tmp_filepath.c_str());
+                return;
+            }
+
+            write_metric(
+                file, "appleseed_rendering", "gauge",
+                "Whether a frame is being rendered.",
+                snapshot.m_rendering ? 1.0 : 0.0);
+
+            write_metric(
+                file, "appleseed_frame_elapsed_seconds", "gauge",
+                "Time spent rendering the current frame.",
+                snapshot.m_elapsed_time);
+
+            write_metric(
+                file, "appleseed_samples", "gauge",
+                "Number of camera samples rendered in the current frame.",
+                static_cast<double>(snapshot.m_samples));
+
+            write_metric(
+                file, "appleseed_samples_per_second", "gauge",
+                "Number of camera samples rendered per second.",
+                compute_rate(snapshot.m_samples, m_previous_snapshot.m_samples, elapsed));
+
+            write_metric(
+                file, "appleseed_rays", "gauge",
+                "Number of rays traced in the current frame.",
+                static_cast<double>(snapshot.m_rays));
+
+            write_metric(
+                file, "appleseed_rays_per_second", "gauge",
+                "Number of rays traced per second.",
+                compute_rate(snapshot.m_rays, m_previous_snapshot.m_rays, elapsed));
+
+            const std::uint64_t texture_cache_accesses =
+                snapshot.m_texture_cache_hits + snapshot.m_texture_cache_misses;
+            write_metric(
+                file, "appleseed_texture_cache_hit_ratio", "gauge",
+                "Fraction of texture cache accesses that hit the cache in the current frame.",
+                texture_cache_accesses > 0
+                    ? static_cast<double>(snapshot.m_texture_cache_hits) / texture_cache_accesses
+                    : 0.0);
+
+            write_metric(
+                file, "appleseed_active_threads", "gauge",
+                "Number of threads currently rendering.",
+                static_cast<double>(snapshot.m_active_threads));
+
+            if (snapshot.m_total_pixels > 0)
+            {
+                write_metric(
+                    file, "appleseed_progress_ratio", "gauge",
+                    "Fraction of the current frame rendered so far.",
+                    static_cast<double>(snapshot.m_rendered_pixels) / snapshot.m_total_pixels);
+            }
+
+            const double remaining_time = snapshot.get_remaining_time();
+            if (remaining_time >= 0.0)
+            {
+                write_metric(
+                    file, "appleseed_remaining_seconds", "gauge",
+                    "Estimated time until the current frame is rendered.",
+                    remaining_time);
+            }
+
+            write_metric(
+                file, "appleseed_process_memory_bytes", "gauge",
+                "Virtual memory used by the process.",
+                static_cast<double>(System::get_process_virtual_memory_size()));
+
+            const MemoryTracker& tracker = global_memory_tracker();
+            file << "# HELP appleseed_memory_bytes Memory used by a subsystem.\n";
+            file << "# TYPE appleseed_memory_bytes gauge\n";
+            for (size_t i = 0, e = tracker.get_category_count(); i < e; ++i)
+            {
+                file
+                    << "appleseed_memory_bytes{subsystem=\"" << tracker.get_category_name(i) << "\"} "
+                    << tracker.get_current_size(i) << '\n';
+            }
+        }
+
+        boost::system::error_code ec;
+        bf::rename(tmp_filepath, m_filepath, ec);
+        if (ec)
+            LOG_ERROR(m_logger, "failed to write metrics file %s: %s.", m_filepath.c_str(), ec.message().c_str());
+
+        m_previous_snapshot = snapshot;
+        m_previous_time = now;
+    }
+};
+
+MetricsFileWriter::MetricsFileWriter(
+    Logger&                     logger,
+    const std::string&          filepath,
+    const double                interval)
+  : impl(new Impl(logger, filepath, interval))
+{
+    impl->m_thread = std::thread([this]() { impl->run(); });
+}
+
+MetricsFileWriter::~MetricsFileWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(impl->m_mutex);
+        impl->m_stop = true;
+    }
+
+    impl->m_stop_event.notify_one();
+    impl->m_thread.join();
+
+    delete impl;
+}
+
+}   // namespace cli
+}   // namespace appleseed
@@ -0,0 +1,72 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// Standard headers.
+#include <string>
+
+// Forward declarations.
+namespace foundation { class Logger; }
+
+namespace appleseed {
+namespace cli {
+
+//
+// Periodically writes live rendering metrics to a file in the Prometheus text format:
+// samples and rays per second, texture cache hit rate, active rendering threads,
+// progress and estimated remaining time, memory used by each subsystem and by the
+// process.
+//
+// The file is replaced atomically so that it can be read at any time, for instance
+// by the textfile collector of the Prometheus node exporter.
+//
+
+class MetricsFileWriter
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor, starts writing the file in the background.
+    MetricsFileWriter(
+        foundation::Logger&     logger,
+        const std::string&      filepath,
+        const double            interval);      // in seconds
+
+    // Destructor, writes the file one last time and stops.
+    ~MetricsFileWriter();
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}   // namespace cli
+}   // namespace appleseed
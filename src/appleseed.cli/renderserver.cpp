@@ -0,0 +1,458 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "renderserver.h"
+
+// appleseed.cli headers.
+#include "stdouttilecallback.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/frame.h"
+#include "renderer/api/rendering.h"
+
+// appleseed.foundation headers.
+#include "foundation/log/log.h"
+#include "foundation/platform/system.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/searchpaths.h"
+
+// Boost headers.
+#include "boost/asio.hpp"
+#include "boost/atomic/atomic.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <istream>
+#include <list>
+#include <memory>
+#include <utility>
+
+using namespace foundation;
+using namespace renderer;
+namespace asio = boost::asio;
+using asio::ip::tcp;
+
+namespace appleseed {
+namespace cli {
+
+namespace
+{
+    //
+    // Tile stream writing to the connection of the request being served.
+    //
+
+    class SocketTileStream
+      : public ITileStream
+    {
+      public:
+        SocketTileStream()
+          : m_socket(nullptr)
+          , m_failed(false)
+        {
+        }
+
+        // Redirect the stream to another connection; data is discarded if `socket` is null.
+        void set_socket(tcp::socket* socket)
+        {
+            m_socket = socket;
+            m_failed = false;
+        }
+
+        void write(const void* data, const size_t size) override
+        {
+            if (m_socket == nullptr || m_failed)
+                return;
+
+            boost::system::error_code ec;
+            asio::write(*m_socket, asio::buffer(data, size), ec);
+
+            if (ec)
+                m_failed = true;
+        }
+
+        // Return true if the client went away.
+        bool failed() const
+        {
+            return m_failed;
+        }
+
+      private:
+        tcp::socket*        m_socket;
+        boost::atomic<bool> m_failed;
+    };
+
+    //
+    // Renderer controller aborting the render when the client disconnects.
+    //
+
+    class RequestRendererController
+      : public DefaultRendererController
+    {
+      public:
+        explicit RequestRendererController(const SocketTileStream& tile_stream)
+          : m_tile_stream(tile_stream)
+        {
+        }
+
+        Status get_status() const override
+        {
+            return m_tile_stream.failed() ? AbortRendering : ContinueRendering;
+        }
+
+      private:
+        const SocketTileStream& m_tile_stream;
+    };
+
+    struct Request
+    {
+        std::string m_project_filepath;
+        std::string m_output_filepath;
+        ParamArray  m_params;
+        bool        m_shutdown;
+
+        Request()
+          : m_shutdown(false)
+        {
+        }
+    };
+
+    bool read_request(tcp::socket& socket, Request& request, std::string& error)
+    {
+        asio::streambuf buffer;
+        boost::system::error_code ec;
+        asio::read_until(socket, buffer, "\n\n", ec);
+        if (ec)
+        {
+            error = ec.message();
+            return false;
+        }
+
+        std::istream input(&buffer);
+        std::string line;
+
+        while (std::getline(input, line))
+        {
+            line = trim_both(line);
+            if (line.empty())
+                break;
+
+            const std::string::size_type sep = line.find(' ');
+            const std::string key = line.substr(0, sep);
+            const std::string value =
+                sep == std::string::npos ? std::string() : trim_both(line.substr(sep + 1));
+
+            if (key == "project")
+                request.m_project_filepath = value;
+            else if (key == "output")
+                request.m_output_filepath = value;
+            else if (key == "parameter")
+            {
+                const std::string::size_type equal_pos = value.find('=');
+                if (equal_pos == std::string::npos)
+                {
+                    error = "malformed parameter \"" + value + "\"";
+                    return false;
+                }
+
+                request.m_params.insert_path(
+                    value.substr(0, equal_pos).c_str(),
+                    value.substr(equal_pos + 1));
+            }
+            else if (key == "shutdown")
+                request.m_shutdown = true;
+            else
+            {
+                error = "unknown request key \"" + key + "\"";
+                return false;
+            }
+        }
+
+        if (!request.m_shutdown && request.m_project_filepath.empty())
+        {
+            error = "no project specified";
+            return false;
+        }
+
+        return true;
+    }
+}
+
+
+//
+// RenderServer class implementation.
+//
+
+struct RenderServer::Impl
+{
+    // A project kept alive between requests, along with its renderer and its caches.
+    struct Session
+    {
+        std::string                                 m_project_filepath;
+        auto_release_ptr<Project>                   m_project;
+        ParamArray                                  m_params;
+        SocketTileStream                            m_tile_stream;
+        std::unique_ptr<StreamTileCallbackFactory>  m_tile_callback_factory;
+        std::unique_ptr<MasterRenderer>             m_renderer;
+    };
+
+    Logger&                                         m_logger;
+    const std::uint16_t                             m_port;
+    const std::uint64_t                             m_memory_budget;
+    const SearchPaths&                              m_resource_search_paths;
+    const LoadProjectFunction                       m_load_project;
+    const ConfigureProjectFunction                  m_configure_project;
+    std::list<std::unique_ptr<Session>>             m_sessions;     // most recently used first
+
+    Impl(
+        Logger&                     logger,
+        const std::uint16_t         port,
+        const std::uint64_t         memory_budget,
+        const SearchPaths&          resource_search_paths,
+        LoadProjectFunction         load_project,
+        ConfigureProjectFunction    configure_project)
+      : m_logger(logger)
+      , m_port(port)
+      , m_memory_budget(memory_budget)
+      , m_resource_search_paths(resource_search_paths)
+      , m_load_project(std::move(load_project))
+      , m_configure_project(std::move(configure_project))
+    {
+    }
+
+    // Return false when the server must stop.
+    bool serve(tcp::socket& socket)
+    {
+        Request request;
+        std::string error;
+        if (!read_request(socket, request, error))
+        {
+            LOG_ERROR(m_logger, "invalid render request: %s.", error.c_str());
+            return true;
+        }
+
+        if (request.m_shutdown)
+        {
+            LOG_INFO(m_logger, "render server shutting down...");
+            return false;
+        }
+
+        const bool success = render(socket, request);
+
+        SocketTileStream result_stream;
+        result_stream.set_socket(&socket);
+        send_render_result(result_stream, success);
+
+        return true;
+    }
+
+    bool render(tcp::socket& socket, const Request& request)
+    {
+        Session* session = get_session(request.m_project_filepath);
+        if (session == nullptr)
+            return false;
+
+        // Apply the overrides of this request on top of the project's rendering parameters.
+        ParamArray params = session->m_params;
+        params.merge(request.m_params);
+        session->m_renderer->get_parameters() = params;
+
+        session->m_tile_stream.set_socket(&socket);
+        session->m_tile_callback_factory->restart();
+
+        LOG_INFO(m_logger, "rendering %s...", request.m_project_filepath.c_str());
+        RequestRendererController renderer_controller(session->m_tile_stream);
+        const MasterRenderer::RenderingResult rendering_result =
+            session->m_renderer->render(renderer_controller);
+
+        session->m_tile_stream.set_socket(nullptr);
+
+        const Project& project = session->m_project.ref();
+        bool success = rendering_result.m_status == MasterRenderer::RenderingResult::Succeeded;
+
+        if (success)
+        {
+            LOG_INFO(
+                m_logger,
+                "rendered %s in %s.",
+                request.m_project_filepath.c_str(),
+                pretty_time(project.get_rendering_timer().get_seconds(), 3).c_str());
+
+            if (!request.m_output_filepath.empty())
+            {
+                const char* file_path = request.m_output_filepath.c_str();
+                if (!project.get_frame()->write_main_image(file_path))
+                    success = false;
+                if (!project.get_frame()->write_aov_images(file_path))
+                    success = false;
+            }
+        }
+        else LOG_ERROR(m_logger, "failed to render %s.", request.m_project_filepath.c_str());
+
+        // Keep the project that was just rendered.
+        enforce_memory_budget(1);
+
+        return success;
+    }
+
+    Session* get_session(const std::string& project_filepath)
+    {
+        for (auto i = m_sessions.begin(), e = m_sessions.end(); i != e; ++i)
+        {
+            if ((*i)->m_project_filepath == project_filepath)
+            {
+                m_sessions.splice(m_sessions.begin(), m_sessions, i);
+                return m_sessions.front().get();
+            }
+        }
+
+        // Make room for the new project.
+        enforce_memory_budget(0);
+
+        LOG_INFO(m_logger, "loading project %s...", project_filepath.c_str());
+
+        std::unique_ptr<Session> session(new Session());
+        session->m_project_filepath = project_filepath;
+        session->m_project = m_load_project(project_filepath);
+        if (session->m_project.get() == nullptr)
+            return nullptr;
+
+        if (!m_configure_project(session->m_project.ref(), session->m_params))
+            return nullptr;
+
+        session->m_tile_callback_factory.reset(
+            new StreamTileCallbackFactory(
+                session->m_tile_stream,
+                TileOutputOptions::AllAOVs));
+
+        session->m_renderer.reset(
+            new MasterRenderer(
+                session->m_project.ref(),
+                session->m_params,
+                m_resource_search_paths,
+                session->m_tile_callback_factory.get()));
+
+        m_sessions.push_front(std::move(session));
+
+        return m_sessions.front().get();
+    }
+
+    // Release least recently used projects until the process fits in the memory budget,
+    // but always keep the `keep_count` most recently used ones.
+    void enforce_memory_budget(const size_t keep_count)
+    {
+        if (m_memory_budget == 0)
+            return;
+
+        while (m_sessions.size() > keep_count &&
+               System::get_process_virtual_memory_size() > m_memory_budget)
+        {
+            LOG_INFO(
+                m_logger,
+                "memory budget exceeded, releasing project %s...",
+                m_sessions.back()->m_project_filepath.c_str());
+
+            m_sessions.pop_back();
+        }
+    }
+};
+
+RenderServer::RenderServer(
+    Logger&                         logger,
+    const std::uint16_t             port,
+    const std::uint64_t             memory_budget,
+    const SearchPaths&              resource_search_paths,
+    LoadProjectFunction             load_project,
+    ConfigureProjectFunction        configure_project)
+  : impl(
+        new Impl(
+            logger,
+            port,
+            memory_budget,
+            resource_search_paths,
+            std::move(load_project),
+            std::move(configure_project)))
+{
+}
+
+RenderServer::~RenderServer()
+{
+    delete impl;
+}
+
+bool RenderServer::run()
+{
+    asio::io_service io_service;
+    tcp::acceptor acceptor(io_service);
+
+    // Only accept local connections.
+    const tcp::endpoint endpoint(asio::ip::address_v4::loopback(), impl->m_port);
+
+    boost::system::error_code ec;
+    acceptor.open(endpoint.protocol(), ec);
+    if (!ec)
+        acceptor.set_option(tcp::acceptor::reuse_address(true), ec);
+    if (!ec)
+        acceptor.bind(endpoint, ec);
+    if (!ec)
+        acceptor.listen(asio::socket_base::max_connections, ec);
+    if (ec)
+    {
+        LOG_ERROR(
+            impl->m_logger,
+            "failed to listen on port %u: %s.",
+            static_cast<unsigned int>(impl->m_port),
+            ec.message().c_str());
+        return false;
+    }
+
+    LOG_INFO(
+        impl->m_logger,
+        "render server listening on port %u...",
+        static_cast<unsigned int>(impl->m_port));
+
+    // Requests are served one at a time since each render uses all rendering threads.
+    while (true)
+    {
+        tcp::socket socket(io_service);
+        acceptor.accept(socket, ec);
+        if (ec)
+        {
+            LOG_ERROR(impl->m_logger, "failed to accept connection: %s.", ec.message().c_str());
+            continue;
+        }
+
+        if (!impl->serve(socket))
+            break;
+    }
+
+    return true;
+}
+
+}   // namespace cli
+}   // namespace appleseed
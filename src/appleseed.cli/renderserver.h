@@ -0,0 +1,103 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/api/project.h"
+#include "renderer/api/utility.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/memory/autoreleaseptr.h"
+
+// Standard headers.
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Forward declarations.
+namespace foundation { class Logger; }
+namespace foundation { class SearchPaths; }
+
+namespace appleseed {
+namespace cli {
+
+//
+// A long-running render server.
+//
+// Clients connect to a TCP port on the loopback interface and send one request made of
+// "key value" lines terminated by an empty line:
+//
+//   project <path>             path to the project file (required)
+//   output <path>              write the main and AOV images to this file once rendered
+//   parameter <name>=<value>   override a rendering parameter, like --parameter
+//
+// Tiles are streamed back using the binary tile protocol of --to-stdout, followed by a
+// render result chunk, then the connection is closed. A "shutdown" request line stops
+// the server.
+//
+// Projects and their master renderers are kept alive between requests so that texture
+// caches, OSL shading systems and optimized shader groups, acceleration structures and
+// light samplers stay warm when the same project is rendered again. Least recently used
+// projects are released when the process memory usage exceeds a given budget.
+//
+
+class RenderServer
+  : public foundation::NonCopyable
+{
+  public:
+    typedef std::function<
+        foundation::auto_release_ptr<renderer::Project> (const std::string& project_filepath)
+    > LoadProjectFunction;
+
+    typedef std::function<
+        bool (renderer::Project& project, renderer::ParamArray& params)
+    > ConfigureProjectFunction;
+
+    RenderServer(
+        foundation::Logger&                 logger,
+        const std::uint16_t                 port,
+        const std::uint64_t                 memory_budget,      // in bytes, 0 for no limit
+        const foundation::SearchPaths&      resource_search_paths,
+        LoadProjectFunction                 load_project,
+        ConfigureProjectFunction            configure_project);
+
+    ~RenderServer();
+
+    // Serve requests until a shutdown request is received.
+    // Return false if the server could not be started.
+    bool run();
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}   // namespace cli
+}   // namespace appleseed
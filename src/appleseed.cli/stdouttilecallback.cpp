@@ -59,242 +59,316 @@ namespace cli {
 
 namespace
 {
+    // Do not change the values of the enumerators as this WILL break client compabitility.
+    enum ChunkType
+    {
+        // Protocol v2
+        ChunkTypeTileHighlight          = 10,
+        ChunkTypeTilesHeader            = 11,
+        ChunkTypePlaneDefinition        = 12,
+        ChunkTypeTileData               = 13,
+        ChunkTypeRenderResult           = 14
+    };
+
     //
-    // StdOutTileCallbackFactory.
+    // Tile stream writing to the standard output.
     //
 
-    class StdOutTileCallback
-      : public TileCallbackBase
+    class StdOutTileStream
+      : public ITileStream
     {
       public:
-        explicit StdOutTileCallback(StdOutTileCallbackFactory::TileOutputOptions export_options)
-          : m_header_sent(false)
-          , m_export_options(export_options)
-        {
-        }
-
-        void release() override
+        void begin() override
         {
-            // The factory always return the same tile callback instance.
-            // Prevent this instance from being destroyed by doing nothing here.
-        }
-
-        void on_tile_begin(
-            const Frame*        frame,
-            const size_t        tile_x,
-            const size_t        tile_y,
-            const size_t        thread_index,
-            const size_t        thread_count) override
-        {
-            boost::mutex::scoped_lock lock(m_mutex);
-
 #ifdef _WIN32
-            const int old_stdout_mode = _setmode(_fileno(stdout), _O_BINARY);
+            m_old_stdout_mode = _setmode(_fileno(stdout), _O_BINARY);
 #endif
-            send_highlight_tile(*frame, tile_x, tile_y);
+        }
 
+        void end() override
+        {
             fflush(stdout);
 #ifdef _WIN32
-            _setmode(_fileno(stdout), old_stdout_mode);
+            _setmode(_fileno(stdout), m_old_stdout_mode);
 #endif
         }
 
-        void on_tile_end(
-            const Frame*        frame,
-            const size_t        tile_x,
-            const size_t        tile_y) override
+        void write(const void* data, const size_t size) override
         {
-            boost::mutex::scoped_lock lock(m_mutex);
+            fwrite(data, 1, size, stdout);
+        }
 
+      private:
 #ifdef _WIN32
-            const int old_stdout_mode = _setmode(_fileno(stdout), _O_BINARY);
+        int m_old_stdout_mode;
 #endif
-            send_header(*frame);
-            send_tile(*frame, tile_x, tile_y);
+    };
+}
 
-            fflush(stdout);
-#ifdef _WIN32
-            _setmode(_fileno(stdout), old_stdout_mode);
-#endif
-        }
+void send_render_result(ITileStream& stream, const bool succeeded)
+{
+    const size_t chunk_size = 1 * sizeof(std::uint32_t);
+    const std::uint32_t chunk[] =
+    {
+        static_cast<std::uint32_t>(ChunkTypeRenderResult),
+        static_cast<std::uint32_t>(chunk_size),
+        succeeded ? 1u : 0u
+    };
 
-      private:
-        // Do not change the values of the enumerators as this WILL break client compabitility.
-        enum ChunkType
-        {
-            // Protocol v2
-            ChunkTypeTileHighlight          = 10,
-            ChunkTypeTilesHeader            = 11,
-            ChunkTypePlaneDefinition        = 12,
-            ChunkTypeTileData               = 13
-        };
+    stream.begin();
+    stream.write(chunk, sizeof(chunk));
+    stream.end();
+}
 
-        boost::mutex m_mutex;
 
-        bool m_header_sent;
-        const StdOutTileCallbackFactory::TileOutputOptions m_export_options;
+//
+// StreamTileCallbackFactory class implementation.
+//
 
-        void send_header(const Frame& frame)
-        {
-            if (m_header_sent) return;
-
-            // Build and write tiles header.
-            // This header is sent only once and can contains AOVs and frame informations.
-            const bool beauty_only = (m_export_options == StdOutTileCallbackFactory::TileOutputOptions::BeautyOnly);
-            const size_t chunk_size = 1 * sizeof(std::uint32_t);
-            const size_t plane_count = beauty_only ? 1 : 1 + frame.aovs().size();
-            const std::uint32_t header[] =
-            {
-                static_cast<std::uint32_t>(ChunkTypeTilesHeader),
-                static_cast<std::uint32_t>(chunk_size),
-                static_cast<std::uint32_t>(plane_count),
-            };
-            fwrite(header, sizeof(header), 1, stdout);
+class StreamTileCallbackFactory::StreamTileCallback
+  : public TileCallbackBase
+{
+  public:
+    StreamTileCallback(
+        ITileStream&            stream,
+        const TileOutputOptions export_options)
+      : m_stream(stream)
+      , m_header_sent(false)
+      , m_export_options(export_options)
+    {
+    }
 
-            send_plane_definition(frame.image(), "beauty", 0);
+    void restart()
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_header_sent = false;
+    }
 
-            if (!beauty_only)
-            {
-                for (size_t i = 0, e = frame.aovs().size(); i < e; ++i)
-                {
-                    const AOV* aov = frame.aovs().get_by_index(i);
-
-                    send_plane_definition(
-                        aov->get_image(),
-                        aov->get_name(),
-                        i + 1);
-                }
-            }
+    void release() override
+    {
+        // The factory always return the same tile callback instance.
+        // Prevent this instance from being destroyed by doing nothing here.
+    }
+
+    void on_tile_begin(
+        const Frame*        frame,
+        const size_t        tile_x,
+        const size_t        tile_y,
+        const size_t        thread_index,
+        const size_t        thread_count) override
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
 
-            m_header_sent = true;
-        }
+        m_stream.begin();
+        send_highlight_tile(*frame, tile_x, tile_y);
+        m_stream.end();
+    }
 
-        void send_plane_definition(
-            const Image&        img,
-            const char*         name,
-            const size_t        index) const
+    void on_tile_end(
+        const Frame*        frame,
+        const size_t        tile_x,
+        const size_t        tile_y) override
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        m_stream.begin();
+        send_header(*frame);
+        send_tile(*frame, tile_x, tile_y);
+        m_stream.end();
+    }
+
+  private:
+    ITileStream&            m_stream;
+    boost::mutex            m_mutex;
+    bool                    m_header_sent;
+    const TileOutputOptions m_export_options;
+
+    void send_header(const Frame& frame)
+    {
+        if (m_header_sent) return;
+
+        // Build and write tiles header.
+        // This header is sent only once and can contains AOVs and frame informations.
+        const bool beauty_only = (m_export_options == TileOutputOptions::BeautyOnly);
+        const size_t chunk_size = 1 * sizeof(std::uint32_t);
+        const size_t plane_count = beauty_only ? 1 : 1 + frame.aovs().size();
+        const std::uint32_t header[] =
         {
-            // Build and write AOV header.
-            const size_t name_len = strlen(name);
-            const size_t chunk_size = 3 * sizeof(std::uint32_t) + name_len * sizeof(char);
-            const std::uint32_t header[] =
-            {
-                static_cast<std::uint32_t>(ChunkTypePlaneDefinition),
-                static_cast<std::uint32_t>(chunk_size),
-                static_cast<std::uint32_t>(index),
-                static_cast<std::uint32_t>(name_len),
-                static_cast<std::uint32_t>(img.properties().m_channel_count)
-            };
-            fwrite(header, sizeof(header), 1, stdout);
-            fwrite(name, sizeof(char), name_len, stdout);
-        }
+            static_cast<std::uint32_t>(ChunkTypeTilesHeader),
+            static_cast<std::uint32_t>(chunk_size),
+            static_cast<std::uint32_t>(plane_count),
+        };
+        m_stream.write(header, sizeof(header));
 
-        void send_highlight_tile(
-            const Frame&        frame,
-            const size_t        tile_x,
-            const size_t        tile_y) const
+        send_plane_definition(frame.image(), "beauty", 0);
+
+        if (!beauty_only)
         {
-            // Compute the coordinates in the image of the top-left corner of the tile.
-            const CanvasProperties& frame_props = frame.image().properties();
-            const size_t x = tile_x * frame_props.m_tile_width;
-            const size_t y = tile_y * frame_props.m_tile_height;
-
-            // Retrieve the source tile and its dimensions.
-            const Tile& tile = frame.image().tile(tile_x, tile_y);
-            const size_t w = tile.get_width();
-            const size_t h = tile.get_height();
-
-            // Build and write highlight tile header.
-            // This header is sent to allow highlighting tiles being rendered.
-            const size_t chunk_size = 4 * sizeof(std::uint32_t);
-            const std::uint32_t header[] =
+            for (size_t i = 0, e = frame.aovs().size(); i < e; ++i)
             {
-                static_cast<std::uint32_t>(ChunkTypeTileHighlight),
-                static_cast<std::uint32_t>(chunk_size),
-                static_cast<std::uint32_t>(x),
-                static_cast<std::uint32_t>(y),
-                static_cast<std::uint32_t>(w),
-                static_cast<std::uint32_t>(h)
-            };
-            fwrite(header, sizeof(header), 1, stdout);
+                const AOV* aov = frame.aovs().get_by_index(i);
+
+                send_plane_definition(
+                    aov->get_image(),
+                    aov->get_name(),
+                    i + 1);
+            }
         }
 
-        void send_tile(
-            const Frame&        frame,
-            const size_t        tile_x,
-            const size_t        tile_y) const
+        m_header_sent = true;
+    }
+
+    void send_plane_definition(
+        const Image&        img,
+        const char*         name,
+        const size_t        index) const
+    {
+        // Build and write AOV header.
+        const size_t name_len = strlen(name);
+        const size_t chunk_size = 3 * sizeof(std::uint32_t) + name_len * sizeof(char);
+        const std::uint32_t header[] =
+        {
+            static_cast<std::uint32_t>(ChunkTypePlaneDefinition),
+            static_cast<std::uint32_t>(chunk_size),
+            static_cast<std::uint32_t>(index),
+            static_cast<std::uint32_t>(name_len),
+            static_cast<std::uint32_t>(img.properties().m_channel_count)
+        };
+        m_stream.write(header, sizeof(header));
+        m_stream.write(name, name_len * sizeof(char));
+    }
+
+    void send_highlight_tile(
+        const Frame&        frame,
+        const size_t        tile_x,
+        const size_t        tile_y) const
+    {
+        // Compute the coordinates in the image of the top-left corner of the tile.
+        const CanvasProperties& frame_props = frame.image().properties();
+        const size_t x = tile_x * frame_props.m_tile_width;
+        const size_t y = tile_y * frame_props.m_tile_height;
+
+        // Retrieve the source tile and its dimensions.
+        const Tile& tile = frame.image().tile(tile_x, tile_y);
+        const size_t w = tile.get_width();
+        const size_t h = tile.get_height();
+
+        // Build and write highlight tile header.
+        // This header is sent to allow highlighting tiles being rendered.
+        const size_t chunk_size = 4 * sizeof(std::uint32_t);
+        const std::uint32_t header[] =
+        {
+            static_cast<std::uint32_t>(ChunkTypeTileHighlight),
+            static_cast<std::uint32_t>(chunk_size),
+            static_cast<std::uint32_t>(x),
+            static_cast<std::uint32_t>(y),
+            static_cast<std::uint32_t>(w),
+            static_cast<std::uint32_t>(h)
+        };
+        m_stream.write(header, sizeof(header));
+    }
+
+    void send_tile(
+        const Frame&        frame,
+        const size_t        tile_x,
+        const size_t        tile_y) const
+    {
+        // We assume all AOV images have the same properties as the main image.
+        const CanvasProperties& props = frame.image().properties();
+
+        // Send beauty tile.
+        do_send_tile(
+            props,
+            frame.image().tile(tile_x, tile_y),
+            tile_x,
+            tile_y,
+            0);
+
+        if (m_export_options == TileOutputOptions::AllAOVs)
         {
-            // We assume all AOV images have the same properties as the main image.
-            const CanvasProperties& props = frame.image().properties();
-
-            // Send beauty tile.
-            do_send_tile(
-                props,
-                frame.image().tile(tile_x, tile_y),
-                tile_x,
-                tile_y,
-                0);
-
-            if (m_export_options == StdOutTileCallbackFactory::TileOutputOptions::AllAOVs)
+            // Send AOV tiles.
+            for (size_t i = 0, e = frame.aovs().size(); i < e; ++i)
             {
-                // Send AOV tiles.
-                for (size_t i = 0, e = frame.aovs().size(); i < e; ++i)
-                {
-                    const AOV* aov = frame.aovs().get_by_index(i);
-
-                    do_send_tile(
-                        props,
-                        aov->get_image().tile(tile_x, tile_y),
-                        tile_x,
-                        tile_y,
-                        i + 1);
-                }
+                const AOV* aov = frame.aovs().get_by_index(i);
+
+                do_send_tile(
+                    props,
+                    aov->get_image().tile(tile_x, tile_y),
+                    tile_x,
+                    tile_y,
+                    i + 1);
             }
         }
+    }
+
+    void do_send_tile(
+        const CanvasProperties& properties,
+        const Tile&         tile,
+        const size_t        tile_x,
+        const size_t        tile_y,
+        const size_t        plane_index) const
+    {
+        const size_t x = tile_x * properties.m_tile_width;
+        const size_t y = tile_y * properties.m_tile_height;
+
+        // Retrieve the tile dimensions.
+        const size_t w = tile.get_width();
+        const size_t h = tile.get_height();
+        const size_t c = tile.get_channel_count();
+
+        // Build and write tile header.
+        // This header contains information about the tile AOV that will be written.
+        const size_t chunk_size = 6 * sizeof(std::uint32_t) + w * h * c * sizeof(float);
+        const std::uint32_t header[] =
+        {
+            static_cast<std::uint32_t>(ChunkTypeTileData),
+            static_cast<std::uint32_t>(chunk_size),
+            static_cast<std::uint32_t>(plane_index),
+            static_cast<std::uint32_t>(x),
+            static_cast<std::uint32_t>(y),
+            static_cast<std::uint32_t>(w),
+            static_cast<std::uint32_t>(h),
+            static_cast<std::uint32_t>(c),
+        };
+        m_stream.write(header, sizeof(header));
 
-        void do_send_tile(
-            const CanvasProperties& properties,
-            const Tile&         tile,
-            const size_t        tile_x,
-            const size_t        tile_y,
-            const size_t        plane_index) const
+        // Send tile pixels.
+        if (properties.m_pixel_format != PixelFormatFloat)
         {
-            const size_t x = tile_x * properties.m_tile_width;
-            const size_t y = tile_y * properties.m_tile_height;
-
-            // Retrieve the tile dimensions.
-            const size_t w = tile.get_width();
-            const size_t h = tile.get_height();
-            const size_t c = tile.get_channel_count();
-
-            // Build and write tile header.
-            // This header contains information about the tile AOV that will be written.
-            const size_t chunk_size = 6 * sizeof(std::uint32_t) + w * h * c * sizeof(float);
-            const std::uint32_t header[] =
-            {
-                static_cast<std::uint32_t>(ChunkTypeTileData),
-                static_cast<std::uint32_t>(chunk_size),
-                static_cast<std::uint32_t>(plane_index),
-                static_cast<std::uint32_t>(x),
-                static_cast<std::uint32_t>(y),
-                static_cast<std::uint32_t>(w),
-                static_cast<std::uint32_t>(h),
-                static_cast<std::uint32_t>(c),
-            };
-            fwrite(header, sizeof(header), 1, stdout);
-
-            // Send tile pixels.
-            if (properties.m_pixel_format != PixelFormatFloat)
-            {
-                const Tile tmp(tile, PixelFormatFloat);
-                fwrite(tmp.get_storage(), 1, tmp.get_size(), stdout);
-            }
-            else
-            {
-                fwrite(tile.get_storage(), 1, tile.get_size(), stdout);
-            }
+            const Tile tmp(tile, PixelFormatFloat);
+            m_stream.write(tmp.get_storage(), tmp.get_size());
         }
-    };
+        else
+        {
+            m_stream.write(tile.get_storage(), tile.get_size());
+        }
+    }
+};
+
+StreamTileCallbackFactory::StreamTileCallbackFactory(
+    ITileStream&            stream,
+    const TileOutputOptions export_options)
+  : m_callback(new StreamTileCallback(stream, export_options))
+{
+}
+
+StreamTileCallbackFactory::~StreamTileCallbackFactory()
+{
+}
+
+void StreamTileCallbackFactory::release()
+{
+    delete this;
+}
+
+ITileCallback* StreamTileCallbackFactory::create()
+{
+    return m_callback.get();
+}
+
+void StreamTileCallbackFactory::restart()
+{
+    m_callback->restart();
 }
 
 
@@ -303,7 +377,8 @@ namespace
 //
 
 StdOutTileCallbackFactory::StdOutTileCallbackFactory(TileOutputOptions export_options)
-  : m_callback(new StdOutTileCallback(export_options))
+  : m_stream(new StdOutTileStream())
+  , m_factory(new StreamTileCallbackFactory(*m_stream, export_options))
 {
 }
 
@@ -314,7 +389,7 @@ void StdOutTileCallbackFactory::release()
 
 ITileCallback* StdOutTileCallbackFactory::create()
 {
-    return m_callback.get();
+    return m_factory->create();
 }
 
 }   // namespace cli
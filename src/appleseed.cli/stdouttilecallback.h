@@ -32,20 +32,73 @@
 #include "renderer/api/rendering.h"
 
 // Standard headers.
+#include <cstddef>
 #include <memory>
 
 namespace appleseed {
 namespace cli {
 
+enum class TileOutputOptions
+{
+    BeautyOnly,
+    AllAOVs
+};
+
+//
+// A destination for tiles sent using the binary tile protocol.
+//
+
+class ITileStream
+{
+  public:
+    virtual ~ITileStream() {}
+
+    // Called before and after writing the chunks of a tile event.
+    virtual void begin() {}
+    virtual void end() {}
+
+    virtual void write(const void* data, const size_t size) = 0;
+};
+
+// Write a chunk reporting the outcome of a render. Must follow the last tile of the render.
+void send_render_result(ITileStream& stream, const bool succeeded);
+
+//
+// Tile callback factory sending tiles to an arbitrary tile stream.
+//
+
+class StreamTileCallbackFactory
+  : public renderer::ITileCallbackFactory
+{
+  public:
+    StreamTileCallbackFactory(
+        ITileStream&            stream,
+        const TileOutputOptions export_options);
+
+    ~StreamTileCallbackFactory() override;
+
+    void release() override;
+
+    renderer::ITileCallback* create() override;
+
+    // Send the tiles header again with the next tile, e.g. when a new render begins.
+    void restart();
+
+  private:
+    class StreamTileCallback;
+
+    std::unique_ptr<StreamTileCallback> m_callback;
+};
+
+//
+// Tile callback factory sending tiles to the standard output.
+//
+
 class StdOutTileCallbackFactory
   : public renderer::ITileCallbackFactory
 {
   public:
-    enum class TileOutputOptions
-    {
-        BeautyOnly,
-        AllAOVs
-    };
+    using TileOutputOptions = cli::TileOutputOptions;
 
     explicit StdOutTileCallbackFactory(TileOutputOptions export_options);
 
@@ -54,7 +107,8 @@ class StdOutTileCallbackFactory
     renderer::ITileCallback* create() override;
 
   private:
-    std::unique_ptr<renderer::ITileCallback> m_callback;
+    std::unique_ptr<ITileStream>                m_stream;
+    std::unique_ptr<StreamTileCallbackFactory>  m_factory;
 };
 
 }   // namespace cli
@@ -30,6 +30,7 @@
 // appleseed.python headers.
 #include "bindentitycontainers.h"
 #include "dict2dict.h"
+#include "gillocks.h"
 
 // appleseed.renderer headers.
 #include "renderer/modeling/scene/assembly.h"
@@ -114,6 +115,48 @@ namespace
     {
         return instance->get_assembly_name();
     }
+
+    //
+    // The following operations may process many entities and don't call back into Python:
+    // they release Python's global interpreter lock (GIL) so that other Python threads,
+    // for instance threads building other staging assemblies, can run in the meantime.
+    //
+
+    void base_group_clear(BaseGroup* group)
+    {
+        ScopedGILUnlock unlock;
+        group->clear();
+    }
+
+    void base_group_merge(BaseGroup* group, BaseGroup* source)
+    {
+        ScopedGILUnlock unlock;
+        group->merge(*source);
+    }
+
+    void assembly_clear(Assembly* assembly)
+    {
+        ScopedGILUnlock unlock;
+        assembly->clear();
+    }
+
+    void assembly_merge(Assembly* assembly, Assembly* source)
+    {
+        ScopedGILUnlock unlock;
+        assembly->merge(*source);
+    }
+
+    GAABB3 assembly_compute_local_bbox(const Assembly* assembly)
+    {
+        ScopedGILUnlock unlock;
+        return assembly->compute_local_bbox();
+    }
+
+    GAABB3 assembly_compute_non_hierarchical_local_bbox(const Assembly* assembly)
+    {
+        ScopedGILUnlock unlock;
+        return assembly->compute_non_hierarchical_local_bbox();
+    }
 }
 
 void bind_assembly()
@@ -125,7 +168,8 @@ void bind_assembly()
         .def("shader_groups", &BaseGroup::shader_groups, bpy::return_value_policy<bpy::reference_existing_object>())
         .def("assemblies", &BaseGroup::assemblies, bpy::return_value_policy<bpy::reference_existing_object>())
         .def("assembly_instances", &BaseGroup::assembly_instances, bpy::return_value_policy<bpy::reference_existing_object>())
-        .def("clear", &BaseGroup::clear);
+        .def("clear", base_group_clear)
+        .def("merge", base_group_merge);
 
     bpy::class_<Assembly, auto_release_ptr<Assembly>, bpy::bases<Entity, BaseGroup>, boost::noncopyable>("Assembly", bpy::no_init)
         .def("__init__", bpy::make_constructor(create_assembly))
@@ -140,9 +184,10 @@ void bind_assembly()
         .def("objects", &Assembly::objects, bpy::return_value_policy<bpy::reference_existing_object>())
         .def("object_instances", &Assembly::object_instances, bpy::return_value_policy<bpy::reference_existing_object>())
         .def("volumes", &Assembly::volumes, bpy::return_value_policy<bpy::reference_existing_object>())
-        .def("clear", &Assembly::clear)
-        .def("compute_local_bbox", &Assembly::compute_local_bbox)
-        .def("compute_non_hierarchical_local_bbox", &Assembly::compute_non_hierarchical_local_bbox);
+        .def("clear", assembly_clear)
+        .def("merge", assembly_merge)
+        .def("compute_local_bbox", assembly_compute_local_bbox)
+        .def("compute_non_hierarchical_local_bbox", assembly_compute_non_hierarchical_local_bbox);
 
     bind_typed_entity_map<Assembly>("AssemblyContainer");
 
@@ -132,6 +132,72 @@ namespace
         return c_array_to_py_array(data.get(), tile->get_pixel_format(), tile->get_size());
     }
 
+#if PY_MAJOR_VERSION >= 3
+
+    // Return the struct module format character of a pixel format.
+    const char* python_buffer_format(PixelFormat format)
+    {
+        switch (format)
+        {
+          case PixelFormatUInt8:
+            return "B";
+
+          case PixelFormatUInt16:
+            return "H";
+
+          case PixelFormatUInt32:
+            return "I";
+
+          case PixelFormatHalf:
+            return "e";
+
+          case PixelFormatFloat:
+            return "f";
+
+          case PixelFormatDouble:
+            return "d";
+
+          default:
+            assert(false);
+            return nullptr;
+        }
+    }
+
+    // Return a read-only memoryview of shape (height, width, channels) over the pixels
+    // of the tile, without copying them. numpy.asarray() accepts it directly.
+    // The view keeps the Python tile object alive, but like the tile itself, it is
+    // only valid as long as the image or frame the tile belongs to.
+    bpy::object tile_get_storage_view(const Tile* tile)
+    {
+        const size_t channel_size = Pixel::size(tile->get_pixel_format());
+
+        Py_ssize_t shape[3];
+        shape[0] = static_cast<Py_ssize_t>(tile->get_height());
+        shape[1] = static_cast<Py_ssize_t>(tile->get_width());
+        shape[2] = static_cast<Py_ssize_t>(tile->get_channel_count());
+
+        Py_ssize_t strides[3];
+        strides[2] = static_cast<Py_ssize_t>(channel_size);
+        strides[1] = strides[2] * shape[2];
+        strides[0] = strides[1] * shape[1];
+
+        // The memoryview copies the shape and strides arrays but not the format string.
+        Py_buffer buffer;
+        std::memset(&buffer, 0, sizeof(Py_buffer));
+        buffer.buf = tile->get_storage();
+        buffer.len = static_cast<Py_ssize_t>(tile->get_size());
+        buffer.itemsize = static_cast<Py_ssize_t>(channel_size);
+        buffer.readonly = 1;
+        buffer.ndim = 3;
+        buffer.format = const_cast<char*>(python_buffer_format(tile->get_pixel_format()));
+        buffer.shape = shape;
+        buffer.strides = strides;
+
+        return bpy::object(bpy::handle<>(PyMemoryView_FromBuffer(&buffer)));
+    }
+
+#endif
+
     std::string image_stack_get_name(const ImageStack* image_stack, const size_t index)
     {
         return image_stack->get_name(index);
@@ -176,7 +242,12 @@ void bind_image()
         .def("get_channel_count", &Tile::get_channel_count)
         .def("get_pixel_count", &Tile::get_pixel_count)
         .def("get_size", &Tile::get_size)
-        .def("get_storage", tile_get_storage);
+        .def("get_storage", tile_get_storage)
+#if PY_MAJOR_VERSION >= 3
+        // Python 2 memoryviews are not weak-referenceable, which the call policy requires.
+        .def("get_storage_view", tile_get_storage_view, bpy::with_custodian_and_ward_postcall<0, 1>())
+#endif
+        ;
 
     const Tile& (Image::*image_get_tile)(const size_t, const size_t) const = &Image::tile;
 
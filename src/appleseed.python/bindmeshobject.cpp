@@ -35,12 +35,17 @@
 #include "renderer/api/object.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/hash/murmurhash.h"
+#include "foundation/math/vector.h"
 #include "foundation/platform/python.h"
 #include "foundation/utility/searchpaths.h"
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
 
 namespace bpy = boost::python;
@@ -68,6 +73,279 @@ namespace
         object->get_triangle(index) = triangle;
     }
 
+    //
+    // Bulk mesh construction from any object exposing a C-contiguous buffer
+    // (NumPy arrays, array.array, memoryview...), without per-element Python calls.
+    //
+
+    class ScopedPyBuffer
+      : public NonCopyable
+    {
+      public:
+        ScopedPyBuffer(const bpy::object& object, const char* name)
+          : m_name(name)
+        {
+            if (PyObject_GetBuffer(object.ptr(), &m_buffer, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0)
+                bpy::throw_error_already_set();
+
+            // Only accept native byte order.
+            const char* format = m_buffer.format != nullptr ? m_buffer.format : "B";
+            if (*format == '@' || *format == '=' || *format == (is_little_endian() ? '<' : '>'))
+                ++format;
+
+            m_format = std::strlen(format) == 1 ? *format : '\0';
+        }
+
+        ~ScopedPyBuffer()
+        {
+            PyBuffer_Release(&m_buffer);
+        }
+
+        // Return the number of items of a given number of components, e.g. 3 for vertices.
+        size_t get_item_count(const size_t component_count) const
+        {
+            const size_t value_count = static_cast<size_t>(m_buffer.len / m_buffer.itemsize);
+
+            if (value_count % component_count != 0 ||
+                (m_buffer.ndim > 1 && m_buffer.shape[m_buffer.ndim - 1] != static_cast<Py_ssize_t>(component_count)))
+                raise(PyExc_ValueError, "has an invalid shape");
+
+            return value_count / component_count;
+        }
+
+        // Raise a TypeError unless the buffer contains float32 or float64 values.
+        void require_scalars() const
+        {
+            if (!(m_format == 'f' && m_buffer.itemsize == 4) &&
+                !(m_format == 'd' && m_buffer.itemsize == 8))
+                raise(PyExc_TypeError, "must contain float32 or float64 values");
+        }
+
+        // Raise a TypeError unless the buffer contains integer values.
+        void require_indices() const
+        {
+            if (m_format == '\0' || std::strchr("bBhHiIlLqQ", m_format) == nullptr)
+                raise(PyExc_TypeError, "must contain integer values");
+        }
+
+        GScalar get_scalar(const size_t index) const
+        {
+            return
+                m_buffer.itemsize == 4
+                    ? static_cast<GScalar>(static_cast<const float*>(m_buffer.buf)[index])
+                    : static_cast<GScalar>(static_cast<const double*>(m_buffer.buf)[index]);
+        }
+
+        // Raise an IndexError if the value is negative or doesn't fit in a triangle index.
+        size_t get_index(const size_t index) const
+        {
+            const void* buf = m_buffer.buf;
+            std::int64_t value;
+
+            switch (m_buffer.itemsize)
+            {
+              case 1:
+                value = is_signed() ? static_cast<const std::int8_t*>(buf)[index] : static_cast<const std::uint8_t*>(buf)[index];
+                break;
+
+              case 2:
+                value = is_signed() ? static_cast<const std::int16_t*>(buf)[index] : static_cast<const std::uint16_t*>(buf)[index];
+                break;
+
+              case 4:
+                value = is_signed() ? static_cast<const std::int32_t*>(buf)[index] : static_cast<const std::uint32_t*>(buf)[index];
+                break;
+
+              default:
+                value = static_cast<const std::int64_t*>(buf)[index];
+                break;
+            }
+
+            if (value < 0 || value >= std::int64_t(Triangle::None))
+                raise(PyExc_IndexError, "contains an out of range index");
+
+            return static_cast<size_t>(value);
+        }
+
+        void raise(PyObject* exception, const char* message) const
+        {
+            const std::string error = std::string(m_name) + " " + message;
+            PyErr_SetString(exception, error.c_str());
+            bpy::throw_error_already_set();
+        }
+
+      private:
+        const char*     m_name;
+        Py_buffer       m_buffer;
+        char            m_format;
+
+        bool is_signed() const
+        {
+            return m_format >= 'a' && m_format <= 'z';
+        }
+
+        static bool is_little_endian()
+        {
+            const std::uint16_t value = 1;
+            return *reinterpret_cast<const std::uint8_t*>(&value) == 1;
+        }
+    };
+
+    size_t push_vertex_array(MeshObject* object, const bpy::object& vertices)
+    {
+        const ScopedPyBuffer buffer(vertices, "vertices");
+        buffer.require_scalars();
+        const size_t count = buffer.get_item_count(3);
+        const size_t base = object->get_vertex_count();
+
+        object->reserve_vertices(base + count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            object->push_vertex(
+                GVector3(
+                    buffer.get_scalar(i * 3 + 0),
+                    buffer.get_scalar(i * 3 + 1),
+                    buffer.get_scalar(i * 3 + 2)));
+        }
+
+        return base;
+    }
+
+    size_t push_vertex_normal_array(MeshObject* object, const bpy::object& normals)
+    {
+        const ScopedPyBuffer buffer(normals, "normals");
+        buffer.require_scalars();
+        const size_t count = buffer.get_item_count(3);
+        const size_t base = object->get_vertex_normal_count();
+
+        object->reserve_vertex_normals(base + count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const GVector3 n(
+                buffer.get_scalar(i * 3 + 0),
+                buffer.get_scalar(i * 3 + 1),
+                buffer.get_scalar(i * 3 + 2));
+
+            // Normals must be unit-length; exporters seldom guarantee it to full precision.
+            object->push_vertex_normal(safe_normalize(n));
+        }
+
+        return base;
+    }
+
+    size_t push_tex_coords_array(MeshObject* object, const bpy::object& tex_coords)
+    {
+        const ScopedPyBuffer buffer(tex_coords, "tex_coords");
+        buffer.require_scalars();
+        const size_t count = buffer.get_item_count(2);
+        const size_t base = object->get_tex_coords_count();
+
+        object->reserve_tex_coords(base + count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            object->push_tex_coords(
+                GVector2(
+                    buffer.get_scalar(i * 2 + 0),
+                    buffer.get_scalar(i * 2 + 1)));
+        }
+
+        return base;
+    }
+
+    // Optional per-triangle index buffer (a triplet per triangle, or one index per triangle).
+    class OptionalIndices
+      : public NonCopyable
+    {
+      public:
+        OptionalIndices(
+            const bpy::object&  object,
+            const char*         name,
+            const size_t        triangle_count,
+            const size_t        component_count,
+            const size_t        max_index)
+          : m_max_index(max_index)
+        {
+            if (object.is_none())
+                return;
+
+            m_buffer.reset(new ScopedPyBuffer(object, name));
+            m_buffer->require_indices();
+
+            if (m_buffer->get_item_count(component_count) != triangle_count)
+                m_buffer->raise(PyExc_ValueError, "must have one entry per triangle");
+        }
+
+        bool empty() const
+        {
+            return !m_buffer;
+        }
+
+        size_t get(const size_t index, const size_t default_value) const
+        {
+            if (!m_buffer)
+                return default_value;
+
+            const size_t value = m_buffer->get_index(index);
+
+            if (value >= m_max_index)
+                m_buffer->raise(PyExc_IndexError, "contains an out of range index");
+
+            return value;
+        }
+
+      private:
+        const size_t                    m_max_index;
+        std::unique_ptr<ScopedPyBuffer> m_buffer;
+    };
+
+    size_t push_triangle_array(
+        MeshObject*         object,
+        const bpy::object&  vertex_indices,
+        const bpy::object&  normal_indices,
+        const bpy::object&  tex_coords_indices,
+        const bpy::object&  material_slots)
+    {
+        const ScopedPyBuffer v_buffer(vertex_indices, "vertex_indices");
+        v_buffer.require_indices();
+        const size_t count = v_buffer.get_item_count(3);
+        const size_t vertex_count = object->get_vertex_count();
+
+        const OptionalIndices n(normal_indices, "normal_indices", count, 3, object->get_vertex_normal_count());
+        const OptionalIndices a(tex_coords_indices, "tex_coords_indices", count, 3, object->get_tex_coords_count());
+        const OptionalIndices pa(material_slots, "material_slots", count, 1, Triangle::None);
+
+        const size_t base = object->get_triangle_count();
+
+        object->reserve_triangles(base + count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            Triangle triangle;
+
+            triangle.m_v0 = static_cast<std::uint32_t>(v_buffer.get_index(i * 3 + 0));
+            triangle.m_v1 = static_cast<std::uint32_t>(v_buffer.get_index(i * 3 + 1));
+            triangle.m_v2 = static_cast<std::uint32_t>(v_buffer.get_index(i * 3 + 2));
+
+            if (triangle.m_v0 >= vertex_count || triangle.m_v1 >= vertex_count || triangle.m_v2 >= vertex_count)
+                v_buffer.raise(PyExc_IndexError, "contains an out of range index");
+
+            triangle.m_n0 = static_cast<std::uint32_t>(n.get(i * 3 + 0, Triangle::None));
+            triangle.m_n1 = static_cast<std::uint32_t>(n.get(i * 3 + 1, Triangle::None));
+            triangle.m_n2 = static_cast<std::uint32_t>(n.get(i * 3 + 2, Triangle::None));
+            triangle.m_a0 = static_cast<std::uint32_t>(a.get(i * 3 + 0, Triangle::None));
+            triangle.m_a1 = static_cast<std::uint32_t>(a.get(i * 3 + 1, Triangle::None));
+            triangle.m_a2 = static_cast<std::uint32_t>(a.get(i * 3 + 2, Triangle::None));
+            triangle.m_pa = static_cast<std::uint32_t>(pa.get(i, 0));
+
+            object->push_triangle(triangle);
+        }
+
+        return base;
+    }
+
     bpy::list read_mesh_objects(
         const bpy::list&      search_paths,
         const std::string&    base_object_name,
@@ -179,6 +457,15 @@ void bind_mesh_object()
         .def("get_triangle", get_triangle, bpy::return_value_policy<bpy::reference_existing_object>())
         .def("set_triangle", set_triangle)
 
+        .def("push_vertex_array", push_vertex_array)
+        .def("push_vertex_normal_array", push_vertex_normal_array)
+        .def("push_tex_coords_array", push_tex_coords_array)
+        .def("push_triangle_array", push_triangle_array,
+            (bpy::arg("vertex_indices"),
+             bpy::arg("normal_indices") = bpy::object(),
+             bpy::arg("tex_coords_indices") = bpy::object(),
+             bpy::arg("material_slots") = bpy::object()))
+
         .def("set_motion_segment_count", &MeshObject::set_motion_segment_count)
         .def("get_motion_segment_count", &MeshObject::get_motion_segment_count)
 
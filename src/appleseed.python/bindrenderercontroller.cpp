@@ -38,6 +38,9 @@
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/python.h"
 
+// Standard headers.
+#include <cstddef>
+
 namespace bpy = boost::python;
 using namespace foundation;
 using namespace renderer;
@@ -193,6 +196,26 @@ namespace
                 return AbortRendering;
             }
         }
+
+        size_t get_active_thread_count() const override
+        {
+            // Lock Python's global interpreter lock (GIL),
+            // it was released in MasterRenderer.render.
+            ScopedGILLock lock;
+
+            try
+            {
+                // Controllers written before this method existed don't override it.
+                if (bpy::override f = get_override("get_active_thread_count"))
+                    return f();
+            }
+            catch (bpy::error_already_set)
+            {
+                PyErr_Print();
+            }
+
+            return 0;
+        }
     };
 }
 
@@ -213,7 +236,8 @@ void bind_renderer_controller()
         .def("on_frame_begin", bpy::pure_virtual(&IRendererController::on_frame_begin))
         .def("on_frame_end", bpy::pure_virtual(&IRendererController::on_frame_end))
         .def("on_progress", bpy::pure_virtual(&IRendererController::on_progress))
-        .def("get_status", bpy::pure_virtual(&IRendererController::get_status));
+        .def("get_status", bpy::pure_virtual(&IRendererController::get_status))
+        .def("get_active_thread_count", bpy::pure_virtual(&IRendererController::get_active_thread_count));
 
     bpy::class_<DefaultRendererController, boost::noncopyable>("DefaultRendererController");
 }
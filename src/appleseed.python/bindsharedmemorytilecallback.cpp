@@ -0,0 +1,166 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.python headers.
+#include "gillocks.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/rendering.h"
+
+// appleseed.foundation headers.
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/platform/python.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace bpy = boost::python;
+using namespace foundation;
+using namespace renderer;
+
+namespace
+{
+    auto_release_ptr<SharedMemoryTileCallback> create_shared_memory_tile_callback(
+        const char*     name,
+        const bool      include_aovs)
+    {
+        return auto_release_ptr<SharedMemoryTileCallback>(new SharedMemoryTileCallback(name, include_aovs));
+    }
+
+    auto_release_ptr<SharedMemoryTileCallback> create_shared_memory_tile_callback_with_aovs(const char* name)
+    {
+        return create_shared_memory_tile_callback(name, true);
+    }
+
+    bpy::dict reader_get_header(const SharedMemoryFrameReader* reader)
+    {
+        const SharedFrameHeader& header = reader->get_header();
+
+        bpy::list planes;
+        for (std::uint32_t i = 0; i < header.m_plane_count; ++i)
+        {
+            bpy::dict plane;
+            plane["name"] = header.m_planes[i].m_name;
+            plane["channel_count"] = header.m_planes[i].m_channel_count;
+            planes.append(plane);
+        }
+
+        bpy::dict result;
+        result["frame_width"] = header.m_frame_width;
+        result["frame_height"] = header.m_frame_height;
+        result["tile_width"] = header.m_tile_width;
+        result["tile_height"] = header.m_tile_height;
+        result["planes"] = planes;
+        return result;
+    }
+
+    bool reader_wait(SharedMemoryFrameReader* reader, const double timeout)
+    {
+        ScopedGILUnlock unlock;
+        return reader->wait(timeout);
+    }
+
+    // Return a tuple (complete, events) where each event is a tuple (type, x, y, width, height).
+    bpy::tuple reader_read_events(SharedMemoryFrameReader* reader)
+    {
+        std::vector<SharedTileEvent> events;
+        const bool complete = reader->read_events(events);
+
+        bpy::list result;
+        for (const SharedTileEvent& e : events)
+            result.append(bpy::make_tuple(e.m_type, e.m_x, e.m_y, e.m_width, e.m_height));
+
+        return bpy::make_tuple(complete, result);
+    }
+
+#if PY_MAJOR_VERSION >= 3
+
+    // Return a read-only memoryview of shape (height, width, channels) over the pixels of
+    // a plane, without copying them. The view keeps the reader alive.
+    bpy::object reader_get_plane_view(const SharedMemoryFrameReader* reader, const size_t plane_index)
+    {
+        const SharedFrameHeader& header = reader->get_header();
+
+        if (plane_index >= header.m_plane_count)
+        {
+            PyErr_SetString(PyExc_IndexError, "Invalid plane index");
+            bpy::throw_error_already_set();
+        }
+
+        Py_ssize_t shape[3];
+        shape[0] = static_cast<Py_ssize_t>(header.m_frame_height);
+        shape[1] = static_cast<Py_ssize_t>(header.m_frame_width);
+        shape[2] = static_cast<Py_ssize_t>(header.m_planes[plane_index].m_channel_count);
+
+        Py_ssize_t strides[3];
+        strides[2] = static_cast<Py_ssize_t>(sizeof(float));
+        strides[1] = strides[2] * shape[2];
+        strides[0] = strides[1] * shape[1];
+
+        // The memoryview copies the shape and strides arrays but not the format string.
+        Py_buffer buffer;
+        std::memset(&buffer, 0, sizeof(Py_buffer));
+        buffer.buf = const_cast<float*>(reader->get_plane_pixels(plane_index));
+        buffer.len = strides[0] * shape[0];
+        buffer.itemsize = static_cast<Py_ssize_t>(sizeof(float));
+        buffer.readonly = 1;
+        buffer.ndim = 3;
+        buffer.format = const_cast<char*>("f");
+        buffer.shape = shape;
+        buffer.strides = strides;
+
+        return bpy::object(bpy::handle<>(PyMemoryView_FromBuffer(&buffer)));
+    }
+
+#endif
+}
+
+void bind_shared_memory_tile_callback()
+{
+    bpy::class_<SharedMemoryTileCallback, auto_release_ptr<SharedMemoryTileCallback>, bpy::bases<ITileCallback>, boost::noncopyable>("SharedMemoryTileCallback", bpy::no_init)
+        .def("__init__", bpy::make_constructor(create_shared_memory_tile_callback))
+        .def("__init__", bpy::make_constructor(create_shared_memory_tile_callback_with_aovs));
+
+    bpy::enum_<SharedTileEventType>("SharedTileEventType")
+        .value("FrameBegin", SharedTileEventFrameBegin)
+        .value("TileBegin", SharedTileEventTileBegin)
+        .value("TileUpdate", SharedTileEventTileUpdate)
+        .value("FrameEnd", SharedTileEventFrameEnd);
+
+    bpy::class_<SharedMemoryFrameReader, boost::noncopyable>("SharedMemoryFrameReader", bpy::init<const char*>())
+        .def("get_header", reader_get_header)
+        .def("is_closed", &SharedMemoryFrameReader::is_closed)
+        .def("wait", reader_wait)
+        .def("read_events", reader_read_events)
+#if PY_MAJOR_VERSION >= 3
+        .def("get_plane_view", reader_get_plane_view, bpy::with_custodian_and_ward_postcall<0, 1>())
+#endif
+        ;
+}
@@ -37,10 +37,17 @@
 // appleseed.foundation headers.
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/python.h"
+#include "foundation/platform/thread.h"
+
+// Boost headers.
+#include "boost/thread/condition_variable.hpp"
 
 // Standard headers.
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace bpy = boost::python;
 using namespace foundation;
@@ -48,23 +55,48 @@ using namespace renderer;
 
 namespace
 {
+    //
+    // Tile begin/end notifications are emitted by render threads. Rather than having every
+    // render thread wait for the GIL, they are queued and delivered in batches by a notifier
+    // thread that runs between on_tiled_frame_begin() and on_tiled_frame_end(). In addition,
+    // notifications that are not overridden in Python are not queued at all.
+    //
+
     class ITileCallbackWrapper
       : public ITileCallback
       , public bpy::wrapper<ITileCallback>
     {
       public:
+        ITileCallbackWrapper()
+          : m_has_tile_begin_override(true)
+          , m_has_tile_end_override(true)
+          , m_stop_notifier(false)
+        {
+        }
+
         void release() override
         {
+            // The frame renderer always pairs on_tiled_frame_begin() with on_tiled_frame_end().
+            assert(!m_notifier_thread);
+
             delete this;
         }
 
         void on_tiled_frame_begin(const Frame* frame) override
         {
-            // Lock Python's global interpreter lock (it was released in MasterRenderer.render).
-            ScopedGILLock lock;
+            {
+                // Lock Python's global interpreter lock (it was released in MasterRenderer.render).
+                ScopedGILLock lock;
 
-            if (bpy::override f = this->get_override("on_tiled_frame_begin"))
-                f(bpy::ptr(frame));
+                m_has_tile_begin_override = has_override("on_tile_begin");
+                m_has_tile_end_override = has_override("on_tile_end");
+
+                if (bpy::override f = this->get_override("on_tiled_frame_begin"))
+                    f(bpy::ptr(frame));
+            }
+
+            if (m_has_tile_begin_override || m_has_tile_end_override)
+                start_notifier();
         }
 
         void default_on_tiled_frame_begin(const Frame* frame)
@@ -73,6 +105,10 @@ namespace
 
         void on_tiled_frame_end(const Frame* frame) override
         {
+            // Deliver pending tile notifications first. The notifier thread needs the GIL,
+            // so this must be done before we lock it.
+            stop_notifier();
+
             // Lock Python's global interpreter lock (it was released in MasterRenderer.render).
             ScopedGILLock lock;
 
@@ -91,11 +127,8 @@ namespace
             const size_t            thread_index,
             const size_t            thread_count) override
         {
-            // Lock Python's global interpreter lock (it was released in MasterRenderer.render).
-            ScopedGILLock lock;
-
-            if (bpy::override f = this->get_override("on_tile_begin"))
-                f(bpy::ptr(frame), tile_x, tile_y, thread_index, thread_count);
+            if (m_has_tile_begin_override)
+                post_tile_event(TileEvent(TileEvent::Begin, frame, tile_x, tile_y, thread_index, thread_count));
         }
 
         void default_on_tile_begin(
@@ -112,11 +145,8 @@ namespace
             const size_t            tile_x,
             const size_t            tile_y) override
         {
-            // Lock Python's global interpreter lock (it was released in MasterRenderer.render).
-            ScopedGILLock lock;
-
-            if (bpy::override f = this->get_override("on_tile_end"))
-                f(bpy::ptr(frame), tile_x, tile_y);
+            if (m_has_tile_end_override)
+                post_tile_event(TileEvent(TileEvent::End, frame, tile_x, tile_y, 0, 0));
         }
 
         void default_on_tile_end(
@@ -159,6 +189,151 @@ namespace
             const std::uint64_t     samples_per_second)
         {
         }
+
+      private:
+        struct TileEvent
+        {
+            enum Type { Begin, End };
+
+            Type                    m_type;
+            const Frame*            m_frame;
+            size_t                  m_tile_x;
+            size_t                  m_tile_y;
+            size_t                  m_thread_index;
+            size_t                  m_thread_count;
+
+            TileEvent(
+                const Type          type,
+                const Frame*        frame,
+                const size_t        tile_x,
+                const size_t        tile_y,
+                const size_t        thread_index,
+                const size_t        thread_count)
+              : m_type(type)
+              , m_frame(frame)
+              , m_tile_x(tile_x)
+              , m_tile_y(tile_y)
+              , m_thread_index(thread_index)
+              , m_thread_count(thread_count)
+            {
+            }
+        };
+
+        // Written with the GIL held, outside of tiled frames.
+        bool                            m_has_tile_begin_override;
+        bool                            m_has_tile_end_override;
+
+        boost::mutex                    m_mutex;
+        boost::condition_variable       m_event_available;
+        std::vector<TileEvent>          m_pending_events;
+        bool                            m_stop_notifier;
+        std::unique_ptr<boost::thread>  m_notifier_thread;
+
+        // The GIL must be locked.
+        bool has_override(const char* name) const
+        {
+            return this->get_override(name) ? true : false;
+        }
+
+        void start_notifier()
+        {
+            assert(!m_notifier_thread);
+
+            m_stop_notifier = false;
+            m_notifier_thread.reset(
+                new boost::thread(&ITileCallbackWrapper::run_notifier, this));
+        }
+
+        // The GIL must not be locked.
+        void stop_notifier()
+        {
+            if (!m_notifier_thread)
+                return;
+
+            {
+                boost::mutex::scoped_lock lock(m_mutex);
+                m_stop_notifier = true;
+            }
+
+            m_event_available.notify_one();
+            m_notifier_thread->join();
+            m_notifier_thread.reset();
+        }
+
+        void post_tile_event(const TileEvent& event)
+        {
+            if (!m_notifier_thread)
+            {
+                // Not in a tiled frame: deliver the notification right away.
+                // Lock Python's global interpreter lock (it was released in MasterRenderer.render).
+                ScopedGILLock lock;
+                deliver_tile_event(event);
+                return;
+            }
+
+            {
+                boost::mutex::scoped_lock lock(m_mutex);
+                m_pending_events.push_back(event);
+            }
+
+            m_event_available.notify_one();
+        }
+
+        void run_notifier()
+        {
+            set_current_thread_name("tile_callback");
+
+            std::vector<TileEvent> events;
+
+            while (true)
+            {
+                {
+                    boost::mutex::scoped_lock lock(m_mutex);
+
+                    while (m_pending_events.empty() && !m_stop_notifier)
+                        m_event_available.wait(lock);
+
+                    // All pending notifications are delivered before stopping.
+                    if (m_pending_events.empty())
+                        break;
+
+                    events.swap(m_pending_events);
+                }
+
+                // Lock Python's global interpreter lock (it was released in MasterRenderer.render).
+                ScopedGILLock lock;
+
+                for (const TileEvent& event : events)
+                {
+                    try
+                    {
+                        deliver_tile_event(event);
+                    }
+                    catch (const bpy::error_already_set&)
+                    {
+                        // There is nobody to propagate the exception to on this thread.
+                        PyErr_Print();
+                    }
+                }
+
+                events.clear();
+            }
+        }
+
+        // The GIL must be locked.
+        void deliver_tile_event(const TileEvent& event)
+        {
+            if (event.m_type == TileEvent::Begin)
+            {
+                if (bpy::override f = this->get_override("on_tile_begin"))
+                    f(bpy::ptr(event.m_frame), event.m_tile_x, event.m_tile_y, event.m_thread_index, event.m_thread_count);
+            }
+            else
+            {
+                if (bpy::override f = this->get_override("on_tile_end"))
+                    f(bpy::ptr(event.m_frame), event.m_tile_x, event.m_tile_y);
+            }
+        }
     };
 }
 
@@ -33,6 +33,7 @@
 #include "renderer/utility/oiiomaketexture.h"
 
 // appleseed.foundation headers.
+#include "foundation/memory/memorytracker.h"
 #include "foundation/platform/python.h"
 #include "foundation/utility/api/apistring.h"
 
@@ -63,6 +64,23 @@ namespace
         if (!success)
             PyErr_SetString(PyExc_RuntimeError, error_msg.c_str());
     }
+
+    bpy::dict get_memory_usage()
+    {
+        const MemoryTracker& tracker = global_memory_tracker();
+
+        bpy::dict result;
+
+        for (size_t i = 0, e = tracker.get_category_count(); i < e; ++i)
+        {
+            bpy::dict category;
+            category["current"] = tracker.get_current_size(i);
+            category["peak"] = tracker.get_peak_size(i);
+            result[tracker.get_category_name(i)] = category;
+        }
+
+        return result;
+    }
 }
 
 void bind_utility()
@@ -86,4 +104,6 @@ void bind_utility()
     bpy::def("global_logger", global_logger, bpy::return_value_policy<bpy::reference_existing_object>());
 
     bpy::def("oiio_make_texture", &make_texture);
+
+    bpy::def("get_memory_usage", &get_memory_usage);
 }
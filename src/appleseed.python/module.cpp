@@ -66,6 +66,7 @@ void bind_scene();
 void bind_shader_compiler();
 void bind_shader_group();
 void bind_shader_query();
+void bind_shared_memory_tile_callback();
 void bind_surface_shader();
 void bind_texture();
 void bind_tile_callback();
@@ -135,6 +136,7 @@ extern "C" void bind_appleseed_python_classes()
 
     bind_renderer_controller();
     bind_tile_callback();
+    bind_shared_memory_tile_callback();
     bind_master_renderer();
 
 #if PY_MAJOR_VERSION == 3
@@ -28,6 +28,7 @@
 
 import unittest
 
+from testassembly import *
 from testbasis import *
 from testdict2dict import *
 from testentitymap import *
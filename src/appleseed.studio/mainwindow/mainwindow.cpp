@@ -90,6 +90,7 @@
 #include <QMimeData>
 #include <QRect>
 #include <QSettings>
+#include <QSpinBox>
 #include <QStatusBar>
 #include <QString>
 #include <QStringList>
@@ -103,7 +104,9 @@
 // Standard headers.
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdlib>
+#include <string>
 
 using namespace appleseed::common;
 using namespace appleseed::qtcommon;
@@ -242,6 +245,8 @@ void MainWindow::open_project_async(const QString& filepath)
     set_rendering_widgets_enabled(false, RenderingMode::NotRendering);
     set_diagnostics_widgets_enabled(false, RenderingMode::NotRendering);
 
+    m_status_bar.set_text(std::string("Loading project ") + filepath.toUtf8().constData() + "...");
+
     m_project_manager.load_project_async(filepath.toUtf8().constData());
 }
 
@@ -653,6 +658,15 @@ void MainWindow::build_toolbar()
     m_action_rendering_settings = new QAction(load_icons("rendering_settings"), combine_name_and_shortcut("Rendering Settings...", m_ui->action_rendering_rendering_settings->shortcut()), this);
     connect(m_action_rendering_settings, SIGNAL(triggered()), SLOT(slot_show_rendering_settings_window()));
     m_ui->main_toolbar->addAction(m_action_rendering_settings);
+
+    // Changing this value takes effect immediately, without restarting rendering.
+    m_spinbox_rendering_threads = new QSpinBox(this);
+    m_spinbox_rendering_threads->setRange(0, static_cast<int>(System::get_logical_cpu_core_count()));
+    m_spinbox_rendering_threads->setPrefix("Threads: ");
+    m_spinbox_rendering_threads->setSpecialValueText("Threads: All");
+    m_spinbox_rendering_threads->setToolTip("Number of rendering threads allowed to run, up to the number of threads rendering was started with");
+    connect(m_spinbox_rendering_threads, SIGNAL(valueChanged(int)), SLOT(slot_set_rendering_thread_count(const int)));
+    m_ui->main_toolbar->addWidget(m_spinbox_rendering_threads);
 }
 
 void MainWindow::build_log_panel()
@@ -1489,6 +1503,7 @@ void MainWindow::slot_open_project_complete(const QString& filepath, const bool
         on_project_change();
     else
     {
+        m_status_bar.clear();
         show_project_file_loading_failed_message_box(this, filepath);
         recreate_render_tabs();
         update_workspace();
@@ -1717,6 +1732,11 @@ void MainWindow::slot_pause_or_resume_rendering(const bool checked)
     update_pause_resume_checkbox(checked);
 }
 
+void MainWindow::slot_set_rendering_thread_count(const int thread_count)
+{
+    m_rendering_manager.set_active_thread_count(static_cast<size_t>(thread_count));
+}
+
 void MainWindow::slot_rendering_end()
 {
     apply_false_colors_settings();
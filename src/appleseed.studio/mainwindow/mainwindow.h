@@ -74,6 +74,7 @@ class QDropEvent;
 class QFileSystemWatcher;
 class QPoint;
 class QRect;
+class QSpinBox;
 class QString;
 class QStringList;
 class QWidget;
@@ -139,6 +140,7 @@ class MainWindow
     QAction*                                    m_action_pause_resume_rendering;
     QAction*                                    m_action_stop_rendering;
     QAction*                                    m_action_rendering_settings;
+    QSpinBox*                                   m_spinbox_rendering_threads;
     QAction*                                    m_action_fullscreen;
 
     std::vector<QAction*>                       m_recently_opened;
@@ -275,6 +277,8 @@ class MainWindow
         const bool      successful);
     void slot_pause_or_resume_rendering(
         const bool      checked);
+    void slot_set_rendering_thread_count(
+        const int       thread_count);
     void slot_rendering_end();
     void slot_camera_changed();
 
@@ -41,18 +41,27 @@
 
 // Qt headers.
 #include <QFont>
+#include <QList>
 #include <QObject>
+#include <QString>
+#include <QTreeWidgetItem>
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <functional>
 
 // Forward declarations.
 namespace appleseed { namespace studio { class EntityEditorContext; } }
-class QString;
 
 namespace appleseed {
 namespace studio {
 
+// Collections with at least that many entities only get their items created
+// when they are expanded for the first time.
+const size_t DeferredCollectionItemThreshold = 100;
+
 // Work around a limitation in Qt: a template class cannot have slots.
 class CollectionItemBaseSlots
   : public ItemBase
@@ -100,12 +109,20 @@ class CollectionItemBase
 
     template <typename EntityContainer> void add_items(EntityContainer& items);
 
+    void create_deferred_children() override;
+
   protected:
     void initialize();
 
     ItemBase* add_item(const int index, Entity* entity);
 
     virtual ItemBase* create_item(Entity* entity);
+
+  private:
+    // Creates the deferred items and returns the one of a given entity, if any.
+    std::function<ItemBase* (const Entity*)> m_deferred_items;
+
+    ItemBase* create_deferred_items(const Entity* target_entity);
 };
 
 
@@ -148,6 +165,11 @@ ItemBase* CollectionItemBase<Entity>::add_item(Entity* entity)
 {
     assert(entity);
 
+    // The entity may already be part of a container whose items were deferred.
+    ItemBase* item = create_deferred_items(entity);
+    if (item)
+        return item;
+
     return add_item(qtcommon::find_sorted_position(this, entity->get_name()), entity);
 }
 
@@ -155,8 +177,77 @@ template <typename Entity>
 template <typename EntityContainer>
 void CollectionItemBase<Entity>::add_items(EntityContainer& entities)
 {
-    for (auto& entity : entities)
-        add_item(&entity);
+    if (static_cast<size_t>(entities.size()) < DeferredCollectionItemThreshold)
+    {
+        for (auto& entity : entities)
+            add_item(&entity);
+
+        return;
+    }
+
+    // The container is only traversed when the items get created, so that entities
+    // inserted or removed in the meantime are accounted for.
+    std::function<ItemBase* (const Entity*)> previous = std::move(m_deferred_items);
+    m_deferred_items = [this, &entities, previous](const Entity* target_entity) -> ItemBase*
+    {
+        ItemBase* target_item = previous ? previous(target_entity) : nullptr;
+
+        QList<QTreeWidgetItem*> items;
+        items.reserve(static_cast<int>(entities.size()));
+
+        for (auto& entity : entities)
+        {
+            ItemBase* item = create_item(&entity);
+
+            if (&entity == target_entity)
+                target_item = item;
+
+            items.append(item);
+        }
+
+        if (childCount() == 0)
+        {
+            // Sort once and insert all items at once rather than one by one.
+            std::stable_sort(
+                items.begin(),
+                items.end(),
+                [](const QTreeWidgetItem* lhs, const QTreeWidgetItem* rhs)
+                {
+                    return QString::localeAwareCompare(lhs->text(0), rhs->text(0)) < 0;
+                });
+
+            addChildren(items);
+        }
+        else
+        {
+            for (QTreeWidgetItem* item : items)
+                insertChild(qtcommon::find_sorted_position(this, item->text(0)), item);
+        }
+
+        return target_item;
+    };
+
+    setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+}
+
+template <typename Entity>
+void CollectionItemBase<Entity>::create_deferred_children()
+{
+    create_deferred_items(nullptr);
+}
+
+template <typename Entity>
+ItemBase* CollectionItemBase<Entity>::create_deferred_items(const Entity* target_entity)
+{
+    if (!m_deferred_items)
+        return nullptr;
+
+    const std::function<ItemBase* (const Entity*)> deferred_items = std::move(m_deferred_items);
+    m_deferred_items = nullptr;
+
+    setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicatorWhenChildless);
+
+    return deferred_items(target_entity);
 }
 
 template <typename Entity>
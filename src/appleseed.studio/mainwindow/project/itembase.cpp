@@ -140,6 +140,10 @@ void ItemBase::delete_multiple(const QList<ItemBase*>& items)
 {
 }
 
+void ItemBase::create_deferred_children()
+{
+}
+
 void ItemBase::slot_edit(AttributeEditor* attribute_editor)
 {
 }
@@ -84,6 +84,9 @@ class ItemBase
 
     virtual void delete_multiple(const QList<ItemBase*>& items);
 
+    // Create the child items whose creation was deferred until this item is expanded.
+    virtual void create_deferred_children();
+
   public slots:
     virtual void slot_edit(AttributeEditor* attribute_editor = nullptr);
     virtual void slot_instantiate();
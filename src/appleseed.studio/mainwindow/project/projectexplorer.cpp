@@ -83,6 +83,11 @@ ProjectExplorer::ProjectExplorer(
 {
     m_tree_widget->setContextMenuPolicy(Qt::CustomContextMenu);
 
+    // Connect before expanding the project item so that deferred items get created.
+    connect(
+        m_tree_widget, SIGNAL(itemExpanded(QTreeWidgetItem*)),
+        SLOT(slot_item_expanded(QTreeWidgetItem*)));
+
     ProjectItem* project_item = new ProjectItem(m_editor_context);
     m_tree_widget->addTopLevelItem(project_item);
 
@@ -145,8 +150,29 @@ namespace
     }
 }
 
+namespace
+{
+    void create_deferred_items(QTreeWidgetItem* item)
+    {
+        static_cast<ItemBase*>(item)->create_deferred_children();
+
+        for (int i = 0; i < item->childCount(); ++i)
+            create_deferred_items(item->child(i));
+    }
+}
+
+void ProjectExplorer::create_all_deferred_items() const
+{
+    for (int i = 0; i < m_tree_widget->topLevelItemCount(); ++i)
+        create_deferred_items(m_tree_widget->topLevelItem(i));
+}
+
 void ProjectExplorer::filter_items(const QString& pattern) const
 {
+    // Items must exist to be matched against the pattern.
+    if (!pattern.isEmpty())
+        create_all_deferred_items();
+
     const QRegExp regexp(pattern, Qt::CaseInsensitive);
 
     for (int i = 0; i < m_tree_widget->topLevelItemCount(); ++i)
@@ -173,6 +199,13 @@ ItemBase* ProjectExplorer::select_entity(const UniqueID uid) const
 
     QTreeWidgetItem* item = m_item_registry.get_item(uid);
 
+    if (item == nullptr)
+    {
+        // The item of this entity may not have been created yet.
+        create_all_deferred_items();
+        item = m_item_registry.get_item(uid);
+    }
+
     if (item)
     {
         m_tree_widget->scrollToItem(item);
@@ -251,6 +284,11 @@ void ProjectExplorer::slot_item_selection_changed()
     }
 }
 
+void ProjectExplorer::slot_item_expanded(QTreeWidgetItem* item)
+{
+    static_cast<ItemBase*>(item)->create_deferred_children();
+}
+
 void ProjectExplorer::slot_edit_item(QTreeWidgetItem* item, int column)
 {
     static_cast<ItemBase*>(item)->slot_edit();
@@ -96,12 +96,16 @@ class ProjectExplorer
     EntityEditorContext             m_editor_context;
     std::unique_ptr<QShortcut>      m_delete_shortcut;
 
+    // Create all items whose creation was deferred until their parent gets expanded.
+    void create_all_deferred_items() const;
+
     QMenu* build_single_item_context_menu(QTreeWidgetItem* item) const;
     QMenu* build_multiple_items_context_menu(const QList<QTreeWidgetItem*>& item_widgets) const;
 
   private slots:
     void slot_context_menu(const QPoint& point);
     void slot_item_selection_changed();
+    void slot_item_expanded(QTreeWidgetItem* item);
     void slot_edit_item(QTreeWidgetItem* item, int column);
     void slot_drag_item(QTreeWidgetItem* item, int column);
     void slot_delete_items();
@@ -40,6 +40,7 @@ namespace studio {
 //
 
 QtRendererController::QtRendererController()
+  : m_active_thread_count(0)
 {
     set_status(ContinueRendering);
 }
@@ -96,5 +97,15 @@ IRendererController::Status QtRendererController::get_status() const
     return m_status;
 }
 
+void QtRendererController::set_active_thread_count(const size_t thread_count)
+{
+    m_active_thread_count = thread_count;
+}
+
+size_t QtRendererController::get_active_thread_count() const
+{
+    return m_active_thread_count;
+}
+
 }   // namespace studio
 }   // namespace appleseed
@@ -38,6 +38,9 @@
 // Qt headers.
 #include <QObject>
 
+// Standard headers.
+#include <cstddef>
+
 namespace appleseed {
 namespace studio {
 
@@ -78,6 +81,12 @@ class QtRendererController
     // Return the current rendering status.
     Status get_status() const override;
 
+    // Store a new number of rendering threads, 0 to use all of them.
+    void set_active_thread_count(const size_t thread_count);
+
+    // Return the number of rendering threads that should be running.
+    size_t get_active_thread_count() const override;
+
   signals:
     void signal_rendering_begin();
     void signal_rendering_success();
@@ -89,6 +98,7 @@ class QtRendererController
 
   private:
     boost::atomic<Status> m_status;
+    boost::atomic<size_t> m_active_thread_count;
 };
 
 }   // namespace studio
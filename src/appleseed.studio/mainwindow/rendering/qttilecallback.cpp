@@ -111,6 +111,21 @@ namespace
             emit signal_update();
         }
 
+        void on_progressive_tiles_update(
+            const Frame&            frame,
+            const size_t*           tile_indices,
+            const size_t            tile_count,
+            const double            /*time*/,
+            const std::uint64_t     /*samples*/,
+            const double            /*samples_per_pixel*/,
+            const std::uint64_t     /*samples_per_second*/) override
+        {
+            assert(m_render_widget);
+            m_render_widget->blit_tiles(frame, tile_indices, tile_count);
+
+            emit signal_update();
+        }
+
       signals:
         void signal_update();
 
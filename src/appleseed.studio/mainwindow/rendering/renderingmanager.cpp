@@ -293,6 +293,11 @@ void RenderingManager::resume_rendering()
     m_renderer_controller.set_status(IRendererController::ContinueRendering);
 }
 
+void RenderingManager::set_active_thread_count(const size_t thread_count)
+{
+    m_renderer_controller.set_active_thread_count(thread_count);
+}
+
 void RenderingManager::schedule(std::unique_ptr<IScheduledAction> action)
 {
     m_scheduled_actions.push_back(action.release());
@@ -49,6 +49,7 @@
 #include <QThread>
 
 // Standard headers.
+#include <cstddef>
 #include <map>
 #include <memory>
 #include <string>
@@ -105,6 +106,9 @@ class RenderingManager
     void pause_rendering();
     void resume_rendering();
 
+    // Change the number of rendering threads of the current and next renders, 0 to use all of them.
+    void set_active_thread_count(const size_t thread_count);
+
     // Interface for scheduled actions.
     class IScheduledAction
     {
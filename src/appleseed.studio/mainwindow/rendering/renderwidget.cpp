@@ -71,6 +71,7 @@ RenderWidget::RenderWidget(
     QWidget*                parent)
   : QWidget(parent)
   , m_mutex(QMutex::Recursive)
+  , m_has_dirty_tiles(false)
   , m_ocio_config(ocio_config)
 {
     setFocusPolicy(Qt::StrongFocus);
@@ -90,6 +91,8 @@ QImage RenderWidget::capture()
 {
     QMutexLocker locker(&m_mutex);
 
+    update_dirty_tiles_no_lock();
+
     return m_image.copy();
 }
 
@@ -117,6 +120,8 @@ void RenderWidget::clear()
 
     m_image.fill(QColor(0, 0, 0));
     m_image_storage.reset();
+    m_dirty_tiles.clear();
+    m_has_dirty_tiles = false;
 }
 
 namespace
@@ -138,6 +143,11 @@ namespace
 
 void RenderWidget::start_render()
 {
+    QMutexLocker locker(&m_mutex);
+
+    // Keep the displayed image once the image storage is cleared.
+    update_dirty_tiles_no_lock();
+
     // Clear the image storage.
     if (m_image_storage)
         m_image_storage->clear(Color4f(0.0f));
@@ -149,6 +159,8 @@ void RenderWidget::multiply(const float multiplier)
 
     assert(multiplier >= 0.0f && multiplier <= 1.0f);
 
+    update_dirty_tiles_no_lock();
+
     const size_t image_width = static_cast<size_t>(m_image.width());
     const size_t image_height = static_cast<size_t>(m_image.height());
     const size_t dest_stride = static_cast<size_t>(m_image.bytesPerLine());
@@ -217,6 +229,17 @@ void RenderWidget::highlight_tile(
     const size_t width = tile.get_width();
     const size_t height = tile.get_height();
 
+    // Make sure a pending update of this tile won't erase the bracket.
+    if (m_image_storage && m_image_storage->properties().m_tile_count_x == frame_props.m_tile_count_x)
+    {
+        const size_t tile_index = tile_y * frame_props.m_tile_count_x + tile_x;
+        if (tile_index < m_dirty_tiles.size() && m_dirty_tiles[tile_index])
+        {
+            update_tile_no_lock(tile_x, tile_y);
+            m_dirty_tiles[tile_index] = false;
+        }
+    }
+
     // Retrieve destination image information.
     APPLESEED_UNUSED const size_t image_width = static_cast<size_t>(m_image.width());
     APPLESEED_UNUSED const size_t image_height = static_cast<size_t>(m_image.height());
@@ -262,7 +285,28 @@ void RenderWidget::blit_tile(
     allocate_working_storage(frame.image().properties());
 
     blit_tile_no_lock(frame, tile_x, tile_y);
-    update_tile_no_lock(tile_x, tile_y);
+    mark_tile_dirty_no_lock(tile_x, tile_y);
+}
+
+void RenderWidget::blit_tiles(
+    const Frame&    frame,
+    const size_t*   tile_indices,
+    const size_t    tile_count)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const CanvasProperties& frame_props = frame.image().properties();
+
+    allocate_working_storage(frame_props);
+
+    for (size_t i = 0; i < tile_count; ++i)
+    {
+        const size_t tile_x = tile_indices[i] % frame_props.m_tile_count_x;
+        const size_t tile_y = tile_indices[i] / frame_props.m_tile_count_x;
+
+        blit_tile_no_lock(frame, tile_x, tile_y);
+        mark_tile_dirty_no_lock(tile_x, tile_y);
+    }
 }
 
 void RenderWidget::blit_frame(const Frame& frame)
@@ -276,11 +320,10 @@ void RenderWidget::blit_frame(const Frame& frame)
     for (size_t y = 0; y < frame_props.m_tile_count_y; ++y)
     {
         for (size_t x = 0; x < frame_props.m_tile_count_x; ++x)
-        {
             blit_tile_no_lock(frame, x, y);
-            update_tile_no_lock(x, y);
-        }
     }
+
+    mark_all_tiles_dirty_no_lock();
 }
 
 void RenderWidget::slot_display_transform_changed(const QString& transform)
@@ -296,15 +339,7 @@ void RenderWidget::slot_display_transform_changed(const QString& transform)
         OCIO::ConstContextRcPtr context = m_ocio_config->getCurrentContext();
         m_ocio_processor = m_ocio_config->getProcessor(context, transform_ptr, OCIO::TRANSFORM_DIR_FORWARD);
 
-        if (m_image_storage)
-        {
-            const CanvasProperties& frame_props = m_image_storage->properties();
-            for (size_t y = 0; y < frame_props.m_tile_count_y; ++y)
-            {
-                for (size_t x = 0; x < frame_props.m_tile_count_x; ++x)
-                    update_tile_no_lock(x, y);
-            }
-        }
+        mark_all_tiles_dirty_no_lock();
     }
 
     update();
@@ -342,6 +377,9 @@ void RenderWidget::allocate_working_storage(const CanvasProperties& frame_props)
                 frame_props.m_tile_height,
                 frame_props.m_channel_count,
                 PixelFormatFloat));
+
+        m_dirty_tiles.assign(frame_props.m_tile_count, false);
+        m_has_dirty_tiles = false;
     }
 
     if (!m_float_tile_storage || !is_compatible(*m_float_tile_storage, frame_props))
@@ -428,10 +466,52 @@ void RenderWidget::update_tile_no_lock(const size_t tile_x, const size_t tile_y)
     NativeDrawing::blit(dest, dest_stride, uint8_rgb_tile);
 }
 
+void RenderWidget::mark_tile_dirty_no_lock(const size_t tile_x, const size_t tile_y)
+{
+    const CanvasProperties& frame_props = m_image_storage->properties();
+    m_dirty_tiles[tile_y * frame_props.m_tile_count_x + tile_x] = true;
+    m_has_dirty_tiles = true;
+}
+
+void RenderWidget::mark_all_tiles_dirty_no_lock()
+{
+    if (m_image_storage)
+    {
+        std::fill(m_dirty_tiles.begin(), m_dirty_tiles.end(), true);
+        m_has_dirty_tiles = true;
+    }
+}
+
+void RenderWidget::update_dirty_tiles_no_lock()
+{
+    if (!m_has_dirty_tiles)
+        return;
+
+    const CanvasProperties& frame_props = m_image_storage->properties();
+
+    for (size_t y = 0; y < frame_props.m_tile_count_y; ++y)
+    {
+        for (size_t x = 0; x < frame_props.m_tile_count_x; ++x)
+        {
+            const size_t tile_index = y * frame_props.m_tile_count_x + x;
+
+            if (m_dirty_tiles[tile_index])
+            {
+                update_tile_no_lock(x, y);
+                m_dirty_tiles[tile_index] = false;
+            }
+        }
+    }
+
+    m_has_dirty_tiles = false;
+}
+
 void RenderWidget::paintEvent(QPaintEvent* event)
 {
     QMutexLocker locker(&m_mutex);
 
+    update_dirty_tiles_no_lock();
+
     m_painter.begin(this);
     m_painter.drawImage(rect(), m_image);
     m_painter.end();
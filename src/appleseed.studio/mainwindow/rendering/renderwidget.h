@@ -51,6 +51,7 @@ namespace OCIO = OCIO_NAMESPACE;
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class CanvasProperties; }
@@ -66,6 +67,11 @@ namespace studio {
 //
 // A render widget based on QImage.
 //
+// Tiles blitted from the frame are only copied to a floating-point working image and
+// marked dirty. The display transform and the conversion to 8-bit are deferred to the
+// next repaint, so they run on the GUI thread at most once per repaint and per dirty
+// tile, instead of on render threads for every tile update.
+//
 
 class RenderWidget
   : public QWidget
@@ -106,13 +112,19 @@ class RenderWidget
         const size_t            thread_index,
         const size_t            thread_count);
 
-    // Thread-safe.
+    // Thread-safe. The tile is converted for display on the next repaint.
     void blit_tile(
         const renderer::Frame&  frame,
         const size_t            tile_x,
         const size_t            tile_y);
 
-    // Thread-safe.
+    // Thread-safe. The tiles are converted for display on the next repaint.
+    void blit_tiles(
+        const renderer::Frame&  frame,
+        const size_t*           tile_indices,
+        const size_t            tile_count);
+
+    // Thread-safe. The frame is converted for display on the next repaint.
     void blit_frame(const renderer::Frame& frame);
 
     // Direct access to internals for high-performance drawing.
@@ -134,6 +146,8 @@ class RenderWidget
     std::unique_ptr<foundation::Tile>   m_float_tile_storage;
     std::unique_ptr<foundation::Tile>   m_uint8_tile_storage;
     std::unique_ptr<foundation::Image>  m_image_storage;
+    std::vector<bool>                   m_dirty_tiles;
+    bool                                m_has_dirty_tiles;
 
     OCIO::ConstConfigRcPtr              m_ocio_config;
     OCIO::ConstProcessorRcPtr           m_ocio_processor;
@@ -149,6 +163,14 @@ class RenderWidget
         const size_t            tile_x,
         const size_t            tile_y);
 
+    void mark_tile_dirty_no_lock(
+        const size_t            tile_x,
+        const size_t            tile_y);
+
+    void mark_all_tiles_dirty_no_lock();
+
+    void update_dirty_tiles_no_lock();
+
     void paintEvent(QPaintEvent* event) override;
     void dragEnterEvent(QDragEnterEvent* event) override;
     void dragMoveEvent(QDragMoveEvent* event) override;
@@ -37,12 +37,116 @@
 #include <cassert>
 #include <map>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 namespace foundation
 {
 
-typedef std::map<InternedString, std::string> StringMap;
-typedef std::map<InternedString, Dictionary> DictionaryMap;
+namespace
+{
+    //
+    // An ordered map keyed by interned strings, with a hash index on the interned string
+    // pointers so that lookups don't have to compare strings. Items are still iterated in
+    // key order, so dictionaries are written and compared deterministically.
+    //
+
+    template <typename Value>
+    class InternedStringMap
+    {
+      public:
+        typedef std::map<InternedString, Value> Map;
+        typedef typename Map::iterator iterator;
+        typedef typename Map::const_iterator const_iterator;
+
+        InternedStringMap() = default;
+
+        InternedStringMap(const InternedStringMap& rhs)
+          : m_map(rhs.m_map)
+        {
+            rebuild_index();
+        }
+
+        InternedStringMap& operator=(const InternedStringMap& rhs)
+        {
+            if (this != &rhs)
+            {
+                m_map = rhs.m_map;
+                rebuild_index();
+            }
+
+            return *this;
+        }
+
+        size_t size() const
+        {
+            return m_map.size();
+        }
+
+        bool empty() const
+        {
+            return m_map.empty();
+        }
+
+        void clear()
+        {
+            m_map.clear();
+            m_index.clear();
+        }
+
+        Value& operator[](const InternedString& key)
+        {
+            iterator i = find(key);
+
+            if (i == m_map.end())
+            {
+                i = m_map.insert(std::make_pair(key, Value())).first;
+                m_index.insert(std::make_pair(key.c_str(), i));
+            }
+
+            return i->second;
+        }
+
+        iterator find(const InternedString& key)
+        {
+            const auto i = m_index.find(key.c_str());
+            return i == m_index.end() ? m_map.end() : i->second;
+        }
+
+        const_iterator find(const InternedString& key) const
+        {
+            const auto i = m_index.find(key.c_str());
+            return i == m_index.end() ? m_map.end() : const_iterator(i->second);
+        }
+
+        void erase(const iterator i)
+        {
+            m_index.erase(i->first.c_str());
+            m_map.erase(i);
+        }
+
+        iterator begin() { return m_map.begin(); }
+        iterator end() { return m_map.end(); }
+        const_iterator begin() const { return m_map.begin(); }
+        const_iterator end() const { return m_map.end(); }
+
+      private:
+        Map                                         m_map;
+        std::unordered_map<const char*, iterator>   m_index;
+
+        void rebuild_index()
+        {
+            m_index.clear();
+            m_index.reserve(m_map.size());
+
+            for (iterator i = m_map.begin(), e = m_map.end(); i != e; ++i)
+                m_index.insert(std::make_pair(i->first.c_str(), i));
+        }
+    };
+}
+
+typedef InternedStringMap<std::string> StringMap;
+typedef InternedStringMap<Dictionary> DictionaryMap;
 
 
 //
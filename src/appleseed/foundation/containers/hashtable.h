@@ -31,10 +31,15 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/scalar.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -80,6 +85,53 @@ class HashTable
 };
 
 
+//
+// An open-addressing hash table with the same interface and restrictions as HashTable,
+// except that the table size is the number of elements it must be able to hold.
+//
+// Entries are stored in a single flat array. A parallel array of one control byte per
+// slot holds 7 bits of the hash of the key stored in the slot, or a marker for empty
+// slots. Slots are probed in groups of 16 whose control bytes are compared against
+// the key's hash bits at once, so that keys are only compared for likely matches.
+//
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+class FlatHashTable
+{
+  public:
+    // Constructor, creates an empty hash table with a given key hasher.
+    explicit FlatHashTable(const KeyHasherType& key_hasher);
+
+    // Resize the table so that it can hold at least a given number of elements.
+    // All previously inserted elements are lost.
+    void resize(const size_t size);
+
+    // Insert an element into the hash table. The key must be unique.
+    void insert(const KeyType& key, const ValueType& value);
+
+    // Retrieve an element from the hash table. Returns nullptr if the element cannot be found.
+    const ValueType* get(const KeyType& key) const;
+
+  private:
+    typedef std::pair<KeyType, ValueType> Entry;
+
+    static const size_t GroupSize = 16;
+    static const std::int8_t EmptySlot = -128;
+
+    const KeyHasherType&        m_key_hasher;
+    size_t                      m_group_mask;
+    size_t                      m_size;
+    std::vector<std::int8_t>    m_control;
+    std::vector<Entry>          m_entries;
+
+    // Return a bit mask of the control bytes of a group equal to a given value.
+    static std::uint32_t match_group(const std::int8_t* control, const std::int8_t value);
+
+    // Return the index of the lowest set bit of a nonzero bit mask.
+    static size_t lowest_bit_index(const std::uint32_t mask);
+};
+
+
 //
 // HashTable class implementation.
 //
@@ -137,4 +189,129 @@ inline const ValueType* HashTable<KeyType, KeyHasherType, ValueType>::get(const
     return nullptr;
 }
 
+
+//
+// FlatHashTable class implementation.
+//
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+const size_t FlatHashTable<KeyType, KeyHasherType, ValueType>::GroupSize;
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+const std::int8_t FlatHashTable<KeyType, KeyHasherType, ValueType>::EmptySlot;
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+FlatHashTable<KeyType, KeyHasherType, ValueType>::FlatHashTable(const KeyHasherType& key_hasher)
+  : m_key_hasher(key_hasher)
+{
+    resize(0);
+}
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+void FlatHashTable<KeyType, KeyHasherType, ValueType>::resize(const size_t size)
+{
+    // Keep the load factor at or below 7/8 so that probe sequences stay short.
+    const size_t slot_count = std::max(GroupSize, next_pow2(size + size / 7 + 1));
+
+    m_group_mask = slot_count / GroupSize - 1;
+    m_size = 0;
+
+    m_control.assign(slot_count, EmptySlot);
+
+    m_entries.clear();
+    m_entries.resize(slot_count);
+}
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+inline void FlatHashTable<KeyType, KeyHasherType, ValueType>::insert(const KeyType& key, const ValueType& value)
+{
+    assert(m_size < m_control.size());
+
+    const size_t hash = m_key_hasher(key);
+    size_t group = (hash >> 7) & m_group_mask;
+
+    // Triangular probing visits every group since the number of groups is a power of two.
+    for (size_t step = 1; ; ++step)
+    {
+        std::int8_t* control = &m_control[group * GroupSize];
+        const std::uint32_t empty_slots = match_group(control, EmptySlot);
+
+        if (empty_slots != 0)
+        {
+            const size_t slot_index = lowest_bit_index(empty_slots);
+            control[slot_index] = static_cast<std::int8_t>(hash & 0x7F);
+            m_entries[group * GroupSize + slot_index] = Entry(key, value);
+            ++m_size;
+            return;
+        }
+
+        group = (group + step) & m_group_mask;
+    }
+}
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+inline const ValueType* FlatHashTable<KeyType, KeyHasherType, ValueType>::get(const KeyType& key) const
+{
+    const size_t hash = m_key_hasher(key);
+    const std::int8_t hash_bits = static_cast<std::int8_t>(hash & 0x7F);
+    size_t group = (hash >> 7) & m_group_mask;
+
+    for (size_t step = 1; step <= m_group_mask + 1; ++step)
+    {
+        const std::int8_t* control = &m_control[group * GroupSize];
+
+        for (std::uint32_t matches = match_group(control, hash_bits); matches != 0; matches &= matches - 1)
+        {
+            const Entry& entry = m_entries[group * GroupSize + lowest_bit_index(matches)];
+
+            if (entry.first == key)
+                return &entry.second;
+        }
+
+        // Elements are never deleted: an empty slot ends the probe sequence.
+        if (match_group(control, EmptySlot) != 0)
+            break;
+
+        group = (group + step) & m_group_mask;
+    }
+
+    return nullptr;
+}
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+inline std::uint32_t FlatHashTable<KeyType, KeyHasherType, ValueType>::match_group(
+    const std::int8_t*  control,
+    const std::int8_t   value)
+{
+#ifdef APPLESEED_USE_SSE
+
+    const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+
+    return
+        static_cast<std::uint32_t>(
+            _mm_movemask_epi8(
+                _mm_cmpeq_epi8(group, _mm_set1_epi8(value))));
+
+#else
+
+    std::uint32_t mask = 0;
+
+    for (size_t i = 0; i < GroupSize; ++i)
+    {
+        if (control[i] == value)
+            mask |= 1UL << i;
+    }
+
+    return mask;
+
+#endif
+}
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+inline size_t FlatHashTable<KeyType, KeyHasherType, ValueType>::lowest_bit_index(const std::uint32_t mask)
+{
+    assert(mask != 0);
+    return static_cast<size_t>(log2_int<std::uint32_t>(mask & (~mask + 1)));
+}
+
 }   // namespace foundation
@@ -0,0 +1,426 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/memory/alignedallocator.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// A vector of records stored as a structure of arrays: each field of the records
+// is stored in its own contiguous, aligned column. Loops that only touch a few
+// fields only load those fields, and can be vectorized over the columns.
+//
+// Columns are padded with default-constructed values to a multiple of Padding
+// elements, so that vectorized loops may process padded_size() elements without
+// handling a remainder.
+//
+// Columns are std::vector instances using AlignedAllocator, like AlignedVector,
+// but without AlignedVector's Visual Studio element wrapper which cannot wrap
+// scalar types.
+//
+
+namespace soa_impl
+{
+    template <size_t... Indices>
+    struct IndexSequence {};
+
+    template <size_t N, size_t... Indices>
+    struct MakeIndexSequence
+      : public MakeIndexSequence<N - 1, N - 1, Indices...>
+    {
+    };
+
+    template <size_t... Indices>
+    struct MakeIndexSequence<0, Indices...>
+    {
+        typedef IndexSequence<Indices...> Type;
+    };
+
+    // Evaluate a pack expansion for its side effects only.
+    inline void swallow(std::initializer_list<int>) {}
+}
+
+template <typename... Fields>
+class SoAVector
+{
+  public:
+    // Number of fields per record.
+    static const size_t FieldCount = sizeof...(Fields);
+
+    // Columns are padded to a multiple of this number of elements.
+    static const size_t Padding = 16;
+
+    // Alignment of the columns in bytes.
+    static const size_t Alignment = 64;
+
+    // Type of a given field.
+    template <size_t I>
+    struct Field
+    {
+        typedef typename std::tuple_element<I, std::tuple<Fields...>>::type Type;
+    };
+
+    // Proxy reference to a record.
+    class Reference
+    {
+      public:
+        Reference(SoAVector& vec, const size_t index)
+          : m_vec(vec)
+          , m_index(index)
+        {
+        }
+
+        template <size_t I>
+        typename Field<I>::Type& get() const
+        {
+            return m_vec.template get<I>(m_index);
+        }
+
+      private:
+        SoAVector&      m_vec;
+        const size_t    m_index;
+    };
+
+    // Proxy constant reference to a record.
+    class ConstReference
+    {
+      public:
+        ConstReference(const SoAVector& vec, const size_t index)
+          : m_vec(vec)
+          , m_index(index)
+        {
+        }
+
+        template <size_t I>
+        const typename Field<I>::Type& get() const
+        {
+            return m_vec.template get<I>(m_index);
+        }
+
+      private:
+        const SoAVector&    m_vec;
+        const size_t        m_index;
+    };
+
+    // Constructor.
+    SoAVector();
+
+    // Return true if the vector is empty.
+    bool empty() const;
+
+    // Return the number of records.
+    size_t size() const;
+
+    // Return the number of records rounded up to a multiple of Padding.
+    size_t padded_size() const;
+
+    // Return the size (in bytes) of this object in memory.
+    size_t get_memory_size() const;
+
+    // Reserve memory for a given number of records.
+    void reserve(const size_t capacity);
+
+    // Resize the vector, new records are default-constructed.
+    void resize(const size_t size);
+
+    // Remove all records, keeping the memory allocated.
+    void clear_keep_memory();
+
+    // Remove all records and release memory.
+    void clear_release_memory();
+
+    // Swap the contents of this vector with those of another vector.
+    void swap(SoAVector& rhs);
+
+    // Append a record.
+    void push_back(const Fields&... fields);
+
+    // Append all records of another vector.
+    void append(const SoAVector& rhs);
+
+    // Access a record.
+    Reference operator[](const size_t index);
+    ConstReference operator[](const size_t index) const;
+
+    // Access a given field of a record.
+    template <size_t I>
+    typename Field<I>::Type& get(const size_t index);
+    template <size_t I>
+    const typename Field<I>::Type& get(const size_t index) const;
+
+    // Return a pointer to the first element of a column, or nullptr if the vector was never used.
+    template <size_t I>
+    typename Field<I>::Type* column();
+    template <size_t I>
+    const typename Field<I>::Type* column() const;
+
+  private:
+    template <typename T>
+    struct Column
+    {
+        typedef std::vector<T, AlignedAllocator<T>> Type;
+    };
+
+    typedef typename soa_impl::MakeIndexSequence<sizeof...(Fields)>::Type Indices;
+
+    std::tuple<typename Column<Fields>::Type...>  m_columns;
+    size_t                                          m_size;
+
+    static size_t pad(const size_t size);
+
+    template <size_t... I>
+    size_t get_memory_size(soa_impl::IndexSequence<I...>) const;
+
+    template <size_t... I>
+    void reserve_columns(const size_t capacity, soa_impl::IndexSequence<I...>);
+
+    template <size_t... I>
+    void resize_columns(const size_t size, soa_impl::IndexSequence<I...>);
+
+    template <size_t... I>
+    void fill_columns(const size_t begin, const size_t end, soa_impl::IndexSequence<I...>);
+
+    template <size_t... I>
+    void set_record(const size_t index, soa_impl::IndexSequence<I...>, const Fields&... fields);
+
+    template <size_t... I>
+    void copy_records(const size_t index, const SoAVector& rhs, soa_impl::IndexSequence<I...>);
+};
+
+
+//
+// SoAVector class implementation.
+//
+
+template <typename... Fields>
+const size_t SoAVector<Fields...>::FieldCount;
+
+template <typename... Fields>
+const size_t SoAVector<Fields...>::Padding;
+
+template <typename... Fields>
+const size_t SoAVector<Fields...>::Alignment;
+
+template <typename... Fields>
+SoAVector<Fields...>::SoAVector()
+  : m_columns(typename Column<Fields>::Type(AlignedAllocator<Fields>(Alignment))...)
+  , m_size(0)
+{
+}
+
+template <typename... Fields>
+inline bool SoAVector<Fields...>::empty() const
+{
+    return m_size == 0;
+}
+
+template <typename... Fields>
+inline size_t SoAVector<Fields...>::size() const
+{
+    return m_size;
+}
+
+template <typename... Fields>
+inline size_t SoAVector<Fields...>::padded_size() const
+{
+    return pad(m_size);
+}
+
+template <typename... Fields>
+size_t SoAVector<Fields...>::get_memory_size() const
+{
+    return sizeof(*this) + get_memory_size(Indices());
+}
+
+template <typename... Fields>
+void SoAVector<Fields...>::reserve(const size_t capacity)
+{
+    reserve_columns(pad(capacity), Indices());
+}
+
+template <typename... Fields>
+void SoAVector<Fields...>::resize(const size_t size)
+{
+    // Reset the records that used to be padding or that are removed.
+    resize_columns(pad(size), Indices());
+    fill_columns(std::min(m_size, size), pad(size), Indices());
+    m_size = size;
+}
+
+template <typename... Fields>
+void SoAVector<Fields...>::clear_keep_memory()
+{
+    resize_columns(0, Indices());
+    m_size = 0;
+}
+
+template <typename... Fields>
+void SoAVector<Fields...>::clear_release_memory()
+{
+    SoAVector empty;
+    swap(empty);
+}
+
+template <typename... Fields>
+inline void SoAVector<Fields...>::swap(SoAVector& rhs)
+{
+    m_columns.swap(rhs.m_columns);
+    std::swap(m_size, rhs.m_size);
+}
+
+template <typename... Fields>
+inline void SoAVector<Fields...>::push_back(const Fields&... fields)
+{
+    // Grow all columns by Padding elements when the padding is used up.
+    if (m_size == std::get<0>(m_columns).size())
+        resize_columns(m_size + Padding, Indices());
+
+    set_record(m_size++, Indices(), fields...);
+}
+
+template <typename... Fields>
+void SoAVector<Fields...>::append(const SoAVector& rhs)
+{
+    const size_t old_size = m_size;
+    resize(m_size + rhs.m_size);
+    copy_records(old_size, rhs, Indices());
+}
+
+template <typename... Fields>
+inline typename SoAVector<Fields...>::Reference SoAVector<Fields...>::operator[](const size_t index)
+{
+    assert(index < m_size);
+    return Reference(*this, index);
+}
+
+template <typename... Fields>
+inline typename SoAVector<Fields...>::ConstReference SoAVector<Fields...>::operator[](const size_t index) const
+{
+    assert(index < m_size);
+    return ConstReference(*this, index);
+}
+
+template <typename... Fields>
+template <size_t I>
+inline typename SoAVector<Fields...>::template Field<I>::Type& SoAVector<Fields...>::get(const size_t index)
+{
+    assert(index < m_size);
+    return std::get<I>(m_columns)[index];
+}
+
+template <typename... Fields>
+template <size_t I>
+inline const typename SoAVector<Fields...>::template Field<I>::Type& SoAVector<Fields...>::get(const size_t index) const
+{
+    assert(index < m_size);
+    return std::get<I>(m_columns)[index];
+}
+
+template <typename... Fields>
+template <size_t I>
+inline typename SoAVector<Fields...>::template Field<I>::Type* SoAVector<Fields...>::column()
+{
+    return std::get<I>(m_columns).empty() ? nullptr : &std::get<I>(m_columns)[0];
+}
+
+template <typename... Fields>
+template <size_t I>
+inline const typename SoAVector<Fields...>::template Field<I>::Type* SoAVector<Fields...>::column() const
+{
+    return std::get<I>(m_columns).empty() ? nullptr : &std::get<I>(m_columns)[0];
+}
+
+template <typename... Fields>
+inline size_t SoAVector<Fields...>::pad(const size_t size)
+{
+    return (size + Padding - 1) / Padding * Padding;
+}
+
+template <typename... Fields>
+template <size_t... I>
+size_t SoAVector<Fields...>::get_memory_size(soa_impl::IndexSequence<I...>) const
+{
+    size_t size = 0;
+    soa_impl::swallow({ (size += std::get<I>(m_columns).capacity() * sizeof(typename Field<I>::Type), 0)... });
+    return size;
+}
+
+template <typename... Fields>
+template <size_t... I>
+void SoAVector<Fields...>::reserve_columns(const size_t capacity, soa_impl::IndexSequence<I...>)
+{
+    soa_impl::swallow({ (std::get<I>(m_columns).reserve(capacity), 0)... });
+}
+
+template <typename... Fields>
+template <size_t... I>
+void SoAVector<Fields...>::resize_columns(const size_t size, soa_impl::IndexSequence<I...>)
+{
+    soa_impl::swallow({ (std::get<I>(m_columns).resize(size), 0)... });
+}
+
+template <typename... Fields>
+template <size_t... I>
+void SoAVector<Fields...>::fill_columns(const size_t begin, const size_t end, soa_impl::IndexSequence<I...>)
+{
+    for (size_t i = begin; i < end; ++i)
+        soa_impl::swallow({ (std::get<I>(m_columns)[i] = typename Field<I>::Type(), 0)... });
+}
+
+template <typename... Fields>
+template <size_t... I>
+inline void SoAVector<Fields...>::set_record(const size_t index, soa_impl::IndexSequence<I...>, const Fields&... fields)
+{
+    soa_impl::swallow({ (std::get<I>(m_columns)[index] = fields, 0)... });
+}
+
+template <typename... Fields>
+template <size_t... I>
+void SoAVector<Fields...>::copy_records(const size_t index, const SoAVector& rhs, soa_impl::IndexSequence<I...>)
+{
+    soa_impl::swallow({
+        (std::copy(
+            std::get<I>(rhs.m_columns).begin(),
+            std::get<I>(rhs.m_columns).begin() + rhs.m_size,
+            std::get<I>(m_columns).begin() + index), 0)... });
+}
+
+}   // namespace foundation
@@ -58,6 +58,11 @@
 #include <OpenEXR/OpenEXRConfig.h>
 #include "foundation/platform/_endexrheaders.h"
 
+// OpenImageDenoise headers.
+#ifdef APPLESEED_WITH_OIDN
+#include <OpenImageDenoise/config.h>
+#endif
+
 // OpenImageIO headers.
 #include "foundation/platform/_beginoiioheaders.h"
 #include <OpenImageIO/oiioversion.h>
@@ -122,6 +127,10 @@ LibraryVersionArray ThirdParties::get_versions()
     versions.push_back(APIStringPair("OpenColorIO", OCIO_VERSION));
 #endif
 
+#ifdef APPLESEED_WITH_OIDN
+    versions.push_back(APIStringPair("OpenImageDenoise", format("{0}.{1}.{2}", OIDN_VERSION_MAJOR, OIDN_VERSION_MINOR, OIDN_VERSION_PATCH)));
+#endif
+
     versions.push_back(APIStringPair("IlmBase", ILMBASE_VERSION_STRING));
     versions.push_back(APIStringPair("libjpeg-turbo", LibJpegTurboVersion));
     versions.push_back(APIStringPair("LibTIFF", LibTIFFVersion));
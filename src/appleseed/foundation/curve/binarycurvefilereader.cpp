@@ -33,13 +33,18 @@
 #include "foundation/core/exceptions/exceptionioerror.h"
 #include "foundation/curve/icurvebuilder.h"
 #include "foundation/image/color.h"
+#include "foundation/math/compressedbeziercurve.h"
+#include "foundation/math/half.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/system.h"
 #include "foundation/utility/bufferedfile.h"
+#include "foundation/utility/virtualfilesystem.h"
 
 // Standard headers.
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <vector>
 
 namespace foundation
 {
@@ -55,6 +60,17 @@ BinaryCurveFileReader::BinaryCurveFileReader(const std::string& filename)
 
 void BinaryCurveFileReader::read(ICurveBuilder& builder)
 {
+    // Read the file directly from memory if it lives in a mounted archive.
+    std::vector<std::uint8_t> buffer;
+    const std::uint8_t* data;
+    size_t size;
+    if (read_virtual_file(m_filename, data, size, buffer))
+    {
+        MemoryReaderAdapter source(data, size);
+        read(source, builder);
+        return;
+    }
+
     BufferedFile file(
         m_filename.c_str(),
         BufferedFile::BinaryType,
@@ -63,23 +79,35 @@ void BinaryCurveFileReader::read(ICurveBuilder& builder)
     if (!file.is_open())
         throw ExceptionIOError();
 
-    read_and_check_signature(file);
+    PassthroughReaderAdapter source(file);
+    read(source, builder);
+}
+
+void BinaryCurveFileReader::read(ReaderAdapter& source, ICurveBuilder& builder)
+{
+    read_and_check_signature(source);
 
     std::uint16_t version;
-    checked_read(file, version);
+    checked_read(source, version);
 
-    std::unique_ptr<ReaderAdapter> reader;
+    std::unique_ptr<ReaderAdapter> lz4_reader;
+    bool quantized = false;
 
     switch (version)
     {
       // Uncompressed.
       case 1:
-        reader.reset(new PassthroughReaderAdapter(file));
         break;
 
       // LZ4-compressed.
       case 2:
-        reader.reset(new LZ4CompressedReaderAdapter(file));
+        lz4_reader.reset(new ParallelLZ4CompressedReaderAdapter(source, System::get_logical_cpu_core_count()));
+        break;
+
+      // LZ4-compressed, quantized vertices and half-precision vertex attributes.
+      case 3:
+        lz4_reader.reset(new ParallelLZ4CompressedReaderAdapter(source, System::get_logical_cpu_core_count()));
+        quantized = true;
         break;
 
       // Unknown format.
@@ -87,21 +115,21 @@ void BinaryCurveFileReader::read(ICurveBuilder& builder)
         throw ExceptionIOError("unknown binarycurve format version");
     }
 
-    read_curves(*reader.get(), builder);
+    read_curves(lz4_reader ? *lz4_reader : source, builder, quantized);
 }
 
-void BinaryCurveFileReader::read_and_check_signature(BufferedFile& file)
+void BinaryCurveFileReader::read_and_check_signature(ReaderAdapter& reader)
 {
     static const char ExpectedSig[11] = { 'B', 'I', 'N', 'A', 'R', 'Y', 'C', 'U', 'R', 'V', 'E' };
 
     char signature[sizeof(ExpectedSig)];
-    checked_read(file, signature, sizeof(signature));
+    checked_read(reader, signature, sizeof(signature));
 
     if (memcmp(signature, ExpectedSig, sizeof(ExpectedSig)) != 0)
         throw ExceptionIOError("invalid binarycurve format signature");
 }
 
-void BinaryCurveFileReader::read_curves(ReaderAdapter& reader, ICurveBuilder& builder)
+void BinaryCurveFileReader::read_curves(ReaderAdapter& reader, ICurveBuilder& builder, const bool quantized)
 {
     try
     {
@@ -129,7 +157,9 @@ void BinaryCurveFileReader::read_curves(ReaderAdapter& reader, ICurveBuilder& bu
             for (std::uint32_t i = 0; i < curve_count; ++i)
             {
                 builder.begin_curve();
-                read_curve(reader, builder);
+                if (quantized)
+                    read_quantized_curve(reader, builder);
+                else read_curve(reader, builder);
                 builder.end_curve();
             }
 
@@ -177,4 +207,47 @@ void BinaryCurveFileReader::read_curve(ReaderAdapter &reader, ICurveBuilder &bui
     }
 }
 
+void BinaryCurveFileReader::read_quantized_curve(ReaderAdapter& reader, ICurveBuilder& builder)
+{
+    std::uint32_t vertex_count;
+    checked_read(reader, vertex_count);
+
+    Vector3f origin, scale;
+    checked_read(reader, origin);
+    checked_read(reader, scale);
+    const PointQuantizer quantizer(origin, scale);
+
+    for (std::uint32_t i = 0; i < vertex_count; ++i)
+    {
+        std::uint16_t q[3];
+        checked_read(reader, q, sizeof(q));
+        builder.push_vertex(quantizer.decode(q));
+    }
+
+    for (std::uint32_t i = 0; i < vertex_count; ++i)
+    {
+        std::uint16_t bits;
+        checked_read(reader, bits);
+        builder.push_vertex_width(Half::from_bits(bits));
+    }
+
+    for (std::uint32_t i = 0; i < vertex_count; ++i)
+    {
+        std::uint16_t bits;
+        checked_read(reader, bits);
+        builder.push_vertex_opacity(Half::from_bits(bits));
+    }
+
+    for (std::uint32_t i = 0; i < vertex_count; ++i)
+    {
+        std::uint16_t bits[3];
+        checked_read(reader, bits, sizeof(bits));
+        builder.push_vertex_color(
+            Color3f(
+                Half::from_bits(bits[0]),
+                Half::from_bits(bits[1]),
+                Half::from_bits(bits[2])));
+    }
+}
+
 }   // namespace foundation
@@ -35,7 +35,6 @@
 #include <string>
 
 // Forward declarations.
-namespace foundation    { class BufferedFile; }
 namespace foundation    { class ICurveBuilder; }
 namespace foundation    { class ReaderAdapter; }
 
@@ -59,9 +58,11 @@ class BinaryCurveFileReader
   private:
     const std::string m_filename;
 
-    static void read_and_check_signature(BufferedFile& file);
-    void read_curves(ReaderAdapter& reader, ICurveBuilder& builder);
+    void read(ReaderAdapter& source, ICurveBuilder& builder);
+    static void read_and_check_signature(ReaderAdapter& reader);
+    void read_curves(ReaderAdapter& reader, ICurveBuilder& builder, const bool quantized);
     void read_curve(ReaderAdapter& reader, ICurveBuilder& builder);
+    void read_quantized_curve(ReaderAdapter& reader, ICurveBuilder& builder);
 };
 
 }   // namespace foundation
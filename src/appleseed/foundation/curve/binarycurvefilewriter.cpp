@@ -32,7 +32,12 @@
 // appleseed.foundation headers.
 #include "foundation/core/exceptions/exceptionioerror.h"
 #include "foundation/curve/icurvewalker.h"
+#include "foundation/image/color.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/compressedbeziercurve.h"
+#include "foundation/math/half.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/system.h"
 
 // Standard headers.
 #include <cstring>
@@ -44,9 +49,12 @@ namespace foundation
 // BinaryCurveFileWriter class implementation.
 //
 
-BinaryCurveFileWriter::BinaryCurveFileWriter(const std::string& filename)
+BinaryCurveFileWriter::BinaryCurveFileWriter(
+    const std::string&  filename,
+    const bool          quantized)
   : m_filename(filename)
-  , m_writer(m_file, 256 * 1024)
+  , m_quantized(quantized)
+  , m_writer(m_file, 256 * 1024, System::get_logical_cpu_core_count())
 {
 }
 
@@ -77,7 +85,8 @@ void BinaryCurveFileWriter::write_signature()
 
 void BinaryCurveFileWriter::write_version()
 {
-    const std::uint16_t Version = 2;
+    // Version 2 is LZ4-compressed, version 3 is LZ4-compressed and quantized.
+    const std::uint16_t Version = m_quantized ? 3 : 2;
     checked_write(m_file, Version);
 }
 
@@ -89,7 +98,11 @@ void BinaryCurveFileWriter::write_curves(const ICurveWalker& walker)
     std::uint32_t vertex_count = 0;
 
     for (std::uint32_t i = 0; i < walker.get_curve_count(); ++i)
-        write_curve(walker, i, vertex_count);
+    {
+        if (m_quantized)
+            write_quantized_curve(walker, i, vertex_count);
+        else write_curve(walker, i, vertex_count);
+    }
 }
 
 void BinaryCurveFileWriter::write_basis(const ICurveWalker& walker)
@@ -124,4 +137,47 @@ void BinaryCurveFileWriter::write_curve(const ICurveWalker& walker, const std::u
     vertex_count += count;
 }
 
+void BinaryCurveFileWriter::write_quantized_curve(const ICurveWalker& walker, const std::uint32_t curve_id, std::uint32_t& vertex_count)
+{
+    const std::uint32_t count = static_cast<std::uint32_t>(walker.get_vertex_count(curve_id));
+    checked_write(m_writer, count);
+
+    AABB3f bbox(Vector3f(0.0f), Vector3f(0.0f));
+
+    if (count > 0)
+    {
+        bbox.invalidate();
+
+        for (std::uint32_t i = 0; i < count; ++i)
+            bbox.insert(walker.get_vertex(i + vertex_count));
+    }
+
+    const PointQuantizer quantizer(bbox);
+    checked_write(m_writer, quantizer.get_origin());
+    checked_write(m_writer, quantizer.get_scale());
+
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        std::uint16_t q[3];
+        quantizer.encode(walker.get_vertex(i + vertex_count), q);
+        checked_write(m_writer, q, sizeof(q));
+    }
+
+    for (std::uint32_t i = 0; i < count; ++i)
+        checked_write(m_writer, Half(walker.get_vertex_width(i + vertex_count)).bits());
+
+    for (std::uint32_t i = 0; i < count; ++i)
+        checked_write(m_writer, Half(walker.get_vertex_opacity(i + vertex_count)).bits());
+
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        const Color3f color = walker.get_vertex_color(i + vertex_count);
+        checked_write(m_writer, Half(color[0]).bits());
+        checked_write(m_writer, Half(color[1]).bits());
+        checked_write(m_writer, Half(color[2]).bits());
+    }
+
+    vertex_count += count;
+}
+
 }   // namespace foundation
@@ -45,21 +45,28 @@ namespace foundation
 //
 // Writer for a simple binary curve file format.
 //
+// When quantized is true, vertices are stored as 16-bit integers relative to the
+// bounding box of their curve, and vertex widths, opacities and colors are stored
+// as half-precision floats.
+//
 
 class BinaryCurveFileWriter
   : public ICurveFileWriter
 {
   public:
     // Constructor.
-    explicit BinaryCurveFileWriter(const std::string& filename);
+    explicit BinaryCurveFileWriter(
+        const std::string&  filename,
+        const bool          quantized = false);
 
     // Write a curve object.
     void write(const ICurveWalker& walker) override;
 
   private:
-    const std::string           m_filename;
-    BufferedFile                m_file;
-    LZ4CompressedWriterAdapter  m_writer;
+    const std::string                   m_filename;
+    const bool                          m_quantized;
+    BufferedFile                        m_file;
+    ParallelLZ4CompressedWriterAdapter  m_writer;
 
     void write_signature();
     void write_version();
@@ -68,6 +75,7 @@ class BinaryCurveFileWriter
     void write_curve_count(const ICurveWalker& walker);
     void write_basis(const ICurveWalker& walker);
     void write_curve(const ICurveWalker& walker, const std::uint32_t curve_id, std::uint32_t& vertex_count);
+    void write_quantized_curve(const ICurveWalker& walker, const std::uint32_t curve_id, std::uint32_t& vertex_count);
 };
 
 }   // namespace foundation
@@ -45,13 +45,15 @@ namespace bf = boost::filesystem;
 namespace foundation
 {
 
-GenericCurveFileWriter::GenericCurveFileWriter(const char* filename)
+GenericCurveFileWriter::GenericCurveFileWriter(
+    const char*     filename,
+    const bool      quantized)
 {
     const bf::path filepath(filename);
     const std::string extension = lower_case(filepath.extension().string());
 
     if (extension == ".binarycurve")
-        m_writer = new BinaryCurveFileWriter(filename);
+        m_writer = new BinaryCurveFileWriter(filename, quantized);
     else throw ExceptionUnsupportedFileFormat(filename);
 }
 
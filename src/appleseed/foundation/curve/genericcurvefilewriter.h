@@ -49,8 +49,11 @@ class APPLESEED_DLLSYMBOL GenericCurveFileWriter
   : public ICurveFileWriter
 {
   public:
-    // Constructor.
-    explicit GenericCurveFileWriter(const char* filename);
+    // Constructor. If supported by the file format, vertices are stored quantized
+    // and vertex attributes are stored as half-precision floats when quantized is true.
+    explicit GenericCurveFileWriter(
+        const char*     filename,
+        const bool      quantized = false);
 
     // Destructor.
     ~GenericCurveFileWriter() override;
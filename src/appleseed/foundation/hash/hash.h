@@ -33,7 +33,9 @@
 #include "foundation/math/scalar.h"
 
 // Standard headers.
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 namespace foundation
 {
@@ -134,6 +136,26 @@ std::uint64_t combine_hashes(
     const std::uint64_t     h2);
 
 
+//
+// String hash functions.
+//
+
+// Hash a null-terminated string into a 64-bit integer (64-bit FNV-1a).
+std::uint64_t hash_string(const char* s);
+
+// Hash and equality functors allowing C strings to be used as keys of unordered containers.
+// The strings must outlive the container since only the pointers are stored.
+struct CStringHash
+{
+    std::size_t operator()(const char* s) const;
+};
+
+struct CStringEqual
+{
+    bool operator()(const char* lhs, const char* rhs) const;
+};
+
+
 //
 // Integer hash functions implementation.
 //
@@ -339,4 +361,32 @@ inline std::uint64_t combine_hashes(
     return k1 + k2 + rotl64(k1, 17) + rotr64(k2, 13) + 0xB504F333F9DE6109ull;
 }
 
+
+//
+// String hash functions implementation.
+//
+
+inline std::uint64_t hash_string(const char* s)
+{
+    std::uint64_t h = 0xCBF29CE484222325ull;            // FNV offset basis
+
+    while (*s)
+    {
+        h ^= static_cast<unsigned char>(*s++);
+        h *= 0x100000001B3ull;                          // FNV prime
+    }
+
+    return h;
+}
+
+inline std::size_t CStringHash::operator()(const char* s) const
+{
+    return static_cast<std::size_t>(hash_string(s));
+}
+
+inline bool CStringEqual::operator()(const char* lhs, const char* rhs) const
+{
+    return std::strcmp(lhs, rhs) == 0;
+}
+
 }   // namespace foundation
@@ -69,14 +69,15 @@ class APPLESEED_DLLSYMBOL MurmurHash
 
     MurmurHash& append(const std::string& str);
 
+    // Append an arbitrary block of memory.
+    void append(const void* data, const size_t bytes);
+
     std::uint64_t h1() const;
     std::uint64_t h2() const;
 
     std::string to_string() const;
 
   private:
-    void append(const void* data, const size_t bytes);
-
     std::uint64_t m_h1;
     std::uint64_t m_h2;
 };
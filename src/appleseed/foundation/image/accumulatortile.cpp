@@ -34,6 +34,9 @@
 #include "foundation/image/pixel.h"
 #include "foundation/math/scalar.h"
 #include "foundation/platform/atomic.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
 
 namespace foundation
 {
@@ -51,8 +54,9 @@ AccumulatorTile::AccumulatorTile(
     const size_t            width,
     const size_t            height,
     const size_t            channel_count,
-    const AABB2u&           crop_window)
-  : Tile(width, height, channel_count + 1, PixelFormatFloat)
+    const AABB2u&           crop_window,
+    std::uint8_t*           storage)
+  : Tile(width, height, channel_count + 1, PixelFormatFloat, storage)
   , m_crop_window(crop_window)
 {
 }
@@ -76,8 +80,7 @@ void AccumulatorTile::add(
     float* APPLESEED_RESTRICT ptr = reinterpret_cast<float*>(pixel(pi.x, pi.y));
     *ptr++ += 1.0f;
 
-    for (size_t i = 0, e = m_channel_count - 1; i < e; ++i)
-        *ptr++ += values[i];
+    scaled_add(ptr, values, 1.0f, m_channel_count - 1);
 }
 
 void AccumulatorTile::atomic_add(
@@ -95,4 +98,44 @@ void AccumulatorTile::atomic_add(
         foundation::atomic_add(ptr++, values[i]);
 }
 
+void AccumulatorTile::scaled_add(
+    float*                  dest,
+    const float*            source,
+    const float             scaling,
+    const size_t            count)
+{
+    float* APPLESEED_RESTRICT d = dest;
+    const float* APPLESEED_RESTRICT s = source;
+
+    size_t i = 0;
+
+    // Pixels are not aligned: the weight channel comes first.
+#ifdef APPLESEED_USE_AVX
+    const __m256 scaling8 = _mm256_set1_ps(scaling);
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_ps(
+            d + i,
+            _mm256_add_ps(
+                _mm256_loadu_ps(d + i),
+                _mm256_mul_ps(_mm256_loadu_ps(s + i), scaling8)));
+    }
+#endif
+
+#ifdef APPLESEED_USE_SSE
+    const __m128 scaling4 = _mm_set1_ps(scaling);
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(
+            d + i,
+            _mm_add_ps(
+                _mm_loadu_ps(d + i),
+                _mm_mul_ps(_mm_loadu_ps(s + i), scaling4)));
+    }
+#endif
+
+    for (; i < count; ++i)
+        d[i] += s[i] * scaling;
+}
+
 }   // namespace foundation
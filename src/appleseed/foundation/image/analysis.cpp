@@ -37,81 +37,248 @@
 #include "foundation/image/image.h"
 #include "foundation/image/tile.h"
 #include "foundation/math/scalar.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <vector>
 
 namespace foundation
 {
 
 namespace
 {
-    void accumulate_luminance(
+    //
+    // Kernels operating on rows of pixels.
+    //
+    // Rows of 4-channel float pixels, the layout of frames, take vectorized paths.
+    // Other layouts are read one pixel at a time.
+    //
+
+    bool is_rgba_float(const Tile& tile)
+    {
+        return
+            tile.get_pixel_format() == PixelFormatFloat &&
+            tile.get_channel_count() == 4;
+    }
+
+    void accumulate_row_luminance(
         const Tile&     tile,
+        const size_t    y,
         double&         accumulated_luminance,
         size_t&         relevant_pixel_count)
     {
-        assert(tile.get_channel_count() == 4);
-
-        const size_t tile_width = tile.get_width();
-        const size_t tile_height = tile.get_height();
+        const size_t width = tile.get_width();
 
-        for (size_t y = 0; y < tile_height; ++y)
+        if (is_rgba_float(tile))
         {
-            for (size_t x = 0; x < tile_width; ++x)
-            {
-                // Fetch the pixel color; assume linear RGBA.
-                Color4f linear_rgba;
-                tile.get_pixel(x, y, linear_rgba);
+            const float* pixels = reinterpret_cast<const float*>(tile.pixel(0, y));
+
+#ifdef APPLESEED_USE_SSE
+            const __m128 rgb_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+            const __m128 weights = _mm_set_ps(0.0f, 0.072169f, 0.715160f, 0.212671f);
+            const __m128 zero = _mm_setzero_ps();
+            __m128 sum = zero;
 
-                // Extract the RGB part (ignore the alpha channel).
-                const Color3f linear_rgb = linear_rgba.rgb();
+            for (size_t x = 0; x < width; ++x)
+            {
+                // Ignore the alpha channel.
+                const __m128 rgb = _mm_and_ps(_mm_loadu_ps(pixels + x * 4), rgb_mask);
 
                 // Skip pixels containing NaN values.
-                if (has_nan(linear_rgb))
+                if (_mm_movemask_ps(_mm_cmpunord_ps(rgb, rgb)) != 0)
                     continue;
 
-                // Compute the Rec. 709 relative luminance of this pixel.
-                const float lum = luminance(clamp_low(linear_rgb, 0.0f));
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_max_ps(rgb, zero), weights));
+                ++relevant_pixel_count;
+            }
+
+            M128Fields fields;
+            fields.m128 = sum;
+            accumulated_luminance +=
+                static_cast<double>(fields.f32[0]) +
+                static_cast<double>(fields.f32[1]) +
+                static_cast<double>(fields.f32[2]);
 
-                // It should no longer be possible to have NaN at this point.
-                assert(lum == lum);
+            return;
+#else
+            for (size_t x = 0; x < width; ++x)
+            {
+                const Color3f linear_rgb(pixels[x * 4 + 0], pixels[x * 4 + 1], pixels[x * 4 + 2]);
 
-                accumulated_luminance += static_cast<double>(lum);
+                if (has_nan(linear_rgb))
+                    continue;
+
+                accumulated_luminance += static_cast<double>(luminance(clamp_low(linear_rgb, 0.0f)));
                 ++relevant_pixel_count;
             }
+
+            return;
+#endif
+        }
+
+        for (size_t x = 0; x < width; ++x)
+        {
+            // Fetch the pixel color; assume linear RGBA.
+            Color4f linear_rgba;
+            tile.get_pixel(x, y, linear_rgba);
+
+            // Extract the RGB part (ignore the alpha channel).
+            const Color3f linear_rgb = linear_rgba.rgb();
+
+            // Skip pixels containing NaN values.
+            if (has_nan(linear_rgb))
+                continue;
+
+            // Compute the Rec. 709 relative luminance of this pixel.
+            const float lum = luminance(clamp_low(linear_rgb, 0.0f));
+
+            // It should no longer be possible to have NaN at this point.
+            assert(lum == lum);
+
+            accumulated_luminance += static_cast<double>(lum);
+            ++relevant_pixel_count;
         }
     }
 
     void accumulate_luminance(
-        const Image&    image,
+        const Tile&     tile,
         double&         accumulated_luminance,
         size_t&         relevant_pixel_count)
     {
-        accumulated_luminance = 0.0;
-        relevant_pixel_count = 0;
+        for (size_t y = 0, h = tile.get_height(); y < h; ++y)
+            accumulate_row_luminance(tile, y, accumulated_luminance, relevant_pixel_count);
+    }
 
-        const CanvasProperties& props = image.properties();
+    // Return the sum of the square RGB distances between a span of pixels of a tile
+    // and the same span of a reference tile.
+    double compute_span_square_distance(
+        const Tile&     tile,
+        const size_t    x,
+        const size_t    y,
+        const Tile&     ref_tile,
+        const size_t    ref_x,
+        const size_t    ref_y,
+        const size_t    count)
+    {
+        if (is_rgba_float(tile) && is_rgba_float(ref_tile))
+        {
+            const float* pixels = reinterpret_cast<const float*>(tile.pixel(x, y));
+            const float* ref_pixels = reinterpret_cast<const float*>(ref_tile.pixel(ref_x, ref_y));
 
-        for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+#ifdef APPLESEED_USE_SSE
+            const __m128 rgb_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+            __m128 sum = _mm_setzero_ps();
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const __m128 d =
+                    _mm_and_ps(
+                        _mm_sub_ps(_mm_loadu_ps(pixels + i * 4), _mm_loadu_ps(ref_pixels + i * 4)),
+                        rgb_mask);
+                sum = _mm_add_ps(sum, _mm_mul_ps(d, d));
+            }
+
+            M128Fields fields;
+            fields.m128 = sum;
+            return
+                static_cast<double>(fields.f32[0]) +
+                static_cast<double>(fields.f32[1]) +
+                static_cast<double>(fields.f32[2]);
+#else
+            float sum = 0.0f;
+
+            for (size_t i = 0; i < count * 4; i += 4)
+            {
+                sum +=
+                    square(pixels[i + 0] - ref_pixels[i + 0]) +
+                    square(pixels[i + 1] - ref_pixels[i + 1]) +
+                    square(pixels[i + 2] - ref_pixels[i + 2]);
+            }
+
+            return static_cast<double>(sum);
+#endif
+        }
+
+        double sum = 0.0;
+
+        for (size_t i = 0; i < count; ++i)
         {
-            for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+            Color3f color;
+            tile.get_pixel(x + i, y, color);
+
+            Color3f ref_color;
+            ref_tile.get_pixel(ref_x + i, ref_y, ref_color);
+
+            sum += square_distance(color, ref_color);
+        }
+
+        return sum;
+    }
+
+    // Return the sum of the square RGB distances between the pixels of a tile of an image
+    // and the corresponding pixels of a reference image, whose tiles may be laid out differently.
+    double compute_tile_square_distance(
+        const CanvasProperties& props,
+        const size_t            tile_x,
+        const size_t            tile_y,
+        const Tile&             tile,
+        const Image&            ref_image)
+    {
+        const CanvasProperties& ref_props = ref_image.properties();
+
+        const size_t origin_x = tile_x * props.m_tile_width;
+        const size_t origin_y = tile_y * props.m_tile_height;
+        const size_t width = tile.get_width();
+        const size_t height = tile.get_height();
+
+        double sum = 0.0;
+
+        for (size_t y = 0; y < height; ++y)
+        {
+            const size_t iy = origin_y + y;
+            const size_t ref_tile_y = iy / ref_props.m_tile_height;
+            const size_t ref_y = iy - ref_tile_y * ref_props.m_tile_height;
+
+            // Process the row in spans that don't cross tiles of the reference image.
+            for (size_t x = 0; x < width; )
             {
-                const Tile& tile = image.tile(tx, ty);
-                accumulate_luminance(tile, accumulated_luminance, relevant_pixel_count);
+                const size_t ix = origin_x + x;
+                const size_t ref_tile_x = ix / ref_props.m_tile_width;
+                const size_t ref_x = ix - ref_tile_x * ref_props.m_tile_width;
+                const Tile& ref_tile = ref_image.tile(ref_tile_x, ref_tile_y);
+                const size_t count = std::min(width - x, ref_tile.get_width() - ref_x);
+
+                sum += compute_span_square_distance(tile, x, y, ref_tile, ref_x, ref_y, count);
+
+                x += count;
             }
         }
+
+        return sum;
     }
 }
 
 double compute_average_luminance(const Image& image)
 {
-    double accumulated_luminance;
-    size_t relevant_pixel_count;
+    double accumulated_luminance = 0.0;
+    size_t relevant_pixel_count = 0;
+
+    const CanvasProperties& props = image.properties();
 
-    accumulate_luminance(image, accumulated_luminance, relevant_pixel_count);
+    for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+    {
+        for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+        {
+            const Tile& tile = image.tile(tx, ty);
+            accumulate_luminance(tile, accumulated_luminance, relevant_pixel_count);
+        }
+    }
 
     return relevant_pixel_count > 0
         ? accumulated_luminance / relevant_pixel_count
@@ -136,21 +303,140 @@ double compute_rms_deviation(const Image& image1, const Image& image2)
     const CanvasProperties& props = image1.properties();
     double mse = 0.0;   // mean square error
 
-    for (size_t y = 0; y < props.m_canvas_height; ++y)
+    for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
     {
-        for (size_t x = 0; x < props.m_canvas_width; ++x)
+        for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+            mse += compute_tile_square_distance(props, tx, ty, image1.tile(tx, ty), image2);
+    }
+
+    mse /= props.m_pixel_count * 3.0;
+
+    return std::sqrt(mse);
+}
+
+
+//
+// TiledImageAnalysis class implementation.
+//
+
+struct TiledImageAnalysis::Impl
+{
+    CanvasProperties        m_props;
+    const Image*            m_ref_image;
+
+    // Per-tile statistics.
+    std::vector<double>     m_accumulated_luminances;
+    std::vector<size_t>     m_relevant_pixel_counts;
+    std::vector<double>     m_square_distances;
+
+    Impl(const CanvasProperties& props, const Image* ref_image)
+      : m_props(props)
+      , m_ref_image(ref_image)
+    {
+    }
+};
+
+TiledImageAnalysis::TiledImageAnalysis(
+    const CanvasProperties& props,
+    const Image*            ref_image)
+  : impl(nullptr)
+{
+    if (ref_image &&
+        (ref_image->properties().m_canvas_width != props.m_canvas_width ||
+         ref_image->properties().m_canvas_height != props.m_canvas_height))
+        throw ExceptionIncompatibleImages();
+
+    impl = new Impl(props, ref_image);
+
+    // Until they are updated, tiles are black.
+    impl->m_accumulated_luminances.assign(props.m_tile_count, 0.0);
+    impl->m_relevant_pixel_counts.resize(props.m_tile_count);
+    for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+    {
+        for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
         {
-            Color3f color1;
-            image1.get_pixel(x, y, color1);
+            impl->m_relevant_pixel_counts[ty * props.m_tile_count_x + tx] =
+                props.get_tile_width(tx) * props.get_tile_height(ty);
+        }
+    }
 
-            Color3f color2;
-            image2.get_pixel(x, y, color2);
+    if (ref_image)
+    {
+        impl->m_square_distances.resize(props.m_tile_count);
+        for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+        {
+            for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+            {
+                Tile black_tile(
+                    props.get_tile_width(tx),
+                    props.get_tile_height(ty),
+                    4,
+                    PixelFormatFloat);
+                black_tile.clear(Color4f(0.0f));
 
-            mse += square_distance(color1, color2);
+                impl->m_square_distances[ty * props.m_tile_count_x + tx] =
+                    compute_tile_square_distance(props, tx, ty, black_tile, *ref_image);
+            }
         }
     }
+}
 
-    mse /= props.m_pixel_count * 3.0;
+TiledImageAnalysis::~TiledImageAnalysis()
+{
+    delete impl;
+}
+
+void TiledImageAnalysis::update_tile(
+    const size_t            tile_x,
+    const size_t            tile_y,
+    const Tile&             tile)
+{
+    assert(tile_x < impl->m_props.m_tile_count_x);
+    assert(tile_y < impl->m_props.m_tile_count_y);
+    assert(tile.get_width() == impl->m_props.get_tile_width(tile_x));
+    assert(tile.get_height() == impl->m_props.get_tile_height(tile_y));
+
+    const size_t tile_index = tile_y * impl->m_props.m_tile_count_x + tile_x;
+
+    double accumulated_luminance = 0.0;
+    size_t relevant_pixel_count = 0;
+    accumulate_luminance(tile, accumulated_luminance, relevant_pixel_count);
+    impl->m_accumulated_luminances[tile_index] = accumulated_luminance;
+    impl->m_relevant_pixel_counts[tile_index] = relevant_pixel_count;
+
+    if (impl->m_ref_image)
+    {
+        impl->m_square_distances[tile_index] =
+            compute_tile_square_distance(impl->m_props, tile_x, tile_y, tile, *impl->m_ref_image);
+    }
+}
+
+double TiledImageAnalysis::get_average_luminance() const
+{
+    double accumulated_luminance = 0.0;
+    size_t relevant_pixel_count = 0;
+
+    for (size_t i = 0, e = impl->m_props.m_tile_count; i < e; ++i)
+    {
+        accumulated_luminance += impl->m_accumulated_luminances[i];
+        relevant_pixel_count += impl->m_relevant_pixel_counts[i];
+    }
+
+    return relevant_pixel_count > 0
+        ? accumulated_luminance / relevant_pixel_count
+        : 0.0;
+}
+
+double TiledImageAnalysis::get_rms_deviation() const
+{
+    assert(impl->m_ref_image);
+
+    double mse = 0.0;   // mean square error
+
+    for (size_t i = 0, e = impl->m_props.m_tile_count; i < e; ++i)
+        mse += impl->m_square_distances[i];
+
+    mse /= impl->m_props.m_pixel_count * 3.0;
 
     return std::sqrt(mse);
 }
@@ -31,13 +31,19 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/exceptions/exception.h"
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/image/color.h"
 
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
+namespace foundation    { class CanvasProperties; }
 namespace foundation    { class Image; }
+namespace foundation    { class Tile; }
 
 namespace foundation
 {
@@ -68,4 +74,44 @@ struct ExceptionIncompatibleImages
 // Throws a foundation::ExceptionIncompatibleImages exception if the images are not compatible.
 APPLESEED_DLLSYMBOL double compute_rms_deviation(const Image& image1, const Image& image2);
 
+
+//
+// Incremental image analysis.
+//
+// Maintains the measurements above from per-tile statistics so that only the tiles
+// that changed need to be analyzed again. Tiles that were never updated are black.
+//
+
+class APPLESEED_DLLSYMBOL TiledImageAnalysis
+  : public NonCopyable
+{
+  public:
+    // Constructor. `props` describes the analyzed image. The optional reference image
+    // must outlive this object. Throws a foundation::ExceptionIncompatibleImages
+    // exception if the reference image has different dimensions.
+    explicit TiledImageAnalysis(
+        const CanvasProperties& props,
+        const Image*            ref_image = nullptr);
+
+    // Destructor.
+    ~TiledImageAnalysis();
+
+    // Update the statistics of a given tile from its new contents, assumed to be linear RGBA.
+    void update_tile(
+        const size_t            tile_x,
+        const size_t            tile_y,
+        const Tile&             tile);
+
+    // Return the average Rec. 709 relative luminance of the image.
+    // Pixels containing NaN values are skipped.
+    double get_average_luminance() const;
+
+    // Return the Root-Mean-Square deviation between the image and the reference image.
+    double get_rms_deviation() const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
 }   // namespace foundation
@@ -30,9 +30,15 @@
 #include "colormap.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
 #include "foundation/image/colorspace.h"
 #include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
 #include "foundation/math/scalar.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
 
 // Standard headers.
 #include <algorithm>
@@ -77,6 +83,71 @@ namespace
             }
         }
     }
+
+    // Invoke a visitor on every tile of an image overlapping a crop window. The visitor
+    // receives the tile and the part of the crop window covering it, in tile coordinates.
+    template <typename ImageType, typename Func>
+    void for_each_tile(
+        ImageType&      image,
+        const AABB2u&   crop_window,
+        const Func&     visitor)
+    {
+        const CanvasProperties& props = image.properties();
+
+        const size_t tile_x_begin = crop_window.min.x / props.m_tile_width;
+        const size_t tile_x_end = crop_window.max.x / props.m_tile_width;
+        const size_t tile_y_begin = crop_window.min.y / props.m_tile_height;
+        const size_t tile_y_end = crop_window.max.y / props.m_tile_height;
+
+        for (size_t tile_y = tile_y_begin; tile_y <= tile_y_end; ++tile_y)
+        {
+            for (size_t tile_x = tile_x_begin; tile_x <= tile_x_end; ++tile_x)
+            {
+                const size_t origin_x = tile_x * props.m_tile_width;
+                const size_t origin_y = tile_y * props.m_tile_height;
+
+                const AABB2u rect(
+                    Vector2u(
+                        std::max(crop_window.min.x, origin_x) - origin_x,
+                        std::max(crop_window.min.y, origin_y) - origin_y),
+                    Vector2u(
+                        std::min(crop_window.max.x, origin_x + props.get_tile_width(tile_x) - 1) - origin_x,
+                        std::min(crop_window.max.y, origin_y + props.get_tile_height(tile_y) - 1) - origin_y));
+
+                visitor(image.tile(tile_x, tile_y), rect);
+            }
+        }
+    }
+
+    // Return true if the pixels of a tile are stored as four floats (RGBA).
+    bool is_float_rgba(const Tile& tile)
+    {
+        return
+            tile.get_pixel_format() == PixelFormatFloat &&
+            tile.get_channel_count() == 4;
+    }
+
+#ifdef APPLESEED_USE_SSE
+
+    // Compute the relative luminance of four consecutive RGBA pixels.
+    inline __m128 luminance4(const float* pixels)
+    {
+        __m128 r = _mm_loadu_ps(pixels + 0);
+        __m128 g = _mm_loadu_ps(pixels + 4);
+        __m128 b = _mm_loadu_ps(pixels + 8);
+        __m128 a = _mm_loadu_ps(pixels + 12);
+
+        _MM_TRANSPOSE4_PS(r, g, b, a);
+
+        return
+            _mm_add_ps(
+                _mm_add_ps(
+                    _mm_mul_ps(r, _mm_set1_ps(0.212671f)),
+                    _mm_mul_ps(g, _mm_set1_ps(0.715160f))),
+                _mm_mul_ps(b, _mm_set1_ps(0.072169f)));
+    }
+
+#endif
 }
 
 void ColorMap::find_min_max_red_channel(
@@ -128,13 +199,81 @@ void ColorMap::find_min_max_relative_luminance(
     min_luminance = +std::numeric_limits<float>::max();
     max_luminance = -std::numeric_limits<float>::max();
 
-    for_each_pixel(image, crop_window, [&min_luminance, &max_luminance](const Color3f& color)
+    for_each_tile(image, crop_window, [&min_luminance, &max_luminance](const Tile& tile, const AABB2u& rect)
     {
-        min_luminance = std::min(luminance(color), min_luminance);
-        max_luminance = std::max(luminance(color), max_luminance);
+        find_min_max_relative_luminance(tile, rect, min_luminance, max_luminance);
     });
 }
 
+void ColorMap::find_min_max_relative_luminance(
+    const Tile&     tile,
+    const AABB2u&   rect,
+    float&          min_luminance,
+    float&          max_luminance)
+{
+    assert(rect.max.x < tile.get_width());
+    assert(rect.max.y < tile.get_height());
+
+    if (!is_float_rgba(tile))
+    {
+        for (size_t y = rect.min.y; y <= rect.max.y; ++y)
+        {
+            for (size_t x = rect.min.x; x <= rect.max.x; ++x)
+            {
+                Color3f color;
+                tile.get_pixel(x, y, color);
+
+                const float lum = luminance(color);
+                min_luminance = std::min(lum, min_luminance);
+                max_luminance = std::max(lum, max_luminance);
+            }
+        }
+
+        return;
+    }
+
+    const size_t count = rect.max.x - rect.min.x + 1;
+
+    for (size_t y = rect.min.y; y <= rect.max.y; ++y)
+    {
+        const float* pixels = reinterpret_cast<const float*>(tile.pixel(rect.min.x, y));
+        size_t i = 0;
+
+#ifdef APPLESEED_USE_SSE
+        if (count >= 4)
+        {
+            __m128 min4 = _mm_set1_ps(min_luminance);
+            __m128 max4 = _mm_set1_ps(max_luminance);
+
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m128 lum4 = luminance4(pixels + i * 4);
+                min4 = _mm_min_ps(lum4, min4);
+                max4 = _mm_max_ps(lum4, max4);
+            }
+
+            M128Fields min_fields, max_fields;
+            min_fields.m128 = min4;
+            max_fields.m128 = max4;
+
+            for (size_t j = 0; j < 4; ++j)
+            {
+                min_luminance = std::min(min_fields.f32[j], min_luminance);
+                max_luminance = std::max(max_fields.f32[j], max_luminance);
+            }
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            const float* p = pixels + i * 4;
+            const float lum = luminance(Color3f(p[0], p[1], p[2]));
+            min_luminance = std::min(lum, min_luminance);
+            max_luminance = std::max(lum, max_luminance);
+        }
+    }
+}
+
 void ColorMap::set_palette_from_array(const float* values, const size_t entry_count)
 {
     m_palette.resize(entry_count);
@@ -215,24 +354,94 @@ void ColorMap::remap_relative_luminance(
     const float     min_luminance,
     const float     max_luminance) const
 {
+    for_each_tile(image, crop_window, [this, min_luminance, max_luminance](Tile& tile, const AABB2u& rect)
+    {
+        remap_relative_luminance(tile, rect, min_luminance, max_luminance);
+    });
+}
+
+void ColorMap::remap_relative_luminance(
+    Tile&           tile,
+    const AABB2u&   rect,
+    const float     min_luminance,
+    const float     max_luminance) const
+{
+    assert(rect.max.x < tile.get_width());
+    assert(rect.max.y < tile.get_height());
+
     if (min_luminance == max_luminance)
     {
         const Color3f mapped_color = evaluate_palette(0.0f);
 
-        for_each_pixel(image, crop_window, [mapped_color](const Color3f& color)
+        for (size_t y = rect.min.y; y <= rect.max.y; ++y)
         {
-            return mapped_color;
-        });
+            for (size_t x = rect.min.x; x <= rect.max.x; ++x)
+                tile.set_pixel(x, y, mapped_color);
+        }
+
+        return;
     }
-    else
+
+    const float k = 1.0f / (max_luminance - min_luminance);
+
+    if (!is_float_rgba(tile))
     {
-        const float k = 1.0f / (max_luminance - min_luminance);
+        for (size_t y = rect.min.y; y <= rect.max.y; ++y)
+        {
+            for (size_t x = rect.min.x; x <= rect.max.x; ++x)
+            {
+                Color3f color;
+                tile.get_pixel(x, y, color);
+                tile.set_pixel(x, y, evaluate_palette(saturate((luminance(color) - min_luminance) * k)));
+            }
+        }
+
+        return;
+    }
+
+    const size_t count = rect.max.x - rect.min.x + 1;
 
-        for_each_pixel(image, crop_window, [this, min_luminance, k](const Color3f& color)
+    for (size_t y = rect.min.y; y <= rect.max.y; ++y)
+    {
+        float* pixels = reinterpret_cast<float*>(tile.pixel(rect.min.x, y));
+        size_t i = 0;
+
+#ifdef APPLESEED_USE_SSE
+        const __m128 min4 = _mm_set1_ps(min_luminance);
+        const __m128 k4 = _mm_set1_ps(k);
+        const __m128 zero4 = _mm_setzero_ps();
+        const __m128 one4 = _mm_set1_ps(1.0f);
+
+        for (; i + 4 <= count; i += 4)
         {
-            const float x = saturate((luminance(color) - min_luminance) * k);
-            return evaluate_palette(x);
-        });
+            M128Fields x;
+            x.m128 =
+                _mm_min_ps(
+                    _mm_max_ps(
+                        _mm_mul_ps(_mm_sub_ps(luminance4(pixels + i * 4), min4), k4),
+                        zero4),
+                    one4);
+
+            for (size_t j = 0; j < 4; ++j)
+            {
+                float* p = pixels + (i + j) * 4;
+                const Color3f color = evaluate_palette(x.f32[j]);
+                p[0] = color[0];
+                p[1] = color[1];
+                p[2] = color[2];
+            }
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            float* p = pixels + i * 4;
+            const float x = saturate((luminance(Color3f(p[0], p[1], p[2])) - min_luminance) * k);
+            const Color3f color = evaluate_palette(x);
+            p[0] = color[0];
+            p[1] = color[1];
+            p[2] = color[2];
+        }
     }
 }
 
@@ -38,6 +38,7 @@
 
 // Forward declarations.
 namespace foundation { class Image; }
+namespace foundation { class Tile; }
 
 namespace foundation
 {
@@ -65,6 +66,15 @@ class ColorMap
         float&          min_luminance,
         float&          max_luminance);
 
+    // Find the minimum and maximum relative luminance of the pixels of a tile within a
+    // given rectangle (inclusive, in tile coordinates). min_luminance and max_luminance
+    // are updated rather than overwritten, so the results of several tiles can be merged.
+    static void find_min_max_relative_luminance(
+        const Tile&     tile,
+        const AABB2u&   rect,
+        float&          min_luminance,
+        float&          max_luminance);
+
     void set_palette_from_array(
         const float*    values,
         const size_t    entry_count);
@@ -91,6 +101,14 @@ class ColorMap
         const float     min_luminance,
         const float     max_luminance) const;
 
+    // Remap the relative luminance of the pixels of a tile within a given rectangle
+    // (inclusive, in tile coordinates). Alpha is left untouched.
+    void remap_relative_luminance(
+        Tile&           tile,
+        const AABB2u&   rect,
+        const float     min_luminance,
+        const float     max_luminance) const;
+
     Color3f evaluate_palette(float x) const;
 
   private:
@@ -48,6 +48,7 @@
 // Standard headers.
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 
 namespace foundation
 {
@@ -296,6 +297,11 @@ float fast_linear_rgb_to_srgb(const float c);
 float fast_srgb_to_linear_rgb(const float c);
 #ifdef APPLESEED_USE_SSE
 inline __m128 fast_linear_rgb_to_srgb(const __m128 linear_rgb);
+inline __m128 fast_srgb_to_linear_rgb(const __m128 srgb);
+#endif
+#ifdef APPLESEED_USE_AVX
+inline __m256 fast_linear_rgb_to_srgb(const __m256 linear_rgb);
+inline __m256 fast_srgb_to_linear_rgb(const __m256 srgb);
 #endif
 Color3f fast_linear_rgb_to_srgb(const Color3f& linear_rgb);
 Color3f fast_srgb_to_linear_rgb(const Color3f& srgb);
@@ -309,6 +315,10 @@ inline __m128 faster_linear_rgb_to_srgb(const __m128 linear_rgb);
 Color3f faster_linear_rgb_to_srgb(const Color3f& linear_rgb);
 Color3f faster_srgb_to_linear_rgb(const Color3f& srgb);
 
+// Exact conversion of 8-bit sRGB color components to the linear RGB color space, using a lookup table.
+APPLESEED_DLLSYMBOL extern const float SRGB8ToLinearRGB[256];
+float srgb8_to_linear_rgb(const std::uint8_t c);
+
 
 //
 // Compute the relative luminance of a linear RGB triplet as defined
@@ -339,6 +349,16 @@ Color<T, 3> spectrum_to_ciexyz(
     const LightingConditions&   lighting,
     const SpectrumType&         spectrum);
 
+#ifdef APPLESEED_USE_SSE
+
+// Convert a 31-channel spectrum stored as 32 floats (the last one being zero) to a color
+// in the CIE XYZ color space. Used by the specializations of spectrum_to_ciexyz().
+Color3f spectrum31f_to_ciexyz(
+    const LightingConditions&   lighting,
+    const float                 spectrum[32]);
+
+#endif
+
 // Convert a spectrum to a color in the CIE XYZ color space using the CIE D65 illuminant
 // and the CIE 1964 10-deg color matching functions.
 APPLESEED_DLLSYMBOL void spectrum_to_ciexyz_standard(
@@ -697,6 +717,11 @@ inline float fast_linear_rgb_to_srgb(const float c)
         : 1.055f * fast_pow(c, 1.0f / 2.4f) - 0.055f;
 }
 
+inline float srgb8_to_linear_rgb(const std::uint8_t c)
+{
+    return SRGB8ToLinearRGB[c];
+}
+
 inline float fast_srgb_to_linear_rgb(const float c)
 {
     return c <= 0.04045f
@@ -720,6 +745,56 @@ inline __m128 fast_linear_rgb_to_srgb(const __m128 linear_rgb)
     return _mm_add_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
 }
 
+inline __m128 fast_srgb_to_linear_rgb(const __m128 srgb)
+{
+    // Apply 2.4 gamma expansion.
+    const __m128 y =
+        fast_pow(
+            _mm_mul_ps(_mm_add_ps(srgb, _mm_set1_ps(0.055f)), _mm_set1_ps(1.0f / 1.055f)),
+            _mm_set1_ps(2.4f));
+
+    // Compute both outcomes of the branch.
+    const __m128 a = _mm_mul_ps(_mm_set1_ps(1.0f / 12.92f), srgb);
+
+    // Interleave them based on the comparison result.
+    const __m128 mask = _mm_cmple_ps(srgb, _mm_set1_ps(0.04045f));
+    return _mm_add_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, y));
+}
+
+#ifdef APPLESEED_USE_AVX
+
+inline __m256 fast_linear_rgb_to_srgb(const __m256 linear_rgb)
+{
+    // Apply 2.4 gamma correction.
+    const __m256 y = fast_pow(linear_rgb, _mm256_set1_ps(1.0f / 2.4f));
+
+    // Compute both outcomes of the branch.
+    const __m256 a = _mm256_mul_ps(_mm256_set1_ps(12.92f), linear_rgb);
+    const __m256 b = _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(1.055f), y), _mm256_set1_ps(0.055f));
+
+    // Select one of them based on the comparison result.
+    const __m256 mask = _mm256_cmp_ps(linear_rgb, _mm256_set1_ps(0.0031308f), _CMP_LE_OQ);
+    return _mm256_blendv_ps(b, a, mask);
+}
+
+inline __m256 fast_srgb_to_linear_rgb(const __m256 srgb)
+{
+    // Apply 2.4 gamma expansion.
+    const __m256 y =
+        fast_pow(
+            _mm256_mul_ps(_mm256_add_ps(srgb, _mm256_set1_ps(0.055f)), _mm256_set1_ps(1.0f / 1.055f)),
+            _mm256_set1_ps(2.4f));
+
+    // Compute both outcomes of the branch.
+    const __m256 a = _mm256_mul_ps(_mm256_set1_ps(1.0f / 12.92f), srgb);
+
+    // Select one of them based on the comparison result.
+    const __m256 mask = _mm256_cmp_ps(srgb, _mm256_set1_ps(0.04045f), _CMP_LE_OQ);
+    return _mm256_blendv_ps(y, a, mask);
+}
+
+#endif  // APPLESEED_USE_AVX
+
 inline Color3f fast_linear_rgb_to_srgb(const Color3f& linear_rgb)
 {
     APPLESEED_SIMD4_ALIGN float transfer[4] =
@@ -865,11 +940,30 @@ Color<T, 3> spectrum_to_ciexyz(
 
 #ifdef APPLESEED_USE_SSE
 
-template <>
-inline Color3f spectrum_to_ciexyz<float, RegularSpectrum31f>(
+inline Color3f spectrum31f_to_ciexyz(
     const LightingConditions&   lighting,
-    const RegularSpectrum31f&   spectrum)
+    const float                 spectrum[32])
 {
+#ifdef APPLESEED_USE_AVX
+    // Process two wavelengths per iteration: (x, y, z, 0) for wavelength w in the low lane, w + 1 in the high lane.
+    __m256 xyz1 = _mm256_setzero_ps();
+    __m256 xyz2 = _mm256_setzero_ps();
+
+    for (size_t w = 0; w < 32; w += 4)
+    {
+        const __m256 s01 =
+            _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(spectrum[w + 0])), _mm_set1_ps(spectrum[w + 1]), 1);
+        const __m256 s23 =
+            _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(spectrum[w + 2])), _mm_set1_ps(spectrum[w + 3]), 1);
+
+        xyz1 = _mm256_add_ps(xyz1, _mm256_mul_ps(s01, _mm256_loadu_ps(&lighting.m_cmf[w + 0][0])));
+        xyz2 = _mm256_add_ps(xyz2, _mm256_mul_ps(s23, _mm256_loadu_ps(&lighting.m_cmf[w + 2][0])));
+    }
+
+    xyz1 = _mm256_add_ps(xyz1, xyz2);
+
+    const __m128 xyz = _mm_add_ps(_mm256_castps256_ps128(xyz1), _mm256_extractf128_ps(xyz1, 1));
+#else
     __m128 xyz1 = _mm_setzero_ps();
     __m128 xyz2 = _mm_setzero_ps();
     __m128 xyz3 = _mm_setzero_ps();
@@ -885,14 +979,24 @@ inline Color3f spectrum_to_ciexyz<float, RegularSpectrum31f>(
 
     xyz1 = _mm_add_ps(xyz1, xyz2);
     xyz3 = _mm_add_ps(xyz3, xyz4);
-    xyz1 = _mm_add_ps(xyz1, xyz3);
+
+    const __m128 xyz = _mm_add_ps(xyz1, xyz3);
+#endif
 
     APPLESEED_SIMD4_ALIGN float transfer[4];
-    _mm_store_ps(transfer, xyz1);
+    _mm_store_ps(transfer, xyz);
 
     return Color3f(transfer[0], transfer[1], transfer[2]);
 }
 
+template <>
+inline Color3f spectrum_to_ciexyz<float, RegularSpectrum31f>(
+    const LightingConditions&   lighting,
+    const RegularSpectrum31f&   spectrum)
+{
+    return spectrum31f_to_ciexyz(lighting, &spectrum[0]);
+}
+
 #endif  // APPLESEED_USE_SSE
 
 template <typename T, typename SpectrumType>
@@ -33,7 +33,16 @@
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/color.h"
 #include "foundation/image/colorspace.h"
+#ifdef APPLESEED_X86
+#include "foundation/image/conversionavx2.h"
+#endif
 #include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/platform/isa.h"
+#ifdef APPLESEED_USE_AVX
+#include "foundation/platform/sse.h"
+#endif
 #include "foundation/string/string.h"
 
 // Standard headers.
@@ -56,13 +65,146 @@ bool is_linear_image_file_format(const bf::path& path)
         extension == ".hdr";
 }
 
+namespace
+{
+#ifdef APPLESEED_USE_AVX
+
+    struct SRGBToLinearRGB
+    {
+        static __m256 apply(const __m256 x)
+        {
+            return fast_srgb_to_linear_rgb(x);
+        }
+    };
+
+    struct LinearRGBToSRGB
+    {
+        static __m256 apply(const __m256 x)
+        {
+            return fast_linear_rgb_to_srgb(x);
+        }
+    };
+
+    inline __m256 saturate(const __m256 x)
+    {
+        return _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    }
+
+    // Convert as many pixels as possible, eight floats at a time. Return the
+    // number of pixels converted; the remaining pixels must be converted by
+    // the scalar path.
+    template <typename Transfer>
+    size_t convert_float_pixels(
+        float* APPLESEED_RESTRICT   values,
+        const size_t                pixel_count,
+        const size_t                channel_count)
+    {
+        if (channel_count == 3)
+        {
+            // Eight RGB pixels span exactly three vectors.
+            const size_t group_count = pixel_count / 8;
+
+            for (size_t i = 0, e = group_count * 3; i < e; ++i, values += 8)
+                _mm256_storeu_ps(values, saturate(Transfer::apply(_mm256_loadu_ps(values))));
+
+            return group_count * 8;
+        }
+        else
+        {
+            // Two RGBA pixels per vector.
+            const size_t pair_count = pixel_count / 2;
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+
+            for (size_t i = 0; i < pair_count; ++i, values += 8)
+            {
+                const __m256 color = _mm256_loadu_ps(values);
+                const __m256 alpha = _mm256_permute_ps(color, _MM_SHUFFLE(3, 3, 3, 3));
+
+                // Unpremultiply, leaving colors with zero alpha untouched.
+                const __m256 nonzero = _mm256_cmp_ps(alpha, zero, _CMP_NEQ_UQ);
+                const __m256 straight =
+                    _mm256_blendv_ps(color, _mm256_mul_ps(color, _mm256_div_ps(one, alpha)), nonzero);
+
+                // Convert, saturate and premultiply by the saturated alpha.
+                const __m256 sat_alpha = saturate(alpha);
+                const __m256 result = _mm256_mul_ps(saturate(Transfer::apply(straight)), sat_alpha);
+
+                // Restore the alpha channel.
+                _mm256_storeu_ps(values, _mm256_blend_ps(result, sat_alpha, 0x88));
+            }
+
+            return pair_count * 2;
+        }
+    }
+
+#endif
+
+    size_t convert_nothing(float*, const size_t, const size_t)
+    {
+        return 0;
+    }
+
+    typedef size_t (*ConvertFloatPixels)(float*, const size_t, const size_t);
+
+    // Pick the vectorized kernels once, for the best instruction set supported
+    // both by the build and by the host CPU.
+    struct ConversionKernels
+    {
+        ConvertFloatPixels  m_srgb_to_linear_rgb;
+        ConvertFloatPixels  m_linear_rgb_to_srgb;
+
+        ConversionKernels()
+          : m_srgb_to_linear_rgb(&convert_nothing)
+          , m_linear_rgb_to_srgb(&convert_nothing)
+        {
+#ifdef APPLESEED_X86
+            if (get_runtime_isa() >= ISA::AVX2 && avx2::is_available())
+            {
+                m_srgb_to_linear_rgb = &avx2::convert_srgb_to_linear_rgb;
+                m_linear_rgb_to_srgb = &avx2::convert_linear_rgb_to_srgb;
+                return;
+            }
+#endif
+
+#ifdef APPLESEED_USE_AVX
+            m_srgb_to_linear_rgb = &convert_float_pixels<SRGBToLinearRGB>;
+            m_linear_rgb_to_srgb = &convert_float_pixels<LinearRGBToSRGB>;
+#endif
+        }
+    };
+
+    const ConversionKernels& get_conversion_kernels()
+    {
+        static const ConversionKernels kernels;
+        return kernels;
+    }
+
+    // Convert as many pixels of a floating-point tile as possible with a
+    // vectorized kernel. Return the number of pixels converted.
+    size_t convert_float_tile(Tile& tile, const ConvertFloatPixels kernel)
+    {
+        if (tile.get_pixel_format() != PixelFormatFloat)
+            return 0;
+
+        return
+            kernel(
+                reinterpret_cast<float*>(tile.get_storage()),
+                tile.get_pixel_count(),
+                tile.get_channel_count());
+    }
+}
+
 void convert_srgb_to_linear_rgb(Tile& tile)
 {
     assert(tile.get_channel_count() == 3 || tile.get_channel_count() == 4);
 
+    const size_t converted =
+        convert_float_tile(tile, get_conversion_kernels().m_srgb_to_linear_rgb);
+
     if (tile.get_channel_count() == 3)
     {
-        for (size_t i = 0, e = tile.get_pixel_count(); i < e; ++i)
+        for (size_t i = converted, e = tile.get_pixel_count(); i < e; ++i)
         {
             Color3f color;
             tile.get_pixel(i, color);
@@ -75,7 +217,7 @@ void convert_srgb_to_linear_rgb(Tile& tile)
     }
     else if (tile.get_channel_count() == 4)
     {
-        for (size_t i = 0, e = tile.get_pixel_count(); i < e; ++i)
+        for (size_t i = converted, e = tile.get_pixel_count(); i < e; ++i)
         {
             Color4f color;
             tile.get_pixel(i, color);
@@ -105,9 +247,12 @@ void convert_linear_rgb_to_srgb(Tile& tile)
 {
     assert(tile.get_channel_count() == 3 || tile.get_channel_count() == 4);
 
+    const size_t converted =
+        convert_float_tile(tile, get_conversion_kernels().m_linear_rgb_to_srgb);
+
     if (tile.get_channel_count() == 3)
     {
-        for (size_t i = 0, e = tile.get_pixel_count(); i < e; ++i)
+        for (size_t i = converted, e = tile.get_pixel_count(); i < e; ++i)
         {
             Color3f color;
             tile.get_pixel(i, color);
@@ -120,7 +265,7 @@ void convert_linear_rgb_to_srgb(Tile& tile)
     }
     else if (tile.get_channel_count() == 4)
     {
-        for (size_t i = 0, e = tile.get_pixel_count(); i < e; ++i)
+        for (size_t i = converted, e = tile.get_pixel_count(); i < e; ++i)
         {
             Color4f color;
             tile.get_pixel(i, color);
@@ -0,0 +1,232 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "conversionavx2.h"
+
+// Standard headers.
+#if defined __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace foundation {
+namespace avx2 {
+
+#if defined __AVX2__
+
+namespace
+{
+    //
+    // Fast power function, same approximation as in foundation/math/fastmath.h.
+    //
+
+    inline __m256 fast_pow2(const __m256 p)
+    {
+        const __m256 ltzero = _mm256_cmp_ps(p, _mm256_setzero_ps(), _CMP_LT_OQ);
+        const __m256 offset = _mm256_and_ps(ltzero, _mm256_set1_ps(1.0f));
+        const __m256 clipp = _mm256_max_ps(p, _mm256_set1_ps(-126.0f));
+        const __m256i w = _mm256_cvttps_epi32(clipp);
+        const __m256 z = _mm256_add_ps(_mm256_sub_ps(clipp, _mm256_cvtepi32_ps(w)), offset);
+
+        const __m256 v =
+            _mm256_fnmadd_ps(
+                _mm256_set1_ps(1.49012907f),
+                z,
+                _mm256_add_ps(
+                    _mm256_add_ps(clipp, _mm256_set1_ps(121.2740575f)),
+                    _mm256_div_ps(_mm256_set1_ps(27.7280233f), _mm256_sub_ps(_mm256_set1_ps(4.84252568f), z))));
+
+        return _mm256_castsi256_ps(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_set1_ps(1 << 23), v)));
+    }
+
+    inline __m256 fast_log2(const __m256 x)
+    {
+        const __m256 a = _mm256_castsi256_ps(_mm256_set1_epi32(0x007FFFFF));
+        const __m256 b = _mm256_castsi256_ps(_mm256_set1_epi32(0x3f000000));
+
+        const __m256 mx = _mm256_or_ps(_mm256_and_ps(x, a), b);
+        const __m256 y =
+            _mm256_fmsub_ps(
+                _mm256_cvtepi32_ps(_mm256_castps_si256(x)),
+                _mm256_set1_ps(1.1920928955078125e-7f),
+                _mm256_set1_ps(124.22551499f));
+
+        return
+            _mm256_sub_ps(
+                _mm256_fnmadd_ps(_mm256_set1_ps(1.498030302f), mx, y),
+                _mm256_div_ps(
+                    _mm256_set1_ps(1.72587999f),
+                    _mm256_add_ps(_mm256_set1_ps(0.3520887068f), mx)));
+    }
+
+    inline __m256 fast_pow(const __m256 x, const __m256 p)
+    {
+        return fast_pow2(_mm256_mul_ps(p, fast_log2(x)));
+    }
+
+    inline __m256 saturate(const __m256 x)
+    {
+        return _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    }
+
+
+    //
+    // Transfer functions.
+    //
+
+    struct SRGBToLinearRGB
+    {
+        static __m256 apply(const __m256 srgb)
+        {
+            // Apply 2.4 gamma expansion.
+            const __m256 y =
+                fast_pow(
+                    _mm256_mul_ps(_mm256_add_ps(srgb, _mm256_set1_ps(0.055f)), _mm256_set1_ps(1.0f / 1.055f)),
+                    _mm256_set1_ps(2.4f));
+
+            // Select the linear segment for small values.
+            const __m256 a = _mm256_mul_ps(_mm256_set1_ps(1.0f / 12.92f), srgb);
+            const __m256 mask = _mm256_cmp_ps(srgb, _mm256_set1_ps(0.04045f), _CMP_LE_OQ);
+            return _mm256_blendv_ps(y, a, mask);
+        }
+    };
+
+    struct LinearRGBToSRGB
+    {
+        static __m256 apply(const __m256 linear_rgb)
+        {
+            // Apply 2.4 gamma correction.
+            const __m256 y = fast_pow(linear_rgb, _mm256_set1_ps(1.0f / 2.4f));
+            const __m256 b = _mm256_fmsub_ps(_mm256_set1_ps(1.055f), y, _mm256_set1_ps(0.055f));
+
+            // Select the linear segment for small values.
+            const __m256 a = _mm256_mul_ps(_mm256_set1_ps(12.92f), linear_rgb);
+            const __m256 mask = _mm256_cmp_ps(linear_rgb, _mm256_set1_ps(0.0031308f), _CMP_LE_OQ);
+            return _mm256_blendv_ps(b, a, mask);
+        }
+    };
+
+
+    //
+    // Conversion kernel.
+    //
+
+    template <typename Transfer>
+    size_t convert(
+        float*          values,
+        const size_t    pixel_count,
+        const size_t    channel_count)
+    {
+        if (channel_count == 3)
+        {
+            // Eight RGB pixels span exactly three vectors.
+            const size_t group_count = pixel_count / 8;
+
+            for (size_t i = 0, e = group_count * 3; i < e; ++i, values += 8)
+                _mm256_storeu_ps(values, saturate(Transfer::apply(_mm256_loadu_ps(values))));
+
+            return group_count * 8;
+        }
+        else
+        {
+            // Two RGBA pixels per vector.
+            const size_t pair_count = pixel_count / 2;
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+
+            for (size_t i = 0; i < pair_count; ++i, values += 8)
+            {
+                const __m256 color = _mm256_loadu_ps(values);
+                const __m256 alpha = _mm256_permute_ps(color, _MM_SHUFFLE(3, 3, 3, 3));
+
+                // Unpremultiply, leaving colors with zero alpha untouched.
+                const __m256 nonzero = _mm256_cmp_ps(alpha, zero, _CMP_NEQ_UQ);
+                const __m256 straight =
+                    _mm256_blendv_ps(color, _mm256_mul_ps(color, _mm256_div_ps(one, alpha)), nonzero);
+
+                // Convert, saturate and premultiply by the saturated alpha.
+                const __m256 sat_alpha = saturate(alpha);
+                const __m256 result = _mm256_mul_ps(saturate(Transfer::apply(straight)), sat_alpha);
+
+                // Restore the alpha channel.
+                _mm256_storeu_ps(values, _mm256_blend_ps(result, sat_alpha, 0x88));
+            }
+
+            return pair_count * 2;
+        }
+    }
+}
+
+bool is_available()
+{
+    return true;
+}
+
+size_t convert_srgb_to_linear_rgb(
+    float*          values,
+    const size_t    pixel_count,
+    const size_t    channel_count)
+{
+    return convert<SRGBToLinearRGB>(values, pixel_count, channel_count);
+}
+
+size_t convert_linear_rgb_to_srgb(
+    float*          values,
+    const size_t    pixel_count,
+    const size_t    channel_count)
+{
+    return convert<LinearRGBToSRGB>(values, pixel_count, channel_count);
+}
+
+#else
+
+bool is_available()
+{
+    return false;
+}
+
+size_t convert_srgb_to_linear_rgb(
+    float*          /*values*/,
+    const size_t    /*pixel_count*/,
+    const size_t    /*channel_count*/)
+{
+    return 0;
+}
+
+size_t convert_linear_rgb_to_srgb(
+    float*          /*values*/,
+    const size_t    /*pixel_count*/,
+    const size_t    /*channel_count*/)
+{
+    return 0;
+}
+
+#endif
+
+}   // namespace avx2
+}   // namespace foundation
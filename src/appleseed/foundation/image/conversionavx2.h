@@ -0,0 +1,63 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// Standard headers.
+#include <cstddef>
+
+namespace foundation {
+namespace avx2 {
+
+//
+// AVX2 versions of the color space conversion kernels of foundation/image/conversion.cpp.
+//
+// This file is compiled with AVX2 and FMA enabled regardless of the build options,
+// and must only be called after checking that the host supports these instruction
+// sets (see foundation/platform/isa.h). To avoid mixing AVX2 code into inline
+// functions shared with the rest of the library, the implementation does not
+// include any appleseed header.
+//
+
+// Return true if the kernels were compiled with AVX2 code.
+bool is_available();
+
+// Convert as many pixels as possible of an RGB or RGBA (premultiplied alpha) buffer of
+// floating-point values. Return the number of pixels converted; the remaining pixels
+// must be converted by another path.
+size_t convert_srgb_to_linear_rgb(
+    float*          values,
+    const size_t    pixel_count,
+    const size_t    channel_count);
+size_t convert_linear_rgb_to_srgb(
+    float*          values,
+    const size_t    pixel_count,
+    const size_t    channel_count);
+
+}   // namespace avx2
+}   // namespace foundation
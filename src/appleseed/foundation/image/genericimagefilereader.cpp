@@ -35,10 +35,16 @@
 #include "foundation/image/genericprogressiveimagefilereader.h"
 #include "foundation/image/image.h"
 #include "foundation/image/tile.h"
+#include "foundation/platform/system.h"
+#include "foundation/platform/thread.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
+#include <exception>
+#include <functional>
 #include <memory>
+#include <vector>
 
 namespace foundation
 {
@@ -47,6 +53,61 @@ namespace foundation
 // GenericImageFileReader class implementation.
 //
 
+namespace
+{
+    // Minimum number of pixels that justifies decoding with an additional thread,
+    // given that each thread opens the file on its own.
+    const size_t MinPixelsPerThread = 1024 * 1024;
+
+    size_t compute_thread_count(const CanvasProperties& props)
+    {
+        size_t thread_count =
+            std::min(
+                System::get_logical_cpu_core_count(),
+                props.m_pixel_count / MinPixelsPerThread);
+
+        if (props.m_tile_count > 1)
+            thread_count = std::min(thread_count, props.m_tile_count);
+
+        return std::max<size_t>(thread_count, 1);
+    }
+
+    // Invoke worker(thread_index) for all thread indices in [0, thread_count) concurrently
+    // and rethrow the first exception thrown by a worker, if any.
+    template <typename Worker>
+    void run_workers(const size_t thread_count, const Worker& worker)
+    {
+        std::vector<std::exception_ptr> exceptions(thread_count);
+
+        auto guarded_worker = [&worker, &exceptions](const size_t thread_index)
+        {
+            try
+            {
+                worker(thread_index);
+            }
+            catch (...)
+            {
+                exceptions[thread_index] = std::current_exception();
+            }
+        };
+
+        boost::thread_group threads;
+
+        for (size_t i = 1; i < thread_count; ++i)
+            threads.create_thread(std::bind(guarded_worker, i));
+
+        guarded_worker(0);
+
+        threads.join_all();
+
+        for (const std::exception_ptr& e : exceptions)
+        {
+            if (e)
+                std::rethrow_exception(e);
+        }
+    }
+}
+
 Image* GenericImageFileReader::read(
     const char*         filename,
     ImageAttributes*    image_attributes)
@@ -69,14 +130,79 @@ Image* GenericImageFileReader::read(
             props.m_channel_count,
             props.m_pixel_format));
 
-    for (size_t tile_y = 0; tile_y < props.m_tile_count_y; ++tile_y)
+    // Large images are decoded by multiple threads, each with its own reader since
+    // OpenImageIO serializes accesses to a given image input. This requires that the
+    // file can be read in any order.
+    const size_t thread_count =
+        reader.supports_random_access() ? compute_thread_count(props) : 1;
+
+    if (thread_count == 1)
     {
-        for (size_t tile_x = 0; tile_x < props.m_tile_count_x; ++tile_x)
+        for (size_t tile_y = 0; tile_y < props.m_tile_count_y; ++tile_y)
         {
-            std::unique_ptr<Tile> tile(reader.read_tile(tile_x, tile_y));
-            image->set_tile(tile_x, tile_y, tile.release());
+            for (size_t tile_x = 0; tile_x < props.m_tile_count_x; ++tile_x)
+            {
+                std::unique_ptr<Tile> tile(reader.read_tile(tile_x, tile_y));
+                image->set_tile(tile_x, tile_y, tile.release());
+            }
         }
     }
+    else if (props.m_tile_count > 1)
+    {
+        // Tiled image: distribute tiles over threads. Distinct tiles of an image
+        // can safely be set concurrently.
+        run_workers(
+            thread_count,
+            [filename, thread_count, &props, &reader, &image](const size_t thread_index)
+            {
+                GenericProgressiveImageFileReader thread_reader;
+                GenericProgressiveImageFileReader* r = &reader;
+
+                if (thread_index > 0)
+                {
+                    thread_reader.open(filename);
+                    r = &thread_reader;
+                }
+
+                for (size_t i = thread_index; i < props.m_tile_count; i += thread_count)
+                {
+                    const size_t tile_x = i % props.m_tile_count_x;
+                    const size_t tile_y = i / props.m_tile_count_x;
+                    image->set_tile(tile_x, tile_y, r->read_tile(tile_x, tile_y));
+                }
+            });
+    }
+    else
+    {
+        // Scanline image: split the canvas into bands of scanlines, decoded
+        // directly into the single tile of the image.
+        Tile* tile =
+            new Tile(
+                props.m_canvas_width,
+                props.m_canvas_height,
+                props.m_channel_count,
+                props.m_pixel_format);
+        image->set_tile(0, 0, tile);
+
+        run_workers(
+            thread_count,
+            [filename, thread_count, &props, &reader, tile](const size_t thread_index)
+            {
+                GenericProgressiveImageFileReader thread_reader;
+                GenericProgressiveImageFileReader* r = &reader;
+
+                if (thread_index > 0)
+                {
+                    thread_reader.open(filename);
+                    r = &thread_reader;
+                }
+
+                r->read_scanlines(
+                    props.m_canvas_height * thread_index / thread_count,
+                    props.m_canvas_height * (thread_index + 1) / thread_count,
+                    tile);
+            });
+    }
 
     reader.close();
 
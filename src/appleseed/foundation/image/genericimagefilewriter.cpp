@@ -342,6 +342,10 @@ struct GenericImageFileWriter::Impl
         // Retrieve canvas properties.
         const CanvasProperties& props = canvas->properties();
 
+        // Retrieve image spec.
+        assert(image_index < m_spec.size());
+        const OIIO::ImageSpec& spec = m_spec[image_index];
+
         // Construct the temporary buffer holding one row of tiles in target format.
         std::unique_ptr<std::uint8_t[]> buffer(new std::uint8_t[props.m_canvas_width * props.m_tile_height * props.m_pixel_size]);
         std::uint8_t* APPLESEED_RESTRICT buffer_ptr = buffer.get();
@@ -384,8 +388,8 @@ struct GenericImageFileWriter::Impl
 
             // Write scanline into the file.
             if (!m_writer->write_scanlines(
-                    static_cast<int>(y_begin),
-                    static_cast<int>(y_end),
+                    spec.y + static_cast<int>(y_begin),
+                    spec.y + static_cast<int>(y_end),
                     0,
                     convert_pixel_format(props.m_pixel_format),
                     buffer_ptr))
@@ -432,7 +436,7 @@ struct GenericImageFileWriter::Impl
                 const size_t ystride =
                     xstride *
                     std::min(
-                        static_cast<size_t>(spec.width + spec.x - tile_offset_x),
+                        static_cast<size_t>(spec.width - tile_offset_x),
                         static_cast<size_t>(spec.tile_width));
 
                 // Retrieve the (tile_x, tile_y) tile.
@@ -440,8 +444,8 @@ struct GenericImageFileWriter::Impl
 
                 // Write the tile into the file.
                 if (!m_writer->write_tile(
-                        static_cast<int>(tile_offset_x),
-                        static_cast<int>(tile_offset_y),
+                        spec.x + static_cast<int>(tile_offset_x),
+                        spec.y + static_cast<int>(tile_offset_y),
                         0,
                         convert_pixel_format(props.m_pixel_format),
                         tile.get_storage(),
@@ -493,6 +497,26 @@ void GenericImageFileWriter::set_image_channels(
     impl->set_image_channels(channel_count, channel_names);
 }
 
+void GenericImageFileWriter::set_image_data_window(
+    const size_t    origin_x,
+    const size_t    origin_y,
+    const size_t    display_width,
+    const size_t    display_height)
+{
+    assert(!impl->m_spec.empty());
+
+    OIIO::ImageSpec& spec = impl->m_spec.back();
+    assert(origin_x + static_cast<size_t>(spec.width) <= display_width);
+    assert(origin_y + static_cast<size_t>(spec.height) <= display_height);
+
+    spec.x = static_cast<int>(origin_x);
+    spec.y = static_cast<int>(origin_y);
+    spec.full_x = 0;
+    spec.full_y = 0;
+    spec.full_width = static_cast<int>(display_width);
+    spec.full_height = static_cast<int>(display_height);
+}
+
 void GenericImageFileWriter::set_image_attributes(const ImageAttributes& image_attributes)
 {
     assert(!impl->m_spec.empty());
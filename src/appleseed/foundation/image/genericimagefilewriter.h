@@ -67,6 +67,15 @@ class APPLESEED_DLLSYMBOL GenericImageFileWriter
         const size_t    channel_count,
         const char**    channel_names);
 
+    // Place the topmost image on the stack at a given position inside a larger display
+    // window whose origin is (0, 0). Only meaningful for formats with data windows
+    // such as OpenEXR.
+    void set_image_data_window(
+        const size_t    origin_x,
+        const size_t    origin_y,
+        const size_t    display_width,
+        const size_t    display_height);
+
     // Set attributes of the topmost image on the stack.
     void set_image_attributes(const ImageAttributes& image_attributes);
 
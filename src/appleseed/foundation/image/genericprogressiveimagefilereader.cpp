@@ -254,6 +254,13 @@ bool GenericProgressiveImageFileReader::choose_subimage(const size_t subimage) c
     return success;
 }
 
+bool GenericProgressiveImageFileReader::supports_random_access() const
+{
+    assert(is_open());
+
+    return impl->m_supports_random_access;
+}
+
 Tile* GenericProgressiveImageFileReader::read_tile(
     const size_t        tile_x,
     const size_t        tile_y)
@@ -377,4 +384,33 @@ void GenericProgressiveImageFileReader::read_tile(
     }
 }
 
+void GenericProgressiveImageFileReader::read_scanlines(
+    const size_t        y_begin,
+    const size_t        y_end,
+    Tile*               output_tile)
+{
+    assert(is_open());
+    assert(output_tile);
+    assert(output_tile->get_channel_count() == impl->m_props.m_channel_count);
+    assert(output_tile->get_pixel_format() == impl->m_props.m_pixel_format);
+    assert(output_tile->get_width() == impl->m_props.m_canvas_width);
+    assert(output_tile->get_height() == impl->m_props.m_canvas_height);
+    assert(y_begin <= y_end);
+    assert(y_end <= impl->m_props.m_canvas_height);
+
+    if (y_begin == y_end)
+        return;
+
+    // Scanlines are addressed relatively to the pixel data window.
+    const OIIO::ImageSpec& spec = impl->m_input->spec();
+
+    if (!impl->m_input->read_scanlines(
+            spec.y + static_cast<int>(y_begin),
+            spec.y + static_cast<int>(y_end),
+            spec.z,
+            spec.format,
+            output_tile->pixel(0, y_begin)))
+        throw ExceptionIOError(impl->m_input->geterror().c_str());
+}
+
 }   // namespace foundation
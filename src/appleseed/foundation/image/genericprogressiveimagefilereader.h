@@ -82,6 +82,9 @@ class APPLESEED_DLLSYMBOL GenericProgressiveImageFileReader
     // Choose the layer in the image file if available.
     bool choose_subimage(const size_t subimage) const;
 
+    // Return true if tiles or scanlines can be read in any order.
+    bool supports_random_access() const;
+
     // Read an image tile. Returns a newly allocated tile.
     Tile* read_tile(
         const size_t        tile_x,
@@ -93,6 +96,13 @@ class APPLESEED_DLLSYMBOL GenericProgressiveImageFileReader
         const size_t        tile_y,
         Tile*               output_tile);
 
+    // Read scanlines [y_begin, y_end) of the image. Outputs the content in the
+    // given tile, which must cover the whole canvas. Other scanlines are left untouched.
+    void read_scanlines(
+        const size_t        y_begin,
+        const size_t        y_end,
+        Tile*               output_tile);
+
   private:
     struct Impl;
     Impl* impl;
@@ -34,11 +34,13 @@
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/color.h"
 #include "foundation/image/tile.h"
+#include "foundation/math/aabb.h"
 
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -108,6 +110,13 @@ class APPLESEED_DLLSYMBOL ICanvas
     // This causes all tiles to be accessed, and created if necessary.
     template <typename T, size_t N>
     void clear(const Color<T, N>& color);
+
+    // Set all pixels of the tiles overlapping a given rectangle to a given color.
+    // Other tiles are left untouched, and are not created if they don't exist yet.
+    template <typename T, size_t N>
+    void clear(
+        const Color<T, N>&      color,
+        const AABB2u&           rect);
 };
 
 
@@ -280,4 +289,23 @@ inline void ICanvas::clear(const Color<T, N>& color)
     }
 }
 
+template <typename T, size_t N>
+inline void ICanvas::clear(
+    const Color<T, N>&  color,
+    const AABB2u&       rect)
+{
+    const CanvasProperties& props = properties();
+    assert(N == props.m_channel_count);
+    assert(rect.is_valid());
+
+    const size_t max_tx = std::min(rect.max.x / props.m_tile_width, props.m_tile_count_x - 1);
+    const size_t max_ty = std::min(rect.max.y / props.m_tile_height, props.m_tile_count_y - 1);
+
+    for (size_t ty = rect.min.y / props.m_tile_height; ty <= max_ty; ++ty)
+    {
+        for (size_t tx = rect.min.x / props.m_tile_width; tx <= max_tx; ++tx)
+            tile(tx, ty).clear(color);
+    }
+}
+
 }   // namespace foundation
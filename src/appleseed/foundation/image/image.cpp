@@ -151,6 +151,68 @@ Image::Image(
     }
 }
 
+Image::Image(
+    const Image&        source,
+    const AABB2u&       window,
+    const size_t        tile_width,
+    const size_t        tile_height,
+    const PixelFormat   pixel_format)
+  : m_props(
+        window.extent(0),
+        window.extent(1),
+        tile_width,
+        tile_height,
+        source.properties().m_channel_count,
+        pixel_format)
+{
+    assert(window.is_valid());
+    assert(window.max.x < source.properties().m_canvas_width);
+    assert(window.max.y < source.properties().m_canvas_height);
+    assert(tile_width > 0);
+    assert(tile_height > 0);
+
+    const CanvasProperties& source_props = source.properties();
+
+    m_tiles = new Tile*[m_props.m_tile_count];
+
+    for (size_t ty = 0; ty < m_props.m_tile_count_y; ++ty)
+    {
+        for (size_t tx = 0; tx < m_props.m_tile_count_x; ++tx)
+        {
+            const size_t tw = m_props.get_tile_width(tx);
+            const size_t th = m_props.get_tile_height(ty);
+
+            Tile* tile =
+                new Tile(
+                    tw,
+                    th,
+                    m_props.m_channel_count,
+                    m_props.m_pixel_format);
+
+            m_tiles[ty * m_props.m_tile_count_x + tx] = tile;
+
+            for (size_t py = 0; py < th; ++py)
+            {
+                for (size_t px = 0; px < tw; ++px)
+                {
+                    const size_t ix = window.min.x + tx * m_props.m_tile_width + px;
+                    const size_t iy = window.min.y + ty * m_props.m_tile_height + py;
+                    const std::uint8_t* source_pixel = source.pixel(ix, iy);
+
+                    Pixel::convert(
+                        source_props.m_pixel_format,
+                        source_pixel,
+                        source_pixel + source_props.m_pixel_size,
+                        1,
+                        m_props.m_pixel_format,
+                        tile->pixel(px, py),
+                        1);
+                }
+            }
+        }
+    }
+}
+
 Image::Image(
     const Image&        source,
     const PixelFormat   pixel_format,
@@ -34,6 +34,7 @@
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/icanvas.h"
 #include "foundation/image/pixel.h"
+#include "foundation/math/aabb.h"
 
 // appleseed.main headers.
 #include "main/dllsymbol.h"
@@ -80,6 +81,15 @@ class APPLESEED_DLLSYMBOL Image
         const size_t        tile_height,        // tile height, in pixels
         const PixelFormat   pixel_format);
 
+    // Copy a rectangular window of an image into a new image the size of the window.
+    // Only the tiles of the source image that overlap the window are accessed.
+    Image(
+        const Image&        source,
+        const AABB2u&       window,             // inclusive, in pixels
+        const size_t        tile_width,         // tile width, in pixels
+        const size_t        tile_height,        // tile height, in pixels
+        const PixelFormat   pixel_format);
+
     // Construct an image by converting an existing image to a given pixel format,
     // and allowing reordering, deletion of channels.
     Image(
@@ -0,0 +1,305 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "outofcoreimage.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/tile.h"
+
+// Boost headers.
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
+
+// Standard headers.
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <string>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// OutOfCoreImage class implementation.
+//
+// Each tile has a fixed-size slot in the scratch file, large enough for a full-size tile.
+// Slots are only written when tiles are evicted; tiles that were never evicted are blank.
+//
+
+struct OutOfCoreImage::Impl
+{
+    typedef std::list<size_t> TileList;
+
+    const std::string           m_scratch_file_path;
+    const size_t                m_max_cached_tiles;
+    const size_t                m_slot_size;
+    mutable boost::mutex        m_mutex;
+    std::fstream                m_file;
+    std::vector<std::uint8_t>   m_stored;           // whether a tile has a copy in the scratch file
+    std::vector<size_t>         m_pin_counts;
+    TileList                    m_cached_tiles;     // resident unpinned tiles, most recently used first
+    std::vector<TileList::iterator> m_cache_entries;
+    size_t                      m_resident_tile_count;
+
+    Impl(
+        const CanvasProperties& props,
+        const char*             scratch_file_path,
+        const size_t            max_cached_tiles)
+      : m_scratch_file_path(scratch_file_path)
+      , m_max_cached_tiles(max_cached_tiles > 0 ? max_cached_tiles : 1)
+      , m_slot_size(props.m_tile_width * props.m_tile_height * props.m_pixel_size)
+      , m_stored(props.m_tile_count, 0)
+      , m_pin_counts(props.m_tile_count, 0)
+      , m_cache_entries(props.m_tile_count)
+      , m_resident_tile_count(0)
+    {
+        m_file.open(
+            scratch_file_path,
+            std::ios_base::in | std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+
+        if (!m_file.is_open())
+            throw ExceptionIOError("failed to create scratch file", scratch_file_path);
+
+        for (size_t i = 0; i < props.m_tile_count; ++i)
+            m_cache_entries[i] = m_cached_tiles.end();
+    }
+
+    ~Impl()
+    {
+        m_file.close();
+        std::remove(m_scratch_file_path.c_str());
+    }
+
+    std::streamoff get_slot_offset(const size_t tile_index) const
+    {
+        return static_cast<std::streamoff>(tile_index) * static_cast<std::streamoff>(m_slot_size);
+    }
+};
+
+OutOfCoreImage::OutOfCoreImage(
+    const size_t        image_width,
+    const size_t        image_height,
+    const size_t        tile_width,
+    const size_t        tile_height,
+    const size_t        channel_count,
+    const PixelFormat   pixel_format,
+    const char*         scratch_file_path,
+    const size_t        max_cached_tiles)
+  : Image(
+        image_width,
+        image_height,
+        tile_width,
+        tile_height,
+        channel_count,
+        pixel_format)
+  , impl(new Impl(m_props, scratch_file_path, max_cached_tiles))
+{
+}
+
+OutOfCoreImage::~OutOfCoreImage()
+{
+    delete impl;
+}
+
+namespace
+{
+    size_t get_tile_index(
+        const CanvasProperties& props,
+        const size_t            tile_x,
+        const size_t            tile_y)
+    {
+        assert(tile_x < props.m_tile_count_x);
+        assert(tile_y < props.m_tile_count_y);
+
+        return tile_y * props.m_tile_count_x + tile_x;
+    }
+}
+
+Tile& OutOfCoreImage::tile(
+    const size_t        tile_x,
+    const size_t        tile_y)
+{
+    const size_t tile_index = get_tile_index(m_props, tile_x, tile_y);
+
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    Tile* tile = load_tile(tile_x, tile_y);
+
+    if (impl->m_pin_counts[tile_index] == 0)
+    {
+        // Move the tile to the front of the cache.
+        if (impl->m_cache_entries[tile_index] != impl->m_cached_tiles.end())
+            impl->m_cached_tiles.erase(impl->m_cache_entries[tile_index]);
+        impl->m_cached_tiles.push_front(tile_index);
+        impl->m_cache_entries[tile_index] = impl->m_cached_tiles.begin();
+
+        trim_cache();
+    }
+
+    return *tile;
+}
+
+const Tile& OutOfCoreImage::tile(
+    const size_t        tile_x,
+    const size_t        tile_y) const
+{
+    return const_cast<OutOfCoreImage*>(this)->tile(tile_x, tile_y);
+}
+
+void OutOfCoreImage::pin_tile(
+    const size_t        tile_x,
+    const size_t        tile_y)
+{
+    const size_t tile_index = get_tile_index(m_props, tile_x, tile_y);
+
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    load_tile(tile_x, tile_y);
+
+    if (impl->m_pin_counts[tile_index]++ == 0 &&
+        impl->m_cache_entries[tile_index] != impl->m_cached_tiles.end())
+    {
+        impl->m_cached_tiles.erase(impl->m_cache_entries[tile_index]);
+        impl->m_cache_entries[tile_index] = impl->m_cached_tiles.end();
+    }
+}
+
+void OutOfCoreImage::unpin_tile(
+    const size_t        tile_x,
+    const size_t        tile_y)
+{
+    const size_t tile_index = get_tile_index(m_props, tile_x, tile_y);
+
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    assert(impl->m_pin_counts[tile_index] > 0);
+
+    if (--impl->m_pin_counts[tile_index] == 0)
+    {
+        // The tile is done with, make it the next one to be evicted.
+        impl->m_cached_tiles.push_back(tile_index);
+        impl->m_cache_entries[tile_index] = --impl->m_cached_tiles.end();
+
+        trim_cache();
+    }
+}
+
+void OutOfCoreImage::discard_tiles()
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    for (size_t i = 0; i < m_props.m_tile_count; ++i)
+    {
+        assert(impl->m_pin_counts[i] == 0);
+
+        delete m_tiles[i];
+        m_tiles[i] = nullptr;
+
+        impl->m_stored[i] = 0;
+        impl->m_cache_entries[i] = impl->m_cached_tiles.end();
+    }
+
+    impl->m_cached_tiles.clear();
+    impl->m_resident_tile_count = 0;
+}
+
+size_t OutOfCoreImage::get_resident_tile_count() const
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    return impl->m_resident_tile_count;
+}
+
+Tile* OutOfCoreImage::load_tile(
+    const size_t        tile_x,
+    const size_t        tile_y)
+{
+    const size_t tile_index = get_tile_index(m_props, tile_x, tile_y);
+
+    if (m_tiles[tile_index] != nullptr)
+        return m_tiles[tile_index];
+
+    Tile* tile =
+        new Tile(
+            m_props.get_tile_width(tile_x),
+            m_props.get_tile_height(tile_y),
+            m_props.m_channel_count,
+            m_props.m_pixel_format);
+
+    if (impl->m_stored[tile_index])
+    {
+        impl->m_file.seekg(impl->get_slot_offset(tile_index));
+        impl->m_file.read(reinterpret_cast<char*>(tile->get_storage()), tile->get_size());
+
+        if (!impl->m_file)
+        {
+            delete tile;
+            throw ExceptionIOError("failed to read from scratch file", impl->m_scratch_file_path.c_str());
+        }
+    }
+    else std::memset(tile->get_storage(), 0, tile->get_size());
+
+    m_tiles[tile_index] = tile;
+    ++impl->m_resident_tile_count;
+
+    return tile;
+}
+
+void OutOfCoreImage::trim_cache()
+{
+    while (impl->m_cached_tiles.size() > impl->m_max_cached_tiles)
+    {
+        const size_t tile_index = impl->m_cached_tiles.back();
+        impl->m_cached_tiles.pop_back();
+        impl->m_cache_entries[tile_index] = impl->m_cached_tiles.end();
+
+        Tile* tile = m_tiles[tile_index];
+        assert(tile != nullptr);
+
+        impl->m_file.seekp(impl->get_slot_offset(tile_index));
+        impl->m_file.write(reinterpret_cast<const char*>(tile->get_storage()), tile->get_size());
+
+        if (!impl->m_file)
+            throw ExceptionIOError("failed to write to scratch file", impl->m_scratch_file_path.c_str());
+
+        impl->m_stored[tile_index] = 1;
+
+        delete tile;
+        m_tiles[tile_index] = nullptr;
+        --impl->m_resident_tile_count;
+    }
+}
+
+}   // namespace foundation
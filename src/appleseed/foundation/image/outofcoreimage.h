@@ -0,0 +1,114 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// An image whose tiles are stored in a scratch file on disk and only kept in memory
+// while they are in use.
+//
+// Pinned tiles stay resident until they are unpinned. Tiles accessed without being
+// pinned are kept in a small least-recently-used cache and written back to the
+// scratch file when they are evicted from it, so that traversing the image tile
+// by tile (e.g. to write it to disk) only ever keeps a few tiles in memory.
+//
+// Pinning, unpinning and accessing tiles are thread-safe. However, a reference to
+// an unpinned tile is only valid until the next access to another unpinned tile,
+// so unpinned tiles must only be accessed from a single thread at a time.
+//
+
+class APPLESEED_DLLSYMBOL OutOfCoreImage
+  : public Image
+{
+  public:
+    // Construct an empty image. The scratch file is created immediately and deleted
+    // when the image is destroyed. Throws a foundation::ExceptionIOError if the
+    // scratch file cannot be created.
+    OutOfCoreImage(
+        const size_t        image_width,        // image width, in pixels
+        const size_t        image_height,       // image height, in pixels
+        const size_t        tile_width,         // tile width, in pixels
+        const size_t        tile_height,        // tile height, in pixels
+        const size_t        channel_count,
+        const PixelFormat   pixel_format,
+        const char*         scratch_file_path,
+        const size_t        max_cached_tiles);  // maximum number of resident unpinned tiles
+
+    // Destructor.
+    ~OutOfCoreImage() override;
+
+    // Access a given tile, loading it from the scratch file if necessary.
+    Tile& tile(
+        const size_t        tile_x,
+        const size_t        tile_y) override;
+    const Tile& tile(
+        const size_t        tile_x,
+        const size_t        tile_y) const override;
+
+    // Keep a given tile in memory until it is unpinned. Tiles may be pinned several times.
+    void pin_tile(
+        const size_t        tile_x,
+        const size_t        tile_y);
+    void unpin_tile(
+        const size_t        tile_x,
+        const size_t        tile_y);
+
+    // Discard the contents of all tiles, resetting them to zero, without touching the scratch file.
+    // No tile may be pinned.
+    void discard_tiles();
+
+    // Return the number of tiles currently in memory.
+    size_t get_resident_tile_count() const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+
+    // Make sure a given tile is resident. The mutex must be locked.
+    Tile* load_tile(
+        const size_t        tile_x,
+        const size_t        tile_y);
+
+    // Evict the least recently used unpinned tiles beyond the cache capacity. The mutex must be locked.
+    void trim_cache();
+};
+
+}   // namespace foundation
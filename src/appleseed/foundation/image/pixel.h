@@ -505,10 +505,15 @@ inline void Pixel::convert_to_format<Half>(
       case PixelFormatFloat:                // lossless half -> float
         {
             float* typed_dest = reinterpret_cast<float*>(dest);
-            for (const Half* it = src_begin; it < src_end; it += src_stride)
+            if (src_stride == 1 && dest_stride == 1)
+                half_to_float(src_begin, typed_dest, src_end - src_begin);
+            else
             {
-                *typed_dest = static_cast<float>(*it);
-                typed_dest += dest_stride;
+                for (const Half* it = src_begin; it < src_end; it += src_stride)
+                {
+                    *typed_dest = static_cast<float>(*it);
+                    typed_dest += dest_stride;
+                }
             }
         }
         break;
@@ -583,10 +588,15 @@ inline void Pixel::convert_to_format<float>(
       case PixelFormatHalf:                 // lossy float -> half
         {
             Half* typed_dest = reinterpret_cast<Half*>(dest);
-            for (const float* it = src_begin; it < src_end; it += src_stride)
-            {
-                *typed_dest = static_cast<Half>(*it);
-                typed_dest += dest_stride;
+            if (src_stride == 1 && dest_stride == 1)
+                float_to_half(src_begin, typed_dest, src_end - src_begin);
+            else
+            {
+                for (const float* it = src_begin; it < src_end; it += src_stride)
+                {
+                    *typed_dest = static_cast<Half>(*it);
+                    typed_dest += dest_stride;
+                }
             }
         }
         break;
@@ -248,6 +248,14 @@ inline void RegularSpectrum<T, N>::set(const ValueType val)
 template <>
 APPLESEED_FORCE_INLINE void RegularSpectrum<float, 31>::set(const float val)
 {
+#ifdef APPLESEED_USE_AVX
+    const __m256 mval = _mm256_set1_ps(val);
+
+    _mm256_storeu_ps(&m_samples[ 0], mval);
+    _mm256_storeu_ps(&m_samples[ 8], mval);
+    _mm256_storeu_ps(&m_samples[16], mval);
+    _mm256_storeu_ps(&m_samples[24], mval);
+#else
     const __m128 mval = _mm_set1_ps(val);
 
     _mm_store_ps(&m_samples[ 0], mval);
@@ -258,6 +266,7 @@ APPLESEED_FORCE_INLINE void RegularSpectrum<float, 31>::set(const float val)
     _mm_store_ps(&m_samples[20], mval);
     _mm_store_ps(&m_samples[24], mval);
     _mm_store_ps(&m_samples[28], mval);
+#endif
 }
 
 #endif  // APPLESEED_USE_SSE
@@ -469,6 +478,12 @@ inline RegularSpectrum<T, N>& operator+=(RegularSpectrum<T, N>& lhs, const Regul
 template <>
 APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator+=(RegularSpectrum<float, 31>& lhs, const RegularSpectrum<float, 31>& rhs)
 {
+#ifdef APPLESEED_USE_AVX
+    _mm256_storeu_ps(&lhs[ 0], _mm256_add_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&rhs[ 0])));
+    _mm256_storeu_ps(&lhs[ 8], _mm256_add_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&rhs[ 8])));
+    _mm256_storeu_ps(&lhs[16], _mm256_add_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&rhs[16])));
+    _mm256_storeu_ps(&lhs[24], _mm256_add_ps(_mm256_loadu_ps(&lhs[24]), _mm256_loadu_ps(&rhs[24])));
+#else
     _mm_store_ps(&lhs[ 0], _mm_add_ps(_mm_load_ps(&lhs[ 0]), _mm_load_ps(&rhs[ 0])));
     _mm_store_ps(&lhs[ 4], _mm_add_ps(_mm_load_ps(&lhs[ 4]), _mm_load_ps(&rhs[ 4])));
     _mm_store_ps(&lhs[ 8], _mm_add_ps(_mm_load_ps(&lhs[ 8]), _mm_load_ps(&rhs[ 8])));
@@ -477,6 +492,7 @@ APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator+=(RegularSpectrum<fl
     _mm_store_ps(&lhs[20], _mm_add_ps(_mm_load_ps(&lhs[20]), _mm_load_ps(&rhs[20])));
     _mm_store_ps(&lhs[24], _mm_add_ps(_mm_load_ps(&lhs[24]), _mm_load_ps(&rhs[24])));
     _mm_store_ps(&lhs[28], _mm_add_ps(_mm_load_ps(&lhs[28]), _mm_load_ps(&rhs[28])));
+#endif
 
     return lhs;
 }
@@ -506,6 +522,14 @@ inline RegularSpectrum<T, N>& operator*=(RegularSpectrum<T, N>& lhs, const T rhs
 template <>
 APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator*=(RegularSpectrum<float, 31>& lhs, const float rhs)
 {
+#ifdef APPLESEED_USE_AVX
+    const __m256 mrhs = _mm256_set1_ps(rhs);
+
+    _mm256_storeu_ps(&lhs[ 0], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 0]), mrhs));
+    _mm256_storeu_ps(&lhs[ 8], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 8]), mrhs));
+    _mm256_storeu_ps(&lhs[16], _mm256_mul_ps(_mm256_loadu_ps(&lhs[16]), mrhs));
+    _mm256_storeu_ps(&lhs[24], _mm256_mul_ps(_mm256_loadu_ps(&lhs[24]), mrhs));
+#else
     const __m128 mrhs = _mm_set1_ps(rhs);
 
     _mm_store_ps(&lhs[ 0], _mm_mul_ps(_mm_load_ps(&lhs[ 0]), mrhs));
@@ -516,6 +540,7 @@ APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator*=(RegularSpectrum<fl
     _mm_store_ps(&lhs[20], _mm_mul_ps(_mm_load_ps(&lhs[20]), mrhs));
     _mm_store_ps(&lhs[24], _mm_mul_ps(_mm_load_ps(&lhs[24]), mrhs));
     _mm_store_ps(&lhs[28], _mm_mul_ps(_mm_load_ps(&lhs[28]), mrhs));
+#endif
 
     return lhs;
 }
@@ -536,6 +561,12 @@ inline RegularSpectrum<T, N>& operator*=(RegularSpectrum<T, N>& lhs, const Regul
 template <>
 APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator*=(RegularSpectrum<float, 31>& lhs, const RegularSpectrum<float, 31>& rhs)
 {
+#ifdef APPLESEED_USE_AVX
+    _mm256_storeu_ps(&lhs[ 0], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&rhs[ 0])));
+    _mm256_storeu_ps(&lhs[ 8], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&rhs[ 8])));
+    _mm256_storeu_ps(&lhs[16], _mm256_mul_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&rhs[16])));
+    _mm256_storeu_ps(&lhs[24], _mm256_mul_ps(_mm256_loadu_ps(&lhs[24]), _mm256_loadu_ps(&rhs[24])));
+#else
     _mm_store_ps(&lhs[ 0], _mm_mul_ps(_mm_load_ps(&lhs[ 0]), _mm_load_ps(&rhs[ 0])));
     _mm_store_ps(&lhs[ 4], _mm_mul_ps(_mm_load_ps(&lhs[ 4]), _mm_load_ps(&rhs[ 4])));
     _mm_store_ps(&lhs[ 8], _mm_mul_ps(_mm_load_ps(&lhs[ 8]), _mm_load_ps(&rhs[ 8])));
@@ -544,6 +575,7 @@ APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator*=(RegularSpectrum<fl
     _mm_store_ps(&lhs[20], _mm_mul_ps(_mm_load_ps(&lhs[20]), _mm_load_ps(&rhs[20])));
     _mm_store_ps(&lhs[24], _mm_mul_ps(_mm_load_ps(&lhs[24]), _mm_load_ps(&rhs[24])));
     _mm_store_ps(&lhs[28], _mm_mul_ps(_mm_load_ps(&lhs[28]), _mm_load_ps(&rhs[28])));
+#endif
 
     return lhs;
 }
@@ -30,6 +30,9 @@
 // Interface header.
 #include "tile.h"
 
+// appleseed.foundation headers.
+#include "foundation/image/tilepool.h"
+
 namespace foundation
 {
 
@@ -63,7 +66,7 @@ Tile::Tile(
     }
     else
     {
-        m_pixel_array = new std::uint8_t[m_array_size];
+        m_pixel_array = static_cast<std::uint8_t*>(TilePool::instance().allocate(m_array_size));
         m_own_storage = true;
     }
 }
@@ -88,7 +91,7 @@ Tile::Tile(
     }
     else
     {
-        m_pixel_array = new std::uint8_t[m_array_size];
+        m_pixel_array = static_cast<std::uint8_t*>(TilePool::instance().allocate(m_array_size));
         m_own_storage = true;
     }
 
@@ -116,7 +119,7 @@ Tile::Tile(
     }
     else
     {
-        m_pixel_array = new std::uint8_t[m_array_size];
+        m_pixel_array = static_cast<std::uint8_t*>(TilePool::instance().allocate(m_array_size));
         m_own_storage = true;
     }
 
@@ -140,7 +143,7 @@ Tile::Tile(const Tile& rhs)
   , m_channel_size(rhs.m_channel_size)
   , m_pixel_size(rhs.m_pixel_size)
   , m_array_size(rhs.m_array_size)
-  , m_pixel_array(new std::uint8_t[rhs.m_array_size])
+  , m_pixel_array(static_cast<std::uint8_t*>(TilePool::instance().allocate(rhs.m_array_size)))
   , m_own_storage(true)
 {
     memcpy(
@@ -152,7 +155,7 @@ Tile::Tile(const Tile& rhs)
 Tile::~Tile()
 {
     if (m_own_storage)
-        delete[] m_pixel_array;
+        TilePool::instance().deallocate(m_pixel_array, m_array_size);
 }
 
 void Tile::release()
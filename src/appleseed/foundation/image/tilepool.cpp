@@ -0,0 +1,305 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "tilepool.h"
+
+// appleseed.foundation headers.
+#include "foundation/memory/memory.h"
+
+// Standard headers.
+#include <atomic>
+#include <mutex>
+
+namespace foundation
+{
+
+//
+// TilePool class implementation.
+//
+
+namespace
+{
+    // Free blocks are chained through their first bytes.
+    struct FreeBlock
+    {
+        FreeBlock* m_next;
+    };
+
+    const size_t MinSizeClassLog2 = 8;                          // 256 bytes
+    const size_t MaxSizeClassLog2 = 26;                         // 64 MB
+    const size_t SizeClassCount = MaxSizeClassLog2 - MinSizeClassLog2 + 1;
+
+    const size_t BlockAlignment = 64;                           // bytes
+    const size_t MaxThreadCacheSize = 8 * 1024 * 1024;          // bytes, per thread
+    const size_t DefaultMaxCachedSize = 256 * 1024 * 1024;      // bytes
+
+    // Return the index of the smallest size class holding `size` bytes,
+    // or SizeClassCount if `size` exceeds the largest size class.
+    size_t get_size_class(const size_t size)
+    {
+        size_t log2 = MinSizeClassLog2;
+
+        while ((size_t(1) << log2) < size)
+        {
+            if (++log2 > MaxSizeClassLog2)
+                return SizeClassCount;
+        }
+
+        return log2 - MinSizeClassLog2;
+    }
+
+    size_t get_block_size(const size_t size_class)
+    {
+        return size_t(1) << (size_class + MinSizeClassLog2);
+    }
+}
+
+struct TilePool::Impl
+{
+    struct ThreadCache;
+
+    mutable std::mutex      m_mutex;
+    FreeBlock*              m_heads[SizeClassCount];
+    size_t                  m_cached_size;
+    size_t                  m_max_cached_size;
+    std::atomic<bool>       m_use_large_pages;
+
+    Impl()
+      : m_cached_size(0)
+      , m_max_cached_size(DefaultMaxCachedSize)
+      , m_use_large_pages(false)
+    {
+        for (size_t i = 0; i < SizeClassCount; ++i)
+            m_heads[i] = nullptr;
+    }
+
+    ~Impl()
+    {
+        release_cached_blocks();
+    }
+
+    ThreadCache& get_thread_cache();
+
+    void* allocate_block(const size_t size) const
+    {
+        return
+            m_use_large_pages
+                ? large_page_aligned_malloc(size, BlockAlignment)
+                : aligned_malloc(size, BlockAlignment);
+    }
+
+    FreeBlock* pop_cached_block(const size_t size_class)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        FreeBlock* block = m_heads[size_class];
+
+        if (block != nullptr)
+        {
+            m_heads[size_class] = block->m_next;
+            m_cached_size -= get_block_size(size_class);
+        }
+
+        return block;
+    }
+
+    void push_cached_block(FreeBlock* block, const size_t size_class)
+    {
+        const size_t block_size = get_block_size(size_class);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (m_cached_size + block_size <= m_max_cached_size)
+            {
+                block->m_next = m_heads[size_class];
+                m_heads[size_class] = block;
+                m_cached_size += block_size;
+                return;
+            }
+        }
+
+        aligned_free(block);
+    }
+
+    void release_cached_blocks()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (size_t i = 0; i < SizeClassCount; ++i)
+        {
+            FreeBlock* block = m_heads[i];
+
+            while (block != nullptr)
+            {
+                FreeBlock* next = block->m_next;
+                aligned_free(block);
+                block = next;
+            }
+
+            m_heads[i] = nullptr;
+        }
+
+        m_cached_size = 0;
+    }
+};
+
+// The thread cache must hand its blocks back when its thread exits, hence the use of
+// thread_local rather than APPLESEED_TLS which only supports trivially destructible types.
+struct TilePool::Impl::ThreadCache
+{
+    Impl*                   m_impl;
+    FreeBlock*              m_heads[SizeClassCount];
+    size_t                  m_size;
+
+    explicit ThreadCache(Impl* impl)
+      : m_impl(impl)
+      , m_size(0)
+    {
+        for (size_t i = 0; i < SizeClassCount; ++i)
+            m_heads[i] = nullptr;
+    }
+
+    ~ThreadCache()
+    {
+        for (size_t i = 0; i < SizeClassCount; ++i)
+        {
+            FreeBlock* block = m_heads[i];
+
+            while (block != nullptr)
+            {
+                FreeBlock* next = block->m_next;
+                m_impl->push_cached_block(block, i);
+                block = next;
+            }
+        }
+    }
+};
+
+TilePool::Impl::ThreadCache& TilePool::Impl::get_thread_cache()
+{
+    static thread_local ThreadCache thread_cache(this);
+    return thread_cache;
+}
+
+TilePool& TilePool::instance()
+{
+    static TilePool pool;
+    return pool;
+}
+
+TilePool::TilePool()
+  : impl(new Impl())
+{
+}
+
+TilePool::~TilePool()
+{
+    delete impl;
+}
+
+void* TilePool::allocate(const size_t size)
+{
+    const size_t size_class = get_size_class(size);
+
+    if (size_class == SizeClassCount)
+        return impl->allocate_block(size);
+
+    Impl::ThreadCache& thread_cache = impl->get_thread_cache();
+    FreeBlock* block = thread_cache.m_heads[size_class];
+
+    if (block != nullptr)
+    {
+        thread_cache.m_heads[size_class] = block->m_next;
+        thread_cache.m_size -= get_block_size(size_class);
+        return block;
+    }
+
+    block = impl->pop_cached_block(size_class);
+
+    if (block != nullptr)
+        return block;
+
+    return impl->allocate_block(get_block_size(size_class));
+}
+
+void TilePool::deallocate(void* ptr, const size_t size)
+{
+    if (ptr == nullptr)
+        return;
+
+    const size_t size_class = get_size_class(size);
+
+    if (size_class == SizeClassCount)
+    {
+        aligned_free(ptr);
+        return;
+    }
+
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    const size_t block_size = get_block_size(size_class);
+    Impl::ThreadCache& thread_cache = impl->get_thread_cache();
+
+    if (thread_cache.m_size + block_size <= MaxThreadCacheSize)
+    {
+        block->m_next = thread_cache.m_heads[size_class];
+        thread_cache.m_heads[size_class] = block;
+        thread_cache.m_size += block_size;
+    }
+    else impl->push_cached_block(block, size_class);
+}
+
+void TilePool::set_use_large_pages(const bool use_large_pages)
+{
+    impl->m_use_large_pages = use_large_pages;
+}
+
+bool TilePool::get_use_large_pages() const
+{
+    return impl->m_use_large_pages;
+}
+
+void TilePool::set_max_cached_size(const size_t max_cached_size)
+{
+    std::lock_guard<std::mutex> lock(impl->m_mutex);
+    impl->m_max_cached_size = max_cached_size;
+}
+
+size_t TilePool::get_cached_size() const
+{
+    std::lock_guard<std::mutex> lock(impl->m_mutex);
+    return impl->m_cached_size;
+}
+
+void TilePool::release_cached_blocks()
+{
+    impl->release_cached_blocks();
+}
+
+}   // namespace foundation
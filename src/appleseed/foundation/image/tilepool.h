@@ -0,0 +1,92 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// A pool of memory blocks for the pixel arrays of tiles.
+//
+// Requests are rounded up to power-of-two size classes. Freed blocks are first kept
+// in a small cache owned by the calling thread, so that a thread repeatedly creating
+// and destroying tiles of the same size never takes a lock. Blocks that don't fit in
+// the thread cache go to a shared cache of bounded size; beyond that bound they are
+// returned to the system. Requests larger than the largest size class bypass the pool.
+//
+// Blocks are aligned on cache lines. Large blocks can optionally be backed by large
+// pages (see large_page_aligned_malloc()).
+//
+
+class APPLESEED_DLLSYMBOL TilePool
+  : public NonCopyable
+{
+  public:
+    // Return the pool used by tiles.
+    static TilePool& instance();
+
+    // Allocate a block of at least `size` bytes.
+    void* allocate(const size_t size);
+
+    // Return a block to the pool. `size` must be the size passed to allocate().
+    void deallocate(void* ptr, const size_t size);
+
+    // Enable or disable large page backing for blocks allocated from now on.
+    // Disabled by default.
+    void set_use_large_pages(const bool use_large_pages);
+    bool get_use_large_pages() const;
+
+    // Set the maximum amount of memory, in bytes, kept in the shared cache.
+    void set_max_cached_size(const size_t max_cached_size);
+
+    // Return the amount of memory, in bytes, kept in the shared cache.
+    size_t get_cached_size() const;
+
+    // Return all blocks of the shared cache to the system.
+    // Blocks kept in thread caches are not affected.
+    void release_cached_blocks();
+
+  private:
+    struct Impl;
+    Impl* impl;
+
+    TilePool();
+    ~TilePool();
+};
+
+}   // namespace foundation
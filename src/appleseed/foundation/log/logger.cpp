@@ -40,6 +40,7 @@
 #include "foundation/utility/foreach.h"
 
 // Boost headers.
+#include "boost/atomic/atomic.hpp"
 #include "boost/date_time/posix_time/posix_time.hpp"
 
 // Standard headers.
@@ -50,6 +51,7 @@
 #include <cstdlib>
 #include <list>
 #include <map>
+#include <string>
 #include <vector>
 
 using namespace boost::posix_time;
@@ -195,6 +197,100 @@ namespace
         size_t              m_thread_count;
         ThreadIdToIntMap    m_thread_id_to_int;
     };
+
+    // A message waiting to be written by the background writer thread.
+    struct QueuedMessage
+    {
+        boost::atomic<QueuedMessage*>   m_next;
+        LogMessage::Category            m_category;
+        const char*                     m_file;
+        size_t                          m_line;
+        ptime                           m_datetime;
+        boost::thread::id               m_thread_id;
+        std::string                     m_message;
+    };
+
+    //
+    // A lock-free, unbounded, multiple producers single consumer queue of messages.
+    //
+    // Pushing a message is wait-free. Popping may spuriously fail while a producer
+    // is in the middle of a push; the message is then returned by a later pop.
+    //
+    // Reference:
+    //
+    //   Intrusive MPSC node-based queue
+    //   http://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+    //
+
+    class MessageQueue
+      : public NonCopyable
+    {
+      public:
+        MessageQueue()
+          : m_head(&m_stub)
+          , m_tail(&m_stub)
+        {
+            m_stub.m_next.store(nullptr, boost::memory_order_relaxed);
+        }
+
+        ~MessageQueue()
+        {
+            while (QueuedMessage* message = pop())
+                delete message;
+        }
+
+        // Can be called from any thread.
+        void push(QueuedMessage* message)
+        {
+            message->m_next.store(nullptr, boost::memory_order_relaxed);
+            QueuedMessage* prev = m_head.exchange(message, boost::memory_order_acq_rel);
+            prev->m_next.store(message, boost::memory_order_release);
+        }
+
+        // Only the consumer thread may call this method.
+        QueuedMessage* pop()
+        {
+            QueuedMessage* tail = m_tail;
+            QueuedMessage* next = tail->m_next.load(boost::memory_order_acquire);
+
+            if (tail == &m_stub)
+            {
+                if (next == nullptr)
+                    return nullptr;
+
+                m_tail = next;
+                tail = next;
+                next = next->m_next.load(boost::memory_order_acquire);
+            }
+
+            if (next != nullptr)
+            {
+                m_tail = next;
+                return tail;
+            }
+
+            // A producer is linking a new message after `tail`.
+            if (tail != m_head.load(boost::memory_order_acquire))
+                return nullptr;
+
+            push(&m_stub);
+
+            next = tail->m_next.load(boost::memory_order_acquire);
+
+            if (next != nullptr)
+            {
+                m_tail = next;
+                return tail;
+            }
+
+            return nullptr;
+        }
+
+      private:
+        boost::atomic<QueuedMessage*>   m_head;
+        QueuedMessage*                  m_tail;
+        QueuedMessage                   m_stub;
+    };
 }
 
 
@@ -202,35 +298,204 @@ namespace
 // Logger class implementation.
 //
 
-struct Logger::Impl
-{
-    typedef std::list<ILogTarget*> LogTargetContainer;
-
-    boost::mutex            m_mutex;
-    bool                    m_enabled;
-    LogMessage::Category    m_verbosity_level;
-    LogTargetContainer      m_targets;
-    std::vector<char>       m_message_buffer;
-    ThreadMap               m_thread_map;
-    Formatter               m_formatter;
-};
-
 namespace
 {
     const size_t InitialBufferSize = 1024;      // in bytes
     const size_t MaxBufferSize = 1024 * 1024;   // in bytes
+
+    const std::uint32_t WriterIdleSleepTime = 5;    // in milliseconds
+    const long RepeatReportInterval = 1000;         // in milliseconds
 }
 
+struct Logger::Impl
+{
+    typedef std::list<ILogTarget*> LogTargetContainer;
+
+    boost::mutex                        m_mutex;
+    boost::atomic<bool>                 m_enabled;
+    boost::atomic<LogMessage::Category> m_verbosity_level;
+    LogTargetContainer                  m_targets;
+    std::vector<char>                   m_message_buffer;
+    ThreadMap                           m_thread_map;
+    Formatter                           m_formatter;
+
+    // Asynchronous mode.
+    boost::mutex                        m_async_mutex;
+    boost::atomic<bool>                 m_async;
+    MessageQueue                        m_queue;
+    boost::atomic<size_t>               m_pending_count;
+    boost::atomic<bool>                 m_flush_requested;
+    boost::atomic<bool>                 m_stop_writer;
+    boost::thread*                      m_writer_thread;
+
+    // Deduplication state, only accessed by the writer thread.
+    bool                                m_has_last_message;
+    QueuedMessage                       m_last_message;
+    size_t                              m_repeat_count;
+    ptime                               m_first_repeat_datetime;
+
+    // Send a message to all log targets. The caller must hold m_mutex.
+    void write_to_targets(
+        const LogMessage::Category      category,
+        const char*                     file,
+        const size_t                    line,
+        const ptime&                    datetime,
+        const boost::thread::id&        thread_id,
+        const char*                     text)
+    {
+        // Format the header and message.
+        const size_t thread = m_thread_map.thread_id_to_int(thread_id);
+        const FormatEvaluator format_evaluator(category, datetime, thread, text);
+        const std::string header = format_evaluator.evaluate(m_formatter.get_header_format(category));
+        std::string message = format_evaluator.evaluate(m_formatter.get_message_format(category));
+
+        // Remove trailing newline characters from the message.
+        message = trim_right(message, "\n");
+
+        if (!message.empty())
+        {
+            // Send the header and message to all log targets.
+            for (const_each<LogTargetContainer> i = m_targets; i; ++i)
+            {
+                ILogTarget* target = *i;
+                target->write(
+                    category,
+                    file,
+                    line,
+                    header.c_str(),
+                    message.c_str());
+            }
+        }
+    }
+
+    void start_writer()
+    {
+        m_pending_count = 0;
+        m_flush_requested = false;
+        m_stop_writer = false;
+        m_has_last_message = false;
+        m_repeat_count = 0;
+        m_writer_thread = new boost::thread([this]() { run_writer(); });
+    }
+
+    void stop_writer()
+    {
+        m_stop_writer = true;
+        m_writer_thread->join();
+        delete m_writer_thread;
+        m_writer_thread = nullptr;
+    }
+
+    void run_writer()
+    {
+        set_current_thread_name("logger");
+
+        while (true)
+        {
+            bool idle = true;
+
+            while (QueuedMessage* message = m_queue.pop())
+            {
+                write_deduplicated(*message);
+                delete message;
+                --m_pending_count;
+                idle = false;
+            }
+
+            if (!idle)
+                continue;
+
+            const bool stopping = m_stop_writer;
+            const bool drained = m_pending_count == 0;
+
+            if (drained && (stopping || m_flush_requested))
+            {
+                report_repeats();
+                m_flush_requested = false;
+
+                if (stopping)
+                    break;
+            }
+            else if (m_repeat_count > 0)
+            {
+                const ptime now(microsec_clock::universal_time());
+                if ((now - m_first_repeat_datetime).total_milliseconds() >= RepeatReportInterval)
+                    report_repeats();
+            }
+
+            foundation::sleep(WriterIdleSleepTime);
+        }
+    }
+
+    void write_deduplicated(const QueuedMessage& message)
+    {
+        if (m_has_last_message &&
+            message.m_category == m_last_message.m_category &&
+            message.m_message == m_last_message.m_message)
+        {
+            if (m_repeat_count++ == 0)
+                m_first_repeat_datetime = message.m_datetime;
+            return;
+        }
+
+        report_repeats();
+
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            write_to_targets(
+                message.m_category,
+                message.m_file,
+                message.m_line,
+                message.m_datetime,
+                message.m_thread_id,
+                message.m_message.c_str());
+        }
+
+        m_has_last_message = true;
+        m_last_message.m_category = message.m_category;
+        m_last_message.m_file = message.m_file;
+        m_last_message.m_line = message.m_line;
+        m_last_message.m_thread_id = message.m_thread_id;
+        m_last_message.m_message = message.m_message;
+    }
+
+    void report_repeats()
+    {
+        if (m_repeat_count == 0)
+            return;
+
+        const std::string text =
+            "(previous message repeated " + to_string(m_repeat_count) +
+            (m_repeat_count > 1 ? " times)" : " time)");
+
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            write_to_targets(
+                m_last_message.m_category,
+                m_last_message.m_file,
+                m_last_message.m_line,
+                microsec_clock::universal_time(),
+                m_last_message.m_thread_id,
+                text.c_str());
+        }
+
+        m_repeat_count = 0;
+    }
+};
+
 Logger::Logger()
   : impl(new Impl())
 {
     impl->m_enabled = true;
     impl->m_verbosity_level = LogMessage::Info;
     impl->m_message_buffer.resize(InitialBufferSize);
+    impl->m_async = false;
+    impl->m_writer_thread = nullptr;
 }
 
 Logger::~Logger()
 {
+    set_async(false);
     delete impl;
 }
 
@@ -239,8 +504,8 @@ void Logger::initialize_from(const Logger& source)
     boost::mutex::scoped_lock source_lock(source.impl->m_mutex);
     boost::mutex::scoped_lock this_lock(impl->m_mutex);
 
-    impl->m_enabled = source.impl->m_enabled;
-    impl->m_verbosity_level = source.impl->m_verbosity_level;
+    impl->m_enabled = source.impl->m_enabled.load();
+    impl->m_verbosity_level = source.impl->m_verbosity_level.load();
 
     impl->m_targets.clear();
     for (const_each<Impl::LogTargetContainer> i = source.impl->m_targets; i; ++i)
@@ -301,6 +566,43 @@ const char* Logger::get_format(const LogMessage::Category category) const
     return impl->m_formatter.get_format(category).c_str();
 }
 
+void Logger::set_async(const bool async)
+{
+    boost::mutex::scoped_lock lock(impl->m_async_mutex);
+
+    if (async == impl->m_async)
+        return;
+
+    if (async)
+    {
+        impl->start_writer();
+        impl->m_async = true;
+    }
+    else
+    {
+        impl->m_async = false;
+        impl->stop_writer();
+    }
+}
+
+bool Logger::is_async() const
+{
+    return impl->m_async;
+}
+
+void Logger::flush()
+{
+    boost::mutex::scoped_lock lock(impl->m_async_mutex);
+
+    if (!impl->m_async)
+        return;
+
+    impl->m_flush_requested = true;
+
+    while (impl->m_flush_requested)
+        sleep(1);
+}
+
 void Logger::add_target(ILogTarget* target)
 {
     boost::mutex::scoped_lock lock(impl->m_mutex);
@@ -364,6 +666,37 @@ void Logger::write(
     const size_t                        line,
     APPLESEED_PRINTF_FMT const char*    format, ...)
 {
+    if (impl->m_async && category != LogMessage::Fatal)
+    {
+        if (category < impl->m_verbosity_level || !impl->m_enabled)
+            return;
+
+        // Format the message on the calling thread, without taking any lock.
+        std::vector<char> buffer(InitialBufferSize);
+        va_list argptr;
+        va_start(argptr, format);
+        const bool formatting_succeeded =
+            write_to_buffer(buffer, MaxBufferSize, format, argptr);
+        va_end(argptr);
+
+        QueuedMessage* message = new QueuedMessage();
+        message->m_category = formatting_succeeded ? category : LogMessage::Error;
+        message->m_file = file;
+        message->m_line = line;
+        message->m_datetime = microsec_clock::universal_time();
+        message->m_thread_id = boost::this_thread::get_id();
+        message->m_message = &buffer[0];
+
+        ++impl->m_pending_count;
+        impl->m_queue.push(message);
+
+        return;
+    }
+
+    // Make sure queued messages are written before a fatal message.
+    if (category == LogMessage::Fatal)
+        flush();
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     if (category < impl->m_verbosity_level)
@@ -378,37 +711,20 @@ void Logger::write(
         va_start(argptr, format);
         const bool formatting_succeeded =
             write_to_buffer(impl->m_message_buffer, MaxBufferSize, format, argptr);
+        va_end(argptr);
 
         // If formatting failed, print the message as an error.
         if (!formatting_succeeded)
             effective_category = LogMessage::Error;
 
-        // Retrieve the current UTC time.
-        const ptime datetime(microsec_clock::universal_time());
-
-        // Format the header and message.
-        const size_t thread = impl->m_thread_map.thread_id_to_int(boost::this_thread::get_id());
-        const FormatEvaluator format_evaluator(effective_category, datetime, thread, &impl->m_message_buffer[0]);
-        const std::string header = format_evaluator.evaluate(impl->m_formatter.get_header_format(effective_category));
-        std::string message = format_evaluator.evaluate(impl->m_formatter.get_message_format(effective_category));
-
-        // Remove trailing newline characters from the message.
-        message = trim_right(message, "\n");
-
-        if (!message.empty())
-        {
-            // Send the header and message to all log targets.
-            for (const_each<Impl::LogTargetContainer> i = impl->m_targets; i; ++i)
-            {
-                ILogTarget* target = *i;
-                target->write(
-                    effective_category,
-                    file,
-                    line,
-                    header.c_str(),
-                    message.c_str());
-            }
-        }
+        // Send the header and message to all log targets.
+        impl->write_to_targets(
+            effective_category,
+            file,
+            line,
+            microsec_clock::universal_time(),
+            boost::this_thread::get_id(),
+            &impl->m_message_buffer[0]);
     }
 
     // Terminate the application if the message category is 'Fatal'.
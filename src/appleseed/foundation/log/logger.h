@@ -102,6 +102,18 @@ class APPLESEED_DLLSYMBOL Logger
     // Log targets can be removed at any time.
     void remove_target(ILogTarget* target);
 
+    // Enable/disable asynchronous mode. In asynchronous mode, write() only formats
+    // the message and queues it without blocking; a background thread sends queued
+    // messages to the log targets. Consecutive identical messages are then collapsed
+    // into a single message followed by a count of repetitions, reported at most once
+    // per second. Fatal messages are always written synchronously.
+    void set_async(const bool async = true);
+    bool is_async() const;
+
+    // Wait until all queued messages have been sent to the log targets.
+    // Does nothing in synchronous mode.
+    void flush();
+
     // Write a message. If the message category is Fatal,
     // this function will not return and the program will
     // be terminated.
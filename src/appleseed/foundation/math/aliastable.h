@@ -0,0 +1,291 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// Alias table for sampling a discrete distribution in constant time.
+//
+// The interface mirrors the one of foundation::CDF so that both can be used
+// interchangeably. Tables are built with Vose's algorithm in linear time.
+//
+// Reference:
+//
+//   Darts, Dice, and Coins: Sampling from a Discrete Distribution
+//   http://www.keithschwarz.com/darts-dice-coins/
+//
+
+template <typename Item, typename Weight>
+class AliasTable
+{
+  public:
+    typedef std::pair<Item, Weight> ItemWeightPair;
+
+    // Constructor.
+    AliasTable();
+
+    // Return the number of items in the table.
+    size_t size() const;
+
+    // Return true if the table is empty.
+    bool empty() const;
+
+    // Return true if the table has at least one item with a positive weight.
+    bool valid() const;
+
+    // Return the sum of the weight of all inserted items.
+    Weight weight() const;
+
+    // Remove all items from the table.
+    void clear();
+
+    // Allocate memory for a given number of items.
+    void reserve(const size_t count);
+
+    // Insert an item with a given non-negative weight.
+    void insert(const Item& item, const Weight weight);
+
+    // Access the i'th item. Weights are normalized once prepare() has been called.
+    const ItemWeightPair& operator[](const size_t i) const;
+
+    // Prepare the table for sampling.
+    // This method must be called once and only once before sample() is called.
+    void prepare();
+
+    // Sample the table. x is in [0,1).
+    const ItemWeightPair& sample(const Weight x) const;
+
+    // Sample the table and return in `residual` a new uniform sample in [0,1)
+    // that is independent of the chosen item and can be reused by the caller.
+    const ItemWeightPair& sample(const Weight x, Weight& residual) const;
+
+  private:
+    struct Bin
+    {
+        Weight          m_threshold;    // probability of keeping this bin's own item
+        size_t          m_alias;        // item chosen otherwise
+    };
+
+    typedef std::vector<ItemWeightPair> ItemVector;
+    typedef std::vector<Bin> BinVector;
+
+    ItemVector          m_items;
+    Weight              m_weight_sum;
+    BinVector           m_bins;
+
+    size_t select_bin(const Weight x, Weight& u) const;
+};
+
+
+//
+// AliasTable class implementation.
+//
+
+template <typename Item, typename Weight>
+inline AliasTable<Item, Weight>::AliasTable()
+  : m_weight_sum(0.0)
+{
+}
+
+template <typename Item, typename Weight>
+inline size_t AliasTable<Item, Weight>::size() const
+{
+    return m_items.size();
+}
+
+template <typename Item, typename Weight>
+inline bool AliasTable<Item, Weight>::empty() const
+{
+    return m_items.empty();
+}
+
+template <typename Item, typename Weight>
+inline bool AliasTable<Item, Weight>::valid() const
+{
+    return m_weight_sum > Weight(0.0);
+}
+
+template <typename Item, typename Weight>
+inline Weight AliasTable<Item, Weight>::weight() const
+{
+    return m_weight_sum;
+}
+
+template <typename Item, typename Weight>
+inline void AliasTable<Item, Weight>::clear()
+{
+    m_items.clear();
+    m_weight_sum = Weight(0.0);
+    m_bins.clear();
+}
+
+template <typename Item, typename Weight>
+inline void AliasTable<Item, Weight>::reserve(const size_t count)
+{
+    m_items.reserve(count);
+}
+
+template <typename Item, typename Weight>
+inline void AliasTable<Item, Weight>::insert(const Item& item, const Weight weight)
+{
+    assert(weight >= Weight(0.0));
+    m_items.push_back(std::make_pair(item, weight));
+    m_weight_sum += weight;
+}
+
+template <typename Item, typename Weight>
+inline const typename AliasTable<Item, Weight>::ItemWeightPair& AliasTable<Item, Weight>::operator[](const size_t i) const
+{
+    assert(i < m_items.size());
+    return m_items[i];
+}
+
+template <typename Item, typename Weight>
+void AliasTable<Item, Weight>::prepare()
+{
+    assert(valid());
+    assert(m_bins.empty());
+
+    const size_t item_count = m_items.size();
+
+    // Normalize weights so that they add up to 1.0.
+    const Weight rcp_weight_sum = Weight(1.0) / m_weight_sum;
+    for (size_t i = 0; i < item_count; ++i)
+        m_items[i].second *= rcp_weight_sum;
+
+    // Split items into those below and above the average weight.
+    m_bins.resize(item_count);
+    std::vector<size_t> small, large;
+    size_t nonzero_item = 0;
+    for (size_t i = 0; i < item_count; ++i)
+    {
+        m_bins[i].m_threshold = m_items[i].second * static_cast<Weight>(item_count);
+        m_bins[i].m_alias = i;
+
+        if (m_items[i].second > Weight(0.0))
+            nonzero_item = i;
+
+        if (m_bins[i].m_threshold < Weight(1.0))
+            small.push_back(i);
+        else large.push_back(i);
+    }
+
+    // Fill the bins of small items with the excess of large items.
+    while (!small.empty() && !large.empty())
+    {
+        const size_t s = small.back();
+        small.pop_back();
+
+        const size_t l = large.back();
+
+        m_bins[s].m_alias = l;
+        m_bins[l].m_threshold = (m_bins[l].m_threshold + m_bins[s].m_threshold) - Weight(1.0);
+
+        if (m_bins[l].m_threshold < Weight(1.0))
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // Remaining items should have a threshold of exactly 1 but may be off due to numerical errors.
+    for (const size_t i : large)
+        m_bins[i].m_threshold = Weight(1.0);
+    for (const size_t i : small)
+    {
+        if (m_items[i].second > Weight(0.0))
+            m_bins[i].m_threshold = Weight(1.0);
+        else
+        {
+            // Never return items with null weight.
+            m_bins[i].m_threshold = Weight(0.0);
+            m_bins[i].m_alias = nonzero_item;
+        }
+    }
+}
+
+template <typename Item, typename Weight>
+inline size_t AliasTable<Item, Weight>::select_bin(const Weight x, Weight& u) const
+{
+    assert(valid());
+    assert(!m_bins.empty());
+    assert(x >= Weight(0.0));
+    assert(x < Weight(1.0));
+
+    const size_t bin_count = m_bins.size();
+    const Weight scaled_x = x * static_cast<Weight>(bin_count);
+    const size_t i = std::min(truncate<size_t>(scaled_x), bin_count - 1);
+    u = scaled_x - static_cast<Weight>(i);
+
+    return i;
+}
+
+template <typename Item, typename Weight>
+inline const std::pair<Item, Weight>& AliasTable<Item, Weight>::sample(const Weight x) const
+{
+    Weight u;
+    const size_t i = select_bin(x, u);
+    const Bin& bin = m_bins[i];
+
+    return m_items[u < bin.m_threshold ? i : bin.m_alias];
+}
+
+template <typename Item, typename Weight>
+inline const std::pair<Item, Weight>& AliasTable<Item, Weight>::sample(const Weight x, Weight& residual) const
+{
+    Weight u;
+    const size_t i = select_bin(x, u);
+    const Bin& bin = m_bins[i];
+
+    if (u < bin.m_threshold)
+    {
+        residual = std::min(u / bin.m_threshold, Weight(1.0) - std::numeric_limits<Weight>::epsilon());
+        return m_items[i];
+    }
+    else
+    {
+        residual = std::min((u - bin.m_threshold) / (Weight(1.0) - bin.m_threshold), Weight(1.0) - std::numeric_limits<Weight>::epsilon());
+        return m_items[bin.m_alias];
+    }
+}
+
+}   // namespace foundation
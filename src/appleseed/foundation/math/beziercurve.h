@@ -37,6 +37,9 @@
 #include "foundation/math/ray.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
 
 // Standard headers.
 #include <algorithm>
@@ -281,6 +284,20 @@ class BezierCurveIntersector
         const ValueType         epsilon = ValueType(0.05),
         const size_t            max_depth = 5);
 
+    // Maximum number of curves culled at once by cull().
+    static const size_t CullBatchSize = 4;
+
+    // Conservatively cull up to CullBatchSize curves against a ray, using the ray space bounding
+    // boxes of their control points. This is the first test performed by intersect(), without
+    // the cost of transforming the whole curve and computing its subdivision depth. Bit i of the
+    // returned mask is set if the ray may intersect curves[i] at a distance less than t.
+    static size_t cull(
+        const BezierCurveType* const    curves[],
+        const size_t                    count,
+        const RayType&                  ray,
+        const MatrixType&               xfm,
+        const ValueType                 t);
+
   private:
     // Dot product function that only considers the x and y components of the vectors.
     static ValueType dotxy(const VectorType& lhs, const VectorType& rhs)
@@ -1046,6 +1063,138 @@ void make_curve_projection_transform(
 }
 
 
+//
+// Ray space culling of curves.
+//
+
+namespace impl
+{
+    template <typename T, size_t N>
+    size_t cull_curves(
+        const BezierCurveBase<T, N>* const  curves[],
+        const size_t                        count,
+        const Matrix<T, 4, 4>&              xfm,
+        const T                             max_z)
+    {
+        size_t mask = 0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const BezierCurveBase<T, N>& curve = *curves[i];
+
+            AABB<T, 3> bbox;
+            bbox.invalidate();
+
+            // The projection transform is affine.
+            for (size_t j = 0; j < N + 1; ++j)
+            {
+                const Vector<T, 3>& p = curve.get_control_point(j);
+                bbox.insert(
+                    Vector<T, 3>(
+                        xfm[0] * p.x + xfm[1] * p.y + xfm[2]  * p.z + xfm[3],
+                        xfm[4] * p.x + xfm[5] * p.y + xfm[6]  * p.z + xfm[7],
+                        xfm[8] * p.x + xfm[9] * p.y + xfm[10] * p.z + xfm[11]));
+            }
+
+            const T half_max_width = T(0.5) * curve.compute_max_width();
+
+            if (!(bbox.min.z > max_z           || bbox.max.z < T(1.0e-6)      ||
+                  bbox.min.x > half_max_width || bbox.max.x < -half_max_width ||
+                  bbox.min.y > half_max_width || bbox.max.y < -half_max_width))
+                mask |= size_t(1) << i;
+        }
+
+        return mask;
+    }
+
+#ifdef APPLESEED_USE_SSE
+
+    template <size_t N>
+    size_t cull_curves(
+        const BezierCurveBase<float, N>* const  curves[],
+        const size_t                            count,
+        const Matrix<float, 4, 4>&              xfm,
+        const float                             max_z)
+    {
+        assert(count > 0 && count <= 4);
+
+        // Unused lanes replicate the first curve and are masked out at the end.
+        const BezierCurveBase<float, N>& c0 = *curves[0];
+        const BezierCurveBase<float, N>& c1 = *curves[count > 1 ? 1 : 0];
+        const BezierCurveBase<float, N>& c2 = *curves[count > 2 ? 2 : 0];
+        const BezierCurveBase<float, N>& c3 = *curves[count > 3 ? 3 : 0];
+
+        __m128 min_x = _mm_set1_ps(std::numeric_limits<float>::max());
+        __m128 min_y = min_x;
+        __m128 min_z = min_x;
+        __m128 max_x = _mm_set1_ps(-std::numeric_limits<float>::max());
+        __m128 max_y = max_x;
+        __m128 max_z_ = max_x;
+
+        for (size_t j = 0; j < N + 1; ++j)
+        {
+            const Vector3f& p0 = c0.get_control_point(j);
+            const Vector3f& p1 = c1.get_control_point(j);
+            const Vector3f& p2 = c2.get_control_point(j);
+            const Vector3f& p3 = c3.get_control_point(j);
+
+            const __m128 px = _mm_setr_ps(p0.x, p1.x, p2.x, p3.x);
+            const __m128 py = _mm_setr_ps(p0.y, p1.y, p2.y, p3.y);
+            const __m128 pz = _mm_setr_ps(p0.z, p1.z, p2.z, p3.z);
+
+            // The projection transform is affine.
+            const __m128 x =
+                _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(xfm[0]), px), _mm_mul_ps(_mm_set1_ps(xfm[1]), py)),
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(xfm[2]), pz), _mm_set1_ps(xfm[3])));
+            const __m128 y =
+                _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(xfm[4]), px), _mm_mul_ps(_mm_set1_ps(xfm[5]), py)),
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(xfm[6]), pz), _mm_set1_ps(xfm[7])));
+            const __m128 z =
+                _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(xfm[8]), px), _mm_mul_ps(_mm_set1_ps(xfm[9]), py)),
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(xfm[10]), pz), _mm_set1_ps(xfm[11])));
+
+            min_x = _mm_min_ps(min_x, x);
+            min_y = _mm_min_ps(min_y, y);
+            min_z = _mm_min_ps(min_z, z);
+            max_x = _mm_max_ps(max_x, x);
+            max_y = _mm_max_ps(max_y, y);
+            max_z_ = _mm_max_ps(max_z_, z);
+        }
+
+        const __m128 half_max_width =
+            _mm_mul_ps(
+                _mm_set1_ps(0.5f),
+                _mm_setr_ps(
+                    c0.compute_max_width(),
+                    c1.compute_max_width(),
+                    c2.compute_max_width(),
+                    c3.compute_max_width()));
+        const __m128 neg_half_max_width = _mm_sub_ps(_mm_setzero_ps(), half_max_width);
+
+        const __m128 rejected =
+            _mm_or_ps(
+                _mm_or_ps(
+                    _mm_cmpgt_ps(min_z, _mm_set1_ps(max_z)),
+                    _mm_cmplt_ps(max_z_, _mm_set1_ps(1.0e-6f))),
+                _mm_or_ps(
+                    _mm_or_ps(
+                        _mm_cmpgt_ps(min_x, half_max_width),
+                        _mm_cmplt_ps(max_x, neg_half_max_width)),
+                    _mm_or_ps(
+                        _mm_cmpgt_ps(min_y, half_max_width),
+                        _mm_cmplt_ps(max_y, neg_half_max_width))));
+
+        return
+            static_cast<size_t>(~_mm_movemask_ps(rejected)) &
+            ((size_t(1) << count) - 1);
+    }
+
+#endif  // APPLESEED_USE_SSE
+}
+
 //
 // BezierCurveIntersector class implementation.
 //
@@ -1111,6 +1260,27 @@ bool BezierCurveIntersector<BezierCurveType>::intersect(
             false);
 }
 
+template <typename BezierCurveType>
+inline size_t BezierCurveIntersector<BezierCurveType>::cull(
+    const BezierCurveType* const    curves[],
+    const size_t                    count,
+    const RayType&                  ray,
+    const MatrixType&               xfm,
+    const ValueType                 t)
+{
+    assert(count <= CullBatchSize);
+
+    if (count == 0)
+        return 0;
+
+    const typename BezierCurveType::Base* base_curves[CullBatchSize];
+    for (size_t i = 0; i < count; ++i)
+        base_curves[i] = curves[i];
+
+    // intersect() compares distances along the normalized ray direction.
+    return impl::cull_curves(base_curves, count, xfm, t * norm(ray.m_dir));
+}
+
 template <typename BezierCurveType>
 bool BezierCurveIntersector<BezierCurveType>::converge(
     const size_t            depth,
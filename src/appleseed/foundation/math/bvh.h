@@ -31,14 +31,19 @@
 
 // Interface headers.
 #include "foundation/math/bvh/bvh_bboxsortpredicate.h"
+#include "foundation/math/bvh/bvh_binnedsahpartitioner.h"
 #include "foundation/math/bvh/bvh_builder.h"
 #include "foundation/math/bvh/bvh_intersector.h"
 #include "foundation/math/bvh/bvh_medianpartitioner.h"
 #include "foundation/math/bvh/bvh_middlepartitioner.h"
 #include "foundation/math/bvh/bvh_node.h"
+#include "foundation/math/bvh/bvh_packetintersector.h"
 #include "foundation/math/bvh/bvh_partitionerbase.h"
 #include "foundation/math/bvh/bvh_sahpartitioner.h"
 #include "foundation/math/bvh/bvh_sbvhpartitioner.h"
 #include "foundation/math/bvh/bvh_spatialbuilder.h"
 #include "foundation/math/bvh/bvh_statistics.h"
 #include "foundation/math/bvh/bvh_tree.h"
+#include "foundation/math/bvh/bvh_widebuilder.h"
+#include "foundation/math/bvh/bvh_wideintersector.h"
+#include "foundation/math/bvh/bvh_widenode.h"
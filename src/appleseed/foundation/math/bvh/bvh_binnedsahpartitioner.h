@@ -0,0 +1,286 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace foundation {
+namespace bvh {
+
+//
+// A BVH partitioner based on the Surface Area Heuristic (SAH), evaluated on a fixed
+// number of bins along each axis rather than at every item.
+//
+// Compared to SAHPartitioner, items don't need to be sorted up front along each axis
+// and partitioning is linear in the number of items, which makes this partitioner
+// much cheaper for very large sets of items at the cost of slightly less optimal trees.
+// Disjoint ranges of items can be partitioned concurrently.
+//
+
+template <typename AABBVector, size_t BinCount = 32>
+class BinnedSAHPartitioner
+  : public NonCopyable
+{
+  public:
+    typedef AABBVector AABBVectorType;
+    typedef typename AABBVectorType::value_type AABBType;
+    typedef typename AABBType::ValueType ValueType;
+    typedef typename AABBType::VectorType VectorType;
+
+    // Constructor.
+    BinnedSAHPartitioner(
+        const AABBVectorType&   bboxes,
+        const size_t            max_leaf_size = 1,
+        const ValueType         interior_node_traversal_cost = ValueType(1.0),
+        const ValueType         item_intersection_cost = ValueType(1.0));
+
+    // Compute the bounding box of a given set of items.
+    AABBType compute_bbox(
+        const size_t            begin,
+        const size_t            end) const;
+
+    // Partition a set of items into two distinct sets.
+    size_t partition(
+        const size_t            begin,
+        const size_t            end,
+        const AABBType&         bbox);
+
+    // Return the items ordering.
+    const std::vector<size_t>& get_item_ordering() const;
+
+  private:
+    static_assert(BinCount > 1, "foundation::bvh::BinnedSAHPartitioner needs at least two bins");
+
+    static const size_t Dimension = AABBType::Dimension;
+
+    const AABBVectorType&       m_bboxes;
+    const size_t                m_max_leaf_size;
+    const ValueType             m_interior_node_traversal_cost;
+    const ValueType             m_item_intersection_cost;
+    std::vector<VectorType>     m_centers;
+    std::vector<size_t>         m_indices;
+
+    size_t compute_bin(
+        const size_t            item,
+        const size_t            dimension,
+        const ValueType         origin,
+        const ValueType         scale) const;
+};
+
+
+//
+// BinnedSAHPartitioner class implementation.
+//
+
+template <typename AABBVector, size_t BinCount>
+BinnedSAHPartitioner<AABBVector, BinCount>::BinnedSAHPartitioner(
+    const AABBVectorType&       bboxes,
+    const size_t                max_leaf_size,
+    const ValueType             interior_node_traversal_cost,
+    const ValueType             item_intersection_cost)
+  : m_bboxes(bboxes)
+  , m_max_leaf_size(max_leaf_size)
+  , m_interior_node_traversal_cost(interior_node_traversal_cost)
+  , m_item_intersection_cost(item_intersection_cost)
+  , m_centers(bboxes.size())
+  , m_indices(bboxes.size())
+{
+    for (size_t i = 0, e = bboxes.size(); i < e; ++i)
+    {
+        m_centers[i] = bboxes[i].center();
+        m_indices[i] = i;
+    }
+}
+
+template <typename AABBVector, size_t BinCount>
+typename AABBVector::value_type BinnedSAHPartitioner<AABBVector, BinCount>::compute_bbox(
+    const size_t                begin,
+    const size_t                end) const
+{
+    AABBType bbox;
+    bbox.invalidate();
+
+    for (size_t i = begin; i < end; ++i)
+        bbox.insert(m_bboxes[m_indices[i]]);
+
+    return bbox;
+}
+
+template <typename AABBVector, size_t BinCount>
+size_t BinnedSAHPartitioner<AABBVector, BinCount>::partition(
+    const size_t                begin,
+    const size_t                end,
+    const AABBType&             bbox)
+{
+    // Don't split leaves containing only degenerate items.
+    if (bbox.rank() < Dimension - 1)
+        return end;
+
+    const size_t count = end - begin;
+    assert(count > 1);
+
+    // Don't split leaves containing less than a predefined number of items.
+    if (count <= m_max_leaf_size)
+        return end;
+
+    // Bins are laid out over the bounding box of the centers of the items.
+    AABBType center_bbox;
+    center_bbox.invalidate();
+    for (size_t i = begin; i < end; ++i)
+        center_bbox.insert(m_centers[m_indices[i]]);
+
+    ValueType best_split_cost = std::numeric_limits<ValueType>::max();
+    size_t best_split_dim = 0;
+    size_t best_split_bin = 0;
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        const ValueType extent = center_bbox.max[d] - center_bbox.min[d];
+        if (!(extent > ValueType(0.0)))
+            continue;
+
+        const ValueType origin = center_bbox.min[d];
+        const ValueType scale = ValueType(BinCount) / extent;
+
+        // Bin the items.
+        AABBType bin_bboxes[BinCount];
+        size_t bin_counts[BinCount];
+        for (size_t b = 0; b < BinCount; ++b)
+        {
+            bin_bboxes[b].invalidate();
+            bin_counts[b] = 0;
+        }
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            const size_t item = m_indices[i];
+            const size_t b = compute_bin(item, d, origin, scale);
+            bin_bboxes[b].insert(m_bboxes[item]);
+            ++bin_counts[b];
+        }
+
+        // Left-to-right sweep to accumulate bounding boxes and compute their surface area.
+        ValueType left_areas[BinCount - 1];
+        size_t left_counts[BinCount - 1];
+        AABBType bbox_accumulator;
+        bbox_accumulator.invalidate();
+        size_t count_accumulator = 0;
+        for (size_t b = 0; b < BinCount - 1; ++b)
+        {
+            bbox_accumulator.insert(bin_bboxes[b]);
+            count_accumulator += bin_counts[b];
+            left_areas[b] = count_accumulator > 0 ? half_surface_area(bbox_accumulator) : ValueType(0.0);
+            left_counts[b] = count_accumulator;
+        }
+
+        // Right-to-left sweep to accumulate bounding boxes, compute their surface area find the best partition.
+        bbox_accumulator.invalidate();
+        count_accumulator = 0;
+        for (size_t b = BinCount - 1; b > 0; --b)
+        {
+            bbox_accumulator.insert(bin_bboxes[b]);
+            count_accumulator += bin_counts[b];
+
+            // Only consider partitions with items on both sides.
+            if (count_accumulator == 0 || left_counts[b - 1] == 0)
+                continue;
+
+            // Compute the cost of this partition.
+            const ValueType left_cost = left_areas[b - 1] * left_counts[b - 1];
+            const ValueType right_cost = half_surface_area(bbox_accumulator) * count_accumulator;
+            const ValueType split_cost = left_cost + right_cost;
+
+            // Keep track of the partition with the lowest cost.
+            if (best_split_cost > split_cost)
+            {
+                best_split_cost = split_cost;
+                best_split_dim = d;
+                best_split_bin = b;
+            }
+        }
+    }
+
+    // All the items have the same center: split them in two halves.
+    if (best_split_bin == 0)
+        return begin + count / 2;
+
+    // Don't split if it's cheaper to make a leaf.
+    const ValueType split_cost =
+        m_interior_node_traversal_cost +
+        best_split_cost / half_surface_area(bbox) * m_item_intersection_cost;
+    const ValueType leaf_cost = count * m_item_intersection_cost;
+    if (leaf_cost <= split_cost)
+        return end;
+
+    // Move the items of the bins left of the split to the beginning of the range.
+    const ValueType origin = center_bbox.min[best_split_dim];
+    const ValueType scale = ValueType(BinCount) / (center_bbox.max[best_split_dim] - origin);
+    const size_t pivot =
+        static_cast<size_t>(
+            std::partition(
+                &m_indices[begin],
+                &m_indices[begin] + count,
+                [&](const size_t item)
+                {
+                    return compute_bin(item, best_split_dim, origin, scale) < best_split_bin;
+                }) - &m_indices[0]);
+    assert(pivot > begin && pivot < end);
+
+    return pivot;
+}
+
+template <typename AABBVector, size_t BinCount>
+inline const std::vector<size_t>& BinnedSAHPartitioner<AABBVector, BinCount>::get_item_ordering() const
+{
+    return m_indices;
+}
+
+template <typename AABBVector, size_t BinCount>
+inline size_t BinnedSAHPartitioner<AABBVector, BinCount>::compute_bin(
+    const size_t                item,
+    const size_t                dimension,
+    const ValueType             origin,
+    const ValueType             scale) const
+{
+    const ValueType x = (m_centers[item][dimension] - origin) * scale;
+    return std::min(truncate<size_t>(std::max(x, ValueType(0.0))), BinCount - 1);
+}
+
+}   // namespace bvh
+}   // namespace foundation
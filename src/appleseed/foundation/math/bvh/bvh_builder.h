@@ -31,11 +31,17 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/log/logger.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/stopwatch.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <vector>
 
 namespace foundation {
 namespace bvh {
@@ -64,6 +70,13 @@ namespace bvh {
 //              const AABBType&     bbox);
 //      };
 //
+// When more than one thread is used, the upper levels of the tree are built
+// sequentially and the subtrees below them are built concurrently, then spliced
+// back together. In that case, partition() is called concurrently on disjoint
+// ranges of items and must be safe to do so. The decomposition only depends on
+// the number of items, never on the number of threads, so the resulting tree is
+// identical to the one built with a single thread.
+//
 
 template <typename Tree, typename Partitioner>
 class Builder
@@ -79,25 +92,69 @@ class Builder
         Tree&           tree,
         Partitioner&    partitioner,
         const size_t    size,
-        const size_t    items_per_leaf_hint);
+        const size_t    items_per_leaf_hint,
+        const size_t    thread_count = 1);
 
     // Return the construction time.
     double get_build_time() const;
 
   private:
+    typedef typename Tree::NodeVectorType NodeVector;
     typedef typename Tree::NodeType NodeType;
     typedef typename NodeType::AABBType AABBType;
 
+    // Subtrees smaller than this are never built as separate jobs.
+    static const size_t MinSubtreeSize = 4096;
+
+    // Number of subtrees the tree is roughly cut into for parallel construction.
+    static const size_t TargetSubtreeCount = 256;
+
+    struct Subtree
+    {
+        explicit Subtree(const typename NodeVector::allocator_type& allocator)
+          : m_nodes(allocator)
+        {
+        }
+
+        size_t          m_node_index;       // index of the root of the subtree in the upper tree
+        size_t          m_begin;
+        size_t          m_end;
+        AABBType        m_bbox;
+        NodeVector      m_nodes;
+    };
+
+    class SubtreeJob;
+
     double m_build_time;
 
-    // Recursively subdivide the tree.
-    void subdivide_recurse(
-        Tree&           tree,
-        Partitioner&    partitioner,
-        const size_t    node_index,
-        const size_t    begin,
-        const size_t    end,
-        const AABBType& bbox);
+    // Recursively subdivide the tree. If 'subtrees' is not null, ranges of at most
+    // 'max_subtree_size' items are recorded in 'subtrees' instead of being subdivided.
+    static void subdivide_recurse(
+        NodeVector&             nodes,
+        Partitioner&            partitioner,
+        const size_t            node_index,
+        const size_t            begin,
+        const size_t            end,
+        const AABBType&         bbox,
+        const size_t            max_subtree_size,
+        std::vector<Subtree>*   subtrees);
+
+    // Build the tree using multiple threads.
+    void parallel_build(
+        Tree&                   tree,
+        Partitioner&            partitioner,
+        const size_t            size,
+        const AABBType&         root_bbox,
+        const size_t            thread_count);
+
+    // Recursively copy a subtree, laying out its nodes as a sequential build would.
+    static void copy_recurse(
+        NodeVector&             dst_nodes,
+        const size_t            dst_node_index,
+        const NodeVector&       src_nodes,
+        const size_t            src_node_index,
+        const std::vector<Subtree>* subtrees,
+        const std::vector<size_t>*  subtree_indices);
 };
 
 
@@ -105,6 +162,39 @@ class Builder
 // Builder class implementation.
 //
 
+template <typename Tree, typename Partitioner>
+class Builder<Tree, Partitioner>::SubtreeJob
+  : public IJob
+{
+  public:
+    SubtreeJob(
+        Partitioner&    partitioner,
+        Subtree&        subtree)
+      : m_partitioner(partitioner)
+      , m_subtree(subtree)
+    {
+    }
+
+    void execute(const size_t thread_index) override
+    {
+        m_subtree.m_nodes.push_back(NodeType());
+
+        subdivide_recurse(
+            m_subtree.m_nodes,
+            m_partitioner,
+            0,
+            m_subtree.m_begin,
+            m_subtree.m_end,
+            m_subtree.m_bbox,
+            0,
+            nullptr);
+    }
+
+  private:
+    Partitioner&        m_partitioner;
+    Subtree&            m_subtree;
+};
+
 template <typename Tree, typename Partitioner>
 Builder<Tree, Partitioner>::Builder()
   : m_build_time(0.0)
@@ -117,7 +207,8 @@ void Builder<Tree, Partitioner>::build(
     Tree&               tree,
     Partitioner&        partitioner,
     const size_t        size,
-    const size_t        items_per_leaf_hint)
+    const size_t        items_per_leaf_hint,
+    const size_t        thread_count)
 {
     // Start stopwatch.
     Stopwatch<Timer> stopwatch;
@@ -131,22 +222,27 @@ void Builder<Tree, Partitioner>::build(
     const size_t node_count_guess = leaf_count_guess > 0 ? 2 * leaf_count_guess - 1 : 0;
     tree.m_nodes.reserve(node_count_guess);
 
-    // Create the root node of the tree.
-    tree.m_nodes.push_back(NodeType());
-
     // Compute the bounding box of the tree.
     const AABBType root_bbox(partitioner.compute_bbox(0, size));
 
-    // todo: preallocate node memory?
+    if (thread_count > 1 && size >= 2 * MinSubtreeSize)
+        parallel_build(tree, partitioner, size, root_bbox, thread_count);
+    else
+    {
+        // Create the root node of the tree.
+        tree.m_nodes.push_back(NodeType());
 
-    // Recursively subdivide the tree.
-    subdivide_recurse(
-        tree,
-        partitioner,
-        0,              // node index
-        0,              // begin
-        size,           // end
-        root_bbox);
+        // Recursively subdivide the tree.
+        subdivide_recurse(
+            tree.m_nodes,
+            partitioner,
+            0,              // node index
+            0,              // begin
+            size,           // end
+            root_bbox,
+            0,
+            nullptr);
+    }
 
     // Measure and save construction time.
     stopwatch.measure();
@@ -161,14 +257,28 @@ inline double Builder<Tree, Partitioner>::get_build_time() const
 
 template <typename Tree, typename Partitioner>
 void Builder<Tree, Partitioner>::subdivide_recurse(
-    Tree&               tree,
-    Partitioner&        partitioner,
-    const size_t        node_index,
-    const size_t        begin,
-    const size_t        end,
-    const AABBType&     bbox)
+    NodeVector&             nodes,
+    Partitioner&            partitioner,
+    const size_t            node_index,
+    const size_t            begin,
+    const size_t            end,
+    const AABBType&         bbox,
+    const size_t            max_subtree_size,
+    std::vector<Subtree>*   subtrees)
 {
-    assert(node_index < tree.m_nodes.size());
+    assert(node_index < nodes.size());
+
+    // Defer the construction of small enough subtrees.
+    if (subtrees && end - begin <= max_subtree_size)
+    {
+        Subtree subtree(nodes.get_allocator());
+        subtree.m_node_index = node_index;
+        subtree.m_begin = begin;
+        subtree.m_end = end;
+        subtree.m_bbox = bbox;
+        subtrees->push_back(subtree);
+        return;
+    }
 
     // Try to partition the set of items.
     size_t pivot = end;
@@ -182,7 +292,7 @@ void Builder<Tree, Partitioner>::subdivide_recurse(
     if (pivot == end)
     {
         // Turn the current node into a leaf node.
-        NodeType& node = tree.m_nodes[node_index];
+        NodeType& node = nodes[node_index];
         node.make_leaf();
         node.set_item_index(begin);
         node.set_item_count(end - begin);
@@ -194,37 +304,133 @@ void Builder<Tree, Partitioner>::subdivide_recurse(
         const AABBType right_bbox(partitioner.compute_bbox(pivot, end));
 
         // Compute the indices of the child nodes.
-        const size_t left_node_index = tree.m_nodes.size();
+        const size_t left_node_index = nodes.size();
         const size_t right_node_index = left_node_index + 1;
 
         // Turn the current node into an interior node.
-        NodeType& node = tree.m_nodes[node_index];
+        NodeType& node = nodes[node_index];
         node.make_interior();
         node.set_left_bbox(left_bbox);
         node.set_right_bbox(right_bbox);
         node.set_child_node_index(left_node_index);
 
         // Create the child nodes.
-        tree.m_nodes.push_back(NodeType());
-        tree.m_nodes.push_back(NodeType());
+        nodes.push_back(NodeType());
+        nodes.push_back(NodeType());
 
         // Recurse into the left subtree.
         subdivide_recurse(
-            tree,
+            nodes,
             partitioner,
             left_node_index,
             begin,
             pivot,
-            left_bbox);
+            left_bbox,
+            max_subtree_size,
+            subtrees);
 
         // Recurse into the right subtree.
         subdivide_recurse(
-            tree,
+            nodes,
             partitioner,
             right_node_index,
             pivot,
             end,
-            right_bbox);
+            right_bbox,
+            max_subtree_size,
+            subtrees);
+    }
+}
+
+template <typename Tree, typename Partitioner>
+void Builder<Tree, Partitioner>::parallel_build(
+    Tree&                   tree,
+    Partitioner&            partitioner,
+    const size_t            size,
+    const AABBType&         root_bbox,
+    const size_t            thread_count)
+{
+    // Subtrees never span more than half of the items: this guarantees that concurrent
+    // partitioning steps only ever touch their own range of the partitioner's arrays.
+    const size_t max_subtree_size = std::max(size / TargetSubtreeCount, MinSubtreeSize);
+    assert(max_subtree_size <= size / 2);
+
+    // Build the upper levels of the tree.
+    NodeVector upper_nodes(tree.m_nodes.get_allocator());
+    upper_nodes.push_back(NodeType());
+    std::vector<Subtree> subtrees;
+    subdivide_recurse(
+        upper_nodes,
+        partitioner,
+        0,
+        0,
+        size,
+        root_bbox,
+        max_subtree_size,
+        &subtrees);
+
+    // Build the subtrees.
+    Logger logger;
+    JobQueue job_queue;
+    JobManager job_manager(logger, job_queue, std::min(thread_count, subtrees.size()));
+    for (size_t i = 0, e = subtrees.size(); i < e; ++i)
+        job_queue.schedule(new SubtreeJob(partitioner, subtrees[i]));
+    job_manager.start();
+    job_queue.wait_until_completion();
+
+    // Splice the subtrees into the upper tree.
+    std::vector<size_t> subtree_indices(upper_nodes.size(), ~size_t(0));
+    size_t node_count = upper_nodes.size();
+    for (size_t i = 0, e = subtrees.size(); i < e; ++i)
+    {
+        subtree_indices[subtrees[i].m_node_index] = i;
+        node_count += subtrees[i].m_nodes.size() - 1;
+    }
+    tree.m_nodes.reserve(node_count);
+    tree.m_nodes.push_back(NodeType());
+    copy_recurse(tree.m_nodes, 0, upper_nodes, 0, &subtrees, &subtree_indices);
+    assert(tree.m_nodes.size() == node_count);
+}
+
+template <typename Tree, typename Partitioner>
+void Builder<Tree, Partitioner>::copy_recurse(
+    NodeVector&                 dst_nodes,
+    const size_t                dst_node_index,
+    const NodeVector&           src_nodes,
+    const size_t                src_node_index,
+    const std::vector<Subtree>* subtrees,
+    const std::vector<size_t>*  subtree_indices)
+{
+    if (subtrees)
+    {
+        const size_t subtree_index = (*subtree_indices)[src_node_index];
+        if (subtree_index != ~size_t(0))
+        {
+            copy_recurse(
+                dst_nodes,
+                dst_node_index,
+                (*subtrees)[subtree_index].m_nodes,
+                0,
+                nullptr,
+                nullptr);
+            return;
+        }
+    }
+
+    const NodeType& src_node = src_nodes[src_node_index];
+    dst_nodes[dst_node_index] = src_node;
+
+    if (src_node.is_interior())
+    {
+        const size_t src_left_node_index = src_node.get_child_node_index();
+        const size_t dst_left_node_index = dst_nodes.size();
+        dst_nodes[dst_node_index].set_child_node_index(dst_left_node_index);
+
+        dst_nodes.push_back(NodeType());
+        dst_nodes.push_back(NodeType());
+
+        copy_recurse(dst_nodes, dst_left_node_index, src_nodes, src_left_node_index, subtrees, subtree_indices);
+        copy_recurse(dst_nodes, dst_left_node_index + 1, src_nodes, src_left_node_index + 1, subtrees, subtree_indices);
     }
 }
 
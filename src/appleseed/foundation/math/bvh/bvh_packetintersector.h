@@ -0,0 +1,525 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/bvh/bvh_intersector.h"
+#include "foundation/math/bvh/bvh_statistics.h"
+#include "foundation/math/minmax.h"
+#include "foundation/math/ray.h"
+#include "foundation/platform/compiler.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace foundation {
+namespace bvh {
+
+//
+// A packet of rays traversing a BVH together.
+//
+// The rays are kept by pointer (they are owned by the caller) and are also
+// copied in structure-of-arrays form for the bounding box tests.
+//
+
+template <typename Ray, size_t Size>
+class RayPacket
+{
+  public:
+    typedef Ray RayType;
+    typedef typename Ray::ValueType ValueType;
+    typedef RayInfo<ValueType, Ray::Dimension> RayInfoType;
+
+    static_assert(Ray::Dimension == 3, "ray packets only support 3D rays");
+    static_assert(Size <= 32, "the ray mask of a packet is 32-bit");
+
+    // Rays of the packet and their precomputed ray info.
+    const RayType*                  m_rays[Size];
+    const RayInfoType*              m_ray_infos[Size];
+
+    // Bit mask of the rays still being traced. Visitors clear the bit of a ray
+    // once it no longer needs to be traced.
+    std::uint32_t                   m_active;
+
+    // Structure-of-arrays copy of the rays. Visitors may lower m_tmax[i] to
+    // the distance of the closest hit found so far along ray i.
+    APPLESEED_SIMD8_ALIGN ValueType m_org[3][Size];
+    APPLESEED_SIMD8_ALIGN ValueType m_rcp_dir[3][Size];
+    APPLESEED_SIMD8_ALIGN ValueType m_tmin[Size];
+    APPLESEED_SIMD8_ALIGN ValueType m_tmax[Size];
+
+    // Constructor. The packet is initially empty.
+    RayPacket();
+
+    // Store a ray in a given slot of the packet and mark it as active.
+    void set(
+        const size_t                index,
+        const RayType&              ray,
+        const RayInfoType&          ray_info);
+};
+
+
+//
+// Intersect all the rays of a packet with a bounding box at once.
+//
+// Returns a bit mask of the rays hitting the box and stores their entry
+// distances into 'tmin'. The semantics match foundation::intersect() for
+// a single ray-box test. Empty slots of the packet never hit.
+//
+
+template <typename T, size_t Size>
+struct RayPacketBoxTest
+{
+    template <typename Ray>
+    static std::uint32_t intersect(
+        const RayPacket<Ray, Size>& packet,
+        const AABB<T, 3>&           bbox,
+        T                           tmin[Size]);
+};
+
+
+//
+// BVH packet intersector.
+//
+// Traverses a binary BVH without motion with a packet of rays at once. Rays
+// of the packet share node fetches and bounding box tests, which are done
+// with SIMD instructions across the rays when SSE is available. Each subtree
+// is only traversed by the rays that hit its bounding box.
+//
+// The Visitor class must conform to the following prototype:
+//
+//      class Visitor
+//        : public foundation::NonCopyable
+//      {
+//        public:
+//          // Visit a leaf with the rays of the packet whose bits are set in 'ray_mask'.
+//          // Clear the bits of packet.m_active for the rays that are done, and lower
+//          // packet.m_tmax for the rays whose closest hit so far got closer.
+//          void visit(
+//              const NodeType&             node,
+//              const std::uint32_t         ray_mask,
+//              RayPacketType&              packet
+//      #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+//              , TraversalStatistics&      stats
+//      #endif
+//              );
+//      };
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t PacketSize = 4,
+    size_t StackSize = 64
+>
+class PacketIntersector
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename NodeType::AABBType::ValueType ValueType;
+    typedef RayPacket<Ray, PacketSize> RayPacketType;
+
+    // Intersect the active rays of a packet with a given BVH without motion.
+    void intersect_no_motion(
+        const Tree&             tree,
+        RayPacketType&          packet,
+        Visitor&                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , TraversalStatistics&  stats
+#endif
+        ) const;
+
+  private:
+    struct StackEntry
+    {
+        const NodeType*         m_node;
+        std::uint32_t           m_ray_mask;     // rays that hit the node
+    };
+};
+
+
+//
+// RayPacket class implementation.
+//
+
+template <typename Ray, size_t Size>
+inline RayPacket<Ray, Size>::RayPacket()
+  : m_active(0)
+{
+    // Empty slots get an empty interval so that they never hit anything.
+    for (size_t i = 0; i < Size; ++i)
+    {
+        m_rays[i] = nullptr;
+        m_ray_infos[i] = nullptr;
+        m_org[0][i] = m_org[1][i] = m_org[2][i] = ValueType(0.0);
+        m_rcp_dir[0][i] = m_rcp_dir[1][i] = m_rcp_dir[2][i] = ValueType(0.0);
+        m_tmin[i] = ValueType(1.0);
+        m_tmax[i] = ValueType(0.0);
+    }
+}
+
+template <typename Ray, size_t Size>
+inline void RayPacket<Ray, Size>::set(
+    const size_t                    index,
+    const RayType&                  ray,
+    const RayInfoType&              ray_info)
+{
+    assert(index < Size);
+
+    m_rays[index] = &ray;
+    m_ray_infos[index] = &ray_info;
+
+    for (size_t d = 0; d < 3; ++d)
+    {
+        m_org[d][index] = ray.m_org[d];
+        m_rcp_dir[d][index] = ray_info.m_rcp_dir[d];
+    }
+
+    m_tmin[index] = ray.m_tmin;
+    m_tmax[index] = ray.m_tmax;
+
+    m_active |= std::uint32_t(1) << index;
+}
+
+
+//
+// RayPacketBoxTest class implementation.
+//
+
+template <typename T, size_t Size>
+template <typename Ray>
+inline std::uint32_t RayPacketBoxTest<T, Size>::intersect(
+    const RayPacket<Ray, Size>&     packet,
+    const AABB<T, 3>&               bbox,
+    T                               tmin[Size])
+{
+    std::uint32_t hits = 0;
+
+    for (size_t i = 0; i < Size; ++i)
+    {
+        const T xl1 = packet.m_rcp_dir[0][i] * (bbox.min.x - packet.m_org[0][i]);
+        const T yl1 = packet.m_rcp_dir[1][i] * (bbox.min.y - packet.m_org[1][i]);
+        const T zl1 = packet.m_rcp_dir[2][i] * (bbox.min.z - packet.m_org[2][i]);
+
+        const T xl2 = packet.m_rcp_dir[0][i] * (bbox.max.x - packet.m_org[0][i]);
+        const T yl2 = packet.m_rcp_dir[1][i] * (bbox.max.y - packet.m_org[1][i]);
+        const T zl2 = packet.m_rcp_dir[2][i] * (bbox.max.z - packet.m_org[2][i]);
+
+        const T ray_tmin = packet.m_tmin[i];
+        const T ray_tmax = packet.m_tmax[i];
+
+        const T box_tmin = ssemax(ssemin(zl1, zl2), ssemax(ssemin(yl1, yl2), ssemax(ssemin(xl1, xl2), ray_tmin)));
+        const T box_tmax = ssemin(ssemax(zl1, zl2), ssemin(ssemax(yl1, yl2), ssemin(ssemax(xl1, xl2), ray_tmax)));
+
+        if (!(box_tmin > box_tmax || box_tmax < ray_tmin || box_tmin >= ray_tmax))
+        {
+            tmin[i] = box_tmin;
+            hits |= std::uint32_t(1) << i;
+        }
+    }
+
+    return hits;
+}
+
+#ifdef APPLESEED_USE_SSE
+
+template <size_t Size>
+struct RayPacketBoxTest<double, Size>
+{
+    template <typename Ray>
+    static std::uint32_t intersect(
+        const RayPacket<Ray, Size>& packet,
+        const AABB3d&               bbox,
+        double                      tmin[Size]);
+};
+
+template <size_t Size>
+template <typename Ray>
+inline std::uint32_t RayPacketBoxTest<double, Size>::intersect(
+    const RayPacket<Ray, Size>&     packet,
+    const AABB3d&                   bbox,
+    double                          tmin[Size])
+{
+    std::uint32_t misses = 0;
+
+#ifdef APPLESEED_USE_AVX
+
+    static_assert(Size % 4 == 0, "the AVX ray packet kernel requires a multiple of 4 rays");
+
+    const __m256d min_x = _mm256_set1_pd(bbox.min.x);
+    const __m256d min_y = _mm256_set1_pd(bbox.min.y);
+    const __m256d min_z = _mm256_set1_pd(bbox.min.z);
+    const __m256d max_x = _mm256_set1_pd(bbox.max.x);
+    const __m256d max_y = _mm256_set1_pd(bbox.max.y);
+    const __m256d max_z = _mm256_set1_pd(bbox.max.z);
+
+    for (size_t i = 0; i < Size; i += 4)
+    {
+        const __m256d org_x = _mm256_load_pd(packet.m_org[0] + i);
+        const __m256d org_y = _mm256_load_pd(packet.m_org[1] + i);
+        const __m256d org_z = _mm256_load_pd(packet.m_org[2] + i);
+        const __m256d rcp_dir_x = _mm256_load_pd(packet.m_rcp_dir[0] + i);
+        const __m256d rcp_dir_y = _mm256_load_pd(packet.m_rcp_dir[1] + i);
+        const __m256d rcp_dir_z = _mm256_load_pd(packet.m_rcp_dir[2] + i);
+        const __m256d ray_tmin = _mm256_load_pd(packet.m_tmin + i);
+        const __m256d ray_tmax = _mm256_load_pd(packet.m_tmax + i);
+
+        const __m256d xl1 = _mm256_mul_pd(rcp_dir_x, _mm256_sub_pd(min_x, org_x));
+        const __m256d yl1 = _mm256_mul_pd(rcp_dir_y, _mm256_sub_pd(min_y, org_y));
+        const __m256d zl1 = _mm256_mul_pd(rcp_dir_z, _mm256_sub_pd(min_z, org_z));
+        const __m256d xl2 = _mm256_mul_pd(rcp_dir_x, _mm256_sub_pd(max_x, org_x));
+        const __m256d yl2 = _mm256_mul_pd(rcp_dir_y, _mm256_sub_pd(max_y, org_y));
+        const __m256d zl2 = _mm256_mul_pd(rcp_dir_z, _mm256_sub_pd(max_z, org_z));
+
+        const __m256d box_tmin =
+            _mm256_max_pd(_mm256_min_pd(zl1, zl2),
+                _mm256_max_pd(_mm256_min_pd(yl1, yl2),
+                    _mm256_max_pd(_mm256_min_pd(xl1, xl2), ray_tmin)));
+        const __m256d box_tmax =
+            _mm256_min_pd(_mm256_max_pd(zl1, zl2),
+                _mm256_min_pd(_mm256_max_pd(yl1, yl2),
+                    _mm256_min_pd(_mm256_max_pd(xl1, xl2), ray_tmax)));
+
+        _mm256_storeu_pd(tmin + i, box_tmin);
+
+        misses |=
+            static_cast<std::uint32_t>(
+                _mm256_movemask_pd(
+                    _mm256_or_pd(
+                        _mm256_cmp_pd(box_tmin, box_tmax, _CMP_GT_OS),
+                        _mm256_or_pd(
+                            _mm256_cmp_pd(box_tmax, ray_tmin, _CMP_LT_OS),
+                            _mm256_cmp_pd(box_tmin, ray_tmax, _CMP_GE_OS))))) << i;
+    }
+
+#else
+
+    static_assert(Size % 2 == 0, "the SSE2 ray packet kernel requires a multiple of 2 rays");
+
+    const __m128d min_x = _mm_set1_pd(bbox.min.x);
+    const __m128d min_y = _mm_set1_pd(bbox.min.y);
+    const __m128d min_z = _mm_set1_pd(bbox.min.z);
+    const __m128d max_x = _mm_set1_pd(bbox.max.x);
+    const __m128d max_y = _mm_set1_pd(bbox.max.y);
+    const __m128d max_z = _mm_set1_pd(bbox.max.z);
+
+    for (size_t i = 0; i < Size; i += 2)
+    {
+        const __m128d org_x = _mm_load_pd(packet.m_org[0] + i);
+        const __m128d org_y = _mm_load_pd(packet.m_org[1] + i);
+        const __m128d org_z = _mm_load_pd(packet.m_org[2] + i);
+        const __m128d rcp_dir_x = _mm_load_pd(packet.m_rcp_dir[0] + i);
+        const __m128d rcp_dir_y = _mm_load_pd(packet.m_rcp_dir[1] + i);
+        const __m128d rcp_dir_z = _mm_load_pd(packet.m_rcp_dir[2] + i);
+        const __m128d ray_tmin = _mm_load_pd(packet.m_tmin + i);
+        const __m128d ray_tmax = _mm_load_pd(packet.m_tmax + i);
+
+        const __m128d xl1 = _mm_mul_pd(rcp_dir_x, _mm_sub_pd(min_x, org_x));
+        const __m128d yl1 = _mm_mul_pd(rcp_dir_y, _mm_sub_pd(min_y, org_y));
+        const __m128d zl1 = _mm_mul_pd(rcp_dir_z, _mm_sub_pd(min_z, org_z));
+        const __m128d xl2 = _mm_mul_pd(rcp_dir_x, _mm_sub_pd(max_x, org_x));
+        const __m128d yl2 = _mm_mul_pd(rcp_dir_y, _mm_sub_pd(max_y, org_y));
+        const __m128d zl2 = _mm_mul_pd(rcp_dir_z, _mm_sub_pd(max_z, org_z));
+
+        const __m128d box_tmin =
+            _mm_max_pd(_mm_min_pd(zl1, zl2),
+                _mm_max_pd(_mm_min_pd(yl1, yl2),
+                    _mm_max_pd(_mm_min_pd(xl1, xl2), ray_tmin)));
+        const __m128d box_tmax =
+            _mm_min_pd(_mm_max_pd(zl1, zl2),
+                _mm_min_pd(_mm_max_pd(yl1, yl2),
+                    _mm_min_pd(_mm_max_pd(xl1, xl2), ray_tmax)));
+
+        _mm_storeu_pd(tmin + i, box_tmin);
+
+        misses |=
+            static_cast<std::uint32_t>(
+                _mm_movemask_pd(
+                    _mm_or_pd(
+                        _mm_cmpgt_pd(box_tmin, box_tmax),
+                        _mm_or_pd(
+                            _mm_cmplt_pd(box_tmax, ray_tmin),
+                            _mm_cmpge_pd(box_tmin, ray_tmax))))) << i;
+    }
+
+#endif
+
+    const std::uint32_t packet_mask = Size == 32 ? ~std::uint32_t(0) : (std::uint32_t(1) << Size) - 1;
+
+    return ~misses & packet_mask;
+}
+
+#endif  // APPLESEED_USE_SSE
+
+
+//
+// PacketIntersector class implementation.
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t PacketSize,
+    size_t StackSize
+>
+void PacketIntersector<Tree, Visitor, Ray, PacketSize, StackSize>::intersect_no_motion(
+    const Tree&                 tree,
+    RayPacketType&              packet,
+    Visitor&                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , TraversalStatistics&      stats
+#endif
+    ) const
+{
+    // Make sure the tree was built.
+    assert(!tree.m_nodes.empty());
+
+    // Node stack.
+    StackEntry stack[StackSize];
+    StackEntry* stack_ptr = stack;
+
+    // Current node.
+    StackEntry current;
+    current.m_node = &tree.m_nodes[0];
+    current.m_ray_mask = packet.m_active;
+
+    // Initialize traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(++stats.m_traversal_count);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_nodes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_leaves = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
+
+    // Traverse the tree and intersect leaf nodes.
+    while (packet.m_active)
+    {
+        // Only the rays that hit this node and are still being traced go further.
+        const std::uint32_t ray_mask = current.m_ray_mask & packet.m_active;
+
+        if (ray_mask)
+        {
+            // Fetch the node.
+            FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+            const NodeType* node_ptr = current.m_node;
+
+            if (node_ptr->is_interior())
+            {
+                FOUNDATION_BVH_TRAVERSAL_STATS(intersected_bboxes += 2);
+
+                ValueType left_tmin[PacketSize];
+                ValueType right_tmin[PacketSize];
+
+                // Intersect the left and right bounding boxes.
+                const std::uint32_t left_hits =
+                    RayPacketBoxTest<ValueType, PacketSize>::intersect(packet, node_ptr->get_left_bbox(), left_tmin) & ray_mask;
+                const std::uint32_t right_hits =
+                    RayPacketBoxTest<ValueType, PacketSize>::intersect(packet, node_ptr->get_right_bbox(), right_tmin) & ray_mask;
+
+                const NodeType* child_ptr = &tree.m_nodes[node_ptr->get_child_node_index()];
+
+                if (left_hits && right_hits)
+                {
+                    // Continue with the child node entered first by any ray, push the other one to the stack.
+                    ValueType left_nearest = ValueType(0.0), right_nearest = ValueType(0.0);
+                    bool first = true;
+                    for (size_t i = 0; i < PacketSize; ++i)
+                    {
+                        if ((left_hits & right_hits) & (std::uint32_t(1) << i))
+                        {
+                            left_nearest = first ? left_tmin[i] : ssemin(left_nearest, left_tmin[i]);
+                            right_nearest = first ? right_tmin[i] : ssemin(right_nearest, right_tmin[i]);
+                            first = false;
+                        }
+                    }
+
+                    const size_t far_index = !first && right_nearest < left_nearest ? 0 : 1;
+
+                    assert(stack_ptr < stack + StackSize);
+                    stack_ptr->m_node = child_ptr + far_index;
+                    stack_ptr->m_ray_mask = far_index == 0 ? left_hits : right_hits;
+                    ++stack_ptr;
+
+                    current.m_node = child_ptr + (1 - far_index);
+                    current.m_ray_mask = far_index == 0 ? right_hits : left_hits;
+                    continue;
+                }
+
+                if (left_hits | right_hits)
+                {
+                    // Continue with the left or right child node.
+                    FOUNDATION_BVH_TRAVERSAL_STATS(++discarded_nodes);
+                    current.m_node = child_ptr + (left_hits ? 0 : 1);
+                    current.m_ray_mask = left_hits | right_hits;
+                    continue;
+                }
+
+                FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += 2);
+            }
+            else
+            {
+                // Visit the leaf.
+                FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+                visitor.visit(
+                    *node_ptr,
+                    ray_mask,
+                    packet
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , stats
+#endif
+                    );
+            }
+        }
+
+        // Terminate traversal if the node stack is empty.
+        if (stack_ptr == stack)
+            break;
+
+        // Pop the top node from the stack.
+        current = *--stack_ptr;
+    }
+
+    // Store traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_nodes.insert(visited_nodes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+}
+
+}   // namespace bvh
+}   // namespace foundation
@@ -65,12 +65,21 @@ class Tree
     template <typename Tree, typename Partitioner>
     friend class SpatialBuilder;
 
+    template <typename Tree, typename WideNodeVector>
+    friend class WideBuilder;
+
     template <typename Tree>
     friend class TreeStatistics;
 
     template <typename Tree, typename Visitor, typename Ray, size_t StackSize, size_t N>
     friend class Intersector;
 
+    template <typename Tree, typename WideNodeVector, typename Visitor, typename Ray, size_t StackSize>
+    friend class WideIntersector;
+
+    template <typename Tree, typename Visitor, typename Ray, size_t PacketSize, size_t StackSize>
+    friend class PacketIntersector;
+
     typedef typename NodeType::AABBType AABBType;
     typedef std::vector<AABBType> AABBVector;
 
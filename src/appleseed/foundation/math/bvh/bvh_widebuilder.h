@@ -0,0 +1,206 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Builds a wide BVH by collapsing the interior nodes of an existing binary BVH.
+//
+// Each wide node is formed by repeatedly replacing the child with the largest
+// surface area by its own two children, until the node is full or only leaves
+// remain. Leaves are not copied: wide nodes reference the leaf nodes of the
+// binary tree, so leaf visitors written for the binary tree keep working.
+//
+// Only trees without motion are supported. If the binary tree is reduced to
+// a single leaf, no wide node is created.
+//
+
+template <typename Tree, typename WideNodeVector>
+class WideBuilder
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename WideNodeVector::value_type WideNodeType;
+    typedef typename NodeType::AABBType AABBType;
+
+    // Constructor.
+    WideBuilder();
+
+    // Build a wide tree from a binary tree.
+    template <typename Timer>
+    void build(
+        const Tree&         tree,
+        WideNodeVector&     wide_nodes);
+
+    // Return the construction time.
+    double get_build_time() const;
+
+  private:
+    static const size_t Width = WideNodeType::MaxChildCount;
+
+    double m_build_time;
+
+    void collapse_recurse(
+        const Tree&         tree,
+        WideNodeVector&     wide_nodes,
+        const size_t        node_index,
+        const size_t        wide_node_index) const;
+};
+
+
+//
+// WideBuilder class implementation.
+//
+
+template <typename Tree, typename WideNodeVector>
+WideBuilder<Tree, WideNodeVector>::WideBuilder()
+  : m_build_time(0.0)
+{
+}
+
+template <typename Tree, typename WideNodeVector>
+template <typename Timer>
+void WideBuilder<Tree, WideNodeVector>::build(
+    const Tree&             tree,
+    WideNodeVector&         wide_nodes)
+{
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    wide_nodes.clear();
+
+    if (!tree.m_nodes.empty() && tree.m_nodes[0].is_interior())
+    {
+        // A binary tree with n leaves has n - 1 interior nodes; wide nodes hold at least two children.
+        wide_nodes.reserve(tree.m_nodes.size() / 2);
+
+        wide_nodes.push_back(WideNodeType());
+        collapse_recurse(tree, wide_nodes, 0, 0);
+    }
+
+    // Measure and save construction time.
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+}
+
+template <typename Tree, typename WideNodeVector>
+inline double WideBuilder<Tree, WideNodeVector>::get_build_time() const
+{
+    return m_build_time;
+}
+
+template <typename Tree, typename WideNodeVector>
+void WideBuilder<Tree, WideNodeVector>::collapse_recurse(
+    const Tree&             tree,
+    WideNodeVector&         wide_nodes,
+    const size_t            node_index,
+    const size_t            wide_node_index) const
+{
+    const NodeType& node = tree.m_nodes[node_index];
+    assert(node.is_interior());
+
+    // Start with the two children of the binary node.
+    size_t child_indices[Width];
+    AABBType child_bboxes[Width];
+    size_t child_count = 2;
+    child_indices[0] = node.get_child_node_index();
+    child_indices[1] = child_indices[0] + 1;
+    child_bboxes[0] = node.get_left_bbox();
+    child_bboxes[1] = node.get_right_bbox();
+
+    // Pull up grandchildren until the wide node is full.
+    while (child_count < Width)
+    {
+        size_t best_child = Width;
+        typename AABBType::ValueType best_area(-1.0);
+
+        for (size_t i = 0; i < child_count; ++i)
+        {
+            if (tree.m_nodes[child_indices[i]].is_interior())
+            {
+                const typename AABBType::ValueType area = half_surface_area(child_bboxes[i]);
+                if (best_area < area)
+                {
+                    best_area = area;
+                    best_child = i;
+                }
+            }
+        }
+
+        if (best_child == Width)
+            break;
+
+        const NodeType& child = tree.m_nodes[child_indices[best_child]];
+        child_indices[child_count] = child.get_child_node_index() + 1;
+        child_bboxes[child_count] = child.get_right_bbox();
+        child_indices[best_child] = child.get_child_node_index();
+        child_bboxes[best_child] = child.get_left_bbox();
+        ++child_count;
+    }
+
+    // Store the children, allocating wide nodes for interior ones.
+    size_t wide_child_indices[Width];
+    for (size_t i = 0; i < child_count; ++i)
+    {
+        const bool is_leaf = tree.m_nodes[child_indices[i]].is_leaf();
+        size_t index = child_indices[i];
+
+        if (!is_leaf)
+        {
+            index = wide_nodes.size();
+            wide_nodes.push_back(WideNodeType());
+        }
+
+        wide_child_indices[i] = index;
+        wide_nodes[wide_node_index].add_child(child_bboxes[i], index, is_leaf);
+    }
+
+    // Recurse into interior children.
+    for (size_t i = 0; i < child_count; ++i)
+    {
+        if (tree.m_nodes[child_indices[i]].is_interior())
+            collapse_recurse(tree, wide_nodes, child_indices[i], wide_child_indices[i]);
+    }
+}
+
+}   // namespace bvh
+}   // namespace foundation
@@ -0,0 +1,438 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_intersector.h"
+#include "foundation/math/bvh/bvh_statistics.h"
+#include "foundation/math/bvh/bvh_widenode.h"
+#include "foundation/math/ray.h"
+#include "foundation/math/scalar.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Intersect a ray with all the children of a wide node at once.
+//
+// Returns a bit mask of the children hit by the ray and stores the entry
+// distances into 'tmin'. The semantics match foundation::intersect() for
+// a single ray-box test.
+//
+
+template <typename T, size_t Width>
+struct WideNodeRayTest
+{
+    static std::uint32_t intersect(
+        const WideNode<AABB<T, 3>, Width>&  node,
+        const Ray<T, 3>&                    ray,
+        const RayInfo<T, 3>&                ray_info,
+        const T                             ray_tmax,
+        T                                   tmin[Width]);
+};
+
+template <typename T, size_t Width>
+inline std::uint32_t WideNodeRayTest<T, Width>::intersect(
+    const WideNode<AABB<T, 3>, Width>&      node,
+    const Ray<T, 3>&                        ray,
+    const RayInfo<T, 3>&                    ray_info,
+    const T                                 ray_tmax,
+    T                                       tmin[Width])
+{
+    std::uint32_t hits = 0;
+
+    for (size_t i = 0, e = node.get_child_count(); i < e; ++i)
+    {
+        const T xl1 = ray_info.m_rcp_dir.x * (node.m_bbox_data[1 - ray_info.m_sgn_dir.x][0][i] - ray.m_org.x);
+        const T yl1 = ray_info.m_rcp_dir.y * (node.m_bbox_data[1 - ray_info.m_sgn_dir.y][1][i] - ray.m_org.y);
+        const T zl1 = ray_info.m_rcp_dir.z * (node.m_bbox_data[1 - ray_info.m_sgn_dir.z][2][i] - ray.m_org.z);
+
+        const T xl2 = ray_info.m_rcp_dir.x * (node.m_bbox_data[    ray_info.m_sgn_dir.x][0][i] - ray.m_org.x);
+        const T yl2 = ray_info.m_rcp_dir.y * (node.m_bbox_data[    ray_info.m_sgn_dir.y][1][i] - ray.m_org.y);
+        const T zl2 = ray_info.m_rcp_dir.z * (node.m_bbox_data[    ray_info.m_sgn_dir.z][2][i] - ray.m_org.z);
+
+        const T child_tmin = ssemax(zl1, ssemax(yl1, ssemax(xl1, ray.m_tmin)));
+        const T child_tmax = ssemin(zl2, ssemin(yl2, ssemin(xl2, ray_tmax)));
+
+        if (!(child_tmin > child_tmax || child_tmax < ray.m_tmin || child_tmin >= ray_tmax))
+        {
+            tmin[i] = child_tmin;
+            hits |= 1u << i;
+        }
+    }
+
+    return hits;
+}
+
+#ifdef APPLESEED_USE_SSE
+
+template <size_t Width>
+struct WideNodeRayTest<double, Width>
+{
+    static std::uint32_t intersect(
+        const WideNode<AABB3d, Width>&      node,
+        const Ray3d&                        ray,
+        const RayInfo3d&                    ray_info,
+        const double                        ray_tmax,
+        double                              tmin[Width]);
+};
+
+template <size_t Width>
+inline std::uint32_t WideNodeRayTest<double, Width>::intersect(
+    const WideNode<AABB3d, Width>&          node,
+    const Ray3d&                            ray,
+    const RayInfo3d&                        ray_info,
+    const double                            ray_tmax,
+    double                                  tmin[Width])
+{
+    const double* near_x = node.m_bbox_data[1 - ray_info.m_sgn_dir.x][0];
+    const double* near_y = node.m_bbox_data[1 - ray_info.m_sgn_dir.y][1];
+    const double* near_z = node.m_bbox_data[1 - ray_info.m_sgn_dir.z][2];
+    const double* far_x  = node.m_bbox_data[    ray_info.m_sgn_dir.x][0];
+    const double* far_y  = node.m_bbox_data[    ray_info.m_sgn_dir.y][1];
+    const double* far_z  = node.m_bbox_data[    ray_info.m_sgn_dir.z][2];
+
+    std::uint32_t misses = 0;
+
+#ifdef APPLESEED_USE_AVX
+
+    static_assert(Width % 4 == 0, "the AVX wide node kernel requires a multiple of 4 children");
+
+    const __m256d org_x = _mm256_set1_pd(ray.m_org.x);
+    const __m256d org_y = _mm256_set1_pd(ray.m_org.y);
+    const __m256d org_z = _mm256_set1_pd(ray.m_org.z);
+    const __m256d rcp_dir_x = _mm256_set1_pd(ray_info.m_rcp_dir.x);
+    const __m256d rcp_dir_y = _mm256_set1_pd(ray_info.m_rcp_dir.y);
+    const __m256d rcp_dir_z = _mm256_set1_pd(ray_info.m_rcp_dir.z);
+    const __m256d ray_tmin_v = _mm256_set1_pd(ray.m_tmin);
+    const __m256d ray_tmax_v = _mm256_set1_pd(ray_tmax);
+
+    for (size_t i = 0; i < Width; i += 4)
+    {
+        const __m256d xl1 = _mm256_mul_pd(rcp_dir_x, _mm256_sub_pd(_mm256_load_pd(near_x + i), org_x));
+        const __m256d yl1 = _mm256_mul_pd(rcp_dir_y, _mm256_sub_pd(_mm256_load_pd(near_y + i), org_y));
+        const __m256d zl1 = _mm256_mul_pd(rcp_dir_z, _mm256_sub_pd(_mm256_load_pd(near_z + i), org_z));
+        const __m256d xl2 = _mm256_mul_pd(rcp_dir_x, _mm256_sub_pd(_mm256_load_pd(far_x + i), org_x));
+        const __m256d yl2 = _mm256_mul_pd(rcp_dir_y, _mm256_sub_pd(_mm256_load_pd(far_y + i), org_y));
+        const __m256d zl2 = _mm256_mul_pd(rcp_dir_z, _mm256_sub_pd(_mm256_load_pd(far_z + i), org_z));
+
+        const __m256d child_tmin = _mm256_max_pd(zl1, _mm256_max_pd(yl1, _mm256_max_pd(xl1, ray_tmin_v)));
+        const __m256d child_tmax = _mm256_min_pd(zl2, _mm256_min_pd(yl2, _mm256_min_pd(xl2, ray_tmax_v)));
+
+        _mm256_storeu_pd(tmin + i, child_tmin);
+
+        misses |=
+            static_cast<std::uint32_t>(
+                _mm256_movemask_pd(
+                    _mm256_or_pd(
+                        _mm256_cmp_pd(child_tmin, child_tmax, _CMP_GT_OS),
+                        _mm256_or_pd(
+                            _mm256_cmp_pd(child_tmax, ray_tmin_v, _CMP_LT_OS),
+                            _mm256_cmp_pd(child_tmin, ray_tmax_v, _CMP_GE_OS))))) << i;
+    }
+
+#else
+
+    static_assert(Width % 2 == 0, "the SSE2 wide node kernel requires a multiple of 2 children");
+
+    const __m128d org_x = _mm_set1_pd(ray.m_org.x);
+    const __m128d org_y = _mm_set1_pd(ray.m_org.y);
+    const __m128d org_z = _mm_set1_pd(ray.m_org.z);
+    const __m128d rcp_dir_x = _mm_set1_pd(ray_info.m_rcp_dir.x);
+    const __m128d rcp_dir_y = _mm_set1_pd(ray_info.m_rcp_dir.y);
+    const __m128d rcp_dir_z = _mm_set1_pd(ray_info.m_rcp_dir.z);
+    const __m128d ray_tmin_v = _mm_set1_pd(ray.m_tmin);
+    const __m128d ray_tmax_v = _mm_set1_pd(ray_tmax);
+
+    for (size_t i = 0; i < Width; i += 2)
+    {
+        const __m128d xl1 = _mm_mul_pd(rcp_dir_x, _mm_sub_pd(_mm_load_pd(near_x + i), org_x));
+        const __m128d yl1 = _mm_mul_pd(rcp_dir_y, _mm_sub_pd(_mm_load_pd(near_y + i), org_y));
+        const __m128d zl1 = _mm_mul_pd(rcp_dir_z, _mm_sub_pd(_mm_load_pd(near_z + i), org_z));
+        const __m128d xl2 = _mm_mul_pd(rcp_dir_x, _mm_sub_pd(_mm_load_pd(far_x + i), org_x));
+        const __m128d yl2 = _mm_mul_pd(rcp_dir_y, _mm_sub_pd(_mm_load_pd(far_y + i), org_y));
+        const __m128d zl2 = _mm_mul_pd(rcp_dir_z, _mm_sub_pd(_mm_load_pd(far_z + i), org_z));
+
+        const __m128d child_tmin = _mm_max_pd(zl1, _mm_max_pd(yl1, _mm_max_pd(xl1, ray_tmin_v)));
+        const __m128d child_tmax = _mm_min_pd(zl2, _mm_min_pd(yl2, _mm_min_pd(xl2, ray_tmax_v)));
+
+        _mm_storeu_pd(tmin + i, child_tmin);
+
+        misses |=
+            static_cast<std::uint32_t>(
+                _mm_movemask_pd(
+                    _mm_or_pd(
+                        _mm_cmpgt_pd(child_tmin, child_tmax),
+                        _mm_or_pd(
+                            _mm_cmplt_pd(child_tmax, ray_tmin_v),
+                            _mm_cmpge_pd(child_tmin, ray_tmax_v))))) << i;
+    }
+
+#endif
+
+    // Empty child slots are never hit.
+    const std::uint32_t child_mask = (1u << node.get_child_count()) - 1;
+
+    return ~misses & child_mask;
+}
+
+#endif  // APPLESEED_USE_SSE
+
+
+//
+// Wide BVH intersector.
+//
+// Traverses a wide tree built by foundation::bvh::WideBuilder and visits the leaves
+// of the binary tree it was collapsed from. The Visitor class must conform to the
+// prototype documented in foundation::bvh::Intersector. Only trees without motion
+// are supported.
+//
+// Children whose user mask (see foundation::bvh::WideNode) does not intersect the
+// ray mask given at construction are skipped without being visited.
+//
+
+template <
+    typename Tree,
+    typename WideNodeVector,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize = 64
+>
+class WideIntersector
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename WideNodeVector::value_type WideNodeType;
+    typedef typename WideNodeType::ValueType ValueType;
+    typedef Ray RayType;
+    typedef RayInfo<ValueType, WideNodeType::Dimension> RayInfoType;
+
+    // Constructor.
+    explicit WideIntersector(const std::uint32_t ray_mask = ~std::uint32_t(0));
+
+    // Intersect a ray with a given wide BVH without motion.
+    void intersect_no_motion(
+        const Tree&             tree,
+        const WideNodeVector&   wide_nodes,
+        const RayType&          ray,
+        const RayInfoType&      ray_info,
+        Visitor&                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , TraversalStatistics&  stats
+#endif
+        ) const;
+
+  private:
+    static const size_t Width = WideNodeType::MaxChildCount;
+
+    const std::uint32_t m_ray_mask;
+
+    // Each level of the traversal pushes at most Width - 1 entries, and the wide
+    // tree is never deeper than the binary tree it was collapsed from.
+    static const size_t StackCapacity = StackSize * (Width - 1);
+
+    struct StackEntry
+    {
+        std::uint32_t   m_index;
+        std::uint32_t   m_is_leaf;
+        ValueType       m_tmin;
+    };
+};
+
+
+//
+// WideIntersector class implementation.
+//
+
+template <
+    typename Tree,
+    typename WideNodeVector,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize
+>
+inline WideIntersector<Tree, WideNodeVector, Visitor, Ray, StackSize>::WideIntersector(
+    const std::uint32_t         ray_mask)
+  : m_ray_mask(ray_mask)
+{
+}
+
+template <
+    typename Tree,
+    typename WideNodeVector,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize
+>
+void WideIntersector<Tree, WideNodeVector, Visitor, Ray, StackSize>::intersect_no_motion(
+    const Tree&                 tree,
+    const WideNodeVector&       wide_nodes,
+    const RayType&              ray,
+    const RayInfoType&          ray_info,
+    Visitor&                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , TraversalStatistics&      stats
+#endif
+    ) const
+{
+    // Make sure the tree was built.
+    assert(!tree.m_nodes.empty());
+
+    // Node stack.
+    StackEntry stack[StackCapacity];
+    StackEntry* stack_ptr = stack;
+
+    // Current node. If the binary tree is a single leaf, there is no wide node.
+    StackEntry current;
+    current.m_index = 0;
+    current.m_is_leaf = wide_nodes.empty() ? 1 : 0;
+    current.m_tmin = ray.m_tmin;
+
+    // Initialize traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(++stats.m_traversal_count);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_nodes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_leaves = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
+
+    // Traverse the tree and intersect leaf nodes.
+    ValueType ray_tmax = ray.m_tmax;
+    while (true)
+    {
+        // Fetch the node.
+        FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+
+        if (!current.m_is_leaf)
+        {
+            const WideNodeType& node = wide_nodes[current.m_index];
+            const size_t child_count = node.get_child_count();
+            FOUNDATION_BVH_TRAVERSAL_STATS(intersected_bboxes += child_count);
+
+            APPLESEED_SIMD4_ALIGN ValueType tmin[Width];
+            const std::uint32_t hits =
+                WideNodeRayTest<ValueType, Width>::intersect(node, ray, ray_info, ray_tmax, tmin);
+
+            // Sort the children that were hit by increasing entry distance.
+            StackEntry hit_children[Width];
+            size_t hit_count = 0;
+            for (size_t i = 0; i < child_count; ++i)
+            {
+                if ((hits & (1u << i)) && (node.get_child_mask(i) & m_ray_mask))
+                {
+                    StackEntry entry;
+                    entry.m_index = static_cast<std::uint32_t>(node.get_child_index(i));
+                    entry.m_is_leaf = node.is_leaf_child(i) ? 1 : 0;
+                    entry.m_tmin = tmin[i];
+
+                    size_t j = hit_count++;
+                    while (j > 0 && hit_children[j - 1].m_tmin > entry.m_tmin)
+                    {
+                        hit_children[j] = hit_children[j - 1];
+                        --j;
+                    }
+                    hit_children[j] = entry;
+                }
+            }
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += child_count - hit_count);
+
+            if (hit_count > 0)
+            {
+                // Push the far child nodes to the stack, continue with the nearest one.
+                for (size_t i = hit_count - 1; i > 0; --i)
+                {
+                    assert(stack_ptr < stack + StackCapacity);
+                    *stack_ptr++ = hit_children[i];
+                }
+                current = hit_children[0];
+                continue;
+            }
+        }
+        else
+        {
+            // Visit the leaf.
+            FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            ValueType distance;
+#ifndef NDEBUG
+            distance = ValueType(-1.0);
+#endif
+            const bool proceed =
+                visitor.visit(
+                    tree.m_nodes[current.m_index],
+                    ray,
+                    ray_info,
+                    distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , stats
+#endif
+                    );
+            assert(!proceed || distance >= ValueType(0.0));
+
+            // Terminate traversal if the visitor decided so.
+            if (!proceed)
+                break;
+
+            // Keep track of the distance to the closest intersection.
+            if (ray_tmax > distance)
+                ray_tmax = distance;
+        }
+
+        // Pop the next node from the stack, skipping nodes beyond the closest intersection.
+        while (stack_ptr > stack && stack_ptr[-1].m_tmin >= ray_tmax)
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(++discarded_nodes);
+            --stack_ptr;
+        }
+
+        // Terminate traversal if the node stack is empty.
+        if (stack_ptr == stack)
+            break;
+
+        current = *--stack_ptr;
+    }
+
+    // Store traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_nodes.insert(visited_nodes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+}
+
+}   // namespace bvh
+}   // namespace foundation
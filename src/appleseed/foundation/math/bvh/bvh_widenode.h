@@ -0,0 +1,214 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace foundation {
+namespace bvh {
+
+//
+// A wide BVH node with up to Width children, obtained by collapsing the upper
+// levels of a binary BVH (see foundation::bvh::WideBuilder).
+//
+// Child bounding boxes are stored in SoA form so that all of them can be
+// intersected at once with SIMD instructions. A child is either another wide
+// node or a leaf node of the binary tree the wide tree was collapsed from.
+//
+// Each child also carries a user-defined bit mask, for instance the union of the
+// visibility flags of the items below it, allowing traversal to skip children
+// that cannot be relevant for a given ray (see foundation::bvh::WideIntersector).
+// Child masks default to all bits set.
+//
+// Wide nodes must be stored with at least 32-byte alignment (for instance using
+// a cache line-aligned foundation::AlignedAllocator) for AVX loads to be valid.
+//
+
+template <typename AABB, size_t Width>
+class APPLESEED_ALIGN(64) WideNode
+{
+  public:
+    typedef AABB AABBType;
+    typedef typename AABBType::ValueType ValueType;
+    static const size_t Dimension = AABBType::Dimension;
+    static const size_t MaxChildCount = Width;
+
+    // Constructor, creates a node without children.
+    WideNode();
+
+    // Append a child and return its slot.
+    size_t add_child(
+        const AABBType&     bbox,
+        const size_t        index,
+        const bool          is_leaf);
+
+    // Replace the index of an existing child.
+    void set_child_index(const size_t slot, const size_t index);
+
+    // Get the number of children.
+    size_t get_child_count() const;
+
+    // Get the bounding box of a given child.
+    AABBType get_child_bbox(const size_t slot) const;
+
+    // Return true if a given child is a leaf of the binary tree.
+    bool is_leaf_child(const size_t slot) const;
+
+    // Get the index of a given child, either in the wide node vector
+    // or, for leaf children, in the node vector of the binary tree.
+    size_t get_child_index(const size_t slot) const;
+
+    // Set/get the user mask of a given child.
+    void set_child_mask(const size_t slot, const std::uint32_t mask);
+    std::uint32_t get_child_mask(const size_t slot) const;
+
+    // Child bounding boxes, indexed by [min/max][dimension][child].
+    APPLESEED_SIMD4_ALIGN ValueType m_bbox_data[2][Dimension][Width];
+
+  private:
+    static const std::uint32_t LeafFlag = 0x80000000u;
+
+    std::uint32_t                   m_child_index[Width];
+    std::uint32_t                   m_child_mask[Width];
+    std::uint32_t                   m_child_count;
+};
+
+
+//
+// WideNode class implementation.
+//
+
+template <typename AABB, size_t Width>
+inline WideNode<AABB, Width>::WideNode()
+  : m_child_count(0)
+{
+    for (size_t i = 0; i < 2; ++i)
+    {
+        for (size_t d = 0; d < Dimension; ++d)
+        {
+            for (size_t c = 0; c < Width; ++c)
+                m_bbox_data[i][d][c] = ValueType(0.0);
+        }
+    }
+
+    for (size_t c = 0; c < Width; ++c)
+    {
+        m_child_index[c] = 0;
+        m_child_mask[c] = ~std::uint32_t(0);
+    }
+}
+
+template <typename AABB, size_t Width>
+inline size_t WideNode<AABB, Width>::add_child(
+    const AABBType&                 bbox,
+    const size_t                    index,
+    const bool                      is_leaf)
+{
+    assert(m_child_count < Width);
+
+    const size_t slot = m_child_count++;
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        m_bbox_data[0][d][slot] = bbox.min[d];
+        m_bbox_data[1][d][slot] = bbox.max[d];
+    }
+
+    m_child_index[slot] = is_leaf ? LeafFlag : 0;
+    set_child_index(slot, index);
+
+    return slot;
+}
+
+template <typename AABB, size_t Width>
+inline void WideNode<AABB, Width>::set_child_index(const size_t slot, const size_t index)
+{
+    assert(slot < m_child_count);
+    assert(index < LeafFlag);
+    m_child_index[slot] = (m_child_index[slot] & LeafFlag) | static_cast<std::uint32_t>(index);
+}
+
+template <typename AABB, size_t Width>
+inline size_t WideNode<AABB, Width>::get_child_count() const
+{
+    return m_child_count;
+}
+
+template <typename AABB, size_t Width>
+inline AABB WideNode<AABB, Width>::get_child_bbox(const size_t slot) const
+{
+    assert(slot < m_child_count);
+
+    AABBType bbox;
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        bbox.min[d] = m_bbox_data[0][d][slot];
+        bbox.max[d] = m_bbox_data[1][d][slot];
+    }
+
+    return bbox;
+}
+
+template <typename AABB, size_t Width>
+inline bool WideNode<AABB, Width>::is_leaf_child(const size_t slot) const
+{
+    assert(slot < m_child_count);
+    return (m_child_index[slot] & LeafFlag) != 0;
+}
+
+template <typename AABB, size_t Width>
+inline size_t WideNode<AABB, Width>::get_child_index(const size_t slot) const
+{
+    assert(slot < m_child_count);
+    return m_child_index[slot] & ~LeafFlag;
+}
+
+template <typename AABB, size_t Width>
+inline void WideNode<AABB, Width>::set_child_mask(const size_t slot, const std::uint32_t mask)
+{
+    assert(slot < m_child_count);
+    m_child_mask[slot] = mask;
+}
+
+template <typename AABB, size_t Width>
+inline std::uint32_t WideNode<AABB, Width>::get_child_mask(const size_t slot) const
+{
+    assert(slot < m_child_count);
+    return m_child_mask[slot];
+}
+
+}   // namespace bvh
+}   // namespace foundation
@@ -0,0 +1,321 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/half.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// The PointQuantizer class maps points inside a bounding box to 16-bit integer
+// coordinates relative to that bounding box, and back.
+//
+
+class PointQuantizer
+{
+  public:
+    // Constructors.
+#if APPLESEED_COMPILER_CXX_DEFAULTED_FUNCTIONS
+    PointQuantizer() = default;         // leave uninitialized
+#else
+    PointQuantizer() {}                 // leave uninitialized
+#endif
+
+    // Quantize points inside a given bounding box.
+    explicit PointQuantizer(const AABB3f& bbox);
+
+    // Construct a quantizer from its origin and scale, as returned by get_origin() and get_scale().
+    PointQuantizer(const Vector3f& origin, const Vector3f& scale);
+
+    const Vector3f& get_origin() const;
+    const Vector3f& get_scale() const;
+
+    void encode(const Vector3f& p, std::uint16_t q[3]) const;
+    Vector3f decode(const std::uint16_t q[3]) const;
+
+  private:
+    Vector3f m_origin;
+    Vector3f m_scale;
+    Vector3f m_rcp_scale;
+};
+
+
+//
+// The CompressedBezierCurveArray class stores Bezier curves in a compressed form.
+//
+// Curves are stored in groups of consecutive curves, typically the segments of
+// a few strands. Control points are quantized to 16 bits per coordinate relative
+// to the bounding box of their group, and widths, opacities and colors are stored
+// as half-precision floats. This roughly halves the memory footprint of curves.
+// Curves are decompressed on access.
+//
+
+template <typename CurveType>
+class CompressedBezierCurveArray
+{
+  public:
+    typedef typename CurveType::ValueType ValueType;
+    typedef typename CurveType::VectorType VectorType;
+    typedef typename CurveType::ColorType ColorType;
+
+    static const size_t ControlPointCount = CurveType::Degree + 1;
+    static const size_t GroupSize = 16;
+
+    // Constructor.
+    CompressedBezierCurveArray();
+
+    // Remove all curves.
+    void clear();
+
+    // Reserve memory for a given number of curves.
+    void reserve(const size_t count);
+
+    // Append a curve.
+    void push_back(const CurveType& curve);
+
+    // Return the number of curves.
+    size_t size() const;
+    bool empty() const;
+
+    // Decompress and return a given curve.
+    CurveType get(const size_t index) const;
+
+    // Return the size (in bytes) of this object in memory.
+    size_t get_memory_size() const;
+
+  private:
+    // Number of half values per control point: width, opacity and color.
+    static const size_t AttributeCount = 5;
+
+    std::vector<PointQuantizer>     m_quantizers;
+    std::vector<std::uint16_t>      m_points;
+    std::vector<Half>               m_attributes;
+    std::vector<CurveType>          m_pending;      // curves of the last, incomplete group
+
+    void compress_pending();
+};
+
+
+//
+// PointQuantizer class implementation.
+//
+
+inline PointQuantizer::PointQuantizer(const AABB3f& bbox)
+  : m_origin(bbox.min)
+{
+    const Vector3f extent = bbox.extent();
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        m_scale[i] = extent[i] / 65535.0f;
+        m_rcp_scale[i] = m_scale[i] > 0.0f ? 1.0f / m_scale[i] : 0.0f;
+    }
+}
+
+inline PointQuantizer::PointQuantizer(const Vector3f& origin, const Vector3f& scale)
+  : m_origin(origin)
+  , m_scale(scale)
+{
+    for (size_t i = 0; i < 3; ++i)
+        m_rcp_scale[i] = m_scale[i] > 0.0f ? 1.0f / m_scale[i] : 0.0f;
+}
+
+inline const Vector3f& PointQuantizer::get_origin() const
+{
+    return m_origin;
+}
+
+inline const Vector3f& PointQuantizer::get_scale() const
+{
+    return m_scale;
+}
+
+inline void PointQuantizer::encode(const Vector3f& p, std::uint16_t q[3]) const
+{
+    for (size_t i = 0; i < 3; ++i)
+        q[i] = round<std::uint16_t>(clamp((p[i] - m_origin[i]) * m_rcp_scale[i], 0.0f, 65535.0f));
+}
+
+inline Vector3f PointQuantizer::decode(const std::uint16_t q[3]) const
+{
+    return
+        Vector3f(
+            m_origin[0] + m_scale[0] * q[0],
+            m_origin[1] + m_scale[1] * q[1],
+            m_origin[2] + m_scale[2] * q[2]);
+}
+
+
+//
+// CompressedBezierCurveArray class implementation.
+//
+
+template <typename CurveType>
+CompressedBezierCurveArray<CurveType>::CompressedBezierCurveArray()
+{
+    m_pending.reserve(GroupSize);
+}
+
+template <typename CurveType>
+void CompressedBezierCurveArray<CurveType>::clear()
+{
+    m_quantizers.clear();
+    m_points.clear();
+    m_attributes.clear();
+    m_pending.clear();
+}
+
+template <typename CurveType>
+void CompressedBezierCurveArray<CurveType>::reserve(const size_t count)
+{
+    m_quantizers.reserve((count + GroupSize - 1) / GroupSize);
+    m_points.reserve(count * ControlPointCount * 3);
+    m_attributes.reserve(count * ControlPointCount * AttributeCount);
+}
+
+template <typename CurveType>
+void CompressedBezierCurveArray<CurveType>::push_back(const CurveType& curve)
+{
+    m_pending.push_back(curve);
+
+    if (m_pending.size() == GroupSize)
+        compress_pending();
+}
+
+template <typename CurveType>
+inline size_t CompressedBezierCurveArray<CurveType>::size() const
+{
+    return m_quantizers.size() * GroupSize + m_pending.size();
+}
+
+template <typename CurveType>
+inline bool CompressedBezierCurveArray<CurveType>::empty() const
+{
+    return size() == 0;
+}
+
+template <typename CurveType>
+inline CurveType CompressedBezierCurveArray<CurveType>::get(const size_t index) const
+{
+    assert(index < size());
+
+    const size_t group = index / GroupSize;
+
+    if (group == m_quantizers.size())
+        return m_pending[index - group * GroupSize];
+
+    const PointQuantizer& quantizer = m_quantizers[group];
+    const std::uint16_t* points = &m_points[index * ControlPointCount * 3];
+    const Half* attributes = &m_attributes[index * ControlPointCount * AttributeCount];
+
+    VectorType ctrl_pts[ControlPointCount];
+    ValueType widths[ControlPointCount];
+    ValueType opacities[ControlPointCount];
+    ColorType colors[ControlPointCount];
+
+    for (size_t i = 0; i < ControlPointCount; ++i)
+    {
+        ctrl_pts[i] = VectorType(quantizer.decode(points));
+        widths[i] = static_cast<ValueType>(attributes[0]);
+        opacities[i] = static_cast<ValueType>(attributes[1]);
+        colors[i] =
+            ColorType(
+                static_cast<ValueType>(attributes[2]),
+                static_cast<ValueType>(attributes[3]),
+                static_cast<ValueType>(attributes[4]));
+        points += 3;
+        attributes += AttributeCount;
+    }
+
+    return CurveType(ctrl_pts, widths, opacities, colors);
+}
+
+template <typename CurveType>
+size_t CompressedBezierCurveArray<CurveType>::get_memory_size() const
+{
+    return
+          sizeof(*this)
+        + m_quantizers.capacity() * sizeof(PointQuantizer)
+        + m_points.capacity() * sizeof(std::uint16_t)
+        + m_attributes.capacity() * sizeof(Half)
+        + m_pending.capacity() * sizeof(CurveType);
+}
+
+template <typename CurveType>
+void CompressedBezierCurveArray<CurveType>::compress_pending()
+{
+    assert(m_pending.size() == GroupSize);
+
+    AABB3f bbox;
+    bbox.invalidate();
+
+    for (size_t i = 0; i < GroupSize; ++i)
+    {
+        for (size_t j = 0; j < ControlPointCount; ++j)
+            bbox.insert(Vector3f(m_pending[i].get_control_point(j)));
+    }
+
+    const PointQuantizer quantizer(bbox);
+    m_quantizers.push_back(quantizer);
+
+    for (size_t i = 0; i < GroupSize; ++i)
+    {
+        const CurveType& curve = m_pending[i];
+
+        for (size_t j = 0; j < ControlPointCount; ++j)
+        {
+            std::uint16_t q[3];
+            quantizer.encode(Vector3f(curve.get_control_point(j)), q);
+            m_points.insert(m_points.end(), q, q + 3);
+
+            const ColorType& color = curve.get_color(j);
+            m_attributes.push_back(Half(static_cast<float>(curve.get_width(j))));
+            m_attributes.push_back(Half(static_cast<float>(curve.get_opacity(j))));
+            m_attributes.push_back(Half(static_cast<float>(color[0])));
+            m_attributes.push_back(Half(static_cast<float>(color[1])));
+            m_attributes.push_back(Half(static_cast<float>(color[2])));
+        }
+    }
+
+    m_pending.clear();
+}
+
+}   // namespace foundation
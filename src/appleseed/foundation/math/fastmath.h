@@ -170,6 +170,19 @@ float fast_cos_full_positive(const float x);    // x >= 0.0f
 
 float fast_acos(const float x);
 
+// Fast arc tangent approximation, max absolute error ~1.2e-5 radians.
+float fast_atan2(const float y, const float x);
+
+//
+// Fast error function approximation, max absolute error ~3.2e-5.
+//
+// Reference:
+//
+//   Handbook of Mathematical Functions, Abramowitz and Stegun, formula 7.1.26.
+//
+
+float fast_erf(const float x);
+
 // Fast reciprocal approximation.
 float fast_rcp(const float x);
 
@@ -194,6 +207,30 @@ __m128 fast_log(const __m128 x);
 __m128 faster_log(const __m128 x);
 __m128 fast_exp(const __m128 x);
 __m128 faster_exp(const __m128 x);
+__m128 fast_sin(const __m128 x);
+__m128 fast_sin_full(const __m128 x);
+__m128 fast_cos_full(const __m128 x);
+__m128 fast_atan2(const __m128 y, const __m128 x);
+__m128 fast_erf(const __m128 x);
+#endif
+
+// AVX variants of some of the functions above.
+#ifdef APPLESEED_USE_AVX
+__m256 fast_pow2(const __m256 p);
+__m256 faster_pow2(const __m256 p);
+__m256 fast_log2(const __m256 x);
+__m256 faster_log2(const __m256 x);
+__m256 fast_pow(const __m256 x, const __m256 p);
+__m256 faster_pow(const __m256 x, const __m256 p);
+__m256 fast_log(const __m256 x);
+__m256 faster_log(const __m256 x);
+__m256 fast_exp(const __m256 x);
+__m256 faster_exp(const __m256 x);
+__m256 fast_sin(const __m256 x);
+__m256 fast_sin_full(const __m256 x);
+__m256 fast_cos_full(const __m256 x);
+__m256 fast_atan2(const __m256 y, const __m256 x);
+__m256 fast_erf(const __m256 x);
 #endif
 
 // Vectorized variants of some of the functions above.
@@ -211,6 +248,40 @@ void faster_log(float x[4]);
 void fast_exp(float x[4]);
 void faster_exp(float x[4]);
 
+//
+// Batched variants of the fast_*() functions above, operating in place on arrays of Width values.
+//
+// The widest instruction set enabled at compile time that divides Width is used: AVX for
+// multiples of 8, SSE for multiples of 4, scalar code otherwise. Results are identical (up
+// to floating point rounding) to those of the scalar functions, and so are the error bounds:
+//
+//   pow2(), exp()      max relative error ~8e-5 when the result is a normal float
+//   log2()             max absolute error ~1.5e-4 for x > 0
+//   log()              max absolute error ~1.1e-4 for x > 0
+//   pow()              max relative error ~8e-5 + ~1.1e-4 * |p|, for x > 0
+//   sin(), cos()       max absolute error ~9e-4 for |x| < 2^31 / (2 * Pi)
+//   atan2()            max absolute error ~1.2e-5 radians
+//   erf()              max absolute error ~3.2e-5
+//
+// All arrays must be 16-byte aligned when Width is a multiple of 4 and 32-byte aligned when
+// Width is a multiple of 8.
+//
+
+template <std::size_t Width>
+struct BatchFastMath
+{
+    static void pow2(float p[Width]);
+    static void log2(float x[Width]);
+    static void pow(float x[Width], const float p[Width]);
+    static void pow(float x[Width], const float p);
+    static void log(float x[Width]);
+    static void exp(float x[Width]);
+    static void sin(float x[Width]);
+    static void cos(float x[Width]);
+    static void atan2(float y[Width], const float x[Width]);
+    static void erf(float x[Width]);
+};
+
 
 //
 // Implementation.
@@ -371,6 +442,36 @@ inline float fast_acos(const float x)
     return negate * foundation::Pi<float>() + ret;
 }
 
+inline float fast_atan2(const float y, const float x)
+{
+    const float abs_x = std::abs(x);
+    const float abs_y = std::abs(y);
+    const float max_xy = abs_x > abs_y ? abs_x : abs_y;
+    const float min_xy = abs_x > abs_y ? abs_y : abs_x;
+
+    // Approximate atan(a) for a in [0, 1] (Abramowitz and Stegun, formula 4.4.49).
+    const float a = max_xy > 0.0f ? min_xy / max_xy : 0.0f;
+    const float s = a * a;
+    float r = a * (0.9998660f + s * (-0.3302995f + s * (0.1801410f + s * (-0.0851330f + s * 0.0208351f))));
+
+    if (abs_y > abs_x)
+        r = HalfPi<float>() - r;
+
+    if (x < 0.0f)
+        r = Pi<float>() - r;
+
+    return y < 0.0f ? -r : r;
+}
+
+inline float fast_erf(const float x)
+{
+    const float abs_x = std::abs(x);
+    const float t = 1.0f / (1.0f + 0.3275911f * abs_x);
+    const float poly = t * (0.254829592f + t * (-0.284496736f + t * (1.421413741f + t * (-1.453152027f + t * 1.061405429f))));
+    const float y = 1.0f - poly * fast_exp(-abs_x * abs_x);
+    return x < 0.0f ? -y : y;
+}
+
 inline float fast_sqrt(const float x)
 {
     assert(x >= 0.0f);
@@ -552,6 +653,82 @@ inline __m128 faster_exp(const __m128 x)
     return faster_pow2(_mm_mul_ps(_mm_set1_ps(1.442695040f), x));
 }
 
+inline __m128 fast_sin(const __m128 x)
+{
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    const __m128 abs_x = _mm_andnot_ps(sign_mask, x);
+    const __m128 p = _mm_or_ps(_mm_set1_ps(0.22308510060189463f), _mm_and_ps(sign_mask, x));
+
+    const __m128 qpprox =
+        _mm_sub_ps(
+            _mm_mul_ps(_mm_set1_ps(FourOverPi<float>()), x),
+            _mm_mul_ps(_mm_set1_ps(FourOverPiSquare<float>()), _mm_mul_ps(x, abs_x)));
+
+    return _mm_mul_ps(qpprox, _mm_add_ps(_mm_set1_ps(0.77633023248007499f), _mm_mul_ps(p, qpprox)));
+}
+
+inline __m128 fast_sin_full(const __m128 x)
+{
+    const __m128 k = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(RcpTwoPi<float>()))));
+    const __m128 ltzero = _mm_cmplt_ps(x, _mm_setzero_ps());
+    const __m128 half = _mm_or_ps(_mm_set1_ps(0.5f), _mm_and_ps(ltzero, _mm_set1_ps(-0.0f)));
+
+    return fast_sin(_mm_sub_ps(_mm_mul_ps(_mm_add_ps(half, k), _mm_set1_ps(TwoPi<float>())), x));
+}
+
+inline __m128 fast_cos_full(const __m128 x)
+{
+    return fast_sin_full(_mm_add_ps(x, _mm_set1_ps(HalfPi<float>())));
+}
+
+inline __m128 fast_atan2(const __m128 y, const __m128 x)
+{
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    const __m128 abs_x = _mm_andnot_ps(sign_mask, x);
+    const __m128 abs_y = _mm_andnot_ps(sign_mask, y);
+    const __m128 max_xy = _mm_max_ps(abs_x, abs_y);
+    const __m128 min_xy = _mm_min_ps(abs_x, abs_y);
+
+    // The division yields NaN when x = y = 0, mask it off.
+    const __m128 a = _mm_and_ps(_mm_div_ps(min_xy, max_xy), _mm_cmpgt_ps(max_xy, _mm_setzero_ps()));
+    const __m128 s = _mm_mul_ps(a, a);
+
+    __m128 r = _mm_set1_ps(0.0208351f);
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(-0.0851330f));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.1801410f));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(-0.3302995f));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.9998660f));
+    r = _mm_mul_ps(r, a);
+
+    const __m128 swap = _mm_cmpgt_ps(abs_y, abs_x);
+    r = _mm_or_ps(_mm_andnot_ps(swap, r), _mm_and_ps(swap, _mm_sub_ps(_mm_set1_ps(HalfPi<float>()), r)));
+
+    const __m128 neg_x = _mm_cmplt_ps(x, _mm_setzero_ps());
+    r = _mm_or_ps(_mm_andnot_ps(neg_x, r), _mm_and_ps(neg_x, _mm_sub_ps(_mm_set1_ps(Pi<float>()), r)));
+
+    const __m128 neg_y = _mm_cmplt_ps(y, _mm_setzero_ps());
+    return _mm_xor_ps(r, _mm_and_ps(neg_y, sign_mask));
+}
+
+inline __m128 fast_erf(const __m128 x)
+{
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    const __m128 abs_x = _mm_andnot_ps(sign_mask, x);
+    const __m128 t = _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.3275911f), abs_x)));
+
+    __m128 poly = _mm_set1_ps(1.061405429f);
+    poly = _mm_add_ps(_mm_mul_ps(poly, t), _mm_set1_ps(-1.453152027f));
+    poly = _mm_add_ps(_mm_mul_ps(poly, t), _mm_set1_ps(1.421413741f));
+    poly = _mm_add_ps(_mm_mul_ps(poly, t), _mm_set1_ps(-0.284496736f));
+    poly = _mm_add_ps(_mm_mul_ps(poly, t), _mm_set1_ps(0.254829592f));
+    poly = _mm_mul_ps(poly, t);
+
+    const __m128 e = fast_exp(_mm_xor_ps(_mm_mul_ps(abs_x, abs_x), sign_mask));
+    const __m128 y = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(poly, e));
+
+    return _mm_xor_ps(y, _mm_and_ps(x, sign_mask));
+}
+
 inline void fast_pow2(float p[4])
 {
     assert(is_aligned(p, 16));
@@ -702,4 +879,335 @@ inline void faster_exp(float x[4])
 
 #endif  // APPLESEED_USE_SSE
 
+#ifdef APPLESEED_USE_AVX
+
+inline __m256 fast_pow2(const __m256 p)
+{
+    const __m256 ltzero = _mm256_cmp_ps(p, _mm256_setzero_ps(), _CMP_LT_OQ);
+    const __m256 offset = _mm256_and_ps(ltzero, _mm256_set1_ps(1.0f));
+    const __m256 clipp = _mm256_max_ps(p, _mm256_set1_ps(-126.0f));
+    const __m256i w = _mm256_cvttps_epi32(clipp);
+    const __m256 z = _mm256_add_ps(_mm256_sub_ps(clipp, _mm256_cvtepi32_ps(w)), offset);
+
+    return
+        _mm256_castsi256_ps(
+            _mm256_cvttps_epi32(
+                _mm256_mul_ps(
+                    _mm256_set1_ps(1 << 23),
+                    _mm256_sub_ps(
+                        _mm256_add_ps(
+                            _mm256_add_ps(clipp, _mm256_set1_ps(121.2740575f)),
+                            _mm256_div_ps(_mm256_set1_ps(27.7280233f), _mm256_sub_ps(_mm256_set1_ps(4.84252568f), z))
+                        ),
+                        _mm256_mul_ps(_mm256_set1_ps(1.49012907f), z)
+                    )
+                )
+            )
+        );
+}
+
+inline __m256 faster_pow2(const __m256 p)
+{
+    const __m256 clipp = _mm256_max_ps(p, _mm256_set1_ps(-126.0f));
+
+    return
+        _mm256_castsi256_ps(
+            _mm256_cvttps_epi32(
+                _mm256_mul_ps(
+                    _mm256_set1_ps(1 << 23),
+                    _mm256_add_ps(clipp, _mm256_set1_ps(126.94269504f))
+                )
+            )
+        );
+}
+
+inline __m256 fast_log2(const __m256 x)
+{
+    const __m256 a = _mm256_castsi256_ps(_mm256_set1_epi32(0x007FFFFF));
+    const __m256 b = _mm256_castsi256_ps(_mm256_set1_epi32(0x3f000000));
+
+    const __m256 mx = _mm256_or_ps(_mm256_and_ps(x, a), b);
+    const __m256 y = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_castps_si256(x)), _mm256_set1_ps(1.1920928955078125e-7f));
+
+    return
+        _mm256_sub_ps(
+            _mm256_sub_ps(
+                _mm256_sub_ps(y, _mm256_set1_ps(124.22551499f)),
+                _mm256_mul_ps(_mm256_set1_ps(1.498030302f), mx)),
+            _mm256_div_ps(
+                _mm256_set1_ps(1.72587999f),
+                _mm256_add_ps(_mm256_set1_ps(0.3520887068f), mx)));
+}
+
+inline __m256 faster_log2(const __m256 x)
+{
+    const __m256 y = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_castps_si256(x)), _mm256_set1_ps(1.1920928955078125e-7f));
+
+    return _mm256_sub_ps(y, _mm256_set1_ps(126.94269504f));
+}
+
+inline __m256 fast_pow(const __m256 x, const __m256 p)
+{
+    return fast_pow2(_mm256_mul_ps(p, fast_log2(x)));
+}
+
+inline __m256 faster_pow(const __m256 x, const __m256 p)
+{
+    return faster_pow2(_mm256_mul_ps(p, faster_log2(x)));
+}
+
+inline __m256 fast_log(const __m256 x)
+{
+    return _mm256_mul_ps(_mm256_set1_ps(0.69314718f), fast_log2(x));
+}
+
+inline __m256 faster_log(const __m256 x)
+{
+    const __m256 y = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_castps_si256(x)), _mm256_set1_ps(8.2629582881927490e-8f));
+
+    return _mm256_sub_ps(y, _mm256_set1_ps(87.989971088f));
+}
+
+inline __m256 fast_exp(const __m256 x)
+{
+    return fast_pow2(_mm256_mul_ps(_mm256_set1_ps(1.442695040f), x));
+}
+
+inline __m256 faster_exp(const __m256 x)
+{
+    return faster_pow2(_mm256_mul_ps(_mm256_set1_ps(1.442695040f), x));
+}
+
+inline __m256 fast_sin(const __m256 x)
+{
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    const __m256 abs_x = _mm256_andnot_ps(sign_mask, x);
+    const __m256 p = _mm256_or_ps(_mm256_set1_ps(0.22308510060189463f), _mm256_and_ps(sign_mask, x));
+
+    const __m256 qpprox =
+        _mm256_sub_ps(
+            _mm256_mul_ps(_mm256_set1_ps(FourOverPi<float>()), x),
+            _mm256_mul_ps(_mm256_set1_ps(FourOverPiSquare<float>()), _mm256_mul_ps(x, abs_x)));
+
+    return _mm256_mul_ps(qpprox, _mm256_add_ps(_mm256_set1_ps(0.77633023248007499f), _mm256_mul_ps(p, qpprox)));
+}
+
+inline __m256 fast_sin_full(const __m256 x)
+{
+    const __m256 k = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(RcpTwoPi<float>()))));
+    const __m256 ltzero = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ);
+    const __m256 half = _mm256_or_ps(_mm256_set1_ps(0.5f), _mm256_and_ps(ltzero, _mm256_set1_ps(-0.0f)));
+
+    return fast_sin(_mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(half, k), _mm256_set1_ps(TwoPi<float>())), x));
+}
+
+inline __m256 fast_cos_full(const __m256 x)
+{
+    return fast_sin_full(_mm256_add_ps(x, _mm256_set1_ps(HalfPi<float>())));
+}
+
+inline __m256 fast_atan2(const __m256 y, const __m256 x)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    const __m256 abs_x = _mm256_andnot_ps(sign_mask, x);
+    const __m256 abs_y = _mm256_andnot_ps(sign_mask, y);
+    const __m256 max_xy = _mm256_max_ps(abs_x, abs_y);
+    const __m256 min_xy = _mm256_min_ps(abs_x, abs_y);
+
+    // The division yields NaN when x = y = 0, mask it off.
+    const __m256 a = _mm256_and_ps(_mm256_div_ps(min_xy, max_xy), _mm256_cmp_ps(max_xy, zero, _CMP_GT_OQ));
+    const __m256 s = _mm256_mul_ps(a, a);
+
+    __m256 r = _mm256_set1_ps(0.0208351f);
+    r = _mm256_add_ps(_mm256_mul_ps(r, s), _mm256_set1_ps(-0.0851330f));
+    r = _mm256_add_ps(_mm256_mul_ps(r, s), _mm256_set1_ps(0.1801410f));
+    r = _mm256_add_ps(_mm256_mul_ps(r, s), _mm256_set1_ps(-0.3302995f));
+    r = _mm256_add_ps(_mm256_mul_ps(r, s), _mm256_set1_ps(0.9998660f));
+    r = _mm256_mul_ps(r, a);
+
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(HalfPi<float>()), r), _mm256_cmp_ps(abs_y, abs_x, _CMP_GT_OQ));
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(Pi<float>()), r), _mm256_cmp_ps(x, zero, _CMP_LT_OQ));
+
+    return _mm256_xor_ps(r, _mm256_and_ps(_mm256_cmp_ps(y, zero, _CMP_LT_OQ), sign_mask));
+}
+
+inline __m256 fast_erf(const __m256 x)
+{
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    const __m256 abs_x = _mm256_andnot_ps(sign_mask, x);
+    const __m256 t = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_add_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(_mm256_set1_ps(0.3275911f), abs_x)));
+
+    __m256 poly = _mm256_set1_ps(1.061405429f);
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, t), _mm256_set1_ps(-1.453152027f));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, t), _mm256_set1_ps(1.421413741f));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, t), _mm256_set1_ps(-0.284496736f));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, t), _mm256_set1_ps(0.254829592f));
+    poly = _mm256_mul_ps(poly, t);
+
+    const __m256 e = fast_exp(_mm256_xor_ps(_mm256_mul_ps(abs_x, abs_x), sign_mask));
+    const __m256 y = _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(poly, e));
+
+    return _mm256_xor_ps(y, _mm256_and_ps(x, sign_mask));
+}
+
+#endif  // APPLESEED_USE_AVX
+
+//
+// BatchFastMath class implementation.
+//
+
+namespace fastmath_impl
+{
+    // Number of values processed at once by BatchFastMath<Width>.
+    template <std::size_t Width>
+    struct PackSize
+    {
+        static const std::size_t Value =
+#ifdef APPLESEED_USE_AVX
+            Width % 8 == 0 ? 8 :
+#endif
+#ifdef APPLESEED_USE_SSE
+            Width % 4 == 0 ? 4 :
+#endif
+            1;
+    };
+
+    template <std::size_t Size>
+    struct Pack;
+
+    template <>
+    struct Pack<1>
+    {
+        typedef float Type;
+        static const std::size_t Size = 1;
+
+        static Type load(const float* p)                { return *p; }
+        static void store(float* p, const Type v)       { *p = v; }
+        static Type set(const float x)                  { return x; }
+    };
+
+#ifdef APPLESEED_USE_SSE
+
+    template <>
+    struct Pack<4>
+    {
+        typedef __m128 Type;
+        static const std::size_t Size = 4;
+
+        static Type load(const float* p)                { assert(is_aligned(p, 16)); return _mm_load_ps(p); }
+        static void store(float* p, const Type v)       { assert(is_aligned(p, 16)); _mm_store_ps(p, v); }
+        static Type set(const float x)                  { return _mm_set1_ps(x); }
+    };
+
+#endif
+
+#ifdef APPLESEED_USE_AVX
+
+    template <>
+    struct Pack<8>
+    {
+        typedef __m256 Type;
+        static const std::size_t Size = 8;
+
+        static Type load(const float* p)                { assert(is_aligned(p, 32)); return _mm256_load_ps(p); }
+        static void store(float* p, const Type v)       { assert(is_aligned(p, 32)); _mm256_store_ps(p, v); }
+        static Type set(const float x)                  { return _mm256_set1_ps(x); }
+    };
+
+#endif
+}   // namespace fastmath_impl
+
+template <std::size_t Width>
+inline void BatchFastMath<Width>::pow2(float x[Width])
+{
+    typedef fastmath_impl::Pack<fastmath_impl::PackSize<Width>::Value> Pack;
+
+    for (std::size_t i = 0; i < Width; i += Pack::Size)
+        Pack::store(x + i, fast_pow2(Pack::load(x + i)));
+}
+
+template <std::size_t Width>
+inline void BatchFastMath<Width>::log2(float x[Width])
+{
+    typedef fastmath_impl::Pack<fastmath_impl::PackSize<Width>::Value> Pack;
+
+    for (std::size_t i = 0; i < Width; i += Pack::Size)
+        Pack::store(x + i, fast_log2(Pack::load(x + i)));
+}
+
+template <std::size_t Width>
+inline void BatchFastMath<Width>::pow(float x[Width], const float p[Width])
+{
+    typedef fastmath_impl::Pack<fastmath_impl::PackSize<Width>::Value> Pack;
+
+    for (std::size_t i = 0; i < Width; i += Pack::Size)
+        Pack::store(x + i, fast_pow(Pack::load(x + i), Pack::load(p + i)));
+}
+
+template <std::size_t Width>
+inline void BatchFastMath<Width>::pow(float x[Width], const float p)
+{
+    typedef fastmath_impl::Pack<fastmath_impl::PackSize<Width>::Value> Pack;
+
+    const typename Pack::Type pp = Pack::set(p);
+
+    for (std::size_t i = 0; i < Width; i += Pack::Size)
+        Pack::store(x + i, fast_pow(Pack::load(x + i), pp));
+}
+
+template <std::size_t Width>
+inline void BatchFastMath<Width>::log(float x[Width])
+{
+    typedef fastmath_impl::Pack<fastmath_impl::PackSize<Width>::Value> Pack;
+
+    for (std::size_t i = 0; i < Width; i += Pack::Size)
+        Pack::store(x + i, fast_log(Pack::load(x + i)));
+}
+
+template <std::size_t Width>
+inline void BatchFastMath<Width>::exp(float x[Width])
+{
+    typedef fastmath_impl::Pack<fastmath_impl::PackSize<Width>::Value> Pack;
+
+    for (std::size_t i = 0; i < Width; i += Pack::Size)
+        Pack::store(x + i, fast_exp(Pack::load(x + i)));
+}
+
+template <std::size_t Width>
+inline void BatchFastMath<Width>::sin(float x[Width])
+{
+    typedef fastmath_impl::Pack<fastmath_impl::PackSize<Width>::Value> Pack;
+
+    for (std::size_t i = 0; i < Width; i += Pack::Size)
+        Pack::store(x + i, fast_sin_full(Pack::load(x + i)));
+}
+
+template <std::size_t Width>
+inline void BatchFastMath<Width>::cos(float x[Width])
+{
+    typedef fastmath_impl::Pack<fastmath_impl::PackSize<Width>::Value> Pack;
+
+    for (std::size_t i = 0; i < Width; i += Pack::Size)
+        Pack::store(x + i, fast_cos_full(Pack::load(x + i)));
+}
+
+template <std::size_t Width>
+inline void BatchFastMath<Width>::atan2(float y[Width], const float x[Width])
+{
+    typedef fastmath_impl::Pack<fastmath_impl::PackSize<Width>::Value> Pack;
+
+    for (std::size_t i = 0; i < Width; i += Pack::Size)
+        Pack::store(y + i, fast_atan2(Pack::load(y + i), Pack::load(x + i)));
+}
+
+template <std::size_t Width>
+inline void BatchFastMath<Width>::erf(float x[Width])
+{
+    typedef fastmath_impl::Pack<fastmath_impl::PackSize<Width>::Value> Pack;
+
+    for (std::size_t i = 0; i < Width; i += Pack::Size)
+        Pack::store(x + i, fast_erf(Pack::load(x + i)));
+}
+
 }   // namespace foundation
@@ -39,6 +39,7 @@
 
 // Standard headers.
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 
 namespace foundation
@@ -184,6 +185,11 @@ __m128 half_to_float(const __m128i h);
 
 #endif
 
+// Convert arrays of values. When F16C is available, eight (with AVX) or four values are
+// converted at a time; results are identical to the ones of the scalar functions above.
+void float_to_half(const float* input, Half* output, const size_t count);
+void half_to_float(const Half* input, float* output, const size_t count);
+
 
 //
 // Half class implementation.
@@ -446,4 +452,56 @@ inline __m128 half_to_float(const __m128i h)
 
 #endif  // APPLESEED_USE_SSE
 
+inline void float_to_half(const float* input, Half* output, const size_t count)
+{
+    size_t i = 0;
+
+#ifdef APPLESEED_USE_F16C
+#ifdef APPLESEED_USE_AVX
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(output + i),
+            _mm256_cvtps_ph(_mm256_loadu_ps(input + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+#endif
+
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storel_epi64(
+            reinterpret_cast<__m128i*>(output + i),
+            _mm_cvtps_ph(_mm_loadu_ps(input + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+#endif
+
+    for (; i < count; ++i)
+        output[i] = float_to_half(input[i]);
+}
+
+inline void half_to_float(const Half* input, float* output, const size_t count)
+{
+    size_t i = 0;
+
+#ifdef APPLESEED_USE_F16C
+#ifdef APPLESEED_USE_AVX
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_ps(
+            output + i,
+            _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i))));
+    }
+#endif
+
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(
+            output + i,
+            _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input + i))));
+    }
+#endif
+
+    for (; i < count; ++i)
+        output[i] = half_to_float(input[i]);
+}
+
 }   // namespace foundation
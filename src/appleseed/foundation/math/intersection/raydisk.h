@@ -32,6 +32,9 @@
 #include "foundation/math/ray.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
+#ifdef APPLESEED_USE_AVX
+#include "foundation/platform/sse.h"
+#endif
 
 // Standard headers.
 #include <cassert>
@@ -65,6 +68,24 @@ bool intersect_disk(
     T&                      u,
     T&                      v);
 
+// Test the intersection between a ray segment and up to 8 arbitrarily oriented disks stored
+// as a structure of arrays. Disk normals must be unit-length. If the ray segment hits at
+// least one disk, the index of the disk with the closest intersection is returned and the
+// distance to this intersection is returned in `tmin`. Otherwise ~size_t(0) is returned
+// and `tmin` is left unchanged. The disks are tested simultaneously when AVX is enabled;
+// only the first `count` entries of the arrays are read.
+size_t intersect_disks_x8(
+    const Ray3f&            ray,
+    const float             center_x[],
+    const float             center_y[],
+    const float             center_z[],
+    const float             normal_x[],
+    const float             normal_y[],
+    const float             normal_z[],
+    const float             radius[],
+    const size_t            count,
+    float&                  tmin);
+
 
 //
 // 3D ray-disk intersection functions implementation.
@@ -118,4 +139,120 @@ inline bool intersect_disk(
     return true;
 }
 
+inline size_t intersect_disks_x8(
+    const Ray3f&            ray,
+    const float             center_x[],
+    const float             center_y[],
+    const float             center_z[],
+    const float             normal_x[],
+    const float             normal_y[],
+    const float             normal_z[],
+    const float             radius[],
+    const size_t            count,
+    float&                  tmin)
+{
+    assert(count <= 8);
+
+#ifdef APPLESEED_USE_AVX
+
+    // Only load the first `count` lanes.
+    const __m256 lane_index = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256 lane_mask = _mm256_cmp_ps(lane_index, _mm256_set1_ps(static_cast<float>(count)), _CMP_LT_OQ);
+    const __m256i load_mask = _mm256_castps_si256(lane_mask);
+
+    const __m256 dir_x = _mm256_set1_ps(ray.m_dir.x);
+    const __m256 dir_y = _mm256_set1_ps(ray.m_dir.y);
+    const __m256 dir_z = _mm256_set1_ps(ray.m_dir.z);
+
+    const __m256 vx = _mm256_sub_ps(_mm256_maskload_ps(center_x, load_mask), _mm256_set1_ps(ray.m_org.x));
+    const __m256 vy = _mm256_sub_ps(_mm256_maskload_ps(center_y, load_mask), _mm256_set1_ps(ray.m_org.y));
+    const __m256 vz = _mm256_sub_ps(_mm256_maskload_ps(center_z, load_mask), _mm256_set1_ps(ray.m_org.z));
+    const __m256 nx = _mm256_maskload_ps(normal_x, load_mask);
+    const __m256 ny = _mm256_maskload_ps(normal_y, load_mask);
+    const __m256 nz = _mm256_maskload_ps(normal_z, load_mask);
+    const __m256 r = _mm256_maskload_ps(radius, load_mask);
+
+    // Distance to the plane of each disk: dot(center - org, n) / dot(dir, n).
+    const __m256 num =
+        _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(vx, nx), _mm256_mul_ps(vy, ny)),
+            _mm256_mul_ps(vz, nz));
+    const __m256 den =
+        _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(dir_x, nx), _mm256_mul_ps(dir_y, ny)),
+            _mm256_mul_ps(dir_z, nz));
+    const __m256 t = _mm256_div_ps(num, den);
+
+    // Squared distance between the hit point and the center of each disk.
+    const __m256 hx = _mm256_sub_ps(_mm256_mul_ps(dir_x, t), vx);
+    const __m256 hy = _mm256_sub_ps(_mm256_mul_ps(dir_y, t), vy);
+    const __m256 hz = _mm256_sub_ps(_mm256_mul_ps(dir_z, t), vz);
+    const __m256 dist_sqr =
+        _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(hx, hx), _mm256_mul_ps(hy, hy)),
+            _mm256_mul_ps(hz, hz));
+
+    // Comparisons involving NaN (ray parallel to a disk) are false.
+    const __m256 hit =
+        _mm256_and_ps(
+            _mm256_and_ps(
+                lane_mask,
+                _mm256_cmp_ps(dist_sqr, _mm256_mul_ps(r, r), _CMP_LE_OQ)),
+            _mm256_and_ps(
+                _mm256_cmp_ps(t, _mm256_set1_ps(ray.m_tmin), _CMP_GE_OQ),
+                _mm256_cmp_ps(t, _mm256_set1_ps(ray.m_tmax), _CMP_LT_OQ)));
+
+    const int hit_bits = _mm256_movemask_ps(hit);
+    if (hit_bits == 0)
+        return ~size_t(0);
+
+    // Find the closest hit across lanes.
+    const __m256 hit_t = _mm256_blendv_ps(_mm256_set1_ps(ray.m_tmax), t, hit);
+    __m256 closest = _mm256_min_ps(hit_t, _mm256_permute_ps(hit_t, _MM_SHUFFLE(2, 3, 0, 1)));
+    closest = _mm256_min_ps(closest, _mm256_permute_ps(closest, _MM_SHUFFLE(1, 0, 3, 2)));
+    closest = _mm256_min_ps(closest, _mm256_permute2f128_ps(closest, closest, 0x01));
+
+    const int closest_bits = hit_bits & _mm256_movemask_ps(_mm256_cmp_ps(hit_t, closest, _CMP_EQ_OQ));
+    assert(closest_bits != 0);
+
+    size_t index = 0;
+    while (!(closest_bits & (1 << index)))
+        ++index;
+
+    tmin = _mm256_cvtss_f32(closest);
+    return index;
+
+#else
+
+    float closest_t = ray.m_tmax;
+    size_t closest_index = ~size_t(0);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Vector3f v(center_x[i] - ray.m_org.x, center_y[i] - ray.m_org.y, center_z[i] - ray.m_org.z);
+        const Vector3f n(normal_x[i], normal_y[i], normal_z[i]);
+
+        const float den = dot(ray.m_dir, n);
+        if (den == 0.0f)
+            continue;
+
+        const float t = dot(v, n) / den;
+        if (t < ray.m_tmin || t >= closest_t)
+            continue;
+
+        if (square_norm(ray.m_dir * t - v) > square(radius[i]))
+            continue;
+
+        closest_t = t;
+        closest_index = i;
+    }
+
+    if (closest_index != ~size_t(0))
+        tmin = closest_t;
+
+    return closest_index;
+
+#endif
+}
+
 }   // namespace foundation
@@ -33,6 +33,9 @@
 #include "foundation/math/ray.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
+#ifdef APPLESEED_USE_AVX
+#include "foundation/platform/sse.h"
+#endif
 
 // Standard headers.
 #include <cassert>
@@ -96,6 +99,21 @@ size_t intersect_sphere_unit_direction(
     const T                 radius,
     T                       t_out[2]);
 
+// Test the intersection between a ray segment and up to 8 spheres stored as a structure
+// of arrays. If the ray segment hits at least one sphere, the index of the sphere with
+// the closest intersection is returned and the distance to this intersection is returned
+// in `tmin`. Otherwise ~size_t(0) is returned and `tmin` is left unchanged. The spheres
+// are tested simultaneously when AVX is enabled; only the first `count` entries of the
+// arrays are read.
+size_t intersect_spheres_x8(
+    const Ray3f&            ray,
+    const float             center_x[],
+    const float             center_y[],
+    const float             center_z[],
+    const float             radius[],
+    const size_t            count,
+    float&                  tmin);
+
 
 //
 // 3D ray-sphere intersection functions implementation.
@@ -298,4 +316,112 @@ inline size_t intersect_sphere_unit_direction(
     return hit_count;
 }
 
+inline size_t intersect_spheres_x8(
+    const Ray3f&            ray,
+    const float             center_x[],
+    const float             center_y[],
+    const float             center_z[],
+    const float             radius[],
+    const size_t            count,
+    float&                  tmin)
+{
+    assert(count <= 8);
+
+#ifdef APPLESEED_USE_AVX
+
+    // Only load the first `count` lanes.
+    const __m256 lane_index = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256 lane_mask = _mm256_cmp_ps(lane_index, _mm256_set1_ps(static_cast<float>(count)), _CMP_LT_OQ);
+    const __m256i load_mask = _mm256_castps_si256(lane_mask);
+
+    const __m256 vx = _mm256_sub_ps(_mm256_maskload_ps(center_x, load_mask), _mm256_set1_ps(ray.m_org.x));
+    const __m256 vy = _mm256_sub_ps(_mm256_maskload_ps(center_y, load_mask), _mm256_set1_ps(ray.m_org.y));
+    const __m256 vz = _mm256_sub_ps(_mm256_maskload_ps(center_z, load_mask), _mm256_set1_ps(ray.m_org.z));
+    const __m256 r = _mm256_maskload_ps(radius, load_mask);
+
+    const __m256 a = _mm256_set1_ps(dot(ray.m_dir, ray.m_dir));
+    assert(dot(ray.m_dir, ray.m_dir) > 0.0f);
+
+    // b = dot(dir, center - org).
+    const __m256 b =
+        _mm256_add_ps(
+            _mm256_add_ps(
+                _mm256_mul_ps(_mm256_set1_ps(ray.m_dir.x), vx),
+                _mm256_mul_ps(_mm256_set1_ps(ray.m_dir.y), vy)),
+            _mm256_mul_ps(_mm256_set1_ps(ray.m_dir.z), vz));
+
+    // c = dot(center - org, center - org) - radius^2.
+    const __m256 c =
+        _mm256_sub_ps(
+            _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)),
+                _mm256_mul_ps(vz, vz)),
+            _mm256_mul_ps(r, r));
+
+    const __m256 d = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+    const __m256 has_roots = _mm256_and_ps(lane_mask, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GE_OQ));
+
+    const __m256 sqrt_d = _mm256_sqrt_ps(_mm256_max_ps(d, _mm256_setzero_ps()));
+    const __m256 t1 = _mm256_div_ps(_mm256_sub_ps(b, sqrt_d), a);
+    const __m256 t2 = _mm256_div_ps(_mm256_add_ps(b, sqrt_d), a);
+
+    const __m256 ray_tmin = _mm256_set1_ps(ray.m_tmin);
+    const __m256 ray_tmax = _mm256_set1_ps(ray.m_tmax);
+    const __m256 t1_valid = _mm256_and_ps(_mm256_cmp_ps(t1, ray_tmin, _CMP_GE_OQ), _mm256_cmp_ps(t1, ray_tmax, _CMP_LT_OQ));
+    const __m256 t2_valid = _mm256_and_ps(_mm256_cmp_ps(t2, ray_tmin, _CMP_GE_OQ), _mm256_cmp_ps(t2, ray_tmax, _CMP_LT_OQ));
+
+    // Keep the closest valid root of each sphere.
+    const __m256 hit = _mm256_and_ps(has_roots, _mm256_or_ps(t1_valid, t2_valid));
+    const __m256 t =
+        _mm256_blendv_ps(
+            _mm256_set1_ps(ray.m_tmax),
+            _mm256_blendv_ps(t2, t1, t1_valid),
+            hit);
+
+    const int hit_bits = _mm256_movemask_ps(hit);
+    if (hit_bits == 0)
+        return ~size_t(0);
+
+    // Find the closest hit across lanes.
+    __m256 closest = _mm256_min_ps(t, _mm256_permute_ps(t, _MM_SHUFFLE(2, 3, 0, 1)));
+    closest = _mm256_min_ps(closest, _mm256_permute_ps(closest, _MM_SHUFFLE(1, 0, 3, 2)));
+    closest = _mm256_min_ps(closest, _mm256_permute2f128_ps(closest, closest, 0x01));
+
+    const int closest_bits = hit_bits & _mm256_movemask_ps(_mm256_cmp_ps(t, closest, _CMP_EQ_OQ));
+    assert(closest_bits != 0);
+
+    size_t index = 0;
+    while (!(closest_bits & (1 << index)))
+        ++index;
+
+    tmin = _mm256_cvtss_f32(closest);
+    return index;
+
+#else
+
+    Ray3f closest_ray(ray);
+    size_t closest_index = ~size_t(0);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        float t;
+        if (intersect_sphere(
+                closest_ray,
+                Vector3f(center_x[i], center_y[i], center_z[i]),
+                radius[i],
+                t))
+        {
+            closest_ray.m_tmax = t;
+            closest_index = i;
+        }
+    }
+
+    if (closest_index != ~size_t(0))
+        tmin = closest_ray.m_tmax;
+
+    return closest_index;
+
+#endif
+}
+
 }   // namespace foundation
@@ -0,0 +1,305 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/math/ray.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
+
+// Standard headers.
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// Watertight ray-triangle intersection test.
+//
+// The triangle vertices are translated to the ray origin, then sheared and scaled so
+// that the ray becomes the +Z axis. The test then only involves 2D edge functions of
+// the vertices, which are evaluated identically for an edge shared by two triangles:
+// rays can't slip between adjacent triangles, regardless of the precision used.
+//
+// The translation is performed in double precision before rounding to T, so that
+// single-precision triangles can be intersected with double-precision rays while
+// keeping the hit distance consistent with the traversal of the enclosing tree.
+//
+// Reference:
+//
+//   Watertight Ray/Triangle Intersection
+//   Sven Woop, Carsten Benthin, Ingo Wald
+//   http://jcgt.org/published/0002/01/05/paper.pdf
+//
+
+// A ray prepared for watertight intersection tests.
+template <typename T>
+struct WatertightRay
+{
+    // Types.
+    typedef T ValueType;
+
+    Vector3d        m_org;
+    size_t          m_kx;
+    size_t          m_ky;
+    size_t          m_kz;
+    ValueType       m_sx;
+    ValueType       m_sy;
+    ValueType       m_sz;
+    ValueType       m_tmin;
+    ValueType       m_tmax;
+
+    // Constructors.
+    WatertightRay();
+    template <typename U>
+    explicit WatertightRay(const Ray<U, 3>& ray);
+};
+
+template <typename T>
+struct TriangleWatertight
+{
+    // Types.
+    typedef T ValueType;
+    typedef Vector<T, 3> VectorType;
+    typedef Ray<T, 3> RayType;
+
+    // Vertices.
+    VectorType      m_v0;
+    VectorType      m_v1;
+    VectorType      m_v2;
+
+    // Constructors.
+    TriangleWatertight();
+    TriangleWatertight(
+        const VectorType&           v0,
+        const VectorType&           v1,
+        const VectorType&           v2);
+
+    // Construct a triangle from another triangle of a different type.
+    template <typename U>
+    TriangleWatertight(const TriangleWatertight<U>& rhs);
+
+    // Intersect a prepared ray. (u, v) are the barycentric coordinates of the
+    // hit point with respect to the second and third vertices.
+    bool intersect(
+        const WatertightRay<T>&     ray,
+        ValueType&                  t,
+        ValueType&                  u,
+        ValueType&                  v) const;
+
+    bool intersect(const WatertightRay<T>& ray) const;
+
+    // Convenience variants that prepare the ray on every call.
+    bool intersect(
+        const RayType&              ray,
+        ValueType&                  t,
+        ValueType&                  u,
+        ValueType&                  v) const;
+
+    bool intersect(const RayType& ray) const;
+
+  private:
+    // Compute the edge functions and the scaled hit distance. Return false if
+    // the ray misses the triangle, regardless of the distance along the ray.
+    bool compute_edge_functions(
+        const WatertightRay<T>&     ray,
+        ValueType&                  e0,
+        ValueType&                  e1,
+        ValueType&                  e2,
+        ValueType&                  det,
+        ValueType&                  scaled_t) const;
+};
+
+
+//
+// WatertightRay class implementation.
+//
+
+template <typename T>
+inline WatertightRay<T>::WatertightRay()
+{
+}
+
+template <typename T>
+template <typename U>
+inline WatertightRay<T>::WatertightRay(const Ray<U, 3>& ray)
+  : m_org(ray.m_org)
+  , m_tmin(static_cast<ValueType>(ray.m_tmin))
+  , m_tmax(static_cast<ValueType>(ray.m_tmax))
+{
+    const Vector<U, 3>& dir = ray.m_dir;
+
+    // Make the dominant axis of the direction the Z axis, preserving the winding.
+    m_kz = max_abs_index(dir);
+    m_kx = m_kz == 2 ? 0 : m_kz + 1;
+    m_ky = m_kx == 2 ? 0 : m_kx + 1;
+    if (dir[m_kz] < U(0.0))
+    {
+        const size_t tmp = m_kx;
+        m_kx = m_ky;
+        m_ky = tmp;
+    }
+
+    // Shear and scale factors mapping the direction to (0, 0, 1).
+    m_sx = static_cast<ValueType>(dir[m_kx] / dir[m_kz]);
+    m_sy = static_cast<ValueType>(dir[m_ky] / dir[m_kz]);
+    m_sz = static_cast<ValueType>(U(1.0) / dir[m_kz]);
+}
+
+
+//
+// TriangleWatertight class implementation.
+//
+
+template <typename T>
+inline TriangleWatertight<T>::TriangleWatertight()
+{
+}
+
+template <typename T>
+inline TriangleWatertight<T>::TriangleWatertight(
+    const VectorType&               v0,
+    const VectorType&               v1,
+    const VectorType&               v2)
+  : m_v0(v0)
+  , m_v1(v1)
+  , m_v2(v2)
+{
+}
+
+template <typename T>
+template <typename U>
+APPLESEED_FORCE_INLINE TriangleWatertight<T>::TriangleWatertight(const TriangleWatertight<U>& rhs)
+  : m_v0(VectorType(rhs.m_v0))
+  , m_v1(VectorType(rhs.m_v1))
+  , m_v2(VectorType(rhs.m_v2))
+{
+}
+
+template <typename T>
+APPLESEED_FORCE_INLINE bool TriangleWatertight<T>::compute_edge_functions(
+    const WatertightRay<T>&         ray,
+    ValueType&                      e0,
+    ValueType&                      e1,
+    ValueType&                      e2,
+    ValueType&                      det,
+    ValueType&                      scaled_t) const
+{
+    // Translate the vertices to the ray origin.
+    const VectorType a(Vector3d(m_v0) - ray.m_org);
+    const VectorType b(Vector3d(m_v1) - ray.m_org);
+    const VectorType c(Vector3d(m_v2) - ray.m_org);
+
+    // Shear the vertices.
+    const ValueType ax = a[ray.m_kx] - ray.m_sx * a[ray.m_kz];
+    const ValueType ay = a[ray.m_ky] - ray.m_sy * a[ray.m_kz];
+    const ValueType bx = b[ray.m_kx] - ray.m_sx * b[ray.m_kz];
+    const ValueType by = b[ray.m_ky] - ray.m_sy * b[ray.m_kz];
+    const ValueType cx = c[ray.m_kx] - ray.m_sx * c[ray.m_kz];
+    const ValueType cy = c[ray.m_ky] - ray.m_sy * c[ray.m_kz];
+
+    // Compute the edge functions.
+    e0 = cx * by - cy * bx;
+    e1 = ax * cy - ay * cx;
+    e2 = bx * ay - by * ax;
+
+    // Recompute edge functions that are exactly zero in double precision,
+    // this is where single-precision rounding could otherwise let rays through.
+    if (e0 == ValueType(0.0) || e1 == ValueType(0.0) || e2 == ValueType(0.0))
+    {
+        e0 = static_cast<ValueType>(static_cast<double>(cx) * by - static_cast<double>(cy) * bx);
+        e1 = static_cast<ValueType>(static_cast<double>(ax) * cy - static_cast<double>(ay) * cx);
+        e2 = static_cast<ValueType>(static_cast<double>(bx) * ay - static_cast<double>(by) * ax);
+    }
+
+    // The ray misses the triangle if the edge functions have different signs.
+    if ((e0 < ValueType(0.0) || e1 < ValueType(0.0) || e2 < ValueType(0.0)) &&
+        (e0 > ValueType(0.0) || e1 > ValueType(0.0) || e2 > ValueType(0.0)))
+        return false;
+
+    // The ray is parallel to the triangle.
+    det = e0 + e1 + e2;
+    if (det == ValueType(0.0))
+        return false;
+
+    // Compute the hit distance, scaled by the determinant.
+    const ValueType az = ray.m_sz * a[ray.m_kz];
+    const ValueType bz = ray.m_sz * b[ray.m_kz];
+    const ValueType cz = ray.m_sz * c[ray.m_kz];
+    scaled_t = e0 * az + e1 * bz + e2 * cz;
+
+    // Check the hit distance against the ray interval.
+    if (det > ValueType(0.0))
+        return scaled_t >= ray.m_tmin * det && scaled_t < ray.m_tmax * det;
+    else return scaled_t <= ray.m_tmin * det && scaled_t > ray.m_tmax * det;
+}
+
+template <typename T>
+APPLESEED_FORCE_INLINE bool TriangleWatertight<T>::intersect(
+    const WatertightRay<T>&         ray,
+    ValueType&                      t,
+    ValueType&                      u,
+    ValueType&                      v) const
+{
+    ValueType e0, e1, e2, det, scaled_t;
+    if (!compute_edge_functions(ray, e0, e1, e2, det, scaled_t))
+        return false;
+
+    const ValueType rcp_det = ValueType(1.0) / det;
+    t = scaled_t * rcp_det;
+    u = e1 * rcp_det;
+    v = e2 * rcp_det;
+
+    return true;
+}
+
+template <typename T>
+APPLESEED_FORCE_INLINE bool TriangleWatertight<T>::intersect(const WatertightRay<T>& ray) const
+{
+    ValueType e0, e1, e2, det, scaled_t;
+    return compute_edge_functions(ray, e0, e1, e2, det, scaled_t);
+}
+
+template <typename T>
+inline bool TriangleWatertight<T>::intersect(
+    const RayType&                  ray,
+    ValueType&                      t,
+    ValueType&                      u,
+    ValueType&                      v) const
+{
+    return intersect(WatertightRay<T>(ray), t, u, v);
+}
+
+template <typename T>
+inline bool TriangleWatertight<T>::intersect(const RayType& ray) const
+{
+    return intersect(WatertightRay<T>(ray));
+}
+
+}   // namespace foundation
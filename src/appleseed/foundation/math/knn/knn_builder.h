@@ -37,6 +37,10 @@
 #include "foundation/math/permutation.h"
 #include "foundation/math/split.h"
 #include "foundation/math/vector.h"
+#include "foundation/log/logger.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/stopwatch.h"
 
 // Standard headers.
@@ -49,6 +53,17 @@
 namespace foundation {
 namespace knn {
 
+//
+// When more than one thread is used, the upper levels of the tree are built
+// sequentially and the subtrees below them are built concurrently, then spliced
+// back together. The decomposition only depends on the number of points, so the
+// resulting tree is identical to the one built with a single thread.
+//
+// Subdivision stops at nodes containing at most a given number of points. Leaves
+// larger than one point are contiguous buckets of points that queries scan with
+// vectorized distance computations, and they make the node array much smaller.
+//
+
 template <typename T, size_t N>
 class Builder
   : public NonCopyable
@@ -61,28 +76,49 @@ class Builder
     typedef Tree<T, N> TreeType;
 
     // Constructor.
-    explicit Builder(TreeType& tree);
+    explicit Builder(
+        TreeType&                   tree,
+        const size_t                max_leaf_size = 1);
 
     // Build a tree for a given set of points.
     template <typename Timer>
     void build(
         const VectorType            points[],
-        const size_t                count);
+        const size_t                count,
+        const size_t                thread_count = 1);
 
     // Like build() but the points will be moved into the tree rather than copied.
     // todo: take rvalue reference.
     template <typename Timer>
     void build_move_points(
-        std::vector<VectorType>&    points);
+        std::vector<VectorType>&    points,
+        const size_t                thread_count = 1);
 
     // Return the construction time.
     double get_build_time() const;
 
   private:
     typedef typename TreeType::NodeType NodeType;
+    typedef std::vector<NodeType> NodeVector;
     typedef AABB<T, N> BboxType;
     typedef Split<T> SplitType;
 
+    // Subtrees smaller than this are never built as separate jobs.
+    static const size_t MinSubtreeSize = 4096;
+
+    // Number of subtrees the tree is roughly cut into for parallel construction.
+    static const size_t TargetSubtreeCount = 256;
+
+    struct Subtree
+    {
+        size_t                      m_node_index;       // index of the root of the subtree in the upper tree
+        size_t                      m_begin;
+        size_t                      m_end;
+        NodeVector                  m_nodes;
+    };
+
+    class SubtreeJob;
+
     struct PartitionPredicate
     {
         typedef std::vector<VectorType> PointVector;
@@ -98,13 +134,33 @@ class Builder
             const size_t            index) const;
     };
 
-    TreeType&   m_tree;
-    double      m_build_time;
+    TreeType&       m_tree;
+    const size_t    m_max_leaf_size;
+    double          m_build_time;
 
+    // Recursively partition a set of points. If 'subtrees' is not null, ranges of at most
+    // 'max_subtree_size' points are recorded in 'subtrees' instead of being partitioned.
     void partition(
+        NodeVector&                 nodes,
         const size_t                parent_node_index,
         const size_t                begin,
-        const size_t                end) const;
+        const size_t                end,
+        const size_t                max_subtree_size,
+        std::vector<Subtree>*       subtrees) const;
+
+    // Build the tree using multiple threads.
+    void parallel_build(
+        const size_t                count,
+        const size_t                thread_count);
+
+    // Recursively copy a subtree, laying out its nodes as a sequential build would.
+    static void copy_recurse(
+        NodeVector&                 dst_nodes,
+        const size_t                dst_node_index,
+        const NodeVector&           src_nodes,
+        const size_t                src_node_index,
+        const std::vector<Subtree>* subtrees,
+        const std::vector<size_t>*  subtree_indices);
 
     BboxType compute_bbox(
         const size_t                begin,
@@ -122,17 +178,54 @@ typedef Builder<double, 3> Builder3d;
 //
 
 template <typename T, size_t N>
-inline Builder<T, N>::Builder(TreeType& tree)
+class Builder<T, N>::SubtreeJob
+  : public IJob
+{
+  public:
+    SubtreeJob(
+        const Builder&              builder,
+        Subtree&                    subtree)
+      : m_builder(builder)
+      , m_subtree(subtree)
+    {
+    }
+
+    void execute(const size_t thread_index) override
+    {
+        m_subtree.m_nodes.reserve((m_subtree.m_end - m_subtree.m_begin) * 2 - 1);
+        m_subtree.m_nodes.push_back(NodeType());
+
+        m_builder.partition(
+            m_subtree.m_nodes,
+            0,
+            m_subtree.m_begin,
+            m_subtree.m_end,
+            0,
+            nullptr);
+    }
+
+  private:
+    const Builder&                  m_builder;
+    Subtree&                        m_subtree;
+};
+
+template <typename T, size_t N>
+inline Builder<T, N>::Builder(
+    TreeType&                   tree,
+    const size_t                max_leaf_size)
   : m_tree(tree)
+  , m_max_leaf_size(max_leaf_size)
   , m_build_time(0.0)
 {
+    assert(max_leaf_size > 0);
 }
 
 template <typename T, size_t N>
 template <typename Timer>
 void Builder<T, N>::build(
     const VectorType            points[],
-    const size_t                count)
+    const size_t                count,
+    const size_t                thread_count)
 {
     std::vector<VectorType> vec(count);
 
@@ -142,13 +235,14 @@ void Builder<T, N>::build(
         std::memcpy(&vec[0], points, count * sizeof(VectorType));
     }
 
-    build_move_points<Timer>(vec);
+    build_move_points<Timer>(vec, thread_count);
 }
 
 template <typename T, size_t N>
 template <typename Timer>
 void Builder<T, N>::build_move_points(
-    std::vector<VectorType>&    points)
+    std::vector<VectorType>&    points,
+    const size_t                thread_count)
 {
     Stopwatch<Timer> stopwatch;
     stopwatch.start();
@@ -165,10 +259,15 @@ void Builder<T, N>::build_move_points(
             m_tree.m_indices[i] = i;
     }
 
-    m_tree.m_nodes.reserve(count * 2 + 1);
-    m_tree.m_nodes.push_back(NodeType());
+    if (thread_count > 1 && count >= 2 * MinSubtreeSize)
+        parallel_build(count, thread_count);
+    else
+    {
+        m_tree.m_nodes.reserve(count * 2 + 1);
+        m_tree.m_nodes.push_back(NodeType());
 
-    partition(0, 0, count);
+        partition(m_tree.m_nodes, 0, 0, count, 0, nullptr);
+    }
 
     if (count > 0)
     {
@@ -210,15 +309,29 @@ inline bool Builder<T, N>::PartitionPredicate::operator()(
 
 template <typename T, size_t N>
 void Builder<T, N>::partition(
+    NodeVector&                 nodes,
     const size_t                parent_node_index,
     const size_t                begin,
-    const size_t                end) const
+    const size_t                end,
+    const size_t                max_subtree_size,
+    std::vector<Subtree>*       subtrees) const
 {
     const size_t count = end - begin;
 
-    if (count <= 1)
+    // Defer the construction of small enough subtrees.
+    if (subtrees && count <= max_subtree_size)
     {
-        NodeType& parent_node = m_tree.m_nodes[parent_node_index];
+        Subtree subtree;
+        subtree.m_node_index = parent_node_index;
+        subtree.m_begin = begin;
+        subtree.m_end = end;
+        subtrees->push_back(subtree);
+        return;
+    }
+
+    if (count <= m_max_leaf_size)
+    {
+        NodeType& parent_node = nodes[parent_node_index];
         parent_node.make_leaf();
         parent_node.set_point_index(begin);
         parent_node.set_point_count(count);
@@ -245,13 +358,13 @@ void Builder<T, N>::partition(
         if (pivot == begin || pivot == end)
             pivot = (begin + end) / 2;
 
-        const size_t left_node_index = m_tree.m_nodes.size();
+        const size_t left_node_index = nodes.size();
         const size_t right_node_index = left_node_index + 1;
 
-        m_tree.m_nodes.push_back(NodeType());
-        m_tree.m_nodes.push_back(NodeType());
+        nodes.push_back(NodeType());
+        nodes.push_back(NodeType());
 
-        NodeType& parent_node = m_tree.m_nodes[parent_node_index];
+        NodeType& parent_node = nodes[parent_node_index];
         parent_node.make_interior();
         parent_node.set_split_dim(split.m_dimension);
         parent_node.set_split_abs(split.m_abscissa);
@@ -259,8 +372,88 @@ void Builder<T, N>::partition(
         parent_node.set_point_index(begin);
         parent_node.set_point_count(count);
 
-        partition(left_node_index, begin, pivot);
-        partition(right_node_index, pivot, end);
+        partition(nodes, left_node_index, begin, pivot, max_subtree_size, subtrees);
+        partition(nodes, right_node_index, pivot, end, max_subtree_size, subtrees);
+    }
+}
+
+template <typename T, size_t N>
+void Builder<T, N>::parallel_build(
+    const size_t                count,
+    const size_t                thread_count)
+{
+    // Subtrees never span more than half of the points, so there is always an upper tree.
+    const size_t max_subtree_size = std::max(count / TargetSubtreeCount, MinSubtreeSize);
+    assert(max_subtree_size <= count / 2);
+
+    // Build the upper levels of the tree.
+    NodeVector upper_nodes;
+    upper_nodes.push_back(NodeType());
+    std::vector<Subtree> subtrees;
+    partition(upper_nodes, 0, 0, count, max_subtree_size, &subtrees);
+
+    // Build the subtrees. Each job only touches its own range of point indices.
+    Logger logger;
+    JobQueue job_queue;
+    JobManager job_manager(logger, job_queue, std::min(thread_count, subtrees.size()));
+    for (size_t i = 0, e = subtrees.size(); i < e; ++i)
+        job_queue.schedule(new SubtreeJob(*this, subtrees[i]));
+    job_manager.start();
+    job_queue.wait_until_completion();
+
+    // Splice the subtrees into the upper tree.
+    std::vector<size_t> subtree_indices(upper_nodes.size(), ~size_t(0));
+    size_t node_count = upper_nodes.size();
+    for (size_t i = 0, e = subtrees.size(); i < e; ++i)
+    {
+        subtree_indices[subtrees[i].m_node_index] = i;
+        node_count += subtrees[i].m_nodes.size() - 1;
+    }
+    m_tree.m_nodes.reserve(node_count);
+    m_tree.m_nodes.push_back(NodeType());
+    copy_recurse(m_tree.m_nodes, 0, upper_nodes, 0, &subtrees, &subtree_indices);
+    assert(m_tree.m_nodes.size() == node_count);
+}
+
+template <typename T, size_t N>
+void Builder<T, N>::copy_recurse(
+    NodeVector&                 dst_nodes,
+    const size_t                dst_node_index,
+    const NodeVector&           src_nodes,
+    const size_t                src_node_index,
+    const std::vector<Subtree>* subtrees,
+    const std::vector<size_t>*  subtree_indices)
+{
+    if (subtrees)
+    {
+        const size_t subtree_index = (*subtree_indices)[src_node_index];
+        if (subtree_index != ~size_t(0))
+        {
+            copy_recurse(
+                dst_nodes,
+                dst_node_index,
+                (*subtrees)[subtree_index].m_nodes,
+                0,
+                nullptr,
+                nullptr);
+            return;
+        }
+    }
+
+    const NodeType& src_node = src_nodes[src_node_index];
+    dst_nodes[dst_node_index] = src_node;
+
+    if (src_node.is_interior())
+    {
+        const size_t src_left_node_index = src_node.get_child_node_index();
+        const size_t dst_left_node_index = dst_nodes.size();
+        dst_nodes[dst_node_index].set_child_node_index(dst_left_node_index);
+
+        dst_nodes.push_back(NodeType());
+        dst_nodes.push_back(NodeType());
+
+        copy_recurse(dst_nodes, dst_left_node_index, src_nodes, src_left_node_index, subtrees, subtree_indices);
+        copy_recurse(dst_nodes, dst_left_node_index + 1, src_nodes, src_left_node_index + 1, subtrees, subtree_indices);
     }
 }
 
@@ -38,11 +38,17 @@
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <limits>
+#include <utility>
+#include <vector>
 
 // Enable or disable k-nn query statistics.
 #undef FOUNDATION_KNN_ENABLE_QUERY_STATS
@@ -50,6 +56,14 @@
 namespace foundation {
 namespace knn {
 
+// Compute the square distances between a query point and an array of points.
+template <typename T, std::size_t N>
+void compute_square_distances(
+    const Vector<T, N>* APPLESEED_RESTRICT  points,
+    const std::size_t                       count,
+    const Vector<T, N>&                     query_point,
+    T* APPLESEED_RESTRICT                   square_dists);
+
 template <typename T, std::size_t N>
 class Query
   : public NonCopyable
@@ -90,9 +104,22 @@ class Query
         const ValueType     query_max_square_distance) const;
 #endif
 
+    // Run one query per point of an array. Queries are reordered so that queries
+    // landing in the same region of the tree run back to back, then the answer of
+    // each query is passed to visitor(query_index, answer).
+    template <typename Visitor>
+    void run_batch(
+        const VectorType    query_points[],
+        const std::size_t   count,
+        const ValueType     query_max_square_distance,
+        Visitor&            visitor) const;
+
   private:
     typedef typename TreeType::NodeType NodeType;
 
+    // Number of points whose distances to the query point are computed at once.
+    static const std::size_t GatherChunkSize = 16;
+
     struct NodeEntry
     {
         ValueType           m_dvec_square_norm;
@@ -114,6 +141,9 @@ class Query
 
     const TreeType&         m_tree;
     AnswerType&             m_answer;
+
+    // Return the index of the first point of the leaf node containing a given point.
+    std::size_t find_leaf_point_index(const VectorType& point) const;
 };
 
 typedef Query<float, 2>  Query2f;
@@ -132,6 +162,74 @@ typedef Query<double, 3> Query3d;
 #define FOUNDATION_KNN_QUERY_STATS(x)
 #endif
 
+template <typename T, std::size_t N>
+inline void compute_square_distances(
+    const Vector<T, N>* APPLESEED_RESTRICT  points,
+    const std::size_t                       count,
+    const Vector<T, N>&                     query_point,
+    T* APPLESEED_RESTRICT                   square_dists)
+{
+    for (std::size_t i = 0; i < count; ++i)
+        square_dists[i] = square_distance(points[i], query_point);
+}
+
+#ifdef APPLESEED_USE_SSE
+
+template <>
+inline void compute_square_distances(
+    const Vector3f* APPLESEED_RESTRICT      points,
+    const std::size_t                       count,
+    const Vector3f&                         query_point,
+    float* APPLESEED_RESTRICT               square_dists)
+{
+    const __m128 qx = _mm_set1_ps(query_point[0]);
+    const __m128 qy = _mm_set1_ps(query_point[1]);
+    const __m128 qz = _mm_set1_ps(query_point[2]);
+
+    std::size_t i = 0;
+
+    // Process four points at a time: load them as three vectors
+    // (x0 y0 z0 x1) (y1 z1 x2 y2) (z2 x3 y3 z3) and transpose them.
+    for (; i + 4 <= count; i += 4)
+    {
+        const float* p = &points[i][0];
+        const __m128 m0 = _mm_loadu_ps(p);
+        const __m128 m1 = _mm_loadu_ps(p + 4);
+        const __m128 m2 = _mm_loadu_ps(p + 8);
+
+        const __m128 x =
+            _mm_shuffle_ps(
+                _mm_shuffle_ps(m0, m0, _MM_SHUFFLE(3, 3, 0, 0)),
+                _mm_shuffle_ps(m1, m2, _MM_SHUFFLE(1, 1, 2, 2)),
+                _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 y =
+            _mm_shuffle_ps(
+                _mm_shuffle_ps(m0, m1, _MM_SHUFFLE(0, 0, 0, 1)),
+                _mm_shuffle_ps(m1, m2, _MM_SHUFFLE(2, 2, 3, 3)),
+                _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 z =
+            _mm_shuffle_ps(
+                _mm_shuffle_ps(m0, m1, _MM_SHUFFLE(1, 1, 2, 2)),
+                _mm_shuffle_ps(m2, m2, _MM_SHUFFLE(3, 3, 0, 0)),
+                _MM_SHUFFLE(2, 0, 2, 0));
+
+        const __m128 dx = _mm_sub_ps(x, qx);
+        const __m128 dy = _mm_sub_ps(y, qy);
+        const __m128 dz = _mm_sub_ps(z, qz);
+
+        _mm_storeu_ps(
+            square_dists + i,
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                _mm_mul_ps(dz, dz)));
+    }
+
+    for (; i < count; ++i)
+        square_dists[i] = square_distance(points[i], query_point);
+}
+
+#endif  // APPLESEED_USE_SSE
+
 template <typename T, std::size_t N>
 inline Query<T, N>::Query(
     const TreeType&         tree,
@@ -240,61 +338,50 @@ inline void Query<T, N>::run(
     {
         FOUNDATION_KNN_QUERY_STATS(++visited_leaf_count);
 
-        std::size_t point_index = node->get_point_index();
-        const VectorType* APPLESEED_RESTRICT point_ptr = points + point_index;
-        const VectorType* APPLESEED_RESTRICT point_end = point_ptr + node->get_point_count();
+        const std::size_t point_begin = node->get_point_index();
+        const std::size_t point_end = point_begin + node->get_point_count();
 
-        // First, we fill up the answer like an array.
-        while (point_ptr < point_end)
+        for (std::size_t chunk_begin = point_begin; chunk_begin < point_end; chunk_begin += GatherChunkSize)
         {
-            FOUNDATION_KNN_QUERY_STATS(++tested_point_count);
+            const std::size_t chunk_size = std::min(GatherChunkSize, point_end - chunk_begin);
 
-            const ValueType square_dist = square_distance(*point_ptr++, query_point);
-
-            if (square_dist <= query_max_square_distance)
-            {
-                m_answer.array_insert(point_index, square_dist);
+            ValueType square_dists[GatherChunkSize];
+            compute_square_distances(points + chunk_begin, chunk_size, query_point, square_dists);
 
-                if (max_square_dist < square_dist)
-                    max_square_dist = square_dist;
-
-                ++point_index;
-
-                if (m_answer.m_size == max_answer_size)
-                    break;
-
-                continue;
-            }
+            FOUNDATION_KNN_QUERY_STATS(tested_point_count += chunk_size);
 
-            ++point_index;
-        }
-
-        if (m_answer.m_size == max_answer_size)
-        {
-            // The answer is full, so we transform it into a heap.
-            m_answer.make_heap();
-
-            // Then, we insert the remaining points into the answer.
-            while (point_ptr < point_end)
+            for (std::size_t i = 0; i < chunk_size; ++i)
             {
-                FOUNDATION_KNN_QUERY_STATS(++tested_point_count);
+                const std::size_t point_index = chunk_begin + i;
+                const ValueType square_dist = square_dists[i];
 
-                const ValueType square_dist = square_distance(*point_ptr++, query_point);
-
-                if (square_dist < max_square_dist)
+                if (m_answer.m_size < max_answer_size)
+                {
+                    // First, we fill up the answer like an array.
+                    if (square_dist <= query_max_square_distance)
+                    {
+                        m_answer.array_insert(point_index, square_dist);
+
+                        if (max_square_dist < square_dist)
+                            max_square_dist = square_dist;
+
+                        // Once the answer is full, we transform it into a heap.
+                        if (m_answer.m_size == max_answer_size)
+                            m_answer.make_heap();
+                    }
+                }
+                else if (square_dist < max_square_dist)
                 {
+                    // Then, we insert the remaining points into the answer.
                     m_answer.heap_insert(point_index, square_dist);
                     max_square_dist = m_answer.top().m_square_dist;
                 }
-
-                ++point_index;
             }
         }
-        else
-        {
-            // We ran out of points.
+
+        // If we ran out of points, the search distance remains the one requested.
+        if (m_answer.m_size < max_answer_size)
             max_square_dist = query_max_square_distance;
-        }
     }
 
     //
@@ -436,33 +523,40 @@ inline void Query<T, N>::run(
 
         FOUNDATION_KNN_QUERY_STATS(++visited_leaf_count);
 
-        std::size_t point_index = node->get_point_index();
-        const VectorType* APPLESEED_RESTRICT point_ptr = points + point_index;
-        const VectorType* APPLESEED_RESTRICT point_end = point_ptr + node->get_point_count();
+        const std::size_t point_begin = node->get_point_index();
+        const std::size_t point_end = point_begin + node->get_point_count();
 
-        while (point_ptr < point_end)
+        for (std::size_t chunk_begin = point_begin; chunk_begin < point_end; chunk_begin += GatherChunkSize)
         {
-            FOUNDATION_KNN_QUERY_STATS(++tested_point_count);
+            const std::size_t chunk_size = std::min(GatherChunkSize, point_end - chunk_begin);
+
+            ValueType square_dists[GatherChunkSize];
+            compute_square_distances(points + chunk_begin, chunk_size, query_point, square_dists);
 
-            const ValueType square_dist = square_distance(*point_ptr++, query_point);
+            FOUNDATION_KNN_QUERY_STATS(tested_point_count += chunk_size);
 
-            if (square_dist < max_square_dist)
+            for (std::size_t i = 0; i < chunk_size; ++i)
             {
-                if (m_answer.m_size == max_answer_size)
-                {
-                    m_answer.heap_insert(point_index, square_dist);
-                    max_square_dist = m_answer.top().m_square_dist;
-                }
-                else
+                const ValueType square_dist = square_dists[i];
+
+                if (square_dist < max_square_dist)
                 {
-                    m_answer.array_insert(point_index, square_dist);
+                    const std::size_t point_index = chunk_begin + i;
 
                     if (m_answer.m_size == max_answer_size)
-                        m_answer.make_heap();
+                    {
+                        m_answer.heap_insert(point_index, square_dist);
+                        max_square_dist = m_answer.top().m_square_dist;
+                    }
+                    else
+                    {
+                        m_answer.array_insert(point_index, square_dist);
+
+                        if (m_answer.m_size == max_answer_size)
+                            m_answer.make_heap();
+                    }
                 }
             }
-
-            ++point_index;
         }
     }
 
@@ -494,5 +588,49 @@ inline void Query<T, N>::run(
 
 #endif
 
+template <typename T, std::size_t N>
+template <typename Visitor>
+void Query<T, N>::run_batch(
+    const VectorType        query_points[],
+    const std::size_t       count,
+    const ValueType         query_max_square_distance,
+    Visitor&                visitor) const
+{
+    assert(!m_tree.empty());
+
+    // Sort queries by the first point of their leaf node. Points are stored in tree
+    // order, so consecutive queries touch the same nodes and points.
+    std::vector<std::pair<std::size_t, std::size_t>> order(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        order[i].first = find_leaf_point_index(query_points[i]);
+        order[i].second = i;
+    }
+    std::sort(order.begin(), order.end());
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const std::size_t query_index = order[i].second;
+        run(query_points[query_index], query_max_square_distance);
+        visitor(query_index, m_answer);
+    }
+}
+
+template <typename T, std::size_t N>
+inline std::size_t Query<T, N>::find_leaf_point_index(const VectorType& point) const
+{
+    const NodeType* APPLESEED_RESTRICT root_node = &m_tree.m_nodes.front();
+    const NodeType* APPLESEED_RESTRICT node = root_node;
+
+    while (node->is_interior())
+    {
+        // Points on the split plane belong to the right child node.
+        const ValueType split_dist = point[node->get_split_dim()] - node->get_split_abs();
+        node = root_node + node->get_child_node_index() + (split_dist >= ValueType(0.0) ? 1 : 0);
+    }
+
+    return node->get_point_index();
+}
+
 }   // namespace knn
 }   // namespace foundation
@@ -42,6 +42,8 @@
 DECLARE_TEST_CASE(Foundation_Math_Knn_Builder, Build_GivenZeroPoint_BuildsEmptyTree);
 DECLARE_TEST_CASE(Foundation_Math_Knn_Builder, Build_GivenTwoPoints_BuildsCorrectTree);
 DECLARE_TEST_CASE(Foundation_Math_Knn_Builder, Build_GivenEightPoints_GeneratesFifteenNodes);
+DECLARE_TEST_CASE(Foundation_Math_Knn_Builder, Build_GivenEightPointsAndMaxLeafSizeTwo_GeneratesSevenNodes);
+DECLARE_TEST_CASE(Foundation_Math_Knn_Builder, Build_UsingMultipleThreads_BuildsSameTreeAsSingleThread);
 
 namespace foundation {
 namespace knn {
@@ -77,6 +79,8 @@ class Tree
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Math_Knn_Builder, Build_GivenZeroPoint_BuildsEmptyTree);
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Math_Knn_Builder, Build_GivenTwoPoints_BuildsCorrectTree);
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Math_Knn_Builder, Build_GivenEightPoints_GeneratesFifteenNodes);
+    GRANT_ACCESS_TO_TEST_CASE(Foundation_Math_Knn_Builder, Build_GivenEightPointsAndMaxLeafSizeTwo_GeneratesSevenNodes);
+    GRANT_ACCESS_TO_TEST_CASE(Foundation_Math_Knn_Builder, Build_UsingMultipleThreads_BuildsSameTreeAsSingleThread);
 
     std::vector<VectorType> m_points;
     std::vector<size_t>     m_indices;
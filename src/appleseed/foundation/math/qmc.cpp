@@ -297,4 +297,46 @@ const double PrecomputedHaltonSequence[4 * PrecomputedHaltonSequenceSize] =
     0.9960937500000000, 0.1495198902606310, 0.0432000000000000, 0.4635568513119533
 };
 
+
+//
+// Bit-reversed generator matrices of the first four dimensions of the Sobol sequence.
+// Row i holds, for each dimension, the bit-reversed direction number of bit i.
+//
+
+const std::uint32_t ReversedSobolMatrices[32][SobolMatrixDimensionCount] =
+{
+    { 0x00000001u, 0x00000001u, 0x00000001u, 0x00000001u },
+    { 0x00000002u, 0x00000003u, 0x00000003u, 0x00000003u },
+    { 0x00000004u, 0x00000005u, 0x00000006u, 0x00000004u },
+    { 0x00000008u, 0x0000000Fu, 0x00000009u, 0x0000000Au },
+    { 0x00000010u, 0x00000011u, 0x00000017u, 0x0000001Fu },
+    { 0x00000020u, 0x00000033u, 0x0000003Au, 0x0000002Eu },
+    { 0x00000040u, 0x00000055u, 0x00000071u, 0x00000045u },
+    { 0x00000080u, 0x000000FFu, 0x000000A3u, 0x000000C9u },
+    { 0x00000100u, 0x00000101u, 0x00000116u, 0x0000011Bu },
+    { 0x00000200u, 0x00000303u, 0x00000339u, 0x000002A4u },
+    { 0x00000400u, 0x00000505u, 0x00000677u, 0x0000079Au },
+    { 0x00000800u, 0x00000F0Fu, 0x000009AAu, 0x00000B67u },
+    { 0x00001000u, 0x00001111u, 0x00001601u, 0x0000101Eu },
+    { 0x00002000u, 0x00003333u, 0x00003903u, 0x0000302Du },
+    { 0x00004000u, 0x00005555u, 0x00007706u, 0x00004041u },
+    { 0x00008000u, 0x0000FFFFu, 0x0000AA09u, 0x0000A0C3u },
+    { 0x00010000u, 0x00010001u, 0x00010117u, 0x0001F104u },
+    { 0x00020000u, 0x00030003u, 0x0003033Au, 0x0002E28Au },
+    { 0x00040000u, 0x00050005u, 0x00060671u, 0x000457DFu },
+    { 0x00080000u, 0x000F000Fu, 0x000909A3u, 0x000C9BAEu },
+    { 0x00100000u, 0x00110011u, 0x00171616u, 0x0011A105u },
+    { 0x00200000u, 0x00330033u, 0x003A3939u, 0x002A7289u },
+    { 0x00400000u, 0x00550055u, 0x00717777u, 0x0079E7DBu },
+    { 0x00800000u, 0x00FF00FFu, 0x00A3AAAAu, 0x00B6DBA4u },
+    { 0x01000000u, 0x01010101u, 0x01170001u, 0x0100011Au },
+    { 0x02000000u, 0x03030303u, 0x033A0003u, 0x030002A7u },
+    { 0x04000000u, 0x05050505u, 0x06710006u, 0x0400079Eu },
+    { 0x08000000u, 0x0F0F0F0Fu, 0x09A30009u, 0x0A000B6Du },
+    { 0x10000000u, 0x11111111u, 0x16160017u, 0x1F001001u },
+    { 0x20000000u, 0x33333333u, 0x3939003Au, 0x2E003003u },
+    { 0x40000000u, 0x55555555u, 0x77770071u, 0x45004004u },
+    { 0x80000000u, 0xFFFFFFFFu, 0xAAAA00A3u, 0xC900A00Au }
+};
+
 }   // namespace foundation
@@ -30,9 +30,13 @@
 #pragma once
 
 // appleseed.foundation headers.
+#include "foundation/hash/hash.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/arch.h"
+#ifdef APPLESEED_USE_SSE42
+#include "foundation/platform/sse.h"
+#endif
 
 // Standard headers.
 #include <cassert>
@@ -47,13 +51,13 @@ namespace foundation
 //
 //   http://www-stat.stanford.edu/~owen/reports/siggraph03.pdf
 //   https://lirias.kuleuven.be/bitstream/123456789/131168/1/mcm2005_bartv.pdf
+//   http://www.jcgt.org/published/0009/04/01/
 //
 // todo:
 //
 //   implement specializations of Halton and Hammersley sequences generators for bases (2,3).
 //   implement incremental radical inverse (for successive input values).
 //   implement vectorized radical inverse functions with SSE2.
-//   implement Sobol sequence generator.
 //
 
 
@@ -200,6 +204,53 @@ Vector<T, Dim> hammersley_zaremba_sequence(
     const size_t        i);             // sample number
 
 
+//
+// Owen-scrambled Sobol sequence.
+//
+// Generator matrices for the first four dimensions of the Sobol sequence
+// (Joe-Kuo direction numbers) are precomputed with their bits reversed:
+// this way, nested uniform scrambling can be applied with a Laine-Karras
+// style hash directly on the output of the matrix multiplication, sparing
+// one bit reversal per dimension.
+//
+// Reference:
+//
+//   Brent Burley, Practical Hash-based Owen Scrambling
+//   http://www.jcgt.org/published/0009/04/01/
+//
+
+const size_t SobolMatrixDimensionCount = 4;
+extern const std::uint32_t ReversedSobolMatrices[32][SobolMatrixDimensionCount];
+
+// Reverse the order of the bits of a 32-bit integer.
+std::uint32_t reverse_bits_uint32(
+    std::uint32_t       value);
+
+// Return the i'th sample of a given dimension of the (unscrambled) Sobol sequence, as a 32-bit fixed point number.
+std::uint32_t sobol_uint32(
+    const size_t        dimension,      // dimension, in [0, SobolMatrixDimensionCount)
+    std::uint32_t       i);             // sample number
+
+// Laine-Karras style hash-based permutation. Operates on bit-reversed values.
+std::uint32_t laine_karras_permutation(
+    std::uint32_t       value,
+    const std::uint32_t seed);
+
+// Nested uniform scrambling (Owen scrambling) in base 2.
+std::uint32_t nested_uniform_scramble_base2(
+    std::uint32_t       value,
+    const std::uint32_t seed);
+
+// Return the i'th sample of the 4D Owen-scrambled Sobol sequence.
+// The order of the samples is shuffled, and each dimension is scrambled
+// independently, based on `seed`. All four dimensions are produced at once,
+// with SSE when available. Return values are in [0, 1)^4, 24 bits of precision.
+void sobol_owen_scrambled_sample4(
+    std::uint32_t       i,              // sample number
+    const std::uint32_t seed,           // scrambling seed
+    float               result[4]);
+
+
 //
 // Base-2 radical inverse functions implementation.
 //
@@ -2610,4 +2661,149 @@ inline Vector<T, Dim> hammersley_zaremba_sequence(
     return p;
 }
 
+
+
+//
+// Owen-scrambled Sobol sequence implementation.
+//
+
+inline std::uint32_t reverse_bits_uint32(
+    std::uint32_t       value)
+{
+    value = (value >> 16) | (value << 16);                                                      // 16-bit swap
+    value = ((value & 0xFF00FF00u) >> 8) | ((value & 0x00FF00FFu) << 8);                        // 8-bit swap
+    value = ((value & 0xF0F0F0F0u) >> 4) | ((value & 0x0F0F0F0Fu) << 4);                        // 4-bit swap
+    value = ((value & 0xCCCCCCCCu) >> 2) | ((value & 0x33333333u) << 2);                        // 2-bit swap
+    value = ((value & 0xAAAAAAAAu) >> 1) | ((value & 0x55555555u) << 1);                        // 1-bit swap
+    return value;
+}
+
+inline std::uint32_t sobol_uint32(
+    const size_t        dimension,
+    std::uint32_t       i)
+{
+    assert(dimension < SobolMatrixDimensionCount);
+
+    std::uint32_t result = 0;
+
+    for (size_t bit = 0; i != 0; i >>= 1, ++bit)
+    {
+        if (i & 1)
+            result ^= ReversedSobolMatrices[bit][dimension];
+    }
+
+    return reverse_bits_uint32(result);
+}
+
+inline std::uint32_t laine_karras_permutation(
+    std::uint32_t       value,
+    const std::uint32_t seed)
+{
+    value += seed;
+    value ^= value * 0x6C50B47Cu;
+    value ^= value * 0xB82F1E52u;
+    value ^= value * 0xC7AFE638u;
+    value ^= value * 0x8D22F6E6u;
+    return value;
+}
+
+inline std::uint32_t nested_uniform_scramble_base2(
+    std::uint32_t       value,
+    const std::uint32_t seed)
+{
+    value = reverse_bits_uint32(value);
+    value = laine_karras_permutation(value, seed);
+    return reverse_bits_uint32(value);
+}
+
+#ifdef APPLESEED_USE_SSE42
+
+inline void sobol_owen_scrambled_sample4(
+    std::uint32_t       i,
+    const std::uint32_t seed,
+    float               result[4])
+{
+    // Shuffle the order of the samples.
+    i = nested_uniform_scramble_base2(i, seed);
+
+    // Compute one scrambling seed per dimension: vectorized hash_uint32(seed + d).
+    __m128i seeds = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(seed)), _mm_setr_epi32(0, 1, 2, 3));
+    seeds = _mm_xor_si128(seeds, _mm_srli_epi32(seeds, 17));
+    seeds = _mm_xor_si128(seeds, _mm_srli_epi32(seeds, 10));
+    seeds = _mm_mullo_epi32(seeds, _mm_set1_epi32(static_cast<int>(0xB36534E5u)));
+    seeds = _mm_xor_si128(seeds, _mm_srli_epi32(seeds, 12));
+    seeds = _mm_xor_si128(seeds, _mm_srli_epi32(seeds, 21));
+    seeds = _mm_mullo_epi32(seeds, _mm_set1_epi32(static_cast<int>(0x93FC4795u)));
+    seeds = _mm_xor_si128(seeds, _mm_set1_epi32(static_cast<int>(0xDF6E307Fu)));
+    seeds = _mm_xor_si128(seeds, _mm_srli_epi32(seeds, 17));
+
+    // Multiply the bit-reversed generator matrices of the four dimensions at once.
+    __m128i x = _mm_setzero_si128();
+    for (size_t bit = 0; i != 0; i >>= 1, ++bit)
+    {
+        if (i & 1)
+        {
+            x = _mm_xor_si128(
+                x,
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(ReversedSobolMatrices[bit])));
+        }
+    }
+
+    // Laine-Karras permutation.
+    x = _mm_add_epi32(x, seeds);
+    x = _mm_xor_si128(x, _mm_mullo_epi32(x, _mm_set1_epi32(static_cast<int>(0x6C50B47Cu))));
+    x = _mm_xor_si128(x, _mm_mullo_epi32(x, _mm_set1_epi32(static_cast<int>(0xB82F1E52u))));
+    x = _mm_xor_si128(x, _mm_mullo_epi32(x, _mm_set1_epi32(static_cast<int>(0xC7AFE638u))));
+    x = _mm_xor_si128(x, _mm_mullo_epi32(x, _mm_set1_epi32(static_cast<int>(0x8D22F6E6u))));
+
+    // Reverse the bits: reverse the bytes of each lane, then the bits of each byte using nibble lookups.
+    x = _mm_shuffle_epi8(x, _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+    const __m128i nibble_mask = _mm_set1_epi8(0x0F);
+    const __m128i reversed_nibbles =
+        _mm_setr_epi8(0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF);
+    const __m128i lo = _mm_shuffle_epi8(reversed_nibbles, _mm_and_si128(x, nibble_mask));
+    const __m128i hi = _mm_shuffle_epi8(reversed_nibbles, _mm_and_si128(_mm_srli_epi16(x, 4), nibble_mask));
+    x = _mm_or_si128(_mm_slli_epi16(lo, 4), hi);
+
+    // Keep 24 bits such that the conversion to single precision is exact and the result is strictly less than 1.
+    _mm_storeu_ps(
+        result,
+        _mm_mul_ps(
+            _mm_cvtepi32_ps(_mm_srli_epi32(x, 8)),
+            _mm_set1_ps(1.0f / 16777216.0f)));
+}
+
+#else
+
+inline void sobol_owen_scrambled_sample4(
+    std::uint32_t       i,
+    const std::uint32_t seed,
+    float               result[4])
+{
+    // Shuffle the order of the samples.
+    i = nested_uniform_scramble_base2(i, seed);
+
+    // Multiply the bit-reversed generator matrices of the four dimensions at once.
+    std::uint32_t x[4] = { 0, 0, 0, 0 };
+    for (size_t bit = 0; i != 0; i >>= 1, ++bit)
+    {
+        if (i & 1)
+        {
+            for (size_t d = 0; d < 4; ++d)
+                x[d] ^= ReversedSobolMatrices[bit][d];
+        }
+    }
+
+    for (size_t d = 0; d < 4; ++d)
+    {
+        const std::uint32_t dimension_seed = hash_uint32(seed + static_cast<std::uint32_t>(d));
+        const std::uint32_t value = reverse_bits_uint32(laine_karras_permutation(x[d], dimension_seed));
+
+        // Keep 24 bits such that the conversion to single precision is exact and the result is strictly less than 1.
+        result[d] = static_cast<float>(value >> 8) * (1.0f / 16777216.0f);
+    }
+}
+
+#endif
+
 }   // namespace foundation
@@ -0,0 +1,235 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#ifdef APPLESEED_USE_AVX2
+#include "foundation/platform/sse.h"
+#endif
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+
+namespace foundation
+{
+
+//
+// Width independent PCG random number generators advanced in lockstep.
+//
+// Stream i produces the same sequence as PCG(init_state, first_stream + i), so
+// that per-pixel streams can be partitioned by stream index. Batches of Width
+// numbers are generated with AVX2 when it is enabled.
+//
+// Reference:
+//
+//   http://www.pcg-random.org/
+//
+
+template <std::size_t Width>
+class WidePCG
+{
+  public:
+    static_assert(Width > 0 && Width % 4 == 0, "WidePCG requires a multiple of 4 streams");
+
+    // Number of streams.
+    static const std::size_t StreamCount = Width;
+
+    // Constructor, seeds the generators.
+    WidePCG(
+        const std::uint64_t init_state = 0x853C49E6748FEA9Bull,
+        const std::uint64_t first_stream = 0xDA3E39CB94B95BDBull);
+
+    // Generate one 32-bit random number per stream.
+    void rand_uint32(std::uint32_t values[Width]);
+
+    // Generate a 32-bit random number, taking turns between streams.
+    std::uint32_t rand_uint32();
+
+    // Advance all streams by a given number of steps in O(log(delta)) time.
+    // Numbers generated but not yet returned by rand_uint32() are discarded.
+    void advance(std::uint64_t delta);
+
+  private:
+    static const std::uint64_t Multiplier = 6364136223846793005ull;
+
+    std::uint64_t                           m_state[Width];     // current state of the generators
+    std::uint64_t                           m_inc[Width];       // stream selectors -- must *always* be odd
+    std::uint32_t                           m_buffer[Width];
+    std::size_t                             m_buffer_index;
+
+    static std::uint32_t step(std::uint64_t& state, const std::uint64_t inc);
+};
+
+
+//
+// WidePCG class implementation.
+//
+
+template <std::size_t Width>
+const std::size_t WidePCG<Width>::StreamCount;
+
+template <std::size_t Width>
+const std::uint64_t WidePCG<Width>::Multiplier;
+
+template <std::size_t Width>
+WidePCG<Width>::WidePCG(const std::uint64_t init_state, const std::uint64_t first_stream)
+  : m_buffer_index(Width)
+{
+    for (std::size_t i = 0; i < Width; ++i)
+    {
+        m_state[i] = 0;
+        m_inc[i] = ((first_stream + i) << 1) | 1;
+        step(m_state[i], m_inc[i]);
+
+        m_state[i] += init_state;
+        step(m_state[i], m_inc[i]);
+    }
+}
+
+template <std::size_t Width>
+inline void WidePCG<Width>::rand_uint32(std::uint32_t values[Width])
+{
+#ifdef APPLESEED_USE_AVX2
+
+    const __m256i mul_lo = _mm256_set1_epi64x(static_cast<long long>(Multiplier & 0xFFFFFFFFull));
+    const __m256i mul_hi = _mm256_set1_epi64x(static_cast<long long>(Multiplier >> 32));
+    const __m256i low_mask = _mm256_set1_epi64x(0xFFFFFFFFll);
+    const __m256i thirty_two = _mm256_set1_epi64x(32);
+    const __m256i pack = _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0);
+
+    for (std::size_t i = 0; i < Width; i += 4)
+    {
+        const __m256i old_state = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_state + i));
+        const __m256i inc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_inc + i));
+
+        // Low 64 bits of old_state * Multiplier, from three 32x32 -> 64-bit products.
+        const __m256i cross =
+            _mm256_add_epi64(
+                _mm256_mul_epu32(_mm256_srli_epi64(old_state, 32), mul_lo),
+                _mm256_mul_epu32(old_state, mul_hi));
+        const __m256i product =
+            _mm256_add_epi64(
+                _mm256_mul_epu32(old_state, mul_lo),
+                _mm256_slli_epi64(cross, 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(m_state + i), _mm256_add_epi64(product, inc));
+
+        const __m256i xorshifted =
+            _mm256_and_si256(
+                _mm256_srli_epi64(_mm256_xor_si256(_mm256_srli_epi64(old_state, 18), old_state), 27),
+                low_mask);
+        const __m256i rot = _mm256_srli_epi64(old_state, 59);
+        const __m256i result =
+            _mm256_and_si256(
+                _mm256_or_si256(
+                    _mm256_srlv_epi64(xorshifted, rot),
+                    _mm256_sllv_epi64(xorshifted, _mm256_sub_epi64(thirty_two, rot))),
+                low_mask);
+
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(values + i),
+            _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(result, pack)));
+    }
+
+#else
+
+    for (std::size_t i = 0; i < Width; ++i)
+        values[i] = step(m_state[i], m_inc[i]);
+
+#endif
+}
+
+template <std::size_t Width>
+inline std::uint32_t WidePCG<Width>::rand_uint32()
+{
+    if (m_buffer_index == Width)
+    {
+        rand_uint32(m_buffer);
+        m_buffer_index = 0;
+    }
+
+    return m_buffer[m_buffer_index++];
+}
+
+template <std::size_t Width>
+void WidePCG<Width>::advance(std::uint64_t delta)
+{
+    // Compose the LCG step with itself by repeated squaring.
+    // Reference: F. Brown, Random Number Generation with Arbitrary Stride.
+    std::uint64_t cur_mult = Multiplier;
+    std::uint64_t acc_mult = 1;
+    std::uint64_t cur_plus[Width];
+    std::uint64_t acc_plus[Width];
+
+    for (std::size_t i = 0; i < Width; ++i)
+    {
+        cur_plus[i] = m_inc[i];
+        acc_plus[i] = 0;
+    }
+
+    while (delta > 0)
+    {
+        if (delta & 1)
+        {
+            acc_mult *= cur_mult;
+
+            for (std::size_t i = 0; i < Width; ++i)
+                acc_plus[i] = acc_plus[i] * cur_mult + cur_plus[i];
+        }
+
+        for (std::size_t i = 0; i < Width; ++i)
+            cur_plus[i] = (cur_mult + 1) * cur_plus[i];
+
+        cur_mult *= cur_mult;
+        delta >>= 1;
+    }
+
+    for (std::size_t i = 0; i < Width; ++i)
+        m_state[i] = acc_mult * m_state[i] + acc_plus[i];
+
+    m_buffer_index = Width;
+}
+
+#pragma warning (push)
+#pragma warning (disable : 4146)    // unary minus operator applied to unsigned type, result still unsigned
+
+template <std::size_t Width>
+inline std::uint32_t WidePCG<Width>::step(std::uint64_t& state, const std::uint64_t inc)
+{
+    const std::uint64_t old_state = state;
+    state = old_state * Multiplier + inc;
+
+    const std::uint32_t xorshifted = static_cast<std::uint32_t>(((old_state >> 18) ^ old_state) >> 27);
+    const std::uint32_t rot = static_cast<std::uint32_t>(old_state >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+#pragma warning (pop)
+
+}   // namespace foundation
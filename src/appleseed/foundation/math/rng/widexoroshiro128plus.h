@@ -0,0 +1,235 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#ifdef APPLESEED_USE_AVX2
+#include "foundation/platform/sse.h"
+#endif
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace foundation
+{
+
+//
+// Width Xoroshiro128+ random number generators advanced in lockstep.
+//
+// Stream 0 produces the same sequence as Xoroshiro128plus(s0, s1), and stream i
+// starts 2^64 steps after stream i - 1 so that streams never overlap. Batches of
+// Width numbers are generated with AVX2 when it is enabled.
+//
+// Reference:
+//
+//   http://xoroshiro.di.unimi.it/
+//
+
+template <std::size_t Width>
+class WideXoroshiro128plus
+{
+  public:
+    static_assert(Width > 0 && Width % 4 == 0, "WideXoroshiro128plus requires a multiple of 4 streams");
+
+    // Number of streams.
+    static const std::size_t StreamCount = Width;
+
+    // Constructors, seed the generators.
+    // The seed must not be zero everywhere.
+    WideXoroshiro128plus();
+    WideXoroshiro128plus(const std::uint64_t s0, const std::uint64_t s1);
+
+    // Generate one 32-bit random number per stream.
+    void rand_uint32(std::uint32_t values[Width]);
+
+    // Generate a 32-bit random number, taking turns between streams.
+    std::uint32_t rand_uint32();
+
+    // Advance all streams by Width * 2^64 steps, i.e. move to the next set of
+    // non-overlapping streams. Use it to hand out disjoint streams to threads.
+    // Numbers generated but not yet returned by rand_uint32() are discarded.
+    void jump();
+
+  private:
+    std::uint64_t                           m_s0[Width];
+    std::uint64_t                           m_s1[Width];
+    std::uint32_t                           m_buffer[Width];
+    std::size_t                             m_buffer_index;
+
+    void init(const std::uint64_t s0, const std::uint64_t s1);
+
+    static std::uint32_t step(std::uint64_t& s0, std::uint64_t& s1);
+
+    // Advance a single generator by 2^64 steps.
+    static void jump(std::uint64_t& s0, std::uint64_t& s1);
+};
+
+
+//
+// WideXoroshiro128plus class implementation.
+//
+
+template <std::size_t Width>
+const std::size_t WideXoroshiro128plus<Width>::StreamCount;
+
+template <std::size_t Width>
+WideXoroshiro128plus<Width>::WideXoroshiro128plus()
+{
+    init(0x46961B5E381BCE6Eull, 0x55897310023CAE21ull);
+}
+
+template <std::size_t Width>
+WideXoroshiro128plus<Width>::WideXoroshiro128plus(const std::uint64_t s0, const std::uint64_t s1)
+{
+    assert(s0 != 0 || s1 != 0);     // if the seed is 0 everywhere, all output values will be 0
+    init(s0, s1);
+}
+
+template <std::size_t Width>
+inline void WideXoroshiro128plus<Width>::rand_uint32(std::uint32_t values[Width])
+{
+#ifdef APPLESEED_USE_AVX2
+
+    const __m256i pack = _mm256_setr_epi32(1, 3, 5, 7, 0, 0, 0, 0);
+
+    for (std::size_t i = 0; i < Width; i += 4)
+    {
+        const __m256i s0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_s0 + i));
+        __m256i s1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_s1 + i));
+
+        const __m256i result = _mm256_add_epi64(s0, s1);
+
+        s1 = _mm256_xor_si256(s1, s0);
+
+        // s0 = rotl64(s0, 55) ^ s1 ^ (s1 << 14), s1 = rotl64(s1, 36).
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(m_s0 + i),
+            _mm256_xor_si256(
+                _mm256_or_si256(_mm256_slli_epi64(s0, 55), _mm256_srli_epi64(s0, 9)),
+                _mm256_xor_si256(s1, _mm256_slli_epi64(s1, 14))));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(m_s1 + i),
+            _mm256_or_si256(_mm256_slli_epi64(s1, 36), _mm256_srli_epi64(s1, 28)));
+
+        // Keep the high 32 bits of each result.
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(values + i),
+            _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(result, pack)));
+    }
+
+#else
+
+    for (std::size_t i = 0; i < Width; ++i)
+        values[i] = step(m_s0[i], m_s1[i]);
+
+#endif
+}
+
+template <std::size_t Width>
+inline std::uint32_t WideXoroshiro128plus<Width>::rand_uint32()
+{
+    if (m_buffer_index == Width)
+    {
+        rand_uint32(m_buffer);
+        m_buffer_index = 0;
+    }
+
+    return m_buffer[m_buffer_index++];
+}
+
+template <std::size_t Width>
+void WideXoroshiro128plus<Width>::jump()
+{
+    for (std::size_t i = 0; i < Width; ++i)
+    {
+        for (std::size_t j = 0; j < Width; ++j)
+            jump(m_s0[i], m_s1[i]);
+    }
+
+    m_buffer_index = Width;
+}
+
+template <std::size_t Width>
+void WideXoroshiro128plus<Width>::init(const std::uint64_t s0, const std::uint64_t s1)
+{
+    m_s0[0] = s0;
+    m_s1[0] = s1;
+
+    for (std::size_t i = 1; i < Width; ++i)
+    {
+        m_s0[i] = m_s0[i - 1];
+        m_s1[i] = m_s1[i - 1];
+        jump(m_s0[i], m_s1[i]);
+    }
+
+    m_buffer_index = Width;
+}
+
+template <std::size_t Width>
+inline std::uint32_t WideXoroshiro128plus<Width>::step(std::uint64_t& s0, std::uint64_t& s1)
+{
+    const std::uint64_t result = s0 + s1;
+
+    s1 ^= s0;
+    s0 = rotl64(s0, 55) ^ s1 ^ (s1 << 14);     // a, b
+    s1 = rotl64(s1, 36);                        // c
+
+    return static_cast<std::uint32_t>(result >> 32);
+}
+
+template <std::size_t Width>
+void WideXoroshiro128plus<Width>::jump(std::uint64_t& s0, std::uint64_t& s1)
+{
+    static const std::uint64_t Jump[] = { 0xBEAC0467EBA5FACBull, 0xD86B048B86AA9922ull };
+
+    std::uint64_t j0 = 0;
+    std::uint64_t j1 = 0;
+
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        for (std::size_t b = 0; b < 64; ++b)
+        {
+            if (Jump[i] & (std::uint64_t(1) << b))
+            {
+                j0 ^= s0;
+                j1 ^= s1;
+            }
+
+            step(s0, s1);
+        }
+    }
+
+    s0 = j0;
+    s1 = j1;
+}
+
+}   // namespace foundation
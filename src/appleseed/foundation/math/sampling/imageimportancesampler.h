@@ -35,15 +35,21 @@
 #include "foundation/image/color.h"
 #include "foundation/image/colorspace.h"
 #include "foundation/image/image.h"
-#include "foundation/math/cdf.h"
+#include "foundation/log/logger.h"
+#include "foundation/math/aliastable.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 #include "foundation/utility/job/iabortswitch.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <utility>
+#include <vector>
 
 namespace foundation
 {
@@ -61,6 +67,8 @@ namespace foundation
 //           Importance&    importance);
 //   };
 //
+// Rows and pixels within rows are selected with alias tables, in constant time.
+//
 
 template <typename Payload, typename Importance>
 class ImageImportanceSampler
@@ -77,12 +85,20 @@ class ImageImportanceSampler
     // Destructor.
     ~ImageImportanceSampler();
 
-    // Resample the image and rebuild the CDFs.
+    // Resample the image and rebuild the sampling tables.
     template <typename ImageSampler>
     void rebuild(
         ImageSampler&       sampler,
         IAbortSwitch*       abort_switch = nullptr);
 
+    // Resample the image and rebuild the sampling tables using one thread per sampler.
+    // Each sampler is only ever used by a single thread. The result is identical to
+    // the one of the single-threaded rebuild.
+    template <typename ImageSampler>
+    void parallel_rebuild(
+        const std::vector<ImageSampler*>&   samplers,
+        IAbortSwitch*                       abort_switch = nullptr);
+
     // Sample the image and return the coordinates of the chosen pixel
     // and its probability density.
     void sample(
@@ -100,14 +116,26 @@ class ImageImportanceSampler
         Payload&            payload,
         Importance&         probability) const;
 
+    // Same as above but also return a new uniform sample in [0,1)^2 that is
+    // independent of the chosen pixel, e.g. to jitter the position within it.
+    void sample(
+        const Vector2Type&  s,
+        size_t&             x,
+        size_t&             y,
+        Payload&            payload,
+        Importance&         probability,
+        Vector2Type&        residual) const;
+
     // Return the probability density of a given pixel.
     Importance get_pdf(
         const size_t        x,
         const size_t        y) const;
 
   private:
-    typedef CDF<size_t, Importance> RowCDF;
-    typedef CDF<Payload, Importance> ColCDF;
+    template <typename ImageSampler> class BuildRowsJob;
+
+    typedef AliasTable<size_t, Importance> RowCDF;
+    typedef AliasTable<Payload, Importance> ColCDF;
 
     const size_t            m_width;
     const size_t            m_height;
@@ -115,6 +143,15 @@ class ImageImportanceSampler
 
     ColCDF*                 m_cols_cdf;
     RowCDF                  m_rows_cdf;
+
+    template <typename ImageSampler>
+    void build_rows(
+        ImageSampler&       sampler,
+        const size_t        begin,
+        const size_t        end,
+        IAbortSwitch*       abort_switch);
+
+    void build_row_table(IAbortSwitch* abort_switch);
 };
 
 
@@ -140,6 +177,40 @@ class ImageSampler
 // ImageImportanceSampler class implementation.
 //
 
+template <typename Payload, typename Importance>
+template <typename ImageSampler>
+class ImageImportanceSampler<Payload, Importance>::BuildRowsJob
+  : public IJob
+{
+  public:
+    BuildRowsJob(
+        ImageImportanceSampler&             owner,
+        const std::vector<ImageSampler*>&   samplers,
+        const size_t                        begin,
+        const size_t                        end,
+        IAbortSwitch*                       abort_switch)
+      : m_owner(owner)
+      , m_samplers(samplers)
+      , m_begin(begin)
+      , m_end(end)
+      , m_abort_switch(abort_switch)
+    {
+    }
+
+    void execute(const size_t thread_index) override
+    {
+        assert(thread_index < m_samplers.size());
+        m_owner.build_rows(*m_samplers[thread_index], m_begin, m_end, m_abort_switch);
+    }
+
+  private:
+    ImageImportanceSampler&                 m_owner;
+    const std::vector<ImageSampler*>&       m_samplers;
+    const size_t                            m_begin;
+    const size_t                            m_end;
+    IAbortSwitch*                           m_abort_switch;
+};
+
 template <typename Payload, typename Importance>
 ImageImportanceSampler<Payload, Importance>::ImageImportanceSampler(
     const size_t            width,
@@ -163,16 +234,61 @@ void ImageImportanceSampler<Payload, Importance>::rebuild(
     ImageSampler&           sampler,
     IAbortSwitch*           abort_switch)
 {
-    m_rows_cdf.clear();
-    m_rows_cdf.reserve(m_height);
+    build_rows(sampler, 0, m_height, abort_switch);
+    build_row_table(abort_switch);
+}
 
-    for (size_t y = 0, ye = m_height; y < ye; ++y)
+template <typename Payload, typename Importance>
+template <typename ImageSampler>
+void ImageImportanceSampler<Payload, Importance>::parallel_rebuild(
+    const std::vector<ImageSampler*>&   samplers,
+    IAbortSwitch*                       abort_switch)
+{
+    assert(!samplers.empty());
+
+    if (samplers.size() == 1)
+    {
+        rebuild(*samplers[0], abort_switch);
+        return;
+    }
+
+    // Split the image into bands of rows, several per thread to balance the load.
+    const size_t band_count = std::min(samplers.size() * 4, m_height);
+    const size_t band_height = (m_height + band_count - 1) / band_count;
+
+    Logger logger;
+    JobQueue job_queue;
+    JobManager job_manager(logger, job_queue, samplers.size());
+
+    for (size_t begin = 0; begin < m_height; begin += band_height)
+    {
+        job_queue.schedule(
+            new BuildRowsJob<ImageSampler>(
+                *this,
+                samplers,
+                begin,
+                std::min(begin + band_height, m_height),
+                abort_switch));
+    }
+
+    job_manager.start();
+    job_queue.wait_until_completion();
+
+    build_row_table(abort_switch);
+}
+
+template <typename Payload, typename Importance>
+template <typename ImageSampler>
+void ImageImportanceSampler<Payload, Importance>::build_rows(
+    ImageSampler&           sampler,
+    const size_t            begin,
+    const size_t            end,
+    IAbortSwitch*           abort_switch)
+{
+    for (size_t y = begin; y < end; ++y)
     {
         if (is_aborted(abort_switch))
-        {
-            m_rows_cdf.clear();
             break;
-        }
 
         m_cols_cdf[y].clear();
         m_cols_cdf[y].reserve(m_width);
@@ -189,9 +305,21 @@ void ImageImportanceSampler<Payload, Importance>::rebuild(
 
         if (m_cols_cdf[y].valid())
             m_cols_cdf[y].prepare();
+    }
+}
+
+template <typename Payload, typename Importance>
+void ImageImportanceSampler<Payload, Importance>::build_row_table(IAbortSwitch* abort_switch)
+{
+    m_rows_cdf.clear();
+
+    if (is_aborted(abort_switch))
+        return;
+
+    m_rows_cdf.reserve(m_height);
 
+    for (size_t y = 0, ye = m_height; y < ye; ++y)
         m_rows_cdf.insert(y, m_cols_cdf[y].weight());
-    }
 
     if (m_rows_cdf.valid())
         m_rows_cdf.prepare();
@@ -266,6 +394,46 @@ inline void ImageImportanceSampler<Payload, Importance>::sample(
     assert(probability > Importance(0.0));
 }
 
+template <typename Payload, typename Importance>
+inline void ImageImportanceSampler<Payload, Importance>::sample(
+    const Vector2Type&      s,
+    size_t&                 x,
+    size_t&                 y,
+    Payload&                payload,
+    Importance&             probability,
+    Vector2Type&            residual) const
+{
+    if (m_rows_cdf.valid())
+    {
+        // Select a row.
+        const typename RowCDF::ItemWeightPair& row = m_rows_cdf.sample(s[1], residual[1]);
+        assert(row.second != Importance(0.0));
+        y = row.first;
+
+        // Select a column within this row.
+        const typename ColCDF::ItemWeightPair& col = m_cols_cdf[y].sample(s[0], residual[0]);
+        assert(col.second != Importance(0.0));
+        x = &col - &m_cols_cdf[y][0];
+
+        payload = col.first;
+        probability = row.second * col.second;
+    }
+    else
+    {
+        // Uniform random sampling.
+        x = truncate<size_t>(s[0] * m_width);
+        y = truncate<size_t>(s[1] * m_height);
+
+        payload = m_cols_cdf[y][x].first;
+        probability = m_rcp_pixel_count;
+
+        residual[0] = frac(s[0] * m_width);
+        residual[1] = frac(s[1] * m_height);
+    }
+
+    assert(probability > Importance(0.0));
+}
+
 template <typename Payload, typename Importance>
 inline Importance ImageImportanceSampler<Payload, Importance>::get_pdf(
     const size_t            x,
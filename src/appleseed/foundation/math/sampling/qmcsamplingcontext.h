@@ -30,6 +30,7 @@
 #pragma once
 
 // appleseed.foundation headers.
+#include "foundation/hash/hash.h"
 #include "foundation/math/permutation.h"
 #include "foundation/math/primes.h"
 #include "foundation/math/qmc.h"
@@ -40,6 +41,7 @@
 // Standard headers.
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 
 // Unit test case declarations.
 DECLARE_TEST_CASE(Foundation_Math_Sampling_QMCSamplingContext, InitialStateIsCorrect);
@@ -59,11 +61,19 @@ namespace foundation
 //   - Cranley-Patterson rotation
 //   - Monte Carlo padding
 //
-// Reference:
+// or, alternatively:
+//
+//   - deterministic sampling based on the 4D Sobol sequence
+//   - hash-based Owen scrambling, with one seed per split
+//
+// References:
 //
 //   Kollig and Keller, Efficient Multidimensional Sampling
 //   www.uni-kl.de/AG-Heinrich/EMS.pdf
 //
+//   Brent Burley, Practical Hash-based Owen Scrambling
+//   http://www.jcgt.org/published/0009/04/01/
+//
 
 template <typename RNG>
 class QMCSamplingContext
@@ -72,10 +82,12 @@ class QMCSamplingContext
     // Random number generator type.
     typedef RNG RNGType;
 
-    // This sampler can operate in two modes:
+    // This sampler can operate in three modes:
     //   1. In QMC mode, it uses possibly patent-encumbered techniques.
     //   2. In RNG mode, it works like `RNGSamplingContext` and sticks to random sampling.
-    enum Mode { QMCMode, RNGMode };
+    //   3. In Sobol mode, it uses Owen-scrambled Sobol points; all dimensions of a sample
+    //      are generated at once, with 24 bits of precision.
+    enum Mode { QMCMode, RNGMode, SobolMode };
 
     // Construct a sampling context of dimension 0.
     // The resulting sampling context cannot be used directly;
@@ -132,17 +144,18 @@ class QMCSamplingContext
 
     typedef Vector<double, 4> VectorType;
 
-    RNG&        m_rng;
-    Mode        m_mode;
+    RNG&            m_rng;
+    Mode            m_mode;
 
-    size_t      m_base_dimension;
-    size_t      m_base_instance;
+    size_t          m_base_dimension;
+    size_t          m_base_instance;
 
-    size_t      m_dimension;
-    size_t      m_sample_count;
+    size_t          m_dimension;
+    size_t          m_sample_count;
 
-    size_t      m_instance;
-    VectorType  m_offset;
+    size_t          m_instance;
+    VectorType      m_offset;
+    std::uint32_t   m_seed;
 
     // Cranley-Patterson rotation.
     template <typename T>
@@ -157,6 +170,7 @@ class QMCSamplingContext
         const size_t    sample_count);
 
     void compute_offset();
+    void compute_seed();
 
     template <typename T> struct Tag {};
 
@@ -182,6 +196,7 @@ inline QMCSamplingContext<RNG>::QMCSamplingContext(
   , m_sample_count(0)
   , m_instance(0)
   , m_offset(0.0)
+  , m_seed(0)
 {
 }
 
@@ -200,8 +215,18 @@ inline QMCSamplingContext<RNG>::QMCSamplingContext(
   , m_sample_count(sample_count)
   , m_instance(instance)
   , m_offset(0.0)
+  , m_seed(0)
 {
     assert(dimension <= VectorType::Dimension);
+
+    if (m_mode == SobolMode)
+    {
+        // Owen scrambling only preserves stratification over contiguous runs of
+        // samples starting at 0: use the initial instance number as a seed instead.
+        m_base_instance = instance;
+        m_instance = 0;
+        compute_seed();
+    }
 }
 
 template <typename RNG>
@@ -219,11 +244,14 @@ inline QMCSamplingContext<RNG>::QMCSamplingContext(
   , m_dimension(dimension)
   , m_sample_count(sample_count)
   , m_instance(0)
+  , m_seed(0)
 {
     assert(dimension <= VectorType::Dimension);
 
     if (m_mode == QMCMode)
         compute_offset();
+    else if (m_mode == SobolMode)
+        compute_seed();
 }
 
 template <typename RNG> inline
@@ -239,6 +267,7 @@ QMCSamplingContext<RNG>::operator=(const QMCSamplingContext& rhs)
     m_sample_count = rhs.m_sample_count;
     m_instance = rhs.m_instance;
     m_offset = rhs.m_offset;
+    m_seed = rhs.m_seed;
 
     return *this;
 }
@@ -274,6 +303,8 @@ inline void QMCSamplingContext<RNG>::split_in_place(
 
     if (m_mode == QMCMode)
         compute_offset();
+    else if (m_mode == SobolMode)
+        compute_seed();
 }
 
 template <typename RNG>
@@ -338,6 +369,16 @@ inline void QMCSamplingContext<RNG>::compute_offset()
     }
 }
 
+template <typename RNG>
+inline void QMCSamplingContext<RNG>::compute_seed()
+{
+    // Decorrelate both successive splits and sibling contexts.
+    m_seed =
+        mix_uint32(
+            static_cast<std::uint32_t>(m_base_dimension),
+            static_cast<std::uint32_t>(m_base_instance));
+}
+
 template <typename RNG>
 template <typename T>
 inline T QMCSamplingContext<RNG>::next2(Tag<T>)
@@ -377,6 +418,16 @@ inline Vector<T, N> QMCSamplingContext<RNG>::next2(Tag<Vector<T, N>>)
             }
         }
     }
+    else if (m_mode == SobolMode)
+    {
+        assert(N <= SobolMatrixDimensionCount);
+
+        float s[SobolMatrixDimensionCount];
+        sobol_owen_scrambled_sample4(static_cast<std::uint32_t>(m_instance), m_seed, s);
+
+        for (size_t i = 0; i < N; ++i)
+            v[i] = static_cast<T>(s[i]);
+    }
     else
     {
         for (size_t i = 0; i < N; ++i)
@@ -42,6 +42,10 @@ namespace foundation
 //
 // A sampling context implementing random sampling.
 //
+// RNG may be any generator providing rand_uint32(), including the wide
+// generators WidePCG and WideXoroshiro128plus which hand out the numbers
+// of their streams in turn.
+//
 
 template <typename RNG>
 class RNGSamplingContext
@@ -33,6 +33,7 @@
 #include "foundation/math/vector.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 
@@ -50,110 +51,137 @@ template <typename T>
 class SphericalRectangleSampler
 {
   public:
+    // Constructor. The rectangle is defined by one of its corners and by its two
+    // edges starting at this corner, which must be orthogonal.
     SphericalRectangleSampler(
         const Vector<T, 3>& origin,
-        const Vector<T, 3>& x_axis,
-        const Vector<T, 3>& y_axis,
-        const Vector<T, 3>& normal,
-        const Vector<T, 3>& center)
-      : m_x(x_axis)
-      , m_y(y_axis)
-      , m_z(normal)
-      , m_center(center)
-    {
-        const Vector<T, 3> d = origin - center;
-
-        const T width = norm(x_axis);
-        const T height = norm(y_axis);
-
-        const T x0 = dot(d, x_axis);
-        const T x1 = x0 + width;
+        const Vector<T, 3>& corner,
+        const Vector<T, 3>& edge_x,
+        const Vector<T, 3>& edge_y);
 
-        m_y0 = dot(d, y_axis);
-        m_y1 = m_y0 + height;
-        m_z0 = dot(d, normal);
+    // Return the solid angle subtended by the rectangle as seen from the origin.
+    T get_solid_angle() const;
 
-        // z flip
-        if (m_z0 > T(0.0))
-        {
-            m_z0 *= T(-1.0);
-            m_z  *= T(-1.0);
-        }
+    // Return a point on the rectangle, uniformly distributed in solid angle.
+    Vector<T, 3> sample(const Vector<T, 2>& s) const;
 
-        m_n0 = Vector<T, 3>(T(0.0), m_z0, -m_y0);
-        m_n2 = Vector<T, 3>(T(0.0), -m_z0, m_y1);
-        const Vector<T, 3> n1 = Vector<T, 3>(-m_z0, T(0.0), x1);
-        const Vector<T, 3> n3 = Vector<T, 3>(m_z0, T(0.0), -x0);
+  private:
+    Vector<T, 3>        m_origin;
+    Vector<T, 3>        m_x;
+    Vector<T, 3>        m_y;
+    Vector<T, 3>        m_z;
 
-        m_y0y0 = square(m_y0);
-        m_y1y1 = square(m_y1);
-        m_z0z0 = square(m_z0);
+    T                   m_x0;
+    T                   m_x1;
+    T                   m_y0;
+    T                   m_y1;
+    T                   m_z0;
+    T                   m_z0z0;
+    T                   m_y0y0;
+    T                   m_y1y1;
 
-        m_n0.z /= std::sqrt(m_z0z0 + m_y0y0);
-        m_n2.z /= std::sqrt(m_z0z0 + m_y1y1);
-        n1.z /= std::sqrt(m_z0z0 + square(x1));
-        n3.z /= std::sqrt(m_z0z0 + square(x0));
+    T                   m_b0;
+    T                   m_b1;
+    T                   m_k;
+    T                   m_solid_angle;
+};
 
-        const T g0 = std::acos(-m_n0.z * n1.z);
-        const T g1 = std::acos(-n1.z * m_n2.z);
-        m_g2 = std::acos(-m_n2.z * n3.z);
-        m_g3 = std::acos(-n3.z * m_n0.z);
 
-        m_area = g0 + g1 + m_g2 + m_g3 - TwoPi<T>();
-    }
+//
+// SphericalRectangleSampler class implementation.
+//
 
-    T get_area() const
+template <typename T>
+SphericalRectangleSampler<T>::SphericalRectangleSampler(
+    const Vector<T, 3>& origin,
+    const Vector<T, 3>& corner,
+    const Vector<T, 3>& edge_x,
+    const Vector<T, 3>& edge_y)
+  : m_origin(origin)
+{
+    // Local reference frame.
+    const T width = norm(edge_x);
+    const T height = norm(edge_y);
+    m_x = edge_x / width;
+    m_y = edge_y / height;
+    m_z = cross(m_x, m_y);
+
+    // Rectangle coordinates in the local reference frame.
+    const Vector<T, 3> d = corner - origin;
+    m_x0 = dot(d, m_x);
+    m_y0 = dot(d, m_y);
+    m_z0 = dot(d, m_z);
+    m_x1 = m_x0 + width;
+    m_y1 = m_y0 + height;
+
+    // Flip the frame so that the rectangle lies below the origin.
+    if (m_z0 > T(0.0))
     {
-        return m_area;
+        m_z0 = -m_z0;
+        m_z = -m_z;
     }
 
-    Vector<T, 3> sample(const Vector<T, 2>& s) const
-    {
-        const T au = s[0] * m_area - m_g2 - m_g3 + TwoPi<T>();
-
-        const T b0 = m_n0.z;
-        const T b1 = m_n2.z;
-        const T fu = (std::cos(au) * b0 - b1) / std::sin(au);
+    m_z0z0 = square(m_z0);
+    m_y0y0 = square(m_y0);
+    m_y1y1 = square(m_y1);
 
-        const T cu =
-            clamp(
-                std::copysign(T(1.0), fu) / std::sqrt(square(fu) + square(b0)),
-                T(-1.0),
-                T(1.0));
+    // z components of the normals of the planes going through the origin and the edges.
+    const T n0z = -m_y0 / std::sqrt(m_z0z0 + m_y0y0);
+    const T n1z = m_x1 / std::sqrt(m_z0z0 + square(m_x1));
+    const T n2z = m_y1 / std::sqrt(m_z0z0 + m_y1y1);
+    const T n3z = -m_x0 / std::sqrt(m_z0z0 + square(m_x0));
 
-        const T xu = (-cu * m_z0) / safe_sqrt(T(1.0) - square(cu));
-        const T d = std::sqrt(square(xu) + m_z0z0);
-        const T d2 = square(d);
+    // Internal angles of the spherical rectangle.
+    const T g0 = std::acos(clamp(-n0z * n1z, T(-1.0), T(1.0)));
+    const T g1 = std::acos(clamp(-n1z * n2z, T(-1.0), T(1.0)));
+    const T g2 = std::acos(clamp(-n2z * n3z, T(-1.0), T(1.0)));
+    const T g3 = std::acos(clamp(-n3z * n0z, T(-1.0), T(1.0)));
 
-        const T h0 = m_y0 / std::sqrt(d2 + m_y0y0);
-        const T h1 = m_y1 / std::sqrt(d2 + m_y1y1);
+    m_b0 = n0z;
+    m_b1 = n2z;
+    m_k = TwoPi<T>() - g2 - g3;
+    m_solid_angle = std::max(g0 + g1 - m_k, T(0.0));
+}
 
-        const T hv = lerp(h0, h1, s[1]);
-        const T hv2 = square(hv);
-        const T yv = (hv * d) / safe_sqrt(T(1.0) - hv2);
-
-        return m_center + xu * m_x + yv * m_y + m_z0 * m_z;
-    }
-
-  private:
-    const Vector<T, 3>  m_x;
-    const Vector<T, 3>  m_y;
-    Vector<T, 3>        m_z;
-    const Vector<T, 3>  m_center;
-
-    T                   m_y0;
-    T                   m_y1;
-    T                   m_z0;
-    T                   m_z0z0;
-    T                   m_y0y0;
-    T                   m_y1y1;
-
-    T                   m_area;
+template <typename T>
+inline T SphericalRectangleSampler<T>::get_solid_angle() const
+{
+    return m_solid_angle;
+}
 
-    Vector<T, 3>        m_n0;
-    Vector<T, 3>        m_n2;
-    T                   m_g2;
-    T                   m_g3;
-};
+template <typename T>
+Vector<T, 3> SphericalRectangleSampler<T>::sample(const Vector<T, 2>& s) const
+{
+    assert(m_solid_angle > T(0.0));
+
+    // Compute the cosine of the x coordinate of the sample.
+    const T au = s[0] * m_solid_angle + m_k;
+    const T fu = (std::cos(au) * m_b0 - m_b1) / std::sin(au);
+    const T cu =
+        clamp(
+            std::copysign(T(1.0), fu) / std::sqrt(square(fu) + square(m_b0)),
+            T(-1.0),
+            T(1.0));
+
+    // Compute the x coordinate of the sample.
+    const T xu =
+        clamp(
+            -(cu * m_z0) / safe_sqrt(T(1.0) - square(cu)),
+            m_x0,
+            m_x1);
+
+    // Compute the y coordinate of the sample.
+    const T d = std::sqrt(square(xu) + m_z0z0);
+    const T h0 = m_y0 / std::sqrt(square(d) + m_y0y0);
+    const T h1 = m_y1 / std::sqrt(square(d) + m_y1y1);
+    const T hv = lerp(h0, h1, s[1]);
+    const T hv2 = square(hv);
+    const T yv =
+        hv2 < T(1.0) - T(1.0e-6)
+            ? clamp((hv * d) / std::sqrt(T(1.0) - hv2), m_y0, m_y1)
+            : m_y1;
+
+    return m_origin + xu * m_x + yv * m_y + m_z0 * m_z;
+}
 
 }  // namespace foundation
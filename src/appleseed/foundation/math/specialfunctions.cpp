@@ -175,10 +175,8 @@ float log_bessel(const float x)
 
 float logistic(const float mean, const float scale)
 {
-    const float loc = std::abs(mean);
-    const float den = (1.0f + std::exp(-loc / scale)) * (1.0f + std::exp(-loc / scale));
-    const float num = -loc / scale;
-    return std::exp(num) / (scale * den);
+    const float e = std::exp(-std::abs(mean) / scale);
+    return e / (scale * square(1.0f + e));
 }
 
 float logistic_cdf(float mean, float scale)
@@ -41,7 +41,10 @@ namespace foundation
 {
 
 //
-// A standard-conformant allocator allocating aligned memory.
+// A standard-conformant allocator allocating aligned memory, optionally backed by
+// large pages (see foundation::large_page_aligned_malloc()). Since both kinds of
+// memory are freed the same way, allocators only differing by their use of large
+// pages compare equal.
 //
 
 template <typename T>
@@ -62,25 +65,31 @@ class AlignedAllocator
         typedef AlignedAllocator<U> other;
     };
 
-    explicit AlignedAllocator(const size_t alignment = 16)
+    explicit AlignedAllocator(
+        const size_t    alignment = 16,
+        const bool      large_pages = false)
       : m_alignment(alignment)
+      , m_large_pages(large_pages)
     {
     }
 
     AlignedAllocator(const AlignedAllocator& rhs)
       : m_alignment(rhs.m_alignment)
+      , m_large_pages(rhs.m_large_pages)
     {
     }
 
     template <typename U>
     AlignedAllocator(const AlignedAllocator<U>& rhs)
       : m_alignment(rhs.m_alignment)
+      , m_large_pages(rhs.m_large_pages)
     {
     }
 
     AlignedAllocator& operator=(const AlignedAllocator& rhs)
     {
         m_alignment = rhs.m_alignment;
+        m_large_pages = rhs.m_large_pages;
         return *this;
     }
 
@@ -116,7 +125,11 @@ class AlignedAllocator
         if (n == 0)
             return nullptr;
 
-        pointer p = static_cast<pointer>(aligned_malloc(n * sizeof(T), m_alignment));
+        pointer p =
+            static_cast<pointer>(
+                m_large_pages
+                    ? large_page_aligned_malloc(n * sizeof(T), m_alignment)
+                    : aligned_malloc(n * sizeof(T), m_alignment));
 
         if (p == nullptr)
              throw std::bad_alloc();
@@ -151,6 +164,7 @@ class AlignedAllocator
     friend class AlignedAllocator;
 
     size_t m_alignment;
+    bool   m_large_pages;
 };
 
 // A partial specialization for the void value type is required for rebinding
@@ -169,14 +183,18 @@ class AlignedAllocator<void>
         typedef AlignedAllocator<U> other;
     };
 
-    explicit AlignedAllocator(const size_t alignment = 16)
+    explicit AlignedAllocator(
+        const size_t    alignment = 16,
+        const bool      large_pages = false)
       : m_alignment(alignment)
+      , m_large_pages(large_pages)
     {
     }
 
     template <typename U>
     AlignedAllocator(const AlignedAllocator<U>& rhs)
       : m_alignment(rhs.m_alignment)
+      , m_large_pages(rhs.m_large_pages)
     {
     }
 
@@ -186,6 +204,7 @@ class AlignedAllocator<void>
     friend class AlignedAllocator;
 
     const size_t m_alignment;
+    const bool   m_large_pages;
 };
 
 }   // namespace foundation
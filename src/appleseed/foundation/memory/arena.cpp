@@ -0,0 +1,130 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "arena.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exception.h"
+#include "foundation/utility/statistics.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cstdint>
+
+namespace foundation
+{
+
+//
+// Arena class implementation.
+//
+
+Arena::Arena()
+  : m_chunk_index(0)
+  , m_end(m_storage + InlineSize)
+  , m_current(m_storage)
+  , m_high_water_mark(0)
+  , m_chunk_allocation_count(0)
+{
+    Chunk chunk;
+    chunk.m_begin = m_storage;
+    chunk.m_end = m_storage + InlineSize;
+    chunk.m_base = 0;
+    m_chunks.push_back(chunk);
+}
+
+Arena::~Arena()
+{
+    for (size_t i = 1, e = m_chunks.size(); i < e; ++i)
+        aligned_free(m_chunks[i].m_begin);
+}
+
+Statistics Arena::get_statistics() const
+{
+    Statistics stats;
+    stats.insert_size("capacity", get_capacity());
+    stats.insert_size("high water mark", get_high_water_mark());
+    stats.insert<std::uint64_t>("chunk allocations", get_chunk_allocation_count());
+    return stats;
+}
+
+void* Arena::allocate_from_next_chunk(const size_t size)
+{
+    const size_t aligned_size = align(size, 16);
+    const size_t next_index = m_chunk_index + 1;
+
+    // Release the chunks following the current one that are too small for this allocation.
+    while (next_index < m_chunks.size() &&
+           static_cast<size_t>(m_chunks[next_index].m_end - m_chunks[next_index].m_begin) < aligned_size)
+    {
+        aligned_free(m_chunks[next_index].m_begin);
+        m_chunks.erase(m_chunks.begin() + next_index);
+    }
+
+    if (next_index == m_chunks.size())
+    {
+        // Grow geometrically so that the number of chunks stays small.
+        const Chunk& current = m_chunks[m_chunk_index];
+        const size_t chunk_size =
+            std::max(
+                std::max(static_cast<size_t>(MinChunkSize), 2 * static_cast<size_t>(current.m_end - current.m_begin)),
+                aligned_size);
+
+        void* storage = aligned_malloc(chunk_size, 16);
+        if (storage == nullptr)
+            throw Exception("out of arena memory");
+
+        Chunk chunk;
+        chunk.m_begin = static_cast<std::uint8_t*>(storage);
+        chunk.m_end = chunk.m_begin + chunk_size;
+        chunk.m_base = 0;
+        m_chunks.push_back(chunk);
+
+        ++m_chunk_allocation_count;
+    }
+
+    // Chunks may have been released or inserted: update the base offsets that follow.
+    for (size_t i = next_index, e = m_chunks.size(); i < e; ++i)
+    {
+        const Chunk& prev = m_chunks[i - 1];
+        m_chunks[i].m_base = prev.m_base + (prev.m_end - prev.m_begin);
+    }
+
+    m_chunk_index = next_index;
+    m_end = m_chunks[next_index].m_end;
+    m_current = m_chunks[next_index].m_begin;
+
+    void* ptr = m_current;
+    m_current += aligned_size;
+
+    assert(is_aligned(ptr, 16));
+
+    return ptr;
+}
+
+}   // namespace foundation
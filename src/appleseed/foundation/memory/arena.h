@@ -30,14 +30,22 @@
 #pragma once
 
 // appleseed.foundation headers.
-#include "foundation/core/exceptions/exception.h"
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/memory/memory.h"
 #include "foundation/platform/compiler.h"
 
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
 // Standard headers.
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <new>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class Statistics; }
 
 namespace foundation
 {
@@ -45,27 +53,85 @@ namespace foundation
 //
 // An arena is a temporary heap providing extremely cheap memory allocation.
 //
+// Memory is handed out from a small inline buffer first, then from heap-allocated
+// chunks of geometrically increasing sizes when the inline buffer is exhausted.
+// Chunks are kept when the arena is cleared or reset, so that an arena quickly
+// reaches the size required by the workload and then stops allocating.
+//
+// Markers allow to release only the allocations made after a given point, for
+// instance to discard the shading data of a path vertex while keeping the path
+// vertices allocated before it.
+//
 
-class Arena
+class APPLESEED_DLLSYMBOL Arena
+  : public NonCopyable
 {
   public:
+    // A position in the arena.
+    class Marker
+    {
+      private:
+        friend class Arena;
+
+        size_t          m_chunk_index;
+        std::uint8_t*   m_current;
+    };
+
+    // Constructor.
     Arena();
 
+    // Destructor.
+    ~Arena();
+
+    // Release all allocations.
     void clear();
 
+    // Return the current position in the arena.
+    Marker get_marker() const;
+
+    // Release all allocations made after a given marker.
+    void reset(const Marker& marker);
+
     void* allocate(const size_t size);
 
     template <typename T> T* allocate();
     template <typename T> T* allocate_noinit();
 
-    const std::uint8_t* get_storage() const;
+    // Return the total size in bytes of the inline buffer and of all chunks.
+    size_t get_capacity() const;
 
-  private:
-    enum { ArenaSize = 384 * 1024 };    // bytes
+    // Return the largest number of bytes ever used at once.
+    size_t get_high_water_mark() const;
+
+    // Return the number of chunks allocated on the heap.
+    size_t get_chunk_allocation_count() const;
+
+    // Return statistics about this arena.
+    Statistics get_statistics() const;
 
-    APPLESEED_SIMD4_ALIGN std::uint8_t  m_storage[ArenaSize];
+  private:
+    enum { InlineSize = 32 * 1024 };    // bytes
+    enum { MinChunkSize = 64 * 1024 };  // bytes
+
+    struct Chunk
+    {
+        std::uint8_t*   m_begin;
+        std::uint8_t*   m_end;
+        size_t          m_base;         // number of bytes in all preceding chunks
+    };
+
+    APPLESEED_SIMD4_ALIGN std::uint8_t  m_storage[InlineSize];
+    std::vector<Chunk>                  m_chunks;
+    size_t                              m_chunk_index;
     const std::uint8_t*                 m_end;
     std::uint8_t*                       m_current;
+    mutable size_t                      m_high_water_mark;
+    size_t                              m_chunk_allocation_count;
+
+    size_t get_used_size() const;
+    void update_high_water_mark() const;
+
+    void* allocate_from_next_chunk(const size_t size);
 };
 
 
@@ -73,21 +139,41 @@ class Arena
 // Arena class implementation.
 //
 
-inline Arena::Arena()
-  : m_end(m_storage + ArenaSize)
-  , m_current(m_storage)
+inline void Arena::clear()
 {
+    update_high_water_mark();
+
+    m_chunk_index = 0;
+    m_end = m_chunks[0].m_end;
+    m_current = m_chunks[0].m_begin;
 }
 
-inline void Arena::clear()
+inline Arena::Marker Arena::get_marker() const
 {
-    m_current = m_storage;
+    Marker marker;
+    marker.m_chunk_index = m_chunk_index;
+    marker.m_current = m_current;
+    return marker;
+}
+
+inline void Arena::reset(const Marker& marker)
+{
+    assert(marker.m_chunk_index <= m_chunk_index);
+    assert(marker.m_current >= m_chunks[marker.m_chunk_index].m_begin);
+    assert(marker.m_current <= m_chunks[marker.m_chunk_index].m_end);
+
+    update_high_water_mark();
+
+    m_chunk_index = marker.m_chunk_index;
+    m_end = m_chunks[m_chunk_index].m_end;
+    m_current = marker.m_current;
 }
 
 inline void* Arena::allocate(const size_t size)
 {
-    if (m_current + size > m_end)
-        throw Exception("out of arena memory");
+    // Chunk sizes are multiples of 16 bytes, so the aligned size fits whenever size does.
+    if (size > static_cast<size_t>(m_end - m_current))
+        return allocate_from_next_chunk(size);
 
     void* ptr = m_current;
     m_current += align(size, 16);
@@ -113,9 +199,34 @@ inline T* Arena::allocate_noinit()
     return static_cast<T*>(allocate(sizeof(T)));
 }
 
-inline const std::uint8_t* Arena::get_storage() const
+inline size_t Arena::get_capacity() const
+{
+    const Chunk& last = m_chunks.back();
+    return last.m_base + (last.m_end - last.m_begin);
+}
+
+inline size_t Arena::get_high_water_mark() const
+{
+    update_high_water_mark();
+    return m_high_water_mark;
+}
+
+inline size_t Arena::get_chunk_allocation_count() const
+{
+    return m_chunk_allocation_count;
+}
+
+inline size_t Arena::get_used_size() const
+{
+    const Chunk& chunk = m_chunks[m_chunk_index];
+    return chunk.m_base + (m_current - chunk.m_begin);
+}
+
+inline void Arena::update_high_water_mark() const
 {
-    return m_storage;
+    const size_t used_size = get_used_size();
+    if (m_high_water_mark < used_size)
+        m_high_water_mark = used_size;
 }
 
 }   // namespace foundation
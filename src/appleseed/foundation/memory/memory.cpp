@@ -34,8 +34,14 @@
 #include "main/allocator.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstdlib>
 
+// Platform headers.
+#if defined __linux__
+#include <sys/mman.h>
+#endif
+
 namespace foundation
 {
 
@@ -82,6 +88,31 @@ void* aligned_malloc(const size_t size, size_t alignment)
     return aligned_ptr;
 }
 
+void* large_page_aligned_malloc(const size_t size, size_t alignment)
+{
+#if defined __linux__ && defined MADV_HUGEPAGE
+    const size_t LargePageSize = 2 * 1024 * 1024;
+
+    // Only allocations spanning at least one large page benefit from large pages.
+    if (size >= LargePageSize)
+    {
+        // Aligning the block on a large page boundary lets the kernel map all of it
+        // with large pages at fault time rather than only its aligned interior.
+        void* ptr = aligned_malloc(size, std::max(alignment, LargePageSize));
+
+        if (ptr)
+        {
+            // Failure (e.g. kernel without transparent huge page support) is harmless:
+            // the block is simply backed by regular pages.
+            madvise(ptr, size, MADV_HUGEPAGE);
+            return ptr;
+        }
+    }
+#endif
+
+    return aligned_malloc(size, alignment);
+}
+
 void aligned_free(void* aligned_ptr)
 {
     assert(aligned_ptr);
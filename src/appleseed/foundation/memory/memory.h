@@ -61,7 +61,13 @@ bool is_aligned(const T ptr, const size_t alignment);
 // Allocate memory on a specified alignment boundary.
 void* aligned_malloc(const size_t size, size_t alignment);
 
-// Free a block of memory that was allocated with aligned_malloc().
+// Allocate memory on a specified alignment boundary and ask the operating system to back
+// it with large pages (2 MB transparent huge pages on Linux) to reduce TLB misses when
+// traversing it. Small allocations and platforms without large page support fall back to
+// aligned_malloc(). The memory must be freed with aligned_free().
+void* large_page_aligned_malloc(const size_t size, size_t alignment);
+
+// Free a block of memory that was allocated with aligned_malloc() or large_page_aligned_malloc().
 void aligned_free(void* aligned_ptr);
 
 
@@ -0,0 +1,199 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "memorytracker.h"
+
+// Boost headers.
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
+
+// Standard headers.
+#include <cassert>
+#include <cstring>
+
+namespace foundation
+{
+
+//
+// MemoryTracker class implementation.
+//
+
+namespace
+{
+    struct Category
+    {
+        const char*                 m_name;
+        boost::atomic<size_t>       m_current_size;
+        boost::atomic<size_t>       m_peak_size;
+    };
+}
+
+struct MemoryTracker::Impl
+{
+    boost::mutex                    m_mutex;
+    boost::atomic<size_t>           m_category_count;
+    Category                        m_categories[MaxCategoryCount];
+
+    Impl()
+      : m_category_count(0)
+    {
+        for (size_t i = 0; i < MaxCategoryCount; ++i)
+        {
+            m_categories[i].m_name = nullptr;
+            m_categories[i].m_current_size = 0;
+            m_categories[i].m_peak_size = 0;
+        }
+    }
+};
+
+MemoryTracker::MemoryTracker()
+  : impl(new Impl())
+{
+}
+
+MemoryTracker::~MemoryTracker()
+{
+    delete impl;
+}
+
+size_t MemoryTracker::get_category(const char* name)
+{
+    assert(name);
+
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    const size_t category_count = impl->m_category_count.load(boost::memory_order_relaxed);
+
+    for (size_t i = 0; i < category_count; ++i)
+    {
+        if (std::strcmp(impl->m_categories[i].m_name, name) == 0)
+            return i;
+    }
+
+    // Reserve the last slot for the "other" category.
+    if (category_count == MaxCategoryCount - 1)
+    {
+        impl->m_categories[category_count].m_name = "other";
+        impl->m_category_count.store(MaxCategoryCount, boost::memory_order_release);
+        return category_count;
+    }
+
+    if (category_count == MaxCategoryCount)
+        return MaxCategoryCount - 1;
+
+    impl->m_categories[category_count].m_name = name;
+    impl->m_category_count.store(category_count + 1, boost::memory_order_release);
+
+    return category_count;
+}
+
+size_t MemoryTracker::get_category_count() const
+{
+    return impl->m_category_count.load(boost::memory_order_acquire);
+}
+
+const char* MemoryTracker::get_category_name(const size_t category) const
+{
+    assert(category < get_category_count());
+    return impl->m_categories[category].m_name;
+}
+
+void MemoryTracker::allocate(const size_t category, const size_t size)
+{
+    assert(category < MaxCategoryCount);
+
+    Category& c = impl->m_categories[category];
+    const size_t current_size = c.m_current_size.fetch_add(size, boost::memory_order_relaxed) + size;
+
+    size_t peak_size = c.m_peak_size.load(boost::memory_order_relaxed);
+    while (current_size > peak_size &&
+           !c.m_peak_size.compare_exchange_weak(peak_size, current_size, boost::memory_order_relaxed)) {}
+}
+
+void MemoryTracker::deallocate(const size_t category, const size_t size)
+{
+    assert(category < MaxCategoryCount);
+    assert(impl->m_categories[category].m_current_size.load(boost::memory_order_relaxed) >= size);
+
+    impl->m_categories[category].m_current_size.fetch_sub(size, boost::memory_order_relaxed);
+}
+
+size_t MemoryTracker::get_current_size(const size_t category) const
+{
+    assert(category < MaxCategoryCount);
+    return impl->m_categories[category].m_current_size.load(boost::memory_order_relaxed);
+}
+
+size_t MemoryTracker::get_peak_size(const size_t category) const
+{
+    assert(category < MaxCategoryCount);
+    return impl->m_categories[category].m_peak_size.load(boost::memory_order_relaxed);
+}
+
+void MemoryTracker::reset_peak_sizes()
+{
+    for (size_t i = 0; i < MaxCategoryCount; ++i)
+    {
+        Category& c = impl->m_categories[i];
+        c.m_peak_size.store(c.m_current_size.load(boost::memory_order_relaxed), boost::memory_order_relaxed);
+    }
+}
+
+StatisticsVector MemoryTracker::get_statistics() const
+{
+    Statistics current_stats;
+    Statistics peak_stats;
+    size_t total_current_size = 0;
+
+    const size_t category_count = get_category_count();
+
+    for (size_t i = 0; i < category_count; ++i)
+    {
+        const size_t current_size = get_current_size(i);
+        current_stats.insert_size(get_category_name(i), current_size);
+        peak_stats.insert_size(get_category_name(i), get_peak_size(i));
+        total_current_size += current_size;
+    }
+
+    current_stats.insert_size("total", total_current_size);
+
+    StatisticsVector vec;
+    vec.insert("current memory usage", current_stats);
+    vec.insert("peak memory usage", peak_stats);
+
+    return vec;
+}
+
+MemoryTracker& global_memory_tracker()
+{
+    static MemoryTracker tracker;
+    return tracker;
+}
+
+}   // namespace foundation
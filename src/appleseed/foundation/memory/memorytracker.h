@@ -0,0 +1,163 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/statistics.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+
+// Standard headers.
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// Keeps track of the current and peak amount of memory used by categories of data,
+// such as geometry, acceleration structures or framebuffers.
+//
+// Categories are identified by name and registered on first use. Accounting for an
+// allocation or a deallocation costs a couple of atomic operations and can be done
+// concurrently from any thread.
+//
+// Category names must be string literals or otherwise outlive the tracker.
+//
+
+class APPLESEED_DLLSYMBOL MemoryTracker
+  : public NonCopyable
+{
+  public:
+    // Maximum number of categories; additional categories are accounted as "other".
+    static const size_t MaxCategoryCount = 32;
+
+    // Constructor.
+    MemoryTracker();
+
+    // Destructor.
+    ~MemoryTracker();
+
+    // Return the index of a given category, registering it if necessary.
+    size_t get_category(const char* name);
+
+    // Return the number of registered categories.
+    size_t get_category_count() const;
+
+    // Return the name of a given category.
+    const char* get_category_name(const size_t category) const;
+
+    // Account for memory allocated or released in a given category.
+    void allocate(const size_t category, const size_t size);
+    void deallocate(const size_t category, const size_t size);
+
+    // Return the current and peak amount of memory (in bytes) used by a given category.
+    size_t get_current_size(const size_t category) const;
+    size_t get_peak_size(const size_t category) const;
+
+    // Reset the peak amount of memory of all categories to their current amount.
+    void reset_peak_sizes();
+
+    // Return the current and peak amount of memory used by all categories.
+    StatisticsVector get_statistics() const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+// Return the memory tracker shared by the whole library.
+APPLESEED_DLLSYMBOL MemoryTracker& global_memory_tracker();
+
+
+//
+// Accounts for the memory used by a given object or container in a category of the
+// global memory tracker. The size is updated by the owner whenever it changes and is
+// released when this object is destroyed.
+//
+
+class APPLESEED_DLLSYMBOL TrackedMemory
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    explicit TrackedMemory(const char* category);
+
+    // Destructor, releases the accounted memory.
+    ~TrackedMemory();
+
+    // Set the amount of memory (in bytes) accounted for.
+    void set_size(const size_t size);
+
+    // Return the amount of memory (in bytes) accounted for.
+    size_t get_size() const;
+
+  private:
+    const size_t    m_category;
+    size_t          m_size;
+};
+
+
+//
+// TrackedMemory class implementation.
+//
+
+inline TrackedMemory::TrackedMemory(const char* category)
+  : m_category(global_memory_tracker().get_category(category))
+  , m_size(0)
+{
+}
+
+inline TrackedMemory::~TrackedMemory()
+{
+    set_size(0);
+}
+
+inline void TrackedMemory::set_size(const size_t size)
+{
+    MemoryTracker& tracker = global_memory_tracker();
+
+    if (size > m_size)
+        tracker.allocate(m_category, size - m_size);
+    else if (size < m_size)
+        tracker.deallocate(m_category, m_size - size);
+
+    m_size = size;
+}
+
+inline size_t TrackedMemory::get_size() const
+{
+    return m_size;
+}
+
+}   // namespace foundation
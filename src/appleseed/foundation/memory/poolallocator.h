@@ -31,6 +31,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/singleton.h"
+#include "foundation/platform/compiler.h"
 #include "foundation/platform/thread.h"
 
 // Standard headers.
@@ -39,6 +40,7 @@
 #include <cstdint>
 #include <limits>
 #include <memory>
+#include <vector>
 
 namespace foundation
 {
@@ -46,8 +48,16 @@ namespace foundation
 //
 // A standard-conformant, thread-safe, fixed-size object allocator.
 //
+// Each thread allocates from and frees to its own magazine, a short list of free
+// memory blocks, without any synchronization. Magazines are refilled from and
+// flushed to a shared depot of full magazines, MagazineSize blocks at a time,
+// under a lock. Memory blocks have no owning thread: a block freed by another
+// thread than the one that allocated it simply goes to the freeing thread's
+// magazine, and flows back to other threads through the depot.
+//
 // Note that memory allocated through this allocator is never returned
-// to the system, and thus is never made available for other uses.
+// to the system, and thus is never made available for other uses. Blocks
+// left in the magazine of a thread when it exits are not reused either.
 //
 
 namespace impl
@@ -60,43 +70,40 @@ namespace impl
       : public Singleton<Pool<ItemSize, ItemsPerPage>>
     {
       public:
+        // Number of memory blocks moved between a thread's magazine and the depot at once.
+        static const size_t MagazineSize = 32;
+
         // Allocate a memory block.
         void* allocate()
         {
-            Spinlock::ScopedLock lock(m_spinlock);
+            Magazine& magazine = get_magazine();
 
-            if (Node* node = m_free_head)
-            {
-                // Return the first node from the list of free nodes.
-                m_free_head = m_free_head->m_next;
-                return node;
-            }
-            else
-            {
-                // The current page is full, allocate a new page of nodes.
-                if (m_page_index == ItemsPerPage)
-                {
-                    m_page = new Node[ItemsPerPage];
-                    m_page_index = 0;
-                }
+            if (magazine.m_head == nullptr)
+                refill(magazine);
 
-                // Return the next node from the page.
-                return &m_page[m_page_index++];
-            }
+            // Return the first node from the magazine.
+            Node* node = magazine.m_head;
+            magazine.m_head = node->m_next;
+            --magazine.m_count;
+
+            return node;
         }
 
         // Return a memory block to the pool.
         void deallocate(void* p)
         {
-            Spinlock::ScopedLock lock(m_spinlock);
-
             assert(p);
 
+            Magazine& magazine = get_magazine();
             Node* node = static_cast<Node*>(p);
 
-            // Insert this node at the beginning of the list of free nodes.
-            node->m_next = m_free_head;
-            m_free_head = node;
+            // Insert this node at the beginning of the magazine.
+            node->m_next = magazine.m_head;
+            magazine.m_head = node;
+
+            // Hand over a full magazine to the depot when this thread frees more than it allocates.
+            if (++magazine.m_count == 2 * MagazineSize)
+                flush(magazine);
         }
 
       private:
@@ -108,18 +115,81 @@ namespace impl
             Node*           m_next;             // pointer to the next free node
         };
 
-        Spinlock    m_spinlock;
-        Node*       m_page;
-        size_t      m_page_index;
-        Node*       m_free_head;
+        // Per-thread list of free nodes. Must remain a POD type to be stored in thread-local storage.
+        struct Magazine
+        {
+            Node*           m_head;
+            size_t          m_count;
+        };
+
+        Spinlock            m_spinlock;
+        Node*               m_page;
+        size_t              m_page_index;
+        std::vector<Node*>  m_depot;            // heads of lists of exactly MagazineSize free nodes
 
         // Constructor.
         Pool()
           : m_page(nullptr)
           , m_page_index(ItemsPerPage)
-          , m_free_head(nullptr)
         {
         }
+
+        // Return the magazine of the calling thread.
+        static Magazine& get_magazine()
+        {
+            static APPLESEED_TLS Magazine magazine;
+            return magazine;
+        }
+
+        // Refill an empty magazine, from the depot if possible, or else from pages.
+        void refill(Magazine& magazine)
+        {
+            assert(magazine.m_head == nullptr);
+
+            Spinlock::ScopedLock lock(m_spinlock);
+
+            if (!m_depot.empty())
+            {
+                magazine.m_head = m_depot.back();
+                magazine.m_count = MagazineSize;
+                m_depot.pop_back();
+                return;
+            }
+
+            for (size_t i = 0; i < MagazineSize; ++i)
+            {
+                // The current page is full, allocate a new page of nodes.
+                if (m_page_index == ItemsPerPage)
+                {
+                    m_page = new Node[ItemsPerPage];
+                    m_page_index = 0;
+                }
+
+                // Insert the next node from the page into the magazine.
+                Node* node = &m_page[m_page_index++];
+                node->m_next = magazine.m_head;
+                magazine.m_head = node;
+            }
+
+            magazine.m_count = MagazineSize;
+        }
+
+        // Move the last MagazineSize nodes of a magazine to the depot.
+        void flush(Magazine& magazine)
+        {
+            assert(magazine.m_count == 2 * MagazineSize);
+
+            Node* last_kept = magazine.m_head;
+            for (size_t i = 1; i < MagazineSize; ++i)
+                last_kept = last_kept->m_next;
+
+            Node* flushed = last_kept->m_next;
+            last_kept->m_next = nullptr;
+            magazine.m_count = MagazineSize;
+
+            Spinlock::ScopedLock lock(m_spinlock);
+            m_depot.push_back(flushed);
+        }
     };
 }
 
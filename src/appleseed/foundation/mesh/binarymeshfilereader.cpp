@@ -35,7 +35,14 @@
 #include "foundation/math/vector.h"
 #include "foundation/memory/memory.h"
 #include "foundation/mesh/imeshbuilder.h"
+#include "foundation/platform/system.h"
 #include "foundation/utility/bufferedfile.h"
+#include "foundation/utility/virtualfilesystem.h"
+
+// Boost headers.
+#include "boost/interprocess/exceptions.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
 
 // Standard headers.
 #include <cstdint>
@@ -49,6 +56,71 @@ namespace foundation
 // BinaryMeshFileReader class implementation.
 //
 
+namespace
+{
+    // Alignment in bytes of the sections of mappable files.
+    const size_t PageSize = 4096;
+
+    // Bounds-checked sequential access to a memory-mapped file.
+    class MappedFileCursor
+    {
+      public:
+        MappedFileCursor(const void* data, const size_t size)
+          : m_data(static_cast<const std::uint8_t*>(data))
+          , m_size(size)
+          , m_offset(0)
+        {
+        }
+
+        bool at_end() const
+        {
+            return m_offset >= m_size;
+        }
+
+        void align_to_page()
+        {
+            const size_t remainder = m_offset % PageSize;
+
+            if (remainder > 0)
+                m_offset += PageSize - remainder;
+        }
+
+        // Return a pointer to the next count elements of type T and step over them.
+        template <typename T>
+        const T* consume(const size_t count)
+        {
+            const size_t bytes = count * sizeof(T);
+
+            if (m_offset > m_size || bytes > m_size - m_offset)
+                throw ExceptionIOError("truncated binarymesh file");
+
+            const T* p = reinterpret_cast<const T*>(m_data + m_offset);
+            m_offset += bytes;
+
+            return p;
+        }
+
+        template <typename T>
+        T read()
+        {
+            T value;
+            std::memcpy(&value, consume<std::uint8_t>(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        std::string read_string()
+        {
+            const std::uint16_t length = read<std::uint16_t>();
+            return std::string(consume<char>(length), length);
+        }
+
+      private:
+        const std::uint8_t* m_data;
+        const size_t        m_size;
+        size_t              m_offset;
+    };
+}
+
 BinaryMeshFileReader::BinaryMeshFileReader(const std::string& filename)
   : m_filename(filename)
 {
@@ -56,6 +128,31 @@ BinaryMeshFileReader::BinaryMeshFileReader(const std::string& filename)
 
 void BinaryMeshFileReader::read(IMeshBuilder& builder)
 {
+    // Read the file directly from memory if it lives in a mounted archive.
+    std::vector<std::uint8_t> buffer;
+    const std::uint8_t* data;
+    size_t size;
+    if (read_virtual_file(m_filename, data, size, buffer))
+    {
+        MemoryReaderAdapter reader(data, size);
+        const std::uint16_t version = read_header(reader);
+
+        if (version == 5)
+        {
+            // Stored archive entries are not necessarily aligned in memory.
+            if (reinterpret_cast<std::uintptr_t>(data) % sizeof(std::uint32_t) != 0)
+            {
+                buffer.assign(data, data + size);
+                data = &buffer[0];
+            }
+
+            read_mappable_meshes(data, size, builder);
+        }
+        else read_meshes(reader, version, builder);
+
+        return;
+    }
+
     BufferedFile file(
         m_filename.c_str(),
         BufferedFile::BinaryType,
@@ -64,19 +161,46 @@ void BinaryMeshFileReader::read(IMeshBuilder& builder)
     if (!file.is_open())
         throw ExceptionIOError();
 
-    read_and_check_signature(file);
+    PassthroughReaderAdapter reader(file);
+    const std::uint16_t version = read_header(reader);
+
+    // Uncompressed, single-precision, page-aligned geometry.
+    if (version == 5)
+    {
+        file.close();
+        read_mappable_file(builder);
+        return;
+    }
+
+    read_meshes(reader, version, builder);
+}
+
+std::uint16_t BinaryMeshFileReader::read_header(ReaderAdapter& reader)
+{
+    static const char ExpectedSig[10] = { 'B', 'I', 'N', 'A', 'R', 'Y', 'M', 'E', 'S', 'H' };
+
+    char signature[sizeof(ExpectedSig)];
+    checked_read(reader, signature, sizeof(signature));
+
+    if (memcmp(signature, ExpectedSig, sizeof(ExpectedSig)))
+        throw ExceptionIOError("invalid binarymesh format signature");
 
     std::uint16_t version;
-    checked_read(file, version);
+    checked_read(reader, version);
+
+    return version;
+}
 
+void BinaryMeshFileReader::read_meshes(
+    ReaderAdapter&          reader,
+    const std::uint16_t     version,
+    IMeshBuilder&           builder)
+{
     switch (version)
     {
       // Uncompressed, double-precision geometry.
       case 1:
-        {
-            PassthroughReaderAdapter reader(file);
-            read_meshes<double>(reader, builder);
-        }
+        read_meshes<double>(reader, builder);
         break;
 
       // LZO-compressed, double-precision geometry.
@@ -88,16 +212,16 @@ void BinaryMeshFileReader::read(IMeshBuilder& builder)
       // LZ4-compressed, double-precision geometry.
       case 3:
         {
-            LZ4CompressedReaderAdapter reader(file);
-            read_meshes<double>(reader, builder);
+            ParallelLZ4CompressedReaderAdapter lz4_reader(reader, System::get_logical_cpu_core_count());
+            read_meshes<double>(lz4_reader, builder);
         }
         break;
 
       // LZ4-compressed, single-precision geometry.
       case 4:
         {
-            LZ4CompressedReaderAdapter reader(file);
-            read_meshes<float>(reader, builder);
+            ParallelLZ4CompressedReaderAdapter lz4_reader(reader, System::get_logical_cpu_core_count());
+            read_meshes<float>(lz4_reader, builder);
         }
         break;
 
@@ -107,17 +231,6 @@ void BinaryMeshFileReader::read(IMeshBuilder& builder)
     }
 }
 
-void BinaryMeshFileReader::read_and_check_signature(BufferedFile& file)
-{
-    static const char ExpectedSig[10] = { 'B', 'I', 'N', 'A', 'R', 'Y', 'M', 'E', 'S', 'H' };
-
-    char signature[sizeof(ExpectedSig)];
-    checked_read(file, signature, sizeof(signature));
-
-    if (memcmp(signature, ExpectedSig, sizeof(ExpectedSig)))
-        throw ExceptionIOError("invalid binarymesh format signature");
-}
-
 std::string BinaryMeshFileReader::read_string(ReaderAdapter& reader)
 {
     std::uint16_t length;
@@ -264,4 +377,115 @@ void BinaryMeshFileReader::read_face(ReaderAdapter& reader, IMeshBuilder& builde
     builder.end_face();
 }
 
+void BinaryMeshFileReader::read_mappable_file(IMeshBuilder& builder)
+{
+    namespace bi = boost::interprocess;
+
+    bi::file_mapping mapping;
+    bi::mapped_region region;
+
+    try
+    {
+        mapping = bi::file_mapping(m_filename.c_str(), bi::read_only);
+        region = bi::mapped_region(mapping, bi::read_only);
+    }
+    catch (const bi::interprocess_exception& e)
+    {
+        throw ExceptionIOError(e.what());
+    }
+
+    region.advise(bi::mapped_region::advice_sequential);
+
+    read_mappable_meshes(region.get_address(), region.get_size(), builder);
+}
+
+void BinaryMeshFileReader::read_mappable_meshes(
+    const void*             data,
+    const size_t            size,
+    IMeshBuilder&           builder)
+{
+    MappedFileCursor cursor(data, size);
+
+    // Skip the signature and the version number.
+    cursor.consume<std::uint8_t>(10 + sizeof(std::uint16_t));
+
+    while (true)
+    {
+        cursor.align_to_page();
+
+        if (cursor.at_end())
+            break;
+
+        // Header.
+        const std::string mesh_name = cursor.read_string();
+        const size_t vertex_count = cursor.read<std::uint32_t>();
+        const size_t vertex_normal_count = cursor.read<std::uint32_t>();
+        const size_t tex_coords_count = cursor.read<std::uint32_t>();
+        const size_t face_count = cursor.read<std::uint32_t>();
+        const size_t face_vertex_count = cursor.read<std::uint32_t>();
+
+        builder.begin_mesh(mesh_name.c_str());
+        builder.reserve_mesh(vertex_count, vertex_normal_count, tex_coords_count, face_count);
+
+        const size_t material_slot_count = cursor.read<std::uint16_t>();
+        for (size_t i = 0; i < material_slot_count; ++i)
+            builder.push_material_slot(cursor.read_string().c_str());
+
+        // Vertices.
+        cursor.align_to_page();
+        const Vector3f* vertices = cursor.consume<Vector3f>(vertex_count);
+        for (size_t i = 0; i < vertex_count; ++i)
+            builder.push_vertex(Vector3d(vertices[i]));
+
+        // Vertex normals.
+        cursor.align_to_page();
+        const Vector3f* vertex_normals = cursor.consume<Vector3f>(vertex_normal_count);
+        for (size_t i = 0; i < vertex_normal_count; ++i)
+            builder.push_vertex_normal(Vector3d(vertex_normals[i]));
+
+        // Texture coordinates.
+        cursor.align_to_page();
+        const Vector2f* tex_coords = cursor.consume<Vector2f>(tex_coords_count);
+        for (size_t i = 0; i < tex_coords_count; ++i)
+            builder.push_tex_coords(Vector2d(tex_coords[i]));
+
+        // Faces.
+        cursor.align_to_page();
+        const std::uint16_t* face_vertex_counts = cursor.consume<std::uint16_t>(face_count);
+        cursor.align_to_page();
+        const std::uint16_t* face_materials = cursor.consume<std::uint16_t>(face_count);
+        cursor.align_to_page();
+        const std::uint32_t* face_vertices = cursor.consume<std::uint32_t>(3 * face_vertex_count);
+        const std::uint32_t* face_vertices_end = face_vertices + 3 * face_vertex_count;
+
+        for (size_t i = 0; i < face_count; ++i)
+        {
+            const size_t count = face_vertex_counts[i];
+
+            if (static_cast<size_t>(face_vertices_end - face_vertices) < 3 * count)
+                throw ExceptionIOError("truncated binarymesh file");
+
+            ensure_minimum_size(m_vertices, count);
+            ensure_minimum_size(m_vertex_normals, count);
+            ensure_minimum_size(m_tex_coords, count);
+
+            for (size_t j = 0; j < count; ++j)
+            {
+                m_vertices[j] = *face_vertices++;
+                m_vertex_normals[j] = *face_vertices++;
+                m_tex_coords[j] = *face_vertices++;
+            }
+
+            builder.begin_face(count);
+            builder.set_face_vertices(&m_vertices[0]);
+            builder.set_face_vertex_normals(&m_vertex_normals[0]);
+            builder.set_face_vertex_tex_coords(&m_tex_coords[0]);
+            builder.set_face_material(face_materials[i]);
+            builder.end_face();
+        }
+
+        builder.end_mesh();
+    }
+}
+
 }   // namespace foundation
@@ -35,11 +35,11 @@
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 // Forward declarations.
-namespace foundation    { class BufferedFile; }
 namespace foundation    { class IMeshBuilder; }
 namespace foundation    { class ReaderAdapter; }
 
@@ -66,7 +66,8 @@ class BinaryMeshFileReader
     std::vector<size_t>     m_vertex_normals;
     std::vector<size_t>     m_tex_coords;
 
-    static void read_and_check_signature(BufferedFile& file);
+    // Check the signature and return the format version.
+    static std::uint16_t read_header(ReaderAdapter& reader);
 
     static std::string read_string(ReaderAdapter& reader);
 
@@ -77,6 +78,11 @@ class BinaryMeshFileReader
     void read_material_slots(ReaderAdapter& reader, IMeshBuilder& builder);
     void read_faces(ReaderAdapter& reader, IMeshBuilder& builder);
     void read_face(ReaderAdapter& reader, IMeshBuilder& builder);
+
+    void read_meshes(ReaderAdapter& reader, const std::uint16_t version, IMeshBuilder& builder);
+
+    void read_mappable_file(IMeshBuilder& builder);
+    void read_mappable_meshes(const void* data, const size_t size, IMeshBuilder& builder);
 };
 
 }   // namespace foundation
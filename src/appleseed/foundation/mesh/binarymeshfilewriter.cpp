@@ -34,6 +34,7 @@
 #include "foundation/core/exceptions/exceptionioerror.h"
 #include "foundation/math/vector.h"
 #include "foundation/mesh/imeshwalker.h"
+#include "foundation/platform/system.h"
 
 // Standard headers.
 #include <cstdint>
@@ -48,14 +49,30 @@ namespace foundation
 
 namespace
 {
-    // Version of the BinaryMesh file format being written by this code.
-    const std::uint16_t Version = 4;
+    // Versions of the BinaryMesh file format being written by this code.
+    const std::uint16_t CompressedVersion = 4;
+    const std::uint16_t MappableVersion = 5;
+
+    // Alignment in bytes of the sections of mappable files.
+    const std::int64_t PageSize = 4096;
 }
 
-BinaryMeshFileWriter::BinaryMeshFileWriter(const std::string& filename)
+BinaryMeshFileWriter::BinaryMeshFileWriter(
+    const std::string&  filename,
+    const Format        format,
+    const size_t        thread_count)
   : m_filename(filename)
-  , m_writer(m_file, 256 * 1024)
+  , m_format(format)
 {
+    if (m_format == CompressedFormat)
+    {
+        m_writer.reset(
+            new ParallelLZ4CompressedWriterAdapter(
+                m_file,
+                256 * 1024,
+                thread_count > 0 ? thread_count : System::get_logical_cpu_core_count()));
+    }
+    else m_writer.reset(new PassthroughWriterAdapter(m_file));
 }
 
 void BinaryMeshFileWriter::write(const IMeshWalker& walker)
@@ -74,7 +91,9 @@ void BinaryMeshFileWriter::write(const IMeshWalker& walker)
         write_version();
     }
 
-    write_mesh(walker);
+    if (m_format == CompressedFormat)
+        write_mesh(walker);
+    else write_mappable_mesh(walker);
 }
 
 void BinaryMeshFileWriter::write_signature()
@@ -85,15 +104,25 @@ void BinaryMeshFileWriter::write_signature()
 
 void BinaryMeshFileWriter::write_version()
 {
-    checked_write(m_file, Version);
+    checked_write(m_file, m_format == CompressedFormat ? CompressedVersion : MappableVersion);
+}
+
+void BinaryMeshFileWriter::align_to_page()
+{
+    static const std::uint8_t Padding[PageSize] = { 0 };
+
+    const std::int64_t remainder = m_file.tell() % PageSize;
+
+    if (remainder > 0)
+        checked_write(m_file, Padding, static_cast<size_t>(PageSize - remainder));
 }
 
 void BinaryMeshFileWriter::write_string(const char* s)
 {
     const std::uint16_t length = static_cast<std::uint16_t>(strlen(s));
 
-    checked_write(m_writer, length);
-    checked_write(m_writer, s, length);
+    checked_write(*m_writer, length);
+    checked_write(*m_writer, s, length);
 }
 
 void BinaryMeshFileWriter::write_mesh(const IMeshWalker& walker)
@@ -109,34 +138,34 @@ void BinaryMeshFileWriter::write_mesh(const IMeshWalker& walker)
 void BinaryMeshFileWriter::write_vertices(const IMeshWalker& walker)
 {
     const std::uint32_t count = static_cast<std::uint32_t>(walker.get_vertex_count());
-    checked_write(m_writer, count);
+    checked_write(*m_writer, count);
 
     for (std::uint32_t i = 0; i < count; ++i)
-        checked_write(m_writer, Vector3f(walker.get_vertex(i)));
+        checked_write(*m_writer, Vector3f(walker.get_vertex(i)));
 }
 
 void BinaryMeshFileWriter::write_vertex_normals(const IMeshWalker& walker)
 {
     const std::uint32_t count = static_cast<std::uint32_t>(walker.get_vertex_normal_count());
-    checked_write(m_writer, count);
+    checked_write(*m_writer, count);
 
     for (std::uint32_t i = 0; i < count; ++i)
-        checked_write(m_writer, Vector3f(walker.get_vertex_normal(i)));
+        checked_write(*m_writer, Vector3f(walker.get_vertex_normal(i)));
 }
 
 void BinaryMeshFileWriter::write_texture_coordinates(const IMeshWalker& walker)
 {
     const std::uint32_t count = static_cast<std::uint32_t>(walker.get_tex_coords_count());
-    checked_write(m_writer, count);
+    checked_write(*m_writer, count);
 
     for (std::uint32_t i = 0; i < count; ++i)
-        checked_write(m_writer, Vector2f(walker.get_tex_coords(i)));
+        checked_write(*m_writer, Vector2f(walker.get_tex_coords(i)));
 }
 
 void BinaryMeshFileWriter::write_material_slots(const IMeshWalker& walker)
 {
     const std::uint16_t count = static_cast<std::uint16_t>(walker.get_material_slot_count());
-    checked_write(m_writer, count);
+    checked_write(*m_writer, count);
 
     for (std::uint16_t i = 0; i < count; ++i)
         write_string(walker.get_material_slot(i));
@@ -145,7 +174,7 @@ void BinaryMeshFileWriter::write_material_slots(const IMeshWalker& walker)
 void BinaryMeshFileWriter::write_faces(const IMeshWalker& walker)
 {
     const std::uint32_t count = static_cast<std::uint32_t>(walker.get_face_count());
-    checked_write(m_writer, count);
+    checked_write(*m_writer, count);
 
     for (std::uint32_t i = 0; i < count; ++i)
         write_face(walker, i);
@@ -154,16 +183,75 @@ void BinaryMeshFileWriter::write_faces(const IMeshWalker& walker)
 void BinaryMeshFileWriter::write_face(const IMeshWalker& walker, const size_t face_index)
 {
     const std::uint16_t count = static_cast<std::uint16_t>(walker.get_face_vertex_count(face_index));
-    checked_write(m_writer, count);
+    checked_write(*m_writer, count);
 
     for (std::uint16_t i = 0; i < count; ++i)
     {
-        checked_write(m_writer, static_cast<std::uint32_t>(walker.get_face_vertex(face_index, i)));
-        checked_write(m_writer, static_cast<std::uint32_t>(walker.get_face_vertex_normal(face_index, i)));
-        checked_write(m_writer, static_cast<std::uint32_t>(walker.get_face_tex_coords(face_index, i)));
+        checked_write(*m_writer, static_cast<std::uint32_t>(walker.get_face_vertex(face_index, i)));
+        checked_write(*m_writer, static_cast<std::uint32_t>(walker.get_face_vertex_normal(face_index, i)));
+        checked_write(*m_writer, static_cast<std::uint32_t>(walker.get_face_tex_coords(face_index, i)));
     }
 
-    checked_write(m_writer, static_cast<std::uint16_t>(walker.get_face_material(face_index)));
+    checked_write(*m_writer, static_cast<std::uint16_t>(walker.get_face_material(face_index)));
+}
+
+void BinaryMeshFileWriter::write_mappable_mesh(const IMeshWalker& walker)
+{
+    const size_t vertex_count = walker.get_vertex_count();
+    const size_t vertex_normal_count = walker.get_vertex_normal_count();
+    const size_t tex_coords_count = walker.get_tex_coords_count();
+    const size_t face_count = walker.get_face_count();
+
+    size_t face_vertex_count = 0;
+    for (size_t i = 0; i < face_count; ++i)
+        face_vertex_count += walker.get_face_vertex_count(i);
+
+    // Header.
+    align_to_page();
+    write_string(walker.get_name());
+    checked_write(m_file, static_cast<std::uint32_t>(vertex_count));
+    checked_write(m_file, static_cast<std::uint32_t>(vertex_normal_count));
+    checked_write(m_file, static_cast<std::uint32_t>(tex_coords_count));
+    checked_write(m_file, static_cast<std::uint32_t>(face_count));
+    checked_write(m_file, static_cast<std::uint32_t>(face_vertex_count));
+    write_material_slots(walker);
+
+    // Vertices.
+    align_to_page();
+    for (size_t i = 0; i < vertex_count; ++i)
+        checked_write(m_file, Vector3f(walker.get_vertex(i)));
+
+    // Vertex normals.
+    align_to_page();
+    for (size_t i = 0; i < vertex_normal_count; ++i)
+        checked_write(m_file, Vector3f(walker.get_vertex_normal(i)));
+
+    // Texture coordinates.
+    align_to_page();
+    for (size_t i = 0; i < tex_coords_count; ++i)
+        checked_write(m_file, Vector2f(walker.get_tex_coords(i)));
+
+    // Number of vertices of each face.
+    align_to_page();
+    for (size_t i = 0; i < face_count; ++i)
+        checked_write(m_file, static_cast<std::uint16_t>(walker.get_face_vertex_count(i)));
+
+    // Material of each face.
+    align_to_page();
+    for (size_t i = 0; i < face_count; ++i)
+        checked_write(m_file, static_cast<std::uint16_t>(walker.get_face_material(i)));
+
+    // Vertex, vertex normal and texture coordinates indices of each face vertex.
+    align_to_page();
+    for (size_t i = 0; i < face_count; ++i)
+    {
+        for (size_t j = 0, e = walker.get_face_vertex_count(i); j < e; ++j)
+        {
+            checked_write(m_file, static_cast<std::uint32_t>(walker.get_face_vertex(i, j)));
+            checked_write(m_file, static_cast<std::uint32_t>(walker.get_face_vertex_normal(i, j)));
+            checked_write(m_file, static_cast<std::uint32_t>(walker.get_face_tex_coords(i, j)));
+        }
+    }
 }
 
 }   // namespace foundation
@@ -36,6 +36,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <memory>
 #include <string>
 
 // Forward declarations.
@@ -47,24 +48,42 @@ namespace foundation
 //
 // Writer for a simple binary mesh file format.
 //
+// Two variants of the format can be written:
+//
+//   - compressed: the whole file is LZ4-compressed (the default).
+//
+//   - mappable: nothing is compressed and every array of every mesh starts on a page
+//     boundary, so that readers can memory-map the file and read arrays in place.
+//
 
 class BinaryMeshFileWriter
   : public IMeshFileWriter
 {
   public:
-    // Constructor.
-    explicit BinaryMeshFileWriter(const std::string& filename);
+    enum Format
+    {
+        CompressedFormat,
+        MappableFormat
+    };
+
+    // Constructor. Compressed files are compressed using thread_count threads (0 for one per core).
+    explicit BinaryMeshFileWriter(
+        const std::string&      filename,
+        const Format            format = CompressedFormat,
+        const size_t            thread_count = 0);
 
     // Write a mesh.
     void write(const IMeshWalker& walker) override;
 
   private:
-    const std::string           m_filename;
-    BufferedFile                m_file;
-    LZ4CompressedWriterAdapter  m_writer;
+    const std::string               m_filename;
+    const Format                    m_format;
+    BufferedFile                    m_file;
+    std::unique_ptr<WriterAdapter>  m_writer;
 
     void write_signature();
     void write_version();
+    void align_to_page();
 
     void write_string(const char* s);
     void write_mesh(const IMeshWalker& walker);
@@ -74,6 +93,7 @@ class BinaryMeshFileWriter
     void write_material_slots(const IMeshWalker& walker);
     void write_faces(const IMeshWalker& walker);
     void write_face(const IMeshWalker& walker, const size_t face_index);
+    void write_mappable_mesh(const IMeshWalker& walker);
 };
 
 }   // namespace foundation
@@ -36,6 +36,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace foundation    { class IMeshWalker; }
 
@@ -50,8 +53,10 @@ class APPLESEED_DLLSYMBOL GenericMeshFileWriter
   : public IMeshFileWriter
 {
   public:
-    // Constructor.
-    explicit GenericMeshFileWriter(const char* filename);
+    // Constructor. Compressed formats are compressed using thread_count threads (0 for one per core).
+    explicit GenericMeshFileWriter(
+        const char*         filename,
+        const std::size_t   thread_count = 0);
 
     // Destructor.
     ~GenericMeshFileWriter() override;
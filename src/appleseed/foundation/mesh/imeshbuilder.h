@@ -56,6 +56,14 @@ class APPLESEED_DLLSYMBOL IMeshBuilder
     // Begin the definition of a mesh.
     virtual void begin_mesh(const char* name) = 0;
 
+    // Optionally reserve memory for the mesh being defined. Readers that know
+    // the size of a mesh upfront call this method right after begin_mesh().
+    virtual void reserve_mesh(
+        const size_t            vertex_count,
+        const size_t            vertex_normal_count,
+        const size_t            tex_coords_count,
+        const size_t            face_count) {}
+
     // Append a vertex to the mesh.
     // Return the index of the vertex within the mesh.
     virtual size_t push_vertex(const Vector3d& v) = 0;
@@ -64,6 +64,8 @@ class OBJMeshFileLexer
       : m_parsing_mode(parsing_mode)
       , m_eof(false)
       , m_line_number(0)
+      , m_memory_ptr(nullptr)
+      , m_memory_end(nullptr)
       , m_line(4096)
       , m_line_size(0)
       , m_line_index(0)
@@ -95,16 +97,40 @@ class OBJMeshFileLexer
         return true;
     }
 
-    // Close the input file.
+    // Open an input buffer, for instance a portion of a file loaded in memory.
+    // The buffer must remain valid until the lexer is closed.
+    void open(const char* begin, const char* end)
+    {
+        m_eof = false;
+        m_line_number = 0;
+        m_line_size = 0;
+        m_line_index = 0;
+
+        m_memory_ptr = begin;
+        m_memory_end = end;
+
+        read_next_line();
+    }
+
+    // Close the input file or buffer.
     void close()
     {
         m_file.close();
+
+        m_memory_ptr = nullptr;
+        m_memory_end = nullptr;
+    }
+
+    // Return true if an input file or buffer is open.
+    bool is_open() const
+    {
+        return m_file.is_open() || m_memory_ptr != nullptr;
     }
 
     // Return the position of the current line in the file.
     size_t get_line_number() const
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         return m_line_number;
     }
@@ -112,7 +138,7 @@ class OBJMeshFileLexer
     // Return the current character in the line.
     APPLESEED_FORCE_INLINE unsigned char get_char() const
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         return m_line_index == m_line_size ? '\n' : m_line[m_line_index];
     }
@@ -120,7 +146,7 @@ class OBJMeshFileLexer
     // Advance to the next character in the line.
     APPLESEED_FORCE_INLINE void next_char()
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         if (m_line_index < m_line_size)
             ++m_line_index;
@@ -140,7 +166,7 @@ class OBJMeshFileLexer
     // Return true if the end of the line has been reached.
     APPLESEED_FORCE_INLINE bool is_eol() const
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         return m_line_index == m_line_size;
     }
@@ -148,7 +174,7 @@ class OBJMeshFileLexer
     // Return true if the end of the file has been reached.
     APPLESEED_FORCE_INLINE bool is_eof() const
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         return m_eof && is_eol();
     }
@@ -156,7 +182,7 @@ class OBJMeshFileLexer
     // Eat blank characters and comments.
     void eat_blanks()
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         while (true)
         {
@@ -191,7 +217,7 @@ class OBJMeshFileLexer
     // Accept a end-of-line character, or generate a parse error.
     void accept_newline()
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         if (!is_eol())
             parse_error();
@@ -202,7 +228,7 @@ class OBJMeshFileLexer
     // Accept a string of non-blank characters, or generate a parse error.
     void accept_string(const char** begin, size_t* length)
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         if (is_eof())
             parse_error();
@@ -235,7 +261,7 @@ class OBJMeshFileLexer
     // Accept a long integer, or generate a parse error.
     APPLESEED_FORCE_INLINE long accept_long()
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         // Read an integer value at the current position in the line.
         const char* base_ptr = &m_line[0];
@@ -254,7 +280,7 @@ class OBJMeshFileLexer
     // Accept a double-precision floating point number, or generate a parse error.
     APPLESEED_FORCE_INLINE double accept_double()
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         // Read a floating-point value at the current position in the line.
         char* base_ptr = &m_line[0];
@@ -280,6 +306,8 @@ class OBJMeshFileLexer
     BufferedFile        m_file;
     bool                m_eof;              // has the end of the file been reached?
     size_t              m_line_number;      // position of the current line in the file
+    const char*         m_memory_ptr;       // next character of the input buffer, if reading from memory
+    const char*         m_memory_end;       // end of the input buffer, if reading from memory
     std::vector<char>   m_line;             // current line
     size_t              m_line_size;        // size of the current line (not counting the zero terminator)
     size_t              m_line_index;       // position of the cursor in the current line
@@ -287,14 +315,14 @@ class OBJMeshFileLexer
     // Close the input file and throw an ExceptionParseError exception.
     void parse_error()
     {
-        m_file.close();
+        close();
         throw OBJMeshFileReader::ExceptionParseError(m_line_number);
     }
 
     // Read the next line from the input file.
     void read_next_line()
     {
-        assert(m_file.is_open());
+        assert(is_open());
 
         m_line_size = 0;
 
@@ -304,9 +332,9 @@ class OBJMeshFileLexer
 
             while (m_line_size < m_line.size() - 1)
             {
-                // Read one character from the file.
+                // Read one character from the file or buffer.
                 char c;
-                if (m_file.read(&c) < 1)
+                if (!read_char(c))
                 {
                     // Reached the end of the file.
                     m_eof = true;
@@ -325,6 +353,22 @@ class OBJMeshFileLexer
         // Append a null terminator.
         m_line[m_line_size] = 0;
     }
+
+    // Read the next character from the input file or buffer.
+    // Return false if the end of the input has been reached.
+    APPLESEED_FORCE_INLINE bool read_char(char& c)
+    {
+        if (m_memory_ptr != nullptr)
+        {
+            if (m_memory_ptr == m_memory_end)
+                return false;
+
+            c = *m_memory_ptr++;
+            return true;
+        }
+
+        return m_file.read(&c) == 1;
+    }
 };
 
 }   // namespace foundation
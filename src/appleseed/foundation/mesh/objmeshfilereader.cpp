@@ -32,17 +32,31 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/log/logger.h"
 #include "foundation/math/vector.h"
 #include "foundation/memory/memory.h"
 #include "foundation/mesh/imeshbuilder.h"
 #include "foundation/mesh/objmeshfilelexer.h"
+#include "foundation/platform/system.h"
+#include "foundation/utility/bufferedfile.h"
+#include "foundation/utility/job.h"
+
+// Boost headers.
+#include "boost/filesystem.hpp"
 
 // Standard headers.
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <exception>
 #include <map>
+#include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
+namespace bf = boost::filesystem;
+
 namespace foundation
 {
 
@@ -53,234 +67,357 @@ namespace foundation
 namespace
 {
     const size_t Undefined = ~size_t(0);
-}
 
-struct OBJMeshFileReader::Impl
-{
-    const int                         m_options;
-    IMeshBuilder&                     m_builder;
-    OBJMeshFileLexer                  m_lexer;
+    //
+    // Recognize OBJ statements and forward them to a handler.
+    //
 
-    // Current state.
-    bool                              m_inside_mesh_def;              // currently inside a mesh definition?
-    std::string                       m_current_mesh_name;            // name of the current mesh
-    std::map<std::string, size_t>     m_material_slots;               // material slots for the current mesh
-    size_t                            m_current_material_slot_index;  // index of the current material slot
+    template <typename Handler>
+    class OBJParser
+    {
+      public:
+        OBJParser(
+            OBJMeshFileLexer&   lexer,
+            Handler&            handler)
+          : m_lexer(lexer)
+          , m_handler(handler)
+        {
+        }
 
-    // Features defined in the file.
-    std::vector<Vector3d>             m_vertices;
-    std::vector<Vector2d>             m_tex_coords;
-    std::vector<Vector3d>             m_normals;
+        void parse()
+        {
+            while (true)
+            {
+                m_lexer.eat_blanks();
 
-    // Mappings between internal indices and mesh indices.
-    std::vector<size_t>               m_vertex_index_mapping;
-    std::vector<size_t>               m_tex_coord_index_mapping;
-    std::vector<size_t>               m_normal_index_mapping;
+                // Handle end of file.
+                if (m_lexer.is_eof())
+                    break;
 
-    // Temporary vectors for collecting indices while parsing face statements.
-    std::vector<size_t>               m_face_vertex_indices;
-    std::vector<size_t>               m_face_tex_coord_indices;
-    std::vector<size_t>               m_face_normal_indices;
+                // Handle empty lines.
+                if (m_lexer.is_eol())
+                {
+                    m_lexer.accept_newline();
+                    continue;
+                }
 
-    // Constructor.
-    Impl(
-        const int           options,
-        IMeshBuilder&       builder)
-      : m_options(options)
-      , m_builder(builder)
-      , m_lexer(
-            (options & FavorSpeedOverPrecision)
-                ? OBJMeshFileLexer::Fast
-                : OBJMeshFileLexer::Precise)
-      , m_inside_mesh_def(false)
-      , m_current_material_slot_index(0)
-    {
-    }
+                const char* keyword;
+                size_t keyword_length;
 
-    // Close the input file and throw an ExceptionParseError exception.
-    void parse_error()
-    {
-        const size_t line_number = m_lexer.get_line_number();
+                m_lexer.accept_string(&keyword, &keyword_length);
+
+                if (keyword_length == 1)
+                {
+                    switch (keyword[0])
+                    {
+                      case 'f':
+                        parse_f_statement();
+                        break;
+
+                      case 'g':
+                      case 'o':
+                        m_handler.on_object_or_group(parse_compound_identifier());
+                        break;
+
+                      case 'v':
+                        parse_v_statement();
+                        break;
+
+                      default:
+                        // Ignore unknown or unhandled statements.
+                        m_lexer.eat_line();
+                        continue;
+                    }
+                }
+                else if (keyword_length == 2)
+                {
+                    switch (keyword[0] * 256 + keyword[1])
+                    {
+                      case 'v' * 256 + 'n':
+                        parse_vn_statement();
+                        break;
+
+                      case 'v' * 256 + 't':
+                        parse_vt_statement();
+                        break;
+
+                      default:
+                        // Ignore unknown or unhandled statements.
+                        m_lexer.eat_line();
+                        continue;
+                    }
+                }
+                else if (strncmp(keyword, "usemtl", keyword_length) == 0)
+                {
+                    m_handler.on_usemtl(parse_compound_identifier());
+                }
+                else
+                {
+                    // Ignore unknown or unhandled statements.
+                    m_lexer.eat_line();
+                    continue;
+                }
 
-        m_lexer.close();
+                m_lexer.eat_blanks();
+                m_lexer.accept_newline();
+            }
+        }
 
-        throw ExceptionParseError(line_number);
-    }
+      private:
+        OBJMeshFileLexer&   m_lexer;
+        Handler&            m_handler;
 
-    void parse_file()
-    {
-        while (true)
-        {
-            m_lexer.eat_blanks();
+        // Temporary vectors for collecting indices while parsing face statements.
+        std::vector<long>   m_face_vertex_indices;
+        std::vector<long>   m_face_tex_coord_indices;
+        std::vector<long>   m_face_normal_indices;
 
-            // Handle end of file.
-            if (m_lexer.is_eof())
-                break;
+        // Close the input file and throw an ExceptionParseError exception.
+        void parse_error()
+        {
+            const size_t line_number = m_lexer.get_line_number();
 
-            // Handle empty lines.
-            if (m_lexer.is_eol())
-            {
-                m_lexer.accept_newline();
-                continue;
-            }
+            m_lexer.close();
 
-            const char* keyword;
-            size_t keyword_length;
+            throw OBJMeshFileReader::ExceptionParseError(line_number);
+        }
 
-            m_lexer.accept_string(&keyword, &keyword_length);
+        void parse_f_statement()
+        {
+            clear_keep_memory(m_face_vertex_indices);
+            clear_keep_memory(m_face_tex_coord_indices);
+            clear_keep_memory(m_face_normal_indices);
 
-            if (keyword_length == 1)
+            while (true)
             {
-                switch (keyword[0])
-                {
-                  case 'f':
-                    parse_f_statement();
-                    break;
+                m_lexer.eat_blanks();
 
-                  case 'g':
-                  case 'o':
-                    parse_o_g_statement();
+                if (m_lexer.is_eol())
                     break;
 
-                  case 'v':
-                    parse_v_statement();
-                    break;
+                //
+                // Recognized (epsilon)
+                // Accept n
+                //
 
-                  default:
-                    // Ignore unknown or unhandled statements.
-                    m_lexer.eat_line();
-                    continue;
+                m_face_vertex_indices.push_back(m_lexer.accept_long());
+
+                //
+                // Recognized n
+                // Accept (epsilon), /
+                //
+
+                {
+                    const unsigned char c = m_lexer.get_char();
+                    if (m_lexer.is_space(c))
+                        continue;
+                    else if (c == '/')
+                        m_lexer.next_char();
+                    else parse_error();
                 }
-            }
-            else if (keyword_length == 2)
-            {
-                switch (keyword[0] * 256 + keyword[1])
+
+                //
+                // Recognized n/
+                // Accept /, n
+                //
+
                 {
-                  case 'v' * 256 + 'n':
-                    parse_vn_statement();
-                    break;
+                    const unsigned char c = m_lexer.get_char();
+                    if (c == '/')
+                    {
+                        m_lexer.next_char();
+                        goto skip;
+                    }
+                    else m_face_tex_coord_indices.push_back(m_lexer.accept_long());
+                }
 
-                  case 'v' * 256 + 't':
-                    parse_vt_statement();
-                    break;
+                //
+                // Recognized n/n
+                // Accept (epsilon), /
+                //
 
-                  default:
-                    // Ignore unknown or unhandled statements.
-                    m_lexer.eat_line();
-                    continue;
+                {
+                    const unsigned char c = m_lexer.get_char();
+                    if (m_lexer.is_space(c))
+                        continue;
+                    else if (c == '/')
+                        m_lexer.next_char();
+                    else parse_error();
+                }
+
+              skip:
+
+                //
+                // Recognized n//, n/n/
+                // Accept (epsilon), n
+                //
+
+                {
+                    const unsigned char c = m_lexer.get_char();
+                    if (m_lexer.is_space(c))
+                        continue;
+                    else m_face_normal_indices.push_back(m_lexer.accept_long());
                 }
             }
-            else if (strncmp(keyword, "usemtl", keyword_length) == 0)
-            {
-                parse_usemtl_statement();
-            }
-            else
+
+            m_handler.on_face(
+                m_face_vertex_indices.data(), m_face_vertex_indices.size(),
+                m_face_tex_coord_indices.data(), m_face_tex_coord_indices.size(),
+                m_face_normal_indices.data(), m_face_normal_indices.size(),
+                m_lexer.get_line_number());
+        }
+
+        std::string parse_compound_identifier()
+        {
+            std::string identifier;
+
+            m_lexer.eat_blanks();
+
+            while (!m_lexer.is_eol())
             {
-                // Ignore unknown or unhandled statements.
-                m_lexer.eat_line();
-                continue;
+                const char* token;
+                size_t token_length;
+
+                m_lexer.accept_string(&token, &token_length);
+                m_lexer.eat_blanks();
+
+                if (!identifier.empty())
+                    identifier += ' ';
+
+                identifier.append(token, token_length);
             }
 
+            return identifier;
+        }
+
+        void parse_v_statement()
+        {
+            Vector3d v;
+
             m_lexer.eat_blanks();
-            m_lexer.accept_newline();
+            v.x = m_lexer.accept_double();
+
+            m_lexer.eat_blanks();
+            v.y = m_lexer.accept_double();
+
+            m_lexer.eat_blanks();
+            v.z = m_lexer.accept_double();
+
+            m_lexer.eat_blanks();
+
+            if (!m_lexer.is_eol())
+                m_lexer.accept_double();
+
+            m_handler.on_vertex(v);
         }
 
-        // End the definition of the last object.
-        if (m_inside_mesh_def)
-            m_builder.end_mesh();
-    }
+        void parse_vt_statement()
+        {
+            Vector2d v;
 
-    void parse_f_statement()
-    {
-        clear_keep_memory(m_face_vertex_indices);
-        clear_keep_memory(m_face_tex_coord_indices);
-        clear_keep_memory(m_face_normal_indices);
+            m_lexer.eat_blanks();
+            v.x = m_lexer.accept_double();
 
-        while (true)
+            m_lexer.eat_blanks();
+            v.y = m_lexer.accept_double();
+
+            m_lexer.eat_blanks();
+
+            if (!m_lexer.is_eol())
+                m_lexer.accept_double();
+
+            m_handler.on_tex_coords(v);
+        }
+
+        void parse_vn_statement()
         {
+            Vector3d n;
+
             m_lexer.eat_blanks();
+            n.x = m_lexer.accept_double();
 
-            if (m_lexer.is_eol())
-                break;
+            m_lexer.eat_blanks();
+            n.y = m_lexer.accept_double();
 
-            //
-            // Recognized (epsilon)
-            // Accept n
-            //
+            m_lexer.eat_blanks();
+            n.z = m_lexer.accept_double();
 
-            {
-                const long n = m_lexer.accept_long();
-                const size_t v = fix_index(n, m_vertices.size());
-                m_face_vertex_indices.push_back(v);
-            }
+            m_handler.on_normal(n);
+        }
+    };
+}
 
-            //
-            // Recognized n
-            // Accept (epsilon), /
-            //
+//
+// Turn OBJ statements into calls to a mesh builder.
+//
 
-            {
-                const unsigned char c = m_lexer.get_char();
-                if (m_lexer.is_space(c))
-                    continue;
-                else if (c == '/')
-                    m_lexer.next_char();
-                else parse_error();
-            }
+struct OBJMeshFileReader::Impl
+{
+    const int                         m_options;
+    IMeshBuilder&                     m_builder;
 
-            //
-            // Recognized n/
-            // Accept /, n
-            //
+    // Current state.
+    bool                              m_inside_mesh_def;              // currently inside a mesh definition?
+    std::string                       m_current_mesh_name;            // name of the current mesh
+    std::map<std::string, size_t>     m_material_slots;               // material slots for the current mesh
+    size_t                            m_current_material_slot_index;  // index of the current material slot
 
-            {
-                const unsigned char c = m_lexer.get_char();
-                if (c == '/')
-                {
-                    m_lexer.next_char();
-                    goto skip;
-                }
-                else
-                {
-                    const long n = m_lexer.accept_long();
-                    const size_t vt = fix_index(n, m_tex_coords.size());
-                    m_face_tex_coord_indices.push_back(vt);
-                }
-            }
+    // Features defined in the file.
+    std::vector<Vector3d>             m_vertices;
+    std::vector<Vector2d>             m_tex_coords;
+    std::vector<Vector3d>             m_normals;
 
-            //
-            // Recognized n/n
-            // Accept (epsilon), /
-            //
+    // Mappings between internal indices and mesh indices.
+    std::vector<size_t>               m_vertex_index_mapping;
+    std::vector<size_t>               m_tex_coord_index_mapping;
+    std::vector<size_t>               m_normal_index_mapping;
 
-            {
-                const unsigned char c = m_lexer.get_char();
-                if (m_lexer.is_space(c))
-                    continue;
-                else if (c == '/')
-                    m_lexer.next_char();
-                else parse_error();
-            }
+    // Temporary vectors for collecting indices of face statements.
+    std::vector<size_t>               m_face_vertex_indices;
+    std::vector<size_t>               m_face_tex_coord_indices;
+    std::vector<size_t>               m_face_normal_indices;
 
-          skip:
+    // Constructor.
+    Impl(
+        const int           options,
+        IMeshBuilder&       builder)
+      : m_options(options)
+      , m_builder(builder)
+      , m_inside_mesh_def(false)
+      , m_current_material_slot_index(0)
+    {
+    }
 
-            //
-            // Recognized n//, n/n/
-            // Accept (epsilon), n
-            //
+    void read_file(const std::string& filename);
+    void read_file_parallel(const std::string& filename);
 
-            {
-                const unsigned char c = m_lexer.get_char();
-                if (m_lexer.is_space(c))
-                    continue;
-                else
-                {
-                    const long n = m_lexer.accept_long();
-                    const size_t vn = fix_index(n, m_normals.size());
-                    m_face_normal_indices.push_back(vn);
-                }
-            }
-        }
+    void on_vertex(const Vector3d& v)
+    {
+        m_vertices.push_back(v);
+    }
+
+    void on_tex_coords(const Vector2d& v)
+    {
+        m_tex_coords.push_back(v);
+    }
+
+    void on_normal(const Vector3d& n)
+    {
+        m_normals.push_back(n);
+    }
+
+    void on_face(
+        const long*         vertex_indices,
+        const size_t        vertex_index_count,
+        const long*         tex_coord_indices,
+        const size_t        tex_coord_index_count,
+        const long*         normal_indices,
+        const size_t        normal_index_count,
+        const size_t        line_number)
+    {
+        fix_indices(vertex_indices, vertex_index_count, m_vertices.size(), m_face_vertex_indices, line_number);
+        fix_indices(tex_coord_indices, tex_coord_index_count, m_tex_coords.size(), m_face_tex_coord_indices, line_number);
+        fix_indices(normal_indices, normal_index_count, m_normals.size(), m_face_normal_indices, line_number);
 
         // Check whether the face is well-formed.
         const size_t vc = m_face_vertex_indices.size();
@@ -300,32 +437,90 @@ struct OBJMeshFileReader::Impl
         {
             // The face is ill-formed, ignore it or abort parsing.
             if (m_options & StopOnInvalidFaceDef)
-                throw ExceptionInvalidFaceDef(m_lexer.get_line_number());
+                throw ExceptionInvalidFaceDef(line_number);
+        }
+    }
+
+    void on_object_or_group(const std::string& upcoming_mesh_name)
+    {
+        // Start a new mesh only if the name of the object or group actually changes.
+        if (upcoming_mesh_name != m_current_mesh_name)
+        {
+            // End the current mesh.
+            if (m_inside_mesh_def)
+            {
+                m_builder.end_mesh();
+                m_inside_mesh_def = false;
+            }
+
+            clear_keep_memory(m_vertex_index_mapping);
+            clear_keep_memory(m_tex_coord_index_mapping);
+            clear_keep_memory(m_normal_index_mapping);
+
+            m_current_mesh_name = upcoming_mesh_name;
+        }
+    }
+
+    void on_usemtl(const std::string& material_slot_name)
+    {
+        // Begin a mesh definition if we're not already inside one.
+        ensure_mesh_def();
+
+        // Check whether this material slot has already been defined for this mesh.
+        const std::map<std::string, size_t>::const_iterator& it =
+            m_material_slots.find(material_slot_name);
+
+        if (it != m_material_slots.end())
+        {
+            // It has: just make it the active material slot.
+            m_current_material_slot_index = it->second;
+        }
+        else
+        {
+            // It hasn't: insert it into the mesh and make it the active material slot.
+            m_current_material_slot_index = m_builder.push_material_slot(material_slot_name.c_str());
+            m_material_slots.insert(std::make_pair(material_slot_name, m_current_material_slot_index));
         }
     }
 
+    void on_end()
+    {
+        // End the definition of the last object.
+        if (m_inside_mesh_def)
+            m_builder.end_mesh();
+    }
+
     // Convert 1-based indices (including negative indices) to 0-based indices.
-    size_t fix_index(const long index, const size_t count)
+    static void fix_indices(
+        const long*             indices,
+        const size_t            index_count,
+        const size_t            count,
+        std::vector<size_t>&    fixed_indices,
+        const size_t            line_number)
+    {
+        clear_keep_memory(fixed_indices);
+
+        for (size_t i = 0; i < index_count; ++i)
+            fixed_indices.push_back(fix_index(indices[i], count, line_number));
+    }
+
+    static size_t fix_index(const long index, const size_t count, const size_t line_number)
     {
         if (index > 0)
         {
             const size_t i = static_cast<size_t>(index);
             if (i > count)
-                parse_error();
+                throw ExceptionParseError(line_number);
             return i - 1;
         }
         else if (index < 0)
         {
             const size_t i = static_cast<size_t>(-index);
             if (i > count)
-                parse_error();
+                throw ExceptionParseError(line_number);
             return count - i;
         }
-        else
-        {
-            parse_error();
-            return 0;       // keep the compiler happy
-        }
+        else throw ExceptionParseError(line_number);
     }
 
     void insert_face_into_mesh()
@@ -415,146 +610,367 @@ struct OBJMeshFileReader::Impl
             indices[i] = mapping[indices[i]];
     }
 
-    void parse_o_g_statement()
+    void ensure_mesh_def()
     {
-        // Retrieve the name of the upcoming mesh.
-        const std::string upcoming_mesh_name = parse_compound_identifier();
-
-        // Start a new mesh only if the name of the object or group actually changes.
-        if (upcoming_mesh_name != m_current_mesh_name)
+        if (!m_inside_mesh_def)
         {
-            // End the current mesh.
-            if (m_inside_mesh_def)
-            {
-                m_builder.end_mesh();
-                m_inside_mesh_def = false;
-            }
-
-            clear_keep_memory(m_vertex_index_mapping);
-            clear_keep_memory(m_tex_coord_index_mapping);
-            clear_keep_memory(m_normal_index_mapping);
+            // Begin the definition of the new mesh.
+            m_builder.begin_mesh(m_current_mesh_name.c_str());
+            m_inside_mesh_def = true;
 
-            m_current_mesh_name = upcoming_mesh_name;
+            // Clear material slot definitions.
+            m_material_slots.clear();
+            m_current_material_slot_index = 0;
         }
     }
+};
 
-    std::string parse_compound_identifier()
-    {
-        std::string identifier;
+void OBJMeshFileReader::Impl::read_file(const std::string& filename)
+{
+    OBJMeshFileLexer lexer(
+        (m_options & FavorSpeedOverPrecision)
+            ? OBJMeshFileLexer::Fast
+            : OBJMeshFileLexer::Precise);
+
+    // Open the input file.
+    if (!lexer.open(filename))
+        throw ExceptionIOError();
+
+    // Parse the file.
+    OBJParser<Impl> parser(lexer, *this);
+    parser.parse();
+    on_end();
+
+    // Close the input file.
+    lexer.close();
+}
+
+namespace
+{
+    // Minimum size in bytes of the portions of a file that are lexed in parallel.
+    const size_t MinChunkSize = 4 * 1024 * 1024;
+
+    // Number of chunks per thread, so that threads stay busy when chunks take unequal times.
+    const size_t ChunksPerThread = 4;
+
+    //
+    // Record the statements of a portion of an OBJ file, to be replayed in file order.
+    // Face indices are kept as they appear in the file since relative indices can only
+    // be resolved once the number of features declared by previous chunks is known.
+    //
 
-        m_lexer.eat_blanks();
+    class OBJStatementRecorder
+    {
+      public:
+        std::vector<Vector3d>   m_vertices;
+        std::vector<Vector2d>   m_tex_coords;
+        std::vector<Vector3d>   m_normals;
 
-        while (!m_lexer.is_eol())
+        void on_vertex(const Vector3d& v)
         {
-            const char* token;
-            size_t token_length;
+            m_vertices.push_back(v);
+            push_feature_statement(Statement::Vertices);
+        }
 
-            m_lexer.accept_string(&token, &token_length);
-            m_lexer.eat_blanks();
+        void on_tex_coords(const Vector2d& v)
+        {
+            m_tex_coords.push_back(v);
+            push_feature_statement(Statement::TexCoords);
+        }
 
-            if (!identifier.empty())
-                identifier += ' ';
+        void on_normal(const Vector3d& n)
+        {
+            m_normals.push_back(n);
+            push_feature_statement(Statement::Normals);
+        }
 
-            identifier.append(token, token_length);
+        void on_face(
+            const long*         vertex_indices,
+            const size_t        vertex_index_count,
+            const long*         tex_coord_indices,
+            const size_t        tex_coord_index_count,
+            const long*         normal_indices,
+            const size_t        normal_index_count,
+            const size_t        line_number)
+        {
+            m_face_indices.insert(m_face_indices.end(), vertex_indices, vertex_indices + vertex_index_count);
+            m_face_indices.insert(m_face_indices.end(), tex_coord_indices, tex_coord_indices + tex_coord_index_count);
+            m_face_indices.insert(m_face_indices.end(), normal_indices, normal_indices + normal_index_count);
+
+            Statement statement;
+            statement.m_type = Statement::Face;
+            statement.m_line_number = line_number;
+            statement.m_counts[0] = vertex_index_count;
+            statement.m_counts[1] = tex_coord_index_count;
+            statement.m_counts[2] = normal_index_count;
+            m_statements.push_back(statement);
         }
 
-        return identifier;
-    }
+        void on_object_or_group(const std::string& name)
+        {
+            push_name_statement(Statement::ObjectOrGroup, name);
+        }
 
-    void parse_v_statement()
-    {
-        Vector3d v;
+        void on_usemtl(const std::string& name)
+        {
+            push_name_statement(Statement::UseMtl, name);
+        }
 
-        m_lexer.eat_blanks();
-        v.x = m_lexer.accept_double();
+        // Send the recorded statements to a handler, in the order they were encountered.
+        template <typename Handler>
+        void replay(Handler& handler, const size_t first_line_number) const
+        {
+            size_t vertex_index = 0;
+            size_t tex_coord_index = 0;
+            size_t normal_index = 0;
+            size_t face_index = 0;
 
-        m_lexer.eat_blanks();
-        v.y = m_lexer.accept_double();
+            for (const Statement& statement : m_statements)
+            {
+                switch (statement.m_type)
+                {
+                  case Statement::Vertices:
+                    for (size_t i = 0; i < statement.m_counts[0]; ++i)
+                        handler.on_vertex(m_vertices[vertex_index++]);
+                    break;
 
-        m_lexer.eat_blanks();
-        v.z = m_lexer.accept_double();
+                  case Statement::TexCoords:
+                    for (size_t i = 0; i < statement.m_counts[0]; ++i)
+                        handler.on_tex_coords(m_tex_coords[tex_coord_index++]);
+                    break;
 
-        m_lexer.eat_blanks();
+                  case Statement::Normals:
+                    for (size_t i = 0; i < statement.m_counts[0]; ++i)
+                        handler.on_normal(m_normals[normal_index++]);
+                    break;
 
-        if (!m_lexer.is_eol())
-            m_lexer.accept_double();
+                  case Statement::Face:
+                    {
+                        const long* indices = m_face_indices.data() + face_index;
+                        const size_t vc = statement.m_counts[0];
+                        const size_t tc = statement.m_counts[1];
+                        const size_t nc = statement.m_counts[2];
+                        handler.on_face(
+                            indices, vc,
+                            indices + vc, tc,
+                            indices + vc + tc, nc,
+                            first_line_number + statement.m_line_number - 1);
+                        face_index += vc + tc + nc;
+                    }
+                    break;
 
-        m_vertices.push_back(v);
-    }
+                  case Statement::ObjectOrGroup:
+                    handler.on_object_or_group(m_names[statement.m_counts[0]]);
+                    break;
 
-    void parse_vt_statement()
-    {
-        Vector2d v;
+                  case Statement::UseMtl:
+                    handler.on_usemtl(m_names[statement.m_counts[0]]);
+                    break;
+                }
+            }
+        }
 
-        m_lexer.eat_blanks();
-        v.x = m_lexer.accept_double();
+      private:
+        struct Statement
+        {
+            enum Type
+            {
+                Vertices,           // m_counts[0] consecutive vertices
+                TexCoords,          // m_counts[0] consecutive texture coordinates
+                Normals,            // m_counts[0] consecutive normals
+                Face,               // m_counts[0..2] vertex, texture coordinate and normal indices
+                ObjectOrGroup,      // m_counts[0] is the index of the name
+                UseMtl              // m_counts[0] is the index of the name
+            };
+
+            Type                m_type;
+            size_t              m_line_number;
+            size_t              m_counts[3];
+        };
+
+        std::vector<Statement>      m_statements;
+        std::vector<long>           m_face_indices;
+        std::vector<std::string>    m_names;
+
+        // Consecutive feature statements are merged into a single statement.
+        void push_feature_statement(const Statement::Type type)
+        {
+            if (!m_statements.empty() && m_statements.back().m_type == type)
+            {
+                ++m_statements.back().m_counts[0];
+                return;
+            }
 
-        m_lexer.eat_blanks();
-        v.y = m_lexer.accept_double();
+            Statement statement;
+            statement.m_type = type;
+            statement.m_line_number = 0;
+            statement.m_counts[0] = 1;
+            m_statements.push_back(statement);
+        }
 
-        m_lexer.eat_blanks();
+        void push_name_statement(const Statement::Type type, const std::string& name)
+        {
+            Statement statement;
+            statement.m_type = type;
+            statement.m_line_number = 0;
+            statement.m_counts[0] = m_names.size();
+            m_statements.push_back(statement);
 
-        if (!m_lexer.is_eol())
-            m_lexer.accept_double();
+            m_names.push_back(name);
+        }
+    };
 
-        m_tex_coords.push_back(v);
-    }
+    // A portion of an OBJ file starting at the beginning of a line.
+    struct OBJChunk
+    {
+        const char*             m_begin;
+        const char*             m_end;
+        size_t                  m_line_count;       // number of newline characters in the chunk
+        OBJStatementRecorder    m_recorder;
+        bool                    m_parse_error;      // did lexing stop on a parse error?
+        size_t                  m_parse_error_line; // line of the parse error, relative to the chunk
+        std::exception_ptr      m_exception;        // any other exception thrown while lexing
+
+        OBJChunk(const char* begin, const char* end)
+          : m_begin(begin)
+          , m_end(end)
+          , m_line_count(0)
+          , m_parse_error(false)
+          , m_parse_error_line(0)
+        {
+        }
+    };
 
-    void parse_vn_statement()
+    class LexOBJChunkJob
+      : public IJob
     {
-        Vector3d n;
+      public:
+        LexOBJChunkJob(
+            OBJChunk&                           chunk,
+            const OBJMeshFileLexer::ParsingMode parsing_mode)
+          : m_chunk(chunk)
+          , m_parsing_mode(parsing_mode)
+        {
+        }
 
-        m_lexer.eat_blanks();
-        n.x = m_lexer.accept_double();
+        void execute(const size_t thread_index) override
+        {
+            m_chunk.m_line_count = std::count(m_chunk.m_begin, m_chunk.m_end, '\n');
 
-        m_lexer.eat_blanks();
-        n.y = m_lexer.accept_double();
+            try
+            {
+                OBJMeshFileLexer lexer(m_parsing_mode);
+                lexer.open(m_chunk.m_begin, m_chunk.m_end);
 
-        m_lexer.eat_blanks();
-        n.z = m_lexer.accept_double();
+                OBJParser<OBJStatementRecorder> parser(lexer, m_chunk.m_recorder);
+                parser.parse();
 
-        m_normals.push_back(n);
-    }
+                lexer.close();
+            }
+            catch (const OBJMeshFileReader::ExceptionParseError& e)
+            {
+                m_chunk.m_parse_error = true;
+                m_chunk.m_parse_error_line = e.m_line;
+            }
+            catch (...)
+            {
+                m_chunk.m_exception = std::current_exception();
+            }
+        }
+
+      private:
+        OBJChunk&                           m_chunk;
+        const OBJMeshFileLexer::ParsingMode m_parsing_mode;
+    };
+}
 
-    void parse_usemtl_statement()
+void OBJMeshFileReader::Impl::read_file_parallel(const std::string& filename)
+{
+    // Load the entire file in memory. Keep a trailing null character so that
+    // string-to-number conversions never read past the end of the buffer.
+    std::vector<char> contents;
     {
-        // Begin a mesh definition if we're not already inside one.
-        ensure_mesh_def();
+        boost::system::error_code ec;
+        const std::uintmax_t file_size = bf::file_size(filename, ec);
+        if (ec)
+            throw ExceptionIOError();
+
+        BufferedFile file(filename.c_str(), BufferedFile::BinaryType, BufferedFile::ReadMode);
+        if (!file.is_open())
+            throw ExceptionIOError();
+
+        contents.resize(static_cast<size_t>(file_size) + 1, 0);
+        if (file.read_unbuf(contents.data(), static_cast<size_t>(file_size)) != file_size)
+            throw ExceptionIOError();
+    }
 
-        // Retrieve the name of the material slot.
-        const std::string material_slot_name = parse_compound_identifier();
+    const char* const contents_begin = contents.data();
+    const char* const contents_end = contents_begin + contents.size() - 1;
+    const size_t contents_size = contents.size() - 1;
 
-        // Check whether this material slot has already been defined for this mesh.
-        const std::map<std::string, size_t>::const_iterator& it =
-            m_material_slots.find(material_slot_name);
+    // Split the file into chunks at line boundaries.
+    const size_t thread_count = System::get_logical_cpu_core_count();
+    const size_t chunk_count =
+        std::max<size_t>(1, std::min(contents_size / MinChunkSize, thread_count * ChunksPerThread));
+    std::vector<std::unique_ptr<OBJChunk>> chunks;
 
-        if (it != m_material_slots.end())
-        {
-            // It has: just make it the active material slot.
-            m_current_material_slot_index = it->second;
-        }
-        else
+    const char* chunk_begin = contents_begin;
+    for (size_t i = 1; i <= chunk_count && chunk_begin < contents_end; ++i)
+    {
+        const char* chunk_end =
+            i == chunk_count
+                ? contents_end
+                : std::find(contents_begin + (contents_size * i) / chunk_count, contents_end, '\n');
+
+        if (chunk_end < contents_end)
+            ++chunk_end;
+
+        if (chunk_end > chunk_begin)
         {
-            // It hasn't: insert it into the mesh and make it the active material slot.
-            m_current_material_slot_index = m_builder.push_material_slot(material_slot_name.c_str());
-            m_material_slots.insert(std::make_pair(material_slot_name, m_current_material_slot_index));
+            chunks.emplace_back(new OBJChunk(chunk_begin, chunk_end));
+            chunk_begin = chunk_end;
         }
     }
 
-    void ensure_mesh_def()
+    // Lex the chunks in parallel.
+    const OBJMeshFileLexer::ParsingMode parsing_mode =
+        (m_options & FavorSpeedOverPrecision)
+            ? OBJMeshFileLexer::Fast
+            : OBJMeshFileLexer::Precise;
+
+    if (chunks.size() == 1)
+        LexOBJChunkJob(*chunks[0], parsing_mode).execute(0);
+    else if (chunks.size() > 1)
     {
-        if (!m_inside_mesh_def)
-        {
-            // Begin the definition of the new mesh.
-            m_builder.begin_mesh(m_current_mesh_name.c_str());
-            m_inside_mesh_def = true;
+        // Jobs capture their own exceptions, so the job manager has nothing to log.
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, std::min(thread_count, chunks.size()));
 
-            // Clear material slot definitions.
-            m_material_slots.clear();
-            m_current_material_slot_index = 0;
-        }
+        for (const std::unique_ptr<OBJChunk>& chunk : chunks)
+            job_queue.schedule(new LexOBJChunkJob(*chunk, parsing_mode));
+
+        job_manager.start();
+        job_queue.wait_until_completion();
     }
-};
+
+    // Replay the statements of all chunks in file order on this thread.
+    size_t first_line_number = 1;
+    for (const std::unique_ptr<OBJChunk>& chunk : chunks)
+    {
+        chunk->m_recorder.replay(*this, first_line_number);
+
+        if (chunk->m_parse_error)
+            throw ExceptionParseError(first_line_number + chunk->m_parse_error_line - 1);
+
+        if (chunk->m_exception)
+            std::rethrow_exception(chunk->m_exception);
+
+        first_line_number += chunk->m_line_count;
+    }
+
+    on_end();
+}
 
 OBJMeshFileReader::OBJMeshFileReader(
     const std::string&   filename,
@@ -568,15 +984,9 @@ void OBJMeshFileReader::read(IMeshBuilder& builder)
 {
     Impl impl(m_options, builder);
 
-    // Open the input file.
-    if (!impl.m_lexer.open(m_filename))
-        throw ExceptionIOError();
-
-    // Parse the file.
-    impl.parse_file();
-
-    // Close the input file.
-    impl.m_lexer.close();
+    if (m_options & ParallelParsing)
+        impl.read_file_parallel(m_filename);
+    else impl.read_file(m_filename);
 }
 
 }   // namespace foundation
@@ -29,13 +29,20 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/rng/distribution.h"
+#include "foundation/log/log.h"
 #include "foundation/math/rng/lcg.h"
 #include "foundation/utility/benchmark.h"
 #include "foundation/utility/cache.h"
+#include "foundation/utility/job.h"
+
+// Boost headers.
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
 
 // Standard headers.
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 
 using namespace foundation;
 
@@ -103,3 +110,159 @@ BENCHMARK_SUITE(Foundation_Utility_Cache_LRUCache)
     BENCHMARK_CASE_F(MediumHitRate, Fixture<50>)    { payload(); }
     BENCHMARK_CASE_F(HighHitRate, Fixture<95>)      { payload(); }
 }
+
+BENCHMARK_SUITE(Foundation_Utility_Cache_Contention)
+{
+    typedef size_t MyKey;
+    typedef int MyElement;
+
+    struct MyKeyHasher
+    {
+        size_t operator()(const MyKey& key) const
+        {
+            return key;
+        }
+    };
+
+    // Element swapper for a cache holding 'CacheSize' elements, safe to use from multiple threads.
+    // The LRU cache ignores acquire().
+    template <size_t CacheSize>
+    struct MyElementSwapper
+    {
+        void load(const MyKey key, MyElement& element)
+        {
+            element = static_cast<MyElement>(key);
+        }
+
+        bool unload(const MyKey key, MyElement& element)
+        {
+            return true;
+        }
+
+        void acquire(const MyKey key, MyElement& element)
+        {
+        }
+
+        bool is_full(const size_t element_count) const
+        {
+            return element_count > CacheSize;
+        }
+    };
+
+    // A LRU cache shared by all threads behind a single lock.
+    template <size_t CacheSize>
+    class LockedLRUCache
+    {
+      public:
+        LockedLRUCache()
+          : m_cache(m_key_hasher, m_element_swapper)
+        {
+        }
+
+        MyElement get(const MyKey key)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            return m_cache.get(key);
+        }
+
+      private:
+        boost::mutex                    m_mutex;
+        MyKeyHasher                     m_key_hasher;
+        MyElementSwapper<CacheSize>     m_element_swapper;
+        LRUCache<
+            MyKey,
+            MyKeyHasher,
+            MyElement,
+            MyElementSwapper<CacheSize>> m_cache;
+    };
+
+    // A concurrent cache shared by all threads.
+    template <size_t CacheSize>
+    class SharedConcurrentCache
+    {
+      public:
+        SharedConcurrentCache()
+          : m_cache(m_key_hasher, m_element_swapper)
+        {
+        }
+
+        MyElement get(const MyKey key)
+        {
+            return m_cache.get(key);
+        }
+
+      private:
+        MyKeyHasher                     m_key_hasher;
+        MyElementSwapper<CacheSize>     m_element_swapper;
+        ConcurrentCache<
+            MyKey,
+            MyKeyHasher,
+            MyElement,
+            MyElementSwapper<CacheSize>> m_cache;
+    };
+
+    template <typename Cache>
+    class LookupJob
+      : public IJob
+    {
+      public:
+        LookupJob(Cache& cache, const std::uint32_t seed)
+          : m_cache(cache)
+          , m_seed(seed)
+          , m_dummy(0)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            LCG rng(m_seed);
+
+            for (size_t i = 0; i < 1000; ++i)
+                m_dummy += m_cache.get(rand_int1(rng, 0, 999));
+        }
+
+      private:
+        Cache&              m_cache;
+        const std::uint32_t m_seed;
+        MyElement           m_dummy;
+    };
+
+    template <typename Cache, size_t ThreadCount>
+    struct Fixture
+    {
+        Logger      m_logger;
+        JobQueue    m_job_queue;
+        JobManager  m_job_manager;
+        Cache       m_cache;
+
+        Fixture()
+          : m_job_manager(m_logger, m_job_queue, ThreadCount, JobManager::KeepRunningOnEmptyQueue)
+        {
+            m_job_manager.start();
+        }
+
+        void payload()
+        {
+            const size_t JobCount = 64;
+
+            for (size_t i = 0; i < JobCount; ++i)
+                m_job_queue.schedule(new LookupJob<Cache>(m_cache, static_cast<std::uint32_t>(i)));
+
+            m_job_queue.wait_until_completion();
+        }
+    };
+
+    typedef Fixture<LockedLRUCache<500>, 1> SingleThreadedLockedLRUFixture;
+    typedef Fixture<LockedLRUCache<500>, 4> QuadThreadedLockedLRUFixture;
+    typedef Fixture<LockedLRUCache<500>, 8> OctoThreadedLockedLRUFixture;
+    typedef Fixture<SharedConcurrentCache<500>, 1> SingleThreadedConcurrentFixture;
+    typedef Fixture<SharedConcurrentCache<500>, 4> QuadThreadedConcurrentFixture;
+    typedef Fixture<SharedConcurrentCache<500>, 8> OctoThreadedConcurrentFixture;
+
+    BENCHMARK_CASE_F(LockedLRUCache_SingleThreaded, SingleThreadedLockedLRUFixture)         { payload(); }
+    BENCHMARK_CASE_F(LockedLRUCache_QuadThreaded, QuadThreadedLockedLRUFixture)             { payload(); }
+    BENCHMARK_CASE_F(LockedLRUCache_OctoThreaded, OctoThreadedLockedLRUFixture)             { payload(); }
+    BENCHMARK_CASE_F(ConcurrentCache_SingleThreaded, SingleThreadedConcurrentFixture)       { payload(); }
+    BENCHMARK_CASE_F(ConcurrentCache_QuadThreaded, QuadThreadedConcurrentFixture)           { payload(); }
+    BENCHMARK_CASE_F(ConcurrentCache_OctoThreaded, OctoThreadedConcurrentFixture)           { payload(); }
+}
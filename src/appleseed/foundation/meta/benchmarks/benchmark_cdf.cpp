@@ -28,6 +28,7 @@
 //
 
 // appleseed.foundation headers.
+#include "foundation/math/aliastable.h"
 #include "foundation/math/cdf.h"
 #include "foundation/math/rng/distribution.h"
 #include "foundation/math/rng/xorshift32.h"
@@ -85,6 +86,122 @@ BENCHMARK_SUITE(Foundation_Math_CDF)
         for (size_t i = 0; i < 100; ++i)
             m_x += m_cdf.sample(rand_double2(m_rng)).second;
     }
+
+    // Emitter selection in the light samplers: single precision, millions of emitting triangles.
+    template <size_t Size>
+    struct SinglePrecisionFixture
+    {
+        typedef CDF<size_t, float> CDFType;
+
+        CDFType     m_cdf;
+        Xorshift32  m_rng;
+        float       m_x;
+
+        SinglePrecisionFixture()
+          : m_x(0.0f)
+        {
+            for (size_t i = 0; i < Size; ++i)
+                m_cdf.insert(i, rand_float1(m_rng));
+
+            assert(m_cdf.valid());
+
+            m_cdf.prepare();
+        }
+    };
+
+    BENCHMARK_CASE_F(SinglePrecisionSampling_1000Elements, SinglePrecisionFixture<1000>)
+    {
+        for (size_t i = 0; i < 100; ++i)
+            m_x += m_cdf.sample(rand_float2(m_rng)).second;
+    }
+
+    BENCHMARK_CASE_F(SinglePrecisionSampling_1000000Elements, SinglePrecisionFixture<1000000>)
+    {
+        for (size_t i = 0; i < 100; ++i)
+            m_x += m_cdf.sample(rand_float2(m_rng)).second;
+    }
+}
+
+BENCHMARK_SUITE(Foundation_Math_AliasTable)
+{
+    template <size_t Size>
+    struct Fixture
+    {
+        typedef AliasTable<size_t, double> AliasTableType;
+
+        AliasTableType  m_table;
+        Xorshift32      m_rng;
+        double          m_x;
+
+        Fixture()
+          : m_x(0.0)
+        {
+            for (size_t i = 0; i < Size; ++i)
+                m_table.insert(i, rand_double1(m_rng));
+
+            assert(m_table.valid());
+
+            m_table.prepare();
+        }
+    };
+
+    BENCHMARK_CASE_F(DoublePrecisionSampling_10Elements, Fixture<10>)
+    {
+        for (size_t i = 0; i < 100; ++i)
+            m_x += m_table.sample(rand_double2(m_rng)).second;
+    }
+
+    BENCHMARK_CASE_F(DoublePrecisionSampling_30Elements, Fixture<30>)
+    {
+        for (size_t i = 0; i < 100; ++i)
+            m_x += m_table.sample(rand_double2(m_rng)).second;
+    }
+
+    BENCHMARK_CASE_F(DoublePrecisionSampling_1000Elements, Fixture<1000>)
+    {
+        for (size_t i = 0; i < 100; ++i)
+            m_x += m_table.sample(rand_double2(m_rng)).second;
+    }
+
+    BENCHMARK_CASE_F(DoublePrecisionSampling_1000000Elements, Fixture<1000000>)
+    {
+        for (size_t i = 0; i < 100; ++i)
+            m_x += m_table.sample(rand_double2(m_rng)).second;
+    }
+
+    // Emitter selection in the light samplers: single precision, millions of emitting triangles.
+    template <size_t Size>
+    struct SinglePrecisionFixture
+    {
+        typedef AliasTable<size_t, float> AliasTableType;
+
+        AliasTableType  m_table;
+        Xorshift32      m_rng;
+        float           m_x;
+
+        SinglePrecisionFixture()
+          : m_x(0.0f)
+        {
+            for (size_t i = 0; i < Size; ++i)
+                m_table.insert(i, rand_float1(m_rng));
+
+            assert(m_table.valid());
+
+            m_table.prepare();
+        }
+    };
+
+    BENCHMARK_CASE_F(SinglePrecisionSampling_1000Elements, SinglePrecisionFixture<1000>)
+    {
+        for (size_t i = 0; i < 100; ++i)
+            m_x += m_table.sample(rand_float2(m_rng)).second;
+    }
+
+    BENCHMARK_CASE_F(SinglePrecisionSampling_1000000Elements, SinglePrecisionFixture<1000000>)
+    {
+        for (size_t i = 0; i < 100; ++i)
+            m_x += m_table.sample(rand_float2(m_rng)).second;
+    }
 }
 
 BENCHMARK_SUITE(Foundation_Math_CDF_Linear_Search)
@@ -30,13 +30,17 @@
 // appleseed.foundation headers.
 #include "foundation/image/color.h"
 #include "foundation/image/colorspace.h"
+#include "foundation/image/conversion.h"
+#include "foundation/image/pixel.h"
 #include "foundation/image/regularspectrum.h"
+#include "foundation/image/tile.h"
 #include "foundation/math/rng/distribution.h"
 #include "foundation/math/rng/mersennetwister.h"
 #include "foundation/utility/benchmark.h"
 
 // Standard headers.
 #include <cstddef>
+#include <cstring>
 
 using namespace foundation;
 
@@ -63,6 +67,78 @@ BENCHMARK_SUITE(Foundation_Image_ColorSpace)
         m_output = fast_linear_rgb_to_srgb(m_input);
     }
 
+    struct RGBATileFixture
+    {
+        Tile    m_input;
+        Tile    m_tile;
+
+        RGBATileFixture()
+          : m_input(32, 32, 4, PixelFormatFloat)
+          , m_tile(32, 32, 4, PixelFormatFloat)
+        {
+            MersenneTwister rng;
+
+            for (size_t i = 0, e = m_input.get_pixel_count(); i < e; ++i)
+            {
+                const float alpha = rand_float1(rng);
+                Color4f color(
+                    rand_float1(rng),
+                    rand_float1(rng),
+                    rand_float1(rng),
+                    alpha);
+                color.premultiply_in_place();
+                m_input.set_pixel(i, color);
+            }
+        }
+
+        // Restore the input pixels since conversions happen in place.
+        void reset()
+        {
+            std::memcpy(m_tile.get_storage(), m_input.get_storage(), m_input.get_size());
+        }
+
+        template <typename Transfer>
+        void convert_per_pixel(Transfer transfer)
+        {
+            for (size_t i = 0, e = m_tile.get_pixel_count(); i < e; ++i)
+            {
+                Color4f color;
+                m_tile.get_pixel(i, color);
+
+                color.unpremultiply_in_place();
+                color.rgb() = transfer(color.rgb());
+                color = saturate(color);
+                color.premultiply_in_place();
+
+                m_tile.set_pixel(i, color);
+            }
+        }
+    };
+
+    BENCHMARK_CASE_F(FastLinearRGBTosRGBConversion_PerPixel_32x32RGBATile, RGBATileFixture)
+    {
+        reset();
+        convert_per_pixel([](const Color3f& c) { return fast_linear_rgb_to_srgb(c); });
+    }
+
+    BENCHMARK_CASE_F(FastLinearRGBTosRGBConversion_Batched_32x32RGBATile, RGBATileFixture)
+    {
+        reset();
+        convert_linear_rgb_to_srgb(m_tile);
+    }
+
+    BENCHMARK_CASE_F(FastsRGBToLinearRGBConversion_PerPixel_32x32RGBATile, RGBATileFixture)
+    {
+        reset();
+        convert_per_pixel([](const Color3f& c) { return fast_srgb_to_linear_rgb(c); });
+    }
+
+    BENCHMARK_CASE_F(FastsRGBToLinearRGBConversion_Batched_32x32RGBATile, RGBATileFixture)
+    {
+        reset();
+        convert_srgb_to_linear_rgb(m_tile);
+    }
+
     struct SpectrumToCIEXYZFixture
     {
         const LightingConditions    m_lighting_conditions;
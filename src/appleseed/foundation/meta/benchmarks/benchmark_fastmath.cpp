@@ -31,7 +31,7 @@
 #include "foundation/math/fastmath.h"
 #include "foundation/math/rng/distribution.h"
 #include "foundation/math/rng/mersennetwister.h"
-#include "foundation/platform/compiler.h"
+#include "foundation/memory/memory.h"
 #include "foundation/utility/benchmark.h"
 
 // Standard headers.
@@ -43,19 +43,28 @@ using namespace foundation;
 
 BENCHMARK_SUITE(Foundation_Math_FastMath)
 {
-    const size_t N = 100;
+    const size_t N = 96;
 
     struct Fixture
     {
-        APPLESEED_SIMD4_ALIGN float m_values[N];
-        APPLESEED_SIMD4_ALIGN float m_output[N];
+        // Fixtures are allocated on the heap, so 32-byte alignment must be enforced manually.
+        float   m_storage[3 * N + 8];
+        float*  m_values;
+        float*  m_values2;
+        float*  m_output;
 
         Fixture()
+          : m_values(align(m_storage, 32))
+          , m_values2(m_values + N)
+          , m_output(m_values2 + N)
         {
             MersenneTwister rng;
 
             for (size_t i = 0; i < N; ++i)
                 m_values[i] = rand_float1(rng);
+
+            for (size_t i = 0; i < N; ++i)
+                m_values2[i] = rand_float1(rng, -1.0f, 1.0f);
         }
     };
 
@@ -97,6 +106,22 @@ BENCHMARK_SUITE(Foundation_Math_FastMath)
             faster_pow2(&m_output[i]);
     }
 
+    BENCHMARK_CASE_F(Batch4FastPow2, Fixture)
+    {
+        memcpy(m_output, m_values, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 4)
+            BatchFastMath<4>::pow2(&m_output[i]);
+    }
+
+    BENCHMARK_CASE_F(Batch8FastPow2, Fixture)
+    {
+        memcpy(m_output, m_values, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 8)
+            BatchFastMath<8>::pow2(&m_output[i]);
+    }
+
     //
     // log2(x)
     //
@@ -129,6 +154,22 @@ BENCHMARK_SUITE(Foundation_Math_FastMath)
             faster_log2(&m_output[i]);
     }
 
+    BENCHMARK_CASE_F(Batch4FastLog2, Fixture)
+    {
+        memcpy(m_output, m_values, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 4)
+            BatchFastMath<4>::log2(&m_output[i]);
+    }
+
+    BENCHMARK_CASE_F(Batch8FastLog2, Fixture)
+    {
+        memcpy(m_output, m_values, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 8)
+            BatchFastMath<8>::log2(&m_output[i]);
+    }
+
     //
     // x^e
     //
@@ -169,6 +210,22 @@ BENCHMARK_SUITE(Foundation_Math_FastMath)
             faster_pow(&m_output[i], Exponent);
     }
 
+    BENCHMARK_CASE_F(Batch4FastPow, Fixture)
+    {
+        memcpy(m_output, m_values, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 4)
+            BatchFastMath<4>::pow(&m_output[i], Exponent);
+    }
+
+    BENCHMARK_CASE_F(Batch8FastPow, Fixture)
+    {
+        memcpy(m_output, m_values, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 8)
+            BatchFastMath<8>::pow(&m_output[i], Exponent);
+    }
+
     //
     // log(x)
     //
@@ -207,6 +264,22 @@ BENCHMARK_SUITE(Foundation_Math_FastMath)
             faster_log(&m_output[i]);
     }
 
+    BENCHMARK_CASE_F(Batch4FastLog, Fixture)
+    {
+        memcpy(m_output, m_values, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 4)
+            BatchFastMath<4>::log(&m_output[i]);
+    }
+
+    BENCHMARK_CASE_F(Batch8FastLog, Fixture)
+    {
+        memcpy(m_output, m_values, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 8)
+            BatchFastMath<8>::log(&m_output[i]);
+    }
+
     //
     // exp(x)
     //
@@ -245,6 +318,150 @@ BENCHMARK_SUITE(Foundation_Math_FastMath)
             faster_exp(&m_output[i]);
     }
 
+    BENCHMARK_CASE_F(Batch4FastExp, Fixture)
+    {
+        memcpy(m_output, m_values, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 4)
+            BatchFastMath<4>::exp(&m_output[i]);
+    }
+
+    BENCHMARK_CASE_F(Batch8FastExp, Fixture)
+    {
+        memcpy(m_output, m_values, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 8)
+            BatchFastMath<8>::exp(&m_output[i]);
+    }
+
+    //
+    // sin(x)
+    //
+
+    BENCHMARK_CASE_F(StdSin, Fixture)
+    {
+        for (size_t i = 0; i < N; ++i)
+            m_output[i] = std::sin(m_values[i]);
+    }
+
+    BENCHMARK_CASE_F(ScalarFastSinFull, Fixture)
+    {
+        for (size_t i = 0; i < N; ++i)
+            m_output[i] = fast_sin_full(m_values[i]);
+    }
+
+    BENCHMARK_CASE_F(Batch4FastSin, Fixture)
+    {
+        memcpy(m_output, m_values, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 4)
+            BatchFastMath<4>::sin(&m_output[i]);
+    }
+
+    BENCHMARK_CASE_F(Batch8FastSin, Fixture)
+    {
+        memcpy(m_output, m_values, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 8)
+            BatchFastMath<8>::sin(&m_output[i]);
+    }
+
+    //
+    // cos(x)
+    //
+
+    BENCHMARK_CASE_F(StdCos, Fixture)
+    {
+        for (size_t i = 0; i < N; ++i)
+            m_output[i] = std::cos(m_values[i]);
+    }
+
+    BENCHMARK_CASE_F(ScalarFastCosFull, Fixture)
+    {
+        for (size_t i = 0; i < N; ++i)
+            m_output[i] = fast_cos_full(m_values[i]);
+    }
+
+    BENCHMARK_CASE_F(Batch4FastCos, Fixture)
+    {
+        memcpy(m_output, m_values, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 4)
+            BatchFastMath<4>::cos(&m_output[i]);
+    }
+
+    BENCHMARK_CASE_F(Batch8FastCos, Fixture)
+    {
+        memcpy(m_output, m_values, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 8)
+            BatchFastMath<8>::cos(&m_output[i]);
+    }
+
+    //
+    // atan2(y, x)
+    //
+
+    BENCHMARK_CASE_F(StdAtan2, Fixture)
+    {
+        for (size_t i = 0; i < N; ++i)
+            m_output[i] = std::atan2(m_values2[i], m_values[i]);
+    }
+
+    BENCHMARK_CASE_F(ScalarFastAtan2, Fixture)
+    {
+        for (size_t i = 0; i < N; ++i)
+            m_output[i] = fast_atan2(m_values2[i], m_values[i]);
+    }
+
+    BENCHMARK_CASE_F(Batch4FastAtan2, Fixture)
+    {
+        memcpy(m_output, m_values2, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 4)
+            BatchFastMath<4>::atan2(&m_output[i], &m_values[i]);
+    }
+
+    BENCHMARK_CASE_F(Batch8FastAtan2, Fixture)
+    {
+        memcpy(m_output, m_values2, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 8)
+            BatchFastMath<8>::atan2(&m_output[i], &m_values[i]);
+    }
+
+    //
+    // erf(x)
+    //
+
+    BENCHMARK_CASE_F(StdErf, Fixture)
+    {
+        for (size_t i = 0; i < N; ++i)
+            m_output[i] = std::erf(m_values2[i]);
+    }
+
+    BENCHMARK_CASE_F(ScalarFastErf, Fixture)
+    {
+        for (size_t i = 0; i < N; ++i)
+            m_output[i] = fast_erf(m_values2[i]);
+    }
+
+    BENCHMARK_CASE_F(Batch4FastErf, Fixture)
+    {
+        memcpy(m_output, m_values2, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 4)
+            BatchFastMath<4>::erf(&m_output[i]);
+    }
+
+    BENCHMARK_CASE_F(Batch8FastErf, Fixture)
+    {
+        memcpy(m_output, m_values2, N * sizeof(float));
+
+        for (size_t i = 0; i < N; i += 8)
+            BatchFastMath<8>::erf(&m_output[i]);
+    }
+
     // 
     // acos(x)
     //
@@ -85,6 +85,11 @@ BENCHMARK_SUITE(Foundation_Math_Half)
             m_output[i] = fast_float_to_half(m_input[i]);
     }
 
+    BENCHMARK_CASE_F(BatchedFloatToHalf_2x2RGBABlock, FloatToHalfFixture<2 * 2 * 4>)
+    {
+        float_to_half(&m_input[0], &m_output[0], m_input.size());
+    }
+
     //
     // Float -> half, 32x32 RGBA tile.
     //
@@ -107,6 +112,11 @@ BENCHMARK_SUITE(Foundation_Math_Half)
             m_output[i] = fast_float_to_half(m_input[i]);
     }
 
+    BENCHMARK_CASE_F(BatchedFloatToHalf_32x32RGBATile, FloatToHalfFixture<32 * 32 * 4>)
+    {
+        float_to_half(&m_input[0], &m_output[0], m_input.size());
+    }
+
     //
     // Float -> half, 2048x2048 RGBA texture.
     //
@@ -129,6 +139,11 @@ BENCHMARK_SUITE(Foundation_Math_Half)
             m_output[i] = fast_float_to_half(m_input[i]);
     }
 
+    BENCHMARK_CASE_F(BatchedFloatToHalf_2Kx2KRGBATexture, FloatToHalfFixture<2048 * 2048 * 4>)
+    {
+        float_to_half(&m_input[0], &m_output[0], m_input.size());
+    }
+
     //
     // Half -> float benchmarks.
     //
@@ -168,6 +183,11 @@ BENCHMARK_SUITE(Foundation_Math_Half)
             m_output[i] = half_to_float_alt(m_input[i]);
     }
 
+    BENCHMARK_CASE_F(BatchedHalfToFloat_2x2RGBABlock, HalfToFloatFixture<2 * 2 * 4>)
+    {
+        half_to_float(&m_input[0], &m_output[0], m_input.size());
+    }
+
     //
     // Half -> float, 32x32 RGBA tile.
     //
@@ -184,6 +204,11 @@ BENCHMARK_SUITE(Foundation_Math_Half)
             m_output[i] = half_to_float_alt(m_input[i]);
     }
 
+    BENCHMARK_CASE_F(BatchedHalfToFloat_32x32RGBATile, HalfToFloatFixture<32 * 32 * 4>)
+    {
+        half_to_float(&m_input[0], &m_output[0], m_input.size());
+    }
+
     //
     // Half -> float, 2048x2048 RGBA texture.
     //
@@ -199,4 +224,9 @@ BENCHMARK_SUITE(Foundation_Math_Half)
         for (size_t i = 0, e = m_input.size(); i < e; ++i)
             m_output[i] = half_to_float_alt(m_input[i]);
     }
+
+    BENCHMARK_CASE_F(BatchedHalfToFloat_2Kx2KRGBATexture, HalfToFloatFixture<2048 * 2048 * 4>)
+    {
+        half_to_float(&m_input[0], &m_output[0], m_input.size());
+    }
 }
@@ -0,0 +1,99 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/containers/hashtable.h"
+#include "foundation/hash/hash.h"
+#include "foundation/utility/benchmark.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+
+using namespace foundation;
+
+BENCHMARK_SUITE(Foundation_Containers_HashTable)
+{
+    struct KeyHasher
+    {
+        size_t operator()(const size_t key) const
+        {
+            return
+                static_cast<size_t>(
+                    hash_uint64(
+                        static_cast<std::uint64_t>(key)));
+        }
+    };
+
+    template <template <typename, typename, typename> class Table, size_t N>
+    struct Fixture
+    {
+        KeyHasher                           m_key_hasher;
+        Table<size_t, KeyHasher, size_t>    m_table;
+        size_t                              m_result;
+
+        Fixture()
+          : m_table(m_key_hasher)
+          , m_result(0)
+        {
+            m_table.resize(N);
+
+            // Insert even keys only, odd keys are used for failed lookups.
+            for (size_t i = 0; i < N; ++i)
+                m_table.insert(2 * i, i);
+        }
+
+        void find_existing_keys()
+        {
+            for (size_t i = 0; i < N; ++i)
+                m_result += *m_table.get(2 * i);
+        }
+
+        void find_missing_keys()
+        {
+            for (size_t i = 0; i < N; ++i)
+                m_result += m_table.get(2 * i + 1) != nullptr ? 1 : 0;
+        }
+    };
+
+    // HashTable expects a power-of-two table size.
+    typedef Fixture<HashTable, 1024> HashTable1KFixture;
+    typedef Fixture<HashTable, 65536> HashTable64KFixture;
+    typedef Fixture<FlatHashTable, 1024> FlatHashTable1KFixture;
+    typedef Fixture<FlatHashTable, 65536> FlatHashTable64KFixture;
+
+    BENCHMARK_CASE_F(HashTable_FindExistingKeys_1K, HashTable1KFixture)             { find_existing_keys(); }
+    BENCHMARK_CASE_F(HashTable_FindExistingKeys_64K, HashTable64KFixture)           { find_existing_keys(); }
+    BENCHMARK_CASE_F(HashTable_FindMissingKeys_1K, HashTable1KFixture)              { find_missing_keys(); }
+    BENCHMARK_CASE_F(HashTable_FindMissingKeys_64K, HashTable64KFixture)            { find_missing_keys(); }
+
+    BENCHMARK_CASE_F(FlatHashTable_FindExistingKeys_1K, FlatHashTable1KFixture)     { find_existing_keys(); }
+    BENCHMARK_CASE_F(FlatHashTable_FindExistingKeys_64K, FlatHashTable64KFixture)   { find_existing_keys(); }
+    BENCHMARK_CASE_F(FlatHashTable_FindMissingKeys_1K, FlatHashTable1KFixture)      { find_missing_keys(); }
+    BENCHMARK_CASE_F(FlatHashTable_FindMissingKeys_64K, FlatHashTable64KFixture)    { find_missing_keys(); }
+}
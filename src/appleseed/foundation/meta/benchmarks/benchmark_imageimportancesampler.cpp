@@ -33,11 +33,13 @@
 #include "foundation/math/rng/xorshift32.h"
 #include "foundation/math/sampling/imageimportancesampler.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/system.h"
 #include "foundation/utility/benchmark.h"
 
 // Standard headers.
 #include <cstddef>
 #include <memory>
+#include <vector>
 
 using namespace foundation;
 
@@ -47,6 +49,7 @@ BENCHMARK_SUITE(Foundation_Math_Sampling_ImageImportanceSampler)
     {
         typedef ImageImportanceSampler<ImageSampler::Payload, float> ImportanceSamplerType;
 
+        std::unique_ptr<Image>                   m_image;
         std::unique_ptr<ImportanceSamplerType>   m_importance_sampler;
         Xorshift32                               m_rng;
 
@@ -58,17 +61,31 @@ BENCHMARK_SUITE(Foundation_Math_Sampling_ImageImportanceSampler)
           , m_texel_prob_sum(0.0f)
         {
             GenericImageFileReader reader;
-            std::unique_ptr<Image> image(reader.read("unit tests/inputs/test_imageimportancesampler_doge2.exr"));
+            m_image.reset(reader.read("unit tests/inputs/test_imageimportancesampler_doge2.exr"));
 
-            const size_t width = image->properties().m_canvas_width;
-            const size_t height = image->properties().m_canvas_height;
+            const size_t width = m_image->properties().m_canvas_width;
+            const size_t height = m_image->properties().m_canvas_height;
 
             m_importance_sampler.reset(new ImportanceSamplerType(width, height));
-            ImageSampler sampler(*image.get());
+            ImageSampler sampler(*m_image.get());
             m_importance_sampler->rebuild(sampler);
         }
     };
 
+    BENCHMARK_CASE_F(Rebuild, Fixture)
+    {
+        ImageSampler sampler(*m_image.get());
+        m_importance_sampler->rebuild(sampler);
+    }
+
+    BENCHMARK_CASE_F(ParallelRebuild, Fixture)
+    {
+        // foundation::ImageSampler is read-only and can be shared between threads.
+        ImageSampler sampler(*m_image.get());
+        const std::vector<ImageSampler*> samplers(System::get_logical_cpu_core_count(), &sampler);
+        m_importance_sampler->parallel_rebuild(samplers);
+    }
+
     BENCHMARK_CASE_F(Sample, Fixture)
     {
         const Vector2f s = rand_vector2<Vector2f>(m_rng);
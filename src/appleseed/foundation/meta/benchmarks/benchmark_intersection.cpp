@@ -28,21 +28,26 @@
 //
 
 // appleseed.foundation headers.
+#include "foundation/containers/alignedvector.h"
 #include "foundation/math/aabb.h"
+#include "foundation/math/bvh.h"
 #include "foundation/math/intersection/rayaabb.h"
 #include "foundation/math/intersection/raytrianglemt.h"
 #include "foundation/math/intersection/raytrianglessk.h"
+#include "foundation/math/intersection/raytrianglewatertight.h"
 #include "foundation/math/ray.h"
 #include "foundation/math/rng/distribution.h"
 #include "foundation/math/rng/mersennetwister.h"
 #include "foundation/math/sampling/mappings.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/defaulttimers.h"
 #include "foundation/utility/benchmark.h"
 
 // Standard headers.
 #include <cstddef>
 #include <limits>
+#include <vector>
 
 using namespace foundation;
 
@@ -316,3 +321,249 @@ BENCHMARK_SUITE(Foundation_Math_Intersection_RayTriangleSSK)
     BENCHMARK_CASE_F(Intersect_DoublePrecision_HitRateIs66Percents, FixtureDouble66) { payload(); }
     BENCHMARK_CASE_F(Intersect_DoublePrecision_HitRateIs100Percents, FixtureDouble100) { payload(); }
 };
+
+BENCHMARK_SUITE(Foundation_Math_Intersection_RayTriangleWatertight)
+{
+    template <typename T, int TargetHitRate>
+    struct Fixture
+      : public RayTriangleFixture<TriangleWatertight<T>, T, TargetHitRate>
+    {
+    };
+
+    // We need these typedefs because we can't use commas in macro parameters.
+    typedef Fixture<float, 0>       FixtureFloat0;
+    typedef Fixture<float, 33>      FixtureFloat33;
+    typedef Fixture<float, 66>      FixtureFloat66;
+    typedef Fixture<float, 100>     FixtureFloat100;
+    typedef Fixture<double, 0>      FixtureDouble0;
+    typedef Fixture<double, 33>     FixtureDouble33;
+    typedef Fixture<double, 66>     FixtureDouble66;
+    typedef Fixture<double, 100>    FixtureDouble100;
+
+    BENCHMARK_CASE_F(Intersect_SinglePrecision_HitRateIs0Percent, FixtureFloat0) { payload(); }
+    BENCHMARK_CASE_F(Intersect_SinglePrecision_HitRateIs33Percents, FixtureFloat33) { payload(); }
+    BENCHMARK_CASE_F(Intersect_SinglePrecision_HitRateIs66Percents, FixtureFloat66) { payload(); }
+    BENCHMARK_CASE_F(Intersect_SinglePrecision_HitRateIs100Percents, FixtureFloat100) { payload(); }
+    BENCHMARK_CASE_F(Intersect_DoublePrecision_HitRateIs0Percent, FixtureDouble0) { payload(); }
+    BENCHMARK_CASE_F(Intersect_DoublePrecision_HitRateIs33Percents, FixtureDouble33) { payload(); }
+    BENCHMARK_CASE_F(Intersect_DoublePrecision_HitRateIs66Percents, FixtureDouble66) { payload(); }
+    BENCHMARK_CASE_F(Intersect_DoublePrecision_HitRateIs100Percents, FixtureDouble100) { payload(); }
+
+    // Rays through the edge shared by two triangles, to compare the cost of watertightness
+    // with Moller-Trumbore, which lets some of these rays through in single precision.
+    template <typename TriangleType>
+    struct SharedEdgeFixture
+    {
+        static const size_t RayCount = 1000;
+
+        TriangleType    m_triangle1;
+        TriangleType    m_triangle2;
+        Ray3f           m_ray[RayCount];
+        size_t          m_miss_count;
+
+        SharedEdgeFixture()
+          : m_triangle1(Vector3f(0.1f, 0.3f, 0.0f), Vector3f(1.7f, 0.2f, 0.01f), Vector3f(1.3f, 1.9f, 0.02f))
+          , m_triangle2(Vector3f(0.1f, 0.3f, 0.0f), Vector3f(1.3f, 1.9f, 0.02f), Vector3f(-0.4f, 1.5f, 0.0f))
+          , m_miss_count(0)
+        {
+            const Vector3f a(0.1f, 0.3f, 0.0f);
+            const Vector3f c(1.3f, 1.9f, 0.02f);
+            const Vector3f org(0.37f, 0.71f, 5.0f);
+
+            for (size_t i = 0; i < RayCount; ++i)
+            {
+                const float s = static_cast<float>(i) / RayCount;
+                m_ray[i] = Ray3f(org, normalize(a + s * (c - a) - org));
+            }
+        }
+    };
+
+    typedef SharedEdgeFixture<TriangleMT<float>> SharedEdgeFixtureMT;
+    typedef SharedEdgeFixture<TriangleWatertight<float>> SharedEdgeFixtureWatertight;
+
+    BENCHMARK_CASE_F(IntersectSharedEdge_MollerTrumbore_SinglePrecision, SharedEdgeFixtureMT)
+    {
+        for (size_t i = 0; i < RayCount; ++i)
+        {
+            if (!m_triangle1.intersect(m_ray[i]) && !m_triangle2.intersect(m_ray[i]))
+                ++m_miss_count;
+        }
+    }
+
+    BENCHMARK_CASE_F(IntersectSharedEdge_Watertight_SinglePrecision, SharedEdgeFixtureWatertight)
+    {
+        for (size_t i = 0; i < RayCount; ++i)
+        {
+            const WatertightRay<float> ray(m_ray[i]);
+
+            if (!m_triangle1.intersect(ray) && !m_triangle2.intersect(ray))
+                ++m_miss_count;
+        }
+    }
+}
+
+BENCHMARK_SUITE(Foundation_Math_Intersection_RayBVH)
+{
+    typedef AlignedVector<bvh::Node<AABB3d>> NodeVector;
+    typedef AlignedVector<bvh::WideNode<AABB3d, 4>> WideNode4Vector;
+    typedef AlignedVector<bvh::WideNode<AABB3d, 8>> WideNode8Vector;
+    typedef std::vector<AABB3d> AABBVector;
+    typedef bvh::Tree<NodeVector> Tree;
+    typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+
+    // Treats items as boxes and finds the closest one.
+    struct Visitor
+    {
+        const AABBVector&           m_bboxes;
+        const std::vector<size_t>&  m_ordering;
+        double                      m_distance;
+
+        Visitor(
+            const AABBVector&           bboxes,
+            const std::vector<size_t>&  ordering,
+            const double                ray_tmax)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+          , m_distance(ray_tmax)
+        {
+        }
+
+        bool visit(
+            const bvh::Node<AABB3d>&    node,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            for (size_t i = node.get_item_index(), e = i + node.get_item_count(); i < e; ++i)
+            {
+                double tmin;
+                if (intersect(ray, ray_info, m_bboxes[m_ordering[i]], tmin) && tmin < m_distance)
+                    m_distance = tmin;
+            }
+
+            distance = m_distance;
+            return true;
+        }
+    };
+
+    struct Fixture
+      : public FixtureBase<double>
+    {
+        static const size_t ItemCount = 100000;
+        static const size_t RayCount = 1000;
+
+        AABBVector          m_bboxes;
+        Partitioner         m_partitioner;
+        Tree                m_tree;
+        WideNode4Vector     m_wide_nodes4;
+        WideNode8Vector     m_wide_nodes8;
+        Ray3d               m_ray[RayCount];
+        RayInfo3d           m_ray_info[RayCount];
+        double              m_distance;
+
+        Fixture()
+          : m_bboxes(make_bboxes())
+          , m_partitioner(m_bboxes, 4)
+          , m_tree(NodeVector::allocator_type(64))
+          , m_wide_nodes4(WideNode4Vector::allocator_type(64))
+          , m_wide_nodes8(WideNode8Vector::allocator_type(64))
+          , m_distance(0.0)
+        {
+            bvh::Builder<Tree, Partitioner> builder;
+            builder.build<DefaultWallclockTimer>(m_tree, m_partitioner, m_bboxes.size(), 4);
+
+            bvh::WideBuilder<Tree, WideNode4Vector> wide_builder4;
+            wide_builder4.build<DefaultWallclockTimer>(m_tree, m_wide_nodes4);
+
+            bvh::WideBuilder<Tree, WideNode8Vector> wide_builder8;
+            wide_builder8.build<DefaultWallclockTimer>(m_tree, m_wide_nodes8);
+
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < RayCount; ++i)
+                get_random_ray(rng, 10.0, m_ray[i], m_ray_info[i]);
+        }
+
+        static AABBVector make_bboxes()
+        {
+            MersenneTwister rng;
+            AABBVector bboxes;
+            bboxes.reserve(ItemCount);
+
+            for (size_t i = 0; i < ItemCount; ++i)
+            {
+                const Vector3d center = get_random_vector<3>(rng, -1.0, 1.0);
+                const Vector3d extent(rand_double1(rng, 0.001, 0.01));
+                bboxes.emplace_back(center - extent, center + extent);
+            }
+
+            return bboxes;
+        }
+    };
+
+    BENCHMARK_CASE_F(IntersectBinaryNodes, Fixture)
+    {
+        bvh::Intersector<Tree, Visitor, Ray3d> intersector;
+
+        for (size_t i = 0; i < RayCount; ++i)
+        {
+            Visitor visitor(m_bboxes, m_partitioner.get_item_ordering(), m_ray[i].m_tmax);
+            intersector.intersect_no_motion(
+                m_tree,
+                m_ray[i],
+                m_ray_info[i],
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , bvh::TraversalStatistics()
+#endif
+                );
+            m_distance += visitor.m_distance;
+        }
+    }
+
+    BENCHMARK_CASE_F(IntersectWideNodes4, Fixture)
+    {
+        bvh::WideIntersector<Tree, WideNode4Vector, Visitor, Ray3d> intersector;
+
+        for (size_t i = 0; i < RayCount; ++i)
+        {
+            Visitor visitor(m_bboxes, m_partitioner.get_item_ordering(), m_ray[i].m_tmax);
+            intersector.intersect_no_motion(
+                m_tree,
+                m_wide_nodes4,
+                m_ray[i],
+                m_ray_info[i],
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , bvh::TraversalStatistics()
+#endif
+                );
+            m_distance += visitor.m_distance;
+        }
+    }
+
+    BENCHMARK_CASE_F(IntersectWideNodes8, Fixture)
+    {
+        bvh::WideIntersector<Tree, WideNode8Vector, Visitor, Ray3d> intersector;
+
+        for (size_t i = 0; i < RayCount; ++i)
+        {
+            Visitor visitor(m_bboxes, m_partitioner.get_item_ordering(), m_ray[i].m_tmax);
+            intersector.intersect_no_motion(
+                m_tree,
+                m_wide_nodes8,
+                m_ray[i],
+                m_ray_info[i],
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , bvh::TraversalStatistics()
+#endif
+                );
+            m_distance += visitor.m_distance;
+        }
+    }
+}
@@ -47,7 +47,29 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
         }
     };
 
-    template <size_t ThreadCount>
+    // A job that schedules a number of child jobs, as SampleGeneratorJob does when it reschedules itself.
+    class SpawningJob
+      : public IJob
+    {
+      public:
+        SpawningJob(JobQueue& job_queue, const size_t child_count)
+          : m_job_queue(job_queue)
+          , m_child_count(child_count)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            for (size_t i = 0; i < m_child_count; ++i)
+                m_job_queue.schedule(new EmptyJob());
+        }
+
+      private:
+        JobQueue&       m_job_queue;
+        const size_t    m_child_count;
+    };
+
+    template <size_t ThreadCount, JobQueue::SchedulingMode SchedulingMode>
     struct Fixture
     {
         Logger      m_logger;
@@ -55,7 +77,8 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
         JobManager  m_job_manager;
 
         Fixture()
-          : m_job_manager(m_logger, m_job_queue, ThreadCount, JobManager::KeepRunningOnEmptyQueue)
+          : m_job_queue(SchedulingMode)
+          , m_job_manager(m_logger, m_job_queue, ThreadCount, JobManager::KeepRunningOnEmptyQueue)
         {
             m_job_manager.start();
         }
@@ -70,15 +93,63 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
 
             m_job_queue.wait_until_completion();
         }
+
+        void spawning_payload()
+        {
+            const size_t JobCount = 16;
+            const size_t ChildCount = 64;
+
+            for (size_t i = 0; i < JobCount; ++i)
+                m_job_queue.schedule(new SpawningJob(m_job_queue, ChildCount));
+
+            m_job_queue.wait_until_completion();
+        }
     };
 
-    BENCHMARK_CASE_F(SingleThreadedJobExecution, Fixture<1>)
+    typedef Fixture<1, JobQueue::CentralizedScheduling> SingleThreadedCentralizedFixture;
+    typedef Fixture<2, JobQueue::CentralizedScheduling> DoubleThreadedCentralizedFixture;
+    typedef Fixture<8, JobQueue::CentralizedScheduling> OctoThreadedCentralizedFixture;
+    typedef Fixture<1, JobQueue::WorkStealingScheduling> SingleThreadedWorkStealingFixture;
+    typedef Fixture<2, JobQueue::WorkStealingScheduling> DoubleThreadedWorkStealingFixture;
+    typedef Fixture<8, JobQueue::WorkStealingScheduling> OctoThreadedWorkStealingFixture;
+
+    BENCHMARK_CASE_F(SingleThreadedJobExecution_Centralized, SingleThreadedCentralizedFixture)
     {
         payload();
     }
 
-    BENCHMARK_CASE_F(DoubleThreadedJobExecution, Fixture<2>)
+    BENCHMARK_CASE_F(DoubleThreadedJobExecution_Centralized, DoubleThreadedCentralizedFixture)
     {
         payload();
     }
+
+    BENCHMARK_CASE_F(OctoThreadedJobExecution_Centralized, OctoThreadedCentralizedFixture)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(SingleThreadedJobExecution_WorkStealing, SingleThreadedWorkStealingFixture)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(DoubleThreadedJobExecution_WorkStealing, DoubleThreadedWorkStealingFixture)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(OctoThreadedJobExecution_WorkStealing, OctoThreadedWorkStealingFixture)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(OctoThreadedSubJobExecution_Centralized, OctoThreadedCentralizedFixture)
+    {
+        spawning_payload();
+    }
+
+    BENCHMARK_CASE_F(OctoThreadedSubJobExecution_WorkStealing, OctoThreadedWorkStealingFixture)
+    {
+        spawning_payload();
+    }
 }
@@ -46,6 +46,7 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -103,12 +104,15 @@ namespace
         knn::Tree3f             m_tree;
         std::vector<Vector3f>   m_query_points;
 
-        FixtureBase(const std::string& benchmark_name, const std::string& dataset_filepath)
+        FixtureBase(
+            const std::string&  benchmark_name,
+            const std::string&  dataset_filepath,
+            const std::size_t   max_leaf_size = 1)
         {
             configure_logger(benchmark_name);
             load_points_from_disk(dataset_filepath);
             compute_bbox();
-            build_tree();
+            build_tree(max_leaf_size);
         }
 
 #ifdef FOUNDATION_KNN_ENABLE_QUERY_STATS
@@ -225,11 +229,11 @@ namespace
                 m_bbox.insert(point);
         }
 
-        void build_tree()
+        void build_tree(const std::size_t max_leaf_size)
         {
             if (!m_points.empty())
             {
-                knn::Builder3f builder(m_tree);
+                knn::Builder3f builder(m_tree, max_leaf_size);
                 builder.build<DefaultWallclockTimer>(&m_points[0], m_points.size());
 
                 LOG_DEBUG(
@@ -348,6 +352,79 @@ BENCHMARK_SUITE(Foundation_Math_Knn_Query)
     BENCHMARK_CASE_F(PhotonMap_RandomQueryPoints_K500, PhotonMapRandomQueryPointsFixture<500>)      { run_queries(); }
 }
 
+BENCHMARK_SUITE(Foundation_Math_Knn_BucketedQuery)
+{
+    template <std::size_t AnswerSize, std::size_t MaxLeafSize>
+    class Fixture
+      : public FixtureBase
+    {
+      public:
+        Fixture()
+          : FixtureBase(
+                "photons_k" + to_string(AnswerSize) + "_leaf" + to_string(MaxLeafSize),
+                "unit benchmarks/inputs/test_knn_photons.bin",
+                MaxLeafSize)
+          , m_answer(AnswerSize)
+        {
+            establish_query_points_in_cloud(QueryPointCount);
+        }
+
+        void run_queries()
+        {
+            const knn::Query3f query(m_tree, m_answer);
+
+            for (const Vector3f& query_point : m_query_points)
+            {
+                query.run(query_point);
+                m_accumulator += m_answer.size();
+            }
+        }
+
+        void run_batch_queries()
+        {
+            if (m_query_points.empty())
+                return;
+
+            const knn::Query3f query(m_tree, m_answer);
+
+            auto visitor = [this](const std::size_t query_index, const knn::Answer<float>& answer)
+            {
+                m_accumulator += answer.size();
+            };
+
+            query.run_batch(
+                &m_query_points[0],
+                m_query_points.size(),
+                std::numeric_limits<float>::max(),
+                visitor);
+        }
+
+      private:
+        static const std::size_t QueryPointCount = 1000;
+
+        knn::Answer<float>      m_answer;
+        std::size_t             m_accumulator = 0;
+    };
+
+    typedef Fixture<20, 1>  K20Leaf1Fixture;
+    typedef Fixture<20, 4>  K20Leaf4Fixture;
+    typedef Fixture<20, 8>  K20Leaf8Fixture;
+    typedef Fixture<20, 16> K20Leaf16Fixture;
+    typedef Fixture<100, 1> K100Leaf1Fixture;
+    typedef Fixture<100, 8> K100Leaf8Fixture;
+
+    BENCHMARK_CASE_F(PhotonMap_K20_LeafSize1, K20Leaf1Fixture)                  { run_queries(); }
+    BENCHMARK_CASE_F(PhotonMap_K20_LeafSize4, K20Leaf4Fixture)                  { run_queries(); }
+    BENCHMARK_CASE_F(PhotonMap_K20_LeafSize8, K20Leaf8Fixture)                  { run_queries(); }
+    BENCHMARK_CASE_F(PhotonMap_K20_LeafSize16, K20Leaf16Fixture)                { run_queries(); }
+    BENCHMARK_CASE_F(PhotonMap_K100_LeafSize1, K100Leaf1Fixture)                { run_queries(); }
+    BENCHMARK_CASE_F(PhotonMap_K100_LeafSize8, K100Leaf8Fixture)                { run_queries(); }
+
+    BENCHMARK_CASE_F(PhotonMap_Batch_K20_LeafSize1, K20Leaf1Fixture)            { run_batch_queries(); }
+    BENCHMARK_CASE_F(PhotonMap_Batch_K20_LeafSize8, K20Leaf8Fixture)            { run_batch_queries(); }
+    BENCHMARK_CASE_F(PhotonMap_Batch_K100_LeafSize8, K100Leaf8Fixture)          { run_batch_queries(); }
+}
+
 BENCHMARK_SUITE(Foundation_Math_Knn_AnyQuery)
 {
     class Fixture
@@ -28,13 +28,16 @@
 //
 
 // appleseed.foundation headers.
+#include "foundation/log/log.h"
 #include "foundation/memory/poolallocator.h"
 #include "foundation/utility/benchmark.h"
+#include "foundation/utility/job.h"
 
 // Standard headers.
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 using namespace foundation;
 
@@ -114,3 +117,102 @@ BENCHMARK_SUITE(Foundation_Utility_PoolAllocator)
         first_allocated_last_deallocated_batch();
     }
 }
+
+BENCHMARK_SUITE(Foundation_Utility_PoolAllocator_MultipleThreads)
+{
+    const size_t N = 100;
+    const size_t JobCount = 64;
+
+    // Allocate and deallocate batches of items on the same thread.
+    template <typename Allocator>
+    class LocalBatchJob
+      : public IJob
+    {
+      public:
+        void execute(const size_t thread_index) override
+        {
+            Allocator allocator;
+            std::uint32_t* p[N];
+
+            for (size_t k = 0; k < 10; ++k)
+            {
+                for (size_t i = 0; i < N; ++i)
+                    p[i] = allocator.allocate(1);
+
+                for (size_t i = 0; i < N; ++i)
+                    allocator.deallocate(p[i], 1);
+            }
+        }
+    };
+
+    // Deallocate a batch of items allocated on another thread.
+    template <typename Allocator>
+    class RemoteDeallocationJob
+      : public IJob
+    {
+      public:
+        explicit RemoteDeallocationJob(std::uint32_t** items)
+          : m_items(items)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            Allocator allocator;
+
+            for (size_t i = 0; i < N; ++i)
+                allocator.deallocate(m_items[i], 1);
+        }
+
+      private:
+        std::uint32_t** m_items;
+    };
+
+    template <typename Allocator, size_t ThreadCount>
+    struct Fixture
+    {
+        Logger                      m_logger;
+        JobQueue                    m_job_queue;
+        JobManager                  m_job_manager;
+        Allocator                   m_allocator;
+        std::vector<std::uint32_t*> m_items;
+
+        Fixture()
+          : m_job_manager(m_logger, m_job_queue, ThreadCount, JobManager::KeepRunningOnEmptyQueue)
+          , m_items(JobCount * N)
+        {
+            m_job_manager.start();
+        }
+
+        void local_batches()
+        {
+            for (size_t i = 0; i < JobCount; ++i)
+                m_job_queue.schedule(new LocalBatchJob<Allocator>());
+
+            m_job_queue.wait_until_completion();
+        }
+
+        void remote_deallocations()
+        {
+            // Allocate all items on this thread, deallocate them on the worker threads.
+            for (size_t i = 0; i < JobCount * N; ++i)
+                m_items[i] = m_allocator.allocate(1);
+
+            for (size_t i = 0; i < JobCount; ++i)
+                m_job_queue.schedule(new RemoteDeallocationJob<Allocator>(&m_items[i * N]));
+
+            m_job_queue.wait_until_completion();
+        }
+    };
+
+    typedef std::allocator<std::uint32_t> DefaultAllocator;
+    typedef PoolAllocator<std::uint32_t, N> PoolAllocator;
+
+    typedef Fixture<DefaultAllocator, 4> QuadThreadedDefaultAllocatorFixture;
+    typedef Fixture<PoolAllocator, 4> QuadThreadedPoolAllocatorFixture;
+
+    BENCHMARK_CASE_F(LocalBatches_DefaultAllocator, QuadThreadedDefaultAllocatorFixture)               { local_batches(); }
+    BENCHMARK_CASE_F(LocalBatches_PoolAllocator, QuadThreadedPoolAllocatorFixture)                     { local_batches(); }
+    BENCHMARK_CASE_F(RemoteDeallocations_DefaultAllocator, QuadThreadedDefaultAllocatorFixture)        { remote_deallocations(); }
+    BENCHMARK_CASE_F(RemoteDeallocations_PoolAllocator, QuadThreadedPoolAllocatorFixture)              { remote_deallocations(); }
+}
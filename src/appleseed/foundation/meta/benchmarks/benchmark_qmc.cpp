@@ -260,6 +260,47 @@ BENCHMARK_SUITE(Foundation_Math_QMC)
         }
     };
 
+    template <typename T>
+    struct Vector4Fixture
+    {
+        Vector<T, 4> m_x;
+
+        void halton_payload()
+        {
+            static const size_t Bases[] = { 2, 3, 5, 7 };
+
+            m_x = Vector<T, 4>(0.0f);
+
+            for (size_t i = 0; i < 64; ++i)
+                m_x += halton_sequence<T, 4>(Bases, i);
+        }
+
+        void faure_scrambled_halton_payload()
+        {
+            m_x = Vector<T, 4>(0.0f);
+
+            for (size_t i = 0; i < 64; ++i)
+            {
+                for (size_t d = 0; d < 4; ++d)
+                    m_x[d] += fast_permuted_radical_inverse<T>(d, FaurePermutations[d], i);
+            }
+        }
+
+        void owen_scrambled_sobol_payload()
+        {
+            m_x = Vector<T, 4>(0.0f);
+
+            for (std::uint32_t i = 0; i < 64; ++i)
+            {
+                float s[4];
+                sobol_owen_scrambled_sample4(i, 0x9E3779B9u, s);
+
+                for (size_t d = 0; d < 4; ++d)
+                    m_x[d] += static_cast<T>(s[d]);
+            }
+        }
+    };
+
     //
     // Radical inverse, single precision.
     //
@@ -369,4 +410,23 @@ BENCHMARK_SUITE(Foundation_Math_QMC)
     {
         hammersley_payload();
     }
+
+    //
+    // 4D sequences.
+    //
+
+    BENCHMARK_CASE_F(HaltonSequence_4D_SinglePrecision, Vector4Fixture<float>)
+    {
+        halton_payload();
+    }
+
+    BENCHMARK_CASE_F(FaureScrambledHaltonSequence_4D_SinglePrecision, Vector4Fixture<float>)
+    {
+        faure_scrambled_halton_payload();
+    }
+
+    BENCHMARK_CASE_F(OwenScrambledSobolSequence_4D_SinglePrecision, Vector4Fixture<float>)
+    {
+        owen_scrambled_sobol_payload();
+    }
 }
@@ -28,6 +28,8 @@
 //
 
 // appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/image/colorspace.h"
 #include "foundation/image/regularspectrum.h"
 #include "foundation/utility/benchmark.h"
 
@@ -39,10 +41,14 @@ BENCHMARK_SUITE(Foundation_Image_RegularSpectrum31f)
     {
         RegularSpectrum31f  m_spectrum1;
         RegularSpectrum31f  m_spectrum2;
+        LightingConditions  m_lighting_conditions;
+        Color3f             m_xyz;
 
         Fixture()
           : m_spectrum1(42.0f)
           , m_spectrum2(1.1f)
+          , m_lighting_conditions(IlluminantCIED65, XYZCMFCIE19312Deg)
+          , m_xyz(0.0f)
         {
         }
     };
@@ -66,4 +72,9 @@ BENCHMARK_SUITE(Foundation_Image_RegularSpectrum31f)
     {
         m_spectrum1 *= m_spectrum2;
     }
+
+    BENCHMARK_CASE_F(ConvertToCIEXYZ, Fixture)
+    {
+        m_xyz += spectrum_to_ciexyz<float>(m_lighting_conditions, m_spectrum2);
+    }
 }
@@ -33,6 +33,8 @@
 #ifdef APPLESEED_USE_SSE
 #include "foundation/math/rng/simdmersennetwister.h"
 #endif
+#include "foundation/math/rng/widepcg.h"
+#include "foundation/math/rng/widexoroshiro128plus.h"
 #include "foundation/math/rng/xoroshiro128plus.h"
 #include "foundation/math/rng/xorshift32.h"
 #include "foundation/math/rng/xorshift64.h"
@@ -138,4 +140,71 @@ BENCHMARK_SUITE(Foundation_Math_RNG)
             m_dummy ^= m_rng.rand_uint32();
         }
     }
+
+    typedef WidePCG<8> WidePCG8;
+    typedef WidePCG<16> WidePCG16;
+    typedef WideXoroshiro128plus<8> WideXoroshiro128plus8;
+    typedef WideXoroshiro128plus<16> WideXoroshiro128plus16;
+
+    BENCHMARK_CASE_F(WidePCG8_RandUint32, Fixture<WidePCG8>)
+    {
+        for (size_t i = 0; i < 250000; ++i)
+        {
+            m_dummy ^= m_rng.rand_uint32();
+            m_dummy ^= m_rng.rand_uint32();
+            m_dummy ^= m_rng.rand_uint32();
+            m_dummy ^= m_rng.rand_uint32();
+        }
+    }
+
+    // The batched cases generate as many numbers as the other cases.
+
+    template <typename RNG>
+    struct BatchFixture
+      : public Fixture<RNG>
+    {
+        std::uint32_t   m_values[RNG::StreamCount];
+
+        void run()
+        {
+            for (size_t i = 0; i < 1000000 / RNG::StreamCount; ++i)
+            {
+                this->m_rng.rand_uint32(m_values);
+
+                for (size_t j = 0; j < RNG::StreamCount; ++j)
+                    this->m_dummy ^= m_values[j];
+            }
+        }
+    };
+
+    BENCHMARK_CASE_F(WidePCG8_RandUint32Batch, BatchFixture<WidePCG8>)
+    {
+        run();
+    }
+
+    BENCHMARK_CASE_F(WidePCG16_RandUint32Batch, BatchFixture<WidePCG16>)
+    {
+        run();
+    }
+
+    BENCHMARK_CASE_F(WideXoroshiro128plus8_RandUint32, Fixture<WideXoroshiro128plus8>)
+    {
+        for (size_t i = 0; i < 250000; ++i)
+        {
+            m_dummy ^= m_rng.rand_uint32();
+            m_dummy ^= m_rng.rand_uint32();
+            m_dummy ^= m_rng.rand_uint32();
+            m_dummy ^= m_rng.rand_uint32();
+        }
+    }
+
+    BENCHMARK_CASE_F(WideXoroshiro128plus8_RandUint32Batch, BatchFixture<WideXoroshiro128plus8>)
+    {
+        run();
+    }
+
+    BENCHMARK_CASE_F(WideXoroshiro128plus16_RandUint32Batch, BatchFixture<WideXoroshiro128plus16>)
+    {
+        run();
+    }
 }
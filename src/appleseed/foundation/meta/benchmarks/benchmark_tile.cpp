@@ -27,11 +27,20 @@
 //
 
 // appleseed.foundation headers.
+#include "foundation/image/accumulatortile.h"
 #include "foundation/image/color.h"
 #include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
+#include "foundation/image/tilepool.h"
+#include "foundation/memory/memory.h"
+#include "foundation/math/vector.h"
 #include "foundation/utility/benchmark.h"
 
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 using namespace foundation;
 
 BENCHMARK_SUITE(Foundation_Image_Tile)
@@ -69,4 +78,117 @@ BENCHMARK_SUITE(Foundation_Image_Tile)
     {
         m_dest.copy_from(m_source);
     }
+
+    // Create and destroy a batch of tiles, as a tile cache does when evicting and loading tiles.
+    struct CreateDestroyFixture
+    {
+        static const size_t TileCount = 32;
+        static const size_t TileSize = 64 * 64 * 4 * sizeof(float);
+
+        void* m_ptrs[TileCount];
+        bool  m_use_large_pages;
+
+        CreateDestroyFixture()
+          : m_use_large_pages(TilePool::instance().get_use_large_pages())
+        {
+        }
+
+        ~CreateDestroyFixture()
+        {
+            TilePool::instance().set_use_large_pages(m_use_large_pages);
+        }
+
+        void create_destroy_tiles(const size_t tile_width, const size_t tile_count)
+        {
+            Tile* tiles[TileCount];
+
+            for (size_t i = 0; i < tile_count; ++i)
+                tiles[i] = new Tile(tile_width, tile_width, 4, PixelFormatFloat);
+
+            for (size_t i = 0; i < tile_count; ++i)
+                delete tiles[i];
+        }
+    };
+
+    // Baseline: what Tile did before it allocated its pixels from TilePool.
+    BENCHMARK_CASE_F(CreateDestroy_NewDelete, CreateDestroyFixture)
+    {
+        for (size_t i = 0; i < TileCount; ++i)
+            m_ptrs[i] = new std::uint8_t[TileSize];
+
+        for (size_t i = 0; i < TileCount; ++i)
+            delete[] static_cast<std::uint8_t*>(m_ptrs[i]);
+    }
+
+    BENCHMARK_CASE_F(CreateDestroy_AlignedMalloc, CreateDestroyFixture)
+    {
+        for (size_t i = 0; i < TileCount; ++i)
+            m_ptrs[i] = aligned_malloc(TileSize, 64);
+
+        for (size_t i = 0; i < TileCount; ++i)
+            aligned_free(m_ptrs[i]);
+    }
+
+    BENCHMARK_CASE_F(CreateDestroy_TilePool, CreateDestroyFixture)
+    {
+        for (size_t i = 0; i < TileCount; ++i)
+            m_ptrs[i] = TilePool::instance().allocate(TileSize);
+
+        for (size_t i = 0; i < TileCount; ++i)
+            TilePool::instance().deallocate(m_ptrs[i], TileSize);
+    }
+
+    BENCHMARK_CASE_F(CreateDestroy_Tile_64x64, CreateDestroyFixture)
+    {
+        TilePool::instance().set_use_large_pages(false);
+        create_destroy_tiles(64, TileCount);
+    }
+
+    // Large pages only apply to blocks of at least 2 MB.
+    BENCHMARK_CASE_F(CreateDestroy_Tile_512x512, CreateDestroyFixture)
+    {
+        TilePool::instance().set_use_large_pages(false);
+        create_destroy_tiles(512, 8);
+    }
+
+    BENCHMARK_CASE_F(CreateDestroy_Tile_512x512_LargePages, CreateDestroyFixture)
+    {
+        TilePool::instance().set_use_large_pages(true);
+        create_destroy_tiles(512, 8);
+    }
+
+    template <size_t ChannelCount>
+    struct AccumulatorTileAddFixture
+    {
+        AccumulatorTile     m_tile;
+        std::vector<float>  m_values;
+
+        AccumulatorTileAddFixture()
+          : m_tile(64, 64, ChannelCount)
+          , m_values(ChannelCount, 0.5f)
+        {
+            m_tile.clear();
+        }
+
+        void add_payload()
+        {
+            for (size_t y = 0; y < 64; ++y)
+            {
+                for (size_t x = 0; x < 64; ++x)
+                    m_tile.add(Vector2u(x, y), &m_values[0]);
+            }
+        }
+    };
+
+    // Main color only.
+    BENCHMARK_CASE_F(AccumulatorTileAdd_4Channels, AccumulatorTileAddFixture<4>)
+    {
+        add_payload();
+    }
+
+    // Main color and 10 RGBA AOVs.
+    BENCHMARK_CASE_F(AccumulatorTileAdd_44Channels, AccumulatorTileAddFixture<44>)
+    {
+        add_payload();
+    }
 }
@@ -0,0 +1,97 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/image/accumulatortile.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Image_AccumulatorTile)
+{
+    // Use a channel count that exercises the AVX, SSE and scalar code paths.
+    const size_t ChannelCount = 15;
+
+    TEST_CASE(Add_AccumulatesValuesAndWeight)
+    {
+        AccumulatorTile tile(2, 2, ChannelCount);
+        tile.clear();
+
+        std::vector<float> values(ChannelCount);
+        for (size_t i = 0; i < ChannelCount; ++i)
+            values[i] = static_cast<float>(i + 1);
+
+        tile.add(Vector2u(1, 0), &values[0]);
+        tile.add(Vector2u(1, 0), &values[0]);
+
+        const float* ptr = tile.pixel(1, 0);
+        EXPECT_EQ(2.0f, ptr[0]);
+        for (size_t i = 0; i < ChannelCount; ++i)
+            EXPECT_EQ(2.0f * values[i], ptr[1 + i]);
+
+        std::vector<float> result(ChannelCount);
+        tile.get_pixel(1, 0, &result[0]);
+        for (size_t i = 0; i < ChannelCount; ++i)
+            EXPECT_EQ(values[i], result[i]);
+    }
+
+    TEST_CASE(Add_DoesNotTouchOtherPixels)
+    {
+        AccumulatorTile tile(2, 2, ChannelCount);
+        tile.clear();
+
+        const std::vector<float> values(ChannelCount, 1.0f);
+        tile.add(Vector2u(0, 1), &values[0]);
+
+        for (size_t i = 0; i < tile.get_pixel_count(); ++i)
+        {
+            if (i == 2)
+                continue;
+
+            const float* ptr = tile.pixel(i);
+            for (size_t c = 0; c < ChannelCount + 1; ++c)
+                EXPECT_EQ(0.0f, ptr[c]);
+        }
+    }
+
+    TEST_CASE(Add_IgnoresSamplesOutsideCropWindow)
+    {
+        AccumulatorTile tile(2, 2, ChannelCount, AABB2u(Vector2u(0, 0), Vector2u(0, 0)));
+        tile.clear();
+
+        const std::vector<float> values(ChannelCount, 1.0f);
+        tile.add(Vector2u(1, 1), &values[0]);
+
+        EXPECT_EQ(0.0f, tile.pixel(1, 1)[0]);
+    }
+}
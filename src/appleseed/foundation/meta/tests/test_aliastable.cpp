@@ -0,0 +1,125 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/math/aliastable.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Math_AliasTable)
+{
+    typedef foundation::AliasTable<int, double> AliasTable;
+
+    TEST_CASE(Valid_GivenTableInInitialState_ReturnsFalse)
+    {
+        AliasTable table;
+
+        EXPECT_FALSE(table.valid());
+    }
+
+    TEST_CASE(Valid_GivenTableWithOneItemWithZeroWeight_ReturnsFalse)
+    {
+        AliasTable table;
+        table.insert(1, 0.0);
+
+        EXPECT_FALSE(table.valid());
+    }
+
+    TEST_CASE(Sample_GivenTableWithOneItemWithPositiveWeight_ReturnsItem)
+    {
+        AliasTable table;
+        table.insert(1, 0.5);
+        table.prepare();
+
+        const AliasTable::ItemWeightPair result = table.sample(0.5);
+
+        EXPECT_EQ(1, result.first);
+        EXPECT_FEQ(1.0, result.second);
+    }
+
+    TEST_CASE(Sample_GivenItemsWithZeroWeight_NeverReturnsThem)
+    {
+        AliasTable table;
+        table.insert(1, 0.0);
+        table.insert(2, 1.0);
+        table.insert(3, 0.0);
+        table.prepare();
+
+        for (size_t i = 0; i < 100; ++i)
+            EXPECT_EQ(2, table.sample(i / 100.0).first);
+    }
+
+    TEST_CASE(Sample_GivenUniformSamples_ReturnsItemsProportionallyToTheirWeight)
+    {
+        AliasTable table;
+        table.insert(0, 0.1);
+        table.insert(1, 0.6);
+        table.insert(2, 0.3);
+        table.prepare();
+
+        const size_t SampleCount = 1000;
+        size_t counts[3] = { 0, 0, 0 };
+
+        for (size_t i = 0; i < SampleCount; ++i)
+            ++counts[table.sample((i + 0.5) / SampleCount).first];
+
+        EXPECT_EQ(100, counts[0]);
+        EXPECT_EQ(600, counts[1]);
+        EXPECT_EQ(300, counts[2]);
+    }
+
+    TEST_CASE(Sample_GivenUniformSamples_ReturnsUniformResiduals)
+    {
+        AliasTable table;
+        table.insert(0, 0.1);
+        table.insert(1, 0.9);
+        table.prepare();
+
+        const size_t SampleCount = 1000;
+        double residual_sum[2] = { 0.0, 0.0 };
+        size_t counts[2] = { 0, 0 };
+
+        for (size_t i = 0; i < SampleCount; ++i)
+        {
+            double residual;
+            const int item = table.sample((i + 0.5) / SampleCount, residual).first;
+
+            EXPECT_TRUE(residual >= 0.0 && residual < 1.0);
+
+            residual_sum[item] += residual;
+            ++counts[item];
+        }
+
+        EXPECT_FEQ_EPS(0.5, residual_sum[0] / counts[0], 0.01);
+        EXPECT_FEQ_EPS(0.5, residual_sum[1] / counts[1], 0.01);
+    }
+}
@@ -29,6 +29,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/image/analysis.h"
+#include "foundation/image/canvasproperties.h"
 #include "foundation/image/color.h"
 #include "foundation/image/image.h"
 #include "foundation/image/pixel.h"
@@ -158,4 +159,56 @@ TEST_SUITE(Foundation_Image_Analysis)
 
         EXPECT_FEQ_EPS(std::sqrt(2.0 / 3.0), rmsd, 1.0e-6);
     }
+
+    TEST_CASE(TiledImageAnalysis_GivenNoUpdatedTile_AnalyzesBlackImage)
+    {
+        Image ref_image(4, 4, 3, 3, 4, PixelFormatFloat);
+        ref_image.clear(Color4f(1.0f));
+
+        const TiledImageAnalysis analysis(CanvasProperties(4, 4, 2, 2, 4, PixelFormatFloat), &ref_image);
+
+        EXPECT_EQ(0.0, analysis.get_average_luminance());
+        EXPECT_FEQ(1.0, analysis.get_rms_deviation());
+    }
+
+    TEST_CASE(TiledImageAnalysis_GivenAllTilesUpdated_MatchesWholeImageAnalysis)
+    {
+        Image image(5, 5, 2, 2, 4, PixelFormatFloat);
+        image.clear(Color4f(0.5f, 0.25f, 1.0f, 1.0f));
+        image.tile(0, 0).set_pixel(1, 1, Color4f(FP<float>::snan()));
+        image.tile(2, 1).set_pixel(0, 1, Color4f(2.0f, -1.0f, 3.0f, 1.0f));
+
+        TiledImageAnalysis analysis(image.properties());
+
+        for (size_t ty = 0; ty < 3; ++ty)
+        {
+            for (size_t tx = 0; tx < 3; ++tx)
+                analysis.update_tile(tx, ty, image.tile(tx, ty));
+        }
+
+        EXPECT_FEQ_EPS(compute_average_luminance(image), analysis.get_average_luminance(), 1.0e-6);
+    }
+
+    TEST_CASE(TiledImageAnalysis_GivenTileUpdatedTwice_KeepsLatestContents)
+    {
+        Image image(4, 4, 2, 2, 4, PixelFormatFloat);
+        image.clear(Color4f(1.0f));
+
+        Image ref_image(4, 4, 3, 3, 3, PixelFormatFloat);
+        ref_image.clear(Color3f(0.5f));
+
+        TiledImageAnalysis analysis(image.properties(), &ref_image);
+
+        for (size_t ty = 0; ty < 2; ++ty)
+        {
+            for (size_t tx = 0; tx < 2; ++tx)
+                analysis.update_tile(tx, ty, image.tile(tx, ty));
+        }
+
+        image.tile(1, 1).clear(Color4f(0.0f));
+        analysis.update_tile(1, 1, image.tile(1, 1));
+
+        EXPECT_FEQ_EPS(compute_average_luminance(image), analysis.get_average_luminance(), 1.0e-6);
+        EXPECT_FEQ_EPS(compute_rms_deviation(image, ref_image), analysis.get_rms_deviation(), 1.0e-6);
+    }
 }
@@ -0,0 +1,141 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/memory/arena.h"
+#include "foundation/memory/memory.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Memory_Arena)
+{
+    TEST_CASE(Allocate_ReturnsAlignedPointers)
+    {
+        Arena arena;
+
+        for (size_t i = 1; i < 100; ++i)
+            EXPECT_TRUE(is_aligned(arena.allocate(i), 16));
+    }
+
+    TEST_CASE(Allocate_GivenMoreMemoryThanInlineBuffer_GrowsArena)
+    {
+        Arena arena;
+        const size_t initial_capacity = arena.get_capacity();
+
+        // Write to every allocation to catch overlapping blocks.
+        std::uint8_t* blocks[64];
+        for (size_t i = 0; i < 64; ++i)
+        {
+            blocks[i] = static_cast<std::uint8_t*>(arena.allocate(4096));
+            std::memset(blocks[i], static_cast<int>(i), 4096);
+        }
+
+        for (size_t i = 0; i < 64; ++i)
+        {
+            EXPECT_EQ(i, blocks[i][0]);
+            EXPECT_EQ(i, blocks[i][4095]);
+        }
+
+        EXPECT_GT(initial_capacity, arena.get_capacity());
+        EXPECT_GT(0, arena.get_chunk_allocation_count());
+    }
+
+    TEST_CASE(Allocate_GivenAllocationLargerThanDefaultChunkSize_Succeeds)
+    {
+        Arena arena;
+
+        std::uint8_t* ptr = static_cast<std::uint8_t*>(arena.allocate(1024 * 1024));
+        std::memset(ptr, 0, 1024 * 1024);
+
+        EXPECT_TRUE(arena.get_capacity() >= 1024 * 1024);
+    }
+
+    TEST_CASE(Clear_ReusesChunks)
+    {
+        Arena arena;
+
+        for (size_t i = 0; i < 64; ++i)
+            arena.allocate(4096);
+
+        const size_t chunk_allocation_count = arena.get_chunk_allocation_count();
+        arena.clear();
+
+        for (size_t i = 0; i < 64; ++i)
+            arena.allocate(4096);
+
+        EXPECT_EQ(chunk_allocation_count, arena.get_chunk_allocation_count());
+    }
+
+    TEST_CASE(Reset_ReleasesOnlyAllocationsMadeAfterMarker)
+    {
+        Arena arena;
+
+        int* kept = arena.allocate<int>();
+        *kept = 42;
+
+        const Arena::Marker marker = arena.get_marker();
+        void* released = arena.allocate(16);
+        arena.reset(marker);
+
+        EXPECT_EQ(released, arena.allocate(16));
+        EXPECT_EQ(42, *kept);
+    }
+
+    TEST_CASE(Reset_GivenMarkerInPreviousChunk_ReturnsToThatChunk)
+    {
+        Arena arena;
+
+        arena.allocate(16);
+        const Arena::Marker marker = arena.get_marker();
+        void* first = arena.allocate(16);
+
+        for (size_t i = 0; i < 64; ++i)
+            arena.allocate(4096);
+
+        arena.reset(marker);
+
+        EXPECT_EQ(first, arena.allocate(16));
+    }
+
+    TEST_CASE(GetHighWaterMark_ReturnsLargestUsedSize)
+    {
+        Arena arena;
+
+        arena.allocate(1000);
+        arena.clear();
+        arena.allocate(100);
+
+        EXPECT_EQ(static_cast<size_t>(align(1000, 16)), arena.get_high_water_mark());
+    }
+}
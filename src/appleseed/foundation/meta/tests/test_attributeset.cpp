@@ -73,6 +73,17 @@ TEST_SUITE(Foundation_Utility_AttributeSet)
         EXPECT_EQ(1, attributes.get_attribute_count(uv_id));
     }
 
+    TEST_CASE_F(TestClearAttributes, FixtureTestAttributeSet)
+    {
+        const Vector2f UV(0.2f, 0.4f);
+        attributes.push_attribute(uv_id, UV);
+
+        attributes.clear_attributes(uv_id);
+
+        EXPECT_EQ(0, attributes.get_attribute_count(uv_id));
+        EXPECT_EQ(uv_id, attributes.find_channel("uv"));
+    }
+
     TEST_CASE_F(TestGetAttribute, FixtureTestAttributeSet)
     {
         const Vector2f RefUV(0.2f, 0.4f);
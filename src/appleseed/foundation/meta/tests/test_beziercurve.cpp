@@ -34,6 +34,8 @@
 #include "foundation/math/beziercurve.h"
 #include "foundation/math/matrix.h"
 #include "foundation/math/ray.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 #include "foundation/utility/countof.h"
@@ -717,6 +719,99 @@ TEST_SUITE(Foundation_Math_BezierCurveIntersector)
     }
 
 
+    //
+    // Check ray space culling.
+    //
+
+    // Return true if cull() never rejects a curve that intersect() reports as hit.
+    template <typename BezierCurveType>
+    bool cull_never_rejects_intersected_curves()
+    {
+        typedef BezierCurveIntersector<BezierCurveType> BezierCurveIntersectorType;
+        const size_t BatchSize = BezierCurveIntersectorType::CullBatchSize;
+        const size_t ControlPointCount = BezierCurveType::Degree + 1;
+
+        MersenneTwister rng;
+
+        for (size_t trial = 0; trial < 1000; ++trial)
+        {
+            BezierCurveType curves[BatchSize];
+            const BezierCurveType* batch[BatchSize];
+
+            for (size_t i = 0; i < BatchSize; ++i)
+            {
+                Vector3f control_points[ControlPointCount];
+                for (size_t j = 0; j < ControlPointCount; ++j)
+                {
+                    control_points[j] =
+                        Vector3f(
+                            rand_float1(rng, -1.0f, 1.0f),
+                            rand_float1(rng, -1.0f, 1.0f),
+                            rand_float1(rng, -1.0f, 1.0f));
+                }
+
+                curves[i] = BezierCurveType(control_points, rand_float1(rng, 0.01f, 0.2f), 1.0f, Color3f(1.0f));
+                batch[i] = &curves[i];
+            }
+
+            const Ray3f ray(
+                Vector3f(rand_float1(rng, -0.5f, 0.5f), rand_float1(rng, -0.5f, 0.5f), -3.0f),
+                Vector3f(rand_float1(rng, -0.2f, 0.2f), rand_float1(rng, -0.2f, 0.2f), rand_float1(rng, 0.5f, 2.0f)));
+
+            Matrix4f xfm_matrix;
+            make_curve_projection_transform(xfm_matrix, ray);
+
+            const float t = std::numeric_limits<float>::max();
+
+            for (size_t count = 1; count <= BatchSize; ++count)
+            {
+                const size_t mask = BezierCurveIntersectorType::cull(batch, count, ray, xfm_matrix, t);
+
+                if (mask >> count != 0)
+                    return false;
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    float u, v, hit_t = t;
+                    if (BezierCurveIntersectorType::intersect(curves[i], ray, xfm_matrix, u, v, hit_t) &&
+                        (mask & (size_t(1) << i)) == 0)
+                        return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    TEST_CASE(Cull_GivenRandomBezier1Curves_NeverCullsIntersectedCurves)
+    {
+        EXPECT_TRUE(cull_never_rejects_intersected_curves<BezierCurve1f>());
+    }
+
+    TEST_CASE(Cull_GivenRandomBezier3Curves_NeverCullsIntersectedCurves)
+    {
+        EXPECT_TRUE(cull_never_rejects_intersected_curves<BezierCurve3f>());
+    }
+
+    TEST_CASE(Cull_GivenCurveBehindRay_CullsCurve)
+    {
+        const Vector3f ControlPoints[] = { Vector3f(-0.5f, 0.0f, -5.0f), Vector3f(0.5f, 0.0f, -5.0f) };
+        const BezierCurve1f Curve(ControlPoints, 0.06f, 1.0f, Color3f(0.2f, 0.0f, 0.7f));
+        const BezierCurve1f* Batch[] = { &Curve };
+
+        const Ray3f ray(Vector3f(0.0f, 0.0f, -3.0f), Vector3f(0.0f, 0.0f, 1.0f));
+
+        Matrix4f xfm_matrix;
+        make_curve_projection_transform(xfm_matrix, ray);
+
+        const size_t mask =
+            BezierCurveIntersector<BezierCurve1f>::cull(
+                Batch, 1, ray, xfm_matrix, std::numeric_limits<float>::max());
+
+        EXPECT_EQ(0, mask);
+    }
+
+
     //
     // Check barycentric coordinates of ray-curve intersections.
     //
@@ -0,0 +1,319 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/math/vector.h"
+#include "foundation/mesh/binarymeshfilereader.h"
+#include "foundation/mesh/binarymeshfilewriter.h"
+#include "foundation/mesh/imeshwalker.h"
+#include "foundation/mesh/meshbuilderbase.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Mesh_BinaryMeshFile)
+{
+    struct Face
+    {
+        std::vector<size_t>      m_vertices;
+        size_t                   m_material;
+
+        bool operator==(const Face& rhs) const
+        {
+            return m_vertices == rhs.m_vertices && m_material == rhs.m_material;
+        }
+    };
+
+    struct Mesh
+    {
+        std::string              m_name;
+        std::vector<Vector3d>    m_vertices;
+        std::vector<std::string> m_material_slots;
+        std::vector<Face>        m_faces;
+
+        bool operator==(const Mesh& rhs) const
+        {
+            return
+                m_name == rhs.m_name &&
+                m_vertices == rhs.m_vertices &&
+                m_material_slots == rhs.m_material_slots &&
+                m_faces == rhs.m_faces;
+        }
+    };
+
+    struct MeshBuilder
+      : public MeshBuilderBase
+    {
+        std::vector<Mesh>        m_meshes;
+        size_t                   m_face_vertex_count;
+
+        void begin_mesh(const char* name) override
+        {
+            m_meshes.emplace_back();
+            m_meshes.back().m_name = name;
+        }
+
+        size_t push_vertex(const Vector3d& v) override
+        {
+            m_meshes.back().m_vertices.push_back(v);
+            return m_meshes.back().m_vertices.size() - 1;
+        }
+
+        size_t push_material_slot(const char* name) override
+        {
+            m_meshes.back().m_material_slots.push_back(name);
+            return m_meshes.back().m_material_slots.size() - 1;
+        }
+
+        void begin_face(const size_t vertex_count) override
+        {
+            m_meshes.back().m_faces.emplace_back();
+            m_face_vertex_count = vertex_count;
+        }
+
+        void set_face_vertices(const size_t vertices[]) override
+        {
+            m_meshes.back().m_faces.back().m_vertices.assign(vertices, vertices + m_face_vertex_count);
+        }
+
+        void set_face_material(const size_t material) override
+        {
+            m_meshes.back().m_faces.back().m_material = material;
+        }
+    };
+
+    struct MeshWalker
+      : public IMeshWalker
+    {
+        const Mesh& m_mesh;
+
+        explicit MeshWalker(const Mesh& mesh)
+          : m_mesh(mesh)
+        {
+        }
+
+        const char* get_name() const override
+        {
+            return m_mesh.m_name.c_str();
+        }
+
+        size_t get_vertex_count() const override
+        {
+            return m_mesh.m_vertices.size();
+        }
+
+        Vector3d get_vertex(const size_t i) const override
+        {
+            return m_mesh.m_vertices[i];
+        }
+
+        size_t get_vertex_normal_count() const override
+        {
+            return 0;
+        }
+
+        Vector3d get_vertex_normal(const size_t i) const override
+        {
+            return Vector3d();
+        }
+
+        size_t get_tex_coords_count() const override
+        {
+            return 0;
+        }
+
+        Vector2d get_tex_coords(const size_t i) const override
+        {
+            return Vector2d();
+        }
+
+        size_t get_material_slot_count() const override
+        {
+            return m_mesh.m_material_slots.size();
+        }
+
+        const char* get_material_slot(const size_t i) const override
+        {
+            return m_mesh.m_material_slots[i].c_str();
+        }
+
+        size_t get_face_count() const override
+        {
+            return m_mesh.m_faces.size();
+        }
+
+        size_t get_face_vertex_count(const size_t face_index) const override
+        {
+            return m_mesh.m_faces[face_index].m_vertices.size();
+        }
+
+        size_t get_face_vertex(const size_t face_index, const size_t vertex_index) const override
+        {
+            return m_mesh.m_faces[face_index].m_vertices[vertex_index];
+        }
+
+        size_t get_face_vertex_normal(const size_t face_index, const size_t vertex_index) const override
+        {
+            return 0;
+        }
+
+        size_t get_face_tex_coords(const size_t face_index, const size_t vertex_index) const override
+        {
+            return 0;
+        }
+
+        size_t get_face_material(const size_t face_index) const override
+        {
+            return m_mesh.m_faces[face_index].m_material;
+        }
+    };
+
+    Mesh create_mesh(const std::string& name)
+    {
+        Mesh mesh;
+        mesh.m_name = name;
+
+        mesh.m_vertices.emplace_back(0.0, 0.0, 0.0);
+        mesh.m_vertices.emplace_back(1.0, 0.0, 0.0);
+        mesh.m_vertices.emplace_back(1.0, 1.0, 0.0);
+        mesh.m_vertices.emplace_back(0.0, 1.0, 0.0);
+        mesh.m_vertices.emplace_back(0.5, 0.5, 1.0);
+
+        mesh.m_material_slots.push_back("front");
+        mesh.m_material_slots.push_back("back");
+
+        Face quad;
+        quad.m_vertices = { 0, 1, 2, 3 };
+        quad.m_material = 0;
+        mesh.m_faces.push_back(quad);
+
+        Face triangle;
+        triangle.m_vertices = { 0, 1, 4 };
+        triangle.m_material = 1;
+        mesh.m_faces.push_back(triangle);
+
+        return mesh;
+    }
+
+    void write_and_read_back(
+        const char*                         filename,
+        const BinaryMeshFileWriter::Format  format,
+        const Mesh&                         mesh1,
+        const Mesh&                         mesh2,
+        MeshBuilder&                        builder)
+    {
+        {
+            BinaryMeshFileWriter writer(filename, format);
+            MeshWalker walker1(mesh1);
+            writer.write(walker1);
+            MeshWalker walker2(mesh2);
+            writer.write(walker2);
+        }
+
+        BinaryMeshFileReader reader(filename);
+        reader.read(builder);
+    }
+
+    TEST_CASE(WriteAndReadCompressedFile)
+    {
+        const Mesh mesh1 = create_mesh("mesh1");
+        const Mesh mesh2 = create_mesh("mesh2");
+
+        MeshBuilder builder;
+        write_and_read_back(
+            "unit tests/outputs/test_binarymeshfile_compressed.binarymesh",
+            BinaryMeshFileWriter::CompressedFormat,
+            mesh1,
+            mesh2,
+            builder);
+
+        ASSERT_EQ(2, builder.m_meshes.size());
+        EXPECT_TRUE(mesh1 == builder.m_meshes[0]);
+        EXPECT_TRUE(mesh2 == builder.m_meshes[1]);
+    }
+
+    TEST_CASE(WriteAndReadMappableFile)
+    {
+        const Mesh mesh1 = create_mesh("mesh1");
+        const Mesh mesh2 = create_mesh("mesh2");
+
+        MeshBuilder builder;
+        write_and_read_back(
+            "unit tests/outputs/test_binarymeshfile_mappable.binarymesh",
+            BinaryMeshFileWriter::MappableFormat,
+            mesh1,
+            mesh2,
+            builder);
+
+        ASSERT_EQ(2, builder.m_meshes.size());
+        EXPECT_TRUE(mesh1 == builder.m_meshes[0]);
+        EXPECT_TRUE(mesh2 == builder.m_meshes[1]);
+    }
+
+    TEST_CASE(ReadTruncatedMappableFile_ThrowsExceptionIOError)
+    {
+        const char* Filename = "unit tests/outputs/test_binarymeshfile_truncated.binarymesh";
+
+        {
+            const Mesh mesh = create_mesh("mesh");
+            BinaryMeshFileWriter writer(Filename, BinaryMeshFileWriter::MappableFormat);
+            MeshWalker walker(mesh);
+            writer.write(walker);
+        }
+
+        // Cut the file in the middle of the vertex array.
+        std::vector<char> contents(4096 + 8, 0);
+        {
+            std::FILE* file = std::fopen(Filename, "rb");
+            ASSERT_TRUE(file != nullptr);
+            EXPECT_EQ(contents.size(), std::fread(&contents[0], 1, contents.size(), file));
+            std::fclose(file);
+        }
+        {
+            std::FILE* file = std::fopen(Filename, "wb");
+            ASSERT_TRUE(file != nullptr);
+            std::fwrite(&contents[0], 1, contents.size(), file);
+            std::fclose(file);
+        }
+
+        BinaryMeshFileReader reader(Filename);
+        MeshBuilder builder;
+
+        EXPECT_EXCEPTION(ExceptionIOError,
+        {
+            reader.read(builder);
+        });
+    }
+}
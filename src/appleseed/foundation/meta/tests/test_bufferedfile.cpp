@@ -32,9 +32,11 @@
 #include "foundation/utility/test.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 
@@ -312,4 +314,63 @@ TEST_SUITE(Foundation_Utility_BufferedFile)
         EXPECT_EQ(4, file.read(value));
         EXPECT_EQ(Value2, value);
     }
+
+    std::vector<std::uint32_t> make_lz4_test_data()
+    {
+        std::vector<std::uint32_t> data(1000);
+
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = static_cast<std::uint32_t>(i * i);
+
+        return data;
+    }
+
+    TEST_CASE(ParallelLZ4CompressedWriterAdapter_OutputIsReadableByLZ4CompressedReaderAdapter)
+    {
+        const std::vector<std::uint32_t> expected = make_lz4_test_data();
+
+        {
+            BufferedFile file(Filename, BufferedFile::BinaryType, BufferedFile::WriteMode);
+            ParallelLZ4CompressedWriterAdapter writer(file, 64, 3);
+            writer.write(&expected[0], expected.size() * sizeof(std::uint32_t));
+        }
+
+        BufferedFile file(Filename, BufferedFile::BinaryType, BufferedFile::ReadMode);
+        LZ4CompressedReaderAdapter reader(file);
+        std::vector<std::uint32_t> data(expected.size());
+        const size_t read_bytes = reader.read(&data[0], data.size() * sizeof(std::uint32_t));
+
+        EXPECT_EQ(expected.size() * sizeof(std::uint32_t), read_bytes);
+        EXPECT_SEQUENCE_EQ(expected.size(), &expected[0], &data[0]);
+    }
+
+    TEST_CASE(ParallelLZ4CompressedReaderAdapter_ReadsOutputOfLZ4CompressedWriterAdapter)
+    {
+        const std::vector<std::uint32_t> expected = make_lz4_test_data();
+
+        {
+            BufferedFile file(Filename, BufferedFile::BinaryType, BufferedFile::WriteMode);
+            LZ4CompressedWriterAdapter writer(file, 64);
+            writer.write(&expected[0], expected.size() * sizeof(std::uint32_t));
+        }
+
+        BufferedFile file(Filename, BufferedFile::BinaryType, BufferedFile::ReadMode);
+        ParallelLZ4CompressedReaderAdapter reader(file, 3);
+        std::vector<std::uint32_t> data(expected.size());
+
+        // Read in small, unaligned pieces to cross block boundaries.
+        const size_t total_bytes = data.size() * sizeof(std::uint32_t);
+        std::uint8_t* ptr = reinterpret_cast<std::uint8_t*>(&data[0]);
+        size_t read_bytes = 0;
+        while (read_bytes < total_bytes)
+        {
+            const size_t bytes = reader.read(ptr + read_bytes, std::min<size_t>(37, total_bytes - read_bytes));
+            if (bytes == 0)
+                break;
+            read_bytes += bytes;
+        }
+
+        EXPECT_EQ(total_bytes, read_bytes);
+        EXPECT_SEQUENCE_EQ(expected.size(), &expected[0], &data[0]);
+    }
 }
@@ -32,12 +32,17 @@
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
 #include "foundation/math/ray.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/xorshift32.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/defaulttimers.h"
 #include "foundation/utility/iostreamop.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <vector>
 
 using namespace foundation;
@@ -75,6 +80,170 @@ TEST_SUITE(Foundation_Math_BVH_Node)
     }
 }
 
+namespace
+{
+    typedef AlignedVector<bvh::Node<AABB3d>> NodeVector;
+    typedef std::vector<AABB3d> AABBVector;
+
+    struct TestTree
+      : public bvh::Tree<NodeVector>
+    {
+        const NodeVector& get_nodes() const
+        {
+            return m_nodes;
+        }
+    };
+
+    AABBVector make_random_bboxes(const size_t count)
+    {
+        Xorshift32 rng;
+        AABBVector bboxes;
+        bboxes.reserve(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            Vector3d center;
+            center[0] = rand_double1(rng, -100.0, 100.0);
+            center[1] = rand_double1(rng, -100.0, 100.0);
+            center[2] = rand_double1(rng, -10.0, 10.0);
+            const Vector3d extent(rand_double1(rng, 0.01, 1.0));
+            bboxes.emplace_back(center - extent, center + extent);
+        }
+
+        return bboxes;
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_Builder)
+{
+    typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+    typedef bvh::Builder<TestTree, Partitioner> Builder;
+
+    bool build_and_compare(const AABBVector& bboxes, const size_t thread_count)
+    {
+        Partitioner ref_partitioner(bboxes, 4);
+        TestTree ref_tree;
+        Builder ref_builder;
+        ref_builder.build<DefaultWallclockTimer>(ref_tree, ref_partitioner, bboxes.size(), 4);
+
+        Partitioner partitioner(bboxes, 4);
+        TestTree tree;
+        Builder builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 4, thread_count);
+
+        if (ref_partitioner.get_item_ordering() != partitioner.get_item_ordering())
+            return false;
+
+        const NodeVector& ref_nodes = ref_tree.get_nodes();
+        const NodeVector& nodes = tree.get_nodes();
+
+        return
+            ref_nodes.size() == nodes.size() &&
+            std::memcmp(&ref_nodes[0], &nodes[0], nodes.size() * sizeof(nodes[0])) == 0;
+    }
+
+    TEST_CASE(Build_SmallTreeWithSeveralThreads_IsIdenticalToSequentialBuild)
+    {
+        EXPECT_TRUE(build_and_compare(make_random_bboxes(100), 4));
+    }
+
+    TEST_CASE(Build_LargeTreeWithSeveralThreads_IsIdenticalToSequentialBuild)
+    {
+        const AABBVector bboxes = make_random_bboxes(50000);
+
+        EXPECT_TRUE(build_and_compare(bboxes, 2));
+        EXPECT_TRUE(build_and_compare(bboxes, 7));
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_BinnedSAHPartitioner)
+{
+    typedef bvh::BinnedSAHPartitioner<AABBVector> Partitioner;
+    typedef bvh::Builder<TestTree, Partitioner> Builder;
+
+    bool leaves_enclose_their_items(
+        const NodeVector&   nodes,
+        const Partitioner&  partitioner,
+        const AABBVector&   bboxes)
+    {
+        const std::vector<size_t>& ordering = partitioner.get_item_ordering();
+
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            if (nodes[i].is_leaf())
+                continue;
+
+            for (size_t c = 0; c < 2; ++c)
+            {
+                const bvh::Node<AABB3d>& child = nodes[nodes[i].get_child_node_index() + c];
+                if (!child.is_leaf())
+                    continue;
+
+                const AABB3d child_bbox = c == 0 ? nodes[i].get_left_bbox() : nodes[i].get_right_bbox();
+                for (size_t j = 0; j < child.get_item_count(); ++j)
+                {
+                    const AABB3d& item_bbox = bboxes[ordering[child.get_item_index() + j]];
+                    if (!child_bbox.contains(item_bbox.min) || !child_bbox.contains(item_bbox.max))
+                        return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    TEST_CASE(Build_LargeTree_OrderingIsPermutationAndLeavesEncloseTheirItems)
+    {
+        const AABBVector bboxes = make_random_bboxes(50000);
+
+        Partitioner partitioner(bboxes, 4);
+        TestTree tree;
+        Builder builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 4, 4);
+
+        std::vector<size_t> ordering = partitioner.get_item_ordering();
+        std::sort(ordering.begin(), ordering.end());
+
+        bool is_permutation = ordering.size() == bboxes.size();
+        for (size_t i = 0; is_permutation && i < ordering.size(); ++i)
+            is_permutation = ordering[i] == i;
+
+        EXPECT_TRUE(is_permutation);
+        EXPECT_TRUE(leaves_enclose_their_items(tree.get_nodes(), partitioner, bboxes));
+    }
+
+    TEST_CASE(Build_LargeTreeWithSeveralThreads_IsIdenticalToSequentialBuild)
+    {
+        const AABBVector bboxes = make_random_bboxes(50000);
+
+        Partitioner ref_partitioner(bboxes, 4);
+        TestTree ref_tree;
+        Builder ref_builder;
+        ref_builder.build<DefaultWallclockTimer>(ref_tree, ref_partitioner, bboxes.size(), 4);
+
+        Partitioner partitioner(bboxes, 4);
+        TestTree tree;
+        Builder builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 4, 7);
+
+        const NodeVector& ref_nodes = ref_tree.get_nodes();
+        const NodeVector& nodes = tree.get_nodes();
+
+        EXPECT_TRUE(ref_partitioner.get_item_ordering() == partitioner.get_item_ordering());
+        ASSERT_EQ(ref_nodes.size(), nodes.size());
+        EXPECT_EQ(0, std::memcmp(&ref_nodes[0], &nodes[0], nodes.size() * sizeof(nodes[0])));
+    }
+
+    TEST_CASE(Partition_ItemsWithIdenticalCenters_SplitsInHalves)
+    {
+        const AABBVector bboxes(10, AABB3d(Vector3d(-1.0), Vector3d(1.0)));
+
+        Partitioner partitioner(bboxes, 2);
+
+        EXPECT_EQ(5, partitioner.partition(0, 10, partitioner.compute_bbox(0, 10)));
+    }
+}
+
 TEST_SUITE(Foundation_Math_BVH_SpatialBuilder)
 {
     struct ItemHandler
@@ -149,3 +318,362 @@ TEST_SUITE(Foundation_Math_BVH_Intersector_2D)
         > intersector;
     }
 }
+
+TEST_SUITE(Foundation_Math_BVH_WideIntersector)
+{
+    typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+    typedef bvh::Builder<TestTree, Partitioner> Builder;
+
+    // Treats items as boxes and finds the closest one.
+    struct ClosestItemVisitor
+    {
+        const AABBVector&           m_bboxes;
+        const std::vector<size_t>&  m_ordering;
+        size_t                      m_closest_item;
+        double                      m_closest_distance;
+
+        ClosestItemVisitor(
+            const AABBVector&           bboxes,
+            const std::vector<size_t>&  ordering,
+            const double                ray_tmax)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+          , m_closest_item(~size_t(0))
+          , m_closest_distance(ray_tmax)
+        {
+        }
+
+        bool visit(
+            const bvh::Node<AABB3d>&    node,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            for (size_t i = node.get_item_index(), e = i + node.get_item_count(); i < e; ++i)
+            {
+                const size_t item = m_ordering[i];
+                double tmin;
+                if (intersect(ray, ray_info, m_bboxes[item], tmin) && tmin < m_closest_distance)
+                {
+                    m_closest_item = item;
+                    m_closest_distance = tmin;
+                }
+            }
+
+            distance = m_closest_distance;
+            return true;
+        }
+    };
+
+    template <size_t Width>
+    size_t count_mismatching_rays(const size_t ray_count)
+    {
+        typedef AlignedVector<bvh::WideNode<AABB3d, Width>> WideNodeVector;
+
+        const AABBVector bboxes = make_random_bboxes(2000);
+
+        Partitioner partitioner(bboxes, 4);
+        TestTree tree;
+        Builder builder;
+        builder.template build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 4);
+
+        WideNodeVector wide_nodes(AlignedAllocator<bvh::WideNode<AABB3d, Width>>(64));
+        bvh::WideBuilder<TestTree, WideNodeVector> wide_builder;
+        wide_builder.template build<DefaultWallclockTimer>(tree, wide_nodes);
+
+        const std::vector<size_t>& ordering = partitioner.get_item_ordering();
+
+        bvh::Intersector<TestTree, ClosestItemVisitor, Ray3d> intersector;
+        bvh::WideIntersector<TestTree, WideNodeVector, ClosestItemVisitor, Ray3d> wide_intersector;
+
+        Xorshift32 rng;
+        size_t mismatch_count = 0;
+
+        for (size_t i = 0; i < ray_count; ++i)
+        {
+            Vector3d org;
+            org[0] = rand_double1(rng, -120.0, 120.0);
+            org[1] = rand_double1(rng, -120.0, 120.0);
+            org[2] = rand_double1(rng, -20.0, 20.0);
+
+            Vector3d target;
+            target[0] = rand_double1(rng, -100.0, 100.0);
+            target[1] = rand_double1(rng, -100.0, 100.0);
+            target[2] = rand_double1(rng, -10.0, 10.0);
+
+            const Ray3d ray(org, normalize(target - org));
+            const RayInfo3d ray_info(ray);
+
+            ClosestItemVisitor visitor(bboxes, ordering, ray.m_tmax);
+            intersector.intersect_no_motion(
+                tree,
+                ray,
+                ray_info,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , bvh::TraversalStatistics()
+#endif
+                );
+
+            ClosestItemVisitor wide_visitor(bboxes, ordering, ray.m_tmax);
+            wide_intersector.intersect_no_motion(
+                tree,
+                wide_nodes,
+                ray,
+                ray_info,
+                wide_visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , bvh::TraversalStatistics()
+#endif
+                );
+
+            if (visitor.m_closest_item != wide_visitor.m_closest_item ||
+                visitor.m_closest_distance != wide_visitor.m_closest_distance)
+                ++mismatch_count;
+        }
+
+        return mismatch_count;
+    }
+
+    TEST_CASE(WideNode_AddChild_StoresBoundingBoxAndIndex)
+    {
+        const AABB3d bbox(Vector3d(1.0, 2.0, 3.0), Vector3d(4.0, 5.0, 6.0));
+
+        bvh::WideNode<AABB3d, 4> node;
+        node.add_child(bbox, 42, true);
+
+        EXPECT_EQ(1, node.get_child_count());
+        EXPECT_EQ(bbox, node.get_child_bbox(0));
+        EXPECT_TRUE(node.is_leaf_child(0));
+        EXPECT_EQ(42, node.get_child_index(0));
+        EXPECT_EQ(~std::uint32_t(0), node.get_child_mask(0));
+    }
+
+    TEST_CASE(IntersectNoMotion_ChildMasksDisjointFromRayMask_VisitsNoLeaf)
+    {
+        typedef AlignedVector<bvh::WideNode<AABB3d, 4>> WideNodeVector;
+
+        const AABBVector bboxes = make_random_bboxes(2000);
+
+        Partitioner partitioner(bboxes, 4);
+        TestTree tree;
+        Builder builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 4);
+
+        WideNodeVector wide_nodes(AlignedAllocator<bvh::WideNode<AABB3d, 4>>(64));
+        bvh::WideBuilder<TestTree, WideNodeVector> wide_builder;
+        wide_builder.build<DefaultWallclockTimer>(tree, wide_nodes);
+
+        for (size_t i = 0, e = wide_nodes[0].get_child_count(); i < e; ++i)
+            wide_nodes[0].set_child_mask(i, 2);
+
+        // Aim at the first item so that the ray hits something.
+        const Ray3d ray(bboxes[0].center() - Vector3d(0.0, 0.0, 20.0), Vector3d(0.0, 0.0, 1.0));
+        const RayInfo3d ray_info(ray);
+
+        ClosestItemVisitor visible_visitor(bboxes, partitioner.get_item_ordering(), ray.m_tmax);
+        bvh::WideIntersector<TestTree, WideNodeVector, ClosestItemVisitor, Ray3d> visible_intersector(2);
+        visible_intersector.intersect_no_motion(
+            tree,
+            wide_nodes,
+            ray,
+            ray_info,
+            visible_visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics()
+#endif
+            );
+
+        ClosestItemVisitor invisible_visitor(bboxes, partitioner.get_item_ordering(), ray.m_tmax);
+        bvh::WideIntersector<TestTree, WideNodeVector, ClosestItemVisitor, Ray3d> invisible_intersector(1);
+        invisible_intersector.intersect_no_motion(
+            tree,
+            wide_nodes,
+            ray,
+            ray_info,
+            invisible_visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics()
+#endif
+            );
+
+        EXPECT_NEQ(~size_t(0), visible_visitor.m_closest_item);
+        EXPECT_EQ(~size_t(0), invisible_visitor.m_closest_item);
+    }
+
+    TEST_CASE(IntersectNoMotion_Width4_FindsSameClosestItemsAsBinaryIntersector)
+    {
+        EXPECT_EQ(0, count_mismatching_rays<4>(1000));
+    }
+
+    TEST_CASE(IntersectNoMotion_Width8_FindsSameClosestItemsAsBinaryIntersector)
+    {
+        EXPECT_EQ(0, count_mismatching_rays<8>(1000));
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_PacketIntersector)
+{
+    typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+    typedef bvh::Builder<TestTree, Partitioner> Builder;
+
+    const size_t PacketSize = 4;
+
+    // Treats items as boxes and finds the closest one along each ray of the packet.
+    struct ClosestItemPacketVisitor
+    {
+        typedef bvh::RayPacket<Ray3d, PacketSize> RayPacketType;
+
+        const AABBVector&           m_bboxes;
+        const std::vector<size_t>&  m_ordering;
+        size_t                      m_closest_item[PacketSize];
+        double                      m_closest_distance[PacketSize];
+
+        ClosestItemPacketVisitor(
+            const AABBVector&           bboxes,
+            const std::vector<size_t>&  ordering,
+            const RayPacketType&        packet)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+        {
+            for (size_t i = 0; i < PacketSize; ++i)
+            {
+                m_closest_item[i] = ~size_t(0);
+                m_closest_distance[i] = packet.m_tmax[i];
+            }
+        }
+
+        void visit(
+            const bvh::Node<AABB3d>&    node,
+            const std::uint32_t         ray_mask,
+            RayPacketType&              packet
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            for (size_t r = 0; r < PacketSize; ++r)
+            {
+                if (!(ray_mask & (1u << r)))
+                    continue;
+
+                for (size_t i = node.get_item_index(), e = i + node.get_item_count(); i < e; ++i)
+                {
+                    const size_t item = m_ordering[i];
+                    double tmin;
+                    if (intersect(*packet.m_rays[r], *packet.m_ray_infos[r], m_bboxes[item], tmin) && tmin < m_closest_distance[r])
+                    {
+                        m_closest_item[r] = item;
+                        m_closest_distance[r] = tmin;
+                    }
+                }
+
+                packet.m_tmax[r] = m_closest_distance[r];
+            }
+        }
+    };
+
+    TEST_CASE(IntersectNoMotion_FindsSameClosestDistancesAsBruteForce)
+    {
+        const AABBVector bboxes = make_random_bboxes(2000);
+
+        Partitioner partitioner(bboxes, 4);
+        TestTree tree;
+        Builder builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 4);
+
+        bvh::PacketIntersector<TestTree, ClosestItemPacketVisitor, Ray3d, PacketSize> intersector;
+
+        Xorshift32 rng;
+        size_t mismatch_count = 0;
+
+        for (size_t i = 0; i < 250; ++i)
+        {
+            // Rays of a packet share their origin, like the probe rays of a shading point.
+            Vector3d org;
+            org[0] = rand_double1(rng, -120.0, 120.0);
+            org[1] = rand_double1(rng, -120.0, 120.0);
+            org[2] = rand_double1(rng, -20.0, 20.0);
+
+            Ray3d rays[PacketSize];
+            RayInfo3d ray_infos[PacketSize];
+            ClosestItemPacketVisitor::RayPacketType packet;
+
+            // Leave the last slot empty.
+            for (size_t r = 0; r < PacketSize - 1; ++r)
+            {
+                Vector3d target;
+                target[0] = rand_double1(rng, -100.0, 100.0);
+                target[1] = rand_double1(rng, -100.0, 100.0);
+                target[2] = rand_double1(rng, -10.0, 10.0);
+
+                rays[r] = Ray3d(org, normalize(target - org));
+                ray_infos[r] = RayInfo3d(rays[r]);
+                packet.set(r, rays[r], ray_infos[r]);
+            }
+
+            ClosestItemPacketVisitor visitor(bboxes, partitioner.get_item_ordering(), packet);
+            intersector.intersect_no_motion(
+                tree,
+                packet,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , bvh::TraversalStatistics()
+#endif
+                );
+
+            for (size_t r = 0; r < PacketSize - 1; ++r)
+            {
+                double closest_distance = rays[r].m_tmax;
+                for (size_t j = 0, e = bboxes.size(); j < e; ++j)
+                {
+                    double tmin;
+                    if (intersect(rays[r], ray_infos[r], bboxes[j], tmin) && tmin < closest_distance)
+                        closest_distance = tmin;
+                }
+
+                if (visitor.m_closest_distance[r] != closest_distance)
+                    ++mismatch_count;
+            }
+
+            EXPECT_EQ(~size_t(0), visitor.m_closest_item[PacketSize - 1]);
+        }
+
+        EXPECT_EQ(0, mismatch_count);
+    }
+
+    TEST_CASE(IntersectNoMotion_InactiveRays_VisitNoLeaf)
+    {
+        const AABBVector bboxes = make_random_bboxes(2000);
+
+        Partitioner partitioner(bboxes, 4);
+        TestTree tree;
+        Builder builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 4);
+
+        // Aim at the first item so that the ray would hit something.
+        const Ray3d ray(bboxes[0].center() - Vector3d(0.0, 0.0, 20.0), Vector3d(0.0, 0.0, 1.0));
+        const RayInfo3d ray_info(ray);
+
+        ClosestItemPacketVisitor::RayPacketType packet;
+        packet.set(0, ray, ray_info);
+        packet.m_active = 0;
+
+        ClosestItemPacketVisitor visitor(bboxes, partitioner.get_item_ordering(), packet);
+        bvh::PacketIntersector<TestTree, ClosestItemPacketVisitor, Ray3d, PacketSize> intersector;
+        intersector.intersect_no_motion(
+            tree,
+            packet,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics()
+#endif
+            );
+
+        EXPECT_EQ(~size_t(0), visitor.m_closest_item[0]);
+    }
+}
@@ -34,9 +34,14 @@
 #include "foundation/utility/cache.h"
 #include "foundation/utility/test.h"
 
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+#include "boost/thread/thread.hpp"
+
 // Standard headers.
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 
 using namespace foundation;
 
@@ -74,6 +79,10 @@ namespace
             return true;
         }
 
+        void acquire(const Key key, Element& element) const
+        {
+        }
+
         bool is_full(const size_t element_count) const
         {
             return false;
@@ -267,3 +276,153 @@ TEST_SUITE(Foundation_Utility_Cache_DualStageCache)
         }
     }
 }
+
+TEST_SUITE(Foundation_Utility_Cache_ConcurrentCache)
+{
+    TEST_CASE(Destructor_UnloadsElementsStillInCache)
+    {
+        ElementSwapperCountingUnloads element_swapper;
+
+        {
+            KeyHasher key_hasher;
+            ConcurrentCache<Key, KeyHasher, Element, ElementSwapperCountingUnloads> cache(key_hasher, element_swapper);
+
+            cache.get(1);
+            cache.get(2);
+            cache.get(3);
+        }
+
+        EXPECT_EQ(3, element_swapper.m_unload_count);
+    }
+
+    struct ElementSwapper
+    {
+        const size_t                m_cache_size;
+        boost::atomic<size_t>       m_element_count;
+        boost::atomic<size_t>       m_acquire_count;
+
+        explicit ElementSwapper(const size_t cache_size)
+          : m_cache_size(cache_size)
+          , m_element_count(0)
+          , m_acquire_count(0)
+        {
+        }
+
+        void load(const Key key, Element& element)
+        {
+            element = static_cast<Element>(key * 10);
+            ++m_element_count;
+        }
+
+        bool unload(const Key key, Element& element)
+        {
+            element = 0;
+            --m_element_count;
+            return true;
+        }
+
+        void acquire(const Key key, Element& element)
+        {
+            ++m_acquire_count;
+        }
+
+        bool is_full(const size_t element_count) const
+        {
+            return element_count > m_cache_size;
+        }
+    };
+
+    struct IntegrityChecker
+    {
+        void operator()(const Key key, const Element element) const
+        {
+            if (element != key * 10)
+                throw Exception("cache integrity check failed");
+        }
+    };
+
+    TEST_CASE(Get_SingleStripe_HonorsCacheSize)
+    {
+        const size_t CacheSize = 8;
+
+        KeyHasher key_hasher;
+        ElementSwapper element_swapper(CacheSize);
+        ConcurrentCache<Key, KeyHasher, Element, ElementSwapper, 1> cache(key_hasher, element_swapper);
+
+        IntegrityChecker checker;
+        LCG rng;
+
+        bool size_honored = true;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            const Key key = rand_int1(rng, 1, 100);
+
+            EXPECT_EQ(key * 10, cache.get(key));
+
+            if (element_swapper.m_element_count > CacheSize)
+                size_honored = false;
+
+            cache.check_integrity(checker);
+        }
+
+        EXPECT_TRUE(size_honored);
+        EXPECT_EQ(1000, cache.get_hit_count() + cache.get_miss_count());
+        EXPECT_EQ(1000, element_swapper.m_acquire_count);
+    }
+
+    TEST_CASE(Get_KeepsRecentlyUsedElements)
+    {
+        KeyHasher key_hasher;
+        ElementSwapper element_swapper(2);
+        ConcurrentCache<Key, KeyHasher, Element, ElementSwapper, 1> cache(key_hasher, element_swapper);
+
+        cache.get(1);
+        cache.get(2);
+        cache.get(3);   // evicts 1
+        cache.get(2);   // hit, sets the reference bit of 2
+        cache.get(4);   // clears the reference bit of 2, evicts 3
+
+        cache.clear_statistics();
+        cache.get(2);
+
+        EXPECT_EQ(1, cache.get_hit_count());
+        EXPECT_EQ(2, element_swapper.m_element_count);
+    }
+
+    TEST_CASE(Get_MultipleThreads_KeepsCacheConsistent)
+    {
+        const size_t CacheSize = 64;
+        const size_t ThreadCount = 4;
+
+        KeyHasher key_hasher;
+        ElementSwapper element_swapper(CacheSize);
+        ConcurrentCache<Key, KeyHasher, Element, ElementSwapper> cache(key_hasher, element_swapper);
+
+        boost::thread_group threads;
+
+        for (size_t i = 0; i < ThreadCount; ++i)
+        {
+            threads.create_thread(
+                [&cache, i]()
+                {
+                    LCG rng(static_cast<std::uint32_t>(i));
+
+                    for (size_t j = 0; j < 10000; ++j)
+                        cache.get(rand_int1(rng, 1, 256));
+                });
+        }
+
+        threads.join_all();
+
+        IntegrityChecker checker;
+        cache.check_integrity(checker);
+
+        EXPECT_EQ(ThreadCount * 10000, cache.get_hit_count() + cache.get_miss_count());
+        EXPECT_EQ(ThreadCount * 10000, element_swapper.m_acquire_count);
+
+        // A stripe holding only the element being inserted cannot evict anything,
+        // so the cache may exceed its budget by one element per stripe.
+        EXPECT_TRUE(element_swapper.m_element_count <= CacheSize + cache.Stripes);
+    }
+}
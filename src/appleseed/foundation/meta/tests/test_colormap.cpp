@@ -0,0 +1,140 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/image/colormap.h"
+#include "foundation/image/colorspace.h"
+#include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cstddef>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Image_ColorMap)
+{
+    static const float Palette[] =
+    {
+        0.0f, 0.0f, 0.0f,
+        1.0f, 0.5f, 0.25f,
+        1.0f, 1.0f, 1.0f
+    };
+
+    Color4f make_color(const size_t x, const size_t y)
+    {
+        return
+            Color4f(
+                static_cast<float>((x * 7 + y * 3) % 11) / 10.0f,
+                static_cast<float>((x * 5 + y * 2) % 13) / 12.0f,
+                static_cast<float>((x * 3 + y * 5) % 7) / 6.0f,
+                0.5f);
+    }
+
+    // Width and height aren't multiples of 4 to exercise the remainder of each row.
+    void fill_image(Image& image)
+    {
+        const CanvasProperties& props = image.properties();
+
+        for (size_t y = 0; y < props.m_canvas_height; ++y)
+        {
+            for (size_t x = 0; x < props.m_canvas_width; ++x)
+                image.set_pixel(x, y, make_color(x, y));
+        }
+    }
+
+    TEST_CASE(FindMinMaxRelativeLuminance_GivenCropWindow_MatchesPerPixelLuminance)
+    {
+        Image image(37, 29, 8, 8, 4, PixelFormatFloat);
+        fill_image(image);
+
+        const AABB2u crop_window(Vector2u(3, 2), Vector2u(30, 27));
+
+        float min_luminance, max_luminance;
+        ColorMap::find_min_max_relative_luminance(image, crop_window, min_luminance, max_luminance);
+
+        float expected_min = +1.0e30f, expected_max = -1.0e30f;
+        for (size_t y = crop_window.min.y; y <= crop_window.max.y; ++y)
+        {
+            for (size_t x = crop_window.min.x; x <= crop_window.max.x; ++x)
+            {
+                const float lum = luminance(make_color(x, y).rgb());
+                expected_min = std::min(expected_min, lum);
+                expected_max = std::max(expected_max, lum);
+            }
+        }
+
+        EXPECT_FEQ(expected_min, min_luminance);
+        EXPECT_FEQ(expected_max, max_luminance);
+    }
+
+    TEST_CASE(RemapRelativeLuminance_GivenTile_RemapsPixelsInsideRectOnly)
+    {
+        Tile tile(13, 5, 4, PixelFormatFloat);
+
+        for (size_t y = 0; y < 5; ++y)
+        {
+            for (size_t x = 0; x < 13; ++x)
+                tile.set_pixel(x, y, make_color(x, y));
+        }
+
+        ColorMap color_map;
+        color_map.set_palette_from_array(Palette, 3);
+
+        const AABB2u rect(Vector2u(1, 1), Vector2u(11, 3));
+        color_map.remap_relative_luminance(tile, rect, 0.1f, 0.9f);
+
+        for (size_t y = 0; y < 5; ++y)
+        {
+            for (size_t x = 0; x < 13; ++x)
+            {
+                const Color4f original = make_color(x, y);
+
+                Color4f expected = original;
+                if (rect.contains(Vector2u(x, y)))
+                {
+                    const float v = saturate((luminance(original.rgb()) - 0.1f) / (0.9f - 0.1f));
+                    expected = Color4f(color_map.evaluate_palette(v), original.a);
+                }
+
+                Color4f result;
+                tile.get_pixel(x, y, result);
+
+                EXPECT_FEQ_EPS(expected, result, 1.0e-5f);
+            }
+        }
+    }
+}
@@ -38,6 +38,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <vector>
 
@@ -465,6 +466,17 @@ TEST_SUITE(Foundation_Image_ColorSpace)
             1.0e-5f);
     }
 
+    TEST_CASE(Test8BitsRGBToLinearRGBConversion)
+    {
+        for (size_t i = 0; i < 256; ++i)
+        {
+            EXPECT_FEQ_EPS(
+                srgb_to_linear_rgb(i / 255.0f),
+                srgb8_to_linear_rgb(static_cast<std::uint8_t>(i)),
+                1.0e-6f);
+        }
+    }
+
     static RegularSpectrum31f get_white_spectrum()
     {
         // The white color from the Cornell Box scene.
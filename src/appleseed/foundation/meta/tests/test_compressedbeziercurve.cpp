@@ -0,0 +1,146 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/beziercurve.h"
+#include "foundation/math/compressedbeziercurve.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/xoroshiro128plus.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Math_PointQuantizer)
+{
+    TEST_CASE(RoundTrip)
+    {
+        const AABB3f bbox(Vector3f(-1.0f, 2.0f, 0.0f), Vector3f(3.0f, 2.5f, 10.0f));
+        const PointQuantizer quantizer(bbox);
+        const float MaxError = max_value(bbox.extent()) / 65535.0f;
+
+        Xoroshiro128plus rng;
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            const Vector3f p(
+                rand_float1(rng, -1.0f, 3.0f),
+                rand_float1(rng, 2.0f, 2.5f),
+                rand_float1(rng, 0.0f, 10.0f));
+
+            std::uint16_t q[3];
+            quantizer.encode(p, q);
+
+            EXPECT_FEQ_EPS(p, quantizer.decode(q), MaxError);
+        }
+    }
+
+    TEST_CASE(RoundTrip_GivenFlatBoundingBox_ReturnsExactPoints)
+    {
+        const AABB3f bbox(Vector3f(1.0f, 2.0f, 3.0f), Vector3f(1.0f, 4.0f, 3.0f));
+        const PointQuantizer quantizer(bbox);
+
+        std::uint16_t q[3];
+        quantizer.encode(Vector3f(1.0f, 4.0f, 3.0f), q);
+
+        EXPECT_EQ(Vector3f(1.0f, 4.0f, 3.0f), quantizer.decode(q));
+    }
+}
+
+TEST_SUITE(Foundation_Math_CompressedBezierCurveArray)
+{
+    BezierCurve3f make_random_curve(Xoroshiro128plus& rng)
+    {
+        Vector3f ctrl_pts[4];
+        float widths[4];
+        float opacities[4];
+        Color3f colors[4];
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            ctrl_pts[i] = Vector3f(rand_float1(rng), rand_float1(rng), rand_float1(rng));
+            widths[i] = 0.01f;
+            opacities[i] = 0.5f;
+            colors[i] = Color3f(rand_float1(rng), 0.25f, 1.0f);
+        }
+
+        return BezierCurve3f(ctrl_pts, widths, opacities, colors);
+    }
+
+    TEST_CASE(Get_ReturnsCurvesCloseToOriginalCurves)
+    {
+        // Enough curves to fill a few groups and leave some uncompressed.
+        const size_t CurveCount = 3 * CompressedBezierCurveArray<BezierCurve3f>::GroupSize + 5;
+
+        Xoroshiro128plus rng;
+        std::vector<BezierCurve3f> curves;
+        CompressedBezierCurveArray<BezierCurve3f> compressed_curves;
+
+        for (size_t i = 0; i < CurveCount; ++i)
+        {
+            curves.push_back(make_random_curve(rng));
+            compressed_curves.push_back(curves.back());
+        }
+
+        ASSERT_EQ(CurveCount, compressed_curves.size());
+
+        for (size_t i = 0; i < CurveCount; ++i)
+        {
+            const BezierCurve3f curve = compressed_curves.get(i);
+
+            for (size_t j = 0; j < 4; ++j)
+            {
+                EXPECT_FEQ_EPS(curves[i].get_control_point(j), curve.get_control_point(j), 1.0e-4f);
+                EXPECT_FEQ_EPS(curves[i].get_width(j), curve.get_width(j), 1.0e-4f);
+                EXPECT_FEQ_EPS(curves[i].get_opacity(j), curve.get_opacity(j), 1.0e-3f);
+                EXPECT_FEQ_EPS(curves[i].get_color(j), curve.get_color(j), 1.0e-3f);
+            }
+        }
+    }
+
+    TEST_CASE(Clear_RemovesAllCurves)
+    {
+        Xoroshiro128plus rng;
+        CompressedBezierCurveArray<BezierCurve3f> compressed_curves;
+
+        for (size_t i = 0; i < 20; ++i)
+            compressed_curves.push_back(make_random_curve(rng));
+
+        compressed_curves.clear();
+
+        EXPECT_TRUE(compressed_curves.empty());
+    }
+}
@@ -148,6 +148,59 @@ TEST_SUITE(Foundation_Utility_StringDictionary)
 
         EXPECT_EQ(&sd, result);
     }
+
+    TEST_CASE(Insert_GivenKeyOfRemovedItem_InsertsValue)
+    {
+        StringDictionary sd;
+        sd.insert("key", "value1");
+        sd.remove("key");
+
+        sd.insert("key", "value2");
+
+        EXPECT_EQ("value2", std::string(sd.get("key")));
+    }
+
+    TEST_CASE(Get_GivenCopiedDictionary_ReturnsValuesOfCopy)
+    {
+        StringDictionary sd1;
+        sd1.insert("key1", "value1");
+        sd1.insert("key2", "value2");
+
+        StringDictionary sd2(sd1);
+        sd1.set("key1", "other");
+        sd1.remove("key2");
+
+        EXPECT_EQ("value1", std::string(sd2.get("key1")));
+        EXPECT_EQ("value2", std::string(sd2.get("key2")));
+    }
+
+    TEST_CASE(Get_GivenAssignedDictionary_ReturnsValuesOfCopy)
+    {
+        StringDictionary sd1;
+        sd1.insert("key", "value");
+
+        StringDictionary sd2;
+        sd2.insert("other", "value");
+        sd2 = sd1;
+        sd1.clear();
+
+        EXPECT_FALSE(sd2.exist("other"));
+        EXPECT_EQ("value", std::string(sd2.get("key")));
+    }
+
+    TEST_CASE(Begin_GivenItemsInsertedOutOfOrder_IteratesInKeyOrder)
+    {
+        StringDictionary sd;
+        sd.insert("c", "3");
+        sd.insert("a", "1");
+        sd.insert("b", "2");
+
+        std::string keys;
+        for (StringDictionary::const_iterator i = sd.begin(); i != sd.end(); ++i)
+            keys += i.key();
+
+        EXPECT_EQ("abc", keys);
+    }
 }
 
 TEST_SUITE(Foundation_Utility_DictionaryDictionary)
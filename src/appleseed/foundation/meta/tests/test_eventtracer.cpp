@@ -0,0 +1,133 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/utility/eventtracer.h"
+#include "foundation/utility/test.h"
+
+// Boost headers.
+#include "boost/thread/thread.hpp"
+
+// Standard headers.
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Utility_EventTracer)
+{
+    TEST_CASE(IsEnabled_GivenNewTracer_ReturnsFalse)
+    {
+        EventTracer tracer;
+
+        EXPECT_FALSE(tracer.is_enabled());
+    }
+
+    TEST_CASE(GetEventCount_GivenNoRecordedEvent_ReturnsZero)
+    {
+        EventTracer tracer;
+
+        EXPECT_EQ(0, tracer.get_event_count());
+    }
+
+    TEST_CASE(GetEventCount_GivenRecordedEvents_ReturnsNumberOfEvents)
+    {
+        EventTracer tracer;
+        tracer.record("category", "event", 0, 1);
+        tracer.record("category", "event", 1, 2);
+
+        EXPECT_EQ(2, tracer.get_event_count());
+    }
+
+    TEST_CASE(GetEventCount_GivenMoreEventsThanCapacity_ReturnsCapacity)
+    {
+        EventTracer tracer;
+        tracer.set_events_per_thread(4);
+
+        for (std::uint64_t i = 0; i < 10; ++i)
+            tracer.record("category", "event", i, i + 1);
+
+        EXPECT_EQ(4, tracer.get_event_count());
+    }
+
+    TEST_CASE(GetEventCount_GivenEventsRecordedFromTwoThreads_ReturnsTotalNumberOfEvents)
+    {
+        EventTracer tracer;
+        tracer.record("category", "event", 0, 1);
+
+        boost::thread thread([&tracer]() { tracer.record("category", "event", 0, 1); });
+        thread.join();
+
+        EXPECT_EQ(2, tracer.get_event_count());
+    }
+
+    TEST_CASE(Clear_RemovesAllEvents)
+    {
+        EventTracer tracer;
+        tracer.record("category", "event", 0, 1);
+
+        tracer.clear();
+
+        EXPECT_EQ(0, tracer.get_event_count());
+    }
+
+    TEST_CASE(WriteChromeTrace_WritesEventsAndThreadNames)
+    {
+        const char* Filepath = "unit tests/outputs/test_eventtracer.json";
+
+        EventTracer tracer;
+        tracer.set_current_thread_name("main");
+        tracer.record("category", "first \"event\"", 10, 25);
+
+        const bool success = tracer.write_chrome_trace(Filepath);
+        ASSERT_TRUE(success);
+
+        std::ifstream file(Filepath);
+        const std::string contents(
+            (std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>());
+
+        EXPECT_NEQ(std::string::npos, contents.find("\"traceEvents\""));
+        EXPECT_NEQ(std::string::npos, contents.find("\"args\":{\"name\":\"main\"}"));
+        EXPECT_NEQ(std::string::npos, contents.find("\"name\":\"first \\\"event\\\"\",\"cat\":\"category\""));
+        EXPECT_NEQ(std::string::npos, contents.find("\"ts\":10,\"dur\":15"));
+    }
+
+    TEST_CASE(ScopedTraceEvent_GivenDisabledGlobalTracer_RecordsNothing)
+    {
+        EventTracer& tracer = global_event_tracer();
+        const size_t initial_count = tracer.get_event_count();
+
+        {
+            APPLESEED_TRACE_SCOPE("category", "event");
+        }
+
+        EXPECT_EQ(initial_count, tracer.get_event_count());
+    }
+}
@@ -40,6 +40,7 @@
 #include "foundation/utility/test.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <string>
@@ -740,4 +741,146 @@ TEST_SUITE(Foundation_Math_FastMath)
             1.0f,
             1000);
     }
+
+    //
+    // atan2(y, x)
+    //
+
+    TEST_CASE(ScalarFastAtan2)
+    {
+        float max_error = 0.0f;
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            for (size_t j = 0; j < 100; ++j)
+            {
+                const float y = fit<size_t, float>(i, 0, 99, -10.0f, 10.0f);
+                const float x = fit<size_t, float>(j, 0, 99, -10.0f, 10.0f);
+                const float error = std::abs(std::atan2(y, x) - fast_atan2(y, x));
+                max_error = std::max(max_error, error);
+            }
+        }
+
+        EXPECT_LT(1.5e-5f, max_error);
+    }
+
+    TEST_CASE(ScalarFastAtan2_GivenOrigin_ReturnsZero)
+    {
+        EXPECT_EQ(0.0f, fast_atan2(0.0f, 0.0f));
+    }
+
+    //
+    // erf(x)
+    //
+
+    float scalar_std_erf(const float x)
+    {
+        return std::erf(x);
+    }
+
+    TEST_CASE(ScalarFastErf)
+    {
+        float max_error = 0.0f;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            const float x = fit<size_t, float>(i, 0, 999, -4.0f, 4.0f);
+            max_error = std::max(max_error, std::abs(std::erf(x) - fast_erf(x)));
+        }
+
+        EXPECT_LT(4.0e-5f, max_error);
+    }
+
+    TEST_CASE(PlotErfFunctions)
+    {
+        const FuncDef<float (*)(float)> functions[] =
+        {
+            { "std::erf", "black", scalar_std_erf },
+            { "foundation::fast_erf", "green", fast_erf }
+        };
+
+        plot_functions(
+            "unit tests/outputs/test_fastmath_erf.gnuplot",
+            functions,
+            countof(functions),
+            -3.0f,
+            +3.0f,
+            1000);
+    }
+
+    //
+    // Batched functions.
+    //
+
+    // Absolute difference for small values, relative difference for large ones.
+    float compute_deviation(const float ref, const float value)
+    {
+        return std::abs(ref - value) / std::max(1.0f, std::abs(ref));
+    }
+
+    template <size_t Width>
+    float compute_max_batch_deviation()
+    {
+        APPLESEED_SIMD8_ALIGN float x[Width];
+        APPLESEED_SIMD8_ALIGN float y[Width];
+        APPLESEED_SIMD8_ALIGN float values[Width];
+        float max_deviation = 0.0f;
+
+        for (size_t i = 0; i < 1000; i += Width)
+        {
+            for (size_t j = 0; j < Width; ++j)
+            {
+                y[j] = fit<size_t, float>(i + j, 0, 999, -20.0f, 20.0f);
+                x[j] = fit<size_t, float>(i + j, 0, 999, 0.01f, 10.0f);
+            }
+
+            #define CHECK_UNARY(batch, scalar, input)                                           \
+                for (size_t j = 0; j < Width; ++j)                                              \
+                    values[j] = input[j];                                                       \
+                BatchFastMath<Width>::batch(values);                                            \
+                for (size_t j = 0; j < Width; ++j)                                              \
+                    max_deviation = std::max(max_deviation, compute_deviation(scalar(input[j]), values[j]))
+
+            CHECK_UNARY(pow2, fast_pow2, y);
+            CHECK_UNARY(log2, fast_log2, x);
+            CHECK_UNARY(log, fast_log, x);
+            CHECK_UNARY(exp, fast_exp, y);
+            CHECK_UNARY(sin, fast_sin_full, y);
+            CHECK_UNARY(cos, fast_cos_full, y);
+            CHECK_UNARY(erf, fast_erf, y);
+
+            #undef CHECK_UNARY
+
+            for (size_t j = 0; j < Width; ++j)
+                values[j] = x[j];
+            BatchFastMath<Width>::pow(values, 2.4f);
+            for (size_t j = 0; j < Width; ++j)
+                max_deviation = std::max(max_deviation, compute_deviation(fast_pow(x[j], 2.4f), values[j]));
+
+            for (size_t j = 0; j < Width; ++j)
+                values[j] = y[j];
+            BatchFastMath<Width>::atan2(values, x);
+            for (size_t j = 0; j < Width; ++j)
+                max_deviation = std::max(max_deviation, compute_deviation(fast_atan2(y[j], x[j]), values[j]));
+        }
+
+        return max_deviation;
+    }
+
+    // Batched functions must match the scalar ones up to floating point rounding.
+
+    TEST_CASE(BatchFastMath_Width1_MatchesScalarFunctions)
+    {
+        EXPECT_EQ(0.0f, compute_max_batch_deviation<1>());
+    }
+
+    TEST_CASE(BatchFastMath_Width4_MatchesScalarFunctions)
+    {
+        EXPECT_LT(1.0e-5f, compute_max_batch_deviation<4>());
+    }
+
+    TEST_CASE(BatchFastMath_Width8_MatchesScalarFunctions)
+    {
+        EXPECT_LT(1.0e-5f, compute_max_batch_deviation<8>());
+    }
 }
@@ -118,6 +118,50 @@ TEST_SUITE(Foundation_Image_GenericImageFileWriter)
         }
     }
 
+    TEST_CASE(Write_LargeImage_ReadBackImageHasCorrectPixels)
+    {
+        const char* ImageFilePath = "unit tests/outputs/test_genericimagefilewriter_large.exr";
+
+        // Large enough to be decoded by multiple threads.
+        const size_t Width = 2048;
+        const size_t Height = 1024;
+
+        {
+            Image image(Width, Height, 64, 64, 3, PixelFormatFloat);
+
+            for (size_t y = 0; y < Height; ++y)
+            {
+                for (size_t x = 0; x < Width; ++x)
+                    image.set_pixel(x, y, Color3f(static_cast<float>(x), static_cast<float>(y), 1.0f));
+            }
+
+            GenericImageFileWriter writer(ImageFilePath);
+            writer.append_image(&image);
+            writer.write();
+        }
+
+        {
+            GenericImageFileReader reader;
+            std::unique_ptr<Image> image(reader.read(ImageFilePath));
+
+            size_t mismatch_count = 0;
+
+            for (size_t y = 0; y < Height; ++y)
+            {
+                for (size_t x = 0; x < Width; ++x)
+                {
+                    Color3f c;
+                    image->get_pixel(x, y, c);
+
+                    if (c != Color3f(static_cast<float>(x), static_cast<float>(y), 1.0f))
+                        ++mismatch_count;
+                }
+            }
+
+            EXPECT_EQ(0, mismatch_count);
+        }
+    }
+
     void draw_radial_gradient_prone_to_banding(Image& image)
     {
         const CanvasProperties& props = image.properties();
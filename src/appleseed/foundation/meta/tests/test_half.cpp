@@ -39,6 +39,7 @@
 // Standard headers.
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 
 using namespace foundation;
 
@@ -138,4 +139,47 @@ TEST_SUITE(Foundation_Math_Half)
             else EXPECT_EQ(imath_float, as_float);
         }
     }
+
+    TEST_CASE(BatchedHalfToFloat_MatchesScalar)
+    {
+        std::vector<Half> input(0x10000);
+        for (size_t i = 0; i < input.size(); ++i)
+            input[i] = Half::from_bits(static_cast<std::uint16_t>(i));
+
+        std::vector<float> output(input.size());
+        half_to_float(&input[0], &output[0], input.size());
+
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            const float expected = half_to_float(input[i]);
+
+            if (FP<float>::is_nan(expected))
+                EXPECT_TRUE(FP<float>::is_nan(output[i]));
+            else EXPECT_EQ(expected, output[i]);
+        }
+    }
+
+    TEST_CASE(BatchedFloatToHalf_MatchesScalar)
+    {
+        // Use an odd count to exercise the scalar tail.
+        std::vector<float> input(0x10000 - 3);
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            const Half h = Half::from_bits(static_cast<std::uint16_t>(i));
+            input[i] = half_to_float(h) * 1.0001f;
+        }
+
+        std::vector<Half> output(input.size());
+        float_to_half(&input[0], &output[0], input.size());
+
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            const float expected = half_to_float(float_to_half(input[i]));
+            const float actual = half_to_float(output[i]);
+
+            if (FP<float>::is_nan(expected))
+                EXPECT_TRUE(FP<float>::is_nan(actual));
+            else EXPECT_EQ(expected, actual);
+        }
+    }
 }
@@ -0,0 +1,131 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/utility/hardwarecounters.h"
+#include "foundation/utility/statistics.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstdint>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Utility_HardwareCounters)
+{
+    std::uint64_t get_call_count(const HardwareCounters& counters, const char* phase)
+    {
+        const StatisticsVector vec = counters.get_statistics();
+        const Statistics* stats = vec.get(std::string(phase) + " hardware counters");
+
+        if (stats == nullptr)
+            return 0;
+
+        const Statistics::UnsignedIntegerEntry* calls =
+            dynamic_cast<const Statistics::UnsignedIntegerEntry*>(stats->get("calls"));
+
+        return calls != nullptr ? calls->m_value : 0;
+    }
+
+    TEST_CASE(IsEnabled_GivenNewSampler_ReturnsFalse)
+    {
+        HardwareCounters counters;
+
+        EXPECT_FALSE(counters.is_enabled());
+    }
+
+    TEST_CASE(GetStatistics_GivenNoPhase_ReturnsNoPhaseStatistics)
+    {
+        HardwareCounters counters;
+
+        const StatisticsVector vec = counters.get_statistics();
+
+        EXPECT_EQ(nullptr, vec.get("shading hardware counters"));
+    }
+
+    TEST_CASE(GetStatistics_GivenPhasesEnteredSeveralTimes_ReturnsNumberOfCallsPerPhase)
+    {
+        HardwareCounters counters;
+        counters.enter_phase("shading");
+        counters.leave_phase();
+        counters.enter_phase("shading");
+        counters.leave_phase();
+        counters.enter_phase("tree traversal");
+        counters.leave_phase();
+
+        EXPECT_EQ(2, get_call_count(counters, "shading"));
+        EXPECT_EQ(1, get_call_count(counters, "tree traversal"));
+    }
+
+    TEST_CASE(GetStatistics_GivenNestedPhases_ReturnsNumberOfCallsPerPhase)
+    {
+        HardwareCounters counters;
+        counters.enter_phase("shading");
+        counters.enter_phase("texture filtering");
+        counters.leave_phase();
+        counters.enter_phase("texture filtering");
+        counters.leave_phase();
+        counters.leave_phase();
+
+        EXPECT_EQ(1, get_call_count(counters, "shading"));
+        EXPECT_EQ(2, get_call_count(counters, "texture filtering"));
+    }
+
+    TEST_CASE(LeavePhase_GivenNoActivePhase_DoesNothing)
+    {
+        HardwareCounters counters;
+        counters.leave_phase();
+        counters.enter_phase("shading");
+        counters.leave_phase();
+
+        EXPECT_EQ(1, get_call_count(counters, "shading"));
+    }
+
+    TEST_CASE(Clear_ResetsNumberOfCalls)
+    {
+        HardwareCounters counters;
+        counters.enter_phase("shading");
+        counters.leave_phase();
+
+        counters.clear();
+
+        EXPECT_EQ(0, get_call_count(counters, "shading"));
+    }
+
+    TEST_CASE(ScopedHardwareCountersPhase_GivenDisabledGlobalSampler_RecordsNothing)
+    {
+        HardwareCounters& counters = global_hardware_counters();
+        const std::uint64_t initial_count = get_call_count(counters, "unit test phase");
+
+        {
+            APPLESEED_HARDWARE_COUNTERS_SCOPE("unit test phase");
+        }
+
+        EXPECT_EQ(initial_count, get_call_count(counters, "unit test phase"));
+    }
+}
@@ -500,4 +500,25 @@ TEST_SUITE(Foundation_Hash_Hash)
                 return combine_hashes(h1, h2);
             });
     }
+
+    TEST_CASE(HashString_GivenEmptyString_ReturnsFNVOffsetBasis)
+    {
+        EXPECT_EQ(0xCBF29CE484222325ull, hash_string(""));
+    }
+
+    TEST_CASE(HashString_GivenKnownString_ReturnsReferenceFNV1aHash)
+    {
+        EXPECT_EQ(0xAF63DC4C8601EC8Cull, hash_string("a"));
+        EXPECT_EQ(0x85944171F73967E8ull, hash_string("foobar"));
+    }
+
+    TEST_CASE(CStringEqual_ComparesCharactersRatherThanPointers)
+    {
+        const char a[] = "object_inst";
+        const char b[] = "object_inst";
+
+        EXPECT_TRUE(CStringEqual()(a, b));
+        EXPECT_EQ(CStringHash()(a), CStringHash()(b));
+        EXPECT_FALSE(CStringEqual()(a, "object"));
+    }
 }
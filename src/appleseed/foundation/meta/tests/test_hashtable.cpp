@@ -91,3 +91,94 @@ TEST_SUITE(Foundation_Containers_HashTable)
         }
     }
 }
+
+TEST_SUITE(Foundation_Containers_FlatHashTable)
+{
+    struct KeyHasher
+    {
+        size_t operator()(const size_t key) const
+        {
+            return
+                static_cast<size_t>(
+                    hash_uint64(
+                        static_cast<std::uint64_t>(key)));
+        }
+    };
+
+    struct BadKeyHasher
+    {
+        size_t operator()(const size_t) const
+        {
+            return 0;
+        }
+    };
+
+    TEST_CASE(Get_TableIsEmpty_ReturnsNullptr)
+    {
+        KeyHasher key_hasher;
+        FlatHashTable<size_t, KeyHasher, float> hash_table(key_hasher);
+
+        const float* val_ptr = hash_table.get(12);
+
+        EXPECT_EQ(0, val_ptr);
+    }
+
+    TEST_CASE(Get_KeyNotInTable_ReturnsNullptr)
+    {
+        KeyHasher key_hasher;
+        FlatHashTable<size_t, KeyHasher, float> hash_table(key_hasher);
+
+        hash_table.resize(100);
+
+        for (size_t i = 0; i < 100; ++i)
+            hash_table.insert(i, static_cast<float>(i));
+
+        const float* val_ptr = hash_table.get(100);
+
+        EXPECT_EQ(0, val_ptr);
+    }
+
+    TEST_CASE(Get_AllKeysCollide_ReturnsCorrectValues)
+    {
+        const size_t N = 100;
+
+        BadKeyHasher key_hasher;
+        FlatHashTable<size_t, BadKeyHasher, float> hash_table(key_hasher);
+
+        hash_table.resize(N);
+
+        for (size_t i = 0; i < N; ++i)
+            hash_table.insert(i, static_cast<float>(2 * i));
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            const float* val_ptr = hash_table.get(i);
+
+            ASSERT_NEQ(0, val_ptr);
+            EXPECT_EQ(static_cast<float>(2 * i), *val_ptr);
+        }
+
+        EXPECT_EQ(0, hash_table.get(N));
+    }
+
+    TEST_CASE(StressTest)
+    {
+        const size_t N = 16 * 1024;
+
+        KeyHasher key_hasher;
+        FlatHashTable<size_t, KeyHasher, float> hash_table(key_hasher);
+
+        hash_table.resize(N);
+
+        for (size_t i = 0; i < N; ++i)
+            hash_table.insert(i, static_cast<float>(2 * i));
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            const float* val_ptr = hash_table.get(i);
+
+            ASSERT_NEQ(0, val_ptr);
+            EXPECT_EQ(static_cast<float>(2 * i), *val_ptr);
+        }
+    }
+}
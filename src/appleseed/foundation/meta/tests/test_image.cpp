@@ -33,6 +33,8 @@
 #include "foundation/image/image.h"
 #include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
 #include "foundation/utility/iostreamop.h"
 #include "foundation/utility/test.h"
 
@@ -96,4 +98,46 @@ TEST_SUITE(Foundation_Image_Image)
             }
         }
     }
+
+    TEST_CASE(Clear_GivenRectangle_OnlyClearsOverlappingTiles)
+    {
+        Image image(4, 4, 2, 2, 3, PixelFormatFloat);
+        image.clear(Color3f(42.0f), AABB2u(Vector2u(1, 1), Vector2u(1, 2)));
+
+        Color3f c00; image.get_pixel(0, 0, c00);
+        Color3f c03; image.get_pixel(0, 3, c03);
+        Color3f c30; image.get_pixel(3, 0, c30);
+
+        EXPECT_EQ(Color3f(42.0f), c00);
+        EXPECT_EQ(Color3f(42.0f), c03);
+        EXPECT_EQ(Color3f(0.0f), c30);
+    }
+
+    TEST_CASE(WindowConstructor_CopiesPixelsOfWindow)
+    {
+        Image source(4, 4, 2, 2, 3, PixelFormatFloat);
+
+        for (size_t y = 0; y < 4; ++y)
+        {
+            for (size_t x = 0; x < 4; ++x)
+                source.set_pixel(x, y, Color3f(static_cast<float>(y * 4 + x)));
+        }
+
+        const Image window(source, AABB2u(Vector2u(1, 2), Vector2u(3, 3)), 2, 2, PixelFormatHalf);
+
+        const CanvasProperties& props = window.properties();
+        ASSERT_EQ(3, props.m_canvas_width);
+        ASSERT_EQ(2, props.m_canvas_height);
+        EXPECT_EQ(PixelFormatHalf, props.m_pixel_format);
+
+        for (size_t y = 0; y < 2; ++y)
+        {
+            for (size_t x = 0; x < 3; ++x)
+            {
+                Color3f c;
+                window.get_pixel(x, y, c);
+                EXPECT_EQ(Color3f(static_cast<float>((y + 2) * 4 + x + 1)), c);
+            }
+        }
+    }
 }
@@ -43,6 +43,7 @@
 #include <cassert>
 #include <cstddef>
 #include <memory>
+#include <vector>
 
 using namespace foundation;
 
@@ -67,6 +68,51 @@ TEST_SUITE(Foundation_Math_Sampling_ImageImportanceSampler)
         const size_t m_width;
     };
 
+    TEST_CASE(Rebuild_GivenMultipleSamplers_MatchesSingleThreadedRebuild)
+    {
+        const size_t Width = 7;
+        const size_t Height = 13;
+
+        HorizontalGradientSampler sampler(Width);
+
+        ImageImportanceSampler<HorizontalGradientSampler::Payload, float> serial_sampler(Width, Height);
+        serial_sampler.rebuild(sampler);
+
+        std::vector<HorizontalGradientSampler*> samplers(3, &sampler);
+        ImageImportanceSampler<HorizontalGradientSampler::Payload, float> parallel_sampler(Width, Height);
+        parallel_sampler.parallel_rebuild(samplers);
+
+        for (size_t y = 0; y < Height; ++y)
+        {
+            for (size_t x = 0; x < Width; ++x)
+                EXPECT_EQ(serial_sampler.get_pdf(x, y), parallel_sampler.get_pdf(x, y));
+        }
+    }
+
+    TEST_CASE(Sample_ReturnsResidualWithinUnitSquare)
+    {
+        const size_t Width = 5;
+        const size_t Height = 5;
+
+        ImageImportanceSampler<HorizontalGradientSampler::Payload, float> importance_sampler(Width, Height);
+        HorizontalGradientSampler sampler(Width);
+        importance_sampler.rebuild(sampler);
+
+        for (size_t i = 0; i < 64; ++i)
+        {
+            const Vector2f s((i % 8 + 0.5f) / 8.0f, (i / 8 + 0.5f) / 8.0f);
+
+            size_t x, y;
+            HorizontalGradientSampler::Payload payload;
+            float prob_xy;
+            Vector2f residual;
+            importance_sampler.sample(s, x, y, payload, prob_xy, residual);
+
+            EXPECT_TRUE(residual[0] >= 0.0f && residual[0] < 1.0f);
+            EXPECT_TRUE(residual[1] >= 0.0f && residual[1] < 1.0f);
+        }
+    }
+
     TEST_CASE(GetPDF_ReturnsSameProbabilityAsSample)
     {
         const size_t Width = 5;
@@ -0,0 +1,105 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/math/fp.h"
+#include "foundation/math/intersection/raydisk.h"
+#include "foundation/math/ray.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Math_Intersection_RayDisk)
+{
+    // Disks of radius 1 facing the X axis, except for the last one which lies in the X-Z plane.
+    const float DisksX[4] = { 10.0f, 4.0f, 7.0f, 2.0f };
+    const float DisksY[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const float DisksZ[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const float DisksNormalX[4] = { 1.0f, -1.0f, 1.0f, 0.0f };
+    const float DisksNormalY[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    const float DisksNormalZ[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const float DisksRadius[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    TEST_CASE(IntersectDisksX8_RayHitsSeveralDisks_ReturnsClosestDisk)
+    {
+        const Ray3f ray(Vector3f(0.0f, 0.5f, 0.0f), Vector3f(1.0f, 0.0f, 0.0f), 0.0f, 100.0f);
+
+        float tmin = FP<float>::snan();
+        const size_t index =
+            intersect_disks_x8(
+                ray,
+                DisksX, DisksY, DisksZ,
+                DisksNormalX, DisksNormalY, DisksNormalZ,
+                DisksRadius,
+                4,
+                tmin);
+
+        ASSERT_EQ(1, index);
+        EXPECT_FEQ(4.0f, tmin);
+    }
+
+    TEST_CASE(IntersectDisksX8_RayPassesOutsideOfDisks_ReturnsNoHit)
+    {
+        const Ray3f ray(Vector3f(0.0f, 1.5f, 0.0f), Vector3f(1.0f, 0.0f, 0.0f), 0.0f, 100.0f);
+
+        float tmin = FP<float>::snan();
+        const size_t index =
+            intersect_disks_x8(
+                ray,
+                DisksX, DisksY, DisksZ,
+                DisksNormalX, DisksNormalY, DisksNormalZ,
+                DisksRadius,
+                4,
+                tmin);
+
+        EXPECT_EQ(~size_t(0), index);
+        EXPECT_TRUE(FP<float>::is_snan(tmin));
+    }
+
+    TEST_CASE(IntersectDisksX8_RayHitsDiskOfUnitDirection_ReturnsDistanceToDisk)
+    {
+        const Ray3f ray(Vector3f(2.0f, 3.0f, 0.5f), Vector3f(0.0f, -1.0f, 0.0f), 0.0f, 100.0f);
+
+        float tmin = FP<float>::snan();
+        const size_t index =
+            intersect_disks_x8(
+                ray,
+                DisksX, DisksY, DisksZ,
+                DisksNormalX, DisksNormalY, DisksNormalZ,
+                DisksRadius,
+                4,
+                tmin);
+
+        ASSERT_EQ(3, index);
+        EXPECT_FEQ(3.0f, tmin);
+    }
+}
@@ -360,4 +360,47 @@ TEST_SUITE(Foundation_Math_Intersection_RaySphere)
         EXPECT_FEQ(1.4 * K, t_out[0]);
         EXPECT_FEQ(3.0 * K, t_out[1]);
     }
+
+    //
+    // Intersection with several spheres at once.
+    //
+
+    // Spheres of radius 1 along the X axis, in no particular order.
+    const float SpheresX[8] = { 10.0f, 4.0f, 7.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    const float SpheresY[8] = { 0.0f, 0.0f, 0.0f, 5.0f, 5.0f, 5.0f, 5.0f, 5.0f };
+    const float SpheresZ[8] = { 0.0f };
+    const float SpheresRadius[8] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+
+    TEST_CASE(IntersectSpheresX8_RayHitsSeveralSpheres_ReturnsClosestSphere)
+    {
+        const Ray3f ray(Vector3f(0.0f, 0.0f, 0.0f), Vector3f(1.0f, 0.0f, 0.0f), 0.0f, 100.0f);
+
+        float tmin = FP<float>::snan();
+        const size_t index = intersect_spheres_x8(ray, SpheresX, SpheresY, SpheresZ, SpheresRadius, 3, tmin);
+
+        ASSERT_EQ(1, index);
+        EXPECT_FEQ(3.0f, tmin);
+    }
+
+    TEST_CASE(IntersectSpheresX8_TMinInsideClosestSphere_ReturnsExitPointOfClosestSphere)
+    {
+        const Ray3f ray(Vector3f(0.0f, 0.0f, 0.0f), Vector3f(1.0f, 0.0f, 0.0f), 4.0f, 100.0f);
+
+        float tmin = FP<float>::snan();
+        const size_t index = intersect_spheres_x8(ray, SpheresX, SpheresY, SpheresZ, SpheresRadius, 3, tmin);
+
+        ASSERT_EQ(1, index);
+        EXPECT_FEQ(5.0f, tmin);
+    }
+
+    TEST_CASE(IntersectSpheresX8_ClosestSphereBeyondCount_IgnoresClosestSphere)
+    {
+        const Ray3f ray(Vector3f(0.0f, 5.0f, 0.0f), Vector3f(-1.0f, 0.0f, 0.0f), 0.0f, 100.0f);
+
+        float tmin = FP<float>::snan();
+        const size_t index = intersect_spheres_x8(ray, SpheresX, SpheresY, SpheresZ, SpheresRadius, 3, tmin);
+
+        EXPECT_EQ(~size_t(0), index);
+        EXPECT_TRUE(FP<float>::is_snan(tmin));
+    }
 }
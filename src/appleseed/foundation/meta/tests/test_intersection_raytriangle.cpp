@@ -30,10 +30,14 @@
 // appleseed.foundation headers.
 #include "foundation/math/intersection/raytrianglemt.h"
 #include "foundation/math/intersection/raytrianglessk.h"
+#include "foundation/math/intersection/raytrianglewatertight.h"
 #include "foundation/math/ray.h"
 #include "foundation/math/vector.h"
 #include "foundation/utility/test.h"
 
+// Standard headers.
+#include <cstddef>
+
 using namespace foundation;
 
 namespace
@@ -166,3 +170,89 @@ TEST_SUITE(Foundation_Math_Intersection_RayTriangleSSK)
         EXPECT_FEQ(0.5, v);
     }
 }
+
+TEST_SUITE(Foundation_Math_Intersection_RayTriangleWatertight)
+{
+    typedef RayTriangleFixture<TriangleWatertight<double>> Fixture;
+
+    TEST_CASE_F(Intersect_GivenRayWithTMinEqualToHitDistance_ReturnsTrue, Fixture)
+    {
+        const Ray3d ray(Vector3d(-0.2, 1.0, 0.2), Vector3d(0.0, -1.0, 0.0), 1.0, 10.0);
+
+        const bool hit = m_triangle.intersect(ray);
+
+        ASSERT_TRUE(hit);
+    }
+
+    TEST_CASE_F(Intersect_GivenRayWithTMaxEqualToHitDistance_ReturnsFalse, Fixture)
+    {
+        const Ray3d ray(Vector3d(-0.2, 1.0, 0.2), Vector3d(0.0, -1.0, 0.0), 0.0, 1.0);
+
+        const bool hit = m_triangle.intersect(ray);
+
+        ASSERT_FALSE(hit);
+    }
+
+    TEST_CASE_F(Intersect_GivenRayWithTMinEqualToHitDistance_ReturnsHit, Fixture)
+    {
+        const Ray3d ray(Vector3d(-0.2, 1.0, 0.2), Vector3d(0.0, -1.0, 0.0), 1.0, 10.0);
+
+        double t, u, v;
+        const bool hit = m_triangle.intersect(ray, t, u, v);
+
+        ASSERT_TRUE(hit);
+        EXPECT_FEQ(1.0, t);
+    }
+
+    TEST_CASE_F(Intersect_GivenRayWithTMaxEqualToHitDistance_ReturnsNoHit, Fixture)
+    {
+        const Ray3d ray(Vector3d(-0.2, 1.0, 0.2), Vector3d(0.0, -1.0, 0.0), 0.0, 1.0);
+
+        double t, u, v;
+        const bool hit = m_triangle.intersect(ray, t, u, v);
+
+        ASSERT_FALSE(hit);
+    }
+
+    TEST_CASE_F(Intersect_GivenRayHittingDiagonalOfQuad_ReturnsHit, Fixture)
+    {
+        const Ray3d ray(Vector3d(0.0, 1.0, 0.0), Vector3d(0.0, -1.0, 0.0));
+
+        double t, u, v;
+        const bool hit = m_triangle.intersect(ray, t, u, v);
+
+        ASSERT_TRUE(hit);
+        EXPECT_FEQ(1.0, t);
+        EXPECT_FEQ(0.0, u);
+        EXPECT_FEQ(0.5, v);
+    }
+
+    TEST_CASE(Intersect_GivenRaysThroughEdgeSharedByTwoTriangles_NeverMissesBothTriangles)
+    {
+        const Vector3f a(0.1f, 0.3f, 0.0f);
+        const Vector3f b(1.7f, 0.2f, 0.01f);
+        const Vector3f c(1.3f, 1.9f, 0.02f);
+        const Vector3f d(-0.4f, 1.5f, 0.0f);
+
+        const TriangleWatertight<float> triangle1(a, b, c);
+        const TriangleWatertight<float> triangle2(a, c, d);
+
+        const Vector3d org(0.37, 0.71, 5.0);
+        const size_t RayCount = 10000;
+
+        size_t miss_count = 0;
+
+        for (size_t i = 0; i < RayCount; ++i)
+        {
+            const float s = static_cast<float>(i) / RayCount;
+            const Vector3f p = a + s * (c - a);
+            const Ray3d ray(org, normalize(Vector3d(p) - org));
+            const WatertightRay<float> watertight_ray(ray);
+
+            if (!triangle1.intersect(watertight_ray) && !triangle2.intersect(watertight_ray))
+                ++miss_count;
+        }
+
+        EXPECT_EQ(0, miss_count);
+    }
+}
@@ -37,13 +37,18 @@
 #include "foundation/utility/job/jobmanager.h"
 #include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/job/workerthread.h"
+#include "foundation/utility/job/workstealingdeque.h"
 #include "foundation/utility/test.h"
 
+// Boost headers.
+#include "boost/thread/thread.hpp"
+
 // Standard headers.
 #include <cstddef>
 #include <cstdint>
 #include <new>
 #include <utility>
+#include <vector>
 
 using namespace foundation;
 
@@ -105,6 +110,156 @@ TEST_SUITE(Foundation_Utility_Job_AbortSwitch)
     }
 }
 
+TEST_SUITE(Foundation_Utility_Job_WorkStealingDeque)
+{
+    TEST_CASE(Pop_GivenEmptyDeque_ReturnsFalse)
+    {
+        WorkStealingDeque<size_t> deque;
+
+        size_t item;
+        EXPECT_FALSE(deque.pop(item));
+    }
+
+    TEST_CASE(Steal_GivenEmptyDeque_ReturnsFalse)
+    {
+        WorkStealingDeque<size_t> deque;
+
+        size_t item;
+        EXPECT_FALSE(deque.steal(item));
+    }
+
+    TEST_CASE(Pop_ReturnsItemsInReverseOrderOfInsertion)
+    {
+        WorkStealingDeque<size_t> deque;
+        deque.push(1);
+        deque.push(2);
+
+        size_t item1, item2;
+        EXPECT_TRUE(deque.pop(item1));
+        EXPECT_TRUE(deque.pop(item2));
+
+        EXPECT_EQ(2, item1);
+        EXPECT_EQ(1, item2);
+        EXPECT_TRUE(deque.empty());
+    }
+
+    TEST_CASE(Steal_ReturnsItemsInOrderOfInsertion)
+    {
+        WorkStealingDeque<size_t> deque;
+        deque.push(1);
+        deque.push(2);
+
+        size_t item1, item2;
+        EXPECT_TRUE(deque.steal(item1));
+        EXPECT_TRUE(deque.steal(item2));
+
+        EXPECT_EQ(1, item1);
+        EXPECT_EQ(2, item2);
+        EXPECT_TRUE(deque.empty());
+    }
+
+    TEST_CASE(Push_BeyondInitialCapacity_GrowsDeque)
+    {
+        const size_t ItemCount = 100;
+
+        WorkStealingDeque<size_t> deque(4);
+
+        for (size_t i = 0; i < ItemCount; ++i)
+            deque.push(i);
+
+        EXPECT_EQ(ItemCount, deque.size());
+
+        bool ordered = true;
+
+        for (size_t i = 0; i < ItemCount; ++i)
+        {
+            size_t item;
+            if (!deque.steal(item) || item != i)
+                ordered = false;
+        }
+
+        EXPECT_TRUE(ordered);
+    }
+
+    struct Thief
+    {
+        WorkStealingDeque<size_t>&  m_deque;
+        volatile std::uint32_t&     m_done;
+        std::vector<size_t>&        m_stolen;
+
+        Thief(
+            WorkStealingDeque<size_t>&  deque,
+            volatile std::uint32_t&     done,
+            std::vector<size_t>&        stolen)
+          : m_deque(deque)
+          , m_done(done)
+          , m_stolen(stolen)
+        {
+        }
+
+        void operator()()
+        {
+            while (true)
+            {
+                const bool done = atomic_read(&m_done) != 0;
+
+                size_t item;
+                if (m_deque.steal(item))
+                    m_stolen.push_back(item);
+                else if (done && m_deque.empty())
+                    break;
+            }
+        }
+    };
+
+    TEST_CASE(ConcurrentPopAndSteal_EachItemIsRetrievedExactlyOnce)
+    {
+        const size_t ItemCount = 100000;
+        const size_t ThiefCount = 3;
+
+        WorkStealingDeque<size_t> deque(16);
+        volatile std::uint32_t done = 0;
+
+        std::vector<size_t> stolen[ThiefCount];
+        boost::thread_group thieves;
+        for (size_t i = 0; i < ThiefCount; ++i)
+            thieves.create_thread(Thief(deque, done, stolen[i]));
+
+        std::vector<size_t> popped;
+        for (size_t i = 0; i < ItemCount; ++i)
+        {
+            deque.push(i);
+
+            size_t item;
+            if (i % 3 == 0 && deque.pop(item))
+                popped.push_back(item);
+        }
+
+        atomic_write(&done, 1);
+        thieves.join_all();
+
+        std::vector<std::uint32_t> retrieval_count(ItemCount, 0);
+
+        for (const size_t item : popped)
+            ++retrieval_count[item];
+
+        for (size_t i = 0; i < ThiefCount; ++i)
+        {
+            for (const size_t item : stolen[i])
+                ++retrieval_count[item];
+        }
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < ItemCount; ++i)
+        {
+            if (retrieval_count[i] != 1)
+                ++mismatches;
+        }
+
+        EXPECT_EQ(0, mismatches);
+    }
+}
+
 TEST_SUITE(Foundation_Utility_Job_JobQueue)
 {
     class JobNotifyingAboutDestruction
@@ -133,6 +288,8 @@ TEST_SUITE(Foundation_Utility_Job_JobQueue)
     {
         JobQueue job_queue;
 
+        EXPECT_EQ(JobQueue::WorkStealingScheduling, job_queue.get_scheduling_mode());
+
         EXPECT_FALSE(job_queue.has_scheduled_jobs());
         EXPECT_FALSE(job_queue.has_running_jobs());
         EXPECT_FALSE(job_queue.has_scheduled_or_running_jobs());
@@ -294,6 +451,102 @@ TEST_SUITE(Foundation_Utility_Job_JobQueue)
 
         EXPECT_EQ(0, destruction_count);
     }
+
+    TEST_CASE(AcquireScheduledJob_CentralizedScheduling_ReturnsJobsInOrderOfScheduling)
+    {
+        IJob* job1 = new EmptyJob();
+        IJob* job2 = new EmptyJob();
+
+        JobQueue job_queue(JobQueue::CentralizedScheduling);
+        job_queue.schedule(job1);
+        job_queue.schedule(job2);
+
+        const JobQueue::RunningJobInfo running_job_info1 = job_queue.acquire_scheduled_job();
+        const JobQueue::RunningJobInfo running_job_info2 = job_queue.acquire_scheduled_job();
+
+        EXPECT_EQ(job1, running_job_info1.first.m_job);
+        EXPECT_EQ(job2, running_job_info2.first.m_job);
+        EXPECT_EQ(2, job_queue.get_running_job_count());
+
+        job_queue.retire_running_job(running_job_info1);
+        job_queue.retire_running_job(running_job_info2);
+
+        EXPECT_FALSE(job_queue.has_scheduled_or_running_jobs());
+    }
+
+    TEST_CASE(AcquireScheduledJob_WorkStealingScheduling_ReturnsJobsInOrderOfScheduling)
+    {
+        IJob* job1 = new EmptyJob();
+        IJob* job2 = new EmptyJob();
+
+        JobQueue job_queue(JobQueue::WorkStealingScheduling);
+        job_queue.schedule(job1);
+        job_queue.schedule(job2);
+
+        const JobQueue::RunningJobInfo running_job_info1 = job_queue.acquire_scheduled_job();
+        const JobQueue::RunningJobInfo running_job_info2 = job_queue.acquire_scheduled_job();
+
+        EXPECT_EQ(job1, running_job_info1.first.m_job);
+        EXPECT_EQ(job2, running_job_info2.first.m_job);
+        EXPECT_EQ(2, job_queue.get_running_job_count());
+
+        job_queue.retire_running_job(running_job_info1);
+        job_queue.retire_running_job(running_job_info2);
+
+        EXPECT_FALSE(job_queue.has_scheduled_or_running_jobs());
+    }
+
+    TEST_CASE(AcquireScheduledJob_CentralizedScheduling_ReturnsHighPriorityJobsFirst)
+    {
+        IJob* job1 = new EmptyJob();
+        IJob* job2 = new EmptyJob();
+        IJob* job3 = new EmptyJob();
+
+        JobQueue job_queue(JobQueue::CentralizedScheduling);
+        job_queue.schedule(job1);
+        job_queue.schedule(job2, true, JobQueue::HighPriority);
+        job_queue.schedule(job3, true, JobQueue::HighPriority);
+
+        const JobQueue::RunningJobInfo running_job_info1 = job_queue.acquire_scheduled_job();
+        const JobQueue::RunningJobInfo running_job_info2 = job_queue.acquire_scheduled_job();
+        const JobQueue::RunningJobInfo running_job_info3 = job_queue.acquire_scheduled_job();
+
+        EXPECT_EQ(job2, running_job_info1.first.m_job);
+        EXPECT_EQ(job3, running_job_info2.first.m_job);
+        EXPECT_EQ(job1, running_job_info3.first.m_job);
+
+        job_queue.retire_running_job(running_job_info1);
+        job_queue.retire_running_job(running_job_info2);
+        job_queue.retire_running_job(running_job_info3);
+
+        EXPECT_FALSE(job_queue.has_scheduled_or_running_jobs());
+    }
+
+    TEST_CASE(AcquireScheduledJob_WorkStealingScheduling_ReturnsHighPriorityJobsFirst)
+    {
+        IJob* job1 = new EmptyJob();
+        IJob* job2 = new EmptyJob();
+        IJob* job3 = new EmptyJob();
+
+        JobQueue job_queue(JobQueue::WorkStealingScheduling);
+        job_queue.schedule(job1);
+        job_queue.schedule(job2, true, JobQueue::HighPriority);
+        job_queue.schedule(job3, true, JobQueue::HighPriority);
+
+        const JobQueue::RunningJobInfo running_job_info1 = job_queue.acquire_scheduled_job();
+        const JobQueue::RunningJobInfo running_job_info2 = job_queue.acquire_scheduled_job();
+        const JobQueue::RunningJobInfo running_job_info3 = job_queue.acquire_scheduled_job();
+
+        EXPECT_EQ(job2, running_job_info1.first.m_job);
+        EXPECT_EQ(job3, running_job_info2.first.m_job);
+        EXPECT_EQ(job1, running_job_info3.first.m_job);
+
+        job_queue.retire_running_job(running_job_info1);
+        job_queue.retire_running_job(running_job_info2);
+        job_queue.retire_running_job(running_job_info3);
+
+        EXPECT_FALSE(job_queue.has_scheduled_or_running_jobs());
+    }
 }
 
 TEST_SUITE(Foundation_Utility_Job_JobManager)
@@ -373,6 +626,120 @@ TEST_SUITE(Foundation_Utility_Job_JobManager)
 
         EXPECT_EQ(1, execution_count);
     }
+
+    const size_t JobCount = 1000;
+
+    std::uint32_t execute_many_jobs_and_sub_jobs(
+        const JobQueue::SchedulingMode  scheduling_mode,
+        const size_t                    thread_count)
+    {
+        Logger logger;
+        JobQueue job_queue(scheduling_mode);
+        JobManager job_manager(logger, job_queue, thread_count, JobManager::KeepRunningOnEmptyQueue);
+
+        job_manager.start();
+
+        volatile std::uint32_t execution_count = 0;
+
+        for (size_t i = 0; i < JobCount; ++i)
+        {
+            job_queue.schedule(
+                new JobCreatingAnotherJob(job_queue, &execution_count));
+        }
+
+        job_queue.wait_until_completion();
+
+        return execution_count;
+    }
+
+    TEST_CASE(JobManagerExecutesManyJobsAndSubJobs_CentralizedScheduling)
+    {
+        EXPECT_EQ(JobCount, execute_many_jobs_and_sub_jobs(JobQueue::CentralizedScheduling, 4));
+    }
+
+    TEST_CASE(JobManagerExecutesManyJobsAndSubJobs_WorkStealingScheduling)
+    {
+        EXPECT_EQ(JobCount, execute_many_jobs_and_sub_jobs(JobQueue::WorkStealingScheduling, 4));
+    }
+
+    TEST_CASE(SetActiveThreadCount_ClampsToThreadCount)
+    {
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, 4);
+
+        EXPECT_EQ(4, job_manager.get_active_thread_count());
+
+        job_manager.set_active_thread_count(2);
+        EXPECT_EQ(2, job_manager.get_active_thread_count());
+
+        job_manager.set_active_thread_count(8);
+        EXPECT_EQ(4, job_manager.get_active_thread_count());
+
+        job_manager.set_active_thread_count(0);
+        EXPECT_EQ(4, job_manager.get_active_thread_count());
+    }
+
+    TEST_CASE(JobManagerExecutesJobsWithParkedThreads)
+    {
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, 4, JobManager::KeepRunningOnEmptyQueue);
+
+        job_manager.start();
+        job_manager.set_active_thread_count(1);
+
+        volatile std::uint32_t execution_count = 0;
+
+        for (size_t i = 0; i < JobCount; ++i)
+        {
+            job_queue.schedule(
+                new JobCreatingAnotherJob(job_queue, &execution_count));
+        }
+
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(JobCount, execution_count);
+    }
+
+    TEST_CASE(GetTimings_GivenCollectTimingsFlag_CountsExecutedJobs)
+    {
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, 4, JobManager::KeepRunningOnEmptyQueue | JobManager::CollectTimings);
+
+        job_manager.start();
+
+        volatile std::uint32_t execution_count = 0;
+
+        for (size_t i = 0; i < JobCount; ++i)
+        {
+            job_queue.schedule(
+                new JobCreatingAnotherJob(job_queue, &execution_count));
+        }
+
+        job_queue.wait_until_completion();
+
+        const JobManager::Timings timings = job_manager.get_timings();
+
+        EXPECT_EQ(2 * JobCount, timings.m_job_count);
+        EXPECT_TRUE(timings.m_job_time >= 0.0);
+        EXPECT_TRUE(timings.m_wait_time >= 0.0);
+    }
+
+    TEST_CASE(GetTimings_WithoutCollectTimingsFlag_ReturnsZeroTimings)
+    {
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, 1);
+
+        job_queue.schedule(new EmptyJob());
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(0, job_manager.get_timings().m_job_count);
+    }
 }
 
 TEST_SUITE(Foundation_Utility_Job_WorkerThread)
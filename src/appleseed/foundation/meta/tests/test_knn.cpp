@@ -46,6 +46,7 @@
 #include <cstdint>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <vector>
 
 using namespace foundation;
@@ -133,6 +134,28 @@ TEST_SUITE(Foundation_Math_Knn_Builder)
         EXPECT_EQ(8 + 4 + 2 + 1, tree.m_nodes.size());
     }
 
+    TEST_CASE(Build_GivenEightPointsAndMaxLeafSizeTwo_GeneratesSevenNodes)
+    {
+        const size_t PointCount = 8;
+
+        Vector3d points[PointCount];
+        for (size_t i = 0; i < PointCount; ++i)
+            points[i] = Vector3d(static_cast<double>(PointCount - i - 1), 0.0, 0.0);
+
+        knn::Tree3d tree;
+
+        knn::Builder3d builder(tree, 2);
+        builder.build<DefaultWallclockTimer>(points, PointCount);
+
+        ASSERT_EQ(4 + 2 + 1, tree.m_nodes.size());
+
+        for (size_t i = 3; i < 7; ++i)
+        {
+            ASSERT_TRUE(tree.m_nodes[i].is_leaf());
+            EXPECT_EQ(2, tree.m_nodes[i].get_point_count());
+        }
+    }
+
     TEST_CASE(Build_GivenTwoCoincidentPoints_Terminates)
     {
         const size_t PointCount = 2;
@@ -143,6 +166,48 @@ TEST_SUITE(Foundation_Math_Knn_Builder)
         knn::Builder3d builder(tree);
         builder.build<DefaultWallclockTimer>(points, PointCount);
     }
+
+    TEST_CASE(Build_UsingMultipleThreads_BuildsSameTreeAsSingleThread)
+    {
+        const size_t PointCount = 20000;
+
+        MersenneTwister rng;
+        std::vector<Vector3f> points(PointCount);
+        for (size_t i = 0; i < PointCount; ++i)
+            points[i] = rand_vector1<Vector3f>(rng);
+
+        knn::Tree3f tree1;
+        knn::Builder3f builder1(tree1);
+        builder1.build<DefaultWallclockTimer>(&points[0], PointCount, 1);
+
+        knn::Tree3f tree4;
+        knn::Builder3f builder4(tree4);
+        builder4.build<DefaultWallclockTimer>(&points[0], PointCount, 4);
+
+        EXPECT_TRUE(tree1.m_points == tree4.m_points);
+        EXPECT_TRUE(tree1.m_indices == tree4.m_indices);
+        ASSERT_EQ(tree1.m_nodes.size(), tree4.m_nodes.size());
+
+        bool same_nodes = true;
+
+        for (size_t i = 0, e = tree1.m_nodes.size(); i < e; ++i)
+        {
+            const knn::Tree3f::NodeType& node1 = tree1.m_nodes[i];
+            const knn::Tree3f::NodeType& node4 = tree4.m_nodes[i];
+
+            if (node1.is_leaf() != node4.is_leaf() ||
+                node1.get_point_index() != node4.get_point_index() ||
+                node1.get_point_count() != node4.get_point_count())
+                same_nodes = false;
+            else if (node1.is_interior() &&
+                     (node1.get_child_node_index() != node4.get_child_node_index() ||
+                      node1.get_split_dim() != node4.get_split_dim() ||
+                      node1.get_split_abs() != node4.get_split_abs()))
+                same_nodes = false;
+        }
+
+        EXPECT_TRUE(same_nodes);
+    }
 }
 
 TEST_SUITE(Foundation_Math_Knn_Answer)
@@ -379,10 +444,11 @@ TEST_SUITE(Foundation_Math_Knn_Query)
         const std::vector<Vector3d>&     points,
         const size_t                     answer_size,
         const size_t                     query_count,
-        std::function<Vector3d()>        make_query_point)
+        std::function<Vector3d()>        make_query_point,
+        const size_t                     max_leaf_size = 1)
     {
         knn::Tree3d tree;
-        knn::Builder3d builder(tree);
+        knn::Builder3d builder(tree, max_leaf_size);
         builder.build<DefaultWallclockTimer>(&points[0], points.size());
 
         knn::Answer<double> answer(answer_size);
@@ -428,6 +494,22 @@ TEST_SUITE(Foundation_Math_Knn_Query)
         EXPECT_TRUE(do_results_match_naive_algorithm(points, AnswerSize, QueryCount, make_query_point));
     }
 
+    TEST_CASE(Run_GivenLeafBuckets_ReturnsIdenticalResultsAsNaiveAlgorithm)
+    {
+        const size_t PointCount = 1000;
+        const size_t QueryCount = 200;
+        const size_t AnswerSize = 20;
+        const size_t MaxLeafSize = 8;
+
+        MersenneTwister rng;
+
+        std::vector<Vector3d> points;
+        generate_random_points(rng, points, PointCount);
+
+        auto make_query_point = [&rng]() { return rand_vector1<Vector3d>(rng); };
+        EXPECT_TRUE(do_results_match_naive_algorithm(points, AnswerSize, QueryCount, make_query_point, MaxLeafSize));
+    }
+
     TEST_CASE(Run_SkewedPointDistribution_ReturnsIdenticalResultsAsNaiveAlgorithm)
     {
         const size_t PointCount = 1000;
@@ -448,6 +530,54 @@ TEST_SUITE(Foundation_Math_Knn_Query)
         EXPECT_TRUE(do_results_match_naive_algorithm(points, AnswerSize, QueryCount, make_query_point));
     }
 
+    TEST_CASE(Run_SinglePrecisionPoints_ReturnsIdenticalResultsAsNaiveAlgorithm)
+    {
+        const size_t PointCount = 1000;
+        const size_t QueryCount = 200;
+        const size_t AnswerSize = 20;
+
+        MersenneTwister rng;
+
+        std::vector<Vector3f> points(PointCount);
+        for (size_t i = 0; i < PointCount; ++i)
+            points[i] = rand_vector1<Vector3f>(rng);
+
+        knn::Tree3f tree;
+        knn::Builder3f builder(tree);
+        builder.build<DefaultWallclockTimer>(&points[0], points.size());
+
+        knn::Answer<float> answer(AnswerSize);
+        knn::Query3f query(tree, answer);
+
+        std::vector<float> ref_square_dists(PointCount);
+        bool same_results = true;
+
+        for (size_t i = 0; i < QueryCount; ++i)
+        {
+            const Vector3f q = rand_vector1<Vector3f>(rng);
+
+            for (size_t j = 0; j < PointCount; ++j)
+                ref_square_dists[j] = square_distance(points[j], q);
+            std::sort(ref_square_dists.begin(), ref_square_dists.end());
+
+            query.run(q);
+            answer.sort();
+
+            if (answer.size() != AnswerSize)
+                same_results = false;
+            else
+            {
+                for (size_t j = 0; j < AnswerSize; ++j)
+                {
+                    if (answer.get(j).m_square_dist != ref_square_dists[j])
+                        same_results = false;
+                }
+            }
+        }
+
+        EXPECT_TRUE(same_results);
+    }
+
     TEST_CASE(Run_QueryPointsArePointsFromTheDataSet_ReturnsIdenticalResultsAsNaiveAlgorithm)
     {
         const size_t PointCount = 1000;
@@ -462,6 +592,65 @@ TEST_SUITE(Foundation_Math_Knn_Query)
         auto make_query_point = [&rng, &points]() { return points[rand_int1(rng, 0, static_cast<std::int32_t>(points.size()) - 1)]; };
         EXPECT_TRUE(do_results_match_naive_algorithm(points, AnswerSize, QueryCount, make_query_point));
     }
+
+    TEST_CASE(RunBatch_ReturnsIdenticalResultsAsIndividualQueries)
+    {
+        const size_t PointCount = 1000;
+        const size_t QueryCount = 200;
+        const size_t AnswerSize = 20;
+
+        MersenneTwister rng;
+
+        std::vector<Vector3d> points;
+        generate_random_points(rng, points, PointCount);
+
+        std::vector<Vector3d> query_points(QueryCount);
+        for (size_t i = 0; i < QueryCount; ++i)
+            query_points[i] = rand_vector1<Vector3d>(rng);
+
+        knn::Tree3d tree;
+        knn::Builder3d builder(tree, 4);
+        builder.build<DefaultWallclockTimer>(&points[0], points.size());
+
+        knn::Answer<double> answer(AnswerSize);
+        knn::Query3d query(tree, answer);
+
+        std::vector<std::vector<size_t>> batch_results(QueryCount);
+        size_t visited_query_count = 0;
+
+        auto visitor = [&batch_results, &visited_query_count](const size_t query_index, knn::Answer<double>& batch_answer)
+        {
+            batch_answer.sort();
+            for (size_t j = 0; j < batch_answer.size(); ++j)
+                batch_results[query_index].push_back(batch_answer.get(j).m_index);
+            ++visited_query_count;
+        };
+
+        query.run_batch(&query_points[0], QueryCount, std::numeric_limits<double>::max(), visitor);
+
+        ASSERT_EQ(QueryCount, visited_query_count);
+
+        bool same_results = true;
+
+        for (size_t i = 0; i < QueryCount; ++i)
+        {
+            query.run(query_points[i]);
+            answer.sort();
+
+            if (answer.size() != batch_results[i].size())
+                same_results = false;
+            else
+            {
+                for (size_t j = 0; j < answer.size(); ++j)
+                {
+                    if (answer.get(j).m_index != batch_results[i][j])
+                        same_results = false;
+                }
+            }
+        }
+
+        EXPECT_TRUE(same_results);
+    }
 }
 
 TEST_SUITE(Foundation_Math_Knn_AnyQuery)
@@ -117,3 +117,65 @@ TEST_SUITE(Foundation_Utility_Lazy_Access)
         EXPECT_EQ(0, access.get());
     }
 }
+
+TEST_SUITE(Foundation_Utility_Lazy)
+{
+    TEST_CASE(IsConstructed_BeforeFirstAccess_ReturnsFalse)
+    {
+        std::unique_ptr<ObjectFactory> factory(new SimpleObjectFactory(42));
+        Lazy<Object> object(std::move(factory));
+
+        EXPECT_FALSE(object.is_constructed());
+    }
+
+    TEST_CASE(IsConstructed_AfterFirstAccess_ReturnsTrue)
+    {
+        std::unique_ptr<ObjectFactory> factory(new SimpleObjectFactory(42));
+        Lazy<Object> object(std::move(factory));
+
+        Access<Object> access(&object);
+
+        EXPECT_TRUE(object.is_constructed());
+    }
+
+    TEST_CASE(TryReleaseObject_GivenObjectBeingAccessed_ReturnsFalse)
+    {
+        std::unique_ptr<ObjectFactory> factory(new SimpleObjectFactory(42));
+        Lazy<Object> object(std::move(factory));
+
+        Access<Object> access(&object);
+
+        EXPECT_FALSE(object.try_release_object());
+        EXPECT_EQ(42, access->m_value);
+    }
+
+    TEST_CASE(TryReleaseObject_GivenUnaccessedObject_DeletesObjectAndRecreatesItOnNextAccess)
+    {
+        std::unique_ptr<ObjectFactory> factory(new SimpleObjectFactory(42));
+        Lazy<Object> object(std::move(factory));
+
+        {
+            Access<Object> access(&object);
+        }
+
+        EXPECT_TRUE(object.try_release_object());
+        EXPECT_FALSE(object.is_constructed());
+
+        Access<Object> access(&object);
+
+        EXPECT_EQ(42, access->m_value);
+    }
+
+    TEST_CASE(TryReleaseObject_GivenSourceObject_ReturnsFalse)
+    {
+        Object source(42);
+        Lazy<Object> object(&source);
+
+        {
+            Access<Object> access(&object);
+        }
+
+        EXPECT_FALSE(object.try_release_object());
+        EXPECT_TRUE(object.is_constructed());
+    }
+}
@@ -0,0 +1,121 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/log/log.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <memory>
+#include <string>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Log_Logger)
+{
+    struct Fixture
+    {
+        Logger                              m_logger;
+        std::unique_ptr<StringLogTarget>    m_target;
+
+        Fixture()
+          : m_target(create_string_log_target())
+        {
+            m_logger.set_all_formats("{message}");
+            m_logger.add_target(m_target.get());
+        }
+
+        ~Fixture()
+        {
+            m_logger.set_async(false);
+            m_logger.remove_target(m_target.get());
+        }
+    };
+
+    TEST_CASE_F(Write_SynchronousMode_WritesMessageImmediately, Fixture)
+    {
+        LOG_INFO(m_logger, "hello %d", 42);
+
+        EXPECT_EQ("hello 42\n", std::string(m_target->get_string()));
+    }
+
+    TEST_CASE_F(Flush_AsynchronousMode_WritesAllMessagesInOrder, Fixture)
+    {
+        m_logger.set_async(true);
+
+        LOG_INFO(m_logger, "one");
+        LOG_WARNING(m_logger, "two");
+        LOG_INFO(m_logger, "three");
+
+        m_logger.flush();
+
+        EXPECT_EQ("one\ntwo\nthree\n", std::string(m_target->get_string()));
+    }
+
+    TEST_CASE_F(Flush_AsynchronousModeWithRepeatedMessages_CollapsesRepeats, Fixture)
+    {
+        m_logger.set_async(true);
+
+        for (int i = 0; i < 5; ++i)
+            LOG_WARNING(m_logger, "invalid sample");
+
+        LOG_INFO(m_logger, "done");
+
+        m_logger.flush();
+
+        EXPECT_EQ(
+            "invalid sample\n"
+            "(previous message repeated 4 times)\n"
+            "done\n",
+            std::string(m_target->get_string()));
+    }
+
+    TEST_CASE_F(SetAsync_False_WritesPendingMessages, Fixture)
+    {
+        m_logger.set_async(true);
+
+        LOG_INFO(m_logger, "pending");
+
+        m_logger.set_async(false);
+
+        EXPECT_EQ("pending\n", std::string(m_target->get_string()));
+        EXPECT_FALSE(m_logger.is_async());
+    }
+
+    TEST_CASE_F(Write_AsynchronousModeBelowVerbosityLevel_DiscardsMessage, Fixture)
+    {
+        m_logger.set_async(true);
+        m_logger.set_verbosity_level(LogMessage::Warning);
+
+        LOG_INFO(m_logger, "discarded");
+
+        m_logger.flush();
+
+        EXPECT_EQ("", std::string(m_target->get_string()));
+    }
+}
@@ -36,6 +36,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <vector>
 
@@ -159,6 +160,44 @@ TEST_SUITE(Foundation_Utility_Memory)
 
 #endif
 
+    TEST_CASE(LargePageAlignedMalloc_SmallAllocation_ReturnsAlignedPointer)
+    {
+        void* ptr = large_page_aligned_malloc(100, 32);
+
+        ASSERT_TRUE(ptr != nullptr);
+        EXPECT_TRUE(is_aligned(ptr, 32));
+
+        aligned_free(ptr);
+    }
+
+    TEST_CASE(LargePageAlignedMalloc_LargeAllocation_ReturnsAlignedWritablePointer)
+    {
+        const size_t Size = 5 * 1024 * 1024;
+
+        std::uint8_t* ptr = static_cast<std::uint8_t*>(large_page_aligned_malloc(Size, 64));
+
+        ASSERT_TRUE(ptr != nullptr);
+        EXPECT_TRUE(is_aligned(ptr, 64));
+
+        ptr[0] = 1;
+        ptr[Size - 1] = 2;
+        EXPECT_EQ(1, ptr[0]);
+        EXPECT_EQ(2, ptr[Size - 1]);
+
+        aligned_free(ptr);
+    }
+
+    TEST_CASE(AlignedAllocator_UsingLargePages_AllocatesAlignedMemory)
+    {
+        typedef AlignedAllocator<int> Allocator;
+
+        std::vector<int, Allocator> v(Allocator(32, true));
+        v.resize(1024 * 1024);
+
+        EXPECT_TRUE(is_aligned(&v[0], 32));
+        EXPECT_TRUE(Allocator(32, true) == Allocator(32, false));
+    }
+
     TEST_CASE(EnsureMinimumSize_GivenEmptyVector_ResizesVectorByInsertingDefaultValue)
     {
         std::vector<int> v;
@@ -0,0 +1,132 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/memory/memorytracker.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstring>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Memory_MemoryTracker)
+{
+    TEST_CASE(GetCategoryCount_GivenNewTracker_ReturnsZero)
+    {
+        MemoryTracker tracker;
+
+        EXPECT_EQ(0, tracker.get_category_count());
+    }
+
+    TEST_CASE(GetCategory_GivenSameNameTwice_ReturnsSameCategory)
+    {
+        MemoryTracker tracker;
+
+        const size_t category1 = tracker.get_category("geometry");
+        const size_t category2 = tracker.get_category("geometry");
+
+        EXPECT_EQ(category1, category2);
+        EXPECT_EQ(1, tracker.get_category_count());
+    }
+
+    TEST_CASE(GetCategory_GivenDifferentNames_ReturnsDifferentCategories)
+    {
+        MemoryTracker tracker;
+
+        const size_t category1 = tracker.get_category("geometry");
+        const size_t category2 = tracker.get_category("textures");
+
+        EXPECT_NEQ(category1, category2);
+        EXPECT_EQ(0, std::strcmp("textures", tracker.get_category_name(category2)));
+    }
+
+    TEST_CASE(GetCategory_GivenMoreCategoriesThanCapacity_ReturnsOtherCategory)
+    {
+        static const char* Names[] =
+        {
+            "c00", "c01", "c02", "c03", "c04", "c05", "c06", "c07",
+            "c08", "c09", "c10", "c11", "c12", "c13", "c14", "c15",
+            "c16", "c17", "c18", "c19", "c20", "c21", "c22", "c23",
+            "c24", "c25", "c26", "c27", "c28", "c29", "c30", "c31",
+            "c32"
+        };
+
+        MemoryTracker tracker;
+
+        size_t category = 0;
+        for (size_t i = 0; i < sizeof(Names) / sizeof(Names[0]); ++i)
+            category = tracker.get_category(Names[i]);
+
+        EXPECT_EQ(MemoryTracker::MaxCategoryCount - 1, category);
+        EXPECT_EQ(0, std::strcmp("other", tracker.get_category_name(category)));
+    }
+
+    TEST_CASE(Deallocate_GivenPreviousAllocations_UpdatesCurrentSizeButNotPeakSize)
+    {
+        MemoryTracker tracker;
+        const size_t category = tracker.get_category("geometry");
+
+        tracker.allocate(category, 100);
+        tracker.allocate(category, 50);
+        tracker.deallocate(category, 120);
+
+        EXPECT_EQ(30, tracker.get_current_size(category));
+        EXPECT_EQ(150, tracker.get_peak_size(category));
+    }
+
+    TEST_CASE(ResetPeakSizes_SetsPeakSizeToCurrentSize)
+    {
+        MemoryTracker tracker;
+        const size_t category = tracker.get_category("geometry");
+        tracker.allocate(category, 100);
+        tracker.deallocate(category, 60);
+
+        tracker.reset_peak_sizes();
+
+        EXPECT_EQ(40, tracker.get_peak_size(category));
+    }
+
+    TEST_CASE(TrackedMemory_GivenSizeChanges_UpdatesGlobalTracker)
+    {
+        MemoryTracker& tracker = global_memory_tracker();
+        const size_t category = tracker.get_category("unit test category");
+        const size_t initial_size = tracker.get_current_size(category);
+
+        {
+            TrackedMemory memory("unit test category");
+            memory.set_size(100);
+            memory.set_size(40);
+
+            EXPECT_EQ(initial_size + 40, tracker.get_current_size(category));
+        }
+
+        EXPECT_EQ(initial_size, tracker.get_current_size(category));
+    }
+}
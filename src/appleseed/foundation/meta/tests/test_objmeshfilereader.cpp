@@ -37,6 +37,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -140,6 +141,109 @@ TEST_SUITE(Foundation_Mesh_OBJMeshFileReader)
         EXPECT_EQ(1, mesh.m_faces.size());
     }
 
+    TEST_CASE(ReadCubeMeshFile_ParallelParsing)
+    {
+        OBJMeshFileReader reader(
+            "unit tests/inputs/test_objmeshfilereader_cube.obj",
+            OBJMeshFileReader::ParallelParsing);
+        MeshBuilder builder;
+        reader.read(builder);
+
+        EXPECT_EQ(1, builder.m_meshes.size());
+
+        Mesh& mesh = builder.m_meshes.front();
+        EXPECT_EQ("", mesh.m_name);
+        EXPECT_EQ(20, mesh.m_vertices.size());
+        EXPECT_EQ(6, mesh.m_vertex_normals.size());
+        EXPECT_EQ(20, mesh.m_tex_coords.size());
+        EXPECT_EQ(12, mesh.m_faces.size());
+    }
+
+    TEST_CASE(ReadLargeMeshFile_ParallelParsing_MatchesSerialParsing)
+    {
+        const char* Filename = "unit tests/outputs/test_objmeshfilereader_large.obj";
+
+        // Write a file large enough to be split into several chunks, with several
+        // groups and faces using both absolute and relative indices.
+        {
+            std::ofstream file(Filename);
+
+            for (size_t i = 0; i < 200000; ++i)
+            {
+                if (i % 50000 == 0)
+                    file << "g group" << i / 50000 << "\n";
+
+                file << "v " << i << ".125 " << i % 7 << ".5 -" << i % 13 << ".25\n";
+                file << "vt 0." << i % 10 << " 0." << i % 3 << "\n";
+
+                if (i % 4 == 3)
+                {
+                    file << "f " << i - 2 << "/" << i - 2 << " " << i << "/" << i << " " << i + 1 << "/" << i + 1 << "\n";
+                    file << "f -4/-4 -3/-3 -1/-1  # comment\n";
+                }
+            }
+        }
+
+        MeshBuilder serial_builder;
+        OBJMeshFileReader(Filename).read(serial_builder);
+
+        MeshBuilder parallel_builder;
+        OBJMeshFileReader(Filename, OBJMeshFileReader::ParallelParsing).read(parallel_builder);
+
+        ASSERT_EQ(4, serial_builder.m_meshes.size());
+        ASSERT_EQ(serial_builder.m_meshes.size(), parallel_builder.m_meshes.size());
+
+        for (size_t i = 0; i < serial_builder.m_meshes.size(); ++i)
+        {
+            const Mesh& serial_mesh = serial_builder.m_meshes[i];
+            const Mesh& parallel_mesh = parallel_builder.m_meshes[i];
+
+            EXPECT_EQ(serial_mesh.m_name, parallel_mesh.m_name);
+            EXPECT_EQ(serial_mesh.m_tex_coords.size(), parallel_mesh.m_tex_coords.size());
+            EXPECT_TRUE(serial_mesh.m_vertices == parallel_mesh.m_vertices);
+
+            ASSERT_EQ(serial_mesh.m_faces.size(), parallel_mesh.m_faces.size());
+
+            for (size_t j = 0; j < serial_mesh.m_faces.size(); ++j)
+                EXPECT_TRUE(serial_mesh.m_faces[j].m_vertices == parallel_mesh.m_faces[j].m_vertices);
+        }
+    }
+
+    TEST_CASE(Read_ParallelParsing_GivenOutOfRangeIndex_ThrowsParseErrorOnSameLineAsSerialParsing)
+    {
+        const char* Filename = "unit tests/outputs/test_objmeshfilereader_outofrangeindex.obj";
+
+        {
+            std::ofstream file(Filename);
+            file << "v 0 0 0\nv 1 0 0\n\nv 0 1 0\nf 1 2 3\nf 1 2 4\n";
+        }
+
+        size_t serial_line = 0;
+        try
+        {
+            MeshBuilder builder;
+            OBJMeshFileReader(Filename).read(builder);
+        }
+        catch (const OBJMeshFileReader::ExceptionParseError& e)
+        {
+            serial_line = e.m_line;
+        }
+
+        size_t parallel_line = 0;
+        try
+        {
+            MeshBuilder builder;
+            OBJMeshFileReader(Filename, OBJMeshFileReader::ParallelParsing).read(builder);
+        }
+        catch (const OBJMeshFileReader::ExceptionParseError& e)
+        {
+            parallel_line = e.m_line;
+        }
+
+        EXPECT_EQ(6, serial_line);
+        EXPECT_EQ(6, parallel_line);
+    }
+
 #if 0
 
     TEST_CASE(OBJFileToCPPFile)
@@ -0,0 +1,98 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/image/outofcoreimage.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Image_OutOfCoreImage)
+{
+    const char* ScratchFilePath = "unit tests/outputs/test_outofcoreimage.tiles";
+
+    TEST_CASE(Tile_GivenMoreTilesThanCacheCapacity_KeepsCapacityTilesResident)
+    {
+        OutOfCoreImage image(4, 1, 1, 1, 3, PixelFormatFloat, ScratchFilePath, 2);
+
+        for (size_t x = 0; x < 4; ++x)
+            image.tile(x, 0);
+
+        EXPECT_EQ(2, image.get_resident_tile_count());
+    }
+
+    TEST_CASE(Tile_GivenEvictedTile_RestoresItsContents)
+    {
+        OutOfCoreImage image(4, 1, 1, 1, 3, PixelFormatFloat, ScratchFilePath, 1);
+
+        for (size_t x = 0; x < 4; ++x)
+            image.tile(x, 0).set_pixel(0, 0, Color3f(static_cast<float>(x + 1)));
+
+        Color3f c0; image.tile(0, 0).get_pixel(0, 0, c0);
+        Color3f c3; image.tile(3, 0).get_pixel(0, 0, c3);
+
+        EXPECT_EQ(Color3f(1.0f), c0);
+        EXPECT_EQ(Color3f(4.0f), c3);
+    }
+
+    TEST_CASE(UnpinTile_EvictsTileBeyondCacheCapacity)
+    {
+        OutOfCoreImage image(4, 1, 1, 1, 3, PixelFormatFloat, ScratchFilePath, 1);
+
+        image.pin_tile(0, 0);
+        image.pin_tile(1, 0);
+        image.tile(0, 0).set_pixel(0, 0, Color3f(1.0f));
+        EXPECT_EQ(2, image.get_resident_tile_count());
+
+        image.unpin_tile(0, 0);
+        image.unpin_tile(1, 0);
+        EXPECT_EQ(1, image.get_resident_tile_count());
+
+        Color3f c0; image.tile(0, 0).get_pixel(0, 0, c0);
+        EXPECT_EQ(Color3f(1.0f), c0);
+    }
+
+    TEST_CASE(DiscardTiles_ResetsTilesToZero)
+    {
+        OutOfCoreImage image(2, 1, 1, 1, 3, PixelFormatFloat, ScratchFilePath, 1);
+        image.tile(0, 0).set_pixel(0, 0, Color3f(1.0f));
+        image.tile(1, 0);
+
+        image.discard_tiles();
+
+        Color3f c0; image.tile(0, 0).get_pixel(0, 0, c0);
+        EXPECT_EQ(Color3f(0.0f), c0);
+    }
+}
@@ -31,9 +31,14 @@
 #include "foundation/memory/poolallocator.h"
 #include "foundation/utility/test.h"
 
+// Boost headers.
+#include "boost/thread/thread.hpp"
+
 // Standard headers.
 #include <cstddef>
 #include <memory>
+#include <set>
+#include <vector>
 
 using namespace foundation;
 
@@ -96,6 +101,77 @@ TEST_SUITE(Foundation_Utility_PoolAllocator)
         allocator.deallocate(p, N);
     }
 
+    TEST_CASE(AllocateMoreItemsThanMagazineSize_ReturnsDistinctItems)
+    {
+        PoolAllocator<int, 2> allocator;
+
+        const size_t N = 1000;
+
+        std::vector<int*> items(N);
+        for (size_t i = 0; i < N; ++i)
+            items[i] = allocator.allocate(1);
+
+        const std::set<int*> unique_items(items.begin(), items.end());
+        EXPECT_EQ(N, unique_items.size());
+
+        for (size_t i = 0; i < N; ++i)
+            allocator.deallocate(items[i], 1);
+    }
+
+    TEST_CASE(DeallocateItemsOnOtherThreads_ItemsCanBeAllocatedAgain)
+    {
+        const size_t N = 1000;
+        const size_t ThreadCount = 4;
+
+        PoolAllocator<int, 16> allocator;
+
+        std::vector<int*> items(N);
+        for (size_t i = 0; i < N; ++i)
+            items[i] = allocator.allocate(1);
+
+        boost::thread_group threads;
+
+        for (size_t t = 0; t < ThreadCount; ++t)
+        {
+            threads.create_thread(
+                [&items, t]()
+                {
+                    PoolAllocator<int, 16> thread_allocator;
+
+                    for (size_t i = t; i < N; i += ThreadCount)
+                        thread_allocator.deallocate(items[i], 1);
+
+                    // Reallocate the items on this thread, and check that none of them is handed out twice.
+                    std::vector<int*> thread_items;
+                    for (size_t i = t; i < N; i += ThreadCount)
+                        thread_items.push_back(thread_allocator.allocate(1));
+
+                    for (size_t i = 0; i < thread_items.size(); ++i)
+                        *thread_items[i] = static_cast<int>(t);
+
+                    for (size_t i = t, j = 0; i < N; i += ThreadCount, ++j)
+                        items[i] = thread_items[j];
+                });
+        }
+
+        threads.join_all();
+
+        const std::set<int*> unique_items(items.begin(), items.end());
+        EXPECT_EQ(N, unique_items.size());
+
+        bool same_values = true;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (*items[i] != static_cast<int>(i % ThreadCount))
+                same_values = false;
+
+            allocator.deallocate(items[i], 1);
+        }
+
+        EXPECT_TRUE(same_values);
+    }
+
     TEST_CASE(RebindVoidAllocatorToIntAllocator)
     {
         PoolAllocator<void, 2>::rebind<int>::other allocator;
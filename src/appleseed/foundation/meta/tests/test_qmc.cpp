@@ -28,6 +28,7 @@
 //
 
 // appleseed.foundation headers.
+#include "foundation/hash/hash.h"
 #include "foundation/image/color.h"
 #include "foundation/image/genericimagefilewriter.h"
 #include "foundation/image/image.h"
@@ -49,6 +50,7 @@
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <string>
 #include <vector>
@@ -568,6 +570,77 @@ TEST_SUITE(Foundation_Math_QMC)
         plotfile.write("unit tests/outputs/test_qmc_integrate1dfunction.gnuplot");
     }
 
+    TEST_CASE(ReverseBitsUInt32)
+    {
+        EXPECT_EQ(0x00000000u, reverse_bits_uint32(0x00000000u));
+        EXPECT_EQ(0x80000000u, reverse_bits_uint32(0x00000001u));
+        EXPECT_EQ(0x00000001u, reverse_bits_uint32(0x80000000u));
+        EXPECT_EQ(0xF0000000u, reverse_bits_uint32(0x0000000Fu));
+        EXPECT_EQ(0x1E6A2C48u, reverse_bits_uint32(0x12345678u));
+    }
+
+    TEST_CASE(Sobol_FirstDimensionIsVanDerCorputSequence)
+    {
+        for (std::uint32_t i = 0; i < 1024; ++i)
+            EXPECT_EQ(reverse_bits_uint32(i), sobol_uint32(0, i));
+    }
+
+    TEST_CASE(Sobol_SecondDimension)
+    {
+        EXPECT_EQ(0x00000000u, sobol_uint32(1, 0));
+        EXPECT_EQ(0x80000000u, sobol_uint32(1, 1));     // 0.5
+        EXPECT_EQ(0xC0000000u, sobol_uint32(1, 2));     // 0.75
+        EXPECT_EQ(0x40000000u, sobol_uint32(1, 3));     // 0.25
+        EXPECT_EQ(0xA0000000u, sobol_uint32(1, 4));     // 0.625
+        EXPECT_EQ(0x20000000u, sobol_uint32(1, 5));     // 0.125
+    }
+
+    TEST_CASE(SobolOwenScrambledSample4_MatchesScalarImplementation)
+    {
+        const std::uint32_t Seed = 0x9E3779B9u;
+
+        for (std::uint32_t i = 0; i < 256; ++i)
+        {
+            float s[4];
+            sobol_owen_scrambled_sample4(i, Seed, s);
+
+            const std::uint32_t index = nested_uniform_scramble_base2(i, Seed);
+
+            for (size_t d = 0; d < 4; ++d)
+            {
+                const std::uint32_t expected =
+                    nested_uniform_scramble_base2(
+                        sobol_uint32(d, index),
+                        hash_uint32(Seed + static_cast<std::uint32_t>(d)));
+
+                EXPECT_EQ(static_cast<float>(expected >> 8) / 16777216.0f, s[d]);
+            }
+        }
+    }
+
+    TEST_CASE(SobolOwenScrambledSample4_First256SamplesAreStratifiedInFirstTwoDimensions)
+    {
+        for (std::uint32_t seed = 0; seed < 4; ++seed)
+        {
+            bool cells[16 * 16] = { false };
+
+            for (std::uint32_t i = 0; i < 256; ++i)
+            {
+                float s[4];
+                sobol_owen_scrambled_sample4(i, seed, s);
+
+                ASSERT_TRUE(s[0] >= 0.0f && s[0] < 1.0f);
+                ASSERT_TRUE(s[1] >= 0.0f && s[1] < 1.0f);
+
+                const size_t cx = static_cast<size_t>(s[0] * 16.0f);
+                const size_t cy = static_cast<size_t>(s[1] * 16.0f);
+
+                EXPECT_FALSE(cells[cy * 16 + cx]);
+                cells[cy * 16 + cx] = true;
+            }
+        }
+    }
+
 #if 0
 
     TEST_CASE(PrecomputeHaltonSequence)
@@ -34,6 +34,10 @@
 #ifdef APPLESEED_USE_SSE
 #include "foundation/math/rng/simdmersennetwister.h"
 #endif
+#include "foundation/math/rng/widepcg.h"
+#include "foundation/math/rng/widexoroshiro128plus.h"
+#include "foundation/math/rng/xoroshiro128plus.h"
+#include "foundation/math/sampling/rngsamplingcontext.h"
 #include "foundation/utility/countof.h"
 #include "foundation/utility/test.h"
 
@@ -996,3 +1000,95 @@ TEST_SUITE(Foundation_Math_RNG_SimdMersenneTwister)
 }
 
 #endif
+
+TEST_SUITE(Foundation_Math_RNG_WidePCG)
+{
+    TEST_CASE(RandUint32_StreamsMatchScalarPCG)
+    {
+        WidePCG<8> wide_rng(42, 54);
+
+        for (size_t i = 0; i < 8; ++i)
+        {
+            PCG rng(42, 54 + i);
+            WidePCG<8> copy(wide_rng);
+            std::uint32_t values[8];
+
+            for (size_t j = 0; j < 100; ++j)
+            {
+                copy.rand_uint32(values);
+                EXPECT_EQ(rng.rand_uint32(), values[i]);
+            }
+        }
+    }
+
+    TEST_CASE(RandUint32_TakesTurnsBetweenStreams)
+    {
+        WidePCG<4> wide_rng(42, 54);
+        PCG rng0(42, 54);
+        PCG rng1(42, 55);
+
+        EXPECT_EQ(rng0.rand_uint32(), wide_rng.rand_uint32());
+        EXPECT_EQ(rng1.rand_uint32(), wide_rng.rand_uint32());
+    }
+
+    TEST_CASE(Advance_IsEquivalentToGeneratingNumbers)
+    {
+        WidePCG<8> rng1(42, 54);
+        WidePCG<8> rng2(42, 54);
+        std::uint32_t values1[8];
+        std::uint32_t values2[8];
+
+        rng1.advance(1000);
+
+        for (size_t i = 0; i < 1000; ++i)
+            rng2.rand_uint32(values2);
+
+        rng1.rand_uint32(values1);
+        rng2.rand_uint32(values2);
+
+        for (size_t i = 0; i < 8; ++i)
+            EXPECT_EQ(values2[i], values1[i]);
+    }
+
+    TEST_CASE(CanBeUsedWithRNGSamplingContext)
+    {
+        WidePCG<8> rng;
+        RNGSamplingContext<WidePCG<8>> sampling_context(rng, 2, 0);
+
+        const Vector2d s = sampling_context.next2<Vector2d>();
+
+        EXPECT_TRUE(s[0] >= 0.0 && s[0] < 1.0);
+        EXPECT_TRUE(s[1] >= 0.0 && s[1] < 1.0);
+    }
+}
+
+TEST_SUITE(Foundation_Math_RNG_WideXoroshiro128plus)
+{
+    TEST_CASE(RandUint32_FirstStreamMatchesScalarXoroshiro128plus)
+    {
+        WideXoroshiro128plus<8> wide_rng(1, 2);
+        Xoroshiro128plus rng(1, 2);
+        std::uint32_t values[8];
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            wide_rng.rand_uint32(values);
+            EXPECT_EQ(rng.rand_uint32(), values[0]);
+        }
+    }
+
+    TEST_CASE(Jump_MovesToDifferentStreams)
+    {
+        WideXoroshiro128plus<4> rng1(1, 2);
+        WideXoroshiro128plus<4> rng2(1, 2);
+        std::uint32_t values1[4];
+        std::uint32_t values2[4];
+
+        rng2.jump();
+
+        rng1.rand_uint32(values1);
+        rng2.rand_uint32(values2);
+
+        EXPECT_NEQ(values1[0], values2[0]);
+    }
+}
@@ -33,6 +33,7 @@
 #include "foundation/math/rng/mersennetwister.h"
 #include "foundation/math/sampling/mappings.h"
 #include "foundation/math/sampling/qmcsamplingcontext.h"
+#include "foundation/math/sampling/sphericalrectanglesampler.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 #include "foundation/string/string.h"
@@ -639,3 +640,71 @@ TEST_SUITE(Foundation_Math_Sampling_Mappings)
         EXPECT_FEQ_EPS(ExpectedIntegralValue, value, 1.0e-2);
     }
 }
+
+TEST_SUITE(Foundation_Math_Sampling_SphericalRectangleSampler)
+{
+    TEST_CASE(GetSolidAngle_CenteredSquare_ReturnsExactSolidAngle)
+    {
+        // Square of side 2 at distance 1: solid angle is 4 * asin(4 / 8) = 2 * Pi / 3.
+        const SphericalRectangleSampler<double> sampler(
+            Vector3d(0.0, 0.0, 0.0),
+            Vector3d(-1.0, -1.0, 1.0),
+            Vector3d(2.0, 0.0, 0.0),
+            Vector3d(0.0, 2.0, 0.0));
+
+        EXPECT_FEQ_EPS(TwoPi<double>() / 3.0, sampler.get_solid_angle(), 1.0e-9);
+    }
+
+    TEST_CASE(Sample_ReturnsPointsOnRectangle)
+    {
+        const Vector3d corner(-0.5, 2.0, -3.0);
+        const Vector3d edge_x(1.0, 0.0, 1.0);
+        const Vector3d edge_y(0.0, 2.0, 0.0);
+        const SphericalRectangleSampler<double> sampler(Vector3d(0.3, -1.0, 0.2), corner, edge_x, edge_y);
+
+        const size_t Bases[] = { 2 };
+
+        for (size_t i = 0; i < 64; ++i)
+        {
+            const Vector2d s = hammersley_sequence<double, 2>(Bases, 64, i);
+            const Vector3d d = sampler.sample(s) - corner;
+
+            const double u = dot(d, edge_x) / square_norm(edge_x);
+            const double v = dot(d, edge_y) / square_norm(edge_y);
+            const double w = dot(d, normalize(cross(edge_x, edge_y)));
+
+            EXPECT_TRUE(u >= -1.0e-9 && u <= 1.0 + 1.0e-9);
+            EXPECT_TRUE(v >= -1.0e-9 && v <= 1.0 + 1.0e-9);
+            EXPECT_FEQ_EPS(0.0, w, 1.0e-9);
+        }
+    }
+
+    TEST_CASE(Sample_IsUniformInSolidAngle)
+    {
+        // The fraction of samples landing in the left half of the rectangle must match
+        // the fraction of the solid angle subtended by this left half.
+        const Vector3d origin(0.7, 0.2, 0.0);
+        const Vector3d corner(-1.0, -0.5, 1.0);
+        const Vector3d edge_x(2.0, 0.0, 0.0);
+        const Vector3d edge_y(0.0, 1.5, 0.0);
+
+        const SphericalRectangleSampler<double> sampler(origin, corner, edge_x, edge_y);
+        const SphericalRectangleSampler<double> left_half(origin, corner, 0.5 * edge_x, edge_y);
+
+        const size_t Bases[] = { 2 };
+        const size_t SampleCount = 4096;
+        size_t left_count = 0;
+
+        for (size_t i = 0; i < SampleCount; ++i)
+        {
+            const Vector2d s = hammersley_sequence<double, 2>(Bases, SampleCount, i);
+            if (sampler.sample(s).x < corner.x + 0.5 * edge_x.x)
+                ++left_count;
+        }
+
+        EXPECT_FEQ_EPS(
+            left_half.get_solid_angle() / sampler.get_solid_angle(),
+            static_cast<double>(left_count) / SampleCount,
+            1.0e-2);
+    }
+}
@@ -31,12 +31,17 @@
 #include "foundation/utility/searchpaths.h"
 #include "foundation/utility/test.h"
 
+// Boost headers.
+#include "boost/filesystem.hpp"
+
 // Standard headers.
 #include <cassert>
 #include <cstdlib>
+#include <fstream>
 #include <string>
 
 using namespace foundation;
+namespace bf = boost::filesystem;
 
 TEST_SUITE(Foundation_Utility_SearchPaths)
 {
@@ -181,4 +186,58 @@ TEST_SUITE(Foundation_Utility_SearchPaths)
     }
 
 #endif
+
+    TEST_CASE(Exist_GivenResolutionCache_FindsExistingFilesOnly)
+    {
+        SearchPaths search_paths;
+        search_paths.set_root_path("unit tests/inputs");
+        search_paths.set_resolution_cache_enabled(true);
+
+        EXPECT_TRUE(search_paths.exist("test_zip/c.txt"));
+        EXPECT_FALSE(search_paths.exist("test_zip/missing.txt"));
+        EXPECT_FALSE(search_paths.exist("missing/c.txt"));
+    }
+
+    TEST_CASE(LoadResolutionCache_AnswersFromSavedListings)
+    {
+        const char* CacheFilepath = "unit tests/outputs/test_searchpaths.searchpaths";
+
+        // Write a listing with a file that does not exist on disk.
+        {
+            const std::string directory = bf::path("unit tests/inputs").make_preferred().string();
+            std::ofstream file(CacheFilepath);
+            file << "appleseed search path resolution cache 1\n";
+            file << "D\t" << directory << "\n";
+            file << "F\tghost.txt\n";
+        }
+
+        SearchPaths search_paths;
+        search_paths.set_root_path("unit tests/inputs");
+        ASSERT_TRUE(search_paths.load_resolution_cache(CacheFilepath));
+
+        EXPECT_TRUE(search_paths.exist("ghost.txt"));
+        EXPECT_FALSE(search_paths.exist("test_zip_validzipfile.zip"));
+
+        bf::remove(CacheFilepath);
+    }
+
+    TEST_CASE(SaveResolutionCache_ThenLoadResolutionCache_PreservesListings)
+    {
+        const char* CacheFilepath = "unit tests/outputs/test_searchpaths.searchpaths";
+
+        SearchPaths saved_search_paths;
+        saved_search_paths.set_root_path("unit tests/inputs");
+        saved_search_paths.set_resolution_cache_enabled(true);
+        EXPECT_TRUE(saved_search_paths.exist("test_zip/c.txt"));
+        ASSERT_TRUE(saved_search_paths.save_resolution_cache(CacheFilepath));
+
+        SearchPaths loaded_search_paths;
+        loaded_search_paths.set_root_path("unit tests/inputs");
+        ASSERT_TRUE(loaded_search_paths.load_resolution_cache(CacheFilepath));
+
+        EXPECT_TRUE(loaded_search_paths.exist("test_zip/c.txt"));
+        EXPECT_FALSE(loaded_search_paths.exist("test_zip/missing.txt"));
+
+        bf::remove(CacheFilepath);
+    }
 }
@@ -0,0 +1,137 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/containers/soavector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Containers_SoAVector)
+{
+    typedef SoAVector<float, std::uint32_t> FloatUIntVector;
+
+    bool is_aligned(const void* ptr, const std::size_t alignment)
+    {
+        return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+    }
+
+    TEST_CASE(Constructor_CreatesEmptyVector)
+    {
+        const FloatUIntVector vec;
+
+        EXPECT_TRUE(vec.empty());
+        EXPECT_EQ(0, vec.size());
+        EXPECT_EQ(0, vec.padded_size());
+    }
+
+    TEST_CASE(PushBack_StoresFieldsInSeparateColumns)
+    {
+        FloatUIntVector vec;
+        vec.push_back(1.0f, 10);
+        vec.push_back(2.0f, 20);
+
+        ASSERT_EQ(2, vec.size());
+        EXPECT_EQ(1.0f, vec[0].get<0>());
+        EXPECT_EQ(10, vec[0].get<1>());
+        EXPECT_EQ(2.0f, vec.get<0>(1));
+        EXPECT_EQ(20, vec.get<1>(1));
+        EXPECT_EQ(2.0f, vec.column<0>()[1]);
+        EXPECT_EQ(20, vec.column<1>()[1]);
+    }
+
+    TEST_CASE(PushBack_AlignsAndPadsColumns)
+    {
+        FloatUIntVector vec;
+
+        for (std::uint32_t i = 0; i < 20; ++i)
+            vec.push_back(0.0f, i);
+
+        EXPECT_EQ(20, vec.size());
+        EXPECT_EQ(2 * FloatUIntVector::Padding, vec.padded_size());
+        EXPECT_TRUE(is_aligned(vec.column<0>(), FloatUIntVector::Alignment));
+        EXPECT_TRUE(is_aligned(vec.column<1>(), FloatUIntVector::Alignment));
+        EXPECT_EQ(0, vec.column<1>()[vec.padded_size() - 1]);
+    }
+
+    TEST_CASE(Reference_AllowsModifyingFields)
+    {
+        FloatUIntVector vec;
+        vec.push_back(1.0f, 10);
+
+        vec[0].get<1>() = 42;
+
+        EXPECT_EQ(42, vec.get<1>(0));
+    }
+
+    TEST_CASE(Resize_ResetsRemovedRecords)
+    {
+        FloatUIntVector vec;
+        vec.push_back(1.0f, 10);
+        vec.push_back(2.0f, 20);
+
+        vec.resize(1);
+        vec.resize(2);
+
+        EXPECT_EQ(1.0f, vec.get<0>(0));
+        EXPECT_EQ(0.0f, vec.get<0>(1));
+        EXPECT_EQ(0, vec.get<1>(1));
+    }
+
+    TEST_CASE(Append_AppendsRecordsOfOtherVector)
+    {
+        FloatUIntVector vec1;
+        vec1.push_back(1.0f, 10);
+
+        FloatUIntVector vec2;
+        vec2.push_back(2.0f, 20);
+        vec2.push_back(3.0f, 30);
+
+        vec1.append(vec2);
+
+        ASSERT_EQ(3, vec1.size());
+        EXPECT_EQ(1.0f, vec1.get<0>(0));
+        EXPECT_EQ(2.0f, vec1.get<0>(1));
+        EXPECT_EQ(30, vec1.get<1>(2));
+    }
+
+    TEST_CASE(ClearReleaseMemory_EmptiesVector)
+    {
+        FloatUIntVector vec;
+        vec.push_back(1.0f, 10);
+
+        vec.clear_release_memory();
+
+        EXPECT_TRUE(vec.empty());
+        EXPECT_EQ(0, vec.padded_size());
+    }
+}
@@ -0,0 +1,144 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/utility/statcounters.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstdint>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Utility_StatCounters)
+{
+    struct Fixture
+    {
+        const StatsLevel m_initial_level;
+
+        Fixture()
+          : m_initial_level(get_stats_level())
+        {
+        }
+
+        ~Fixture()
+        {
+            set_stats_level(m_initial_level);
+        }
+    };
+
+    TEST_CASE_F(SetStatsLevel_LevelAboveCompiledLevel_ClampsToCompiledLevel, Fixture)
+    {
+        set_stats_level(StatsLevel::Detailed);
+
+        EXPECT_TRUE(get_stats_level() <= CompiledStatsLevel);
+    }
+
+    TEST_CASE(StatCounter_OffLevel_IsDisabled)
+    {
+        StatCounter<StatsLevel::Off> counter;
+        ++counter;
+
+        EXPECT_FALSE(counter.is_enabled());
+        EXPECT_EQ(0, counter.get());
+    }
+
+    TEST_CASE_F(StatCounter_EnabledLevel_CountsIncrements, Fixture)
+    {
+        set_stats_level(StatsLevel::Basic);
+
+        StatCounter<StatsLevel::Basic> counter;
+        ++counter;
+        ++counter;
+        counter += 3;
+
+        if (CompiledStatsLevel >= StatsLevel::Basic)
+        {
+            EXPECT_TRUE(counter.is_enabled());
+            EXPECT_EQ(5, counter.get());
+        }
+        else
+        {
+            EXPECT_FALSE(counter.is_enabled());
+            EXPECT_EQ(0, counter.get());
+        }
+    }
+
+    TEST_CASE_F(StatCounter_LevelDisabledAtRunTime_DoesNotCount, Fixture)
+    {
+        set_stats_level(StatsLevel::Off);
+
+        StatCounter<StatsLevel::Basic> counter;
+        ++counter;
+
+        EXPECT_FALSE(counter.is_enabled());
+        EXPECT_EQ(0, counter.get());
+    }
+
+    TEST_CASE_F(StatCounter_Clear_ResetsValue, Fixture)
+    {
+        set_stats_level(StatsLevel::Basic);
+
+        StatCounter<StatsLevel::Basic> counter;
+        ++counter;
+        counter.clear();
+
+        EXPECT_EQ(0, counter.get());
+    }
+
+    TEST_CASE(StatCounter_LevelNotCompiledIn_HasNoState)
+    {
+        if (CompiledStatsLevel < StatsLevel::Detailed)
+            EXPECT_TRUE(sizeof(StatCounter<StatsLevel::Detailed>) < sizeof(std::uint64_t));
+    }
+
+    TEST_CASE_F(StatPopulation_EnabledLevel_RecordsValues, Fixture)
+    {
+        set_stats_level(StatsLevel::Basic);
+
+        StatPopulation<StatsLevel::Basic, std::uint64_t> population;
+        population.insert(2);
+        population.insert(4);
+
+        if (CompiledStatsLevel >= StatsLevel::Basic)
+        {
+            EXPECT_EQ(2, population.get().get_size());
+            EXPECT_EQ(3.0, population.get().get_mean());
+        }
+        else EXPECT_EQ(0, population.get().get_size());
+    }
+
+    TEST_CASE(CacheLinePadded_ForwardsToValue)
+    {
+        CacheLinePadded<std::uint64_t> padded;
+        padded.get() = 42;
+
+        EXPECT_EQ(42, *padded.operator->());
+        EXPECT_TRUE(sizeof(padded) >= sizeof(std::uint64_t) + 128);
+    }
+}
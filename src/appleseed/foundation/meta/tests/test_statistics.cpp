@@ -210,6 +210,25 @@ TEST_SUITE(Foundation_Utility_Statistics)
 
         EXPECT_EQ("  existing value                19.6%", stats.to_string());
     }
+
+    TEST_CASE(Get_GivenExistingStatistic_ReturnsIt)
+    {
+        Statistics stats;
+        stats.insert<std::uint64_t>("some value", 17);
+
+        const Statistics::Entry* entry = stats.get("some value");
+
+        ASSERT_NEQ(nullptr, entry);
+        EXPECT_EQ(17u, static_cast<const Statistics::UnsignedIntegerEntry*>(entry)->m_value);
+    }
+
+    TEST_CASE(Get_GivenUnknownStatistic_ReturnsNullptr)
+    {
+        Statistics stats;
+        stats.insert<std::uint64_t>("some value", 17);
+
+        EXPECT_EQ(nullptr, stats.get("other value"));
+    }
 }
 
 TEST_SUITE(Foundation_Utility_StatisticsVector)
@@ -228,4 +247,19 @@ TEST_SUITE(Foundation_Utility_StatisticsVector)
 
         EXPECT_EQ("stats 1:\n  counter 1                     17\nstats 2:\n  counter 2                     42", vec.to_string());
     }
+
+    TEST_CASE(Get_GivenExistingName_ReturnsStatistics)
+    {
+        Statistics stats;
+        stats.insert<std::uint64_t>("counter", 17);
+
+        StatisticsVector vec;
+        vec.insert("stats", stats);
+
+        const Statistics* found = vec.get("stats");
+
+        ASSERT_NEQ(nullptr, found);
+        EXPECT_EQ("  counter                       17", found->to_string());
+        EXPECT_EQ(nullptr, vec.get("other stats"));
+    }
 }
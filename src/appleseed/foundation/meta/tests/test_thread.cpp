@@ -28,6 +28,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/thread.h"
 #include "foundation/utility/job/abortswitch.h"
 #include "foundation/utility/stopwatch.h"
@@ -44,6 +45,48 @@ TEST_SUITE(Foundation_Platform_Thread)
         sleep(1000 * 3600, abort_switch);
     }
 
+    TEST_CASE(GetNUMANodeOfCPUCore_ReturnsValidNode)
+    {
+        const size_t node_count = System::get_numa_node_count();
+
+        EXPECT_GT(0, node_count);
+
+        for (size_t i = 0, e = System::get_logical_cpu_core_count(); i < e; ++i)
+            EXPECT_LT(node_count, System::get_numa_node_of_cpu_core(i));
+    }
+
+#if defined _WIN32 || defined __linux__
+
+    struct PinToFirstNode
+    {
+        bool& m_success;
+
+        explicit PinToFirstNode(bool& success)
+          : m_success(success)
+        {
+        }
+
+        void operator()()
+        {
+            m_success =
+                set_current_thread_cpu_core_affinity(0) &&
+                set_current_thread_numa_node_affinity(0);
+        }
+    };
+
+    TEST_CASE(SetCurrentThreadAffinity_OnFirstCoreAndNode_Succeeds)
+    {
+        bool success = false;
+
+        // Use a separate thread to leave the affinity of the test thread untouched.
+        boost::thread thread((PinToFirstNode(success)));
+        thread.join();
+
+        EXPECT_TRUE(success);
+    }
+
+#endif
+
 #ifdef EXPLORATION_TESTS
 
     TEST_CASE(Sleep_CheckElapsedTime)
@@ -0,0 +1,101 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/image/tilepool.h"
+#include "foundation/memory/memory.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Image_TilePool)
+{
+    TEST_CASE(Allocate_ReturnsCacheLineAlignedBlock)
+    {
+        TilePool& pool = TilePool::instance();
+
+        void* ptr = pool.allocate(1000);
+
+        EXPECT_TRUE(is_aligned(ptr, 64));
+
+        pool.deallocate(ptr, 1000);
+    }
+
+    TEST_CASE(Allocate_GivenSizeOfFreedBlock_ReusesBlock)
+    {
+        TilePool& pool = TilePool::instance();
+
+        void* ptr1 = pool.allocate(64 * 64 * 4 * 4);
+        pool.deallocate(ptr1, 64 * 64 * 4 * 4);
+
+        void* ptr2 = pool.allocate(64 * 64 * 4 * 4);
+        pool.deallocate(ptr2, 64 * 64 * 4 * 4);
+
+        EXPECT_EQ(ptr1, ptr2);
+    }
+
+    TEST_CASE(Allocate_GivenSizeInSameSizeClassAsFreedBlock_ReusesBlock)
+    {
+        TilePool& pool = TilePool::instance();
+
+        void* ptr1 = pool.allocate(64 * 64 * 4 * 4);
+        pool.deallocate(ptr1, 64 * 64 * 4 * 4);
+
+        void* ptr2 = pool.allocate(64 * 40 * 4 * 4);
+        pool.deallocate(ptr2, 64 * 40 * 4 * 4);
+
+        EXPECT_EQ(ptr1, ptr2);
+    }
+
+    TEST_CASE(Allocate_GivenSizeBeyondLargestSizeClass_ReturnsUsableBlock)
+    {
+        TilePool& pool = TilePool::instance();
+
+        const size_t Size = 64 * 1024 * 1024 + 1;
+        unsigned char* ptr = static_cast<unsigned char*>(pool.allocate(Size));
+        ptr[0] = 1;
+        ptr[Size - 1] = 2;
+
+        EXPECT_EQ(1, ptr[0]);
+        EXPECT_EQ(2, ptr[Size - 1]);
+
+        pool.deallocate(ptr, Size);
+    }
+
+    TEST_CASE(ReleaseCachedBlocks_EmptiesSharedCache)
+    {
+        TilePool& pool = TilePool::instance();
+
+        pool.release_cached_blocks();
+
+        EXPECT_EQ(0, pool.get_cached_size());
+    }
+}
@@ -36,6 +36,8 @@
 
 // Standard headers.
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <set>
 #include <string>
 #include <vector>
@@ -137,4 +139,60 @@ TEST_SUITE(Foundation_Utility_Zip)
         EXPECT_TRUE(find(files.begin(), files.end(), "subfolder/b.txt") != files.end());
         EXPECT_TRUE(find(files.begin(), files.end(), "c.txt")           != files.end());
     }
+
+    TEST_CASE(ZipArchive_ReadFile_GivenStoredFile_ReturnsFileContent)
+    {
+        const ZipArchive archive("unit tests/inputs/test_zip_validzipfile.zip");
+
+        std::vector<std::uint8_t> buffer;
+        const std::uint8_t* data;
+        size_t size;
+        ASSERT_TRUE(archive.read_file("subfolder/a.txt", data, size, buffer));
+
+        ASSERT_EQ(3, size);
+        EXPECT_EQ('A', data[0]);
+        EXPECT_TRUE(buffer.empty());
+    }
+
+    TEST_CASE(ZipArchive_ReadFile_GivenDeflatedFile_ReturnsFileContent)
+    {
+        const std::string TargetZip = "unit tests/outputs/test_zip_ziparchive.zip";
+
+        try
+        {
+            ASSERT_FALSE(bf::exists(TargetZip));
+
+            zip(TargetZip, "unit tests/inputs/test_zip");
+
+            {
+                const ZipArchive archive(TargetZip);
+
+                std::vector<std::uint8_t> buffer;
+                const std::uint8_t* data;
+                size_t size;
+                ASSERT_TRUE(archive.read_file("c.txt", data, size, buffer));
+
+                ASSERT_EQ(3, size);
+                EXPECT_EQ('C', data[0]);
+            }
+
+            bf::remove(TargetZip);
+        }
+        catch (const std::exception& e)
+        {
+            bf::remove(TargetZip);
+            throw e;
+        }
+    }
+
+    TEST_CASE(ZipArchive_ReadFile_GivenMissingFile_ReturnsFalse)
+    {
+        const ZipArchive archive("unit tests/inputs/test_zip_validzipfile.zip");
+
+        std::vector<std::uint8_t> buffer;
+        const std::uint8_t* data;
+        size_t size;
+
+        EXPECT_FALSE(archive.read_file("missing.txt", data, size, buffer));
+    }
 }
@@ -0,0 +1,110 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "isa.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/system.h"
+#include "foundation/utility/otherwise.h"
+
+namespace foundation
+{
+
+ISA get_compiled_isa()
+{
+#if defined APPLESEED_USE_AVX2
+    return ISA::AVX2;
+#elif defined APPLESEED_USE_AVX
+    return ISA::AVX;
+#elif defined APPLESEED_USE_SSE42
+    return ISA::SSE42;
+#elif defined APPLESEED_USE_SSE
+    return ISA::SSE2;
+#else
+    return ISA::Generic;
+#endif
+}
+
+namespace
+{
+    ISA detect_runtime_isa()
+    {
+#ifdef APPLESEED_X86
+        System::X86CPUFeatures features;
+        System::detect_x86_cpu_features(features);
+
+        if (features.m_os_avx512 &&
+            features.m_hw_avx512_f &&
+            features.m_hw_avx512_cd &&
+            features.m_hw_avx512_vl &&
+            features.m_hw_avx512_bw &&
+            features.m_hw_avx512_dq)
+            return ISA::AVX512;
+
+        if (features.m_os_avx && features.m_hw_avx2 && features.m_hw_fma3)
+            return ISA::AVX2;
+
+        if (features.m_os_avx && features.m_hw_avx)
+            return ISA::AVX;
+
+        if (features.m_hw_sse42)
+            return ISA::SSE42;
+
+        if (features.m_hw_sse2)
+            return ISA::SSE2;
+#endif
+
+        return ISA::Generic;
+    }
+}
+
+ISA get_runtime_isa()
+{
+    static const ISA isa = detect_runtime_isa();
+    return isa;
+}
+
+const char* get_isa_name(const ISA isa)
+{
+    switch (isa)
+    {
+      case ISA::Generic:    return "generic";
+      case ISA::SSE2:       return "SSE2";
+      case ISA::SSE42:      return "SSE4.2";
+      case ISA::AVX:        return "AVX";
+      case ISA::AVX2:       return "AVX2";
+      case ISA::AVX512:     return "AVX-512";
+      assert_otherwise;
+    }
+
+    // Keep the compiler happy.
+    return "";
+}
+
+}   // namespace foundation
@@ -0,0 +1,65 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+namespace foundation
+{
+
+//
+// Instruction set architectures, from least to most capable.
+//
+// A few hot kernels are compiled for several instruction sets, and the best version
+// supported by the host is selected at runtime. This allows binaries built for the
+// baseline instruction set to use wider SIMD units where they are available.
+//
+
+enum class ISA
+{
+    Generic,            // no SIMD instruction set assumed
+    SSE2,
+    SSE42,
+    AVX,
+    AVX2,               // AVX2 and FMA3
+    AVX512              // AVX-512 F, CD, VL, BW and DQ
+};
+
+// Return the instruction set the binary was compiled for.
+APPLESEED_DLLSYMBOL ISA get_compiled_isa();
+
+// Return the most capable instruction set supported by both the CPU and the operating system.
+// The CPU is only queried on the first call.
+APPLESEED_DLLSYMBOL ISA get_runtime_isa();
+
+// Return a human-readable name for an instruction set.
+APPLESEED_DLLSYMBOL const char* get_isa_name(const ISA isa);
+
+}   // namespace foundation
@@ -37,14 +37,17 @@
 #endif
 #include "foundation/platform/arch.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/isa.h"
 #include "foundation/platform/thread.h"
 #include "foundation/platform/types.h"
 #include "foundation/log/log.h"
 #include "foundation/string/string.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstring>
 #include <sstream>
+#include <vector>
 
 // Windows.
 #if defined _WIN32
@@ -986,10 +989,12 @@ void System::print_information(Logger& logger)
         "  vendor                        %s\n"
 #endif
         "  logical cores                 %s\n"
+        "  NUMA nodes                    %s\n"
         "  L1 data cache                 size %s, line size %s\n"
         "  L2 cache                      size %s, line size %s\n"
         "  L3 cache                      size %s, line size %s\n"
         "  instruction sets              %s\n"
+        "  dispatched instruction set    %s (compiled for %s)\n"
         "  physical memory               size %s\n"
         "  virtual memory                size %s\n"
         "  default wallclock timer       %s Hz\n"
@@ -1001,6 +1006,7 @@ void System::print_information(Logger& logger)
         "unknown",
 #endif
         pretty_uint(get_logical_cpu_core_count()).c_str(),
+        pretty_uint(get_numa_node_count()).c_str(),
         pretty_size(get_l1_data_cache_size()).c_str(),
         pretty_size(get_l1_data_cache_line_size()).c_str(),
         pretty_size(get_l2_cache_size()).c_str(),
@@ -1008,6 +1014,8 @@ void System::print_information(Logger& logger)
         pretty_size(get_l3_cache_size()).c_str(),
         pretty_size(get_l3_cache_line_size()).c_str(),
         get_cpu_features_string().c_str(),
+        get_isa_name(get_runtime_isa()),
+        get_isa_name(get_compiled_isa()),
         pretty_size(get_total_physical_memory_size()).c_str(),
         pretty_size(get_total_virtual_memory_size()).c_str(),
         pretty_uint(DefaultWallclockTimer().frequency()).c_str(),
@@ -1043,6 +1051,112 @@ size_t System::get_logical_cpu_core_count()
     return concurrency > 1 ? concurrency : 1;
 }
 
+namespace
+{
+    // Map each logical CPU core to its NUMA node.
+    // An empty table means that the NUMA topology is unknown.
+    struct NUMATopology
+    {
+        size_t              m_node_count;
+        std::vector<size_t> m_core_to_node;
+
+        NUMATopology()
+          : m_node_count(1)
+        {
+#if defined _WIN32
+
+            ULONG highest_node_number = 0;
+            if (GetNumaHighestNodeNumber(&highest_node_number) == FALSE)
+                return;
+
+            m_node_count = static_cast<size_t>(highest_node_number) + 1;
+
+            const size_t core_count = System::get_logical_cpu_core_count();
+            m_core_to_node.resize(core_count, 0);
+
+            // GetNumaProcessorNode() only supports the first 64 processors (processor group 0).
+            for (size_t i = 0; i < core_count && i < 64; ++i)
+            {
+                UCHAR node_number = 0;
+                if (GetNumaProcessorNode(static_cast<UCHAR>(i), &node_number) == TRUE && node_number != 0xFF)
+                    m_core_to_node[i] = std::min<size_t>(node_number, m_node_count - 1);
+            }
+
+#elif defined __linux__
+
+            // Reference: https://www.kernel.org/doc/Documentation/ABI/stable/sysfs-devices-node
+
+            const size_t core_count = System::get_logical_cpu_core_count();
+            std::vector<size_t> core_to_node(core_count, 0);
+            size_t node_count = 0;
+
+            for (size_t node = 0; ; ++node)
+            {
+                char path[64];
+                std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%lu/cpulist", (unsigned long)node);
+
+                FILE* file = std::fopen(path, "r");
+                if (file == nullptr)
+                    break;
+
+                ++node_count;
+
+                // The format of the list is a comma-separated list of ranges, e.g. "0-15,32-47".
+                unsigned long first, last;
+                while (std::fscanf(file, "%lu", &first) == 1)
+                {
+                    last = first;
+
+                    int c = std::fgetc(file);
+                    if (c == '-')
+                    {
+                        if (std::fscanf(file, "%lu", &last) != 1)
+                            break;
+                        c = std::fgetc(file);
+                    }
+
+                    for (unsigned long core = first; core <= last && core < core_count; ++core)
+                        core_to_node[core] = node;
+
+                    if (c != ',')
+                        break;
+                }
+
+                std::fclose(file);
+            }
+
+            if (node_count > 0)
+            {
+                m_node_count = node_count;
+                m_core_to_node.swap(core_to_node);
+            }
+
+#endif
+        }
+    };
+
+    const NUMATopology& get_numa_topology()
+    {
+        static const NUMATopology topology;
+        return topology;
+    }
+}
+
+size_t System::get_numa_node_count()
+{
+    return get_numa_topology().m_node_count;
+}
+
+size_t System::get_numa_node_of_cpu_core(const size_t core_index)
+{
+    const NUMATopology& topology = get_numa_topology();
+
+    return
+        core_index < topology.m_core_to_node.size()
+            ? topology.m_core_to_node[core_index]
+            : 0;
+}
+
 #ifdef APPLESEED_X86
 
 // This symbol is not defined by gcc (and potentially other compilers).
@@ -70,6 +70,17 @@ class APPLESEED_DLLSYMBOL System
     // Return the number of logical CPU cores available in the system.
     static size_t get_logical_cpu_core_count();
 
+    //
+    // NUMA topology.
+    //
+
+    // Return the number of NUMA nodes in the system, 1 if the system is not a NUMA system
+    // or if the topology cannot be determined.
+    static size_t get_numa_node_count();
+
+    // Return the NUMA node to which a given logical CPU core belongs, 0 if unknown.
+    static size_t get_numa_node_of_cpu_core(const size_t core_index);
+
     //
     // CPU caches.
     //
@@ -33,6 +33,7 @@
 // appleseed.foundation headers.
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #ifdef _WIN32
 #include "foundation/platform/windows.h"
 #endif
@@ -51,7 +52,11 @@
 #elif defined __FreeBSD__
 #include <pthread.h>
 #include <pthread_np.h>
+#include <sys/param.h>
+#include <sys/cpuset.h>
 #elif defined __linux__
+#include <pthread.h>
+#include <sched.h>
 #include <sys/prctl.h>
 #endif
 
@@ -172,6 +177,96 @@ void yield()
     this_thread::yield();
 }
 
+// Windows.
+#if defined _WIN32
+
+    bool set_current_thread_cpu_core_affinity(const size_t core_index)
+    {
+        // Only the first processor group (64 logical cores) is supported.
+        if (core_index >= 64)
+            return false;
+
+        const DWORD_PTR mask = static_cast<DWORD_PTR>(1) << core_index;
+        return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+    }
+
+    bool set_current_thread_numa_node_affinity(const size_t node_index)
+    {
+        ULONGLONG mask = 0;
+        if (GetNumaNodeProcessorMask(static_cast<UCHAR>(node_index), &mask) == FALSE || mask == 0)
+            return false;
+
+        return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(mask)) != 0;
+    }
+
+// Linux and FreeBSD.
+#elif defined __linux__ || defined __FreeBSD__
+
+    namespace
+    {
+#if defined __linux__
+        typedef cpu_set_t CPUSet;
+#else
+        typedef cpuset_t CPUSet;
+#endif
+
+        bool set_current_thread_cpu_set(const CPUSet& cpu_set)
+        {
+#if defined __linux__
+            return pthread_setaffinity_np(pthread_self(), sizeof(CPUSet), &cpu_set) == 0;
+#else
+            return cpuset_setaffinity(CPU_LEVEL_WHICH, CPU_WHICH_TID, -1, sizeof(CPUSet), &cpu_set) == 0;
+#endif
+        }
+    }
+
+    bool set_current_thread_cpu_core_affinity(const size_t core_index)
+    {
+        if (core_index >= CPU_SETSIZE)
+            return false;
+
+        CPUSet cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(core_index, &cpu_set);
+
+        return set_current_thread_cpu_set(cpu_set);
+    }
+
+    bool set_current_thread_numa_node_affinity(const size_t node_index)
+    {
+        CPUSet cpu_set;
+        CPU_ZERO(&cpu_set);
+
+        const size_t core_count = System::get_logical_cpu_core_count();
+        bool found = false;
+
+        for (size_t i = 0; i < core_count && i < CPU_SETSIZE; ++i)
+        {
+            if (System::get_numa_node_of_cpu_core(i) == node_index)
+            {
+                CPU_SET(i, &cpu_set);
+                found = true;
+            }
+        }
+
+        return found && set_current_thread_cpu_set(cpu_set);
+    }
+
+// Other platforms, including macOS which has no thread affinity API.
+#else
+
+    bool set_current_thread_cpu_core_affinity(const size_t core_index)
+    {
+        return false;
+    }
+
+    bool set_current_thread_numa_node_affinity(const size_t node_index)
+    {
+        return false;
+    }
+
+#endif
+
 
 //
 // ProcessPriorityContext class implementation.
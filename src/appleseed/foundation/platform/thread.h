@@ -43,6 +43,7 @@
 #include "boost/thread/thread.hpp"
 
 // Standard headers.
+#include <cstddef>
 #include <cstdint>
 
 // Forward declarations.
@@ -67,6 +68,14 @@ APPLESEED_DLLSYMBOL void sleep(const std::uint32_t ms, IAbortSwitch& abort_switc
 // Give up the remainder of the current thread's time slice, to allow other threads to run.
 APPLESEED_DLLSYMBOL void yield();
 
+// Restrict the current thread to run on a given logical CPU core.
+// Return false if thread affinity is not supported on this platform or if the operation failed.
+APPLESEED_DLLSYMBOL bool set_current_thread_cpu_core_affinity(const size_t core_index);
+
+// Restrict the current thread to run on the logical CPU cores of a given NUMA node.
+// Return false if thread affinity is not supported on this platform or if the operation failed.
+APPLESEED_DLLSYMBOL bool set_current_thread_numa_node_affinity(const size_t node_index);
+
 
 //
 // A simple spinlock.
@@ -87,4 +87,14 @@ AttributeSet::ChannelID AttributeSet::find_channel(const char* name) const
     return InvalidChannelID;
 }
 
+size_t AttributeSet::get_memory_size() const
+{
+    size_t size = m_channels.capacity() * sizeof(Channel*);
+
+    for (const Channel* channel : m_channels)
+        size += sizeof(Channel) + channel->m_storage.capacity();
+
+    return size;
+}
+
 }   // namespace foundation
@@ -42,4 +42,5 @@
 #include "foundation/utility/benchmark/ibenchmarklistener.h"
 #include "foundation/utility/benchmark/loggerbenchmarklistener.h"
 #include "foundation/utility/benchmark/timingresult.h"
+#include "foundation/utility/benchmark/valueresult.h"
 #include "foundation/utility/benchmark/xmlfilebenchmarklistener.h"
@@ -42,6 +42,7 @@
 namespace foundation    { class BenchmarkSuite; }
 namespace foundation    { class IBenchmarkCase; }
 namespace foundation    { class TimingResult; }
+namespace foundation    { class ValueResult; }
 
 namespace foundation
 {
@@ -99,6 +100,16 @@ class APPLESEED_DLLSYMBOL BenchmarkListenerBase
         const TimingResult&     timing_result) override
     {
     }
+
+    // Write a value result.
+    void write(
+        const BenchmarkSuite&   benchmark_suite,
+        const IBenchmarkCase&   benchmark_case,
+        const char*             file,
+        const size_t            line,
+        const ValueResult&      value_result) override
+    {
+    }
 };
 
 }   // namespace foundation
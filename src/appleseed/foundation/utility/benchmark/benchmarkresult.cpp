@@ -212,4 +212,23 @@ void BenchmarkResult::write(
     }
 }
 
+void BenchmarkResult::write(
+    const BenchmarkSuite&   benchmark_suite,
+    const IBenchmarkCase&   benchmark_case,
+    const char*             file,
+    const size_t            line,
+    const ValueResult&      value_result)
+{
+    // Send the value result to all the listeners.
+    for (each<Impl::BenchmarkListenerContainer> i = impl->m_listeners; i; ++i)
+    {
+        (*i)->write(
+            benchmark_suite,
+            benchmark_case,
+            file,
+            line,
+            value_result);
+    }
+}
+
 }   // namespace foundation
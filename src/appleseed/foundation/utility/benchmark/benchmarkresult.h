@@ -44,6 +44,7 @@ namespace foundation    { class BenchmarkSuite; }
 namespace foundation    { class IBenchmarkCase; }
 namespace foundation    { class IBenchmarkListener; }
 namespace foundation    { class TimingResult; }
+namespace foundation    { class ValueResult; }
 
 namespace foundation
 {
@@ -118,6 +119,14 @@ class APPLESEED_DLLSYMBOL BenchmarkResult
         const size_t            line,
         const TimingResult&     timing_result);
 
+    // Write a value result.
+    void write(
+        const BenchmarkSuite&   benchmark_suite,
+        const IBenchmarkCase&   benchmark_case,
+        const char*             file,
+        const size_t            line,
+        const ValueResult&      value_result);
+
   private:
     struct Impl;
     Impl* impl;
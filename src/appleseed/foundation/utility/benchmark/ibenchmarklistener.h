@@ -42,6 +42,7 @@
 namespace foundation    { class BenchmarkSuite; }
 namespace foundation    { class IBenchmarkCase; }
 namespace foundation    { class TimingResult; }
+namespace foundation    { class ValueResult; }
 
 namespace foundation
 {
@@ -87,6 +88,14 @@ class APPLESEED_DLLSYMBOL IBenchmarkListener
         const char*             file,
         const size_t            line,
         const TimingResult&     timing_result) = 0;
+
+    // Write a value result.
+    virtual void write(
+        const BenchmarkSuite&   benchmark_suite,
+        const IBenchmarkCase&   benchmark_case,
+        const char*             file,
+        const size_t            line,
+        const ValueResult&      value_result) = 0;
 };
 
 }   // namespace foundation
@@ -38,6 +38,7 @@
 #include "foundation/utility/benchmark/benchmarksuite.h"
 #include "foundation/utility/benchmark/ibenchmarkcase.h"
 #include "foundation/utility/benchmark/timingresult.h"
+#include "foundation/utility/benchmark/valueresult.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/test.h"
 
@@ -203,6 +204,24 @@ namespace
                 callrate_string.c_str());
         }
 
+        void write(
+            const BenchmarkSuite&   benchmark_suite,
+            const IBenchmarkCase&   benchmark_case,
+            const char*             file,
+            const size_t            line,
+            const ValueResult&      value_result) override
+        {
+            print_suite_name(benchmark_suite);
+
+            LOG_INFO(
+                m_logger,
+                "  %s: %s %s %s",
+                benchmark_case.get_name(),
+                value_result.m_name,
+                pretty_scalar(value_result.m_value, 3).c_str(),
+                value_result.m_unit);
+        }
+
       private:
         Logger&     m_logger;
         bool        m_suite_name_printed;
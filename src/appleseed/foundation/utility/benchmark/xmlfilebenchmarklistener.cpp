@@ -36,6 +36,7 @@
 #include "foundation/utility/benchmark/benchmarksuite.h"
 #include "foundation/utility/benchmark/ibenchmarkcase.h"
 #include "foundation/utility/benchmark/timingresult.h"
+#include "foundation/utility/benchmark/valueresult.h"
 #include "foundation/utility/indenter.h"
 
 // Standard headers.
@@ -185,6 +186,22 @@ void XMLFileBenchmarkListener::write(
     fprintf(impl->m_file, "%s</results>\n", impl->m_indenter.c_str());
 }
 
+void XMLFileBenchmarkListener::write(
+    const BenchmarkSuite&   benchmark_suite,
+    const IBenchmarkCase&   benchmark_case,
+    const char*             file,
+    const size_t            line,
+    const ValueResult&      value_result)
+{
+    fprintf(
+        impl->m_file,
+        "%s<value name=\"%s\" unit=\"%s\">%f</value>\n",
+        impl->m_indenter.c_str(),
+        value_result.m_name,
+        value_result.m_unit,
+        value_result.m_value);
+}
+
 bool XMLFileBenchmarkListener::open(const char* filename)
 {
     assert(filename);
@@ -31,7 +31,9 @@
 #include "bufferedfile.h"
 
 // appleseed.foundation headers.
+#include "foundation/log/logger.h"
 #include "foundation/memory/memory.h"
+#include "foundation/utility/job.h"
 #include "foundation/utility/otherwise.h"
 
 // LZ4 headers.
@@ -498,7 +500,15 @@ size_t CompressedWriterAdapter::write(
 //
 
 CompressedReaderAdapter::CompressedReaderAdapter(BufferedFile& file)
-  : m_file(file)
+  : m_file_adapter(new PassthroughReaderAdapter(file))
+  , m_source(*m_file_adapter)
+  , m_buffer_index(0)
+  , m_buffer_end(0)
+{
+}
+
+CompressedReaderAdapter::CompressedReaderAdapter(ReaderAdapter& source)
+  : m_source(source)
   , m_buffer_index(0)
   , m_buffer_end(0)
 {
@@ -518,7 +528,7 @@ size_t CompressedReaderAdapter::read(
                 break;
         }
 
-        const size_t copy = std::min(size, m_buffer_end - m_buffer_index);
+        const size_t copy = std::min(remaining, m_buffer_end - m_buffer_index);
         memcpy(outbuf, &m_buffer[m_buffer_index], copy);
 
         outbuf = reinterpret_cast<std::uint8_t*>(outbuf) + copy;
@@ -536,8 +546,8 @@ size_t CompressedReaderAdapter::read(
 
 namespace
 {
-    template <typename T>
-    inline size_t read_uint64(BufferedFile& file, T& x)
+    template <typename File, typename T>
+    inline size_t read_uint64(File& file, T& x)
     {
         std::uint64_t y;
         const size_t result = file.read(y);
@@ -610,11 +620,16 @@ LZ4CompressedReaderAdapter::LZ4CompressedReaderAdapter(BufferedFile& file)
 {
 }
 
+LZ4CompressedReaderAdapter::LZ4CompressedReaderAdapter(ReaderAdapter& source)
+  : CompressedReaderAdapter(source)
+{
+}
+
 bool LZ4CompressedReaderAdapter::fill_buffer()
 {
     // Read uncompressed size.
     size_t buffer_size;
-    if (read_uint64(m_file, buffer_size) == 0)
+    if (read_uint64(m_source, buffer_size) == 0)
         return false;
 
     // Allocate memory for the uncompressed buffer.
@@ -622,13 +637,13 @@ bool LZ4CompressedReaderAdapter::fill_buffer()
 
     // Read compressed size.
     size_t compressed_buffer_size;
-    read_uint64(m_file, compressed_buffer_size);
+    read_uint64(m_source, compressed_buffer_size);
 
     // Allocate memory for the compressed buffer.
     ensure_minimum_size(m_compressed_buffer, compressed_buffer_size);
 
     // Read compressed data.
-    m_file.read(&m_compressed_buffer[0], compressed_buffer_size);
+    m_source.read(&m_compressed_buffer[0], compressed_buffer_size);
 
     // Decompress data.
 #ifndef NDEBUG
@@ -647,4 +662,295 @@ bool LZ4CompressedReaderAdapter::fill_buffer()
     return true;
 }
 
+
+
+//
+// Jobs used by the multithreaded LZ4 compression adapters.
+//
+
+namespace
+{
+    class CompressLZ4BlockJob
+      : public IJob
+    {
+      public:
+        CompressLZ4BlockJob(
+            const std::vector<std::uint8_t>&    data,
+            const size_t                        size,
+            std::vector<std::uint8_t>&          compressed_data,
+            size_t&                             compressed_size)
+          : m_data(data)
+          , m_size(size)
+          , m_compressed_data(compressed_data)
+          , m_compressed_size(compressed_size)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            const size_t max_compressed_size =
+                static_cast<size_t>(LZ4_compressBound(static_cast<int>(m_size)));
+            ensure_minimum_size(m_compressed_data, max_compressed_size);
+
+            const int compressed_size =
+                LZ4_compress_default(
+                    reinterpret_cast<const char*>(&m_data[0]),
+                    reinterpret_cast<char*>(&m_compressed_data[0]),
+                    static_cast<int>(m_size),
+                    static_cast<int>(max_compressed_size));
+            assert(compressed_size > 0);
+
+            m_compressed_size = static_cast<size_t>(compressed_size);
+        }
+
+      private:
+        const std::vector<std::uint8_t>&        m_data;
+        const size_t                            m_size;
+        std::vector<std::uint8_t>&              m_compressed_data;
+        size_t&                                 m_compressed_size;
+    };
+
+    class DecompressLZ4BlockJob
+      : public IJob
+    {
+      public:
+        DecompressLZ4BlockJob(
+            const std::vector<std::uint8_t>&    compressed_data,
+            const size_t                        compressed_size,
+            std::vector<std::uint8_t>&          data,
+            const size_t                        size)
+          : m_compressed_data(compressed_data)
+          , m_compressed_size(compressed_size)
+          , m_data(data)
+          , m_size(size)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            ensure_minimum_size(m_data, m_size);
+
+#ifndef NDEBUG
+            const int decompressed_bytes =
+#endif
+                LZ4_decompress_safe(
+                    reinterpret_cast<const char*>(&m_compressed_data[0]),
+                    reinterpret_cast<char*>(&m_data[0]),
+                    static_cast<int>(m_compressed_size),
+                    static_cast<int>(m_size));
+            assert(decompressed_bytes == static_cast<int>(m_size));
+        }
+
+      private:
+        const std::vector<std::uint8_t>&        m_compressed_data;
+        const size_t                            m_compressed_size;
+        std::vector<std::uint8_t>&              m_data;
+        const size_t                            m_size;
+    };
+
+    // Number of blocks processed in a batch, per thread.
+    const size_t BlocksPerThread = 2;
+}
+
+
+//
+// ParallelLZ4CompressedWriterAdapter class implementation.
+//
+
+ParallelLZ4CompressedWriterAdapter::ParallelLZ4CompressedWriterAdapter(
+    BufferedFile&       file,
+    const size_t        buffer_size,
+    const size_t        thread_count)
+  : CompressedWriterAdapter(file, buffer_size)
+  , m_thread_count(std::max<size_t>(thread_count, 1))
+  , m_blocks(m_thread_count * BlocksPerThread)
+  , m_block_count(0)
+{
+}
+
+ParallelLZ4CompressedWriterAdapter::~ParallelLZ4CompressedWriterAdapter()
+{
+    if (m_buffer_index > 0)
+        flush_buffer();
+
+    if (m_block_count > 0)
+        write_blocks();
+}
+
+void ParallelLZ4CompressedWriterAdapter::flush_buffer()
+{
+    // Make sure we have some data to compress and write.
+    assert(m_buffer_index > 0);
+
+    // Hand the content of the compression buffer over to the next block of the batch.
+    Block& block = m_blocks[m_block_count++];
+    block.m_data.swap(m_buffer);
+    block.m_size = m_buffer_index;
+    m_buffer_index = 0;
+
+    if (m_block_count == m_blocks.size())
+        write_blocks();
+}
+
+void ParallelLZ4CompressedWriterAdapter::write_blocks()
+{
+    assert(m_block_count > 0);
+
+    // Compress all blocks of the batch in parallel.
+    if (m_block_count > 1 && m_thread_count > 1)
+    {
+        // Jobs don't fail, so the job manager has nothing to log.
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, std::min(m_thread_count, m_block_count));
+
+        for (size_t i = 0; i < m_block_count; ++i)
+        {
+            Block& block = m_blocks[i];
+            job_queue.schedule(
+                new CompressLZ4BlockJob(
+                    block.m_data,
+                    block.m_size,
+                    block.m_compressed_data,
+                    block.m_compressed_size));
+        }
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+    }
+    else
+    {
+        for (size_t i = 0; i < m_block_count; ++i)
+        {
+            Block& block = m_blocks[i];
+            CompressLZ4BlockJob(
+                block.m_data,
+                block.m_size,
+                block.m_compressed_data,
+                block.m_compressed_size).execute(0);
+        }
+    }
+
+    // Write blocks in order, using the same layout as LZ4CompressedWriterAdapter.
+    for (size_t i = 0; i < m_block_count; ++i)
+    {
+        const Block& block = m_blocks[i];
+        m_file.write(static_cast<std::uint64_t>(block.m_size));
+        m_file.write(static_cast<std::uint64_t>(block.m_compressed_size));
+        m_file.write(&block.m_compressed_data[0], block.m_compressed_size);
+    }
+
+    m_block_count = 0;
+}
+
+
+//
+// ParallelLZ4CompressedReaderAdapter class implementation.
+//
+
+ParallelLZ4CompressedReaderAdapter::ParallelLZ4CompressedReaderAdapter(
+    BufferedFile&       file,
+    const size_t        thread_count)
+  : CompressedReaderAdapter(file)
+  , m_thread_count(std::max<size_t>(thread_count, 1))
+  , m_blocks(m_thread_count * BlocksPerThread)
+  , m_block_count(0)
+  , m_next_block(0)
+{
+}
+
+ParallelLZ4CompressedReaderAdapter::ParallelLZ4CompressedReaderAdapter(
+    ReaderAdapter&      source,
+    const size_t        thread_count)
+  : CompressedReaderAdapter(source)
+  , m_thread_count(std::max<size_t>(thread_count, 1))
+  , m_blocks(m_thread_count * BlocksPerThread)
+  , m_block_count(0)
+  , m_next_block(0)
+{
+}
+
+bool ParallelLZ4CompressedReaderAdapter::fill_buffer()
+{
+    if (m_next_block == m_block_count)
+    {
+        if (!read_blocks())
+            return false;
+    }
+
+    // Hand the content of the next decompressed block over to the buffer.
+    Block& block = m_blocks[m_next_block++];
+    m_buffer.swap(block.m_data);
+
+    m_buffer_index = 0;
+    m_buffer_end = block.m_size;
+
+    return true;
+}
+
+bool ParallelLZ4CompressedReaderAdapter::read_blocks()
+{
+    m_block_count = 0;
+    m_next_block = 0;
+
+    // Read the compressed data of a batch of blocks.
+    while (m_block_count < m_blocks.size())
+    {
+        Block& block = m_blocks[m_block_count];
+
+        // Read uncompressed size.
+        if (read_uint64(m_source, block.m_size) == 0)
+            break;
+
+        // Read compressed size.
+        read_uint64(m_source, block.m_compressed_size);
+
+        // Read compressed data.
+        ensure_minimum_size(block.m_compressed_data, block.m_compressed_size);
+        m_source.read(&block.m_compressed_data[0], block.m_compressed_size);
+
+        ++m_block_count;
+    }
+
+    if (m_block_count == 0)
+        return false;
+
+    // Decompress all blocks of the batch in parallel.
+    if (m_block_count > 1 && m_thread_count > 1)
+    {
+        // Jobs don't fail, so the job manager has nothing to log.
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, std::min(m_thread_count, m_block_count));
+
+        for (size_t i = 0; i < m_block_count; ++i)
+        {
+            Block& block = m_blocks[i];
+            job_queue.schedule(
+                new DecompressLZ4BlockJob(
+                    block.m_compressed_data,
+                    block.m_compressed_size,
+                    block.m_data,
+                    block.m_size));
+        }
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+    }
+    else
+    {
+        for (size_t i = 0; i < m_block_count; ++i)
+        {
+            Block& block = m_blocks[i];
+            DecompressLZ4BlockJob(
+                block.m_compressed_data,
+                block.m_compressed_size,
+                block.m_data,
+                block.m_size).execute(0);
+        }
+    }
+
+    return true;
+}
+
 }   // namespace foundation
@@ -42,6 +42,8 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -291,8 +293,32 @@ class PassthroughReaderAdapter
 };
 
 
+//
+// Adapter reading from a block of memory, for instance a memory-mapped file.
+//
+
+class MemoryReaderAdapter
+  : public ReaderAdapter
+{
+  public:
+    MemoryReaderAdapter(
+        const void*         data,
+        const size_t        size);
+
+    size_t read(
+        void*               outbuf,
+        const size_t        size) override;
+
+  private:
+    const std::uint8_t*     m_data;
+    const size_t            m_size;
+    size_t                  m_index;
+};
+
+
 //
 // Base classes for adapters providing data compression on top of foundation::BufferedFile.
+// Reader adapters can also decompress data provided by another reader adapter.
 //
 
 class CompressedWriterAdapter
@@ -323,16 +349,18 @@ class CompressedReaderAdapter
 {
   public:
     explicit CompressedReaderAdapter(BufferedFile& file);
+    explicit CompressedReaderAdapter(ReaderAdapter& source);
 
     size_t read(
         void*                   outbuf,
         const size_t            size) override;
 
   protected:
-    BufferedFile&               m_file;
-    size_t                      m_buffer_index;
-    size_t                      m_buffer_end;
-    std::vector<std::uint8_t>   m_buffer;
+    std::unique_ptr<ReaderAdapter>  m_file_adapter;
+    ReaderAdapter&                  m_source;
+    size_t                          m_buffer_index;
+    size_t                          m_buffer_end;
+    std::vector<std::uint8_t>       m_buffer;
 
     virtual bool fill_buffer() = 0;
 };
@@ -365,6 +393,7 @@ class LZ4CompressedReaderAdapter
 {
   public:
     explicit LZ4CompressedReaderAdapter(BufferedFile& file);
+    explicit LZ4CompressedReaderAdapter(ReaderAdapter& source);
 
   private:
     std::vector<std::uint8_t>   m_compressed_buffer;
@@ -373,6 +402,74 @@ class LZ4CompressedReaderAdapter
 };
 
 
+//
+// Multithreaded LZ4 compression adapters.
+//
+// These adapters read and write the same stream of independently compressed
+// blocks as the adapters above, so files written by one can be read by the other.
+// Blocks are processed in batches: a batch of blocks is compressed (or read then
+// decompressed) in parallel, then written (or consumed) in order.
+//
+
+class ParallelLZ4CompressedWriterAdapter
+  : public CompressedWriterAdapter
+{
+  public:
+    ParallelLZ4CompressedWriterAdapter(
+        BufferedFile&           file,
+        const size_t            buffer_size,                // compression buffer size, in bytes
+        const size_t            thread_count);
+
+    ~ParallelLZ4CompressedWriterAdapter() override;
+
+  private:
+    struct Block
+    {
+        std::vector<std::uint8_t>   m_data;
+        size_t                      m_size;
+        std::vector<std::uint8_t>   m_compressed_data;
+        size_t                      m_compressed_size;
+    };
+
+    const size_t                m_thread_count;
+    std::vector<Block>          m_blocks;
+    size_t                      m_block_count;
+
+    void flush_buffer() override;
+    void write_blocks();
+};
+
+class ParallelLZ4CompressedReaderAdapter
+  : public CompressedReaderAdapter
+{
+  public:
+    ParallelLZ4CompressedReaderAdapter(
+        BufferedFile&           file,
+        const size_t            thread_count);
+
+    ParallelLZ4CompressedReaderAdapter(
+        ReaderAdapter&          source,
+        const size_t            thread_count);
+
+  private:
+    struct Block
+    {
+        std::vector<std::uint8_t>   m_data;
+        size_t                      m_size;
+        std::vector<std::uint8_t>   m_compressed_data;
+        size_t                      m_compressed_size;
+    };
+
+    const size_t                m_thread_count;
+    std::vector<Block>          m_blocks;
+    size_t                      m_block_count;
+    size_t                      m_next_block;
+
+    bool fill_buffer() override;
+    bool read_blocks();
+};
+
+
 //
 // BufferedFile class implementation.
 //
@@ -573,4 +670,31 @@ inline size_t PassthroughReaderAdapter::read(
     return m_file.read(outbuf, size);
 }
 
+
+//
+// MemoryReaderAdapter class implementation.
+//
+
+inline MemoryReaderAdapter::MemoryReaderAdapter(
+    const void*         data,
+    const size_t        size)
+  : m_data(static_cast<const std::uint8_t*>(data))
+  , m_size(size)
+  , m_index(0)
+{
+}
+
+inline size_t MemoryReaderAdapter::read(
+    void*               outbuf,
+    const size_t        size)
+{
+    const size_t remaining = m_size - m_index;
+    const size_t copy = size < remaining ? size : remaining;
+
+    std::memcpy(outbuf, m_data + m_index, copy);
+    m_index += copy;
+
+    return copy;
+}
+
 }   // namespace foundation
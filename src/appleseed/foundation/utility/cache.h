@@ -31,23 +31,29 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/hash/hash.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/iterators.h"
 #include "foundation/utility/statistics.h"
 
 // Boost headers.
+#include "boost/atomic/atomic.hpp"
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
 #include "boost/unordered_map.hpp"
 
 // Standard headers.
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <list>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace foundation
 {
@@ -690,6 +696,156 @@ class DualStageCache
 };
 
 
+//
+// Concurrent cache, safe to share between threads.
+//
+// Elements are distributed over a number of stripes according to the hash of their key.
+// Each stripe has its own lock, index and storage, so that threads accessing different
+// stripes never wait on each other. Within a stripe, elements are evicted with the CLOCK
+// algorithm: a cache hit only sets a reference bit instead of reordering a queue, which
+// keeps the locked section of lookups very short, and eviction approximates LRU.
+//
+// References returned by get() remain valid until the element is unloaded. Since other
+// threads may trigger evictions at any time, the element swapper should mark elements
+// as in use in acquire() and refuse to unload them while they are.
+//
+// The element swapper is shared by all stripes and must be thread-safe. It must conform
+// to the following prototype:
+//
+//      class ElementSwapper
+//        : public foundation::NonCopyable
+//      {
+//        public:
+//          // Load a cache line.
+//          void load(const Key key, Element& element);
+//
+//          // Unload a cache line. Return true if unloading succeeded,
+//          // false if the element could not be unloaded.
+//          bool unload(const Key key, Element& element);
+//
+//          // Called with the lock of the element's stripe held, each
+//          // time the element is returned by get().
+//          void acquire(const Key key, Element& element);
+//
+//          // Return true if the cache is full, false otherwise.
+//          // 'element_count' is the number of elements in the whole cache.
+//          bool is_full(const size_t element_count);
+//      };
+//
+
+template <
+    typename    Key,
+    typename    KeyHasher,
+    typename    Element,
+    typename    ElementSwapper,
+    size_t      Stripes_ = 16
+>
+class ConcurrentCache
+  : public NonCopyable
+{
+  public:
+    // Types.
+    typedef Key             KeyType;
+    typedef KeyHasher       KeyHasherType;
+    typedef Element         ElementType;
+    typedef ElementSwapper  ElementSwapperType;
+
+    // Stripe count.
+    static const size_t Stripes = Stripes_;
+
+    // Constructor.
+    ConcurrentCache(
+        KeyHasherType&      key_hasher,
+        ElementSwapperType& element_swapper);
+
+    // Destructor.
+    ~ConcurrentCache();
+
+    // Clear the cache.
+    void clear();
+
+    // Get an element from the cache.
+    ElementType& get(const KeyType& key);
+
+    // Return the size (in bytes) of this object in memory.
+    size_t get_memory_size() const;
+
+    // Reset the cache performance statistics.
+    void clear_statistics();
+
+    // Return the number of cache hits/misses.
+    std::uint64_t get_hit_count() const;
+    std::uint64_t get_miss_count() const;
+
+    // Return the number of times a thread had to wait for the lock of a stripe.
+    std::uint64_t get_contention_count() const;
+
+    // Check the integrity of the cache. For debug purposes only.
+    template <typename IntegrityChecker>
+    void check_integrity(IntegrityChecker& checker) const;
+
+  private:
+    // Cache slot.
+    struct Slot
+    {
+        KeyType             m_key;
+        ElementType         m_element;
+        bool                m_used;
+        bool                m_referenced;
+
+        Slot()
+          : m_used(false)
+          , m_referenced(false)
+        {
+        }
+    };
+
+    // Slots are stored in a deque so that growing a stripe never moves elements.
+    typedef std::deque<Slot> SlotDeque;
+
+    // Index: given a key, find the index of the slot holding the element.
+    typedef boost::unordered_map<KeyType, size_t, KeyHasherType> Index;
+
+    struct Stripe
+      : public NonCopyable
+    {
+        mutable boost::mutex    m_mutex;
+        Index                   m_index;
+        SlotDeque               m_slots;
+        std::vector<size_t>     m_free_slots;
+        size_t                  m_clock_hand;
+        std::uint64_t           m_hit_count;
+        std::uint64_t           m_miss_count;
+        std::uint64_t           m_contention_count;
+
+        explicit Stripe(KeyHasherType& key_hasher)
+          : m_index(4, key_hasher)
+          , m_clock_hand(0)
+          , m_hit_count(0)
+          , m_miss_count(0)
+          , m_contention_count(0)
+        {
+        }
+    };
+
+    KeyHasherType&          m_key_hasher;
+    ElementSwapperType&     m_element_swapper;
+    boost::atomic<size_t>   m_element_count;
+    std::unique_ptr<Stripe> m_stripes[Stripes];
+
+    // Return the stripe that holds a given key.
+    Stripe& get_stripe(const KeyType& key) const
+    {
+        // Rehash the key so that stripes and the buckets of their index use different bits.
+        const std::uint64_t h = hash_uint64(static_cast<std::uint64_t>(m_key_hasher(key)));
+        return *m_stripes[h % Stripes];
+    }
+
+    // Evict elements from a stripe until the cache is no longer full, sparing a given slot.
+    void evict(Stripe& stripe, const size_t spared_slot_index);
+};
+
+
 //
 // Utility functions to query and format cache statistics.
 //
@@ -1087,6 +1243,269 @@ check_integrity(IntegrityChecker& checker) const
 #undef FOUNDATION_DSCACHE_TEMPLATE_DEF
 
 
+//
+// ConcurrentCache class implementation.
+//
+
+#define FOUNDATION_CONCURRENTCACHE_TEMPLATE_DEF(MiddleDecl) \
+    template <                                          \
+        typename    Key,                                \
+        typename    KeyHasher,                          \
+        typename    Element,                            \
+        typename    ElementSwapper,                     \
+        size_t      Stripes_                            \
+    >                                                   \
+    MiddleDecl                                          \
+    ConcurrentCache<                                    \
+        Key,                                            \
+        KeyHasher,                                      \
+        Element,                                        \
+        ElementSwapper,                                 \
+        Stripes_                                        \
+    >::
+
+FOUNDATION_CONCURRENTCACHE_TEMPLATE_DEF(APPLESEED_EMPTY)
+ConcurrentCache(
+    KeyHasherType&      key_hasher,
+    ElementSwapperType& element_swapper)
+  : m_key_hasher(key_hasher)
+  , m_element_swapper(element_swapper)
+  , m_element_count(0)
+{
+    for (size_t i = 0; i < Stripes; ++i)
+        m_stripes[i].reset(new Stripe(key_hasher));
+}
+
+FOUNDATION_CONCURRENTCACHE_TEMPLATE_DEF(APPLESEED_EMPTY)
+~ConcurrentCache()
+{
+    clear();
+}
+
+FOUNDATION_CONCURRENTCACHE_TEMPLATE_DEF(void)
+clear()
+{
+    for (size_t i = 0; i < Stripes; ++i)
+    {
+        Stripe& stripe = *m_stripes[i];
+        boost::mutex::scoped_lock lock(stripe.m_mutex);
+
+        for (each<SlotDeque> j = stripe.m_slots; j; ++j)
+        {
+            if (j->m_used)
+            {
+#ifndef NDEBUG
+                const bool success =
+#endif
+                m_element_swapper.unload(j->m_key, j->m_element);
+                assert(success);
+            }
+        }
+
+        m_element_count -= stripe.m_index.size();
+
+        stripe.m_index.clear();
+        stripe.m_slots.clear();
+        stripe.m_free_slots.clear();
+        stripe.m_clock_hand = 0;
+    }
+}
+
+FOUNDATION_CONCURRENTCACHE_TEMPLATE_DEF(inline Element&)
+get(const KeyType& key)
+{
+    Stripe& stripe = get_stripe(key);
+
+    boost::mutex::scoped_lock lock(stripe.m_mutex, boost::try_to_lock);
+
+    if (!lock.owns_lock())
+    {
+        lock.lock();
+        ++stripe.m_contention_count;
+    }
+
+    // Search for this key in the index.
+    const typename Index::const_iterator index_it = stripe.m_index.find(key);
+
+    if (index_it != stripe.m_index.end())
+    {
+        // The key was found in the index: cache hit.
+        ++stripe.m_hit_count;
+
+        Slot& slot = stripe.m_slots[index_it->second];
+        slot.m_referenced = true;
+
+        m_element_swapper.acquire(slot.m_key, slot.m_element);
+
+        return slot.m_element;
+    }
+
+    // The key was not found in the index: cache miss.
+    ++stripe.m_miss_count;
+
+    // Find a free slot, growing the stripe if necessary.
+    if (stripe.m_free_slots.empty())
+    {
+        stripe.m_free_slots.push_back(stripe.m_slots.size());
+        stripe.m_slots.push_back(Slot());
+    }
+
+    const size_t slot_index = stripe.m_free_slots.back();
+    Slot& slot = stripe.m_slots[slot_index];
+
+    // Load the new element. The slot is only taken once loading succeeded (it might have failed with an exception).
+    m_element_swapper.load(key, slot.m_element);
+    stripe.m_free_slots.pop_back();
+
+    // New elements start without their reference bit so that elements used only once
+    // are evicted before elements that were used again.
+    slot.m_key = key;
+    slot.m_used = true;
+    slot.m_referenced = false;
+
+    // Insert the new element into the index.
+    stripe.m_index[key] = slot_index;
+    ++m_element_count;
+
+    m_element_swapper.acquire(slot.m_key, slot.m_element);
+
+    evict(stripe, slot_index);
+
+    return slot.m_element;
+}
+
+FOUNDATION_CONCURRENTCACHE_TEMPLATE_DEF(size_t)
+get_memory_size() const
+{
+    size_t size = sizeof(*this);
+
+    for (size_t i = 0; i < Stripes; ++i)
+    {
+        const Stripe& stripe = *m_stripes[i];
+        boost::mutex::scoped_lock lock(stripe.m_mutex);
+
+        size +=
+              sizeof(Stripe)
+            + sizeof(typename Index::value_type) * stripe.m_index.size()
+            + sizeof(Slot) * stripe.m_slots.size()
+            + sizeof(size_t) * stripe.m_free_slots.capacity();
+    }
+
+    return size;
+}
+
+FOUNDATION_CONCURRENTCACHE_TEMPLATE_DEF(void)
+clear_statistics()
+{
+    for (size_t i = 0; i < Stripes; ++i)
+    {
+        Stripe& stripe = *m_stripes[i];
+        boost::mutex::scoped_lock lock(stripe.m_mutex);
+
+        stripe.m_hit_count = 0;
+        stripe.m_miss_count = 0;
+        stripe.m_contention_count = 0;
+    }
+}
+
+FOUNDATION_CONCURRENTCACHE_TEMPLATE_DEF(std::uint64_t)
+get_hit_count() const
+{
+    std::uint64_t count = 0;
+
+    for (size_t i = 0; i < Stripes; ++i)
+    {
+        const Stripe& stripe = *m_stripes[i];
+        boost::mutex::scoped_lock lock(stripe.m_mutex);
+        count += stripe.m_hit_count;
+    }
+
+    return count;
+}
+
+FOUNDATION_CONCURRENTCACHE_TEMPLATE_DEF(std::uint64_t)
+get_miss_count() const
+{
+    std::uint64_t count = 0;
+
+    for (size_t i = 0; i < Stripes; ++i)
+    {
+        const Stripe& stripe = *m_stripes[i];
+        boost::mutex::scoped_lock lock(stripe.m_mutex);
+        count += stripe.m_miss_count;
+    }
+
+    return count;
+}
+
+FOUNDATION_CONCURRENTCACHE_TEMPLATE_DEF(std::uint64_t)
+get_contention_count() const
+{
+    std::uint64_t count = 0;
+
+    for (size_t i = 0; i < Stripes; ++i)
+    {
+        const Stripe& stripe = *m_stripes[i];
+        boost::mutex::scoped_lock lock(stripe.m_mutex);
+        count += stripe.m_contention_count;
+    }
+
+    return count;
+}
+
+FOUNDATION_CONCURRENTCACHE_TEMPLATE_DEF(template <typename IntegrityChecker> void)
+check_integrity(IntegrityChecker& checker) const
+{
+    for (size_t i = 0; i < Stripes; ++i)
+    {
+        const Stripe& stripe = *m_stripes[i];
+        boost::mutex::scoped_lock lock(stripe.m_mutex);
+
+        for (const_each<SlotDeque> j = stripe.m_slots; j; ++j)
+        {
+            if (j->m_used)
+                checker(j->m_key, j->m_element);
+        }
+    }
+}
+
+FOUNDATION_CONCURRENTCACHE_TEMPLATE_DEF(void)
+evict(Stripe& stripe, const size_t spared_slot_index)
+{
+    const size_t slot_count = stripe.m_slots.size();
+
+    // The first turn of the clock may only clear reference bits: stop after two turns,
+    // in case the remaining elements cannot be unloaded.
+    for (size_t step = 0; step < 2 * slot_count && m_element_swapper.is_full(m_element_count); ++step)
+    {
+        const size_t slot_index = stripe.m_clock_hand;
+        stripe.m_clock_hand = slot_index + 1 < slot_count ? slot_index + 1 : 0;
+
+        Slot& slot = stripe.m_slots[slot_index];
+
+        if (!slot.m_used || slot_index == spared_slot_index)
+            continue;
+
+        // Give recently used elements a second chance.
+        if (slot.m_referenced)
+        {
+            slot.m_referenced = false;
+            continue;
+        }
+
+        if (m_element_swapper.unload(slot.m_key, slot.m_element))
+        {
+            stripe.m_index.erase(slot.m_key);
+            slot.m_used = false;
+            stripe.m_free_slots.push_back(slot_index);
+            --m_element_count;
+        }
+    }
+}
+
+#undef FOUNDATION_CONCURRENTCACHE_TEMPLATE_DEF
+
+
 //
 // Utility functions implementation.
 //
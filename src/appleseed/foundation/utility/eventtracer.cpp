@@ -0,0 +1,328 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "eventtracer.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/thread.h"
+
+// Boost headers.
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// EventTracer class implementation.
+//
+
+namespace
+{
+    struct Event
+    {
+        const char*     m_category;
+        const char*     m_name;
+        std::uint64_t   m_begin_time;
+        std::uint64_t   m_end_time;
+    };
+
+    // Unique identifier of each tracer, to tell apart tracers allocated at the same address.
+    boost::atomic<std::uint64_t> g_tracer_id(0);
+
+    // Identifier of the tracer owning the thread events cached by the calling thread.
+    APPLESEED_TLS std::uint64_t tls_tracer_id = ~std::uint64_t(0);
+    APPLESEED_TLS void* tls_thread_events = nullptr;
+
+    // Name of the calling thread, set before or after it starts recording events.
+    const size_t MaxThreadNameLength = 64;
+    APPLESEED_TLS char tls_thread_name[MaxThreadNameLength] = { 0 };
+
+    void write_json_string(std::FILE* file, const char* s)
+    {
+        std::fputc('"', file);
+
+        for (; *s; ++s)
+        {
+            const unsigned char c = static_cast<unsigned char>(*s);
+
+            if (c == '"' || c == '\\')
+            {
+                std::fputc('\\', file);
+                std::fputc(c, file);
+            }
+            else if (c < 0x20)
+                std::fprintf(file, "\\u%04x", c);
+            else std::fputc(c, file);
+        }
+
+        std::fputc('"', file);
+    }
+}
+
+struct EventTracer::ThreadEvents
+{
+    boost::thread::id           m_thread_id;
+    size_t                      m_thread_index;
+    std::string                 m_thread_name;
+    std::vector<Event>          m_events;           // ring buffer
+    std::uint64_t               m_recorded_count;   // number of events recorded since last cleared
+    mutable Spinlock            m_lock;
+};
+
+struct EventTracer::Impl
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const std::uint64_t         m_id;
+    const Clock::time_point     m_origin;
+    boost::mutex                m_mutex;
+    size_t                      m_events_per_thread;
+    std::vector<std::unique_ptr<ThreadEvents>> m_threads;
+
+    Impl()
+      : m_id(g_tracer_id++)
+      , m_origin(Clock::now())
+      , m_events_per_thread(DefaultEventsPerThread)
+    {
+    }
+};
+
+EventTracer::EventTracer()
+  : impl(new Impl())
+  , m_enabled(false)
+{
+}
+
+EventTracer::~EventTracer()
+{
+    delete impl;
+}
+
+void EventTracer::set_enabled(const bool enabled)
+{
+    m_enabled.store(enabled, boost::memory_order_relaxed);
+}
+
+void EventTracer::set_events_per_thread(const size_t count)
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+    impl->m_events_per_thread = std::max<size_t>(count, 1);
+}
+
+void EventTracer::set_current_thread_name(const char* name)
+{
+    std::strncpy(tls_thread_name, name, MaxThreadNameLength - 1);
+    tls_thread_name[MaxThreadNameLength - 1] = '\0';
+
+    // Rename the thread if it already recorded events.
+    if (tls_tracer_id == impl->m_id)
+    {
+        ThreadEvents& thread_events = *static_cast<ThreadEvents*>(tls_thread_events);
+        Spinlock::ScopedLock lock(thread_events.m_lock);
+        thread_events.m_thread_name = tls_thread_name;
+    }
+}
+
+std::uint64_t EventTracer::read_time() const
+{
+    return
+        static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                Impl::Clock::now() - impl->m_origin).count());
+}
+
+void EventTracer::record(
+    const char*                 category,
+    const char*                 name,
+    const std::uint64_t         begin_time,
+    const std::uint64_t         end_time)
+{
+    ThreadEvents& thread_events = get_thread_events();
+
+    Event event;
+    event.m_category = category;
+    event.m_name = name;
+    event.m_begin_time = begin_time;
+    event.m_end_time = end_time;
+
+    Spinlock::ScopedLock lock(thread_events.m_lock);
+
+    const size_t capacity = thread_events.m_events.size();
+    thread_events.m_events[thread_events.m_recorded_count % capacity] = event;
+    ++thread_events.m_recorded_count;
+}
+
+void EventTracer::clear()
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    for (const auto& thread_events : impl->m_threads)
+    {
+        Spinlock::ScopedLock thread_lock(thread_events->m_lock);
+        thread_events->m_recorded_count = 0;
+    }
+}
+
+size_t EventTracer::get_event_count() const
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    size_t count = 0;
+
+    for (const auto& thread_events : impl->m_threads)
+    {
+        Spinlock::ScopedLock thread_lock(thread_events->m_lock);
+        count +=
+            static_cast<size_t>(
+                std::min<std::uint64_t>(
+                    thread_events->m_recorded_count,
+                    thread_events->m_events.size()));
+    }
+
+    return count;
+}
+
+bool EventTracer::write_chrome_trace(const char* filepath) const
+{
+    std::FILE* file = std::fopen(filepath, "wt");
+
+    if (file == nullptr)
+        return false;
+
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    std::fprintf(file, "{\"traceEvents\":[\n");
+
+    bool first = true;
+
+    for (const auto& thread_events : impl->m_threads)
+    {
+        Spinlock::ScopedLock thread_lock(thread_events->m_lock);
+
+        const unsigned long tid = static_cast<unsigned long>(thread_events->m_thread_index);
+
+        if (!thread_events->m_thread_name.empty())
+        {
+            std::fprintf(
+                file,
+                "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":",
+                first ? "" : ",\n",
+                tid);
+            write_json_string(file, thread_events->m_thread_name.c_str());
+            std::fprintf(file, "}}");
+            first = false;
+        }
+
+        // Write retained events from oldest to newest.
+        const std::uint64_t capacity = thread_events->m_events.size();
+        const std::uint64_t recorded = thread_events->m_recorded_count;
+        const std::uint64_t begin = recorded > capacity ? recorded - capacity : 0;
+
+        for (std::uint64_t i = begin; i < recorded; ++i)
+        {
+            const Event& event = thread_events->m_events[i % capacity];
+
+            std::fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+            write_json_string(file, event.m_name);
+            std::fprintf(file, ",\"cat\":");
+            write_json_string(file, event.m_category);
+            std::fprintf(
+                file,
+                ",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":%lu}",
+                static_cast<unsigned long long>(event.m_begin_time),
+                static_cast<unsigned long long>(event.m_end_time - event.m_begin_time),
+                tid);
+            first = false;
+        }
+    }
+
+    std::fprintf(file, "\n]}\n");
+
+    const bool success = std::ferror(file) == 0;
+
+    return std::fclose(file) == 0 && success;
+}
+
+EventTracer::ThreadEvents& EventTracer::get_thread_events()
+{
+    if (tls_tracer_id == impl->m_id)
+        return *static_cast<ThreadEvents*>(tls_thread_events);
+
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    const boost::thread::id thread_id = boost::this_thread::get_id();
+
+    ThreadEvents* thread_events = nullptr;
+
+    for (const auto& e : impl->m_threads)
+    {
+        if (e->m_thread_id == thread_id)
+        {
+            thread_events = e.get();
+            break;
+        }
+    }
+
+    if (thread_events == nullptr)
+    {
+        std::unique_ptr<ThreadEvents> new_thread_events(new ThreadEvents());
+        new_thread_events->m_thread_id = thread_id;
+        new_thread_events->m_thread_index = impl->m_threads.size();
+        new_thread_events->m_thread_name = tls_thread_name;
+        new_thread_events->m_events.resize(impl->m_events_per_thread);
+        new_thread_events->m_recorded_count = 0;
+
+        thread_events = new_thread_events.get();
+        impl->m_threads.push_back(std::move(new_thread_events));
+    }
+
+    tls_tracer_id = impl->m_id;
+    tls_thread_events = thread_events;
+
+    return *thread_events;
+}
+
+EventTracer& global_event_tracer()
+{
+    static EventTracer tracer;
+    return tracer;
+}
+
+}   // namespace foundation
@@ -0,0 +1,177 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+
+namespace foundation
+{
+
+//
+// A low-overhead recorder of timed events, meant to visualize what every thread is doing
+// over the course of a render (e.g. which threads are waiting for tiles, texture loads,
+// tree builds or shader compilations).
+//
+// Each thread records its events into its own fixed-size ring buffer, so only the most
+// recent events of each thread are retained. Tracing is disabled by default, in which
+// case recording an event costs a single atomic load.
+//
+// Event names and categories must be string literals or otherwise outlive the tracer.
+//
+
+class APPLESEED_DLLSYMBOL EventTracer
+  : public NonCopyable
+{
+  public:
+    // Default number of events retained per thread.
+    static const size_t DefaultEventsPerThread = 64 * 1024;
+
+    // Constructor.
+    EventTracer();
+
+    // Destructor.
+    ~EventTracer();
+
+    // Enable or disable event recording. Disabling tracing keeps recorded events.
+    void set_enabled(const bool enabled);
+    bool is_enabled() const;
+
+    // Set the number of events retained per thread. Only affects threads that
+    // haven't recorded any event yet.
+    void set_events_per_thread(const size_t count);
+
+    // Set the name under which the calling thread appears in exported traces.
+    void set_current_thread_name(const char* name);
+
+    // Return the current time in microseconds.
+    std::uint64_t read_time() const;
+
+    // Record an event on the calling thread. Times are in microseconds.
+    void record(
+        const char*             category,
+        const char*             name,
+        const std::uint64_t     begin_time,
+        const std::uint64_t     end_time);
+
+    // Discard all recorded events.
+    void clear();
+
+    // Return the number of events currently retained, across all threads.
+    size_t get_event_count() const;
+
+    // Write all retained events to a file in the Chrome trace event format, which can be
+    // loaded into chrome://tracing or https://ui.perfetto.dev. Return true on success.
+    bool write_chrome_trace(const char* filepath) const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+
+    boost::atomic<bool> m_enabled;
+
+    struct ThreadEvents;
+    ThreadEvents& get_thread_events();
+};
+
+// Return the event tracer shared by the whole library.
+APPLESEED_DLLSYMBOL EventTracer& global_event_tracer();
+
+
+//
+// Record the lifetime of a scope as an event of the global event tracer.
+//
+
+class ScopedTraceEvent
+  : public NonCopyable
+{
+  public:
+    ScopedTraceEvent(const char* category, const char* name);
+    ~ScopedTraceEvent();
+
+  private:
+    const char*     m_category;
+    const char*     m_name;
+    std::uint64_t   m_begin_time;
+};
+
+#define APPLESEED_TRACE_CONCAT_IMPL(a, b) a ## b
+#define APPLESEED_TRACE_CONCAT(a, b) APPLESEED_TRACE_CONCAT_IMPL(a, b)
+
+// Trace the enclosing scope under a given category and name.
+#define APPLESEED_TRACE_SCOPE(category, name) \
+    foundation::ScopedTraceEvent APPLESEED_TRACE_CONCAT(trace_scope_, __LINE__)(category, name)
+
+
+//
+// EventTracer class implementation.
+//
+
+inline bool EventTracer::is_enabled() const
+{
+    return m_enabled.load(boost::memory_order_relaxed);
+}
+
+
+//
+// ScopedTraceEvent class implementation.
+//
+
+inline ScopedTraceEvent::ScopedTraceEvent(const char* category, const char* name)
+  : m_category(category)
+  , m_name(name)
+  , m_begin_time(0)
+{
+    const EventTracer& tracer = global_event_tracer();
+
+    if (tracer.is_enabled())
+        m_begin_time = tracer.read_time();
+    else m_category = nullptr;
+}
+
+inline ScopedTraceEvent::~ScopedTraceEvent()
+{
+    if (m_category != nullptr)
+    {
+        EventTracer& tracer = global_event_tracer();
+        tracer.record(m_category, m_name, m_begin_time, tracer.read_time());
+    }
+}
+
+}   // namespace foundation
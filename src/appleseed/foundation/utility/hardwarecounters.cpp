@@ -0,0 +1,437 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "hardwarecounters.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/thread.h"
+
+// Boost headers.
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+// Platform headers.
+#if defined __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Standard headers.
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// HardwareCounters class implementation.
+//
+
+namespace
+{
+    // Unique identifier of each sampler, to tell apart samplers allocated at the same address.
+    boost::atomic<std::uint64_t> g_sampler_id(0);
+
+    // Identifier of the sampler owning the thread counters cached by the calling thread.
+    APPLESEED_TLS std::uint64_t tls_sampler_id = ~std::uint64_t(0);
+    APPLESEED_TLS void* tls_thread_counters = nullptr;
+
+    // Index of the phase used for phases that don't fit in the phase table.
+    const size_t IgnoredPhase = ~size_t(0);
+
+    struct PhaseCounts
+    {
+        const char*     m_name;
+        std::uint64_t   m_calls;
+        std::uint64_t   m_events[HardwareCounters::EventCount];
+    };
+
+#if defined __linux__
+
+    int open_event(const HardwareCounters::Event event, const int group_fd)
+    {
+        static const std::uint64_t Configs[HardwareCounters::EventCount] =
+        {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = Configs[event];
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        // Count events of the calling thread, on any CPU.
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+    }
+
+#endif
+}
+
+struct HardwareCounters::ThreadCounters
+{
+    boost::thread::id           m_thread_id;
+    bool                        m_available;                    // could the counters be opened?
+    int                         m_fds[EventCount];              // counters, -1 if unavailable, the first one leads the group
+    size_t                      m_slots[EventCount];            // position of each counter in group reads
+    size_t                      m_slot_count;
+    std::uint64_t               m_last_values[EventCount];      // counter values at the last phase boundary
+    PhaseCounts                 m_phases[MaxPhaseCount];
+    size_t                      m_phase_count;
+    size_t                      m_stack[MaxPhaseDepth];         // indices of active phases
+    size_t                      m_depth;                        // may exceed MaxPhaseDepth
+    mutable Spinlock            m_lock;
+
+    ThreadCounters()
+      : m_available(false)
+      , m_slot_count(0)
+      , m_phase_count(0)
+      , m_depth(0)
+    {
+        for (size_t i = 0; i < EventCount; ++i)
+        {
+            m_fds[i] = -1;
+            m_slots[i] = 0;
+            m_last_values[i] = 0;
+        }
+
+        open();
+    }
+
+    ~ThreadCounters()
+    {
+#if defined __linux__
+        // Close group members before the group leader.
+        for (size_t i = EventCount; i > 0; --i)
+        {
+            if (m_fds[i - 1] != -1)
+                close(m_fds[i - 1]);
+        }
+#endif
+    }
+
+    void open()
+    {
+#if defined __linux__
+        int group_fd = -1;
+
+        for (size_t i = 0; i < EventCount; ++i)
+        {
+            m_fds[i] = open_event(static_cast<Event>(i), group_fd);
+
+            if (m_fds[i] == -1)
+            {
+                // Without a group leader, no other counter can be opened.
+                if (group_fd == -1)
+                    return;
+
+                continue;
+            }
+
+            if (group_fd == -1)
+                group_fd = m_fds[i];
+
+            m_slots[i] = m_slot_count++;
+        }
+
+        m_available = true;
+#endif
+    }
+
+    void read(std::uint64_t values[EventCount]) const
+    {
+        for (size_t i = 0; i < EventCount; ++i)
+            values[i] = 0;
+
+#if defined __linux__
+        if (!m_available)
+            return;
+
+        // Layout of a group read: number of counters followed by their values.
+        std::uint64_t buffer[1 + EventCount];
+        const ssize_t size = ::read(m_fds[0], buffer, sizeof(buffer));
+        if (size < static_cast<ssize_t>(sizeof(std::uint64_t)))
+            return;
+
+        for (size_t i = 0; i < EventCount; ++i)
+        {
+            if (m_fds[i] != -1 && m_slots[i] < buffer[0])
+                values[i] = buffer[1 + m_slots[i]];
+        }
+#endif
+    }
+
+    // Attribute events counted since the last phase boundary to the active phase.
+    void update_active_phase()
+    {
+        std::uint64_t values[EventCount];
+        read(values);
+
+        if (m_depth > 0 && m_depth <= MaxPhaseDepth)
+        {
+            const size_t phase = m_stack[m_depth - 1];
+
+            if (phase != IgnoredPhase)
+            {
+                for (size_t i = 0; i < EventCount; ++i)
+                    m_phases[phase].m_events[i] += values[i] - m_last_values[i];
+            }
+        }
+
+        for (size_t i = 0; i < EventCount; ++i)
+            m_last_values[i] = values[i];
+    }
+
+    size_t find_or_insert_phase(const char* name)
+    {
+        for (size_t i = 0; i < m_phase_count; ++i)
+        {
+            if (m_phases[i].m_name == name || std::strcmp(m_phases[i].m_name, name) == 0)
+                return i;
+        }
+
+        if (m_phase_count == MaxPhaseCount)
+            return IgnoredPhase;
+
+        PhaseCounts& phase = m_phases[m_phase_count];
+        phase.m_name = name;
+        phase.m_calls = 0;
+        for (size_t i = 0; i < EventCount; ++i)
+            phase.m_events[i] = 0;
+
+        return m_phase_count++;
+    }
+};
+
+struct HardwareCounters::Impl
+{
+    const std::uint64_t         m_id;
+    boost::mutex                m_mutex;
+    std::vector<std::unique_ptr<ThreadCounters>> m_threads;
+
+    Impl()
+      : m_id(g_sampler_id++)
+    {
+    }
+};
+
+HardwareCounters::HardwareCounters()
+  : impl(new Impl())
+  , m_enabled(false)
+{
+}
+
+HardwareCounters::~HardwareCounters()
+{
+    delete impl;
+}
+
+bool HardwareCounters::is_supported()
+{
+#if defined __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+void HardwareCounters::set_enabled(const bool enabled)
+{
+    m_enabled.store(enabled, boost::memory_order_relaxed);
+}
+
+void HardwareCounters::enter_phase(const char* name)
+{
+    ThreadCounters& thread_counters = get_thread_counters();
+    Spinlock::ScopedLock lock(thread_counters.m_lock);
+
+    thread_counters.update_active_phase();
+
+    const size_t phase = thread_counters.find_or_insert_phase(name);
+    if (phase != IgnoredPhase)
+        ++thread_counters.m_phases[phase].m_calls;
+
+    if (thread_counters.m_depth < MaxPhaseDepth)
+        thread_counters.m_stack[thread_counters.m_depth] = phase;
+
+    ++thread_counters.m_depth;
+}
+
+void HardwareCounters::leave_phase()
+{
+    ThreadCounters& thread_counters = get_thread_counters();
+    Spinlock::ScopedLock lock(thread_counters.m_lock);
+
+    if (thread_counters.m_depth == 0)
+        return;
+
+    thread_counters.update_active_phase();
+
+    --thread_counters.m_depth;
+}
+
+void HardwareCounters::clear()
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    for (const auto& thread_counters : impl->m_threads)
+    {
+        Spinlock::ScopedLock thread_lock(thread_counters->m_lock);
+
+        for (size_t i = 0; i < thread_counters->m_phase_count; ++i)
+        {
+            PhaseCounts& phase = thread_counters->m_phases[i];
+            phase.m_calls = 0;
+            for (size_t j = 0; j < EventCount; ++j)
+                phase.m_events[j] = 0;
+        }
+    }
+}
+
+StatisticsVector HardwareCounters::get_statistics() const
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    // Merge the counts of all threads, phase by phase.
+    std::vector<PhaseCounts> phases;
+    size_t unavailable_thread_count = 0;
+
+    for (const auto& thread_counters : impl->m_threads)
+    {
+        Spinlock::ScopedLock thread_lock(thread_counters->m_lock);
+
+        if (!thread_counters->m_available)
+            ++unavailable_thread_count;
+
+        for (size_t i = 0; i < thread_counters->m_phase_count; ++i)
+        {
+            const PhaseCounts& thread_phase = thread_counters->m_phases[i];
+
+            PhaseCounts* phase = nullptr;
+            for (PhaseCounts& p : phases)
+            {
+                if (std::strcmp(p.m_name, thread_phase.m_name) == 0)
+                {
+                    phase = &p;
+                    break;
+                }
+            }
+
+            if (phase == nullptr)
+            {
+                phases.push_back(thread_phase);
+                continue;
+            }
+
+            phase->m_calls += thread_phase.m_calls;
+            for (size_t j = 0; j < EventCount; ++j)
+                phase->m_events[j] += thread_phase.m_events[j];
+        }
+    }
+
+    StatisticsVector vec;
+
+    if (unavailable_thread_count > 0)
+    {
+        Statistics stats;
+        stats.insert<std::uint64_t>("threads without counters", unavailable_thread_count);
+        vec.insert("hardware counters", stats);
+    }
+
+    for (const PhaseCounts& phase : phases)
+    {
+        const std::uint64_t cycles = phase.m_events[Cycles];
+        const std::uint64_t instructions = phase.m_events[Instructions];
+
+        Statistics stats;
+        stats.insert<std::uint64_t>("calls", phase.m_calls);
+        stats.insert<std::uint64_t>("cycles", cycles);
+        stats.insert<std::uint64_t>("instructions", instructions);
+        stats.insert("instructions per cycle", cycles > 0 ? static_cast<double>(instructions) / cycles : 0.0);
+        stats.insert<std::uint64_t>("cache misses", phase.m_events[CacheMisses]);
+        stats.insert("cache misses per 1k instr.", instructions > 0 ? 1000.0 * phase.m_events[CacheMisses] / instructions : 0.0);
+        stats.insert<std::uint64_t>("branch mispredictions", phase.m_events[BranchMisses]);
+        vec.insert(std::string(phase.m_name) + " hardware counters", stats);
+    }
+
+    return vec;
+}
+
+HardwareCounters::ThreadCounters& HardwareCounters::get_thread_counters()
+{
+    if (tls_sampler_id == impl->m_id)
+        return *static_cast<ThreadCounters*>(tls_thread_counters);
+
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    const boost::thread::id thread_id = boost::this_thread::get_id();
+
+    ThreadCounters* thread_counters = nullptr;
+
+    for (const auto& e : impl->m_threads)
+    {
+        if (e->m_thread_id == thread_id)
+        {
+            thread_counters = e.get();
+            break;
+        }
+    }
+
+    if (thread_counters == nullptr)
+    {
+        std::unique_ptr<ThreadCounters> new_thread_counters(new ThreadCounters());
+        new_thread_counters->m_thread_id = thread_id;
+
+        thread_counters = new_thread_counters.get();
+        impl->m_threads.push_back(std::move(new_thread_counters));
+    }
+
+    tls_sampler_id = impl->m_id;
+    tls_thread_counters = thread_counters;
+
+    return *thread_counters;
+}
+
+HardwareCounters& global_hardware_counters()
+{
+    static HardwareCounters counters;
+    return counters;
+}
+
+}   // namespace foundation
@@ -0,0 +1,177 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/statistics.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+
+namespace foundation
+{
+
+//
+// Samples hardware performance counters (cycles, instructions, cache misses and branch
+// mispredictions) and attributes them to named phases of the calling thread, such as
+// tree traversal or shading.
+//
+// Counts are exclusive: events counted while a nested phase is active are attributed to
+// the nested phase only. Every phase boundary reads the counters of the calling thread,
+// which costs a system call, so results are meant for comparisons between builds rather
+// than as absolute timings. Sampling is disabled by default, in which case entering a
+// phase costs a single atomic load.
+//
+// Counters are only available on Linux, through perf_event_open(). They may also be
+// unavailable if the kernel restricts access to them (see /proc/sys/kernel/perf_event_paranoid)
+// or when running in a virtual machine.
+//
+// Phase names must be string literals or otherwise outlive the sampler.
+//
+
+class APPLESEED_DLLSYMBOL HardwareCounters
+  : public NonCopyable
+{
+  public:
+    enum Event
+    {
+        Cycles,
+        Instructions,
+        CacheMisses,
+        BranchMisses,
+        EventCount
+    };
+
+    // Maximum number of distinct phases per thread; additional phases are ignored.
+    static const size_t MaxPhaseCount = 16;
+
+    // Maximum nesting depth of phases; deeper phases are ignored.
+    static const size_t MaxPhaseDepth = 32;
+
+    // Constructor.
+    HardwareCounters();
+
+    // Destructor.
+    ~HardwareCounters();
+
+    // Return true if hardware counters are supported on this platform.
+    static bool is_supported();
+
+    // Enable or disable sampling. Disabling sampling keeps accumulated counts.
+    void set_enabled(const bool enabled);
+    bool is_enabled() const;
+
+    // Enter or leave a phase on the calling thread.
+    void enter_phase(const char* name);
+    void leave_phase();
+
+    // Reset all accumulated counts.
+    void clear();
+
+    // Return the counts accumulated by all threads, one set of statistics per phase.
+    StatisticsVector get_statistics() const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+
+    boost::atomic<bool> m_enabled;
+
+    struct ThreadCounters;
+    ThreadCounters& get_thread_counters();
+};
+
+// Return the hardware counters sampler shared by the whole library.
+APPLESEED_DLLSYMBOL HardwareCounters& global_hardware_counters();
+
+
+//
+// Attribute the hardware events of the enclosing scope to a phase of the global sampler.
+//
+
+class ScopedHardwareCountersPhase
+  : public NonCopyable
+{
+  public:
+    explicit ScopedHardwareCountersPhase(const char* name);
+    ~ScopedHardwareCountersPhase();
+
+  private:
+    bool m_active;
+};
+
+#define APPLESEED_HARDWARE_COUNTERS_CONCAT_IMPL(a, b) a ## b
+#define APPLESEED_HARDWARE_COUNTERS_CONCAT(a, b) APPLESEED_HARDWARE_COUNTERS_CONCAT_IMPL(a, b)
+
+// Attribute the hardware events of the enclosing scope to a given phase.
+#define APPLESEED_HARDWARE_COUNTERS_SCOPE(name) \
+    foundation::ScopedHardwareCountersPhase APPLESEED_HARDWARE_COUNTERS_CONCAT(hardware_counters_scope_, __LINE__)(name)
+
+
+//
+// HardwareCounters class implementation.
+//
+
+inline bool HardwareCounters::is_enabled() const
+{
+    return m_enabled.load(boost::memory_order_relaxed);
+}
+
+
+//
+// ScopedHardwareCountersPhase class implementation.
+//
+
+inline ScopedHardwareCountersPhase::ScopedHardwareCountersPhase(const char* name)
+  : m_active(false)
+{
+    HardwareCounters& counters = global_hardware_counters();
+
+    if (counters.is_enabled())
+    {
+        counters.enter_phase(name);
+        m_active = true;
+    }
+}
+
+inline ScopedHardwareCountersPhase::~ScopedHardwareCountersPhase()
+{
+    if (m_active)
+        global_hardware_counters().leave_phase();
+}
+
+}   // namespace foundation
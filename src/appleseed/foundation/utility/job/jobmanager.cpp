@@ -32,11 +32,13 @@
 
 // appleseed.foundation headers.
 #include "foundation/log/log.h"
+#include "foundation/platform/defaulttimers.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/job/workerthread.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <vector>
 
@@ -56,8 +58,12 @@ struct JobManager::Impl
     Logger&             m_logger;
     JobQueue&           m_job_queue;
     size_t              m_thread_count;
+    size_t              m_active_thread_count;
     const int           m_flags;
+    bool                m_paused;
     WorkerThreads       m_worker_threads;
+    JobTimingCounters   m_timing_counters;
+    double              m_rcp_timer_frequency;
 
     // Constructor.
     Impl(
@@ -68,8 +74,23 @@ struct JobManager::Impl
       : m_logger(logger)
       , m_job_queue(job_queue)
       , m_thread_count(thread_count)
+      , m_active_thread_count(thread_count)
       , m_flags(flags)
+      , m_paused(false)
     {
+        DefaultWallclockTimer timer;
+        m_rcp_timer_frequency = 1.0 / timer.frequency();
+    }
+
+    // Park worker threads beyond the active thread count and resume the other ones.
+    void update_worker_threads()
+    {
+        for (size_t i = 0, e = m_worker_threads.size(); i < e; ++i)
+        {
+            if (m_paused || i >= m_active_thread_count)
+                m_worker_threads[i]->pause();
+            else m_worker_threads[i]->resume();
+        }
     }
 };
 
@@ -109,13 +130,17 @@ void JobManager::start()
                     i,
                     impl->m_logger,
                     impl->m_job_queue,
-                    impl->m_flags));
+                    impl->m_flags,
+                    &impl->m_timing_counters));
         }
     }
 
     // Start worker threads.
     for (each<Impl::WorkerThreads> i = impl->m_worker_threads; i; ++i)
         (*i)->start();
+
+    // Park worker threads beyond the active thread count.
+    impl->update_worker_threads();
 }
 
 void JobManager::stop()
@@ -124,18 +149,42 @@ void JobManager::stop()
     for (each<Impl::WorkerThreads> i = impl->m_worker_threads; i; ++i)
         delete *i;
     impl->m_worker_threads.clear();
+    impl->m_paused = false;
 }
 
 void JobManager::pause()
 {
-    for (each<Impl::WorkerThreads> i = impl->m_worker_threads; i; ++i)
-        (*i)->pause();
+    impl->m_paused = true;
+    impl->update_worker_threads();
 }
 
 void JobManager::resume()
 {
-    for (each<Impl::WorkerThreads> i = impl->m_worker_threads; i; ++i)
-        (*i)->resume();
+    impl->m_paused = false;
+    impl->update_worker_threads();
+}
+
+void JobManager::set_active_thread_count(const size_t thread_count)
+{
+    impl->m_active_thread_count =
+        thread_count > 0
+            ? std::min(thread_count, impl->m_thread_count)
+            : impl->m_thread_count;
+    impl->update_worker_threads();
+}
+
+size_t JobManager::get_active_thread_count() const
+{
+    return impl->m_active_thread_count;
+}
+
+JobManager::Timings JobManager::get_timings() const
+{
+    Timings timings;
+    timings.m_job_count = impl->m_timing_counters.m_job_count.load(boost::memory_order_relaxed);
+    timings.m_job_time = impl->m_timing_counters.m_job_ticks.load(boost::memory_order_relaxed) * impl->m_rcp_timer_frequency;
+    timings.m_wait_time = impl->m_timing_counters.m_wait_ticks.load(boost::memory_order_relaxed) * impl->m_rcp_timer_frequency;
+    return timings;
 }
 
 }   // namespace foundation
@@ -37,6 +37,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 
 // Forward declarations.
 namespace foundation    { class JobQueue; }
@@ -58,7 +59,18 @@ class APPLESEED_DLLSYMBOL JobManager
     enum Flags
     {
         KeepRunningOnEmptyQueue = 1UL << 0,     // the worker thread keeps running even if the job queue is empty
-        KeepRunningOnJobFailure = 1UL << 1      // the worker thread keeps executing jobs from the work queue even if one or more jobs failed
+        KeepRunningOnJobFailure = 1UL << 1,     // the worker thread keeps executing jobs from the work queue even if one or more jobs failed
+        PinThreadsToCPUCores    = 1UL << 2,     // worker thread i only runs on logical CPU core i (modulo the number of cores)
+        PinThreadsToNUMANodes   = 1UL << 3,     // worker threads are distributed round-robin across NUMA nodes and only run on their node
+        CollectTimings          = 1UL << 4      // worker threads measure how long jobs run and wait in the job queue, see get_timings()
+    };
+
+    // Job timings accumulated by the worker threads.
+    struct Timings
+    {
+        std::uint64_t   m_job_count = 0;        // number of executed jobs
+        double          m_job_time = 0.0;       // total time spent executing jobs, in seconds
+        double          m_wait_time = 0.0;      // total time spent waiting for these jobs in the job queue, in seconds
     };
 
     // Constructor.
@@ -74,6 +86,16 @@ class APPLESEED_DLLSYMBOL JobManager
     // Return the number of worker threads.
     size_t get_thread_count() const;
 
+    // Set the number of worker threads allowed to execute jobs, at most the number of worker
+    // threads; 0 allows all worker threads. Worker threads beyond that count are parked once
+    // their current job is completed and resume when the count grows again. Thread indices
+    // never change, so jobs relying on per-thread data remain valid. Not thread-safe with
+    // respect to start(), stop(), pause() and resume().
+    void set_active_thread_count(const size_t thread_count);
+
+    // Return the number of worker threads allowed to execute jobs.
+    size_t get_active_thread_count() const;
+
     // Start job execution. Returns immediately.
     void start();
 
@@ -87,9 +109,36 @@ class APPLESEED_DLLSYMBOL JobManager
     // Resume job execution.
     void resume();
 
+    // Return the job timings accumulated since the job manager was constructed, or zero timings
+    // if the CollectTimings flag is not set. Contrary to the other methods, this method can be
+    // called from any thread, including while jobs are running. Waits are only counted when jobs
+    // were already scheduled, so that time spent idling on an empty job queue is excluded.
+    Timings get_timings() const;
+
   private:
     struct Impl;
     Impl* impl;
 };
 
+// Return the timings accumulated between two calls to JobManager::get_timings().
+JobManager::Timings operator-(
+    const JobManager::Timings&  lhs,
+    const JobManager::Timings&  rhs);
+
+
+//
+// JobManager::Timings class implementation.
+//
+
+inline JobManager::Timings operator-(
+    const JobManager::Timings&  lhs,
+    const JobManager::Timings&  rhs)
+{
+    JobManager::Timings result;
+    result.m_job_count = lhs.m_job_count - rhs.m_job_count;
+    result.m_job_time = lhs.m_job_time - rhs.m_job_time;
+    result.m_wait_time = lhs.m_wait_time - rhs.m_wait_time;
+    return result;
+}
+
 }   // namespace foundation
@@ -31,17 +31,24 @@
 #include "jobqueue.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/rng/xorshift32.h"
+#include "foundation/platform/compiler.h"
 #include "foundation/platform/thread.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/iterators.h"
 #include "foundation/utility/job/abortswitch.h"
 #include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/workstealingdeque.h"
 
 // Boost headers.
+#include "boost/atomic/atomic.hpp"
 #include "boost/thread/condition_variable.hpp"
 
 // Standard headers.
 #include <cassert>
+#include <cstdint>
+#include <deque>
+#include <iterator>
 
 namespace foundation
 {
@@ -50,13 +57,120 @@ namespace foundation
 // JobQueue class implementation.
 //
 
+namespace
+{
+    // Maximum number of worker threads that can be attached to a work stealing queue.
+    // Additional worker threads still execute jobs but don't own a deque.
+    const size_t MaxWorkerCount = 1024;
+
+    // Number of unsuccessful attempts at finding a job before a worker thread parks itself.
+    const size_t SpinCountBeforeParking = 64;
+
+    // The ownership flag of a job is stored in the lowest bit of its pointer in the deques.
+    std::uintptr_t pack_job(const IJob* job, const bool owned)
+    {
+        const std::uintptr_t bits = reinterpret_cast<std::uintptr_t>(job);
+        assert((bits & 1) == 0);
+        return bits | (owned ? 1 : 0);
+    }
+
+    IJob* unpack_job(const std::uintptr_t packed)
+    {
+        return reinterpret_cast<IJob*>(packed & ~static_cast<std::uintptr_t>(1));
+    }
+
+    bool unpack_owned(const std::uintptr_t packed)
+    {
+        return (packed & 1) != 0;
+    }
+}
+
 struct JobQueue::Impl
 {
+    //
+    // Centralized scheduling.
+    //
+
     mutable boost::mutex            m_mutex;
     boost::condition_variable_any   m_event;
-    JobList                         m_scheduled_jobs;
+    JobList                         m_scheduled_jobs;           // high priority jobs come first
+    size_t                          m_high_priority_list_count; // number of high priority jobs at the front of m_scheduled_jobs
     JobList                         m_running_jobs;
 
+    //
+    // Work stealing scheduling.
+    //
+
+    struct Worker
+      : public NonCopyable
+    {
+        WorkStealingDeque<std::uintptr_t>   m_deque;
+        Xorshift32                          m_rng;
+        bool                                m_attached;     // protected by Impl::m_workers_mutex
+
+        boost::mutex                        m_park_mutex;
+        boost::condition_variable           m_park_event;
+        boost::atomic<bool>                 m_parked;
+        bool                                m_notified;     // protected by m_park_mutex
+
+        explicit Worker(const size_t index)
+          : m_rng(static_cast<std::uint32_t>(index * 2654435761UL + 1))
+          , m_attached(false)
+          , m_parked(false)
+          , m_notified(false)
+        {
+        }
+    };
+
+    const SchedulingMode            m_scheduling_mode;
+
+    boost::atomic<size_t>           m_scheduled_count;
+    boost::atomic<size_t>           m_running_count;
+
+    // Shared queue for jobs scheduled from threads that are not worker threads of this queue.
+    boost::mutex                    m_shared_mutex;
+    std::deque<std::uintptr_t>      m_shared_jobs;
+    boost::atomic<size_t>           m_shared_job_count;
+
+    // Shared queue for high priority jobs, regardless of the thread that scheduled them.
+    std::deque<std::uintptr_t>      m_high_priority_jobs;       // protected by m_shared_mutex
+    boost::atomic<size_t>           m_high_priority_job_count;
+
+    // Worker slots are never deallocated while the queue is alive so that thieves can safely access them.
+    boost::mutex                    m_workers_mutex;
+    boost::atomic<Worker*>          m_workers[MaxWorkerCount];
+    boost::atomic<size_t>           m_worker_count;
+    boost::atomic<size_t>           m_parked_count;
+
+    // Only used to wake up threads blocked in wait_until_completion().
+    boost::mutex                    m_completion_mutex;
+    boost::condition_variable       m_completion_event;
+
+    // The worker slot owned by the current thread, if any.
+    static APPLESEED_TLS Worker*    s_current_worker;
+    static APPLESEED_TLS Impl*      s_current_owner;
+
+    explicit Impl(const SchedulingMode scheduling_mode)
+      : m_high_priority_list_count(0)
+      , m_scheduling_mode(scheduling_mode)
+      , m_scheduled_count(0)
+      , m_running_count(0)
+      , m_shared_job_count(0)
+      , m_high_priority_job_count(0)
+      , m_worker_count(0)
+      , m_parked_count(0)
+    {
+        for (size_t i = 0; i < MaxWorkerCount; ++i)
+            m_workers[i].store(nullptr, boost::memory_order_relaxed);
+    }
+
+    ~Impl()
+    {
+        const size_t worker_count = m_worker_count.load();
+        for (size_t i = 0; i < worker_count; ++i)
+            delete m_workers[i].load();
+    }
+
     static void delete_jobs(JobList& list)
     {
         for (each<JobList> i = list; i; ++i)
@@ -67,10 +181,240 @@ struct JobQueue::Impl
 
         list.clear();
     }
+
+    Worker* get_current_worker()
+    {
+        return s_current_owner == this ? s_current_worker : nullptr;
+    }
+
+    bool is_idle() const
+    {
+        // Order matters: a job moving from the scheduled to the running state
+        // first increments the running count, then decrements the scheduled count.
+        return m_scheduled_count.load() == 0 && m_running_count.load() == 0;
+    }
+
+    void push_shared_job(const std::uintptr_t packed)
+    {
+        boost::mutex::scoped_lock lock(m_shared_mutex);
+        m_shared_jobs.push_back(packed);
+        ++m_shared_job_count;
+    }
+
+    void push_high_priority_job(const std::uintptr_t packed)
+    {
+        boost::mutex::scoped_lock lock(m_shared_mutex);
+        m_high_priority_jobs.push_back(packed);
+        ++m_high_priority_job_count;
+    }
+
+    bool pop_high_priority_job(std::uintptr_t& packed)
+    {
+        if (m_high_priority_job_count.load(boost::memory_order_relaxed) == 0)
+            return false;
+
+        boost::mutex::scoped_lock lock(m_shared_mutex);
+
+        if (m_high_priority_jobs.empty())
+            return false;
+
+        packed = m_high_priority_jobs.front();
+        m_high_priority_jobs.pop_front();
+        --m_high_priority_job_count;
+
+        return true;
+    }
+
+    bool pop_shared_job(std::uintptr_t& packed)
+    {
+        if (m_shared_job_count.load(boost::memory_order_relaxed) == 0)
+            return false;
+
+        boost::mutex::scoped_lock lock(m_shared_mutex);
+
+        if (m_shared_jobs.empty())
+            return false;
+
+        packed = m_shared_jobs.front();
+        m_shared_jobs.pop_front();
+        --m_shared_job_count;
+
+        return true;
+    }
+
+    bool steal_job(Worker* thief, std::uintptr_t& packed)
+    {
+        const size_t worker_count = m_worker_count.load(boost::memory_order_acquire);
+
+        if (worker_count == 0)
+            return false;
+
+        // Start at a random victim and visit all other workers from there.
+        const size_t start =
+            thief != nullptr ? thief->m_rng.rand_uint32() % worker_count : 0;
+
+        for (size_t i = 0; i < worker_count; ++i)
+        {
+            Worker* victim = m_workers[(start + i) % worker_count].load(boost::memory_order_acquire);
+
+            if (victim == nullptr || victim == thief)
+                continue;
+
+            if (victim->m_deque.steal(packed))
+                return true;
+        }
+
+        return false;
+    }
+
+    // Move a job from the scheduled to the running state.
+    bool try_acquire_job(Worker* worker, std::uintptr_t& packed)
+    {
+        if (m_scheduled_count.load(boost::memory_order_relaxed) == 0)
+            return false;
+
+        const bool found =
+            pop_high_priority_job(packed) ||
+            (worker != nullptr && worker->m_deque.pop(packed)) ||
+            pop_shared_job(packed) ||
+            steal_job(worker, packed);
+
+        if (found)
+        {
+            ++m_running_count;
+            --m_scheduled_count;
+        }
+
+        return found;
+    }
+
+    // Wake up one parked worker thread, if any.
+    void wake_one_worker()
+    {
+        if (m_parked_count.load() == 0)
+            return;
+
+        const size_t worker_count = m_worker_count.load(boost::memory_order_acquire);
+
+        for (size_t i = 0; i < worker_count; ++i)
+        {
+            Worker* worker = m_workers[i].load(boost::memory_order_acquire);
+
+            if (worker == nullptr || !worker->m_parked.load())
+                continue;
+
+            boost::mutex::scoped_lock lock(worker->m_park_mutex);
+
+            if (worker->m_parked.load() && !worker->m_notified)
+            {
+                worker->m_notified = true;
+                worker->m_park_event.notify_one();
+                return;
+            }
+        }
+    }
+
+    // Wake up all parked worker threads.
+    void wake_all_workers()
+    {
+        const size_t worker_count = m_worker_count.load(boost::memory_order_acquire);
+
+        for (size_t i = 0; i < worker_count; ++i)
+        {
+            Worker* worker = m_workers[i].load(boost::memory_order_acquire);
+
+            if (worker == nullptr)
+                continue;
+
+            boost::mutex::scoped_lock lock(worker->m_park_mutex);
+            worker->m_notified = true;
+            worker->m_park_event.notify_one();
+        }
+    }
+
+    // Block the calling worker thread until it is notified or until a job is available.
+    void park_worker(Worker& worker, AbortSwitch& abort_switch)
+    {
+        boost::mutex::scoped_lock lock(worker.m_park_mutex);
+
+        worker.m_notified = false;
+        worker.m_parked.store(true);
+        ++m_parked_count;
+
+        // Check again now that we advertised that we are parked: a thread scheduling
+        // a job either sees us parked and notifies us, or we see the job here.
+        if (m_scheduled_count.load() == 0)
+        {
+            while (!worker.m_notified && !abort_switch.is_aborted())
+                worker.m_park_event.wait(lock);
+        }
+
+        --m_parked_count;
+        worker.m_parked.store(false);
+    }
+
+    // Notify threads blocked in wait_until_completion() if the queue just became idle.
+    void notify_if_idle()
+    {
+        if (is_idle())
+        {
+            boost::mutex::scoped_lock lock(m_completion_mutex);
+            m_completion_event.notify_all();
+        }
+    }
+
+    void delete_job(const std::uintptr_t packed)
+    {
+        if (unpack_owned(packed))
+            delete unpack_job(packed);
+    }
+
+    // Remove and delete all scheduled jobs. Return the number of jobs removed.
+    size_t clear_work_stealing_jobs()
+    {
+        size_t cleared = 0;
+        std::uintptr_t packed;
+
+        while (pop_high_priority_job(packed))
+        {
+            delete_job(packed);
+            ++cleared;
+        }
+
+        while (pop_shared_job(packed))
+        {
+            delete_job(packed);
+            ++cleared;
+        }
+
+        const size_t worker_count = m_worker_count.load(boost::memory_order_acquire);
+
+        for (size_t i = 0; i < worker_count; ++i)
+        {
+            Worker* worker = m_workers[i].load(boost::memory_order_acquire);
+
+            if (worker == nullptr)
+                continue;
+
+            while (!worker->m_deque.empty())
+            {
+                if (worker->m_deque.steal(packed))
+                {
+                    delete_job(packed);
+                    ++cleared;
+                }
+            }
+        }
+
+        return cleared;
+    }
 };
 
-JobQueue::JobQueue()
-  : impl(new Impl())
+APPLESEED_TLS JobQueue::Impl::Worker* JobQueue::Impl::s_current_worker = nullptr;
+APPLESEED_TLS JobQueue::Impl* JobQueue::Impl::s_current_owner = nullptr;
+
+JobQueue::JobQueue(const SchedulingMode scheduling_mode)
+  : impl(new Impl(scheduling_mode))
 {
 }
 
@@ -80,18 +424,33 @@ JobQueue::~JobQueue()
 
     // At this point, no job must be running.
     assert(impl->m_running_jobs.empty());
+    assert(impl->m_running_count.load() == 0);
 
     // Delete all scheduled jobs that the queue owns.
     Impl::delete_jobs(impl->m_scheduled_jobs);
+    impl->clear_work_stealing_jobs();
 
     delete impl;
 }
 
+JobQueue::SchedulingMode JobQueue::get_scheduling_mode() const
+{
+    return impl->m_scheduling_mode;
+}
+
 void JobQueue::clear_scheduled_jobs()
 {
+    if (impl->m_scheduling_mode == WorkStealingScheduling)
+    {
+        impl->m_scheduled_count -= impl->clear_work_stealing_jobs();
+        impl->notify_if_idle();
+        return;
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     impl->delete_jobs(impl->m_scheduled_jobs);
+    impl->m_high_priority_list_count = 0;
 
     // Notify worker threads that all scheduled jobs are gone.
     impl->m_event.notify_all();
@@ -99,6 +458,9 @@ void JobQueue::clear_scheduled_jobs()
 
 bool JobQueue::has_scheduled_jobs() const
 {
+    if (impl->m_scheduling_mode == WorkStealingScheduling)
+        return impl->m_scheduled_count.load() > 0;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return !impl->m_scheduled_jobs.empty();
@@ -106,6 +468,9 @@ bool JobQueue::has_scheduled_jobs() const
 
 bool JobQueue::has_running_jobs() const
 {
+    if (impl->m_scheduling_mode == WorkStealingScheduling)
+        return impl->m_running_count.load() > 0;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return !impl->m_running_jobs.empty();
@@ -113,6 +478,9 @@ bool JobQueue::has_running_jobs() const
 
 bool JobQueue::has_scheduled_or_running_jobs() const
 {
+    if (impl->m_scheduling_mode == WorkStealingScheduling)
+        return !impl->is_idle();
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return !impl->m_scheduled_jobs.empty() || !impl->m_running_jobs.empty();
@@ -120,6 +488,9 @@ bool JobQueue::has_scheduled_or_running_jobs() const
 
 size_t JobQueue::get_scheduled_job_count() const
 {
+    if (impl->m_scheduling_mode == WorkStealingScheduling)
+        return impl->m_scheduled_count.load();
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return impl->m_scheduled_jobs.size();
@@ -127,6 +498,9 @@ size_t JobQueue::get_scheduled_job_count() const
 
 size_t JobQueue::get_running_job_count() const
 {
+    if (impl->m_scheduling_mode == WorkStealingScheduling)
+        return impl->m_running_count.load();
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return impl->m_running_jobs.size();
@@ -134,18 +508,55 @@ size_t JobQueue::get_running_job_count() const
 
 size_t JobQueue::get_total_job_count() const
 {
+    if (impl->m_scheduling_mode == WorkStealingScheduling)
+    {
+        const size_t scheduled_count = impl->m_scheduled_count.load();
+        return scheduled_count + impl->m_running_count.load();
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return impl->m_scheduled_jobs.size() + impl->m_running_jobs.size();
 }
 
-void JobQueue::schedule(IJob* job, const bool transfer_ownership)
+void JobQueue::schedule(
+    IJob*           job,
+    const bool      transfer_ownership,
+    const Priority  priority)
 {
     assert(job);
 
+    if (impl->m_scheduling_mode == WorkStealingScheduling)
+    {
+        const std::uintptr_t packed = pack_job(job, transfer_ownership);
+
+        // Count the job before publishing it so that the queue never appears idle while it holds jobs.
+        ++impl->m_scheduled_count;
+
+        Impl::Worker* worker = impl->get_current_worker();
+        if (priority == HighPriority)
+            impl->push_high_priority_job(packed);
+        else if (worker != nullptr)
+            worker->m_deque.push(packed);
+        else impl->push_shared_job(packed);
+
+        // Wake up a single parked worker thread, if any.
+        impl->wake_one_worker();
+
+        return;
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
-    impl->m_scheduled_jobs.push_back(JobInfo(job, transfer_ownership));
+    if (priority == HighPriority)
+    {
+        // Insert the job after the other high priority jobs.
+        impl->m_scheduled_jobs.insert(
+            std::next(impl->m_scheduled_jobs.begin(), impl->m_high_priority_list_count),
+            JobInfo(job, transfer_ownership));
+        ++impl->m_high_priority_list_count;
+    }
+    else impl->m_scheduled_jobs.push_back(JobInfo(job, transfer_ownership));
 
     // Notify worker threads that a new scheduled job is available.
     impl->m_event.notify_all();
@@ -153,6 +564,17 @@ void JobQueue::schedule(IJob* job, const bool transfer_ownership)
 
 void JobQueue::wait_until_completion()
 {
+    if (impl->m_scheduling_mode == WorkStealingScheduling)
+    {
+        boost::mutex::scoped_lock lock(impl->m_completion_mutex);
+
+        // Wait until there is no more scheduled or running jobs.
+        while (!impl->is_idle())
+            impl->m_completion_event.wait(lock);
+
+        return;
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     // Wait until there is no more scheduled or running jobs.
@@ -162,6 +584,9 @@ void JobQueue::wait_until_completion()
 
 JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job()
 {
+    if (impl->m_scheduling_mode == WorkStealingScheduling)
+        return acquire_scheduled_job_no_lock();
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return acquire_scheduled_job_no_lock();
@@ -169,6 +594,17 @@ JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job()
 
 JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job_no_lock()
 {
+    if (impl->m_scheduling_mode == WorkStealingScheduling)
+    {
+        std::uintptr_t packed;
+
+        if (!impl->try_acquire_job(impl->get_current_worker(), packed))
+            return RunningJobInfo(JobInfo(nullptr, false), JobList::iterator());
+
+        // There is no list of running jobs in this mode.
+        return RunningJobInfo(JobInfo(unpack_job(packed), unpack_owned(packed)), JobList::iterator());
+    }
+
     // Bail out if there is no scheduled job.
     if (impl->m_scheduled_jobs.empty())
         return RunningJobInfo(JobInfo(nullptr, false), impl->m_running_jobs.end());
@@ -176,6 +612,8 @@ JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job_no_lock()
     // Move the next scheduled job to the end of the queue of running jobs.
     const JobInfo job_info = impl->m_scheduled_jobs.front();
     impl->m_scheduled_jobs.pop_front();
+    if (impl->m_high_priority_list_count > 0)
+        --impl->m_high_priority_list_count;
     impl->m_running_jobs.push_back(job_info);
 
     // Notify worker threads that a job has moved from the scheduled to the running state.
@@ -186,6 +624,30 @@ JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job_no_lock()
 
 JobQueue::RunningJobInfo JobQueue::wait_for_scheduled_job(AbortSwitch& abort_switch)
 {
+    if (impl->m_scheduling_mode == WorkStealingScheduling)
+    {
+        Impl::Worker* worker = impl->get_current_worker();
+
+        for (size_t attempt = 0; !abort_switch.is_aborted(); ++attempt)
+        {
+            std::uintptr_t packed;
+
+            if (impl->try_acquire_job(worker, packed))
+                return RunningJobInfo(JobInfo(unpack_job(packed), unpack_owned(packed)), JobList::iterator());
+
+            if (attempt < SpinCountBeforeParking)
+                yield();
+            else if (worker != nullptr)
+            {
+                impl->park_worker(*worker, abort_switch);
+                attempt = 0;
+            }
+            else sleep(1, abort_switch);
+        }
+
+        return RunningJobInfo(JobInfo(nullptr, false), JobList::iterator());
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     // Wait for a scheduled job to be available.
@@ -197,6 +659,20 @@ JobQueue::RunningJobInfo JobQueue::wait_for_scheduled_job(AbortSwitch& abort_swi
 
 void JobQueue::retire_running_job(const RunningJobInfo& running_job_info)
 {
+    if (impl->m_scheduling_mode == WorkStealingScheduling)
+    {
+        // Delete the job.
+        if (running_job_info.first.m_owned)
+            delete running_job_info.first.m_job;
+
+        --impl->m_running_count;
+
+        // Notify threads waiting for completion if this was the last job.
+        impl->notify_if_idle();
+
+        return;
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     // Remove the job from the running list.
@@ -212,9 +688,78 @@ void JobQueue::retire_running_job(const RunningJobInfo& running_job_info)
 
 void JobQueue::signal_event()
 {
+    if (impl->m_scheduling_mode == WorkStealingScheduling)
+    {
+        impl->wake_all_workers();
+        return;
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     impl->m_event.notify_all();
 }
 
+void JobQueue::attach_worker()
+{
+    if (impl->m_scheduling_mode != WorkStealingScheduling)
+        return;
+
+    assert(impl->get_current_worker() == nullptr);
+
+    boost::mutex::scoped_lock lock(impl->m_workers_mutex);
+
+    // Reuse a detached worker slot if there is one.
+    const size_t worker_count = impl->m_worker_count.load();
+    for (size_t i = 0; i < worker_count; ++i)
+    {
+        Impl::Worker* worker = impl->m_workers[i].load();
+
+        if (!worker->m_attached)
+        {
+            worker->m_attached = true;
+            Impl::s_current_worker = worker;
+            Impl::s_current_owner = impl;
+            return;
+        }
+    }
+
+    // Worker threads beyond the maximum count run without a deque of their own.
+    if (worker_count == MaxWorkerCount)
+        return;
+
+    Impl::Worker* worker = new Impl::Worker(worker_count);
+    worker->m_attached = true;
+    impl->m_workers[worker_count].store(worker, boost::memory_order_release);
+    impl->m_worker_count.store(worker_count + 1, boost::memory_order_release);
+
+    Impl::s_current_worker = worker;
+    Impl::s_current_owner = impl;
+}
+
+void JobQueue::detach_worker()
+{
+    Impl::Worker* worker = impl->get_current_worker();
+
+    if (worker == nullptr)
+        return;
+
+    // Hand over the jobs left in our deque to the other threads.
+    std::uintptr_t packed;
+    bool handed_over = false;
+    while (worker->m_deque.pop(packed))
+    {
+        impl->push_shared_job(packed);
+        handed_over = true;
+    }
+
+    if (handed_over)
+        impl->wake_one_worker();
+
+    Impl::s_current_worker = nullptr;
+    Impl::s_current_owner = nullptr;
+
+    boost::mutex::scoped_lock lock(impl->m_workers_mutex);
+    worker->m_attached = false;
+}
+
 }   // namespace foundation
@@ -52,6 +52,10 @@ DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJobWorksOnNon
 DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, RetiringRunningJobWorks);
 DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, RunningJobOwnedByQueueIsDestructedWhenRetired);
 DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, RunningJobNotOwnedByQueueIsNotDestructedWhenRetired);
+DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJob_CentralizedScheduling_ReturnsJobsInOrderOfScheduling);
+DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJob_WorkStealingScheduling_ReturnsJobsInOrderOfScheduling);
+DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJob_CentralizedScheduling_ReturnsHighPriorityJobsFirst);
+DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJob_WorkStealingScheduling_ReturnsHighPriorityJobsFirst);
 
 namespace foundation
 {
@@ -66,17 +70,52 @@ namespace foundation
 //   - scheduled: the job was inserted into the job queue, but hasn't yet been executed
 //   - running: the job is currently being executed
 //
+// Two scheduling modes are available:
+//
+//   - centralized: scheduled jobs are stored in a single list protected by a mutex,
+//     and worker threads wait on a condition variable shared by the whole queue.
+//     Jobs are executed in the order in which they were scheduled.
+//
+//   - work stealing: each worker thread owns a lock-free deque where it pushes the
+//     jobs it schedules itself. Jobs scheduled by other threads go to a shared FIFO
+//     queue. An idle worker thread first pops jobs from its own deque, then from the
+//     shared queue, then steals from the deques of randomly chosen other workers.
+//     Worker threads that run out of work are parked individually and are woken up
+//     one at a time when new jobs are scheduled. Jobs scheduled from outside of
+//     worker threads are still started in the order in which they were scheduled.
+//
+// In both modes, jobs can be scheduled with a high priority. High priority jobs are
+// meant for latency-sensitive work such as the last tiles of a frame: they are kept
+// in their own FIFO queue and are always started before any normal priority job.
+// Running jobs are never interrupted, so high priority jobs preempt bulk work at job
+// boundaries only.
+//
 
 class APPLESEED_DLLSYMBOL JobQueue
   : public NonCopyable
 {
   public:
+    enum SchedulingMode
+    {
+        CentralizedScheduling,
+        WorkStealingScheduling
+    };
+
+    enum Priority
+    {
+        NormalPriority,
+        HighPriority
+    };
+
     // Constructor.
-    JobQueue();
+    explicit JobQueue(const SchedulingMode scheduling_mode = WorkStealingScheduling);
 
     // Destructor. All scheduled jobs are deleted. Not thread-safe.
     ~JobQueue();
 
+    // Return the scheduling mode of this job queue.
+    SchedulingMode get_scheduling_mode() const;
+
     // Delete all scheduled jobs.
     void clear_scheduled_jobs();
 
@@ -100,7 +139,10 @@ class APPLESEED_DLLSYMBOL JobQueue
 
     // Schedule a job for execution. Ownership of the job is transfered
     // to the job queue if and only if transfer_ownership is true.
-    void schedule(IJob* job, const bool transfer_ownership = true);
+    void schedule(
+        IJob*           job,
+        const bool      transfer_ownership = true,
+        const Priority  priority = NormalPriority);
 
     // Wait until all scheduled and running jobs are completed.
     void wait_until_completion();
@@ -116,6 +158,10 @@ class APPLESEED_DLLSYMBOL JobQueue
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Utility_Job_JobQueue, RetiringRunningJobWorks);
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Utility_Job_JobQueue, RunningJobOwnedByQueueIsDestructedWhenRetired);
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Utility_Job_JobQueue, RunningJobNotOwnedByQueueIsNotDestructedWhenRetired);
+    GRANT_ACCESS_TO_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJob_CentralizedScheduling_ReturnsJobsInOrderOfScheduling);
+    GRANT_ACCESS_TO_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJob_WorkStealingScheduling_ReturnsJobsInOrderOfScheduling);
+    GRANT_ACCESS_TO_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJob_CentralizedScheduling_ReturnsHighPriorityJobsFirst);
+    GRANT_ACCESS_TO_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJob_WorkStealingScheduling_ReturnsHighPriorityJobsFirst);
 
     struct JobInfo
     {
@@ -147,6 +193,11 @@ class APPLESEED_DLLSYMBOL JobQueue
 
     // Signal a queue event.
     void signal_event();
+
+    // Register the calling thread as a worker thread of this queue, or unregister it.
+    // Jobs remaining in the worker's deque when it is unregistered are moved to the shared queue.
+    void attach_worker();
+    void detach_worker();
 };
 
 }   // namespace foundation
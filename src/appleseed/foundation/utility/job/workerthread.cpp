@@ -31,11 +31,14 @@
 #include "workerthread.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/defaulttimers.h"
 #include "foundation/platform/snprintf.h"
 #ifdef APPLESEED_USE_SSE42
 #include "foundation/platform/sse.h"
 #endif
+#include "foundation/platform/system.h"
 #include "foundation/platform/types.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/job/ijob.h"
 #include "foundation/utility/job/jobmanager.h"
 #include "foundation/utility/job/jobqueue.h"
@@ -55,14 +58,16 @@ namespace foundation
 //
 
 WorkerThread::WorkerThread(
-    const size_t    index,
-    Logger&         logger,
-    JobQueue&       job_queue,
-    const int       flags)
+    const size_t        index,
+    Logger&             logger,
+    JobQueue&           job_queue,
+    const int           flags,
+    JobTimingCounters*  timing_counters)
   : m_index(index)
   , m_logger(logger)
   , m_job_queue(job_queue)
   , m_flags(flags)
+  , m_timing_counters(timing_counters)
   , m_thread_func(*this)
   , m_thread(nullptr)
 {
@@ -133,12 +138,40 @@ void WorkerThread::set_thread_name()
     char thread_name[16];
     portable_snprintf(thread_name, sizeof(thread_name), "worker_%03lu", (long unsigned int)m_index);
     set_current_thread_name(thread_name);
+    global_event_tracer().set_current_thread_name(thread_name);
+}
+
+void WorkerThread::set_thread_affinity()
+{
+    bool success = true;
+
+    if (m_flags & JobManager::PinThreadsToCPUCores)
+    {
+        const size_t core_count = System::get_logical_cpu_core_count();
+        success = set_current_thread_cpu_core_affinity(m_index % core_count);
+    }
+    else if (m_flags & JobManager::PinThreadsToNUMANodes)
+    {
+        const size_t node_count = System::get_numa_node_count();
+        success = set_current_thread_numa_node_affinity(m_index % node_count);
+    }
+
+    // Only report the failure once rather than once per worker thread.
+    if (!success && m_index == 0)
+    {
+        LOG_WARNING(
+            m_logger,
+            "failed to set the affinity of worker threads, threads will not be pinned.");
+    }
 }
 
 void WorkerThread::run()
 {
     set_thread_name();
 
+    // Pin the thread before anything gets allocated so that its memory is first touched on the right node.
+    set_thread_affinity();
+
 #if defined APPLESEED_WITH_EMBREE && defined APPLESEED_USE_SSE42
 
     //
@@ -158,6 +191,13 @@ void WorkerThread::run()
 
 #endif
 
+    // Let the job queue know about this thread so that it can give it a deque of its own.
+    m_job_queue.attach_worker();
+
+    const bool collect_timings =
+        m_timing_counters != nullptr && (m_flags & JobManager::CollectTimings) != 0;
+    DefaultWallclockTimer timer;
+
     while (!m_abort_switch.is_aborted())
     {
         if (m_pause_flag.is_set())
@@ -168,6 +208,10 @@ void WorkerThread::run()
                 m_pause_event.wait(lock);
         }
 
+        // Only time waits for jobs that are already scheduled, not idling on an empty queue.
+        const bool time_wait = collect_timings && m_job_queue.get_scheduled_job_count() > 0;
+        const std::uint64_t wait_begin = time_wait ? timer.read() : 0;
+
         // Acquire a job.
         const JobQueue::RunningJobInfo running_job_info =
             m_job_queue.wait_for_scheduled_job(m_abort_switch);
@@ -188,8 +232,19 @@ void WorkerThread::run()
         }
 
         // Execute the job.
+        const std::uint64_t job_begin = collect_timings ? timer.read() : 0;
         const bool success = execute_job(*running_job_info.first.m_job);
 
+        // Account for the job before retiring it so that timings are complete once the queue is idle.
+        if (collect_timings)
+        {
+            const std::uint64_t job_end = timer.read();
+            m_timing_counters->m_job_count.fetch_add(1, boost::memory_order_relaxed);
+            m_timing_counters->m_job_ticks.fetch_add(job_end - job_begin, boost::memory_order_relaxed);
+            if (time_wait)
+                m_timing_counters->m_wait_ticks.fetch_add(job_begin - wait_begin, boost::memory_order_relaxed);
+        }
+
         // Retire the job.
         m_job_queue.retire_running_job(running_job_info);
 
@@ -200,6 +255,8 @@ void WorkerThread::run()
             break;
         }
     }
+
+    m_job_queue.detach_worker();
 }
 
 bool WorkerThread::execute_job(IJob& job)
@@ -35,10 +35,12 @@
 #include "foundation/utility/job/abortswitch.h"
 
 // Boost headers.
+#include "boost/atomic/atomic.hpp"
 #include "boost/thread/condition_variable.hpp"
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 
 // Forward declarations.
 namespace boost         { class thread; }
@@ -49,6 +51,26 @@ namespace foundation    { class Logger; }
 namespace foundation
 {
 
+//
+// Job timing counters shared by the worker threads of a job manager.
+//
+
+struct JobTimingCounters
+  : public NonCopyable
+{
+    boost::atomic<std::uint64_t>    m_job_count;
+    boost::atomic<std::uint64_t>    m_job_ticks;
+    boost::atomic<std::uint64_t>    m_wait_ticks;
+
+    JobTimingCounters()
+      : m_job_count(0)
+      , m_job_ticks(0)
+      , m_wait_ticks(0)
+    {
+    }
+};
+
+
 //
 // Worker thread.
 //
@@ -57,12 +79,14 @@ class WorkerThread
   : public NonCopyable
 {
   public:
-    // Constructor.
+    // Constructor. Job timings are only collected if the JobManager::CollectTimings
+    // flag is set and timing counters are provided.
     WorkerThread(
-        const size_t    index,
-        Logger&         logger,
-        JobQueue&       job_queue,
-        const int       flags);     // see foundation::JobManager::Flags
+        const size_t        index,
+        Logger&             logger,
+        JobQueue&           job_queue,
+        const int           flags,                      // see foundation::JobManager::Flags
+        JobTimingCounters*  timing_counters = nullptr);
 
     // Destructor.
     ~WorkerThread();
@@ -101,6 +125,7 @@ class WorkerThread
     Logger&                         m_logger;
     JobQueue&                       m_job_queue;
     const int                       m_flags;
+    JobTimingCounters*              m_timing_counters;
 
     AbortSwitch                     m_abort_switch;
 
@@ -112,6 +137,7 @@ class WorkerThread
     boost::mutex                    m_pause_mutex;
 
     void set_thread_name();
+    void set_thread_affinity();
 
     // Main line of the worker thread.
     void run();
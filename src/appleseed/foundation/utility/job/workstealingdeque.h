@@ -0,0 +1,281 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/scalar.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+#include "boost/atomic/fences.hpp"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// A lock-free, growable, single-owner work-stealing deque.
+//
+// The owner thread pushes and pops items at the bottom of the deque (LIFO order)
+// while any number of other threads may concurrently steal items from the top
+// of the deque (FIFO order).
+//
+// T must be a trivially copyable type small enough for boost::atomic<T> to be
+// lock-free, typically a pointer or an integer.
+//
+// The ring buffer grows when it is full. Retired buffers are kept alive until
+// the deque is destructed since a thief might still be reading from them.
+//
+// References:
+//
+//   Dynamic Circular Work-Stealing Deque
+//   http://www.dre.vanderbilt.edu/~schmidt/PDF/work-stealing-dequeue.pdf
+//
+//   Correct and Efficient Work-Stealing for Weak Memory Models
+//   https://www.di.ens.fr/~zappa/readings/ppopp13.pdf
+//
+
+template <typename T>
+class WorkStealingDeque
+  : public NonCopyable
+{
+  public:
+    // Constructor. The initial capacity must be a power of two.
+    explicit WorkStealingDeque(const size_t initial_capacity = 256);
+
+    // Destructor.
+    ~WorkStealingDeque();
+
+    // Push an item at the bottom of the deque. Only the owner thread may call this method.
+    void push(const T& item);
+
+    // Pop an item from the bottom of the deque. Only the owner thread may call this method.
+    // Return false if the deque is empty.
+    bool pop(T& item);
+
+    // Steal an item from the top of the deque. Can be called from any thread.
+    // Return false if the deque is empty or if another thread won the race for the item.
+    bool steal(T& item);
+
+    // Return an approximation of the number of items in the deque.
+    size_t size() const;
+
+    // Return whether the deque appears to be empty.
+    bool empty() const;
+
+  private:
+    struct Buffer
+    {
+        const std::int64_t          m_capacity;
+        const std::int64_t          m_mask;
+        boost::atomic<T>*           m_items;
+
+        explicit Buffer(const std::int64_t capacity);
+        ~Buffer();
+
+        T get(const std::int64_t index) const;
+        void put(const std::int64_t index, const T& item);
+
+        Buffer* grow(const std::int64_t top, const std::int64_t bottom) const;
+    };
+
+    // Keep top and bottom on separate cache lines to avoid false sharing between the owner and thieves.
+    boost::atomic<std::int64_t>     m_top;
+    char                            m_pad0[64 - sizeof(boost::atomic<std::int64_t>)];
+    boost::atomic<std::int64_t>     m_bottom;
+    char                            m_pad1[64 - sizeof(boost::atomic<std::int64_t>)];
+    boost::atomic<Buffer*>          m_buffer;
+    std::vector<Buffer*>            m_retired_buffers;
+};
+
+
+//
+// WorkStealingDeque class implementation.
+//
+
+template <typename T>
+WorkStealingDeque<T>::Buffer::Buffer(const std::int64_t capacity)
+  : m_capacity(capacity)
+  , m_mask(capacity - 1)
+  , m_items(new boost::atomic<T>[static_cast<size_t>(capacity)])
+{
+    assert(is_pow2(capacity));
+}
+
+template <typename T>
+WorkStealingDeque<T>::Buffer::~Buffer()
+{
+    delete [] m_items;
+}
+
+template <typename T>
+inline T WorkStealingDeque<T>::Buffer::get(const std::int64_t index) const
+{
+    return m_items[index & m_mask].load(boost::memory_order_relaxed);
+}
+
+template <typename T>
+inline void WorkStealingDeque<T>::Buffer::put(const std::int64_t index, const T& item)
+{
+    m_items[index & m_mask].store(item, boost::memory_order_relaxed);
+}
+
+template <typename T>
+typename WorkStealingDeque<T>::Buffer* WorkStealingDeque<T>::Buffer::grow(
+    const std::int64_t          top,
+    const std::int64_t          bottom) const
+{
+    Buffer* buffer = new Buffer(m_capacity * 2);
+
+    for (std::int64_t i = top; i < bottom; ++i)
+        buffer->put(i, get(i));
+
+    return buffer;
+}
+
+template <typename T>
+WorkStealingDeque<T>::WorkStealingDeque(const size_t initial_capacity)
+  : m_top(1)
+  , m_bottom(1)
+  , m_buffer(new Buffer(static_cast<std::int64_t>(initial_capacity)))
+{
+}
+
+template <typename T>
+WorkStealingDeque<T>::~WorkStealingDeque()
+{
+    delete m_buffer.load(boost::memory_order_relaxed);
+
+    for (Buffer* buffer : m_retired_buffers)
+        delete buffer;
+}
+
+template <typename T>
+void WorkStealingDeque<T>::push(const T& item)
+{
+    const std::int64_t bottom = m_bottom.load(boost::memory_order_relaxed);
+    const std::int64_t top = m_top.load(boost::memory_order_acquire);
+    Buffer* buffer = m_buffer.load(boost::memory_order_relaxed);
+
+    // Grow the buffer if it is full.
+    if (bottom - top > buffer->m_capacity - 1)
+    {
+        m_retired_buffers.push_back(buffer);
+        buffer = buffer->grow(top, bottom);
+        m_buffer.store(buffer, boost::memory_order_release);
+    }
+
+    buffer->put(bottom, item);
+
+    boost::atomic_thread_fence(boost::memory_order_release);
+    m_bottom.store(bottom + 1, boost::memory_order_relaxed);
+}
+
+template <typename T>
+bool WorkStealingDeque<T>::pop(T& item)
+{
+    const std::int64_t bottom = m_bottom.load(boost::memory_order_relaxed) - 1;
+    Buffer* buffer = m_buffer.load(boost::memory_order_relaxed);
+    m_bottom.store(bottom, boost::memory_order_relaxed);
+
+    boost::atomic_thread_fence(boost::memory_order_seq_cst);
+
+    std::int64_t top = m_top.load(boost::memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        // The deque was empty.
+        m_bottom.store(bottom + 1, boost::memory_order_relaxed);
+        return false;
+    }
+
+    item = buffer->get(bottom);
+
+    if (top == bottom)
+    {
+        // This was the last item: race against thieves for it.
+        const bool won =
+            m_top.compare_exchange_strong(
+                top,
+                top + 1,
+                boost::memory_order_seq_cst,
+                boost::memory_order_relaxed);
+
+        m_bottom.store(bottom + 1, boost::memory_order_relaxed);
+
+        return won;
+    }
+
+    return true;
+}
+
+template <typename T>
+bool WorkStealingDeque<T>::steal(T& item)
+{
+    std::int64_t top = m_top.load(boost::memory_order_acquire);
+
+    boost::atomic_thread_fence(boost::memory_order_seq_cst);
+
+    const std::int64_t bottom = m_bottom.load(boost::memory_order_acquire);
+
+    if (top >= bottom)
+        return false;
+
+    Buffer* buffer = m_buffer.load(boost::memory_order_acquire);
+    item = buffer->get(top);
+
+    return
+        m_top.compare_exchange_strong(
+            top,
+            top + 1,
+            boost::memory_order_seq_cst,
+            boost::memory_order_relaxed);
+}
+
+template <typename T>
+inline size_t WorkStealingDeque<T>::size() const
+{
+    const std::int64_t bottom = m_bottom.load(boost::memory_order_relaxed);
+    const std::int64_t top = m_top.load(boost::memory_order_relaxed);
+    return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+}
+
+template <typename T>
+inline bool WorkStealingDeque<T>::empty() const
+{
+    return size() == 0;
+}
+
+}   // namespace foundation
@@ -98,6 +98,15 @@ class Lazy
     // Return the source object associated with that lazy object, if any.
     ObjectType* get_source_object() const;
 
+    // Return true if the object has been created by the factory or bound to the source object.
+    bool is_constructed();
+
+    // Delete the object created by the factory if no one is currently accessing it.
+    // The object will be created again the next time it is accessed. This method does
+    // not block: it returns false if the lazy object is busy, if the object is not owned
+    // by the lazy object, if it does not exist yet or if it is currently being accessed.
+    bool try_release_object();
+
   private:
     template <typename> friend class Access;
 
@@ -140,7 +149,7 @@ class Access
     // if any. Note that releasing access to a lazy object does not
     // imply that the object is deleted, even if the reference count
     // on this object has reached 0. An object is deleted only if it
-    // is garbage-collected.
+    // is explicitly released with Lazy::try_release_object().
     void reset(LazyType* lazy);
 
     // Get the object pointer.
@@ -386,6 +395,30 @@ inline typename Lazy<Object>::ObjectType* Lazy<Object>::get_source_object() cons
     return m_source_object;
 }
 
+template <typename Object>
+bool Lazy<Object>::is_constructed()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_object != nullptr;
+}
+
+template <typename Object>
+bool Lazy<Object>::try_release_object()
+{
+    boost::mutex::scoped_try_lock lock(m_mutex);
+
+    if (!lock.owns_lock())
+        return false;
+
+    if (!m_own_object || m_object == nullptr || m_reference_count > 0)
+        return false;
+
+    delete m_object;
+    m_object = nullptr;
+
+    return true;
+}
+
 
 //
 // Access class implementation.
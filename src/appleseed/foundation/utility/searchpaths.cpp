@@ -33,16 +33,23 @@
 // appleseed.foundation headers.
 #include "foundation/string/string.h"
 #include "foundation/utility/foreach.h"
+#include "foundation/utility/virtualfilesystem.h"
 
 // Boost headers.
-#include "boost/filesystem/operations.hpp"
-#include "boost/filesystem/path.hpp"
+#include "boost/filesystem.hpp"
+#include "boost/system/error_code.hpp"
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
 
 // Standard headers.
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <fstream>
 #include <iterator>
+#include <map>
+#include <memory>
+#include <unordered_set>
 #include <vector>
 
 namespace bf = boost::filesystem;
@@ -68,6 +75,132 @@ const char SearchPaths::osl_path_separator()
     return ':';
 }
 
+namespace
+{
+    //
+    // Snapshots of directory listings, used to answer file existence queries in memory.
+    //
+
+    class ResolutionCache
+    {
+      public:
+        bool exists(const bf::path& filepath)
+        {
+            const std::string filename = filepath.filename().string();
+
+            if (filename.empty() || filename == "." || filename == "..")
+                return bf::exists(filepath);
+
+            boost::mutex::scoped_lock lock(m_mutex);
+
+            const Listing& listing = get_listing(filepath.parent_path());
+            return listing.find(normalize_name(filename)) != listing.end();
+        }
+
+        bool save(const char* filepath) const
+        {
+            const std::string temp_filepath = std::string(filepath) + ".tmp";
+
+            {
+                std::ofstream file(temp_filepath.c_str());
+                if (!file.is_open())
+                    return false;
+
+                file << Header << '\n';
+
+                boost::mutex::scoped_lock lock(m_mutex);
+
+                for (const auto& directory : m_listings)
+                {
+                    file << "D\t" << directory.first << '\n';
+
+                    for (const std::string& name : directory.second)
+                        file << "F\t" << name << '\n';
+                }
+
+                if (!file.good())
+                    return false;
+            }
+
+            // Replace the cache file atomically since other processes might be reading it.
+            boost::system::error_code ec;
+            bf::rename(temp_filepath, filepath, ec);
+
+            return !ec;
+        }
+
+        bool load(const char* filepath)
+        {
+            std::ifstream file(filepath);
+            if (!file.is_open())
+                return false;
+
+            std::string line;
+            if (!std::getline(file, line) || line != Header)
+                return false;
+
+            ListingMap listings;
+            Listing* listing = nullptr;
+
+            while (std::getline(file, line))
+            {
+                if (line.size() < 2 || line[1] != '\t')
+                    return false;
+
+                if (line[0] == 'D')
+                    listing = &listings[line.substr(2)];
+                else if (line[0] == 'F' && listing != nullptr)
+                    listing->insert(line.substr(2));
+                else return false;
+            }
+
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_listings.swap(listings);
+
+            return true;
+        }
+
+      private:
+        typedef std::unordered_set<std::string> Listing;
+        typedef std::map<std::string, Listing> ListingMap;
+
+        static const char*  Header;
+
+        mutable boost::mutex    m_mutex;
+        ListingMap              m_listings;     // missing directories have empty listings
+
+        // File systems are case-insensitive on Windows.
+        static std::string normalize_name(const std::string& name)
+        {
+#ifdef _WIN32
+            return lower_case(name);
+#else
+            return name;
+#endif
+        }
+
+        const Listing& get_listing(const bf::path& directory)
+        {
+            const std::string key = directory.string();
+
+            const ListingMap::const_iterator i = m_listings.find(key);
+            if (i != m_listings.end())
+                return i->second;
+
+            Listing& listing = m_listings[key];
+
+            boost::system::error_code ec;
+            for (bf::directory_iterator it(directory.empty() ? bf::path(".") : directory, ec), e;
+                 !ec && it != e; it.increment(ec))
+                listing.insert(normalize_name(it->path().filename().string()));
+
+            return listing;
+        }
+    };
+
+    const char* ResolutionCache::Header = "appleseed search path resolution cache 1";
+}
+
 struct SearchPaths::Impl
 {
     typedef std::vector<std::string> PathCollection;
@@ -76,6 +209,16 @@ struct SearchPaths::Impl
     PathCollection  m_environment_paths;
     PathCollection  m_explicit_paths;
     PathCollection  m_all_paths;    // first all environment paths, then all explicit paths
+
+    std::shared_ptr<ResolutionCache> m_resolution_cache;
+
+    bool file_exists(const bf::path& filepath) const
+    {
+        return
+            m_resolution_cache
+                ? mounted_file_exists(filepath) || m_resolution_cache->exists(filepath)
+                : virtual_file_exists(filepath);
+    }
 };
 
 SearchPaths::SearchPaths()
@@ -214,19 +357,19 @@ bool SearchPaths::exist(const char* filepath) const
             if (has_root_path() && search_path.is_relative())
                 search_path = impl->m_root_path / search_path;
 
-            if (bf::exists(search_path / fp))
+            if (impl->file_exists(search_path / fp))
                 return true;
         }
 
         // Look in the root path if there is one.
         if (has_root_path())
         {
-            if (bf::exists(impl->m_root_path / fp))
+            if (impl->file_exists(impl->m_root_path / fp))
                 return true;
         }
     }
 
-    return bf::exists(fp);
+    return impl->file_exists(fp);
 }
 
 APIString SearchPaths::qualify(const char* filepath) const
@@ -256,7 +399,7 @@ void SearchPaths::qualify(const char* filepath, APIString* qualified_filepath_st
 
             bf::path qualified_fp = search_path / fp;
 
-            if (bf::exists(qualified_fp))
+            if (impl->file_exists(qualified_fp))
             {
                 qualified_fp.make_preferred();
                 *qualified_filepath_str = APIString(qualified_fp.string().c_str());
@@ -271,7 +414,7 @@ void SearchPaths::qualify(const char* filepath, APIString* qualified_filepath_st
         {
             bf::path qualified_fp = impl->m_root_path / fp;
 
-            if (bf::exists(qualified_fp))
+            if (impl->file_exists(qualified_fp))
             {
                 qualified_fp.make_preferred();
                 *qualified_filepath_str = APIString(qualified_fp.string().c_str());
@@ -325,4 +468,35 @@ APIString SearchPaths::do_to_string(const char separator, const bool reversed) c
     return APIString(paths_str.c_str());
 }
 
+void SearchPaths::set_resolution_cache_enabled(const bool enabled)
+{
+    if (enabled)
+    {
+        if (!impl->m_resolution_cache)
+            impl->m_resolution_cache.reset(new ResolutionCache());
+    }
+    else impl->m_resolution_cache.reset();
+}
+
+bool SearchPaths::is_resolution_cache_enabled() const
+{
+    return impl->m_resolution_cache != nullptr;
+}
+
+bool SearchPaths::save_resolution_cache(const char* filepath) const
+{
+    assert(filepath);
+
+    return impl->m_resolution_cache && impl->m_resolution_cache->save(filepath);
+}
+
+bool SearchPaths::load_resolution_cache(const char* filepath)
+{
+    assert(filepath);
+
+    set_resolution_cache_enabled(true);
+
+    return impl->m_resolution_cache->load(filepath);
+}
+
 }   // namespace foundation
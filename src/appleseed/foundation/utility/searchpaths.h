@@ -167,6 +167,31 @@ class APPLESEED_DLLSYMBOL SearchPaths
     APIString to_string(const char separator) const;
     APIString to_string_reversed(const char separator) const;
 
+    //
+    // Resolution cache.
+    //
+    // When enabled, exist() and qualify() look files up in snapshots of directory
+    // listings instead of querying the file system for each candidate path. A
+    // directory is listed the first time it is probed; missing directories are
+    // remembered as well. The cache is shared between copies of this object and
+    // is never invalidated: only enable it while files are not expected to appear
+    // or disappear, e.g. while loading a project.
+    //
+
+    // Enable or disable the resolution cache. Disabling it discards its content.
+    void set_resolution_cache_enabled(const bool enabled);
+
+    // Return true if the resolution cache is enabled.
+    bool is_resolution_cache_enabled() const;
+
+    // Write the directory listings of the resolution cache to disk.
+    // Returns false if the cache is disabled or in case of failure.
+    bool save_resolution_cache(const char* filepath) const;
+
+    // Enable the resolution cache and fill it with directory listings read from disk.
+    // Returns false in case of failure, in which case the content of the cache is unchanged.
+    bool load_resolution_cache(const char* filepath);
+
   protected:
     struct Impl;
     Impl* impl;
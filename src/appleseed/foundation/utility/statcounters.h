@@ -0,0 +1,328 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/math/population.h"
+#include "foundation/platform/compiler.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+
+//
+// Compile-time statistics level.
+//
+// Counters above this level are compiled out entirely: their updates turn into
+// no-ops and they occupy no more than an empty struct. Define APPLESEED_STATS_LEVEL
+// to one of the values below to override the default.
+//
+
+#define APPLESEED_STATS_LEVEL_OFF           0
+#define APPLESEED_STATS_LEVEL_BASIC         1
+#define APPLESEED_STATS_LEVEL_DETAILED      2
+
+#ifndef APPLESEED_STATS_LEVEL
+#define APPLESEED_STATS_LEVEL APPLESEED_STATS_LEVEL_BASIC
+#endif
+
+namespace foundation
+{
+
+enum class StatsLevel
+{
+    Off         = APPLESEED_STATS_LEVEL_OFF,
+    Basic       = APPLESEED_STATS_LEVEL_BASIC,
+    Detailed    = APPLESEED_STATS_LEVEL_DETAILED
+};
+
+// Highest statistics level compiled in.
+constexpr StatsLevel CompiledStatsLevel = static_cast<StatsLevel>(APPLESEED_STATS_LEVEL);
+
+// Set or get the run-time statistics level. The run-time level is clamped to the
+// compile-time level. It is sampled when counters are constructed, so changing it
+// only affects counters created afterward (typically at the start of a render).
+APPLESEED_DLLSYMBOL void set_stats_level(const StatsLevel level);
+APPLESEED_DLLSYMBOL StatsLevel get_stats_level();
+
+// Return true if counters of a given level are both compiled in and enabled at run-time.
+template <StatsLevel Level>
+bool is_stats_level_enabled();
+
+
+namespace impl
+{
+    // Map levels that are not compiled in to StatsLevel::Off.
+    template <StatsLevel Level>
+    struct CompiledLevel
+    {
+        static const StatsLevel Value =
+            Level <= CompiledStatsLevel ? Level : StatsLevel::Off;
+    };
+
+    template <StatsLevel Level> class StatCounter;
+    template <StatsLevel Level, typename T> class StatPopulation;
+}
+
+
+//
+// A statistics counter.
+//
+// Meant to be owned by a single thread: updates are plain, non-atomic increments.
+//
+
+template <StatsLevel Level>
+using StatCounter = impl::StatCounter<impl::CompiledLevel<Level>::Value>;
+
+
+//
+// A statistics population (minimum, maximum, average, deviation).
+//
+
+template <StatsLevel Level, typename T>
+using StatPopulation = impl::StatPopulation<impl::CompiledLevel<Level>::Value, T>;
+
+
+//
+// Storage for a set of per-thread counters, padded to a multiple of the cache line
+// size on both ends so that counters of different threads never share a cache line.
+// Needed because per-thread objects are often allocated back-to-back by the main thread.
+//
+
+template <typename T>
+class CacheLinePadded
+{
+  public:
+    T* operator->();
+    const T* operator->() const;
+
+    T& get();
+    const T& get() const;
+
+  private:
+    enum { MaxCacheLineSize = 128 };
+
+    std::uint8_t    m_pad_before[MaxCacheLineSize];
+    T               m_value;
+    std::uint8_t    m_pad_after[MaxCacheLineSize];
+};
+
+
+//
+// Implementation.
+//
+
+template <StatsLevel Level>
+inline bool is_stats_level_enabled()
+{
+    return
+        Level != StatsLevel::Off &&
+        Level <= CompiledStatsLevel &&
+        Level <= get_stats_level();
+}
+
+namespace impl
+{
+
+template <StatsLevel Level>
+class StatCounter
+{
+  public:
+    // Constructor.
+    StatCounter();
+
+    // Return true if this counter is recording.
+    bool is_enabled() const;
+
+    // Update the counter.
+    void operator++();
+    void operator+=(const std::uint64_t n);
+
+    // Return the value of the counter.
+    std::uint64_t get() const;
+
+    // Reset the counter to zero.
+    void clear();
+
+  private:
+    std::uint64_t   m_value;
+    bool            m_enabled;
+};
+
+// Counters of a level that is not compiled in have no state.
+template <>
+class StatCounter<StatsLevel::Off>
+{
+  public:
+    bool is_enabled() const { return false; }
+    void operator++() {}
+    void operator+=(const std::uint64_t) {}
+    std::uint64_t get() const { return 0; }
+    void clear() {}
+};
+
+template <StatsLevel Level, typename T>
+class StatPopulation
+{
+  public:
+    // Constructor.
+    StatPopulation();
+
+    // Return true if this population is recording.
+    bool is_enabled() const;
+
+    // Insert a new value into the population.
+    void insert(const T& value);
+
+    // Return the underlying population.
+    const Population<T>& get() const;
+
+  private:
+    Population<T>   m_population;
+    bool            m_enabled;
+};
+
+template <typename T>
+class StatPopulation<StatsLevel::Off, T>
+{
+  public:
+    bool is_enabled() const { return false; }
+    void insert(const T&) {}
+    const Population<T>& get() const { static const Population<T> empty; return empty; }
+};
+
+
+//
+// StatCounter class implementation.
+//
+
+template <StatsLevel Level>
+inline StatCounter<Level>::StatCounter()
+  : m_value(0)
+  , m_enabled(is_stats_level_enabled<Level>())
+{
+}
+
+template <StatsLevel Level>
+inline bool StatCounter<Level>::is_enabled() const
+{
+    return m_enabled;
+}
+
+template <StatsLevel Level>
+APPLESEED_FORCE_INLINE void StatCounter<Level>::operator++()
+{
+    if (m_enabled)
+        ++m_value;
+}
+
+template <StatsLevel Level>
+APPLESEED_FORCE_INLINE void StatCounter<Level>::operator+=(const std::uint64_t n)
+{
+    if (m_enabled)
+        m_value += n;
+}
+
+template <StatsLevel Level>
+inline std::uint64_t StatCounter<Level>::get() const
+{
+    return m_value;
+}
+
+template <StatsLevel Level>
+inline void StatCounter<Level>::clear()
+{
+    m_value = 0;
+}
+
+
+//
+// StatPopulation class implementation.
+//
+
+template <StatsLevel Level, typename T>
+inline StatPopulation<Level, T>::StatPopulation()
+  : m_enabled(is_stats_level_enabled<Level>())
+{
+}
+
+template <StatsLevel Level, typename T>
+inline bool StatPopulation<Level, T>::is_enabled() const
+{
+    return m_enabled;
+}
+
+template <StatsLevel Level, typename T>
+APPLESEED_FORCE_INLINE void StatPopulation<Level, T>::insert(const T& value)
+{
+    if (m_enabled)
+        m_population.insert(value);
+}
+
+template <StatsLevel Level, typename T>
+inline const Population<T>& StatPopulation<Level, T>::get() const
+{
+    return m_population;
+}
+
+}   // namespace impl
+
+
+//
+// CacheLinePadded class implementation.
+//
+
+template <typename T>
+inline T* CacheLinePadded<T>::operator->()
+{
+    return &m_value;
+}
+
+template <typename T>
+inline const T* CacheLinePadded<T>::operator->() const
+{
+    return &m_value;
+}
+
+template <typename T>
+inline T& CacheLinePadded<T>::get()
+{
+    return m_value;
+}
+
+template <typename T>
+inline const T& CacheLinePadded<T>::get() const
+{
+    return m_value;
+}
+
+}   // namespace foundation
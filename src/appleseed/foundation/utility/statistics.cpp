@@ -93,6 +93,12 @@ void Statistics::merge(const Statistics& other)
     }
 }
 
+const Statistics::Entry* Statistics::get(const std::string& name) const
+{
+    const EntryIndex::const_iterator it = m_index.find(name);
+    return it != m_index.end() ? it->second : nullptr;
+}
+
 std::string Statistics::to_string(const size_t max_header_length) const
 {
     if (m_entries.empty())
@@ -317,6 +323,17 @@ void StatisticsVector::merge(const NamedStatistics& other)
     m_stats.push_back(other);
 }
 
+const Statistics* StatisticsVector::get(const std::string& name) const
+{
+    for (const_each<NamedStatisticsVector> i = m_stats; i; ++i)
+    {
+        if (i->m_name == name)
+            return &i->m_stats;
+    }
+
+    return nullptr;
+}
+
 std::string StatisticsVector::to_string(const size_t max_header_length) const
 {
     std::stringstream sstr;
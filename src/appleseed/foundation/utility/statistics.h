@@ -244,6 +244,9 @@ class Statistics
 
     void merge(const Statistics& other);
 
+    // Return the entry with a given name, or nullptr if there is no such entry.
+    const Entry* get(const std::string& name) const;
+
     std::string to_string(const size_t max_header_length = 30) const;
 
   private:
@@ -275,6 +278,9 @@ class StatisticsVector
 
     void merge(const StatisticsVector& other);
 
+    // Return the statistics with a given name, or nullptr if there are none.
+    const Statistics* get(const std::string& name) const;
+
     std::string to_string(const size_t max_header_length = 30) const;
 
   private:
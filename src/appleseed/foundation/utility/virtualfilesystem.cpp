@@ -0,0 +1,189 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "virtualfilesystem.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/zip.h"
+
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <memory>
+
+namespace bf = boost::filesystem;
+
+namespace foundation
+{
+
+namespace
+{
+    struct Mount
+    {
+        std::string         m_directory;        // normalized, without trailing separator
+        const ZipArchive*   m_archive;
+    };
+
+    boost::mutex g_mounts_mutex;
+    std::vector<Mount> g_mounts;
+
+    // Make a path absolute and resolve "." and ".." components, without touching the disk.
+    std::string normalize_path(const bf::path& path)
+    {
+        bf::path result;
+
+        for (const bf::path& component : bf::absolute(path))
+        {
+            if (component == ".")
+                continue;
+
+            if (component == "..")
+                result = result.parent_path();
+            else result /= component;
+        }
+
+        return result.generic_string();
+    }
+
+    // Find the mounted archive containing a given file, and the name of the file in this archive.
+    const ZipArchive* find_archive(const bf::path& filepath, std::string& filename)
+    {
+        boost::mutex::scoped_lock lock(g_mounts_mutex);
+
+        if (g_mounts.empty())
+            return nullptr;
+
+        const std::string normalized_filepath = normalize_path(filepath);
+
+        // Search the most recent mounts first.
+        for (auto i = g_mounts.rbegin(), e = g_mounts.rend(); i != e; ++i)
+        {
+            const std::string& directory = i->m_directory;
+
+            if (normalized_filepath.size() > directory.size() + 1 &&
+                normalized_filepath.compare(0, directory.size(), directory) == 0 &&
+                normalized_filepath[directory.size()] == '/')
+            {
+                filename = normalized_filepath.substr(directory.size() + 1);
+
+                if (i->m_archive->has_file(filename))
+                    return i->m_archive;
+            }
+        }
+
+        return nullptr;
+    }
+}
+
+
+//
+// ScopedZipArchiveMount class implementation.
+//
+
+struct ScopedZipArchiveMount::Impl
+{
+    std::unique_ptr<ZipArchive> m_archive;
+};
+
+ScopedZipArchiveMount::ScopedZipArchiveMount(
+    const std::string&          zip_filename,
+    const std::string&          directory)
+  : impl(new Impl())
+{
+    try
+    {
+        impl->m_archive.reset(new ZipArchive(zip_filename));
+    }
+    catch (...)
+    {
+        delete impl;
+        throw;
+    }
+
+    Mount mount;
+    mount.m_directory = normalize_path(directory);
+    mount.m_archive = impl->m_archive.get();
+
+    boost::mutex::scoped_lock lock(g_mounts_mutex);
+    g_mounts.push_back(mount);
+}
+
+ScopedZipArchiveMount::~ScopedZipArchiveMount()
+{
+    {
+        boost::mutex::scoped_lock lock(g_mounts_mutex);
+
+        g_mounts.erase(
+            std::find_if(
+                g_mounts.begin(),
+                g_mounts.end(),
+                [this](const Mount& mount) { return mount.m_archive == impl->m_archive.get(); }));
+    }
+
+    delete impl;
+}
+
+const ZipArchive& ScopedZipArchiveMount::get_archive() const
+{
+    return *impl->m_archive;
+}
+
+
+//
+// Free functions implementation.
+//
+
+bool mounted_file_exists(const bf::path& filepath)
+{
+    std::string filename;
+    return find_archive(filepath, filename) != nullptr;
+}
+
+bool virtual_file_exists(const bf::path& filepath)
+{
+    return mounted_file_exists(filepath) || bf::exists(filepath);
+}
+
+bool read_virtual_file(
+    const bf::path&             filepath,
+    const std::uint8_t*&        data,
+    size_t&                     size,
+    std::vector<std::uint8_t>&  buffer)
+{
+    std::string filename;
+    const ZipArchive* archive = find_archive(filepath, filename);
+
+    return archive != nullptr && archive->read_file(filename, data, size, buffer);
+}
+
+}   // namespace foundation
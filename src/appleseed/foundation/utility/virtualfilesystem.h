@@ -0,0 +1,92 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// Boost headers.
+#include "boost/filesystem/path.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class ZipArchive; }
+
+namespace foundation
+{
+
+//
+// A minimal process-wide virtual file system.
+//
+// Mounting a zip archive at a directory makes the files of the archive appear
+// below that directory, as if the archive had been extracted there, without
+// touching the disk. Files that are not in any mounted archive are looked up
+// on disk as usual.
+//
+
+class ScopedZipArchiveMount
+  : public NonCopyable
+{
+  public:
+    // Mount a zip archive at a given directory. Throws foundation::ZipException.
+    ScopedZipArchiveMount(
+        const std::string&          zip_filename,
+        const std::string&          directory);
+
+    // Unmount the archive.
+    ~ScopedZipArchiveMount();
+
+    // Access the mounted archive.
+    const ZipArchive& get_archive() const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+// Return true if a file exists in a mounted archive.
+bool mounted_file_exists(const boost::filesystem::path& filepath);
+
+// Return true if a file exists, either in a mounted archive or on disk.
+bool virtual_file_exists(const boost::filesystem::path& filepath);
+
+// Retrieve the content of a file from the mounted archives, see foundation::ZipArchive::read_file().
+// Returns false if the file is not in any mounted archive. Throws foundation::ZipException.
+bool read_virtual_file(
+    const boost::filesystem::path&  filepath,
+    const std::uint8_t*&            data,
+    size_t&                         size,
+    std::vector<std::uint8_t>&      buffer);
+
+}   // namespace foundation
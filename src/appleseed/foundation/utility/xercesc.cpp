@@ -31,14 +31,24 @@
 #include "xercesc.h"
 
 // appleseed.foundation headers.
+#include "foundation/hash/siphash.h"
 #include "foundation/string/string.h"
+#include "foundation/utility/bufferedfile.h"
 
 // Xerces-C++ headers.
 #include "xercesc/util/PlatformUtils.hpp"
 #include "xercesc/util/XMLException.hpp"
 #include "xercesc/util/XMLExceptMsgs.hpp"
 
+// Boost headers.
+#include "boost/filesystem.hpp"
+
+// Standard headers.
+#include <cstring>
+#include <exception>
+
 using namespace xercesc;
+namespace bf = boost::filesystem;
 
 namespace foundation
 {
@@ -208,4 +218,437 @@ void ErrorLogger::print(
         transcode(e.getMessage()).c_str());
 }
 
+
+//
+// SAX2EventCache class implementation.
+//
+// Events are stored as a sequence of XMLCh code units: the event type, followed by its
+// strings. Sizes are stored as two code units, and strings as their size followed by
+// their code units and a null terminator, so that they can be replayed in place.
+//
+
+namespace
+{
+    enum SAX2EventType
+    {
+        SAX2StartElement = 1,
+        SAX2EndElement,
+        SAX2Characters
+    };
+
+    // Version of the SAX2 event cache file format. Bump whenever the encoding of events changes.
+    const std::uint16_t SAX2EventCacheVersion = 1;
+
+    const char SAX2EventCacheSignature[14] =
+        { 'S', 'A', 'X', '2', 'E', 'V', 'E', 'N', 'T', 'C', 'A', 'C', 'H', 'E' };
+
+    struct SAX2EventReader
+    {
+        const XMLCh* m_ptr;
+
+        explicit SAX2EventReader(const XMLCh* ptr)
+          : m_ptr(ptr)
+        {
+        }
+
+        size_t read_size()
+        {
+            const size_t low = m_ptr[0];
+            const size_t high = m_ptr[1];
+            m_ptr += 2;
+            return low | (high << 16);
+        }
+
+        const XMLCh* read_string(size_t& length)
+        {
+            length = read_size();
+            const XMLCh* s = m_ptr;
+            m_ptr += length + 1;
+            return s;
+        }
+
+        const XMLCh* read_string()
+        {
+            size_t length;
+            return read_string(length);
+        }
+    };
+
+    class CachedAttributes
+      : public Attributes
+    {
+      public:
+        struct Attribute
+        {
+            const XMLCh*    m_uri;
+            const XMLCh*    m_localname;
+            const XMLCh*    m_qname;
+            const XMLCh*    m_type;
+            const XMLCh*    m_value;
+        };
+
+        std::vector<Attribute> m_attributes;
+
+        XMLSize_t getLength() const override
+        {
+            return m_attributes.size();
+        }
+
+        const XMLCh* getURI(const XMLSize_t index) const override
+        {
+            return index < m_attributes.size() ? m_attributes[index].m_uri : nullptr;
+        }
+
+        const XMLCh* getLocalName(const XMLSize_t index) const override
+        {
+            return index < m_attributes.size() ? m_attributes[index].m_localname : nullptr;
+        }
+
+        const XMLCh* getQName(const XMLSize_t index) const override
+        {
+            return index < m_attributes.size() ? m_attributes[index].m_qname : nullptr;
+        }
+
+        const XMLCh* getType(const XMLSize_t index) const override
+        {
+            return index < m_attributes.size() ? m_attributes[index].m_type : nullptr;
+        }
+
+        const XMLCh* getValue(const XMLSize_t index) const override
+        {
+            return index < m_attributes.size() ? m_attributes[index].m_value : nullptr;
+        }
+
+        bool getIndex(const XMLCh* const uri, const XMLCh* const localPart, XMLSize_t& index) const override
+        {
+            for (size_t i = 0, e = m_attributes.size(); i < e; ++i)
+            {
+                if (XMLString::equals(m_attributes[i].m_uri, uri) &&
+                    XMLString::equals(m_attributes[i].m_localname, localPart))
+                {
+                    index = i;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        int getIndex(const XMLCh* const uri, const XMLCh* const localPart) const override
+        {
+            XMLSize_t index;
+            return getIndex(uri, localPart, index) ? static_cast<int>(index) : -1;
+        }
+
+        bool getIndex(const XMLCh* const qName, XMLSize_t& index) const override
+        {
+            for (size_t i = 0, e = m_attributes.size(); i < e; ++i)
+            {
+                if (XMLString::equals(m_attributes[i].m_qname, qName))
+                {
+                    index = i;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        int getIndex(const XMLCh* const qName) const override
+        {
+            XMLSize_t index;
+            return getIndex(qName, index) ? static_cast<int>(index) : -1;
+        }
+
+        const XMLCh* getType(const XMLCh* const uri, const XMLCh* const localPart) const override
+        {
+            XMLSize_t index;
+            return getIndex(uri, localPart, index) ? m_attributes[index].m_type : nullptr;
+        }
+
+        const XMLCh* getType(const XMLCh* const qName) const override
+        {
+            XMLSize_t index;
+            return getIndex(qName, index) ? m_attributes[index].m_type : nullptr;
+        }
+
+        const XMLCh* getValue(const XMLCh* const uri, const XMLCh* const localPart) const override
+        {
+            XMLSize_t index;
+            return getIndex(uri, localPart, index) ? m_attributes[index].m_value : nullptr;
+        }
+
+        const XMLCh* getValue(const XMLCh* const qName) const override
+        {
+            XMLSize_t index;
+            return getIndex(qName, index) ? m_attributes[index].m_value : nullptr;
+        }
+    };
+}
+
+void SAX2EventCache::clear()
+{
+    m_data.clear();
+}
+
+void SAX2EventCache::record_start_element(
+    const XMLCh* const          uri,
+    const XMLCh* const          localname,
+    const XMLCh* const          qname,
+    const Attributes&           attrs)
+{
+    m_data.push_back(SAX2StartElement);
+    push_string(uri);
+    push_string(localname);
+    push_string(qname);
+
+    const XMLSize_t attr_count = attrs.getLength();
+    push_size(attr_count);
+
+    for (XMLSize_t i = 0; i < attr_count; ++i)
+    {
+        push_string(attrs.getURI(i));
+        push_string(attrs.getLocalName(i));
+        push_string(attrs.getQName(i));
+        push_string(attrs.getType(i));
+        push_string(attrs.getValue(i));
+    }
+}
+
+void SAX2EventCache::record_end_element(
+    const XMLCh* const          uri,
+    const XMLCh* const          localname,
+    const XMLCh* const          qname)
+{
+    m_data.push_back(SAX2EndElement);
+    push_string(uri);
+    push_string(localname);
+    push_string(qname);
+}
+
+void SAX2EventCache::record_characters(
+    const XMLCh* const          chars,
+    const XMLSize_t             length)
+{
+    m_data.push_back(SAX2Characters);
+    push_string(chars, length);
+}
+
+void SAX2EventCache::replay(ContentHandler& handler) const
+{
+    if (m_data.empty())
+        return;
+
+    SAX2EventReader reader(m_data.data());
+    const XMLCh* end = m_data.data() + m_data.size();
+
+    CachedAttributes attrs;
+
+    while (reader.m_ptr < end)
+    {
+        const XMLCh event_type = *reader.m_ptr++;
+
+        switch (event_type)
+        {
+          case SAX2StartElement:
+            {
+                const XMLCh* uri = reader.read_string();
+                const XMLCh* localname = reader.read_string();
+                const XMLCh* qname = reader.read_string();
+
+                attrs.m_attributes.resize(reader.read_size());
+
+                for (CachedAttributes::Attribute& attr : attrs.m_attributes)
+                {
+                    attr.m_uri = reader.read_string();
+                    attr.m_localname = reader.read_string();
+                    attr.m_qname = reader.read_string();
+                    attr.m_type = reader.read_string();
+                    attr.m_value = reader.read_string();
+                }
+
+                handler.startElement(uri, localname, qname, attrs);
+            }
+            break;
+
+          case SAX2EndElement:
+            {
+                const XMLCh* uri = reader.read_string();
+                const XMLCh* localname = reader.read_string();
+                const XMLCh* qname = reader.read_string();
+
+                handler.endElement(uri, localname, qname);
+            }
+            break;
+
+          case SAX2Characters:
+            {
+                size_t length;
+                const XMLCh* chars = reader.read_string(length);
+
+                handler.characters(chars, length);
+            }
+            break;
+
+          default:
+            assert(!"Invalid SAX2 event type.");
+            return;
+        }
+    }
+}
+
+bool SAX2EventCache::save(const std::string& filepath, const std::uint64_t key) const
+{
+    // Write to a temporary file first so that concurrent reads never see partial files.
+    const std::string temp_filepath = filepath + ".tmp";
+
+    try
+    {
+        {
+            BufferedFile file(
+                temp_filepath.c_str(),
+                BufferedFile::BinaryType,
+                BufferedFile::WriteMode);
+
+            if (!file.is_open())
+                return false;
+
+            const std::uint64_t data_size = m_data.size() * sizeof(XMLCh);
+            const std::uint64_t checksum = siphash24(m_data.data(), static_cast<size_t>(data_size));
+
+            checked_write(file, SAX2EventCacheSignature, sizeof(SAX2EventCacheSignature));
+            checked_write(file, SAX2EventCacheVersion);
+            checked_write(file, static_cast<std::uint16_t>(sizeof(XMLCh)));
+            checked_write(file, key);
+            checked_write(file, data_size);
+            checked_write(file, checksum);
+
+            if (data_size > 0)
+                checked_write(file, m_data.data(), static_cast<size_t>(data_size));
+        }
+
+        bf::rename(temp_filepath, filepath);
+    }
+    catch (const std::exception&)
+    {
+        boost::system::error_code ec;
+        bf::remove(temp_filepath, ec);
+        return false;
+    }
+
+    return true;
+}
+
+bool SAX2EventCache::load(const std::string& filepath, const std::uint64_t key)
+{
+    clear();
+
+    BufferedFile file(
+        filepath.c_str(),
+        BufferedFile::BinaryType,
+        BufferedFile::ReadMode);
+
+    if (!file.is_open())
+        return false;
+
+    try
+    {
+        char signature[sizeof(SAX2EventCacheSignature)];
+        checked_read(file, signature, sizeof(signature));
+        if (memcmp(signature, SAX2EventCacheSignature, sizeof(signature)) != 0)
+            return false;
+
+        std::uint16_t version, char_size;
+        checked_read(file, version);
+        checked_read(file, char_size);
+        if (version != SAX2EventCacheVersion || char_size != sizeof(XMLCh))
+            return false;
+
+        std::uint64_t file_key, data_size, checksum;
+        checked_read(file, file_key);
+        checked_read(file, data_size);
+        checked_read(file, checksum);
+        if (file_key != key || data_size % sizeof(XMLCh) != 0)
+            return false;
+
+        m_data.resize(static_cast<size_t>(data_size / sizeof(XMLCh)));
+
+        if (data_size > 0)
+            checked_read(file, m_data.data(), static_cast<size_t>(data_size));
+
+        if (siphash24(m_data.data(), static_cast<size_t>(data_size)) != checksum)
+        {
+            clear();
+            return false;
+        }
+    }
+    catch (const std::exception&)
+    {
+        clear();
+        return false;
+    }
+
+    return true;
+}
+
+void SAX2EventCache::push_size(const size_t size)
+{
+    assert(size <= 0xFFFFFFFFu);
+
+    m_data.push_back(static_cast<XMLCh>(size & 0xFFFF));
+    m_data.push_back(static_cast<XMLCh>((size >> 16) & 0xFFFF));
+}
+
+void SAX2EventCache::push_string(const XMLCh* s)
+{
+    push_string(s, s ? XMLString::stringLen(s) : 0);
+}
+
+void SAX2EventCache::push_string(const XMLCh* s, const size_t length)
+{
+    push_size(length);
+    m_data.insert(m_data.end(), s, s + length);
+    m_data.push_back(0);
+}
+
+
+//
+// SAX2EventRecorder class implementation.
+//
+
+SAX2EventRecorder::SAX2EventRecorder(
+    ContentHandler&             handler,
+    SAX2EventCache&             cache)
+  : m_handler(handler)
+  , m_cache(cache)
+{
+}
+
+void SAX2EventRecorder::startElement(
+    const XMLCh* const          uri,
+    const XMLCh* const          localname,
+    const XMLCh* const          qname,
+    const Attributes&           attrs)
+{
+    m_cache.record_start_element(uri, localname, qname, attrs);
+    m_handler.startElement(uri, localname, qname, attrs);
+}
+
+void SAX2EventRecorder::endElement(
+    const XMLCh* const          uri,
+    const XMLCh* const          localname,
+    const XMLCh* const          qname)
+{
+    m_cache.record_end_element(uri, localname, qname);
+    m_handler.endElement(uri, localname, qname);
+}
+
+void SAX2EventRecorder::characters(
+    const XMLCh* const          chars,
+    const XMLSize_t             length)
+{
+    m_cache.record_characters(chars, length);
+    m_handler.characters(chars, length);
+}
+
 }   // namespace foundation
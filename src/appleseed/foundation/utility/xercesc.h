@@ -39,16 +39,19 @@
 #include "xercesc/sax/ErrorHandler.hpp"
 #include "xercesc/sax/SAXParseException.hpp"
 #include "xercesc/sax2/Attributes.hpp"
+#include "xercesc/sax2/ContentHandler.hpp"
 #include "xercesc/sax2/DefaultHandler.hpp"
 #include "xercesc/util/XMLString.hpp"
 
 // Standard headers.
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <stack>
 #include <string>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class Logger; }
@@ -316,6 +319,92 @@ class ErrorLogger
 };
 
 
+//
+// A record of the element and character events generated while parsing an XML document.
+//
+// Replaying a record into a content handler is much faster than parsing the document
+// again, and records can be saved to binary files to speed up later reads of a document.
+//
+
+class SAX2EventCache
+  : public NonCopyable
+{
+  public:
+    // Remove all recorded events.
+    void clear();
+
+    // Record events.
+    void record_start_element(
+        const XMLCh* const          uri,
+        const XMLCh* const          localname,
+        const XMLCh* const          qname,
+        const xercesc::Attributes&  attrs);
+    void record_end_element(
+        const XMLCh* const          uri,
+        const XMLCh* const          localname,
+        const XMLCh* const          qname);
+    void record_characters(
+        const XMLCh* const          chars,
+        const XMLSize_t             length);
+
+    // Send the recorded events to a content handler, in the order they were recorded.
+    void replay(xercesc::ContentHandler& handler) const;
+
+    // Write the record to a binary file, along with a key identifying the source document.
+    // Return true on success.
+    bool save(const std::string& filepath, const std::uint64_t key) const;
+
+    // Read a record from a binary file. Return false if the file doesn't exist,
+    // is invalid, or was saved with a different key.
+    bool load(const std::string& filepath, const std::uint64_t key);
+
+  private:
+    std::vector<XMLCh> m_data;
+
+    void push_size(const size_t size);
+    void push_string(const XMLCh* s);
+    void push_string(const XMLCh* s, const size_t length);
+};
+
+
+//
+// A SAX2 content handler that records element and character events into
+// a SAX2EventCache while forwarding them to another content handler.
+//
+
+class SAX2EventRecorder
+  : public xercesc::DefaultHandler
+{
+  public:
+    // Constructor.
+    SAX2EventRecorder(
+        xercesc::ContentHandler&    handler,
+        SAX2EventCache&             cache);
+
+    // Receive notification of the start of an element.
+    void startElement(
+        const XMLCh* const          uri,
+        const XMLCh* const          localname,
+        const XMLCh* const          qname,
+        const xercesc::Attributes&  attrs) override;
+
+    // Receive notification of the end of an element.
+    void endElement(
+        const XMLCh* const          uri,
+        const XMLCh* const          localname,
+        const XMLCh* const          qname) override;
+
+    // Receive notification of character data inside an element.
+    void characters(
+        const XMLCh* const          chars,
+        const XMLSize_t             length) override;
+
+  private:
+    xercesc::ContentHandler&    m_handler;
+    SAX2EventCache&             m_cache;
+};
+
+
 //
 // Transcoding functions implementation.
 //
@@ -30,22 +30,35 @@
 #include "zip.h"
 
 // appleseed.foundation headers.
+#include "foundation/log/logger.h"
+#include "foundation/platform/system.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/foreach.h"
+#include "foundation/utility/job.h"
 #include "foundation/utility/minizip/unzip.h"
 #include "foundation/utility/minizip/zip.h"
 
 // Boost headers.
 #include "boost/filesystem.hpp"
+#include "boost/interprocess/exceptions.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
 #include "boost/range/iterator_range.hpp"
 
+// zlib headers.
+#include <zlib.h>
+
 // Standard headers.
+#include <algorithm>
+#include <cstring>
 #include <ctime>
 #include <fstream>
+#include <map>
 #include <set>
 #include <vector>
 
 namespace bf = boost::filesystem;
+namespace bi = boost::interprocess;
 
 namespace foundation
 {
@@ -142,6 +155,17 @@ namespace
             bf::create_directories(parent_path);
     }
 
+    bool has_extension(const std::string& filename, const std::vector<std::string>& extensions)
+    {
+        for (const std::string& extension : extensions)
+        {
+            if (ends_with(filename, extension))
+                return true;
+        }
+
+        return false;
+    }
+
     void extract_current_file(unzFile& zip_file, const std::string& unzipped_dir)
     {
         const std::string filepath = get_filepath(zip_file, unzipped_dir);
@@ -170,40 +194,16 @@ namespace
         unzip_close_current_file(zip_file);
     }
 
-    void zip_close_current_file(zipFile& zip_file)
-    {
-        const int err = zipCloseFileInZip(zip_file);
-
-        if (err != ZIP_OK)
-            throw ZipException("error while closing file in zip", err);
-    }
-
-    void write_chunk(zipFile& zip_file, char* buffer, const size_t chunk_size)
+    // A file compressed ahead of time, to be stored as is in a zip archive.
+    struct CompressedZipEntry
     {
-        const int err =
-            zipWriteInFileInZip(
-                zip_file,
-                buffer,
-                static_cast<unsigned int>(chunk_size));
-
-        if (err < 0)
-            throw ZipException("error while writing to zip", err);
-    }
-
-    void open_new_file_in_zip(zipFile& zip_file, std::string filename_in_zip, zip_fileinfo zip_file_info)
-    {
-        const int err =
-            zipOpenNewFileInZip(
-                zip_file,
-                filename_in_zip.c_str(),
-                &zip_file_info,
-                nullptr, 0, nullptr, 0, nullptr,
-                Z_DEFLATED,
-                Z_DEFAULT_COMPRESSION);
-
-        if (err != ZIP_OK)
-            throw ZipException(("error while opening " + filename_in_zip + " in zipfile").c_str());
-    }
+        std::string                 m_filename;
+        zip_fileinfo                m_file_info;
+        std::vector<Bytef>          m_compressed_data;
+        uLong                       m_uncompressed_size;
+        uLong                       m_crc;
+        std::string                 m_error;                // empty unless compression failed
+    };
 
     zip_fileinfo make_zip_fileinfo(const std::string& filename)
     {
@@ -225,34 +225,170 @@ namespace
         return zip_file_info;
     }
 
-    void zip_current_file(zipFile& zip_file, const std::string& filename, const std::string& base_directory)
+    // Deflate a file into a raw (headerless) stream, as stored in zip archives.
+    void compress_zip_entry(const std::string& base_directory, CompressedZipEntry& entry)
     {
-        const std::string filename_in_fs = (bf::path(base_directory) / filename).string();
-
-        const zip_fileinfo zip_file_info = make_zip_fileinfo(filename_in_fs);
+        const std::string filename_in_fs = (bf::path(base_directory) / entry.m_filename).string();
 
-        open_new_file_in_zip(zip_file, filename, zip_file_info);
-
-        std::fstream in(filename_in_fs.c_str(), std::ios_base::in | std::ios_base::binary);
+        std::ifstream in(filename_in_fs.c_str(), std::ios_base::in | std::ios_base::binary);
         if (in.fail())
             throw ZipException(("can't open file " + filename_in_fs).c_str());
 
+        z_stream stream;
+        std::memset(&stream, 0, sizeof(stream));
+
+        // Same settings as minizip's own compression.
+        const int err = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+        if (err != Z_OK)
+            throw ZipException("can't initialize compression", err);
+
+        entry.m_uncompressed_size = 0;
+        entry.m_crc = crc32(0, Z_NULL, 0);
+
+        const size_t BUFFER_SIZE = 64 * 1024;
+        std::vector<Bytef> input(BUFFER_SIZE);
+        std::vector<Bytef> output(BUFFER_SIZE);
+
+        int flush;
+
         do
         {
-            const size_t BUFFER_SIZE = 4096;
-            char buffer[BUFFER_SIZE];
+            in.read(reinterpret_cast<char*>(&input[0]), BUFFER_SIZE);
+
+            if (in.bad())
+            {
+                deflateEnd(&stream);
+                throw ZipException(("i/o error while reading " + filename_in_fs).c_str());
+            }
+
+            const uInt read = static_cast<uInt>(in.gcount());
+            entry.m_uncompressed_size += read;
+            entry.m_crc = crc32(entry.m_crc, &input[0], read);
+
+            flush = in.eof() ? Z_FINISH : Z_NO_FLUSH;
+            stream.next_in = &input[0];
+            stream.avail_in = read;
+
+            do
+            {
+                stream.next_out = &output[0];
+                stream.avail_out = static_cast<uInt>(BUFFER_SIZE);
+                deflate(&stream, flush);
+
+                entry.m_compressed_data.insert(
+                    entry.m_compressed_data.end(),
+                    &output[0],
+                    &output[0] + (BUFFER_SIZE - stream.avail_out));
+            }
+            while (stream.avail_out == 0);
+        }
+        while (flush != Z_FINISH);
+
+        deflateEnd(&stream);
+    }
+
+    class CompressZipEntryJob
+      : public IJob
+    {
+      public:
+        CompressZipEntryJob(
+            const std::string&      base_directory,
+            CompressedZipEntry&     entry)
+          : m_base_directory(base_directory)
+          , m_entry(entry)
+        {
+        }
 
-            in.read(&buffer[0], BUFFER_SIZE);
-            write_chunk(zip_file, &buffer[0], in.gcount());
+        void execute(const size_t thread_index) override
+        {
+            try
+            {
+                compress_zip_entry(m_base_directory, m_entry);
+            }
+            catch (const std::exception& e)
+            {
+                m_entry.m_error = e.what();
+            }
         }
-        while (!in.eof());
 
-        in.close();
-        zip_close_current_file(zip_file);
+      private:
+        const std::string&          m_base_directory;
+        CompressedZipEntry&         m_entry;
+    };
+
+    void compress_zip_entries(
+        const std::string&                  base_directory,
+        std::vector<CompressedZipEntry>&    entries,
+        const size_t                        thread_count)
+    {
+        if (entries.size() > 1 && thread_count > 1)
+        {
+            // Jobs don't fail, so the job manager has nothing to log.
+            Logger logger;
+            JobQueue job_queue;
+            JobManager job_manager(logger, job_queue, std::min(thread_count, entries.size()));
+
+            for (CompressedZipEntry& entry : entries)
+                job_queue.schedule(new CompressZipEntryJob(base_directory, entry));
+
+            job_manager.start();
+            job_queue.wait_until_completion();
+        }
+        else
+        {
+            for (CompressedZipEntry& entry : entries)
+                CompressZipEntryJob(base_directory, entry).execute(0);
+        }
     }
+
+    void write_compressed_zip_entry(zipFile& zip_file, const CompressedZipEntry& entry)
+    {
+        if (!entry.m_error.empty())
+            throw ZipException(entry.m_error.c_str());
+
+        int err =
+            zipOpenNewFileInZip2(
+                zip_file,
+                entry.m_filename.c_str(),
+                &entry.m_file_info,
+                nullptr, 0, nullptr, 0, nullptr,
+                Z_DEFLATED,
+                Z_DEFAULT_COMPRESSION,
+                1);                                         // raw: the data is already compressed
+
+        if (err != ZIP_OK)
+            throw ZipException(("error while opening " + entry.m_filename + " in zipfile").c_str());
+
+        const size_t CHUNK_SIZE = 1024 * 1024;
+
+        for (size_t offset = 0; offset < entry.m_compressed_data.size(); offset += CHUNK_SIZE)
+        {
+            const size_t chunk_size = std::min(CHUNK_SIZE, entry.m_compressed_data.size() - offset);
+
+            err =
+                zipWriteInFileInZip(
+                    zip_file,
+                    &entry.m_compressed_data[offset],
+                    static_cast<unsigned int>(chunk_size));
+
+            if (err < 0)
+                throw ZipException("error while writing to zip", err);
+        }
+
+        err = zipCloseFileInZipRaw(zip_file, entry.m_uncompressed_size, entry.m_crc);
+
+        if (err != ZIP_OK)
+            throw ZipException("error while closing file in zip", err);
+    }
+
+    // Number of files compressed in a batch, per thread.
+    const size_t FilesPerThread = 2;
 }
 
-void unzip(const std::string& zip_filename, const std::string& unzipped_dir)
+void unzip(
+    const std::string&              zip_filename,
+    const std::string&              unzipped_dir,
+    const std::vector<std::string>& excluded_extensions)
 {
     try
     {
@@ -267,7 +403,8 @@ void unzip(const std::string& zip_filename, const std::string& unzipped_dir)
         int has_next = UNZ_OK;
         while (has_next == UNZ_OK)
         {
-            extract_current_file(zip_file, unzipped_dir);
+            if (!has_extension(read_filename(zip_file), excluded_extensions))
+                extract_current_file(zip_file, unzipped_dir);
             has_next = unzGoToNextFile(zip_file);
         }
 
@@ -290,8 +427,28 @@ void zip(const std::string& zip_filename, const std::string& directory_to_zip)
         if (zip_file == nullptr)
             throw ZipException(("can't open file " + zip_filename).c_str());
 
-        for (const std::string& filename_to_zip : files_to_zip)
-            zip_current_file(zip_file, filename_to_zip, directory_to_zip);
+        // Files are compressed in parallel, by batches, then stored in the archive in order.
+        const size_t thread_count = System::get_logical_cpu_core_count();
+        std::vector<CompressedZipEntry> entries;
+
+        std::set<std::string>::const_iterator it = files_to_zip.begin();
+        while (it != files_to_zip.end())
+        {
+            entries.clear();
+
+            while (it != files_to_zip.end() && entries.size() < thread_count * FilesPerThread)
+            {
+                entries.emplace_back();
+                CompressedZipEntry& entry = entries.back();
+                entry.m_filename = *it++;
+                entry.m_file_info = make_zip_fileinfo((bf::path(directory_to_zip) / entry.m_filename).string());
+            }
+
+            compress_zip_entries(directory_to_zip, entries, thread_count);
+
+            for (const CompressedZipEntry& entry : entries)
+                write_compressed_zip_entry(zip_file, entry);
+        }
 
         zipClose(zip_file, nullptr);
     }
@@ -341,6 +498,211 @@ std::vector<std::string> get_filenames_with_extension_from_zip(const std::string
     return filenames;
 }
 
+
+//
+// ZipArchive class implementation.
+//
+
+struct ZipArchive::Impl
+{
+    struct Entry
+    {
+        std::uint64_t       m_data_offset;          // offset of the (possibly compressed) data in the archive
+        std::uint64_t       m_compressed_size;
+        std::uint64_t       m_uncompressed_size;
+        bool                m_stored;               // true if the data is not compressed
+    };
+
+    typedef std::map<std::string, Entry> EntryMap;
+
+    bi::file_mapping        m_mapping;
+    bi::mapped_region       m_region;
+    EntryMap                m_entries;
+
+    void read_entries(const std::string& zip_filename)
+    {
+        unzFile zip_file = unzOpen(zip_filename.c_str());
+        if (zip_file == nullptr)
+            throw ZipException(("can't open file " + zip_filename).c_str());
+
+        try
+        {
+            int has_next = unzGoToFirstFile(zip_file);
+            while (has_next == UNZ_OK)
+            {
+                const std::string filename = read_filename(zip_file);
+
+                if (!is_zip_entry_directory(filename))
+                    m_entries[filename] = read_current_entry(zip_file);
+
+                has_next = unzGoToNextFile(zip_file);
+            }
+        }
+        catch (...)
+        {
+            unzClose(zip_file);
+            throw;
+        }
+
+        unzClose(zip_file);
+    }
+
+    static Entry read_current_entry(unzFile& zip_file)
+    {
+        unz_file_info64 zip_file_info;
+        unzGetCurrentFileInfo64(zip_file, &zip_file_info, nullptr, 0, nullptr, 0, nullptr, 0);
+
+        if (zip_file_info.compression_method != 0 &&
+            zip_file_info.compression_method != Z_DEFLATED)
+            throw ZipException("unsupported compression method in zip file");
+
+        Entry entry;
+        entry.m_compressed_size = zip_file_info.compressed_size;
+        entry.m_uncompressed_size = zip_file_info.uncompressed_size;
+        entry.m_stored = zip_file_info.compression_method == 0;
+
+        // Opening the file makes minizip parse its local header, which gives us where its data begins.
+        open_current_file(zip_file);
+        entry.m_data_offset = unzGetCurrentFileZStreamPos64(zip_file);
+        unzCloseCurrentFile(zip_file);
+
+        return entry;
+    }
+
+    void inflate_entry(const Entry& entry, std::vector<std::uint8_t>& buffer) const
+    {
+        const std::uint8_t* compressed_data =
+            static_cast<const std::uint8_t*>(m_region.get_address()) + entry.m_data_offset;
+
+        buffer.resize(static_cast<size_t>(entry.m_uncompressed_size));
+
+        z_stream stream;
+        std::memset(&stream, 0, sizeof(stream));
+
+        // Negative window bits: raw deflate data, without zlib header.
+        int err = inflateInit2(&stream, -MAX_WBITS);
+        if (err != Z_OK)
+            throw ZipException("zlib error while decompressing file: ", err);
+
+        // zlib counts bytes with 32-bit integers, feed it in chunks.
+        const std::uint64_t MaxChunkSize = 1UL << 30;
+        std::uint64_t remaining_in = entry.m_compressed_size;
+        std::uint64_t remaining_out = entry.m_uncompressed_size;
+        stream.next_in = const_cast<Bytef*>(compressed_data);
+        stream.next_out = &buffer[0];
+
+        while (err == Z_OK)
+        {
+            if (stream.avail_in == 0 && remaining_in > 0)
+            {
+                stream.avail_in = static_cast<uInt>(std::min(remaining_in, MaxChunkSize));
+                remaining_in -= stream.avail_in;
+            }
+
+            if (stream.avail_out == 0 && remaining_out > 0)
+            {
+                stream.avail_out = static_cast<uInt>(std::min(remaining_out, MaxChunkSize));
+                remaining_out -= stream.avail_out;
+            }
+
+            err = inflate(&stream, Z_NO_FLUSH);
+        }
+
+        const std::uint64_t total_out = stream.total_out;
+        inflateEnd(&stream);
+
+        if (err != Z_STREAM_END || total_out != entry.m_uncompressed_size)
+            throw ZipException("zlib error while decompressing file: ", err);
+    }
+};
+
+ZipArchive::ZipArchive(const std::string& zip_filename)
+  : impl(new Impl())
+{
+    try
+    {
+        impl->read_entries(zip_filename);
+
+        try
+        {
+            impl->m_mapping = bi::file_mapping(zip_filename.c_str(), bi::read_only);
+            impl->m_region = bi::mapped_region(impl->m_mapping, bi::read_only);
+        }
+        catch (const bi::interprocess_exception& e)
+        {
+            throw ZipException(e.what());
+        }
+
+        const std::uint64_t archive_size = impl->m_region.get_size();
+
+        for (const auto& entry : impl->m_entries)
+        {
+            if (entry.second.m_data_offset > archive_size ||
+                entry.second.m_compressed_size > archive_size - entry.second.m_data_offset)
+                throw ZipException(("corrupted zip file " + zip_filename).c_str());
+        }
+    }
+    catch (...)
+    {
+        delete impl;
+        throw;
+    }
+}
+
+ZipArchive::~ZipArchive()
+{
+    delete impl;
+}
+
+std::vector<std::string> ZipArchive::get_filenames() const
+{
+    std::vector<std::string> filenames;
+    filenames.reserve(impl->m_entries.size());
+
+    for (const auto& entry : impl->m_entries)
+        filenames.push_back(entry.first);
+
+    return filenames;
+}
+
+bool ZipArchive::has_file(const std::string& filename) const
+{
+    return impl->m_entries.find(filename) != impl->m_entries.end();
+}
+
+bool ZipArchive::read_file(
+    const std::string&          filename,
+    const std::uint8_t*&        data,
+    size_t&                     size,
+    std::vector<std::uint8_t>&  buffer) const
+{
+    const Impl::EntryMap::const_iterator i = impl->m_entries.find(filename);
+
+    if (i == impl->m_entries.end())
+        return false;
+
+    const Impl::Entry& entry = i->second;
+
+    if (entry.m_uncompressed_size == 0)
+    {
+        data = nullptr;
+        size = 0;
+    }
+    else if (entry.m_stored)
+    {
+        data = static_cast<const std::uint8_t*>(impl->m_region.get_address()) + entry.m_data_offset;
+        size = static_cast<size_t>(entry.m_uncompressed_size);
+    }
+    else
+    {
+        impl->inflate_entry(entry, buffer);
+        data = &buffer[0];
+        size = buffer.size();
+    }
+
+    return true;
+}
+
 std::set<std::string> recursive_ls(const bf::path& dir)
 {
     std::set<std::string> files;
@@ -29,12 +29,15 @@
 #pragma once
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/core/exceptions/exception.h"
 
 // Boost headers.
 #include "boost/filesystem/path.hpp"
 
 // Standard headers.
+#include <cstddef>
+#include <cstdint>
 #include <set>
 #include <string>
 #include <vector>
@@ -56,12 +59,16 @@ class ZipException
 
 //
 // Extracts zip file zipFilename to unzipped_dir directory.
+// Files whose name ends with one of excluded_extensions are not extracted.
 //
 // Throws ZipException in case of exception.
 // If exception is thrown, unzipped folder is deleted.
 //
 
-void unzip(const std::string& zip_filename, const std::string& unzipped_dir);
+void unzip(
+    const std::string&              zip_filename,
+    const std::string&              unzipped_dir,
+    const std::vector<std::string>& excluded_extensions = std::vector<std::string>());
 
 //
 // Archives directory_to_zip to zip_filename zip file.
@@ -88,6 +95,46 @@ std::vector<std::string> get_filenames_with_extension_from_zip(
     const std::string& zip_filename,
     const std::string& extension);
 
+//
+// Read-only access to the files of a zip archive without extracting them.
+//
+// The archive is memory-mapped: files stored without compression are accessed
+// in place, deflated files are decompressed into memory. Files can be read
+// concurrently from multiple threads.
+//
+
+class ZipArchive
+  : public NonCopyable
+{
+  public:
+    // Constructor. Throws ZipException if zip_filename can't be opened or is not a zip file.
+    explicit ZipArchive(const std::string& zip_filename);
+
+    // Destructor.
+    ~ZipArchive();
+
+    // Return the names of all the files of the archive.
+    std::vector<std::string> get_filenames() const;
+
+    // Return true if the archive contains a given file.
+    bool has_file(const std::string& filename) const;
+
+    // Retrieve the content of a file of the archive. If the file is stored,
+    // data points directly into the memory-mapped archive and buffer is left
+    // untouched; otherwise the file is decompressed into buffer. data remains
+    // valid as long as both the archive and buffer are alive.
+    // Returns false if the file does not exist. Throws ZipException.
+    bool read_file(
+        const std::string&          filename,
+        const std::uint8_t*&        data,
+        size_t&                     size,
+        std::vector<std::uint8_t>&  buffer) const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
 //
 // Retrieves all files inside a given directory and its subdirectories.
 //
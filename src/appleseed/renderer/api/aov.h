@@ -49,5 +49,6 @@
 #include "renderer/modeling/aov/pixeltimeaov.h"
 #include "renderer/modeling/aov/pixelvariationaov.h"
 #include "renderer/modeling/aov/positionaov.h"
+#include "renderer/modeling/aov/rendercostaov.h"
 #include "renderer/modeling/aov/screenspacevelocityaov.h"
 #include "renderer/modeling/aov/uvaov.h"
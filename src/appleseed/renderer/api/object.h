@@ -43,6 +43,7 @@
 #include "renderer/modeling/object/object.h"
 #include "renderer/modeling/object/objectfactoryregistrar.h"
 #include "renderer/modeling/object/objecttraits.h"
+#include "renderer/modeling/object/particlesetobject.h"
 #include "renderer/modeling/object/proceduralobject.h"
 #include "renderer/modeling/object/rectangleobject.h"
 #include "renderer/modeling/object/sphereobject.h"
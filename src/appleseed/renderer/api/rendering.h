@@ -30,6 +30,7 @@
 #pragma once
 
 // API headers.
+#include "renderer/kernel/rendering/convergencerenderercontroller.h"
 #include "renderer/kernel/rendering/debug/blanktilerenderer.h"
 #include "renderer/kernel/rendering/debug/debugtilerenderer.h"
 #include "renderer/kernel/rendering/defaultrenderercontroller.h"
@@ -43,8 +44,12 @@
 #include "renderer/kernel/rendering/itilerenderer.h"
 #include "renderer/kernel/rendering/masterrenderer.h"
 #include "renderer/kernel/rendering/nulltilecallback.h"
+#include "renderer/kernel/rendering/phasetimer.h"
 #include "renderer/kernel/rendering/progressive/progressiveframerenderer.h"
 #include "renderer/kernel/rendering/renderercontrollercollection.h"
+#include "renderer/kernel/rendering/renderingmetrics.h"
+#include "renderer/kernel/rendering/scenechangetracker.h"
+#include "renderer/kernel/rendering/sharedmemorytilecallback.h"
 #include "renderer/kernel/rendering/tilecallbackbase.h"
 #include "renderer/kernel/rendering/tilecallbackcollection.h"
 #include "renderer/kernel/rendering/timedrenderercontroller.h"
@@ -32,6 +32,7 @@
 // API headers.
 #include "renderer/utility/bbox.h"
 #include "renderer/utility/messagecontext.h"
+#include "renderer/utility/oiiomaketexture.h"
 #include "renderer/utility/paramarray.h"
 #include "renderer/utility/pluginstore.h"
 #include "renderer/utility/projectpoints.h"
@@ -31,30 +31,50 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
+#include "renderer/kernel/rendering/iframerenderer.h"
 #include "renderer/kernel/rendering/oiioerrorhandler.h"
+#include "renderer/kernel/rendering/phasetimer.h"
 #include "renderer/kernel/rendering/renderercomponents.h"
 #include "renderer/kernel/rendering/rendererservices.h"
+#include "renderer/kernel/rendering/scenechangetracker.h"
 #include "renderer/kernel/shading/closures.h"
 #include "renderer/kernel/shading/oslshadingsystem.h"
 #include "renderer/kernel/texturing/oiiotexturesystem.h"
 #include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/modeling/frame/frame.h"
 #include "renderer/modeling/project/project.h"
+#include "renderer/modeling/project/renderingtimer.h"
 #include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/settingsparsing.h"
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
 #include "foundation/utility/searchpaths.h"
+#include "foundation/utility/statistics.h"
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
 
 using namespace foundation;
 
 namespace renderer
 {
 
+namespace
+{
+    std::uint64_t get_uint_statistic(const Statistics& stats, const char* name)
+    {
+        const Statistics::UnsignedIntegerEntry* entry =
+            dynamic_cast<const Statistics::UnsignedIntegerEntry*>(stats.get(name));
+
+        return entry != nullptr ? entry->m_value : 0;
+    }
+}
+
 CPURenderDevice::CPURenderDevice(
     Project&                project,
     const ParamArray&       params)
@@ -74,6 +94,7 @@ CPURenderDevice::CPURenderDevice(
     m_texture_system->attribute("gray_to_rgb", 1);
     m_texture_system->attribute("latlong_up", "y");
     m_texture_system->attribute("flip_t", 1);
+    m_texture_store.set_texture_system(m_texture_system);
 
     m_renderer_services =
         new RendererServices(
@@ -119,17 +140,19 @@ CPURenderDevice::~CPURenderDevice()
     const std::string modified_stats = prefix_all_lines(trim_both(stats), "oiio: ");
     RENDERER_LOG_DEBUG("%s", modified_stats.c_str());
 
+    // Print texture store performance statistics while they can still include oiio's image cache.
+    RENDERER_LOG_DEBUG("%s", m_texture_store.get_statistics().to_string().c_str());
+
     RENDERER_LOG_DEBUG("destroying oiio texture system...");
+    m_texture_store.set_texture_system(nullptr);
     m_texture_system->release();
     delete m_error_handler;
-
-    // Print texture store performance statistics.
-    RENDERER_LOG_DEBUG("%s", m_texture_store.get_statistics().to_string().c_str());
 }
 
 bool CPURenderDevice::initialize(
     const SearchPaths&      resource_search_paths,
     ITileCallbackFactory*   tile_callback_factory,
+    const std::uint32_t     scene_changes,
     IAbortSwitch&           abort_switch)
 {
     // Construct a search paths string from the project's search paths.
@@ -138,9 +161,7 @@ bool CPURenderDevice::initialize(
 
     // Initialize OIIO.
     const size_t texture_cache_size_bytes =
-        get_params().child("texture_store").get_optional<size_t>(
-            "max_size",
-            TextureStore::get_default_size());
+        TextureStore::get_image_cache_size(get_params().child("texture_store"));
     RENDERER_LOG_INFO(
         "setting oiio texture cache size to %s.",
         pretty_size(texture_cache_size_bytes).c_str());
@@ -165,6 +186,7 @@ bool CPURenderDevice::initialize(
     m_renderer_services->initialize(m_texture_store);
 
     // Create renderer components.
+    std::unique_ptr<RendererComponents> previous_components(std::move(m_components));
     m_components.reset(
         new RendererComponents(
             get_project(),
@@ -174,6 +196,16 @@ bool CPURenderDevice::initialize(
             *m_texture_system,
             *m_shading_system));
 
+    // Light samplers only depend on lights and geometry: keep them if neither changed.
+    if (previous_components &&
+        (scene_changes & (SceneChangeTracker::LightsChanged | SceneChangeTracker::GeometryChanged)) == 0)
+    {
+        RENDERER_LOG_DEBUG("reusing light samplers from previous render...");
+        m_components->reuse_light_samplers(*previous_components);
+    }
+
+    previous_components.reset();
+
     // Set OSL search paths.
     std::string prev_osl_search_paths;
     m_shading_system->getattribute("searchpath:shader", prev_osl_search_paths);
@@ -190,18 +222,34 @@ bool CPURenderDevice::initialize(
         const APIString stdosl_path = resource_search_paths.qualify("stdosl.h");
         RENDERER_LOG_INFO("found OSL headers in %s", stdosl_path.c_str());
         m_osl_compiler = ShaderCompilerFactory::create(stdosl_path.c_str());
+
+        // Optionally reuse shaders compiled by previous renders.
+        const std::string cache_directory =
+            get_params().child("shader_compiler").get_optional<std::string>("cache_directory", "");
+        if (!cache_directory.empty())
+        {
+            RENDERER_LOG_INFO("caching compiled OSL shaders in %s", cache_directory.c_str());
+            m_osl_compiler->set_cache_directory(cache_directory.c_str());
+        }
     }
     else
         RENDERER_LOG_INFO("OSL headers not found.");
 
     // Re-optimize shader groups that need updating.
+    PhaseTimer phase_timer;
+    RenderingTimer stopwatch;
+    stopwatch.start();
     if (!get_project().get_scene()->create_optimized_osl_shader_groups(
             *m_shading_system,
             m_osl_compiler.get(),
-            &abort_switch))
+            &abort_switch,
+            get_rendering_thread_count(get_params())))
     {
         return false;
     }
+    stopwatch.measure();
+    get_project().get_frame()->render_info().insert("osl_preparation_time", stopwatch.get_seconds());
+    phase_timer.record(get_project().get_frame()->render_info(), "osl_preparation");
 
     return m_components->create();
 }
@@ -277,6 +325,16 @@ IRendererController::Status CPURenderDevice::render_frame(
 
     assert(!frame_renderer.is_rendering());
 
+    // Record how many rays were traced. Every shading ray yields a shading point.
+    const StatisticsVector stats = frame_renderer.get_statistics();
+    const Statistics* intersection_stats = stats.get("intersection statistics");
+    if (intersection_stats != nullptr)
+    {
+        ParamArray& render_info = get_project().get_frame()->render_info();
+        render_info.insert("ray_count", get_uint_statistic(*intersection_stats, "total rays"));
+        render_info.insert("shading_point_count", get_uint_statistic(*intersection_stats, "shading rays"));
+    }
+
     return status;
 }
 
@@ -38,6 +38,7 @@
 #include "foundation/memory/autoreleaseptr.h"
 
 // Standard headers.
+#include <cstdint>
 #include <memory>
 
 // Forward declarations.
@@ -64,6 +65,7 @@ class CPURenderDevice
     bool initialize(
         const foundation::SearchPaths&  resource_search_paths,
         ITileCallbackFactory*           tile_callback_factory,
+        const std::uint32_t             scene_changes,
         foundation::IAbortSwitch&       abort_switch) override;
 
     bool build_or_update_scene() override;
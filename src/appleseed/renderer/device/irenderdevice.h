@@ -36,6 +36,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 
 // Forward declarations.
 namespace foundation { class IAbortSwitch; }
@@ -56,10 +57,13 @@ class IRenderDevice
     // Destructor.
     virtual ~IRenderDevice() = default;
 
-    // Initialize the render device.
+    // Initialize the render device. `scene_changes` is a combination of SceneChangeTracker::Changes
+    // flags describing what changed in the scene since the device was last initialized; devices may
+    // use it to keep components that don't depend on the changed entities.
     virtual bool initialize(
         const foundation::SearchPaths&  resource_search_paths,
         ITileCallbackFactory*           tile_callback_factory,
+        const std::uint32_t             scene_changes,
         foundation::IAbortSwitch&       abort_switch)  = 0;
 
     // Build or update ray tracing acceleration structures.
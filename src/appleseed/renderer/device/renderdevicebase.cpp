@@ -30,13 +30,16 @@
 #include "renderdevicebase.h"
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #include "renderer/kernel/rendering/iframerenderer.h"
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
 #include "foundation/platform/thread.h"
+#include "foundation/string/string.h"
 
 // Standard headers.
+#include <cstddef>
 #include <string>
 
 namespace renderer
@@ -80,12 +83,30 @@ IRendererController::Status RenderDeviceBase::wait_for_event(
     IRendererController&    renderer_controller)
 {
     bool is_paused = false;
+    size_t active_thread_count = 0;
 
     while (true)
     {
         if (!frame_renderer.is_rendering())
             return IRendererController::TerminateRendering;
 
+        const size_t requested_thread_count = renderer_controller.get_active_thread_count();
+
+        if (requested_thread_count != active_thread_count)
+        {
+            if (requested_thread_count > 0)
+            {
+                RENDERER_LOG_INFO(
+                    "limiting rendering to %s %s...",
+                    foundation::pretty_uint(requested_thread_count).c_str(),
+                    foundation::plural(requested_thread_count, "thread").c_str());
+            }
+            else RENDERER_LOG_INFO("using all rendering threads...");
+
+            frame_renderer.set_active_thread_count(requested_thread_count);
+            active_thread_count = requested_thread_count;
+        }
+
         const IRendererController::Status status = renderer_controller.get_status();
 
         switch (status)
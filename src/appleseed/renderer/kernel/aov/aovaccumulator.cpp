@@ -31,13 +31,19 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
+#include "renderer/kernel/aov/aovcomponents.h"
+#include "renderer/kernel/shading/shadingcomponents.h"
+#include "renderer/kernel/shading/shadingresult.h"
 #include "renderer/modeling/aov/aov.h"
+#include "renderer/modeling/color/colorspace.h"
 #include "renderer/modeling/frame/frame.h"
 
 // appleseed.foundation headers.
 #include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
 #include "foundation/image/image.h"
 #include "foundation/image/tile.h"
+#include "foundation/utility/otherwise.h"
 
 // Standard headers.
 #include <cassert>
@@ -48,6 +54,133 @@ using namespace foundation;
 namespace renderer
 {
 
+namespace
+{
+    //
+    // Inputs of the built-in AOV writers.
+    //
+
+    enum BuiltinAOVInput
+    {
+        InputAlbedo             = 1UL << 0,
+        InputDirectDiffuse      = 1UL << 1,
+        InputIndirectDiffuse    = 1UL << 2,
+        InputDirectGlossy       = 1UL << 3,
+        InputIndirectGlossy     = 1UL << 4,
+        InputEmission           = 1UL << 5
+    };
+
+    std::uint32_t get_builtin_inputs(const AOVWriterKind kind)
+    {
+        switch (kind)
+        {
+          case AOVWriterKind::Albedo:           return InputAlbedo;
+          case AOVWriterKind::Diffuse:          return InputDirectDiffuse | InputIndirectDiffuse;
+          case AOVWriterKind::DirectDiffuse:    return InputDirectDiffuse;
+          case AOVWriterKind::IndirectDiffuse:  return InputIndirectDiffuse;
+          case AOVWriterKind::Glossy:           return InputDirectGlossy | InputIndirectGlossy;
+          case AOVWriterKind::DirectGlossy:     return InputDirectGlossy;
+          case AOVWriterKind::IndirectGlossy:   return InputIndirectGlossy;
+          case AOVWriterKind::Emission:         return InputEmission;
+          default:                              return 0;
+        }
+    }
+
+    // RGB values of the shading components used by built-in writers,
+    // converted once per sample.
+    struct BuiltinAOVInputs
+    {
+        Color3f m_albedo;
+        Color3f m_direct_diffuse;
+        Color3f m_indirect_diffuse;
+        Color3f m_direct_glossy;
+        Color3f m_indirect_glossy;
+        Color3f m_emission;
+
+        void compute(
+            const std::uint32_t         inputs,
+            const ShadingComponents&    shading_components,
+            const AOVComponents&        aov_components)
+        {
+            if (inputs & InputAlbedo)
+                m_albedo = aov_components.m_albedo.to_rgb(g_std_lighting_conditions);
+
+            if (inputs & InputDirectDiffuse)
+                m_direct_diffuse = shading_components.m_diffuse.to_rgb(g_std_lighting_conditions);
+
+            if (inputs & InputIndirectDiffuse)
+                m_indirect_diffuse = shading_components.m_indirect_diffuse.to_rgb(g_std_lighting_conditions);
+
+            if (inputs & InputDirectGlossy)
+                m_direct_glossy = shading_components.m_glossy.to_rgb(g_std_lighting_conditions);
+
+            if (inputs & InputIndirectGlossy)
+                m_indirect_glossy = shading_components.m_indirect_glossy.to_rgb(g_std_lighting_conditions);
+
+            if (inputs & InputEmission)
+                m_emission = shading_components.m_emission.to_rgb(g_std_lighting_conditions);
+        }
+    };
+
+    void write_builtin_aov(
+        const AOVWriterKind         kind,
+        const size_t                index,
+        const BuiltinAOVInputs&     inputs,
+        const AOVComponents&        aov_components,
+        ShadingResult&              shading_result)
+    {
+        Color4f& aov = shading_result.m_aovs[index];
+
+        switch (kind)
+        {
+          case AOVWriterKind::Albedo:
+            aov.rgb() = inputs.m_albedo;
+            break;
+
+          case AOVWriterKind::Diffuse:
+            aov.rgb() = inputs.m_direct_diffuse + inputs.m_indirect_diffuse;
+            break;
+
+          case AOVWriterKind::DirectDiffuse:
+            aov.rgb() = inputs.m_direct_diffuse;
+            break;
+
+          case AOVWriterKind::IndirectDiffuse:
+            aov.rgb() = inputs.m_indirect_diffuse;
+            break;
+
+          case AOVWriterKind::Glossy:
+            aov.rgb() = inputs.m_direct_glossy + inputs.m_indirect_glossy;
+            break;
+
+          case AOVWriterKind::DirectGlossy:
+            aov.rgb() = inputs.m_direct_glossy;
+            break;
+
+          case AOVWriterKind::IndirectGlossy:
+            aov.rgb() = inputs.m_indirect_glossy;
+            break;
+
+          case AOVWriterKind::Emission:
+            aov.rgb() = inputs.m_emission;
+            break;
+
+          case AOVWriterKind::NPRShading:
+            aov.rgb() = aov_components.m_npr_shading;
+            break;
+
+          case AOVWriterKind::NPRContour:
+            aov = aov_components.m_npr_contour;
+            return;
+
+          assert_otherwise;
+        }
+
+        aov.a = shading_result.m_main.a;
+    }
+}
+
+
 //
 // AOVAccumulator class implementation.
 //
@@ -61,6 +194,16 @@ void AOVAccumulator::release()
     delete this;
 }
 
+bool AOVAccumulator::supports_sub_tiles() const
+{
+    return true;
+}
+
+AOVWriterKind AOVAccumulator::get_writer_kind() const
+{
+    return AOVWriterKind::Custom;
+}
+
 void AOVAccumulator::on_tile_begin(
     const Frame&                frame,
     const size_t                tile_x,
@@ -149,6 +292,38 @@ void UnfilteredAOVAccumulator::on_tile_end(
 }
 
 
+//
+// BuiltinAOVAccumulator class implementation.
+//
+
+BuiltinAOVAccumulator::BuiltinAOVAccumulator(
+    const AOVWriterKind         kind,
+    const size_t                index)
+  : m_kind(kind)
+  , m_index(index)
+{
+    assert(kind != AOVWriterKind::Custom);
+}
+
+AOVWriterKind BuiltinAOVAccumulator::get_writer_kind() const
+{
+    return m_kind;
+}
+
+void BuiltinAOVAccumulator::write(
+    const PixelContext&         pixel_context,
+    const ShadingPoint&         shading_point,
+    const ShadingComponents&    shading_components,
+    const AOVComponents&        aov_components,
+    ShadingResult&              shading_result)
+{
+    BuiltinAOVInputs inputs;
+    inputs.compute(get_builtin_inputs(m_kind), shading_components, aov_components);
+
+    write_builtin_aov(m_kind, m_index, inputs, aov_components, shading_result);
+}
+
+
 //
 // AOVAccumulatorContainer class implementation.
 //
@@ -181,6 +356,12 @@ void AOVAccumulatorContainer::init()
 {
     m_size = 0;
     memset(m_accumulators, 0, MaxAOVAccumulatorCount * sizeof(AOVAccumulator*));
+
+    m_custom_size = 0;
+    memset(m_custom_accumulators, 0, MaxAOVAccumulatorCount * sizeof(AOVAccumulator*));
+
+    m_builtin_size = 0;
+    m_builtin_inputs = 0;
 }
 
 AOVAccumulatorContainer::~AOVAccumulatorContainer()
@@ -189,6 +370,17 @@ AOVAccumulatorContainer::~AOVAccumulatorContainer()
         delete m_accumulators[i];
 }
 
+bool AOVAccumulatorContainer::supports_sub_tiles() const
+{
+    for (size_t i = 0, e = m_size; i < e; ++i)
+    {
+        if (!m_accumulators[i]->supports_sub_tiles())
+            return false;
+    }
+
+    return true;
+}
+
 void AOVAccumulatorContainer::on_tile_begin(
     const Frame&                frame,
     const size_t                tile_x,
@@ -211,29 +403,29 @@ void AOVAccumulatorContainer::on_tile_end(
 void AOVAccumulatorContainer::on_pixel_begin(
     const Vector2i&             pi)
 {
-    for (size_t i = 0, e = m_size; i < e; ++i)
-        m_accumulators[i]->on_pixel_begin(pi);
+    for (size_t i = 0, e = m_custom_size; i < e; ++i)
+        m_custom_accumulators[i]->on_pixel_begin(pi);
 }
 
 void AOVAccumulatorContainer::on_pixel_end(
     const Vector2i&             pi)
 {
-    for (size_t i = 0, e = m_size; i < e; ++i)
-        m_accumulators[i]->on_pixel_end(pi);
+    for (size_t i = 0, e = m_custom_size; i < e; ++i)
+        m_custom_accumulators[i]->on_pixel_end(pi);
 }
 
 void AOVAccumulatorContainer::on_sample_begin(
     const PixelContext&         pixel_context)
 {
-    for (size_t i = 0, e = m_size; i < e; ++i)
-        m_accumulators[i]->on_sample_begin(pixel_context);
+    for (size_t i = 0, e = m_custom_size; i < e; ++i)
+        m_custom_accumulators[i]->on_sample_begin(pixel_context);
 }
 
 void AOVAccumulatorContainer::on_sample_end(
     const PixelContext&         pixel_context)
 {
-    for (size_t i = 0, e = m_size; i < e; ++i)
-        m_accumulators[i]->on_sample_end(pixel_context);
+    for (size_t i = 0, e = m_custom_size; i < e; ++i)
+        m_custom_accumulators[i]->on_sample_end(pixel_context);
 }
 
 void AOVAccumulatorContainer::write(
@@ -243,9 +435,26 @@ void AOVAccumulatorContainer::write(
     const AOVComponents&        aov_components,
     ShadingResult&              shading_result)
 {
-    for (size_t i = 0, e = m_size; i < e; ++i)
+    if (m_builtin_size > 0)
     {
-        m_accumulators[i]->write(
+        BuiltinAOVInputs inputs;
+        inputs.compute(m_builtin_inputs, shading_components, aov_components);
+
+        for (size_t i = 0, e = m_builtin_size; i < e; ++i)
+        {
+            const BuiltinWriter& writer = m_builtin_writers[i];
+            write_builtin_aov(
+                writer.m_kind,
+                writer.m_index,
+                inputs,
+                aov_components,
+                shading_result);
+        }
+    }
+
+    for (size_t i = 0, e = m_custom_size; i < e; ++i)
+    {
+        m_custom_accumulators[i]->write(
             pixel_context,
             shading_point,
             shading_components,
@@ -261,7 +470,21 @@ bool AOVAccumulatorContainer::insert(auto_release_ptr<AOVAccumulator> aov_accum)
     if (m_size + 1 == MaxAOVAccumulatorCount)
         return false;
 
-    m_accumulators[m_size++] = aov_accum.release();
+    AOVAccumulator* accumulator = aov_accum.release();
+    m_accumulators[m_size++] = accumulator;
+
+    const AOVWriterKind kind = accumulator->get_writer_kind();
+
+    if (kind == AOVWriterKind::Custom)
+        m_custom_accumulators[m_custom_size++] = accumulator;
+    else
+    {
+        BuiltinWriter& writer = m_builtin_writers[m_builtin_size++];
+        writer.m_kind = kind;
+        writer.m_index = static_cast<const BuiltinAOVAccumulator*>(accumulator)->get_index();
+        m_builtin_inputs |= get_builtin_inputs(kind);
+    }
+
     return true;
 }
 
@@ -40,6 +40,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 
 // Forward declarations.
 namespace foundation    { class Image; }
@@ -54,6 +55,31 @@ namespace renderer      { class ShadingResult; }
 namespace renderer
 {
 
+//
+// Kinds of AOV writers.
+//
+// Most AOVs copy a component of the shading result to their channel of the shading
+// result. Their accumulators identify this component with a writer kind instead of
+// implementing write(), so that AOVAccumulatorContainer can write all of them in a
+// single loop, without virtual calls, and convert each component to RGB only once.
+//
+
+enum class AOVWriterKind
+{
+    Custom,                         // the accumulator implements write()
+    Albedo,
+    Diffuse,                        // direct + indirect diffuse
+    DirectDiffuse,
+    IndirectDiffuse,
+    Glossy,                         // direct + indirect glossy
+    DirectGlossy,
+    IndirectGlossy,
+    Emission,
+    NPRShading,
+    NPRContour
+};
+
+
 //
 // AOV accumulator base class.
 //
@@ -68,6 +94,14 @@ class AOVAccumulator
     // Delete this instance.
     void release();
 
+    // Return true if tiles can be rendered in several parts, possibly concurrently
+    // by different threads. The default implementation returns true.
+    virtual bool supports_sub_tiles() const;
+
+    // Return the kind of writer of this accumulator.
+    // The default implementation returns AOVWriterKind::Custom.
+    virtual AOVWriterKind get_writer_kind() const;
+
     // This method is called before a tile gets rendered.
     virtual void on_tile_begin(
         const Frame&                frame,
@@ -140,6 +174,40 @@ class UnfilteredAOVAccumulator
 };
 
 
+//
+// Accumulator for AOVs with a built-in writer.
+//
+// AOVAccumulatorContainer only forwards tile events to these accumulators and
+// writes their AOV itself.
+//
+
+class BuiltinAOVAccumulator
+  : public AOVAccumulator
+{
+  public:
+    // Constructor.
+    BuiltinAOVAccumulator(
+        const AOVWriterKind         kind,
+        const size_t                index);             // index of the AOV in ShadingResult::m_aovs
+
+    AOVWriterKind get_writer_kind() const override;
+
+    size_t get_index() const;
+
+    // Write this AOV alone.
+    void write(
+        const PixelContext&         pixel_context,
+        const ShadingPoint&         shading_point,
+        const ShadingComponents&    shading_components,
+        const AOVComponents&        aov_components,
+        ShadingResult&              shading_result) override;
+
+  private:
+    const AOVWriterKind             m_kind;
+    const size_t                    m_index;
+};
+
+
 //
 // A collection of AOV accumulators.
 //
@@ -155,6 +223,9 @@ class AOVAccumulatorContainer
     // Destructor.
     ~AOVAccumulatorContainer();
 
+    // Return true if all accumulators support tiles rendered in several parts.
+    bool supports_sub_tiles() const;
+
     // This method is called before a tile gets rendered.
     void on_tile_begin(
         const Frame&                frame,
@@ -198,8 +269,34 @@ class AOVAccumulatorContainer
 
     enum { MaxAOVAccumulatorCount = MaxAOVCount + 1 };  // MaxAOVCount + Beauty
 
+    struct BuiltinWriter
+    {
+        AOVWriterKind   m_kind;
+        size_t          m_index;
+    };
+
+    // All accumulators.
     size_t          m_size;
     AOVAccumulator* m_accumulators[MaxAOVAccumulatorCount];
+
+    // Accumulators implementing write() and receiving all events.
+    size_t          m_custom_size;
+    AOVAccumulator* m_custom_accumulators[MaxAOVAccumulatorCount];
+
+    // Flat table of built-in writers, and the shading components they need.
+    size_t          m_builtin_size;
+    BuiltinWriter   m_builtin_writers[MaxAOVAccumulatorCount];
+    std::uint32_t   m_builtin_inputs;
 };
 
+
+//
+// BuiltinAOVAccumulator class implementation.
+//
+
+inline size_t BuiltinAOVAccumulator::get_index() const
+{
+    return m_index;
+}
+
 }   // namespace renderer
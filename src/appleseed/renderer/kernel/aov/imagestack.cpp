@@ -32,9 +32,11 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/aov/tilestack.h"
+#include "renderer/utility/filesystem.h"
 
 // appleseed.foundation headers.
 #include "foundation/image/image.h"
+#include "foundation/image/outofcoreimage.h"
 
 // Standard headers.
 #include <cassert>
@@ -53,6 +55,9 @@ struct ImageStack::Impl
     size_t                  m_canvas_height;
     size_t                  m_tile_width;
     size_t                  m_tile_height;
+    bool                    m_out_of_core;
+    std::string             m_scratch_directory;
+    size_t                  m_max_cached_tiles;
 
     struct NamedImage
     {
@@ -74,6 +79,8 @@ ImageStack::ImageStack(
     impl->m_canvas_height = canvas_height;
     impl->m_tile_width = tile_width;
     impl->m_tile_height = tile_height;
+    impl->m_out_of_core = false;
+    impl->m_max_cached_tiles = 0;
 }
 
 ImageStack::~ImageStack()
@@ -83,6 +90,15 @@ ImageStack::~ImageStack()
     delete impl;
 }
 
+void ImageStack::enable_out_of_core_storage(
+    const char*             scratch_directory,
+    const size_t            max_cached_tiles)
+{
+    impl->m_out_of_core = true;
+    impl->m_scratch_directory = scratch_directory;
+    impl->m_max_cached_tiles = max_cached_tiles;
+}
+
 void ImageStack::clear()
 {
     const size_t size = impl->m_images.size();
@@ -143,13 +159,23 @@ size_t ImageStack::append(
 
     named_image.m_name = name;
     named_image.m_image =
-        new Image(
-            impl->m_canvas_width,
-            impl->m_canvas_height,
-            impl->m_tile_width,
-            impl->m_tile_height,
-            channel_count,
-            pixel_format);
+        impl->m_out_of_core
+            ? new OutOfCoreImage(
+                  impl->m_canvas_width,
+                  impl->m_canvas_height,
+                  impl->m_tile_width,
+                  impl->m_tile_height,
+                  channel_count,
+                  pixel_format,
+                  make_scratch_file_path(impl->m_scratch_directory).c_str(),
+                  impl->m_max_cached_tiles)
+            : new Image(
+                  impl->m_canvas_width,
+                  impl->m_canvas_height,
+                  impl->m_tile_width,
+                  impl->m_tile_height,
+                  channel_count,
+                  pixel_format);
 
     const size_t aov_index = impl->m_images.size();
 
@@ -62,6 +62,13 @@ class APPLESEED_DLLSYMBOL ImageStack
 
     ~ImageStack();
 
+    // Store the images appended from now on in scratch files in a given directory
+    // (see foundation::OutOfCoreImage). An empty directory means the system's
+    // temporary directory.
+    void enable_out_of_core_storage(
+        const char*                     scratch_directory,
+        const size_t                    max_cached_tiles);
+
     void clear();
 
     bool empty() const;
@@ -0,0 +1,169 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "compacthistogrambuffer.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+
+namespace renderer
+{
+
+namespace
+{
+    const float MaxQuantizedCount = 65535.0f;
+    const size_t MaxBinCount = 256;
+}
+
+CompactHistogramBuffer::CompactHistogramBuffer()
+  : m_width(0)
+  , m_height(0)
+  , m_bin_count(0)
+{
+}
+
+void CompactHistogramBuffer::resize(
+    const size_t    width,
+    const size_t    height,
+    const size_t    bin_count)
+{
+    assert(bin_count <= MaxBinCount);
+
+    m_width = width;
+    m_height = height;
+    m_bin_count = bin_count;
+
+    const size_t pixel_count = width * height;
+    m_bins.resize(pixel_count * bin_count);
+    m_scales.resize(pixel_count);
+    m_sample_counts.resize(pixel_count);
+
+    clear();
+}
+
+void CompactHistogramBuffer::clear()
+{
+    std::fill(m_bins.begin(), m_bins.end(), std::uint16_t(0));
+    std::fill(m_scales.begin(), m_scales.end(), 0.0f);
+    std::fill(m_sample_counts.begin(), m_sample_counts.end(), 0.0f);
+}
+
+void CompactHistogramBuffer::get_bins(
+    const size_t    x,
+    const size_t    y,
+    float           bins[]) const
+{
+    assert(x < m_width);
+    assert(y < m_height);
+
+    const size_t pixel_index = y * m_width + x;
+    const std::uint16_t* src = &m_bins[pixel_index * m_bin_count];
+    const float scale = m_scales[pixel_index];
+
+    for (size_t i = 0; i < m_bin_count; ++i)
+        bins[i] = src[i] * scale;
+}
+
+void CompactHistogramBuffer::set(
+    const size_t    x,
+    const size_t    y,
+    const float     bins[],
+    const float     sample_count)
+{
+    assert(x < m_width);
+    assert(y < m_height);
+
+    const size_t pixel_index = y * m_width + x;
+
+    encode(pixel_index, bins);
+    m_sample_counts[pixel_index] = sample_count;
+}
+
+void CompactHistogramBuffer::add(
+    const size_t    x,
+    const size_t    y,
+    const float     bins[],
+    const float     sample_count)
+{
+    assert(x < m_width);
+    assert(y < m_height);
+
+    const size_t pixel_index = y * m_width + x;
+
+    float sum[MaxBinCount];
+    get_bins(x, y, sum);
+
+    for (size_t i = 0; i < m_bin_count; ++i)
+        sum[i] += bins[i];
+
+    encode(pixel_index, sum);
+    m_sample_counts[pixel_index] += sample_count;
+}
+
+size_t CompactHistogramBuffer::get_memory_size() const
+{
+    return
+        sizeof(*this) +
+        m_bins.capacity() * sizeof(std::uint16_t) +
+        m_scales.capacity() * sizeof(float) +
+        m_sample_counts.capacity() * sizeof(float);
+}
+
+void CompactHistogramBuffer::encode(
+    const size_t    pixel_index,
+    const float     bins[])
+{
+    std::uint16_t* dst = &m_bins[pixel_index * m_bin_count];
+
+    float max_value = 0.0f;
+    for (size_t i = 0; i < m_bin_count; ++i)
+        max_value = std::max(max_value, bins[i]);
+
+    if (max_value == 0.0f)
+    {
+        std::fill(dst, dst + m_bin_count, std::uint16_t(0));
+        m_scales[pixel_index] = 0.0f;
+        return;
+    }
+
+    // The largest bin is mapped to the largest 16-bit count.
+    const float scale = max_value / MaxQuantizedCount;
+    const float rcp_scale = MaxQuantizedCount / max_value;
+
+    for (size_t i = 0; i < m_bin_count; ++i)
+    {
+        const float count = std::max(bins[i], 0.0f) * rcp_scale + 0.5f;
+        dst[i] = static_cast<std::uint16_t>(std::min(count, MaxQuantizedCount));
+    }
+
+    m_scales[pixel_index] = scale;
+}
+
+}   // namespace renderer
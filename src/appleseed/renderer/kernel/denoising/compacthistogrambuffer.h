@@ -0,0 +1,140 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A compact per-pixel storage for the sample histograms of the BCD denoiser.
+//
+// The bins of each pixel are stored as 16-bit counts normalized to the largest bin
+// of the pixel, together with a single floating-point scale per pixel. This halves
+// the memory footprint of float histograms. Since requantization costs a full pass
+// over the bins of a pixel, histograms should be accumulated at full precision
+// elsewhere (e.g. per tile) and merged into the buffer in batches.
+//
+
+class CompactHistogramBuffer
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    CompactHistogramBuffer();
+
+    // Resize the buffer. Its content is cleared.
+    void resize(
+        const size_t    width,
+        const size_t    height,
+        const size_t    bin_count);
+
+    // Set all bins and sample counts to zero.
+    void clear();
+
+    size_t get_width() const;
+    size_t get_height() const;
+    size_t get_bin_count() const;
+
+    // Return the number of samples accumulated in a given pixel.
+    float get_sample_count(
+        const size_t    x,
+        const size_t    y) const;
+
+    // Retrieve the bins of a given pixel. `bins` must hold get_bin_count() values.
+    void get_bins(
+        const size_t    x,
+        const size_t    y,
+        float           bins[]) const;
+
+    // Replace the bins and the sample count of a given pixel.
+    void set(
+        const size_t    x,
+        const size_t    y,
+        const float     bins[],
+        const float     sample_count);
+
+    // Add bins and a sample count to a given pixel.
+    void add(
+        const size_t    x,
+        const size_t    y,
+        const float     bins[],
+        const float     sample_count);
+
+    // Return the size in bytes of the buffer.
+    size_t get_memory_size() const;
+
+  private:
+    size_t                      m_width;
+    size_t                      m_height;
+    size_t                      m_bin_count;
+    std::vector<std::uint16_t>  m_bins;
+    std::vector<float>          m_scales;
+    std::vector<float>          m_sample_counts;
+
+    void encode(
+        const size_t    pixel_index,
+        const float     bins[]);
+};
+
+
+//
+// CompactHistogramBuffer class implementation.
+//
+
+inline size_t CompactHistogramBuffer::get_width() const
+{
+    return m_width;
+}
+
+inline size_t CompactHistogramBuffer::get_height() const
+{
+    return m_height;
+}
+
+inline size_t CompactHistogramBuffer::get_bin_count() const
+{
+    return m_bin_count;
+}
+
+inline float CompactHistogramBuffer::get_sample_count(
+    const size_t    x,
+    const size_t    y) const
+{
+    return m_sample_counts[y * m_width + x];
+}
+
+}   // namespace renderer
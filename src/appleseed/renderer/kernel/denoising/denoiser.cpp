@@ -31,11 +31,18 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
+#include "renderer/modeling/aov/denoiseraov.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
 #include "foundation/image/color.h"
 #include "foundation/image/image.h"
-#include "foundation/utility/job/iabortswitch.h"
+#include "foundation/platform/system.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/job.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
 
 // BCD headers.
 #include "bcd/DeepImage.h"
@@ -46,6 +53,7 @@
 #include "bcd/Utils.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cmath>
 #include <memory>
 #include <vector>
@@ -203,6 +211,210 @@ namespace
         return denoiser->denoise();
     }
 
+    void extract_tile(
+        const Deepimf&          src,
+        const int               x0,
+        const int               y0,
+        const int               width,
+        const int               height,
+        Deepimf&                dst)
+    {
+        dst.resize(width, height, 3);
+
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                for (int k = 0; k < 3; ++k)
+                    dst.set(y, x, k, src.get(y0 + y, x0 + x, k));
+            }
+        }
+    }
+
+    // Write the pixels [x0, x0 + width) x [y0, y0 + height) of a tile whose origin
+    // in the frame is (tile_x0, tile_y0) back into an image.
+    void write_tile(
+        const Deepimf&          src,
+        const int               tile_x0,
+        const int               tile_y0,
+        const int               x0,
+        const int               y0,
+        const int               width,
+        const int               height,
+        Image&                  dst)
+    {
+        for (int y = y0; y < y0 + height; ++y)
+        {
+            for (int x = x0; x < x0 + width; ++x)
+            {
+                const size_t ix = static_cast<size_t>(x);
+                const size_t iy = static_cast<size_t>(y);
+
+                Color4f c;
+                dst.get_pixel(ix, iy, c);
+
+                c[0] = src.get(y - tile_y0, x - tile_x0, 0);
+                c[1] = src.get(y - tile_y0, x - tile_x0, 1);
+                c[2] = src.get(y - tile_y0, x - tile_x0, 2);
+
+                c.premultiply_in_place();
+                dst.set_pixel(ix, iy, c);
+            }
+        }
+    }
+
+    struct TiledDenoisingContext
+    {
+        TiledDenoisingContext(
+            Image&                      beauty_img,
+            const std::vector<Image*>&  aov_images,
+            const Deepimf&              beauty_src,
+            const std::vector<Deepimf>& aov_srcs,
+            const DenoiserAOV&          denoiser_aov,
+            const DenoiserOptions&      options,
+            IAbortSwitch*               abort_switch)
+          : m_beauty_img(beauty_img)
+          , m_aov_images(aov_images)
+          , m_beauty_src(beauty_src)
+          , m_aov_srcs(aov_srcs)
+          , m_denoiser_aov(denoiser_aov)
+          , m_options(options)
+          , m_abort_switch(abort_switch)
+          , m_success(true)
+        {
+        }
+
+        Image&                          m_beauty_img;
+        const std::vector<Image*>&      m_aov_images;
+        const Deepimf&                  m_beauty_src;
+        const std::vector<Deepimf>&     m_aov_srcs;
+        const DenoiserAOV&              m_denoiser_aov;
+        DenoiserOptions                 m_options;
+        IAbortSwitch*                   m_abort_switch;
+        boost::atomic<bool>             m_success;
+    };
+
+    class DenoiseTileJob
+      : public IJob
+    {
+      public:
+        DenoiseTileJob(
+            TiledDenoisingContext&      context,
+            const int                   x0,
+            const int                   y0,
+            const int                   width,
+            const int                   height,
+            const int                   border)
+          : m_context(context)
+          , m_x0(x0)
+          , m_y0(y0)
+          , m_width(width)
+          , m_height(height)
+          , m_border(border)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            if (!m_context.m_success || is_aborted(m_context.m_abort_switch))
+                return;
+
+            const DenoiserOptions& options = m_context.m_options;
+
+            // Compute the extent of the tile including its border.
+            const int frame_width = m_context.m_beauty_src.getWidth();
+            const int frame_height = m_context.m_beauty_src.getHeight();
+            const int tile_x0 = std::max(m_x0 - m_border, 0);
+            const int tile_y0 = std::max(m_y0 - m_border, 0);
+            const int tile_x1 = std::min(m_x0 + m_width + m_border, frame_width);
+            const int tile_y1 = std::min(m_y0 + m_height + m_border, frame_height);
+            const int tile_width = tile_x1 - tile_x0;
+            const int tile_height = tile_y1 - tile_y0;
+
+            // Fetch the denoiser inputs of this tile.
+            Deepimf num_samples, histograms, covariances;
+            m_context.m_denoiser_aov.extract_num_samples_image(tile_x0, tile_y0, tile_width, tile_height, num_samples);
+            m_context.m_denoiser_aov.extract_histograms_image(tile_x0, tile_y0, tile_width, tile_height, histograms);
+            m_context.m_denoiser_aov.compute_covariances_image(tile_x0, tile_y0, tile_width, tile_height, covariances);
+
+            // Denoise the beauty image.
+            {
+                Deepimf src;
+                extract_tile(m_context.m_beauty_src, tile_x0, tile_y0, tile_width, tile_height, src);
+
+                if (options.m_prefilter_spikes)
+                {
+                    SpikeRemovalFilter::filter(
+                        src,
+                        num_samples,
+                        histograms,
+                        covariances,
+                        options.m_prefilter_threshold_stddev_factor);
+                }
+
+                if (!denoise_tile(src, num_samples, histograms, covariances, tile_x0, tile_y0, m_context.m_beauty_img))
+                    return;
+            }
+
+            // Denoise the AOV images.
+            for (size_t i = 0, e = m_context.m_aov_images.size(); i < e; ++i)
+            {
+                Deepimf src;
+                extract_tile(m_context.m_aov_srcs[i], tile_x0, tile_y0, tile_width, tile_height, src);
+
+                if (options.m_prefilter_spikes)
+                {
+                    SpikeRemovalFilter::filter(
+                        src,
+                        options.m_prefilter_threshold_stddev_factor);
+                }
+
+                if (!denoise_tile(src, num_samples, histograms, covariances, tile_x0, tile_y0, *m_context.m_aov_images[i]))
+                    return;
+            }
+        }
+
+      private:
+        TiledDenoisingContext&  m_context;
+        const int               m_x0;
+        const int               m_y0;
+        const int               m_width;
+        const int               m_height;
+        const int               m_border;
+
+        bool denoise_tile(
+            Deepimf&            src,
+            const Deepimf&      num_samples,
+            const Deepimf&      histograms,
+            const Deepimf&      covariances,
+            const int           tile_x0,
+            const int           tile_y0,
+            Image&              img)
+        {
+            Deepimf dst(src);
+
+            const bool success =
+                do_denoise_image(
+                    src,
+                    num_samples,
+                    histograms,
+                    covariances,
+                    m_context.m_options,
+                    m_context.m_abort_switch,
+                    dst);
+
+            if (!success)
+            {
+                m_context.m_success = false;
+                return false;
+            }
+
+            // Only keep the pixels that are not part of the border.
+            write_tile(dst, tile_x0, tile_y0, m_x0, m_y0, m_width, m_height, img);
+
+            return true;
+        }
+    };
 }
 
 bool denoise_beauty_image(
@@ -244,6 +456,87 @@ bool denoise_beauty_image(
     return success;
 }
 
+bool denoise_images_tiled(
+    Image&                      beauty_img,
+    const std::vector<Image*>&  aov_images,
+    const DenoiserAOV&          denoiser_aov,
+    const DenoiserOptions&      options,
+    IAbortSwitch*               abort_switch)
+{
+    assert(options.m_tile_size > 0);
+
+    // Take a copy of the source images since tiles read pixels of their neighbors
+    // while denoised pixels are being written back.
+    Deepimf beauty_src;
+    image_to_deepimage(beauty_img, beauty_src);
+
+    std::vector<Deepimf> aov_srcs(aov_images.size());
+    for (size_t i = 0, e = aov_images.size(); i < e; ++i)
+        image_to_deepimage(*aov_images[i], aov_srcs[i]);
+
+    const size_t thread_count =
+        options.m_num_cores > 0
+            ? options.m_num_cores
+            : System::get_logical_cpu_core_count();
+
+    TiledDenoisingContext context(
+        beauty_img,
+        aov_images,
+        beauty_src,
+        aov_srcs,
+        denoiser_aov,
+        options,
+        abort_switch);
+
+    // Tiles are denoised concurrently, each on a single thread.
+    context.m_options.m_num_cores = 1;
+
+    // The border must cover the patches and the search windows at the coarsest scale.
+    const size_t scale_factor = size_t(1) << (std::max<size_t>(options.m_num_scales, 1) - 1);
+    const int border =
+        static_cast<int>((options.m_patch_radius + options.m_search_window_radius + 1) * scale_factor);
+
+    const int frame_width = beauty_src.getWidth();
+    const int frame_height = beauty_src.getHeight();
+    const int tile_size = static_cast<int>(options.m_tile_size);
+
+    JobQueue job_queue;
+    JobManager job_manager(global_logger(), job_queue, thread_count);
+
+    size_t tile_count = 0;
+
+    for (int y = 0; y < frame_height; y += tile_size)
+    {
+        for (int x = 0; x < frame_width; x += tile_size)
+        {
+            job_queue.schedule(
+                new DenoiseTileJob(
+                    context,
+                    x,
+                    y,
+                    std::min(tile_size, frame_width - x),
+                    std::min(tile_size, frame_height - y),
+                    border));
+            ++tile_count;
+        }
+    }
+
+    RENDERER_LOG_DEBUG(
+        "denoising %s %s of %dx%d pixels with a border of %d pixels using %s %s...",
+        pretty_uint(tile_count).c_str(),
+        plural(tile_count, "tile").c_str(),
+        tile_size,
+        tile_size,
+        border,
+        pretty_uint(thread_count).c_str(),
+        plural(thread_count, "thread").c_str());
+
+    job_manager.start();
+    job_queue.wait_until_completion();
+
+    return context.m_success && !is_aborted(abort_switch);
+}
+
 bool denoise_aov_image(
     Image&                  img,
     const Deepimf&          num_samples,
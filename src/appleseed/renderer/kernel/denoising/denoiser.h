@@ -31,9 +31,14 @@
 // BCD headers.
 #include "bcd/DeepImage.h"
 
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
 namespace foundation    { class Image; }
+namespace renderer      { class DenoiserAOV; }
 
 namespace renderer
 {
@@ -52,6 +57,7 @@ class DenoiserOptions
     size_t  m_num_scales;                         //  number of pyramid levels to use.
     size_t  m_num_cores;                          //  number of cores used to denoise. O means using all the cores available.
     bool    m_mark_invalid_pixels;
+    size_t  m_tile_size;                          //  size in pixels of the tiles denoised independently; 0 means denoising whole images
 
     DenoiserOptions()
       : m_histogram_patch_distance_threshold(1.0f)
@@ -65,6 +71,7 @@ class DenoiserOptions
       , m_num_scales(3)
       , m_num_cores(0)
       , m_mark_invalid_pixels(false)
+      , m_tile_size(0)
     {
     }
 };
@@ -85,4 +92,15 @@ bool denoise_aov_image(
     const DenoiserOptions&      options,
     foundation::IAbortSwitch*   abort_switch);
 
+// Denoise the beauty image and a set of AOV images one tile at a time. The inputs of each
+// tile, including a border wide enough to cover the denoiser's patches and search windows,
+// are extracted from the denoiser AOV when the tile is processed. Tiles are denoised in
+// parallel using options.m_num_cores threads.
+bool denoise_images_tiled(
+    foundation::Image&                      beauty_img,
+    const std::vector<foundation::Image*>&  aov_images,
+    const DenoiserAOV&                      denoiser_aov,
+    const DenoiserOptions&                  options,
+    foundation::IAbortSwitch*               abort_switch);
+
 }   // namespace renderer
@@ -0,0 +1,224 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "oidndenoiser.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/utility/job/iabortswitch.h"
+
+// OpenImageDenoise headers.
+#include <OpenImageDenoise/oidn.hpp>
+
+// Standard headers.
+#include <cassert>
+#include <vector>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    bool progress_monitor(void* user_ptr, const double progress)
+    {
+        // Returning false cancels the filter.
+        return !is_aborted(static_cast<IAbortSwitch*>(user_ptr));
+    }
+
+    // Extract the unpremultiplied RGB channels of a premultiplied RGBA image.
+    void extract_color_pixels(const Image& src, std::vector<float>& dst)
+    {
+        const CanvasProperties& src_props = src.properties();
+        assert(src_props.m_channel_count == 4);
+
+        dst.resize(src_props.m_pixel_count * 3);
+
+        float* ptr = dst.data();
+
+        for (size_t j = 0; j < src_props.m_canvas_height; ++j)
+        {
+            for (size_t i = 0; i < src_props.m_canvas_width; ++i)
+            {
+                Color4f c;
+                src.get_pixel(i, j, c);
+                c.unpremultiply_in_place();
+
+                *ptr++ = c[0];
+                *ptr++ = c[1];
+                *ptr++ = c[2];
+            }
+        }
+    }
+
+    // Extract and decode the normals stored in a normal AOV image.
+    void extract_normal_pixels(const Image& src, std::vector<float>& dst)
+    {
+        const CanvasProperties& src_props = src.properties();
+        assert(src_props.m_channel_count >= 3);
+
+        dst.resize(src_props.m_pixel_count * 3);
+
+        float* ptr = dst.data();
+
+        for (size_t j = 0; j < src_props.m_canvas_height; ++j)
+        {
+            for (size_t i = 0; i < src_props.m_canvas_width; ++i)
+            {
+                Color3f c;
+                src.get_pixel(i, j, c);
+
+                *ptr++ = 2.0f * c[0] - 1.0f;
+                *ptr++ = 2.0f * c[1] - 1.0f;
+                *ptr++ = 2.0f * c[2] - 1.0f;
+            }
+        }
+    }
+
+    // Replace the RGB channels of a premultiplied RGBA image, keeping its alpha channel.
+    void write_color_pixels(const std::vector<float>& src, Image& dst)
+    {
+        const CanvasProperties& dst_props = dst.properties();
+        assert(dst_props.m_channel_count == 4);
+        assert(src.size() == dst_props.m_pixel_count * 3);
+
+        const float* ptr = src.data();
+
+        for (size_t j = 0; j < dst_props.m_canvas_height; ++j)
+        {
+            for (size_t i = 0; i < dst_props.m_canvas_width; ++i)
+            {
+                Color4f c;
+                dst.get_pixel(i, j, c);
+
+                c[0] = *ptr++;
+                c[1] = *ptr++;
+                c[2] = *ptr++;
+
+                c.premultiply_in_place();
+                dst.set_pixel(i, j, c);
+            }
+        }
+    }
+
+    bool has_same_dimensions(const Image& lhs, const Image& rhs)
+    {
+        return
+            lhs.properties().m_canvas_width == rhs.properties().m_canvas_width &&
+            lhs.properties().m_canvas_height == rhs.properties().m_canvas_height;
+    }
+}
+
+
+//
+// OIDNDenoiser class implementation.
+//
+
+struct OIDNDenoiser::Impl
+{
+    oidn::DeviceRef m_device;
+};
+
+OIDNDenoiser::OIDNDenoiser(const size_t thread_count)
+  : impl(new Impl())
+{
+    // Creating the device is expensive, so it is kept alive across calls to denoise().
+    impl->m_device = oidn::newDevice();
+
+    if (thread_count > 0)
+        impl->m_device.set("numThreads", static_cast<int>(thread_count));
+
+    impl->m_device.commit();
+}
+
+OIDNDenoiser::~OIDNDenoiser()
+{
+    delete impl;
+}
+
+bool OIDNDenoiser::denoise(
+    Image&                  img,
+    const Image*            albedo,
+    const Image*            normal,
+    IAbortSwitch*           abort_switch)
+{
+    const CanvasProperties& props = img.properties();
+    const size_t width = props.m_canvas_width;
+    const size_t height = props.m_canvas_height;
+
+    std::vector<float> color_pixels;
+    extract_color_pixels(img, color_pixels);
+
+    std::vector<float> output_pixels(color_pixels.size());
+
+    oidn::FilterRef filter = impl->m_device.newFilter("RT");
+    filter.setImage("color", color_pixels.data(), oidn::Format::Float3, width, height);
+    filter.setImage("output", output_pixels.data(), oidn::Format::Float3, width, height);
+    filter.set("hdr", true);
+
+    // Normals can only be used in conjunction with albedo.
+    std::vector<float> albedo_pixels, normal_pixels;
+    if (albedo != nullptr && has_same_dimensions(img, *albedo))
+    {
+        extract_color_pixels(*albedo, albedo_pixels);
+        filter.setImage("albedo", albedo_pixels.data(), oidn::Format::Float3, width, height);
+
+        if (normal != nullptr && has_same_dimensions(img, *normal))
+        {
+            extract_normal_pixels(*normal, normal_pixels);
+            filter.setImage("normal", normal_pixels.data(), oidn::Format::Float3, width, height);
+        }
+    }
+
+    if (abort_switch != nullptr)
+        filter.setProgressMonitorFunction(progress_monitor, abort_switch);
+
+    filter.commit();
+    filter.execute();
+
+    const char* error_message;
+    if (impl->m_device.getError(error_message) != oidn::Error::None)
+    {
+        if (!is_aborted(abort_switch))
+            RENDERER_LOG_ERROR("open image denoise failed: %s", error_message);
+        return false;
+    }
+
+    write_color_pixels(output_pixels, img);
+
+    return true;
+}
+
+}   // namespace renderer
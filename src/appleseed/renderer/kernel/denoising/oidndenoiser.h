@@ -0,0 +1,77 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class IAbortSwitch; }
+namespace foundation    { class Image; }
+
+namespace renderer
+{
+
+//
+// Denoiser based on Intel Open Image Denoise.
+//
+// Unlike the BCD denoiser, it does not need per-pixel sample statistics: it only uses
+// the image to denoise and, optionally, albedo and normal images as auxiliary features.
+// It is fast enough to be run on progressive frame updates.
+//
+
+class OIDNDenoiser
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. A thread count of 0 lets the library use all available cores.
+    explicit OIDNDenoiser(const size_t thread_count = 0);
+
+    // Destructor.
+    ~OIDNDenoiser();
+
+    // Denoise a premultiplied RGBA image in place. The albedo and normal images are
+    // optional; the normal image is expected to be encoded as in the normal AOV, that
+    // is n * 0.5 + 0.5. Normals are ignored if no albedo image is given.
+    // Returns true if successful, false otherwise.
+    bool denoise(
+        foundation::Image&          img,
+        const foundation::Image*    albedo,
+        const foundation::Image*    normal,
+        foundation::IAbortSwitch*   abort_switch);
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}   // namespace renderer
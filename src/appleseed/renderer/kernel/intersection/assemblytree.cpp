@@ -35,9 +35,12 @@
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/modeling/camera/camera.h"
 #include "renderer/modeling/entity/entityvector.h"
+#include "renderer/modeling/material/material.h"
 #include "renderer/modeling/object/curveobject.h"
 #include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/meshobjectoperations.h"
 #include "renderer/modeling/object/object.h"
 #include "renderer/modeling/object/proceduralobject.h"
 #include "renderer/modeling/scene/assemblyinstance.h"
@@ -46,17 +49,24 @@
 #include "renderer/utility/bbox.h"
 
 // appleseed.foundation headers.
+#include "foundation/hash/murmurhash.h"
 #include "foundation/hash/siphash.h"
 #include "foundation/math/beziercurve.h"
 #include "foundation/math/permutation.h"
 #include "foundation/math/ray.h"
+#include "foundation/math/scalar.h"
 #include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
 #include "foundation/memory/alignedallocator.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
 #include "foundation/platform/system.h"
 #include "foundation/platform/timers.h"
 #include "foundation/string/string.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/foreach.h"
+#include "foundation/utility/job.h"
 #include "foundation/utility/lazy.h"
 #include "foundation/utility/statistics.h"
 
@@ -67,6 +77,7 @@
 #include <cstring>
 #include <set>
 #include <utility>
+#include <vector>
 
 using namespace foundation;
 
@@ -78,8 +89,10 @@ namespace renderer
 //
 
 AssemblyTree::AssemblyTree(const Scene& scene)
-  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
+  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size(), true))
   , m_scene(scene)
+  , m_built_sah_cost(0.0)
+  , m_tracked_memory("acceleration structures")
 #ifdef APPLESEED_WITH_EMBREE
   , m_use_embree(false)
   , m_dirty(false)
@@ -94,8 +107,27 @@ AssemblyTree::~AssemblyTree()
 
 void AssemblyTree::update()
 {
-    rebuild_assembly_tree();
+#ifdef APPLESEED_WITH_EMBREE
+    // The instance scene refers to Embree scenes that may be deleted below.
+    m_embree_instance_scene.reset();
+#endif
+
+    // Retrieve the memory budget of the triangle trees built on demand (0 means unlimited).
+    m_triangle_tree_budget.set_max_size(
+        m_scene.get_parameters().child("acceleration_structure").get_optional<size_t>("triangle_tree_memory_budget", 0));
+
+    if (!refit_assembly_tree())
+        rebuild_assembly_tree();
+
     update_tree_hierarchy();
+
+#ifdef APPLESEED_WITH_EMBREE
+    if (use_embree() &&
+        m_scene.get_parameters().child("acceleration_structure").get_optional<bool>("embree_instancing", false))
+        build_embree_instance_scene();
+#endif
+
+    m_tracked_memory.set_size(get_memory_size());
 }
 
 size_t AssemblyTree::get_memory_size() const
@@ -104,15 +136,121 @@ size_t AssemblyTree::get_memory_size() const
           TreeType::get_memory_size()
         - sizeof(*static_cast<const TreeType*>(this))
         + sizeof(*this)
-        + m_items.capacity() * sizeof(AssemblyInstance*)
+        + m_node_bboxes.capacity() * sizeof(AABB3d)
+        + m_items.capacity() * sizeof(Item)
+        + m_transform_sequences.size() * sizeof(TransformSequence)
+        + m_static_transforms.capacity() * sizeof(StaticTransform)
+        + m_item_instance_uids.capacity() * sizeof(UniqueID)
+        + m_item_ordering.capacity() * sizeof(size_t)
         + m_assembly_versions.size() * sizeof(std::pair<UniqueID, VersionID>);
 }
 
+namespace
+{
+    bool get_shutter_interval(const Scene& scene, float& shutter_open, float& shutter_close)
+    {
+        const Camera* camera = scene.get_render_data().m_active_camera;
+        if (camera == nullptr)
+            return false;
+
+        shutter_open = camera->get_shutter_open_begin_time();
+        shutter_close = camera->get_shutter_close_end_time();
+
+        return shutter_open < shutter_close;
+    }
+
+    // Return the number of motion segments needed to bound a transform sequence over a time interval.
+    size_t get_motion_segment_count(
+        const TransformSequence&    transform_seq,
+        const float                 time_begin,
+        const float                 time_end)
+    {
+        if (transform_seq.size() < 2)
+            return 0;
+
+        size_t inner_key_count = 0;
+
+        for (size_t i = 0, e = transform_seq.size(); i < e; ++i)
+        {
+            float time;
+            Transformd transform;
+            transform_seq.get_transform(i, time, transform);
+
+            if (time > time_begin && time < time_end)
+                ++inner_key_count;
+        }
+
+        return std::min(next_pow2(inner_key_count + 1), AssemblyTreeMaxMotionSegmentCount);
+    }
+
+    // Compute the bounding box swept by a local bounding box over the time interval [time_begin, time_end].
+    AABB3d compute_swept_bbox(
+        const TransformSequence&    transform_seq,
+        const AABB3d&               local_bbox,
+        const float                 time_begin,
+        const float                 time_end)
+    {
+        // Restrict the sequence to the time interval. The path followed between
+        // two keys does not change when one of the keys is moved along this path.
+        TransformSequence segment_seq;
+        Transformd scratch;
+        segment_seq.set_transform(time_begin, transform_seq.evaluate(time_begin, scratch));
+        segment_seq.set_transform(time_end, transform_seq.evaluate(time_end, scratch));
+
+        for (size_t i = 0, e = transform_seq.size(); i < e; ++i)
+        {
+            float time;
+            Transformd transform;
+            transform_seq.get_transform(i, time, transform);
+
+            if (time > time_begin && time < time_end)
+                segment_seq.set_transform(time, transform);
+        }
+
+        segment_seq.prepare();
+
+        return segment_seq.to_parent(local_bbox);
+    }
+
+    // Evaluate a set of motion bounding boxes at pose index / (pose_count - 1). Both pose counts are
+    // powers of two plus one so that poses fall either on a motion bounding box or between two of them.
+    AABB3d evaluate_motion_bbox(
+        const std::vector<AABB3d>&  bboxes,
+        const size_t                pose_index,
+        const size_t                pose_count)
+    {
+        assert(!bboxes.empty());
+
+        if (bboxes.size() == 1)
+            return bboxes[0];
+
+        assert(pose_count >= bboxes.size());
+
+        const size_t num = pose_index * (bboxes.size() - 1);
+        const size_t den = pose_count - 1;
+        const size_t prev_index = num / den;
+
+        if (num % den == 0)
+            return bboxes[prev_index];
+
+        return
+            lerp(
+                bboxes[prev_index],
+                bboxes[prev_index + 1],
+                static_cast<double>(num % den) / den);
+    }
+}
+
 void AssemblyTree::collect_assembly_instances(
     const AssemblyInstanceContainer&    assembly_instances,
     const TransformSequence&            parent_transform_seq,
-    AABBVector&                         assembly_instance_bboxes)
+    StaticTransformIndexMap&            static_transform_indices,
+    AABBVector&                         assembly_instance_bboxes,
+    MotionAABBVector&                   assembly_instance_motion_bboxes)
 {
+    float shutter_open = 0.0f, shutter_close = 0.0f;
+    const bool has_shutter_interval = get_shutter_interval(m_scene, shutter_open, shutter_close);
+
     for (const_each<AssemblyInstanceContainer> i = assembly_instances; i; ++i)
     {
         // Retrieve the assembly instance.
@@ -130,42 +268,135 @@ void AssemblyTree::collect_assembly_instances(
         collect_assembly_instances(
             assembly.assembly_instances(),
             cumulated_transform_seq,
-            assembly_instance_bboxes);
+            static_transform_indices,
+            assembly_instance_bboxes,
+            assembly_instance_motion_bboxes);
 
         // Skip empty assemblies.
         if (assembly.object_instances().empty())
             continue;
 
+        // Top-level assembly instances are entered with their own transform sequence,
+        // only nested ones need their cumulated transform sequence to be stored.
+        const TransformSequence* transform_seq = &assembly_instance.transform_sequence();
+        if (!parent_transform_seq.empty())
+        {
+            m_transform_sequences.push_back(cumulated_transform_seq);
+            transform_seq = &m_transform_sequences.back();
+        }
+
+        // Static assembly instances are entered with a compact single-precision transform.
+        const std::uint32_t static_transform_index =
+            cumulated_transform_seq.size() > 1
+                ? Item::NoStaticTransform
+                : insert_static_transform(
+                      cumulated_transform_seq.get_earliest_transform(),
+                      static_transform_indices);
+
         // Create and store an item for this assembly instance.
         m_items.emplace_back(
             &assembly,
             &assembly_instance,
-            cumulated_transform_seq);
+            transform_seq,
+            static_transform_index);
 
         // Compute and store the assembly instance bounding box.
-        AABB3d assembly_instance_bbox(
-            cumulated_transform_seq.to_parent(
-                assembly.compute_non_hierarchical_local_bbox()));
+        const AABB3d local_bbox(assembly.compute_non_hierarchical_local_bbox());
+        AABB3d assembly_instance_bbox(cumulated_transform_seq.to_parent(local_bbox));
         assembly_instance_bbox.robust_grow(1.0e-15);
         assembly_instance_bboxes.push_back(assembly_instance_bbox);
+
+        // Compute and store the bounding boxes of the assembly instance at regularly spaced times.
+        // Each one bounds the motion over the two adjacent segments, so that interpolating between
+        // two consecutive bounding boxes bounds the motion over the segment they delimit.
+        const size_t segment_count =
+            has_shutter_interval
+                ? get_motion_segment_count(cumulated_transform_seq, shutter_open, shutter_close)
+                : 0;
+        assembly_instance_motion_bboxes.emplace_back();
+        AABBVector& motion_bboxes = assembly_instance_motion_bboxes.back();
+
+        if (segment_count > 0 && local_bbox.is_valid())
+        {
+            AABBVector swept_bboxes(segment_count);
+            for (size_t j = 0; j < segment_count; ++j)
+            {
+                swept_bboxes[j] =
+                    compute_swept_bbox(
+                        cumulated_transform_seq,
+                        local_bbox,
+                        lerp(shutter_open, shutter_close, static_cast<float>(j) / segment_count),
+                        lerp(shutter_open, shutter_close, static_cast<float>(j + 1) / segment_count));
+                swept_bboxes[j].robust_grow(1.0e-15);
+            }
+
+            motion_bboxes.resize(segment_count + 1);
+            motion_bboxes[0] = swept_bboxes[0];
+            for (size_t j = 1; j < segment_count; ++j)
+            {
+                motion_bboxes[j] = swept_bboxes[j - 1];
+                motion_bboxes[j].insert(swept_bboxes[j]);
+            }
+            motion_bboxes[segment_count] = swept_bboxes[segment_count - 1];
+        }
+        else motion_bboxes.push_back(assembly_instance_bbox);
     }
 }
 
+std::uint32_t AssemblyTree::insert_static_transform(
+    const Transformd&                   transform,
+    StaticTransformIndexMap&            static_transform_indices)
+{
+    const StaticTransform static_transform(transform.get_parent_to_local());
+
+    MurmurHash hash;
+    hash.append(static_transform.m_rows, sizeof(static_transform.m_rows));
+
+    const std::pair<StaticTransformIndexMap::iterator, bool> result =
+        static_transform_indices.insert(
+            std::make_pair(
+                hash.h1(),
+                static_cast<std::uint32_t>(m_static_transforms.size())));
+
+    // Share the static transform of another assembly instance with the same placement.
+    const std::uint32_t index = result.first->second;
+    if (!result.second &&
+        std::memcmp(m_static_transforms[index].m_rows, static_transform.m_rows, sizeof(static_transform.m_rows)) == 0)
+        return index;
+
+    m_static_transforms.push_back(static_transform);
+
+    return static_cast<std::uint32_t>(m_static_transforms.size() - 1);
+}
+
 void AssemblyTree::rebuild_assembly_tree()
 {
+    APPLESEED_TRACE_SCOPE("acceleration", "build assembly tree");
+
     // Clear the current tree.
     clear();
+    m_node_bboxes.clear();
     m_items.clear();
+    m_item_instance_uids.clear();
+    m_item_ordering.clear();
+    m_transform_sequences.clear();
+    m_static_transforms.clear();
 
     Statistics statistics;
 
     // Collect assembly instances and their bounding boxes.
     RENDERER_LOG_INFO("collecting assembly instances...");
+    StaticTransformIndexMap static_transform_indices;
     AABBVector assembly_instance_bboxes;
+    MotionAABBVector assembly_instance_motion_bboxes;
     collect_assembly_instances(
         m_scene.assembly_instances(),
         TransformSequence(),
-        assembly_instance_bboxes);
+        static_transform_indices,
+        assembly_instance_bboxes,
+        assembly_instance_motion_bboxes);
+
+    statistics.insert("static transforms", m_static_transforms.size());
 
     RENDERER_LOG_INFO(
         "building assembly tree (%s %s)...",
@@ -183,7 +414,12 @@ void AssemblyTree::rebuild_assembly_tree()
     // Build the assembly tree.
     typedef bvh::Builder<AssemblyTree, Partitioner> Builder;
     Builder builder;
-    builder.build<DefaultWallclockTimer>(*this, partitioner, m_items.size(), AssemblyTreeMaxLeafSize);
+    builder.build<DefaultWallclockTimer>(
+        *this,
+        partitioner,
+        m_items.size(),
+        AssemblyTreeMaxLeafSize,
+        System::get_logical_cpu_core_count());
     statistics.insert_time("build time", builder.get_build_time());
     statistics.merge(bvh::TreeStatistics<AssemblyTree>(*this, AABB3d(m_scene.compute_bbox())));
 
@@ -202,13 +438,277 @@ void AssemblyTree::rebuild_assembly_tree()
 
         // Store the items in the tree leaves whenever possible.
         store_items_in_leaves(statistics);
+
+        // Store motion bounding boxes, in tree order.
+        MotionAABBVector item_motion_bboxes(ordering.size());
+        for (size_t i = 0, e = ordering.size(); i < e; ++i)
+            item_motion_bboxes[i].swap(assembly_instance_motion_bboxes[ordering[i]]);
+        store_motion_bboxes(item_motion_bboxes);
+
+        // Keep what is needed to refit the tree later.
+        m_item_ordering = ordering;
+        m_item_instance_uids.resize(m_items.size());
+        for (size_t i = 0, e = m_items.size(); i < e; ++i)
+            m_item_instance_uids[ordering[i]] = m_items[i].m_assembly_instance->get_uid();
+        m_built_sah_cost = compute_sah_cost();
+    }
+
+    // Print assembly tree statistics.
+    RENDERER_LOG_DEBUG("%s",
+        StatisticsVector::make(
+            "assembly tree statistics",
+            statistics).to_string().c_str());
+}
+
+bool AssemblyTree::refit_assembly_tree()
+{
+    if (m_items.empty())
+        return false;
+
+    // Collect assembly instances and their bounding boxes, in collection order.
+    // The transforms of the current items are kept until the new items replace them.
+    ItemVector old_items;
+    old_items.swap(m_items);
+    TransformSequenceDeque old_transform_sequences;
+    old_transform_sequences.swap(m_transform_sequences);
+    StaticTransformVector old_static_transforms;
+    old_static_transforms.swap(m_static_transforms);
+    StaticTransformIndexMap static_transform_indices;
+    AABBVector assembly_instance_bboxes;
+    MotionAABBVector assembly_instance_motion_bboxes;
+    collect_assembly_instances(
+        m_scene.assembly_instances(),
+        TransformSequence(),
+        static_transform_indices,
+        assembly_instance_bboxes,
+        assembly_instance_motion_bboxes);
+
+    // The tree can only be refitted if the set of assembly instances did not change.
+    bool same_items = m_items.size() == old_items.size();
+    for (size_t i = 0, e = m_items.size(); same_items && i < e; ++i)
+    {
+        const Item& new_item = m_items[m_item_ordering[i]];
+        same_items =
+            new_item.m_assembly_instance->get_uid() == m_item_instance_uids[m_item_ordering[i]] &&
+            new_item.m_assembly_uid == old_items[i].m_assembly_uid;
+    }
+
+    if (!same_items)
+    {
+        m_items.swap(old_items);
+        m_transform_sequences.swap(old_transform_sequences);
+        m_static_transforms.swap(old_static_transforms);
+        return false;
     }
 
+    // Put the new items and their bounding boxes in tree order.
+    AABBVector item_bboxes(m_items.size());
+    for (size_t i = 0, e = m_items.size(); i < e; ++i)
+    {
+        old_items[i] = m_items[m_item_ordering[i]];
+        item_bboxes[i] = assembly_instance_bboxes[m_item_ordering[i]];
+    }
+    m_items.swap(old_items);
+
+    Statistics statistics;
+
+    RENDERER_LOG_INFO(
+        "refitting assembly tree (%s %s)...",
+        pretty_int(m_items.size()).c_str(),
+        plural(m_items.size(), "assembly instance").c_str());
+
+    // Update node bounding boxes bottom-up, keeping the tree topology.
+    refit_node(0, item_bboxes);
+
+    // Fall back to a full rebuild if the refitted tree became too expensive to traverse.
+    const double sah_cost = compute_sah_cost();
+    const double sah_cost_ratio = m_built_sah_cost > 0.0 ? sah_cost / m_built_sah_cost : 1.0;
+    if (sah_cost_ratio > AssemblyTreeMaxRefitCostRatio)
+    {
+        RENDERER_LOG_DEBUG(
+            "refitted assembly tree is %sx more expensive than when it was built, rebuilding it.",
+            pretty_scalar(sah_cost_ratio).c_str());
+        return false;
+    }
+
+    store_items_in_leaves(statistics);
+
+    // Recompute motion bounding boxes, in tree order.
+    MotionAABBVector item_motion_bboxes(m_items.size());
+    for (size_t i = 0, e = m_items.size(); i < e; ++i)
+        item_motion_bboxes[i].swap(assembly_instance_motion_bboxes[m_item_ordering[i]]);
+    store_motion_bboxes(item_motion_bboxes);
+
+    statistics.insert("sah cost ratio", sah_cost_ratio);
+
     // Print assembly tree statistics.
     RENDERER_LOG_DEBUG("%s",
         StatisticsVector::make(
             "assembly tree statistics",
             statistics).to_string().c_str());
+
+    return true;
+}
+
+AABB3d AssemblyTree::refit_node(const size_t node_index, const AABBVector& item_bboxes)
+{
+    NodeType& node = m_nodes[node_index];
+
+    if (node.is_leaf())
+    {
+        AABB3d bbox;
+        bbox.invalidate();
+
+        const size_t item_begin = node.get_item_index();
+        const size_t item_end = item_begin + node.get_item_count();
+
+        for (size_t i = item_begin; i < item_end; ++i)
+            bbox.insert(item_bboxes[i]);
+
+        return bbox;
+    }
+
+    const size_t child_node_index = node.get_child_node_index();
+    const AABB3d left_bbox = refit_node(child_node_index, item_bboxes);
+    const AABB3d right_bbox = refit_node(child_node_index + 1, item_bboxes);
+
+    node.set_left_bbox(left_bbox);
+    node.set_right_bbox(right_bbox);
+
+    AABB3d bbox(left_bbox);
+    bbox.insert(right_bbox);
+
+    return bbox;
+}
+
+void AssemblyTree::store_motion_bboxes(const MotionAABBVector& item_motion_bboxes)
+{
+    m_node_bboxes.clear();
+
+    bool has_motion = false;
+    for (size_t i = 0, e = item_motion_bboxes.size(); i < e; ++i)
+    {
+        if (item_motion_bboxes[i].size() > 1)
+        {
+            has_motion = true;
+            break;
+        }
+    }
+
+    // Keep using the faster, motion-less traversal in static scenes.
+    if (has_motion)
+        compute_motion_bboxes(item_motion_bboxes, 0);
+}
+
+AssemblyTree::AABBVector AssemblyTree::compute_motion_bboxes(
+    const MotionAABBVector&             item_motion_bboxes,
+    const size_t                        node_index)
+{
+    NodeType& node = m_nodes[node_index];
+
+    if (node.is_interior())
+    {
+        const AABBVector left_bboxes = compute_motion_bboxes(item_motion_bboxes, node.get_child_node_index() + 0);
+        const AABBVector right_bboxes = compute_motion_bboxes(item_motion_bboxes, node.get_child_node_index() + 1);
+
+        // The assembly tree intersector is not the SSE one: bounding boxes are stored as-is.
+        node.set_left_bbox_count(left_bboxes.size());
+        if (left_bboxes.size() > 1)
+        {
+            node.set_left_bbox_index(m_node_bboxes.size());
+            m_node_bboxes.insert(m_node_bboxes.end(), left_bboxes.begin(), left_bboxes.end());
+        }
+
+        node.set_right_bbox_count(right_bboxes.size());
+        if (right_bboxes.size() > 1)
+        {
+            node.set_right_bbox_index(m_node_bboxes.size());
+            m_node_bboxes.insert(m_node_bboxes.end(), right_bboxes.begin(), right_bboxes.end());
+        }
+
+        const size_t pose_count = std::max(left_bboxes.size(), right_bboxes.size());
+        AABBVector bboxes(pose_count);
+
+        for (size_t i = 0; i < pose_count; ++i)
+        {
+            bboxes[i] = evaluate_motion_bbox(left_bboxes, i, pose_count);
+            bboxes[i].insert(evaluate_motion_bbox(right_bboxes, i, pose_count));
+        }
+
+        return bboxes;
+    }
+    else
+    {
+        const size_t item_begin = node.get_item_index();
+        const size_t item_end = item_begin + node.get_item_count();
+
+        size_t pose_count = 1;
+        for (size_t i = item_begin; i < item_end; ++i)
+            pose_count = std::max(pose_count, item_motion_bboxes[i].size());
+
+        AABBVector bboxes(pose_count);
+
+        for (size_t j = 0; j < pose_count; ++j)
+        {
+            bboxes[j].invalidate();
+
+            for (size_t i = item_begin; i < item_end; ++i)
+                bboxes[j].insert(evaluate_motion_bbox(item_motion_bboxes[i], j, pose_count));
+        }
+
+        return bboxes;
+    }
+}
+
+double AssemblyTree::compute_sah_cost() const
+{
+    if (m_nodes.empty() || m_nodes[0].is_leaf())
+        return 0.0;
+
+    double cost = 0.0;
+    double root_area = 0.0;
+
+    struct Entry
+    {
+        size_t  m_node_index;
+        double  m_area;
+    };
+
+    std::vector<Entry> stack;
+    stack.push_back(Entry{ 0, 0.0 });
+
+    while (!stack.empty())
+    {
+        const Entry entry = stack.back();
+        stack.pop_back();
+
+        const NodeType& node = m_nodes[entry.m_node_index];
+
+        if (node.is_leaf())
+        {
+            cost += entry.m_area * node.get_item_count() * AssemblyTreeTriangleIntersectionCost;
+            continue;
+        }
+
+        const AABB3d left_bbox = node.get_left_bbox();
+        const AABB3d right_bbox = node.get_right_bbox();
+        const double left_area = left_bbox.is_valid() ? half_surface_area(left_bbox) : 0.0;
+        const double right_area = right_bbox.is_valid() ? half_surface_area(right_bbox) : 0.0;
+
+        if (entry.m_node_index == 0)
+        {
+            AABB3d root_bbox(left_bbox);
+            root_bbox.insert(right_bbox);
+            root_area = half_surface_area(root_bbox);
+        }
+        else cost += entry.m_area * AssemblyTreeInteriorNodeTraversalCost;
+
+        const size_t child_node_index = node.get_child_node_index();
+        stack.push_back(Entry{ child_node_index, left_area });
+        stack.push_back(Entry{ child_node_index + 1, right_area });
+    }
+
+    return root_area > 0.0 ? AssemblyTreeInteriorNodeTraversalCost + cost / root_area : 0.0;
 }
 
 void AssemblyTree::store_items_in_leaves(Statistics& statistics)
@@ -253,22 +753,20 @@ void AssemblyTree::update_tree_hierarchy()
     // Delete child trees of assemblies that no longer exist.
     delete_unused_child_trees(assemblies);
 
-    // Create or rebuild the child trees of each assembly.
+    // Delete the child trees of assemblies that are out-of-date. This is done before
+    // any child tree gets created since it may invalidate the trees of other assemblies.
     for (const_each<AssemblyVector> i = assemblies; i; ++i)
     {
         // Retrieve the assembly.
         const Assembly& assembly = **i;
 
-        // Retrieve the current version ID of the assembly.
-        const VersionID current_version_id = assembly.get_version_id();
-
         // Retrieve the stored version ID of the assembly.
-        const AssemblyVersionMap::const_iterator stored_version_it =
+        const AssemblyVersionMap::iterator stored_version_it =
             m_assembly_versions.find(assembly.get_uid());
 
         if (stored_version_it != m_assembly_versions.end())
         {
-            if ((stored_version_it->second == current_version_id)
+            if ((stored_version_it->second == assembly.get_version_id())
 #ifdef APPLESEED_WITH_EMBREE
                 && !m_dirty
 #endif
@@ -279,19 +777,35 @@ void AssemblyTree::update_tree_hierarchy()
             }
 
             // The child trees of this assembly are out-of-date: delete them.
+            m_assembly_versions.erase(stored_version_it);
             delete_child_trees(assembly.get_uid());
         }
+    }
+
+    // Create the child trees of assemblies that don't have any.
+    for (const_each<AssemblyVector> i = assemblies; i; ++i)
+    {
+        // Retrieve the assembly.
+        const Assembly& assembly = **i;
+
+        if (m_assembly_versions.find(assembly.get_uid()) != m_assembly_versions.end())
+            continue;
 
         // Lazily build new child trees.
         create_child_trees(assembly);
 
         // Store the current version ID of the assembly.
-        m_assembly_versions[assembly.get_uid()] = current_version_id;
+        m_assembly_versions[assembly.get_uid()] = assembly.get_version_id();
     }
 
     // Update child trees.
     update_triangle_trees();
 
+#ifdef APPLESEED_WITH_EMBREE
+    if (use_embree())
+        build_embree_scenes();
+#endif
+
 #ifdef APPLESEED_WITH_EMBREE
     m_dirty = false;
 #endif
@@ -367,6 +881,57 @@ namespace
 
         return hash;
     }
+
+    bool has_alpha_maps(const ObjectInstance& object_instance)
+    {
+        // Use the uncached versions of get_alpha_map() since on_frame_begin()
+        // hasn't been called on the object or materials at this point.
+
+        if (object_instance.get_object().get_uncached_alpha_map())
+            return true;
+
+        const MaterialArray& materials = object_instance.get_front_materials();
+
+        for (size_t i = 0, e = materials.size(); i < e; ++i)
+        {
+            if (materials[i] && materials[i]->get_uncached_alpha_map())
+                return true;
+        }
+
+        return false;
+    }
+
+    // Like hash_assembly_geometry() for mesh objects, except that meshes are hashed by content
+    // so that assemblies holding identical copies of the same meshes (e.g. the same archive or
+    // mesh file referenced many times under different names) share a single triangle tree.
+    // Objects with alpha maps are still hashed by identity since shared triangle trees don't
+    // have intersection filters.
+    std::uint64_t hash_assembly_mesh_content(const Assembly& assembly)
+    {
+        MurmurHash hash;
+        std::uint64_t object_instance_index = 0;
+
+        for (const_each<ObjectInstanceContainer> i = assembly.object_instances(); i; ++i, ++object_instance_index)
+        {
+            const ObjectInstance& object_instance = *i;
+            const Object& object = object_instance.get_object();
+
+            if (strcmp(object.get_model(), MeshObjectFactory().get_model()) != 0)
+                continue;
+
+            // Triangle keys store object instance indices.
+            hash.append(object_instance_index);
+
+            if (has_alpha_maps(object_instance))
+                hash.append(object.get_uid());
+            else compute_signature(hash, static_cast<const MeshObject&>(object));
+
+            hash.append(object_instance.get_vis_flags());
+            hash.append(object_instance.get_transform().get_local_to_parent());
+        }
+
+        return hash.h1();
+    }
 }
 
 void AssemblyTree::create_child_trees(const Assembly& assembly)
@@ -393,7 +958,7 @@ void AssemblyTree::create_child_trees(const Assembly& assembly)
 
 void AssemblyTree::create_triangle_tree(const Assembly& assembly)
 {
-    const std::uint64_t hash = hash_assembly_geometry(assembly, MeshObjectFactory().get_model());
+    const std::uint64_t hash = hash_assembly_mesh_content(assembly);
     Lazy<TriangleTree>* tree = m_triangle_tree_repository.acquire(hash);
 
     if (tree == nullptr)
@@ -404,15 +969,31 @@ void AssemblyTree::create_triangle_tree(const Assembly& assembly)
                 assembly.object_instances().begin(),
                 assembly.object_instances().end());
 
-        std::unique_ptr<ILazyFactory<TriangleTree>> triangle_tree_factory(
-            new TriangleTreeFactory(
-                TriangleTree::Arguments(
-                    m_scene,
-                    assembly.get_uid(),
-                    assembly_bbox,
-                    assembly)));
+        const TriangleTree::Arguments arguments(
+            m_scene,
+            assembly.get_uid(),
+            assembly_bbox,
+            assembly);
+
+        // Trees of assemblies with deferred builds are only built when a ray first enters
+        // them, and may be released again when the triangle tree memory budget is exceeded.
+        const bool deferred_build =
+            assembly.get_parameters().child("acceleration_structure").get_optional<bool>("deferred_build", false);
+
+        if (deferred_build)
+        {
+            DeferredTriangleTreeFactory* deferred_factory =
+                new DeferredTriangleTreeFactory(arguments, m_triangle_tree_budget);
+            tree = new Lazy<TriangleTree>(std::unique_ptr<ILazyFactory<TriangleTree>>(deferred_factory));
+            deferred_factory->set_lazy_tree(tree);
+        }
+        else
+        {
+            std::unique_ptr<ILazyFactory<TriangleTree>> triangle_tree_factory(
+                new TriangleTreeFactory(arguments));
+            tree = new Lazy<TriangleTree>(std::move(triangle_tree_factory));
+        }
 
-        tree = new Lazy<TriangleTree>(std::move(triangle_tree_factory));
         m_triangle_tree_repository.insert(hash, tree);
     }
 
@@ -484,6 +1065,94 @@ void AssemblyTree::create_embree_scene(const Assembly& assembly)
     m_embree_scenes.insert(std::make_pair(assembly.get_uid(), scene));
 }
 
+namespace
+{
+    class BuildEmbreeSceneJob
+      : public IJob
+    {
+      public:
+        explicit BuildEmbreeSceneJob(Lazy<EmbreeScene>* scene)
+          : m_scene(scene)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            // Accessing the lazy object creates and commits the scene.
+            Access<EmbreeScene> access(m_scene);
+        }
+
+      private:
+        Lazy<EmbreeScene>* m_scene;
+    };
+}
+
+void AssemblyTree::build_embree_scenes()
+{
+    // Scenes may be shared by several assemblies with identical geometry.
+    std::set<Lazy<EmbreeScene>*> scenes;
+    for (const_each<EmbreeSceneContainer> i = m_embree_scenes; i; ++i)
+    {
+        if (!i->second->is_constructed())
+            scenes.insert(i->second);
+    }
+
+    if (scenes.empty())
+        return;
+
+    // Scenes of distinct assemblies are independent: commit them concurrently
+    // instead of one after the other on first access. Each commit still uses
+    // Embree's own tasking system to build its BVH.
+    const size_t thread_count =
+        std::min(scenes.size(), System::get_logical_cpu_core_count());
+
+    if (thread_count < 2)
+    {
+        Access<EmbreeScene> access(*scenes.begin());
+        return;
+    }
+
+    JobQueue job_queue;
+    JobManager job_manager(global_logger(), job_queue, thread_count);
+
+    for (const_each<std::set<Lazy<EmbreeScene>*>> i = scenes; i; ++i)
+        job_queue.schedule(new BuildEmbreeSceneJob(*i));
+
+    job_manager.start();
+    job_queue.wait_until_completion();
+}
+
+void AssemblyTree::build_embree_instance_scene()
+{
+    EmbreeInstanceScene::InstanceVector instances;
+    instances.reserve(m_items.size());
+
+    for (const_each<ItemVector> i = m_items; i; ++i)
+    {
+        const Item& item = *i;
+
+        // Moving assembly instances and procedural objects are only supported by the assembly tree.
+        if (item.m_static_transform_index == Item::NoStaticTransform ||
+            !item.m_assembly->get_render_data().m_procedural_object_instances.empty())
+        {
+            RENDERER_LOG_WARNING(
+                "cannot use embree instancing: assembly instance \"%s\" is moving or contains procedural objects.",
+                item.m_assembly_instance->get_path().c_str());
+            return;
+        }
+
+        const EmbreeSceneContainer::const_iterator it = m_embree_scenes.find(item.m_assembly_uid);
+        assert(it != m_embree_scenes.end());
+
+        // Scenes were committed by build_embree_scenes() and are never released on their own.
+        Access<EmbreeScene> access(it->second);
+        instances.emplace_back(access.get(), item.m_assembly_instance, item.m_transform_sequence);
+    }
+
+    m_embree_instance_scene.reset(
+        new EmbreeInstanceScene(m_scene.get_embree_device(), instances));
+}
+
 void AssemblyTree::delete_embree_scene(const UniqueID assembly_id)
 {
     const EmbreeSceneContainer::iterator it = m_embree_scenes.find(assembly_id);
@@ -510,8 +1179,31 @@ void AssemblyTree::delete_triangle_tree(const UniqueID assembly_id)
     const TriangleTreeContainer::iterator it = m_triangle_trees.find(assembly_id);
     if (it != m_triangle_trees.end())
     {
+        const Lazy<TriangleTree>* tree = it->second;
         m_triangle_tree_repository.release(it->second);
         m_triangle_trees.erase(it);
+
+        // A triangle tree refers to the assembly it was created for. If other assemblies share
+        // this tree, have them create their child trees again so that none of them keeps using
+        // a tree that may refer to an assembly that changed or no longer exists.
+        std::vector<UniqueID> sharing_assembly_ids;
+        for (const_each<TriangleTreeContainer> i = m_triangle_trees; i; ++i)
+        {
+            if (i->second == tree)
+                sharing_assembly_ids.push_back(i->first);
+        }
+
+        for (const_each<std::vector<UniqueID>> i = sharing_assembly_ids; i; ++i)
+        {
+            const TriangleTreeContainer::iterator sharing_it = m_triangle_trees.find(*i);
+            m_triangle_tree_repository.release(sharing_it->second);
+            m_triangle_trees.erase(sharing_it);
+            delete_curve_tree(*i);
+#ifdef APPLESEED_WITH_EMBREE
+            delete_embree_scene(*i);
+#endif
+            m_assembly_versions.erase(*i);
+        }
     }
 }
 
@@ -527,14 +1219,24 @@ void AssemblyTree::delete_curve_tree(const UniqueID assembly_id)
 
 namespace
 {
-    template <typename TreeType>
-    struct UpdateTrees
+    struct UpdateTriangleTrees
     {
-        void operator()(Lazy<TreeType>& tree, const size_t ref_count)
+        void operator()(Lazy<TriangleTree>& tree, const size_t ref_count)
         {
-            Access<TreeType> update(&tree);
-
             const bool enable_intersection_filters = ref_count == 1;
+
+            // Don't force the construction of trees built on demand: let them set up
+            // their intersection filters when they get built.
+            DeferredTriangleTreeFactory* deferred_factory =
+                dynamic_cast<DeferredTriangleTreeFactory*>(tree.get_factory());
+            if (deferred_factory)
+            {
+                deferred_factory->set_enable_intersection_filters(enable_intersection_filters);
+                if (!tree.is_constructed())
+                    return;
+            }
+
+            Access<TriangleTree> update(&tree);
             update->update_non_geometry(enable_intersection_filters);
         }
     };
@@ -542,20 +1244,89 @@ namespace
 
 void AssemblyTree::update_triangle_trees()
 {
-    UpdateTrees<TriangleTree> update_trees;
+    UpdateTriangleTrees update_trees;
     m_triangle_tree_repository.for_each(update_trees);
 }
 
 
+//
+// AssemblyTree::StaticTransform class implementation.
+//
+
+AssemblyTree::StaticTransform::StaticTransform(const Matrix4d& parent_to_local)
+{
+    for (size_t i = 0; i < 3; ++i)
+    {
+        for (size_t j = 0; j < 4; ++j)
+            m_rows[i][j] = static_cast<float>(parent_to_local(i, j));
+    }
+}
+
+namespace
+{
+    // Multiply the 3x4 matrix of a static transform with (x, y, z, w).
+    APPLESEED_FORCE_INLINE Vector3d transform_by_rows(
+        const float                 rows[3][4],
+        const Vector3d&             v,
+        const float                 w)
+    {
+#ifdef APPLESEED_USE_SSE
+
+        const __m128 x =
+            _mm_set_ps(
+                w,
+                static_cast<float>(v.z),
+                static_cast<float>(v.y),
+                static_cast<float>(v.x));
+
+        __m128 r0 = _mm_mul_ps(_mm_load_ps(rows[0]), x);
+        __m128 r1 = _mm_mul_ps(_mm_load_ps(rows[1]), x);
+        __m128 r2 = _mm_mul_ps(_mm_load_ps(rows[2]), x);
+        __m128 r3 = _mm_setzero_ps();
+
+        // Sum the products of each row.
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+        M128Fields result;
+        result.m128 = _mm_add_ps(_mm_add_ps(r0, r1), _mm_add_ps(r2, r3));
+
+        return Vector3d(result.f32[0], result.f32[1], result.f32[2]);
+
+#else
+
+        const Vector3f x(v);
+
+        return
+            Vector3d(
+                rows[0][0] * x.x + rows[0][1] * x.y + rows[0][2] * x.z + rows[0][3] * w,
+                rows[1][0] * x.x + rows[1][1] * x.y + rows[1][2] * x.z + rows[1][3] * w,
+                rows[2][0] * x.x + rows[2][1] * x.y + rows[2][2] * x.z + rows[2][3] * w);
+
+#endif
+    }
+}
+
+Vector3d AssemblyTree::StaticTransform::point_to_local(const Vector3d& p) const
+{
+    return transform_by_rows(m_rows, p, 1.0f);
+}
+
+Vector3d AssemblyTree::StaticTransform::vector_to_local(const Vector3d& v) const
+{
+    return transform_by_rows(m_rows, v, 0.0f);
+}
+
+
 //
 // Utility function to transform a ray to the space of an assembly instance.
 //
 
 namespace
 {
+    template <typename Transform>
     void compute_assembly_instance_ray(
         const AssemblyInstance&     assembly_instance,
-        const Transformd&           assembly_instance_transform,
+        const Transform&            assembly_instance_transform,
         const ShadingPoint*         parent_sp,
         const ShadingRay&           input_ray,
         ShadingRay&                 output_ray)
@@ -632,20 +1403,33 @@ bool AssemblyLeafVisitor::visit(
         FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
 
         // Evaluate the transformation of the assembly instance.
-        const TransformSequence* assembly_instance_transform_seq =
-            &item.m_transform_sequence;
-        Transformd scratch;
+        const bool is_static = item.m_static_transform_index != AssemblyTree::Item::NoStaticTransform;
+        const TransformSequence* assembly_instance_transform_seq = item.m_transform_sequence;
         const Transformd& assembly_instance_transform =
-            assembly_instance_transform_seq->evaluate(ray.m_time.m_absolute, scratch);
+            is_static
+                ? assembly_instance_transform_seq->get_earliest_transform()
+                : m_transform_cache.evaluate(*assembly_instance_transform_seq, ray.m_time.m_absolute);
 
         // Transform the ray to assembly instance space.
         ShadingPoint asm_inst_shading_point;
-        compute_assembly_instance_ray(
-            assembly_instance,
-            assembly_instance_transform,
-            m_parent_shading_point,
-            ray,
-            asm_inst_shading_point.m_ray);
+        if (is_static)
+        {
+            compute_assembly_instance_ray(
+                assembly_instance,
+                m_tree.m_static_transforms[item.m_static_transform_index],
+                m_parent_shading_point,
+                ray,
+                asm_inst_shading_point.m_ray);
+        }
+        else
+        {
+            compute_assembly_instance_ray(
+                assembly_instance,
+                assembly_instance_transform,
+                m_parent_shading_point,
+                ray,
+                asm_inst_shading_point.m_ray);
+        }
         const RayInfo3d asm_inst_ray_info(asm_inst_shading_point.m_ray);
 
 #ifdef APPLESEED_WITH_EMBREE
@@ -672,34 +1456,11 @@ bool AssemblyLeafVisitor::visit(
             if (triangle_tree)
             {
                 // Check the intersection between the ray and the triangle tree.
-                TriangleTreeIntersector intersector;
-                TriangleLeafVisitor visitor(*triangle_tree, asm_inst_shading_point);
-                if (triangle_tree->get_moving_triangle_count() > 0)
-                {
-                    intersector.intersect_motion(
-                        *triangle_tree,
-                        asm_inst_shading_point.m_ray,
-                        asm_inst_ray_info,
-                        asm_inst_shading_point.m_ray.m_time.m_normalized,
-                        visitor
-#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                        , m_triangle_tree_stats
-#endif
-                        );
-                }
-                else
-                {
-                    intersector.intersect_no_motion(
-                        *triangle_tree,
-                        asm_inst_shading_point.m_ray,
-                        asm_inst_ray_info,
-                        visitor
-#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-                        , m_triangle_tree_stats
-#endif
-                        );
-                }
-                visitor.read_hit_triangle_data();
+                intersect_triangle_tree(
+                    *triangle_tree,
+                    asm_inst_shading_point,
+                    asm_inst_ray_info,
+                    TriangleLeafVisitor::AnyObjectInstance);
             }
         }
 
@@ -730,18 +1491,11 @@ bool AssemblyLeafVisitor::visit(
         }
 
         // Keep track of the closest hit.
-        if (asm_inst_shading_point.hit_surface() && asm_inst_shading_point.m_ray.m_tmax < m_shading_point.m_ray.m_tmax)
-        {
-            m_shading_point.m_ray.m_tmax = asm_inst_shading_point.m_ray.m_tmax;
-            m_shading_point.m_primitive_type = asm_inst_shading_point.m_primitive_type;
-            m_shading_point.m_bary = asm_inst_shading_point.m_bary;
-            m_shading_point.m_assembly_instance = item.m_assembly_instance;
-            m_shading_point.m_assembly_instance_transform = assembly_instance_transform;
-            m_shading_point.m_assembly_instance_transform_seq = assembly_instance_transform_seq;
-            m_shading_point.m_object_instance_index = asm_inst_shading_point.m_object_instance_index;
-            m_shading_point.m_primitive_index = asm_inst_shading_point.m_primitive_index;
-            m_shading_point.m_triangle_support_plane = asm_inst_shading_point.m_triangle_support_plane;
-        }
+        record_closest_hit(
+            asm_inst_shading_point,
+            item.m_assembly_instance,
+            assembly_instance_transform,
+            assembly_instance_transform_seq);
 
         // Check the intersection between the ray and procedural objects.
         const IndexedObjectInstanceArray& procedural_object_instances =
@@ -757,7 +1511,6 @@ bool AssemblyLeafVisitor::visit(
             if (!(object_instance->get_vis_flags() & ray.m_flags))
                 continue;
 
-            // todo: transform ray differentials.
             const Transformd& object_instance_transform = object_instance->get_transform();
 
             // Transform the ray direction from world space to object instance space.
@@ -789,7 +1542,24 @@ bool AssemblyLeafVisitor::visit(
                         assembly_instance_transform.point_to_local(ray.m_org));
             }
 
-            obj_inst_ray.m_has_differentials = false;
+            // Transform the ray differentials to object instance space.
+            obj_inst_ray.m_has_differentials = ray.m_has_differentials;
+            if (ray.m_has_differentials)
+            {
+                obj_inst_ray.m_rx.m_org =
+                    object_instance_transform.point_to_local(
+                        assembly_instance_transform.point_to_local(ray.m_rx.m_org));
+                obj_inst_ray.m_rx.m_dir =
+                    object_instance_transform.vector_to_local(
+                        assembly_instance_transform.vector_to_local(ray.m_rx.m_dir));
+                obj_inst_ray.m_ry.m_org =
+                    object_instance_transform.point_to_local(
+                        assembly_instance_transform.point_to_local(ray.m_ry.m_org));
+                obj_inst_ray.m_ry.m_dir =
+                    object_instance_transform.vector_to_local(
+                        assembly_instance_transform.vector_to_local(ray.m_ry.m_dir));
+            }
+
             obj_inst_ray.m_tmin = asm_inst_shading_point.m_ray.m_tmin;
             obj_inst_ray.m_tmax = asm_inst_shading_point.m_ray.m_tmax;
             obj_inst_ray.m_time = asm_inst_shading_point.m_ray.m_time;
@@ -837,6 +1607,126 @@ bool AssemblyLeafVisitor::visit(
     return true;
 }
 
+void AssemblyLeafVisitor::visit_object_instance(
+    const AssemblyInstance&             assembly_instance,
+    const UniqueID                      assembly_uid,
+    const Transformd&                   assembly_instance_transform,
+    const TransformSequence*            assembly_instance_transform_seq,
+    const size_t                        object_instance_index)
+{
+    // Skip this assembly instance if it isn't visible for this ray.
+    if (!(assembly_instance.get_vis_flags() & m_shading_point.m_ray.m_flags))
+        return;
+
+    // Retrieve the triangle tree of the assembly.
+    const TriangleTree* triangle_tree =
+        m_triangle_tree_cache.access(
+            assembly_uid,
+            m_tree.m_triangle_trees);
+
+    if (triangle_tree == nullptr)
+        return;
+
+    // Transform the ray to assembly instance space.
+    ShadingPoint asm_inst_shading_point;
+    compute_assembly_instance_ray(
+        assembly_instance,
+        assembly_instance_transform,
+        m_parent_shading_point,
+        m_shading_point.m_ray,
+        asm_inst_shading_point.m_ray);
+    const RayInfo3d asm_inst_ray_info(asm_inst_shading_point.m_ray);
+
+    // Check the intersection between the ray and the triangles of the object instance.
+    intersect_triangle_tree(
+        *triangle_tree,
+        asm_inst_shading_point,
+        asm_inst_ray_info,
+        object_instance_index);
+
+    // Keep track of the closest hit.
+    record_closest_hit(
+        asm_inst_shading_point,
+        &assembly_instance,
+        assembly_instance_transform,
+        assembly_instance_transform_seq);
+}
+
+void AssemblyLeafVisitor::intersect_triangle_tree(
+    const TriangleTree&                 triangle_tree,
+    ShadingPoint&                       asm_inst_shading_point,
+    const RayInfo3d&                    asm_inst_ray_info,
+    const size_t                        object_instance_index)
+{
+    // Skip the tree if none of its triangles is visible for this ray.
+    const VisibilityFlags::Type ray_flags = asm_inst_shading_point.m_ray.m_flags;
+    if (!(triangle_tree.get_vis_flags() & ray_flags))
+        return;
+
+    TriangleTreeIntersector intersector;
+    TriangleLeafVisitor visitor(triangle_tree, asm_inst_shading_point, object_instance_index);
+    if (triangle_tree.get_moving_triangle_count() > 0)
+    {
+        intersector.intersect_motion(
+            triangle_tree,
+            asm_inst_shading_point.m_ray,
+            asm_inst_ray_info,
+            asm_inst_shading_point.m_ray.m_time.m_normalized,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_triangle_tree_stats
+#endif
+            );
+    }
+    else if (!triangle_tree.get_wide_nodes().empty())
+    {
+        TriangleTreeWideIntersector wide_intersector(ray_flags);
+        wide_intersector.intersect_no_motion(
+            triangle_tree,
+            triangle_tree.get_wide_nodes(),
+            asm_inst_shading_point.m_ray,
+            asm_inst_ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_triangle_tree_stats
+#endif
+            );
+    }
+    else
+    {
+        intersector.intersect_no_motion(
+            triangle_tree,
+            asm_inst_shading_point.m_ray,
+            asm_inst_ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_triangle_tree_stats
+#endif
+            );
+    }
+    visitor.read_hit_triangle_data();
+}
+
+void AssemblyLeafVisitor::record_closest_hit(
+    const ShadingPoint&                 asm_inst_shading_point,
+    const AssemblyInstance*             assembly_instance,
+    const Transformd&                   assembly_instance_transform,
+    const TransformSequence*            assembly_instance_transform_seq)
+{
+    if (asm_inst_shading_point.hit_surface() && asm_inst_shading_point.m_ray.m_tmax < m_shading_point.m_ray.m_tmax)
+    {
+        m_shading_point.m_ray.m_tmax = asm_inst_shading_point.m_ray.m_tmax;
+        m_shading_point.m_primitive_type = asm_inst_shading_point.m_primitive_type;
+        m_shading_point.m_bary = asm_inst_shading_point.m_bary;
+        m_shading_point.m_assembly_instance = assembly_instance;
+        m_shading_point.m_assembly_instance_transform = assembly_instance_transform;
+        m_shading_point.m_assembly_instance_transform_seq = assembly_instance_transform_seq;
+        m_shading_point.m_object_instance_index = asm_inst_shading_point.m_object_instance_index;
+        m_shading_point.m_primitive_index = asm_inst_shading_point.m_primitive_index;
+        m_shading_point.m_triangle_support_plane = asm_inst_shading_point.m_triangle_support_plane;
+    }
+}
+
 
 //
 // AssemblyLeafProbeVisitor class implementation.
@@ -872,18 +1762,32 @@ bool AssemblyLeafProbeVisitor::visit(
         FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
 
         // Evaluate the transformation of the assembly instance.
-        Transformd scratch;
+        const bool is_static = item.m_static_transform_index != AssemblyTree::Item::NoStaticTransform;
         const Transformd& assembly_instance_transform =
-            item.m_transform_sequence.evaluate(ray.m_time.m_absolute, scratch);
+            is_static
+                ? item.m_transform_sequence->get_earliest_transform()
+                : m_transform_cache.evaluate(*item.m_transform_sequence, ray.m_time.m_absolute);
 
         // Transform the ray to assembly instance space.
         ShadingRay asm_inst_ray;
-        compute_assembly_instance_ray(
-            assembly_instance,
-            assembly_instance_transform,
-            m_parent_shading_point,
-            ray,
-            asm_inst_ray);
+        if (is_static)
+        {
+            compute_assembly_instance_ray(
+                assembly_instance,
+                m_tree.m_static_transforms[item.m_static_transform_index],
+                m_parent_shading_point,
+                ray,
+                asm_inst_ray);
+        }
+        else
+        {
+            compute_assembly_instance_ray(
+                assembly_instance,
+                assembly_instance_transform,
+                m_parent_shading_point,
+                ray,
+                asm_inst_ray);
+        }
         const RayInfo3d asm_inst_ray_info(asm_inst_ray);
 
 #ifdef APPLESEED_WITH_EMBREE
@@ -897,6 +1801,9 @@ bool AssemblyLeafProbeVisitor::visit(
 
             if (embree_scene.occlude(asm_inst_ray))
             {
+                if (m_occluder)
+                    m_occluder->m_assembly_instance = nullptr;
+
                 m_hit = true;
                 return false;
             }
@@ -911,7 +1818,8 @@ bool AssemblyLeafProbeVisitor::visit(
                     item.m_assembly_uid,
                     m_tree.m_triangle_trees);
 
-            if (triangle_tree)
+            // Skip the tree if none of its triangles is visible for this ray.
+            if (triangle_tree && (triangle_tree->get_vis_flags() & asm_inst_ray.m_flags))
             {
                 // Check the intersection between the ray and the triangle tree.
                 TriangleTreeProbeIntersector intersector;
@@ -926,6 +1834,20 @@ bool AssemblyLeafProbeVisitor::visit(
                         visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                         , m_triangle_tree_stats
+#endif
+                        );
+                }
+                else if (!triangle_tree->get_wide_nodes().empty())
+                {
+                    TriangleTreeWideProbeIntersector wide_intersector(asm_inst_ray.m_flags);
+                    wide_intersector.intersect_no_motion(
+                        *triangle_tree,
+                        triangle_tree->get_wide_nodes(),
+                        asm_inst_ray,
+                        asm_inst_ray_info,
+                        visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                        , m_triangle_tree_stats
 #endif
                         );
                 }
@@ -945,6 +1867,19 @@ bool AssemblyLeafProbeVisitor::visit(
                 // Terminate traversal if there was a hit.
                 if (visitor.hit())
                 {
+                    // Remember the occluder if it can be cached.
+                    if (m_occluder)
+                    {
+                        if (visitor.has_hit_triangle())
+                        {
+                            m_occluder->m_assembly_instance = &assembly_instance;
+                            m_occluder->m_transform_sequence = item.m_transform_sequence;
+                            m_occluder->m_ray_flags = ray.m_flags;
+                            m_occluder->m_triangle = visitor.get_hit_triangle();
+                        }
+                        else m_occluder->m_assembly_instance = nullptr;
+                    }
+
                     m_hit = true;
                     return false;
                 }
@@ -979,6 +1914,9 @@ bool AssemblyLeafProbeVisitor::visit(
             // Terminate traversal if there was a hit.
             if (visitor.hit())
             {
+                if (m_occluder)
+                    m_occluder->m_assembly_instance = nullptr;
+
                 m_hit = true;
                 return false;
             }
@@ -1042,6 +1980,9 @@ bool AssemblyLeafProbeVisitor::visit(
             const ProceduralObject& object = static_cast<const ProceduralObject&>(object_instance->get_object());
             if (object.intersect(obj_inst_ray))
             {
+                if (m_occluder)
+                    m_occluder->m_assembly_instance = nullptr;
+
                 m_hit = true;
                 return false;
             }
@@ -1053,4 +1994,203 @@ bool AssemblyLeafProbeVisitor::visit(
     return true;
 }
 
+bool AssemblyLeafProbeVisitor::intersect_occluder(
+    const OccluderCache::Entry&         occluder,
+    const ShadingRay&                   ray) const
+{
+    assert(occluder.m_assembly_instance);
+
+    // The occluder may not be visible for rays with other visibility flags.
+    if (occluder.m_ray_flags != ray.m_flags)
+        return false;
+
+    // Evaluate the transformation of the assembly instance.
+    const Transformd& assembly_instance_transform =
+        m_transform_cache.evaluate(*occluder.m_transform_sequence, ray.m_time.m_absolute);
+
+    // Transform the ray to assembly instance space, the same way traversal does.
+    ShadingRay asm_inst_ray;
+    compute_assembly_instance_ray(
+        *occluder.m_assembly_instance,
+        assembly_instance_transform,
+        m_parent_shading_point,
+        ray,
+        asm_inst_ray);
+
+    return occluder.m_triangle.intersect(asm_inst_ray);
+}
+
+
+//
+// AssemblyLeafPacketProbeVisitor class implementation.
+//
+
+void AssemblyLeafPacketProbeVisitor::visit(
+    const AssemblyTree::NodeType&       node,
+    const std::uint32_t                 ray_mask,
+    RayPacketType&                      packet
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&         stats
+#endif
+    )
+{
+    // Retrieve the assembly instances for this leaf.
+    const size_t assembly_instance_count = node.get_item_count();
+    const AssemblyTree::Item* items =
+        assembly_instance_count <= AssemblyTree::NodeType::MaxUserDataSize / sizeof(AssemblyTree::Item)
+            ? &node.get_user_data<AssemblyTree::Item>()     // items are stored in the leaf node
+            : &m_tree.m_items[node.get_item_index()];       // items are stored in the tree
+
+    bool packet_leaf = true;
+    for (size_t i = 0; i < assembly_instance_count; ++i)
+    {
+        if (!supports_packets(items[i]))
+        {
+            packet_leaf = false;
+            break;
+        }
+    }
+
+    if (!packet_leaf)
+    {
+        // Trace the rays through this leaf one at a time.
+        for (size_t j = 0; j < ProbeRayPacketSize; ++j)
+        {
+            const std::uint32_t ray_bit = std::uint32_t(1) << j;
+            if (!(ray_mask & packet.m_active & ray_bit))
+                continue;
+
+            AssemblyLeafProbeVisitor visitor(
+                m_tree,
+                m_triangle_tree_cache,
+                m_curve_tree_cache,
+                m_transform_cache,
+#ifdef APPLESEED_WITH_EMBREE
+                m_embree_scene_cache,
+#endif
+                m_parent_shading_point,
+                nullptr
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , m_triangle_tree_stats
+                , m_curve_tree_stats
+#endif
+                );
+
+            double distance;
+            visitor.visit(
+                node,
+                *packet.m_rays[j],
+                *packet.m_ray_infos[j],
+                distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+
+            if (visitor.hit())
+            {
+                m_hits |= ray_bit;
+                packet.m_active &= ~ray_bit;
+            }
+        }
+
+        return;
+    }
+
+    for (size_t i = 0; i < assembly_instance_count; ++i)
+    {
+        // Retrieve the assembly instance and its triangle tree.
+        const AssemblyTree::Item& item = items[i];
+        const AssemblyInstance& assembly_instance = *item.m_assembly_instance;
+        const TriangleTree* triangle_tree =
+            m_triangle_tree_cache.access(
+                item.m_assembly_uid,
+                m_tree.m_triangle_trees);
+
+        if (triangle_tree == nullptr)
+            continue;
+
+        FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+        // Transform the rays for which the assembly instance is visible to assembly instance space.
+        ShadingRay asm_inst_rays[ProbeRayPacketSize];
+        RayInfo3d asm_inst_ray_infos[ProbeRayPacketSize];
+        double ray_times[ProbeRayPacketSize];
+        VisibilityFlags::Type ray_flags[ProbeRayPacketSize];
+        TriangleLeafPacketProbeVisitor::RayPacketType asm_inst_packet;
+
+        for (size_t j = 0; j < ProbeRayPacketSize; ++j)
+        {
+            if (!(ray_mask & packet.m_active & (std::uint32_t(1) << j)))
+                continue;
+
+            const ShadingRay& ray = *packet.m_rays[j];
+            if (!(assembly_instance.get_vis_flags() & ray.m_flags) ||
+                !(triangle_tree->get_vis_flags() & ray.m_flags))
+                continue;
+
+            compute_assembly_instance_ray(
+                assembly_instance,
+                m_tree.m_static_transforms[item.m_static_transform_index],
+                m_parent_shading_point,
+                ray,
+                asm_inst_rays[j]);
+            asm_inst_ray_infos[j] = RayInfo3d(asm_inst_rays[j]);
+            ray_times[j] = asm_inst_rays[j].m_time.m_normalized;
+            ray_flags[j] = asm_inst_rays[j].m_flags;
+
+            asm_inst_packet.set(j, asm_inst_rays[j], asm_inst_ray_infos[j]);
+        }
+
+        if (asm_inst_packet.m_active == 0)
+            continue;
+
+        // Check the intersection between the rays and the triangle tree.
+        TriangleTreePacketProbeIntersector intersector;
+        TriangleLeafPacketProbeVisitor visitor(*triangle_tree, ray_times, ray_flags);
+        intersector.intersect_no_motion(
+            *triangle_tree,
+            asm_inst_packet,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_triangle_tree_stats
+#endif
+            );
+
+        // Rays that hit a triangle are done.
+        m_hits |= visitor.get_hits();
+        packet.m_active &= ~visitor.get_hits();
+
+        if (!(ray_mask & packet.m_active))
+            break;
+    }
+}
+
+bool AssemblyLeafPacketProbeVisitor::supports_packets(const AssemblyTree::Item& item)
+{
+    // Moving assembly instances need their transform evaluated for each ray.
+    if (item.m_static_transform_index == AssemblyTree::Item::NoStaticTransform)
+        return false;
+
+#ifdef APPLESEED_WITH_EMBREE
+    if (m_tree.use_embree())
+        return false;
+#endif
+
+    // Curves and procedural objects are only intersected one ray at a time.
+    if (!item.m_assembly->get_render_data().m_procedural_object_instances.empty())
+        return false;
+
+    if (m_curve_tree_cache.access(item.m_assembly_uid, m_tree.m_curve_trees))
+        return false;
+
+    // Packets only traverse triangle trees without motion.
+    const TriangleTree* triangle_tree =
+        m_triangle_tree_cache.access(
+            item.m_assembly_uid,
+            m_tree.m_triangle_trees);
+
+    return triangle_tree == nullptr || triangle_tree->get_moving_triangle_count() == 0;
+}
+
 }   // namespace renderer
@@ -34,6 +34,7 @@
 #ifdef APPLESEED_WITH_EMBREE
 #include "renderer/kernel/intersection/embreescene.h"
 #endif
+#include "renderer/kernel/intersection/occludercache.h"
 #include "renderer/kernel/intersection/probevisitorbase.h"
 #include "renderer/kernel/intersection/treerepository.h"
 #include "renderer/kernel/intersection/triangletree.h"
@@ -47,12 +48,20 @@
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
+#include "foundation/math/matrix.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/memorytracker.h"
+#include "foundation/platform/compiler.h"
 #include "foundation/utility/uid.h"
 #include "foundation/utility/version.h"
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 // Forward declarations.
@@ -82,7 +91,9 @@ class AssemblyTree
     // Destructor.
     ~AssemblyTree();
 
-    // Update the assembly tree and all the child trees.
+    // Update the assembly tree and all the child trees. When only the transforms or
+    // bounding boxes of assembly instances changed, the existing tree is refitted
+    // instead of being rebuilt, unless refitting degrades the tree too much.
     void update();
 
     // Return the size (in bytes) of this object in memory.
@@ -97,39 +108,70 @@ class AssemblyTree
 
   private:
     friend class AssemblyLeafVisitor;
+    friend class AssemblyLeafPacketProbeVisitor;
     friend class AssemblyLeafProbeVisitor;
     friend class Intersector;
 
+    // Single-precision transform from parent space to the space of a static assembly
+    // instance, made of the first three rows of the matrix. Assembly instances with
+    // the same placement share the same static transform.
+    struct StaticTransform
+    {
+        APPLESEED_SIMD4_ALIGN float             m_rows[3][4];
+
+        explicit StaticTransform(const foundation::Matrix4d& parent_to_local);
+
+        foundation::Vector3d point_to_local(const foundation::Vector3d& p) const;
+        foundation::Vector3d vector_to_local(const foundation::Vector3d& v) const;
+    };
+
     struct Item
     {
+        // Value of m_static_transform_index for moving assembly instances.
+        static const std::uint32_t NoStaticTransform = ~std::uint32_t(0);
+
         const renderer::Assembly*               m_assembly;
         foundation::UniqueID                    m_assembly_uid;
         const renderer::AssemblyInstance*       m_assembly_instance;
-        renderer::TransformSequence             m_transform_sequence;
+        const renderer::TransformSequence*      m_transform_sequence;       // owned by the assembly instance or by the tree
+        std::uint32_t                           m_static_transform_index;
 
         Item() {}
 
         Item(
             const renderer::Assembly*           assembly,
             const renderer::AssemblyInstance*   assembly_instance,
-            const renderer::TransformSequence&  transform_sequence)
+            const renderer::TransformSequence*  transform_sequence,
+            const std::uint32_t                 static_transform_index)
           : m_assembly(assembly)
           , m_assembly_uid(assembly->get_uid())
           , m_assembly_instance(assembly_instance)
           , m_transform_sequence(transform_sequence)
+          , m_static_transform_index(static_transform_index)
         {
         }
     };
 
     typedef std::vector<Item> ItemVector;
+    typedef std::deque<TransformSequence> TransformSequenceDeque;
+    typedef foundation::AlignedVector<StaticTransform> StaticTransformVector;
+    typedef std::unordered_map<std::uint64_t, std::uint32_t> StaticTransformIndexMap;
     typedef std::vector<foundation::AABB3d> AABBVector;
+    typedef std::vector<AABBVector> MotionAABBVector;
     typedef std::vector<const Assembly*> AssemblyVector;
     typedef std::map<foundation::UniqueID, foundation::VersionID> AssemblyVersionMap;
 
     const Scene&                    m_scene;
     ItemVector                      m_items;
+    std::vector<foundation::UniqueID> m_item_instance_uids;     // in collection order
+    std::vector<size_t>             m_item_ordering;            // tree position -> collection order
+    TransformSequenceDeque          m_transform_sequences;      // cumulated transforms of nested assembly instances
+    StaticTransformVector           m_static_transforms;
+    double                          m_built_sah_cost;
     AssemblyVersionMap              m_assembly_versions;
+    foundation::TrackedMemory       m_tracked_memory;
 
+    TriangleTreeMemoryBudget        m_triangle_tree_budget;     // must outlive the triangle trees
     TreeRepository<TriangleTree>    m_triangle_tree_repository;
     TriangleTreeContainer           m_triangle_trees;
 
@@ -140,6 +182,7 @@ class AssemblyTree
 
     TreeRepository<EmbreeScene>     m_embree_scene_repository;
     EmbreeSceneContainer            m_embree_scenes;
+    std::unique_ptr<EmbreeInstanceScene> m_embree_instance_scene;  // references the scenes above
     bool                            m_use_embree;
     bool                            m_dirty; // is used to determine triangle tree / embree switch
 
@@ -148,9 +191,27 @@ class AssemblyTree
     void collect_assembly_instances(
         const AssemblyInstanceContainer&        assembly_instances,
         const TransformSequence&                parent_transform_seq,
-        AABBVector&                             assembly_instance_bboxes);
+        StaticTransformIndexMap&                static_transform_indices,
+        AABBVector&                             assembly_instance_bboxes,
+        MotionAABBVector&                       assembly_instance_motion_bboxes);
+
+    // Return the index of the static transform of a static assembly instance,
+    // reusing an existing static transform with the same placement if possible.
+    std::uint32_t insert_static_transform(
+        const foundation::Transformd&           transform,
+        StaticTransformIndexMap&                static_transform_indices);
 
     void rebuild_assembly_tree();
+    bool refit_assembly_tree();
+    foundation::AABB3d refit_node(const size_t node_index, const AABBVector& item_bboxes);
+    double compute_sah_cost() const;
+
+    // Store per-node bounding boxes at regularly spaced times across the shutter interval,
+    // so that traversal only considers the motion of assembly instances around a ray's time.
+    // Item motion bounding boxes must be given in tree order.
+    void store_motion_bboxes(const MotionAABBVector& item_motion_bboxes);
+    AABBVector compute_motion_bboxes(const MotionAABBVector& item_motion_bboxes, const size_t node_index);
+    bool has_motion_bboxes() const;
     void store_items_in_leaves(foundation::Statistics& statistics);
 
     void update_tree_hierarchy();
@@ -166,6 +227,12 @@ class AssemblyTree
     void create_embree_scene(const Assembly& assembly);
     void delete_embree_scene(const foundation::UniqueID assembly_id);
 
+    // Build all Embree scenes that don't exist yet, in parallel.
+    void build_embree_scenes();
+
+    // Build a two-level Embree scene over all assembly instances, if they are all static.
+    void build_embree_instance_scene();
+
 #endif
 
     void delete_child_trees(const foundation::UniqueID assembly_id);
@@ -190,6 +257,7 @@ class AssemblyLeafVisitor
         const AssemblyTree&                         tree,
         TriangleTreeAccessCache&                    triangle_tree_cache,
         CurveTreeAccessCache&                       curve_tree_cache,
+        TransformSequenceCache&                     transform_cache,
 #ifdef APPLESEED_WITH_EMBREE
         EmbreeSceneAccessCache&                     embree_scene_cache,
 #endif
@@ -211,11 +279,21 @@ class AssemblyLeafVisitor
 #endif
         );
 
+    // Intersect the ray of the shading point with the triangles of a single object instance,
+    // bypassing the assembly tree as well as curves and procedural objects.
+    void visit_object_instance(
+        const AssemblyInstance&                     assembly_instance,
+        const foundation::UniqueID                  assembly_uid,
+        const foundation::Transformd&               assembly_instance_transform,
+        const TransformSequence*                    assembly_instance_transform_seq,
+        const size_t                                object_instance_index);
+
   private:
     ShadingPoint&                                   m_shading_point;
     const AssemblyTree&                             m_tree;
     TriangleTreeAccessCache&                        m_triangle_tree_cache;
     CurveTreeAccessCache&                           m_curve_tree_cache;
+    TransformSequenceCache&                         m_transform_cache;
 #ifdef APPLESEED_WITH_EMBREE
     EmbreeSceneAccessCache&                         m_embree_scene_cache;
 #endif
@@ -224,6 +302,20 @@ class AssemblyLeafVisitor
     foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
     foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
 #endif
+
+    // Intersect a ray expressed in assembly instance space with a triangle tree.
+    void intersect_triangle_tree(
+        const TriangleTree&                         triangle_tree,
+        ShadingPoint&                               asm_inst_shading_point,
+        const foundation::RayInfo3d&                asm_inst_ray_info,
+        const size_t                                object_instance_index);
+
+    // Keep track of the closest surface hit found in an assembly instance.
+    void record_closest_hit(
+        const ShadingPoint&                         asm_inst_shading_point,
+        const AssemblyInstance*                     assembly_instance,
+        const foundation::Transformd&               assembly_instance_transform,
+        const TransformSequence*                    assembly_instance_transform_seq);
 };
 
 
@@ -241,10 +333,12 @@ class AssemblyLeafProbeVisitor
         const AssemblyTree&                         tree,
         TriangleTreeAccessCache&                    triangle_tree_cache,
         CurveTreeAccessCache&                       curve_tree_cache,
+        TransformSequenceCache&                     transform_cache,
 #ifdef APPLESEED_WITH_EMBREE
         EmbreeSceneAccessCache&                     embree_scene_cache,
 #endif
-        const ShadingPoint*                         parent_shading_point
+        const ShadingPoint*                         parent_shading_point,
+        OccluderCache::Entry*                       occluder
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , foundation::bvh::TraversalStatistics&     triangle_tree_stats
         , foundation::bvh::TraversalStatistics&     curve_tree_stats
@@ -262,14 +356,21 @@ class AssemblyLeafProbeVisitor
 #endif
         );
 
+    // Return true if the occluder cached in a given entry blocks a given probe ray.
+    bool intersect_occluder(
+        const OccluderCache::Entry&                 occluder,
+        const ShadingRay&                           ray) const;
+
   private:
     const AssemblyTree&                             m_tree;
     TriangleTreeAccessCache&                        m_triangle_tree_cache;
     CurveTreeAccessCache&                           m_curve_tree_cache;
+    TransformSequenceCache&                         m_transform_cache;
 #ifdef APPLESEED_WITH_EMBREE
     EmbreeSceneAccessCache&                         m_embree_scene_cache;
 #endif
     const ShadingPoint*                             m_parent_shading_point;
+    OccluderCache::Entry*                           m_occluder;                 // optional, records the occluder on hit
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
     foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
@@ -277,6 +378,69 @@ class AssemblyLeafProbeVisitor
 };
 
 
+//
+// Assembly leaf visitor for packets of probe rays, used in conjunction with
+// foundation::bvh::PacketIntersector. Rays of the packet traverse the triangle
+// trees of static assembly instances together. Leaves holding an assembly
+// instance that moves, is rendered with Embree, or contains curves or procedural
+// objects fall back to AssemblyLeafProbeVisitor, one ray at a time.
+//
+
+class AssemblyLeafPacketProbeVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    typedef foundation::bvh::RayPacket<ShadingRay, ProbeRayPacketSize> RayPacketType;
+
+    // Constructor.
+    AssemblyLeafPacketProbeVisitor(
+        const AssemblyTree&                         tree,
+        TriangleTreeAccessCache&                    triangle_tree_cache,
+        CurveTreeAccessCache&                       curve_tree_cache,
+        TransformSequenceCache&                     transform_cache,
+#ifdef APPLESEED_WITH_EMBREE
+        EmbreeSceneAccessCache&                     embree_scene_cache,
+#endif
+        const ShadingPoint*                         parent_shading_point
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     triangle_tree_stats
+        , foundation::bvh::TraversalStatistics&     curve_tree_stats
+#endif
+        );
+
+    // Visit a leaf.
+    void visit(
+        const AssemblyTree::NodeType&               node,
+        const std::uint32_t                         ray_mask,
+        RayPacketType&                              packet
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     stats
+#endif
+        );
+
+    // Return the bit mask of the rays that hit something.
+    std::uint32_t get_hits() const;
+
+  private:
+    const AssemblyTree&                             m_tree;
+    TriangleTreeAccessCache&                        m_triangle_tree_cache;
+    CurveTreeAccessCache&                           m_curve_tree_cache;
+    TransformSequenceCache&                         m_transform_cache;
+#ifdef APPLESEED_WITH_EMBREE
+    EmbreeSceneAccessCache&                         m_embree_scene_cache;
+#endif
+    const ShadingPoint*                             m_parent_shading_point;
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
+    foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
+#endif
+    std::uint32_t                                   m_hits;
+
+    // Return true if the rays of a packet can traverse a given assembly instance together.
+    bool supports_packets(const AssemblyTree::Item& item);
+};
+
+
 //
 // Assembly tree intersectors.
 //
@@ -293,6 +457,23 @@ typedef foundation::bvh::Intersector<
     ShadingRay
 > AssemblyTreeProbeIntersector;
 
+typedef foundation::bvh::PacketIntersector<
+    AssemblyTree,
+    AssemblyLeafPacketProbeVisitor,
+    ShadingRay,
+    ProbeRayPacketSize
+> AssemblyTreePacketProbeIntersector;
+
+
+//
+// AssemblyTree class implementation.
+//
+
+inline bool AssemblyTree::has_motion_bboxes() const
+{
+    return !m_node_bboxes.empty();
+}
+
 
 //
 // AssemblyLeafVisitor class implementation.
@@ -303,6 +484,7 @@ inline AssemblyLeafVisitor::AssemblyLeafVisitor(
     const AssemblyTree&                             tree,
     TriangleTreeAccessCache&                        triangle_tree_cache,
     CurveTreeAccessCache&                           curve_tree_cache,
+    TransformSequenceCache&                         transform_cache,
 #ifdef APPLESEED_WITH_EMBREE
     EmbreeSceneAccessCache&                         embree_scene_cache,
 #endif
@@ -316,6 +498,7 @@ inline AssemblyLeafVisitor::AssemblyLeafVisitor(
   , m_tree(tree)
   , m_triangle_tree_cache(triangle_tree_cache)
   , m_curve_tree_cache(curve_tree_cache)
+  , m_transform_cache(transform_cache)
 #ifdef APPLESEED_WITH_EMBREE
   , m_embree_scene_cache(embree_scene_cache)
 #endif
@@ -336,6 +519,43 @@ inline AssemblyLeafProbeVisitor::AssemblyLeafProbeVisitor(
     const AssemblyTree&                             tree,
     TriangleTreeAccessCache&                        triangle_tree_cache,
     CurveTreeAccessCache&                           curve_tree_cache,
+    TransformSequenceCache&                         transform_cache,
+#ifdef APPLESEED_WITH_EMBREE
+    EmbreeSceneAccessCache&                         embree_scene_cache,
+#endif
+    const ShadingPoint*                             parent_shading_point,
+    OccluderCache::Entry*                           occluder
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&         triangle_tree_stats
+    , foundation::bvh::TraversalStatistics&         curve_tree_stats
+#endif
+    )
+  : m_tree(tree)
+  , m_triangle_tree_cache(triangle_tree_cache)
+  , m_curve_tree_cache(curve_tree_cache)
+  , m_transform_cache(transform_cache)
+#ifdef APPLESEED_WITH_EMBREE
+  , m_embree_scene_cache(embree_scene_cache)
+#endif
+  , m_parent_shading_point(parent_shading_point)
+  , m_occluder(occluder)
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+  , m_triangle_tree_stats(triangle_tree_stats)
+  , m_curve_tree_stats(curve_tree_stats)
+#endif
+{
+}
+
+
+//
+// AssemblyLeafPacketProbeVisitor class implementation.
+//
+
+inline AssemblyLeafPacketProbeVisitor::AssemblyLeafPacketProbeVisitor(
+    const AssemblyTree&                             tree,
+    TriangleTreeAccessCache&                        triangle_tree_cache,
+    CurveTreeAccessCache&                           curve_tree_cache,
+    TransformSequenceCache&                         transform_cache,
 #ifdef APPLESEED_WITH_EMBREE
     EmbreeSceneAccessCache&                         embree_scene_cache,
 #endif
@@ -348,6 +568,7 @@ inline AssemblyLeafProbeVisitor::AssemblyLeafProbeVisitor(
   : m_tree(tree)
   , m_triangle_tree_cache(triangle_tree_cache)
   , m_curve_tree_cache(curve_tree_cache)
+  , m_transform_cache(transform_cache)
 #ifdef APPLESEED_WITH_EMBREE
   , m_embree_scene_cache(embree_scene_cache)
 #endif
@@ -356,7 +577,13 @@ inline AssemblyLeafProbeVisitor::AssemblyLeafProbeVisitor(
   , m_triangle_tree_stats(triangle_tree_stats)
   , m_curve_tree_stats(curve_tree_stats)
 #endif
+  , m_hits(0)
+{
+}
+
+inline std::uint32_t AssemblyLeafPacketProbeVisitor::get_hits() const
 {
+    return m_hits;
 }
 
 }   // namespace renderer
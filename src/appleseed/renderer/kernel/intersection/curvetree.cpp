@@ -50,6 +50,7 @@
 #include "foundation/platform/system.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/api/apistring.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/makevector.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/stopwatch.h"
@@ -68,6 +69,46 @@ namespace renderer
 // CurveTree class implementation.
 //
 
+namespace
+{
+    template <typename CurveType>
+    GAABB3 compute_curve_bbox(const CurveType& curve)
+    {
+        GAABB3 bbox = curve.compute_bbox();
+        bbox.grow(GVector3(GScalar(0.5) * curve.compute_max_width()));
+        return bbox;
+    }
+
+    // Recursively split a curve in halves for as long as it significantly tightens its
+    // bounds, then hand the resulting pieces and their bounding boxes over to 'store'.
+    template <typename CurveType, typename StoreFunction>
+    void split_and_store_curve(
+        const CurveType&        curve,
+        const GAABB3&           bbox,
+        const size_t            max_split_depth,
+        StoreFunction&          store)
+    {
+        if (max_split_depth > 0)
+        {
+            CurveType child1, child2;
+            curve.split(child1, child2);
+
+            const GAABB3 bbox1 = compute_curve_bbox(child1);
+            const GAABB3 bbox2 = compute_curve_bbox(child2);
+
+            if (half_surface_area(bbox1) + half_surface_area(bbox2) <
+                    CurveTreeSplitAreaThreshold * half_surface_area(bbox))
+            {
+                split_and_store_curve(child1, bbox1, max_split_depth - 1, store);
+                split_and_store_curve(child2, bbox2, max_split_depth - 1, store);
+                return;
+            }
+        }
+
+        store(curve, bbox);
+    }
+}
+
 CurveTree::Arguments::Arguments(
     const Scene&            scene,
     const UniqueID          curve_tree_uid,
@@ -81,9 +122,13 @@ CurveTree::Arguments::Arguments(
 }
 
 CurveTree::CurveTree(const Arguments& arguments)
-  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
+  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size(), true))
   , m_arguments(arguments)
+  , m_compressed(false)
+  , m_tracked_memory("acceleration structures")
 {
+    APPLESEED_TRACE_SCOPE("acceleration", "build curve tree");
+
     // Retrieve construction parameters.
     const MessageContext message_context(
         format("while building curve tree for assembly \"{0}\"", m_arguments.m_assembly.get_path()));
@@ -103,6 +148,8 @@ CurveTree::CurveTree(const Arguments& arguments)
     statistics.insert_time("total build time", stopwatch.measure().get_seconds());
     statistics.insert_size("nodes alignment", alignment(&m_nodes[0]));
 
+    m_tracked_memory.set_size(get_memory_size());
+
     // Print curve tree statistics.
     RENDERER_LOG_DEBUG("%s",
         StatisticsVector::make(
@@ -110,9 +157,25 @@ CurveTree::CurveTree(const Arguments& arguments)
             statistics).to_string().c_str());
 }
 
-void CurveTree::collect_curves(std::vector<GAABB3>& curve_bboxes)
+size_t CurveTree::get_memory_size() const
+{
+    return
+          TreeType::get_memory_size()
+        - sizeof(*static_cast<const TreeType*>(this))
+        + sizeof(*this)
+        + m_curves1.capacity() * sizeof(Curve1Type)
+        + m_curves3.capacity() * sizeof(Curve3Type)
+        + m_compressed_curves1.get_memory_size() - sizeof(m_compressed_curves1)
+        + m_compressed_curves3.get_memory_size() - sizeof(m_compressed_curves3)
+        + m_curve_keys.capacity() * sizeof(CurveKey);
+}
+
+size_t CurveTree::collect_curves(
+    const size_t            max_split_depth,
+    std::vector<GAABB3>&    curve_bboxes)
 {
     const ObjectInstanceContainer& object_instances = m_arguments.m_assembly.object_instances();
+    size_t curve_count = 0;
 
     for (size_t i = 0; i < object_instances.size(); ++i)
     {
@@ -129,6 +192,10 @@ void CurveTree::collect_curves(std::vector<GAABB3>& curve_bboxes)
 
         const CurveObject& curve_object = static_cast<const CurveObject&>(object);
 
+        // Keep curves compressed in the tree if any of the objects stores them compressed.
+        if (curve_object.has_compressed_curves())
+            m_compressed = true;
+
         // Retrieve the object instance transform.
         const Transformd::MatrixType& transform =
             object_instance->get_transform().get_local_to_parent();
@@ -137,42 +204,50 @@ void CurveTree::collect_curves(std::vector<GAABB3>& curve_bboxes)
         const size_t curve1_count = curve_object.get_curve1_count();
         for (size_t j = 0; j < curve1_count; ++j)
         {
+            auto store = [&](const Curve1Type& curve, const GAABB3& curve_bbox)
+            {
+                const CurveKey curve_key(
+                    i,                  // object instance index
+                    j,                  // curve index in object
+                    m_curves1.size(),   // curve index in tree
+                    0,                  // for now we assume all the curves have the same material
+                    1);                 // curve degree
+
+                m_curves1.push_back(curve);
+                m_curve_keys.push_back(curve_key);
+                curve_bboxes.push_back(curve_bbox);
+            };
+
             const Curve1Type curve(curve_object.get_curve1(j), transform);
-            const CurveKey curve_key(
-                i,                  // object instance index
-                j,                  // curve index in object
-                m_curves1.size(),   // curve index in tree
-                0,                  // for now we assume all the curves have the same material
-                1);                 // curve degree
-
-            GAABB3 curve_bbox = curve.compute_bbox();
-            curve_bbox.grow(GVector3(GScalar(0.5) * curve.compute_max_width()));
-
-            m_curves1.push_back(curve);
-            m_curve_keys.push_back(curve_key);
-            curve_bboxes.push_back(curve_bbox);
+            split_and_store_curve(curve, compute_curve_bbox(curve), max_split_depth, store);
         }
 
         // Store degree-3 curves, curve keys and curve bounding boxes.
         const size_t curve3_count = curve_object.get_curve3_count();
         for (size_t j = 0; j < curve3_count; ++j)
         {
+            auto store = [&](const Curve3Type& curve, const GAABB3& curve_bbox)
+            {
+                const CurveKey curve_key(
+                    i,                  // object instance index
+                    j,                  // curve index in object
+                    m_curves3.size(),   // curve index in tree
+                    0,                  // for now we assume all the curves have the same material
+                    3);                 // curve degree
+
+                m_curves3.push_back(curve);
+                m_curve_keys.push_back(curve_key);
+                curve_bboxes.push_back(curve_bbox);
+            };
+
             const Curve3Type curve(curve_object.get_curve3(j), transform);
-            const CurveKey curve_key(
-                i,                  // object instance index
-                j,                  // curve index in object
-                m_curves3.size(),   // curve index in tree
-                0,                  // for now we assume all the curves have the same material
-                3);                 // curve degree
-
-            GAABB3 curve_bbox = curve.compute_bbox();
-            curve_bbox.grow(GVector3(GScalar(0.5) * curve.compute_max_width()));
-
-            m_curves3.push_back(curve);
-            m_curve_keys.push_back(curve_key);
-            curve_bboxes.push_back(curve_bbox);
+            split_and_store_curve(curve, compute_curve_bbox(curve), max_split_depth, store);
         }
+
+        curve_count += curve1_count + curve3_count;
     }
+
+    return curve_count;
 }
 
 void CurveTree::build_bvh(
@@ -185,18 +260,21 @@ void CurveTree::build_bvh(
         "collecting geometry for curve tree #" FMT_UNIQUE_ID " from assembly \"%s\"...",
         m_arguments.m_curve_tree_uid,
         m_arguments.m_assembly.get_path().c_str());
+    const size_t max_split_depth = params.get_optional<size_t>("curve_split_depth", CurveTreeDefaultMaxSplitDepth);
     std::vector<GAABB3> curve_bboxes;
-    collect_curves(curve_bboxes);
+    const size_t curve_count = collect_curves(max_split_depth, curve_bboxes);
 
     // Print statistics about the input geometry.
     RENDERER_LOG_INFO(
-        "building curve tree #" FMT_UNIQUE_ID " (bvh, %s %s)...",
+        "building curve tree #" FMT_UNIQUE_ID " (bvh, %s %s, %s %s)...",
         m_arguments.m_curve_tree_uid,
+        pretty_uint(curve_count).c_str(),
+        plural(curve_count, "curve").c_str(),
         pretty_uint(m_curve_keys.size()).c_str(),
-        plural(m_curve_keys.size(), "curve").c_str());
+        plural(m_curve_keys.size(), "segment").c_str());
 
     // Create the partitioner.
-    typedef bvh::SAHPartitioner<std::vector<GAABB3>> Partitioner;
+    typedef bvh::BinnedSAHPartitioner<std::vector<GAABB3>> Partitioner;
     Partitioner partitioner(
         curve_bboxes,
         CurveTreeDefaultMaxLeafSize,
@@ -204,13 +282,17 @@ void CurveTree::build_bvh(
         CurveTreeDefaultCurveIntersectionCost);
 
     // Build the tree.
+    const size_t build_thread_count = params.get_optional<size_t>("build_thread_count", System::get_logical_cpu_core_count());
     typedef bvh::Builder<CurveTree, Partitioner> Builder;
     Builder builder;
     builder.build<DefaultWallclockTimer>(
         *this,
         partitioner,
         m_curves1.size() + m_curves3.size(),
-        CurveTreeDefaultMaxLeafSize);
+        CurveTreeDefaultMaxLeafSize,
+        build_thread_count);
+    statistics.insert("curves", curve_count);
+    statistics.insert("curve segments", m_curve_keys.size());
     statistics.merge(
         bvh::TreeStatistics<CurveTree>(*this, m_arguments.m_bbox));
 
@@ -222,6 +304,9 @@ void CurveTree::build_bvh(
         reorder_curves(ordering);
         reorder_curve_keys_in_leaf_nodes();
     }
+
+    if (m_compressed)
+        compress_curves();
 }
 
 void CurveTree::reorder_curve_keys(const std::vector<size_t>& ordering)
@@ -301,6 +386,20 @@ void CurveTree::reorder_curve_keys_in_leaf_nodes()
     }
 }
 
+void CurveTree::compress_curves()
+{
+    m_compressed_curves1.reserve(m_curves1.size());
+    for (size_t i = 0; i < m_curves1.size(); ++i)
+        m_compressed_curves1.push_back(m_curves1[i]);
+
+    m_compressed_curves3.reserve(m_curves3.size());
+    for (size_t i = 0; i < m_curves3.size(); ++i)
+        m_compressed_curves3.push_back(m_curves3[i]);
+
+    clear_release_memory(m_curves1);
+    clear_release_memory(m_curves3);
+}
+
 
 //
 // CurveTreeFactory class implementation.
@@ -40,11 +40,14 @@
 #include "foundation/containers/alignedvector.h"
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/bvh.h"
+#include "foundation/math/compressedbeziercurve.h"
+#include "foundation/memory/memorytracker.h"
 #include "foundation/memory/poolallocator.h"
 #include "foundation/utility/lazy.h"
 #include "foundation/utility/uid.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <map>
@@ -91,6 +94,9 @@ class CurveTree
     // Constructor, builds the tree for a given assembly.
     explicit CurveTree(const Arguments& arguments);
 
+    // Return the size (in bytes) of this object in memory.
+    size_t get_memory_size() const;
+
   private:
     friend class CurveLeafVisitor;
     friend class CurveLeafProbeVisitor;
@@ -103,12 +109,24 @@ class CurveTree
         std::uint32_t       m_curve3_count;
     };
 
-    const Arguments         m_arguments;
-    std::vector<Curve1Type> m_curves1;
-    std::vector<Curve3Type> m_curves3;
-    std::vector<CurveKey>   m_curve_keys;
-
-    void collect_curves(std::vector<GAABB3>& curve_bboxes);
+    const Arguments                                             m_arguments;
+    bool                                                        m_compressed;
+    std::vector<Curve1Type>                                     m_curves1;
+    std::vector<Curve3Type>                                     m_curves3;
+    foundation::CompressedBezierCurveArray<Curve1Type>          m_compressed_curves1;
+    foundation::CompressedBezierCurveArray<Curve3Type>          m_compressed_curves3;
+    std::vector<CurveKey>                                       m_curve_keys;
+    foundation::TrackedMemory                                   m_tracked_memory;
+
+    // Return a given curve, decompressing it into storage if curves are compressed.
+    const Curve1Type& get_curve1(const size_t index, Curve1Type& storage) const;
+    const Curve3Type& get_curve3(const size_t index, Curve3Type& storage) const;
+
+    // Collect the curves of the assembly, splitting curved or slanted ones to tighten their bounds.
+    // Return the number of curves collected before splitting.
+    size_t collect_curves(
+        const size_t                            max_split_depth,
+        std::vector<GAABB3>&                    curve_bboxes);
 
     void build_bvh(
         const ParamArray&                       params,
@@ -123,6 +141,9 @@ class CurveTree
 
     // Reorder curve keys in leaf nodes so that all degree-1 curve keys come before degree-3 ones.
     void reorder_curve_keys_in_leaf_nodes();
+
+    // Move curves to compressed storage.
+    void compress_curves();
 };
 
 
@@ -249,6 +270,29 @@ typedef foundation::bvh::Intersector<
 > CurveTreeProbeIntersector;
 
 
+//
+// CurveTree class implementation.
+//
+
+inline const Curve1Type& CurveTree::get_curve1(const size_t index, Curve1Type& storage) const
+{
+    if (!m_compressed)
+        return m_curves1[index];
+
+    storage = m_compressed_curves1.get(index);
+    return storage;
+}
+
+inline const Curve3Type& CurveTree::get_curve3(const size_t index, Curve3Type& storage) const
+{
+    if (!m_compressed)
+        return m_curves3[index];
+
+    storage = m_compressed_curves3.get(index);
+    return storage;
+}
+
+
 //
 // CurveLeafVisitor class implementation.
 //
@@ -279,31 +323,56 @@ inline bool CurveLeafVisitor::visit(
     size_t hit_curve_index = ~size_t(0);
     GScalar u, v, t = ray.m_tmax;
 
-    for (std::uint32_t i = 0; i < user_data.m_curve1_count; ++i, ++curve_index)
+    // Curves are culled in batches before running the full intersection test on the survivors.
+    for (std::uint32_t i = 0; i < user_data.m_curve1_count; i += Curve1IntersectorType::CullBatchSize)
     {
-        const Curve1Type& curve = m_tree.m_curves1[user_data.m_curve1_offset + i];
-        if (Curve1IntersectorType::intersect(curve, ray, m_xfm_matrix, u, v, t))
+        Curve1Type storage[Curve1IntersectorType::CullBatchSize];
+        const Curve1Type* batch[Curve1IntersectorType::CullBatchSize];
+        const size_t batch_size =
+            std::min<size_t>(user_data.m_curve1_count - i, Curve1IntersectorType::CullBatchSize);
+        for (size_t j = 0; j < batch_size; ++j)
+            batch[j] = &m_tree.get_curve1(user_data.m_curve1_offset + i + j, storage[j]);
+
+        size_t mask = Curve1IntersectorType::cull(batch, batch_size, ray, m_xfm_matrix, t);
+
+        for (size_t j = 0; mask != 0; ++j, mask >>= 1)
         {
-            m_shading_point.m_primitive_type = ShadingPoint::PrimitiveCurve1;
-            m_shading_point.m_ray.m_tmax = static_cast<double>(t);
-            m_shading_point.m_bary[0] = static_cast<float>(u);
-            m_shading_point.m_bary[1] = static_cast<float>(v);
-            hit_curve_index = curve_index;
+            if ((mask & 1) && Curve1IntersectorType::intersect(*batch[j], ray, m_xfm_matrix, u, v, t))
+            {
+                m_shading_point.m_primitive_type = ShadingPoint::PrimitiveCurve1;
+                m_shading_point.m_ray.m_tmax = static_cast<double>(t);
+                m_shading_point.m_bary[0] = static_cast<float>(u);
+                m_shading_point.m_bary[1] = static_cast<float>(v);
+                hit_curve_index = curve_index + i + j;
+            }
         }
     }
 
+    curve_index += user_data.m_curve1_count;
+
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(curve1_curve_count));
 
-    for (std::uint32_t i = 0; i < user_data.m_curve3_count; ++i, ++curve_index)
+    for (std::uint32_t i = 0; i < user_data.m_curve3_count; i += Curve3IntersectorType::CullBatchSize)
     {
-        const Curve3Type& curve = m_tree.m_curves3[user_data.m_curve3_offset + i];
-        if (Curve3IntersectorType::intersect(curve, ray, m_xfm_matrix, u, v, t))
+        Curve3Type storage[Curve3IntersectorType::CullBatchSize];
+        const Curve3Type* batch[Curve3IntersectorType::CullBatchSize];
+        const size_t batch_size =
+            std::min<size_t>(user_data.m_curve3_count - i, Curve3IntersectorType::CullBatchSize);
+        for (size_t j = 0; j < batch_size; ++j)
+            batch[j] = &m_tree.get_curve3(user_data.m_curve3_offset + i + j, storage[j]);
+
+        size_t mask = Curve3IntersectorType::cull(batch, batch_size, ray, m_xfm_matrix, t);
+
+        for (size_t j = 0; mask != 0; ++j, mask >>= 1)
         {
-            m_shading_point.m_primitive_type = ShadingPoint::PrimitiveCurve3;
-            m_shading_point.m_ray.m_tmax = static_cast<double>(t);
-            m_shading_point.m_bary[0] = static_cast<float>(u);
-            m_shading_point.m_bary[1] = static_cast<float>(v);
-            hit_curve_index = curve_index;
+            if ((mask & 1) && Curve3IntersectorType::intersect(*batch[j], ray, m_xfm_matrix, u, v, t))
+            {
+                m_shading_point.m_primitive_type = ShadingPoint::PrimitiveCurve3;
+                m_shading_point.m_ray.m_tmax = static_cast<double>(t);
+                m_shading_point.m_bary[0] = static_cast<float>(u);
+                m_shading_point.m_bary[1] = static_cast<float>(v);
+                hit_curve_index = curve_index + i + j;
+            }
         }
     }
 
@@ -346,27 +415,49 @@ inline bool CurveLeafProbeVisitor::visit(
 {
     const CurveTree::LeafUserData& user_data = node.get_user_data<CurveTree::LeafUserData>();
 
-    for (std::uint32_t i = 0; i < user_data.m_curve1_count; ++i)
+    for (std::uint32_t i = 0; i < user_data.m_curve1_count; i += Curve1IntersectorType::CullBatchSize)
     {
-        const Curve1Type& curve = m_tree.m_curves1[user_data.m_curve1_offset + i];
-        if (Curve1IntersectorType::intersect(curve, ray, m_xfm_matrix))
+        Curve1Type storage[Curve1IntersectorType::CullBatchSize];
+        const Curve1Type* batch[Curve1IntersectorType::CullBatchSize];
+        const size_t batch_size =
+            std::min<size_t>(user_data.m_curve1_count - i, Curve1IntersectorType::CullBatchSize);
+        for (size_t j = 0; j < batch_size; ++j)
+            batch[j] = &m_tree.get_curve1(user_data.m_curve1_offset + i + j, storage[j]);
+
+        size_t mask = Curve1IntersectorType::cull(batch, batch_size, ray, m_xfm_matrix, ray.m_tmax);
+
+        for (size_t j = 0; mask != 0; ++j, mask >>= 1)
         {
-            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(i + 1));
-            m_hit = true;
-            return false;
+            if ((mask & 1) && Curve1IntersectorType::intersect(*batch[j], ray, m_xfm_matrix))
+            {
+                FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(i + j + 1));
+                m_hit = true;
+                return false;
+            }
         }
     }
 
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(curve1_curve_count));
 
-    for (std::uint32_t i = 0; i < user_data.m_curve3_count; ++i)
+    for (std::uint32_t i = 0; i < user_data.m_curve3_count; i += Curve3IntersectorType::CullBatchSize)
     {
-        const Curve3Type& curve = m_tree.m_curves3[user_data.m_curve3_offset + i];
-        if (Curve3IntersectorType::intersect(curve, ray, m_xfm_matrix))
+        Curve3Type storage[Curve3IntersectorType::CullBatchSize];
+        const Curve3Type* batch[Curve3IntersectorType::CullBatchSize];
+        const size_t batch_size =
+            std::min<size_t>(user_data.m_curve3_count - i, Curve3IntersectorType::CullBatchSize);
+        for (size_t j = 0; j < batch_size; ++j)
+            batch[j] = &m_tree.get_curve3(user_data.m_curve3_offset + i + j, storage[j]);
+
+        size_t mask = Curve3IntersectorType::cull(batch, batch_size, ray, m_xfm_matrix, ray.m_tmax);
+
+        for (size_t j = 0; mask != 0; ++j, mask >>= 1)
         {
-            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(i + 1));
-            m_hit = true;
-            return false;
+            if ((mask & 1) && Curve3IntersectorType::intersect(*batch[j], ray, m_xfm_matrix))
+            {
+                FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(i + j + 1));
+                m_hit = true;
+                return false;
+            }
         }
     }
 
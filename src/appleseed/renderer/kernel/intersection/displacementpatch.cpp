@@ -0,0 +1,276 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "displacementpatch.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/defaulttimers.h"
+
+// Standard headers.
+#include <limits>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// DisplacementPatch class implementation.
+//
+
+namespace
+{
+    // Maximum number of triangles per leaf of a patch BVH.
+    const size_t MaxTrianglesPerLeaf = 4;
+
+    typedef bvh::MiddlePartitioner<std::vector<AABB3d>> PatchPartitioner;
+}
+
+DisplacementPatch::DisplacementPatch(
+    std::vector<GVector3>&          vertices,
+    std::vector<GVector2>&          uvs,
+    std::vector<std::uint32_t>&     indices)
+{
+    assert(uvs.size() == vertices.size());
+    assert(indices.size() % 3 == 0);
+
+    m_vertices.swap(vertices);
+    m_uvs.swap(uvs);
+    m_indices.swap(indices);
+
+    const size_t triangle_count = get_triangle_count();
+
+    if (triangle_count == 0)
+        return;
+
+    // Compute the bounding boxes of the triangles.
+    std::vector<AABB3d> triangle_bboxes(triangle_count);
+    for (size_t i = 0; i < triangle_count; ++i)
+    {
+        AABB3d& bbox = triangle_bboxes[i];
+        bbox.invalidate();
+        bbox.insert(Vector3d(m_vertices[m_indices[i * 3 + 0]]));
+        bbox.insert(Vector3d(m_vertices[m_indices[i * 3 + 1]]));
+        bbox.insert(Vector3d(m_vertices[m_indices[i * 3 + 2]]));
+    }
+
+    // Build the BVH. Patches are small and built by the rendering thread that
+    // reaches them first, so a single thread and a cheap partitioner are used.
+    PatchPartitioner partitioner(triangle_bboxes, MaxTrianglesPerLeaf);
+    bvh::Builder<DisplacementPatch, PatchPartitioner> builder;
+    builder.build<DefaultWallclockTimer>(
+        *this,
+        partitioner,
+        triangle_count,
+        MaxTrianglesPerLeaf);
+
+    // Reorder the triangles to match the ordering of the BVH.
+    const std::vector<size_t>& ordering = partitioner.get_item_ordering();
+    assert(ordering.size() == triangle_count);
+
+    std::vector<std::uint32_t> reordered_indices(m_indices.size());
+    for (size_t i = 0; i < triangle_count; ++i)
+    {
+        const size_t src = ordering[i];
+        reordered_indices[i * 3 + 0] = m_indices[src * 3 + 0];
+        reordered_indices[i * 3 + 1] = m_indices[src * 3 + 1];
+        reordered_indices[i * 3 + 2] = m_indices[src * 3 + 2];
+    }
+
+    m_indices.swap(reordered_indices);
+}
+
+size_t DisplacementPatch::get_memory_size() const
+{
+    return
+          TreeType::get_memory_size()
+        - sizeof(TreeType)
+        + sizeof(*this)
+        + m_vertices.capacity() * sizeof(GVector3)
+        + m_uvs.capacity() * sizeof(GVector2)
+        + m_indices.capacity() * sizeof(std::uint32_t);
+}
+
+
+//
+// Patch leaf visitors.
+//
+
+class DisplacementPatch::LeafVisitor
+  : public NonCopyable
+{
+  public:
+    LeafVisitor(
+        const DisplacementPatch&    patch,
+        Hit&                        hit)
+      : m_patch(patch)
+      , m_hit(hit)
+      , m_found(false)
+    {
+        m_hit.m_distance = std::numeric_limits<double>::max();
+    }
+
+    bool visit(
+        const NodeType&             node,
+        const Ray3d&                ray,
+        const RayInfo3d&            ray_info,
+        double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , bvh::TraversalStatistics& stats
+#endif
+        )
+    {
+        Ray3d leaf_ray(ray);
+        if (m_found)
+            leaf_ray.m_tmax = m_hit.m_distance;
+
+        const size_t begin = node.get_item_index();
+        const size_t end = begin + node.get_item_count();
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            double t, u, v;
+            if (m_patch.get_triangle(i).intersect(leaf_ray, t, u, v))
+            {
+                leaf_ray.m_tmax = t;
+                m_hit.m_distance = t;
+                m_hit.m_triangle_index = i;
+                m_hit.m_u = u;
+                m_hit.m_v = v;
+                m_found = true;
+            }
+        }
+
+        distance = m_hit.m_distance;
+        return true;
+    }
+
+    bool found() const
+    {
+        return m_found;
+    }
+
+  private:
+    const DisplacementPatch&        m_patch;
+    Hit&                            m_hit;
+    bool                            m_found;
+};
+
+class DisplacementPatch::LeafProbeVisitor
+  : public NonCopyable
+{
+  public:
+    explicit LeafProbeVisitor(const DisplacementPatch& patch)
+      : m_patch(patch)
+      , m_found(false)
+    {
+    }
+
+    bool visit(
+        const NodeType&             node,
+        const Ray3d&                ray,
+        const RayInfo3d&            ray_info,
+        double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , bvh::TraversalStatistics& stats
+#endif
+        )
+    {
+        const size_t begin = node.get_item_index();
+        const size_t end = begin + node.get_item_count();
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (m_patch.get_triangle(i).intersect(ray))
+            {
+                m_found = true;
+                return false;
+            }
+        }
+
+        distance = ray.m_tmax;
+        return true;
+    }
+
+    bool found() const
+    {
+        return m_found;
+    }
+
+  private:
+    const DisplacementPatch&        m_patch;
+    bool                            m_found;
+};
+
+bool DisplacementPatch::intersect(
+    const Ray3d&                    ray,
+    Hit&                            hit) const
+{
+    if (m_nodes.empty())
+        return false;
+
+    LeafVisitor visitor(*this, hit);
+    FOUNDATION_BVH_TRAVERSAL_STATS(bvh::TraversalStatistics stats;)
+    bvh::Intersector<DisplacementPatch, LeafVisitor, Ray3d> intersector;
+    intersector.intersect_no_motion(
+        *this,
+        ray,
+        RayInfo3d(ray),
+        visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , stats
+#endif
+        );
+
+    return visitor.found();
+}
+
+bool DisplacementPatch::intersect(const Ray3d& ray) const
+{
+    if (m_nodes.empty())
+        return false;
+
+    LeafProbeVisitor visitor(*this);
+    FOUNDATION_BVH_TRAVERSAL_STATS(bvh::TraversalStatistics stats;)
+    bvh::Intersector<DisplacementPatch, LeafProbeVisitor, Ray3d> intersector;
+    intersector.intersect_no_motion(
+        *this,
+        ray,
+        RayInfo3d(ray),
+        visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , stats
+#endif
+        );
+
+    return visitor.found();
+}
+
+}   // namespace renderer
@@ -0,0 +1,153 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+
+// appleseed.foundation headers.
+#include "foundation/containers/alignedvector.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/bvh.h"
+#include "foundation/math/intersection/raytrianglemt.h"
+#include "foundation/math/ray.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A tessellated, displaced patch: a small triangle mesh with its own BVH.
+//
+// Patches are created on demand by displaced objects and live in a GeometryCache.
+//
+
+class DisplacementPatch
+  : public foundation::bvh::Tree<
+               foundation::AlignedVector<
+                   foundation::bvh::Node<foundation::AABB3d>
+               >
+           >
+{
+  public:
+    // Closest intersection between a ray and the patch.
+    struct Hit
+    {
+        double                          m_distance;
+        size_t                          m_triangle_index;
+        double                          m_u;                // barycentric coordinates in the triangle
+        double                          m_v;
+    };
+
+    // Constructor, builds the BVH. The contents of the vectors are moved into the
+    // patch. Triangles are given as triplets of indices into `vertices` and `uvs`.
+    DisplacementPatch(
+        std::vector<GVector3>&          vertices,
+        std::vector<GVector2>&          uvs,
+        std::vector<std::uint32_t>&     indices);
+
+    size_t get_triangle_count() const;
+
+    // Return a given triangle.
+    foundation::TriangleMT<double> get_triangle(const size_t triangle_index) const;
+
+    // Interpolate the UV coordinates of a given point of a given triangle.
+    GVector2 get_uv(
+        const size_t                    triangle_index,
+        const double                    u,
+        const double                    v) const;
+
+    // Find the closest intersection between a ray and the patch.
+    bool intersect(
+        const foundation::Ray3d&        ray,
+        Hit&                            hit) const;
+
+    // Return whether a ray intersects the patch.
+    bool intersect(const foundation::Ray3d& ray) const;
+
+    // Return the size (in bytes) of this object in memory.
+    size_t get_memory_size() const;
+
+  private:
+    class LeafVisitor;
+    class LeafProbeVisitor;
+
+    std::vector<GVector3>               m_vertices;
+    std::vector<GVector2>               m_uvs;
+    std::vector<std::uint32_t>          m_indices;
+};
+
+
+//
+// DisplacementPatch class implementation.
+//
+
+inline size_t DisplacementPatch::get_triangle_count() const
+{
+    return m_indices.size() / 3;
+}
+
+inline foundation::TriangleMT<double> DisplacementPatch::get_triangle(const size_t triangle_index) const
+{
+    assert(triangle_index < get_triangle_count());
+
+    const std::uint32_t* indices = &m_indices[triangle_index * 3];
+
+    return
+        foundation::TriangleMT<double>(
+            foundation::Vector3d(m_vertices[indices[0]]),
+            foundation::Vector3d(m_vertices[indices[1]]),
+            foundation::Vector3d(m_vertices[indices[2]]));
+}
+
+inline GVector2 DisplacementPatch::get_uv(
+    const size_t                        triangle_index,
+    const double                        u,
+    const double                        v) const
+{
+    assert(triangle_index < get_triangle_count());
+
+    const std::uint32_t* indices = &m_indices[triangle_index * 3];
+    const GScalar w1 = static_cast<GScalar>(u);
+    const GScalar w2 = static_cast<GScalar>(v);
+    const GScalar w0 = GScalar(1.0) - w1 - w2;
+
+    return
+          w0 * m_uvs[indices[0]]
+        + w1 * m_uvs[indices[1]]
+        + w2 * m_uvs[indices[2]];
+}
+
+}   // namespace renderer
@@ -38,7 +38,10 @@
 #include "renderer/modeling/object/object.h"
 #include "renderer/modeling/object/triangle.h"
 #include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
 #include "renderer/modeling/scene/containers.h"
+#include "renderer/utility/messagecontext.h"
+#include "renderer/utility/transformsequence.h"
 
 // appleseed.foundation headers.
 #include "foundation/math/area.h"
@@ -48,12 +51,15 @@
 #include "foundation/math/scalar.h"
 #include "foundation/math/transform.h"
 #include "foundation/platform/sse.h"
+#include "foundation/string/string.h"
 #include "foundation/utility/makevector.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/stopwatch.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstdint>
+#include <string>
 
 using namespace foundation;
 using namespace renderer;
@@ -70,6 +76,9 @@ class EmbreeGeometryData
     unsigned int            m_vertices_count;
     unsigned int            m_vertices_stride;
 
+    // Curve control points, as (x, y, z, radius) quadruples.
+    float*                  m_curve_vertices;
+
     // Primitive data.
     std::uint32_t*          m_primitives;
     size_t                  m_primitives_count;
@@ -85,6 +94,7 @@ class EmbreeGeometryData
 
     EmbreeGeometryData()
       : m_vertices(nullptr)
+      , m_curve_vertices(nullptr)
       , m_primitives(nullptr)
       , m_geometry_handle(nullptr)
     {
@@ -93,13 +103,28 @@ class EmbreeGeometryData
     ~EmbreeGeometryData()
     {
         delete[] m_vertices;
+        delete[] m_curve_vertices;
         delete[] m_primitives;
-        rtcReleaseGeometry(m_geometry_handle);
+
+        if (m_geometry_handle != nullptr)
+            rtcReleaseGeometry(m_geometry_handle);
     }
 };
 
 namespace
 {
+    // Return the object space position of a vertex of a mesh at a given motion key.
+    GVector3 get_vertex_key(
+        const StaticTriangleTess&   tess,
+        const size_t                vertex_index,
+        const size_t                key_index)
+    {
+        return
+            key_index == 0
+                ? tess.m_vertices[vertex_index]
+                : tess.get_vertex_pose(vertex_index, key_index - 1);
+    }
+
     void collect_triangle_data(
         const ObjectInstance&   object_instance,
         EmbreeGeometryData&     geometry_data)
@@ -115,7 +140,11 @@ namespace
         const MeshObject& mesh = static_cast<const MeshObject&>(object);
         const StaticTriangleTess& tess = mesh.get_static_triangle_tess();
 
-        const unsigned int motion_steps_count = static_cast<unsigned int>(tess.get_motion_segment_count()) + 1;
+        // Motion keys map one-to-one onto Embree time steps. Meshes with more keys than
+        // Embree supports are resampled to the maximum number of time steps.
+        const size_t key_count = tess.get_motion_segment_count() + 1;
+        const unsigned int motion_steps_count =
+            static_cast<unsigned int>(std::min<size_t>(key_count, RTC_MAX_TIME_STEP_COUNT));
         geometry_data.m_motion_steps_count = motion_steps_count;
 
         //
@@ -137,10 +166,30 @@ namespace
 
         for (size_t m = 1; m < motion_steps_count; ++m)
         {
-            for (size_t i = 0; i < vertices_count; ++i)
+            if (key_count == motion_steps_count)
+            {
+                for (size_t i = 0; i < vertices_count; ++i)
+                {
+                    const GVector3 vertex_os = get_vertex_key(tess, i, m);
+                    geometry_data.m_vertices[vertices_count * m + i] = transform.point_to_parent(vertex_os);
+                }
+            }
+            else
             {
-                const GVector3& vertex_os = tess.get_vertex_pose(i, m - 1);
-                geometry_data.m_vertices[vertices_count * m + i] = transform.point_to_parent(vertex_os);
+                // Interpolate the two keys surrounding the time of this time step.
+                const double key = static_cast<double>(m * (key_count - 1)) / (motion_steps_count - 1);
+                const size_t key_begin = std::min(truncate<size_t>(key), key_count - 2);
+                const GScalar p = static_cast<GScalar>(key - key_begin);
+
+                for (size_t i = 0; i < vertices_count; ++i)
+                {
+                    const GVector3 vertex_os =
+                        lerp(
+                            get_vertex_key(tess, i, key_begin),
+                            get_vertex_key(tess, i, key_begin + 1),
+                            p);
+                    geometry_data.m_vertices[vertices_count * m + i] = transform.point_to_parent(vertex_os);
+                }
             }
         }
 
@@ -161,25 +210,52 @@ namespace
         }
     };
 
+    template <typename CurveType>
     void collect_curve_data(
-        const ObjectInstance&   object_instance,
+        const Transformd&       transform,
+        const size_t            curve_count,
+        CurveType               (CurveObject::*get_curve)(const size_t) const,
+        const CurveObject&      curve_object,
         EmbreeGeometryData&     geometry_data)
     {
-        //const Transformd& transform = object_instance.get_transform();
+        const size_t ctrl_pts_per_curve = CurveType::Degree + 1;
 
-        switch(geometry_data.m_geometry_type)
-        {
-        case RTC_GEOMETRY_TYPE_FLAT_BEZIER_CURVE:
-            //
-            // [Note: Girish] Retrieve data from CurveObject here and push it to geometry_data.
-            //
+        geometry_data.m_motion_steps_count = 1;
 
-            break;
+        //
+        // Retrieve assembly space control points.
+        //
+        const unsigned int vertices_count = static_cast<unsigned int>(curve_count * ctrl_pts_per_curve);
+        geometry_data.m_vertices_count = vertices_count;
+        geometry_data.m_vertices_stride = sizeof(float) * 4;
 
-        default:
-            assert(!"Unsupported geometry type.");
-            break;
+        // Allocate memory for the control points. Keep one extra control point for padding.
+        geometry_data.m_curve_vertices = new float[(vertices_count + 1) * 4];
+
+        for (size_t i = 0; i < curve_count; ++i)
+        {
+            const CurveType curve((curve_object.*get_curve)(i), transform.get_local_to_parent());
+
+            for (size_t j = 0; j < ctrl_pts_per_curve; ++j)
+            {
+                const GVector3& p = curve.get_control_point(j);
+                float* vertex = &geometry_data.m_curve_vertices[(i * ctrl_pts_per_curve + j) * 4];
+                vertex[0] = static_cast<float>(p.x);
+                vertex[1] = static_cast<float>(p.y);
+                vertex[2] = static_cast<float>(p.z);
+                vertex[3] = static_cast<float>(0.5 * curve.get_width(j));
+            }
         }
+
+        //
+        // Retrieve per primitive data: each curve is a single segment referencing its first control point.
+        //
+        geometry_data.m_primitives = new std::uint32_t[curve_count];
+        geometry_data.m_primitives_stride = sizeof(std::uint32_t);
+        geometry_data.m_primitives_count = curve_count;
+
+        for (size_t i = 0; i < curve_count; ++i)
+            geometry_data.m_primitives[i] = static_cast<std::uint32_t>(i * ctrl_pts_per_curve);
     }
 
     // Returns minimal tnear needed to compensate double to float transition of ray fields.
@@ -212,11 +288,12 @@ namespace
 
     void shading_ray_to_embree_ray(
         const ShadingRay&       shading_ray,
+        const Vector3d&         org,
         RTCRay&                 embree_ray)
     {
-        embree_ray.org_x = static_cast<float>(shading_ray.m_org.x);
-        embree_ray.org_y = static_cast<float>(shading_ray.m_org.y);
-        embree_ray.org_z = static_cast<float>(shading_ray.m_org.z);
+        embree_ray.org_x = static_cast<float>(org.x);
+        embree_ray.org_y = static_cast<float>(org.y);
+        embree_ray.org_z = static_cast<float>(org.z);
 
         embree_ray.dir_x = static_cast<float>(shading_ray.m_dir.x);
         embree_ray.dir_y = static_cast<float>(shading_ray.m_dir.y);
@@ -230,6 +307,82 @@ namespace
 
         embree_ray.tnear = static_cast<float>(shading_ray.m_tmin) + tnear_offset;
     }
+
+    void shading_ray_to_embree_ray(
+        const ShadingRay&       shading_ray,
+        RTCRay&                 embree_ray)
+    {
+        shading_ray_to_embree_ray(shading_ray, shading_ray.m_org, embree_ray);
+    }
+
+    // Return the world space origin of a ray leaving a parent shading point.
+    Vector3d get_world_space_origin(
+        const ShadingRay&       shading_ray,
+        const ShadingPoint*     parent_shading_point)
+    {
+        if (parent_shading_point &&
+            parent_shading_point->get_primitive_type() == ShadingPoint::PrimitiveTriangle)
+        {
+            // Start from the properly offset previous intersection point, which is
+            // expressed in the space of the assembly instance that contains it.
+            const Transformd& transform = parent_shading_point->get_assembly_instance_transform();
+            return
+                transform.point_to_parent(
+                    parent_shading_point->get_offset_point(
+                        transform.vector_to_local(shading_ray.m_dir)));
+        }
+
+        return shading_ray.m_org;
+    }
+
+    RTCBuildQuality get_build_quality(
+        const ObjectInstance&   object_instance,
+        const bool              is_deforming)
+    {
+        const Object& object = object_instance.get_object();
+
+        const std::string quality =
+            object.get_parameters().get_optional<std::string>(
+                "embree_build_quality",
+                "auto",
+                make_vector("auto", "low", "medium", "high"),
+                EntityDefMessageContext("object", &object));
+
+        if (quality == "low")
+            return RTC_BUILD_QUALITY_LOW;
+        else if (quality == "medium")
+            return RTC_BUILD_QUALITY_MEDIUM;
+        else if (quality == "high")
+            return RTC_BUILD_QUALITY_HIGH;
+
+        // Deforming geometry is rebuilt whenever it changes: favor build speed over
+        // traversal speed. Static geometry gets the best BVH Embree can build.
+        return is_deforming ? RTC_BUILD_QUALITY_LOW : RTC_BUILD_QUALITY_HIGH;
+    }
+
+    // Embree devices own a thread pool and are expensive to create. A single device
+    // is shared by all scenes and lives until the process exits, so that successive
+    // renders in the same process don't pay for its creation again.
+    RTCDevice get_shared_device()
+    {
+        struct SharedDevice
+        {
+            RTCDevice m_device;
+
+            SharedDevice()
+              : m_device(rtcNewDevice(nullptr))
+            {
+            }
+
+            ~SharedDevice()
+            {
+                rtcReleaseDevice(m_device);
+            }
+        };
+
+        static SharedDevice shared_device;
+        return shared_device.m_device;
+    }
 }
 
 
@@ -238,10 +391,10 @@ namespace
 //
 
 EmbreeDevice::EmbreeDevice()
+  : m_device(get_shared_device())
 {
-    // todo: set number of threads.
-    m_device = rtcNewDevice(nullptr);
-};
+    rtcRetainDevice(m_device);
+}
 
 EmbreeDevice::~EmbreeDevice()
 {
@@ -264,9 +417,12 @@ EmbreeScene::EmbreeScene(const EmbreeScene::Arguments& arguments)
     m_device = arguments.m_device.m_device;
     m_scene = rtcNewScene(m_device);
 
-    rtcSetSceneBuildQuality(
-        m_scene,
-        RTCBuildQuality::RTC_BUILD_QUALITY_HIGH);
+    // The scene is built with the lowest quality requested by its geometries.
+    RTCBuildQuality scene_build_quality = RTC_BUILD_QUALITY_HIGH;
+
+    size_t mesh_count = 0;
+    size_t deforming_mesh_count = 0;
+    size_t time_step_count = 0;
 
     const ObjectInstanceContainer& instance_container = arguments.m_assembly.object_instances();
 
@@ -298,13 +454,24 @@ EmbreeScene::EmbreeScene(const EmbreeScene::Arguments& arguments)
             // Retrieve triangle data.
             collect_triangle_data(*object_instance, *geometry_data);
 
+            ++mesh_count;
+            if (geometry_data->m_motion_steps_count > 1)
+            {
+                ++deforming_mesh_count;
+                time_step_count += geometry_data->m_motion_steps_count;
+            }
+
             geometry_handle = rtcNewGeometry(
                 m_device,
                 RTC_GEOMETRY_TYPE_TRIANGLE);
 
+            const RTCBuildQuality build_quality =
+                get_build_quality(*object_instance, geometry_data->m_motion_steps_count > 1);
+            scene_build_quality = std::min(scene_build_quality, build_quality);
+
             rtcSetGeometryBuildQuality(
                 geometry_handle,
-                RTCBuildQuality::RTC_BUILD_QUALITY_HIGH);
+                build_quality);
 
             rtcSetGeometryTimeStepCount(
                 geometry_handle,
@@ -351,41 +518,48 @@ EmbreeScene::EmbreeScene(const EmbreeScene::Arguments& arguments)
         }
         else if (strcmp(object_model, CurveObjectFactory().get_model()) == 0)
         {
-            geometry_data->m_geometry_type = RTC_GEOMETRY_TYPE_FLAT_BEZIER_CURVE;
+            const CurveObject& curve_object = static_cast<const CurveObject&>(object_instance->get_object());
 
-            // Retrieve curve data.
-            collect_curve_data(*object_instance, *geometry_data);
+            const RTCBuildQuality build_quality = get_build_quality(*object_instance, false);
 
-            geometry_handle = rtcNewGeometry(
-                m_device,
-                RTC_GEOMETRY_TYPE_FLAT_BEZIER_CURVE);
-
-            rtcSetGeometryBuildQuality(
-                geometry_handle,
-                RTCBuildQuality::RTC_BUILD_QUALITY_HIGH);
-
-            // Set vertices. (x_pos, y_pos, z_pos, radii)
-            rtcSetSharedGeometryBuffer(
-                geometry_handle,                                // geometry
-                RTC_BUFFER_TYPE_INDEX,                          // buffer type
-                0,                                              // slot
-                RTC_FORMAT_FLOAT4,                              // format
-                geometry_data->m_vertices,                      // buffer
-                0,                                              // byte offset
-                geometry_data->m_vertices_stride,               // byte stride
-                geometry_data->m_vertices_count);               // item count
+            // Degree-1 and degree-3 curves of the object go to two distinct geometries.
+            if (curve_object.get_curve1_count() > 0)
+            {
+                std::unique_ptr<EmbreeGeometryData> curve1_data(new EmbreeGeometryData());
+                curve1_data->m_object_instance_idx = instance_idx;
+                curve1_data->m_vis_flags = object_instance->get_vis_flags();
+                curve1_data->m_geometry_type = RTC_GEOMETRY_TYPE_FLAT_LINEAR_CURVE;
+
+                collect_curve_data(
+                    object_instance->get_transform(),
+                    curve_object.get_curve1_count(),
+                    &CurveObject::get_curve1,
+                    curve_object,
+                    *curve1_data);
+
+                attach_curve_geometry(std::move(curve1_data), build_quality);
+                scene_build_quality = std::min(scene_build_quality, build_quality);
+            }
 
-            // Set vertex indices.
-            rtcSetSharedGeometryBuffer(
-                geometry_handle,                                // geometry
-                RTC_BUFFER_TYPE_INDEX,                          // buffer type
-                0,                                              // slot
-                RTC_FORMAT_UINT4,                               // format
-                geometry_data->m_primitives,                    // buffer
-                0,                                              // byte offset
-                geometry_data->m_primitives_stride,             // byte stride
-                geometry_data->m_primitives_count);             // item count
+            if (curve_object.get_curve3_count() > 0)
+            {
+                std::unique_ptr<EmbreeGeometryData> curve3_data(new EmbreeGeometryData());
+                curve3_data->m_object_instance_idx = instance_idx;
+                curve3_data->m_vis_flags = object_instance->get_vis_flags();
+                curve3_data->m_geometry_type = RTC_GEOMETRY_TYPE_FLAT_BEZIER_CURVE;
+
+                collect_curve_data(
+                    object_instance->get_transform(),
+                    curve_object.get_curve3_count(),
+                    &CurveObject::get_curve3,
+                    curve_object,
+                    *curve3_data);
+
+                attach_curve_geometry(std::move(curve3_data), build_quality);
+                scene_build_quality = std::min(scene_build_quality, build_quality);
+            }
 
+            continue;
         }
         else
         {
@@ -393,12 +567,18 @@ EmbreeScene::EmbreeScene(const EmbreeScene::Arguments& arguments)
             continue;
         }
 
-        rtcAttachGeometryByID(m_scene, geometry_handle, static_cast<unsigned int>(instance_idx));
+        // Geometry IDs are indices into the geometry container.
+        rtcAttachGeometryByID(m_scene, geometry_handle, static_cast<unsigned int>(m_geometry_container.size()));
         m_geometry_container.push_back(std::move(geometry_data));
     }
 
+    rtcSetSceneBuildQuality(m_scene, scene_build_quality);
     rtcCommitScene(m_scene);
 
+    statistics.insert("meshes", mesh_count);
+    statistics.insert("deforming meshes", deforming_mesh_count);
+    if (deforming_mesh_count > 0)
+        statistics.insert("avg. time steps", static_cast<double>(time_step_count) / deforming_mesh_count);
     statistics.insert_time("total build time", stopwatch.measure().get_seconds());
 
     RENDERER_LOG_DEBUG("%s",
@@ -407,6 +587,51 @@ EmbreeScene::EmbreeScene(const EmbreeScene::Arguments& arguments)
             statistics).to_string().c_str());
 }
 
+void EmbreeScene::attach_curve_geometry(
+    std::unique_ptr<EmbreeGeometryData> geometry_data,
+    const RTCBuildQuality               build_quality)
+{
+    RTCGeometry geometry_handle = rtcNewGeometry(m_device, geometry_data->m_geometry_type);
+
+    rtcSetGeometryBuildQuality(
+        geometry_handle,
+        build_quality);
+
+    geometry_data->m_geometry_handle = geometry_handle;
+
+    // Set control points. (x_pos, y_pos, z_pos, radius)
+    rtcSetSharedGeometryBuffer(
+        geometry_handle,                                    // geometry
+        RTC_BUFFER_TYPE_VERTEX,                             // buffer type
+        0,                                                  // slot
+        RTC_FORMAT_FLOAT4,                                  // format
+        geometry_data->m_curve_vertices,                    // buffer
+        0,                                                  // byte offset
+        geometry_data->m_vertices_stride,                   // byte stride
+        geometry_data->m_vertices_count);                   // item count
+
+    // Set the index of the first control point of each curve.
+    rtcSetSharedGeometryBuffer(
+        geometry_handle,                                    // geometry
+        RTC_BUFFER_TYPE_INDEX,                              // buffer type
+        0,                                                  // slot
+        RTC_FORMAT_UINT,                                    // format
+        geometry_data->m_primitives,                        // buffer
+        0,                                                  // byte offset
+        geometry_data->m_primitives_stride,                 // byte stride
+        geometry_data->m_primitives_count);                 // item count
+
+    rtcSetGeometryMask(
+        geometry_handle,
+        geometry_data->m_vis_flags);
+
+    rtcCommitGeometry(geometry_handle);
+
+    // Geometry IDs are indices into the geometry container.
+    rtcAttachGeometryByID(m_scene, geometry_handle, static_cast<unsigned int>(m_geometry_container.size()));
+    m_geometry_container.push_back(std::move(geometry_data));
+}
+
 EmbreeScene::~EmbreeScene()
 {
     rtcReleaseScene(m_scene);
@@ -425,65 +650,89 @@ void EmbreeScene::intersect(ShadingPoint& shading_point) const
     rtcIntersect1(m_scene, &context, &rayhit);
 
     if (rayhit.hit.geomID != RTC_INVALID_GEOMETRY_ID)
-    {
-        assert(rayhit.hit.geomID < m_geometry_container.size());
+        record_hit(rayhit, shading_point);
+}
 
-        const auto& geometry_data = m_geometry_container[rayhit.hit.geomID];
-        assert(geometry_data);
+void EmbreeScene::record_hit(
+    const RTCRayHit&                    rayhit,
+    ShadingPoint&                       shading_point) const
+{
+    assert(rayhit.hit.geomID < m_geometry_container.size());
 
-        shading_point.m_bary[0] = rayhit.hit.u;
-        shading_point.m_bary[1] = rayhit.hit.v;
+    const auto& geometry_data = m_geometry_container[rayhit.hit.geomID];
+    assert(geometry_data);
+
+    if (geometry_data->m_geometry_type != RTC_GEOMETRY_TYPE_TRIANGLE)
+    {
+        // Embree's u is the parameter along the curve (appleseed's v), and its v is the
+        // signed distance to the center line of the flat curve in [-1, 1] (appleseed's u in [0, 1]).
+        shading_point.m_bary[0] = saturate(0.5f * (rayhit.hit.v + 1.0f));
+        shading_point.m_bary[1] = rayhit.hit.u;
 
         shading_point.m_object_instance_index = geometry_data->m_object_instance_idx;
-        // TODO: remove regions
         shading_point.m_primitive_index = rayhit.hit.primID;
-        shading_point.m_primitive_type = ShadingPoint::PrimitiveTriangle;
+        shading_point.m_primitive_type =
+            geometry_data->m_geometry_type == RTC_GEOMETRY_TYPE_FLAT_LINEAR_CURVE
+                ? ShadingPoint::PrimitiveCurve1
+                : ShadingPoint::PrimitiveCurve3;
         shading_point.m_ray.m_tmax = rayhit.ray.tfar;
 
-        const std::uint32_t v0_idx = geometry_data->m_primitives[rayhit.hit.primID * 3];
-        const std::uint32_t v1_idx = geometry_data->m_primitives[rayhit.hit.primID * 3 + 1];
-        const std::uint32_t v2_idx = geometry_data->m_primitives[rayhit.hit.primID * 3 + 2];
-
-        if (geometry_data->m_motion_steps_count > 1)
-        {
-            const std::uint32_t last_motion_step_idx = geometry_data->m_motion_steps_count - 1;
-
-            const std::uint32_t motion_step_begin_idx = static_cast<std::uint32_t>(rayhit.ray.time * last_motion_step_idx);
-            const std::uint32_t motion_step_end_idx = motion_step_begin_idx + 1;
-
-            const std::uint32_t motion_step_begin_offset = motion_step_begin_idx * geometry_data->m_vertices_count;
-            const std::uint32_t motion_step_end_offset = motion_step_end_idx * geometry_data->m_vertices_count;
-
-            const float motion_step_begin_time = static_cast<float>(motion_step_begin_idx) / last_motion_step_idx;
+        return;
+    }
 
-            // Linear interpolation coefficients.
-            const float p = (rayhit.ray.time - motion_step_begin_time) * last_motion_step_idx;
-            const float q = 1.0f - p;
+    shading_point.m_bary[0] = rayhit.hit.u;
+    shading_point.m_bary[1] = rayhit.hit.v;
 
-            assert(p > 0.0f && p <= 1.0f);
+    shading_point.m_object_instance_index = geometry_data->m_object_instance_idx;
+    // TODO: remove regions
+    shading_point.m_primitive_index = rayhit.hit.primID;
+    shading_point.m_primitive_type = ShadingPoint::PrimitiveTriangle;
+    shading_point.m_ray.m_tmax = rayhit.ray.tfar;
 
-            const TriangleType triangle(
-                Vector3d(
-                    geometry_data->m_vertices[motion_step_begin_offset + v0_idx] * q
-                    + geometry_data->m_vertices[motion_step_end_offset + v0_idx] * p),
-                Vector3d(
-                    geometry_data->m_vertices[motion_step_begin_offset + v1_idx] * q
-                    + geometry_data->m_vertices[motion_step_end_offset + v1_idx] * p),
-                Vector3d(
-                    geometry_data->m_vertices[motion_step_begin_offset + v2_idx] * q
-                    + geometry_data->m_vertices[motion_step_end_offset + v2_idx] * p));
+    const std::uint32_t v0_idx = geometry_data->m_primitives[rayhit.hit.primID * 3];
+    const std::uint32_t v1_idx = geometry_data->m_primitives[rayhit.hit.primID * 3 + 1];
+    const std::uint32_t v2_idx = geometry_data->m_primitives[rayhit.hit.primID * 3 + 2];
 
-            shading_point.m_triangle_support_plane.initialize(triangle);
-        }
-        else
-        {
-            const TriangleType triangle(
-                Vector3d(geometry_data->m_vertices[v0_idx]),
-                Vector3d(geometry_data->m_vertices[v1_idx]),
-                Vector3d(geometry_data->m_vertices[v2_idx]));
+    if (geometry_data->m_motion_steps_count > 1)
+    {
+        const std::uint32_t last_motion_step_idx = geometry_data->m_motion_steps_count - 1;
+
+        // Rays at the very end of the shutter interval fall at the end of the last segment.
+        const float motion_step = rayhit.ray.time * last_motion_step_idx;
+        const std::uint32_t motion_step_begin_idx =
+            std::min(truncate<std::uint32_t>(motion_step), last_motion_step_idx - 1);
+        const std::uint32_t motion_step_end_idx = motion_step_begin_idx + 1;
+
+        const std::uint32_t motion_step_begin_offset = motion_step_begin_idx * geometry_data->m_vertices_count;
+        const std::uint32_t motion_step_end_offset = motion_step_end_idx * geometry_data->m_vertices_count;
+
+        // Linear interpolation coefficients.
+        const float p = motion_step - motion_step_begin_idx;
+        const float q = 1.0f - p;
+
+        assert(p >= 0.0f && p <= 1.0f);
+
+        const TriangleType triangle(
+            Vector3d(
+                geometry_data->m_vertices[motion_step_begin_offset + v0_idx] * q
+                + geometry_data->m_vertices[motion_step_end_offset + v0_idx] * p),
+            Vector3d(
+                geometry_data->m_vertices[motion_step_begin_offset + v1_idx] * q
+                + geometry_data->m_vertices[motion_step_end_offset + v1_idx] * p),
+            Vector3d(
+                geometry_data->m_vertices[motion_step_begin_offset + v2_idx] * q
+                + geometry_data->m_vertices[motion_step_end_offset + v2_idx] * p));
+
+        shading_point.m_triangle_support_plane.initialize(triangle);
+    }
+    else
+    {
+        const TriangleType triangle(
+            Vector3d(geometry_data->m_vertices[v0_idx]),
+            Vector3d(geometry_data->m_vertices[v1_idx]),
+            Vector3d(geometry_data->m_vertices[v2_idx]));
 
-            shading_point.m_triangle_support_plane.initialize(triangle);
-        }
+        shading_point.m_triangle_support_plane.initialize(triangle);
     }
 }
 
@@ -506,6 +755,154 @@ bool EmbreeScene::occlude(const ShadingRay& shading_ray) const
     return false;
 }
 
+
+//
+// EmbreeInstanceScene class implementation.
+//
+
+EmbreeInstanceScene::EmbreeInstanceScene(
+    const EmbreeDevice&                 device,
+    const InstanceVector&               instances)
+  : m_scene(rtcNewScene(device.m_device))
+  , m_instances(instances)
+{
+    // Start stopwatch.
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    for (size_t i = 0, e = m_instances.size(); i < e; ++i)
+    {
+        const Instance& instance = m_instances[i];
+
+        RTCGeometry geometry_handle = rtcNewGeometry(device.m_device, RTC_GEOMETRY_TYPE_INSTANCE);
+        rtcSetGeometryInstancedScene(geometry_handle, instance.m_scene->m_scene);
+
+        // Embree expects the first three rows of the local-to-parent matrix.
+        const Matrix4d& local_to_parent =
+            instance.m_transform_sequence->get_earliest_transform().get_local_to_parent();
+        float xfm[12];
+        for (size_t row = 0; row < 3; ++row)
+        {
+            for (size_t col = 0; col < 4; ++col)
+                xfm[row * 4 + col] = static_cast<float>(local_to_parent(row, col));
+        }
+        rtcSetGeometryTransform(geometry_handle, 0, RTC_FORMAT_FLOAT3X4_ROW_MAJOR, xfm);
+
+        rtcSetGeometryMask(geometry_handle, instance.m_assembly_instance->get_vis_flags());
+        rtcCommitGeometry(geometry_handle);
+
+        // Instance IDs are indices into the instance vector.
+        rtcAttachGeometryByID(m_scene, geometry_handle, static_cast<unsigned int>(i));
+        rtcReleaseGeometry(geometry_handle);
+    }
+
+    rtcCommitScene(m_scene);
+
+    RENDERER_LOG_DEBUG(
+        "built embree instance scene with %s %s in %s.",
+        pretty_uint(m_instances.size()).c_str(),
+        plural(m_instances.size(), "assembly instance").c_str(),
+        pretty_time(stopwatch.measure().get_seconds()).c_str());
+}
+
+EmbreeInstanceScene::~EmbreeInstanceScene()
+{
+    rtcReleaseScene(m_scene);
+}
+
+void EmbreeInstanceScene::intersect(
+    ShadingPoint&                       shading_point,
+    const ShadingPoint*                 parent_shading_point) const
+{
+    RTCIntersectContext context;
+    rtcInitIntersectContext(&context);
+
+    const ShadingRay& ray = shading_point.get_ray();
+
+    RTCRayHit rayhit;
+    shading_ray_to_embree_ray(ray, get_world_space_origin(ray, parent_shading_point), rayhit.ray);
+
+    rayhit.hit.geomID = RTC_INVALID_GEOMETRY_ID;
+    rayhit.hit.instID[0] = RTC_INVALID_GEOMETRY_ID;
+
+    rtcIntersect1(m_scene, &context, &rayhit);
+
+    if (rayhit.hit.geomID != RTC_INVALID_GEOMETRY_ID)
+    {
+        assert(rayhit.hit.instID[0] < m_instances.size());
+
+        const Instance& instance = m_instances[rayhit.hit.instID[0]];
+
+        shading_point.m_assembly_instance = instance.m_assembly_instance;
+        shading_point.m_assembly_instance_transform = instance.m_transform_sequence->get_earliest_transform();
+        shading_point.m_assembly_instance_transform_seq = instance.m_transform_sequence;
+
+        // Embree does not normalize the direction of instanced rays: distances along
+        // the world space ray are preserved in assembly instance space.
+        instance.m_scene->record_hit(rayhit, shading_point);
+    }
+}
+
+bool EmbreeInstanceScene::occlude(
+    const ShadingRay&                   shading_ray,
+    const ShadingPoint*                 parent_shading_point) const
+{
+    RTCIntersectContext context;
+    rtcInitIntersectContext(&context);
+
+    RTCRay ray;
+    shading_ray_to_embree_ray(shading_ray, get_world_space_origin(shading_ray, parent_shading_point), ray);
+
+    rtcOccluded1(
+        m_scene,
+        &context,
+        &ray);
+
+    return ray.tfar < signed_min<float>();
+}
+
+void EmbreeInstanceScene::occlude(
+    const ShadingRay*                   shading_rays,
+    const size_t                        ray_count,
+    bool*                               occluded,
+    const ShadingPoint*                 parent_shading_point) const
+{
+    RTCIntersectContext context;
+    rtcInitIntersectContext(&context);
+
+    // Rays leaving the same shading point are coherent.
+    if (parent_shading_point)
+        context.flags = RTC_INTERSECT_CONTEXT_FLAG_COHERENT;
+
+    RTCRay rays[EmbreeRayStreamSize];
+
+    for (size_t begin = 0; begin < ray_count; begin += EmbreeRayStreamSize)
+    {
+        const size_t count = std::min(ray_count - begin, EmbreeRayStreamSize);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const ShadingRay& shading_ray = shading_rays[begin + i];
+            shading_ray_to_embree_ray(shading_ray, get_world_space_origin(shading_ray, parent_shading_point), rays[i]);
+        }
+
+        rtcOccluded1M(
+            m_scene,
+            &context,
+            rays,
+            static_cast<unsigned int>(count),
+            sizeof(RTCRay));
+
+        for (size_t i = 0; i < count; ++i)
+            occluded[begin + i] = rays[i].tfar < signed_min<float>();
+    }
+}
+
+
+//
+// EmbreeSceneFactory class implementation.
+//
+
 EmbreeSceneFactory::EmbreeSceneFactory(const EmbreeScene::Arguments& arguments)
   : m_arguments(arguments)
 {
@@ -50,8 +50,10 @@
 
 // Forward declarations.
 namespace renderer { class Assembly; }
+namespace renderer { class AssemblyInstance; }
 namespace renderer { class ShadingPoint; }
 namespace renderer { class ShadingRay; }
+namespace renderer { class TransformSequence; }
 
 namespace renderer
 {
@@ -62,6 +64,10 @@ typedef std::vector<std::unique_ptr<EmbreeGeometryData>>  EmbreeGeometryDataCont
 
 class EmbreeScene;
 
+//
+// Reference to the Embree device shared by all scenes of the process.
+//
+
 class EmbreeDevice
   : public foundation::NonCopyable
 {
@@ -70,6 +76,7 @@ class EmbreeDevice
     ~EmbreeDevice();
 
   private:
+    friend class EmbreeInstanceScene;
     friend class EmbreeScene;
 
     RTCDevice m_device;
@@ -100,9 +107,75 @@ class EmbreeScene
     bool occlude(const ShadingRay& shading_ray) const;
 
   private:
+    friend class EmbreeInstanceScene;
+
     RTCDevice                   m_device;
     RTCScene                    m_scene;
     EmbreeGeometryDataContainer m_geometry_container;
+
+    void attach_curve_geometry(
+        std::unique_ptr<EmbreeGeometryData> geometry_data,
+        const RTCBuildQuality               build_quality);
+
+    // Fill the shading point from a hit found in this scene, in assembly space.
+    void record_hit(
+        const RTCRayHit&                    rayhit,
+        ShadingPoint&                       shading_point) const;
+};
+
+
+//
+// Two-level Embree scene instancing the Embree scenes of static assembly instances,
+// so that rays traverse assembly instances and their geometry without leaving Embree.
+//
+
+class EmbreeInstanceScene
+  : public foundation::NonCopyable
+{
+  public:
+    struct Instance
+    {
+        const EmbreeScene*          m_scene;                // owned by the assembly tree
+        const AssemblyInstance*     m_assembly_instance;
+        const TransformSequence*    m_transform_sequence;   // static, owned by the assembly instance or by the assembly tree
+
+        Instance(
+            const EmbreeScene*          scene,
+            const AssemblyInstance*     assembly_instance,
+            const TransformSequence*    transform_sequence)
+          : m_scene(scene)
+          , m_assembly_instance(assembly_instance)
+          , m_transform_sequence(transform_sequence)
+        {
+        }
+    };
+
+    typedef std::vector<Instance> InstanceVector;
+
+    EmbreeInstanceScene(
+        const EmbreeDevice&         device,
+        const InstanceVector&       instances);
+
+    ~EmbreeInstanceScene();
+
+    // Rays are given in world space.
+    void intersect(
+        ShadingPoint&               shading_point,
+        const ShadingPoint*         parent_shading_point) const;
+    bool occlude(
+        const ShadingRay&           shading_ray,
+        const ShadingPoint*         parent_shading_point) const;
+
+    // Trace a stream of probe rays with rtcOccluded1M(). occluded[i] is set to the result of the i'th ray.
+    void occlude(
+        const ShadingRay*           shading_rays,
+        const size_t                ray_count,
+        bool*                       occluded,
+        const ShadingPoint*         parent_shading_point) const;
+
+  private:
+    RTCScene                        m_scene;
+    InstanceVector                  m_instances;
 };
 
 typedef std::map<
@@ -0,0 +1,134 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "geometrycache.h"
+
+// Standard headers.
+#include <cassert>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// GeometryCache class implementation.
+//
+
+GeometryCache::GeometryCache(const size_t memory_limit)
+  : m_memory_limit(memory_limit)
+  , m_memory_size(0)
+  , m_hit_count(0)
+  , m_miss_count(0)
+{
+}
+
+void GeometryCache::clear()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    m_index.clear();
+    m_queue.clear();
+    m_memory_size = 0;
+}
+
+size_t GeometryCache::get_patch_count() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_queue.size();
+}
+
+size_t GeometryCache::get_memory_size() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_memory_size;
+}
+
+std::uint64_t GeometryCache::get_hit_count() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_hit_count;
+}
+
+std::uint64_t GeometryCache::get_miss_count() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_miss_count;
+}
+
+GeometryCache::PatchPtr GeometryCache::find(const std::uint64_t key)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    const Index::iterator i = m_index.find(key);
+
+    if (i == m_index.end())
+    {
+        ++m_miss_count;
+        return PatchPtr();
+    }
+
+    ++m_hit_count;
+
+    // Move the patch to the front of the queue.
+    m_queue.splice(m_queue.begin(), m_queue, i->second);
+
+    return i->second->second;
+}
+
+GeometryCache::PatchPtr GeometryCache::insert(
+    const std::uint64_t         key,
+    const PatchPtr&             patch)
+{
+    assert(patch);
+
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    const Index::iterator i = m_index.find(key);
+
+    if (i != m_index.end())
+        return i->second->second;
+
+    m_queue.push_front(Line(key, patch));
+    m_index[key] = m_queue.begin();
+    m_memory_size += patch->get_memory_size();
+
+    // Evict least recently used patches, but always keep the one just inserted.
+    while (m_memory_size > m_memory_limit && m_queue.size() > 1)
+    {
+        const Line& lru = m_queue.back();
+        m_memory_size -= lru.second->get_memory_size();
+        m_index.erase(lru.first);
+        m_queue.pop_back();
+    }
+
+    return patch;
+}
+
+}   // namespace renderer
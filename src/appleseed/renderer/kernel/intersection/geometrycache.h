@@ -0,0 +1,126 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/intersection/displacementpatch.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/thread.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+namespace renderer
+{
+
+//
+// A thread-safe, memory-bounded LRU cache of tessellated displacement patches.
+//
+// Patches are tessellated outside of the cache lock, so that threads reaching
+// different patches tessellate them concurrently. Patches evicted while a thread
+// is still intersecting them stay alive until that thread releases them.
+//
+
+class GeometryCache
+  : public foundation::NonCopyable
+{
+  public:
+    typedef std::shared_ptr<const DisplacementPatch> PatchPtr;
+
+    // Constructor. memory_limit is in bytes.
+    explicit GeometryCache(const size_t memory_limit);
+
+    // Fetch a patch, calling tessellate() to create it if it isn't cached. Thread-safe.
+    template <typename TessellateFunc>
+    PatchPtr get(
+        const std::uint64_t     key,
+        const TessellateFunc&   tessellate);
+
+    // Remove all patches from the cache.
+    void clear();
+
+    // Return the number of cached patches.
+    size_t get_patch_count() const;
+
+    // Return the size (in bytes) of the cached patches.
+    size_t get_memory_size() const;
+
+    std::uint64_t get_hit_count() const;
+    std::uint64_t get_miss_count() const;
+
+  private:
+    typedef std::pair<std::uint64_t, PatchPtr> Line;
+    typedef std::list<Line> Queue;
+    typedef std::unordered_map<std::uint64_t, Queue::iterator> Index;
+
+    const size_t                m_memory_limit;
+    mutable boost::mutex        m_mutex;
+    Queue                       m_queue;            // from most to least recently used
+    Index                       m_index;
+    size_t                      m_memory_size;
+    std::uint64_t               m_hit_count;
+    std::uint64_t               m_miss_count;
+
+    // Return a cached patch, or nullptr if it isn't cached.
+    PatchPtr find(const std::uint64_t key);
+
+    // Insert a patch and evict least recently used patches until the cache fits
+    // in its memory limit. If another thread inserted a patch with the same key
+    // in the meantime, that patch is kept and returned instead.
+    PatchPtr insert(
+        const std::uint64_t     key,
+        const PatchPtr&         patch);
+};
+
+
+//
+// GeometryCache class implementation.
+//
+
+template <typename TessellateFunc>
+GeometryCache::PatchPtr GeometryCache::get(
+    const std::uint64_t         key,
+    const TessellateFunc&       tessellate)
+{
+    PatchPtr patch = find(key);
+
+    if (!patch)
+        patch = insert(key, tessellate());
+
+    return patch;
+}
+
+}   // namespace renderer
@@ -41,10 +41,12 @@
 #include "renderer/modeling/scene/objectinstance.h"
 
 // appleseed.foundation headers.
+#include "foundation/memory/memory.h"
 #include "foundation/utility/foreach.h"
 
 // Standard headers.
 #include <cassert>
+#include <cmath>
 #include <memory>
 
 using namespace foundation;
@@ -54,13 +56,6 @@ namespace renderer
 
 namespace
 {
-    size_t get_triangle_count(Object& object)
-    {
-        const MeshObject& mesh = static_cast<const MeshObject&>(object);
-        const StaticTriangleTess& tess = mesh.get_static_triangle_tess();
-        return tess.m_primitives.size();
-    }
-
     void copy_uv_coordinates(const StaticTriangleTess& tess, std::vector<Vector2f>& uv)
     {
         for (const_each<StaticTriangleTess::PrimitiveArray> i = tess.m_primitives; i; ++i)
@@ -84,34 +79,146 @@ namespace
         }
     }
 
-    void copy_uv_coordinates(Object& object, std::vector<Vector2f>& uv)
+    bool is_finite(const Vector2f& v)
+    {
+        return std::isfinite(v[0]) && std::isfinite(v[1]);
+    }
+}
+
+//
+// IntersectionFilter::AlphaMask class implementation.
+//
+
+void IntersectionFilter::AlphaMask::build_hierarchy()
+{
+    m_any_opaque.clear();
+    m_any_transparent.clear();
+
+    size_t width = m_bitmask.get_width();
+    size_t height = m_bitmask.get_height();
+
+    while (width > 1 || height > 1)
+    {
+        const size_t parent_width = (width + 1) / 2;
+        const size_t parent_height = (height + 1) / 2;
+
+        std::unique_ptr<BitMask2> any_opaque(new BitMask2(parent_width, parent_height));
+        std::unique_ptr<BitMask2> any_transparent(new BitMask2(parent_width, parent_height));
+        any_opaque->clear();
+        any_transparent->clear();
+
+        for (size_t y = 0; y < height; ++y)
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                bool opaque, transparent;
+
+                if (m_any_opaque.empty())
+                {
+                    opaque = m_bitmask.is_set(x, y);
+                    transparent = !opaque;
+                }
+                else
+                {
+                    opaque = m_any_opaque.back()->is_set(x, y);
+                    transparent = m_any_transparent.back()->is_set(x, y);
+                }
+
+                if (opaque)
+                    any_opaque->set(x / 2, y / 2);
+
+                if (transparent)
+                    any_transparent->set(x / 2, y / 2);
+            }
+        }
+
+        m_any_opaque.push_back(std::move(any_opaque));
+        m_any_transparent.push_back(std::move(any_transparent));
+
+        width = parent_width;
+        height = parent_height;
+    }
+}
+
+IntersectionFilter::AlphaMask::Coverage IntersectionFilter::AlphaMask::classify(const AABB2f& uv_bbox) const
+{
+    // Compute the range of texels that is_opaque() can fetch.
+    size_t x0 = texel_x(uv_bbox.min[0]);
+    size_t y0 = texel_y(uv_bbox.min[1]);
+    size_t x1 = texel_x(uv_bbox.max[0]);
+    size_t y1 = texel_y(uv_bbox.max[1]);
+
+    // Move up the hierarchy until only a handful of texels need to be visited.
+    // Coarser texels cover larger footprints which keeps the classification conservative.
+    size_t level = 0;
+    while (level < m_any_opaque.size() && (x1 - x0 > 3 || y1 - y0 > 3))
+    {
+        x0 /= 2;
+        y0 /= 2;
+        x1 /= 2;
+        y1 /= 2;
+        ++level;
+    }
+
+    bool any_opaque = false;
+    bool any_transparent = false;
+
+    for (size_t y = y0; y <= y1; ++y)
+    {
+        for (size_t x = x0; x <= x1; ++x)
+        {
+            if (level == 0)
+            {
+                if (m_bitmask.is_set(x, y))
+                    any_opaque = true;
+                else any_transparent = true;
+            }
+            else
+            {
+                any_opaque |= m_any_opaque[level - 1]->is_set(x, y);
+                any_transparent |= m_any_transparent[level - 1]->is_set(x, y);
+            }
+
+            if (any_opaque && any_transparent)
+                return Mixed;
+        }
+    }
+
+    return any_opaque ? Opaque : Transparent;
+}
+
+size_t IntersectionFilter::AlphaMask::get_memory_size() const
+{
+    size_t size = m_bitmask.get_memory_size();
+
+    for (size_t i = 0; i < m_any_opaque.size(); ++i)
     {
-        const MeshObject& mesh = static_cast<const MeshObject&>(object);
-        const StaticTriangleTess& tess = mesh.get_static_triangle_tess();
-        copy_uv_coordinates(tess, uv);
+        size += m_any_opaque[i]->get_memory_size();
+        size += m_any_transparent[i]->get_memory_size();
     }
+
+    return size;
 }
 
+
+//
+// IntersectionFilter class implementation.
+//
+
 IntersectionFilter::IntersectionFilter(
     Object&                 object,
     const MaterialArray&    materials,
     TextureCache&           texture_cache)
-  : m_obj_alpha_mask(nullptr)
-  , m_obj_alpha_map_signature(0)
+  : m_obj_alpha_map_signature(0)
+  , m_obj_alpha_mask(nullptr)
+  , m_partially_transparent_triangle_count(0)
 {
     // Initialize the material -> alpha mask mapping.
     m_material_alpha_map_signatures.assign(materials.size(), 0);
     m_material_alpha_masks.assign(materials.size(), nullptr);
 
-    // Create alpha masks.
+    // Create alpha masks and classify triangles.
     update(object, materials, texture_cache);
-
-    if (has_alpha_masks())
-    {
-        // Make a local copy of the object's UV coordinates.
-        m_uv.reserve(get_triangle_count(object) * 3);
-        copy_uv_coordinates(object, m_uv);
-    }
 }
 
 IntersectionFilter::~IntersectionFilter()
@@ -171,6 +278,9 @@ void IntersectionFilter::do_update(
         return;
     }
 
+    // Build the hierarchy used to classify triangles.
+    alpha_mask->build_hierarchy();
+
     // Store the alpha mask.
     delete mask;
     mask = alpha_mask.release();
@@ -200,6 +310,80 @@ void IntersectionFilter::update(
         else
             delete_and_clear(m_material_alpha_masks[i]);
     }
+
+    update_triangle_states(object);
+}
+
+void IntersectionFilter::update_triangle_states(const Object& object)
+{
+    const MeshObject& mesh = static_cast<const MeshObject&>(object);
+    const StaticTriangleTess& tess = mesh.get_static_triangle_tess();
+    const size_t triangle_count = tess.m_primitives.size();
+
+    m_partially_transparent_triangle_count = 0;
+
+    if (!has_alpha_masks())
+    {
+        m_triangle_states.assign(triangle_count, AcceptAlways);
+        clear_release_memory(m_uv);
+        return;
+    }
+
+    // Make a local copy of the object's UV coordinates.
+    if (m_uv.empty())
+    {
+        m_uv.reserve(triangle_count * 3);
+        copy_uv_coordinates(tess, m_uv);
+    }
+
+    m_triangle_states.resize(triangle_count);
+
+    for (size_t i = 0; i < triangle_count; ++i)
+    {
+        const Vector2f& uv0 = m_uv[i * 3 + 0];
+        const Vector2f& uv1 = m_uv[i * 3 + 1];
+        const Vector2f& uv2 = m_uv[i * 3 + 2];
+
+        if (!is_finite(uv0) || !is_finite(uv1) || !is_finite(uv2))
+        {
+            m_triangle_states[i] = LookupMasks;
+            ++m_partially_transparent_triangle_count;
+            continue;
+        }
+
+        // Slightly enlarge the UV bounding box of the triangle to account for
+        // barycentric coordinates that fall marginally outside the triangle.
+        AABB2f uv_bbox;
+        uv_bbox.invalidate();
+        uv_bbox.insert(uv0);
+        uv_bbox.insert(uv1);
+        uv_bbox.insert(uv2);
+        uv_bbox.grow(Vector2f(1.0e-4f));
+
+        // Use the same primitive attribute index as the one stored in triangle keys.
+        const size_t pa = static_cast<std::uint16_t>(tess.m_primitives[i].m_pa);
+        const AlphaMask* mtl_alpha_mask =
+            pa < m_material_alpha_masks.size() ? m_material_alpha_masks[pa] : nullptr;
+
+        const AlphaMask::Coverage obj_coverage =
+            m_obj_alpha_mask ? m_obj_alpha_mask->classify(uv_bbox) : AlphaMask::Opaque;
+        const AlphaMask::Coverage mtl_coverage =
+            mtl_alpha_mask ? mtl_alpha_mask->classify(uv_bbox) : AlphaMask::Opaque;
+
+        if (obj_coverage == AlphaMask::Transparent || mtl_coverage == AlphaMask::Transparent)
+            m_triangle_states[i] = RejectAlways;
+        else if (obj_coverage == AlphaMask::Opaque && mtl_coverage == AlphaMask::Opaque)
+            m_triangle_states[i] = AcceptAlways;
+        else
+        {
+            m_triangle_states[i] = LookupMasks;
+            ++m_partially_transparent_triangle_count;
+        }
+    }
+
+    // UV coordinates are only needed by triangles that require alpha mask lookups.
+    if (m_partially_transparent_triangle_count == 0)
+        clear_release_memory(m_uv);
 }
 
 bool IntersectionFilter::has_alpha_masks() const
@@ -234,7 +418,14 @@ size_t IntersectionFilter::get_masks_memory_size() const
 
 size_t IntersectionFilter::get_uv_memory_size() const
 {
-    return m_uv.capacity() * sizeof(Vector2f);
+    return
+        m_uv.capacity() * sizeof(Vector2f) +
+        m_triangle_states.capacity() * sizeof(std::uint8_t);
+}
+
+size_t IntersectionFilter::get_partially_transparent_triangle_count() const
+{
+    return m_partially_transparent_triangle_count;
 }
 
 IntersectionFilter::AlphaMask* IntersectionFilter::create_alpha_mask(
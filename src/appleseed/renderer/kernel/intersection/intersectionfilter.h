@@ -34,6 +34,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 #include "foundation/utility/bitmask.h"
@@ -41,6 +42,7 @@
 // Standard headers.
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 // Forward declarations.
@@ -73,6 +75,9 @@ class IntersectionFilter
     size_t get_masks_memory_size() const;
     size_t get_uv_memory_size() const;
 
+    // Return the number of triangles that require an alpha mask lookup.
+    size_t get_partially_transparent_triangle_count() const;
+
     bool accept(
         const TriangleKey&      triangle_key,
         const double            u,
@@ -83,6 +88,13 @@ class IntersectionFilter
       : public foundation::NonCopyable
     {
       public:
+        enum Coverage
+        {
+            Opaque,
+            Transparent,
+            Mixed
+        };
+
         AlphaMask(
             const size_t        width,
             const size_t        height)
@@ -100,15 +112,12 @@ class IntersectionFilter
             m_bitmask.set(x, y, opaque);
         }
 
+        // Build the mip hierarchy used by classify(), once all texels are set.
+        void build_hierarchy();
+
         bool is_opaque(const foundation::Vector2f& uv) const
         {
-            const float fx = foundation::clamp(uv[0] * m_bitmask.get_width(), 0.0f, m_max_x);
-            const float fy = foundation::clamp(uv[1] * m_bitmask.get_height(), 0.0f, m_max_y);
-
-            const size_t ix = foundation::truncate<size_t>(fx);
-            const size_t iy = foundation::truncate<size_t>(fy);
-
-            return m_bitmask.is_set(ix, iy);
+            return m_bitmask.is_set(texel_x(uv[0]), texel_y(uv[1]));
         }
 
         bool is_transparent(const foundation::Vector2f& uv) const
@@ -116,15 +125,39 @@ class IntersectionFilter
             return !is_opaque(uv);
         }
 
-        size_t get_memory_size() const
-        {
-            return m_bitmask.get_memory_size();
-        }
+        // Conservatively classify the texels looked up by UV coordinates within a given bounding box.
+        Coverage classify(const foundation::AABB2f& uv_bbox) const;
+
+        size_t get_memory_size() const;
 
       private:
+        typedef std::vector<std::unique_ptr<foundation::BitMask2>> BitMaskVector;
+
         const float             m_max_x;
         const float             m_max_y;
         foundation::BitMask2    m_bitmask;
+
+        // Mip levels 1 and up: whether any texel of each footprint is opaque or transparent.
+        BitMaskVector           m_any_opaque;
+        BitMaskVector           m_any_transparent;
+
+        size_t texel_x(const float u) const
+        {
+            return foundation::truncate<size_t>(foundation::clamp(u * m_bitmask.get_width(), 0.0f, m_max_x));
+        }
+
+        size_t texel_y(const float v) const
+        {
+            return foundation::truncate<size_t>(foundation::clamp(v * m_bitmask.get_height(), 0.0f, m_max_y));
+        }
+    };
+
+    // Outcome of the alpha test for all points of a triangle, when known in advance.
+    enum TriangleState
+    {
+        AcceptAlways,
+        RejectAlways,
+        LookupMasks
     };
 
     std::uint64_t                       m_obj_alpha_map_signature;
@@ -132,6 +165,10 @@ class IntersectionFilter
     std::vector<std::uint64_t>          m_material_alpha_map_signatures;
     std::vector<AlphaMask*>             m_material_alpha_masks;
     std::vector<foundation::Vector2f>   m_uv;
+    std::vector<std::uint8_t>           m_triangle_states;     // one TriangleState per triangle
+    size_t                              m_partially_transparent_triangle_count;
+
+    void update_triangle_states(const Object& object);
 
     template <typename EntityType>
     static void do_update(
@@ -165,12 +202,20 @@ inline bool IntersectionFilter::accept(
     if (u != u || v != v)
         return true;
 
+    const size_t triangle_index = triangle_key.get_triangle_index();
+
+    // Most triangles are either entirely opaque or entirely transparent.
+    switch (m_triangle_states[triangle_index])
+    {
+      case AcceptAlways: return true;
+      case RejectAlways: return false;
+      default: break;
+    }
+
     const AlphaMask* mtl_alpha_mask = m_material_alpha_masks[triangle_key.get_triangle_pa()];
 
     if (m_obj_alpha_mask || mtl_alpha_mask)
     {
-        const size_t triangle_index = triangle_key.get_triangle_index();
-
         const float fu = static_cast<float>(u);
         const float fv = static_cast<float>(v);
 
@@ -35,6 +35,7 @@
 // appleseed.foundation headers.
 #include "foundation/math/beziercurve.h"
 #include "foundation/math/intersection/raytrianglemt.h"
+#include "foundation/math/intersection/raytrianglewatertight.h"
 #include "foundation/math/matrix.h"
 
 // Standard headers.
@@ -56,6 +57,12 @@ const double AssemblyTreeInteriorNodeTraversalCost = 1.0;
 // Relative cost of intersecting an assembly.
 const double AssemblyTreeTriangleIntersectionCost = 10.0;
 
+// Maximum SAH cost of a refitted assembly tree, relative to its cost when it was built.
+const double AssemblyTreeMaxRefitCostRatio = 1.5;
+
+// Maximum number of motion segments used to bound a moving assembly instance (power of two).
+const size_t AssemblyTreeMaxMotionSegmentCount = 16;
+
 
 //
 // Triangle tree settings.
@@ -64,6 +71,13 @@ const double AssemblyTreeTriangleIntersectionCost = 10.0;
 // Triangle format used for storage.
 typedef foundation::TriangleMT<GScalar> GTriangleType;
 
+// Triangle format used for storage and intersection in watertight mode.
+// Both formats occupy the same space so that leaf layouts don't depend on the mode.
+typedef foundation::TriangleWatertight<GScalar> GWatertightTriangleType;
+static_assert(
+    sizeof(GWatertightTriangleType) == sizeof(GTriangleType),
+    "Watertight and Moller-Trumbore triangles must have the same size");
+
 // Triangle format used for intersection.
 typedef foundation::TriangleMT<double> TriangleType;
 typedef foundation::TriangleMTSupportPlane<double> TriangleSupportPlaneType;
@@ -71,12 +85,19 @@ typedef foundation::TriangleMTSupportPlane<double> TriangleSupportPlaneType;
 // Maximum number of triangles per leaf.
 const size_t TriangleTreeDefaultMaxLeafSize = 2;
 
+// Maximum number of triangles per leaf when leaves are compressed.
+const size_t TriangleTreeDefaultCompressedMaxLeafSize = 6;
+
 // Relative cost of traversing an interior node.
 const GScalar TriangleTreeDefaultInteriorNodeTraversalCost(1.0);
 
 // Relative cost of intersecting a triangle.
 const GScalar TriangleTreeDefaultTriangleIntersectionCost(1.0);
 
+// Relative amount by which node bounding boxes are grown in watertight mode, so that
+// rounding errors in ray-box tests can't cull rays that hit the triangles they enclose.
+const double TriangleTreeWatertightBBoxGrowEps = 1.0e-9;
+
 // Number of bins used during SBVH construction.
 const size_t TriangleTreeDefaultBinCount = 256;
 
@@ -94,6 +115,9 @@ const size_t TriangleTreeAccessCacheWays = 2;
 // Size of the stack (in number of nodes) used during traversal.
 const size_t TriangleTreeStackSize = 64;
 
+// Number of children of the wide nodes used to traverse triangle trees without motion (4 or 8).
+const size_t TriangleTreeWideNodeWidth = 4;
+
 
 //
 // Curve tree settings.
@@ -119,6 +143,13 @@ const GScalar CurveTreeDefaultInteriorNodeTraversalCost(1.0);
 // Relative cost of intersecting a curve.
 const GScalar CurveTreeDefaultCurveIntersectionCost(1.0);
 
+// Maximum number of times a curve is recursively split in halves to tighten its bounds.
+const size_t CurveTreeDefaultMaxSplitDepth = 2;
+
+// A curve is split if the bounding boxes of its halves have a total surface area
+// smaller than this fraction of the surface area of its own bounding box.
+const GScalar CurveTreeSplitAreaThreshold(0.7);
+
 // Size of the curve tree access cache.
 const size_t CurveTreeAccessCacheLines = 128;
 const size_t CurveTreeAccessCacheWays = 2;
@@ -137,12 +168,18 @@ const size_t CurveTreeStackSize = 64;
 const size_t EmbreeSceneAccessCacheLines = 128;
 const size_t EmbreeSceneAccessCacheWays = 2;
 
+// Maximum number of probe rays handed to Embree at once by a ray stream query.
+const size_t EmbreeRayStreamSize = 16;
+
 #endif
 
 //
 // Miscellaneous settings.
 //
 
+// Number of probe rays traversing the assembly and triangle trees together as a packet (multiple of 4).
+const size_t ProbeRayPacketSize = 4;
+
 // If defined, an adaptive procedure is used to offset intersection points.
 // If left undefined, a fixed, constant-time procedure is used. The adaptive
 // procedure handles degenerate cases better but is slightly slower. It must
@@ -42,11 +42,13 @@
 #include "foundation/string/string.h"
 #include "foundation/utility/cache.h"
 #include "foundation/utility/casts.h"
+#include "foundation/utility/hardwarecounters.h"
 #include "foundation/utility/lazy.h"
 #include "foundation/utility/poison.h"
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
@@ -132,6 +134,8 @@ bool Intersector::trace(
     assert(parent_shading_point == nullptr || parent_shading_point != &shading_point);
     assert(parent_shading_point == nullptr || parent_shading_point->is_valid());
 
+    APPLESEED_HARDWARE_COUNTERS_SCOPE("tree traversal");
+
     // Update ray casting statistics.
     ++m_shading_ray_count;
 
@@ -152,87 +156,322 @@ bool Intersector::trace(
     // Retrieve assembly tree.
     const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
 
-    // Check the intersection between the ray and the assembly tree.
-    AssemblyTreeIntersector intersector;
+#ifdef APPLESEED_WITH_EMBREE
+    if (assembly_tree.m_embree_instance_scene)
+    {
+        // Traverse assembly instances and their geometry in a single Embree scene.
+        assembly_tree.m_embree_instance_scene->intersect(shading_point, parent_shading_point);
+    }
+    else
+#endif
+    {
+        // Check the intersection between the ray and the assembly tree.
+        AssemblyTreeIntersector intersector;
+        AssemblyLeafVisitor visitor(
+            shading_point,
+            assembly_tree,
+            m_triangle_tree_cache,
+            m_curve_tree_cache,
+            m_transform_cache,
+#ifdef APPLESEED_WITH_EMBREE
+            m_embree_scene_cache,
+#endif
+            parent_shading_point
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_triangle_tree_traversal_stats
+#endif
+            );
+        if (assembly_tree.has_motion_bboxes())
+        {
+            intersector.intersect_motion(
+                assembly_tree,
+                shading_point.m_ray,
+                ray_info,
+                shading_point.m_ray.m_time.m_normalized,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , m_assembly_tree_traversal_stats
+#endif
+                );
+        }
+        else
+        {
+            intersector.intersect_no_motion(
+                assembly_tree,
+                shading_point.m_ray,
+                ray_info,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , m_assembly_tree_traversal_stats
+#endif
+                );
+        }
+    }
+
+    // Detect and report self-intersections.
+    if (m_report_self_intersections)
+        report_self_intersection(shading_point, parent_shading_point);
+
+    const ShadingRay::Medium* medium = ray.get_current_medium();
+    if (!shading_point.hit_surface() && medium != nullptr && medium->get_volume() != nullptr)
+        shading_point.m_primitive_type = ShadingPoint::PrimitiveVolume;
+
+    return shading_point.hit_surface();
+}
+
+bool Intersector::trace_object_instance(
+    const ShadingRay&                   ray,
+    const ShadingPoint&                 reference_point,
+    ShadingPoint&                       shading_point,
+    const ShadingPoint*                 parent_shading_point) const
+{
+    assert(is_normalized(ray.m_dir));
+    assert(reference_point.hit_surface());
+    assert(shading_point.m_scene == nullptr);
+    assert(!shading_point.is_valid());
+    assert(parent_shading_point == nullptr || parent_shading_point != &shading_point);
+    assert(parent_shading_point == nullptr || parent_shading_point->is_valid());
+
+    // Retrieve assembly tree.
+    const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
+
+#ifdef APPLESEED_WITH_EMBREE
+    // Embree scenes cannot be restricted to a single object instance.
+    if (assembly_tree.use_embree())
+        return trace(ray, shading_point, parent_shading_point);
+#endif
+
+    APPLESEED_HARDWARE_COUNTERS_SCOPE("tree traversal");
+
+    // Update ray casting statistics.
+    ++m_shading_ray_count;
+
+    // Initialize the shading point.
+    shading_point.m_texture_cache = &m_texture_cache;
+    shading_point.m_scene = &m_trace_context.get_scene();
+    shading_point.m_ray = ray;
+
+    // Refine and offset the previous intersection point.
+    if (parent_shading_point &&
+        parent_shading_point->hit_surface() &&
+        !(parent_shading_point->m_members & ShadingPoint::HasRefinedPoints))
+        parent_shading_point->refine_and_offset();
+
+    // Check the intersection between the ray and the object instance, bypassing the assembly tree.
     AssemblyLeafVisitor visitor(
         shading_point,
         assembly_tree,
         m_triangle_tree_cache,
         m_curve_tree_cache,
+        m_transform_cache,
 #ifdef APPLESEED_WITH_EMBREE
         m_embree_scene_cache,
 #endif
         parent_shading_point
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , m_triangle_tree_traversal_stats
+        , m_curve_tree_traversal_stats
 #endif
         );
-    intersector.intersect_no_motion(
-        assembly_tree,
-        shading_point.m_ray,
-        ray_info,
-        visitor
-#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-        , m_assembly_tree_traversal_stats
-#endif
-        );
+    visitor.visit_object_instance(
+        reference_point.get_assembly_instance(),
+        reference_point.get_assembly().get_uid(),
+        reference_point.get_assembly_instance_transform(),
+        reference_point.m_assembly_instance_transform_seq,
+        reference_point.get_object_instance_index());
 
     // Detect and report self-intersections.
     if (m_report_self_intersections)
         report_self_intersection(shading_point, parent_shading_point);
 
-    const ShadingRay::Medium* medium = ray.get_current_medium();
-    if (!shading_point.hit_surface() && medium != nullptr && medium->get_volume() != nullptr)
-        shading_point.m_primitive_type = ShadingPoint::PrimitiveVolume;
-
     return shading_point.hit_surface();
 }
 
 bool Intersector::trace_probe(
     const ShadingRay&                   ray,
-    const ShadingPoint*                 parent_shading_point) const
+    const ShadingPoint*                 parent_shading_point,
+    const size_t                        occluder_key) const
 {
     assert(is_normalized(ray.m_dir));
     assert(parent_shading_point == 0 || parent_shading_point->hit_surface());
 
+    APPLESEED_HARDWARE_COUNTERS_SCOPE("tree traversal");
+
     // Update ray casting statistics.
     ++m_probe_ray_count;
 
-    // Compute ray info once for the entire traversal.
-    const ShadingRay::RayInfoType ray_info(ray);
-
     // Refine and offset the previous intersection point.
     if (parent_shading_point &&
         parent_shading_point->hit_surface() &&
         !(parent_shading_point->m_members & ShadingPoint::HasRefinedPoints))
         parent_shading_point->refine_and_offset();
 
+    if (occluder_key == OccluderCache::NoKey)
+        return probe_assembly_tree(ray, parent_shading_point);
+
+    return probe_assembly_tree(ray, parent_shading_point, &m_occluder_cache.get(occluder_key));
+}
+
+void Intersector::trace_probe_stream(
+    const ShadingRay*                   rays,
+    const size_t                        ray_count,
+    bool*                               occluded,
+    const ShadingPoint*                 parent_shading_point) const
+{
+    assert(parent_shading_point == 0 || parent_shading_point->hit_surface());
+
+    APPLESEED_HARDWARE_COUNTERS_SCOPE("tree traversal");
+
+    // Update ray casting statistics.
+    m_probe_ray_count += ray_count;
+
+    // Refine and offset the previous intersection point once for the entire stream.
+    if (parent_shading_point &&
+        parent_shading_point->hit_surface() &&
+        !(parent_shading_point->m_members & ShadingPoint::HasRefinedPoints))
+        parent_shading_point->refine_and_offset();
+
+    // Retrieve assembly tree.
+    const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
+
+#ifdef APPLESEED_WITH_EMBREE
+    // Hand the entire stream over to Embree.
+    if (assembly_tree.m_embree_instance_scene)
+    {
+        assembly_tree.m_embree_instance_scene->occlude(rays, ray_count, occluded, parent_shading_point);
+        return;
+    }
+#endif
+
+    // Packets don't support assembly trees with motion, trace the rays one at a time.
+    if (assembly_tree.has_motion_bboxes())
+    {
+        for (size_t i = 0; i < ray_count; ++i)
+        {
+            assert(is_normalized(rays[i].m_dir));
+            occluded[i] = probe_assembly_tree(rays[i], parent_shading_point);
+        }
+
+        return;
+    }
+
+    // Trace the rays in packets.
+    AssemblyTreePacketProbeIntersector intersector;
+    for (size_t begin = 0; begin < ray_count; begin += ProbeRayPacketSize)
+    {
+        const size_t count = std::min(ray_count - begin, ProbeRayPacketSize);
+
+        // Compute ray infos once for the entire traversal.
+        ShadingRay::RayInfoType ray_infos[ProbeRayPacketSize];
+        AssemblyLeafPacketProbeVisitor::RayPacketType packet;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const ShadingRay& ray = rays[begin + i];
+            assert(is_normalized(ray.m_dir));
+            ray_infos[i] = ShadingRay::RayInfoType(ray);
+            packet.set(i, ray, ray_infos[i]);
+        }
+
+        // Check the intersection between the rays and the assembly tree.
+        AssemblyLeafPacketProbeVisitor visitor(
+            assembly_tree,
+            m_triangle_tree_cache,
+            m_curve_tree_cache,
+            m_transform_cache,
+#ifdef APPLESEED_WITH_EMBREE
+            m_embree_scene_cache,
+#endif
+            parent_shading_point
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_triangle_tree_traversal_stats
+            , m_curve_tree_traversal_stats
+#endif
+            );
+        intersector.intersect_no_motion(
+            assembly_tree,
+            packet,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_assembly_tree_traversal_stats
+#endif
+            );
+
+        for (size_t i = 0; i < count; ++i)
+            occluded[begin + i] = (visitor.get_hits() & (std::uint32_t(1) << i)) != 0;
+    }
+}
+
+bool Intersector::probe_assembly_tree(
+    const ShadingRay&                   ray,
+    const ShadingPoint*                 parent_shading_point,
+    OccluderCache::Entry*               occluder) const
+{
     // Retrieve assembly tree.
     const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
 
+#ifdef APPLESEED_WITH_EMBREE
+    // Occluder cache entries are only tested against the assembly tree.
+    if (assembly_tree.m_embree_instance_scene)
+        return assembly_tree.m_embree_instance_scene->occlude(ray, parent_shading_point);
+#endif
+
+    // Compute ray info once for the entire traversal.
+    const ShadingRay::RayInfoType ray_info(ray);
+
     // Check the intersection between the ray and the assembly tree.
     AssemblyTreeProbeIntersector intersector;
     AssemblyLeafProbeVisitor visitor(
         assembly_tree,
         m_triangle_tree_cache,
         m_curve_tree_cache,
+        m_transform_cache,
 #ifdef APPLESEED_WITH_EMBREE
         m_embree_scene_cache,
 #endif
-        parent_shading_point
+        parent_shading_point,
+        occluder
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , m_triangle_tree_traversal_stats
 #endif
         );
-    intersector.intersect_no_motion(
-        assembly_tree,
-        ray,
-        ray_info,
-        visitor
+
+    // Test the cached occluder first, if any.
+    if (occluder && occluder->m_assembly_instance)
+    {
+        ++m_occluder_cache.m_lookup_count;
+
+        if (visitor.intersect_occluder(*occluder, ray))
+        {
+            ++m_occluder_cache.m_hit_count;
+            return true;
+        }
+    }
+
+    if (assembly_tree.has_motion_bboxes())
+    {
+        intersector.intersect_motion(
+            assembly_tree,
+            ray,
+            ray_info,
+            ray.m_time.m_normalized,
+            visitor
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-        , m_assembly_tree_traversal_stats
+            , m_assembly_tree_traversal_stats
 #endif
-        );
+            );
+    }
+    else
+    {
+        intersector.intersect_no_motion(
+            assembly_tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , m_assembly_tree_traversal_stats
+#endif
+            );
+    }
 
     return visitor.hit();
 }
@@ -356,18 +595,17 @@ void Intersector::make_volume_shading_point(
 
 namespace
 {
+    // The ray count is stored in m_value so that it can be retrieved as an unsigned integer entry.
     struct RayCountStatisticsEntry
-      : public Statistics::Entry
+      : public Statistics::UnsignedIntegerEntry
     {
-        std::uint64_t   m_ray_count;
         std::uint64_t   m_total_ray_count;
 
         RayCountStatisticsEntry(
             const std::string&   name,
             const std::uint64_t  ray_count,
             const std::uint64_t  total_ray_count)
-          : Entry(name)
-          , m_ray_count(ray_count)
+          : UnsignedIntegerEntry(name, std::string(), ray_count)
           , m_total_ray_count(total_ray_count)
         {
         }
@@ -382,13 +620,13 @@ namespace
             const RayCountStatisticsEntry* typed_other =
                 cast<RayCountStatisticsEntry>(other);
 
-            m_ray_count += typed_other->m_ray_count;
+            m_value += typed_other->m_value;
             m_total_ray_count += typed_other->m_total_ray_count;
         }
 
         std::string to_string() const override
         {
-            return pretty_uint(m_ray_count) + " (" + pretty_percent(m_ray_count, m_total_ray_count) + ")";
+            return pretty_uint(m_value) + " (" + pretty_percent(m_value, m_total_ray_count) + ")";
         }
     };
 }
@@ -430,6 +668,21 @@ StatisticsVector Intersector::get_statistics() const
         "triangle tree access cache statistics",
         make_dual_stage_cache_stats(m_triangle_tree_cache));
 
+    vec.insert(
+        "assembly instance transform cache statistics",
+        make_single_stage_cache_stats(m_transform_cache));
+
+    if (m_occluder_cache.m_lookup_count.is_enabled())
+    {
+        Statistics occluder_cache_stats;
+        occluder_cache_stats.insert("lookups", m_occluder_cache.m_lookup_count.get());
+        occluder_cache_stats.insert_percent(
+            "hit rate",
+            m_occluder_cache.m_hit_count.get(),
+            m_occluder_cache.m_lookup_count.get());
+        vec.insert("shadow occluder cache statistics", occluder_cache_stats);
+    }
+
     return vec;
 }
 
@@ -35,6 +35,7 @@
 #include "renderer/kernel/intersection/embreescene.h"
 #endif
 #include "renderer/kernel/intersection/intersectionsettings.h"
+#include "renderer/kernel/intersection/occludercache.h"
 #include "renderer/kernel/intersection/triangletree.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/kernel/tessellation/statictessellation.h"
@@ -78,9 +79,33 @@ class Intersector
         ShadingPoint&                       shading_point,
         const ShadingPoint*                 parent_shading_point = nullptr) const;
 
+    // Trace a world space ray against the triangles of a single object instance: the one
+    // of `reference_point`. Other object instances, curves and procedural objects are
+    // ignored, which makes this much cheaper than trace() for local queries such as
+    // subsurface scattering probes. When Embree is used, this falls back to trace()
+    // and hits on other object instances may be returned.
+    bool trace_object_instance(
+        const ShadingRay&                   ray,
+        const ShadingPoint&                 reference_point,
+        ShadingPoint&                       shading_point,
+        const ShadingPoint*                 parent_shading_point = nullptr) const;
+
     // Trace a world space probe ray through the scene.
+    // If an occluder key other than OccluderCache::NoKey is given, the triangle that last
+    // blocked a probe ray traced with the same key is tested before traversing the scene.
     bool trace_probe(
         const ShadingRay&                   ray,
+        const ShadingPoint*                 parent_shading_point = nullptr,
+        const size_t                        occluder_key = OccluderCache::NoKey) const;
+
+    // Trace a stream of world space probe rays through the scene, all originating from
+    // the same parent shading point (if any). occluded[i] is set to the result of the
+    // i'th ray. The stream is handed over to Embree when Embree instancing is enabled,
+    // otherwise rays traverse the trees in packets of ProbeRayPacketSize rays.
+    void trace_probe_stream(
+        const ShadingRay*                   rays,
+        const size_t                        ray_count,
+        bool*                               occluded,
         const ShadingPoint*                 parent_shading_point = nullptr) const;
 
     // Manufacture a triangle hit "by hand".
@@ -120,6 +145,9 @@ class Intersector
         const ShadingRay&                   volume_ray,
         const double                        distance) const;
 
+    // Return the number of rays traced so far by this intersector.
+    std::uint64_t get_ray_count() const;
+
     // Retrieve performance statistics.
     foundation::StatisticsVector get_statistics() const;
 
@@ -131,6 +159,8 @@ class Intersector
     // Access caches.
     mutable TriangleTreeAccessCache                 m_triangle_tree_cache;
     mutable CurveTreeAccessCache                    m_curve_tree_cache;
+    mutable TransformSequenceCache                  m_transform_cache;
+    mutable OccluderCache                           m_occluder_cache;
 #ifdef APPLESEED_WITH_EMBREE
     mutable EmbreeSceneAccessCache                  m_embree_scene_cache;
 #endif
@@ -142,6 +172,22 @@ class Intersector
     mutable foundation::bvh::TraversalStatistics    m_triangle_tree_traversal_stats;
     mutable foundation::bvh::TraversalStatistics    m_curve_tree_traversal_stats;
 #endif
+
+    // Trace a probe ray, assuming the parent shading point was already refined.
+    bool probe_assembly_tree(
+        const ShadingRay&                   ray,
+        const ShadingPoint*                 parent_shading_point,
+        OccluderCache::Entry*               occluder = nullptr) const;
 };
 
+
+//
+// Intersector class implementation.
+//
+
+inline std::uint64_t Intersector::get_ray_count() const
+{
+    return m_shading_ray_count + m_probe_ray_count;
+}
+
 }   // namespace renderer
@@ -0,0 +1,134 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/intersection/intersectionsettings.h"
+#include "renderer/modeling/scene/visibilityflags.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/hash/hash.h"
+#include "foundation/utility/statcounters.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+// Forward declarations.
+namespace renderer  { class AssemblyInstance; }
+namespace renderer  { class TransformSequence; }
+
+namespace renderer
+{
+
+//
+// A small cache of the triangles that last blocked probe rays.
+//
+// Entries are identified by an arbitrary key chosen by the caller, typically
+// identifying a light. Consecutive shadow rays toward a given light are often
+// blocked by the same triangle: testing it first allows skipping the traversal
+// of the scene altogether.
+//
+// Only static triangles are cached. They are stored in assembly instance space
+// so that the cached occluder remains valid for moving assembly instances.
+//
+// The cache is not thread-safe: each rendering thread must own its own instance.
+//
+
+class OccluderCache
+  : public foundation::NonCopyable
+{
+  public:
+    // Key value meaning that the cache must not be used.
+    static const size_t NoKey = ~size_t(0);
+
+    struct Entry
+    {
+        size_t                      m_key;
+        const AssemblyInstance*     m_assembly_instance;        // null if no occluder is cached
+        const TransformSequence*    m_transform_sequence;       // assembly instance space to world space
+        VisibilityFlags::Type       m_ray_flags;                // flags of the ray that hit the occluder
+        TriangleType                m_triangle;                 // in assembly instance space
+    };
+
+    // Constructor.
+    OccluderCache();
+
+    // Return the entry for a given key. The entry is reset if it was used by another key.
+    Entry& get(const size_t key);
+
+    // Remove all cached occluders.
+    void clear();
+
+    // Performance statistics.
+    foundation::StatCounter<foundation::StatsLevel::Detailed>  m_lookup_count;
+    foundation::StatCounter<foundation::StatsLevel::Detailed>  m_hit_count;
+
+  private:
+    static const size_t EntryCount = 64;
+
+    Entry                           m_entries[EntryCount];
+};
+
+
+//
+// OccluderCache class implementation.
+//
+
+inline OccluderCache::OccluderCache()
+{
+    clear();
+}
+
+inline OccluderCache::Entry& OccluderCache::get(const size_t key)
+{
+    assert(key != NoKey);
+
+    Entry& entry = m_entries[foundation::hash_uint64(key) & (EntryCount - 1)];
+
+    if (entry.m_key != key)
+    {
+        entry.m_key = key;
+        entry.m_assembly_instance = nullptr;
+    }
+
+    return entry;
+}
+
+inline void OccluderCache::clear()
+{
+    for (size_t i = 0; i < EntryCount; ++i)
+    {
+        m_entries[i].m_key = NoKey;
+        m_entries[i].m_assembly_instance = nullptr;
+    }
+}
+
+}   // namespace renderer
@@ -35,16 +35,123 @@
 #include "renderer/kernel/intersection/trianglevertexinfo.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
 #include "foundation/memory/memory.h"
 
 // Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <cstdint>
+#include <limits>
 
 using namespace foundation;
 
 namespace renderer
 {
 
+namespace
+{
+    // Number of bits of the grid coordinates of the largest vertex coordinate.
+    const int GridBits = 20;
+
+    // Maximum number of distinct vertices in a compressed leaf.
+    const size_t MaxCompressedLeafVertexCount = 256;
+
+    typedef Vector<std::int32_t, 3> GridVector;
+
+    // A leaf with its vertices snapped to the grid and deduplicated.
+    struct QuantizedLeaf
+    {
+        std::uint32_t               m_vis_flags;
+        GridVector                  m_base;
+        std::vector<GridVector>     m_vertices;
+        std::vector<std::uint8_t>   m_indices;
+    };
+
+    bool quantize_leaf(
+        const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+        const std::vector<GVector3>&            triangle_vertices,
+        const std::vector<size_t>&              triangle_indices,
+        const size_t                            item_begin,
+        const size_t                            item_count,
+        const GScalar                           grid_step,
+        QuantizedLeaf&                          leaf)
+    {
+        leaf.m_vertices.clear();
+        leaf.m_indices.clear();
+
+        GridVector vmin(std::numeric_limits<std::int32_t>::max());
+        GridVector vmax(std::numeric_limits<std::int32_t>::min());
+
+        for (size_t i = 0; i < item_count; ++i)
+        {
+            const size_t triangle_index = triangle_indices[item_begin + i];
+            const TriangleVertexInfo& vertex_info = triangle_vertex_infos[triangle_index];
+
+            // Only static triangles sharing the same visibility flags can be compressed.
+            if (vertex_info.m_motion_segment_count > 0)
+                return false;
+            if (i == 0)
+                leaf.m_vis_flags = vertex_info.m_vis_flags;
+            else if (vertex_info.m_vis_flags != leaf.m_vis_flags)
+                return false;
+
+            for (size_t j = 0; j < 3; ++j)
+            {
+                const GVector3& v = triangle_vertices[vertex_info.m_vertex_index + j];
+
+                // Dividing by a power of two is exact.
+                const GridVector q(
+                    round<std::int32_t>(v[0] / grid_step),
+                    round<std::int32_t>(v[1] / grid_step),
+                    round<std::int32_t>(v[2] / grid_step));
+
+                const std::vector<GridVector>::const_iterator it =
+                    std::find(leaf.m_vertices.begin(), leaf.m_vertices.end(), q);
+
+                if (it == leaf.m_vertices.end())
+                {
+                    if (leaf.m_vertices.size() == MaxCompressedLeafVertexCount)
+                        return false;
+
+                    leaf.m_indices.push_back(static_cast<std::uint8_t>(leaf.m_vertices.size()));
+                    leaf.m_vertices.push_back(q);
+
+                    vmin = component_wise_min(vmin, q);
+                    vmax = component_wise_max(vmax, q);
+                }
+                else leaf.m_indices.push_back(static_cast<std::uint8_t>(it - leaf.m_vertices.begin()));
+            }
+        }
+
+        // Vertices are stored as 16-bit offsets from the base of the leaf.
+        for (size_t i = 0; i < 3; ++i)
+        {
+            if (static_cast<std::int64_t>(vmax[i]) - vmin[i] > std::numeric_limits<std::uint16_t>::max())
+                return false;
+        }
+
+        leaf.m_base = vmin;
+
+        return true;
+    }
+
+    size_t compute_compressed_leaf_size(const QuantizedLeaf& leaf)
+    {
+        size_t size = 0;
+
+        size += sizeof(std::uint32_t);                                  // visibility flags
+        size += 3 * sizeof(std::int32_t);                               // base grid coordinates
+        size += (leaf.m_indices.size() + 1) & ~size_t(1);               // vertex indices
+        size += leaf.m_vertices.size() * 3 * sizeof(std::uint16_t);     // vertex grid coordinates
+
+        // Keep the next leaf aligned.
+        return (size + 3) & ~size_t(3);
+    }
+}
+
 size_t TriangleEncoder::compute_size(
     const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
     const std::vector<size_t>&              triangle_indices,
@@ -75,6 +182,7 @@ void TriangleEncoder::encode(
     const std::vector<size_t>&              triangle_indices,
     const size_t                            item_begin,
     const size_t                            item_count,
+    const bool                              watertight,
     MemoryWriter&                           writer)
 {
     for (size_t i = 0; i < item_count; ++i)
@@ -85,7 +193,15 @@ void TriangleEncoder::encode(
         writer.write(vertex_info.m_vis_flags);
         writer.write(static_cast<std::uint32_t>(vertex_info.m_motion_segment_count));
 
-        if (vertex_info.m_motion_segment_count == 0)
+        if (vertex_info.m_motion_segment_count == 0 && watertight)
+        {
+            writer.write(
+                GWatertightTriangleType(
+                    triangle_vertices[vertex_info.m_vertex_index + 0],
+                    triangle_vertices[vertex_info.m_vertex_index + 1],
+                    triangle_vertices[vertex_info.m_vertex_index + 2]));
+        }
+        else if (vertex_info.m_motion_segment_count == 0)
         {
             writer.write(
                 GTriangleType(
@@ -102,4 +218,95 @@ void TriangleEncoder::encode(
     }
 }
 
+GScalar TriangleEncoder::compute_grid_step(
+    const std::vector<GVector3>&            triangle_vertices)
+{
+    GScalar max_abs(0.0);
+
+    for (size_t i = 0, e = triangle_vertices.size(); i < e; ++i)
+    {
+        const GVector3& v = triangle_vertices[i];
+        max_abs = std::max(max_abs, std::abs(v[max_abs_index(v)]));
+    }
+
+    if (max_abs == GScalar(0.0))
+        return GScalar(0.0);
+
+    // The largest vertex coordinate maps to a grid coordinate below 2^GridBits.
+    int exponent;
+    std::frexp(max_abs, &exponent);
+
+    return std::ldexp(GScalar(1.0), exponent - GridBits);
+}
+
+bool TriangleEncoder::compute_compressed_size(
+    const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+    const std::vector<GVector3>&            triangle_vertices,
+    const std::vector<size_t>&              triangle_indices,
+    const size_t                            item_begin,
+    const size_t                            item_count,
+    const GScalar                           grid_step,
+    size_t&                                 size)
+{
+    QuantizedLeaf leaf;
+
+    if (!quantize_leaf(
+            triangle_vertex_infos,
+            triangle_vertices,
+            triangle_indices,
+            item_begin,
+            item_count,
+            grid_step,
+            leaf))
+        return false;
+
+    size = compute_compressed_leaf_size(leaf);
+
+    return true;
+}
+
+void TriangleEncoder::encode_compressed(
+    const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+    const std::vector<GVector3>&            triangle_vertices,
+    const std::vector<size_t>&              triangle_indices,
+    const size_t                            item_begin,
+    const size_t                            item_count,
+    const GScalar                           grid_step,
+    MemoryWriter&                           writer)
+{
+    QuantizedLeaf leaf;
+
+    const bool success =
+        quantize_leaf(
+            triangle_vertex_infos,
+            triangle_vertices,
+            triangle_indices,
+            item_begin,
+            item_count,
+            grid_step,
+            leaf);
+    assert(success);
+
+    const size_t begin = writer.offset();
+
+    writer.write(leaf.m_vis_flags);
+    writer.write(leaf.m_base[0]);
+    writer.write(leaf.m_base[1]);
+    writer.write(leaf.m_base[2]);
+
+    writer.write(&leaf.m_indices[0], leaf.m_indices.size());
+    if (leaf.m_indices.size() & 1)
+        writer.write<std::uint8_t>(0);
+
+    for (size_t i = 0, e = leaf.m_vertices.size(); i < e; ++i)
+    {
+        writer.write(static_cast<std::uint16_t>(leaf.m_vertices[i][0] - leaf.m_base[0]));
+        writer.write(static_cast<std::uint16_t>(leaf.m_vertices[i][1] - leaf.m_base[1]));
+        writer.write(static_cast<std::uint16_t>(leaf.m_vertices[i][2] - leaf.m_base[2]));
+    }
+
+    while (writer.offset() - begin < compute_compressed_leaf_size(leaf))
+        writer.write<std::uint8_t>(0);
+}
+
 }   // namespace renderer
@@ -31,9 +31,11 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
 // Forward declarations.
@@ -58,7 +60,137 @@ class TriangleEncoder
         const std::vector<size_t>&              triangle_indices,
         const size_t                            item_begin,
         const size_t                            item_count,
+        const bool                              watertight,
         foundation::MemoryWriter&               writer);
+
+    // Compute the step of the grid onto which the vertices of compressed leaves are snapped.
+    // The step is a power of two, hence decoded vertices are exactly representable and a
+    // vertex shared by several leaves decodes to the same position in all of them.
+    static GScalar compute_grid_step(
+        const std::vector<GVector3>&            triangle_vertices);
+
+    // Compute the size of a compressed leaf. Return false if the leaf cannot be
+    // compressed, in which case it must be encoded with encode().
+    static bool compute_compressed_size(
+        const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+        const std::vector<GVector3>&            triangle_vertices,
+        const std::vector<size_t>&              triangle_indices,
+        const size_t                            item_begin,
+        const size_t                            item_count,
+        const GScalar                           grid_step,
+        size_t&                                 size);
+
+    static void encode_compressed(
+        const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+        const std::vector<GVector3>&            triangle_vertices,
+        const std::vector<size_t>&              triangle_indices,
+        const size_t                            item_begin,
+        const size_t                            item_count,
+        const GScalar                           grid_step,
+        foundation::MemoryWriter&               writer);
+};
+
+
+//
+// Decoder for the triangles of a compressed leaf.
+//
+// A compressed leaf only holds static triangles sharing the same visibility flags.
+// The distinct vertices of the leaf are stored once, as 16-bit grid coordinates
+// relative to the base grid coordinates of the leaf:
+//
+//   std::uint32_t      visibility flags
+//   std::int32_t       base grid coordinates (x, y, z)
+//   std::uint8_t       vertex indices (3 per triangle)
+//   (padding to 2 bytes)
+//   std::uint16_t      vertex grid coordinates (x, y, z per vertex)
+//   (padding to 4 bytes)
+//
+
+class CompressedTriangleLeafReader
+{
+  public:
+    // Constructor.
+    CompressedTriangleLeafReader(
+        const std::uint8_t*                     leaf_data,
+        const size_t                            triangle_count,
+        const GScalar                           grid_step);
+
+    // Return the visibility flags of the triangles of the leaf.
+    std::uint32_t get_vis_flags() const;
+
+    // Decode a given triangle of the leaf.
+    GTriangleType read_triangle(const size_t triangle_index) const;
+    GWatertightTriangleType read_watertight_triangle(const size_t triangle_index) const;
+
+  private:
+    const std::uint8_t*     m_indices;
+    const std::uint16_t*    m_vertices;
+    std::uint32_t           m_vis_flags;
+    std::int32_t            m_base[3];
+    GScalar                 m_grid_step;
+
+    GVector3 read_vertex(const size_t vertex_index) const;
 };
 
+
+//
+// CompressedTriangleLeafReader class implementation.
+//
+
+inline CompressedTriangleLeafReader::CompressedTriangleLeafReader(
+    const std::uint8_t*                         leaf_data,
+    const size_t                                triangle_count,
+    const GScalar                               grid_step)
+  : m_grid_step(grid_step)
+{
+    const std::uint32_t* header = reinterpret_cast<const std::uint32_t*>(leaf_data);
+    m_vis_flags = header[0];
+    m_base[0] = static_cast<std::int32_t>(header[1]);
+    m_base[1] = static_cast<std::int32_t>(header[2]);
+    m_base[2] = static_cast<std::int32_t>(header[3]);
+
+    m_indices = leaf_data + 4 * sizeof(std::uint32_t);
+    m_vertices = reinterpret_cast<const std::uint16_t*>(m_indices + ((triangle_count * 3 + 1) & ~size_t(1)));
+}
+
+inline std::uint32_t CompressedTriangleLeafReader::get_vis_flags() const
+{
+    return m_vis_flags;
+}
+
+inline GTriangleType CompressedTriangleLeafReader::read_triangle(const size_t triangle_index) const
+{
+    const std::uint8_t* indices = m_indices + triangle_index * 3;
+
+    return
+        GTriangleType(
+            read_vertex(indices[0]),
+            read_vertex(indices[1]),
+            read_vertex(indices[2]));
+}
+
+inline GWatertightTriangleType CompressedTriangleLeafReader::read_watertight_triangle(const size_t triangle_index) const
+{
+    const std::uint8_t* indices = m_indices + triangle_index * 3;
+
+    return
+        GWatertightTriangleType(
+            read_vertex(indices[0]),
+            read_vertex(indices[1]),
+            read_vertex(indices[2]));
+}
+
+inline GVector3 CompressedTriangleLeafReader::read_vertex(const size_t vertex_index) const
+{
+    const std::uint16_t* v = m_vertices + vertex_index * 3;
+
+    // Grid coordinates fit in the mantissa of GScalar and the grid step is a power of two:
+    // these products are exact.
+    return
+        GVector3(
+            static_cast<GScalar>(m_base[0] + v[0]) * m_grid_step,
+            static_cast<GScalar>(m_base[1] + v[1]) * m_grid_step,
+            static_cast<GScalar>(m_base[2] + v[2]) * m_grid_step);
+}
+
 }   // namespace renderer
@@ -54,8 +54,12 @@
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/containers/dictionary.h"
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/hash/murmurhash.h"
 #include "foundation/math/area.h"
 #include "foundation/math/intersection/aabbtriangle.h"
+#include "foundation/math/intersection/raytrianglewatertight.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/transform.h"
 #include "foundation/math/treeoptimizer.h"
@@ -67,18 +71,27 @@
 #include "foundation/platform/types.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/api/apistring.h"
+#include "foundation/utility/bufferedfile.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/makevector.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/stopwatch.h"
 
+// Boost headers.
+#include "boost/filesystem.hpp"
+
 // Standard headers.
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <exception>
 #include <set>
 #include <string>
 
 using namespace foundation;
+namespace bf = boost::filesystem;
 
 namespace renderer
 {
@@ -395,9 +408,17 @@ TriangleTree::Arguments::Arguments(
 }
 
 TriangleTree::TriangleTree(const Arguments& arguments)
-  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
+  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size(), true))
   , m_arguments(arguments)
+  , m_leaf_data(AlignedAllocator<void>(System::get_l1_data_cache_line_size(), true))
+  , m_vertex_grid_step(0.0)
+  , m_watertight(false)
+  , m_wide_nodes(AlignedAllocator<void>(System::get_l1_data_cache_line_size(), true))
+  , m_vis_flags(0)
+  , m_tracked_memory("acceleration structures")
 {
+    APPLESEED_TRACE_SCOPE("acceleration", "build triangle tree");
+
     // Retrieve construction parameters.
     const MessageContext message_context(
         format("while building triangle tree for assembly \"{0}\"", m_arguments.m_assembly.get_path()));
@@ -405,26 +426,77 @@ TriangleTree::TriangleTree(const Arguments& arguments)
     const std::string algorithm = params.get_optional<std::string>("algorithm", "bvh", make_vector("bvh", "sbvh"), message_context);
     const double time = params.get_optional<double>("time", 0.5);
     const bool save_memory = params.get_optional<bool>("save_temporary_memory", false);
+    const bool use_wide_nodes = params.get_optional<bool>("wide_nodes", true);
+    m_watertight =
+        params.get_optional<std::string>(
+            "triangle_intersector",
+            "moller_trumbore",
+            make_vector("moller_trumbore", "watertight"),
+            message_context) == "watertight";
+
+    const std::string cache_directory = params.get_optional<std::string>("cache_directory", "");
 
     // Start stopwatch.
     Stopwatch<DefaultWallclockTimer> stopwatch;
     stopwatch.start();
 
-    // Build the tree.
+    // Look for a previously built tree in the cache.
     Statistics statistics;
-    if (algorithm == "bvh")
-        build_bvh(params, time, save_memory, statistics);
-    else build_sbvh(params, time, save_memory, statistics);
-    statistics.insert_time("total build time", stopwatch.measure().get_seconds());
-    statistics.insert_size("nodes alignment", alignment(&m_nodes[0]));
+    std::string cache_filepath;
+    bool loaded_from_cache = false;
+    if (!cache_directory.empty())
+    {
+        cache_filepath =
+            (bf::path(cache_directory) /
+                (compute_cache_key(params, time, save_memory).to_string() + ".triangletree")).string();
+        loaded_from_cache = load_from_cache(cache_filepath);
+        statistics.insert("cache", loaded_from_cache ? "hit" : "miss");
+    }
+
+    if (loaded_from_cache)
+    {
+        RENDERER_LOG_INFO(
+            "loaded triangle tree #" FMT_UNIQUE_ID " from %s.",
+            m_arguments.m_triangle_tree_uid,
+            cache_filepath.c_str());
+        statistics.insert_time("total load time", stopwatch.measure().get_seconds());
+    }
+    else
+    {
+        // Build the tree.
+        if (algorithm == "bvh")
+            build_bvh(params, time, save_memory, statistics);
+        else build_sbvh(params, time, save_memory, statistics);
+        statistics.insert_time("total build time", stopwatch.measure().get_seconds());
 
 #ifdef RENDERER_TRIANGLE_TREE_REORDER_NODES
-    // Optimize the tree layout in memory.
-    TreeOptimizer<NodeVectorType> tree_optimizer(m_nodes);
-    tree_optimizer.optimize_node_layout(TriangleTreeSubtreeDepth);
-    assert(m_nodes.size() == m_nodes.capacity());
+        // Optimize the tree layout in memory.
+        TreeOptimizer<NodeVectorType> tree_optimizer(m_nodes);
+        tree_optimizer.optimize_node_layout(TriangleTreeSubtreeDepth);
+        assert(m_nodes.size() == m_nodes.capacity());
 #endif
 
+        // Store the tree in the cache for later renders.
+        if (!cache_filepath.empty())
+            save_to_cache(cache_filepath);
+    }
+
+    statistics.insert_size("nodes alignment", alignment(&m_nodes[0]));
+
+    // Collapse the tree into wide nodes for faster traversal. Motion is only supported by binary nodes.
+    if (use_wide_nodes && m_moving_triangle_count == 0)
+    {
+        bvh::WideBuilder<TriangleTree, WideNodeVector> wide_builder;
+        wide_builder.build<DefaultWallclockTimer>(*this, m_wide_nodes);
+        statistics.insert_time("wide nodes build time", wide_builder.get_build_time());
+        statistics.insert("wide nodes", m_wide_nodes.size());
+    }
+
+    // Let rays skip the parts of the tree they can't see.
+    compute_vis_flags();
+
+    m_tracked_memory.set_size(get_memory_size());
+
     // Print triangle tree statistics.
     RENDERER_LOG_DEBUG("%s",
         StatisticsVector::make(
@@ -456,7 +528,8 @@ size_t TriangleTree::get_memory_size() const
         - sizeof(*static_cast<const TreeType*>(this))
         + sizeof(*this)
         + m_triangle_keys.capacity() * sizeof(TriangleKey)
-        + m_leaf_data.capacity() * sizeof(std::uint8_t);
+        + m_leaf_data.capacity() * sizeof(std::uint8_t)
+        + m_wide_nodes.capacity() * sizeof(WideNodeVector::value_type);
 }
 
 namespace
@@ -494,6 +567,190 @@ namespace
     }
 }
 
+namespace
+{
+    // Version of the triangle tree cache file format. Bump whenever the layout
+    // of nodes or leaves, or the way trees are built, changes.
+    const std::uint16_t TriangleTreeCacheVersion = 1;
+
+    const char TriangleTreeCacheSignature[12] =
+        { 'T', 'R', 'I', 'A', 'N', 'G', 'L', 'E', 'T', 'R', 'E', 'E' };
+
+    template <typename Vector>
+    void write_vector(BufferedFile& file, const Vector& vec)
+    {
+        checked_write(file, static_cast<std::uint64_t>(vec.size()));
+        if (!vec.empty())
+            checked_write(file, &vec[0], vec.size() * sizeof(typename Vector::value_type));
+    }
+
+    template <typename Vector>
+    void read_vector(BufferedFile& file, Vector& vec)
+    {
+        std::uint64_t size;
+        checked_read(file, size);
+        vec.resize(static_cast<size_t>(size));
+        if (!vec.empty())
+            checked_read(file, &vec[0], vec.size() * sizeof(typename Vector::value_type));
+    }
+}
+
+MurmurHash TriangleTree::compute_cache_key(
+    const ParamArray&   params,
+    const double        time,
+    const bool          save_memory) const
+{
+    MurmurHash hash;
+
+    // Format of the cached data.
+    hash.append(TriangleTreeCacheVersion);
+    hash.append(static_cast<std::uint32_t>(sizeof(NodeType)));
+    hash.append(static_cast<std::uint32_t>(sizeof(GScalar)));
+
+    // Build settings, except those that don't affect the resulting tree.
+    for (const_each<StringDictionary> i = params.strings(); i; ++i)
+    {
+        if (strcmp(i->key(), "cache_directory") == 0 ||
+            strcmp(i->key(), "build_thread_count") == 0 ||
+            strcmp(i->key(), "save_temporary_memory") == 0 ||
+            strcmp(i->key(), "wide_nodes") == 0)
+            continue;
+
+        hash.append(i->key());
+        hash.append(i->value());
+    }
+
+    hash.append(m_arguments.m_bbox);
+
+    // Geometry.
+    std::vector<TriangleKey> triangle_keys;
+    std::vector<TriangleVertexInfo> triangle_vertex_infos;
+    std::vector<GVector3> triangle_vertices;
+    collect_triangles<GAABB3>(
+        m_arguments,
+        time,
+        save_memory,
+        &triangle_keys,
+        &triangle_vertex_infos,
+        &triangle_vertices,
+        nullptr);
+
+    hash.append(static_cast<std::uint64_t>(triangle_keys.size()));
+    for (const TriangleKey& key : triangle_keys)
+    {
+        hash.append(static_cast<std::uint64_t>(key.get_object_instance_index()));
+        hash.append(static_cast<std::uint64_t>(key.get_triangle_index()));
+        hash.append(static_cast<std::uint64_t>(key.get_triangle_pa()));
+    }
+
+    for (const TriangleVertexInfo& info : triangle_vertex_infos)
+    {
+        hash.append(static_cast<std::uint64_t>(info.m_vertex_index));
+        hash.append(static_cast<std::uint64_t>(info.m_motion_segment_count));
+        hash.append(info.m_vis_flags);
+    }
+
+    hash.append(static_cast<std::uint64_t>(triangle_vertices.size()));
+    for (const GVector3& v : triangle_vertices)
+        hash.append(v);
+
+    return hash;
+}
+
+bool TriangleTree::load_from_cache(const std::string& filepath)
+{
+    BufferedFile file(
+        filepath.c_str(),
+        BufferedFile::BinaryType,
+        BufferedFile::ReadMode);
+
+    if (!file.is_open())
+        return false;
+
+    try
+    {
+        char signature[sizeof(TriangleTreeCacheSignature)];
+        checked_read(file, signature, sizeof(signature));
+        if (memcmp(signature, TriangleTreeCacheSignature, sizeof(signature)) != 0)
+            return false;
+
+        std::uint16_t version;
+        checked_read(file, version);
+        if (version != TriangleTreeCacheVersion)
+            return false;
+
+        std::uint64_t static_triangle_count, moving_triangle_count;
+        checked_read(file, static_triangle_count);
+        checked_read(file, moving_triangle_count);
+        checked_read(file, m_vertex_grid_step);
+
+        read_vector(file, m_nodes);
+        read_vector(file, m_node_bboxes);
+        read_vector(file, m_triangle_keys);
+        read_vector(file, m_leaf_data);
+
+        m_static_triangle_count = static_cast<size_t>(static_triangle_count);
+        m_moving_triangle_count = static_cast<size_t>(moving_triangle_count);
+    }
+    catch (const std::exception&)
+    {
+        RENDERER_LOG_WARNING("failed to read triangle tree cache file %s.", filepath.c_str());
+
+        clear();
+        m_node_bboxes.clear();
+        m_triangle_keys.clear();
+        m_leaf_data.clear();
+        m_vertex_grid_step = GScalar(0.0);
+
+        return false;
+    }
+
+    return !m_nodes.empty();
+}
+
+void TriangleTree::save_to_cache(const std::string& filepath) const
+{
+    // Write to a temporary file first so that concurrent renders never see partial files.
+    // Its name must be unique across processes sharing the cache directory.
+    const std::string temp_filepath =
+        (bf::path(filepath).parent_path() / bf::unique_path("%%%%-%%%%-%%%%-%%%%.tmp")).string();
+
+    try
+    {
+        bf::create_directories(bf::path(filepath).parent_path());
+
+        {
+            BufferedFile file(
+                temp_filepath.c_str(),
+                BufferedFile::BinaryType,
+                BufferedFile::WriteMode);
+
+            if (!file.is_open())
+                throw ExceptionIOError();
+
+            checked_write(file, TriangleTreeCacheSignature, sizeof(TriangleTreeCacheSignature));
+            checked_write(file, TriangleTreeCacheVersion);
+            checked_write(file, static_cast<std::uint64_t>(m_static_triangle_count));
+            checked_write(file, static_cast<std::uint64_t>(m_moving_triangle_count));
+            checked_write(file, m_vertex_grid_step);
+
+            write_vector(file, m_nodes);
+            write_vector(file, m_node_bboxes);
+            write_vector(file, m_triangle_keys);
+            write_vector(file, m_leaf_data);
+        }
+
+        bf::rename(temp_filepath, filepath);
+    }
+    catch (const std::exception&)
+    {
+        RENDERER_LOG_WARNING("failed to write triangle tree cache file %s.", filepath.c_str());
+
+        boost::system::error_code ec;
+        bf::remove(temp_filepath, ec);
+    }
+}
+
 void TriangleTree::build_bvh(
     const ParamArray&   params,
     const double        time,
@@ -535,9 +792,14 @@ void TriangleTree::build_bvh(
         plural(m_moving_triangle_count, "moving triangle").c_str());
 
     // Retrieving the partitioner parameters.
-    const size_t max_leaf_size = params.get_optional<size_t>("max_leaf_size", TriangleTreeDefaultMaxLeafSize);
+    const bool compress_leaves = params.get_optional<bool>("compressed_leaves", false);
+    const size_t max_leaf_size =
+        params.get_optional<size_t>(
+            "max_leaf_size",
+            compress_leaves ? TriangleTreeDefaultCompressedMaxLeafSize : TriangleTreeDefaultMaxLeafSize);
     const GScalar interior_node_traversal_cost = params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost);
     const GScalar triangle_intersection_cost = params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost);
+    const size_t build_thread_count = params.get_optional<size_t>("build_thread_count", System::get_logical_cpu_core_count());
 
     // Create the partitioner.
     typedef bvh::SAHPartitioner<std::vector<GAABB3>> Partitioner;
@@ -554,7 +816,8 @@ void TriangleTree::build_bvh(
         *this,
         partitioner,
         triangle_keys.size(),
-        max_leaf_size);
+        max_leaf_size,
+        build_thread_count);
     statistics.merge(
         bvh::TreeStatistics<TriangleTree>(*this, AABB3d(m_arguments.m_bbox)));
 
@@ -587,6 +850,7 @@ void TriangleTree::build_bvh(
         triangle_vertex_infos,
         triangle_vertices,
         triangle_keys,
+        compress_leaves,
         statistics);
 
     const double store_time = stopwatch.measure().get_seconds();
@@ -638,7 +902,11 @@ void TriangleTree::build_sbvh(
         plural(m_moving_triangle_count, "moving triangle").c_str());
 
     // Retrieving the partitioner parameters.
-    const size_t max_leaf_size = params.get_optional<size_t>("max_leaf_size", TriangleTreeDefaultMaxLeafSize);
+    const bool compress_leaves = params.get_optional<bool>("compressed_leaves", false);
+    const size_t max_leaf_size =
+        params.get_optional<size_t>(
+            "max_leaf_size",
+            compress_leaves ? TriangleTreeDefaultCompressedMaxLeafSize : TriangleTreeDefaultMaxLeafSize);
     const size_t bin_count = params.get_optional<size_t>("bin_count", TriangleTreeDefaultBinCount);
     const GScalar interior_node_traversal_cost = params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost);
     const GScalar triangle_intersection_cost = params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost);
@@ -698,6 +966,7 @@ void TriangleTree::build_sbvh(
         triangle_vertex_infos,
         triangle_vertices,
         triangle_keys,
+        compress_leaves,
         statistics);
 
     const double store_time = stopwatch.measure().get_seconds();
@@ -750,6 +1019,12 @@ namespace
     }
 
 #endif
+
+    AABB3d grow_node_bbox(AABB3d bbox)
+    {
+        bbox.robust_grow(TriangleTreeWatertightBBoxGrowEps);
+        return bbox;
+    }
 }
 
 std::vector<GAABB3> TriangleTree::compute_motion_bboxes(
@@ -784,7 +1059,10 @@ std::vector<GAABB3> TriangleTree::compute_motion_bboxes(
             node.set_left_bbox_index(m_node_bboxes.size());
 
             for (std::vector<GAABB3>::const_iterator i = left_bboxes.begin(); i != left_bboxes.end(); ++i)
-                m_node_bboxes.push_back(swizzle(AABB3d(*i)));
+            {
+                const AABB3d bbox(*i);
+                m_node_bboxes.push_back(swizzle(m_watertight ? grow_node_bbox(bbox) : bbox));
+            }
         }
 
         if (right_bboxes.size() > 1)
@@ -792,7 +1070,10 @@ std::vector<GAABB3> TriangleTree::compute_motion_bboxes(
             node.set_right_bbox_index(m_node_bboxes.size());
 
             for (std::vector<GAABB3>::const_iterator i = right_bboxes.begin(); i != right_bboxes.end(); ++i)
-                m_node_bboxes.push_back(swizzle(AABB3d(*i)));
+            {
+                const AABB3d bbox(*i);
+                m_node_bboxes.push_back(swizzle(m_watertight ? grow_node_bbox(bbox) : bbox));
+            }
         }
 
         const size_t bbox_count = std::max(left_bboxes.size(), right_bboxes.size());
@@ -875,19 +1156,40 @@ std::vector<GAABB3> TriangleTree::compute_motion_bboxes(
     }
 }
 
+namespace
+{
+    //
+    // The user data of leaf nodes starts with a 32-bit word locating the triangles of the leaf:
+    // either InlineLeafData if they are stored in the node itself, or their offset in the leaf
+    // data of the tree. In trees with compressed leaves, the high bit of this word is set for
+    // compressed leaves.
+    //
+
+    const std::uint32_t InlineLeafData = ~std::uint32_t(0);
+    const std::uint32_t CompressedLeafFlag = std::uint32_t(1) << 31;
+}
+
 void TriangleTree::store_triangles(
     const std::vector<size_t>&               triangle_indices,
     const std::vector<TriangleVertexInfo>&   triangle_vertex_infos,
     const std::vector<GVector3>&             triangle_vertices,
     const std::vector<TriangleKey>&          triangle_keys,
+    const bool                               compress_leaves,
     Statistics&                              statistics)
 {
     const size_t node_count = m_nodes.size();
 
+    // Compute the grid onto which the vertices of compressed leaves are snapped.
+    // Motion is only supported by uncompressed leaves.
+    m_vertex_grid_step = GScalar(0.0);
+    if (compress_leaves && m_moving_triangle_count == 0)
+        m_vertex_grid_step = TriangleEncoder::compute_grid_step(triangle_vertices);
+
     // Gather statistics.
 
     size_t leaf_count = 0;
     size_t fat_leaf_count = 0;
+    size_t compressed_leaf_count = 0;
     size_t leaf_data_size = 0;
 
     for (size_t i = 0; i < node_count; ++i)
@@ -901,12 +1203,27 @@ void TriangleTree::store_triangles(
             const size_t item_begin = node.get_item_index();
             const size_t item_count = node.get_item_count();
 
-            const size_t leaf_size =
-                TriangleEncoder::compute_size(
+            size_t leaf_size;
+
+            if (m_vertex_grid_step > GScalar(0.0) &&
+                TriangleEncoder::compute_compressed_size(
                     triangle_vertex_infos,
+                    triangle_vertices,
                     triangle_indices,
                     item_begin,
-                    item_count);
+                    item_count,
+                    m_vertex_grid_step,
+                    leaf_size))
+                ++compressed_leaf_count;
+            else
+            {
+                leaf_size =
+                    TriangleEncoder::compute_size(
+                        triangle_vertex_infos,
+                        triangle_indices,
+                        item_begin,
+                        item_count);
+            }
 
             if (leaf_size < NodeType::MaxUserDataSize)
                 ++fat_leaf_count;
@@ -914,6 +1231,22 @@ void TriangleTree::store_triangles(
         }
     }
 
+    // Offsets of compressed leaves must leave room for the compressed leaf flag.
+    if (m_vertex_grid_step > GScalar(0.0) && leaf_data_size >= CompressedLeafFlag)
+    {
+        RENDERER_LOG_WARNING(
+            "triangle tree #" FMT_UNIQUE_ID " is too large for compressed leaves, storing uncompressed leaves instead.",
+            m_arguments.m_triangle_tree_uid);
+        store_triangles(
+            triangle_indices,
+            triangle_vertex_infos,
+            triangle_vertices,
+            triangle_keys,
+            false,
+            statistics);
+        return;
+    }
+
     // Store triangle keys and triangles.
 
     m_triangle_keys.reserve(triangle_indices.size());
@@ -938,43 +1271,207 @@ void TriangleTree::store_triangles(
                 m_triangle_keys.push_back(triangle_keys[triangle_index]);
             }
 
-            const size_t leaf_size =
-                TriangleEncoder::compute_size(
+            size_t leaf_size;
+
+            const bool compressed =
+                m_vertex_grid_step > GScalar(0.0) &&
+                TriangleEncoder::compute_compressed_size(
                     triangle_vertex_infos,
+                    triangle_vertices,
                     triangle_indices,
                     item_begin,
-                    item_count);
+                    item_count,
+                    m_vertex_grid_step,
+                    leaf_size);
+
+            if (!compressed)
+            {
+                leaf_size =
+                    TriangleEncoder::compute_size(
+                        triangle_vertex_infos,
+                        triangle_indices,
+                        item_begin,
+                        item_count);
+            }
+
+            const bool fat = leaf_size <= NodeType::MaxUserDataSize - sizeof(std::uint32_t);
 
             MemoryWriter user_data_writer(&node.get_user_data<std::uint8_t>());
+            MemoryWriter& writer = fat ? user_data_writer : leaf_data_writer;
+
+            std::uint32_t location =
+                fat ? InlineLeafData : static_cast<std::uint32_t>(leaf_data_writer.offset());
 
-            if (leaf_size <= NodeType::MaxUserDataSize - sizeof(std::uint32_t))
+            if (m_vertex_grid_step > GScalar(0.0))
             {
-                user_data_writer.write<std::uint32_t>(~std::uint32_t(0));
+                location &= ~CompressedLeafFlag;
+                if (compressed)
+                    location |= CompressedLeafFlag;
+            }
 
-                TriangleEncoder::encode(
+            user_data_writer.write(location);
+
+            if (compressed)
+            {
+                TriangleEncoder::encode_compressed(
                     triangle_vertex_infos,
                     triangle_vertices,
                     triangle_indices,
                     item_begin,
                     item_count,
-                    user_data_writer);
+                    m_vertex_grid_step,
+                    writer);
             }
             else
             {
-                user_data_writer.write(static_cast<std::uint32_t>(leaf_data_writer.offset()));
-
                 TriangleEncoder::encode(
                     triangle_vertex_infos,
                     triangle_vertices,
                     triangle_indices,
                     item_begin,
                     item_count,
-                    leaf_data_writer);
+                    m_watertight,
+                    writer);
+            }
+        }
+    }
+
+    // Decoded vertices lie up to half a grid step away from the original vertices:
+    // grow the bounding boxes of the tree so that they still enclose all triangles.
+    if (m_vertex_grid_step > GScalar(0.0))
+    {
+        const Vector3d margin(static_cast<double>(m_vertex_grid_step));
+
+        for (size_t i = 0; i < node_count; ++i)
+        {
+            NodeType& node = m_nodes[i];
+
+            if (node.is_interior())
+            {
+                AABB3d left_bbox = node.get_left_bbox();
+                AABB3d right_bbox = node.get_right_bbox();
+                left_bbox.grow(margin);
+                right_bbox.grow(margin);
+                node.set_left_bbox(left_bbox);
+                node.set_right_bbox(right_bbox);
+            }
+        }
+    }
+
+    // Make ray-box tests conservative so that they don't undo the watertightness of the triangle tests.
+    if (m_watertight)
+    {
+        for (size_t i = 0; i < node_count; ++i)
+        {
+            NodeType& node = m_nodes[i];
+
+            if (node.is_interior())
+            {
+                node.set_left_bbox(grow_node_bbox(node.get_left_bbox()));
+                node.set_right_bbox(grow_node_bbox(node.get_right_bbox()));
             }
         }
     }
 
     statistics.insert_percent("fat leaves", fat_leaf_count, leaf_count);
+    statistics.insert_percent("compressed leaves", compressed_leaf_count, leaf_count);
+}
+
+const std::uint8_t* TriangleTree::get_leaf_data(
+    const NodeType&                          node,
+    bool&                                    compressed) const
+{
+    const std::uint8_t* user_data = &node.get_user_data<std::uint8_t>();
+    std::uint32_t location = *reinterpret_cast<const std::uint32_t*>(user_data);
+
+    compressed = false;
+
+    if (m_vertex_grid_step > GScalar(0.0))
+    {
+        compressed = (location & CompressedLeafFlag) != 0;
+        location &= ~CompressedLeafFlag;
+        if (location == (InlineLeafData & ~CompressedLeafFlag))
+            location = InlineLeafData;
+    }
+
+    return
+        location == InlineLeafData
+            ? user_data + sizeof(std::uint32_t)     // triangles are stored in the leaf node
+            : &m_leaf_data[location];               // triangles are stored in the tree
+}
+
+std::uint32_t TriangleTree::compute_leaf_vis_flags(const NodeType& node) const
+{
+    const size_t triangle_count = node.get_item_count();
+
+    if (triangle_count == 0)
+        return 0;
+
+    bool compressed;
+    const std::uint8_t* leaf_data = get_leaf_data(node, compressed);
+
+    // Compressed leaves only hold triangles sharing the same visibility flags.
+    if (compressed)
+    {
+        const CompressedTriangleLeafReader leaf_reader(
+            leaf_data,
+            triangle_count,
+            m_vertex_grid_step);
+
+        return leaf_reader.get_vis_flags();
+    }
+
+    MemoryReader reader(leaf_data);
+    std::uint32_t vis_flags = 0;
+
+    for (size_t i = 0; i < triangle_count; ++i)
+    {
+        vis_flags |= reader.read<std::uint32_t>();
+
+        const std::uint32_t motion_segment_count = reader.read<std::uint32_t>();
+        reader +=
+            motion_segment_count == 0
+                ? sizeof(GTriangleType)
+                : (motion_segment_count + 1) * 3 * sizeof(GVector3);
+    }
+
+    return vis_flags;
+}
+
+std::uint32_t TriangleTree::compute_wide_node_vis_flags(const size_t wide_node_index)
+{
+    std::uint32_t vis_flags = 0;
+
+    for (size_t i = 0, e = m_wide_nodes[wide_node_index].get_child_count(); i < e; ++i)
+    {
+        const size_t child_index = m_wide_nodes[wide_node_index].get_child_index(i);
+        const std::uint32_t child_vis_flags =
+            m_wide_nodes[wide_node_index].is_leaf_child(i)
+                ? compute_leaf_vis_flags(m_nodes[child_index])
+                : compute_wide_node_vis_flags(child_index);
+
+        m_wide_nodes[wide_node_index].set_child_mask(i, child_vis_flags);
+        vis_flags |= child_vis_flags;
+    }
+
+    return vis_flags;
+}
+
+void TriangleTree::compute_vis_flags()
+{
+    if (!m_wide_nodes.empty())
+    {
+        m_vis_flags = compute_wide_node_vis_flags(0);
+        return;
+    }
+
+    m_vis_flags = 0;
+
+    for (const_each<NodeVectorType> i = m_nodes; i; ++i)
+    {
+        if (i->is_leaf())
+            m_vis_flags |= compute_leaf_vis_flags(*i);
+    }
 }
 
 namespace
@@ -1172,12 +1669,14 @@ namespace
 
             RENDERER_LOG_DEBUG(
                 "created intersection filter for object \"%s\" with " FMT_SIZE_T " material%s "
-                "(masks: %s, uvs: %s, filter key hash: 0x" FMT_UINT64_HEX ").",
+                "(masks: %s, uvs: %s, triangles requiring mask lookups: " FMT_SIZE_T ", "
+                "filter key hash: 0x" FMT_UINT64_HEX ").",
                 filter_key.m_object->get_path().c_str(),
                 filter_key.m_materials.size(),
                 filter_key.m_materials.size() > 1 ? "s" : "",
                 pretty_size(intersection_filter->get_masks_memory_size()).c_str(),
-                pretty_size(intersection_filter->get_masks_memory_size()).c_str(),
+                pretty_size(intersection_filter->get_uv_memory_size()).c_str(),
+                intersection_filter->get_partially_transparent_triangle_count(),
                 filter_key_hash);
 
             // Store this intersection filter.
@@ -1307,6 +1806,126 @@ std::unique_ptr<TriangleTree> TriangleTreeFactory::create()
 }
 
 
+//
+// TriangleTreeMemoryBudget class implementation.
+//
+
+TriangleTreeMemoryBudget::TriangleTreeMemoryBudget(const size_t max_size)
+  : m_max_size(max_size)
+  , m_size(0)
+  , m_release_count(0)
+{
+}
+
+void TriangleTreeMemoryBudget::set_max_size(const size_t max_size)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_max_size = max_size;
+}
+
+void TriangleTreeMemoryBudget::insert(Lazy<TriangleTree>* tree, const size_t size)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    remove_no_lock(tree);
+
+    m_trees.push_back(std::make_pair(tree, size));
+    m_size += size;
+
+    if (m_max_size == 0)
+        return;
+
+    // Release the oldest trees until we're back within budget. The caller is building
+    // the last tree of the list while holding its lock, so there is no point trying it.
+    // Trees that are locked or accessed by another thread are skipped rather than waited
+    // for: this never blocks and thus cannot deadlock with threads building other trees.
+    TreeList::iterator i = m_trees.begin();
+    while (m_size > m_max_size && i->first != tree)
+    {
+        if (i->first->try_release_object())
+        {
+            m_size -= i->second;
+            ++m_release_count;
+            i = m_trees.erase(i);
+        }
+        else ++i;
+    }
+}
+
+void TriangleTreeMemoryBudget::remove(const Lazy<TriangleTree>* tree)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    remove_no_lock(tree);
+}
+
+size_t TriangleTreeMemoryBudget::get_size() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_size;
+}
+
+size_t TriangleTreeMemoryBudget::get_release_count() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_release_count;
+}
+
+void TriangleTreeMemoryBudget::remove_no_lock(const Lazy<TriangleTree>* tree)
+{
+    for (TreeList::iterator i = m_trees.begin(), e = m_trees.end(); i != e; ++i)
+    {
+        if (i->first == tree)
+        {
+            m_size -= i->second;
+            m_trees.erase(i);
+            return;
+        }
+    }
+}
+
+
+//
+// DeferredTriangleTreeFactory class implementation.
+//
+
+DeferredTriangleTreeFactory::DeferredTriangleTreeFactory(
+    const TriangleTree::Arguments&  arguments,
+    TriangleTreeMemoryBudget&       budget)
+  : m_arguments(arguments)
+  , m_budget(budget)
+  , m_tree(nullptr)
+  , m_enable_intersection_filters(false)
+{
+}
+
+DeferredTriangleTreeFactory::~DeferredTriangleTreeFactory()
+{
+    if (m_tree)
+        m_budget.remove(m_tree);
+}
+
+void DeferredTriangleTreeFactory::set_lazy_tree(Lazy<TriangleTree>* tree)
+{
+    m_tree = tree;
+}
+
+void DeferredTriangleTreeFactory::set_enable_intersection_filters(const bool enable)
+{
+    m_enable_intersection_filters = enable;
+}
+
+std::unique_ptr<TriangleTree> DeferredTriangleTreeFactory::create()
+{
+    std::unique_ptr<TriangleTree> tree(new TriangleTree(m_arguments));
+    tree->update_non_geometry(m_enable_intersection_filters);
+
+    if (m_tree)
+        m_budget.insert(m_tree, tree->get_memory_size());
+
+    return tree;
+}
+
+
 //
 // Utility class to convert a triangle to the desired precision if necessary,
 // but avoid any work (in particular, no copy) if the source triangle already
@@ -1342,6 +1961,26 @@ namespace
     typedef TriangleReaderImpl<
         sizeof(GTriangleType::ValueType) == sizeof(TriangleType::ValueType)
     > TriangleReader;
+
+    // Intersect a triangle with the watertight intersector, returning the hit in double precision.
+    inline bool intersect_watertight(
+        const GWatertightTriangleType&      triangle,
+        const WatertightRay<GScalar>&       ray,
+        double&                             t,
+        double&                             u,
+        double&                             v)
+    {
+        GScalar gt, gu, gv;
+
+        if (!triangle.intersect(ray, gt, gu, gv))
+            return false;
+
+        t = static_cast<double>(gt);
+        u = static_cast<double>(gu);
+        v = static_cast<double>(gv);
+
+        return true;
+    }
 }
 
 
@@ -1349,6 +1988,31 @@ namespace
 // TriangleLeafVisitor class implementation.
 //
 
+inline bool TriangleLeafVisitor::accept_hit(
+    const size_t                            triangle_index,
+    const double                            u,
+    const double                            v) const
+{
+    if (!m_has_intersection_filters && m_object_instance_index == AnyObjectInstance)
+        return true;
+
+    const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
+    const size_t object_instance_index = triangle_key.get_object_instance_index();
+
+    // Ignore triangles of other object instances if the visitor is restricted to one.
+    if (m_object_instance_index != AnyObjectInstance && object_instance_index != m_object_instance_index)
+        return false;
+
+    if (m_has_intersection_filters)
+    {
+        const IntersectionFilter* filter = m_tree.m_intersection_filters[object_instance_index];
+        if (filter && !filter->accept(triangle_key, u, v))
+            return false;
+    }
+
+    return true;
+}
+
 bool TriangleLeafVisitor::visit(
     const TriangleTree::NodeType&           node,
     const Ray3d&                            ray,
@@ -1360,12 +2024,83 @@ bool TriangleLeafVisitor::visit(
     )
 {
     // Retrieve the pointer to the data of this leaf.
-    const std::uint8_t* user_data = &node.get_user_data<std::uint8_t>();
-    const std::uint32_t leaf_data_index = *reinterpret_cast<const std::uint32_t*>(user_data);
-    const std::uint8_t* leaf_data =
-        leaf_data_index == ~std::uint32_t(0)
-            ? user_data + sizeof(std::uint32_t)         // triangles are stored in the leaf node
-            : &m_tree.m_leaf_data[leaf_data_index];     // triangles are stored in the tree
+    bool compressed;
+    const std::uint8_t* leaf_data = m_tree.get_leaf_data(node, compressed);
+
+    // Prepare the ray for the watertight intersector.
+    WatertightRay<GScalar> watertight_ray;
+    if (m_tree.m_watertight)
+        watertight_ray = WatertightRay<GScalar>(ray);
+
+    if (compressed)
+    {
+        const CompressedTriangleLeafReader leaf_reader(
+            leaf_data,
+            node.get_item_count(),
+            m_tree.m_vertex_grid_step);
+
+        // Check visibility flags, shared by all triangles of the leaf.
+        if (leaf_reader.get_vis_flags() & m_shading_point.m_ray.m_flags)
+        {
+            // Sequentially intersect all triangles of the leaf.
+            for (size_t i = 0, triangle_count = node.get_item_count(); i < triangle_count; ++i)
+            {
+                FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+                if (m_tree.m_watertight)
+                {
+                    // Decode and intersect the triangle.
+                    const GWatertightTriangleType triangle = leaf_reader.read_watertight_triangle(i);
+                    const size_t triangle_index = node.get_item_index() + i;
+
+                    double t, u, v;
+                    if (intersect_watertight(triangle, watertight_ray, t, u, v))
+                    {
+                        // Optionally filter intersections.
+                        if (!accept_hit(triangle_index, u, v))
+                            continue;
+
+                        m_interpolated_triangle = GTriangleType(triangle.m_v0, triangle.m_v1, triangle.m_v2);
+                        m_hit_triangle = &m_interpolated_triangle;
+                        m_hit_triangle_index = triangle_index;
+                        m_shading_point.m_ray.m_tmax = t;
+                        m_shading_point.m_bary[0] = static_cast<float>(u);
+                        m_shading_point.m_bary[1] = static_cast<float>(v);
+                        watertight_ray.m_tmax = static_cast<GScalar>(t);
+                    }
+
+                    continue;
+                }
+
+                // Decode the triangle and convert it to the right format if necessary.
+                const GTriangleType triangle = leaf_reader.read_triangle(i);
+                const TriangleReader triangle_reader(triangle);
+
+                // Intersect the triangle.
+                double t, u, v;
+                if (triangle_reader.m_triangle.intersect(ray, t, u, v))
+                {
+                    const size_t triangle_index = node.get_item_index() + i;
+
+                    // Optionally filter intersections.
+                    if (!accept_hit(triangle_index, u, v))
+                        continue;
+
+                    m_interpolated_triangle = triangle;
+                    m_hit_triangle = &m_interpolated_triangle;
+                    m_hit_triangle_index = triangle_index;
+                    m_shading_point.m_ray.m_tmax = t;
+                    m_shading_point.m_bary[0] = static_cast<float>(u);
+                    m_shading_point.m_bary[1] = static_cast<float>(v);
+                }
+            }
+        }
+
+        // Continue traversal.
+        distance = m_shading_point.m_ray.m_tmax;
+        return true;
+    }
+
     MemoryReader reader(leaf_data);
 
     // Sequentially intersect all triangles of the leaf.
@@ -1392,6 +2127,30 @@ bool TriangleLeafVisitor::visit(
                 continue;
             }
 
+            if (m_tree.m_watertight)
+            {
+                // Read and intersect the triangle.
+                const GWatertightTriangleType& triangle = reader.read<GWatertightTriangleType>();
+
+                double t, u, v;
+                if (intersect_watertight(triangle, watertight_ray, t, u, v))
+                {
+                    // Optionally filter intersections.
+                    if (!accept_hit(triangle_index, u, v))
+                        continue;
+
+                    m_interpolated_triangle = GTriangleType(triangle.m_v0, triangle.m_v1, triangle.m_v2);
+                    m_hit_triangle = &m_interpolated_triangle;
+                    m_hit_triangle_index = triangle_index;
+                    m_shading_point.m_ray.m_tmax = t;
+                    m_shading_point.m_bary[0] = static_cast<float>(u);
+                    m_shading_point.m_bary[1] = static_cast<float>(v);
+                    watertight_ray.m_tmax = static_cast<GScalar>(t);
+                }
+
+                continue;
+            }
+
             // Read the triangle, converting it to the right format if necessary.
             const GTriangleType& triangle = reader.read<GTriangleType>();
             const TriangleReader triangle_reader(triangle);
@@ -1401,14 +2160,8 @@ bool TriangleLeafVisitor::visit(
             if (triangle_reader.m_triangle.intersect(ray, t, u, v))
             {
                 // Optionally filter intersections.
-                if (m_has_intersection_filters)
-                {
-                    const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
-                    const IntersectionFilter* filter =
-                        m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
-                    if (filter && !filter->accept(triangle_key, u, v))
-                        continue;
-                }
+                if (!accept_hit(triangle_index, u, v))
+                    continue;
 
                 m_hit_triangle = &triangle;
                 m_hit_triangle_index = triangle_index;
@@ -1453,17 +2206,15 @@ bool TriangleLeafVisitor::visit(
 
             // Intersect the triangle.
             double t, u, v;
-            if (reader.m_triangle.intersect(ray, t, u, v))
+            const bool hit =
+                m_tree.m_watertight
+                    ? intersect_watertight(GWatertightTriangleType(v0, v1, v2), watertight_ray, t, u, v)
+                    : reader.m_triangle.intersect(ray, t, u, v);
+            if (hit)
             {
                 // Optionally filter intersections.
-                if (m_has_intersection_filters)
-                {
-                    const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
-                    const IntersectionFilter* filter =
-                        m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
-                    if (filter && !filter->accept(triangle_key, u, v))
-                        continue;
-                }
+                if (!accept_hit(triangle_index, u, v))
+                    continue;
 
                 m_interpolated_triangle = triangle;
                 m_hit_triangle = &m_interpolated_triangle;
@@ -1471,6 +2222,7 @@ bool TriangleLeafVisitor::visit(
                 m_shading_point.m_ray.m_tmax = t;
                 m_shading_point.m_bary[0] = static_cast<float>(u);
                 m_shading_point.m_bary[1] = static_cast<float>(v);
+                watertight_ray.m_tmax = static_cast<GScalar>(t);
             }
         }
     }
@@ -1514,12 +2266,64 @@ bool TriangleLeafProbeVisitor::visit(
     )
 {
     // Retrieve the pointer to the data of this leaf.
-    const std::uint8_t* user_data = &node.get_user_data<std::uint8_t>();
-    const std::uint32_t leaf_data_index = *reinterpret_cast<const std::uint32_t*>(user_data);
-    const std::uint8_t* leaf_data =
-        leaf_data_index == ~std::uint32_t(0)
-            ? user_data + sizeof(std::uint32_t)         // triangles are stored in the leaf node
-            : &m_tree.m_leaf_data[leaf_data_index];     // triangles are stored in the tree
+    bool compressed;
+    const std::uint8_t* leaf_data = m_tree.get_leaf_data(node, compressed);
+
+    // Prepare the ray for the watertight intersector.
+    WatertightRay<GScalar> watertight_ray;
+    if (m_tree.m_watertight)
+        watertight_ray = WatertightRay<GScalar>(ray);
+
+    if (compressed)
+    {
+        const CompressedTriangleLeafReader leaf_reader(
+            leaf_data,
+            node.get_item_count(),
+            m_tree.m_vertex_grid_step);
+
+        // Check visibility flags, shared by all triangles of the leaf.
+        if (leaf_reader.get_vis_flags() & m_ray_flags)
+        {
+            // Sequentially intersect triangles until a hit is found.
+            for (size_t i = 0, triangle_count = node.get_item_count(); i < triangle_count; ++i)
+            {
+                FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+                if (m_tree.m_watertight)
+                {
+                    // Decode and intersect the triangle.
+                    const GWatertightTriangleType triangle = leaf_reader.read_watertight_triangle(i);
+                    if (triangle.intersect(watertight_ray))
+                    {
+                        m_hit = true;
+                        m_has_hit_triangle = true;
+                        m_hit_triangle = TriangleType(Vector3d(triangle.m_v0), Vector3d(triangle.m_v1), Vector3d(triangle.m_v2));
+                        return false;
+                    }
+
+                    continue;
+                }
+
+                // Decode the triangle and convert it to the right format if necessary.
+                const GTriangleType triangle = leaf_reader.read_triangle(i);
+                const TriangleReader triangle_reader(triangle);
+
+                // Intersect the triangle.
+                if (triangle_reader.m_triangle.intersect(ray))
+                {
+                    m_hit = true;
+                    m_has_hit_triangle = true;
+                    m_hit_triangle = triangle_reader.m_triangle;
+                    return false;
+                }
+            }
+        }
+
+        // Continue traversal.
+        distance = ray.m_tmax;
+        return true;
+    }
+
     MemoryReader reader(leaf_data);
 
     // Sequentially intersect triangles until a hit is found.
@@ -1543,6 +2347,21 @@ bool TriangleLeafProbeVisitor::visit(
                 continue;
             }
 
+            if (m_tree.m_watertight)
+            {
+                // Read and intersect the triangle.
+                const GWatertightTriangleType& triangle = reader.read<GWatertightTriangleType>();
+                if (triangle.intersect(watertight_ray))
+                {
+                    m_hit = true;
+                    m_has_hit_triangle = true;
+                    m_hit_triangle = TriangleType(Vector3d(triangle.m_v0), Vector3d(triangle.m_v1), Vector3d(triangle.m_v2));
+                    return false;
+                }
+
+                continue;
+            }
+
             // Read the triangle, converting it to the right format if necessary.
             const GTriangleType& triangle = reader.read<GTriangleType>();
             const TriangleReader triangle_reader(triangle);
@@ -1551,6 +2370,8 @@ bool TriangleLeafProbeVisitor::visit(
             if (triangle_reader.m_triangle.intersect(ray))
             {
                 m_hit = true;
+                m_has_hit_triangle = true;
+                m_hit_triangle = triangle_reader.m_triangle;
                 return false;
             }
         }
@@ -1581,12 +2402,12 @@ bool TriangleLeafProbeVisitor::visit(
             v1 += reader.read<GVector3>() * frac;
             v2 += reader.read<GVector3>() * frac;
 
-            // Build the triangle and convert it to the right format if necessary.
-            const GTriangleType triangle(v0, v1, v2);
-            const TriangleReader triangle_reader(triangle);
-
             // Intersect the triangle.
-            if (triangle_reader.m_triangle.intersect(ray))
+            const bool hit =
+                m_tree.m_watertight
+                    ? GWatertightTriangleType(v0, v1, v2).intersect(watertight_ray)
+                    : TriangleReader(GTriangleType(v0, v1, v2)).m_triangle.intersect(ray);
+            if (hit)
             {
                 m_hit = true;
                 return false;
@@ -1602,4 +2423,46 @@ bool TriangleLeafProbeVisitor::visit(
     return true;
 }
 
+
+//
+// TriangleLeafPacketProbeVisitor class implementation.
+//
+
+void TriangleLeafPacketProbeVisitor::visit(
+    const TriangleTree::NodeType&           node,
+    const std::uint32_t                     ray_mask,
+    RayPacketType&                          packet
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , bvh::TraversalStatistics&             stats
+#endif
+    )
+{
+    for (size_t i = 0; i < ProbeRayPacketSize; ++i)
+    {
+        const std::uint32_t ray_bit = std::uint32_t(1) << i;
+        if (!(ray_mask & ray_bit))
+            continue;
+
+        // Intersect the triangles of the leaf with this ray.
+        TriangleLeafProbeVisitor visitor(m_tree, m_ray_times[i], m_ray_flags[i]);
+        double distance;
+        visitor.visit(
+            node,
+            *packet.m_rays[i],
+            *packet.m_ray_infos[i],
+            distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+
+        // Retire the ray from the packet if it hit a triangle.
+        if (visitor.hit())
+        {
+            m_hits |= ray_bit;
+            packet.m_active &= ~ray_bit;
+        }
+    }
+}
+
 }   // namespace renderer
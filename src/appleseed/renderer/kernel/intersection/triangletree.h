@@ -43,18 +43,24 @@
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
 #include "foundation/math/ray.h"
+#include "foundation/memory/alignedallocator.h"
+#include "foundation/memory/memorytracker.h"
 #include "foundation/memory/poolallocator.h"
+#include "foundation/platform/thread.h"
 #include "foundation/utility/lazy.h"
 #include "foundation/utility/uid.h"
 
 // Standard headers.
 #include <cstddef>
 #include <cstdint>
+#include <list>
 #include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 // Forward declarations.
+namespace foundation    { class MurmurHash; }
 namespace foundation    { class Statistics; }
 namespace renderer      { class Assembly; }
 namespace renderer      { class IntersectionFilter; }
@@ -109,6 +115,17 @@ class TriangleTree
     size_t get_static_triangle_count() const;
     size_t get_moving_triangle_count() const;
 
+    // Wide nodes, only built for trees without motion.
+    typedef foundation::AlignedVector<
+        foundation::bvh::WideNode<foundation::AABB3d, TriangleTreeWideNodeWidth>
+    > WideNodeVector;
+    const WideNodeVector& get_wide_nodes() const;
+
+    // Return the union of the visibility flags of all triangles of the tree.
+    // The children of wide nodes carry the visibility flags of their subtree
+    // as user masks, so that rays skip subtrees that are invisible to them.
+    std::uint32_t get_vis_flags() const;
+
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
 
@@ -122,11 +139,18 @@ class TriangleTree
     size_t                                      m_moving_triangle_count;
 
     std::vector<TriangleKey>                    m_triangle_keys;
-    std::vector<std::uint8_t>                   m_leaf_data;
+    std::vector<std::uint8_t, foundation::AlignedAllocator<std::uint8_t>> m_leaf_data;
+    GScalar                                     m_vertex_grid_step;     // zero if the tree has no compressed leaves
+    bool                                        m_watertight;           // use the single-precision watertight intersector
+
+    WideNodeVector                              m_wide_nodes;
+    std::uint32_t                               m_vis_flags;
 
     IntersectionFilterRepository                m_intersection_filters_repository;
     std::vector<const IntersectionFilter*>      m_intersection_filters;
 
+    foundation::TrackedMemory                   m_tracked_memory;
+
     void build_bvh(
         const ParamArray&                       params,
         const double                            time,
@@ -150,8 +174,28 @@ class TriangleTree
         const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
         const std::vector<GVector3>&            triangle_vertices,
         const std::vector<TriangleKey>&         triangle_keys,
+        const bool                              compress_leaves,
         foundation::Statistics&                 statistics);
 
+    // Persistent cache of built trees, keyed by a hash of the geometry and of the build settings.
+    foundation::MurmurHash compute_cache_key(
+        const ParamArray&                       params,
+        const double                            time,
+        const bool                              save_memory) const;
+    bool load_from_cache(const std::string& filepath);
+    void save_to_cache(const std::string& filepath) const;
+
+    // Return the triangles of a given leaf node and whether they are compressed.
+    const std::uint8_t* get_leaf_data(
+        const NodeType&                         node,
+        bool&                                   compressed) const;
+
+    // Compute the visibility flags of a leaf node, and of a wide node subtree
+    // while storing the visibility flags of its children as their user masks.
+    std::uint32_t compute_leaf_vis_flags(const NodeType& node) const;
+    std::uint32_t compute_wide_node_vis_flags(const size_t wide_node_index);
+    void compute_vis_flags();
+
     void update_intersection_filters();
     void delete_intersection_filters();
 };
@@ -177,6 +221,83 @@ class TriangleTreeFactory
 };
 
 
+//
+// A memory budget for triangle trees built on demand.
+//
+// Once the trees accounted for by the budget use more memory than allowed, the oldest
+// ones that are not currently accessed are released. Trees used by the rendering threads
+// are pinned by their access caches, so the released trees are the least recently used
+// ones. A released tree is built again the next time a ray enters it.
+//
+
+class TriangleTreeMemoryBudget
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. A maximum size of 0 means that the budget is unlimited.
+    explicit TriangleTreeMemoryBudget(const size_t max_size = 0);
+
+    // Set the maximum size (in bytes) of the trees accounted for by the budget.
+    void set_max_size(const size_t max_size);
+
+    // Account for a tree that was just built, releasing older trees if necessary.
+    void insert(foundation::Lazy<TriangleTree>* tree, const size_t size);
+
+    // Stop accounting for a tree.
+    void remove(const foundation::Lazy<TriangleTree>* tree);
+
+    // Return the size (in bytes) of the trees accounted for by the budget.
+    size_t get_size() const;
+
+    // Return the number of trees released so far.
+    size_t get_release_count() const;
+
+  private:
+    typedef std::list<std::pair<foundation::Lazy<TriangleTree>*, size_t>> TreeList;
+
+    mutable boost::mutex    m_mutex;
+    size_t                  m_max_size;
+    size_t                  m_size;
+    size_t                  m_release_count;
+    TreeList                m_trees;            // in build order
+
+    void remove_no_lock(const foundation::Lazy<TriangleTree>* tree);
+};
+
+
+//
+// Factory for triangle trees built on demand, the first time a ray enters them.
+//
+
+class DeferredTriangleTreeFactory
+  : public foundation::ILazyFactory<TriangleTree>
+{
+  public:
+    // Constructor.
+    DeferredTriangleTreeFactory(
+        const TriangleTree::Arguments& arguments,
+        TriangleTreeMemoryBudget&      budget);
+
+    // Destructor.
+    ~DeferredTriangleTreeFactory() override;
+
+    // Bind the factory to the lazy tree it creates. Must be called before the tree is accessed.
+    void set_lazy_tree(foundation::Lazy<TriangleTree>* tree);
+
+    // Set whether intersection filters are enabled on the trees created by this factory.
+    void set_enable_intersection_filters(const bool enable);
+
+    // Create the triangle tree.
+    std::unique_ptr<TriangleTree> create() override;
+
+  private:
+    TriangleTree::Arguments             m_arguments;
+    TriangleTreeMemoryBudget&           m_budget;
+    foundation::Lazy<TriangleTree>*     m_tree;
+    bool                                m_enable_intersection_filters;
+};
+
+
 //
 // Some additional types.
 //
@@ -206,10 +327,15 @@ class TriangleLeafVisitor
   : public foundation::NonCopyable
 {
   public:
-    // Constructor.
+    // Value of object_instance_index to consider triangles of all object instances.
+    static const size_t AnyObjectInstance = ~size_t(0);
+
+    // Constructor. If object_instance_index is not AnyObjectInstance, only triangles
+    // of that object instance of the assembly are considered.
     TriangleLeafVisitor(
         const TriangleTree&                     tree,
-        ShadingPoint&                           shading_point);
+        ShadingPoint&                           shading_point,
+        const size_t                            object_instance_index = AnyObjectInstance);
 
     // Visit a leaf.
     bool visit(
@@ -229,9 +355,16 @@ class TriangleLeafVisitor
     const TriangleTree&     m_tree;
     const bool              m_has_intersection_filters;
     ShadingPoint&           m_shading_point;
+    const size_t            m_object_instance_index;
     GTriangleType           m_interpolated_triangle;
     const GTriangleType*    m_hit_triangle;
     size_t                  m_hit_triangle_index;
+
+    // Return true if a hit on a given triangle should be recorded.
+    bool accept_hit(
+        const size_t                            triangle_index,
+        const double                            u,
+        const double                            v) const;
 };
 
 
@@ -261,11 +394,58 @@ class TriangleLeafProbeVisitor
 #endif
         );
 
+    // Return true if the ray hit a static triangle, in which case the triangle
+    // (in assembly space) can be retrieved with get_hit_triangle().
+    bool has_hit_triangle() const;
+    const TriangleType& get_hit_triangle() const;
+
   private:
     const TriangleTree&         m_tree;
     const double                m_ray_time;
     const VisibilityFlags::Type m_ray_flags;
     const bool                  m_has_intersection_filters;
+    bool                        m_has_hit_triangle;
+    TriangleType                m_hit_triangle;
+};
+
+
+//
+// Triangle leaf visitor for packets of probe rays, used in conjunction with
+// foundation::bvh::PacketIntersector. A ray leaves the packet as soon as it
+// hits a triangle.
+//
+
+class TriangleLeafPacketProbeVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    typedef foundation::bvh::RayPacket<foundation::Ray3d, ProbeRayPacketSize> RayPacketType;
+
+    // Constructor. 'ray_times' and 'ray_flags' hold the normalized time and
+    // the visibility flags of each ray of the packet.
+    TriangleLeafPacketProbeVisitor(
+        const TriangleTree&                     tree,
+        const double*                           ray_times,
+        const VisibilityFlags::Type*            ray_flags);
+
+    // Visit a leaf.
+    void visit(
+        const TriangleTree::NodeType&           node,
+        const std::uint32_t                     ray_mask,
+        RayPacketType&                          packet
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        );
+
+    // Return the bit mask of the rays that hit a triangle.
+    std::uint32_t get_hits() const;
+
+  private:
+    const TriangleTree&             m_tree;
+    const double*                   m_ray_times;
+    const VisibilityFlags::Type*    m_ray_flags;
+    std::uint32_t                   m_hits;
 };
 
 
@@ -287,6 +467,30 @@ typedef foundation::bvh::Intersector<
     TriangleTreeStackSize
 > TriangleTreeProbeIntersector;
 
+typedef foundation::bvh::WideIntersector<
+    TriangleTree,
+    TriangleTree::WideNodeVector,
+    TriangleLeafVisitor,
+    foundation::Ray3d,
+    TriangleTreeStackSize
+> TriangleTreeWideIntersector;
+
+typedef foundation::bvh::WideIntersector<
+    TriangleTree,
+    TriangleTree::WideNodeVector,
+    TriangleLeafProbeVisitor,
+    foundation::Ray3d,
+    TriangleTreeStackSize
+> TriangleTreeWideProbeIntersector;
+
+typedef foundation::bvh::PacketIntersector<
+    TriangleTree,
+    TriangleLeafPacketProbeVisitor,
+    foundation::Ray3d,
+    ProbeRayPacketSize,
+    TriangleTreeStackSize
+> TriangleTreePacketProbeIntersector;
+
 
 //
 // TriangleTree class implementation.
@@ -302,6 +506,16 @@ inline size_t TriangleTree::get_moving_triangle_count() const
     return m_moving_triangle_count;
 }
 
+inline const TriangleTree::WideNodeVector& TriangleTree::get_wide_nodes() const
+{
+    return m_wide_nodes;
+}
+
+inline std::uint32_t TriangleTree::get_vis_flags() const
+{
+    return m_vis_flags;
+}
+
 
 //
 // TriangleLeafVisitor class implementation.
@@ -309,10 +523,12 @@ inline size_t TriangleTree::get_moving_triangle_count() const
 
 inline TriangleLeafVisitor::TriangleLeafVisitor(
     const TriangleTree&         tree,
-    ShadingPoint&               shading_point)
+    ShadingPoint&               shading_point,
+    const size_t                object_instance_index)
   : m_tree(tree)
   , m_has_intersection_filters(!tree.m_intersection_filters.empty())
   , m_shading_point(shading_point)
+  , m_object_instance_index(object_instance_index)
   , m_hit_triangle(nullptr)
 {
 }
@@ -330,7 +546,40 @@ inline TriangleLeafProbeVisitor::TriangleLeafProbeVisitor(
   , m_ray_time(ray_time)
   , m_ray_flags(ray_flags)
   , m_has_intersection_filters(!tree.m_intersection_filters.empty())
+  , m_has_hit_triangle(false)
+{
+}
+
+inline bool TriangleLeafProbeVisitor::has_hit_triangle() const
+{
+    return m_has_hit_triangle;
+}
+
+inline const TriangleType& TriangleLeafProbeVisitor::get_hit_triangle() const
+{
+    assert(m_has_hit_triangle);
+    return m_hit_triangle;
+}
+
+
+//
+// TriangleLeafPacketProbeVisitor class implementation.
+//
+
+inline TriangleLeafPacketProbeVisitor::TriangleLeafPacketProbeVisitor(
+    const TriangleTree&             tree,
+    const double*                   ray_times,
+    const VisibilityFlags::Type*    ray_flags)
+  : m_tree(tree)
+  , m_ray_times(ray_times)
+  , m_ray_flags(ray_flags)
+  , m_hits(0)
+{
+}
+
+inline std::uint32_t TriangleLeafPacketProbeVisitor::get_hits() const
 {
+    return m_hits;
 }
 
 }   // namespace renderer
@@ -0,0 +1,158 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "adaptiverr.h"
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/radianceestimategrid.h"
+#include "renderer/kernel/shading/shadingcomponents.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    // Lower bound on survival probabilities, to protect against underestimated radiance.
+    const float MinSurvivalProbability = 0.05f;
+}
+
+
+//
+// AdaptiveRR class implementation.
+//
+
+AdaptiveRR::AdaptiveRR(
+    RadianceEstimateGrid&               grid,
+    const float                         window_size)
+  : m_grid(grid)
+  , m_window_low(2.0f / (1.0f + std::max(window_size, 1.0f)))
+  , m_path_radiance(nullptr)
+  , m_pixel_estimate(-1.0f)
+  , m_vertex_count(0)
+  , m_adaptive_decision_count(0)
+{
+}
+
+void AdaptiveRR::begin_path(const ShadingComponents& path_radiance)
+{
+    m_path_radiance = &path_radiance;
+    m_pixel_estimate = -1.0f;
+    m_vertex_count = 0;
+}
+
+void AdaptiveRR::end_path()
+{
+    assert(m_path_radiance);
+
+    const float path_radiance = average_value(m_path_radiance->m_beauty);
+
+    if (m_vertex_count > 0)
+    {
+        // The value of the whole path is a sample of the value of the pixel.
+        m_grid.record_pixel(m_vertices[0].m_point, path_radiance);
+
+        // The radiance gathered after a vertex, divided by the throughput up to that
+        // vertex, is the radiance that paths gather after reaching that vertex.
+        for (size_t i = 0; i < m_vertex_count; ++i)
+        {
+            const Vertex& vertex = m_vertices[i];
+
+            if (vertex.m_throughput > 0.0f)
+            {
+                m_grid.record_outgoing(
+                    vertex.m_point,
+                    std::max(path_radiance - vertex.m_radiance, 0.0f) / vertex.m_throughput);
+            }
+        }
+    }
+
+    m_path_radiance = nullptr;
+    m_vertex_count = 0;
+}
+
+bool AdaptiveRR::get_survival_probability(
+    const Vector3d&                     point,
+    const size_t                        path_length,
+    const Spectrum&                     throughput,
+    float&                              probability)
+{
+    // The pixel estimate is looked up where the camera path first hits the scene.
+    if (path_length == 1)
+    {
+        if (!m_grid.lookup_pixel(point, m_pixel_estimate))
+            m_pixel_estimate = -1.0f;
+
+        // Always extend camera paths.
+        probability = 1.0f;
+        return true;
+    }
+
+    if (m_pixel_estimate <= 0.0f)
+        return false;
+
+    float outgoing_radiance;
+    if (!m_grid.lookup_outgoing(point, outgoing_radiance))
+        return false;
+
+    ++m_adaptive_decision_count;
+
+    // Expected contribution of the path to its pixel, relative to the pixel value.
+    // The weight window is [low, s * low] with low = 2 / (1 + s), centered on 1.
+    const float weight = average_value(throughput) * outgoing_radiance / m_pixel_estimate;
+
+    probability =
+        weight < m_window_low
+            ? std::max(weight, MinSurvivalProbability)
+            : 1.0f;
+
+    return true;
+}
+
+void AdaptiveRR::add_vertex(
+    const Vector3d&                     point,
+    const Spectrum&                     throughput)
+{
+    assert(m_path_radiance);
+
+    if (m_vertex_count < MaxVertexCount)
+    {
+        Vertex& vertex = m_vertices[m_vertex_count++];
+        vertex.m_point = point;
+        vertex.m_throughput = average_value(throughput);
+        vertex.m_radiance = average_value(m_path_radiance->m_beauty);
+    }
+}
+
+}   // namespace renderer
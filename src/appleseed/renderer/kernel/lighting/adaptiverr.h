@@ -0,0 +1,126 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+
+// Forward declarations.
+namespace renderer  { class RadianceEstimateGrid; }
+namespace renderer  { class ShadingComponents; }
+
+namespace renderer
+{
+
+//
+// Adjoint-driven Russian Roulette state of the paths traced by a path tracer, one path at a time.
+//
+// The expected contribution of a path to its pixel is estimated at each surface vertex
+// as the path throughput times the radiance that paths learned to gather after that
+// vertex, relative to the value learned for the pixel. Paths whose expected contribution
+// falls below a weight window centered on the pixel value are terminated with a
+// probability that brings the weight of the survivors to the center of the window.
+// Paths above the window are not split since the path tracer follows a single path.
+//
+// Reference:
+//
+//   Adjoint-Driven Russian Roulette and Splitting in Light Transport Simulation
+//   Jiri Vorba, Jaroslav Krivanek
+//   ACM Transactions on Graphics (Proceedings of SIGGRAPH 2016)
+//
+
+class AdaptiveRR
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    AdaptiveRR(
+        RadianceEstimateGrid&               grid,
+        const float                         window_size);   // ratio between the upper and lower bounds of the weight window
+
+    // Begin a new path. `path_radiance` is the radiance accumulated by the path tracer.
+    void begin_path(const ShadingComponents& path_radiance);
+
+    // Record the radiance gathered by the path into the grid.
+    void end_path();
+
+    // Compute the probability of extending the path at a surface vertex, given the path
+    // throughput up to that vertex. Return false if no estimate is available.
+    bool get_survival_probability(
+        const foundation::Vector3d&         point,
+        const size_t                        path_length,
+        const Spectrum&                     throughput,
+        float&                              probability);
+
+    // Remember a surface vertex through which the path continues.
+    void add_vertex(
+        const foundation::Vector3d&         point,
+        const Spectrum&                     throughput);    // path throughput up to the vertex, after Russian Roulette
+
+    // Return the number of Russian Roulette decisions driven by the learned estimates.
+    std::uint64_t get_adaptive_decision_count() const;
+
+  private:
+    struct Vertex
+    {
+        foundation::Vector3d                m_point;
+        float                               m_throughput;
+        float                               m_radiance;     // path radiance when the vertex was added
+    };
+
+    enum { MaxVertexCount = 16 };
+
+    RadianceEstimateGrid&                   m_grid;
+    const float                             m_window_low;
+    const ShadingComponents*                m_path_radiance;
+    float                                   m_pixel_estimate;   // negative if unknown
+    Vertex                                  m_vertices[MaxVertexCount];
+    size_t                                  m_vertex_count;
+    std::uint64_t                           m_adaptive_decision_count;
+};
+
+
+//
+// AdaptiveRR class implementation.
+//
+
+inline std::uint64_t AdaptiveRR::get_adaptive_decision_count() const
+{
+    return m_adaptive_decision_count;
+}
+
+}   // namespace renderer
@@ -39,15 +39,28 @@
 #include "renderer/modeling/material/material.h"
 #include "renderer/modeling/scene/scene.h"
 
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+
 // Standard headers.
 #include <cassert>
+#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 using namespace foundation;
 
 namespace renderer
 {
 
+namespace
+{
+    // Beyond this number of light groups the light importance cache would use
+    // too much memory and is not built.
+    const size_t MaxLightGroupCount = 256;
+}
+
 //
 // BackwardLightSampler class implementation.
 //
@@ -78,6 +91,14 @@ Dictionary BackwardLightSampler::get_params_metadata()
                             .insert("label", "Light Tree")
                             .insert("help", "Lights organized in a BVH"))));
 
+    metadata.insert(
+        "enable_light_importance_cache",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Enable Light Importance Cache")
+            .insert("help", "Learn which lights are visible from each region of the scene and sample them more often (CDF light sampler only)"));
+
     metadata.merge(LightSamplerBase::get_params_metadata());
 
     return metadata;
@@ -87,6 +108,7 @@ BackwardLightSampler::BackwardLightSampler(
     const Scene&                        scene,
     const ParamArray&                   params)
   : LightSamplerBase(params)
+  , m_light_portals(scene)
 {
     // Read which sampling algorithm should be used.
     m_use_light_tree = params.get_optional<std::string>("algorithm", "cdf") == "lighttree";
@@ -122,6 +144,7 @@ BackwardLightSampler::BackwardLightSampler(
     m_non_physical_light_count = m_non_physical_lights.size();
 
     // Collect all light-emitting shapes.
+    std::vector<float> shape_probs;
     collect_emitting_shapes(
         scene.assembly_instances(),
         TransformSequence(),
@@ -148,14 +171,23 @@ BackwardLightSampler::BackwardLightSampler(
                 const float shape_importance = m_params.m_importance_sampling ? area : 1.0f;
                 const float shape_prob = shape_importance * importance_multiplier;
 
-                // Insert the light-emitting shape into the CDF.
-                m_emitting_shapes_cdf.insert(emitting_shape_index, shape_prob);
+                // Store the probability density until texture importances are known.
+                assert(shape_probs.size() == emitting_shape_index);
+                shape_probs.push_back(shape_prob);
 
                 // Accept this shape.
                 return true;
             }
         });
 
+    // Account for the variations of textured emission across emitting shapes.
+    if (m_use_light_tree || m_params.m_importance_sampling)
+        compute_texture_importances(scene);
+
+    // Insert the light-emitting shapes into the CDF.
+    for (size_t i = 0, e = shape_probs.size(); i < e; ++i)
+        m_emitting_shapes_cdf.insert(i, shape_probs[i] * m_emitting_shapes[i].get_texture_importance());
+
     // Build the hash table of emitting shapes.
     build_emitting_shape_hash_table();
 
@@ -195,6 +227,19 @@ BackwardLightSampler::BackwardLightSampler(
         plural(m_light_tree_lights.size() + m_emitting_shapes.size(), "light-tree compatible light").c_str(),
         pretty_int(m_emitting_shapes.size()).c_str(),
         plural(m_emitting_shapes.size(), "shape").c_str());
+
+    if (params.get_optional<bool>("enable_light_importance_cache", false))
+    {
+        if (m_use_light_tree)
+            RENDERER_LOG_WARNING("the light importance cache is not supported by the light tree, disabling it.");
+        else build_importance_cache(scene);
+    }
+}
+
+void BackwardLightSampler::refit_light_tree()
+{
+    if (m_light_tree)
+        m_light_tree->refit();
 }
 
 void BackwardLightSampler::sample_lightset(
@@ -214,6 +259,22 @@ void BackwardLightSampler::sample_lightset(
     }
     else
     {
+        if (m_importance_cache)
+        {
+            const size_t cell_index = m_importance_cache->get_cell_index(shading_point.get_point());
+
+            if (m_importance_cache->is_ready(cell_index))
+            {
+                // Importance cache sampling.
+                sample_importance_cache(
+                    time,
+                    s,
+                    cell_index,
+                    light_sample);
+                return;
+            }
+        }
+
         // CDF-based sampling.
         sample_emitting_shapes(
             time,
@@ -238,18 +299,132 @@ float BackwardLightSampler::evaluate_pdf(
 
     const EmittingShape* shape = *shape_ptr;
 
-    const float shape_probability =
-        m_use_light_tree
-            ? m_light_tree->evaluate_node_pdf(
+    float shape_probability;
+
+    if (m_use_light_tree)
+    {
+        shape_probability =
+            m_light_tree->evaluate_node_pdf(
                 surface_shading_point,
-                shape->m_light_tree_node_index)
-            : shape->evaluate_pdf_uniform();
+                shape->m_light_tree_node_index);
+    }
+    else
+    {
+        shape_probability = shape->evaluate_pdf_uniform();
+
+        if (m_importance_cache)
+        {
+            // The surface point must be looked up in the same cell as when sampling.
+            const size_t cell_index = m_importance_cache->get_cell_index(surface_shading_point.get_point());
+
+            if (m_importance_cache->is_ready(cell_index))
+            {
+                const size_t shape_index = shape - &m_emitting_shapes[0];
+                shape_probability =
+                      m_importance_cache->evaluate(cell_index, m_shape_groups[shape_index])
+                    * m_shape_group_probs[shape_index]
+                    * shape->get_rcp_area();
+            }
+        }
+    }
 
     assert(shape_probability >= 0.0f);
 
     return shape_probability;
 }
 
+void BackwardLightSampler::record_lightset_sample(
+    const ShadingPoint&                 shading_point,
+    const LightSample&                  light_sample,
+    const float                         contribution) const
+{
+    if (!m_importance_cache || light_sample.m_shape == nullptr)
+        return;
+
+    const size_t shape_index = light_sample.m_shape - &m_emitting_shapes[0];
+    assert(shape_index < m_emitting_shapes.size());
+
+    m_importance_cache->record(
+        m_importance_cache->get_cell_index(shading_point.get_point()),
+        m_shape_groups[shape_index],
+        contribution);
+}
+
+void BackwardLightSampler::build_importance_cache(const Scene& scene)
+{
+    const size_t emitting_shape_count = m_emitting_shapes.size();
+
+    // Group emitting shapes per object instance.
+    std::map<std::pair<const AssemblyInstance*, size_t>, std::uint32_t> group_indices;
+    std::vector<float> group_probs;
+    m_shape_groups.resize(emitting_shape_count);
+
+    for (size_t i = 0; i < emitting_shape_count; ++i)
+    {
+        const EmittingShape& shape = m_emitting_shapes[i];
+
+        const auto result =
+            group_indices.insert(
+                std::make_pair(
+                    std::make_pair(shape.get_assembly_instance(), shape.get_object_instance_index()),
+                    static_cast<std::uint32_t>(group_probs.size())));
+
+        if (result.second)
+            group_probs.push_back(0.0f);
+
+        const std::uint32_t group_index = result.first->second;
+        m_shape_groups[i] = group_index;
+        group_probs[group_index] += shape.get_shape_prob();
+    }
+
+    const size_t group_count = group_probs.size();
+
+    if (group_count < 2 || group_count > MaxLightGroupCount)
+    {
+        RENDERER_LOG_WARNING(
+            "the light importance cache requires between 2 and %s light-emitting object instances, found %s, disabling it.",
+            pretty_uint(MaxLightGroupCount).c_str(),
+            pretty_uint(group_count).c_str());
+        m_shape_groups.clear();
+        return;
+    }
+
+    // Build the distribution of emitting shapes within each group.
+    std::vector<size_t> local_indices(emitting_shape_count);
+    m_group_cdfs.resize(group_count);
+
+    for (size_t i = 0; i < emitting_shape_count; ++i)
+    {
+        EmitterCDF& group_cdf = m_group_cdfs[m_shape_groups[i]];
+        local_indices[i] = group_cdf.size();
+        group_cdf.insert(i, m_emitting_shapes[i].get_shape_prob());
+    }
+
+    for (EmitterCDF& group_cdf : m_group_cdfs)
+    {
+        if (group_cdf.valid())
+            group_cdf.prepare();
+    }
+
+    m_shape_group_probs.resize(emitting_shape_count);
+
+    for (size_t i = 0; i < emitting_shape_count; ++i)
+    {
+        const EmitterCDF& group_cdf = m_group_cdfs[m_shape_groups[i]];
+        m_shape_group_probs[i] = group_cdf.valid() ? group_cdf[local_indices[i]].second : 0.0f;
+    }
+
+    m_importance_cache.reset(
+        new LightImportanceCache(
+            AABB3d(scene.compute_bbox()),
+            group_probs));
+
+    RENDERER_LOG_INFO(
+        "light importance cache enabled with %s light %s.",
+        pretty_uint(group_count).c_str(),
+        plural(group_count, "group").c_str());
+}
+
 void BackwardLightSampler::sample_light_tree(
     const ShadingRay::Time&             time,
     const Vector3f&                     s,
@@ -297,4 +472,26 @@ void BackwardLightSampler::sample_light_tree(
     assert(light_sample.m_probability > 0.0f);
 }
 
+void BackwardLightSampler::sample_importance_cache(
+    const ShadingRay::Time&             time,
+    const Vector3f&                     s,
+    const size_t                        cell_index,
+    LightSample&                        light_sample) const
+{
+    // Choose a light group using the learned distribution of the cell.
+    float s0 = s[0];
+    float group_prob;
+    const size_t group_index = m_importance_cache->sample(cell_index, s0, group_prob);
+
+    // Choose an emitting shape within the group using the default distribution.
+    const EmitterCDF::ItemWeightPair& result = m_group_cdfs[group_index].sample(s0);
+
+    sample_emitting_shape(
+        time,
+        Vector2f(s[1], s[2]),
+        result.first,
+        group_prob * result.second,
+        light_sample);
+}
+
 }   // namespace renderer
@@ -30,6 +30,8 @@
 #pragma once
 
 // appleseed.renderer headers.
+#include "renderer/kernel/lighting/lightimportancecache.h"
+#include "renderer/kernel/lighting/lightportals.h"
 #include "renderer/kernel/lighting/lightsamplerbase.h"
 #include "renderer/kernel/lighting/lighttree.h"
 #include "renderer/kernel/lighting/lighttypes.h"
@@ -40,6 +42,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -78,6 +81,16 @@ class BackwardLightSampler
     // Return true if the light set is not empty.
     bool has_lightset() const;
 
+    // Return true if light set samples are chosen with the help of a light importance cache.
+    bool has_importance_cache() const;
+
+    // Return the light portals through which the environment should be sampled.
+    const LightPortals& get_light_portals() const;
+
+    // Update the light tree after light intensities or transforms changed without
+    // rebuilding it. Does nothing if the light tree is not used.
+    void refit_light_tree();
+
     // Sample the light set.
     void sample_lightset(
         const ShadingRay::Time&             time,
@@ -92,16 +105,40 @@ class BackwardLightSampler
         const ShadingPoint&                 light_shading_point,
         const ShadingPoint&                 surface_shading_point) const;
 
+    // Record the contribution of a light set sample taken at a given shading point.
+    // The contribution must already be divided by the probability of the sample.
+    // Does nothing if the light importance cache is not used.
+    void record_lightset_sample(
+        const ShadingPoint&                 shading_point,
+        const LightSample&                  light_sample,
+        const float                         contribution) const;
+
   private:
     bool                                    m_use_light_tree;
     NonPhysicalLightVector                  m_light_tree_lights;
     std::unique_ptr<LightTree>              m_light_tree;
 
+    // Emitting shapes are grouped per object instance for the light importance cache.
+    std::unique_ptr<LightImportanceCache>   m_importance_cache;
+    std::vector<std::uint32_t>              m_shape_groups;         // group of each emitting shape
+    std::vector<float>                      m_shape_group_probs;    // probability of each emitting shape within its group
+    std::vector<EmitterCDF>                 m_group_cdfs;
+
+    LightPortals                            m_light_portals;
+
+    void build_importance_cache(const Scene& scene);
+
     void sample_light_tree(
         const ShadingRay::Time&             time,
         const foundation::Vector3f&         s,
         const ShadingPoint&                 shading_point,
         LightSample&                        light_sample) const;
+
+    void sample_importance_cache(
+        const ShadingRay::Time&             time,
+        const foundation::Vector3f&         s,
+        const size_t                        cell_index,
+        LightSample&                        light_sample) const;
 };
 
 
@@ -127,4 +164,14 @@ inline bool BackwardLightSampler::has_lightset() const
     return !m_emitting_shapes.empty() || !m_light_tree_lights.empty();
 }
 
+inline bool BackwardLightSampler::has_importance_cache() const
+{
+    return m_importance_cache != nullptr;
+}
+
+inline const LightPortals& BackwardLightSampler::get_light_portals() const
+{
+    return m_light_portals;
+}
+
 }   // namespace renderer
@@ -48,6 +48,7 @@
 
 // Standard headers.
 #include <cstdint>
+#include <vector>
 
 using namespace foundation;
 
@@ -74,20 +75,19 @@ namespace
         const BSDF*             m_bsdf;
         const void*             m_bsdf_data;
         Vector3d                m_dir_to_prev_vertex;
-        const BDPTVertex*       m_prev_vertex;
         Basis3f                 m_shading_basis;
         Spectrum                m_Le;
         ShadingPoint            m_shading_point;
         bool                    m_is_light_vertex;
 
-        float                   m_fwd_pdf;
-        float                   m_rev_pdf;
+        // Area densities cached once per subpath to evaluate MIS weights without walking the path.
+        float                   m_fwd_pdf;              // density of this vertex when sampled from its own subpath
+        float                   m_rev_pdf;              // density of this vertex when sampled from the next two vertices of its subpath
 
         BDPTVertex()
           : m_beta(0.0f)
           , m_bsdf(nullptr)
           , m_bsdf_data(nullptr)
-          , m_prev_vertex(nullptr)
           , m_Le(0.0f)
           , m_is_light_vertex(false)
           , m_fwd_pdf(0.0f)
@@ -139,6 +139,12 @@ namespace
             m_shutter_close_end_time = camera->get_shutter_close_end_time();
 
             m_num_max_vertices = m_params.m_max_bounces + 3;
+
+            // Lighting engines are per-thread: allocate subpath storage once and reuse it for every sample.
+            m_camera_vertices.resize(m_num_max_vertices - 1);
+            m_light_vertices.resize(m_num_max_vertices);
+            m_light_densities.resize(m_num_max_vertices + 1);
+            m_camera_densities.resize(m_num_max_vertices + 1);
         }
 
         void release() override
@@ -158,9 +164,8 @@ namespace
             ShadingComponents&          radiance,               // output radiance, in W.sr^-1.m^-2
             AOVComponents&              aov_components) override
         {
-            /// todo: use arena to alloc BDPTVertices instead
-            BDPTVertex* camera_vertices = new BDPTVertex[m_num_max_vertices - 1];
-            BDPTVertex* light_vertices = new BDPTVertex[m_num_max_vertices];
+            BDPTVertex* camera_vertices = m_camera_vertices.data();
+            BDPTVertex* light_vertices = m_light_vertices.data();
 
             size_t num_light_vertices = trace_light(sampling_context, shading_context, light_vertices);
             size_t num_camera_vertices = trace_camera(sampling_context, shading_context, shading_point, camera_vertices);
@@ -168,23 +173,46 @@ namespace
             assert(num_camera_vertices <= m_num_max_vertices - 1);
             assert(num_light_vertices <= m_num_max_vertices);
 
+            cache_light_densities(light_vertices, num_light_vertices);
+            cache_camera_densities(camera_vertices, num_camera_vertices);
+
+            // Evaluate all strategies, deferring the visibility tests of the connections.
+            m_connection_origins.clear();
+            m_connection_targets.clear();
+            m_connection_values.clear();
+
             for (size_t s = 0; s < num_light_vertices + 1; s++)
             {
                 for (size_t t = 2; t < num_camera_vertices + 2; t++)
                 {
                     if (s + t <= m_num_max_vertices)
-                        connect(shading_context, shading_point, light_vertices, camera_vertices, s, t, radiance);
+                        connect(light_vertices, camera_vertices, s, t, radiance);
                 }
             }
 
-            delete[] camera_vertices;
-            delete[] light_vertices;
+            // Trace the shadow rays of all connections as a single batch.
+            const size_t connection_count = m_connection_values.size();
+            if (connection_count > 0)
+            {
+                m_connection_transmissions.resize(connection_count);
+
+                shading_context.get_tracer().trace_between_simple(
+                    shading_context,
+                    connection_count,
+                    m_connection_origins.data(),
+                    m_connection_targets.data(),
+                    shading_point.get_ray().m_time,
+                    VisibilityFlags::ShadowRay,
+                    shading_point.get_ray().m_depth,
+                    m_connection_transmissions.data());
+
+                for (size_t i = 0; i < connection_count; ++i)
+                    radiance.m_beauty += m_connection_values[i] * m_connection_transmissions[i];
+            }
         }
 
-        // todo: use an output parameter instead of returning a spectrum.
-        Spectrum compute_geometry_term(
-            const ShadingContext&       shading_context,
-            const ShadingPoint&         shading_point,
+        // Return the geometry term between two vertices, without the visibility term.
+        static float compute_geometry_term(
             const BDPTVertex&           a,
             const BDPTVertex&           b)
         {
@@ -196,165 +224,245 @@ namespace
             const double cos1 = std::max(-dot(normalized_v, b.m_geometric_normal), 0.0);
             const double cos2 = std::max(dot(normalized_v, a.m_geometric_normal), 0.0);
 
-            Spectrum result(0.0f);
+            return static_cast<float>(cos1 * cos2 / dist2);
+        }
+
+        // Return the area density of 'to' when sampled by the BSDF of 'from'.
+        static float compute_bsdf_density(
+            const BDPTVertex&           from,
+            const Vector3f&             incoming,
+            const BDPTVertex&           to,
+            const bool                  adjoint)
+        {
+            if (from.m_bsdf == nullptr || from.m_bsdf_data == nullptr)
+                return 0.0f;
+
+            BSDF::LocalGeometry local_geometry;
+            local_geometry.m_shading_point = &from.m_shading_point;
+            local_geometry.m_geometric_normal = Vector3f(from.m_geometric_normal);
+            local_geometry.m_shading_basis = from.m_shading_basis;
+
+            const float pdf_w =
+                from.m_bsdf->evaluate_pdf(
+                    from.m_bsdf_data,
+                    adjoint,
+                    local_geometry,
+                    static_cast<Vector3f>(normalize(to.m_position - from.m_position)),
+                    incoming,
+                    ScatteringMode::All);
+
+            const float pdf_a = static_cast<float>(from.convert_density(pdf_w, to));
+            assert(pdf_a >= 0.0f);
+            return pdf_a;
+        }
+
+        // Return the area density of the i'th vertex of a full path, counted from the light,
+        // given that vertex and the two vertices before it.
+        /// todo: precompute pdf of light sample in the non diffuse case.
+        float compute_light_side_density(
+            const size_t                i,
+            const BDPTVertex&           vertex,
+            const BDPTVertex*           prev_vertex,
+            const BDPTVertex*           prev2_vertex) const
+        {
+            if (i == 1) // the vertex on light source
+                return vertex.m_is_light_vertex ? m_light_sampler.evaluate_pdf(vertex.m_shading_point) : 0.0f;
 
-            // do the visibility test
-            if (cos1 > 0.0 && cos2 > 0.0)
+            if (i == 2) // the vertex after light source
             {
-                shading_context.get_tracer().trace_between_simple(
-                    shading_context,
-                    a.m_position + (v * 1.0e-6),
-                    b.m_position,
-                    shading_point.get_ray().m_time,
-                    VisibilityFlags::ShadowRay,
-                    shading_point.get_ray().m_depth,
-                    result);
-                double geometry_term = cos1 * cos2 / dist2;
-                result *= (float)geometry_term;
+                /// todo: fix this. This assumes diffuse light source.
+                const float pdf_w = static_cast<float>(dot(normalize(vertex.m_position - prev_vertex->m_position), prev_vertex->m_geometric_normal) * RcpPi<float>());
+                return static_cast<float>(prev_vertex->convert_density(pdf_w, vertex));
             }
 
-            return result;
+            return
+                compute_bsdf_density(
+                    *prev_vertex,
+                    static_cast<Vector3f>(normalize(prev2_vertex->m_position - prev_vertex->m_position)),
+                    vertex,
+                    true);
         }
 
-        /// todo: precompute path density using fwd_pdf and rev_pdf.
-        /// in the final code, this function should be removed and the mis weight computation should be very simple.
-        /// example: https://github.com/mmp/pbrt-v3/blob/master/src/integrators/bdpt.cpp#L228
-        float compute_path_density(
+        // Return the area density of the i'th vertex of a full path, counted from the camera
+        // (the camera itself being the first vertex), given that vertex and the two vertices before it.
+        static float compute_camera_side_density(
+            const size_t                i,
+            const BDPTVertex&           vertex,
+            const BDPTVertex&           prev_vertex,
+            const BDPTVertex*           prev2_vertex)
+        {
+            assert(i >= 3);
+
+            return
+                compute_bsdf_density(
+                    prev_vertex,
+                    i == 3  // first point after shading point
+                        ? static_cast<Vector3f>(prev_vertex.m_dir_to_prev_vertex)
+                        : static_cast<Vector3f>(normalize(prev2_vertex->m_position - prev_vertex.m_position)),
+                    vertex,
+                    false);
+        }
+
+        // Cache the densities of the light subpath that don't depend on the camera subpath.
+        void cache_light_densities(
             BDPTVertex*                 light_vertices,
+            const size_t                num_light_vertices) const
+        {
+            for (size_t k = 0; k < num_light_vertices; ++k)
+            {
+                BDPTVertex& vertex = light_vertices[k];
+
+                vertex.m_fwd_pdf =
+                    compute_light_side_density(
+                        k + 1,
+                        vertex,
+                        k >= 1 ? &light_vertices[k - 1] : nullptr,
+                        k >= 2 ? &light_vertices[k - 2] : nullptr);
+
+                vertex.m_rev_pdf =
+                    k + 2 < num_light_vertices
+                        ? compute_bsdf_density(
+                              light_vertices[k + 1],
+                              static_cast<Vector3f>(normalize(light_vertices[k + 2].m_position - light_vertices[k + 1].m_position)),
+                              vertex,
+                              false)
+                        : 0.0f;
+            }
+        }
+
+        // Cache the densities of the camera subpath that don't depend on the light subpath.
+        void cache_camera_densities(
             BDPTVertex*                 camera_vertices,
+            const size_t                num_camera_vertices) const
+        {
+            for (size_t j = 0; j < num_camera_vertices; ++j)
+            {
+                BDPTVertex& vertex = camera_vertices[j];
+
+                vertex.m_fwd_pdf =
+                    j >= 1
+                        ? compute_camera_side_density(
+                              j + 2,
+                              vertex,
+                              camera_vertices[j - 1],
+                              j >= 2 ? &camera_vertices[j - 2] : nullptr)
+                        : 0.0f;
+
+                vertex.m_rev_pdf =
+                    j >= 1 && j + 2 < num_camera_vertices
+                        ? compute_bsdf_density(
+                              camera_vertices[j + 1],
+                              static_cast<Vector3f>(normalize(camera_vertices[j + 2].m_position - camera_vertices[j + 1].m_position)),
+                              vertex,
+                              true)
+                        : 0.0f;
+            }
+        }
+
+        // Compute the MIS weight of the strategy (s, t) with the balance heuristic.
+        // Only the densities of the (up to) four vertices around the connection are evaluated,
+        // all others come from the per-subpath caches.
+        float compute_mis_weight(
+            const BDPTVertex*           light_vertices,
+            const BDPTVertex*           camera_vertices,
             const size_t                s,
-            const size_t                t,
-            const size_t                p,
-            const size_t                q)
+            const size_t                t)
         {
-            assert(p + q == s + t);
+            const size_t n = s + t;
 
             // get i Vertex in the constructed path
             // i = 1 correspond first vertex of the full path
 
-            auto get_vertex_start_from_light = [&](const size_t i)
+            auto get_vertex_start_from_light = [&](const size_t i) -> const BDPTVertex*
             {
-                if (i <= s)
-                {
-                    return &light_vertices[i - 1];
-                }
-                else
-                {
-                    return &camera_vertices[s + t - i - 1];
-                }
+                if (i == 0)
+                    return nullptr;
+                return i <= s ? &light_vertices[i - 1] : &camera_vertices[n - i - 1];
             };
 
-            auto get_vertex_start_from_camera = [&](const size_t i)
+            auto get_vertex_start_from_camera = [&](const size_t i) -> const BDPTVertex*
             {
-                if (i <= t)
-                {
-                    return &camera_vertices[i - 2];
-                }
-                else
-                {
-                    return &light_vertices[s + t - i];
-                }
+                if (i <= 1)
+                    return nullptr;
+                return i <= t ? &camera_vertices[i - 2] : &light_vertices[n - i];
             };
 
-            /// todo: swap all pdf computation to rev_pdf and fwd_pdf
-            float result = 1.0f;
-            // start from light
-            for (size_t i = 1; i <= p; i++)
+            // Prefix products of the densities of the full path, from the light and from the camera.
+            // The last two vertices of the full path (the camera and the shading point) are never
+            // sampled from the light.
+            float* light_densities = m_light_densities.data();
+            float* camera_densities = m_camera_densities.data();
+
+            light_densities[0] = 1.0f;
+            for (size_t i = 1; i <= n - 2; ++i)
             {
-                if (i == 1) // the vertex on light source
-                {
-                    const BDPTVertex& vertex = *get_vertex_start_from_light(i);
-                    float pdf_a = vertex.m_is_light_vertex ? m_light_sampler.evaluate_pdf(vertex.m_shading_point) : 0.0f;
-                    assert(pdf_a >= 0.0f);
-                    result *= pdf_a;
-                }
-                else if (i == 2) // the vertex after light source
-                {
-                    const BDPTVertex& prev_vertex = *get_vertex_start_from_light(i - 1);
-                    const BDPTVertex& vertex = *get_vertex_start_from_light(i);
-                    /// todo: fix this. This assumes diffuse light source.
-                    float pdf_w = static_cast<float>(dot(normalize(vertex.m_position - prev_vertex.m_position), prev_vertex.m_geometric_normal) * RcpPi<float>());
-                    float pdf_a = static_cast<float>(prev_vertex.convert_density(pdf_w, vertex));
-                    assert(pdf_a >= 0.0f);
-                    result *= pdf_a;
-                }
+                float pdf_a;
+                if (i <= s)
+                    pdf_a = light_vertices[i - 1].m_fwd_pdf;
+                else if (i >= s + 3)
+                    pdf_a = camera_vertices[n - i - 1].m_rev_pdf;
                 else
                 {
-                    const BDPTVertex& prev2_vertex = *get_vertex_start_from_light(i - 2);
-                    const BDPTVertex& prev_vertex = *get_vertex_start_from_light(i - 1);
-                    const BDPTVertex& vertex = *get_vertex_start_from_light(i);
-                    BSDF::LocalGeometry local_geometry;
-                    local_geometry.m_shading_point = &prev_vertex.m_shading_point;
-                    local_geometry.m_geometric_normal = Vector3f(prev_vertex.m_geometric_normal);
-                    local_geometry.m_shading_basis = prev_vertex.m_shading_basis;
-                    const float pdf_w =
-                        prev_vertex.m_bsdf->evaluate_pdf(
-                            prev_vertex.m_bsdf_data,
-                            true,
-                            local_geometry,
-                            static_cast<Vector3f>(normalize(vertex.m_position - prev_vertex.m_position)),
-                            static_cast<Vector3f>(normalize(prev2_vertex.m_position - prev_vertex.m_position)),
-                            ScatteringMode::All);
-                    float pdf_a = static_cast<float>(prev_vertex.convert_density(pdf_w, vertex));
-                    assert(pdf_a >= 0.0f);
-                    result *= pdf_a;
+                    pdf_a =
+                        compute_light_side_density(
+                            i,
+                            *get_vertex_start_from_light(i),
+                            get_vertex_start_from_light(i - 1),
+                            get_vertex_start_from_light(i - 2));
                 }
+
+                assert(pdf_a >= 0.0f);
+                light_densities[i] = light_densities[i - 1] * pdf_a;
             }
 
-            // start from camera
-            for (size_t i = 3; i <= q; i++)
+            camera_densities[2] = 1.0f;
+            for (size_t i = 3; i <= n; ++i)
             {
-                if (i == 3) // first point after shading point
-                {
-                    const BDPTVertex& prev_vertex = *get_vertex_start_from_camera(i - 1);
-                    const BDPTVertex& vertex = *get_vertex_start_from_camera(i);
-                    BSDF::LocalGeometry local_geometry;
-                    local_geometry.m_shading_point = &prev_vertex.m_shading_point;
-                    local_geometry.m_geometric_normal = Vector3f(prev_vertex.m_geometric_normal);
-                    local_geometry.m_shading_basis = prev_vertex.m_shading_basis;
-                    const float pdf_w =
-                        prev_vertex.m_bsdf->evaluate_pdf(
-                            prev_vertex.m_bsdf_data,
-                            false,
-                            local_geometry,
-                            static_cast<Vector3f>(normalize(vertex.m_position - prev_vertex.m_position)),
-                            static_cast<Vector3f>(prev_vertex.m_dir_to_prev_vertex),
-                            ScatteringMode::All);
-                    float pdf_a = static_cast<float>(prev_vertex.convert_density(pdf_w, vertex));
-                    assert(pdf_a >= 0.0f);
-                    result *= pdf_a;
-                }
+                float pdf_a;
+                if (i <= t)
+                    pdf_a = camera_vertices[i - 2].m_fwd_pdf;
+                else if (i >= t + 3)
+                    pdf_a = light_vertices[n - i].m_rev_pdf;
                 else
                 {
-                    const BDPTVertex& prev2_vertex = *get_vertex_start_from_camera(i - 2);
-                    const BDPTVertex& prev_vertex = *get_vertex_start_from_camera(i - 1);
-                    const BDPTVertex& vertex = *get_vertex_start_from_camera(i);
-                    BSDF::LocalGeometry local_geometry;
-                    local_geometry.m_shading_point = &prev_vertex.m_shading_point;
-                    local_geometry.m_geometric_normal = Vector3f(prev_vertex.m_geometric_normal);
-                    local_geometry.m_shading_basis = prev_vertex.m_shading_basis;
-                    const float pdf_w =
-                        prev_vertex.m_bsdf->evaluate_pdf(
-                            prev_vertex.m_bsdf_data,
-                            false,
-                            local_geometry,
-                            static_cast<Vector3f>(normalize(vertex.m_position - prev_vertex.m_position)),
-                            static_cast<Vector3f>(normalize(prev2_vertex.m_position - prev_vertex.m_position)),
-                            ScatteringMode::All);
-                    float pdf_a = static_cast<float>(prev_vertex.convert_density(pdf_w, vertex));
-                    assert(pdf_a >= 0.0f);
-                    result *= pdf_a;
+                    pdf_a =
+                        compute_camera_side_density(
+                            i,
+                            *get_vertex_start_from_camera(i),
+                            *get_vertex_start_from_camera(i - 1),
+                            get_vertex_start_from_camera(i - 2));
                 }
+
+                assert(pdf_a >= 0.0f);
+                camera_densities[i] = camera_densities[i - 1] * pdf_a;
             }
 
-            return result;
+            const float numerator = light_densities[s] * camera_densities[t];
+            if (numerator == 0.0f)
+                return 0.0f;
+
+            /// todo: unhandled case where (numerator <= 0) (specular surface / impossible path).
+            assert(FP<float>::is_finite(numerator));
+            assert(numerator > 0.0f);
+
+            float denominator = 0.0f;
+            // [p = 0, q = s + t], [p = 1, q = s + t - 1] ... [p = s + t - 2, q = 2]
+            for (size_t p = 0; p <= n - 2; p++)
+                denominator += light_densities[p] * camera_densities[n - p];
+
+            /// todo: unhandled case where (denominator <= 0) (specular surface / impossible path).
+            assert(FP<float>::is_finite(denominator));
+            assert(denominator > 0.0f);
+
+            const float mis_weight = numerator / denominator;
+            assert(mis_weight <= 1.0f);
+
+            return mis_weight;
         }
 
         void connect(
-            const ShadingContext&       shading_context,
-            const ShadingPoint&         shading_point,
-            BDPTVertex*                 light_vertices,
-            BDPTVertex*                 camera_vertices,
+            const BDPTVertex*           light_vertices,
+            const BDPTVertex*           camera_vertices,
             const size_t                s,
             const size_t                t,
             ShadingComponents&          radiance)
@@ -362,10 +470,11 @@ namespace
             assert(t >= 2);
             Spectrum result(0);
 
+            const BDPTVertex& camera_vertex = camera_vertices[t - 2];
+
             if (s == 0)
             {
                 // camera subpath is a complete path
-                const BDPTVertex& camera_vertex = camera_vertices[t - 2];
                 if (!camera_vertex.m_is_light_vertex)
                 {
                     return;
@@ -376,7 +485,6 @@ namespace
             {
                 // only one light vertex
                 const BDPTVertex& light_vertex = light_vertices[s - 1];
-                const BDPTVertex& camera_vertex = camera_vertices[t - 2];
 
                 /// todo: need to take care of light material as well
                 if (camera_vertex.m_bsdf == nullptr || camera_vertex.m_bsdf_data == nullptr)
@@ -384,7 +492,9 @@ namespace
                     return;
                 }
 
-                const Spectrum geometry = compute_geometry_term(shading_context, shading_point, camera_vertex, light_vertex);
+                const float geometry = compute_geometry_term(camera_vertex, light_vertex);
+                if (geometry == 0.0f)
+                    return;
 
                 BSDF::LocalGeometry local_geometry;
                 local_geometry.m_shading_point = &camera_vertex.m_shading_point;
@@ -407,10 +517,13 @@ namespace
             else
             {
                 const BDPTVertex& light_vertex = light_vertices[s - 1];
-                const BDPTVertex& camera_vertex = camera_vertices[t - 2];
 
                 if (light_vertex.m_bsdf == nullptr || camera_vertex.m_bsdf == nullptr ||
-                    light_vertex.m_bsdf_data == nullptr || camera_vertex.m_bsdf == nullptr)
+                    light_vertex.m_bsdf_data == nullptr || camera_vertex.m_bsdf_data == nullptr)
+                    return;
+
+                const float geometry = compute_geometry_term(camera_vertex, light_vertex);
+                if (geometry == 0.0f)
                     return;
 
                 BSDF::LocalGeometry camera_local_geometry;
@@ -445,7 +558,6 @@ namespace
                     ScatteringMode::All,
                     light_eval_bsdf);
 
-                Spectrum geometry = compute_geometry_term(shading_context, shading_point, camera_vertex, light_vertex);
                 result = geometry * camera_eval_bsdf.m_beauty * light_eval_bsdf.m_beauty * camera_vertex.m_beta * light_vertex.m_beta;
             }
 
@@ -453,27 +565,24 @@ namespace
             if (fz(result, 1.0e-4f))
                 return;
 
-            const float numerator = compute_path_density(light_vertices, camera_vertices, s, t, s, t);
-            if (numerator == 0.0f)
+            const float mis_weight = compute_mis_weight(light_vertices, camera_vertices, s, t);
+            if (mis_weight == 0.0f)
                 return;
 
-            /// todo: unhandled case where (numerator <= 0) (specular surface / impossible path).
-            assert(FP<float>::is_finite(numerator));
-            assert(numerator > 0.0f);
+            result *= mis_weight;
 
-            float denominator = 0.0f;
-            // [p = 0, q = s + t], [p = 1, q = s + t - 1] ... [p = s + t - 2, q = 2]
-            for (size_t i = 0; i <= s + t - 2; i++)
-                denominator += compute_path_density(light_vertices, camera_vertices, s, t, i, s + t - i);
-
-            /// todo: unhandled case where (denominator <= 0) (specular surface / impossible path).
-            assert(FP<float>::is_finite(denominator));
-            assert(denominator > 0.0f);
-
-            const float mis_weight = numerator / denominator;
+            if (s == 0)
+            {
+                radiance.m_beauty += result;
+                return;
+            }
 
-            assert(mis_weight <= 1.0f);
-            radiance.m_beauty += mis_weight * result;
+            // Defer the visibility test of the connection.
+            const BDPTVertex& light_vertex = light_vertices[s - 1];
+            const Vector3d v = light_vertex.m_position - camera_vertex.m_position;
+            m_connection_origins.push_back(camera_vertex.m_position + (v * 1.0e-6));
+            m_connection_targets.push_back(light_vertex.m_position);
+            m_connection_values.push_back(result);
         }
 
         size_t trace_light(
@@ -576,12 +685,12 @@ namespace
 
             BDPTVertex& bdpt_vertex = vertices[0];
             bdpt_vertex.m_beta = initial_flux;
-            bdpt_vertex.m_fwd_pdf = light_sample.m_probability;
+            bdpt_vertex.m_bsdf = nullptr;
+            bdpt_vertex.m_bsdf_data = nullptr;
             /// CONFUSE:: why geometric normal is flipped?
             bdpt_vertex.m_geometric_normal = -light_shading_point.get_geometric_normal();
             bdpt_vertex.m_is_light_vertex = true;
             bdpt_vertex.m_position = light_shading_point.get_point();
-            bdpt_vertex.m_rev_pdf = 1.0;
             bdpt_vertex.m_shading_point = light_shading_point;
 
             // Build the path tracer.
@@ -678,6 +787,16 @@ namespace
 
         size_t                      m_num_max_vertices;
 
+        // Per-thread storage, reused across samples.
+        std::vector<BDPTVertex>     m_camera_vertices;
+        std::vector<BDPTVertex>     m_light_vertices;
+        std::vector<float>          m_light_densities;
+        std::vector<float>          m_camera_densities;
+        std::vector<Vector3d>       m_connection_origins;
+        std::vector<Vector3d>       m_connection_targets;
+        std::vector<Spectrum>       m_connection_values;
+        std::vector<Spectrum>       m_connection_transmissions;
+
         struct PathVisitor
         {
             const ShadingContext&           m_shading_context;
@@ -722,12 +841,12 @@ namespace
                 bdpt_vertex.m_bsdf = vertex.m_bsdf;
                 bdpt_vertex.m_bsdf_data = vertex.m_bsdf_data;
                 bdpt_vertex.m_dir_to_prev_vertex = normalize(vertex.m_outgoing.get_value());
-                bdpt_vertex.m_fwd_pdf = vertex.m_prev_prob;
                 bdpt_vertex.m_geometric_normal = vertex.get_geometric_normal();
                 bdpt_vertex.m_position = vertex.get_point();
                 bdpt_vertex.m_shading_basis = Basis3f(vertex.get_shading_basis());
                 bdpt_vertex.m_shading_point = *vertex.m_shading_point;
-                /// todo: compute rev_pdf here
+                bdpt_vertex.m_Le.set(0.0f);
+                bdpt_vertex.m_is_light_vertex = false;
 
                 if (vertex.m_edf)
                 {
@@ -735,7 +854,6 @@ namespace
                     bdpt_vertex.m_is_light_vertex = true;
                 }
 
-                bdpt_vertex.m_prev_vertex = (*m_num_vertices == 0) ? nullptr : m_vertices - 1;
                 (*m_num_vertices)++;
             }
 
@@ -32,6 +32,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/lighting/backwardlightsampler.h"
+#include "renderer/kernel/lighting/directlightingreservoirs.h"
 #include "renderer/kernel/lighting/lightpathstream.h"
 #include "renderer/kernel/lighting/tracer.h"
 #include "renderer/kernel/shading/directshadingcomponents.h"
@@ -45,9 +46,11 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/rr.h"
+#include "foundation/math/sampling/mappings.h"
 #include "foundation/math/scalar.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 
@@ -56,6 +59,78 @@ using namespace foundation;
 namespace renderer
 {
 
+namespace
+{
+    // Reservoirs of other pixels or passes are only reused on similar surfaces.
+    const float ReuseMinNormalCosine = 0.9f;
+    const float ReuseMaxRelativeDistance = 0.1f;
+
+    // Offset, relative to the length of the ray, of the origin of the rays testing
+    // whether reused light samples are visible from the surfaces of other pixels.
+    const double SupportRayOffset = 1.0e-4;
+
+    bool is_similar_surface(
+        const DirectLightingReservoir&  lhs,
+        const DirectLightingReservoir&  rhs)
+    {
+        return
+            dot(lhs.m_surface_normal, rhs.m_surface_normal) >= ReuseMinNormalCosine &&
+            std::abs(lhs.m_surface_distance - rhs.m_surface_distance) <= ReuseMaxRelativeDistance * lhs.m_surface_distance;
+    }
+
+    void load_light_sample(
+        const DirectLightingReservoir&  reservoir,
+        LightSample&                    sample)
+    {
+        sample.m_shape = reservoir.m_shape;
+        sample.m_param_coords = reservoir.m_param_coords;
+        sample.m_point = Vector3d(reservoir.m_point);
+        sample.m_shading_normal = Vector3d(reservoir.m_shading_normal);
+        sample.m_geometric_normal = Vector3d(reservoir.m_geometric_normal);
+        sample.m_probability = 0.0f;        // not used by resampling
+    }
+
+    void store_light_sample(
+        const LightSample&              sample,
+        DirectLightingReservoir&        reservoir)
+    {
+        reservoir.m_shape = sample.m_shape;
+        reservoir.m_param_coords = sample.m_param_coords;
+        reservoir.m_point = Vector3f(sample.m_point);
+        reservoir.m_shading_normal = Vector3f(sample.m_shading_normal);
+        reservoir.m_geometric_normal = Vector3f(sample.m_geometric_normal);
+    }
+
+    // A reservoir being filled with weighted light samples, one at a time.
+    struct ResamplingState
+    {
+        LightSample                     m_sample;
+        DirectShadingComponents         m_material_value;   // BSDF value of the selected sample
+        Spectrum                        m_edf_value;        // emitted radiance of the selected sample times the geometric term
+        float                           m_target;           // target function of the selected sample
+        float                           m_weight_sum;
+        int                             m_source;           // index of the reservoir the selected sample comes from, or -1
+
+        ResamplingState()
+          : m_target(0.0f)
+          , m_weight_sum(0.0f)
+          , m_source(-1)
+        {
+        }
+
+        // Stream a sample of a given resampling weight through the reservoir.
+        // Return true if it replaces the selected sample.
+        bool update(const float weight, const float s)
+        {
+            if (!(weight > 0.0f))
+                return false;
+
+            m_weight_sum += weight;
+            return s * m_weight_sum < weight;
+        }
+    };
+}
+
 //
 // DirectLightingIntegrator class implementation.
 //
@@ -72,6 +147,11 @@ namespace renderer
 //       compute_outgoing_radiance_material_sampling
 //       compute_outgoing_radiance_light_sampling_low_variance
 //
+//   compute_outgoing_radiance_light_sampling_resampled
+//       add_non_physical_light_sample_contribution
+//       evaluate_unshadowed_contribution
+//       is_sample_in_support
+//
 
 DirectLightingIntegrator::DirectLightingIntegrator(
     const ShadingContext&           shading_context,
@@ -176,13 +256,35 @@ void DirectLightingIntegrator::compute_outgoing_radiance_light_sampling_low_vari
             // Add the contribution of the chosen light.
             if (sample.m_shape)
             {
-                add_emitting_shape_sample_contribution(
-                    sampling_context,
-                    sample,
-                    mis_heuristic,
-                    outgoing,
-                    lightset_radiance,
-                    light_path_stream);
+                if (m_light_sampler.has_importance_cache())
+                {
+                    DirectShadingComponents sample_radiance;
+                    add_emitting_shape_sample_contribution(
+                        sampling_context,
+                        sample,
+                        mis_heuristic,
+                        outgoing,
+                        sample_radiance,
+                        light_path_stream);
+
+                    // Let the light importance cache learn from this sample, including when it was occluded.
+                    m_light_sampler.record_lightset_sample(
+                        m_material_sampler.get_shading_point(),
+                        sample,
+                        average_value(sample_radiance.m_beauty));
+
+                    lightset_radiance += sample_radiance;
+                }
+                else
+                {
+                    add_emitting_shape_sample_contribution(
+                        sampling_context,
+                        sample,
+                        mis_heuristic,
+                        outgoing,
+                        lightset_radiance,
+                        light_path_stream);
+                }
             }
             else
             {
@@ -225,6 +327,266 @@ void DirectLightingIntegrator::compute_outgoing_radiance_combined_sampling_low_v
     radiance += radiance_light_sampling;
 }
 
+void DirectLightingIntegrator::compute_outgoing_radiance_light_sampling_resampled(
+    SamplingContext&                sampling_context,
+    const Dual3d&                   outgoing,
+    const Vector2i&                 pixel_coords,
+    const bool                      two_sided,
+    DirectLightingReservoirs&       reservoirs,
+    DirectShadingComponents&        radiance,
+    LightPathStream*                light_path_stream) const
+{
+    radiance.set(0.0f);
+
+    // No light source in the scene.
+    if (!m_light_sampler.has_lights())
+        return;
+
+    // Check if PDF of the sampler is Dirac delta and therefore cannot contribute to the light sampling.
+    if (!m_material_sampler.contributes_to_light_sampling())
+        return;
+
+    // Add contributions from all non-physical light sources that aren't part of the lightset.
+    for (size_t i = 0, e = m_light_sampler.get_non_physical_light_count(); i < e; ++i)
+    {
+        LightSample sample;
+        m_light_sampler.sample_non_physical_light(m_time, i, sample);
+
+        add_non_physical_light_sample_contribution(
+            sampling_context,
+            sample,
+            outgoing,
+            radiance,
+            light_path_stream);
+    }
+
+    if (!m_light_sampler.has_lightset())
+        return;
+
+    const DirectLightingReservoirs::Parameters& params = reservoirs.get_parameters();
+    const ShadingPoint& shading_point = m_material_sampler.get_shading_point();
+
+    // Describe the surface of this pixel for reservoirs reuse.
+    DirectLightingReservoir reservoir;
+    reservoir.m_shape = nullptr;
+    reservoir.m_weight = 0.0f;
+    reservoir.m_sample_count = 0.0f;
+    reservoir.m_surface_point = Vector3f(m_material_sampler.get_point());
+    reservoir.m_surface_normal = Vector3f(shading_point.get_shading_normal());
+    reservoir.m_surface_distance = static_cast<float>(shading_point.get_distance());
+    reservoir.m_surface_two_sided = two_sided;
+
+    //
+    // Resample candidates from the light set against their unshadowed contribution.
+    //
+
+    const size_t candidate_count = params.m_candidate_count;
+    ResamplingState candidates;
+    DirectShadingComponents non_physical_radiance;
+
+    sampling_context.split_in_place(4, candidate_count);
+
+    for (size_t i = 0; i < candidate_count; ++i)
+    {
+        const Vector4f s = sampling_context.next2<Vector4f>();
+
+        LightSample sample;
+        m_light_sampler.sample_lightset(
+            m_time,
+            Vector3f(s[0], s[1], s[2]),
+            shading_point,
+            sample);
+
+        // Non-physical lights of the light set are not resampled: estimate their contribution directly.
+        if (sample.m_shape == nullptr)
+        {
+            add_non_physical_light_sample_contribution(
+                sampling_context,
+                sample,
+                outgoing,
+                non_physical_radiance,
+                light_path_stream);
+            continue;
+        }
+
+        DirectShadingComponents material_value;
+        Spectrum edf_value;
+        const float target =
+            evaluate_unshadowed_contribution(sample, outgoing, material_value, edf_value);
+
+        if (target > 0.0f && candidates.update(target / sample.m_probability, s[3]))
+        {
+            candidates.m_sample = sample;
+            candidates.m_material_value = material_value;
+            candidates.m_edf_value = edf_value;
+            candidates.m_target = target;
+            candidates.m_source = 0;
+        }
+    }
+
+    if (candidate_count > 1)
+        non_physical_radiance /= static_cast<float>(candidate_count);
+
+    radiance += non_physical_radiance;
+
+    //
+    // Visibility reuse: the reservoir of the candidates gets a zero weight if its sample is occluded.
+    //
+
+    Spectrum candidate_transmission(0.0f);
+    if (candidates.m_source == 0)
+    {
+        m_material_sampler.trace_between(
+            m_shading_context,
+            candidates.m_sample.m_point,
+            reinterpret_cast<size_t>(candidates.m_sample.m_shape),
+            candidate_transmission);
+
+        // The weight of the reservoir in the combination below reduces to the sum of the candidate weights.
+        if (is_zero(candidate_transmission))
+        {
+            candidates.m_weight_sum = 0.0f;
+            candidates.m_source = -1;
+        }
+    }
+
+    //
+    // Combine the reservoir of the candidates with reservoirs of the previous pass at this
+    // pixel (temporal reuse) and at neighboring pixels (spatial reuse).
+    //
+
+    ResamplingState combined = candidates;
+    float combined_sample_count = static_cast<float>(candidate_count);
+    const float max_sample_count = params.m_max_history * static_cast<float>(candidate_count);
+
+    const DirectLightingReservoir* reused[1 + DirectLightingReservoirs::MaxSpatialReuseCount];
+    float reused_sample_counts[1 + DirectLightingReservoirs::MaxSpatialReuseCount];
+    size_t reused_count = 0;
+
+    assert(params.m_spatial_reuse_count <= DirectLightingReservoirs::MaxSpatialReuseCount);
+    sampling_context.split_in_place(3, 1 + params.m_spatial_reuse_count);
+
+    for (size_t i = 0; i <= params.m_spatial_reuse_count; ++i)
+    {
+        const Vector3f s = sampling_context.next2<Vector3f>();
+
+        Vector2i coords = pixel_coords;
+        if (i > 0)
+        {
+            // Pick a neighboring pixel uniformly in a disk.
+            const Vector2f d = sample_disk_uniform(Vector2f(s[0], s[1])) * params.m_spatial_reuse_radius;
+            coords.x += static_cast<int>(std::floor(d.x + 0.5f));
+            coords.y += static_cast<int>(std::floor(d.y + 0.5f));
+            if (coords == pixel_coords)
+                continue;
+        }
+
+        const DirectLightingReservoir* other = reservoirs.get_previous(coords.x, coords.y);
+        if (other == nullptr || !is_similar_surface(reservoir, *other))
+            continue;
+
+        const float other_sample_count = std::min(other->m_sample_count, max_sample_count);
+        reused[reused_count] = other;
+        reused_sample_counts[reused_count] = other_sample_count;
+        combined_sample_count += other_sample_count;
+        ++reused_count;
+
+        if (other->m_weight == 0.0f)
+            continue;
+
+        LightSample sample;
+        load_light_sample(*other, sample);
+
+        DirectShadingComponents material_value;
+        Spectrum edf_value;
+        const float target =
+            evaluate_unshadowed_contribution(sample, outgoing, material_value, edf_value);
+
+        if (combined.update(target * other->m_weight * other_sample_count, s[2]))
+        {
+            combined.m_sample = sample;
+            combined.m_material_value = material_value;
+            combined.m_edf_value = edf_value;
+            combined.m_target = target;
+            combined.m_source = static_cast<int>(reused_count);
+        }
+    }
+
+    const bool store_reservoir =
+        static_cast<size_t>(pixel_coords.x) < reservoirs.get_width() &&
+        static_cast<size_t>(pixel_coords.y) < reservoirs.get_height();
+
+    if (combined.m_source < 0)
+    {
+        if (store_reservoir && candidates.m_target > 0.0f)
+        {
+            // Keep track of the occluded sample so that its sample count is not lost.
+            store_light_sample(candidates.m_sample, reservoir);
+            reservoir.m_sample_count = std::min(combined_sample_count, max_sample_count);
+            reservoirs.set_current(pixel_coords.x, pixel_coords.y, reservoir);
+        }
+        return;
+    }
+
+    //
+    // Compute the unbiased contribution weight of the selected sample: only count the
+    // candidates of the reservoirs that could have selected it.
+    //
+
+    float support_sample_count = static_cast<float>(candidate_count);
+    for (size_t i = 0; i < reused_count; ++i)
+    {
+        if (combined.m_source == static_cast<int>(i + 1) ||
+            is_sample_in_support(*reused[i], combined.m_sample))
+            support_sample_count += reused_sample_counts[i];
+    }
+
+    const float weight = combined.m_weight_sum / (support_sample_count * combined.m_target);
+
+    // Compute the transmission toward the selected sample, unless it is already known.
+    Spectrum transmission;
+    if (combined.m_source == 0)
+        transmission = candidate_transmission;
+    else
+    {
+        m_material_sampler.trace_between(
+            m_shading_context,
+            combined.m_sample.m_point,
+            reinterpret_cast<size_t>(combined.m_sample.m_shape),
+            transmission);
+    }
+
+    const bool occluded = is_zero(transmission);
+
+    // Store the combined reservoir for the next pass.
+    if (store_reservoir)
+    {
+        store_light_sample(combined.m_sample, reservoir);
+        reservoir.m_weight = occluded ? 0.0f : weight;
+        reservoir.m_sample_count = std::min(combined_sample_count, max_sample_count);
+        reservoirs.set_current(pixel_coords.x, pixel_coords.y, reservoir);
+    }
+
+    if (occluded)
+        return;
+
+    // Add the contribution of the selected sample to the illumination.
+    Spectrum edf_value = combined.m_edf_value;
+    edf_value *= transmission;
+    edf_value *= weight;
+    madd(radiance, combined.m_material_value, edf_value);
+
+    // Record light path event.
+    if (light_path_stream)
+    {
+        light_path_stream->sampled_emitting_shape(
+            *combined.m_sample.m_shape,
+            combined.m_sample.m_point,
+            combined.m_material_value.m_beauty,
+            edf_value);
+    }
+}
+
 void DirectLightingIntegrator::take_single_material_sample(
     SamplingContext&                sampling_context,
     const MISHeuristic              mis_heuristic,
@@ -402,10 +764,12 @@ void DirectLightingIntegrator::add_emitting_shape_sample_contribution(
     }
 
     // Compute the transmission factor between the light sample and the shading point.
+    // Consecutive shadow rays toward a given light are often blocked by the same occluder.
     Spectrum transmission;
     m_material_sampler.trace_between(
         m_shading_context,
         sample.m_point,
+        reinterpret_cast<size_t>(sample.m_shape),
         transmission);
 
     // Discard occluded samples.
@@ -514,6 +878,7 @@ void DirectLightingIntegrator::add_non_physical_light_sample_contribution(
         m_material_sampler.trace_between(
             m_shading_context,
             emission_position,
+            reinterpret_cast<size_t>(light),
             transmission);
 
         // Discard occluded samples.
@@ -552,4 +917,112 @@ void DirectLightingIntegrator::add_non_physical_light_sample_contribution(
     }
 }
 
+float DirectLightingIntegrator::evaluate_unshadowed_contribution(
+    const LightSample&              sample,
+    const Dual3d&                   outgoing,
+    DirectShadingComponents&        material_value,
+    Spectrum&                       edf_value) const
+{
+    const Material* material = sample.m_shape->get_material();
+    const Material::RenderData& material_data = material->get_render_data();
+    const EDF* edf = material_data.m_edf;
+
+    // No contribution if we are computing indirect lighting but this light does not cast indirect light.
+    if (m_indirect && !(edf->get_flags() & EDF::CastIndirectLight))
+        return 0.0f;
+
+    // Compute the incoming direction in world space.
+    Vector3d incoming = sample.m_point - m_material_sampler.get_point();
+
+    // No contribution if the shading point is behind the light.
+    double cos_on = dot(-incoming, sample.m_shading_normal);
+    if (cos_on <= 0.0)
+        return 0.0f;
+
+    // Compute the square distance between the light sample and the shading point.
+    const double square_distance = square_norm(incoming);
+
+    // Don't use this sample if we're closer than the light near start value.
+    if (square_distance < square(edf->get_light_near_start()))
+        return 0.0f;
+
+    const double rcp_sample_square_distance = 1.0 / square_distance;
+    const double rcp_sample_distance = std::sqrt(rcp_sample_square_distance);
+
+    // Normalize the incoming direction.
+    cos_on *= rcp_sample_distance;
+    incoming *= rcp_sample_distance;
+
+    // Evaluate the BSDF (or volume).
+    const float material_probability =
+        m_material_sampler.evaluate(
+            Vector3f(outgoing.get_value()),
+            Vector3f(incoming),
+            m_light_sampling_modes,
+            material_value);
+    assert(material_probability >= 0.0f);
+    if (material_probability == 0.0f)
+        return 0.0f;
+
+    // Build a shading point on the light source.
+    ShadingPoint light_shading_point;
+    sample.make_shading_point(
+        light_shading_point,
+        sample.m_shading_normal,
+        m_shading_context.get_intersector());
+
+    if (material_data.m_shader_group)
+    {
+        m_shading_context.execute_osl_emission(
+            *material_data.m_shader_group,
+            light_shading_point);
+    }
+
+    // Evaluate the EDF.
+    edf_value.set(0.0f);
+    edf->evaluate(
+        edf->evaluate_inputs(m_shading_context, light_shading_point),
+        Vector3f(sample.m_geometric_normal),
+        Basis3f(Vector3f(sample.m_shading_normal)),
+        -Vector3f(incoming),
+        edf_value);
+
+    // Apply the geometric term.
+    edf_value *= static_cast<float>(cos_on * rcp_sample_square_distance);
+
+    Spectrum beauty = material_value.m_beauty;
+    beauty *= edf_value;
+
+    return std::max(average_value(beauty), 0.0f);
+}
+
+bool DirectLightingIntegrator::is_sample_in_support(
+    const DirectLightingReservoir&  reservoir,
+    const LightSample&              sample) const
+{
+    const Vector3d surface_point(reservoir.m_surface_point);
+    const Vector3d to_sample = sample.m_point - surface_point;
+
+    // The surface must be in front of the light.
+    if (dot(to_sample, sample.m_shading_normal) >= 0.0)
+        return false;
+
+    // The light must be on a side of the surface where light is scattered.
+    if (!reservoir.m_surface_two_sided && dot(to_sample, Vector3d(reservoir.m_surface_normal)) <= 0.0)
+        return false;
+
+    // The light must be visible from the surface.
+    Spectrum transmission;
+    m_shading_context.get_tracer().trace_between_simple(
+        m_shading_context,
+        surface_point + SupportRayOffset * to_sample,
+        sample.m_point,
+        m_time,
+        VisibilityFlags::ShadowRay,
+        0,                              // ray depth
+        transmission);
+
+    return !is_zero(transmission);
+}
+
 }   // namespace renderer
@@ -45,6 +45,8 @@
 
 // Forward declarations.
 namespace renderer  { class BackwardLightSampler; }
+namespace renderer  { class DirectLightingReservoirs; }
+namespace renderer  { struct DirectLightingReservoir; }
 namespace renderer  { class DirectShadingComponents; }
 namespace renderer  { class LightPathStream; }
 namespace renderer  { class LightSample; }
@@ -67,6 +69,17 @@ namespace renderer
 //   The number of shadow rays cast by these functions may be as high as the number of light
 //   samples passed to the constructor plus the number of non-physical lights in the scene.
 //
+// Note about compute_outgoing_radiance_light_sampling_resampled():
+//
+//   This method estimates the lighting from light-emitting shapes with reservoir-based
+//   spatiotemporal resampled importance sampling (ReSTIR). Many candidate light samples are
+//   generated but only the one selected by resampling against the unshadowed contribution is
+//   traced. The reservoir of the pixel is then combined with the reservoirs of the same pixel
+//   and of a few neighboring pixels at the previous pass, and the combination is weighted so
+//   that it stays unbiased. Since it already samples the product of the BSDF and of the
+//   emission, it is not combined with BSDF sampling: the caller must not count light-emitting
+//   shapes hit by non-specular BSDF samples.
+//
 
 class DirectLightingIntegrator
 {
@@ -105,6 +118,18 @@ class DirectLightingIntegrator
         DirectShadingComponents&        radiance,
         LightPathStream*                light_path_stream) const;
 
+    // Compute outgoing radiance due to direct lighting via resampled light sampling, reusing
+    // and updating the reservoirs of a given pixel. `two_sided` tells whether the material
+    // scatters light on both sides of the surface.
+    void compute_outgoing_radiance_light_sampling_resampled(
+        SamplingContext&                sampling_context,
+        const foundation::Dual3d&       outgoing,                   // world space outgoing direction, unit-length
+        const foundation::Vector2i&     pixel_coords,
+        const bool                      two_sided,
+        DirectLightingReservoirs&       reservoirs,
+        DirectShadingComponents&        radiance,
+        LightPathStream*                light_path_stream) const;
+
   private:
     friend class VolumeLightingIntegrator;
 
@@ -138,6 +163,22 @@ class DirectLightingIntegrator
         const foundation::Dual3d&       outgoing,
         DirectShadingComponents&        radiance,
         LightPathStream*                light_path_stream) const;
+
+    // Evaluate the BSDF and the emitted radiance (times the geometric term) of a light-emitting
+    // shape sample, ignoring visibility. Return the resampling target function, i.e. the average
+    // of the beauty component of the unshadowed contribution.
+    float evaluate_unshadowed_contribution(
+        const LightSample&              sample,
+        const foundation::Dual3d&       outgoing,
+        DirectShadingComponents&        material_value,
+        Spectrum&                       edf_value) const;
+
+    // Return true if a reservoir built for another surface may have selected a given sample,
+    // i.e. if the sample faces that surface, lies on a side of it where light is scattered
+    // and is visible from it.
+    bool is_sample_in_support(
+        const DirectLightingReservoir&  reservoir,
+        const LightSample&              sample) const;
 };
 
 }   // namespace renderer
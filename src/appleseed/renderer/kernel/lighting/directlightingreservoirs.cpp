@@ -0,0 +1,113 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "directlightingreservoirs.h"
+
+// Standard headers.
+#include <algorithm>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    DirectLightingReservoir make_empty_reservoir()
+    {
+        DirectLightingReservoir reservoir;
+        reservoir.m_shape = nullptr;
+        reservoir.m_weight = 0.0f;
+        reservoir.m_sample_count = 0.0f;
+        return reservoir;
+    }
+}
+
+
+//
+// DirectLightingReservoirs class implementation.
+//
+
+DirectLightingReservoirs::DirectLightingReservoirs(
+    const size_t                    width,
+    const size_t                    height,
+    const Parameters&               params)
+  : m_width(width)
+  , m_height(height)
+  , m_params(params)
+  , m_previous(width * height, make_empty_reservoir())
+  , m_current(width * height, make_empty_reservoir())
+  , m_update_count(0)
+  , m_tracked_memory("direct lighting reservoirs")
+{
+    m_tracked_memory.set_size(get_memory_size());
+}
+
+void DirectLightingReservoirs::update()
+{
+    std::swap(m_previous, m_current);
+    std::fill(m_current.begin(), m_current.end(), make_empty_reservoir());
+
+    ++m_update_count;
+}
+
+void DirectLightingReservoirs::clear()
+{
+    std::fill(m_previous.begin(), m_previous.end(), make_empty_reservoir());
+    std::fill(m_current.begin(), m_current.end(), make_empty_reservoir());
+}
+
+size_t DirectLightingReservoirs::get_memory_size() const
+{
+    return (m_previous.capacity() + m_current.capacity()) * sizeof(DirectLightingReservoir);
+}
+
+Statistics DirectLightingReservoirs::get_statistics() const
+{
+    size_t filled_count = 0;
+    double sample_count = 0.0;
+
+    for (const DirectLightingReservoir& reservoir : m_previous)
+    {
+        if (!reservoir.is_empty())
+        {
+            ++filled_count;
+            sample_count += reservoir.m_sample_count;
+        }
+    }
+
+    Statistics stats;
+    stats.insert("updates", m_update_count);
+    stats.insert_percent("filled pixels", filled_count, m_previous.size());
+    stats.insert("avg. samples", filled_count > 0 ? sample_count / filled_count : 0.0);
+    stats.insert_size("memory size", get_memory_size());
+    return stats;
+}
+
+}   // namespace renderer
@@ -0,0 +1,202 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/memorytracker.h"
+#include "foundation/utility/statistics.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Forward declarations.
+namespace renderer  { class EmittingShape; }
+
+namespace renderer
+{
+
+//
+// A reservoir of light samples for the direct lighting of the surface seen through a pixel.
+//
+// The reservoir holds the light sample selected by resampled importance sampling among
+// all the candidates it has seen, the unbiased contribution weight of that sample and
+// the number of candidates (possibly clamped) that it represents. It also records the
+// surface it was built for, so that reusing it at another pixel or pass can be rejected
+// when the surfaces differ too much.
+//
+
+struct DirectLightingReservoir
+{
+    // Selected light sample. m_shape is nullptr for empty reservoirs.
+    const EmittingShape*        m_shape;
+    foundation::Vector2f        m_param_coords;
+    foundation::Vector3f        m_point;
+    foundation::Vector3f        m_shading_normal;
+    foundation::Vector3f        m_geometric_normal;
+
+    float                       m_weight;               // unbiased contribution weight of the selected sample
+    float                       m_sample_count;         // number of candidates represented by this reservoir
+
+    // Surface this reservoir was built for.
+    foundation::Vector3f        m_surface_point;
+    foundation::Vector3f        m_surface_normal;       // shading normal, unit-length
+    float                       m_surface_distance;     // distance to the camera
+    bool                        m_surface_two_sided;    // true if the surface scatters light on both sides
+
+    bool is_empty() const;
+};
+
+
+//
+// Per-pixel reservoirs used by resampled direct lighting, persisted across passes.
+//
+// Reservoirs are double-buffered: during a pass, reservoirs built at a pixel are stored
+// in the current buffer, while the reservoirs of the previous pass (temporal and spatial
+// reuse) are only read from the previous buffer. Since pixels of a pass are rendered by
+// a single thread, neither buffer needs any synchronization.
+//
+
+class DirectLightingReservoirs
+  : public foundation::NonCopyable
+{
+  public:
+    enum { MaxSpatialReuseCount = 8 };
+
+    struct Parameters
+    {
+        size_t  m_candidate_count;          // number of initial light samples per shading point
+        size_t  m_spatial_reuse_count;      // number of neighboring pixels to reuse reservoirs from, at most MaxSpatialReuseCount
+        float   m_spatial_reuse_radius;     // in pixels
+        float   m_max_history;              // maximum sample count of reused reservoirs, relative to m_candidate_count
+    };
+
+    // Constructor.
+    DirectLightingReservoirs(
+        const size_t                width,
+        const size_t                height,
+        const Parameters&           params);
+
+    // Return the parameters of resampled direct lighting.
+    const Parameters& get_parameters() const;
+
+    // Return the dimensions of the buffers, in pixels.
+    size_t get_width() const;
+    size_t get_height() const;
+
+    // Return the reservoir built at a pixel during the previous pass, or nullptr if there is none.
+    const DirectLightingReservoir* get_previous(
+        const int                   x,
+        const int                   y) const;
+
+    // Store the reservoir built at a pixel during the current pass.
+    void set_current(
+        const size_t                x,
+        const size_t                y,
+        const DirectLightingReservoir& reservoir);
+
+    // Make the reservoirs of the current pass available for reuse. Not thread-safe.
+    void update();
+
+    // Discard all reservoirs, e.g. when the camera or the scene changed. Not thread-safe.
+    void clear();
+
+    // Return the size in bytes of the buffers.
+    size_t get_memory_size() const;
+
+    // Return statistics about the reservoirs.
+    foundation::Statistics get_statistics() const;
+
+  private:
+    const size_t                            m_width;
+    const size_t                            m_height;
+    const Parameters                        m_params;
+    std::vector<DirectLightingReservoir>    m_previous;
+    std::vector<DirectLightingReservoir>    m_current;
+    size_t                                  m_update_count;
+    foundation::TrackedMemory               m_tracked_memory;
+};
+
+
+//
+// DirectLightingReservoir class implementation.
+//
+
+inline bool DirectLightingReservoir::is_empty() const
+{
+    return m_shape == nullptr;
+}
+
+
+//
+// DirectLightingReservoirs class implementation.
+//
+
+inline const DirectLightingReservoirs::Parameters& DirectLightingReservoirs::get_parameters() const
+{
+    return m_params;
+}
+
+inline size_t DirectLightingReservoirs::get_width() const
+{
+    return m_width;
+}
+
+inline size_t DirectLightingReservoirs::get_height() const
+{
+    return m_height;
+}
+
+inline const DirectLightingReservoir* DirectLightingReservoirs::get_previous(
+    const int                       x,
+    const int                       y) const
+{
+    if (x < 0 || y < 0 || static_cast<size_t>(x) >= m_width || static_cast<size_t>(y) >= m_height)
+        return nullptr;
+
+    const DirectLightingReservoir& reservoir = m_previous[static_cast<size_t>(y) * m_width + static_cast<size_t>(x)];
+    return reservoir.is_empty() ? nullptr : &reservoir;
+}
+
+inline void DirectLightingReservoirs::set_current(
+    const size_t                    x,
+    const size_t                    y,
+    const DirectLightingReservoir&  reservoir)
+{
+    assert(x < m_width);
+    assert(y < m_height);
+
+    m_current[y * m_width + x] = reservoir;
+}
+
+}   // namespace renderer
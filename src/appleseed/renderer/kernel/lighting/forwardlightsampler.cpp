@@ -43,6 +43,7 @@
 // Standard headers.
 #include <cassert>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 
@@ -77,6 +78,7 @@ ForwardLightSampler::ForwardLightSampler(const Scene& scene, const ParamArray& p
     m_non_physical_light_count = m_non_physical_lights.size();
 
     // Collect all light-emitting shapes.
+    std::vector<float> shape_probs;
     collect_emitting_shapes(
         scene.assembly_instances(),
         TransformSequence(),
@@ -94,13 +96,22 @@ ForwardLightSampler::ForwardLightSampler(const Scene& scene, const ParamArray& p
             const float shape_importance = m_params.m_importance_sampling ? area : 1.0f;
             const float shape_prob = shape_importance * importance_multiplier;
 
-            // Insert the light-emitting shape into the CDF.
-            m_emitting_shapes_cdf.insert(emitting_shape_index, shape_prob);
+            // Store the probability density until texture importances are known.
+            assert(shape_probs.size() == emitting_shape_index);
+            shape_probs.push_back(shape_prob);
 
             // Accept this shape.
             return true;
         });
 
+    // Account for the variations of textured emission across emitting shapes.
+    if (m_params.m_importance_sampling)
+        compute_texture_importances(scene);
+
+    // Insert the light-emitting shapes into the CDF.
+    for (size_t i = 0, e = shape_probs.size(); i < e; ++i)
+        m_emitting_shapes_cdf.insert(i, shape_probs[i] * m_emitting_shapes[i].get_texture_importance());
+
     // Build the hash table of emitting shapes.
     build_emitting_shape_hash_table();
 
@@ -0,0 +1,251 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "guidedpath.h"
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/scatteringmode.h"
+#include "renderer/kernel/lighting/sdtree.h"
+#include "renderer/kernel/shading/shadingcomponents.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/modeling/bsdf/bsdfsample.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// GuidedPath class implementation.
+//
+
+GuidedPath::GuidedPath(
+    SDTree&                             sd_tree,
+    const float                         bsdf_sampling_fraction)
+  : m_sd_tree(sd_tree)
+  , m_bsdf_sampling_fraction(bsdf_sampling_fraction)
+  , m_path_radiance(nullptr)
+  , m_vertex_count(0)
+  , m_guided_sample_count(0)
+{
+    assert(m_bsdf_sampling_fraction > 0.0f && m_bsdf_sampling_fraction < 1.0f);
+}
+
+void GuidedPath::begin_path(const ShadingComponents& path_radiance)
+{
+    m_path_radiance = &path_radiance;
+    m_vertex_count = 0;
+}
+
+void GuidedPath::end_path()
+{
+    assert(m_path_radiance);
+
+    const Spectrum& path_radiance = m_path_radiance->m_beauty;
+
+    for (size_t i = 0; i < m_vertex_count; ++i)
+    {
+        const Vertex& vertex = m_vertices[i];
+
+        // The radiance gathered after a vertex, divided by the throughput up to that
+        // vertex, is the radiance incident at the vertex along the sampled direction.
+        float incident_radiance = 0.0f;
+
+        for (size_t c = 0, e = Spectrum::size(); c < e; ++c)
+        {
+            if (vertex.m_throughput[c] > 0.0f)
+            {
+                incident_radiance +=
+                    std::max(path_radiance[c] - vertex.m_radiance[c], 0.0f) / vertex.m_throughput[c];
+            }
+        }
+
+        incident_radiance /= static_cast<float>(Spectrum::size());
+
+        m_sd_tree.record(
+            vertex.m_point,
+            vertex.m_incoming,
+            incident_radiance / vertex.m_pdf);
+    }
+
+    m_path_radiance = nullptr;
+    m_vertex_count = 0;
+}
+
+float GuidedPath::sample(
+    SamplingContext&                    sampling_context,
+    const BSDF&                         bsdf,
+    const void*                         bsdf_data,
+    const bool                          adjoint,
+    const BSDF::LocalGeometry&          local_geometry,
+    const Dual3f&                       outgoing,
+    const int                           modes,
+    const bool                          compute_aovs,
+    BSDFSample&                         sample)
+{
+    const int guided_modes = modes & (ScatteringMode::Diffuse | ScatteringMode::Glossy);
+
+    const DTree* dtree =
+        guided_modes != 0
+            ? m_sd_tree.get_sampling_dtree(local_geometry.m_shading_point->get_point())
+            : nullptr;
+
+    // Plain BSDF sampling where nothing was learned yet.
+    if (dtree == nullptr)
+    {
+        bsdf.sample(
+            sampling_context,
+            bsdf_data,
+            adjoint,
+            true,       // multiply by |cos(incoming, normal)|
+            local_geometry,
+            outgoing,
+            modes,
+            sample);
+
+        return sample.get_probability();
+    }
+
+    sampling_context.split_in_place(1, 1);
+    const float s = sampling_context.next2<float>();
+
+    if (s < m_bsdf_sampling_fraction)
+    {
+        // Sample the BSDF.
+        bsdf.sample(
+            sampling_context,
+            bsdf_data,
+            adjoint,
+            true,       // multiply by |cos(incoming, normal)|
+            local_geometry,
+            outgoing,
+            modes,
+            sample);
+
+        if (sample.get_mode() == ScatteringMode::None)
+            return 0.0f;
+
+        // Specular directions can only be chosen by this strategy.
+        if (sample.get_mode() == ScatteringMode::Specular)
+        {
+            sample.m_value /= m_bsdf_sampling_fraction;
+            return BSDF::DiracDelta;
+        }
+
+        const float bsdf_pdf = sample.get_probability();
+        const float pdf =
+              m_bsdf_sampling_fraction * bsdf_pdf
+            + (1.0f - m_bsdf_sampling_fraction) * dtree->evaluate_pdf(sample.m_incoming.get_value());
+
+        sample.m_value *= bsdf_pdf / pdf;
+
+        return pdf;
+    }
+    else
+    {
+        // Let the BSDF provide the AOV components it would have provided without guiding.
+        if (compute_aovs)
+        {
+            BSDFSample aov_sample;
+            bsdf.sample(
+                sampling_context,
+                bsdf_data,
+                adjoint,
+                true,       // multiply by |cos(incoming, normal)|
+                local_geometry,
+                outgoing,
+                modes,
+                aov_sample);
+            sample.m_aov_components = aov_sample.m_aov_components;
+        }
+
+        // Sample the SD-tree.
+        sampling_context.split_in_place(2, 1);
+        float guided_pdf;
+        const Vector3f incoming = dtree->sample(sampling_context.next2<Vector2f>(), guided_pdf);
+
+        // Evaluate the non-specular components of the BSDF in that direction.
+        const float bsdf_pdf =
+            bsdf.evaluate(
+                bsdf_data,
+                adjoint,
+                true,       // multiply by |cos(incoming, normal)|
+                local_geometry,
+                outgoing.get_value(),
+                incoming,
+                guided_modes,
+                sample.m_value);
+
+        if (bsdf_pdf == 0.0f)
+        {
+            sample.set_to_absorption();
+            return 0.0f;
+        }
+
+        const float pdf =
+              m_bsdf_sampling_fraction * bsdf_pdf
+            + (1.0f - m_bsdf_sampling_fraction) * guided_pdf;
+
+        sample.set_to_scattering(
+            (guided_modes & ScatteringMode::Diffuse) != 0 ? ScatteringMode::Diffuse : ScatteringMode::Glossy,
+            bsdf_pdf);
+        sample.m_incoming = Dual3f(incoming);
+        sample.m_value *= bsdf_pdf / pdf;
+
+        ++m_guided_sample_count;
+
+        return pdf;
+    }
+}
+
+void GuidedPath::add_vertex(
+    const Vector3d&                     point,
+    const Vector3f&                     incoming,
+    const Spectrum&                     throughput,
+    const float                         pdf)
+{
+    assert(m_path_radiance);
+    assert(pdf > 0.0f);
+
+    if (m_vertex_count == MaxVertexCount)
+        return;
+
+    Vertex& vertex = m_vertices[m_vertex_count++];
+    vertex.m_point = point;
+    vertex.m_incoming = incoming;
+    vertex.m_throughput = throughput;
+    vertex.m_radiance = m_path_radiance->m_beauty;
+    vertex.m_pdf = pdf;
+}
+
+}   // namespace renderer
@@ -0,0 +1,132 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/modeling/bsdf/bsdf.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/dual.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace renderer  { class BSDFSample; }
+namespace renderer  { class SDTree; }
+namespace renderer  { class ShadingComponents; }
+
+namespace renderer
+{
+
+//
+// Path guiding state of the paths traced by a path tracer, one path at a time.
+//
+// Directions at non-specular surface vertices are chosen either by sampling the BSDF
+// or by sampling the incident radiance distribution learned by an SD-tree, and are
+// weighted by the one-sample MIS mixture of both densities. Scattering events are
+// remembered so that the radiance eventually carried by the path can be recorded
+// into the SD-tree once the path is complete.
+//
+
+class GuidedPath
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    GuidedPath(
+        SDTree&                             sd_tree,
+        const float                         bsdf_sampling_fraction);
+
+    // Begin a new path. `path_radiance` is the radiance accumulated by the path tracer.
+    void begin_path(const ShadingComponents& path_radiance);
+
+    // Record the radiance received by each scattering event of the path into the SD-tree.
+    void end_path();
+
+    // Choose an incoming direction at a surface vertex. On return, the value of the
+    // sample is already corrected so that dividing it by its probability yields the
+    // MIS-weighted contribution; its probability remains the BSDF probability so that
+    // it can be used for MIS against light sampling. Return the probability density
+    // with which the direction was actually chosen.
+    float sample(
+        SamplingContext&                    sampling_context,
+        const BSDF&                         bsdf,
+        const void*                         bsdf_data,
+        const bool                          adjoint,
+        const BSDF::LocalGeometry&          local_geometry,
+        const foundation::Dual3f&           outgoing,
+        const int                           modes,
+        const bool                          compute_aovs,
+        BSDFSample&                         sample);
+
+    // Remember a non-specular scattering event.
+    void add_vertex(
+        const foundation::Vector3d&         point,
+        const foundation::Vector3f&         incoming,
+        const Spectrum&                     throughput,     // path throughput after scattering
+        const float                         pdf);           // probability density of the incoming direction
+
+    // Return the number of directions chosen by sampling the SD-tree.
+    size_t get_guided_sample_count() const;
+
+  private:
+    struct Vertex
+    {
+        foundation::Vector3d                m_point;
+        foundation::Vector3f                m_incoming;
+        Spectrum                            m_throughput;
+        Spectrum                            m_radiance;     // path radiance when the vertex was added
+        float                               m_pdf;
+    };
+
+    enum { MaxVertexCount = 16 };
+
+    SDTree&                                 m_sd_tree;
+    const float                             m_bsdf_sampling_fraction;
+    const ShadingComponents*                m_path_radiance;
+    Vertex                                  m_vertices[MaxVertexCount];
+    size_t                                  m_vertex_count;
+    size_t                                  m_guided_sample_count;
+};
+
+
+//
+// GuidedPath class implementation.
+//
+
+inline size_t GuidedPath::get_guided_sample_count() const
+{
+    return m_guided_sample_count;
+}
+
+}   // namespace renderer
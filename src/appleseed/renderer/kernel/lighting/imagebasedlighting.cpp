@@ -32,6 +32,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/lighting/lightpathstream.h"
+#include "renderer/kernel/lighting/lightportals.h"
 #include "renderer/kernel/lighting/materialsamplers.h"
 #include "renderer/kernel/lighting/tracer.h"
 #include "renderer/kernel/shading/directshadingcomponents.h"
@@ -58,6 +59,7 @@ void compute_ibl_combined_sampling(
     SamplingContext&            sampling_context,
     const ShadingContext&       shading_context,
     const EnvironmentEDF&       environment_edf,
+    const LightPortals*         light_portals,
     const Dual3d&               outgoing,
     const IMaterialSampler&     material_sampler,
     const int                   env_sampling_modes,
@@ -73,6 +75,7 @@ void compute_ibl_combined_sampling(
         sampling_context,
         shading_context,
         environment_edf,
+        light_portals,
         outgoing,
         material_sampler,
         material_sample_count,
@@ -85,6 +88,7 @@ void compute_ibl_combined_sampling(
         sampling_context,
         shading_context,
         environment_edf,
+        light_portals,
         outgoing,
         material_sampler,
         env_sampling_modes,
@@ -99,6 +103,7 @@ void compute_ibl_material_sampling(
     SamplingContext&            sampling_context,
     const ShadingContext&       shading_context,
     const EnvironmentEDF&       environment_edf,
+    const LightPortals*         light_portals,
     const Dual3d&               outgoing,
     const IMaterialSampler&     material_sampler,
     const size_t                bsdf_sample_count,
@@ -148,6 +153,10 @@ void compute_ibl_material_sampling(
             env_value,
             env_prob);
 
+        // When sampling through light portals, the environment is sampled with the portals' density.
+        if (light_portals)
+            env_prob = light_portals->evaluate_pdf(material_sampler.get_point(), incoming.get_value());
+
         // Apply all weights, including MIS weight.
         if (material_prob == BSDF::DiracDelta)
             env_value *= transmission;
@@ -173,6 +182,7 @@ void compute_ibl_environment_sampling(
     SamplingContext&            sampling_context,
     const ShadingContext&       shading_context,
     const EnvironmentEDF&       environment_edf,
+    const LightPortals*         light_portals,
     const Dual3d&               outgoing,
     const IMaterialSampler&     material_sampler,
     const int                   env_sampling_modes,
@@ -200,14 +210,34 @@ void compute_ibl_environment_sampling(
         Vector3f incoming;
         Spectrum env_value(Spectrum::Illuminance);
         float env_prob;
-        environment_edf.sample(
-            shading_context,
-            s,
-            incoming,
-            env_value,
-            env_prob);
+        if (light_portals)
+        {
+            // Sample a direction through the light portals and look up the environment in that direction.
+            if (!light_portals->sample(material_sampler.get_point(), s, incoming, env_prob))
+                continue;
+
+            float unused_prob;
+            environment_edf.evaluate(
+                shading_context,
+                incoming,
+                env_value,
+                unused_prob);
+        }
+        else
+        {
+            environment_edf.sample(
+                shading_context,
+                s,
+                incoming,
+                env_value,
+                env_prob);
+        }
         assert(is_normalized(incoming));
 
+        // Skip samples of zero probability, such as infinite points of the environment.
+        if (env_prob == 0.0f)
+            continue;
+
         // Compute the transmission factor between the environment and the shading point.
         Spectrum transmission;
         if (environment_edf.get_flags() & EnvironmentEDF::CastShadows)
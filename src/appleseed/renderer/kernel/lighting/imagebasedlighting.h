@@ -45,6 +45,7 @@ namespace renderer  { class DirectShadingComponents; }
 namespace renderer  { class EnvironmentEDF; }
 namespace renderer  { class IMaterialSampler; }
 namespace renderer  { class LightPathStream; }
+namespace renderer  { class LightPortals; }
 namespace renderer  { class ShadingContext; }
 namespace renderer  { class ShadingPoint; }
 
@@ -60,6 +61,7 @@ void compute_ibl_combined_sampling(
     SamplingContext&                sampling_context,
     const ShadingContext&           shading_context,
     const EnvironmentEDF&           environment_edf,
+    const LightPortals*             light_portals,          // portals through which the environment is sampled, or nullptr
     const foundation::Dual3d&       outgoing,               // world space outgoing direction, unit-length
     const IMaterialSampler&         material_sampler,
     const int                       env_sampling_modes,     // permitted scattering modes during environment sampling
@@ -73,6 +75,7 @@ void compute_ibl_material_sampling(
     SamplingContext&                sampling_context,
     const ShadingContext&           shading_context,
     const EnvironmentEDF&           environment_edf,
+    const LightPortals*             light_portals,          // portals through which the environment is sampled, or nullptr
     const foundation::Dual3d&       outgoing,               // world space outgoing direction, unit-length
     const IMaterialSampler&         material_sampler,
     const size_t                    material_sample_count,  // number of samples in BSDF sampling
@@ -84,6 +87,7 @@ void compute_ibl_environment_sampling(
     SamplingContext&                sampling_context,
     const ShadingContext&           shading_context,
     const EnvironmentEDF&           environment_edf,
+    const LightPortals*             light_portals,          // portals through which the environment is sampled, or nullptr
     const foundation::Dual3d&       outgoing,               // world space outgoing direction, unit-length
     const IMaterialSampler&         material_sampler,
     const int                       env_sampling_modes,     // permitted scattering modes during environment sampling
@@ -0,0 +1,219 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "lightimportancecache.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/atomic.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// LightImportanceCache class implementation.
+//
+
+LightImportanceCache::LightImportanceCache(
+    const AABB3d&               bbox,
+    const std::vector<float>&   group_probs,
+    const size_t                resolution,
+    const size_t                learning_sample_count,
+    const float                 learned_fraction)
+  : m_group_probs(group_probs)
+  , m_group_count(group_probs.size())
+  , m_resolution(resolution)
+  , m_learning_sample_count(static_cast<std::uint32_t>(learning_sample_count))
+  , m_learned_fraction(learned_fraction)
+  , m_origin(0.0)
+  , m_rcp_cell_size(0.0)
+{
+    assert(m_group_count > 0);
+    assert(m_resolution > 0);
+    assert(m_learning_sample_count > 0);
+    assert(m_learned_fraction >= 0.0f && m_learned_fraction < 1.0f);
+
+    if (bbox.is_valid())
+    {
+        const Vector3d extent = bbox.extent();
+
+        m_origin = bbox.min;
+
+        for (size_t i = 0; i < 3; ++i)
+        {
+            m_rcp_cell_size[i] =
+                extent[i] > 0.0
+                    ? static_cast<double>(m_resolution) / extent[i]
+                    : 0.0;
+        }
+    }
+
+    const size_t cell_count = m_resolution * m_resolution * m_resolution;
+
+    m_cell_states.assign(cell_count, Learning);
+    m_cell_sample_counts.assign(cell_count, 0);
+    m_contributions.assign(cell_count * m_group_count, 0.0f);
+    m_probs.resize(cell_count * m_group_count);
+    m_cdfs.resize(cell_count * m_group_count);
+}
+
+size_t LightImportanceCache::get_cell_index(const Vector3d& point) const
+{
+    const double max_coord = static_cast<double>(m_resolution - 1);
+
+    size_t coords[3];
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const double x = std::floor((point[i] - m_origin[i]) * m_rcp_cell_size[i]);
+        coords[i] = static_cast<size_t>(std::min(std::max(x, 0.0), max_coord));
+    }
+
+    return (coords[2] * m_resolution + coords[1]) * m_resolution + coords[0];
+}
+
+bool LightImportanceCache::is_ready(const size_t cell_index) const
+{
+    assert(cell_index < m_cell_states.size());
+
+    volatile std::uint32_t* state = const_cast<std::uint32_t*>(&m_cell_states[cell_index]);
+
+    return atomic_read(state) == Ready;
+}
+
+size_t LightImportanceCache::sample(
+    const size_t                cell_index,
+    float&                      s,
+    float&                      group_prob) const
+{
+    assert(is_ready(cell_index));
+    assert(s >= 0.0f && s < 1.0f);
+
+    const float* cdf = &m_cdfs[cell_index * m_group_count];
+    const float* probs = &m_probs[cell_index * m_group_count];
+
+    // Find the first group whose cumulated probability exceeds s.
+    const size_t group_index =
+        std::min(
+            static_cast<size_t>(std::upper_bound(cdf, cdf + m_group_count, s) - cdf),
+            m_group_count - 1);
+
+    // Remap s to [0,1) within the chosen group.
+    const float low = group_index > 0 ? cdf[group_index - 1] : 0.0f;
+    const float width = cdf[group_index] - low;
+    s = width > 0.0f ? std::min((s - low) / width, 0.99999994f) : 0.0f;
+
+    group_prob = probs[group_index];
+    assert(group_prob > 0.0f);
+
+    return group_index;
+}
+
+float LightImportanceCache::evaluate(
+    const size_t                cell_index,
+    const size_t                group_index) const
+{
+    assert(is_ready(cell_index));
+    assert(group_index < m_group_count);
+
+    return m_probs[cell_index * m_group_count + group_index];
+}
+
+void LightImportanceCache::record(
+    const size_t                cell_index,
+    const size_t                group_index,
+    const float                 contribution)
+{
+    assert(cell_index < m_cell_states.size());
+    assert(group_index < m_group_count);
+
+    if (atomic_read(&m_cell_states[cell_index]) != Learning)
+        return;
+
+    if (contribution > 0.0f)
+        atomic_add(&m_contributions[cell_index * m_group_count + group_index], contribution);
+
+    // The thread that records the last learning sample builds the distribution.
+    const std::uint32_t previous_count = atomic_inc(&m_cell_sample_counts[cell_index]);
+    if (previous_count + 1 == m_learning_sample_count &&
+        atomic_cas(&m_cell_states[cell_index], Learning, Building) == Learning)
+    {
+        build_distribution(cell_index);
+        atomic_write(&m_cell_states[cell_index], Ready);
+    }
+}
+
+void LightImportanceCache::build_distribution(const size_t cell_index)
+{
+    const float* contributions = &m_contributions[cell_index * m_group_count];
+    float* probs = &m_probs[cell_index * m_group_count];
+    float* cdf = &m_cdfs[cell_index * m_group_count];
+
+    float total_contribution = 0.0f;
+    for (size_t i = 0; i < m_group_count; ++i)
+        total_contribution += contributions[i];
+
+    // Mix the learned distribution with the default one. If nothing contributed,
+    // there is nothing to learn and the default distribution is kept as is.
+    float total_prob = 0.0f;
+    for (size_t i = 0; i < m_group_count; ++i)
+    {
+        float prob = m_group_probs[i];
+
+        if (total_contribution > 0.0f)
+        {
+            prob =
+                  (1.0f - m_learned_fraction) * prob
+                + m_learned_fraction * (contributions[i] / total_contribution);
+        }
+
+        probs[i] = prob;
+        total_prob += prob;
+    }
+
+    assert(total_prob > 0.0f);
+
+    float cumulated_prob = 0.0f;
+    for (size_t i = 0; i < m_group_count; ++i)
+    {
+        probs[i] /= total_prob;
+        cumulated_prob += probs[i];
+        cdf[i] = cumulated_prob;
+    }
+
+    cdf[m_group_count - 1] = 1.0f;
+}
+
+}   // namespace renderer
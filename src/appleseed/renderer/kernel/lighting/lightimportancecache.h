@@ -0,0 +1,135 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A spatial cache of light importance.
+//
+// The bounding box of the scene is divided into a regular grid of cells. Each cell
+// starts by recording the contributions of light samples chosen with the default
+// light distribution. Once enough samples have been recorded, the cell switches,
+// once and for all, to a learned distribution over light groups that favors the
+// groups that actually contributed (i.e. were visible) from that cell.
+//
+// The learned distribution is always mixed with the default one, so that every
+// light group keeps a nonzero probability and the estimator remains unbiased.
+//
+
+class LightImportanceCache
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. `group_probs` are the probabilities of the light groups under
+    // the default light distribution and must sum to one.
+    LightImportanceCache(
+        const foundation::AABB3d&       bbox,
+        const std::vector<float>&       group_probs,
+        const size_t                    resolution = 16,
+        const size_t                    learning_sample_count = 256,
+        const float                     learned_fraction = 0.75f);
+
+    // Return the number of light groups.
+    size_t get_group_count() const;
+
+    // Return the index of the cell containing a given point.
+    // Points outside the bounding box are assigned to the closest cell.
+    size_t get_cell_index(const foundation::Vector3d& point) const;
+
+    // Return true if the learned distribution of a given cell is available.
+    bool is_ready(const size_t cell_index) const;
+
+    // Choose a light group using the learned distribution of a ready cell.
+    // `s` is remapped to [0,1) so that it can be used to sample within the group.
+    size_t sample(
+        const size_t                    cell_index,
+        float&                          s,
+        float&                          group_prob) const;
+
+    // Return the probability of choosing a given light group in a ready cell.
+    float evaluate(
+        const size_t                    cell_index,
+        const size_t                    group_index) const;
+
+    // Record the contribution of a light sample chosen with the default distribution.
+    // Samples recorded in cells that are no longer learning are ignored.
+    void record(
+        const size_t                    cell_index,
+        const size_t                    group_index,
+        const float                     contribution);
+
+  private:
+    enum CellState : std::uint32_t
+    {
+        Learning,
+        Building,
+        Ready
+    };
+
+    const std::vector<float>            m_group_probs;
+    const size_t                        m_group_count;
+    const size_t                        m_resolution;
+    const std::uint32_t                 m_learning_sample_count;
+    const float                         m_learned_fraction;
+
+    foundation::Vector3d                m_origin;
+    foundation::Vector3d                m_rcp_cell_size;
+
+    std::vector<std::uint32_t>          m_cell_states;
+    std::vector<std::uint32_t>          m_cell_sample_counts;
+    std::vector<float>                  m_contributions;    // per cell, per group
+    std::vector<float>                  m_probs;            // per cell, per group
+    std::vector<float>                  m_cdfs;             // per cell, per group
+
+    void build_distribution(const size_t cell_index);
+};
+
+
+//
+// LightImportanceCache class implementation.
+//
+
+inline size_t LightImportanceCache::get_group_count() const
+{
+    return m_group_count;
+}
+
+}   // namespace renderer
@@ -41,6 +41,7 @@
 #include "foundation/memory/memory.h"
 #include "foundation/platform/defaulttimers.h"
 #include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/bufferedfile.h"
@@ -81,6 +82,12 @@ struct LightPathRecorder::Impl
     size_t                                   m_render_height;
     std::vector<IndexEntry>                  m_index;
 
+    // Paths of all streams, with vertex indices relative to the whole recorder.
+    std::vector<LightPathStream::StoredPath> m_paths;
+
+    // Index of the first vertex of each stream, plus the total vertex count.
+    std::vector<size_t>                      m_vertex_bases;
+
     explicit Impl(const Project& project)
       : m_project(project)
     {
@@ -103,11 +110,13 @@ void LightPathRecorder::clear()
         stream->clear();
 
     clear_release_memory(impl->m_index);
+    clear_release_memory(impl->m_paths);
+    clear_release_memory(impl->m_vertex_bases);
 }
 
 size_t LightPathRecorder::get_light_path_count() const
 {
-    size_t count = 0;
+    size_t count = impl->m_paths.size();
 
     for (const auto& stream : impl->m_streams)
         count += stream->m_paths.size();
@@ -117,10 +126,7 @@ size_t LightPathRecorder::get_light_path_count() const
 
 size_t LightPathRecorder::get_vertex_count() const
 {
-    assert(impl->m_streams.size() == 1);
-    const LightPathStream* stream = impl->m_streams[0].get();
-
-    return stream->m_vertices.size();
+    return impl->m_vertex_bases.empty() ? 0 : impl->m_vertex_bases.back();
 }
 
 LightPathStream* LightPathRecorder::create_stream()
@@ -143,49 +149,35 @@ void LightPathRecorder::finalize(
     if (impl->m_streams.empty())
         return;
 
-    // Merge all streams into the first one.
-    if (impl->m_streams.size() > 1)
-    {
-        const size_t light_path_count = get_light_path_count();
-
-        RENDERER_LOG_INFO("merging %s light path streams (%s light path%s)...",
-            pretty_uint(impl->m_streams.size()).c_str(),
-            pretty_uint(light_path_count).c_str(),
-            light_path_count > 1 ? "s" : "");
-
-        for (size_t i = 1, e = impl->m_streams.size(); i < e; ++i)
-        {
-            merge_streams(
-                *impl->m_streams[0],
-                *impl->m_streams[i]);
-        }
-
-        impl->m_streams.resize(1);
-    }
-
-    // Retrieve the first and only stream.
-    LightPathStream* stream = impl->m_streams[0].get();
+    // Gather the paths of all streams. Vertices stay in their stream (in memory or spilled to disk).
+    const size_t total_light_path_count = get_light_path_count();
+    RENDERER_LOG_INFO("merging %s light path stream%s (%s light path%s)...",
+        pretty_uint(impl->m_streams.size()).c_str(),
+        impl->m_streams.size() > 1 ? "s" : "",
+        pretty_uint(total_light_path_count).c_str(),
+        total_light_path_count > 1 ? "s" : "");
+    merge_streams();
 
     // Remove paths that end outside of the frame.
-    RENDERER_LOG_INFO("filtering light path%s...", stream->m_paths.size() > 1 ? "s" : "");
-    stream->m_paths.erase(
+    RENDERER_LOG_INFO("filtering light path%s...", impl->m_paths.size() > 1 ? "s" : "");
+    impl->m_paths.erase(
         remove_if(
-            stream->m_paths.begin(),
-            stream->m_paths.end(),
+            impl->m_paths.begin(),
+            impl->m_paths.end(),
             [render_width, render_height](const LightPathStream::StoredPath& p)
             {
                 return
                     p.m_pixel_coords.x >= render_width ||
                     p.m_pixel_coords.y >= render_height;
             }),
-        stream->m_paths.end());
-    const auto light_path_count = stream->m_paths.size();
+        impl->m_paths.end());
+    const auto light_path_count = impl->m_paths.size();
 
     // Sort paths by pixel coordinates.
     RENDERER_LOG_INFO("sorting light path%s...", light_path_count > 1 ? "s" : "");
     sort(
-        stream->m_paths.begin(),
-        stream->m_paths.end(),
+        impl->m_paths.begin(),
+        impl->m_paths.end(),
         [](const LightPathStream::StoredPath& lhs,
            const LightPathStream::StoredPath& rhs)
         {
@@ -202,10 +194,10 @@ void LightPathRecorder::finalize(
         index_entry.m_begin_path = ~size_t(0);
         index_entry.m_end_path = ~size_t(0);
     }
-    for (size_t i = 0, e = stream->m_paths.size(); i < e; ++i)
+    for (size_t i = 0, e = impl->m_paths.size(); i < e; ++i)
     {
         // Retrieve index entry.
-        const auto& path = stream->m_paths[i];
+        const auto& path = impl->m_paths[i];
         const auto x = path.m_pixel_coords.x;
         const auto y = path.m_pixel_coords.y;
         auto& index_entry = impl->m_index[y * render_width + x];
@@ -229,9 +221,6 @@ void LightPathRecorder::query(
     const size_t        y1,
     LightPathArray&     result) const
 {
-    assert(impl->m_streams.size() == 1);
-    const LightPathStream* stream = impl->m_streams[0].get();
-
     for (size_t y = y0; y <= y1; ++y)
     {
         for (size_t x = x0; x <= x1; ++x)
@@ -240,15 +229,15 @@ void LightPathRecorder::query(
 
             for (size_t p = index_entry.m_begin_path; p < index_entry.m_end_path; ++p)
             {
-                const auto& source_path = stream->m_paths[p];
+                const auto& source_path = impl->m_paths[p];
 
                 LightPath path;
                 path.m_pixel_coords[0] = source_path.m_pixel_coords[0];
                 path.m_pixel_coords[1] = source_path.m_pixel_coords[1];
                 path.m_sample_position[0] = source_path.m_sample_position[0];
                 path.m_sample_position[1] = source_path.m_sample_position[1];
-                path.m_vertex_begin_index = source_path.m_vertex_begin_index;
-                path.m_vertex_end_index = source_path.m_vertex_end_index;
+                path.m_vertex_begin_index = static_cast<size_t>(source_path.m_vertex_begin_index);
+                path.m_vertex_end_index = static_cast<size_t>(source_path.m_vertex_end_index);
 
                 result.push_back(path);
             }
@@ -260,11 +249,23 @@ void LightPathRecorder::get_light_path_vertex(
     const size_t        index,
     LightPathVertex&    result) const
 {
-    assert(impl->m_streams.size() == 1);
-    const LightPathStream* stream = impl->m_streams[0].get();
+    assert(index < get_vertex_count());
 
-    assert(index < stream->m_vertices.size());
-    const auto& source_vertex = stream->m_vertices[index];
+    // Find the stream holding this vertex.
+    const auto& bases = impl->m_vertex_bases;
+    const size_t stream_index =
+        static_cast<size_t>(std::upper_bound(bases.begin(), bases.end(), index) - bases.begin()) - 1;
+    const LightPathStream* stream = impl->m_streams[stream_index].get();
+
+    LightPathStream::StoredPathVertex source_vertex;
+    if (!stream->read_vertices(index - bases[stream_index], index - bases[stream_index] + 1, &source_vertex))
+    {
+        RENDERER_LOG_ERROR("failed to read light path vertex " FMT_SIZE_T ".", index);
+        result.m_entity = nullptr;
+        result.m_position[0] = result.m_position[1] = result.m_position[2] = 0.0f;
+        result.m_radiance[0] = result.m_radiance[1] = result.m_radiance[2] = 0.0f;
+        return;
+    }
 
     result.m_entity = source_vertex.m_entity;
 
@@ -288,10 +289,7 @@ bool LightPathRecorder::write(const char* filename) const
     Stopwatch<DefaultWallclockTimer> stopwatch;
     stopwatch.start();
 
-    // Retrieve the first and only stream.
-    assert(impl->m_streams.size() == 1);
-    const LightPathStream* stream = impl->m_streams[0].get();
-    const size_t light_path_count = stream->m_paths.size();
+    const size_t light_path_count = impl->m_paths.size();
 
     try
     {
@@ -350,20 +348,34 @@ bool LightPathRecorder::write(const char* filename) const
         // Collect entity names and build (entity name -> name index) dictionary.
         std::vector<std::string> entity_names;
         std::map<const Entity*, std::uint16_t> entity_name_to_index;
-        for (const auto& vertex : stream->m_vertices)
+        std::vector<LightPathStream::StoredPathVertex> vertices;
+        for (const auto& stream : impl->m_streams)
         {
-            if (entity_name_to_index.find(vertex.m_entity) == entity_name_to_index.end())
+            // Vertices may have been spilled to disk: scan them chunk by chunk.
+            const size_t vertex_count = stream->get_vertex_count();
+            for (size_t begin = 0; begin < vertex_count; begin += LightPathStream::SpillThreshold)
             {
-                // Insert a new (entity name -> name index) entry into the dictionary.
-                assert(entity_names.size() < 65536);
-                entity_name_to_index.insert(
-                    std::make_pair(
-                        vertex.m_entity,
-                        static_cast<std::uint16_t>(entity_names.size())));
-
-                // Insert the entity name into the vector.
-                entity_names.push_back(
-                    to_string(vertex.m_entity->get_path()));
+                const size_t end = std::min(begin + LightPathStream::SpillThreshold, vertex_count);
+                vertices.resize(end - begin);
+                if (!stream->read_vertices(begin, end, vertices.data()))
+                    throw ExceptionIOError("failed to read spilled light path vertices");
+
+                for (const auto& vertex : vertices)
+                {
+                    if (entity_name_to_index.find(vertex.m_entity) == entity_name_to_index.end())
+                    {
+                        // Insert a new (entity name -> name index) entry into the dictionary.
+                        assert(entity_names.size() < 65536);
+                        entity_name_to_index.insert(
+                            std::make_pair(
+                                vertex.m_entity,
+                                static_cast<std::uint16_t>(entity_names.size())));
+
+                        // Insert the entity name into the vector.
+                        entity_names.push_back(
+                            to_string(vertex.m_entity->get_path()));
+                    }
+                }
             }
         }
 
@@ -378,7 +390,7 @@ bool LightPathRecorder::write(const char* filename) const
         }
 
         // Write paths.
-        for (const auto& path : stream->m_paths)
+        for (const auto& path : impl->m_paths)
         {
             // Retrieve index entry.
             const auto x = path.m_pixel_coords.x;
@@ -402,10 +414,18 @@ bool LightPathRecorder::write(const char* filename) const
             assert(vertex_count < 65536);
             checked_write(file, static_cast<std::uint16_t>(vertex_count));
 
+            // Fetch path vertices. All vertices of a path belong to the same stream.
+            const auto& bases = impl->m_vertex_bases;
+            const size_t stream_index =
+                static_cast<size_t>(std::upper_bound(bases.begin(), bases.end(), path.m_vertex_begin_index) - bases.begin()) - 1;
+            const size_t stream_begin = static_cast<size_t>(path.m_vertex_begin_index) - bases[stream_index];
+            vertices.resize(vertex_count);
+            if (!impl->m_streams[stream_index]->read_vertices(stream_begin, stream_begin + vertex_count, vertices.data()))
+                throw ExceptionIOError("failed to read spilled light path vertices");
+
             // Write path vertices.
-            for (auto i = path.m_vertex_begin_index; i < path.m_vertex_end_index; ++i)
+            for (const auto& vertex : vertices)
             {
-                const auto& vertex = stream->m_vertices[i];
 
                 // Entity name index.
                 const auto it = entity_name_to_index.find(vertex.m_entity);
@@ -453,33 +473,34 @@ bool LightPathRecorder::write(const char* filename) const
     }
 }
 
-void LightPathRecorder::merge_streams(
-    LightPathStream&    dest,
-    LightPathStream&    source)
+void LightPathRecorder::merge_streams()
 {
-    const size_t old_size = dest.m_paths.size();
-
-    dest.m_paths.insert(
-        dest.m_paths.end(),
-        source.m_paths.begin(),
-        source.m_paths.end());
+    // Paths gathered by a previous call are kept: their vertex indices remain valid
+    // since streams are never removed and only grow at the end.
+    clear_keep_memory(impl->m_vertex_bases);
 
-    clear_release_memory(source.m_paths);
+    impl->m_paths.reserve(get_light_path_count());
+    impl->m_vertex_bases.reserve(impl->m_streams.size() + 1);
 
-    const auto vertex_index_shift = static_cast<std::uint32_t>(dest.m_vertices.size());
+    size_t vertex_base = 0;
 
-    for (size_t i = old_size, e = dest.m_paths.size(); i < e; ++i)
+    for (auto& stream : impl->m_streams)
     {
-        dest.m_paths[i].m_vertex_begin_index += vertex_index_shift;
-        dest.m_paths[i].m_vertex_end_index += vertex_index_shift;
-    }
+        impl->m_vertex_bases.push_back(vertex_base);
+
+        for (auto path : stream->m_paths)
+        {
+            path.m_vertex_begin_index += vertex_base;
+            path.m_vertex_end_index += vertex_base;
+            impl->m_paths.push_back(path);
+        }
+
+        clear_release_memory(stream->m_paths);
 
-    dest.m_vertices.insert(
-        dest.m_vertices.end(),
-        source.m_vertices.begin(),
-        source.m_vertices.end());
+        vertex_base += stream->get_vertex_count();
+    }
 
-    clear_release_memory(source.m_vertices);
+    impl->m_vertex_bases.push_back(vertex_base);
 }
 
 }   // namespace renderer
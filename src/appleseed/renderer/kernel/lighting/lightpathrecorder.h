@@ -73,7 +73,7 @@ struct LightPathVertex
 
 //
 // This class allows to
-//   - create per-thread streams to collect light paths in memory
+//   - create per-thread streams to collect light paths (spilling vertices to disk as needed)
 //   - query and retrieve light paths
 //   - write light paths to disk using an efficient binary format
 //
@@ -99,7 +99,7 @@ class APPLESEED_DLLSYMBOL LightPathRecorder
     // Thread-safe. Returns a non-owning pointer.
     LightPathStream* create_stream();
 
-    // Merge all streams into one and build the index.
+    // Gather the paths of all streams and build the index.
     void finalize(
         const size_t        render_width,
         const size_t        render_height);
@@ -136,11 +136,8 @@ class APPLESEED_DLLSYMBOL LightPathRecorder
     struct Impl;
     Impl* impl;
 
-    // Merge `source` into `dest` and clear `source`.
-    // Being a static method of `LightPathRecorder` grants it access to the internals of `LightPathStream`.
-    static void merge_streams(
-        LightPathStream&    dest,
-        LightPathStream&    source);
+    // Move the paths of all streams into a single list and compute per-stream vertex bases.
+    void merge_streams();
 };
 
 
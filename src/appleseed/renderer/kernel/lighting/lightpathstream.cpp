@@ -50,6 +50,7 @@
 #include "foundation/utility/otherwise.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 
 using namespace foundation;
@@ -57,11 +58,32 @@ using namespace foundation;
 namespace renderer
 {
 
+namespace
+{
+    bool seek(std::FILE* file, const std::uint64_t offset, const int origin)
+    {
+#ifdef _WIN32
+        return _fseeki64(file, static_cast<__int64>(offset), origin) == 0;
+#else
+        return fseeko(file, static_cast<off_t>(offset), origin) == 0;
+#endif
+    }
+}
+
 LightPathStream::LightPathStream(const Project& project)
   : m_scene(*project.get_scene())   // at this time the scene's render data are not available
+  , m_spill_file(nullptr)
+  , m_spill_failed(false)
+  , m_spilled_vertex_count(0)
 {
 }
 
+LightPathStream::~LightPathStream()
+{
+    if (m_spill_file != nullptr)
+        std::fclose(m_spill_file);
+}
+
 void LightPathStream::clear()
 {
     clear_release_memory(m_events);
@@ -72,6 +94,15 @@ void LightPathStream::clear()
 
     clear_release_memory(m_paths);
     clear_release_memory(m_vertices);
+
+    if (m_spill_file != nullptr)
+    {
+        std::fclose(m_spill_file);
+        m_spill_file = nullptr;
+    }
+
+    m_spill_failed = false;
+    m_spilled_vertex_count = 0;
 }
 
 void LightPathStream::begin_path(
@@ -227,6 +258,82 @@ void LightPathStream::end_path()
     clear_keep_memory(m_hit_emitter_data);
     clear_keep_memory(m_sampled_emitter_data);
     clear_keep_memory(m_sampled_env_data);
+
+    // Only spill at path boundaries so that all our paths have a contiguous range of vertices.
+    if (m_vertices.size() >= SpillThreshold)
+        spill_vertices();
+}
+
+size_t LightPathStream::get_vertex_count() const
+{
+    return m_spilled_vertex_count + m_vertices.size();
+}
+
+void LightPathStream::spill_vertices()
+{
+    // Keep everything in memory if we failed to create or write the spill file.
+    if (m_spill_failed)
+        return;
+
+    if (m_spill_file == nullptr)
+    {
+        m_spill_file = std::tmpfile();
+
+        if (m_spill_file == nullptr)
+        {
+            m_spill_failed = true;
+            return;
+        }
+    }
+
+    // Always append to the end of the file, reads may have moved the file position.
+    if (!seek(m_spill_file, 0, SEEK_END) ||
+        std::fwrite(m_vertices.data(), sizeof(StoredPathVertex), m_vertices.size(), m_spill_file) != m_vertices.size())
+    {
+        // Any partially written record lies beyond m_spilled_vertex_count and will never be read.
+        m_spill_failed = true;
+        return;
+    }
+
+    m_spilled_vertex_count += m_vertices.size();
+    clear_keep_memory(m_vertices);
+}
+
+bool LightPathStream::read_vertices(
+    const size_t            begin,
+    const size_t            end,
+    StoredPathVertex*       vertices) const
+{
+    assert(begin <= end);
+    assert(end <= get_vertex_count());
+
+    size_t i = begin;
+
+    // Spilled vertices.
+    if (i < m_spilled_vertex_count)
+    {
+        assert(m_spill_file != nullptr);
+
+        const size_t count = std::min(end, m_spilled_vertex_count) - i;
+
+        if (!seek(m_spill_file, static_cast<std::uint64_t>(i) * sizeof(StoredPathVertex), SEEK_SET) ||
+            std::fread(vertices, sizeof(StoredPathVertex), count, m_spill_file) != count)
+            return false;
+
+        vertices += count;
+        i += count;
+    }
+
+    // In-memory vertices.
+    if (i < end)
+    {
+        std::copy(
+            m_vertices.begin() + (i - m_spilled_vertex_count),
+            m_vertices.begin() + (end - m_spilled_vertex_count),
+            vertices);
+    }
+
+    return true;
 }
 
 void LightPathStream::create_path_from_hit_emitter(const size_t emitter_event_index)
@@ -238,7 +345,7 @@ void LightPathStream::create_path_from_hit_emitter(const size_t emitter_event_in
     StoredPath stored_path;
     stored_path.m_pixel_coords = Vector2u16(m_pixel_coords);
     stored_path.m_sample_position = m_sample_position;
-    stored_path.m_vertex_begin_index = static_cast<std::uint32_t>(m_vertices.size());
+    stored_path.m_vertex_begin_index = static_cast<std::uint64_t>(get_vertex_count());
 
     // Emitter vertex.
     StoredPathVertex emitter_vertex;
@@ -292,7 +399,7 @@ void LightPathStream::create_path_from_hit_emitter(const size_t emitter_event_in
     m_vertices.push_back(camera_vertex);
 
     // Store path.
-    stored_path.m_vertex_end_index = static_cast<std::uint32_t>(m_vertices.size());
+    stored_path.m_vertex_end_index = static_cast<std::uint64_t>(get_vertex_count());
     m_paths.push_back(stored_path);
 }
 
@@ -313,7 +420,7 @@ void LightPathStream::create_path_from_sampled_emitter(const size_t emitter_even
     StoredPath stored_path;
     stored_path.m_pixel_coords = Vector2u16(m_pixel_coords);
     stored_path.m_sample_position = m_sample_position;
-    stored_path.m_vertex_begin_index = static_cast<std::uint32_t>(m_vertices.size());
+    stored_path.m_vertex_begin_index = static_cast<std::uint64_t>(get_vertex_count());
 
     // Emitter vertex.
     StoredPathVertex emitter_vertex;
@@ -367,7 +474,7 @@ void LightPathStream::create_path_from_sampled_emitter(const size_t emitter_even
     m_vertices.push_back(camera_vertex);
 
     // Store path.
-    stored_path.m_vertex_end_index = static_cast<std::uint32_t>(m_vertices.size());
+    stored_path.m_vertex_end_index = static_cast<std::uint64_t>(get_vertex_count());
     m_paths.push_back(stored_path);
 }
 
@@ -388,7 +495,7 @@ void LightPathStream::create_path_from_sampled_environment(const size_t env_even
     StoredPath stored_path;
     stored_path.m_pixel_coords = Vector2u16(m_pixel_coords);
     stored_path.m_sample_position = m_sample_position;
-    stored_path.m_vertex_begin_index = static_cast<std::uint32_t>(m_vertices.size());
+    stored_path.m_vertex_begin_index = static_cast<std::uint64_t>(get_vertex_count());
 
     // Emitter vertex.
     StoredPathVertex emitter_vertex;
@@ -442,7 +549,7 @@ void LightPathStream::create_path_from_sampled_environment(const size_t env_even
     m_vertices.push_back(camera_vertex);
 
     // Store path.
-    stored_path.m_vertex_end_index = static_cast<std::uint32_t>(m_vertices.size());
+    stored_path.m_vertex_end_index = static_cast<std::uint64_t>(get_vertex_count());
     m_paths.push_back(stored_path);
 }
 
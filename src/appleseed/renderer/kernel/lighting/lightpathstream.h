@@ -32,12 +32,14 @@
 #include "renderer/global/globaltypes.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/image/color.h"
 #include "foundation/math/vector.h"
 
 // Standard headers.
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <vector>
 
 // Forward declarations.
@@ -56,12 +58,21 @@ namespace renderer
 {
 
 //
-// This class allows a single thread to collect light paths in memory.
+// This class allows a single thread to collect light paths.
+//
+// Path vertices are accumulated in memory and spilled to a temporary file in
+// large chunks so that the memory footprint of a stream remains bounded no
+// matter how many paths are recorded. Spilled vertices are stored as fixed-size
+// records and can therefore still be retrieved by index.
 //
 
 class LightPathStream
+  : public foundation::NonCopyable
 {
   public:
+    // Destructor.
+    ~LightPathStream();
+
     void clear();
 
     void begin_path(
@@ -148,8 +159,8 @@ class LightPathStream
     {
         Vector2u16                  m_pixel_coords;
         foundation::Vector2f        m_sample_position;
-        std::uint32_t               m_vertex_begin_index;       // index of the first vertex in m_vertices
-        std::uint32_t               m_vertex_end_index;         // index of one vertex past the last one in m_vertices
+        std::uint64_t               m_vertex_begin_index;       // index of the first vertex, spilled vertices included
+        std::uint64_t               m_vertex_end_index;         // index of one vertex past the last one, spilled vertices included
     };
 
     struct StoredPathVertex
@@ -178,11 +189,32 @@ class LightPathStream
 
     // Final representation as paths and path vertices (persistent).
     std::vector<StoredPath>         m_paths;
-    std::vector<StoredPathVertex>   m_vertices;
+    std::vector<StoredPathVertex>   m_vertices;                 // vertices that have not been spilled yet
+
+    // Spilled path vertices (persistent).
+    std::FILE*                      m_spill_file;
+    bool                            m_spill_failed;
+    size_t                          m_spilled_vertex_count;
+
+    // Number of vertices accumulated in memory before they get spilled to disk.
+    static const size_t             SpillThreshold = 64 * 1024;
 
     // Constructor.
     explicit LightPathStream(const Project& project);
 
+    // Return the total number of vertices in this stream, spilled vertices included.
+    size_t get_vertex_count() const;
+
+    // Write all in-memory vertices to the spill file.
+    void spill_vertices();
+
+    // Retrieve the vertices [begin, end) of this stream, wherever they are stored.
+    // Not thread-safe. Return true if successful, false otherwise.
+    bool read_vertices(
+        const size_t                begin,
+        const size_t                end,
+        StoredPathVertex*           vertices) const;
+
     void create_path_from_hit_emitter(const size_t emitter_event_index);
     void create_path_from_sampled_emitter(const size_t emitter_event_index);
     void create_path_from_sampled_environment(const size_t env_event_index);
@@ -0,0 +1,286 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "lightportals.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/global/globaltypes.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/transformsequence.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/sampling/sphericalrectanglesampler.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/transform.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/api/apistring.h"
+#include "foundation/utility/foreach.h"
+
+// Standard headers.
+#include <algorithm>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    // Portals subtending a smaller solid angle than this are ignored.
+    const double MinPortalSolidAngle = 1.0e-9;
+
+    template <typename Visitor>
+    void collect_portals(
+        const Assembly&                     assembly,
+        const Transformd&                   assembly_inst_transform,
+        Visitor&                            visitor)
+    {
+        for (const_each<ObjectInstanceContainer> i = assembly.object_instances(); i; ++i)
+        {
+            const ObjectInstance& object_instance = *i;
+
+            if (object_instance.get_parameters().get_optional<bool>("light_portal", false))
+            {
+                const Transformd object_inst_transform =
+                    object_instance.get_transform() * assembly_inst_transform;
+
+                visitor(
+                    object_instance,
+                    object_inst_transform,
+                    AABB3d(object_instance.get_object().compute_local_bbox()));
+            }
+        }
+    }
+
+    template <typename Visitor>
+    void collect_portals(
+        const AssemblyInstanceContainer&    assembly_instances,
+        const Transformd&                   parent_transform,
+        Visitor&                            visitor)
+    {
+        for (const_each<AssemblyInstanceContainer> i = assembly_instances; i; ++i)
+        {
+            const AssemblyInstance& assembly_instance = *i;
+            const Assembly& assembly = assembly_instance.get_assembly();
+
+            // todo: consider the portals throughout the entire time interval.
+            const Transformd cumulated_transform =
+                assembly_instance.transform_sequence().get_earliest_transform() * parent_transform;
+
+            collect_portals(assembly.assembly_instances(), cumulated_transform, visitor);
+            collect_portals(assembly, cumulated_transform, visitor);
+        }
+    }
+}
+
+LightPortals::LightPortals(const Scene& scene)
+{
+    auto visitor =
+        [this](
+            const ObjectInstance&   object_instance,
+            const Transformd&       transform,
+            const AABB3d&           bbox)
+        {
+            if (!bbox.is_valid())
+                return;
+
+            // The portal is the face of the bounding box orthogonal to its thinnest dimension.
+            const Vector3d extent = bbox.extent();
+            const size_t normal_axis = min_index(extent);
+            const size_t x_axis = (normal_axis + 1) % 3;
+            const size_t y_axis = (normal_axis + 2) % 3;
+
+            Vector3d corner = bbox.min;
+            corner[normal_axis] += 0.5 * extent[normal_axis];
+
+            Vector3d edge_x(0.0), edge_y(0.0);
+            edge_x[x_axis] = extent[x_axis];
+            edge_y[y_axis] = extent[y_axis];
+
+            if (edge_x[x_axis] == 0.0 || edge_y[y_axis] == 0.0)
+            {
+                RENDERER_LOG_WARNING(
+                    "object instance \"%s\" cannot be used as a light portal because it is degenerate.",
+                    object_instance.get_path().c_str());
+                return;
+            }
+
+            add_portal(
+                transform.point_to_parent(corner),
+                transform.vector_to_parent(edge_x),
+                transform.vector_to_parent(edge_y));
+        };
+
+    collect_portals(scene.assembly_instances(), Transformd::identity(), visitor);
+
+    if (!m_portals.empty())
+    {
+        RENDERER_LOG_INFO(
+            "found %s %s.",
+            pretty_int(m_portals.size()).c_str(),
+            plural(m_portals.size(), "light portal").c_str());
+    }
+}
+
+void LightPortals::add_portal(
+    const Vector3d&         corner,
+    const Vector3d&         edge_x,
+    const Vector3d&         edge_y)
+{
+    Portal portal;
+    portal.m_corner = corner;
+    portal.m_edge_x = edge_x;
+    portal.m_edge_y = edge_y;
+    portal.m_normal = normalize(cross(edge_x, edge_y));
+    portal.m_rcp_square_width = 1.0 / square_norm(edge_x);
+    portal.m_rcp_square_height = 1.0 / square_norm(edge_y);
+    m_portals.push_back(portal);
+}
+
+bool LightPortals::sample(
+    const Vector3d&         point,
+    const Vector2f&         s,
+    Vector3f&               incoming,
+    float&                  probability) const
+{
+    const double total_solid_angle = compute_total_solid_angle(point);
+    if (total_solid_angle == 0.0)
+        return false;
+
+    // Choose a portal with a probability proportional to its solid angle,
+    // and sample it uniformly in solid angle.
+    double x = s[0] * total_solid_angle;
+
+    for (const Portal& portal : m_portals)
+    {
+        const SphericalRectangleSampler<double> sampler(
+            point,
+            portal.m_corner,
+            portal.m_edge_x,
+            portal.m_edge_y);
+
+        const double solid_angle = sampler.get_solid_angle();
+        if (solid_angle < MinPortalSolidAngle)
+            continue;
+
+        if (x < solid_angle || &portal == &m_portals.back())
+        {
+            const double u = std::min(x / solid_angle, 1.0 - 1.0e-9);
+            const Vector3d direction = sampler.sample(Vector2d(u, s[1])) - point;
+            const double distance = norm(direction);
+            if (distance == 0.0)
+                return false;
+
+            const Vector3d d = direction / distance;
+            incoming = Vector3f(d);
+
+            // Portals may overlap as seen from the point.
+            const size_t crossed = count_portals_crossed(point, d);
+            probability = static_cast<float>(std::max<size_t>(crossed, 1) / total_solid_angle);
+
+            return true;
+        }
+
+        x -= solid_angle;
+    }
+
+    return false;
+}
+
+float LightPortals::evaluate_pdf(
+    const Vector3d&         point,
+    const Vector3f&         incoming) const
+{
+    const size_t crossed = count_portals_crossed(point, Vector3d(incoming));
+    if (crossed == 0)
+        return 0.0f;
+
+    const double total_solid_angle = compute_total_solid_angle(point);
+    if (total_solid_angle == 0.0)
+        return 0.0f;
+
+    return static_cast<float>(crossed / total_solid_angle);
+}
+
+double LightPortals::compute_total_solid_angle(const Vector3d& point) const
+{
+    double total_solid_angle = 0.0;
+
+    for (const Portal& portal : m_portals)
+    {
+        const SphericalRectangleSampler<double> sampler(
+            point,
+            portal.m_corner,
+            portal.m_edge_x,
+            portal.m_edge_y);
+
+        const double solid_angle = sampler.get_solid_angle();
+        if (solid_angle >= MinPortalSolidAngle)
+            total_solid_angle += solid_angle;
+    }
+
+    return total_solid_angle;
+}
+
+size_t LightPortals::count_portals_crossed(
+    const Vector3d&         point,
+    const Vector3d&         direction) const
+{
+    size_t count = 0;
+
+    for (const Portal& portal : m_portals)
+    {
+        const double cos_theta = dot(direction, portal.m_normal);
+        if (cos_theta == 0.0)
+            continue;
+
+        const Vector3d to_corner = portal.m_corner - point;
+        const double t = dot(to_corner, portal.m_normal) / cos_theta;
+        if (t <= 0.0)
+            continue;
+
+        const Vector3d p = t * direction - to_corner;
+        const double u = dot(p, portal.m_edge_x) * portal.m_rcp_square_width;
+        const double v = dot(p, portal.m_edge_y) * portal.m_rcp_square_height;
+
+        if (u >= 0.0 && u <= 1.0 && v >= 0.0 && v <= 1.0)
+            ++count;
+    }
+
+    return count;
+}
+
+}   // namespace renderer
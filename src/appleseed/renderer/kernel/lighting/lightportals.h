@@ -0,0 +1,127 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace renderer  { class Scene; }
+
+namespace renderer
+{
+
+//
+// Light portals are rectangles, typically windows and doors, through which the
+// environment lights the interior of a scene. Sampling the environment through
+// portals instead of over the whole sphere of directions avoids wasting most
+// shadow rays on walls in interior scenes.
+//
+// Portals are object instances with the "light_portal" parameter set to true.
+// The portal rectangle is the largest face of the bounding box of the object
+// (usually a single quad), which should otherwise be made invisible.
+//
+// Directions of the environment that are not visible through any portal are
+// only reached by material sampling; combined with multiple importance sampling,
+// lighting remains unbiased.
+//
+
+class LightPortals
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor, collects the light portals of a scene.
+    explicit LightPortals(const Scene& scene);
+
+    // Return true if the scene contains no light portals.
+    bool empty() const;
+
+    // Return the number of light portals.
+    size_t size() const;
+
+    // Sample a direction through the portals, uniformly in the solid angle subtended
+    // by the portals as seen from a given point. Return false if no portal is visible.
+    bool sample(
+        const foundation::Vector3d&     point,
+        const foundation::Vector2f&     s,
+        foundation::Vector3f&           incoming,
+        float&                          probability) const;
+
+    // Compute the probability density in solid angle measure with which sample()
+    // chooses a given direction from a given point.
+    float evaluate_pdf(
+        const foundation::Vector3d&     point,
+        const foundation::Vector3f&     incoming) const;
+
+  private:
+    struct Portal
+    {
+        foundation::Vector3d            m_corner;
+        foundation::Vector3d            m_edge_x;
+        foundation::Vector3d            m_edge_y;
+        foundation::Vector3d            m_normal;
+        double                          m_rcp_square_width;
+        double                          m_rcp_square_height;
+    };
+
+    std::vector<Portal>                 m_portals;
+
+    void add_portal(
+        const foundation::Vector3d&     corner,
+        const foundation::Vector3d&     edge_x,
+        const foundation::Vector3d&     edge_y);
+
+    double compute_total_solid_angle(const foundation::Vector3d& point) const;
+
+    size_t count_portals_crossed(
+        const foundation::Vector3d&     point,
+        const foundation::Vector3d&     direction) const;
+};
+
+
+//
+// LightPortals class implementation.
+//
+
+inline bool LightPortals::empty() const
+{
+    return m_portals.empty();
+}
+
+inline size_t LightPortals::size() const
+{
+    return m_portals.size();
+}
+
+}   // namespace renderer
@@ -79,7 +79,7 @@ struct EmittingShapeKeyHasher
     size_t operator()(const EmittingShapeKey& key) const;
 };
 
-typedef foundation::HashTable<
+typedef foundation::FlatHashTable<
     EmittingShapeKey,
     EmittingShapeKeyHasher,
     const EmittingShape*
@@ -30,9 +30,14 @@
 #include "lightsamplerbase.h"
 
 // appleseed.renderer headers
+#include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/modeling/edf/edf.h"
+#include "renderer/modeling/input/source.h"
+#include "renderer/modeling/input/sourceinputs.h"
 #include "renderer/modeling/light/light.h"
 #include "renderer/modeling/object/diskobject.h"
 #include "renderer/modeling/object/meshobject.h"
@@ -44,7 +49,22 @@
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
+#include "foundation/math/qmc.h"
 #include "foundation/math/sampling/mappings.h"
+#include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 using namespace foundation;
 
@@ -100,8 +120,7 @@ void LightSamplerBase::build_emitting_shape_hash_table()
 {
     const size_t emitting_shape_count = m_emitting_shapes.size();
 
-    m_emitting_shape_hash_table.resize(
-        emitting_shape_count > 0 ? next_pow2(emitting_shape_count) : 0);
+    m_emitting_shape_hash_table.resize(emitting_shape_count);
 
     for (size_t i = 0; i < emitting_shape_count; ++i)
     {
@@ -259,9 +278,9 @@ void LightSamplerBase::collect_emitting_shapes(
                     triangle.m_n2 != Triangle::None)
                 {
                     // Retrieve object instance space vertex normals.
-                    const Vector3d n0_os = Vector3d(tess.m_vertex_normals[triangle.m_n0]);
-                    const Vector3d n1_os = Vector3d(tess.m_vertex_normals[triangle.m_n1]);
-                    const Vector3d n2_os = Vector3d(tess.m_vertex_normals[triangle.m_n2]);
+                    const Vector3d n0_os = Vector3d(tess.get_vertex_normal(triangle.m_n0));
+                    const Vector3d n1_os = Vector3d(tess.get_vertex_normal(triangle.m_n1));
+                    const Vector3d n2_os = Vector3d(tess.get_vertex_normal(triangle.m_n2));
 
                     // Transform vertex normals to world space.
                     n0 = normalize(global_transform.normal_to_parent(n0_os));
@@ -614,6 +633,218 @@ void LightSamplerBase::collect_non_physical_lights(
     }
 }
 
+namespace
+{
+    // Below this number of textured shapes, texture importances are computed on the calling thread.
+    const size_t MinParallelShapeCount = 1024;
+
+    // Number of textured shapes whose texture importance is computed by a single job.
+    const size_t ShapesPerJob = 256;
+
+    // Bounds on the number of texture lookups used to estimate the radiance of a shape.
+    const size_t MinTextureSampleCount = 4;
+    const size_t MaxTextureSampleCount = 64;
+
+    // Lower bound on texture importances, so that every shape can still be sampled.
+    const float MinTextureImportance = 1.0e-3f;
+
+    typedef std::function<void (size_t, size_t, size_t)> ComputeTextureImportancesFunction;
+
+    class ComputeTextureImportancesJob
+      : public IJob
+    {
+      public:
+        ComputeTextureImportancesJob(
+            const ComputeTextureImportancesFunction&    compute,
+            const size_t                                begin,
+            const size_t                                end)
+          : m_compute(compute)
+          , m_begin(begin)
+          , m_end(end)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            m_compute(thread_index, m_begin, m_end);
+        }
+
+      private:
+        const ComputeTextureImportancesFunction&        m_compute;
+        const size_t                                    m_begin;
+        const size_t                                    m_end;
+    };
+
+    // Return the source bound to the radiance input of the EDF of a material
+    // if this source is not uniform, or nullptr otherwise.
+    const Source* get_textured_radiance_source(const Material* material)
+    {
+        const EDF* edf = material->get_uncached_edf();
+        if (edf == nullptr)
+            return nullptr;
+
+        const Source* source = edf->get_inputs().source("radiance");
+        return source != nullptr && !source->is_uniform() ? source : nullptr;
+    }
+
+    // Estimate the average radiance emitted by a triangle shape by looking up
+    // the radiance source roughly once per texel covered by the triangle.
+    float estimate_average_radiance(
+        const EmittingShape&    shape,
+        const Source&           source,
+        TextureCache&           texture_cache)
+    {
+        assert(shape.get_shape_type() == EmittingShape::TriangleShape);
+
+        // Retrieve the triangle in the tessellation of its mesh.
+        const Assembly& assembly = shape.get_assembly_instance()->get_assembly();
+        const ObjectInstance* object_instance =
+            assembly.object_instances().get_by_index(shape.get_object_instance_index());
+        const MeshObject& mesh = static_cast<const MeshObject&>(object_instance->get_object());
+        const StaticTriangleTess& tess = mesh.get_static_triangle_tess();
+        const Triangle& triangle = tess.m_primitives[shape.get_primitive_index()];
+
+        // Retrieve the texture coordinates from UV set #0, like ShadingPoint does.
+        Vector2f uv0(0.0f, 0.0f), uv1(1.0f, 0.0f), uv2(0.0f, 1.0f);
+        if (triangle.has_vertex_attributes() && tess.get_tex_coords_count() > 0)
+        {
+            uv0 = Vector2f(tess.get_tex_coords(triangle.m_a0));
+            uv1 = Vector2f(tess.get_tex_coords(triangle.m_a1));
+            uv2 = Vector2f(tess.get_tex_coords(triangle.m_a2));
+        }
+
+        // Compute the number of texels covered by the triangle.
+        const Source::Hints hints = source.get_hints();
+        const Vector2f e1 = uv1 - uv0;
+        const Vector2f e2 = uv2 - uv0;
+        const float uv_area = 0.5f * std::abs(e1[0] * e2[1] - e1[1] * e2[0]);
+        const float texel_count = uv_area * static_cast<float>(hints.m_width * hints.m_height);
+        const size_t sample_count =
+            std::max(
+                static_cast<size_t>(std::min(texel_count, static_cast<float>(MaxTextureSampleCount))),
+                MinTextureSampleCount);
+
+        float radiance = 0.0f;
+
+        for (size_t i = 0; i < sample_count; ++i)
+        {
+            const size_t Bases[] = { 2 };
+            const Vector2f s = hammersley_sequence<float, 2>(Bases, sample_count, i);
+            const Vector3f bary = sample_triangle_uniform(s);
+            const Vector2f uv = bary[0] * uv0 + bary[1] * uv1 + bary[2] * uv2;
+
+            Spectrum spectrum;
+            source.evaluate(texture_cache, SourceInputs(uv), spectrum);
+            radiance += std::max(average_value(spectrum), 0.0f);
+        }
+
+        return radiance / static_cast<float>(sample_count);
+    }
+}
+
+void LightSamplerBase::compute_texture_importances(const Scene& scene)
+{
+    // Collect the triangles whose EDF radiance is textured.
+    std::vector<size_t> shape_indices;
+    std::vector<const Source*> sources;
+    for (size_t i = 0, e = m_emitting_shapes.size(); i < e; ++i)
+    {
+        const EmittingShape& shape = m_emitting_shapes[i];
+        if (shape.get_shape_type() != EmittingShape::TriangleShape)
+            continue;
+
+        if (const Source* source = get_textured_radiance_source(shape.get_material()))
+        {
+            shape_indices.push_back(i);
+            sources.push_back(source);
+        }
+    }
+
+    const size_t shape_count = shape_indices.size();
+    if (shape_count == 0)
+        return;
+
+    RENDERER_LOG_INFO(
+        "estimating radiance of %s textured emitting %s...",
+        pretty_uint(shape_count).c_str(),
+        shape_count > 1 ? "triangles" : "triangle");
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    // Texture caches are not thread-safe: give each thread its own cache.
+    const size_t thread_count =
+        shape_count < MinParallelShapeCount ? 1 : System::get_logical_cpu_core_count();
+    TextureStore texture_store(scene);
+    std::vector<std::unique_ptr<TextureCache>> texture_caches;
+    for (size_t i = 0; i < thread_count; ++i)
+        texture_caches.emplace_back(new TextureCache(texture_store));
+
+    std::vector<float> radiances(shape_count);
+
+    const ComputeTextureImportancesFunction compute =
+        [&](const size_t thread_index, const size_t begin, const size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                radiances[i] =
+                    estimate_average_radiance(
+                        m_emitting_shapes[shape_indices[i]],
+                        *sources[i],
+                        *texture_caches[thread_index]);
+            }
+        };
+
+    if (thread_count < 2)
+        compute(0, 0, shape_count);
+    else
+    {
+        JobQueue job_queue;
+        JobManager job_manager(global_logger(), job_queue, thread_count);
+
+        for (size_t begin = 0; begin < shape_count; begin += ShapesPerJob)
+        {
+            job_queue.schedule(
+                new ComputeTextureImportancesJob(
+                    compute,
+                    begin,
+                    std::min(begin + ShapesPerJob, shape_count)));
+        }
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+    }
+
+    // Compute the area-weighted average radiance of each material, so that
+    // texture importances don't change the total importance of a material.
+    std::unordered_map<const Material*, std::pair<double, double>> material_radiances;
+    for (size_t i = 0; i < shape_count; ++i)
+    {
+        const EmittingShape& shape = m_emitting_shapes[shape_indices[i]];
+        std::pair<double, double>& entry = material_radiances[shape.get_material()];
+        entry.first += static_cast<double>(shape.get_area()) * radiances[i];
+        entry.second += static_cast<double>(shape.get_area());
+    }
+
+    for (size_t i = 0; i < shape_count; ++i)
+    {
+        EmittingShape& shape = m_emitting_shapes[shape_indices[i]];
+        const std::pair<double, double>& entry = material_radiances[shape.get_material()];
+        const double average_radiance = entry.second > 0.0 ? entry.first / entry.second : 0.0;
+
+        shape.m_texture_importance =
+            average_radiance > 0.0
+                ? std::max(static_cast<float>(radiances[i] / average_radiance), MinTextureImportance)
+                : 1.0f;
+    }
+
+    stopwatch.measure();
+
+    RENDERER_LOG_INFO(
+        "estimated radiance of textured emitting triangles in %s.",
+        pretty_time(stopwatch.get_seconds()).c_str());
+}
+
 void LightSamplerBase::store_object_area_in_shadergroups(
     const AssemblyInstance*             assembly_instance,
     const ObjectInstance*               object_instance,
@@ -36,7 +36,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
-#include "foundation/math/cdf.h"
+#include "foundation/math/aliastable.h"
 
 // Standard headers.
 #include <functional>
@@ -47,6 +47,7 @@ namespace renderer      { class Assembly; }
 namespace renderer      { class AssemblyInstance; }
 namespace renderer      { class Material; }
 namespace renderer      { class MaterialArray; }
+namespace renderer      { class Scene; }
 
 namespace renderer
 {
@@ -82,7 +83,10 @@ class LightSamplerBase
 
     typedef std::vector<NonPhysicalLightInfo> NonPhysicalLightVector;
     typedef std::vector<EmittingShape> EmittingShapeVector;
-    typedef foundation::CDF<size_t, float> EmitterCDF;
+
+    // Emitters are chosen with alias tables: they share the interface of foundation::CDF
+    // but sample in constant time, which matters with millions of emitting triangles.
+    typedef foundation::AliasTable<size_t, float> EmitterCDF;
 
     typedef std::function<void (const NonPhysicalLightInfo&)> LightHandlingFunction;
     typedef std::function<bool (const Material*, const float, const size_t)> ShapeHandlingFunction;
@@ -134,6 +138,10 @@ class LightSamplerBase
         const TransformSequence&            transform_sequence,
         const LightHandlingFunction&        light_handling);
 
+    // Estimate how much light each emitting triangle with a textured EDF emits
+    // compared to the other triangles sharing its material.
+    void compute_texture_importances(const Scene& scene);
+
     void store_object_area_in_shadergroups(
         const AssemblyInstance*             assembly_instance,
         const ObjectInstance*               object_instance,
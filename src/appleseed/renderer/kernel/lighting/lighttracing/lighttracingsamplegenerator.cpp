@@ -78,9 +78,11 @@
 #include "foundation/memory/arena.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/job/iabortswitch.h"
+#include "foundation/utility/statcounters.h"
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
@@ -187,7 +189,6 @@ namespace
                 m_params.m_transparency_threshold,
                 m_params.m_max_iterations)
           , m_light_sample_count(0)
-          , m_path_count(0)
         {
             const Scene::RenderData& scene_data = m_scene.get_render_data();
             m_scene_center = Vector3d(scene_data.m_center);
@@ -251,10 +252,17 @@ namespace
         StatisticsVector get_statistics() const override
         {
             Statistics stats;
-            stats.insert("path count", m_path_count);
-            stats.insert("path length", m_path_length);
 
-            return StatisticsVector::make("light tracing statistics", stats);
+            if (m_stats->m_path_count.is_enabled())
+                stats.insert("path count", m_stats->m_path_count.get());
+
+            if (m_stats->m_path_length.is_enabled())
+                stats.insert("path length", m_stats->m_path_length.get());
+
+            StatisticsVector vec = StatisticsVector::make("light tracing statistics", stats);
+            vec.insert("shading arena statistics", m_arena.get_statistics());
+
+            return vec;
         }
 
       private:
@@ -553,8 +561,13 @@ namespace
 
         std::uint64_t                   m_light_sample_count;
 
-        std::uint64_t                   m_path_count;
-        Population<std::uint64_t>       m_path_length;
+        struct PathStatistics
+        {
+            StatCounter<StatsLevel::Basic>                          m_path_count;
+            StatPopulation<StatsLevel::Detailed, std::uint64_t>     m_path_length;
+        };
+
+        CacheLinePadded<PathStatistics> m_stats;
 
         float                           m_shutter_open_begin_time;
         float                           m_shutter_close_end_time;
@@ -572,6 +585,15 @@ namespace
                 m_params.m_sampling_mode,
                 instance);
 
+#ifdef APPLESEED_WITH_SPECTRAL_SUPPORT
+            // In hero wavelength mode, choose the bands carried by the light paths.
+            if (Spectrum::get_mode() == Spectrum::HeroWavelength)
+            {
+                sampling_context.split_in_place(1, 1);
+                Spectrum::select_band_block(sampling_context.next2<float>());
+            }
+#endif
+
             size_t stored_sample_count = 0;
 
             // Trace one path from one of the lights.
@@ -594,6 +616,38 @@ namespace
             return stored_sample_count;
         }
 
+        void flush_samples(
+            SampleVector&               samples,
+            IAbortSwitch&               abort_switch) override
+        {
+            if (samples.size() < 2)
+                return;
+
+            // Light paths splat to random pixels. Sort this job's samples in the memory order
+            // of the frame-wide accumulation buffer and merge samples that landed on the same
+            // pixel, so that the shared buffer sees fewer and more coherent writes.
+            const int canvas_width = static_cast<int>(m_frame.image().properties().m_canvas_width);
+            std::sort(
+                samples.begin(),
+                samples.end(),
+                [canvas_width](const Sample& lhs, const Sample& rhs)
+                {
+                    return
+                        lhs.m_pixel_coords.y * canvas_width + lhs.m_pixel_coords.x <
+                        rhs.m_pixel_coords.y * canvas_width + rhs.m_pixel_coords.x;
+                });
+
+            size_t last = 0;
+            for (size_t i = 1, e = samples.size(); i < e; ++i)
+            {
+                if (samples[i].m_pixel_coords == samples[last].m_pixel_coords)
+                    samples[last].m_color += samples[i].m_color;
+                else samples[++last] = samples[i];
+            }
+
+            samples.resize(last + 1);
+        }
+
         size_t generate_light_sample(
             SamplingContext&            sampling_context,
             SampleVector&               samples)
@@ -726,8 +780,8 @@ namespace
                     &parent_shading_point);
 
             // Update path statistics.
-            ++m_path_count;
-            m_path_length.insert(path_length);
+            ++m_stats->m_path_count;
+            m_stats->m_path_length.insert(path_length);
 
             // Return the number of samples generated when tracing this light path.
             return path_visitor.get_sample_count();
@@ -808,8 +862,8 @@ namespace
                     light_ray);
 
             // Update path statistics.
-            ++m_path_count;
-            m_path_length.insert(path_length);
+            ++m_stats->m_path_count;
+            m_stats->m_path_length.insert(path_length);
 
             // Return the number of samples generated when tracing this light path.
             return path_visitor.get_sample_count();
@@ -894,8 +948,8 @@ namespace
                     light_ray);
 
             // Update path statistics.
-            ++m_path_count;
-            m_path_length.insert(path_length);
+            ++m_stats->m_path_count;
+            m_stats->m_path_length.insert(path_length);
 
             // Return the number of samples generated when tracing this light path.
             return path_visitor.get_sample_count();
@@ -958,7 +1012,8 @@ SampleAccumulationBuffer* LightTracingSampleGeneratorFactory::create_sample_accu
     return
         new GlobalSampleAccumulationBuffer(
             props.m_canvas_width,
-            props.m_canvas_height);
+            props.m_canvas_height,
+            m_params.get_optional<size_t>("accumulation_buffer_stripes", 1));
 }
 
 }   // namespace renderer
@@ -44,12 +44,19 @@
 #include "foundation/math/permutation.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/timers.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/stopwatch.h"
 #include "foundation/utility/vpythonfile.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <functional>
 #include <limits>
 
 using namespace foundation;
@@ -68,6 +75,7 @@ LightTree::LightTree(
   , m_emitting_shapes(emitting_shapes)
   , m_tree_depth(0)
   , m_is_built(false)
+  , m_tracked_memory("light trees")
 {
 }
 
@@ -78,22 +86,7 @@ std::vector<size_t> LightTree::build()
     // Collect non-physical light sources.
     for (size_t i = 0, e = m_non_physical_lights.size(); i < e; ++i)
     {
-        const Light* light = m_non_physical_lights[i].m_light;
-
-        // Retrieve the exact position of the light.
-        const Vector3d position = light->get_transform()
-                                    .get_local_to_parent()
-                                    .extract_translation();
-
-        // Non physical light has no real size - hence some arbitrary small
-        // value is assigned.
-        const double BboxSize = 0.001f;
-        const AABB3d bbox = AABB3d(Vector3d(position[0] - BboxSize,
-                                            position[1] - BboxSize,
-                                            position[2] - BboxSize),
-                                   Vector3d(position[0] + BboxSize,
-                                            position[1] + BboxSize,
-                                            position[2] + BboxSize));
+        const AABB3d bbox = compute_non_physical_light_bbox(i);
         light_bboxes.push_back(bbox);
 
         m_items.emplace_back(bbox, i, NonPhysicalLightType);
@@ -117,13 +110,21 @@ std::vector<size_t> LightTree::build()
     // Build the light tree.
     typedef bvh::Builder<LightTree, Partitioner> Builder;
     Builder builder;
-    builder.build<DefaultWallclockTimer>(*this, partitioner, m_items.size(), 1);
+    builder.build<DefaultWallclockTimer>(
+        *this,
+        partitioner,
+        m_items.size(),
+        1,
+        System::get_logical_cpu_core_count());
 
     // Reorder m_items vector to match the ordering in the LightTree.
     if (!m_items.empty())
     {
         m_is_built = true;
 
+        Stopwatch<DefaultWallclockTimer> stopwatch;
+        stopwatch.start();
+
         const std::vector<size_t>& ordering = partitioner.get_item_ordering();
         assert(m_items.size() == ordering.size());
 
@@ -135,16 +136,27 @@ std::vector<size_t> LightTree::build()
             &ordering[0],
             ordering.size());
 
+        // Compute the importance of each light source.
+        compute_item_importances();
+
         // Set total node importance and level for each node of the LightTree.
         IndexLUT tri_index_to_node_index;
         tri_index_to_node_index.resize(m_emitting_shapes.size());
         recursive_node_update(0, 0, 0, tri_index_to_node_index);
 
+        stopwatch.measure();
+
+        m_tracked_memory.set_size(
+              TreeType::get_memory_size()
+            + m_items.capacity() * sizeof(Item)
+            + m_item_importances.capacity() * sizeof(float));
+
         // Print light tree statistics.
         Statistics statistics;
         statistics.insert("nodes", m_nodes.size());
         statistics.insert("max tree depth", m_tree_depth);
-        statistics.insert_time("total build time", builder.get_build_time());
+        statistics.insert_time("tree build time", builder.get_build_time());
+        statistics.insert_time("importance update time", stopwatch.get_seconds());
         RENDERER_LOG_INFO("%s",
             StatisticsVector::make(
                 "light tree statistics",
@@ -162,6 +174,193 @@ bool LightTree::is_built() const
     return m_is_built;
 }
 
+void LightTree::refit()
+{
+    if (!m_is_built)
+        return;
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    // Non-physical lights may have moved. Emitting shapes are stored in world space
+    // by the light sampler and are only refreshed when the light sampler is recreated.
+    for (Item& item : m_items)
+    {
+        if (item.m_light_type == NonPhysicalLightType)
+            item.m_bbox = compute_non_physical_light_bbox(item.m_light_index);
+    }
+
+    compute_item_importances();
+
+    AABB3d root_bbox;
+    refit_node(0, root_bbox);
+
+    stopwatch.measure();
+
+    RENDERER_LOG_DEBUG(
+        "refitted light tree in %s.",
+        pretty_time(stopwatch.get_seconds()).c_str());
+}
+
+AABB3d LightTree::compute_non_physical_light_bbox(const size_t light_index) const
+{
+    const Light* light = m_non_physical_lights[light_index].m_light;
+
+    // Retrieve the exact position of the light.
+    const Vector3d position = light->get_transform()
+                                .get_local_to_parent()
+                                .extract_translation();
+
+    // Non physical light has no real size - hence some arbitrary small
+    // value is assigned.
+    const double BboxSize = 0.001f;
+    return AABB3d(Vector3d(position[0] - BboxSize,
+                           position[1] - BboxSize,
+                           position[2] - BboxSize),
+                  Vector3d(position[0] + BboxSize,
+                           position[1] + BboxSize,
+                           position[2] + BboxSize));
+}
+
+float LightTree::compute_item_importance(const Item& item) const
+{
+    if (item.m_light_type == NonPhysicalLightType)
+    {
+        const Light* light = m_non_physical_lights[item.m_light_index].m_light;
+
+        // Retrieve the non-physical light importance.
+        Spectrum spectrum;
+        light->get_inputs().find("intensity").source()->evaluate_uniform(spectrum);
+        return average_value(spectrum);
+    }
+    else
+    {
+        assert(item.m_light_type == EmittingShapeType);
+
+        const EmittingShape& shape = m_emitting_shapes[item.m_light_index];
+
+        // Retrieve the emitting shape importance.
+        const EDF* edf = shape.get_material()->get_uncached_edf();
+        assert(edf != nullptr);
+
+        const float max_contribution = edf->get_uncached_max_contribution();
+
+        // max_contribution is reported as std::numeric_limits<float>::max() when
+        // we can't compute the max_contribution easily (ex: textured lights)
+        // In such cases, we fall back to the radiance of the shape relative to
+        // the other shapes of its material to avoid infinite importance values
+        // in the light tree nodes.
+        if (max_contribution == std::numeric_limits<float>::max())
+            return shape.get_texture_importance();
+        else return max_contribution * edf->get_uncached_importance_multiplier();
+    }
+}
+
+namespace
+{
+    // Below this number of lights, importances are computed on the calling thread.
+    const size_t MinParallelItemCount = 16 * 1024;
+
+    // Number of lights whose importance is computed by a single job.
+    const size_t ItemsPerJob = 4 * 1024;
+
+    class ComputeImportancesJob
+      : public IJob
+    {
+      public:
+        ComputeImportancesJob(
+            const std::function<void (size_t, size_t)>& compute,
+            const size_t                                begin,
+            const size_t                                end)
+          : m_compute(compute)
+          , m_begin(begin)
+          , m_end(end)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            m_compute(m_begin, m_end);
+        }
+
+      private:
+        const std::function<void (size_t, size_t)>&     m_compute;
+        const size_t                                    m_begin;
+        const size_t                                    m_end;
+    };
+}
+
+void LightTree::compute_item_importances()
+{
+    const size_t item_count = m_items.size();
+    m_item_importances.resize(item_count);
+
+    const std::function<void (size_t, size_t)> compute =
+        [this](const size_t begin, const size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                m_item_importances[i] = compute_item_importance(m_items[i]);
+        };
+
+    const size_t thread_count = System::get_logical_cpu_core_count();
+
+    if (item_count < MinParallelItemCount || thread_count < 2)
+    {
+        compute(0, item_count);
+        return;
+    }
+
+    JobQueue job_queue;
+    JobManager job_manager(global_logger(), job_queue, thread_count);
+
+    for (size_t begin = 0; begin < item_count; begin += ItemsPerJob)
+    {
+        job_queue.schedule(
+            new ComputeImportancesJob(
+                compute,
+                begin,
+                std::min(begin + ItemsPerJob, item_count)));
+    }
+
+    job_manager.start();
+    job_queue.wait_until_completion();
+}
+
+float LightTree::refit_node(
+    const size_t    node_index,
+    AABB3d&         bbox)
+{
+    LightTreeNode<AABB3d>& node = m_nodes[node_index];
+
+    float importance;
+
+    if (node.is_leaf())
+    {
+        const size_t item_index = node.get_item_index();
+        bbox = m_items[item_index].m_bbox;
+        importance = m_item_importances[item_index];
+    }
+    else
+    {
+        const size_t child_node_index = node.get_child_node_index();
+
+        AABB3d left_bbox, right_bbox;
+        const float importance1 = refit_node(child_node_index, left_bbox);
+        const float importance2 = refit_node(child_node_index + 1, right_bbox);
+
+        node.set_left_bbox(left_bbox);
+        node.set_right_bbox(right_bbox);
+
+        bbox = left_bbox;
+        bbox.insert(right_bbox);
+        importance = importance1 + importance2;
+    }
+
+    node.set_importance(importance);
+
+    return importance;
+}
+
 float LightTree::recursive_node_update(
     const size_t    parent_index,
     const size_t    node_index,
@@ -184,41 +383,11 @@ float LightTree::recursive_node_update(
     {
         // Retrieve the light source associated to this leaf.
         const size_t item_index = m_nodes[node_index].get_item_index();
-        const size_t light_index = m_items[item_index].m_light_index;
+        importance = m_item_importances[item_index];
 
-        if (m_items[item_index].m_light_type == NonPhysicalLightType)
-        {
-            const Light* light = m_non_physical_lights[light_index].m_light;
-
-            // Retrieve the non-physical light importance.
-            Spectrum spectrum;
-            light->get_inputs().find("intensity").source()->evaluate_uniform(spectrum);
-            importance = average_value(spectrum);
-        }
-        else
-        {
-            assert(m_items[item_index].m_light_type == EmittingShapeType);
-
-            const EmittingShape& shape = m_emitting_shapes[light_index];
-
-            // Retrieve the emitting shape importance.
-            const EDF* edf = shape.get_material()->get_uncached_edf();
-            assert(edf != nullptr);
-
-            const float max_contribution = edf->get_uncached_max_contribution();
-
-            // max_contribution is reported as std::numeric_limits<float>::max() when
-            // we can't compute the max_contribution easily (ex: textured lights)
-            // In such cases, we can use a default importance value of 1.0 to avoid
-            // infinite importance values in the light tree nodes.
-            if (max_contribution == std::numeric_limits<float>::max())
-                importance = 1.0f;
-            else
-                importance = max_contribution * edf->get_uncached_importance_multiplier();
-
-            // Save the index of the light tree node containing the EMT in the look up table.
-            tri_index_to_node_index[light_index] = node_index;
-        }
+        // Save the index of the light tree node containing the EMT in the look up table.
+        if (m_items[item_index].m_light_type == EmittingShapeType)
+            tri_index_to_node_index[m_items[item_index].m_light_index] = node_index;
 
         // Keep track of the tree depth.
         if (m_tree_depth < node_level)
@@ -36,10 +36,12 @@
 #include "foundation/containers/alignedvector.h"
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
+#include "foundation/memory/memorytracker.h"
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
 #include <cstddef>
+#include <vector>
 
 // Forward declarations.
 namespace renderer  { class ShadingPoint; }
@@ -69,6 +71,10 @@ class LightTree
 
     bool is_built() const;
 
+    // Update node bounding boxes and importances after light intensities or
+    // non-physical light transforms changed, keeping the topology of the tree.
+    void refit();
+
     void sample(
         const ShadingPoint&             shading_point,
         const float                     s,
@@ -114,8 +120,24 @@ class LightTree
     const NonPhysicalLightVector&                   m_non_physical_lights;
     const EmittingShapeVector&                      m_emitting_shapes;
     ItemVector                                      m_items;
+    std::vector<float>                              m_item_importances;
     size_t                                          m_tree_depth;
     bool                                            m_is_built;
+    foundation::TrackedMemory                       m_tracked_memory;
+
+    // Compute the bounding box of a non-physical light.
+    foundation::AABB3d compute_non_physical_light_bbox(const size_t light_index) const;
+
+    // Compute the importance of a single item.
+    float compute_item_importance(const Item& item) const;
+
+    // Compute the importances of all items, using multiple threads for large trees.
+    void compute_item_importances();
+
+    // Recompute the bounding boxes and importances of a subtree.
+    float refit_node(
+        const size_t                                node_index,
+        foundation::AABB3d&                         bbox);
 
     // Calculate the tree depth.
     // Assign total importance to each node of the tree, where total importance
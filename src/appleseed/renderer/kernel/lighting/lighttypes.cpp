@@ -208,6 +208,7 @@ EmittingShape::EmittingShape(
     m_material = material;
     m_shape_prob = 0.0f;
     m_average_flux = 1.0f;
+    m_texture_importance = 1.0f;
 }
 
 void EmittingShape::sample_uniform(
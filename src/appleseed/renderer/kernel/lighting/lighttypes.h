@@ -170,6 +170,10 @@ class EmittingShape
     float get_average_flux() const;
     float get_max_flux() const;
 
+    // Return the average radiance emitted by this shape relative to the
+    // average radiance emitted by all shapes sharing its material.
+    float get_texture_importance() const;
+
   private:
     friend class LightSamplerBase;
     friend class BackwardLightSampler;
@@ -227,6 +231,7 @@ class EmittingShape
     float                       m_shape_prob;                   // probability density of this shape
     float                       m_average_flux;                 // estimated average radiant flux in W emitted by this shape
     float                       m_max_flux;                     // estimated maximum radiant flux in W emitted by this shape
+    float                       m_texture_importance;           // relative radiance of this shape when its emission is textured
     const Material*             m_material;
     foundation::AABB3d          m_bbox;
     foundation::Vector3d        m_centroid;
@@ -315,4 +320,9 @@ inline float EmittingShape::get_max_flux() const
     return m_max_flux;
 }
 
+inline float EmittingShape::get_texture_importance() const
+{
+    return m_texture_importance;
+}
+
 }   // namespace renderer
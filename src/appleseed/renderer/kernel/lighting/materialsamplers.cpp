@@ -128,6 +128,7 @@ void BSDFSampler::trace_simple(
 void BSDFSampler::trace_between(
     const ShadingContext&       shading_context,
     const Vector3d&             target_position,
+    const size_t                occluder_key,
     Spectrum&                   transmission) const
 {
     shading_context.get_tracer().trace_between_simple(
@@ -136,7 +137,8 @@ void BSDFSampler::trace_between(
         target_position,
         m_shading_point.get_ray(),
         VisibilityFlags::ShadowRay,
-        transmission);
+        transmission,
+        occluder_key);
 }
 
 bool BSDFSampler::sample(
@@ -267,6 +269,7 @@ void VolumeSampler::trace_simple(
 void VolumeSampler::trace_between(
     const ShadingContext&       shading_context,
     const Vector3d&             target_position,
+    const size_t                occluder_key,
     Spectrum&                   transmission) const
 {
     shading_context.get_tracer().trace_between_simple(
@@ -275,7 +278,8 @@ void VolumeSampler::trace_between(
         target_position,
         m_volume_ray,
         VisibilityFlags::ShadowRay,
-        transmission);
+        transmission,
+        occluder_key);
 }
 
 bool VolumeSampler::sample(
@@ -37,6 +37,9 @@
 #include "foundation/math/dual.h"
 #include "foundation/math/vector.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace renderer  { class DirectShadingComponents; }
 namespace renderer  { class ShadingContext; }
@@ -72,9 +75,12 @@ class IMaterialSampler
         const foundation::Vector3f&     direction,
         Spectrum&                       transmission) const = 0;
 
+    // Compute the transmission toward a target position. Shadow rays traced with
+    // the same occluder key share a cached occluder (see OccluderCache).
     virtual void trace_between(
         const ShadingContext&           shading_context,
         const foundation::Vector3d&     target_position,
+        const size_t                    occluder_key,
         Spectrum&                       transmission) const = 0;
 
     virtual bool sample(
@@ -120,6 +126,7 @@ class BSDFSampler
     void trace_between(
         const ShadingContext&           shading_context,
         const foundation::Vector3d&     target_position,
+        const size_t                    occluder_key,
         Spectrum&                       transmission) const override;
 
     bool sample(
@@ -173,6 +180,7 @@ class VolumeSampler
     void trace_between(
         const ShadingContext&           shading_context,
         const foundation::Vector3d&     target_position,
+        const size_t                    occluder_key,
         Spectrum&                       transmission) const override;
 
     bool sample(
@@ -34,7 +34,10 @@
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/aov/aovcomponents.h"
 #include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/lighting/adaptiverr.h"
+#include "renderer/kernel/lighting/guidedpath.h"
 #include "renderer/kernel/lighting/pathvertex.h"
+#include "renderer/kernel/lighting/radiancecachepath.h"
 #include "renderer/kernel/lighting/scatteringmode.h"
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
@@ -64,6 +67,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 
 namespace renderer
 {
@@ -100,7 +104,31 @@ namespace renderer
 //   };
 //
 
-template <typename PathVisitor, typename VolumeVisitor, bool Adjoint>
+//
+// Scene features a path tracer must handle. A path tracer instantiated without a
+// feature compiles the corresponding code paths out, so a scene that does not use
+// them can be rendered by a leaner instantiation.
+//
+
+class PathTracerFeatures
+{
+  public:
+    typedef std::uint32_t Type;
+
+    enum Values
+    {
+        None                = 0,
+        ParticipatingMedia  = 1UL << 0,     // materials with volumes
+        Subsurface          = 1UL << 1,     // materials with BSSRDFs
+        All                 = ParticipatingMedia | Subsurface
+    };
+};
+
+template <
+    typename PathVisitor,
+    typename VolumeVisitor,
+    bool Adjoint,
+    PathTracerFeatures::Type Features = PathTracerFeatures::All>
 class PathTracer
   : public foundation::NonCopyable
 {
@@ -116,7 +144,10 @@ class PathTracer
         const size_t                max_volume_bounces,
         const bool                  clamp_roughness,
         const size_t                max_iterations = 1000,
-        const double                near_start = 0.0);          // abort tracing if the first ray is shorter than this
+        const double                near_start = 0.0,           // abort tracing if the first ray is shorter than this
+        GuidedPath*                 guided_path = nullptr,      // optional path guiding
+        AdaptiveRR*                 adaptive_rr = nullptr,      // optional adjoint-driven Russian Roulette
+        RadianceCachePath*          radiance_cache_path = nullptr); // optional radiance caching
 
     size_t trace(
         SamplingContext&            sampling_context,
@@ -131,9 +162,10 @@ class PathTracer
         const ShadingPoint&         shading_point,
         const bool                  clear_arena = true);
 
-    const ShadingPoint& get_path_vertex(const size_t i) const;
-
   private:
+    static const bool HasParticipatingMedia = (Features & PathTracerFeatures::ParticipatingMedia) != 0;
+    static const bool HasSubsurface = (Features & PathTracerFeatures::Subsurface) != 0;
+
     PathVisitor&                    m_path_visitor;
     VolumeVisitor&                  m_volume_visitor;
     const size_t                    m_rr_min_path_length;
@@ -145,12 +177,15 @@ class PathTracer
     const bool                      m_clamp_roughness;
     const size_t                    m_max_iterations;
     const double                    m_near_start;
+    GuidedPath*                     m_guided_path;
+    AdaptiveRR*                     m_adaptive_rr;
+    RadianceCachePath*              m_radiance_cache_path;
     size_t                          m_diffuse_bounces;
     size_t                          m_glossy_bounces;
     size_t                          m_specular_bounces;
     size_t                          m_volume_bounces;
     size_t                          m_iterations;
-    foundation::Arena               m_shading_point_arena;
+    foundation::Arena::Marker       m_vertex_marker;            // end of the last path vertex in the shading arena
 
     // Determine whether a ray can pass through a surface with a given alpha value.
     static bool pass_through(
@@ -162,6 +197,12 @@ class PathTracer
         SamplingContext&            sampling_context,
         PathVertex&                 vertex);
 
+    // Use Russian Roulette driven by learned radiance estimates at a surface vertex,
+    // falling back to continue_path_rr() where no estimate is available.
+    bool continue_path_adaptive_rr(
+        SamplingContext&            sampling_context,
+        PathVertex&                 vertex);
+
     // Apply path visitor and sample BSDF in a given path vertex.
     // If all checks are passed, build a bounced ray that continues in the sampled direction
     // and return true, otherwise return false.
@@ -187,8 +228,8 @@ class PathTracer
 // PathTracer class implementation.
 //
 
-template <typename PathVisitor, typename VolumeVisitor, bool Adjoint>
-inline PathTracer<PathVisitor, VolumeVisitor, Adjoint>::PathTracer(
+template <typename PathVisitor, typename VolumeVisitor, bool Adjoint, PathTracerFeatures::Type Features>
+inline PathTracer<PathVisitor, VolumeVisitor, Adjoint, Features>::PathTracer(
     PathVisitor&                path_visitor,
     VolumeVisitor&              volume_visitor,
     const size_t                rr_min_path_length,
@@ -199,7 +240,10 @@ inline PathTracer<PathVisitor, VolumeVisitor, Adjoint>::PathTracer(
     const size_t                max_volume_bounces,
     const bool                  clamp_roughness,
     const size_t                max_iterations,
-    const double                near_start)
+    const double                near_start,
+    GuidedPath*                 guided_path,
+    AdaptiveRR*                 adaptive_rr,
+    RadianceCachePath*          radiance_cache_path)
   : m_path_visitor(path_visitor)
   , m_volume_visitor(volume_visitor)
   , m_rr_min_path_length(rr_min_path_length)
@@ -211,11 +255,14 @@ inline PathTracer<PathVisitor, VolumeVisitor, Adjoint>::PathTracer(
   , m_clamp_roughness(clamp_roughness)
   , m_max_iterations(max_iterations)
   , m_near_start(near_start)
+  , m_guided_path(guided_path)
+  , m_adaptive_rr(adaptive_rr)
+  , m_radiance_cache_path(radiance_cache_path)
 {
 }
 
-template <typename PathVisitor, typename VolumeVisitor, bool Adjoint>
-inline size_t PathTracer<PathVisitor, VolumeVisitor, Adjoint>::trace(
+template <typename PathVisitor, typename VolumeVisitor, bool Adjoint, PathTracerFeatures::Type Features>
+inline size_t PathTracer<PathVisitor, VolumeVisitor, Adjoint, Features>::trace(
     SamplingContext&            sampling_context,
     const ShadingContext&       shading_context,
     const ShadingRay&           ray,
@@ -233,8 +280,8 @@ inline size_t PathTracer<PathVisitor, VolumeVisitor, Adjoint>::trace(
             clear_arena);
 }
 
-template <typename PathVisitor, typename VolumeVisitor, bool Adjoint>
-size_t PathTracer<PathVisitor, VolumeVisitor, Adjoint>::trace(
+template <typename PathVisitor, typename VolumeVisitor, bool Adjoint, PathTracerFeatures::Type Features>
+size_t PathTracer<PathVisitor, VolumeVisitor, Adjoint, Features>::trace(
     SamplingContext&            sampling_context,
     const ShadingContext&       shading_context,
     const ShadingPoint&         shading_point,
@@ -264,12 +311,21 @@ size_t PathTracer<PathVisitor, VolumeVisitor, Adjoint>::trace(
     m_volume_bounces = 0;
     m_iterations = 0;
 
+    // Path vertices are allocated from the shading arena, interleaved with the shading
+    // data of each vertex. The arena is rewound to the end of the last path vertex at
+    // every bounce, so that the shading data is released but the path is kept.
+    foundation::Arena& arena = shading_context.get_arena();
+    if (clear_arena)
+        arena.clear();
+    m_vertex_marker = arena.get_marker();
+
     while (true)
     {
         if (clear_arena)
-            shading_context.get_arena().clear();
+            arena.reset(m_vertex_marker);
 
-        ShadingPoint* next_shading_point = m_shading_point_arena.allocate<ShadingPoint>();
+        ShadingPoint* next_shading_point = arena.allocate<ShadingPoint>();
+        m_vertex_marker = arena.get_marker();
 
 #ifndef NDEBUG
         // Save the sampling context at the beginning of the iteration.
@@ -446,11 +502,11 @@ size_t PathTracer<PathVisitor, VolumeVisitor, Adjoint>::trace(
         vertex.m_edf =
             vertex.m_shading_point->is_curve_primitive() ? nullptr : material_data.m_edf;
         vertex.m_bsdf = material_data.m_bsdf;
-        vertex.m_bssrdf = material_data.m_bssrdf;
+        vertex.m_bssrdf = HasSubsurface ? material_data.m_bssrdf : nullptr;
 
         // We allow materials with both a BSDF and a BSSRDF.
         // When both are present, pick one to extend the path.
-        if (vertex.m_bsdf && vertex.m_bssrdf)
+        if (HasSubsurface && vertex.m_bsdf && vertex.m_bssrdf)
         {
             sampling_context.split_in_place(1, 1);
             if (sampling_context.next2<float>() < 0.5f)
@@ -467,7 +523,7 @@ size_t PathTracer<PathVisitor, VolumeVisitor, Adjoint>::trace(
         }
 
         // Evaluate the inputs of the BSSRDF.
-        if (vertex.m_bssrdf)
+        if (HasSubsurface && vertex.m_bssrdf)
         {
             vertex.m_bssrdf_data =
                 vertex.m_bssrdf->evaluate_inputs(shading_context, *vertex.m_shading_point);
@@ -481,8 +537,16 @@ size_t PathTracer<PathVisitor, VolumeVisitor, Adjoint>::trace(
         vertex.m_cos_on = foundation::dot(vertex.m_outgoing.get_value(), vertex.get_shading_normal());
         m_path_visitor.on_hit(vertex);
 
+        // Terminate the path into the radiance cache where it knows the remaining radiance.
+        if (m_radiance_cache_path && m_radiance_cache_path->terminate(vertex))
+            break;
+
         // Use Russian Roulette to cut the path without introducing bias.
-        if (!continue_path_rr(sampling_context, vertex))
+        const bool continue_path =
+            m_adaptive_rr
+                ? continue_path_adaptive_rr(sampling_context, vertex)
+                : continue_path_rr(sampling_context, vertex);
+        if (!continue_path)
             break;
 
         // Honor the global bounce limit.
@@ -504,6 +568,9 @@ size_t PathTracer<PathVisitor, VolumeVisitor, Adjoint>::trace(
         if (vertex.m_scattering_modes == ScatteringMode::None)
             break;
 
+        if (m_radiance_cache_path)
+            m_radiance_cache_path->add_vertex(vertex);
+
         BSDF::LocalGeometry local_geometry;
         local_geometry.m_shading_point = vertex.m_shading_point;
         local_geometry.m_geometric_normal = foundation::Vector3f(vertex.get_geometric_normal());
@@ -513,7 +580,7 @@ size_t PathTracer<PathVisitor, VolumeVisitor, Adjoint>::trace(
 
         // Subsurface scattering.
         BSSRDFSample bssrdf_sample;
-        if (vertex.m_bssrdf)
+        if (HasSubsurface && vertex.m_bssrdf)
         {
             // Sample the BSSRDF and terminate the path if no incoming point is found.
             if (!vertex.m_bssrdf->sample(
@@ -616,7 +683,8 @@ size_t PathTracer<PathVisitor, VolumeVisitor, Adjoint>::trace(
         medium_start = vertex.get_point();
 
         const ShadingRay::Medium* current_medium = next_ray.get_current_medium();
-        if (current_medium != nullptr &&
+        if (HasParticipatingMedia &&
+            current_medium != nullptr &&
             current_medium->get_volume() != nullptr)
         {
             // This ray is being cast into a participating medium.
@@ -645,8 +713,8 @@ size_t PathTracer<PathVisitor, VolumeVisitor, Adjoint>::trace(
     return vertex.m_path_length;
 }
 
-template <typename PathVisitor, typename VolumeVisitor, bool Adjoint>
-inline bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::pass_through(
+template <typename PathVisitor, typename VolumeVisitor, bool Adjoint, PathTracerFeatures::Type Features>
+inline bool PathTracer<PathVisitor, VolumeVisitor, Adjoint, Features>::pass_through(
     SamplingContext&            sampling_context,
     const Alpha                 alpha)
 {
@@ -665,8 +733,8 @@ inline bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::pass_through(
     return s >= alpha[0];
 }
 
-template <typename PathVisitor, typename VolumeVisitor, bool Adjoint>
-inline bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::continue_path_rr(
+template <typename PathVisitor, typename VolumeVisitor, bool Adjoint, PathTracerFeatures::Type Features>
+inline bool PathTracer<PathVisitor, VolumeVisitor, Adjoint, Features>::continue_path_rr(
     SamplingContext&            sampling_context,
     PathVertex&                 vertex)
 {
@@ -693,8 +761,48 @@ inline bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::continue_path_rr(
     return true;
 }
 
-template <typename PathVisitor, typename VolumeVisitor, bool Adjoint>
-bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::process_bounce(
+template <typename PathVisitor, typename VolumeVisitor, bool Adjoint, PathTracerFeatures::Type Features>
+inline bool PathTracer<PathVisitor, VolumeVisitor, Adjoint, Features>::continue_path_adaptive_rr(
+    SamplingContext&            sampling_context,
+    PathVertex&                 vertex)
+{
+    assert(m_adaptive_rr);
+
+    const foundation::Vector3d& point = vertex.m_shading_point->get_point();
+
+    float scattering_prob;
+    if (m_adaptive_rr->get_survival_probability(
+            point,
+            vertex.m_path_length,
+            vertex.m_throughput,
+            scattering_prob))
+    {
+        if (scattering_prob < 1.0f)
+        {
+            // Generate a uniform sample in [0,1).
+            sampling_context.split_in_place(1, 1);
+            const float s = sampling_context.next2<float>();
+
+            // Russian Roulette.
+            if (!foundation::pass_rr(scattering_prob, s))
+                return false;
+
+            // Adjust throughput to account for terminated paths.
+            assert(scattering_prob > 0.0f);
+            vertex.m_throughput /= scattering_prob;
+        }
+    }
+    else if (!continue_path_rr(sampling_context, vertex))
+        return false;
+
+    // Remember this vertex to learn the radiance gathered after it.
+    m_adaptive_rr->add_vertex(point, vertex.m_throughput);
+
+    return true;
+}
+
+template <typename PathVisitor, typename VolumeVisitor, bool Adjoint, PathTracerFeatures::Type Features>
+bool PathTracer<PathVisitor, VolumeVisitor, Adjoint, Features>::process_bounce(
     SamplingContext&            sampling_context,
     PathVertex&                 vertex,
     const BSDF::LocalGeometry&  local_geometry,
@@ -708,18 +816,38 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::process_bounce(
     if (vertex.m_scattering_modes == ScatteringMode::None)
         return false;
 
+    // Probability density of the incoming direction when path guiding is used.
+    float guided_prob = 0.0f;
+
     // Above-surface scattering.
     if (vertex.m_bssrdf == nullptr)
     {
-        vertex.m_bsdf->sample(
-            sampling_context,
-            vertex.m_bsdf_data,
-            Adjoint,
-            true,       // multiply by |cos(incoming, normal)|
-            local_geometry,
-            foundation::Dual3f(vertex.m_outgoing),
-            vertex.m_scattering_modes,
-            sample);
+        if (m_guided_path)
+        {
+            guided_prob =
+                m_guided_path->sample(
+                    sampling_context,
+                    *vertex.m_bsdf,
+                    vertex.m_bsdf_data,
+                    Adjoint,
+                    local_geometry,
+                    foundation::Dual3f(vertex.m_outgoing),
+                    vertex.m_scattering_modes,
+                    vertex.m_path_length == 1,
+                    sample);
+        }
+        else
+        {
+            vertex.m_bsdf->sample(
+                sampling_context,
+                vertex.m_bsdf_data,
+                Adjoint,
+                true,       // multiply by |cos(incoming, normal)|
+                local_geometry,
+                foundation::Dual3f(vertex.m_outgoing),
+                vertex.m_scattering_modes,
+                sample);
+        }
 
         next_ray.m_min_roughness = m_clamp_roughness ? sample.m_min_roughness : 0.0f;
 
@@ -755,6 +883,16 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::process_bounce(
         sample.m_value /= sample.get_probability();
     vertex.m_throughput *= sample.m_value.m_beauty;
 
+    // Remember non-specular scattering events to learn incident radiance.
+    if (m_guided_path && guided_prob > 0.0f && sample.get_mode() != ScatteringMode::Specular)
+    {
+        m_guided_path->add_vertex(
+            vertex.m_shading_point->get_point(),
+            sample.m_incoming.get_value(),
+            vertex.m_throughput,
+            guided_prob);
+    }
+
     // Update bounce counters.
     ++vertex.m_path_length;
     m_diffuse_bounces +=  (sample.get_mode() >> ScatteringMode::DiffuseBitShift)  & 1;
@@ -782,8 +920,8 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::process_bounce(
     return true;
 }
 
-template <typename PathVisitor, typename VolumeVisitor, bool Adjoint>
-bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
+template <typename PathVisitor, typename VolumeVisitor, bool Adjoint, PathTracerFeatures::Type Features>
+bool PathTracer<PathVisitor, VolumeVisitor, Adjoint, Features>::march(
     SamplingContext&            sampling_context,
     const ShadingContext&       shading_context,
     const ShadingRay&           ray,
@@ -808,7 +946,7 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
 
     while (true)
     {
-        shading_context.get_arena().clear();
+        shading_context.get_arena().reset(m_vertex_marker);
 
         // Put a hard limit on the number of iterations.
         if (m_iterations++ == m_max_iterations)
@@ -849,56 +987,118 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
             break;
         }
 
-        // Retrieve extinction spectrum.
-        const Spectrum& extinction_coef =
-            volume->extinction_coefficient(vertex.m_volume_data, volume_ray);
-
-        // Sample channel uniformly at random.
-        sampling_context.split_in_place(1, 1);
-        const float s = sampling_context.next2<float>();
-        const size_t channel = foundation::truncate<size_t>(s * Spectrum::size());
-        const bool extinction_is_null = extinction_coef[channel] < 1.0e-6f;
-
-        // Sample distance.
-        float distance_sample, distance_pdf;
-        if (extinction_is_null)
-        {
-            distance_sample = 0.0f;
-            distance_pdf = 0.0f;
-        }
-        else
+        // Sample the distance to the scattering event and compute the throughput weight of this event.
+        float distance_sample;
+        Spectrum scattering_weight;
+        if (volume->is_homogeneous())
         {
+            // Retrieve extinction spectrum.
+            const Spectrum& extinction_coef =
+                volume->extinction_coefficient(vertex.m_volume_data, volume_ray);
+
+            // Sample channel uniformly at random.
             sampling_context.split_in_place(1, 1);
-            distance_sample =
-                foundation::sample_exponential_distribution(
-                    sampling_context.next2<float>(),
-                    extinction_coef[channel]);
-            distance_pdf =
-                foundation::exponential_distribution_pdf(
-                    distance_sample,
-                    extinction_coef[channel]);
-        }
+            const float s = sampling_context.next2<float>();
+            const size_t channel = foundation::truncate<size_t>(s * Spectrum::size());
+            const bool extinction_is_null = extinction_coef[channel] < 1.0e-6f;
 
-        // Continue path tracing if sampled distance exceeds total length of the ray,
-        // otherwise process the scattering event.
-        if (extinction_is_null || volume_ray.m_tmax < distance_sample)
-        {
+            // Sample distance.
+            float distance_pdf;
+            if (extinction_is_null)
+            {
+                distance_sample = 0.0f;
+                distance_pdf = 0.0f;
+            }
+            else
+            {
+                sampling_context.split_in_place(1, 1);
+                distance_sample =
+                    foundation::sample_exponential_distribution(
+                        sampling_context.next2<float>(),
+                        extinction_coef[channel]);
+                distance_pdf =
+                    foundation::exponential_distribution_pdf(
+                        distance_sample,
+                        extinction_coef[channel]);
+            }
+
+            // Continue path tracing if sampled distance exceeds total length of the ray,
+            // otherwise process the scattering event.
+            if (extinction_is_null || volume_ray.m_tmax < distance_sample)
+            {
+                Spectrum transmission;
+                volume->evaluate_transmission(
+                    vertex.m_volume_data,
+                    volume_ray,
+                    transmission);
+                vertex.m_throughput *= transmission;
+                vertex.m_throughput /=                       // equivalent to multiplying by MIS weight
+                    foundation::average_value(transmission); // and then dividing by transmission[channel]
+                break;
+            }
+
+            // Retrieve scattering spectrum.
+            const Spectrum& scattering_coef =
+                volume->scattering_coefficient(vertex.m_volume_data, volume_ray);
+
+            // Evaluate transmission between the origin and the sampled distance.
             Spectrum transmission;
             volume->evaluate_transmission(
                 vertex.m_volume_data,
                 volume_ray,
+                distance_sample,
                 transmission);
-            vertex.m_throughput *= transmission;
-            vertex.m_throughput /=                       // equivalent to multiplying by MIS weight
-                foundation::average_value(transmission); // and then dividing by transmission[channel]
-            break;
+
+            // Compute MIS weight.
+            // MIS terms are:
+            //  - scattering albedo,
+            //  - throughput of the entire path up to the sampled point.
+            // Reference: "Practical and Controllable Subsurface Scattering
+            // for Production Path Tracing", p. 1 [ACM 2016 Article].
+            float mis_weights_sum = 0.0f;
+            for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
+            {
+                if (extinction_coef[i] > 1.0e-6f)
+                {
+                    const float probability =
+                        foundation::exponential_distribution_pdf(
+                            distance_sample,
+                            extinction_coef[i]);
+                    mis_weights_sum += foundation::square(probability);
+                }
+            }
+            if (mis_weights_sum < 1.0e-6f)
+                return false;  // no scattering
+            const float current_mis_weight =
+                Spectrum::size() *
+                foundation::square(distance_pdf) /
+                mis_weights_sum;
+
+            scattering_weight = scattering_coef;
+            scattering_weight *= transmission;
+            scattering_weight *= current_mis_weight / distance_pdf;
+        }
+        else
+        {
+            // Heterogeneous media are tracked by the volume itself (e.g. delta tracking).
+            if (!volume->sample_distance(
+                    sampling_context,
+                    vertex.m_volume_data,
+                    volume_ray,
+                    distance_sample,
+                    scattering_weight))
+            {
+                vertex.m_throughput *= scattering_weight;
+                break;
+            }
         }
 
         //
         // Bounce.
         //
 
-        ShadingPoint* next_shading_point = m_shading_point_arena.allocate<ShadingPoint>();
+        ShadingPoint* next_shading_point = shading_context.get_arena().allocate<ShadingPoint>();
+        m_vertex_marker = shading_context.get_arena().get_marker();
         shading_context.get_intersector().make_volume_shading_point(
             *next_shading_point,
             volume_ray,
@@ -915,46 +1115,7 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
         if (vertex.m_scattering_modes == ScatteringMode::None)
             return false;
 
-        // Retrieve scattering spectrum.
-        const Spectrum& scattering_coef =
-            volume->scattering_coefficient(vertex.m_volume_data, volume_ray);
-
-        // Evaluate transmission between the origin and the sampled distance.
-        Spectrum transmission;
-        volume->evaluate_transmission(
-            vertex.m_volume_data,
-            volume_ray,
-            distance_sample,
-            transmission);
-
-        // Compute MIS weight.
-        // MIS terms are:
-        //  - scattering albedo,
-        //  - throughput of the entire path up to the sampled point.
-        // Reference: "Practical and Controllable Subsurface Scattering
-        // for Production Path Tracing", p. 1 [ACM 2016 Article].
-        float mis_weights_sum = 0.0f;
-        for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
-        {
-            if (extinction_coef[i] > 1.0e-6f)
-            {
-                const float probability =
-                    foundation::exponential_distribution_pdf(
-                        distance_sample,
-                        extinction_coef[i]);
-                mis_weights_sum += foundation::square(probability);
-            }
-        }
-        if (mis_weights_sum < 1.0e-6f)
-            return false;  // no scattering
-        const float current_mis_weight =
-            Spectrum::size() *
-            foundation::square(distance_pdf) /
-            mis_weights_sum;
-
-        vertex.m_throughput *= scattering_coef;
-        vertex.m_throughput *= transmission;
-        vertex.m_throughput *= current_mis_weight / distance_pdf;
+        vertex.m_throughput *= scattering_weight;
 
         // Sample phase function.
         foundation::Vector3f incoming;
@@ -997,10 +1158,4 @@ bool PathTracer<PathVisitor, VolumeVisitor, Adjoint>::march(
     return true;
 }
 
-template <typename PathVisitor, typename VolumeVisitor, bool Adjoint>
-inline const ShadingPoint& PathTracer<PathVisitor, VolumeVisitor, Adjoint>::get_path_vertex(const size_t i) const
-{
-    return reinterpret_cast<const ShadingPoint*>(m_shading_point_arena.get_storage())[i];
-}
-
 }   // namespace renderer
@@ -35,13 +35,19 @@
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/aov/aovcomponents.h"
 #include "renderer/kernel/lighting/directlightingintegrator.h"
+#include "renderer/kernel/lighting/directlightingreservoirs.h"
+#include "renderer/kernel/lighting/adaptiverr.h"
+#include "renderer/kernel/lighting/guidedpath.h"
 #include "renderer/kernel/lighting/imagebasedlighting.h"
 #include "renderer/kernel/lighting/lightpathrecorder.h"
 #include "renderer/kernel/lighting/lightpathstream.h"
+#include "renderer/kernel/lighting/lightportals.h"
 #include "renderer/kernel/lighting/pathtracer.h"
 #include "renderer/kernel/lighting/pathvertex.h"
+#include "renderer/kernel/lighting/radiancecachepath.h"
 #include "renderer/kernel/lighting/scatteringmode.h"
 #include "renderer/kernel/lighting/volumelightingintegrator.h"
+#include "renderer/kernel/rendering/pixelcontext.h"
 #include "renderer/kernel/shading/shadingcomponents.h"
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
@@ -49,6 +55,10 @@
 #include "renderer/modeling/edf/edf.h"
 #include "renderer/modeling/environment/environment.h"
 #include "renderer/modeling/environmentedf/environmentedf.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
 #include "renderer/modeling/scene/scene.h"
 #include "renderer/utility/spectrumclamp.h"
 #include "renderer/utility/stochasticcast.h"
@@ -57,9 +67,13 @@
 #include "foundation/containers/dictionary.h"
 #include "foundation/math/mis.h"
 #include "foundation/math/population.h"
+#include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 #include "foundation/string/string.h"
+#include "foundation/utility/foreach.h"
+#include "foundation/utility/statcounters.h"
 #include "foundation/utility/statistics.h"
+#include "foundation/utility/uid.h"
 
 // Standard headers.
 #include <algorithm>
@@ -67,11 +81,12 @@
 #include <cstddef>
 #include <cstdint>
 #include <limits>
+#include <memory>
+#include <set>
 #include <string>
 
 // Forward declarations.
 namespace renderer  { class BackwardLightSampler; }
-namespace renderer  { class PixelContext; }
 namespace renderer  { class TextureCache; }
 
 using namespace foundation;
@@ -81,6 +96,53 @@ namespace renderer
 
 namespace
 {
+    //
+    // Detect the features of a scene that path tracers must support.
+    //
+    // Unlike Scene::has_participating_media(), all object instances are considered
+    // regardless of their visibility since paths may reach them by any kind of ray.
+    //
+
+    PathTracerFeatures::Type collect_path_tracer_features(
+        const AssemblyInstanceContainer&    assembly_instances,
+        std::set<UniqueID>&                 visited_assemblies)
+    {
+        PathTracerFeatures::Type features = PathTracerFeatures::None;
+
+        for (const_each<AssemblyInstanceContainer> i = assembly_instances; i; ++i)
+        {
+            const Assembly& assembly = i->get_assembly();
+
+            if (visited_assemblies.find(assembly.get_uid()) == visited_assemblies.end())
+            {
+                visited_assemblies.insert(assembly.get_uid());
+
+                for (const_each<ObjectInstanceContainer> j = assembly.object_instances(); j; ++j)
+                {
+                    if (j->has_participating_media())
+                        features |= PathTracerFeatures::ParticipatingMedia;
+
+                    if (j->has_subsurface_scattering())
+                        features |= PathTracerFeatures::Subsurface;
+                }
+
+                features |= collect_path_tracer_features(assembly.assembly_instances(), visited_assemblies);
+            }
+
+            if (features == PathTracerFeatures::All)
+                break;
+        }
+
+        return features;
+    }
+
+    PathTracerFeatures::Type detect_path_tracer_features(const Scene& scene)
+    {
+        std::set<UniqueID> visited_assemblies;
+        return collect_path_tracer_features(scene.assembly_instances(), visited_assemblies);
+    }
+
+
     //
     // Path Tracing lighting engine.
     //
@@ -98,16 +160,41 @@ namespace
         PTLightingEngine(
             const BackwardLightSampler&     light_sampler,
             LightPathRecorder&              light_path_recorder,
+            SDTree*                         sd_tree,
+            RadianceEstimateGrid*           radiance_estimates,
+            RadianceCache*                  radiance_cache,
+            DirectLightingReservoirs*       dl_reservoirs,
+            const PathTracerFeatures::Type  path_tracer_features,
             const ParamArray&               params)
           : m_params(params)
+          , m_path_tracer_features(path_tracer_features)
           , m_light_sampler(light_sampler)
           , m_light_path_stream(
               m_params.m_record_light_paths
                   ? light_path_recorder.create_stream()
                   : nullptr)
-          , m_path_count(0)
+          , m_dl_reservoirs(dl_reservoirs)
+          , m_pixel_coords(0, 0)
           , m_inf_volume_ray_warnings(0)
         {
+            if (sd_tree)
+            {
+                m_guided_path.reset(
+                    new GuidedPath(
+                        *sd_tree,
+                        m_params.m_path_guiding_bsdf_sampling_fraction));
+            }
+
+            if (radiance_estimates)
+            {
+                m_adaptive_rr.reset(
+                    new AdaptiveRR(
+                        *radiance_estimates,
+                        m_params.m_adaptive_rr_window_size));
+            }
+
+            if (radiance_cache)
+                m_radiance_cache_path.reset(new RadianceCachePath(*radiance_cache));
         }
 
         void release() override
@@ -128,6 +215,7 @@ namespace
                 "  max specular bounces          %s\n"
                 "  max volume bounces            %s\n"
                 "  russian roulette start bounce %s\n"
+                "  adaptive russian roulette     %s\n"
                 "  next event estimation         %s\n"
                 "  dl light samples              %s\n"
                 "  dl light threshold            %s\n"
@@ -135,7 +223,12 @@ namespace
                 "  max ray intensity             %s\n"
                 "  volume distance samples       %s\n"
                 "  equiangular sampling          %s\n"
-                "  clamp roughness               %s",
+                "  clamp roughness               %s\n"
+                "  path guiding                  %s\n"
+                "  radiance cache                %s\n"
+                "  dl resampling                 %s\n"
+                "  participating media           %s\n"
+                "  subsurface scattering         %s",
                 m_params.m_enable_dl ? "on" : "off",
                 m_params.m_enable_ibl ? "on" : "off",
                 m_params.m_enable_caustics ? "on" : "off",
@@ -145,6 +238,7 @@ namespace
                 m_params.m_max_specular_bounces == ~size_t(0) ? "unlimited" : pretty_uint(m_params.m_max_specular_bounces).c_str(),
                 m_params.m_max_volume_bounces == ~size_t(0) ? "unlimited" : pretty_uint(m_params.m_max_volume_bounces).c_str(),
                 m_params.m_rr_min_path_length == ~size_t(0) ? "unlimited" : pretty_uint(m_params.m_rr_min_path_length).c_str(),
+                m_adaptive_rr ? "on" : "off",
                 m_params.m_next_event_estimation ? "on" : "off",
                 pretty_scalar(m_params.m_dl_light_sample_count).c_str(),
                 pretty_scalar(m_params.m_dl_low_light_threshold, 3).c_str(),
@@ -152,7 +246,12 @@ namespace
                 m_params.m_has_max_ray_intensity ? pretty_scalar(m_params.m_max_ray_intensity).c_str() : "unlimited",
                 pretty_int(m_params.m_distance_sample_count).c_str(),
                 m_params.m_enable_equiangular_sampling ? "on" : "off",
-                m_params.m_clamp_roughness ? "on" : "off");
+                m_params.m_clamp_roughness ? "on" : "off",
+                m_guided_path ? "on" : "off",
+                m_radiance_cache_path ? "on" : "off",
+                m_dl_reservoirs ? "on" : "off",
+                (m_path_tracer_features & PathTracerFeatures::ParticipatingMedia) != 0 ? "on" : "off",
+                (m_path_tracer_features & PathTracerFeatures::Subsurface) != 0 ? "on" : "off");
         }
 
         void compute_lighting(
@@ -171,9 +270,12 @@ namespace
                     shading_point.get_ray().m_org);
             }
 
+            // Resampled direct lighting reuses the reservoirs of the pixel being rendered.
+            m_pixel_coords = pixel_context.get_pixel_coords();
+
             if (m_params.m_next_event_estimation)
             {
-                do_compute_lighting<PathVisitorNextEventEstimation, VolumeVisitorDistanceSampling>(
+                select_path_tracer<PathVisitorNextEventEstimation, VolumeVisitorDistanceSampling>(
                     sampling_context,
                     shading_context,
                     shading_point,
@@ -182,7 +284,7 @@ namespace
             }
             else
             {
-                do_compute_lighting<PathVisitorSimple, VolumeVisitorSimple>(
+                select_path_tracer<PathVisitorSimple, VolumeVisitorSimple>(
                     sampling_context,
                     shading_context,
                     shading_point,
@@ -194,7 +296,56 @@ namespace
                 m_light_path_stream->end_path();
         }
 
+        // Dispatch to the path tracer instantiation specialized for the features of the scene.
         template <typename PathVisitor, typename VolumeVisitor>
+        void select_path_tracer(
+            SamplingContext&        sampling_context,
+            const ShadingContext&   shading_context,
+            const ShadingPoint&     shading_point,
+            ShadingComponents&      radiance,               // output radiance, in W.sr^-1.m^-2
+            AOVComponents&          aov_components)
+        {
+            switch (m_path_tracer_features)
+            {
+              case PathTracerFeatures::None:
+                do_compute_lighting<PathVisitor, VolumeVisitor, PathTracerFeatures::None>(
+                    sampling_context,
+                    shading_context,
+                    shading_point,
+                    radiance,
+                    aov_components);
+                break;
+
+              case PathTracerFeatures::ParticipatingMedia:
+                do_compute_lighting<PathVisitor, VolumeVisitor, PathTracerFeatures::ParticipatingMedia>(
+                    sampling_context,
+                    shading_context,
+                    shading_point,
+                    radiance,
+                    aov_components);
+                break;
+
+              case PathTracerFeatures::Subsurface:
+                do_compute_lighting<PathVisitor, VolumeVisitor, PathTracerFeatures::Subsurface>(
+                    sampling_context,
+                    shading_context,
+                    shading_point,
+                    radiance,
+                    aov_components);
+                break;
+
+              default:
+                do_compute_lighting<PathVisitor, VolumeVisitor, PathTracerFeatures::All>(
+                    sampling_context,
+                    shading_context,
+                    shading_point,
+                    radiance,
+                    aov_components);
+                break;
+            }
+        }
+
+        template <typename PathVisitor, typename VolumeVisitor, PathTracerFeatures::Type Features>
         void do_compute_lighting(
             SamplingContext&        sampling_context,
             const ShadingContext&   shading_context,
@@ -210,7 +361,9 @@ namespace
                 shading_point.get_scene(),
                 radiance,
                 aov_components,
-                m_light_path_stream);
+                m_light_path_stream,
+                m_dl_reservoirs,
+                m_pixel_coords);
 
             VolumeVisitor volume_visitor(
                 m_params,
@@ -221,7 +374,7 @@ namespace
                 radiance,
                 m_inf_volume_ray_warnings);
 
-            PathTracer<PathVisitor, VolumeVisitor, false> path_tracer(     // false = not adjoint
+            PathTracer<PathVisitor, VolumeVisitor, false, Features> path_tracer(     // false = not adjoint
                 path_visitor,
                 volume_visitor,
                 m_params.m_rr_min_path_length,
@@ -231,7 +384,20 @@ namespace
                 m_params.m_max_specular_bounces,
                 m_params.m_max_volume_bounces,
                 m_params.m_clamp_roughness,
-                shading_context.get_max_iterations());
+                shading_context.get_max_iterations(),
+                0.0,                // near_start
+                m_guided_path.get(),
+                m_adaptive_rr.get(),
+                m_radiance_cache_path.get());
+
+            if (m_guided_path)
+                m_guided_path->begin_path(radiance);
+
+            if (m_adaptive_rr)
+                m_adaptive_rr->begin_path(radiance);
+
+            if (m_radiance_cache_path)
+                m_radiance_cache_path->begin_path(radiance);
 
             const size_t path_length =
                 path_tracer.trace(
@@ -239,16 +405,38 @@ namespace
                     shading_context,
                     shading_point);
 
+            if (m_guided_path)
+                m_guided_path->end_path();
+
+            if (m_adaptive_rr)
+                m_adaptive_rr->end_path();
+
+            if (m_radiance_cache_path)
+                m_radiance_cache_path->end_path();
+
             // Update statistics.
-            ++m_path_count;
-            m_path_length.insert(path_length);
+            ++m_stats->m_path_count;
+            m_stats->m_path_length.insert(path_length);
         }
 
         StatisticsVector get_statistics() const override
         {
             Statistics stats;
-            stats.insert("path count", m_path_count);
-            stats.insert("path length", m_path_length);
+
+            if (m_stats->m_path_count.is_enabled())
+                stats.insert("path count", m_stats->m_path_count.get());
+
+            if (m_stats->m_path_length.is_enabled())
+                stats.insert("path length", m_stats->m_path_length.get());
+
+            if (m_guided_path)
+                stats.insert<std::uint64_t>("guided samples", m_guided_path->get_guided_sample_count());
+
+            if (m_adaptive_rr)
+                stats.insert<std::uint64_t>("adaptive rr decisions", m_adaptive_rr->get_adaptive_decision_count());
+
+            if (m_radiance_cache_path)
+                stats.insert<std::uint64_t>("cached terminations", m_radiance_cache_path->get_terminated_path_count());
 
             return StatisticsVector::make("path tracing statistics", stats);
         }
@@ -269,6 +457,7 @@ namespace
             const bool      m_clamp_roughness;
 
             const size_t    m_rr_min_path_length;           // minimum path length before Russian Roulette kicks in, ~0 for unlimited
+            const float     m_adaptive_rr_window_size;      // ratio between the bounds of the weight window of adaptive Russian Roulette
             const bool      m_next_event_estimation;        // use next event estimation?
 
             const float     m_dl_light_sample_count;        // number of light samples used to estimate direct illumination
@@ -285,6 +474,8 @@ namespace
 
             const bool      m_record_light_paths;
 
+            const float     m_path_guiding_bsdf_sampling_fraction;  // probability of sampling the BSDF rather than the SD-tree
+
             explicit Parameters(const ParamArray& params)
               : m_enable_dl(params.get_optional<bool>("enable_dl", true))
               , m_enable_ibl(params.get_optional<bool>("enable_ibl", true))
@@ -296,6 +487,7 @@ namespace
               , m_max_volume_bounces(fixup_bounces(params.get_optional<int>("max_volume_bounces", 8)))
               , m_clamp_roughness(params.get_optional<bool>("clamp_roughness", false))
               , m_rr_min_path_length(fixup_path_length(params.get_optional<size_t>("rr_min_path_length", 6)))
+              , m_adaptive_rr_window_size(std::max(params.get_optional<float>("adaptive_rr_window_size", 5.0f), 1.0f))
               , m_next_event_estimation(params.get_optional<bool>("next_event_estimation", true))
               , m_dl_light_sample_count(params.get_optional<float>("dl_light_samples", 1.0f))
               , m_dl_low_light_threshold(params.get_optional<float>("dl_low_light_threshold", 0.0f))
@@ -305,6 +497,8 @@ namespace
               , m_distance_sample_count(params.get_optional<size_t>("volume_distance_samples", 2))
               , m_enable_equiangular_sampling(!params.get_optional<bool>("optimize_for_lights_outside_volumes", false))
               , m_record_light_paths(params.get_optional<bool>("record_light_paths", false))
+              , m_path_guiding_bsdf_sampling_fraction(
+                    clamp(params.get_optional<float>("path_guiding_bsdf_sampling_fraction", 0.5f), 0.01f, 0.99f))
             {
                 // Precompute the reciprocal of the number of light samples.
                 m_rcp_dl_light_sample_count =
@@ -331,11 +525,22 @@ namespace
         };
 
         const Parameters                m_params;
+        const PathTracerFeatures::Type  m_path_tracer_features;
         const BackwardLightSampler&     m_light_sampler;
         LightPathStream*                m_light_path_stream;
+        std::unique_ptr<GuidedPath>     m_guided_path;
+        std::unique_ptr<AdaptiveRR>     m_adaptive_rr;
+        std::unique_ptr<RadianceCachePath> m_radiance_cache_path;
+        DirectLightingReservoirs*       m_dl_reservoirs;
+        Vector2i                        m_pixel_coords;
 
-        std::uint64_t                   m_path_count;
-        Population<std::uint64_t>       m_path_length;
+        struct PathStatistics
+        {
+            StatCounter<StatsLevel::Basic>                          m_path_count;
+            StatPopulation<StatsLevel::Detailed, std::uint64_t>     m_path_length;
+        };
+
+        CacheLinePadded<PathStatistics> m_stats;
 
         size_t                          m_inf_volume_ray_warnings;
         static const size_t             MaxInfVolumeRayWarnings = 5;
@@ -382,9 +587,12 @@ namespace
             SamplingContext&                    m_sampling_context;
             const ShadingContext&               m_shading_context;
             const EnvironmentEDF*               m_env_edf;
+            const LightPortals*                 m_light_portals;
             ShadingComponents&                  m_path_radiance;
             AOVComponents&                      m_aov_components;
             LightPathStream*                    m_light_path_stream;
+            DirectLightingReservoirs*           m_dl_reservoirs;
+            const Vector2i                      m_pixel_coords;
             bool                                m_omit_emitted_light;
 
             PathVisitorBase(
@@ -395,15 +603,23 @@ namespace
                 const Scene&                    scene,
                 ShadingComponents&              path_radiance,
                 AOVComponents&                  aov_components,
-                LightPathStream*                light_path_stream)
+                LightPathStream*                light_path_stream,
+                DirectLightingReservoirs*       dl_reservoirs,
+                const Vector2i&                 pixel_coords)
               : m_params(params)
               , m_light_sampler(light_sampler)
               , m_sampling_context(sampling_context)
               , m_shading_context(shading_context)
               , m_env_edf(scene.get_environment()->get_environment_edf())
+              , m_light_portals(
+                  light_sampler.get_light_portals().empty()
+                      ? nullptr
+                      : &light_sampler.get_light_portals())
               , m_path_radiance(path_radiance)
               , m_aov_components(aov_components)
               , m_light_path_stream(light_path_stream)
+              , m_dl_reservoirs(dl_reservoirs)
+              , m_pixel_coords(pixel_coords)
               , m_omit_emitted_light(false)
             {
             }
@@ -425,7 +641,9 @@ namespace
                 const Scene&                    scene,
                 ShadingComponents&              path_radiance,
                 AOVComponents&                  aov_components,
-                LightPathStream*                light_path_stream)
+                LightPathStream*                light_path_stream,
+                DirectLightingReservoirs*       dl_reservoirs,
+                const Vector2i&                 pixel_coords)
               : PathVisitorBase(
                     params,
                     light_sampler,
@@ -434,7 +652,9 @@ namespace
                     scene,
                     path_radiance,
                     aov_components,
-                    light_path_stream)
+                    light_path_stream,
+                    dl_reservoirs,
+                    pixel_coords)
             {
             }
 
@@ -530,7 +750,9 @@ namespace
                 const Scene&                    scene,
                 ShadingComponents&              path_radiance,
                 AOVComponents&                  aov_components,
-                LightPathStream*                light_path_stream)
+                LightPathStream*                light_path_stream,
+                DirectLightingReservoirs*       dl_reservoirs,
+                const Vector2i&                 pixel_coords)
               : PathVisitorBase(
                     params,
                     light_sampler,
@@ -539,8 +761,11 @@ namespace
                     scene,
                     path_radiance,
                     aov_components,
-                    light_path_stream)
+                    light_path_stream,
+                    dl_reservoirs,
+                    pixel_coords)
               , m_is_indirect_lighting(false)
+              , m_omit_emitting_shapes(false)
             {
             }
 
@@ -574,6 +799,16 @@ namespace
                 if (vertex.m_prev_mode != ScatteringMode::Specular)
                 {
                     assert(vertex.m_prev_prob > 0.0f);
+
+                    // With light portals, the environment is only sampled through the portals.
+                    if (m_light_portals)
+                    {
+                        env_prob =
+                            m_light_portals->evaluate_pdf(
+                                vertex.get_ray().m_org,
+                                -Vector3f(vertex.m_outgoing.get_value()));
+                    }
+
                     const float env_sample_count = std::max(m_params.m_ibl_env_sample_count, 1.0f);
                     const float mis_weight =
                         mis_power2(
@@ -603,7 +838,8 @@ namespace
                     vertex.m_edf &&
                     vertex.m_cos_on > 0.0 &&
                     (vertex.m_path_length > 2 || m_params.m_enable_dl) &&
-                    (vertex.m_path_length < 2 || (vertex.m_edf->get_flags() & EDF::CastIndirectLight)))
+                    (vertex.m_path_length < 2 || (vertex.m_edf->get_flags() & EDF::CastIndirectLight)) &&
+                    (!m_omit_emitting_shapes || vertex.m_prev_mode == ScatteringMode::Specular))
                 {
                     // Compute the emitted radiance.
                     Spectrum emitted_radiance(0.0f);
@@ -642,6 +878,9 @@ namespace
                 if (ScatteringMode::has_diffuse_or_glossy_or_volume(vertex.m_prev_mode))
                     m_is_indirect_lighting = true;
 
+                // Only the vertex right after a resampled direct lighting estimate must ignore emitting shapes.
+                m_omit_emitting_shapes = false;
+
                 // When caustics are disabled, disable glossy and specular components after a diffuse or volume bounce.
                 if (!m_params.m_enable_caustics)
                 {
@@ -724,6 +963,7 @@ namespace
 
           private:
             bool m_is_indirect_lighting;
+            bool m_omit_emitting_shapes;            // was direct lighting at the previous vertex resampled?
 
             void add_emitted_light_contribution(
                 const PathVertex&           vertex,
@@ -784,12 +1024,32 @@ namespace
                     light_sample_count,
                     m_params.m_dl_low_light_threshold,
                     m_is_indirect_lighting);
-                integrator.compute_outgoing_radiance_light_sampling_low_variance(
-                    m_sampling_context,
-                    MISPower2,
-                    outgoing,
-                    dl_radiance,
-                    light_path_stream);
+
+                // Resample direct lighting at primary vertices when reservoirs are available.
+                // Resampling already accounts for the BSDF, so light-emitting shapes found by
+                // BSDF sampling from this vertex must then be ignored.
+                if (m_dl_reservoirs && !m_is_indirect_lighting && shading_point.get_ray().m_depth == 0)
+                {
+                    integrator.compute_outgoing_radiance_light_sampling_resampled(
+                        m_sampling_context,
+                        outgoing,
+                        m_pixel_coords,
+                        (bsdf.get_type() & BSDF::Transmissive) != 0,
+                        *m_dl_reservoirs,
+                        dl_radiance,
+                        light_path_stream);
+
+                    m_omit_emitting_shapes = true;
+                }
+                else
+                {
+                    integrator.compute_outgoing_radiance_light_sampling_low_variance(
+                        m_sampling_context,
+                        MISPower2,
+                        outgoing,
+                        dl_radiance,
+                        light_path_stream);
+                }
 
                 // Divide by the sample count when this number is less than 1.
                 if (m_params.m_rcp_dl_light_sample_count > 0.0f)
@@ -826,6 +1086,7 @@ namespace
                     m_sampling_context,
                     m_shading_context,
                     *m_env_edf,
+                    m_light_portals,
                     outgoing,
                     bsdf_sampler,
                     scattering_modes,
@@ -1142,6 +1403,23 @@ Dictionary PTLightingEngineFactory::get_params_metadata()
             .insert("label", "Russian Roulette Start Bounce")
             .insert("help", "Consider pruning low contribution paths starting with this bounce"));
 
+    metadata.dictionaries().insert(
+        "enable_adaptive_rr",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Enable Adaptive Russian Roulette")
+            .insert("help", "Learn radiance estimates over the passes and use them to prune paths with a low expected contribution to their pixel (requires multiple passes)"));
+
+    metadata.dictionaries().insert(
+        "adaptive_rr_window_size",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "5.0")
+            .insert("min", "1.0")
+            .insert("label", "Adaptive Russian Roulette Window Size")
+            .insert("help", "Ratio between the upper and lower bounds of the window of expected path contributions left untouched by adaptive Russian Roulette"));
+
     metadata.dictionaries().insert(
         "next_event_estimation",
         Dictionary()
@@ -1218,16 +1496,124 @@ Dictionary PTLightingEngineFactory::get_params_metadata()
             .insert("label", "Record Light Paths")
             .insert("help", "Record light paths in memory to later allow visualizing them or saving them to disk"));
 
+    metadata.dictionaries().insert(
+        "enable_path_guiding",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Enable Path Guiding")
+            .insert("help", "Learn the distribution of incident light over the passes and use it to choose bounce directions (requires multiple passes)"));
+
+    metadata.dictionaries().insert(
+        "path_guiding_bsdf_sampling_fraction",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.5")
+            .insert("min", "0.01")
+            .insert("max", "0.99")
+            .insert("label", "BSDF Sampling Fraction")
+            .insert("help", "Probability of choosing bounce directions by sampling the BSDF rather than the learned distribution"));
+
+    metadata.dictionaries().insert(
+        "path_guiding_max_memory",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "256")
+            .insert("min", "1")
+            .insert("label", "Path Guiding Memory Limit")
+            .insert("help", "Maximum memory used by the learned distribution, in megabytes"));
+
+    metadata.dictionaries().insert(
+        "enable_radiance_cache",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Enable Radiance Cache")
+            .insert("help", "Learn the radiance leaving surfaces over the passes and terminate paths into it after secondary diffuse bounces (requires multiple passes, introduces bias)"));
+
+    metadata.dictionaries().insert(
+        "radiance_cache_resolution",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "128")
+            .insert("min", "1")
+            .insert("label", "Radiance Cache Resolution")
+            .insert("help", "Number of radiance cache cells along the largest extent of the scene"));
+
+    metadata.dictionaries().insert(
+        "radiance_cache_max_memory",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "256")
+            .insert("min", "1")
+            .insert("label", "Radiance Cache Memory Limit")
+            .insert("help", "Maximum memory used by the radiance cache, in megabytes"));
+
+    metadata.dictionaries().insert(
+        "enable_dl_resampling",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Enable Direct Lighting Resampling")
+            .insert("help", "Choose the light sample of primary vertices among many candidates and reuse it across neighboring pixels and passes (requires multiple passes)"));
+
+    metadata.dictionaries().insert(
+        "dl_resampling_candidates",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "16")
+            .insert("min", "1")
+            .insert("label", "Resampling Candidates")
+            .insert("help", "Number of candidate light samples resampled at each primary vertex"));
+
+    metadata.dictionaries().insert(
+        "dl_resampling_spatial_neighbors",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "3")
+            .insert("min", "0")
+            .insert("max", "8")
+            .insert("label", "Resampling Spatial Neighbors")
+            .insert("help", "Number of neighboring pixels whose reservoirs are reused"));
+
+    metadata.dictionaries().insert(
+        "dl_resampling_spatial_radius",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "16.0")
+            .insert("min", "1.0")
+            .insert("label", "Resampling Spatial Radius")
+            .insert("help", "Radius in pixels within which neighboring reservoirs are reused"));
+
+    metadata.dictionaries().insert(
+        "dl_resampling_max_history",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "20.0")
+            .insert("min", "1.0")
+            .insert("label", "Resampling Max History")
+            .insert("help", "Maximum number of candidates, relative to the per-pass candidate count, a reservoir can accumulate"));
+
     return metadata;
 }
 
 PTLightingEngineFactory::PTLightingEngineFactory(
+    const Scene&                    scene,
     const BackwardLightSampler&     light_sampler,
     LightPathRecorder&              light_path_recorder,
+    SDTree*                         sd_tree,
+    RadianceEstimateGrid*           radiance_estimates,
+    RadianceCache*                  radiance_cache,
+    DirectLightingReservoirs*       dl_reservoirs,
     const ParamArray&               params)
   : m_light_sampler(light_sampler)
   , m_light_path_recorder(light_path_recorder)
+  , m_sd_tree(sd_tree)
+  , m_radiance_estimates(radiance_estimates)
+  , m_radiance_cache(radiance_cache)
+  , m_dl_reservoirs(dl_reservoirs)
   , m_params(params)
+  , m_path_tracer_features(detect_path_tracer_features(scene))
 {
 }
 
@@ -1242,6 +1628,11 @@ ILightingEngine* PTLightingEngineFactory::create()
         new PTLightingEngine(
             m_light_sampler,
             m_light_path_recorder,
+            m_sd_tree,
+            m_radiance_estimates,
+            m_radiance_cache,
+            m_dl_reservoirs,
+            m_path_tracer_features,
             m_params);
 }
 
@@ -36,10 +36,18 @@
 // appleseed.foundation headers.
 #include "foundation/platform/compiler.h"
 
+// Standard headers.
+#include <cstdint>
+
 // Forward declarations.
 namespace foundation    { class Dictionary; }
 namespace renderer      { class BackwardLightSampler; }
+namespace renderer      { class DirectLightingReservoirs; }
 namespace renderer      { class LightPathRecorder; }
+namespace renderer      { class RadianceCache; }
+namespace renderer      { class RadianceEstimateGrid; }
+namespace renderer      { class Scene; }
+namespace renderer      { class SDTree; }
 
 namespace renderer
 {
@@ -55,10 +63,20 @@ class PTLightingEngineFactory
     // Return parameters metadata.
     static foundation::Dictionary get_params_metadata();
 
-    // Constructor.
+    // Constructor. `sd_tree` is only required when path guiding is enabled,
+    // `radiance_estimates` only when adaptive Russian Roulette is enabled,
+    // `radiance_cache` only when radiance caching is enabled and `dl_reservoirs`
+    // only when resampled direct lighting is enabled. The scene is scanned
+    // for the features the path tracer must support (participating media,
+    // subsurface scattering) so that path tracers can be specialized for it.
     PTLightingEngineFactory(
+        const Scene&                    scene,
         const BackwardLightSampler&     light_sampler,
         LightPathRecorder&              light_path_recorder,
+        SDTree*                         sd_tree,
+        RadianceEstimateGrid*           radiance_estimates,
+        RadianceCache*                  radiance_cache,
+        DirectLightingReservoirs*       dl_reservoirs,
         const ParamArray&               params);
 
     // Delete this instance.
@@ -70,7 +88,12 @@ class PTLightingEngineFactory
   private:
     const BackwardLightSampler&         m_light_sampler;
     LightPathRecorder&                  m_light_path_recorder;
+    SDTree*                             m_sd_tree;
+    RadianceEstimateGrid*               m_radiance_estimates;
+    RadianceCache*                      m_radiance_cache;
+    DirectLightingReservoirs*           m_dl_reservoirs;
     ParamArray                          m_params;
+    std::uint32_t                       m_path_tracer_features;
 };
 
 }   // namespace renderer
@@ -0,0 +1,213 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "ptpasscallback.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/global/globaltypes.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/modeling/scene/scene.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/math/aabb.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/job/iabortswitch.h"
+#include "foundation/utility/statistics.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    // Number of samples a spatial leaf must receive before it gets subdivided.
+    const std::size_t SpatialThreshold = 12000;
+
+    std::size_t get_max_memory_size(const ParamArray& params)
+    {
+        const std::size_t max_memory_mb =
+            params.get_optional<std::size_t>("path_guiding_max_memory", 256);
+
+        return max_memory_mb * 1024 * 1024;
+    }
+
+    // Number of cells of the radiance estimate grid along the largest extent of the scene.
+    const std::size_t RadianceEstimateResolution = 64;
+
+    std::size_t get_radiance_cache_max_memory_size(const ParamArray& params)
+    {
+        const std::size_t max_memory_mb =
+            params.get_optional<std::size_t>("radiance_cache_max_memory", 256);
+
+        return max_memory_mb * 1024 * 1024;
+    }
+
+    DirectLightingReservoirs::Parameters get_dl_resampling_params(const ParamArray& params)
+    {
+        DirectLightingReservoirs::Parameters result;
+        result.m_candidate_count =
+            std::max<std::size_t>(params.get_optional<std::size_t>("dl_resampling_candidates", 16), 1);
+        result.m_spatial_reuse_count =
+            std::min<std::size_t>(
+                params.get_optional<std::size_t>("dl_resampling_spatial_neighbors", 3),
+                DirectLightingReservoirs::MaxSpatialReuseCount);
+        result.m_spatial_reuse_radius =
+            std::max(params.get_optional<float>("dl_resampling_spatial_radius", 16.0f), 1.0f);
+        result.m_max_history =
+            std::max(params.get_optional<float>("dl_resampling_max_history", 20.0f), 1.0f);
+        return result;
+    }
+}
+
+
+//
+// PTPassCallback class implementation.
+//
+
+PTPassCallback::PTPassCallback(
+    const Scene&                        scene,
+    const Frame&                        frame,
+    const ParamArray&                   params)
+{
+    const AABB3d scene_bbox(scene.compute_bbox());
+
+    if (params.get_optional<bool>("enable_path_guiding", false))
+    {
+        m_sd_tree.reset(
+            new SDTree(
+                scene_bbox,
+                SpatialThreshold,
+                get_max_memory_size(params)));
+    }
+
+    if (params.get_optional<bool>("enable_adaptive_rr", false))
+    {
+        m_radiance_estimates.reset(
+            new RadianceEstimateGrid(
+                scene_bbox,
+                RadianceEstimateResolution));
+    }
+
+    if (params.get_optional<bool>("enable_radiance_cache", false))
+    {
+        const std::size_t channel_count =
+            params.get_optional<std::string>("spectrum_mode", "rgb") == "rgb" ? 3 : Spectrum::Samples;
+
+        m_radiance_cache.reset(
+            new RadianceCache(
+                scene_bbox,
+                params.get_optional<std::size_t>("radiance_cache_resolution", 128),
+                channel_count,
+                get_radiance_cache_max_memory_size(params)));
+    }
+
+    if (params.get_optional<bool>("enable_dl_resampling", false))
+    {
+        const CanvasProperties& props = frame.image().properties();
+
+        m_dl_reservoirs.reset(
+            new DirectLightingReservoirs(
+                props.m_canvas_width,
+                props.m_canvas_height,
+                get_dl_resampling_params(params)));
+    }
+}
+
+void PTPassCallback::release()
+{
+    delete this;
+}
+
+void PTPassCallback::on_pass_begin(
+    const Frame&                        frame,
+    JobQueue&                           job_queue,
+    IAbortSwitch&                       abort_switch)
+{
+}
+
+void PTPassCallback::on_pass_end(
+    const Frame&                        frame,
+    JobQueue&                           job_queue,
+    IAbortSwitch&                       abort_switch)
+{
+    if (abort_switch.is_aborted())
+        return;
+
+    // Worker threads are idle between passes: structures can be rebuilt without synchronization.
+    if (m_sd_tree)
+    {
+        m_sd_tree->update();
+
+        RENDERER_LOG_DEBUG("%s",
+            StatisticsVector::make(
+                "path guiding statistics",
+                m_sd_tree->get_statistics()).to_string().c_str());
+    }
+
+    if (m_radiance_estimates)
+    {
+        m_radiance_estimates->update();
+
+        RENDERER_LOG_DEBUG("%s",
+            StatisticsVector::make(
+                "adaptive russian roulette statistics",
+                m_radiance_estimates->get_statistics()).to_string().c_str());
+    }
+
+    if (m_radiance_cache)
+    {
+        m_radiance_cache->update();
+
+        RENDERER_LOG_DEBUG("%s",
+            StatisticsVector::make(
+                "radiance cache statistics",
+                m_radiance_cache->get_statistics()).to_string().c_str());
+    }
+
+    if (m_dl_reservoirs)
+    {
+        m_dl_reservoirs->update();
+
+        RENDERER_LOG_DEBUG("%s",
+            StatisticsVector::make(
+                "direct lighting resampling statistics",
+                m_dl_reservoirs->get_statistics()).to_string().c_str());
+    }
+}
+
+}   // namespace renderer
@@ -0,0 +1,129 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/directlightingreservoirs.h"
+#include "renderer/kernel/lighting/radiancecache.h"
+#include "renderer/kernel/lighting/radianceestimategrid.h"
+#include "renderer/kernel/lighting/sdtree.h"
+#include "renderer/kernel/rendering/ipasscallback.h"
+#include "renderer/utility/paramarray.h"
+
+// Standard headers.
+#include <memory>
+
+// Forward declarations.
+namespace foundation    { class IAbortSwitch; }
+namespace foundation    { class JobQueue; }
+namespace renderer      { class Frame; }
+namespace renderer      { class Scene; }
+
+namespace renderer
+{
+
+//
+// This class owns the structures that path tracing lighting engines learn over the
+// passes (the SD-tree used for path guiding, the radiance estimates used for
+// adjoint-driven Russian Roulette, the radiance cache and the reservoirs of resampled
+// direct lighting) and refines them at the end of each pass.
+//
+
+class PTPassCallback
+  : public IPassCallback
+{
+  public:
+    // Constructor.
+    PTPassCallback(
+        const Scene&                        scene,
+        const Frame&                        frame,
+        const ParamArray&                   params);
+
+    // Delete this instance.
+    void release() override;
+
+    // This method is called at the beginning of a pass.
+    void on_pass_begin(
+        const Frame&                        frame,
+        foundation::JobQueue&               job_queue,
+        foundation::IAbortSwitch&           abort_switch) override;
+
+    // This method is called at the end of a pass.
+    void on_pass_end(
+        const Frame&                        frame,
+        foundation::JobQueue&               job_queue,
+        foundation::IAbortSwitch&           abort_switch) override;
+
+    // Return the SD-tree shared by all lighting engines, or nullptr if path guiding is disabled.
+    SDTree* get_sd_tree();
+
+    // Return the radiance estimates shared by all lighting engines, or nullptr if
+    // adjoint-driven Russian Roulette is disabled.
+    RadianceEstimateGrid* get_radiance_estimates();
+
+    // Return the radiance cache shared by all lighting engines, or nullptr if radiance caching is disabled.
+    RadianceCache* get_radiance_cache();
+
+    // Return the direct lighting reservoirs shared by all lighting engines, or nullptr if
+    // resampled direct lighting is disabled.
+    DirectLightingReservoirs* get_dl_reservoirs();
+
+  private:
+    std::unique_ptr<SDTree>                     m_sd_tree;
+    std::unique_ptr<RadianceEstimateGrid>       m_radiance_estimates;
+    std::unique_ptr<RadianceCache>              m_radiance_cache;
+    std::unique_ptr<DirectLightingReservoirs>   m_dl_reservoirs;
+};
+
+
+//
+// PTPassCallback class implementation.
+//
+
+inline SDTree* PTPassCallback::get_sd_tree()
+{
+    return m_sd_tree.get();
+}
+
+inline RadianceEstimateGrid* PTPassCallback::get_radiance_estimates()
+{
+    return m_radiance_estimates.get();
+}
+
+inline RadianceCache* PTPassCallback::get_radiance_cache()
+{
+    return m_radiance_cache.get();
+}
+
+inline DirectLightingReservoirs* PTPassCallback::get_dl_reservoirs()
+{
+    return m_dl_reservoirs.get();
+}
+
+}   // namespace renderer
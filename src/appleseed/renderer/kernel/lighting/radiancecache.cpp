@@ -0,0 +1,306 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "radiancecache.h"
+
+// appleseed.foundation headers.
+#include "foundation/hash/hash.h"
+#include "foundation/math/scalar.h"
+#include "foundation/platform/atomic.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    // Number of entries visited when looking for an entry before giving up.
+    const size_t MaxProbeCount = 8;
+
+    // Number of samples a direction bin must have received before it provides an estimate.
+    const std::uint32_t MinSampleCount = 16;
+
+    const size_t NoEntry = ~size_t(0);
+
+    // Return the index of the dominant axis of a vector, times two, plus one if the
+    // vector points toward the negative side of that axis.
+    size_t get_direction_bin(const Vector3d& v)
+    {
+        const size_t axis = max_abs_index(v);
+        return 2 * axis + (v[axis] < 0.0 ? 1 : 0);
+    }
+
+    std::uint32_t get_key(const std::uint64_t hash)
+    {
+        // Zero marks free entries.
+        const std::uint32_t key = static_cast<std::uint32_t>(hash >> 32);
+        return key != 0 ? key : 1;
+    }
+}
+
+
+//
+// RadianceCache class implementation.
+//
+
+RadianceCache::RadianceCache(
+    const AABB3d&               bbox,
+    const size_t                resolution,
+    const size_t                channel_count,
+    const size_t                max_memory_size)
+  : m_origin(0.0)
+  , m_rcp_cell_size(1.0)
+  , m_channel_count(std::max<size_t>(channel_count, 1))
+  , m_dropped_sample_count(0)
+  , m_update_count(0)
+  , m_tracked_memory("radiance cache")
+{
+    if (bbox.is_valid())
+    {
+        const double max_extent = max_value(bbox.extent());
+
+        if (max_extent > 0.0)
+        {
+            m_origin = bbox.min;
+            m_rcp_cell_size = static_cast<double>(std::max<size_t>(resolution, 1)) / max_extent;
+        }
+    }
+
+    // Use the largest power-of-two number of entries that fits in the memory budget.
+    const size_t entry_size =
+        sizeof(std::uint32_t) +
+        DirectionBinCount * (m_channel_count * (sizeof(float) + sizeof(double)) + 2 * sizeof(std::uint32_t));
+    const size_t max_entry_count = std::max<size_t>(max_memory_size / entry_size, 1);
+    m_entry_count = 1;
+    while (2 * m_entry_count <= max_entry_count)
+        m_entry_count *= 2;
+
+    const size_t bin_count = m_entry_count * DirectionBinCount;
+    m_keys.assign(m_entry_count, 0);
+    m_pass_sums.assign(bin_count * m_channel_count, 0.0f);
+    m_pass_counts.assign(bin_count, 0);
+    m_sums.assign(bin_count * m_channel_count, 0.0);
+    m_counts.assign(bin_count, 0);
+
+    m_tracked_memory.set_size(get_memory_size());
+}
+
+bool RadianceCache::lookup(
+    const Vector3d&             point,
+    const Vector3d&             normal,
+    const Vector3d&             outgoing,
+    Spectrum&                   radiance) const
+{
+    const size_t entry = find_entry(compute_hash(point, normal));
+    if (entry == NoEntry)
+        return false;
+
+    const size_t bin = entry * DirectionBinCount + get_direction_bin(outgoing);
+    const std::uint32_t count = m_counts[bin];
+    if (count < MinSampleCount)
+        return false;
+
+    // In hero wavelength mode, only the bands carried by the current path are retrieved.
+    const size_t band_offset = Spectrum::get_band_offset();
+    assert(band_offset < m_channel_count);
+
+    const double rcp_count = 1.0 / count;
+    const double* sums = &m_sums[bin * m_channel_count + band_offset];
+    const size_t channel_count = std::min(m_channel_count - band_offset, Spectrum::size());
+
+    radiance.set(0.0f);
+    for (size_t i = 0; i < channel_count; ++i)
+        radiance[i] = static_cast<float>(sums[i] * rcp_count);
+
+    return true;
+}
+
+void RadianceCache::record(
+    const Vector3d&             point,
+    const Vector3d&             normal,
+    const Vector3d&             outgoing,
+    const Spectrum&             radiance)
+{
+    const size_t band_offset = Spectrum::get_band_offset();
+    assert(band_offset < m_channel_count);
+
+    const size_t channel_count = std::min(m_channel_count - band_offset, Spectrum::size());
+
+    for (size_t i = 0; i < channel_count; ++i)
+    {
+        if (!(radiance[i] >= 0.0f && std::isfinite(radiance[i])))
+            return;
+    }
+
+    const size_t entry = find_or_insert_entry(compute_hash(point, normal));
+    if (entry == NoEntry)
+    {
+        atomic_inc(&m_dropped_sample_count);
+        return;
+    }
+
+    const size_t bin = entry * DirectionBinCount + get_direction_bin(outgoing);
+    float* sums = &m_pass_sums[bin * m_channel_count + band_offset];
+
+    // In hero wavelength mode, each band only receives the samples of the paths that carry
+    // it: weighting them keeps the per-bin averages unbiased.
+    const float band_weight = Spectrum::get_band_weight();
+
+    for (size_t i = 0; i < channel_count; ++i)
+        atomic_add(&sums[i], radiance[i] * band_weight);
+
+    atomic_inc(&m_pass_counts[bin]);
+}
+
+void RadianceCache::update()
+{
+    const size_t bin_count = m_entry_count * DirectionBinCount;
+
+    for (size_t bin = 0; bin < bin_count; ++bin)
+    {
+        const std::uint32_t pass_count = m_pass_counts[bin];
+        if (pass_count == 0)
+            continue;
+
+        float* pass_sums = &m_pass_sums[bin * m_channel_count];
+        double* sums = &m_sums[bin * m_channel_count];
+
+        for (size_t i = 0; i < m_channel_count; ++i)
+        {
+            sums[i] += pass_sums[i];
+            pass_sums[i] = 0.0f;
+        }
+
+        m_counts[bin] += pass_count;
+        m_pass_counts[bin] = 0;
+    }
+
+    ++m_update_count;
+}
+
+size_t RadianceCache::get_memory_size() const
+{
+    return
+        sizeof(*this) +
+        m_keys.capacity() * sizeof(std::uint32_t) +
+        m_pass_sums.capacity() * sizeof(float) +
+        m_pass_counts.capacity() * sizeof(std::uint32_t) +
+        m_sums.capacity() * sizeof(double) +
+        m_counts.capacity() * sizeof(std::uint32_t);
+}
+
+Statistics RadianceCache::get_statistics() const
+{
+    std::uint64_t used_entries = 0;
+    for (const std::uint32_t key : m_keys)
+    {
+        if (key != 0)
+            ++used_entries;
+    }
+
+    std::uint64_t valid_bins = 0;
+    for (const std::uint32_t count : m_counts)
+    {
+        if (count >= MinSampleCount)
+            ++valid_bins;
+    }
+
+    Statistics stats;
+    stats.insert("updates", m_update_count);
+    stats.insert_percent("used entries", used_entries, static_cast<std::uint64_t>(m_entry_count));
+    stats.insert_percent("valid bins", valid_bins, static_cast<std::uint64_t>(m_counts.size()));
+    stats.insert<std::uint64_t>("dropped samples", m_dropped_sample_count);
+    stats.insert_size("memory size", get_memory_size());
+
+    return stats;
+}
+
+std::uint64_t RadianceCache::compute_hash(
+    const Vector3d&             point,
+    const Vector3d&             normal) const
+{
+    const Vector3d p = (point - m_origin) * m_rcp_cell_size;
+
+    return
+        mix_uint64(
+            static_cast<std::uint64_t>(static_cast<std::int64_t>(std::floor(p[0]))),
+            static_cast<std::uint64_t>(static_cast<std::int64_t>(std::floor(p[1]))),
+            static_cast<std::uint64_t>(static_cast<std::int64_t>(std::floor(p[2]))),
+            static_cast<std::uint64_t>(get_direction_bin(normal)));
+}
+
+size_t RadianceCache::find_entry(const std::uint64_t hash) const
+{
+    const std::uint32_t key = get_key(hash);
+    const size_t mask = m_entry_count - 1;
+
+    for (size_t i = 0; i < MaxProbeCount; ++i)
+    {
+        const size_t entry = (static_cast<size_t>(hash) + i) & mask;
+        const std::uint32_t entry_key = m_keys[entry];
+
+        if (entry_key == key)
+            return entry;
+
+        // Entries are never freed: a free entry ends the probe sequence.
+        if (entry_key == 0)
+            break;
+    }
+
+    return NoEntry;
+}
+
+size_t RadianceCache::find_or_insert_entry(const std::uint64_t hash)
+{
+    const std::uint32_t key = get_key(hash);
+    const size_t mask = m_entry_count - 1;
+
+    for (size_t i = 0; i < MaxProbeCount; ++i)
+    {
+        const size_t entry = (static_cast<size_t>(hash) + i) & mask;
+        std::uint32_t entry_key = atomic_read(&m_keys[entry]);
+
+        // Try to claim a free entry; another thread may claim it first.
+        if (entry_key == 0)
+            entry_key = atomic_cas(&m_keys[entry], 0, key);
+
+        if (entry_key == 0 || entry_key == key)
+            return entry;
+    }
+
+    return NoEntry;
+}
+
+}   // namespace renderer
@@ -0,0 +1,137 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/memorytracker.h"
+#include "foundation/utility/statistics.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A world space cache of the radiance leaving surfaces, learned over the passes.
+//
+// The cache is a hash table of entries keyed by a voxel of a uniform grid over the
+// scene and by the dominant axis of the surface normal, so that both sides of thin
+// walls get separate entries. Each entry stores the outgoing radiance in six bins
+// of directions. The table has a fixed capacity derived from a memory budget: entries
+// are claimed with atomic compare-and-swap operations and samples that find no free
+// entry within a few probes are dropped.
+//
+// Samples recorded during a pass only become visible to lookups after update() is
+// called, so that all paths of a pass see the same cache. Bins that received too few
+// samples don't provide any estimate.
+//
+
+class RadianceCache
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    RadianceCache(
+        const foundation::AABB3d&   bbox,
+        const size_t                resolution,         // number of cells along the largest extent of the bounding box
+        const size_t                channel_count,      // number of spectrum channels to store
+        const size_t                max_memory_size);   // in bytes
+
+    // Retrieve the radiance leaving a surface point in a given direction. `normal` is the
+    // geometric normal on the side of `outgoing`. Return false if no estimate is available.
+    bool lookup(
+        const foundation::Vector3d& point,
+        const foundation::Vector3d& normal,
+        const foundation::Vector3d& outgoing,
+        Spectrum&                   radiance) const;
+
+    // Record a sample of the radiance leaving a surface point. Thread-safe and lock-free.
+    void record(
+        const foundation::Vector3d& point,
+        const foundation::Vector3d& normal,
+        const foundation::Vector3d& outgoing,
+        const Spectrum&             radiance);
+
+    // Merge the samples recorded since the last update into the cache. Not thread-safe.
+    void update();
+
+    // Return the number of updates since construction.
+    size_t get_update_count() const;
+
+    // Return the size in bytes of this cache.
+    size_t get_memory_size() const;
+
+    // Return statistics about this cache.
+    foundation::Statistics get_statistics() const;
+
+  private:
+    enum { DirectionBinCount = 6 };
+
+    foundation::Vector3d            m_origin;
+    double                          m_rcp_cell_size;
+    const size_t                    m_channel_count;
+    size_t                          m_entry_count;      // power of two
+    std::vector<std::uint32_t>      m_keys;             // 0 for free entries
+    std::vector<float>              m_pass_sums;        // per entry, per direction bin, per channel
+    std::vector<std::uint32_t>      m_pass_counts;      // per entry, per direction bin
+    std::vector<double>             m_sums;             // per entry, per direction bin, per channel
+    std::vector<std::uint32_t>      m_counts;           // per entry, per direction bin
+    std::uint32_t                   m_dropped_sample_count;
+    size_t                          m_update_count;
+    foundation::TrackedMemory       m_tracked_memory;
+
+    std::uint64_t compute_hash(
+        const foundation::Vector3d& point,
+        const foundation::Vector3d& normal) const;
+
+    // Return the index of the entry with a given hash, or ~size_t(0) if there is none.
+    size_t find_entry(const std::uint64_t hash) const;
+    size_t find_or_insert_entry(const std::uint64_t hash);
+};
+
+
+//
+// RadianceCache class implementation.
+//
+
+inline size_t RadianceCache::get_update_count() const
+{
+    return m_update_count;
+}
+
+}   // namespace renderer
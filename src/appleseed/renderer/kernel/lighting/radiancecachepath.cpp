@@ -0,0 +1,148 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "radiancecachepath.h"
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/pathvertex.h"
+#include "renderer/kernel/lighting/radiancecache.h"
+#include "renderer/kernel/lighting/scatteringmode.h"
+#include "renderer/kernel/shading/shadingcomponents.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    // Paths are only terminated into the cache after their first bounce off the camera
+    // path: the cache is too coarse to be seen directly through a single diffuse bounce.
+    const size_t MinTerminationPathLength = 3;
+
+    // Return the geometric normal on the side of the outgoing direction.
+    Vector3d get_facing_normal(const PathVertex& vertex)
+    {
+        const Vector3d& n = vertex.get_geometric_normal();
+        return dot(n, vertex.m_outgoing.get_value()) < 0.0 ? -n : n;
+    }
+}
+
+
+//
+// RadianceCachePath class implementation.
+//
+
+RadianceCachePath::RadianceCachePath(RadianceCache& cache)
+  : m_cache(cache)
+  , m_path_radiance(nullptr)
+  , m_vertex_count(0)
+  , m_terminated_path_count(0)
+{
+}
+
+void RadianceCachePath::begin_path(ShadingComponents& path_radiance)
+{
+    m_path_radiance = &path_radiance;
+    m_vertex_count = 0;
+}
+
+void RadianceCachePath::end_path()
+{
+    assert(m_path_radiance);
+
+    const Spectrum& path_radiance = m_path_radiance->m_beauty;
+
+    // The radiance gathered after a vertex, divided by the throughput up to that
+    // vertex, is the radiance leaving that vertex toward the previous one.
+    for (size_t i = 0; i < m_vertex_count; ++i)
+    {
+        const Vertex& vertex = m_vertices[i];
+
+        if (min_value(vertex.m_throughput) > 0.0f)
+        {
+            Spectrum radiance = path_radiance;
+            radiance -= vertex.m_radiance;
+            radiance /= vertex.m_throughput;
+            radiance = clamp_low(radiance, 0.0f);
+
+            m_cache.record(vertex.m_point, vertex.m_normal, vertex.m_outgoing, radiance);
+        }
+    }
+
+    m_path_radiance = nullptr;
+    m_vertex_count = 0;
+}
+
+bool RadianceCachePath::terminate(const PathVertex& vertex)
+{
+    assert(m_path_radiance);
+
+    if (vertex.m_path_length < MinTerminationPathLength ||
+        vertex.m_prev_mode != ScatteringMode::Diffuse ||
+        vertex.m_bsdf == nullptr ||
+        vertex.m_bssrdf != nullptr)
+        return false;
+
+    Spectrum radiance;
+    if (!m_cache.lookup(
+            vertex.get_point(),
+            get_facing_normal(vertex),
+            vertex.m_outgoing.get_value(),
+            radiance))
+        return false;
+
+    radiance *= vertex.m_throughput;
+    m_path_radiance->add_emission(vertex.m_path_length, vertex.m_aov_mode, radiance);
+
+    ++m_terminated_path_count;
+
+    return true;
+}
+
+void RadianceCachePath::add_vertex(const PathVertex& vertex)
+{
+    assert(m_path_radiance);
+
+    if (m_vertex_count < MaxVertexCount)
+    {
+        Vertex& v = m_vertices[m_vertex_count++];
+        v.m_point = vertex.get_point();
+        v.m_normal = get_facing_normal(vertex);
+        v.m_outgoing = vertex.m_outgoing.get_value();
+        v.m_throughput = vertex.m_throughput;
+        v.m_radiance = m_path_radiance->m_beauty;
+    }
+}
+
+}   // namespace renderer
@@ -0,0 +1,111 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+
+// Forward declarations.
+namespace renderer  { class PathVertex; }
+namespace renderer  { class RadianceCache; }
+namespace renderer  { class ShadingComponents; }
+
+namespace renderer
+{
+
+//
+// Radiance cache state of the paths traced by a path tracer, one path at a time.
+//
+// Paths reaching a surface through a diffuse bounce, past the first bounce, are
+// terminated into the cache where it knows the radiance that they would gather after
+// that vertex. Paths feed the cache with the radiance they actually gathered after
+// each of their surface vertices.
+//
+
+class RadianceCachePath
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    explicit RadianceCachePath(RadianceCache& cache);
+
+    // Begin a new path. `path_radiance` is the radiance accumulated by the path tracer.
+    void begin_path(ShadingComponents& path_radiance);
+
+    // Record the radiance gathered by the path into the cache.
+    void end_path();
+
+    // Add the cached radiance leaving a surface vertex, weighted by the path throughput,
+    // to the path radiance. Return true if the path should be terminated at that vertex.
+    bool terminate(const PathVertex& vertex);
+
+    // Remember a surface vertex through which the path continues.
+    void add_vertex(const PathVertex& vertex);     // path throughput up to the vertex, after Russian Roulette
+
+    // Return the number of paths terminated into the cache.
+    std::uint64_t get_terminated_path_count() const;
+
+  private:
+    struct Vertex
+    {
+        foundation::Vector3d                m_point;
+        foundation::Vector3d                m_normal;
+        foundation::Vector3d                m_outgoing;
+        Spectrum                            m_throughput;
+        Spectrum                            m_radiance;     // path radiance when the vertex was added
+    };
+
+    enum { MaxVertexCount = 16 };
+
+    RadianceCache&                          m_cache;
+    ShadingComponents*                      m_path_radiance;
+    Vertex                                  m_vertices[MaxVertexCount];
+    size_t                                  m_vertex_count;
+    std::uint64_t                           m_terminated_path_count;
+};
+
+
+//
+// RadianceCachePath class implementation.
+//
+
+inline std::uint64_t RadianceCachePath::get_terminated_path_count() const
+{
+    return m_terminated_path_count;
+}
+
+}   // namespace renderer
@@ -0,0 +1,193 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "radianceestimategrid.h"
+
+// appleseed.foundation headers.
+#include "foundation/hash/hash.h"
+#include "foundation/platform/atomic.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    // Number of cells of the hash table; must be a power of two.
+    const size_t CellCount = 1 << 16;
+
+    // Number of samples a cell must have received before it provides an estimate.
+    const std::uint64_t MinSampleCount = 16;
+
+    float get_estimate(const double sum, const std::uint64_t count)
+    {
+        return count >= MinSampleCount ? static_cast<float>(sum / count) : -1.0f;
+    }
+}
+
+
+//
+// RadianceEstimateGrid class implementation.
+//
+
+RadianceEstimateGrid::RadianceEstimateGrid(
+    const AABB3d&               bbox,
+    const size_t                resolution)
+  : m_origin(0.0)
+  , m_rcp_cell_size(1.0)
+  , m_update_count(0)
+  , m_tracked_memory("radiance estimates")
+{
+    if (bbox.is_valid())
+    {
+        const double max_extent = max_value(bbox.extent());
+
+        if (max_extent > 0.0)
+        {
+            m_origin = bbox.min;
+            m_rcp_cell_size = static_cast<double>(std::max<size_t>(resolution, 1)) / max_extent;
+        }
+    }
+
+    Accumulator accumulator;
+    accumulator.m_outgoing_sum = 0.0f;
+    accumulator.m_outgoing_count = 0;
+    accumulator.m_pixel_sum = 0.0f;
+    accumulator.m_pixel_count = 0;
+    m_accumulators.assign(CellCount, accumulator);
+
+    Cell cell;
+    cell.m_outgoing_sum = 0.0;
+    cell.m_outgoing_count = 0;
+    cell.m_pixel_sum = 0.0;
+    cell.m_pixel_count = 0;
+    cell.m_outgoing = -1.0f;
+    cell.m_pixel = -1.0f;
+    m_cells.assign(CellCount, cell);
+
+    m_tracked_memory.set_size(get_memory_size());
+}
+
+void RadianceEstimateGrid::record_outgoing(
+    const Vector3d&             point,
+    const float                 radiance)
+{
+    if (radiance >= 0.0f && std::isfinite(radiance))
+    {
+        Accumulator& accumulator = m_accumulators[find_cell(point)];
+        atomic_add(&accumulator.m_outgoing_sum, radiance);
+        atomic_inc(&accumulator.m_outgoing_count);
+    }
+}
+
+void RadianceEstimateGrid::record_pixel(
+    const Vector3d&             point,
+    const float                 value)
+{
+    if (value >= 0.0f && std::isfinite(value))
+    {
+        Accumulator& accumulator = m_accumulators[find_cell(point)];
+        atomic_add(&accumulator.m_pixel_sum, value);
+        atomic_inc(&accumulator.m_pixel_count);
+    }
+}
+
+void RadianceEstimateGrid::update()
+{
+    for (size_t i = 0; i < CellCount; ++i)
+    {
+        Accumulator& accumulator = m_accumulators[i];
+        Cell& cell = m_cells[i];
+
+        cell.m_outgoing_sum += accumulator.m_outgoing_sum;
+        cell.m_outgoing_count += accumulator.m_outgoing_count;
+        cell.m_pixel_sum += accumulator.m_pixel_sum;
+        cell.m_pixel_count += accumulator.m_pixel_count;
+
+        cell.m_outgoing = get_estimate(cell.m_outgoing_sum, cell.m_outgoing_count);
+        cell.m_pixel = get_estimate(cell.m_pixel_sum, cell.m_pixel_count);
+
+        accumulator.m_outgoing_sum = 0.0f;
+        accumulator.m_outgoing_count = 0;
+        accumulator.m_pixel_sum = 0.0f;
+        accumulator.m_pixel_count = 0;
+    }
+
+    ++m_update_count;
+}
+
+size_t RadianceEstimateGrid::get_memory_size() const
+{
+    return
+        sizeof(*this) +
+        m_accumulators.capacity() * sizeof(Accumulator) +
+        m_cells.capacity() * sizeof(Cell);
+}
+
+Statistics RadianceEstimateGrid::get_statistics() const
+{
+    std::uint64_t outgoing_cells = 0;
+    std::uint64_t pixel_cells = 0;
+
+    for (const Cell& cell : m_cells)
+    {
+        if (cell.m_outgoing >= 0.0f)
+            ++outgoing_cells;
+        if (cell.m_pixel > 0.0f)
+            ++pixel_cells;
+    }
+
+    Statistics stats;
+    stats.insert("updates", m_update_count);
+    stats.insert_percent("outgoing estimates", outgoing_cells, static_cast<std::uint64_t>(CellCount));
+    stats.insert_percent("pixel estimates", pixel_cells, static_cast<std::uint64_t>(CellCount));
+    stats.insert_size("memory size", get_memory_size());
+
+    return stats;
+}
+
+size_t RadianceEstimateGrid::find_cell(const Vector3d& point) const
+{
+    const Vector3d p = (point - m_origin) * m_rcp_cell_size;
+
+    const std::uint64_t h =
+        mix_uint64(
+            static_cast<std::uint64_t>(static_cast<std::int64_t>(std::floor(p[0]))),
+            static_cast<std::uint64_t>(static_cast<std::int64_t>(std::floor(p[1]))),
+            static_cast<std::uint64_t>(static_cast<std::int64_t>(std::floor(p[2]))));
+
+    return static_cast<size_t>(h & (CellCount - 1));
+}
+
+}   // namespace renderer
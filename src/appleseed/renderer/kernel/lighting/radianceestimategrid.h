@@ -0,0 +1,151 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/memorytracker.h"
+#include "foundation/utility/statistics.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A coarse, hashed voxel grid over the scene learning two scalar radiance estimates
+// over the passes:
+//
+//   - the radiance that paths still gather after reaching a point, per unit throughput,
+//   - the radiance carried by camera paths whose first vertex lies near a point, which
+//     stands in for the value of the pixels seeing that point.
+//
+// Samples recorded during a pass only become visible to lookups after update() is
+// called, so that all paths of a pass see the same estimates. Cells that received
+// too few samples don't provide any estimate.
+//
+
+class RadianceEstimateGrid
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    RadianceEstimateGrid(
+        const foundation::AABB3d&   bbox,
+        const size_t                resolution);        // number of cells along the largest extent of the bounding box
+
+    // Retrieve the estimates learned at a given point. Return false if none is available.
+    bool lookup_outgoing(
+        const foundation::Vector3d& point,
+        float&                      radiance) const;
+    bool lookup_pixel(
+        const foundation::Vector3d& point,
+        float&                      value) const;
+
+    // Record samples of the estimates at a given point. Thread-safe.
+    void record_outgoing(
+        const foundation::Vector3d& point,
+        const float                 radiance);
+    void record_pixel(
+        const foundation::Vector3d& point,
+        const float                 value);
+
+    // Merge the samples recorded since the last update into the estimates. Not thread-safe.
+    void update();
+
+    // Return the number of updates since construction.
+    size_t get_update_count() const;
+
+    // Return the size in bytes of this grid.
+    size_t get_memory_size() const;
+
+    // Return statistics about this grid.
+    foundation::Statistics get_statistics() const;
+
+  private:
+    struct Accumulator
+    {
+        float                       m_outgoing_sum;
+        std::uint32_t               m_outgoing_count;
+        float                       m_pixel_sum;
+        std::uint32_t               m_pixel_count;
+    };
+
+    struct Cell
+    {
+        double                      m_outgoing_sum;
+        std::uint64_t               m_outgoing_count;
+        double                      m_pixel_sum;
+        std::uint64_t               m_pixel_count;
+        float                       m_outgoing;         // negative if unknown
+        float                       m_pixel;            // negative if unknown
+    };
+
+    foundation::Vector3d            m_origin;
+    double                          m_rcp_cell_size;
+    std::vector<Accumulator>        m_accumulators;
+    std::vector<Cell>               m_cells;
+    size_t                          m_update_count;
+    foundation::TrackedMemory       m_tracked_memory;
+
+    size_t find_cell(const foundation::Vector3d& point) const;
+};
+
+
+//
+// RadianceEstimateGrid class implementation.
+//
+
+inline bool RadianceEstimateGrid::lookup_outgoing(
+    const foundation::Vector3d&     point,
+    float&                          radiance) const
+{
+    radiance = m_cells[find_cell(point)].m_outgoing;
+    return radiance >= 0.0f;
+}
+
+inline bool RadianceEstimateGrid::lookup_pixel(
+    const foundation::Vector3d&     point,
+    float&                          value) const
+{
+    value = m_cells[find_cell(point)].m_pixel;
+    return value > 0.0f;
+}
+
+inline size_t RadianceEstimateGrid::get_update_count() const
+{
+    return m_update_count;
+}
+
+}   // namespace renderer
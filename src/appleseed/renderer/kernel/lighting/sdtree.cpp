@@ -0,0 +1,529 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "sdtree.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/population.h"
+#include "foundation/math/scalar.h"
+#include "foundation/platform/atomic.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    const float OneMinusEpsilon = 0.99999994f;
+
+    // Fraction of the total energy above which a quadrant is subdivided.
+    const float DirectionalThreshold = 0.01f;
+
+    // Maximum depth of D-trees.
+    const size_t MaxDirectionalDepth = 20;
+
+    // Map a unit-length direction to the unit square.
+    Vector2f direction_to_square(const Vector3f& direction)
+    {
+        const float cos_theta = clamp(direction[2], -1.0f, 1.0f);
+
+        float phi = std::atan2(direction[1], direction[0]);
+        if (phi < 0.0f)
+            phi += TwoPi<float>();
+
+        return
+            Vector2f(
+                clamp((cos_theta + 1.0f) * 0.5f, 0.0f, OneMinusEpsilon),
+                clamp(phi * RcpTwoPi<float>(), 0.0f, OneMinusEpsilon));
+    }
+
+    // Map a point of the unit square to a unit-length direction.
+    Vector3f square_to_direction(const Vector2f& p)
+    {
+        const float cos_theta = 2.0f * p[0] - 1.0f;
+        const float sin_theta = std::sqrt(std::max(1.0f - cos_theta * cos_theta, 0.0f));
+        const float phi = TwoPi<float>() * p[1];
+
+        return
+            Vector3f(
+                sin_theta * std::cos(phi),
+                sin_theta * std::sin(phi),
+                cos_theta);
+    }
+
+    // Choose one of two intervals proportionally to their weights and remap s to [0,1) within it.
+    size_t choose_half(
+        const float     weight0,
+        const float     weight1,
+        float&          s)
+    {
+        const float p0 = weight0 / (weight0 + weight1);
+
+        if (s < p0)
+        {
+            s = std::min(s / p0, OneMinusEpsilon);
+            return 0;
+        }
+        else
+        {
+            s = std::min((s - p0) / (1.0f - p0), OneMinusEpsilon);
+            return 1;
+        }
+    }
+}
+
+
+//
+// DTree class implementation.
+//
+
+DTree::DTree()
+{
+    m_nodes.push_back(Node());
+    clear();
+}
+
+Vector3f DTree::sample(const Vector2f& s, float& pdf) const
+{
+    Vector2f u = s;
+    Vector2f origin(0.0f);
+    float size = 1.0f;
+    float square_pdf = 1.0f;
+    size_t node_index = 0;
+
+    while (true)
+    {
+        const Node& node = m_nodes[node_index];
+        const float* energies = node.m_energies;
+        const float total = energies[0] + energies[1] + energies[2] + energies[3];
+
+        // Sample uniformly below nodes that did not receive any energy.
+        if (!(total > 0.0f))
+            break;
+
+        // Choose a column, then a quadrant within that column.
+        const size_t x = choose_half(energies[0] + energies[2], energies[1] + energies[3], u[0]);
+        const size_t y = choose_half(energies[x], energies[x + 2], u[1]);
+        const size_t child = x + 2 * y;
+
+        square_pdf *= 4.0f * energies[child] / total;
+        size *= 0.5f;
+        origin += Vector2f(static_cast<float>(x), static_cast<float>(y)) * size;
+
+        if (node.m_children[child] == 0)
+            break;
+
+        node_index = node.m_children[child];
+    }
+
+    pdf = square_pdf * RcpFourPi<float>();
+
+    return square_to_direction(origin + u * size);
+}
+
+float DTree::evaluate_pdf(const Vector3f& direction) const
+{
+    Vector2f p = direction_to_square(direction);
+    float square_pdf = 1.0f;
+    size_t node_index = 0;
+
+    while (true)
+    {
+        const Node& node = m_nodes[node_index];
+        const float* energies = node.m_energies;
+        const float total = energies[0] + energies[1] + energies[2] + energies[3];
+
+        if (!(total > 0.0f))
+            break;
+
+        const size_t x = p[0] < 0.5f ? 0 : 1;
+        const size_t y = p[1] < 0.5f ? 0 : 1;
+        const size_t child = x + 2 * y;
+
+        square_pdf *= 4.0f * energies[child] / total;
+
+        if (square_pdf == 0.0f || node.m_children[child] == 0)
+            break;
+
+        p[0] = 2.0f * p[0] - static_cast<float>(x);
+        p[1] = 2.0f * p[1] - static_cast<float>(y);
+        node_index = node.m_children[child];
+    }
+
+    return square_pdf * RcpFourPi<float>();
+}
+
+void DTree::record(const Vector3f& direction, const float energy)
+{
+    Vector2f p = direction_to_square(direction);
+    size_t node_index = 0;
+
+    while (true)
+    {
+        Node& node = m_nodes[node_index];
+
+        const size_t x = p[0] < 0.5f ? 0 : 1;
+        const size_t y = p[1] < 0.5f ? 0 : 1;
+        const size_t child = x + 2 * y;
+
+        atomic_add(&node.m_energies[child], energy);
+
+        if (node.m_children[child] == 0)
+            break;
+
+        p[0] = 2.0f * p[0] - static_cast<float>(x);
+        p[1] = 2.0f * p[1] - static_cast<float>(y);
+        node_index = node.m_children[child];
+    }
+}
+
+void DTree::build(
+    const DTree&                source,
+    const float                 threshold,
+    const size_t                max_depth,
+    const size_t                max_node_count)
+{
+    assert(&source != this);
+
+    m_nodes.clear();
+    m_nodes.push_back(Node());
+
+    const Node& source_root = source.m_nodes[0];
+    const float total =
+        source_root.m_energies[0] +
+        source_root.m_energies[1] +
+        source_root.m_energies[2] +
+        source_root.m_energies[3];
+
+    struct Entry
+    {
+        std::uint32_t   m_source_index;     // ~0 if the source node is a leaf
+        std::uint32_t   m_node_index;
+        size_t          m_depth;
+        float           m_energy;           // energy of the node, used if the source node is a leaf
+    };
+
+    const std::uint32_t NoSource = ~std::uint32_t(0);
+
+    std::vector<Entry> stack;
+    stack.push_back(Entry{ 0, 0, 1, total });
+
+    while (!stack.empty())
+    {
+        const Entry entry = stack.back();
+        stack.pop_back();
+
+        for (size_t c = 0; c < 4; ++c)
+        {
+            // Quadrants that were leaves in the source tree are assumed to have received uniform energy.
+            const float energy =
+                entry.m_source_index != NoSource
+                    ? source.m_nodes[entry.m_source_index].m_energies[c]
+                    : entry.m_energy * 0.25f;
+
+            if (!(total > 0.0f) ||
+                entry.m_depth >= max_depth ||
+                energy <= threshold * total ||
+                m_nodes.size() >= max_node_count)
+                continue;
+
+            const std::uint32_t child_index = static_cast<std::uint32_t>(m_nodes.size());
+            m_nodes.push_back(Node());
+            m_nodes[entry.m_node_index].m_children[c] = child_index;
+
+            const std::uint32_t source_child_index =
+                entry.m_source_index != NoSource && source.m_nodes[entry.m_source_index].m_children[c] != 0
+                    ? source.m_nodes[entry.m_source_index].m_children[c]
+                    : NoSource;
+
+            stack.push_back(Entry{ source_child_index, child_index, entry.m_depth + 1, energy });
+        }
+    }
+
+    clear();
+}
+
+void DTree::clear()
+{
+    for (Node& node : m_nodes)
+    {
+        for (size_t c = 0; c < 4; ++c)
+            node.m_energies[c] = 0.0f;
+    }
+}
+
+size_t DTree::get_depth() const
+{
+    size_t max_depth = 0;
+
+    std::vector<std::pair<std::uint32_t, size_t>> stack;
+    stack.emplace_back(0, 1);
+
+    while (!stack.empty())
+    {
+        const std::pair<std::uint32_t, size_t> entry = stack.back();
+        stack.pop_back();
+
+        max_depth = std::max(max_depth, entry.second);
+
+        for (size_t c = 0; c < 4; ++c)
+        {
+            const std::uint32_t child_index = m_nodes[entry.first].m_children[c];
+            if (child_index != 0)
+                stack.emplace_back(child_index, entry.second + 1);
+        }
+    }
+
+    return max_depth;
+}
+
+
+//
+// SDTree class implementation.
+//
+
+SDTree::SDTree(
+    const AABB3d&               bbox,
+    const size_t                spatial_threshold,
+    const size_t                max_memory_size)
+  : m_origin(0.0)
+  , m_extent(1.0)
+  , m_spatial_threshold(static_cast<std::uint32_t>(spatial_threshold))
+  , m_max_memory_size(max_memory_size)
+  , m_update_count(0)
+  , m_tracked_memory("path guiding")
+{
+    if (bbox.is_valid())
+    {
+        m_origin = bbox.min;
+        m_extent = bbox.extent();
+    }
+
+    Node root;
+    root.m_children[0] = root.m_children[1] = 0;
+    root.m_leaf_index = 0;
+    root.m_axis = 0;
+    m_nodes.push_back(root);
+
+    Leaf leaf;
+    leaf.m_sample_count = 0;
+    m_leaves.push_back(leaf);
+
+    m_tracked_memory.set_size(get_memory_size());
+}
+
+const DTree* SDTree::get_sampling_dtree(const Vector3d& point) const
+{
+    const DTree& dtree = m_leaves[find_leaf(point)].m_sampling_dtree;
+    return dtree.is_valid() ? &dtree : nullptr;
+}
+
+void SDTree::record(
+    const Vector3d&             point,
+    const Vector3f&             direction,
+    const float                 energy)
+{
+    Leaf& leaf = m_leaves[find_leaf(point)];
+
+    if (energy > 0.0f && std::isfinite(energy))
+        leaf.m_building_dtree.record(direction, energy);
+
+    atomic_inc(&leaf.m_sample_count);
+}
+
+void SDTree::update()
+{
+    // Split spatial leaves that received many samples.
+    split_leaves();
+
+    // Distribute the memory left among D-trees.
+    const size_t spatial_memory_size =
+        m_nodes.capacity() * sizeof(Node) +
+        m_leaves.capacity() * sizeof(Leaf);
+    const size_t dtree_memory_size =
+        m_max_memory_size > spatial_memory_size
+            ? m_max_memory_size - spatial_memory_size
+            : 0;
+    const size_t max_dtree_node_count =
+        std::max<size_t>(dtree_memory_size / (2 * m_leaves.size() * DTree::get_node_memory_size()), 1);
+
+    // Make the energy recorded during the last pass available for sampling and
+    // refine the directional subdivisions accordingly.
+    for (Leaf& leaf : m_leaves)
+    {
+        if (leaf.m_building_dtree.is_valid())
+        {
+            std::swap(leaf.m_sampling_dtree, leaf.m_building_dtree);
+
+            leaf.m_building_dtree.build(
+                leaf.m_sampling_dtree,
+                DirectionalThreshold,
+                MaxDirectionalDepth,
+                max_dtree_node_count);
+        }
+
+        leaf.m_sample_count = 0;
+    }
+
+    ++m_update_count;
+
+    m_tracked_memory.set_size(get_memory_size());
+}
+
+size_t SDTree::get_memory_size() const
+{
+    size_t size =
+        sizeof(*this) +
+        m_nodes.capacity() * sizeof(Node) +
+        m_leaves.capacity() * sizeof(Leaf);
+
+    for (const Leaf& leaf : m_leaves)
+    {
+        size += leaf.m_sampling_dtree.get_memory_size();
+        size += leaf.m_building_dtree.get_memory_size();
+    }
+
+    return size;
+}
+
+Statistics SDTree::get_statistics() const
+{
+    Population<std::uint64_t> dtree_node_counts;
+    Population<std::uint64_t> dtree_depths;
+
+    for (const Leaf& leaf : m_leaves)
+    {
+        dtree_node_counts.insert(leaf.m_sampling_dtree.get_node_count());
+        dtree_depths.insert(leaf.m_sampling_dtree.get_depth());
+    }
+
+    Statistics stats;
+    stats.insert("updates", m_update_count);
+    stats.insert("spatial nodes", m_nodes.size());
+    stats.insert("spatial leaves", m_leaves.size());
+    stats.insert("directional nodes", dtree_node_counts);
+    stats.insert("directional depth", dtree_depths);
+    stats.insert_size("memory size", get_memory_size());
+
+    return stats;
+}
+
+size_t SDTree::find_leaf(const Vector3d& point) const
+{
+    Vector3d p;
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        p[i] =
+            m_extent[i] > 0.0
+                ? clamp((point[i] - m_origin[i]) / m_extent[i], 0.0, 1.0)
+                : 0.5;
+    }
+
+    size_t node_index = 0;
+
+    while (true)
+    {
+        const Node& node = m_nodes[node_index];
+
+        if (node.m_children[0] == 0)
+            return node.m_leaf_index;
+
+        double& x = p[node.m_axis];
+
+        if (x < 0.5)
+        {
+            x = 2.0 * x;
+            node_index = node.m_children[0];
+        }
+        else
+        {
+            x = 2.0 * x - 1.0;
+            node_index = node.m_children[1];
+        }
+    }
+}
+
+void SDTree::split_leaves()
+{
+    size_t memory_size = get_memory_size();
+
+    // Children are appended to the node array and are visited in turn, so that
+    // leaves keep being split until their share of samples is below the threshold.
+    for (size_t i = 0; i < m_nodes.size(); ++i)
+    {
+        if (m_nodes[i].m_children[0] != 0)
+            continue;
+
+        const std::uint32_t leaf_index = m_nodes[i].m_leaf_index;
+
+        if (m_leaves[leaf_index].m_sample_count <= m_spatial_threshold)
+            continue;
+
+        // Don't split beyond the memory budget.
+        const size_t leaf_memory_size =
+            sizeof(Leaf) +
+            m_leaves[leaf_index].m_sampling_dtree.get_memory_size() +
+            m_leaves[leaf_index].m_building_dtree.get_memory_size();
+        if (memory_size + 2 * sizeof(Node) + leaf_memory_size > m_max_memory_size)
+            break;
+        memory_size += 2 * sizeof(Node) + leaf_memory_size;
+
+        // Both children inherit the statistics of their parent.
+        m_leaves[leaf_index].m_sample_count /= 2;
+        const Leaf leaf_copy = m_leaves[leaf_index];
+        const std::uint32_t new_leaf_index = static_cast<std::uint32_t>(m_leaves.size());
+        m_leaves.push_back(leaf_copy);
+
+        const std::uint32_t child_axis = (m_nodes[i].m_axis + 1) % 3;
+        const std::uint32_t first_child_index = static_cast<std::uint32_t>(m_nodes.size());
+
+        Node child;
+        child.m_children[0] = child.m_children[1] = 0;
+        child.m_axis = child_axis;
+
+        child.m_leaf_index = leaf_index;
+        m_nodes.push_back(child);
+
+        child.m_leaf_index = new_leaf_index;
+        m_nodes.push_back(child);
+
+        m_nodes[i].m_children[0] = first_child_index;
+        m_nodes[i].m_children[1] = first_child_index + 1;
+    }
+}
+
+}   // namespace renderer
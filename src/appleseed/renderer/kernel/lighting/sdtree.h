@@ -0,0 +1,228 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/memorytracker.h"
+#include "foundation/utility/statistics.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A directional quadtree (D-tree) representing a distribution of incident radiance
+// over the sphere of directions.
+//
+// Directions are mapped to the unit square using the area-preserving cylindrical
+// mapping (cos(theta), phi). Each node stores the energy recorded in its four
+// quadrants; sampling and PDF evaluation descend the tree proportionally to these
+// energies.
+//
+
+class DTree
+{
+  public:
+    // Constructor. The tree initially has a single level.
+    DTree();
+
+    // Return true if this tree holds a distribution that can be sampled.
+    bool is_valid() const;
+
+    // Sample a direction and return its probability density in solid angle measure.
+    foundation::Vector3f sample(
+        const foundation::Vector2f& s,
+        float&                      pdf) const;
+
+    // Return the probability density of a given direction in solid angle measure.
+    float evaluate_pdf(const foundation::Vector3f& direction) const;
+
+    // Record energy arriving from a given direction. Thread-safe.
+    void record(
+        const foundation::Vector3f& direction,
+        const float                 energy);
+
+    // Rebuild this tree from the energy distribution of another tree: quadrants
+    // holding more than `threshold` of the total energy are subdivided, the others
+    // are collapsed. Recorded energies are reset.
+    void build(
+        const DTree&                source,
+        const float                 threshold,
+        const size_t                max_depth,
+        const size_t                max_node_count);
+
+    // Reset recorded energies while keeping the structure of the tree.
+    void clear();
+
+    // Return the number of nodes and the depth of the tree.
+    size_t get_node_count() const;
+    size_t get_depth() const;
+
+    // Return the size in bytes of the nodes of this tree.
+    size_t get_memory_size() const;
+
+    // Return the size in bytes of a single node.
+    static size_t get_node_memory_size();
+
+  private:
+    struct Node
+    {
+        float                       m_energies[4];
+        std::uint32_t               m_children[4];      // 0 for leaves
+    };
+
+    std::vector<Node>               m_nodes;
+};
+
+
+//
+// A spatial binary tree over the scene bounding box whose leaves hold D-trees (SD-tree).
+//
+// Each leaf owns two D-trees: one that is only read for sampling during a pass,
+// and one that accumulates energy during the same pass. update() is called between
+// passes to refine the spatial and directional subdivisions from the recorded
+// statistics and to make the new distributions available for sampling.
+//
+// Reference:
+//
+//   Practical Path Guiding for Efficient Light-Transport Simulation
+//   Thomas Muller, Markus Gross, Jan Novák
+//   https://tom94.net/data/publications/mueller17practical/mueller17practical.pdf
+//
+
+class SDTree
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    SDTree(
+        const foundation::AABB3d&   bbox,
+        const size_t                spatial_threshold,  // number of samples after which a spatial leaf is split
+        const size_t                max_memory_size);   // in bytes
+
+    // Return the D-tree to sample at a given point, or nullptr if nothing was learned there yet.
+    const DTree* get_sampling_dtree(const foundation::Vector3d& point) const;
+
+    // Record energy arriving at a given point from a given direction. Thread-safe.
+    void record(
+        const foundation::Vector3d& point,
+        const foundation::Vector3f& direction,
+        const float                 energy);
+
+    // Refine the tree from the statistics recorded since the last update and make
+    // the learned distributions available for sampling. Not thread-safe.
+    void update();
+
+    // Return the number of updates since construction.
+    size_t get_update_count() const;
+
+    // Return the size in bytes of this tree.
+    size_t get_memory_size() const;
+
+    // Return statistics about this tree.
+    foundation::Statistics get_statistics() const;
+
+  private:
+    struct Node
+    {
+        std::uint32_t               m_children[2];      // 0 for leaves
+        std::uint32_t               m_leaf_index;       // index of the leaf data, only defined for leaves
+        std::uint32_t               m_axis;             // split axis
+    };
+
+    struct Leaf
+    {
+        DTree                       m_sampling_dtree;
+        DTree                       m_building_dtree;
+        std::uint32_t               m_sample_count;
+    };
+
+    foundation::Vector3d            m_origin;
+    foundation::Vector3d            m_extent;
+    const std::uint32_t             m_spatial_threshold;
+    const size_t                    m_max_memory_size;
+    std::vector<Node>               m_nodes;
+    std::vector<Leaf>               m_leaves;
+    size_t                          m_update_count;
+    foundation::TrackedMemory       m_tracked_memory;
+
+    size_t find_leaf(const foundation::Vector3d& point) const;
+
+    void split_leaves();
+};
+
+
+//
+// DTree class implementation.
+//
+
+inline bool DTree::is_valid() const
+{
+    const Node& root = m_nodes[0];
+
+    return
+        root.m_energies[0] +
+        root.m_energies[1] +
+        root.m_energies[2] +
+        root.m_energies[3] > 0.0f;
+}
+
+inline size_t DTree::get_node_count() const
+{
+    return m_nodes.size();
+}
+
+inline size_t DTree::get_memory_size() const
+{
+    return m_nodes.capacity() * sizeof(Node);
+}
+
+inline size_t DTree::get_node_memory_size()
+{
+    return sizeof(Node);
+}
+
+
+//
+// SDTree class implementation.
+//
+
+inline size_t SDTree::get_update_count() const
+{
+    return m_update_count;
+}
+
+}   // namespace renderer
@@ -34,6 +34,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/statistics.h"
 
@@ -57,8 +58,12 @@ SPPMImportonMap::SPPMImportonMap(SPPMImportonVector& importons)
             pretty_uint(importon_count).c_str(),
             importon_count > 1 ? "importons" : "importon");
 
-        knn::Builder3f builder(*this);
-        builder.build_move_points<DefaultWallclockTimer>(importons);
+        const size_t MaxImportonsPerLeaf = 8;
+
+        knn::Builder3f builder(*this, MaxImportonsPerLeaf);
+        builder.build_move_points<DefaultWallclockTimer>(
+            importons,
+            System::get_logical_cpu_core_count());
 
         Statistics statistics;
         statistics.insert_time("build time", builder.get_build_time());
@@ -532,22 +532,26 @@ namespace
                 {
                     // Retrieve the i'th photon.
                     const knn::Answer<float>::Entry& entry = m_answer.get(i);
-                    const SPPMMonoPhoton& photon =
+                    const SPPMPhotonVector::MonoPhotonArray::ConstReference photon =
                         m_pass_callback.get_mono_photon(
                             photon_map.remap(entry.m_index));
 
+                    // Decode the photon's directions.
+                    const Vector3f incoming(photon.get<SPPMPhotonVector::Incoming>());
+                    const Vector3f geometric_normal(photon.get<SPPMPhotonVector::GeometricNormal>());
+
                     // Reject photons from the opposite hemisphere as they won't contribute.
-                    if (dot(normal, photon.m_incoming) <= 0.0f)
+                    if (dot(normal, incoming) <= 0.0f)
                         continue;
 
                     // Reject photons on a surface with too different an orientation.
                     const float NormalThreshold = 1.0e-3f;
-                    if (dot(normal, photon.m_geometric_normal) < NormalThreshold)
+                    if (dot(normal, geometric_normal) < NormalThreshold)
                         continue;
 
 #if 0
                     // Reject photons on the wrong side of the surface.
-                    if (dot(vertex.m_outgoing, Vector3d(photon.m_geometric_normal)) <= 0.0)
+                    if (dot(vertex.m_outgoing, Vector3d(geometric_normal)) <= 0.0)
                         continue;
 #endif
 
@@ -573,7 +577,7 @@ namespace
                             true,                                       // multiply by |cos(incoming, normal)|
                             local_geometry,
                             Vector3f(vertex.m_outgoing.get_value()),    // toward the camera
-                            normalize(photon.m_incoming),               // toward the light
+                            incoming,                                   // toward the light
                             ScatteringMode::Diffuse,
                             bsdf_value);
                     if (bsdf_prob == 0.0f)
@@ -582,15 +586,19 @@ namespace
                     // The photons store flux but we are computing reflected radiance.
                     // The first step of the flux -> radiance conversion is done here.
                     // The conversion will be completed when doing density estimation.
-                    float bsdf_mono_value = bsdf_value.m_beauty[photon.m_flux.m_wavelength];
-                    bsdf_mono_value /= std::abs(dot(photon.m_incoming, photon.m_geometric_normal));
-                    bsdf_mono_value *= photon.m_flux.m_amplitude;
+                    const SpectrumLine& flux = photon.get<SPPMPhotonVector::Flux>();
+                    const std::size_t channel = flux.m_wavelength - Spectrum::get_band_offset();
+                    if (channel >= Spectrum::size())
+                        continue;   // in hero wavelength mode, the photon's band is not carried by this path
+                    float bsdf_mono_value = bsdf_value.m_beauty[channel];
+                    bsdf_mono_value /= std::abs(dot(incoming, geometric_normal));
+                    bsdf_mono_value *= flux.m_amplitude;
 
                     // Apply kernel weight.
                     bsdf_mono_value *= epanechnikov2d(entry.m_square_dist * rcp_max_square_dist);
 
                     // Accumulate reflected flux.
-                    radiance[photon.m_flux.m_wavelength] += bsdf_mono_value;
+                    radiance[channel] += bsdf_mono_value;
                 }
             }
 
@@ -607,22 +615,26 @@ namespace
                 {
                     // Retrieve the i'th photon.
                     const knn::Answer<float>::Entry& entry = m_answer.get(i);
-                    const SPPMPolyPhoton& photon =
+                    const SPPMPhotonVector::PolyPhotonArray::ConstReference photon =
                         m_pass_callback.get_poly_photon(
                             photon_map.remap(entry.m_index));
 
+                    // Decode the photon's directions.
+                    const Vector3f incoming(photon.get<SPPMPhotonVector::Incoming>());
+                    const Vector3f geometric_normal(photon.get<SPPMPhotonVector::GeometricNormal>());
+
                     // Reject photons from the opposite hemisphere as they won't contribute.
-                    if (dot(normal, photon.m_incoming) <= 0.0f)
+                    if (dot(normal, incoming) <= 0.0f)
                         continue;
 
                     // Reject photons on a surface with too different an orientation.
                     const float NormalThreshold = 1.0e-3f;
-                    if (dot(normal, photon.m_geometric_normal) < NormalThreshold)
+                    if (dot(normal, geometric_normal) < NormalThreshold)
                         continue;
 
 #if 0
                     // Reject photons on the wrong side of the surface.
-                    if (dot(vertex.m_outgoing, Vector3d(photon.m_geometric_normal)) <= 0.0)
+                    if (dot(vertex.m_outgoing, Vector3d(geometric_normal)) <= 0.0)
                         continue;
 #endif
 
@@ -648,7 +660,7 @@ namespace
                             true,                                       // multiply by |cos(incoming, normal)|
                             local_geometry,
                             Vector3f(vertex.m_outgoing.get_value()),    // toward the camera
-                            normalize(photon.m_incoming),               // toward the light
+                            incoming,                                   // toward the light
                             ScatteringMode::Diffuse,
                             bsdf_value);
                     if (bsdf_prob == 0.0f)
@@ -657,8 +669,8 @@ namespace
                     // The photons store flux but we are computing reflected radiance.
                     // The first step of the flux -> radiance conversion is done here.
                     // The conversion will be completed when doing density estimation.
-                    bsdf_value.m_beauty /= std::abs(dot(photon.m_incoming, photon.m_geometric_normal));
-                    bsdf_value.m_beauty *= photon.m_flux;
+                    bsdf_value.m_beauty /= std::abs(dot(incoming, geometric_normal));
+                    bsdf_value.m_beauty *= photon.get<SPPMPhotonVector::Flux>();
 
                     // Apply kernel weight.
                     bsdf_value.m_beauty *= epanechnikov2d(entry.m_square_dist * rcp_max_square_dist);
@@ -708,8 +720,10 @@ namespace
                 {
                     const knn::Answer<float>::Entry& photon = m_answer.get(i);
                     const SpectrumLine& flux =
-                        m_pass_callback.get_mono_photon(photon_map.remap(photon.m_index)).m_flux;
-                    radiance[flux.m_wavelength] += flux.m_amplitude;
+                        m_pass_callback.get_mono_photon(photon_map.remap(photon.m_index)).get<SPPMPhotonVector::Flux>();
+                    const std::size_t channel = flux.m_wavelength - Spectrum::get_band_offset();
+                    if (channel < Spectrum::size())
+                        radiance[channel] += flux.m_amplitude;
                 }
             }
             else
@@ -717,7 +731,7 @@ namespace
                 for (std::size_t i = 0; i < photon_count; ++i)
                 {
                     const knn::Answer<float>::Entry& photon = m_answer.get(i);
-                    radiance += m_pass_callback.get_poly_photon(photon_map.remap(photon.m_index)).m_flux;
+                    radiance += m_pass_callback.get_poly_photon(photon_map.remap(photon.m_index)).get<SPPMPhotonVector::Flux>();
                 }
             }
 
@@ -911,6 +925,41 @@ Dictionary SPPMLightingEngineFactory::get_params_metadata()
             .insert("label", "Alpha")
             .insert("help", "Evolution rate of photon lookup radius"));
 
+    metadata.dictionaries().insert(
+        "node_count",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "1")
+            .insert("min", "1")
+            .insert("label", "Render Nodes")
+            .insert("help", "Number of render nodes sharing photon tracing, each tracing a disjoint subset of the photons of every pass"));
+
+    metadata.dictionaries().insert(
+        "node_index",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "0")
+            .insert("min", "0")
+            .insert("label", "Render Node Index")
+            .insert("help", "Index of this render node, between 0 and the number of render nodes minus one"));
+
+    metadata.dictionaries().insert(
+        "photon_exchange_path",
+        Dictionary()
+            .insert("type", "text")
+            .insert("default", "")
+            .insert("label", "Photon Exchange Directory")
+            .insert("help", "Directory shared by all render nodes through which photons are exchanged"));
+
+    metadata.dictionaries().insert(
+        "photon_exchange_timeout",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "600.0")
+            .insert("min", "0.0")
+            .insert("label", "Photon Exchange Timeout")
+            .insert("help", "Maximum time in seconds to wait for the photons of other render nodes"));
+
     return metadata;
 }
 
@@ -95,7 +95,7 @@ namespace
 }
 
 SPPMParameters::SPPMParameters(const ParamArray& params)
-  : m_spectrum_mode(get_spectrum_mode(params))
+  : m_spectrum_mode(get_shared_data_spectrum_mode(get_spectrum_mode(params)))
   , m_sampling_mode(get_sampling_context_mode(params))
   , m_pass_count(params.get_optional<size_t>("passes", 1))
   , m_photon_type(get_photon_type(params, "photon_type", "poly"))
@@ -105,6 +105,10 @@ SPPMParameters::SPPMParameters(const ParamArray& params)
   , m_light_photon_count(params.get_optional<size_t>("light_photons_per_pass", 1000000))
   , m_env_photon_count(params.get_optional<size_t>("env_photons_per_pass", 1000000))
   , m_photon_packet_size(params.get_optional<size_t>("photon_packet_size", 100000))
+  , m_node_index(params.get_optional<size_t>("node_index", 0))
+  , m_node_count(params.get_optional<size_t>("node_count", 1))
+  , m_photon_exchange_path(params.get_optional<std::string>("photon_exchange_path", ""))
+  , m_photon_exchange_timeout(params.get_optional<float>("photon_exchange_timeout", 600.0f))
   , m_enable_importons(params.get_optional<bool>("enable_importons", true))
   , m_importon_lookup_radius_percents(params.get_optional<float>("importon_lookup_radius", 5.0f))
   , m_photon_tracing_max_bounces(fixup_bounces(params.get_optional<int>("photon_tracing_max_bounces", -1)))
@@ -128,6 +132,24 @@ SPPMParameters::SPPMParameters(const ParamArray& params)
         m_dl_light_sample_count > 0.0f && m_dl_light_sample_count < 1.0f
             ? 1.0f / m_dl_light_sample_count
             : 0.0f;
+
+    // Distributed photon tracing requires a place to exchange photons.
+    if (m_node_count > 1 && m_photon_exchange_path.empty())
+    {
+        RENDERER_LOG_ERROR("sppm photon tracing cannot be distributed without a photon exchange path; tracing all photons on this node.");
+        m_node_index = 0;
+        m_node_count = 1;
+    }
+
+    if (m_node_count == 0 || m_node_index >= m_node_count)
+    {
+        RENDERER_LOG_ERROR(
+            "invalid sppm node index " FMT_SIZE_T " for " FMT_SIZE_T " node(s); tracing all photons on this node.",
+            m_node_index,
+            m_node_count);
+        m_node_index = 0;
+        m_node_count = 1;
+    }
 }
 
 void SPPMParameters::print() const
@@ -150,12 +172,16 @@ void SPPMParameters::print() const
         "  environment photons           %s\n"
         "  max bounces                   %s\n"
         "  russian roulette start bounce %s\n"
-        "  importon lookup radius        %s%%",
+        "  importon lookup radius        %s%%\n"
+        "  render nodes                  %s",
         pretty_uint(m_light_photon_count).c_str(),
         pretty_uint(m_env_photon_count).c_str(),
         m_photon_tracing_max_bounces == ~size_t(0) ? "unlimited" : pretty_uint(m_photon_tracing_max_bounces).c_str(),
         m_photon_tracing_rr_min_path_length == ~size_t(0) ? "unlimited" : pretty_uint(m_photon_tracing_rr_min_path_length).c_str(),
-        pretty_scalar(m_importon_lookup_radius_percents, 3).c_str());
+        pretty_scalar(m_importon_lookup_radius_percents, 3).c_str(),
+        m_node_count > 1
+            ? (pretty_uint(m_node_index + 1) + " of " + pretty_uint(m_node_count)).c_str()
+            : "single");
 
     RENDERER_LOG_INFO(
         "sppm path tracing settings:\n"
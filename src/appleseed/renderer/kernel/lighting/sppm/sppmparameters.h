@@ -34,6 +34,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <string>
 
 // Forward declarations.
 namespace renderer  { class ParamArray; }
@@ -60,6 +61,11 @@ struct SPPMParameters
     const std::size_t           m_env_photon_count;                         // number of photons emitted from the environment
     const std::size_t           m_photon_packet_size;                       // number of photons per tracing job
 
+    std::size_t                 m_node_index;                               // index of this render node when photon tracing is distributed
+    std::size_t                 m_node_count;                               // number of render nodes sharing photon tracing, 1 when not distributed
+    const std::string           m_photon_exchange_path;                     // directory shared by all render nodes to exchange photons
+    const float                 m_photon_exchange_timeout;                  // maximum time in seconds to wait for the photons of other nodes
+
     const bool                  m_enable_importons;                         // are importons enabled?
     const float                 m_importon_lookup_radius_percents;          // importon lookup radius as a percentage of the scene diameter
     const std::size_t           m_photon_tracing_max_bounces;               // maximum number of photon bounces, ~0 for unlimited
@@ -91,6 +91,10 @@ SPPMPassCallback::SPPMPassCallback(
 
     // Start with the initial photon lookup radius.
     m_photon_lookup_radius = m_initial_photon_lookup_radius;
+
+    // Exchange photons with other render nodes if photon tracing is distributed.
+    if (m_params.m_node_count > 1)
+        m_photon_exchange.reset(new SPPMPhotonExchange(m_params));
 }
 
 void SPPMPassCallback::release()
@@ -156,6 +160,19 @@ void SPPMPassCallback::on_pass_begin(
         if (abort_switch.is_aborted())
             return;
 
+        // Gather the photons traced by other render nodes.
+        if (m_photon_exchange)
+        {
+            m_photon_exchange->exchange(
+                m_photons,
+                effective_pass_number,
+                pass_hash,
+                abort_switch);
+
+            if (abort_switch.is_aborted())
+                return;
+        }
+
         // Build a new photon map.
         m_photon_map.reset(new SPPMPhotonMap(m_photons));
 
@@ -35,6 +35,7 @@
 #include "renderer/kernel/lighting/sppm/sppmlightingengineworkingset.h"
 #include "renderer/kernel/lighting/sppm/sppmparameters.h"
 #include "renderer/kernel/lighting/sppm/sppmphoton.h"
+#include "renderer/kernel/lighting/sppm/sppmphotonexchange.h"
 #include "renderer/kernel/lighting/sppm/sppmphotonmap.h"
 #include "renderer/kernel/lighting/sppm/sppmphotontracer.h"
 #include "renderer/kernel/rendering/ipasscallback.h"
@@ -108,8 +109,8 @@ class SPPMPassCallback
     float get_photon_lookup_radius() const;
 
     // Return the i'th photon.
-    const SPPMMonoPhoton& get_mono_photon(const std::size_t i) const;
-    const SPPMPolyPhoton& get_poly_photon(const std::size_t i) const;
+    SPPMPhotonVector::MonoPhotonArray::ConstReference get_mono_photon(const std::size_t i) const;
+    SPPMPhotonVector::PolyPhotonArray::ConstReference get_poly_photon(const std::size_t i) const;
 
     // Hand over a newly allocated, empty working set.
     SPPMLightingEngineWorkingSet& acquire_working_set();
@@ -117,6 +118,7 @@ class SPPMPassCallback
   private:
     const SPPMParameters                    m_params;
     SPPMPhotonTracer                        m_photon_tracer;
+    std::unique_ptr<SPPMPhotonExchange>     m_photon_exchange;
     IShadingResultFrameBufferFactory&       m_shading_result_framebuffer_factory;
     std::size_t                             m_pass_number;
     SPPMPhotonVector                        m_photons;
@@ -151,12 +153,12 @@ inline float SPPMPassCallback::get_photon_lookup_radius() const
     return m_photon_lookup_radius;
 }
 
-inline const SPPMMonoPhoton& SPPMPassCallback::get_mono_photon(const std::size_t i) const
+inline SPPMPhotonVector::MonoPhotonArray::ConstReference SPPMPassCallback::get_mono_photon(const std::size_t i) const
 {
     return m_photons.m_mono_photons[i];
 }
 
-inline const SPPMPolyPhoton& SPPMPassCallback::get_poly_photon(const std::size_t i) const
+inline SPPMPhotonVector::PolyPhotonArray::ConstReference SPPMPassCallback::get_poly_photon(const std::size_t i) const
 {
     return m_photons.m_poly_photons[i];
 }
@@ -56,8 +56,8 @@ size_t SPPMPhotonVector::get_memory_size() const
 {
     return
         m_positions.capacity() * sizeof(Vector3f) +
-        m_mono_photons.capacity() * sizeof(SPPMMonoPhoton) +
-        m_poly_photons.capacity() * sizeof(SPPMPolyPhoton);
+        m_mono_photons.get_memory_size() +
+        m_poly_photons.get_memory_size();
 }
 
 void SPPMPhotonVector::swap(SPPMPhotonVector& rhs)
@@ -70,15 +70,15 @@ void SPPMPhotonVector::swap(SPPMPhotonVector& rhs)
 void SPPMPhotonVector::clear_release_memory()
 {
     foundation::clear_release_memory(m_positions);
-    foundation::clear_release_memory(m_mono_photons);
-    foundation::clear_release_memory(m_poly_photons);
+    m_mono_photons.clear_release_memory();
+    m_poly_photons.clear_release_memory();
 }
 
 void SPPMPhotonVector::clear_keep_memory()
 {
     foundation::clear_keep_memory(m_positions);
-    foundation::clear_keep_memory(m_mono_photons);
-    foundation::clear_keep_memory(m_poly_photons);
+    m_mono_photons.clear_keep_memory();
+    m_poly_photons.clear_keep_memory();
 }
 
 void SPPMPhotonVector::reserve_mono_photons(const size_t capacity)
@@ -98,7 +98,7 @@ void SPPMPhotonVector::push_back(
     const SPPMMonoPhoton&   photon)
 {
     m_positions.push_back(position);
-    m_mono_photons.push_back(photon);
+    m_mono_photons.push_back(photon.m_incoming, photon.m_geometric_normal, photon.m_flux);
 }
 
 void SPPMPhotonVector::push_back(
@@ -106,15 +106,15 @@ void SPPMPhotonVector::push_back(
     const SPPMPolyPhoton&   photon)
 {
     m_positions.push_back(position);
-    m_poly_photons.push_back(photon);
+    m_poly_photons.push_back(photon.m_incoming, photon.m_geometric_normal, photon.m_flux);
 }
 
 void SPPMPhotonVector::append(const SPPMPhotonVector& rhs)
 {
     boost::mutex::scoped_lock lock(m_mutex);
     m_positions.insert(m_positions.end(), rhs.m_positions.begin(), rhs.m_positions.end());
-    m_mono_photons.insert(m_mono_photons.end(), rhs.m_mono_photons.begin(), rhs.m_mono_photons.end());
-    m_poly_photons.insert(m_poly_photons.end(), rhs.m_poly_photons.begin(), rhs.m_poly_photons.end());
+    m_mono_photons.append(rhs.m_mono_photons);
+    m_poly_photons.append(rhs.m_poly_photons);
 }
 
 }   // namespace renderer
@@ -33,6 +33,8 @@
 #include "renderer/global/globaltypes.h"
 
 // appleseed.foundation headers.
+#include "foundation/containers/soavector.h"
+#include "foundation/math/compressedunitvector.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/thread.h"
 
@@ -57,9 +59,9 @@ struct SpectrumLine
 class SPPMMonoPhoton
 {
   public:
-    foundation::Vector3f    m_incoming;             // incoming direction, world space, unit length
-    foundation::Vector3f    m_geometric_normal;     // geometric normal at the photon location, world space, unit length
-    SpectrumLine            m_flux;                 // flux carried by this photon (in W)
+    foundation::CompressedUnitVector    m_incoming;             // incoming direction, world space
+    foundation::CompressedUnitVector    m_geometric_normal;     // geometric normal at the photon location, world space
+    SpectrumLine                        m_flux;                 // flux carried by this photon (in W)
 };
 
 
@@ -70,22 +72,45 @@ class SPPMMonoPhoton
 class SPPMPolyPhoton
 {
   public:
-    foundation::Vector3f    m_incoming;             // incoming direction, world space, unit length
-    foundation::Vector3f    m_geometric_normal;     // geometric normal at the photon location, world space, unit length
-    Spectrum                m_flux;                 // flux carried by this photon (in W)
+    foundation::CompressedUnitVector    m_incoming;             // incoming direction, world space
+    foundation::CompressedUnitVector    m_geometric_normal;     // geometric normal at the photon location, world space
+    Spectrum                            m_flux;                 // flux carried by this photon (in W)
 };
 
 
 //
 // A vector of photons.
 //
+// Photons are stored as structures of arrays so that lookups, which reject most
+// photons based on their directions alone, don't load the flux of rejected photons.
+//
 
 class SPPMPhotonVector
 {
   public:
+    // Indices of the photon fields in the photon arrays.
+    enum Field
+    {
+        Incoming,
+        GeometricNormal,
+        Flux
+    };
+
+    typedef foundation::SoAVector<
+        foundation::CompressedUnitVector,
+        foundation::CompressedUnitVector,
+        SpectrumLine
+    > MonoPhotonArray;
+
+    typedef foundation::SoAVector<
+        foundation::CompressedUnitVector,
+        foundation::CompressedUnitVector,
+        Spectrum
+    > PolyPhotonArray;
+
     std::vector<foundation::Vector3f>   m_positions;
-    std::vector<SPPMMonoPhoton>         m_mono_photons;
-    std::vector<SPPMPolyPhoton>         m_poly_photons;
+    MonoPhotonArray                     m_mono_photons;
+    PolyPhotonArray                     m_poly_photons;
     boost::mutex                        m_mutex;
 
     bool empty() const;
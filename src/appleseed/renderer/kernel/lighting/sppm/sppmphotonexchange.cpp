@@ -0,0 +1,296 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "sppmphotonexchange.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/kernel/lighting/sppm/sppmparameters.h"
+#include "renderer/kernel/lighting/sppm/sppmphoton.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/thread.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/bufferedfile.h"
+#include "foundation/utility/job/iabortswitch.h"
+#include "foundation/utility/stopwatch.h"
+
+// Boost headers.
+#include "boost/filesystem.hpp"
+
+// Standard headers.
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <sstream>
+
+using namespace foundation;
+namespace bf = boost::filesystem;
+
+namespace renderer
+{
+
+namespace
+{
+    // Version of the photon exchange file format. Bump whenever the layout of photons changes.
+    const std::uint16_t PhotonFileVersion = 1;
+
+    const char PhotonFileSignature[11] =
+        { 'S', 'P', 'P', 'M', 'P', 'H', 'O', 'T', 'O', 'N', 'S' };
+
+    // Interval in milliseconds between two checks for the photons of other nodes.
+    const std::uint32_t PollingInterval = 50;
+
+    template <typename Array, std::size_t... I>
+    void write_columns(BufferedFile& file, const Array& array)
+    {
+        checked_write(file, static_cast<std::uint64_t>(array.size()));
+
+        if (!array.empty())
+        {
+            const int dummy[] =
+            {
+                (checked_write(
+                    file,
+                    array.template column<I>(),
+                    array.size() * sizeof(typename Array::template Field<I>::Type)), 0)...
+            };
+            (void)dummy;
+        }
+    }
+
+    template <typename Array, std::size_t... I>
+    void read_columns(BufferedFile& file, Array& array)
+    {
+        std::uint64_t size;
+        checked_read(file, size);
+        array.resize(static_cast<std::size_t>(size));
+
+        if (!array.empty())
+        {
+            const int dummy[] =
+            {
+                (checked_read(
+                    file,
+                    array.template column<I>(),
+                    array.size() * sizeof(typename Array::template Field<I>::Type)), 0)...
+            };
+            (void)dummy;
+        }
+    }
+
+    void write_photons(const std::string& filepath, const SPPMPhotonVector& photons)
+    {
+        BufferedFile file(
+            filepath.c_str(),
+            BufferedFile::BinaryType,
+            BufferedFile::WriteMode);
+
+        if (!file.is_open())
+            throw ExceptionIOError();
+
+        checked_write(file, PhotonFileSignature, sizeof(PhotonFileSignature));
+        checked_write(file, PhotonFileVersion);
+
+        checked_write(file, static_cast<std::uint64_t>(photons.m_positions.size()));
+        if (!photons.m_positions.empty())
+        {
+            checked_write(
+                file,
+                &photons.m_positions[0],
+                photons.m_positions.size() * sizeof(Vector3f));
+        }
+
+        write_columns<SPPMPhotonVector::MonoPhotonArray, 0, 1, 2>(file, photons.m_mono_photons);
+        write_columns<SPPMPhotonVector::PolyPhotonArray, 0, 1, 2>(file, photons.m_poly_photons);
+    }
+
+    void read_photons(const std::string& filepath, SPPMPhotonVector& photons)
+    {
+        BufferedFile file(
+            filepath.c_str(),
+            BufferedFile::BinaryType,
+            BufferedFile::ReadMode);
+
+        if (!file.is_open())
+            throw ExceptionIOError();
+
+        char signature[sizeof(PhotonFileSignature)];
+        checked_read(file, signature, sizeof(signature));
+        if (std::memcmp(signature, PhotonFileSignature, sizeof(signature)) != 0)
+            throw ExceptionIOError();
+
+        std::uint16_t version;
+        checked_read(file, version);
+        if (version != PhotonFileVersion)
+            throw ExceptionIOError();
+
+        std::uint64_t position_count;
+        checked_read(file, position_count);
+        photons.m_positions.resize(static_cast<std::size_t>(position_count));
+        if (!photons.m_positions.empty())
+        {
+            checked_read(
+                file,
+                &photons.m_positions[0],
+                photons.m_positions.size() * sizeof(Vector3f));
+        }
+
+        read_columns<SPPMPhotonVector::MonoPhotonArray, 0, 1, 2>(file, photons.m_mono_photons);
+        read_columns<SPPMPhotonVector::PolyPhotonArray, 0, 1, 2>(file, photons.m_poly_photons);
+
+        if (photons.m_mono_photons.size() + photons.m_poly_photons.size() != photons.m_positions.size())
+            throw ExceptionIOError();
+    }
+}
+
+SPPMPhotonExchange::SPPMPhotonExchange(const SPPMParameters& params)
+  : m_node_index(params.m_node_index)
+  , m_node_count(params.m_node_count)
+  , m_path(params.m_photon_exchange_path)
+  , m_timeout(params.m_photon_exchange_timeout)
+{
+}
+
+bool SPPMPhotonExchange::exchange(
+    SPPMPhotonVector&       photons,
+    const std::size_t       pass_number,
+    const std::uint32_t     pass_hash,
+    IAbortSwitch&           abort_switch)
+{
+    // Publish the photons of this node. Write to a temporary file first so that
+    // other nodes never see partial files.
+    const std::string filepath = get_filepath(pass_number, pass_hash, m_node_index);
+    const std::string temp_filepath = filepath + ".tmp";
+
+    try
+    {
+        bf::create_directories(bf::path(m_path));
+        write_photons(temp_filepath, photons);
+        bf::rename(temp_filepath, filepath);
+    }
+    catch (const std::exception&)
+    {
+        RENDERER_LOG_ERROR("failed to write sppm photon file %s.", filepath.c_str());
+
+        boost::system::error_code ec;
+        bf::remove(temp_filepath, ec);
+
+        return false;
+    }
+
+    // The files of the pass before the previous one can be removed: when this node
+    // reaches the current pass, all nodes are done gathering photons of that pass.
+    if (!m_previous_filepaths[0].empty())
+    {
+        boost::system::error_code ec;
+        bf::remove(m_previous_filepaths[0], ec);
+    }
+    m_previous_filepaths[0] = m_previous_filepaths[1];
+    m_previous_filepaths[1] = filepath;
+
+    RENDERER_LOG_INFO(
+        "gathering sppm photons from " FMT_SIZE_T " other render node%s...",
+        m_node_count - 1,
+        m_node_count > 2 ? "s" : "");
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    bool success = true;
+
+    for (std::size_t i = 0; i < m_node_count; ++i)
+    {
+        if (i == m_node_index)
+            continue;
+
+        const std::string node_filepath = get_filepath(pass_number, pass_hash, i);
+
+        // Wait until the node has published its photons.
+        bool timed_out = false;
+        while (!bf::exists(node_filepath))
+        {
+            if (abort_switch.is_aborted())
+                return false;
+
+            if (stopwatch.measure().get_seconds() > m_timeout)
+            {
+                timed_out = true;
+                break;
+            }
+
+            sleep(PollingInterval, abort_switch);
+        }
+
+        if (timed_out)
+        {
+            RENDERER_LOG_ERROR(
+                "timed out waiting for sppm photons of render node " FMT_SIZE_T ".",
+                i + 1);
+            success = false;
+            continue;
+        }
+
+        try
+        {
+            SPPMPhotonVector node_photons;
+            read_photons(node_filepath, node_photons);
+            photons.append(node_photons);
+        }
+        catch (const std::exception&)
+        {
+            RENDERER_LOG_ERROR("failed to read sppm photon file %s.", node_filepath.c_str());
+            success = false;
+        }
+    }
+
+    RENDERER_LOG_INFO(
+        "gathered %s sppm photons in %s.",
+        pretty_uint(photons.size()).c_str(),
+        pretty_time(stopwatch.measure().get_seconds()).c_str());
+
+    return success;
+}
+
+std::string SPPMPhotonExchange::get_filepath(
+    const std::size_t       pass_number,
+    const std::uint32_t     pass_hash,
+    const std::size_t       node_index) const
+{
+    std::stringstream sstr;
+    sstr << "sppm_photons_pass_" << pass_number
+         << "_" << std::hex << std::setw(8) << std::setfill('0') << pass_hash
+         << std::dec << "_node_" << node_index << ".bin";
+
+    return (bf::path(m_path) / sstr.str()).string();
+}
+
+}   // namespace renderer
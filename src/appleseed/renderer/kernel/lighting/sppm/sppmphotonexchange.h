@@ -0,0 +1,86 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Forward declarations.
+namespace foundation    { class IAbortSwitch; }
+namespace renderer      { struct SPPMParameters; }
+namespace renderer      { class SPPMPhotonVector; }
+
+namespace renderer
+{
+
+//
+// Exchange of photons between render nodes when SPPM photon tracing is distributed.
+//
+// Each node traces a disjoint subset of the photon packets of a pass, publishes
+// its photons as a file in a directory shared by all nodes, then gathers the
+// photons published by the other nodes. Since photon packets are deterministically
+// seeded, every node ends up with the exact photon set a single node would have
+// traced, and builds the same photon map.
+//
+
+class SPPMPhotonExchange
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    explicit SPPMPhotonExchange(const SPPMParameters& params);
+
+    // Publish the photons traced by this node for a given pass, then append the
+    // photons traced by all other nodes for that same pass to `photons`.
+    // Return false if the photons of some nodes could not be gathered.
+    bool exchange(
+        SPPMPhotonVector&               photons,
+        const std::size_t               pass_number,
+        const std::uint32_t             pass_hash,
+        foundation::IAbortSwitch&       abort_switch);
+
+  private:
+    const std::size_t                   m_node_index;
+    const std::size_t                   m_node_count;
+    const std::string                   m_path;
+    const float                         m_timeout;
+    std::string                         m_previous_filepaths[2];
+
+    std::string get_filepath(
+        const std::size_t               pass_number,
+        const std::uint32_t             pass_hash,
+        const std::size_t               node_index) const;
+};
+
+}   // namespace renderer
@@ -36,6 +36,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/statistics.h"
 
@@ -49,6 +50,7 @@ namespace renderer
 {
 
 SPPMPhotonMap::SPPMPhotonMap(SPPMPhotonVector& photons)
+  : m_tracked_memory("photon maps")
 {
     const size_t photon_count = photons.size();
 
@@ -59,8 +61,17 @@ SPPMPhotonMap::SPPMPhotonMap(SPPMPhotonVector& photons)
             pretty_uint(photon_count).c_str(),
             photon_count > 1 ? "photons" : "photon");
 
-        knn::Builder3f builder(*this);
-        builder.build_move_points<DefaultWallclockTimer>(photons.m_positions);
+        // Photons are stored in small leaf buckets that queries scan with vectorized
+        // distance computations. This makes the tree much smaller than with single
+        // photon leaves.
+        const size_t MaxPhotonsPerLeaf = 8;
+
+        knn::Builder3f builder(*this, MaxPhotonsPerLeaf);
+        builder.build_move_points<DefaultWallclockTimer>(
+            photons.m_positions,
+            System::get_logical_cpu_core_count());
+
+        m_tracked_memory.set_size(get_memory_size());
 
         Statistics statistics;
         statistics.insert_time("build time", builder.get_build_time());
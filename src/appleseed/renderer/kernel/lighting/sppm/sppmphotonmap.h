@@ -31,6 +31,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/knn.h"
+#include "foundation/memory/memorytracker.h"
 
 // Forward declarations.
 namespace renderer  { class SPPMPhotonVector; }
@@ -44,6 +45,9 @@ class SPPMPhotonMap
   public:
     // Constructor, *moves* the photon positions into the map.
     explicit SPPMPhotonMap(SPPMPhotonVector& photons);
+
+  private:
+    foundation::TrackedMemory m_tracked_memory;
 };
 
 }   // namespace renderer
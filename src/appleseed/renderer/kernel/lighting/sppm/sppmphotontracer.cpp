@@ -65,6 +65,7 @@
 // appleseed.foundation headers.
 #include "foundation/hash/hash.h"
 #include "foundation/math/basis.h"
+#include "foundation/math/compressedunitvector.h"
 #include "foundation/math/knn/knn_anyquery.h"
 #include "foundation/math/sampling/mappings.h"
 #include "foundation/math/scalar.h"
@@ -188,8 +189,8 @@ namespace
 
                     // Create and store a new photon.
                     SPPMMonoPhoton photon;
-                    photon.m_incoming = Vector3f(vertex.m_outgoing.get_value());
-                    photon.m_geometric_normal = Vector3f(vertex.get_geometric_normal());
+                    photon.m_incoming = CompressedUnitVector(Vector3f(vertex.m_outgoing.get_value()));
+                    photon.m_geometric_normal = CompressedUnitVector(Vector3f(vertex.get_geometric_normal()));
                     photon.m_flux.m_wavelength = wavelength;
                     photon.m_flux.m_amplitude =
                         m_initial_flux[wavelength] *
@@ -203,8 +204,8 @@ namespace
 
                     // Create and store a new photon.
                     SPPMPolyPhoton photon;
-                    photon.m_incoming = Vector3f(vertex.m_outgoing.get_value());
-                    photon.m_geometric_normal = Vector3f(vertex.get_geometric_normal());
+                    photon.m_incoming = CompressedUnitVector(Vector3f(vertex.m_outgoing.get_value()));
+                    photon.m_geometric_normal = CompressedUnitVector(Vector3f(vertex.get_geometric_normal()));
                     photon.m_flux = m_initial_flux;
                     photon.m_flux *= vertex.m_throughput;
                     m_photons.push_back(point, photon);
@@ -937,8 +938,12 @@ void SPPMPhotonTracer::schedule_light_photon_tracing_jobs(
         pretty_uint(m_params.m_light_photon_count).c_str(),
         m_params.m_light_photon_count > 1 ? "photons" : "photon");
 
-    for (size_t i = 0; i < m_params.m_light_photon_count; i += m_params.m_photon_packet_size)
+    for (size_t i = 0, packet = 0; i < m_params.m_light_photon_count; i += m_params.m_photon_packet_size, ++packet)
     {
+        // When photon tracing is distributed, only trace the packets assigned to this node.
+        if (packet % m_params.m_node_count != m_params.m_node_index)
+            continue;
+
         const size_t photon_begin = i;
         const size_t photon_end = std::min(i + m_params.m_photon_packet_size, m_params.m_light_photon_count);
 
@@ -981,8 +986,12 @@ void SPPMPhotonTracer::schedule_environment_photon_tracing_jobs(
         pretty_uint(m_params.m_env_photon_count).c_str(),
         m_params.m_env_photon_count > 1 ? "photons" : "photon");
 
-    for (size_t i = 0; i < m_params.m_env_photon_count; i += m_params.m_photon_packet_size)
+    for (size_t i = 0, packet = 0; i < m_params.m_env_photon_count; i += m_params.m_photon_packet_size, ++packet)
     {
+        // When photon tracing is distributed, only trace the packets assigned to this node.
+        if (packet % m_params.m_node_count != m_params.m_node_index)
+            continue;
+
         const size_t photon_begin = i;
         const size_t photon_end = std::min(i + m_params.m_photon_packet_size, m_params.m_env_photon_count);
 
@@ -65,6 +65,7 @@ Tracer::Tracer(
   , m_assume_no_participating_media(!scene.has_participating_media())
   , m_transmission_threshold(transparency_threshold)
   , m_max_iterations(max_iterations)
+  , m_stream_capacity(0)
 {
     if (print_details)
     {
@@ -83,6 +84,65 @@ Tracer::Tracer(
     }
 }
 
+void Tracer::trace_between_simple(
+    const ShadingContext&       shading_context,
+    const size_t                segment_count,
+    const Vector3d              origins[],
+    const Vector3d              targets[],
+    const ShadingRay::Time&     ray_time,
+    const VisibilityFlags::Type ray_flags,
+    const ShadingRay::DepthType ray_depth,
+    Spectrum                    transmissions[])
+{
+    if (!(m_assume_no_alpha_mapping && m_assume_no_participating_media))
+    {
+        for (size_t i = 0; i < segment_count; ++i)
+        {
+            trace_between_simple(
+                shading_context,
+                origins[i],
+                targets[i],
+                ray_time,
+                ray_flags,
+                ray_depth,
+                transmissions[i]);
+        }
+
+        return;
+    }
+
+    if (m_stream_capacity < segment_count)
+    {
+        m_stream_occluded.reset(new bool[segment_count]);
+        m_stream_capacity = segment_count;
+    }
+
+    m_stream_rays.clear();
+
+    for (size_t i = 0; i < segment_count; ++i)
+    {
+        const Vector3d direction = targets[i] - origins[i];
+        const double dist = norm(direction);
+
+        m_stream_rays.emplace_back(
+            origins[i],
+            direction / dist,
+            0.0,                        // ray tmin
+            dist * (1.0 - 1.0e-6),      // ray tmax
+            ray_time,
+            ray_flags,
+            ray_depth);
+    }
+
+    m_intersector.trace_probe_stream(
+        m_stream_rays.data(),
+        segment_count,
+        m_stream_occluded.get());
+
+    for (size_t i = 0; i < segment_count; ++i)
+        transmissions[i].set(m_stream_occluded[i] ? 0.0f : 1.0f);
+}
+
 const ShadingPoint& Tracer::do_trace(
     const ShadingContext&       shading_context,
     const ShadingRay&           ray,
@@ -32,6 +32,7 @@
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/intersection/occludercache.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/kernel/shading/shadingray.h"
 #include "renderer/modeling/scene/visibilityflags.h"
@@ -42,6 +43,8 @@
 
 // Standard headers.
 #include <cstddef>
+#include <memory>
+#include <vector>
 
 // Forward declarations.
 namespace renderer  { class Material;}
@@ -86,6 +89,8 @@ class Tracer
 
     // Compute the transmission between two points.
     // Returns the transmission factor up to (but excluding) this occluder.
+    // When probe tracing is possible, a non-default occluder key enables testing the
+    // triangle that last blocked a ray traced with the same key (see OccluderCache).
     void trace_between_simple(
         const ShadingContext&           shading_context,
         const ShadingPoint&             origin,
@@ -98,14 +103,16 @@ class Tracer
         const foundation::Vector3d&     target,
         const ShadingRay&               parent_ray,
         const VisibilityFlags::Type     ray_flags,
-        Spectrum&                       transmission);
+        Spectrum&                       transmission,
+        const size_t                    occluder_key = OccluderCache::NoKey);
     void trace_between_simple(
         const ShadingContext&           shading_context,
         const foundation::Vector3d&     origin,
         const foundation::Vector3d&     target,
         const ShadingRay&               parent_ray,
         const VisibilityFlags::Type     ray_flags,
-        Spectrum&                       transmission);
+        Spectrum&                       transmission,
+        const size_t                    occluder_key = OccluderCache::NoKey);
     void trace_between_simple(
         const ShadingContext&           shading_context,
         const foundation::Vector3d&     origin,
@@ -115,6 +122,18 @@ class Tracer
         const ShadingRay::DepthType     ray_depth,
         Spectrum&                       transmission);
 
+    // Compute the transmission between the two points of each of a batch of segments.
+    // When probe tracing is possible, all segments are traced as a single ray stream.
+    void trace_between_simple(
+        const ShadingContext&           shading_context,
+        const size_t                    segment_count,
+        const foundation::Vector3d      origins[],
+        const foundation::Vector3d      targets[],
+        const ShadingRay::Time&         ray_time,
+        const VisibilityFlags::Type     ray_flags,
+        const ShadingRay::DepthType     ray_depth,
+        Spectrum                        transmissions[]);
+
     // Compute the transmission in a given direction.
     // Returns the intersection with the closest fully opaque occluder
     // and the transmission factor up to (but excluding) this occluder,
@@ -170,6 +189,9 @@ class Tracer
     const float                         m_transmission_threshold;
     const size_t                        m_max_iterations;
     ShadingPoint                        m_shading_points[2];
+    std::vector<ShadingRay>             m_stream_rays;
+    std::unique_ptr<bool[]>             m_stream_occluded;
+    size_t                              m_stream_capacity;
 
     const ShadingPoint& do_trace(
         const ShadingContext&           shading_context,
@@ -281,7 +303,8 @@ inline void Tracer::trace_between_simple(
     const foundation::Vector3d&         target,
     const ShadingRay&                   parent_ray,
     const VisibilityFlags::Type         ray_flags,
-    Spectrum&                           transmission)
+    Spectrum&                           transmission,
+    const size_t                        occluder_key)
 {
     if (m_assume_no_alpha_mapping && m_assume_no_participating_media)
     {
@@ -297,7 +320,7 @@ inline void Tracer::trace_between_simple(
             ray_flags,
             parent_ray.m_depth);
 
-        transmission.set(m_intersector.trace_probe(ray, &origin) ? 0.0f : 1.0f);
+        transmission.set(m_intersector.trace_probe(ray, &origin, occluder_key) ? 0.0f : 1.0f);
     }
     else
     {
@@ -321,7 +344,8 @@ inline void Tracer::trace_between_simple(
     const foundation::Vector3d&         target,
     const ShadingRay&                   parent_ray,
     const VisibilityFlags::Type         ray_flags,
-    Spectrum&                           transmission)
+    Spectrum&                           transmission,
+    const size_t                        occluder_key)
 {
     if (m_assume_no_alpha_mapping && m_assume_no_participating_media)
     {
@@ -337,7 +361,7 @@ inline void Tracer::trace_between_simple(
             ray_flags,
             parent_ray.m_depth);
 
-        transmission.set(m_intersector.trace_probe(ray) ? 0.0f : 1.0f);
+        transmission.set(m_intersector.trace_probe(ray, nullptr, occluder_key) ? 0.0f : 1.0f);
     }
     else
     {
@@ -0,0 +1,719 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "visibilitybuffer.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/rasterization/objectrasterizer.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/modeling/camera/camera.h"
+#include "renderer/modeling/camera/pinholecamera.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/visibilityflags.h"
+#include "renderer/utility/transformsequence.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/transform.h"
+#include "foundation/platform/atomic.h"
+#include "foundation/platform/defaulttimers.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    const std::uint32_t NoRecord = ~std::uint32_t(0);
+
+    //
+    // A triangle clipped against the near plane of the camera and projected onto the frame.
+    // Coordinates are expressed in pixels. The reciprocal of the camera space depth is an
+    // affine function of these coordinates.
+    //
+
+    struct ScreenPolygon
+    {
+        Vector2d    m_points[4];
+        size_t      m_count;
+        double      m_orientation;                          // sign of the area of the polygon
+        double      m_min_depth;
+        Vector2d    m_min;
+        Vector2d    m_max;
+        double      m_rcp_depth_a, m_rcp_depth_b, m_rcp_depth_c;
+
+        double rcp_depth(const double x, const double y) const
+        {
+            return m_rcp_depth_a * x + m_rcp_depth_b * y + m_rcp_depth_c;
+        }
+
+        double edge(const size_t i, const double x, const double y) const
+        {
+            const Vector2d& a = m_points[i];
+            const Vector2d& b = m_points[i + 1 < m_count ? i + 1 : 0];
+            return m_orientation * ((b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x));
+        }
+
+        bool contains(const double x, const double y) const
+        {
+            for (size_t i = 0; i < m_count; ++i)
+            {
+                if (edge(i, x, y) < 0.0)
+                    return false;
+            }
+
+            return true;
+        }
+
+        // Return true if the polygon overlaps the pixel [x, x + 1) x [y, y + 1).
+        bool overlaps_pixel(const double x, const double y) const
+        {
+            if (m_max.x <= x || m_min.x >= x + 1.0 ||
+                m_max.y <= y || m_min.y >= y + 1.0)
+                return false;
+
+            for (size_t i = 0; i < m_count; ++i)
+            {
+                if (edge(i, x, y) < 0.0 &&
+                    edge(i, x + 1.0, y) < 0.0 &&
+                    edge(i, x, y + 1.0) < 0.0 &&
+                    edge(i, x + 1.0, y + 1.0) < 0.0)
+                    return false;
+            }
+
+            return true;
+        }
+    };
+
+    bool compute_rcp_depth_plane(
+        ScreenPolygon&          polygon,
+        const double            rcp_depths[],
+        const size_t            i0,
+        const size_t            i1,
+        const size_t            i2)
+    {
+        const Vector2d e1 = polygon.m_points[i1] - polygon.m_points[i0];
+        const Vector2d e2 = polygon.m_points[i2] - polygon.m_points[i0];
+        const double det = e1.x * e2.y - e1.y * e2.x;
+
+        if (std::abs(det) < 1.0e-12)
+            return false;
+
+        const double dw1 = rcp_depths[i1] - rcp_depths[i0];
+        const double dw2 = rcp_depths[i2] - rcp_depths[i0];
+
+        polygon.m_rcp_depth_a = (dw1 * e2.y - dw2 * e1.y) / det;
+        polygon.m_rcp_depth_b = (dw2 * e1.x - dw1 * e2.x) / det;
+        polygon.m_rcp_depth_c =
+            rcp_depths[i0] -
+            polygon.m_rcp_depth_a * polygon.m_points[i0].x -
+            polygon.m_rcp_depth_b * polygon.m_points[i0].y;
+
+        return true;
+    }
+}
+
+
+//
+// VisibilityBuffer::Builder class implementation.
+//
+
+class VisibilityBuffer::Builder
+  : public ObjectRasterizer
+{
+  public:
+    explicit Builder(VisibilityBuffer& buffer)
+      : m_buffer(buffer)
+      , m_width(buffer.m_width)
+      , m_height(buffer.m_height)
+      , m_camera(buffer.m_scene.get_render_data().m_active_camera)
+    {
+    }
+
+    // Return false if primary visibility cannot be rasterized for the active camera.
+    bool initialize()
+    {
+        if (m_camera == nullptr)
+            return false;
+
+        if (std::strcmp(m_camera->get_model(), PinholeCameraFactory().get_model()) != 0)
+        {
+            RENDERER_LOG_WARNING(
+                "primary visibility can only be rasterized for pinhole cameras; tracing camera rays instead.");
+            return false;
+        }
+
+        if (m_camera->transform_sequence().size() > 1)
+        {
+            RENDERER_LOG_WARNING(
+                "primary visibility cannot be rasterized for moving cameras; tracing camera rays instead.");
+            return false;
+        }
+
+        m_camera_transform = m_camera->transform_sequence().get_earliest_transform();
+
+        // Find the affine mapping from (x / -z, y / -z) in camera space to pixel coordinates
+        // by projecting points beyond the near plane of the camera.
+        const double d = std::max(1.0, 2.0 * std::abs(m_camera->get_parameters().get_optional<double>("near_z", 0.0)));
+        Vector2d ndc0, ndcx, ndcy;
+        if (!m_camera->project_camera_space_point(Vector3d(0.0, 0.0, -d), ndc0) ||
+            !m_camera->project_camera_space_point(Vector3d(d, 0.0, -d), ndcx) ||
+            !m_camera->project_camera_space_point(Vector3d(0.0, d, -d), ndcy))
+            return false;
+
+        const Vector2d scale(static_cast<double>(m_width), static_cast<double>(m_height));
+        m_projection_origin = ndc0 * scale;
+        m_projection_dx = (ndcx - ndc0) * scale;
+        m_projection_dy = (ndcy - ndc0) * scale;
+
+        // Pinhole camera rays start at the pinhole. Geometry closer to the camera plane than
+        // this tiny distance is ignored: it can only be seen through the pixels if it lies
+        // in the immediate vicinity of the pinhole.
+        const GAABB3 scene_bbox = m_buffer.m_scene.compute_bbox();
+        const double scene_diameter = scene_bbox.is_valid() ? static_cast<double>(norm(scene_bbox.extent())) : 0.0;
+        m_near_z = -1.0e-6 * std::max(scene_diameter, 1.0);
+
+        return true;
+    }
+
+    void build()
+    {
+        const size_t corner_count = (m_width + 1) * (m_height + 1);
+        m_corner_depths.assign(corner_count, std::numeric_limits<float>::max());
+        m_corner_records.assign(corner_count, NoRecord);
+        m_buffer.m_pixels.assign(m_width * m_height, NoRecord);
+
+        // Find the closest opaque triangle at each pixel corner.
+        rasterize_scene(CornerPass);
+
+        // Pixels whose four corners see the same triangle are candidates.
+        for (size_t y = 0; y < m_height; ++y)
+        {
+            for (size_t x = 0; x < m_width; ++x)
+            {
+                const size_t c = y * (m_width + 1) + x;
+                const std::uint32_t record_index = m_corner_records[c];
+
+                if (record_index != NoRecord &&
+                    m_corner_records[c + 1] == record_index &&
+                    m_corner_records[c + m_width + 1] == record_index &&
+                    m_corner_records[c + m_width + 2] == record_index)
+                    m_buffer.m_pixels[y * m_width + x] = record_index;
+            }
+        }
+
+        // Reject candidates that another triangle may occlude within the pixel.
+        rasterize_scene(OcclusionPass);
+
+        m_buffer.m_resolved_pixel_count =
+            std::count_if(
+                m_buffer.m_pixels.begin(),
+                m_buffer.m_pixels.end(),
+                [](const std::uint32_t record_index) { return record_index != NoRecord; });
+    }
+
+    void begin_object(const size_t triangle_count_hint) override
+    {
+        m_primitive_index = 0;
+    }
+
+    void end_object() override
+    {
+    }
+
+    void rasterize(const Triangle& triangle) override
+    {
+        const Vector3d assembly_vertices[3] =
+        {
+            m_object_instance_transform->point_to_parent(Vector3d(triangle.m_v0[0], triangle.m_v0[1], triangle.m_v0[2])),
+            m_object_instance_transform->point_to_parent(Vector3d(triangle.m_v1[0], triangle.m_v1[1], triangle.m_v1[2])),
+            m_object_instance_transform->point_to_parent(Vector3d(triangle.m_v2[0], triangle.m_v2[1], triangle.m_v2[2]))
+        };
+
+        const Vector3d world_vertices[3] =
+        {
+            m_assembly_instance_transform->point_to_parent(assembly_vertices[0]),
+            m_assembly_instance_transform->point_to_parent(assembly_vertices[1]),
+            m_assembly_instance_transform->point_to_parent(assembly_vertices[2])
+        };
+
+        process_triangle(world_vertices, m_opaque ? assembly_vertices : nullptr);
+
+        ++m_primitive_index;
+    }
+
+  private:
+    enum Pass
+    {
+        CornerPass,
+        OcclusionPass
+    };
+
+    VisibilityBuffer&               m_buffer;
+    const size_t                    m_width;
+    const size_t                    m_height;
+    const Camera*                   m_camera;
+    Transformd                      m_camera_transform;
+    Vector2d                        m_projection_origin;
+    Vector2d                        m_projection_dx;
+    Vector2d                        m_projection_dy;
+    double                          m_near_z;
+    std::vector<float>              m_corner_depths;
+    std::vector<std::uint32_t>      m_corner_records;
+
+    // Rasterization state.
+    Pass                            m_pass;
+    std::uint32_t                   m_triangle_index;
+    const AssemblyInstance*         m_assembly_instance;
+    const Transformd*               m_assembly_instance_transform;
+    size_t                          m_object_instance_index;
+    const Transformd*               m_object_instance_transform;
+    bool                            m_opaque;
+    size_t                          m_primitive_index;
+
+    void rasterize_scene(const Pass pass)
+    {
+        m_pass = pass;
+        m_triangle_index = 0;
+
+        for (const AssemblyInstance& assembly_instance : m_buffer.m_scene.assembly_instances())
+        {
+            if (!(assembly_instance.get_vis_flags() & VisibilityFlags::CameraRay))
+                continue;
+
+            const Assembly& assembly = assembly_instance.get_assembly();
+            const TransformSequence& transform_sequence = assembly_instance.transform_sequence();
+
+            // Nested assemblies are only considered as potential occluders.
+            if (!assembly.assembly_instances().empty())
+            {
+                rasterize_occluder_box(AABB3d(assembly_instance.compute_parent_bbox()));
+                continue;
+            }
+
+            const ObjectInstanceContainer& object_instances = assembly.object_instances();
+
+            for (size_t i = 0, e = object_instances.size(); i < e; ++i)
+            {
+                const ObjectInstance* object_instance = object_instances.get_by_index(i);
+
+                if (!(object_instance->get_vis_flags() & VisibilityFlags::CameraRay))
+                    continue;
+
+                const Object* object = object_instance->find_object();
+                if (object == nullptr)
+                    continue;
+
+                const bool is_static_mesh =
+                    transform_sequence.size() <= 1 &&
+                    std::strcmp(object->get_model(), MeshObjectFactory().get_model()) == 0 &&
+                    static_cast<const MeshObject*>(object)->get_motion_segment_count() == 0;
+
+                // Objects that cannot be rasterized are only considered as potential occluders.
+                if (!is_static_mesh)
+                {
+                    rasterize_occluder_box(
+                        transform_sequence.to_parent(AABB3d(object_instance->compute_parent_bbox())));
+                    continue;
+                }
+
+                m_assembly_instance = &assembly_instance;
+                m_assembly_instance_transform = &transform_sequence.get_earliest_transform();
+                m_object_instance_index = i;
+                m_object_instance_transform = &object_instance->get_transform();
+                m_opaque = !object->has_alpha_map() && !object_instance->uses_alpha_mapping();
+
+                object->rasterize(*this);
+            }
+        }
+    }
+
+    void rasterize_occluder_box(const AABB3d& bbox)
+    {
+        if (!bbox.is_valid())
+            return;
+
+        Vector3d corners[8];
+        for (size_t i = 0; i < 8; ++i)
+        {
+            corners[i] =
+                Vector3d(
+                    bbox[(i >> 0) & 1].x,
+                    bbox[(i >> 1) & 1].y,
+                    bbox[(i >> 2) & 1].z);
+        }
+
+        static const size_t Faces[6][4] =
+        {
+            { 0, 2, 6, 4 }, { 1, 3, 7, 5 },
+            { 0, 1, 5, 4 }, { 2, 3, 7, 6 },
+            { 0, 1, 3, 2 }, { 4, 5, 7, 6 }
+        };
+
+        for (size_t i = 0; i < 6; ++i)
+        {
+            const Vector3d t0[3] = { corners[Faces[i][0]], corners[Faces[i][1]], corners[Faces[i][2]] };
+            const Vector3d t1[3] = { corners[Faces[i][0]], corners[Faces[i][2]], corners[Faces[i][3]] };
+            process_triangle(t0, nullptr);
+            process_triangle(t1, nullptr);
+        }
+    }
+
+    // `assembly_vertices` is null for triangles that are only potential occluders.
+    void process_triangle(
+        const Vector3d              world_vertices[3],
+        const Vector3d*             assembly_vertices)
+    {
+        ScreenPolygon polygon;
+
+        if (project_triangle(world_vertices, polygon))
+        {
+            if (m_pass == CornerPass)
+            {
+                if (assembly_vertices != nullptr)
+                    rasterize_corners(polygon, assembly_vertices);
+            }
+            else test_occlusion(polygon);
+        }
+
+        ++m_triangle_index;
+    }
+
+    bool project_triangle(
+        const Vector3d              world_vertices[3],
+        ScreenPolygon&              polygon) const
+    {
+        Vector3d p[3];
+        for (size_t i = 0; i < 3; ++i)
+            p[i] = m_camera_transform.point_to_local(world_vertices[i]);
+
+        // Clip the triangle against the near plane.
+        Vector3d clipped[4];
+        size_t count = 0;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const Vector3d& a = p[i];
+            const Vector3d& b = p[i < 2 ? i + 1 : 0];
+            const bool a_inside = a.z <= m_near_z;
+            const bool b_inside = b.z <= m_near_z;
+
+            if (a_inside)
+                clipped[count++] = a;
+
+            if (a_inside != b_inside)
+            {
+                Vector3d& q = clipped[count++];
+                q = a + ((m_near_z - a.z) / (b.z - a.z)) * (b - a);
+                q.z = m_near_z;
+            }
+        }
+
+        if (count < 3)
+            return false;
+
+        // Project the vertices onto the frame.
+        double rcp_depths[4];
+        polygon.m_count = count;
+        polygon.m_min_depth = std::numeric_limits<double>::max();
+        polygon.m_min = Vector2d(std::numeric_limits<double>::max());
+        polygon.m_max = Vector2d(-std::numeric_limits<double>::max());
+        for (size_t i = 0; i < count; ++i)
+        {
+            const double depth = -clipped[i].z;
+            const double rcp_depth = 1.0 / depth;
+
+            const Vector2d& point = polygon.m_points[i] =
+                m_projection_origin +
+                (clipped[i].x * rcp_depth) * m_projection_dx +
+                (clipped[i].y * rcp_depth) * m_projection_dy;
+
+            rcp_depths[i] = rcp_depth;
+            polygon.m_min_depth = std::min(polygon.m_min_depth, depth);
+            polygon.m_min = component_wise_min(polygon.m_min, point);
+            polygon.m_max = component_wise_max(polygon.m_max, point);
+        }
+
+        // Skip polygons seen edge-on.
+        double area = 0.0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Vector2d& a = polygon.m_points[i];
+            const Vector2d& b = polygon.m_points[i + 1 < count ? i + 1 : 0];
+            area += a.x * b.y - a.y * b.x;
+        }
+
+        if (std::abs(area) < 1.0e-12)
+            return false;
+
+        polygon.m_orientation = area > 0.0 ? 1.0 : -1.0;
+
+        return
+            compute_rcp_depth_plane(polygon, rcp_depths, 0, 1, 2) ||
+            (count == 4 && compute_rcp_depth_plane(polygon, rcp_depths, 0, 2, 3));
+    }
+
+    void rasterize_corners(
+        const ScreenPolygon&        polygon,
+        const Vector3d*             assembly_vertices)
+    {
+        const double x0 = std::max(std::ceil(polygon.m_min.x), 0.0);
+        const double y0 = std::max(std::ceil(polygon.m_min.y), 0.0);
+        const double x1 = std::min(std::floor(polygon.m_max.x), static_cast<double>(m_width));
+        const double y1 = std::min(std::floor(polygon.m_max.y), static_cast<double>(m_height));
+
+        std::uint32_t record_index = NoRecord;
+
+        for (double y = y0; y <= y1; y += 1.0)
+        {
+            for (double x = x0; x <= x1; x += 1.0)
+            {
+                if (!polygon.contains(x, y))
+                    continue;
+
+                const double rcp_depth = polygon.rcp_depth(x, y);
+                if (rcp_depth <= 0.0)
+                    continue;
+
+                const size_t c = static_cast<size_t>(y) * (m_width + 1) + static_cast<size_t>(x);
+                const float depth = static_cast<float>(1.0 / rcp_depth);
+
+                if (depth < m_corner_depths[c])
+                {
+                    if (record_index == NoRecord)
+                        record_index = add_record(assembly_vertices);
+
+                    m_corner_depths[c] = depth;
+                    m_corner_records[c] = record_index;
+                }
+            }
+        }
+    }
+
+    std::uint32_t add_record(const Vector3d* assembly_vertices)
+    {
+        const std::uint32_t record_index = static_cast<std::uint32_t>(m_buffer.m_records.size());
+
+        Record record;
+        record.m_assembly_instance = m_assembly_instance;
+        record.m_object_instance_index = static_cast<std::uint32_t>(m_object_instance_index);
+        record.m_primitive_index = static_cast<std::uint32_t>(m_primitive_index);
+        record.m_triangle_index = m_triangle_index;
+        record.m_triangle = TriangleType(assembly_vertices[0], assembly_vertices[1], assembly_vertices[2]);
+        m_buffer.m_records.push_back(record);
+
+        return record_index;
+    }
+
+    void test_occlusion(const ScreenPolygon& polygon)
+    {
+        const double x0 = std::max(std::floor(polygon.m_min.x), 0.0);
+        const double y0 = std::max(std::floor(polygon.m_min.y), 0.0);
+        const double x1 = std::min(std::ceil(polygon.m_max.x), static_cast<double>(m_width)) - 1.0;
+        const double y1 = std::min(std::ceil(polygon.m_max.y), static_cast<double>(m_height)) - 1.0;
+
+        for (double y = y0; y <= y1; y += 1.0)
+        {
+            for (double x = x0; x <= x1; x += 1.0)
+            {
+                const size_t ix = static_cast<size_t>(x);
+                const size_t iy = static_cast<size_t>(y);
+                std::uint32_t& record_index = m_buffer.m_pixels[iy * m_width + ix];
+
+                if (record_index == NoRecord ||
+                    m_buffer.m_records[record_index].m_triangle_index == m_triangle_index ||
+                    !polygon.overlaps_pixel(x, y))
+                    continue;
+
+                // Lower bound of the depth of this triangle within the pixel. The reciprocal of
+                // the depth is affine, hence it is maximal at one of the corners of the pixel.
+                double min_depth = polygon.m_min_depth;
+                const double w00 = polygon.rcp_depth(x, y);
+                const double w10 = polygon.rcp_depth(x + 1.0, y);
+                const double w01 = polygon.rcp_depth(x, y + 1.0);
+                const double w11 = polygon.rcp_depth(x + 1.0, y + 1.0);
+                if (std::min(std::min(w00, w10), std::min(w01, w11)) > 0.0)
+                    min_depth = std::max(min_depth, 1.0 / std::max(std::max(w00, w10), std::max(w01, w11)));
+
+                // Upper bound of the depth of the visible triangle within the pixel.
+                const size_t c = iy * (m_width + 1) + ix;
+                const double max_depth =
+                    std::max(
+                        std::max(m_corner_depths[c], m_corner_depths[c + 1]),
+                        std::max(m_corner_depths[c + m_width + 1], m_corner_depths[c + m_width + 2]));
+
+                if (min_depth <= max_depth * (1.0 + 1.0e-5))
+                    record_index = NoRecord;
+            }
+        }
+    }
+};
+
+
+//
+// VisibilityBuffer class implementation.
+//
+
+VisibilityBuffer::VisibilityBuffer(
+    const Scene&                    scene,
+    const Frame&                    frame)
+  : m_scene(scene)
+  , m_frame(frame)
+  , m_is_valid(0)
+  , m_width(0)
+  , m_height(0)
+  , m_resolved_pixel_count(0)
+  , m_build_time(0.0)
+{
+}
+
+void VisibilityBuffer::invalidate()
+{
+    m_is_valid = 0;
+}
+
+void VisibilityBuffer::update()
+{
+    if (atomic_read(&m_is_valid) != 0)
+        return;
+
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    if (m_is_valid == 0)
+    {
+        build();
+        atomic_write(&m_is_valid, 1);
+    }
+}
+
+bool VisibilityBuffer::trace(
+    const Intersector&              intersector,
+    const ShadingRay&               ray,
+    const Vector2d&                 ndc,
+    ShadingPoint&                   shading_point) const
+{
+    if (m_pixels.empty())
+        return false;
+
+    const double x = ndc.x * static_cast<double>(m_width);
+    const double y = ndc.y * static_cast<double>(m_height);
+
+    if (!(x >= 0.0 && x < static_cast<double>(m_width) &&
+          y >= 0.0 && y < static_cast<double>(m_height)))
+        return false;
+
+    const std::uint32_t record_index =
+        m_pixels[truncate<size_t>(y) * m_width + truncate<size_t>(x)];
+
+    if (record_index == NoRecord)
+        return false;
+
+    const Record& record = m_records[record_index];
+    const Transformd& assembly_instance_transform =
+        record.m_assembly_instance->transform_sequence().get_earliest_transform();
+
+    // Intersect the ray with the visible triangle in assembly instance space.
+    const ShadingRay::RayType local_ray = assembly_instance_transform.to_local(ray);
+    double t, u, v;
+    if (!record.m_triangle.intersect(local_ray, t, u, v))
+        return false;
+
+    ShadingRay hit_ray(ray);
+    hit_ray.m_tmax = t;
+
+    intersector.make_triangle_shading_point(
+        shading_point,
+        hit_ray,
+        Vector2f(static_cast<float>(u), static_cast<float>(v)),
+        record.m_assembly_instance,
+        assembly_instance_transform,
+        record.m_object_instance_index,
+        record.m_primitive_index,
+        TriangleSupportPlaneType(record.m_triangle));
+
+    return true;
+}
+
+Statistics VisibilityBuffer::get_statistics() const
+{
+    Statistics stats;
+    stats.insert_percent("resolved pixels", m_resolved_pixel_count, m_pixels.size());
+    stats.insert("visible triangles", m_records.size());
+    stats.insert_time("build time", m_build_time);
+    return stats;
+}
+
+void VisibilityBuffer::build()
+{
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    const CanvasProperties& props = m_frame.image().properties();
+    m_width = props.m_canvas_width;
+    m_height = props.m_canvas_height;
+    m_pixels.clear();
+    m_records.clear();
+    m_resolved_pixel_count = 0;
+
+    Builder builder(*this);
+    if (builder.initialize())
+        builder.build();
+
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+
+    RENDERER_LOG_DEBUG("%s",
+        StatisticsVector::make(
+            "primary visibility buffer statistics",
+            get_statistics()).to_string().c_str());
+}
+
+}   // namespace renderer
@@ -0,0 +1,128 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/intersection/intersectionsettings.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/statistics.h"
+
+// Boost headers.
+#include "boost/thread/mutex.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Forward declarations.
+namespace renderer  { class AssemblyInstance; }
+namespace renderer  { class Frame; }
+namespace renderer  { class Intersector; }
+namespace renderer  { class Scene; }
+namespace renderer  { class ShadingPoint; }
+namespace renderer  { class ShadingRay; }
+
+namespace renderer
+{
+
+//
+// A buffer holding, for each pixel of the frame, the triangle that all camera rays
+// passing through the pixel hit first, or nothing if this cannot be guaranteed.
+//
+// The buffer is built by rasterizing the scene from the camera at the corners of the
+// pixels: a pixel is resolved if its four corners see the same triangle and if no
+// other triangle overlapping the pixel may be closer to the camera. Camera rays
+// through resolved pixels are then intersected with that single triangle instead of
+// being traced through the scene.
+//
+// Only static pinhole cameras are supported. Objects that cannot be rasterized
+// (non-mesh objects, objects with motion blur or nested assemblies) and alpha-mapped
+// triangles only contribute as potential occluders, by their bounding boxes in the
+// former case.
+//
+
+class VisibilityBuffer
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    VisibilityBuffer(
+        const Scene&                    scene,
+        const Frame&                    frame);
+
+    // Discard the contents of the buffer so that it gets rebuilt the next time update()
+    // is called, e.g. because the scene or the camera changed. Not thread-safe.
+    void invalidate();
+
+    // Rebuild the buffer if it was invalidated. Thread-safe.
+    void update();
+
+    // Reconstruct the first hit of a camera ray passing through a given point of the frame
+    // (in normalized device coordinates). Return false if the hit cannot be reconstructed,
+    // in which case the ray must be traced.
+    bool trace(
+        const Intersector&              intersector,
+        const ShadingRay&               ray,
+        const foundation::Vector2d&     ndc,
+        ShadingPoint&                   shading_point) const;
+
+    // Return statistics about the buffer.
+    foundation::Statistics get_statistics() const;
+
+  private:
+    struct Record
+    {
+        const AssemblyInstance*         m_assembly_instance;
+        std::uint32_t                   m_object_instance_index;
+        std::uint32_t                   m_primitive_index;
+        std::uint32_t                   m_triangle_index;       // index of the triangle in rasterization order
+        TriangleType                    m_triangle;             // in assembly instance space
+    };
+
+    class Builder;
+
+    const Scene&                        m_scene;
+    const Frame&                        m_frame;
+    boost::mutex                        m_mutex;
+    volatile std::uint32_t              m_is_valid;
+    size_t                              m_width;
+    size_t                              m_height;
+    std::vector<std::uint32_t>          m_pixels;               // index of the record of each pixel
+    std::vector<Record>                 m_records;
+    size_t                              m_resolved_pixel_count;
+    double                              m_build_time;
+
+    void build();
+};
+
+}   // namespace renderer
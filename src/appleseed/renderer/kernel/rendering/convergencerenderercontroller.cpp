@@ -0,0 +1,143 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "convergencerenderercontroller.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/thread.h"
+#include "foundation/string/string.h"
+
+// Standard headers.
+#include <limits>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// ConvergenceRendererController class implementation.
+//
+
+struct ConvergenceRendererController::Impl
+{
+    const float         m_target_error;
+    const Mode          m_mode;
+    mutable Spinlock    m_spinlock;
+    float               m_error;
+
+    Impl(
+        const float     target_error,
+        const Mode      mode)
+      : m_target_error(target_error)
+      , m_mode(mode)
+      , m_error(std::numeric_limits<float>::max())
+    {
+    }
+};
+
+ConvergenceRendererController::Mode ConvergenceRendererController::parse_mode(const std::string& mode)
+{
+    if (mode == "global")
+        return Mode::Global;
+    else if (mode == "per_tile")
+        return Mode::PerTile;
+    else
+    {
+        RENDERER_LOG_ERROR(
+            "invalid value \"%s\" for parameter \"%s\", using default value \"%s\".",
+            mode.c_str(),
+            "noise_target_mode",
+            "global");
+
+        return Mode::Global;
+    }
+}
+
+ConvergenceRendererController::ConvergenceRendererController(
+    const float         target_error,
+    const Mode          mode)
+  : impl(new Impl(target_error, mode))
+{
+}
+
+ConvergenceRendererController::~ConvergenceRendererController()
+{
+    delete impl;
+}
+
+void ConvergenceRendererController::on_frame_begin()
+{
+    Spinlock::ScopedLock lock(impl->m_spinlock);
+    impl->m_error = std::numeric_limits<float>::max();
+}
+
+IRendererController::Status ConvergenceRendererController::get_status() const
+{
+    return is_converged() ? TerminateRendering : ContinueRendering;
+}
+
+void ConvergenceRendererController::set_error_estimate(
+    const float         average_error,
+    const float         max_error)
+{
+    const float error = impl->m_mode == Mode::Global ? average_error : max_error;
+
+    {
+        Spinlock::ScopedLock lock(impl->m_spinlock);
+        impl->m_error = error;
+    }
+
+    // Errors can't be estimated until pixels received enough samples.
+    if (error == std::numeric_limits<float>::max())
+        return;
+
+    RENDERER_LOG_INFO(
+        "noise estimate: %s average, %s in the noisiest block (target: %s %s)",
+        pretty_scalar(average_error, 4).c_str(),
+        pretty_scalar(max_error, 4).c_str(),
+        pretty_scalar(impl->m_target_error, 4).c_str(),
+        impl->m_mode == Mode::Global ? "average" : "in every block");
+}
+
+float ConvergenceRendererController::get_error_estimate() const
+{
+    Spinlock::ScopedLock lock(impl->m_spinlock);
+    return impl->m_error;
+}
+
+bool ConvergenceRendererController::is_converged() const
+{
+    return get_error_estimate() <= impl->m_target_error;
+}
+
+}   // namespace renderer
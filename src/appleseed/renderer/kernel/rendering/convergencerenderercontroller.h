@@ -0,0 +1,96 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/defaultrenderercontroller.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <string>
+
+namespace renderer
+{
+
+//
+// A renderer controller that terminates rendering once an estimate of the relative
+// error of the frame falls below a target.
+//
+// Estimates are submitted by the frame renderer as rendering progresses, either
+// averaged over the whole frame or for its noisiest block of pixels.
+//
+
+class APPLESEED_DLLSYMBOL ConvergenceRendererController
+  : public DefaultRendererController
+{
+  public:
+    enum class Mode
+    {
+        Global,         // stop when the error averaged over the frame is below the target
+        PerTile         // stop when the error of every block of pixels is below the target
+    };
+
+    // Parse a mode from a string ("global" or "per_tile"), returning Mode::Global on failure.
+    static Mode parse_mode(const std::string& mode);
+
+    // Constructor.
+    ConvergenceRendererController(
+        const float         target_error,
+        const Mode          mode);
+
+    // Destructor.
+    ~ConvergenceRendererController() override;
+
+    void on_frame_begin() override;
+
+    Status get_status() const override;
+
+    // Submit new estimates of the relative error of the frame, averaged over the frame
+    // and in its noisiest block of pixels, and report them. Thread-safe.
+    void set_error_estimate(
+        const float         average_error,
+        const float         max_error);
+
+    // Return the latest estimate of the error relevant to the mode. Thread-safe.
+    float get_error_estimate() const;
+
+    // Return true if the latest estimate is below the target. Thread-safe.
+    bool is_converged() const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}   // namespace renderer
@@ -74,4 +74,9 @@ IRendererController::Status DefaultRendererController::get_status() const
     return ContinueRendering;
 }
 
+size_t DefaultRendererController::get_active_thread_count() const
+{
+    return 0;
+}
+
 }   // namespace renderer
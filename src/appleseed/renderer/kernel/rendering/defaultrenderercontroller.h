@@ -75,6 +75,9 @@ class APPLESEED_DLLSYMBOL DefaultRendererController
 
     // Return the current rendering status.
     Status get_status() const override;
+
+    // Return the number of rendering threads that should be running, or 0 to run all of them.
+    size_t get_active_thread_count() const override;
 };
 
 }   // namespace renderer
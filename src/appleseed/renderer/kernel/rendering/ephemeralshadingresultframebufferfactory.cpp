@@ -36,14 +36,28 @@
 #include "renderer/modeling/frame/frame.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
 #include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
 
+// Standard headers.
+#include <cassert>
+
 using namespace foundation;
 
 namespace renderer
 {
 
+EphemeralShadingResultFrameBufferFactory::~EphemeralShadingResultFrameBufferFactory()
+{
+    for (const Storage& storage : m_storage)
+    {
+        assert(!storage.m_in_use);
+        delete[] storage.m_pixels;
+    }
+}
+
 void EphemeralShadingResultFrameBufferFactory::release()
 {
     delete this;
@@ -54,6 +68,12 @@ void EphemeralShadingResultFrameBufferFactory::clear()
     // Nothing to do.
 }
 
+bool EphemeralShadingResultFrameBufferFactory::supports_sub_tiles() const
+{
+    // Each part of a tile gets its own framebuffer.
+    return true;
+}
+
 ShadingResultFrameBuffer* EphemeralShadingResultFrameBufferFactory::create(
     const Frame&                frame,
     const std::size_t           tile_x,
@@ -61,14 +81,25 @@ ShadingResultFrameBuffer* EphemeralShadingResultFrameBufferFactory::create(
     const AABB2u&               tile_bbox)
 {
     const Tile& tile = frame.image().tile(tile_x, tile_y);
+    const size_t aov_count = frame.aov_images().size();
+
+    // Size pooled storage for the largest tile so that it fits any tile of the frame.
+    const CanvasProperties& props = frame.image().properties();
+    const size_t max_size =
+          props.m_tile_width
+        * props.m_tile_height
+        * (ShadingResultFrameBuffer::get_total_channel_count(aov_count) + 1)
+        * Pixel::size(PixelFormatFloat);
 
     ShadingResultFrameBuffer* framebuffer =
         new ShadingResultFrameBuffer(
             tile.get_width(),
             tile.get_height(),
-            frame.aov_images().size(),
-            tile_bbox);
+            aov_count,
+            tile_bbox,
+            acquire_storage(max_size));
 
+    // Only the part of the storage used by this tile needs clearing.
     framebuffer->clear();
 
     return framebuffer;
@@ -77,7 +108,56 @@ ShadingResultFrameBuffer* EphemeralShadingResultFrameBufferFactory::create(
 void EphemeralShadingResultFrameBufferFactory::destroy(
     ShadingResultFrameBuffer*   framebuffer)
 {
+    const std::uint8_t* pixels = framebuffer->get_storage();
     delete framebuffer;
+    release_storage(pixels);
+}
+
+std::uint8_t* EphemeralShadingResultFrameBufferFactory::acquire_storage(const size_t size)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    // Reuse a free block, growing it if the frame changed since it was allocated.
+    for (Storage& storage : m_storage)
+    {
+        if (!storage.m_in_use)
+        {
+            if (storage.m_size < size)
+            {
+                delete[] storage.m_pixels;
+                storage.m_pixels = new std::uint8_t[size];
+                storage.m_size = size;
+            }
+
+            storage.m_in_use = true;
+            return storage.m_pixels;
+        }
+    }
+
+    Storage storage;
+    storage.m_pixels = new std::uint8_t[size];
+    storage.m_size = size;
+    storage.m_in_use = true;
+    m_storage.push_back(storage);
+
+    return storage.m_pixels;
+}
+
+void EphemeralShadingResultFrameBufferFactory::release_storage(const std::uint8_t* pixels)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    for (Storage& storage : m_storage)
+    {
+        if (storage.m_pixels == pixels)
+        {
+            assert(storage.m_in_use);
+            storage.m_in_use = false;
+            return;
+        }
+    }
+
+    assert(!"Unknown framebuffer storage.");
 }
 
 }   // namespace renderer
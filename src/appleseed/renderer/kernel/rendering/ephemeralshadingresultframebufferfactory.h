@@ -35,9 +35,12 @@
 // appleseed.foundation headers.
 #include "foundation/math/aabb.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/thread.h"
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 // Forward declarations.
 namespace renderer  { class Frame; }
@@ -46,15 +49,27 @@ namespace renderer  { class ShadingResultFrameBuffer; }
 namespace renderer
 {
 
+//
+// A framebuffer factory that creates a framebuffer for each tile job and forgets it
+// once the tile is developed. The pixel storage of destroyed framebuffers is pooled
+// and reused by later tiles and passes, so that in steady state there is one block
+// of storage per render thread and no allocation per tile.
+//
+
 class EphemeralShadingResultFrameBufferFactory
   : public IShadingResultFrameBufferFactory
 {
   public:
+    // Destructor.
+    ~EphemeralShadingResultFrameBufferFactory() override;
+
     // Delete this instance.
     void release() override;
 
     void clear() override;
 
+    bool supports_sub_tiles() const override;
+
     ShadingResultFrameBuffer* create(
         const Frame&                frame,
         const std::size_t           tile_x,
@@ -63,6 +78,20 @@ class EphemeralShadingResultFrameBufferFactory
 
     void destroy(
         ShadingResultFrameBuffer*   framebuffer) override;
+
+  private:
+    struct Storage
+    {
+        std::uint8_t*               m_pixels;
+        std::size_t                 m_size;             // in bytes
+        bool                        m_in_use;
+    };
+
+    boost::mutex                    m_mutex;
+    std::vector<Storage>            m_storage;
+
+    std::uint8_t* acquire_storage(const std::size_t size);
+    void release_storage(const std::uint8_t* pixels);
 };
 
 }   // namespace renderer
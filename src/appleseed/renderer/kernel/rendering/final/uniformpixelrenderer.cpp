@@ -59,8 +59,10 @@
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <vector>
 
 using namespace foundation;
 
@@ -85,7 +87,13 @@ namespace
           : m_params(params)
           , m_sample_renderer(factory->create(thread_index))
           , m_sample_count(m_params.m_samples)
+          , m_batch_size(std::max<size_t>(std::min(m_params.m_batch_size, m_sample_count), 1))
+          , m_shading_results(m_batch_size)
         {
+            m_sampling_contexts.reserve(m_batch_size);
+            m_pixel_contexts.reserve(m_batch_size);
+            m_image_points.reserve(m_batch_size);
+
             const size_t sample_aov_index = frame.aovs().get_index("pixel_sample_count");
 
             // If the sample count AOV is enabled, we need to reset its normalization
@@ -110,8 +118,10 @@ namespace
             RENDERER_LOG_INFO(
                 "uniform pixel renderer settings:\n"
                 "  samples                       %s\n"
+                "  sample batch size             %s\n"
                 "  force anti-aliasing           %s",
                 pretty_uint(m_params.m_samples).c_str(),
+                pretty_uint(m_batch_size).c_str(),
                 m_params.m_force_aa ? "on" : "off");
 
             m_sample_renderer->print_settings();
@@ -144,43 +154,61 @@ namespace
                 0,                          // number of samples -- unknown
                 instance);                  // initial instance number
 
-            for (size_t i = 0, e = m_sample_count; i < e; ++i)
+            // Render the samples of the pixel in batches so that the sample renderer
+            // can generate and trace their primary rays together.
+            for (size_t begin = 0; begin < m_sample_count; begin += m_batch_size)
             {
-                // Generate a uniform sample in [0,1)^2.
-                const Vector2f s =
-                    m_sample_count > 1 || m_params.m_force_aa
-                        ? sampling_context.next2<Vector2f>()
-                        : Vector2f(0.5f);
-
-                // Sample the pixel filter.
-                const auto& filter_table = frame.get_filter_sampling_table();
-                const Vector2d pf(
-                    static_cast<double>(filter_table.sample(s[0]) + 0.5f),
-                    static_cast<double>(filter_table.sample(s[1]) + 0.5f));
-
-                // Compute the sample position in NDC.
-                const Vector2d sample_position = frame.get_sample_position(pi.x + pf.x, pi.y + pf.y);
-
-                // Create a pixel context that identifies the pixel and sample currently being rendered.
-                const PixelContext pixel_context(pi, sample_position);
-
-                // Render the sample.
-                ShadingResult shading_result(aov_count);
-                SamplingContext child_sampling_context(sampling_context);
-                m_sample_renderer->render_sample(
-                    child_sampling_context,
-                    pixel_context,
-                    sample_position,
+                const size_t count = std::min(m_batch_size, m_sample_count - begin);
+
+                m_sampling_contexts.clear();
+                m_pixel_contexts.clear();
+                m_image_points.clear();
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    // Generate a uniform sample in [0,1)^2.
+                    const Vector2f s =
+                        m_sample_count > 1 || m_params.m_force_aa
+                            ? sampling_context.next2<Vector2f>()
+                            : Vector2f(0.5f);
+
+                    // Sample the pixel filter.
+                    const auto& filter_table = frame.get_filter_sampling_table();
+                    const Vector2d pf(
+                        static_cast<double>(filter_table.sample(s[0]) + 0.5f),
+                        static_cast<double>(filter_table.sample(s[1]) + 0.5f));
+
+                    // Compute the sample position in NDC.
+                    const Vector2d sample_position = frame.get_sample_position(pi.x + pf.x, pi.y + pf.y);
+
+                    // Create a pixel context that identifies the pixel and sample currently being rendered.
+                    m_pixel_contexts.emplace_back(pi, sample_position);
+
+                    m_sampling_contexts.push_back(sampling_context);
+                    m_image_points.push_back(sample_position);
+                    m_shading_results[i].reset(aov_count);
+                }
+
+                // Render the samples.
+                m_sample_renderer->render_samples(
+                    count,
+                    &m_sampling_contexts[0],
+                    &m_pixel_contexts[0],
+                    &m_image_points[0],
                     aov_accumulators,
-                    shading_result);
-
-                // Update sampling statistics.
-                m_total_sampling_dim.insert(child_sampling_context.get_total_dimension());
-
-                // Merge the sample into the framebuffer.
-                if (shading_result.is_valid())
-                    framebuffer.add(Vector2u(pt), shading_result);
-                else signal_invalid_sample();
+                    &m_shading_results[0]);
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    // Update sampling statistics.
+                    m_total_sampling_dim.insert(m_sampling_contexts[i].get_total_dimension());
+
+                    // Merge the sample into the framebuffer.
+                    const ShadingResult& shading_result = m_shading_results[i];
+                    if (shading_result.is_valid())
+                        framebuffer.add(Vector2u(pt), shading_result);
+                    else signal_invalid_sample();
+                }
             }
 
             on_pixel_end(frame, pi, pt, tile_bbox, aov_accumulators);
@@ -208,11 +236,13 @@ namespace
         {
             const SamplingContext::Mode     m_sampling_mode;
             const size_t                    m_samples;
+            const size_t                    m_batch_size;
             const bool                      m_force_aa;
 
             explicit Parameters(const ParamArray& params)
               : m_sampling_mode(get_sampling_context_mode(params))
               , m_samples(params.get_required<size_t>("samples", 64))
+              , m_batch_size(params.get_optional<size_t>("sample_batch_size", 16))
               , m_force_aa(params.get_optional<bool>("force_antialiasing", false))
             {
             }
@@ -221,7 +251,13 @@ namespace
         const Parameters                    m_params;
         auto_release_ptr<ISampleRenderer>   m_sample_renderer;
         const size_t                        m_sample_count;
+        const size_t                        m_batch_size;
         Population<std::uint64_t>           m_total_sampling_dim;
+
+        std::vector<SamplingContext>        m_sampling_contexts;
+        std::vector<PixelContext>           m_pixel_contexts;
+        std::vector<Vector2d>               m_image_points;
+        std::vector<ShadingResult>          m_shading_results;
     };
 }
 
@@ -242,6 +278,14 @@ Dictionary UniformPixelRendererFactory::get_params_metadata()
             .insert("label", "Samples")
             .insert("help", "Number of anti-aliasing samples"));
 
+    metadata.dictionaries().insert(
+        "sample_batch_size",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "16")
+            .insert("label", "Sample Batch Size")
+            .insert("help", "Number of samples of a pixel rendered together; 1 renders samples one at a time"));
+
     metadata.dictionaries().insert(
         "force_antialiasing",
         Dictionary()
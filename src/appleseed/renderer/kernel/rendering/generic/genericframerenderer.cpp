@@ -33,6 +33,7 @@
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
+#include "renderer/kernel/rendering/convergencerenderercontroller.h"
 #include "renderer/kernel/rendering/generic/tilejob.h"
 #include "renderer/kernel/rendering/generic/tilejobfactory.h"
 #include "renderer/kernel/rendering/iframerenderer.h"
@@ -40,7 +41,10 @@
 #include "renderer/kernel/rendering/ishadingresultframebufferfactory.h"
 #include "renderer/kernel/rendering/itilecallback.h"
 #include "renderer/kernel/rendering/itilerenderer.h"
+#include "renderer/kernel/rendering/jobgranularitycontroller.h"
 #include "renderer/kernel/rendering/permanentshadingresultframebufferfactory.h"
+#include "renderer/kernel/rendering/rendercosttracker.h"
+#include "renderer/kernel/rendering/renderingmetrics.h"
 #include "renderer/modeling/frame/frame.h"
 #include "renderer/utility/settingsparsing.h"
 
@@ -49,7 +53,10 @@
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/hash/hash.h"
 #include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
 #include "foundation/image/image.h"
+#include "foundation/image/tile.h"
+#include "foundation/math/aabb.h"
 #include "foundation/platform/thread.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/foreach.h"
@@ -57,9 +64,12 @@
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -75,6 +85,81 @@ namespace renderer
 
 namespace
 {
+    //
+    // Estimate the relative error of a frame rendered in multiple passes by comparing
+    // it with its state at the end of the previous pass, using the same metric as the
+    // adaptive tile renderer. The difference between the averages of `pass_count` and
+    // `pass_count - 1` passes is scaled by sqrt(pass_count - 1) to match the error of
+    // the average of `pass_count` passes. Errors are averaged over each tile of the
+    // frame and over the crop window.
+    //
+
+    void estimate_pass_error(
+        const Image&                        image,
+        const Image&                        previous_image,
+        const AABB2u&                       crop_window,
+        const size_t                        pass_count,
+        float&                              average_error,
+        float&                              max_error)
+    {
+        assert(pass_count > 1);
+
+        const CanvasProperties& props = image.properties();
+        const float scale = std::sqrt(static_cast<float>(pass_count - 1));
+
+        double error_sum = 0.0;
+        max_error = 0.0f;
+
+        for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+        {
+            for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+            {
+                // Intersect the tile with the crop window.
+                const Tile& tile = image.tile(tx, ty);
+                const Tile& previous_tile = previous_image.tile(tx, ty);
+                const size_t origin_x = tx * props.m_tile_width;
+                const size_t origin_y = ty * props.m_tile_height;
+                const AABB2u tile_rect(
+                    Vector2u(origin_x, origin_y),
+                    Vector2u(origin_x + tile.get_width() - 1, origin_y + tile.get_height() - 1));
+
+                if (!AABB2u::overlap(tile_rect, crop_window))
+                    continue;
+
+                const AABB2u rect = AABB2u::intersect(tile_rect, crop_window);
+
+                double tile_error_sum = 0.0;
+
+                for (size_t y = rect.min.y; y <= rect.max.y; ++y)
+                {
+                    for (size_t x = rect.min.x; x <= rect.max.x; ++x)
+                    {
+                        Color3f color, previous_color;
+                        tile.get_pixel(x - origin_x, y - origin_y, color);
+                        previous_tile.get_pixel(x - origin_x, y - origin_y, previous_color);
+
+                        const float rgb = std::abs(color.r) + std::abs(color.g) + std::abs(color.b);
+
+                        if (rgb > 0.0f)
+                        {
+                            tile_error_sum +=
+                                scale *
+                                (std::abs(color.r - previous_color.r) +
+                                 std::abs(color.g - previous_color.g) +
+                                 std::abs(color.b - previous_color.b)) / std::sqrt(rgb);
+                        }
+                    }
+                }
+
+                error_sum += tile_error_sum;
+                max_error = std::max(max_error, static_cast<float>(tile_error_sum / rect.volume()));
+            }
+        }
+
+        average_error = static_cast<float>(error_sum / crop_window.volume());
+    }
+
+
     //
     // Generic frame renderer.
     //
@@ -99,13 +184,54 @@ namespace
             // We must have a renderer factory, but it's OK not to have a callback factory.
             assert(tile_renderer_factory);
 
+            // Noise levels are estimated from the difference between consecutive passes.
+            if (m_params.m_noise_target > 0.0f)
+            {
+                if (m_params.m_pass_count > 1)
+                {
+                    m_convergence_renderer_controller.reset(
+                        new ConvergenceRendererController(
+                            m_params.m_noise_target,
+                            m_params.m_noise_target_mode));
+                }
+                else
+                {
+                    RENDERER_LOG_WARNING(
+                        "a noise target requires multiple rendering passes, ignoring it.");
+                }
+            }
+
+            // Jobs are made smaller than a tile by splitting tiles into up to TileJob::MaxSubTileCount
+            // sub-tiles, their size is thus measured in pixels and adjusted between rendering passes.
+            if (m_params.m_adaptive_job_granularity)
+            {
+                if (m_params.m_tile_splitting)
+                {
+                    const CanvasProperties& props = m_frame.image().properties();
+                    const std::uint64_t tile_pixel_count = props.m_tile_width * props.m_tile_height;
+                    m_granularity_controller.reset(
+                        new JobGranularityController(
+                            m_params.m_target_job_duration,
+                            tile_pixel_count / TileJob::MaxSubTileCount,
+                            tile_pixel_count,
+                            tile_pixel_count));
+                }
+                else
+                {
+                    RENDERER_LOG_WARNING(
+                        "adaptive job granularity requires tile splitting, ignoring it.");
+                }
+            }
+
             // Create and initialize job manager.
             m_job_manager.reset(
                 new JobManager(
                     global_logger(),
                     m_job_queue,
                     m_params.m_thread_count,
-                    JobManager::KeepRunningOnEmptyQueue));
+                      JobManager::KeepRunningOnEmptyQueue
+                    | (m_granularity_controller ? JobManager::CollectTimings : 0)
+                    | m_params.m_thread_affinity_flags));
 
             // Instantiate tile renderers, one per rendering thread.
             m_tile_renderers.reserve(m_params.m_thread_count);
@@ -146,20 +272,40 @@ namespace
 
         void print_settings() const override
         {
+            std::string noise_target = "off";
+            if (m_convergence_renderer_controller)
+            {
+                noise_target = pretty_scalar(m_params.m_noise_target, 4);
+                noise_target +=
+                    m_params.m_noise_target_mode == ConvergenceRendererController::Mode::Global
+                        ? " (global)"
+                        : " (per tile)";
+            }
+
             RENDERER_LOG_INFO(
                 "generic frame renderer settings:\n"
                 "  spectrum mode                 %s\n"
                 "  sampling mode                 %s\n"
                 "  rendering threads             %s\n"
+                "  thread affinity               %s\n"
                 "  tile ordering                 %s\n"
-                "  passes                        %s",
+                "  tile splitting                %s\n"
+                "  adaptive job granularity      %s\n"
+                "  passes                        %s\n"
+                "  noise target                  %s",
                 get_spectrum_mode_name(m_params.m_spectrum_mode).c_str(),
                 get_sampling_context_mode_name(m_params.m_sampling_mode).c_str(),
                 pretty_uint(m_params.m_thread_count).c_str(),
+                get_rendering_thread_affinity_name(m_params.m_thread_affinity_flags).c_str(),
                 m_params.m_tile_ordering == TileJobFactory::TileOrdering::LinearOrdering ? "linear" :
                 m_params.m_tile_ordering == TileJobFactory::TileOrdering::SpiralOrdering ? "spiral" :
                 m_params.m_tile_ordering == TileJobFactory::TileOrdering::HilbertOrdering ? "hilbert" : "random",
-                pretty_uint(m_params.m_pass_count).c_str());
+                m_params.m_tile_splitting ? "on" : "off",
+                m_granularity_controller
+                    ? ("on, " + pretty_time(m_params.m_target_job_duration) + " per job").c_str()
+                    : "off",
+                pretty_uint(m_params.m_pass_count).c_str(),
+                noise_target.c_str());
 
             m_tile_renderers.front()->print_settings();
         }
@@ -201,8 +347,12 @@ namespace
                     m_pass_callback,
                     m_params.m_spectrum_mode,
                     m_params.m_tile_ordering,
+                    m_params.m_tile_splitting,
                     m_params.m_pass_count,
+                    m_convergence_renderer_controller.get(),
                     m_job_queue,
+                    *m_job_manager,
+                    m_granularity_controller.get(),
                     m_params.m_thread_count,
                     m_abort_switch,
                     m_is_rendering));
@@ -235,6 +385,11 @@ namespace
             m_job_manager->resume();
         }
 
+        void set_active_thread_count(const size_t thread_count) override
+        {
+            m_job_manager->set_active_thread_count(thread_count);
+        }
+
         void terminate_rendering() override
         {
             stop_rendering();
@@ -242,28 +397,53 @@ namespace
             print_tile_renderers_stats();
         }
 
+        StatisticsVector get_statistics() const override
+        {
+            StatisticsVector stats;
+
+            for (auto tile_renderer : m_tile_renderers)
+                stats.merge(tile_renderer->get_statistics());
+
+            if (m_granularity_controller)
+                stats.insert("job granularity (pixels)", m_granularity_controller->get_statistics());
+
+            return stats;
+        }
+
       private:
         struct Parameters
         {
             const Spectrum::Mode                m_spectrum_mode;
             const SamplingContext::Mode         m_sampling_mode;
             const size_t                        m_thread_count;     // number of rendering threads
+            const int                           m_thread_affinity_flags;
             const TileJobFactory::TileOrdering  m_tile_ordering;    // tile rendering order
+            const bool                          m_tile_splitting;   // split tiles into sub-tiles at the end of a pass
+            const bool                          m_adaptive_job_granularity; // split tiles after the measured duration of jobs?
+            const double                        m_target_job_duration;      // in seconds
             const size_t                        m_pass_count;       // number of rendering passes
+            const float                         m_noise_target;     // stop after the pass whose estimated noise level is below this value, 0 to disable
+            const ConvergenceRendererController::Mode m_noise_target_mode;
 
             explicit Parameters(const ParamArray& params)
               : m_spectrum_mode(get_spectrum_mode(params))
               , m_sampling_mode(get_sampling_context_mode(params))
               , m_thread_count(get_rendering_thread_count(params))
+              , m_thread_affinity_flags(get_rendering_thread_affinity_flags(params))
               , m_tile_ordering(get_tile_ordering(params))
+              , m_tile_splitting(params.get_optional<bool>("tile_splitting", true))
+              , m_adaptive_job_granularity(params.get_optional<bool>("adaptive_job_granularity", false))
+              , m_target_job_duration(params.get_optional<double>("target_job_duration", 0.25))
               , m_pass_count(params.get_optional<size_t>("passes", 1))
+              , m_noise_target(params.get_optional<float>("noise_target", 0.0f))
+              , m_noise_target_mode(ConvergenceRendererController::parse_mode(params.get_optional<std::string>("noise_target_mode", "global")))
             {
             }
 
             static TileJobFactory::TileOrdering get_tile_ordering(const ParamArray& params)
             {
                 const std::string tile_ordering =
-                    params.get_optional<std::string>("tile_ordering", "spiral");
+                    params.get_optional<std::string>("tile_ordering", "hilbert");
 
                 if (tile_ordering == "linear")
                 {
@@ -306,8 +486,12 @@ namespace
                 IPassCallback*                      pass_callback,
                 const Spectrum::Mode                spectrum_mode,
                 const TileJobFactory::TileOrdering  tile_ordering,
+                const bool                          tile_splitting,
                 const size_t                        pass_count,
+                ConvergenceRendererController*      convergence_controller,
                 JobQueue&                           job_queue,
+                const JobManager&                   job_manager,
+                JobGranularityController*           granularity_controller,
                 const size_t                        thread_count,
                 IAbortSwitch&                       abort_switch,
                 bool&                               is_rendering)
@@ -318,8 +502,12 @@ namespace
               , m_pass_callback(pass_callback)
               , m_spectrum_mode(spectrum_mode)
               , m_tile_ordering(tile_ordering)
+              , m_tile_splitting(tile_splitting)
               , m_pass_count(pass_count)
+              , m_convergence_controller(convergence_controller)
               , m_job_queue(job_queue)
+              , m_job_manager(job_manager)
+              , m_granularity_controller(granularity_controller)
               , m_thread_count(thread_count)
               , m_abort_switch(abort_switch)
               , m_is_rendering(is_rendering)
@@ -332,6 +520,16 @@ namespace
 
                 const size_t start_pass = m_frame.get_initial_pass();
 
+                // Let monitoring tools estimate the remaining rendering time.
+                const Vector2u crop_extent = m_frame.get_crop_window().extent();
+                global_rendering_metrics().set_total_pixels(
+                      static_cast<std::uint64_t>(crop_extent.x + 1)
+                    * static_cast<std::uint64_t>(crop_extent.y + 1)
+                    * (m_pass_count > start_pass ? m_pass_count - start_pass : 0));
+
+                if (m_convergence_controller)
+                    m_convergence_controller->on_frame_begin();
+
                 //
                 // Rendering passes.
                 //
@@ -362,6 +560,7 @@ namespace
 
                     // Create tile jobs.
                     const std::uint32_t pass_hash = mix_uint32(m_frame.get_noise_seed(), static_cast<std::uint32_t>(pass));
+                    const size_t sub_tile_count = m_granularity_controller ? get_sub_tile_count() : 1;
                     TileJobFactory::TileJobVector tile_jobs;
                     m_tile_job_factory.create(
                         m_frame,
@@ -372,15 +571,22 @@ namespace
                         pass_hash,
                         m_spectrum_mode,
                         tile_jobs,
+                        m_tile_splitting ? &m_job_queue : nullptr,
+                        sub_tile_count,
                         m_abort_switch);
 
                     // Schedule tile jobs.
+                    const JobManager::Timings job_timings = m_job_manager.get_timings();
                     for (const_each<TileJobFactory::TileJobVector> i = tile_jobs; i; ++i)
                         m_job_queue.schedule(*i);
 
                     // Wait until tile jobs have effectively stopped.
                     m_job_queue.wait_until_completion();
 
+                    // Resize the jobs of the next pass after the duration of the jobs of this pass.
+                    if (m_granularity_controller)
+                        m_granularity_controller->update(m_job_manager.get_timings() - job_timings);
+
                     // Invoke on_tiled_frame_end() on tile callbacks.
                     for (auto tile_callback : m_tile_callbacks)
                         tile_callback->on_tiled_frame_end(&m_frame);
@@ -395,6 +601,16 @@ namespace
 
                     // Optionally write a checkpoint file to disk.
                     m_frame.save_checkpoint(m_framebuffer_factory, pass);
+
+                    // Stop rendering passes once the noise target is reached.
+                    if (m_convergence_controller && pass + 1 < m_pass_count && is_converged(pass))
+                    {
+                        RENDERER_LOG_INFO(
+                            "noise target reached after %s %s.",
+                            pretty_uint(pass + 1).c_str(),
+                            pass > 0 ? "passes" : "pass");
+                        break;
+                    }
                 }
 
                 // Check abort flag.
@@ -411,7 +627,8 @@ namespace
                 // Denoising pass.
                 //
 
-                if (m_frame.get_denoising_mode() == Frame::DenoisingMode::Denoise)
+                if (m_frame.get_denoising_mode() == Frame::DenoisingMode::Denoise ||
+                    m_frame.get_denoising_mode() == Frame::DenoisingMode::DenoiseOIDN)
                 {
                     if (m_pass_count > 1)
                         RENDERER_LOG_INFO("--- beginning denoising pass ---");
@@ -437,12 +654,46 @@ namespace
             IPassCallback*                          m_pass_callback;
             const Spectrum::Mode                    m_spectrum_mode;
             const TileJobFactory::TileOrdering      m_tile_ordering;
+            const bool                              m_tile_splitting;
             const size_t                            m_pass_count;
+            ConvergenceRendererController*          m_convergence_controller;
             JobQueue&                               m_job_queue;
+            const JobManager&                       m_job_manager;
+            JobGranularityController*               m_granularity_controller;
             const size_t                            m_thread_count;
             IAbortSwitch&                           m_abort_switch;
             bool&                                   m_is_rendering;
             TileJobFactory                          m_tile_job_factory;
+            std::unique_ptr<Image>                  m_previous_image;   // frame at the end of the previous pass
+
+            size_t get_sub_tile_count() const
+            {
+                const CanvasProperties& props = m_frame.image().properties();
+                const std::uint64_t tile_pixel_count = props.m_tile_width * props.m_tile_height;
+                const std::uint64_t job_size = m_granularity_controller->get_job_size();
+                return static_cast<size_t>((tile_pixel_count + job_size - 1) / job_size);
+            }
+
+            bool is_converged(const size_t pass)
+            {
+                // Passes resumed from a checkpoint can't be compared to the previous pass.
+                if (m_previous_image)
+                {
+                    float average_error, max_error;
+                    estimate_pass_error(
+                        m_frame.image(),
+                        *m_previous_image,
+                        m_frame.get_crop_window(),
+                        pass + 1,
+                        average_error,
+                        max_error);
+                    m_convergence_controller->set_error_estimate(average_error, max_error);
+                }
+
+                m_previous_image.reset(new Image(m_frame.image()));
+
+                return m_convergence_controller->is_converged();
+            }
 
             void on_tile_begin_whole_frame()
             {
@@ -478,6 +729,8 @@ namespace
         const Frame&                            m_frame;            // target framebuffer
         const Parameters                        m_params;
 
+        std::unique_ptr<JobGranularityController> m_granularity_controller;
+
         JobQueue                                m_job_queue;
         std::unique_ptr<JobManager>             m_job_manager;
         AbortSwitch                             m_abort_switch;
@@ -489,6 +742,8 @@ namespace
 
         TileJobFactory                          m_tile_job_factory;
 
+        std::unique_ptr<ConvergenceRendererController> m_convergence_renderer_controller;
+
         bool                                    m_is_rendering;
         std::unique_ptr<PassManagerFunc>        m_pass_manager_func;
         std::unique_ptr<boost::thread>          m_pass_manager_thread;
@@ -497,12 +752,9 @@ namespace
         {
             assert(!m_tile_renderers.empty());
 
-            StatisticsVector stats;
-
-            for (auto tile_renderer : m_tile_renderers)
-                stats.merge(tile_renderer->get_statistics());
-
+            const StatisticsVector stats = get_statistics();
             RENDERER_LOG_DEBUG("%s", stats.to_string().c_str());
+            RenderCostTracker::print_report(stats);
         }
     };
 }
@@ -521,7 +773,7 @@ Dictionary GenericFrameRendererFactory::get_params_metadata()
         Dictionary()
             .insert("type", "enum")
             .insert("values", "linear|spiral|hilbert|random")
-            .insert("default", "spiral")
+            .insert("default", "hilbert")
             .insert("label", "Tile Order")
             .insert("help", "Tile rendering order")
             .insert(
@@ -548,6 +800,47 @@ Dictionary GenericFrameRendererFactory::get_params_metadata()
                             .insert("label", "Random")
                             .insert("help", "Random tile ordering"))));
 
+    metadata.dictionaries().insert(
+        "tile_splitting",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "true")
+            .insert("label", "Tile Splitting")
+            .insert("help", "Split the last tiles of a pass into sub-tiles so that all threads remain busy"));
+
+    metadata.dictionaries().insert(
+        "adaptive_job_granularity",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Adaptive Job Granularity")
+            .insert("help", "Split tiles into sub-tiles after the measured duration of the jobs of the previous pass (requires tile splitting)"));
+
+    metadata.dictionaries().insert(
+        "target_job_duration",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.25")
+            .insert("label", "Target Job Duration")
+            .insert("help", "Duration in seconds of rendering jobs when adaptive job granularity is enabled"));
+
+    metadata.dictionaries().insert(
+        "noise_target",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.0")
+            .insert("label", "Noise Target")
+            .insert("help", "Stop rendering passes once the estimated noise level falls below this value (0 to disable)"));
+
+    metadata.dictionaries().insert(
+        "noise_target_mode",
+        Dictionary()
+            .insert("type", "enum")
+            .insert("values", "global|per_tile")
+            .insert("default", "global")
+            .insert("label", "Noise Target Mode")
+            .insert("help", "Compare the noise target to the noise level of the whole frame or of its noisiest tile"));
+
     return metadata;
 }
 
@@ -31,6 +31,7 @@
 #include "genericsamplegenerator.h"
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/aov/aovaccumulator.h"
 #include "renderer/kernel/rendering/isamplerenderer.h"
@@ -43,6 +44,7 @@
 #include "renderer/utility/settingsparsing.h"
 
 // appleseed.foundation headers.
+#include "foundation/hash/hash.h"
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/image.h"
 #include "foundation/math/filtersamplingtable.h"
@@ -51,9 +53,13 @@
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 #include "foundation/memory/autoreleaseptr.h"
+#include "foundation/memory/memory.h"
+#include "foundation/utility/countof.h"
+#include "foundation/utility/job/iabortswitch.h"
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <vector>
@@ -65,6 +71,16 @@ namespace renderer
 
 namespace
 {
+    // Size in pixels of the blocks of the coarse passes rendered in progressive resolution mode,
+    // from the coarsest pass to the finest one. Each coarse pass renders one sample per block.
+    const size_t CoarsePassBlockSizes[] = { 8, 4, 2 };
+    const size_t CoarsePassCount = countof(CoarsePassBlockSizes);
+
+    size_t get_block_count(const size_t pixel_count, const size_t block_size)
+    {
+        return (pixel_count + block_size - 1) / block_size;
+    }
+
     class GenericSampleGenerator
       : public SampleGeneratorBase
     {
@@ -87,7 +103,26 @@ namespace
           , m_window_width_next_pow2(next_power(static_cast<double>(m_window_width), 2.0))
           , m_window_height_next_pow3(next_power(static_cast<double>(m_window_height), 3.0))
           , m_filter_sampling_table(frame.get_filter_sampling_table())
+          , m_buffer(nullptr)
+          , m_sorting_tile_count_x((m_window_width + SortingTileSize - 1) / SortingTileSize)
+          , m_coarse_sequence_end(0)
         {
+            if (m_params.m_progressive_resolution)
+            {
+                // Each coarse pass uses as many sequence indices as there are cells in its padded grid of blocks.
+                for (size_t i = 0; i < CoarsePassCount; ++i)
+                {
+                    CoarsePass& pass = m_coarse_passes[i];
+                    pass.m_block_size = static_cast<int>(CoarsePassBlockSizes[i]);
+                    pass.m_block_count_x = static_cast<int>(get_block_count(m_window_width, CoarsePassBlockSizes[i]));
+                    pass.m_block_count_y = static_cast<int>(get_block_count(m_window_height, CoarsePassBlockSizes[i]));
+                    pass.m_block_count_x_next_pow2 = next_power(static_cast<double>(pass.m_block_count_x), 2.0);
+                    pass.m_block_count_y_next_pow3 = next_power(static_cast<double>(pass.m_block_count_y), 3.0);
+                    pass.m_sequence_begin = m_coarse_sequence_end;
+                    m_coarse_sequence_end +=
+                        static_cast<size_t>(pass.m_block_count_x_next_pow2 * pass.m_block_count_y_next_pow3);
+                }
+            }
         }
 
         void release() override
@@ -97,6 +132,13 @@ namespace
 
         void print_settings() const override
         {
+            RENDERER_LOG_INFO(
+                "generic sample generator settings:\n"
+                "  sort samples                  %s\n"
+                "  progressive resolution        %s",
+                m_params.m_sort_samples ? "on" : "off",
+                m_params.m_progressive_resolution ? "on" : "off");
+
             m_sample_renderer->print_settings();
         }
 
@@ -106,6 +148,17 @@ namespace
             m_rng = SamplingContext::RNGType();
         }
 
+        void generate_samples(
+            const size_t                    sample_count,
+            SampleAccumulationBuffer&       buffer,
+            IAbortSwitch&                   abort_switch) override
+        {
+            // Keep track of the buffer to skip pixels that have already converged.
+            m_buffer = &buffer;
+            SampleGeneratorBase::generate_samples(sample_count, buffer, abort_switch);
+            m_buffer = nullptr;
+        }
+
         StatisticsVector get_statistics() const override
         {
             Statistics stats;
@@ -122,9 +175,13 @@ namespace
         struct Parameters
         {
             const SamplingContext::Mode     m_sampling_mode;
+            const bool                      m_sort_samples;
+            const bool                      m_progressive_resolution;
 
             explicit Parameters(const ParamArray& params)
               : m_sampling_mode(get_sampling_context_mode(params))
+              , m_sort_samples(params.get_optional<bool>("sort_samples", false))
+              , m_progressive_resolution(params.get_optional<bool>("progressive_resolution", false))
             {
             }
         };
@@ -148,23 +205,166 @@ namespace
 
         AOVAccumulatorContainer             m_aov_accumulators;
 
+        const SampleAccumulationBuffer*     m_buffer;
+
+        // Size in pixels of the screen space tiles used to order deferred samples.
+        static const int SortingTileSize = 32;
+        const std::uint64_t                 m_sorting_tile_count_x;
+
+        // A sample whose rendering was deferred until the end of the current batch.
+        struct DeferredSample
+        {
+            std::uint64_t                   m_key;
+            size_t                          m_sequence_index;
+            int                             m_x;
+            int                             m_y;
+
+            bool operator<(const DeferredSample& rhs) const
+            {
+                return m_key < rhs.m_key;
+            }
+        };
+
+        std::vector<DeferredSample>         m_deferred_samples;
+
+        // A coarse pass of the progressive resolution mode.
+        struct CoarsePass
+        {
+            int                             m_block_size;
+            int                             m_block_count_x;
+            int                             m_block_count_y;
+            double                          m_block_count_x_next_pow2;
+            double                          m_block_count_y_next_pow3;
+            size_t                          m_sequence_begin;
+        };
+
+        CoarsePass                          m_coarse_passes[CoarsePassCount];
+        size_t                              m_coarse_sequence_end;
+
         size_t generate_samples(
             const size_t                    sequence_index,
             SampleVector&                   samples) override
         {
-            // Compute the sample position in NDC.
+            int x, y;
+            if (sequence_index < m_coarse_sequence_end)
+            {
+                if (!get_coarse_pass_pixel(sequence_index, x, y))
+                    return 0;
+            }
+            else
+            {
+                // Compute the sample position in NDC.
+                const size_t Bases[2] = { 2, 3 };
+                const Vector2d s = halton_sequence<double, 2>(Bases, sequence_index - m_coarse_sequence_end);
+
+                // Compute the coordinates of the pixel in the padded crop window.
+                const Vector2d t(s[0] * m_window_width_next_pow2, s[1] * m_window_height_next_pow3);
+                x = truncate<int>(t[0]);
+                y = truncate<int>(t[1]);
+
+                // Reject samples that fall outside the actual frame.
+                if (x >= m_window_width || y >= m_window_height)
+                    return 0;
+            }
+
+            // Skip pixels that have converged.
+            if (m_buffer->is_converged(
+                    static_cast<size_t>(m_window_origin_x + x),
+                    static_cast<size_t>(m_window_origin_y + y)))
+                return 0;
+
+            if (m_params.m_sort_samples)
+            {
+                // Consecutive Halton sample positions are scattered across the whole frame.
+                // Defer rendering so that samples can be rendered in screen space order.
+                const std::uint64_t tile_index =
+                    static_cast<std::uint64_t>(y / SortingTileSize) * m_sorting_tile_count_x + x / SortingTileSize;
+
+                DeferredSample deferred_sample;
+                deferred_sample.m_key =
+                    (tile_index << 16) |
+                    static_cast<std::uint64_t>((y % SortingTileSize) * SortingTileSize + x % SortingTileSize);
+                deferred_sample.m_sequence_index = sequence_index;
+                deferred_sample.m_x = x;
+                deferred_sample.m_y = y;
+                m_deferred_samples.push_back(deferred_sample);
+
+                return 1;
+            }
+
+            return render_sample(sequence_index, x, y, samples);
+        }
+
+        void flush_samples(
+            SampleVector&                   samples,
+            IAbortSwitch&                   abort_switch) override
+        {
+            if (m_deferred_samples.empty())
+                return;
+
+            // Render deferred samples tile by tile, to improve the coherence of
+            // geometry, texture and shader accesses between successive samples.
+            std::sort(m_deferred_samples.begin(), m_deferred_samples.end());
+
+            for (size_t i = 0, e = m_deferred_samples.size(); i < e; ++i)
+            {
+                if ((i & 63) == 0 && abort_switch.is_aborted())
+                    break;
+
+                const DeferredSample& deferred_sample = m_deferred_samples[i];
+                render_sample(
+                    deferred_sample.m_sequence_index,
+                    deferred_sample.m_x,
+                    deferred_sample.m_y,
+                    samples);
+            }
+
+            clear_keep_memory(m_deferred_samples);
+        }
+
+        // Find the pixel of the crop window sampled by a given sequence index of a coarse pass.
+        // Return false if the sequence index falls outside the crop window.
+        bool get_coarse_pass_pixel(
+            const size_t                    sequence_index,
+            int&                            x,
+            int&                            y) const
+        {
+            size_t pass_index = CoarsePassCount - 1;
+            while (sequence_index < m_coarse_passes[pass_index].m_sequence_begin)
+                --pass_index;
+
+            const CoarsePass& pass = m_coarse_passes[pass_index];
+
+            // The first indices of the Halton sequence stratify the padded grid of blocks:
+            // each block of the pass receives exactly one sample.
             const size_t Bases[2] = { 2, 3 };
-            const Vector2d s = halton_sequence<double, 2>(Bases, sequence_index);
+            const Vector2d s =
+                halton_sequence<double, 2>(Bases, sequence_index - pass.m_sequence_begin);
 
-            // Compute the coordinates of the pixel in the padded crop window.
-            const Vector2d t(s[0] * m_window_width_next_pow2, s[1] * m_window_height_next_pow3);
-            const int x = truncate<int>(t[0]);
-            const int y = truncate<int>(t[1]);
+            const int bx = truncate<int>(s[0] * pass.m_block_count_x_next_pow2);
+            const int by = truncate<int>(s[1] * pass.m_block_count_y_next_pow3);
 
-            // Reject samples that fall outside the actual frame.
-            if (x >= m_window_width || y >= m_window_height)
-                return 0;
+            if (bx >= pass.m_block_count_x || by >= pass.m_block_count_y)
+                return false;
+
+            // Pick a random pixel inside the block so that the sample contributes to the full resolution image.
+            const std::uint32_t h = hash_uint32(static_cast<std::uint32_t>(sequence_index));
+            const int offset_x = static_cast<int>(h % pass.m_block_size);
+            const int offset_y = static_cast<int>((h / pass.m_block_size) % pass.m_block_size);
 
+            x = std::min(bx * pass.m_block_size + offset_x, m_window_width - 1);
+            y = std::min(by * pass.m_block_size + offset_y, m_window_height - 1);
+
+            return true;
+        }
+
+        // Render a sample for a given sequence index and pixel of the crop window.
+        size_t render_sample(
+            const size_t                    sequence_index,
+            const int                       x,
+            const int                       y,
+            SampleVector&                   samples)
+        {
             // Create a sampling context. We start with an initial dimension of 2,
             // corresponding to the Halton sequence used for the sample positions.
             SamplingContext sampling_context(
@@ -258,10 +458,41 @@ SampleAccumulationBuffer* GenericSampleGeneratorFactory::create_sample_accumulat
 {
     const CanvasProperties& props = m_frame.image().properties();
 
-    return
+    LocalSampleAccumulationBuffer* buffer =
         new LocalSampleAccumulationBuffer(
             props.m_canvas_width,
             props.m_canvas_height);
+
+    // Only display levels of the pyramid once the coarse passes covered all their pixels.
+    if (m_params.get_optional<bool>("progressive_resolution", false))
+    {
+        const Vector2u window_extent = m_frame.get_crop_window().extent();
+
+        std::vector<LocalSampleAccumulationBuffer::CoarsePass> passes;
+        for (const size_t block_size : CoarsePassBlockSizes)
+        {
+            LocalSampleAccumulationBuffer::CoarsePass pass;
+            pass.m_block_size = block_size;
+            pass.m_sample_count =
+                get_block_count(window_extent.x, block_size) *
+                get_block_count(window_extent.y, block_size);
+            passes.push_back(pass);
+        }
+
+        buffer->set_coarse_passes(passes);
+    }
+
+    // A positive noise threshold enables adaptive sampling.
+    const float noise_threshold = m_params.get_optional<float>("noise_threshold", 0.0f);
+    if (noise_threshold > 0.0f)
+    {
+        buffer->enable_convergence_tracking(
+            m_frame.get_crop_window(),
+            noise_threshold,
+            m_params.get_optional<size_t>("min_samples", 16));
+    }
+
+    return buffer;
 }
 
 }   // namespace renderer
@@ -38,6 +38,10 @@
 #include "renderer/kernel/intersection/tracecontext.h"
 #include "renderer/kernel/lighting/ilightingengine.h"
 #include "renderer/kernel/lighting/tracer.h"
+#include "renderer/kernel/rasterization/visibilitybuffer.h"
+#include "renderer/kernel/rendering/pixelcontext.h"
+#include "renderer/kernel/rendering/rendercosttracker.h"
+#include "renderer/kernel/rendering/renderingmetrics.h"
 #include "renderer/kernel/shading/oslshadergroupexec.h"
 #include "renderer/kernel/shading/oslshadingsystem.h"
 #include "renderer/kernel/shading/shadingcontext.h"
@@ -61,14 +65,14 @@
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
+#include <algorithm>
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <string>
 
-// Forward declarations.
-namespace renderer  { class PixelContext; }
-
 using namespace foundation;
 
 namespace renderer
@@ -97,17 +101,24 @@ namespace
             ShadingEngine&          shading_engine,
             OIIOTextureSystem&      oiio_texture_system,
             OSLShadingSystem&       shading_system,
+            VisibilityBuffer*       visibility_buffer,
             const size_t            thread_index,
             const ParamArray&       params)
           : m_params(params)
           , m_scene(scene)
+          , m_frame(frame)
           , m_opacity_threshold(1.0f - m_params.m_transparency_threshold)
           , m_texture_cache(texture_store)
           , m_lighting_engine(lighting_engine_factory->create())
           , m_shading_engine(shading_engine)
           , m_oiio_texture_system(oiio_texture_system)
+          , m_visibility_buffer(visibility_buffer)
           , m_thread_index(thread_index)
-          , m_shadergroup_exec(shading_system, m_arena)
+          , m_cost_tracker(
+                m_params.m_cost_attribution
+                    ? new RenderCostTracker(m_intersector, m_params.m_cost_timing_interval)
+                    : nullptr)
+          , m_shadergroup_exec(shading_system, m_arena, m_cost_tracker.get())
           , m_intersector(
                 trace_context,
                 m_texture_cache,
@@ -130,15 +141,27 @@ namespace
                 m_lighting_engine,
                 m_params.m_transparency_threshold,
                 m_params.m_max_iterations)
+          , m_reconstructed_primary_hits(0)
+          , m_traced_primary_rays(0)
+          , m_sample_count(0)
+          , m_published_sample_count(0)
+          , m_published_ray_count(0)
+          , m_published_texture_cache_hit_count(0)
+          , m_published_texture_cache_miss_count(0)
         {
             // 1/4 of a pixel, like in RenderMan RIS.
             const CanvasProperties& c = frame.image().properties();
             m_image_point_dx = Vector2d(1.0 / (4.0 * c.m_canvas_width), 0.0);
             m_image_point_dy = Vector2d(0.0, -1.0 / (4.0 * c.m_canvas_height));
+
+            // In multi-view frames, image points are expressed relative to their view.
+            m_view_point_dx = m_image_point_dx * static_cast<double>(frame.get_view_column_count());
+            m_view_point_dy = m_image_point_dy * static_cast<double>(frame.get_view_row_count());
         }
 
         ~GenericSampleRenderer() override
         {
+            publish_metrics();
             m_lighting_engine->release();
         }
 
@@ -153,10 +176,16 @@ namespace
                 "generic sample renderer settings:\n"
                 "  transparency threshold        %f\n"
                 "  max iterations                %s\n"
-                "  report self intersections     %s",
+                "  report self intersections     %s\n"
+                "  rasterize primary visibility  %s\n"
+                "  cost attribution              %s",
                 m_params.m_transparency_threshold,
                 pretty_uint(m_params.m_max_iterations).c_str(),
-                m_params.m_report_self_intersections ? "on" : "off");
+                m_params.m_report_self_intersections ? "on" : "off",
+                m_visibility_buffer ? "on" : "off",
+                m_params.m_cost_attribution
+                    ? ("on, timing 1 in " + pretty_uint(m_params.m_cost_timing_interval) + " events").c_str()
+                    : "off");
 
             m_lighting_engine->print_settings();
         }
@@ -177,19 +206,322 @@ namespace
 
             // Construct a primary ray.
             ShadingRay primary_ray;
-            m_scene.get_render_data().m_active_camera->spawn_ray(
+            spawn_primary_ray(sampling_context, pixel_context, image_point, primary_ray);
+
+            if (m_visibility_buffer)
+                m_visibility_buffer->update();
+
+            // Trace the primary ray, or reconstruct the primary hit from the visibility buffer.
+            ShadingPoint primary_hit;
+            trace_primary_ray(primary_ray, image_point, primary_hit);
+
+            shade_sample(
                 sampling_context,
-                Dual2d(image_point, m_image_point_dx, m_image_point_dy),
-                primary_ray);
+                pixel_context,
+                primary_ray,
+                primary_hit,
+                aov_accumulators,
+                shading_result);
+
+#ifdef DEBUG_DISPLAY_TEXTURE_CACHE_PERFORMANCE
+
+            const std::uint64_t delta_hit_count = m_texture_cache.get_hit_count() - last_texture_cache_hit_count;
+            const std::uint64_t delta_miss_count = m_texture_cache.get_miss_count() - last_texture_cache_miss_count;
+
+            if (delta_hit_count + delta_miss_count == 0)
+            {
+                // In black: no access to the texture cache.
+                shading_result.m_main = Color4f(0.0f, 0.0f, 0.0f, 1.0f);
+            }
+            else if (delta_hit_count > delta_miss_count)
+            {
+                // In green: a majority of cache hits.
+                shading_result.m_main = Color4f(0.0f, 1.0f, 0.0f, 1.0f);
+            }
+            else
+            {
+                // In red: a majority of cache misses.
+                shading_result.m_main = Color4f(1.0f, 0.0f, 0.0f, 1.0f);
+            }
+
+#endif
+        }
+
+        void render_samples(
+            const size_t                count,
+            SamplingContext             sampling_contexts[],
+            const PixelContext          pixel_contexts[],
+            const Vector2d              image_points[],
+            AOVAccumulatorContainer&    aov_accumulators,
+            ShadingResult               shading_results[]) override
+        {
+#ifdef DEBUG_DISPLAY_TEXTURE_CACHE_PERFORMANCE
+
+            // Texture cache accesses must be attributed to individual samples.
+            ISampleRenderer::render_samples(
+                count,
+                sampling_contexts,
+                pixel_contexts,
+                image_points,
+                aov_accumulators,
+                shading_results);
+
+#else
+
+            for (size_t begin = 0; begin < count; begin += MaxBatchSize)
+            {
+                const size_t end = std::min<size_t>(begin + MaxBatchSize, count);
+
+                // Construct all primary rays of the batch.
+                spawn_primary_rays(
+                    end - begin,
+                    sampling_contexts + begin,
+                    pixel_contexts + begin,
+                    image_points + begin,
+                    m_batch_rays);
+
+                if (m_visibility_buffer)
+                    m_visibility_buffer->update();
+
+                // Trace them back-to-back: the rays are coherent and keep the same
+                // parts of the acceleration structures in cache.
+                for (size_t i = begin; i < end; ++i)
+                {
+                    trace_primary_ray(
+                        m_batch_rays[i - begin],
+                        image_points[i],
+                        m_batch_hits[i - begin]);
+                }
+
+                // Shade the samples in order.
+                for (size_t i = begin; i < end; ++i)
+                {
+                    shade_sample(
+                        sampling_contexts[i],
+                        pixel_contexts[i],
+                        m_batch_rays[i - begin],
+                        m_batch_hits[i - begin],
+                        aov_accumulators,
+                        shading_results[i]);
+                }
+            }
+
+#endif
+        }
+
+        StatisticsVector get_statistics() const override
+        {
+            StatisticsVector stats;
+            stats.merge(m_texture_cache.get_statistics());
+            stats.merge(m_intersector.get_statistics());
+            stats.merge(m_lighting_engine->get_statistics());
+            stats.insert("shading arena statistics", m_arena.get_statistics());
 
+            if (m_visibility_buffer)
+            {
+                Statistics primary_stats;
+                primary_stats.insert_percent(
+                    "reconstructed hits",
+                    m_reconstructed_primary_hits,
+                    m_reconstructed_primary_hits + m_traced_primary_rays);
+                stats.insert("primary visibility statistics", primary_stats);
+            }
+
+            if (m_cost_tracker)
+                stats.merge(m_cost_tracker->get_statistics());
+
+            return stats;
+        }
+
+      private:
+        struct Parameters
+        {
+            const float     m_transparency_threshold;
+            const size_t    m_max_iterations;
+            const bool      m_report_self_intersections;
+            const bool      m_cost_attribution;             // attribute rendering costs to objects, materials and shader groups?
+            const size_t    m_cost_timing_interval;         // time one out of this many shading events
+
+            explicit Parameters(const ParamArray& params)
+              : m_transparency_threshold(params.get_optional<float>("transparency_threshold", 0.001f))
+              , m_max_iterations(params.get_optional<size_t>("max_iterations", 100))
+              , m_report_self_intersections(params.get_optional<bool>("report_self_intersections", false))
+              , m_cost_attribution(params.get_optional<bool>("cost_attribution", false))
+              , m_cost_timing_interval(params.get_optional<size_t>("cost_timing_interval", 16))
+            {
+            }
+        };
+
+        enum { MaxBatchSize = 16 };
+
+        // Number of samples between two updates of the global rendering metrics.
+        enum { MetricsPublishInterval = 256 };
+
+        const Parameters            m_params;
+        const Scene&                m_scene;
+        const Frame&                m_frame;
+        const float                 m_opacity_threshold;
+        TextureCache                m_texture_cache;
+        ILightingEngine*            m_lighting_engine;
+        ShadingEngine&              m_shading_engine;
+        OIIOTextureSystem&          m_oiio_texture_system;
+        VisibilityBuffer*           m_visibility_buffer;
+        const size_t                m_thread_index;
+
+        Arena                       m_arena;
+        std::unique_ptr<RenderCostTracker> m_cost_tracker;
+        OSLShaderGroupExec          m_shadergroup_exec;
+        const Intersector           m_intersector;
+        Tracer                      m_tracer;
+        const ShadingContext        m_shading_context;
+
+        Vector2d                    m_image_point_dx;
+        Vector2d                    m_image_point_dy;
+        Vector2d                    m_view_point_dx;
+        Vector2d                    m_view_point_dy;
+
+        std::uint64_t               m_reconstructed_primary_hits;
+        std::uint64_t               m_traced_primary_rays;
+
+        ShadingRay                  m_batch_rays[MaxBatchSize];
+        ShadingPoint                m_batch_hits[MaxBatchSize];
+
+        std::uint64_t               m_sample_count;
+        std::uint64_t               m_published_sample_count;
+        std::uint64_t               m_published_ray_count;
+        std::uint64_t               m_published_texture_cache_hit_count;
+        std::uint64_t               m_published_texture_cache_miss_count;
+
+        // Publish the counts accumulated since the last call to the global rendering metrics.
+        void publish_metrics()
+        {
+            RenderingMetrics& metrics = global_rendering_metrics();
+
+            const std::uint64_t ray_count = m_intersector.get_ray_count();
+            const std::uint64_t hit_count = m_texture_cache.get_hit_count();
+            const std::uint64_t miss_count = m_texture_cache.get_miss_count();
+
+            metrics.add_samples(m_sample_count - m_published_sample_count);
+            metrics.add_rays(ray_count - m_published_ray_count);
+            metrics.add_texture_cache_accesses(
+                hit_count - m_published_texture_cache_hit_count,
+                miss_count - m_published_texture_cache_miss_count);
+
+            m_published_sample_count = m_sample_count;
+            m_published_ray_count = ray_count;
+            m_published_texture_cache_hit_count = hit_count;
+            m_published_texture_cache_miss_count = miss_count;
+        }
+
+        void spawn_primary_ray(
+            SamplingContext&            sampling_context,
+            const PixelContext&         pixel_context,
+            const Vector2d&             image_point,
+            ShadingRay&                 primary_ray) const
+        {
+            if (m_frame.get_view_count() == 0)
+            {
+                m_scene.get_render_data().m_active_camera->spawn_ray(
+                    sampling_context,
+                    Dual2d(image_point, m_image_point_dx, m_image_point_dy),
+                    primary_ray);
+            }
+            else
+            {
+                Vector2d view_point;
+                const size_t view_index =
+                    m_frame.get_view(pixel_context.get_pixel_coords(), image_point, view_point);
+
+                m_scene.get_view_camera(view_index)->spawn_ray(
+                    sampling_context,
+                    Dual2d(view_point, m_view_point_dx, m_view_point_dy),
+                    primary_ray);
+            }
+        }
+
+        void spawn_primary_rays(
+            const size_t                count,
+            SamplingContext             sampling_contexts[],
+            const PixelContext          pixel_contexts[],
+            const Vector2d              image_points[],
+            ShadingRay                  primary_rays[]) const
+        {
+            assert(count <= MaxBatchSize);
+
+            if (m_frame.get_view_count() == 0)
+            {
+                // All rays come from the same camera: let it share work between them.
+                Dual2d ndc[MaxBatchSize];
+                for (size_t i = 0; i < count; ++i)
+                    ndc[i] = Dual2d(image_points[i], m_image_point_dx, m_image_point_dy);
+
+                m_scene.get_render_data().m_active_camera->spawn_rays(
+                    sampling_contexts,
+                    ndc,
+                    count,
+                    primary_rays);
+            }
+            else
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    spawn_primary_ray(
+                        sampling_contexts[i],
+                        pixel_contexts[i],
+                        image_points[i],
+                        primary_rays[i]);
+                }
+            }
+        }
+
+        void trace_primary_ray(
+            const ShadingRay&           primary_ray,
+            const Vector2d&             image_point,
+            ShadingPoint&               shading_point)
+        {
+            shading_point.clear();
+
+            if (m_visibility_buffer &&
+                m_visibility_buffer->trace(
+                    m_intersector,
+                    primary_ray,
+                    image_point,
+                    shading_point))
+                ++m_reconstructed_primary_hits;
+            else
+            {
+                m_intersector.trace(primary_ray, shading_point);
+                ++m_traced_primary_rays;
+            }
+        }
+
+        // Shade a sample given the first hit of its primary ray, then keep tracing
+        // through transparent surfaces.
+        void shade_sample(
+            SamplingContext&            sampling_context,
+            const PixelContext&         pixel_context,
+            ShadingRay&                 primary_ray,
+            const ShadingPoint&         primary_hit,
+            AOVAccumulatorContainer&    aov_accumulators,
+            ShadingResult&              shading_result)
+        {
             ShadingPoint shading_points[2];
             size_t shading_point_index = 0;
-            const ShadingPoint* shading_point_ptr = nullptr;
+            const ShadingPoint* shading_point_ptr = &primary_hit;
             size_t iterations = 0;
 
             // Inform the AOV accumulators that we are about to render a sample.
             aov_accumulators.on_sample_begin(pixel_context);
 
+#ifdef APPLESEED_WITH_SPECTRAL_SUPPORT
+            // In hero wavelength mode, choose the bands carried by the paths of this sample.
+            if (Spectrum::get_mode() == Spectrum::HeroWavelength)
+            {
+                sampling_context.split_in_place(1, 1);
+                Spectrum::select_band_block(sampling_context.next2<float>());
+            }
+#endif
+
             while (true)
             {
                 // Put a hard limit on the number of iterations.
@@ -203,17 +535,6 @@ namespace
 
                 m_arena.clear();
 
-                // Trace the ray.
-                shading_points[shading_point_index].clear();
-                m_intersector.trace(
-                    primary_ray,
-                    shading_points[shading_point_index],
-                    shading_point_ptr);
-
-                // Update the pointers to the shading points.
-                shading_point_ptr = &shading_points[shading_point_index];
-                shading_point_index = 1 - shading_point_index;
-
                 if (iterations == 1)
                 {
                     // Shade the first intersection point along the ray.
@@ -231,6 +552,17 @@ namespace
                 }
                 else
                 {
+                    // Trace the ray.
+                    shading_points[shading_point_index].clear();
+                    m_intersector.trace(
+                        primary_ray,
+                        shading_points[shading_point_index],
+                        shading_point_ptr);
+
+                    // Update the pointers to the shading points.
+                    shading_point_ptr = &shading_points[shading_point_index];
+                    shading_point_index = 1 - shading_point_index;
+
                     // Shade the next intersection point along the ray.
                     ShadingResult local_result(shading_result.m_aov_count);
                     const bool terminate_path =
@@ -270,71 +602,9 @@ namespace
             // Inform the AOV accumulators that we are done rendering a sample.
             aov_accumulators.on_sample_end(pixel_context);
 
-#ifdef DEBUG_DISPLAY_TEXTURE_CACHE_PERFORMANCE
-
-            const std::uint64_t delta_hit_count = m_texture_cache.get_hit_count() - last_texture_cache_hit_count;
-            const std::uint64_t delta_miss_count = m_texture_cache.get_miss_count() - last_texture_cache_miss_count;
-
-            if (delta_hit_count + delta_miss_count == 0)
-            {
-                // In black: no access to the texture cache.
-                shading_result.m_main = Color4f(0.0f, 0.0f, 0.0f, 1.0f);
-            }
-            else if (delta_hit_count > delta_miss_count)
-            {
-                // In green: a majority of cache hits.
-                shading_result.m_main = Color4f(0.0f, 1.0f, 0.0f, 1.0f);
-            }
-            else
-            {
-                // In red: a majority of cache misses.
-                shading_result.m_main = Color4f(1.0f, 0.0f, 0.0f, 1.0f);
-            }
-
-#endif
-        }
-
-        StatisticsVector get_statistics() const override
-        {
-            StatisticsVector stats;
-            stats.merge(m_texture_cache.get_statistics());
-            stats.merge(m_intersector.get_statistics());
-            stats.merge(m_lighting_engine->get_statistics());
-            return stats;
+            if (++m_sample_count - m_published_sample_count >= MetricsPublishInterval)
+                publish_metrics();
         }
-
-      private:
-        struct Parameters
-        {
-            const float     m_transparency_threshold;
-            const size_t    m_max_iterations;
-            const bool      m_report_self_intersections;
-
-            explicit Parameters(const ParamArray& params)
-              : m_transparency_threshold(params.get_optional<float>("transparency_threshold", 0.001f))
-              , m_max_iterations(params.get_optional<size_t>("max_iterations", 100))
-              , m_report_self_intersections(params.get_optional<bool>("report_self_intersections", false))
-            {
-            }
-        };
-
-        const Parameters            m_params;
-        const Scene&                m_scene;
-        const float                 m_opacity_threshold;
-        TextureCache                m_texture_cache;
-        ILightingEngine*            m_lighting_engine;
-        ShadingEngine&              m_shading_engine;
-        OIIOTextureSystem&          m_oiio_texture_system;
-        const size_t                m_thread_index;
-
-        Arena                       m_arena;
-        OSLShaderGroupExec          m_shadergroup_exec;
-        const Intersector           m_intersector;
-        Tracer                      m_tracer;
-        const ShadingContext        m_shading_context;
-
-        Vector2d                    m_image_point_dx;
-        Vector2d                    m_image_point_dy;
     };
 }
 
@@ -352,6 +622,7 @@ GenericSampleRendererFactory::GenericSampleRendererFactory(
     ShadingEngine&          shading_engine,
     OIIOTextureSystem&      oiio_texture_system,
     OSLShadingSystem&       shading_system,
+    VisibilityBuffer*       visibility_buffer,
     const ParamArray&       params)
   : m_scene(scene)
   , m_frame(frame)
@@ -361,6 +632,7 @@ GenericSampleRendererFactory::GenericSampleRendererFactory(
   , m_shading_engine(shading_engine)
   , m_oiio_texture_system(oiio_texture_system)
   , m_shading_system(shading_system)
+  , m_visibility_buffer(visibility_buffer)
   , m_params(params)
 {
 }
@@ -382,6 +654,7 @@ ISampleRenderer* GenericSampleRendererFactory::create(const size_t thread_index)
             m_shading_engine,
             m_oiio_texture_system,
             m_shading_system,
+            m_visibility_buffer,
             thread_index,
             m_params);
 }
@@ -45,6 +45,7 @@ namespace renderer  { class Scene; }
 namespace renderer  { class ShadingEngine; }
 namespace renderer  { class TextureStore; }
 namespace renderer  { class TraceContext; }
+namespace renderer  { class VisibilityBuffer; }
 
 namespace renderer
 {
@@ -67,6 +68,7 @@ class GenericSampleRendererFactory
         ShadingEngine&          shading_engine,
         OIIOTextureSystem&      oiio_texture_system,
         OSLShadingSystem&       shading_system,
+        VisibilityBuffer*       visibility_buffer,
         const ParamArray&       params);
 
     // Delete this instance.
@@ -85,6 +87,7 @@ class GenericSampleRendererFactory
     ShadingEngine&              m_shading_engine;
     OIIOTextureSystem&          m_oiio_texture_system;
     OSLShadingSystem&           m_shading_system;
+    VisibilityBuffer*           m_visibility_buffer;
     const ParamArray            m_params;
 };
 
@@ -39,6 +39,7 @@
 #include "renderer/kernel/rendering/ipixelrenderer.h"
 #include "renderer/kernel/rendering/ishadingresultframebufferfactory.h"
 #include "renderer/kernel/rendering/pixelcontext.h"
+#include "renderer/kernel/rendering/renderingmetrics.h"
 #include "renderer/kernel/rendering/shadingresultframebuffer.h"
 #include "renderer/modeling/frame/frame.h"
 #include "renderer/utility/bbox.h"
@@ -56,6 +57,7 @@
 #include "foundation/platform/arch.h"
 #include "foundation/platform/debugger.h"
 #include "foundation/string/string.h"
+#include "foundation/utility/hardwarecounters.h"
 #include "foundation/utility/iostreamop.h"
 #include "foundation/utility/job.h"
 #include "foundation/utility/statistics.h"
@@ -120,6 +122,47 @@ namespace
             const size_t                        tile_y,
             const std::uint32_t                 pass_hash,
             IAbortSwitch&                       abort_switch) override
+        {
+            render_tile_region(frame, tile_x, tile_y, nullptr, pass_hash, abort_switch);
+        }
+
+        bool supports_sub_tiles() const override
+        {
+            return
+                m_framebuffer_factory->supports_sub_tiles() &&
+                m_aov_accumulators.supports_sub_tiles();
+        }
+
+        void render_sub_tile(
+            const Frame&                        frame,
+            const size_t                        tile_x,
+            const size_t                        tile_y,
+            const AABB2u&                       rect,
+            const std::uint32_t                 pass_hash,
+            IAbortSwitch&                       abort_switch) override
+        {
+            render_tile_region(frame, tile_x, tile_y, &rect, pass_hash, abort_switch);
+        }
+
+        StatisticsVector get_statistics() const override
+        {
+            return m_pixel_renderer->get_statistics();
+        }
+
+      protected:
+        auto_release_ptr<IPixelRenderer>        m_pixel_renderer;
+        AOVAccumulatorContainer                 m_aov_accumulators;
+        IShadingResultFrameBufferFactory*       m_framebuffer_factory;
+        std::vector<Vector<std::int16_t, 2>>    m_pixel_ordering;
+
+        // Render a tile, or only a part of it if `rect` is not null.
+        void render_tile_region(
+            const Frame&                        frame,
+            const size_t                        tile_x,
+            const size_t                        tile_y,
+            const AABB2u*                       rect,
+            const std::uint32_t                 pass_hash,
+            IAbortSwitch&                       abort_switch)
         {
             // Retrieve frame properties.
             const CanvasProperties& frame_properties = frame.image().properties();
@@ -135,16 +178,20 @@ namespace
             const int tile_height = static_cast<int>(tile.get_height());
 
             // Compute the tile space bounding box of the pixels to render.
-            const AABB2i tile_bbox =
+            AABB2i tile_bbox =
                 compute_tile_space_bbox(
                     tile_origin_x,
                     tile_origin_y,
                     tile_width,
                     tile_height,
                     frame.get_crop_window());
+            if (rect != nullptr)
+                tile_bbox = AABB2i::intersect(tile_bbox, AABB2i(*rect));
             if (!tile_bbox.is_valid())
                 return;
 
+            ScopedRenderingThread rendering_thread;
+
             // Inform the pixel renderer that we are about to render a tile.
             m_pixel_renderer->on_tile_begin(
                 frame,
@@ -208,7 +255,12 @@ namespace
             }
 
             // Develop the framebuffer to the tile.
-            framebuffer->develop_to_tile(tile, aov_tiles);
+            {
+                APPLESEED_HARDWARE_COUNTERS_SCOPE("accumulation");
+                if (rect != nullptr)
+                    framebuffer->develop_to_tile(tile, aov_tiles, AABB2u(tile_bbox));
+                else framebuffer->develop_to_tile(tile, aov_tiles);
+            }
 
             // Release the framebuffer.
             m_framebuffer_factory->destroy(framebuffer);
@@ -223,19 +275,12 @@ namespace
                 tile_y,
                 tile,
                 aov_tiles);
-        }
 
-        StatisticsVector get_statistics() const override
-        {
-            return m_pixel_renderer->get_statistics();
+            const Vector2i extent = tile_bbox.extent();
+            global_rendering_metrics().add_rendered_pixels(
+                static_cast<std::uint64_t>(extent.x + 1) * static_cast<std::uint64_t>(extent.y + 1));
         }
 
-      protected:
-        auto_release_ptr<IPixelRenderer>        m_pixel_renderer;
-        AOVAccumulatorContainer                 m_aov_accumulators;
-        IShadingResultFrameBufferFactory*       m_framebuffer_factory;
-        std::vector<Vector<std::int16_t, 2>>    m_pixel_ordering;
-
         void compute_pixel_ordering(const Frame& frame)
         {
             // Compute the dimensions in pixels of the tile.
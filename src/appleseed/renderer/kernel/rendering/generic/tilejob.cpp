@@ -31,6 +31,8 @@
 #include "tilejob.h"
 
 // appleseed.renderer headers.
+#include "renderer/kernel/aov/imagestack.h"
+#include "renderer/kernel/aov/tilestack.h"
 #include "renderer/kernel/rendering/itilecallback.h"
 #include "renderer/kernel/rendering/itilerenderer.h"
 #include "renderer/modeling/frame/frame.h"
@@ -39,9 +41,13 @@
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/image.h"
 #include "foundation/image/tile.h"
+#include "foundation/utility/eventtracer.h"
+#include "foundation/utility/job/jobqueue.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <exception>
 
 using namespace foundation;
@@ -53,6 +59,14 @@ namespace renderer
 // TileJob class implementation.
 //
 
+namespace
+{
+    // Sub-tiles are never smaller than this, in pixels, along either dimension.
+    const size_t MinSubTileSize = 8;
+}
+
+const size_t TileJob::MaxSubTileCount;
+
 TileJob::TileJob(
     const TileRendererVector&   tile_renderers,
     const TileCallbackVector&   tile_callbacks,
@@ -62,6 +76,8 @@ TileJob::TileJob(
     const size_t                thread_count,
     const std::uint32_t         pass_hash,
     const Spectrum::Mode        spectrum_mode,
+    JobQueue*                   job_queue,
+    const size_t                sub_tile_count,
     IAbortSwitch&               abort_switch)
   : m_tile_renderers(tile_renderers)
   , m_tile_callbacks(tile_callbacks)
@@ -71,7 +87,11 @@ TileJob::TileJob(
   , m_thread_count(thread_count)
   , m_pass_hash(pass_hash)
   , m_spectrum_mode(spectrum_mode)
+  , m_job_queue(job_queue)
+  , m_sub_tile_count(sub_tile_count)
   , m_abort_switch(abort_switch)
+  , m_is_sub_tile(false)
+  , m_is_finished(false)
 {
     // Either there is no tile callback, or there is the same number
     // of tile callbacks and rendering threads.
@@ -80,8 +100,39 @@ TileJob::TileJob(
         || m_tile_callbacks.size() == tile_renderers.size());
 }
 
+TileJob::TileJob(
+    const TileJob&              parent,
+    const AABB2u&               sub_tile)
+  : m_tile_renderers(parent.m_tile_renderers)
+  , m_tile_callbacks(parent.m_tile_callbacks)
+  , m_frame(parent.m_frame)
+  , m_tile_x(parent.m_tile_x)
+  , m_tile_y(parent.m_tile_y)
+  , m_thread_count(parent.m_thread_count)
+  , m_pass_hash(parent.m_pass_hash)
+  , m_spectrum_mode(parent.m_spectrum_mode)
+  , m_job_queue(nullptr)
+  , m_sub_tile_count(1)
+  , m_abort_switch(parent.m_abort_switch)
+  , m_is_sub_tile(true)
+  , m_sub_tile(sub_tile)
+  , m_is_finished(false)
+  , m_pending_sub_tiles(parent.m_pending_sub_tiles)
+{
+}
+
+TileJob::~TileJob()
+{
+    // A sub-tile job may be deleted without being executed if rendering is aborted.
+    // Release the tile if this was its last pending sub-tile.
+    if (m_pending_sub_tiles && !m_is_finished && finish())
+        m_frame.unpin_tile(m_tile_x, m_tile_y);
+}
+
 void TileJob::execute(const size_t thread_index)
 {
+    APPLESEED_TRACE_SCOPE("rendering", "render tile");
+
     // Initialize thread-local variables.
     Spectrum::set_mode(m_spectrum_mode);
 
@@ -125,43 +176,163 @@ void TileJob::execute(const size_t thread_index)
     // to invoking `on_tile_begin()` is a faster, sufficient alternative.
     //
 
-    // This causes the tile to be allocated.
-    m_frame.image().tile(m_tile_x, m_tile_y);
+    assert(thread_index < m_tile_renderers.size());
 
     // Retrieve the tile callback.
-    assert(thread_index < m_tile_renderers.size());
     ITileCallback* tile_callback =
         m_tile_callbacks.size() == m_tile_renderers.size()
             ? m_tile_callbacks[thread_index]
             : nullptr;
 
-    // Call the pre-render tile callback.
-    if (tile_callback)
-        tile_callback->on_tile_begin(&m_frame, m_tile_x, m_tile_y, thread_index, m_thread_count);
+    // Sub-tile jobs created by split() share the tile with the job that split it,
+    // which already pinned it and called the pre-render tile callback.
+    if (!m_is_sub_tile)
+    {
+        // Keep the tile in memory until it is rendered if the frame is out-of-core.
+        m_frame.pin_tile(m_tile_x, m_tile_y);
+
+        // This causes the tile to be allocated.
+        m_frame.image().tile(m_tile_x, m_tile_y);
+
+        // Call the pre-render tile callback.
+        if (tile_callback)
+            tile_callback->on_tile_begin(&m_frame, m_tile_x, m_tile_y, thread_index, m_thread_count);
+
+        // Split the tile if jobs are meant to be smaller than a tile, and further near
+        // the end of the frame so that idle threads can help render it.
+        if (m_job_queue != nullptr && m_tile_renderers[thread_index]->supports_sub_tiles())
+        {
+            size_t sub_tile_count = m_sub_tile_count;
+
+            const size_t scheduled_job_count = m_job_queue->get_scheduled_job_count();
+            if (scheduled_job_count + 1 < m_thread_count)
+                sub_tile_count = std::max(sub_tile_count, m_thread_count - scheduled_job_count);
+
+            if (sub_tile_count > 1)
+                split(std::min(sub_tile_count, MaxSubTileCount));
+        }
+    }
 
     try
     {
         // Render the tile.
-        m_tile_renderers[thread_index]->render_tile(
-            m_frame,
-            m_tile_x,
-            m_tile_y,
-            m_pass_hash,
-            m_abort_switch);
+        if (m_is_sub_tile)
+        {
+            m_tile_renderers[thread_index]->render_sub_tile(
+                m_frame,
+                m_tile_x,
+                m_tile_y,
+                m_sub_tile,
+                m_pass_hash,
+                m_abort_switch);
+        }
+        else
+        {
+            m_tile_renderers[thread_index]->render_tile(
+                m_frame,
+                m_tile_x,
+                m_tile_y,
+                m_pass_hash,
+                m_abort_switch);
+        }
     }
     catch (const std::exception&)
     {
-        // Call the post-render tile callback.
-        if (tile_callback)
-            tile_callback->on_tile_end(&m_frame, m_tile_x, m_tile_y);
+        end_tile(tile_callback);
 
         // Rethrow the exception.
         throw;
     }
 
+    end_tile(tile_callback);
+}
+
+bool TileJob::finish()
+{
+    assert(!m_is_finished);
+    m_is_finished = true;
+
+    return !m_pending_sub_tiles || --*m_pending_sub_tiles == 0;
+}
+
+void TileJob::end_tile(ITileCallback* tile_callback)
+{
+    // Only the last sub-tile to complete ends the tile.
+    if (!finish())
+        return;
+
     // Call the post-render tile callback.
     if (tile_callback)
         tile_callback->on_tile_end(&m_frame, m_tile_x, m_tile_y);
+
+    // Let the tile be flushed to disk if the frame is out-of-core.
+    m_frame.unpin_tile(m_tile_x, m_tile_y);
+}
+
+void TileJob::split(const size_t max_sub_tile_count)
+{
+    const Tile& tile = m_frame.image().tile(m_tile_x, m_tile_y);
+    const size_t tile_width = tile.get_width();
+    const size_t tile_height = tile.get_height();
+
+    // Find a grid of sub-tiles, splitting the longest side of the sub-tiles first.
+    size_t count_x = 1, count_y = 1;
+    while (count_x * count_y < max_sub_tile_count)
+    {
+        const bool can_split_x = tile_width / (count_x + 1) >= MinSubTileSize;
+        const bool can_split_y = tile_height / (count_y + 1) >= MinSubTileSize;
+
+        if (can_split_x && (!can_split_y || tile_width * count_y >= tile_height * count_x))
+        {
+            if ((count_x + 1) * count_y > max_sub_tile_count)
+                break;
+            ++count_x;
+        }
+        else if (can_split_y)
+        {
+            if (count_x * (count_y + 1) > max_sub_tile_count)
+                break;
+            ++count_y;
+        }
+        else break;
+    }
+
+    if (count_x * count_y == 1)
+        return;
+
+    // Make sure the AOV tiles are allocated before sub-tiles are rendered concurrently.
+    m_frame.aov_images().tiles(m_tile_x, m_tile_y);
+
+    // All sub-tiles, including the one rendered by this job, are pending.
+    m_pending_sub_tiles = std::make_shared<boost::atomic<size_t>>(count_x * count_y);
+
+    for (size_t y = 0; y < count_y; ++y)
+    {
+        for (size_t x = 0; x < count_x; ++x)
+        {
+            const AABB2u sub_tile(
+                Vector2u(
+                    static_cast<std::uint32_t>(x * tile_width / count_x),
+                    static_cast<std::uint32_t>(y * tile_height / count_y)),
+                Vector2u(
+                    static_cast<std::uint32_t>((x + 1) * tile_width / count_x - 1),
+                    static_cast<std::uint32_t>((y + 1) * tile_height / count_y - 1)));
+
+            // This job renders the first sub-tile. The other sub-tiles are
+            // scheduled ahead of the remaining whole tiles to shorten the tail.
+            if (x == 0 && y == 0)
+                m_sub_tile = sub_tile;
+            else
+            {
+                m_job_queue->schedule(
+                    new TileJob(*this, sub_tile),
+                    true,
+                    JobQueue::HighPriority);
+            }
+        }
+    }
+
+    m_is_sub_tile = true;
 }
 
 }   // namespace renderer
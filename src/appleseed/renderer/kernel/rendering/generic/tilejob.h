@@ -33,11 +33,16 @@
 #include "renderer/global/globaltypes.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/aabb.h"
 #include "foundation/utility/job.h"
 
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+
 // Standard headers.
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 // Forward declarations.
@@ -59,7 +64,18 @@ class TileJob
     typedef std::vector<ITileRenderer*> TileRendererVector;
     typedef std::vector<ITileCallback*> TileCallbackVector;
 
-    // Constructor.
+    // Maximum number of sub-tiles a tile can be split into.
+    static const size_t MaxSubTileCount = 16;
+
+    // Constructor. If `job_queue` is not null and fewer jobs than rendering threads remain
+    // in it when the job starts, the tile is split into sub-tiles and all of them but one
+    // are scheduled into `job_queue` so that otherwise idle threads can help render it.
+    // Likewise, the tile is always split into about `sub_tile_count` sub-tiles if it is
+    // greater than 1.
+    //
+    // Tile callbacks are invoked once per tile even if the tile is split: `on_tile_begin()`
+    // is called by the job that splits the tile, and `on_tile_end()` by the job rendering
+    // the last sub-tile to complete.
     TileJob(
         const TileRendererVector&   tile_renderers,
         const TileCallbackVector&   tile_callbacks,
@@ -69,8 +85,13 @@ class TileJob
         const size_t                thread_count,
         const std::uint32_t         pass_hash,
         const Spectrum::Mode        spectrum_mode,
+        foundation::JobQueue*       job_queue,
+        const size_t                sub_tile_count,
         foundation::IAbortSwitch&   abort_switch);
 
+    // Destructor.
+    ~TileJob() override;
+
     // Execute the job.
     void execute(const size_t thread_index) override;
 
@@ -83,7 +104,31 @@ class TileJob
     const size_t                    m_thread_count;
     const std::uint32_t             m_pass_hash;
     const Spectrum::Mode            m_spectrum_mode;
+    foundation::JobQueue*           m_job_queue;
+    const size_t                    m_sub_tile_count;
     foundation::IAbortSwitch&       m_abort_switch;
+    bool                            m_is_sub_tile;
+    foundation::AABB2u              m_sub_tile;     // in tile space, only valid if m_is_sub_tile is true
+    bool                            m_is_finished;
+
+    // Number of sub-tiles of the tile that are not finished yet, shared by all the sub-tile
+    // jobs of the tile. Null if the tile is not split.
+    std::shared_ptr<boost::atomic<size_t>> m_pending_sub_tiles;
+
+    // Constructor for sub-tile jobs.
+    TileJob(
+        const TileJob&              parent,
+        const foundation::AABB2u&   sub_tile);
+
+    // Split the tile into at most `max_sub_tile_count` sub-tiles, schedule all of them
+    // but the first one and turn this job into a job rendering the first sub-tile.
+    void split(const size_t max_sub_tile_count);
+
+    // Mark this job as finished. Return true if the whole tile is finished.
+    bool finish();
+
+    // Call the post-render tile callback and release the tile once the whole tile is finished.
+    void end_tile(ITileCallback* tile_callback);
 };
 
 }   // namespace renderer
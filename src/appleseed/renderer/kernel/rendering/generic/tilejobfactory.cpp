@@ -60,6 +60,8 @@ void TileJobFactory::create(
     const std::uint32_t                 pass_hash,
     const Spectrum::Mode                spectrum_mode,
     TileJobVector&                      tile_jobs,
+    JobQueue*                           job_queue,
+    const size_t                        sub_tile_count,
     IAbortSwitch&                       abort_switch)
 {
     // Retrieve frame properties.
@@ -72,7 +74,8 @@ void TileJobFactory::create(
     // Make sure the right number of tiles was created.
     assert(tiles.size() == props.m_tile_count);
 
-    // Create tile jobs, one per tile.
+    // Create tile jobs, one per tile overlapping the crop window.
+    // Tiles outside the crop window are neither rendered nor allocated.
     for (size_t i = 0; i < props.m_tile_count; ++i)
     {
         // Compute coordinates of the tile in the frame.
@@ -82,6 +85,9 @@ void TileJobFactory::create(
         assert(tile_x < props.m_tile_count_x);
         assert(tile_y < props.m_tile_count_y);
 
+        if (!frame.overlaps_crop_window(tile_x, tile_y))
+            continue;
+
         // Create the tile job.
         tile_jobs.push_back(
             new TileJob(
@@ -93,6 +99,8 @@ void TileJobFactory::create(
                 thread_count,
                 pass_hash,
                 spectrum_mode,
+                job_queue,
+                sub_tile_count,
                 abort_switch));
     }
 }
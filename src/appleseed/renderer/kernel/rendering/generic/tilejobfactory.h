@@ -44,6 +44,7 @@
 // Forward declarations.
 namespace foundation    { class CanvasProperties; }
 namespace foundation    { class IAbortSwitch; }
+namespace foundation    { class JobQueue; }
 namespace renderer      { class Frame; }
 namespace renderer      { class TileJob; }
 
@@ -68,7 +69,9 @@ class TileJobFactory
         RandomOrdering
     };
 
-    // Create tile jobs for a given frame.
+    // Create tile jobs for a given frame. If job_queue is not null, tile jobs
+    // may split their tile and schedule sub-tile jobs into it, and always split
+    // it into about sub_tile_count sub-tiles if sub_tile_count is greater than 1.
     void create(
         const Frame&                        frame,
         const TileOrdering                  tile_ordering,
@@ -78,6 +81,8 @@ class TileJobFactory
         const std::uint32_t                 pass_hash,
         const Spectrum::Mode                spectrum_mode,
         TileJobVector&                      tile_jobs,
+        foundation::JobQueue*               job_queue,
+        const size_t                        sub_tile_count,
         foundation::IAbortSwitch&           abort_switch);
 
   private:
@@ -35,28 +35,63 @@
 #include "renderer/modeling/frame/frame.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/analysis.h"
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/color.h"
 #include "foundation/image/image.h"
 #include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/utility/hardwarecounters.h"
 #include "foundation/utility/job/iabortswitch.h"
 
 // Boost headers.
+#include "boost/atomic/atomic.hpp"
 #include "boost/chrono/duration.hpp"
 
+// Standard headers.
+#include <cassert>
+
 using namespace foundation;
 
 namespace renderer
 {
 
-GlobalSampleAccumulationBuffer::GlobalSampleAccumulationBuffer(
+namespace
+{
+    // Return a small integer unique to the calling thread, used to pick a stripe.
+    size_t get_thread_stripe_index()
+    {
+        static boost::atomic<size_t> next_index(0);
+        static APPLESEED_TLS size_t thread_index = ~size_t(0);
+
+        if (thread_index == ~size_t(0))
+            thread_index = next_index++;
+
+        return thread_index;
+    }
+}
+
+GlobalSampleAccumulationBuffer::Stripe::Stripe(
     const size_t    width,
     const size_t    height)
   : m_fb(width, height, 3)
 {
 }
 
+GlobalSampleAccumulationBuffer::GlobalSampleAccumulationBuffer(
+    const size_t    width,
+    const size_t    height,
+    const size_t    stripe_count)
+{
+    assert(stripe_count > 0);
+
+    for (size_t i = 0; i < stripe_count; ++i)
+        m_stripes.emplace_back(new Stripe(width, height));
+
+    m_tracked_memory.set_size(stripe_count * m_stripes[0]->m_fb.get_memory_size());
+}
+
 void GlobalSampleAccumulationBuffer::clear()
 {
     // Request exclusive access.
@@ -64,7 +99,8 @@ void GlobalSampleAccumulationBuffer::clear()
 
     m_sample_count = 0;
 
-    m_fb.clear();
+    for (const std::unique_ptr<Stripe>& stripe : m_stripes)
+        stripe->m_fb.clear();
 }
 
 void GlobalSampleAccumulationBuffer::store_samples(
@@ -72,6 +108,8 @@ void GlobalSampleAccumulationBuffer::store_samples(
     const Sample    samples[],
     IAbortSwitch&   abort_switch)
 {
+    APPLESEED_HARDWARE_COUNTERS_SCOPE("accumulation");
+
     // Request non-exclusive access.
     boost::shared_lock<boost::shared_mutex> lock(m_mutex, boost::defer_lock);
     while (true)
@@ -82,6 +120,18 @@ void GlobalSampleAccumulationBuffer::store_samples(
             break;
     }
 
+    if (m_stripes.size() == 1)
+        store_samples_atomic(sample_count, samples, abort_switch);
+    else store_samples_striped(sample_count, samples, abort_switch);
+}
+
+void GlobalSampleAccumulationBuffer::store_samples_atomic(
+    const size_t    sample_count,
+    const Sample    samples[],
+    IAbortSwitch&   abort_switch)
+{
+    AccumulatorTile& fb = m_stripes[0]->m_fb;
+
     size_t counter = 0;
 
     const Sample* sample_end = samples + sample_count;
@@ -90,7 +140,49 @@ void GlobalSampleAccumulationBuffer::store_samples(
         if ((counter++ & 4096) == 0 && abort_switch.is_aborted())
             return;
 
-        m_fb.atomic_add(Vector2u(s->m_pixel_coords), &s->m_color[0]);
+        fb.atomic_add(Vector2u(s->m_pixel_coords), &s->m_color[0]);
+    }
+}
+
+void GlobalSampleAccumulationBuffer::store_samples_striped(
+    const size_t    sample_count,
+    const Sample    samples[],
+    IAbortSwitch&   abort_switch)
+{
+    const size_t stripe_count = m_stripes.size();
+    const size_t home_index = get_thread_stripe_index() % stripe_count;
+
+    // Prefer the stripe of this thread, but don't wait if another stripe is free.
+    Stripe* stripe = nullptr;
+    boost::mutex::scoped_lock stripe_lock;
+    for (size_t i = 0; i < stripe_count; ++i)
+    {
+        Stripe* candidate = m_stripes[(home_index + i) % stripe_count].get();
+        boost::mutex::scoped_lock candidate_lock(candidate->m_mutex, boost::try_to_lock);
+        if (candidate_lock.owns_lock())
+        {
+            stripe = candidate;
+            stripe_lock.swap(candidate_lock);
+            break;
+        }
+    }
+
+    if (stripe == nullptr)
+    {
+        stripe = m_stripes[home_index].get();
+        boost::mutex::scoped_lock home_lock(stripe->m_mutex);
+        stripe_lock.swap(home_lock);
+    }
+
+    size_t counter = 0;
+
+    const Sample* sample_end = samples + sample_count;
+    for (const Sample* s = samples; s < sample_end; ++s)
+    {
+        if ((counter++ & 4096) == 0 && abort_switch.is_aborted())
+            return;
+
+        stripe->m_fb.add(Vector2u(s->m_pixel_coords), &s->m_color[0]);
     }
 }
 
@@ -111,8 +203,8 @@ void GlobalSampleAccumulationBuffer::develop_to_frame(
     Image& image = frame.image();
     const CanvasProperties& frame_props = image.properties();
 
-    assert(frame_props.m_canvas_width == m_fb.get_width());
-    assert(frame_props.m_canvas_height == m_fb.get_height());
+    assert(frame_props.m_canvas_width == m_stripes[0]->m_fb.get_width());
+    assert(frame_props.m_canvas_height == m_stripes[0]->m_fb.get_height());
     assert(frame_props.m_channel_count == 4);
 
     const float scale = 1.0f / m_sample_count;
@@ -124,6 +216,10 @@ void GlobalSampleAccumulationBuffer::develop_to_frame(
             if (abort_switch.is_aborted())
                 return;
 
+            // Don't allocate tiles outside the crop window.
+            if (!frame.overlaps_crop_window(tx, ty))
+                continue;
+
             Tile& tile = image.tile(tx, ty);
 
             const size_t x = tx * frame_props.m_tile_width;
@@ -134,6 +230,78 @@ void GlobalSampleAccumulationBuffer::develop_to_frame(
     }
 }
 
+void GlobalSampleAccumulationBuffer::develop_dirty_tiles_to_frame(
+    Frame&                  frame,
+    std::vector<size_t>&    dirty_tiles,
+    IAbortSwitch&           abort_switch)
+{
+    develop_to_frame(frame, abort_switch);
+
+    const CanvasProperties& frame_props = frame.image().properties();
+
+    dirty_tiles.clear();
+
+    for (size_t ty = 0; ty < frame_props.m_tile_count_y; ++ty)
+    {
+        for (size_t tx = 0; tx < frame_props.m_tile_count_x; ++tx)
+        {
+            if (frame.overlaps_crop_window(tx, ty))
+                dirty_tiles.push_back(ty * frame_props.m_tile_count_x + tx);
+        }
+    }
+}
+
+void GlobalSampleAccumulationBuffer::update_analysis(
+    const Frame&            frame,
+    TiledImageAnalysis&     analysis,
+    IAbortSwitch&           abort_switch)
+{
+    // Request exclusive access.
+    boost::unique_lock<boost::shared_mutex> lock(m_mutex, boost::defer_lock);
+    while (true)
+    {
+        if (abort_switch.is_aborted())
+            return;
+        if (lock.try_lock_for(boost::chrono::milliseconds(5)))
+            break;
+    }
+
+    const CanvasProperties& frame_props = frame.image().properties();
+
+    assert(frame_props.m_canvas_width == m_stripes[0]->m_fb.get_width());
+    assert(frame_props.m_canvas_height == m_stripes[0]->m_fb.get_height());
+
+    const float scale = 1.0f / m_sample_count;
+
+    for (size_t ty = 0; ty < frame_props.m_tile_count_y; ++ty)
+    {
+        for (size_t tx = 0; tx < frame_props.m_tile_count_x; ++tx)
+        {
+            if (abort_switch.is_aborted())
+                return;
+
+            if (!frame.overlaps_crop_window(tx, ty))
+                continue;
+
+            Tile tile(
+                frame_props.get_tile_width(tx),
+                frame_props.get_tile_height(ty),
+                4,
+                PixelFormatFloat);
+
+            develop_to_tile(
+                tile,
+                tx * frame_props.m_tile_width,
+                ty * frame_props.m_tile_height,
+                tx,
+                ty,
+                scale);
+
+            analysis.update_tile(tx, ty, tile);
+        }
+    }
+}
+
 void GlobalSampleAccumulationBuffer::increment_sample_count(const std::uint64_t delta_sample_count)
 {
     m_sample_count += delta_sample_count;
@@ -149,14 +317,22 @@ void GlobalSampleAccumulationBuffer::develop_to_tile(
 {
     const size_t tile_width = tile.get_width();
     const size_t tile_height = tile.get_height();
+    const size_t stripe_count = m_stripes.size();
 
     for (size_t y = 0; y < tile_height; ++y)
     {
         for (size_t x = 0; x < tile_width; ++x)
         {
-            const float* ptr = m_fb.pixel(origin_x + x, origin_y + y);
+            // Sum the contributions of all stripes.
+            Color4f color(0.0f, 0.0f, 0.0f, 1.0f);
+            for (size_t i = 0; i < stripe_count; ++i)
+            {
+                const float* ptr = m_stripes[i]->m_fb.pixel(origin_x + x, origin_y + y);
+                color[0] += ptr[1];
+                color[1] += ptr[2];
+                color[2] += ptr[3];
+            }
 
-            Color4f color(ptr[1], ptr[2], ptr[3], 1.0f);
             color.rgb() *= scale;
 
             tile.set_pixel(x, y, color);
@@ -40,16 +40,29 @@
 // Standard headers.
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
 namespace foundation    { class Tile; }
+namespace foundation    { class TiledImageAnalysis; }
 namespace renderer      { class Frame; }
 namespace renderer      { class Sample; }
 
 namespace renderer
 {
 
+//
+// A sample accumulation buffer covering the whole frame, used by sample generators
+// that splat samples anywhere in the frame.
+//
+// With a single stripe, samples are accumulated with atomic additions into a single
+// frame buffer. With more stripes, each thread accumulates into its own copy of the
+// frame buffer (threads are distributed round-robin across stripes) and stripes are
+// only summed when the buffer is developed, trading memory for less contention.
+//
+
 class GlobalSampleAccumulationBuffer
   : public SampleAccumulationBuffer
 {
@@ -57,7 +70,8 @@ class GlobalSampleAccumulationBuffer
     // Constructor.
     GlobalSampleAccumulationBuffer(
         const size_t                width,
-        const size_t                height);
+        const size_t                height,
+        const size_t                stripe_count = 1);
 
     // Reset the buffer to its initial state. Thread-safe.
     void clear() override;
@@ -73,12 +87,44 @@ class GlobalSampleAccumulationBuffer
         Frame&                      frame,
         foundation::IAbortSwitch&   abort_switch) override;
 
+    // Samples can be splatted anywhere, so all tiles are developed. Thread-safe.
+    void develop_dirty_tiles_to_frame(
+        Frame&                      frame,
+        std::vector<size_t>&        dirty_tiles,
+        foundation::IAbortSwitch&   abort_switch) override;
+
+    // Samples can be splatted anywhere, so all tiles are analyzed. Thread-safe.
+    void update_analysis(
+        const Frame&                    frame,
+        foundation::TiledImageAnalysis& analysis,
+        foundation::IAbortSwitch&       abort_switch) override;
+
     // Increment the number of samples used for pixel values renormalization. Thread-safe.
     void increment_sample_count(const std::uint64_t delta_sample_count);
 
   private:
+    struct Stripe
+    {
+        boost::mutex                m_mutex;
+        foundation::AccumulatorTile m_fb;
+
+        Stripe(
+            const size_t            width,
+            const size_t            height);
+    };
+
     boost::shared_mutex             m_mutex;
-    foundation::AccumulatorTile     m_fb;
+    std::vector<std::unique_ptr<Stripe>> m_stripes;
+
+    void store_samples_atomic(
+        const size_t                sample_count,
+        const Sample                samples[],
+        foundation::IAbortSwitch&   abort_switch);
+
+    void store_samples_striped(
+        const size_t                sample_count,
+        const Sample                samples[],
+        foundation::IAbortSwitch&   abort_switch);
 
     void develop_to_tile(
         foundation::Tile&           tile,
@@ -31,6 +31,10 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/iunknown.h"
+#include "foundation/utility/statistics.h"
+
+// Standard headers.
+#include <cstddef>
 
 // Forward declarations.
 namespace renderer { class IRendererController; }
@@ -65,6 +69,15 @@ class IFrameRenderer
     virtual void pause_rendering() = 0;
     virtual void resume_rendering() = 0;
     virtual void terminate_rendering() = 0;
+
+    // Change the number of rendering threads during asynchronous rendering, without
+    // restarting it. The count is clamped to the number of threads the frame renderer
+    // was created with, and 0 means all of them. Threads beyond the count are parked
+    // at job boundaries.
+    virtual void set_active_thread_count(const size_t thread_count) = 0;
+
+    // Return the statistics accumulated by the rendering threads of this frame renderer.
+    virtual foundation::StatisticsVector get_statistics() const = 0;
 };
 
 
@@ -35,6 +35,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 namespace renderer
 {
 
@@ -96,6 +99,11 @@ class APPLESEED_DLLSYMBOL IRendererController
 
     // Return the current rendering status.
     virtual Status get_status() const = 0;
+
+    // Return the number of rendering threads that should be running, or 0 to run
+    // all of them. This method is called continuously during rendering, allowing
+    // to shrink or grow the number of rendering threads without restarting.
+    virtual size_t get_active_thread_count() const = 0;
 };
 
 }   // namespace renderer
@@ -0,0 +1,64 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "isamplerenderer.h"
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/pixelcontext.h"
+#include "renderer/kernel/shading/shadingresult.h"
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// ISampleRenderer class implementation.
+//
+
+void ISampleRenderer::render_samples(
+    const size_t                count,
+    SamplingContext             sampling_contexts[],
+    const PixelContext          pixel_contexts[],
+    const Vector2d              image_points[],
+    AOVAccumulatorContainer&    aov_accumulators,
+    ShadingResult               shading_results[])
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        render_sample(
+            sampling_contexts[i],
+            pixel_contexts[i],
+            image_points[i],
+            aov_accumulators,
+            shading_results[i]);
+    }
+}
+
+}   // namespace renderer
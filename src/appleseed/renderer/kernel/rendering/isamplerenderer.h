@@ -68,6 +68,17 @@ class ISampleRenderer
         AOVAccumulatorContainer&        aov_accumulators,
         ShadingResult&                  shading_result) = 0;
 
+    // Render a batch of samples. This is equivalent to calling render_sample() for each
+    // sample in order, but lets implementations group work such as primary ray generation
+    // and tracing across samples. The default implementation calls render_sample().
+    virtual void render_samples(
+        const size_t                    count,
+        SamplingContext                 sampling_contexts[],
+        const PixelContext              pixel_contexts[],
+        const foundation::Vector2d      image_points[],
+        AOVAccumulatorContainer&        aov_accumulators,
+        ShadingResult                   shading_results[]);
+
     // Retrieve performance statistics.
     virtual foundation::StatisticsVector get_statistics() const = 0;
 };
@@ -49,6 +49,10 @@ class IShadingResultFrameBufferFactory
   public:
     virtual void clear() = 0;
 
+    // Return true if framebuffers for disjoint parts of a same tile can be
+    // created and used concurrently.
+    virtual bool supports_sub_tiles() const = 0;
+
     virtual ShadingResultFrameBuffer* create(
         const Frame&                frame,
         const std::size_t           tile_x,
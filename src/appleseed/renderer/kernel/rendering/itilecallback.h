@@ -92,9 +92,43 @@ class APPLESEED_DLLSYMBOL ITileCallback
         const std::uint64_t     samples,
         const double            samples_per_pixel,
         const std::uint64_t     samples_per_second) = 0;
+
+    // This method is called after some tiles of the frame have been updated; the other
+    // tiles did not change since the previous update. Tiles are identified by their index
+    // tile_y * tile_count_x + tile_x. By default, the whole frame is considered updated.
+    virtual void on_progressive_tiles_update(
+        const Frame&            frame,
+        const size_t*           tile_indices,
+        const size_t            tile_count,
+        const double            time,
+        const std::uint64_t     samples,
+        const double            samples_per_pixel,
+        const std::uint64_t     samples_per_second);
 };
 
 
+//
+// ITileCallback class implementation.
+//
+
+inline void ITileCallback::on_progressive_tiles_update(
+    const Frame&                frame,
+    const size_t*               tile_indices,
+    const size_t                tile_count,
+    const double                time,
+    const std::uint64_t         samples,
+    const double                samples_per_pixel,
+    const std::uint64_t         samples_per_second)
+{
+    on_progressive_frame_update(
+        frame,
+        time,
+        samples,
+        samples_per_pixel,
+        samples_per_second);
+}
+
+
 //
 // Interface of a ITileCallback factory that can cross DLL boundaries.
 //
@@ -31,8 +31,10 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/iunknown.h"
+#include "foundation/math/aabb.h"
 
 // Standard headers.
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 
@@ -63,6 +65,20 @@ class ITileRenderer
         const std::uint32_t         pass_hash,
         foundation::IAbortSwitch&   abort_switch) = 0;
 
+    // Return true if this renderer can render disjoint parts of a tile independently,
+    // possibly concurrently with other threads rendering other parts of the same tile.
+    virtual bool supports_sub_tiles() const;
+
+    // Render a part of a tile, expressed in tile space (inclusive on all sides).
+    // Only called if supports_sub_tiles() returns true.
+    virtual void render_sub_tile(
+        const Frame&                frame,
+        const size_t                tile_x,
+        const size_t                tile_y,
+        const foundation::AABB2u&   rect,
+        const std::uint32_t         pass_hash,
+        foundation::IAbortSwitch&   abort_switch);
+
     // Retrieve performance statistics.
     virtual foundation::StatisticsVector get_statistics() const = 0;
 };
@@ -80,4 +96,25 @@ class ITileRendererFactory
     virtual ITileRenderer* create(const size_t thread_index) = 0;
 };
 
+
+//
+// ITileRenderer class implementation.
+//
+
+inline bool ITileRenderer::supports_sub_tiles() const
+{
+    return false;
+}
+
+inline void ITileRenderer::render_sub_tile(
+    const Frame&                    frame,
+    const size_t                    tile_x,
+    const size_t                    tile_y,
+    const foundation::AABB2u&       rect,
+    const std::uint32_t             pass_hash,
+    foundation::IAbortSwitch&       abort_switch)
+{
+    assert(!"This tile renderer does not support sub-tiles.");
+}
+
 }   // namespace renderer
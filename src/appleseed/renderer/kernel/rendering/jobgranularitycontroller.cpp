@@ -0,0 +1,148 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "jobgranularitycontroller.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/string/string.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// JobGranularityController class implementation.
+//
+
+namespace
+{
+    // Number of jobs the average duration of jobs must be measured on before acting upon it.
+    const std::uint64_t MinJobCountPerUpdate = 8;
+
+    // Bounds of the factor by which the job size may change in a single update.
+    const double MinResizeFactor = 0.5;
+    const double MaxResizeFactor = 2.0;
+
+    // Jobs whose average duration is within this factor of the target are left alone.
+    const double Tolerance = 1.25;
+
+    // Jobs are not made smaller once waiting for them takes this fraction of their duration.
+    const double MaxWaitToJobTimeRatio = 0.1;
+}
+
+JobGranularityController::JobGranularityController(
+    const double            target_job_duration,
+    const std::uint64_t     min_job_size,
+    const std::uint64_t     max_job_size,
+    const std::uint64_t     initial_job_size)
+  : m_target_job_duration(target_job_duration)
+  , m_min_job_size(std::max<std::uint64_t>(min_job_size, 1))
+  , m_max_job_size(std::max(max_job_size, m_min_job_size))
+  , m_job_size(clamp(initial_job_size, m_min_job_size, m_max_job_size))
+  , m_resize_count(0)
+{
+    assert(target_job_duration > 0.0);
+}
+
+bool JobGranularityController::update(const JobManager::Timings& timings)
+{
+    m_pending.m_job_count += timings.m_job_count;
+    m_pending.m_job_time += timings.m_job_time;
+    m_pending.m_wait_time += timings.m_wait_time;
+
+    if (m_pending.m_job_count < MinJobCountPerUpdate)
+        return false;
+
+    const double avg_job_time = m_pending.m_job_time / m_pending.m_job_count;
+    const double avg_wait_time = m_pending.m_wait_time / m_pending.m_job_count;
+
+    m_total.m_job_count += m_pending.m_job_count;
+    m_total.m_job_time += m_pending.m_job_time;
+    m_total.m_wait_time += m_pending.m_wait_time;
+    m_pending = JobManager::Timings();
+
+    // Jobs too short to be timed can only be too small.
+    double factor =
+        avg_job_time > 0.0
+            ? clamp(m_target_job_duration / avg_job_time, MinResizeFactor, MaxResizeFactor)
+            : MaxResizeFactor;
+
+    if (factor < Tolerance && factor > 1.0 / Tolerance)
+        return false;
+
+    if (factor < 1.0 && avg_wait_time > MaxWaitToJobTimeRatio * avg_job_time)
+        return false;
+
+    const std::uint64_t job_size = m_job_size.load();
+    const std::uint64_t new_job_size =
+        clamp(
+            static_cast<std::uint64_t>(std::llround(job_size * factor)),
+            m_min_job_size,
+            m_max_job_size);
+
+    if (new_job_size == job_size)
+        return false;
+
+    m_job_size.store(new_job_size);
+    ++m_resize_count;
+
+    return true;
+}
+
+std::uint64_t JobGranularityController::get_job_size() const
+{
+    return m_job_size.load();
+}
+
+Statistics JobGranularityController::get_statistics() const
+{
+    Statistics stats;
+    stats.insert("job size", m_job_size.load());
+    stats.insert("job size range", pretty_uint(m_min_job_size) + " to " + pretty_uint(m_max_job_size));
+    stats.insert("resizes", m_resize_count);
+    stats.insert_time("target duration", m_target_job_duration);
+
+    if (m_total.m_job_count > 0)
+    {
+        stats.insert("timed jobs", m_total.m_job_count);
+        stats.insert_time("avg. job duration", m_total.m_job_time / m_total.m_job_count);
+        stats.insert_time("avg. queue wait", m_total.m_wait_time / m_total.m_job_count);
+    }
+
+    return stats;
+}
+
+}   // namespace renderer
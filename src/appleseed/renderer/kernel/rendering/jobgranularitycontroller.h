@@ -0,0 +1,86 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/statistics.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+
+// Standard headers.
+#include <cstdint>
+
+namespace renderer
+{
+
+//
+// Resizes rendering jobs so that their average duration, as measured by the job manager,
+// converges toward a target duration. Jobs that are too small spend a large share of their
+// time in scheduling overhead while jobs that are too large hurt interactivity and the load
+// balance at the end of a frame.
+//
+// The size of a job is expressed in renderer-defined work units (samples, pixels, etc.) and
+// the duration of a job is assumed to be roughly proportional to its size.
+//
+
+class JobGranularityController
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    JobGranularityController(
+        const double                        target_job_duration,    // in seconds
+        const std::uint64_t                 min_job_size,
+        const std::uint64_t                 max_job_size,
+        const std::uint64_t                 initial_job_size);
+
+    // Resize jobs from timings accumulated since the previous update. Timings spanning too
+    // few jobs are kept for the next update. Return true if the job size has changed.
+    bool update(const foundation::JobManager::Timings& timings);
+
+    // Return the current job size. Thread-safe.
+    std::uint64_t get_job_size() const;
+
+    // Return the current job size and the timings it is based on. Not thread-safe with update().
+    foundation::Statistics get_statistics() const;
+
+  private:
+    const double                            m_target_job_duration;
+    const std::uint64_t                     m_min_job_size;
+    const std::uint64_t                     m_max_job_size;
+    boost::atomic<std::uint64_t>            m_job_size;
+    foundation::JobManager::Timings         m_pending;  // timings not yet acted upon
+    foundation::JobManager::Timings         m_total;    // timings of all updates
+    std::uint64_t                           m_resize_count;
+};
+
+}   // namespace renderer
@@ -37,7 +37,9 @@
 #include "renderer/modeling/frame/frame.h"
 
 // appleseed.foundation headers.
+#include "foundation/hash/hash.h"
 #include "foundation/image/accumulatortile.h"
+#include "foundation/image/analysis.h"
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/color.h"
 #include "foundation/image/image.h"
@@ -47,12 +49,15 @@
 #include "foundation/platform/atomic.h"
 #include "foundation/platform/timers.h"
 #include "foundation/platform/types.h"
+#include "foundation/utility/hardwarecounters.h"
 #include "foundation/utility/job/iabortswitch.h"
 #include "foundation/utility/stopwatch.h"
 
 // Standard headers.
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <limits>
 
 using namespace boost;
 using namespace foundation;
@@ -77,12 +82,83 @@ namespace renderer
 //   pushing samples to and the level that is displayed. As soon as a level contains enough
 //   samples, it becomes the new active level.
 //
+//   When the sample generator renders coarse passes first (one sample per block of pixels),
+//   the switch to a level is delayed until the coarse passes of lower resolution than that
+//   level are complete, so that levels are only displayed once all their pixels got samples.
+//   Samples of coarse passes are stored at every level like any other sample.
+//
+// For incremental display updates, the full resolution level is also divided into square
+// blocks of pixels that are flagged when they receive samples. Only the tiles of the frame
+// overlapping flagged blocks need to be developed again.
+//
+// When convergence tracking is enabled, the crop window is additionally divided into
+// square blocks of pixels. A random half of the samples is also stored into a second full
+// resolution level, and the noise of a block is estimated by comparing the two full resolution levels,
+// using the same metric as the adaptive tile renderer. Blocks whose noise level falls below
+// the threshold are retired: sample generators query is_converged() and stop sending samples
+// there, so that subsequent samples concentrate on the regions that are still noisy. The
+// average noise level of each block is kept to report the error of the whole crop window.
+//
 
 // #define PRINT_DETAILED_PERF_REPORTS
 
+namespace
+{
+    // Size in pixels of the blocks used for convergence tracking.
+    const size_t ConvergenceBlockSize = 16;
+
+    // Size in pixels of the blocks used for dirty tracking.
+    const size_t DirtyBlockSize = 16;
+
+    // Consumers of dirty tiles.
+    const std::uint8_t DisplayDirtyFlag = 1UL << 0;     // develop_dirty_tiles_to_frame()
+    const std::uint8_t AnalysisDirtyFlag = 1UL << 1;    // update_analysis()
+    const std::uint8_t AllDirtyFlags = DisplayDirtyFlag | AnalysisDirtyFlag;
+
+    // Compute the noise level of a pixel given its values in the full resolution level
+    // and in the level that received half of the samples (Dammertz et al. 2010).
+    float compute_pixel_error(
+        const float*    main,
+        const float*    half)
+    {
+        const float main_weight = *main++;
+        const float half_weight = *half++;
+
+        // No estimate can be made until both levels received samples.
+        if (main_weight == 0.0f || half_weight == 0.0f)
+            return std::numeric_limits<float>::max();
+
+        const float rcp_main_weight = 1.0f / main_weight;
+        const float rcp_half_weight = 1.0f / half_weight;
+
+        const Color3f main_color(main[0] * rcp_main_weight, main[1] * rcp_main_weight, main[2] * rcp_main_weight);
+        const Color3f half_color(half[0] * rcp_half_weight, half[1] * rcp_half_weight, half[2] * rcp_half_weight);
+
+        const float rgb = std::abs(main_color.r) + std::abs(main_color.g) + std::abs(main_color.b);
+
+        if (rgb == 0.0f)
+            return 0.0f;
+
+        return
+            (std::abs(main_color.r - half_color.r) +
+             std::abs(main_color.g - half_color.g) +
+             std::abs(main_color.b - half_color.b)) / std::sqrt(rgb);
+    }
+}
+
 LocalSampleAccumulationBuffer::LocalSampleAccumulationBuffer(
     const size_t        width,
     const size_t        height)
+  : m_block_count_x(0)
+  , m_block_count(0)
+  , m_noise_threshold(0.0f)
+  , m_min_samples(0)
+  , m_average_error(std::numeric_limits<float>::max())
+  , m_max_error(std::numeric_limits<float>::max())
+  , m_dirty_block_count_x((width + DirtyBlockSize - 1) / DirtyBlockSize)
+  , m_dirty_block_count_y((height + DirtyBlockSize - 1) / DirtyBlockSize)
+  , m_developed_level(~std::uint32_t(0))
+  , m_analyzed_level(~std::uint32_t(0))
 {
     const size_t MinSize = 32;
 
@@ -104,7 +180,14 @@ LocalSampleAccumulationBuffer::LocalSampleAccumulationBuffer(
         level_height = std::max(level_height / 2, MinSize);
     }
 
+    m_level_delays.assign(m_levels.size(), 0);
     m_remaining_pixels = new boost::atomic<std::int32_t>[m_levels.size()];
+    m_dirty_blocks.reset(new boost::atomic<std::uint8_t>[m_dirty_block_count_x * m_dirty_block_count_y]);
+
+    size_t memory_size = 0;
+    for (size_t i = 0, e = m_levels.size(); i < e; ++i)
+        memory_size += m_levels[i]->get_memory_size();
+    m_tracked_memory.set_size(memory_size);
 
     clear();
 }
@@ -117,6 +200,62 @@ LocalSampleAccumulationBuffer::~LocalSampleAccumulationBuffer()
         delete m_levels[i];
 }
 
+void LocalSampleAccumulationBuffer::enable_convergence_tracking(
+    const AABB2u&       crop_window,
+    const float         noise_threshold,
+    const size_t        min_samples)
+{
+    assert(crop_window.is_valid());
+    assert(crop_window.max.x < m_levels[0]->get_width());
+    assert(crop_window.max.y < m_levels[0]->get_height());
+    assert(noise_threshold >= 0.0f);
+
+    m_crop_window = crop_window;
+    m_noise_threshold = noise_threshold;
+    m_min_samples = std::max<size_t>(min_samples, 1);
+
+    m_block_count_x = (crop_window.extent(0) + ConvergenceBlockSize - 1) / ConvergenceBlockSize;
+    const size_t block_count_y = (crop_window.extent(1) + ConvergenceBlockSize - 1) / ConvergenceBlockSize;
+    m_block_count = m_block_count_x * block_count_y;
+
+    const size_t previous_half_level_size = m_half_level ? m_half_level->get_memory_size() : 0;
+
+    m_half_level.reset(
+        new AccumulatorTile(
+            m_levels[0]->get_width(),
+            m_levels[0]->get_height(),
+            4));
+    m_block_converged.reset(new boost::atomic<bool>[m_block_count]);
+    m_block_errors.reset(new float[m_block_count]);
+
+    m_tracked_memory.set_size(
+        m_tracked_memory.get_size() - previous_half_level_size + m_half_level->get_memory_size());
+
+    clear();
+}
+
+void LocalSampleAccumulationBuffer::set_coarse_passes(const std::vector<CoarsePass>& passes)
+{
+    const size_t width = m_levels[0]->get_width();
+
+    for (size_t i = 0, e = m_levels.size(); i < e; ++i)
+    {
+        // Size of the blocks of pixels covered by a single pixel of this level.
+        const size_t level_block_size = size_t(1) << log2_int(width / m_levels[i]->get_width());
+
+        size_t delay = 0;
+        for (const CoarsePass& pass : passes)
+        {
+            if (pass.m_block_size > level_block_size)
+                delay += pass.m_sample_count;
+        }
+
+        m_level_delays[i] = static_cast<std::int32_t>(delay);
+    }
+
+    clear();
+}
+
 void LocalSampleAccumulationBuffer::clear()
 {
 #ifdef PRINT_DETAILED_PERF_REPORTS
@@ -139,10 +278,38 @@ void LocalSampleAccumulationBuffer::clear()
         m_levels[i]->clear();
 
         m_remaining_pixels[i] =
-            static_cast<std::int32_t>(m_levels[i]->get_pixel_count());
+            static_cast<std::int32_t>(m_levels[i]->get_pixel_count()) + m_level_delays[i];
     }
 
     m_active_level = static_cast<std::uint32_t>(m_levels.size() - 1);
+
+    // Force the next incremental develop and analysis to process all tiles.
+    m_developed_level = ~std::uint32_t(0);
+    m_analyzed_level = ~std::uint32_t(0);
+    for (size_t i = 0, e = m_dirty_block_count_x * m_dirty_block_count_y; i < e; ++i)
+        m_dirty_blocks[i] = 0;
+
+    if (m_half_level)
+    {
+        m_half_level->clear();
+
+        for (size_t i = 0; i < m_block_count; ++i)
+        {
+            m_block_converged[i] = false;
+            m_block_errors[i] = std::numeric_limits<float>::max();
+        }
+
+        m_converged_block_count = 0;
+
+        {
+            Spinlock::ScopedLock error_lock(m_error_spinlock);
+            m_average_error = std::numeric_limits<float>::max();
+            m_max_error = std::numeric_limits<float>::max();
+        }
+
+        // Don't bother estimating noise levels before each pixel may have received enough samples.
+        m_next_convergence_update = m_crop_window.volume() * m_min_samples;
+    }
 }
 
 void LocalSampleAccumulationBuffer::store_samples(
@@ -150,6 +317,8 @@ void LocalSampleAccumulationBuffer::store_samples(
     const Sample            samples[],
     IAbortSwitch&           abort_switch)
 {
+    APPLESEED_HARDWARE_COUNTERS_SCOPE("accumulation");
+
 #ifdef PRINT_DETAILED_PERF_REPORTS
     Stopwatch<DefaultWallclockTimer> sw(0);
     sw.start();
@@ -193,11 +362,43 @@ void LocalSampleAccumulationBuffer::store_samples(
             }
         }
 
+        // Store a random half of the samples into the level used for noise estimation.
+        // Sample generators tend to visit a given pixel at sample indices of the same
+        // parity, so we can't simply store every other sample.
+        if (m_half_level)
+        {
+            const std::uint32_t base = static_cast<std::uint32_t>(m_sample_count);
+            for (size_t i = 0; i < sample_count; ++i)
+            {
+                if ((hash_uint32(base + static_cast<std::uint32_t>(i)) & 1) == 0)
+                    continue;
+
+                const Sample& s = samples[i];
+                m_half_level->atomic_add(
+                    Vector2u(
+                        static_cast<size_t>(s.m_pixel_coords.x),
+                        static_cast<size_t>(s.m_pixel_coords.y)),
+                    &s.m_color[0]);
+            }
+        }
+
+        mark_blocks_dirty(sample_count, samples);
+
         m_lock.unlock_read();
     }
 
     m_sample_count += sample_count;
 
+    // Periodically reevaluate the convergence of the blocks of pixels, roughly every time
+    // the buffer has received an additional sample per pixel. Only one thread does it.
+    if (m_half_level)
+    {
+        std::uint64_t next_update = m_next_convergence_update;
+        if (m_sample_count >= next_update &&
+            m_next_convergence_update.compare_exchange_strong(next_update, m_sample_count + m_crop_window.volume()))
+            update_block_convergence(abort_switch);
+    }
+
 #ifdef PRINT_DETAILED_PERF_REPORTS
     sw.measure();
     RENDERER_LOG_DEBUG("store_samples: " FMT_SIZE_T " -> %f", sample_count, sw.get_seconds() * 1000.0);
@@ -252,15 +453,11 @@ void LocalSampleAccumulationBuffer::develop_to_frame(
     RENDERER_LOG_DEBUG("develop_to_frame: acquiring lock: %f", t1 * 1000.0);
 #endif
 
-    Image& color_image = frame.image();
-
-    const CanvasProperties& frame_props = color_image.properties();
+    const CanvasProperties& frame_props = frame.image().properties();
     assert(frame_props.m_canvas_width == m_levels[0]->get_width());
     assert(frame_props.m_canvas_height == m_levels[0]->get_height());
     assert(frame_props.m_channel_count == 4);
 
-    const AABB2u& crop_window = frame.get_crop_window();
-
     const AccumulatorTile& level = *m_levels[m_active_level];
 
     for (size_t ty = 0; ty < frame_props.m_tile_count_y; ++ty)
@@ -273,24 +470,9 @@ void LocalSampleAccumulationBuffer::develop_to_frame(
                 return;
             }
 
-            const size_t origin_x = tx * frame_props.m_tile_width;
-            const size_t origin_y = ty * frame_props.m_tile_height;
-
-            Tile& color_tile = color_image.tile(tx, ty);
-
-            const AABB2u tile_rect(
-                Vector2u(origin_x, origin_y),
-                Vector2u(origin_x + color_tile.get_width() - 1, origin_y + color_tile.get_height() - 1));
-
-            const AABB2u rect = AABB2u::intersect(tile_rect, crop_window);
-            develop_to_tile(
-                color_tile,
-                frame_props.m_canvas_width,
-                frame_props.m_canvas_height,
-                level,
-                origin_x,
-                origin_y,
-                rect);
+            // Don't allocate tiles outside the crop window.
+            if (frame.overlaps_crop_window(tx, ty))
+                develop_tile(frame, level, tx, ty);
         }
     }
 
@@ -303,6 +485,361 @@ void LocalSampleAccumulationBuffer::develop_to_frame(
 #endif
 }
 
+void LocalSampleAccumulationBuffer::develop_dirty_tiles_to_frame(
+    Frame&                  frame,
+    std::vector<size_t>&    dirty_tiles,
+    IAbortSwitch&           abort_switch)
+{
+    dirty_tiles.clear();
+
+    // Request exclusive access.
+    while (!m_lock.try_lock_write())
+    {
+        foundation::sleep(5);
+        if (abort_switch.is_aborted())
+            return;
+    }
+
+    const CanvasProperties& frame_props = frame.image().properties();
+    assert(frame_props.m_canvas_width == m_levels[0]->get_width());
+    assert(frame_props.m_canvas_height == m_levels[0]->get_height());
+    assert(frame_props.m_channel_count == 4);
+
+    const std::uint32_t active_level = m_active_level;
+    const AccumulatorTile& level = *m_levels[active_level];
+
+    // Pixels of coarser levels span several tiles; develop everything until the full
+    // resolution level is displayed, and once more when switching to it.
+    const bool develop_all = active_level != 0 || m_developed_level != 0;
+    collect_dirty_tiles(frame, DisplayDirtyFlag, develop_all, dirty_tiles);
+
+    m_developed_level = active_level;
+
+    for (const size_t tile_index : dirty_tiles)
+    {
+        if (abort_switch.is_aborted())
+        {
+            // Tiles that were not developed must be developed by the next call.
+            m_developed_level = ~std::uint32_t(0);
+            m_lock.unlock_write();
+            return;
+        }
+
+        develop_tile(
+            frame,
+            level,
+            tile_index % frame_props.m_tile_count_x,
+            tile_index / frame_props.m_tile_count_x);
+    }
+
+    m_lock.unlock_write();
+}
+
+void LocalSampleAccumulationBuffer::update_analysis(
+    const Frame&            frame,
+    TiledImageAnalysis&     analysis,
+    IAbortSwitch&           abort_switch)
+{
+    // Request exclusive access.
+    while (!m_lock.try_lock_write())
+    {
+        foundation::sleep(5);
+        if (abort_switch.is_aborted())
+            return;
+    }
+
+    const CanvasProperties& frame_props = frame.image().properties();
+    assert(frame_props.m_canvas_width == m_levels[0]->get_width());
+    assert(frame_props.m_canvas_height == m_levels[0]->get_height());
+
+    const std::uint32_t active_level = m_active_level;
+    const AccumulatorTile& level = *m_levels[active_level];
+
+    // Same policy as develop_dirty_tiles_to_frame().
+    const bool analyze_all = active_level != 0 || m_analyzed_level != 0;
+    std::vector<size_t> dirty_tiles;
+    collect_dirty_tiles(frame, AnalysisDirtyFlag, analyze_all, dirty_tiles);
+
+    m_analyzed_level = active_level;
+
+    for (const size_t tile_index : dirty_tiles)
+    {
+        if (abort_switch.is_aborted())
+        {
+            // Tiles that were not analyzed must be analyzed by the next call.
+            m_analyzed_level = ~std::uint32_t(0);
+            break;
+        }
+
+        const size_t tile_x = tile_index % frame_props.m_tile_count_x;
+        const size_t tile_y = tile_index / frame_props.m_tile_count_x;
+        const size_t origin_x = tile_x * frame_props.m_tile_width;
+        const size_t origin_y = tile_y * frame_props.m_tile_height;
+
+        // Pixels outside the crop window are left black.
+        Tile tile(
+            frame_props.get_tile_width(tile_x),
+            frame_props.get_tile_height(tile_y),
+            4,
+            PixelFormatFloat);
+        tile.clear(Color4f(0.0f));
+
+        const AABB2u tile_rect(
+            Vector2u(origin_x, origin_y),
+            Vector2u(origin_x + tile.get_width() - 1, origin_y + tile.get_height() - 1));
+
+        develop_to_tile(
+            tile,
+            frame_props.m_canvas_width,
+            frame_props.m_canvas_height,
+            level,
+            origin_x,
+            origin_y,
+            AABB2u::intersect(tile_rect, frame.get_crop_window()));
+
+        analysis.update_tile(tile_x, tile_y, tile);
+    }
+
+    m_lock.unlock_write();
+}
+
+void LocalSampleAccumulationBuffer::mark_blocks_dirty(
+    const size_t            sample_count,
+    const Sample            samples[])
+{
+    for (size_t i = 0; i < sample_count; ++i)
+    {
+        const Sample& s = samples[i];
+        const size_t bx = static_cast<size_t>(s.m_pixel_coords.x) / DirtyBlockSize;
+        const size_t by = static_cast<size_t>(s.m_pixel_coords.y) / DirtyBlockSize;
+        assert(bx < m_dirty_block_count_x);
+        assert(by < m_dirty_block_count_y);
+
+        // Avoid writing to cache lines shared with other threads when the flags are already set.
+        boost::atomic<std::uint8_t>& dirty = m_dirty_blocks[by * m_dirty_block_count_x + bx];
+        if (dirty.load(boost::memory_order_relaxed) != AllDirtyFlags)
+            dirty.store(AllDirtyFlags, boost::memory_order_relaxed);
+    }
+}
+
+bool LocalSampleAccumulationBuffer::is_tile_dirty(
+    const CanvasProperties& frame_props,
+    const size_t            tile_x,
+    const size_t            tile_y,
+    const std::uint8_t      consumer_flag) const
+{
+    const size_t x0 = tile_x * frame_props.m_tile_width;
+    const size_t y0 = tile_y * frame_props.m_tile_height;
+    const size_t x1 = x0 + frame_props.get_tile_width(tile_x) - 1;
+    const size_t y1 = y0 + frame_props.get_tile_height(tile_y) - 1;
+
+    for (size_t by = y0 / DirtyBlockSize, e = y1 / DirtyBlockSize; by <= e; ++by)
+    {
+        for (size_t bx = x0 / DirtyBlockSize, f = x1 / DirtyBlockSize; bx <= f; ++bx)
+        {
+            if ((m_dirty_blocks[by * m_dirty_block_count_x + bx].load(boost::memory_order_relaxed) & consumer_flag) != 0)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+void LocalSampleAccumulationBuffer::collect_dirty_tiles(
+    const Frame&            frame,
+    const std::uint8_t      consumer_flag,
+    const bool              collect_all,
+    std::vector<size_t>&    dirty_tiles)
+{
+    const CanvasProperties& frame_props = frame.image().properties();
+
+    for (size_t ty = 0; ty < frame_props.m_tile_count_y; ++ty)
+    {
+        for (size_t tx = 0; tx < frame_props.m_tile_count_x; ++tx)
+        {
+            if (frame.overlaps_crop_window(tx, ty) &&
+                (collect_all || is_tile_dirty(frame_props, tx, ty, consumer_flag)))
+                dirty_tiles.push_back(ty * frame_props.m_tile_count_x + tx);
+        }
+    }
+
+    // Samples stored from now on will flag their blocks again.
+    const std::uint8_t mask = ~consumer_flag;
+    for (size_t i = 0, e = m_dirty_block_count_x * m_dirty_block_count_y; i < e; ++i)
+        m_dirty_blocks[i].fetch_and(mask, boost::memory_order_relaxed);
+}
+
+void LocalSampleAccumulationBuffer::develop_tile(
+    Frame&                  frame,
+    const AccumulatorTile&  level,
+    const size_t            tile_x,
+    const size_t            tile_y) const
+{
+    Image& color_image = frame.image();
+    const CanvasProperties& frame_props = color_image.properties();
+
+    const size_t origin_x = tile_x * frame_props.m_tile_width;
+    const size_t origin_y = tile_y * frame_props.m_tile_height;
+
+    Tile& color_tile = color_image.tile(tile_x, tile_y);
+
+    const AABB2u tile_rect(
+        Vector2u(origin_x, origin_y),
+        Vector2u(origin_x + color_tile.get_width() - 1, origin_y + color_tile.get_height() - 1));
+
+    const AABB2u rect = AABB2u::intersect(tile_rect, frame.get_crop_window());
+    develop_to_tile(
+        color_tile,
+        frame_props.m_canvas_width,
+        frame_props.m_canvas_height,
+        level,
+        origin_x,
+        origin_y,
+        rect);
+}
+
+bool LocalSampleAccumulationBuffer::is_converged(
+    const size_t            x,
+    const size_t            y) const
+{
+    if (!m_half_level || !m_crop_window.contains(Vector2u(x, y)))
+        return false;
+
+    const size_t bx = (x - m_crop_window.min.x) / ConvergenceBlockSize;
+    const size_t by = (y - m_crop_window.min.y) / ConvergenceBlockSize;
+
+    return m_block_converged[by * m_block_count_x + bx];
+}
+
+bool LocalSampleAccumulationBuffer::is_converged() const
+{
+    return m_half_level && m_converged_block_count == m_block_count;
+}
+
+void LocalSampleAccumulationBuffer::enable_error_estimation(const AABB2u& crop_window)
+{
+    if (!m_half_level)
+        enable_convergence_tracking(crop_window, 0.0f, 1);
+}
+
+bool LocalSampleAccumulationBuffer::get_error_estimate(
+    float&                  average_error,
+    float&                  max_error) const
+{
+    if (!m_half_level)
+        return false;
+
+    Spinlock::ScopedLock lock(m_error_spinlock);
+    average_error = m_average_error;
+    max_error = m_max_error;
+
+    return true;
+}
+
+void LocalSampleAccumulationBuffer::update_block_convergence(IAbortSwitch& abort_switch)
+{
+    // Request exclusive access.
+    while (!m_lock.try_lock_write())
+    {
+        foundation::sleep(1);
+        if (abort_switch.is_aborted())
+            return;
+    }
+
+    const AccumulatorTile& main_level = *m_levels[0];
+    const float min_weight = static_cast<float>(m_min_samples);
+
+    for (size_t i = 0; i < m_block_count; ++i)
+    {
+        // Retired blocks never come back, and keep their last noise level.
+        if (m_block_converged[i])
+            continue;
+
+        const size_t bx = i % m_block_count_x;
+        const size_t by = i / m_block_count_x;
+
+        const AABB2u block(
+            Vector2u(
+                m_crop_window.min.x + bx * ConvergenceBlockSize,
+                m_crop_window.min.y + by * ConvergenceBlockSize),
+            Vector2u(
+                std::min(m_crop_window.min.x + (bx + 1) * ConvergenceBlockSize - 1, m_crop_window.max.x),
+                std::min(m_crop_window.min.y + (by + 1) * ConvergenceBlockSize - 1, m_crop_window.max.y)));
+
+        // The noise level of the block is the average noise level of its pixels, but
+        // the block only converges once each of its pixels is below the threshold.
+        bool valid = true;
+        float error_sum = 0.0f;
+        float max_pixel_error = 0.0f;
+
+        for (size_t y = block.min.y; valid && y <= block.max.y; ++y)
+        {
+            for (size_t x = block.min.x; x <= block.max.x; ++x)
+            {
+                const float* main_ptr = main_level.pixel(x, y);
+                const float* half_ptr = m_half_level->pixel(x, y);
+
+                const float pixel_error = compute_pixel_error(main_ptr, half_ptr);
+
+                if (main_ptr[0] < min_weight ||
+                    pixel_error == std::numeric_limits<float>::max())
+                {
+                    valid = false;
+                    break;
+                }
+
+                error_sum += pixel_error;
+                max_pixel_error = std::max(max_pixel_error, pixel_error);
+            }
+        }
+
+        m_block_errors[i] =
+            valid
+                ? error_sum / static_cast<float>(block.volume())
+                : std::numeric_limits<float>::max();
+
+        if (valid && m_noise_threshold > 0.0f && max_pixel_error <= m_noise_threshold)
+        {
+            m_block_converged[i] = true;
+            ++m_converged_block_count;
+        }
+    }
+
+    // Aggregate the noise levels of the blocks, weighting blocks by their pixel count.
+    double error_sum = 0.0;
+    float max_error = 0.0f;
+
+    for (size_t i = 0; i < m_block_count; ++i)
+    {
+        const float block_error = m_block_errors[i];
+
+        if (block_error == std::numeric_limits<float>::max())
+        {
+            max_error = block_error;
+            break;
+        }
+
+        const size_t bx = i % m_block_count_x;
+        const size_t by = i / m_block_count_x;
+        const size_t block_width = std::min(ConvergenceBlockSize, m_crop_window.extent(0) - bx * ConvergenceBlockSize);
+        const size_t block_height = std::min(ConvergenceBlockSize, m_crop_window.extent(1) - by * ConvergenceBlockSize);
+
+        error_sum += static_cast<double>(block_error) * (block_width * block_height);
+        max_error = std::max(max_error, block_error);
+    }
+
+    {
+        Spinlock::ScopedLock error_lock(m_error_spinlock);
+        m_average_error =
+            max_error == std::numeric_limits<float>::max()
+                ? std::numeric_limits<float>::max()
+                : static_cast<float>(error_sum / m_crop_window.volume());
+        m_max_error = max_error;
+    }
+
+    m_lock.unlock_write();
+}
+
 void LocalSampleAccumulationBuffer::develop_to_tile(
     Tile&                   color_tile,
     const size_t            image_width,
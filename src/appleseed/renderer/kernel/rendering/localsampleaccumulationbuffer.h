@@ -41,12 +41,15 @@
 // Standard headers.
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 // Forward declarations.
 namespace foundation    { class AccumulatorTile; }
+namespace foundation    { class CanvasProperties; }
 namespace foundation    { class IAbortSwitch; }
 namespace foundation    { class Tile; }
+namespace foundation    { class TiledImageAnalysis; }
 namespace renderer      { class Frame; }
 namespace renderer      { class Sample; }
 
@@ -65,6 +68,28 @@ class LocalSampleAccumulationBuffer
     // Destructor.
     ~LocalSampleAccumulationBuffer() override;
 
+    // Enable tracking of the convergence of blocks of pixels inside a given crop window.
+    // A block is retired once each of its pixels has received at least `min_samples`
+    // samples and its estimated noise level is below `noise_threshold`. A threshold of 0
+    // only estimates noise levels and never retires blocks. Not thread-safe.
+    void enable_convergence_tracking(
+        const foundation::AABB2u&               crop_window,
+        const float                             noise_threshold,
+        const size_t                            min_samples);
+
+    // A coarse pass renders one sample per block of m_block_size x m_block_size pixels.
+    struct CoarsePass
+    {
+        size_t                                  m_block_size;
+        size_t                                  m_sample_count;
+    };
+
+    // Account for a sample generator that renders coarse passes before rendering samples
+    // at full resolution. A level of the pyramid is only displayed once the coarse passes
+    // of lower resolution than itself are complete and it received as many additional
+    // samples as it has pixels. Not thread-safe.
+    void set_coarse_passes(const std::vector<CoarsePass>& passes);
+
     // Reset the buffer to its initial state. Thread-safe.
     void clear() override;
 
@@ -79,6 +104,38 @@ class LocalSampleAccumulationBuffer
         Frame&                                  frame,
         foundation::IAbortSwitch&               abort_switch) override;
 
+    // Develop to a frame the tiles that received samples since the last call to this
+    // method. All tiles are developed while a coarser level of the pyramid is displayed,
+    // since a pixel of such a level covers several tiles. Thread-safe.
+    void develop_dirty_tiles_to_frame(
+        Frame&                                  frame,
+        std::vector<size_t>&                    dirty_tiles,
+        foundation::IAbortSwitch&               abort_switch) override;
+
+    // Update an analysis of a frame with the tiles that received samples since the last
+    // call to this method. Dirty tiles are tracked independently of the method above.
+    // Thread-safe.
+    void update_analysis(
+        const Frame&                            frame,
+        foundation::TiledImageAnalysis&         analysis,
+        foundation::IAbortSwitch&               abort_switch) override;
+
+    // Return true if the block of pixels containing (x, y) has converged. Thread-safe.
+    bool is_converged(
+        const size_t                            x,
+        const size_t                            y) const override;
+
+    // Return true if all blocks of pixels have converged. Thread-safe.
+    bool is_converged() const override;
+
+    // Enable convergence tracking if it isn't already, without retiring blocks. Not thread-safe.
+    void enable_error_estimation(const foundation::AABB2u& crop_window) override;
+
+    // Retrieve the noise levels estimated by the last convergence update. Thread-safe.
+    bool get_error_estimate(
+        float&                                  average_error,
+        float&                                  max_error) const override;
+
     // Exposed for tests and benchmarks.
     static void develop_to_tile(
         foundation::Tile&                       color_tile,
@@ -97,8 +154,58 @@ class LocalSampleAccumulationBuffer
     LockType                                    m_lock;
     std::vector<foundation::AccumulatorTile*>   m_levels;
     std::vector<foundation::Vector2f>           m_level_scales;
+    std::vector<std::int32_t>                   m_level_delays;     // samples of coarser passes, per level
     boost::atomic<std::int32_t>*                m_remaining_pixels;
     boost::atomic<std::uint32_t>                m_active_level;
+
+    // Convergence tracking.
+    std::unique_ptr<foundation::AccumulatorTile> m_half_level;     // full resolution, half of the samples
+    std::unique_ptr<boost::atomic<bool>[]>      m_block_converged;
+    std::unique_ptr<float[]>                    m_block_errors;     // average noise level of each block
+    foundation::AABB2u                          m_crop_window;
+    size_t                                      m_block_count_x;
+    size_t                                      m_block_count;
+    float                                       m_noise_threshold;
+    size_t                                      m_min_samples;
+    boost::atomic<size_t>                       m_converged_block_count;
+    boost::atomic<std::uint64_t>                m_next_convergence_update;
+    mutable foundation::Spinlock                m_error_spinlock;
+    float                                       m_average_error;
+    float                                       m_max_error;
+
+    // Dirty tracking, in square blocks of pixels of the full resolution level.
+    // Each block holds one flag per consumer of dirty tiles.
+    std::unique_ptr<boost::atomic<std::uint8_t>[]> m_dirty_blocks;
+    size_t                                      m_dirty_block_count_x;
+    size_t                                      m_dirty_block_count_y;
+    std::uint32_t                               m_developed_level;  // level of the last incremental develop, ~0 if none
+    std::uint32_t                               m_analyzed_level;   // level of the last incremental analysis, ~0 if none
+
+    void mark_blocks_dirty(
+        const size_t                            sample_count,
+        const Sample                            samples[]);
+
+    bool is_tile_dirty(
+        const foundation::CanvasProperties&     frame_props,
+        const size_t                            tile_x,
+        const size_t                            tile_y,
+        const std::uint8_t                      consumer_flag) const;
+
+    // Collect the tiles of a frame that are dirty for a given consumer, or all tiles
+    // overlapping the crop window if `collect_all` is true, and clear the consumer's flags.
+    void collect_dirty_tiles(
+        const Frame&                            frame,
+        const std::uint8_t                      consumer_flag,
+        const bool                              collect_all,
+        std::vector<size_t>&                    dirty_tiles);
+
+    void develop_tile(
+        Frame&                                  frame,
+        const foundation::AccumulatorTile&      level,
+        const size_t                            tile_x,
+        const size_t                            tile_y) const;
+
+    void update_block_convergence(foundation::IAbortSwitch& abort_switch);
 };
 
 }   // namespace renderer
@@ -36,7 +36,11 @@
 #include "renderer/kernel/lighting/lightpathrecorder.h"
 #include "renderer/kernel/rendering/iframerenderer.h"
 #include "renderer/kernel/rendering/itilecallback.h"
+#include "renderer/kernel/rendering/phasetimer.h"
+#include "renderer/kernel/rendering/postprocessingpipeline.h"
 #include "renderer/kernel/rendering/renderercontrollercollection.h"
+#include "renderer/kernel/rendering/renderingmetrics.h"
+#include "renderer/kernel/rendering/scenechangetracker.h"
 #include "renderer/kernel/rendering/serialrenderercontroller.h"
 #include "renderer/kernel/rendering/serialtilecallback.h"
 #include "renderer/modeling/display/display.h"
@@ -50,18 +54,21 @@
 #include "renderer/utility/settingsparsing.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/image.h"
 #include "foundation/memory/autoreleaseptr.h"
+#include "foundation/memory/memorytracker.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/utility/hardwarecounters.h"
 #include "foundation/utility/job/iabortswitch.h"
 #include "foundation/utility/otherwise.h"
 #include "foundation/utility/searchpaths.h"
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
-#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <exception>
 #include <memory>
 #include <new>
@@ -101,6 +108,47 @@ namespace
       private:
         IRendererController& m_renderer_controller;
     };
+
+    // Enable hardware counters sampling for the lifetime of this object, if requested,
+    // and print the collected counts upon destruction.
+    class HardwareCountersContext
+      : public NonCopyable
+    {
+      public:
+        explicit HardwareCountersContext(const ParamArray& params)
+          : m_enabled(false)
+        {
+            if (!params.get_optional<bool>("hardware_counters", false))
+                return;
+
+            if (!HardwareCounters::is_supported())
+            {
+                RENDERER_LOG_WARNING("hardware counters are not supported on this platform.");
+                return;
+            }
+
+            HardwareCounters& counters = global_hardware_counters();
+            counters.clear();
+            counters.set_enabled(true);
+            m_enabled = true;
+        }
+
+        ~HardwareCountersContext()
+        {
+            if (!m_enabled)
+                return;
+
+            HardwareCounters& counters = global_hardware_counters();
+            counters.set_enabled(false);
+
+            RENDERER_LOG_INFO(
+                "hardware counters:\n%s",
+                counters.get_statistics().to_string().c_str());
+        }
+
+      private:
+        bool m_enabled;
+    };
 }
 
 struct MasterRenderer::Impl
@@ -116,6 +164,7 @@ struct MasterRenderer::Impl
     ITileCallbackFactory*               m_serial_tile_callback_factory;
 
     std::unique_ptr<IRenderDevice>      m_render_device;
+    SceneChangeTracker                  m_scene_change_tracker;
 
     Impl(
         Project&                        project,
@@ -184,7 +233,10 @@ struct MasterRenderer::Impl
         if (device_name == "cpu")
         {
             if (dynamic_cast<const CPURenderDevice*>(m_render_device.get()) == nullptr)
+            {
                 m_render_device.reset(new CPURenderDevice(m_project, m_params));
+                m_scene_change_tracker.reset();
+            }
         }
         else
         {
@@ -193,11 +245,14 @@ struct MasterRenderer::Impl
         }
 
         // Initialize thread-local variables.
-        Spectrum::set_mode(get_spectrum_mode(m_params));
+        Spectrum::set_mode(get_shared_data_spectrum_mode(get_spectrum_mode(m_params)));
 
         // Reset the frame's render info.
         m_project.get_frame()->render_info().clear();
 
+        // Only report memory usage peaks reached during this render.
+        global_memory_tracker().reset_peak_sizes();
+
         // If a single tile callback was provided, wrap the provided renderer controller
         // and single tile callback into their serial counterparts.
         if (m_tile_callback != nullptr)
@@ -212,11 +267,14 @@ struct MasterRenderer::Impl
         try
         {
             // Render.
-            result.m_status =
-                do_render(
-                    m_serial_renderer_controller != nullptr
-                        ? *m_serial_renderer_controller
-                        : renderer_controller);
+            {
+                HardwareCountersContext hardware_counters_context(m_params);
+                result.m_status =
+                    do_render(
+                        m_serial_renderer_controller != nullptr
+                            ? *m_serial_renderer_controller
+                            : renderer_controller);
+            }
 
             // Retrieve frame's render info. Note that the frame entity may have been replaced during rendering.
             ParamArray& render_info = m_project.get_frame()->render_info();
@@ -224,11 +282,15 @@ struct MasterRenderer::Impl
             // Insert rendering time into frame's render info.
             render_info.insert("render_time", m_project.get_rendering_timer().get_seconds());
 
+            // Print memory usage statistics.
+            RENDERER_LOG_INFO("%s", global_memory_tracker().get_statistics().to_string().c_str());
+
             // Don't proceed further if rendering failed.
             if (result.m_status != RenderingResult::Succeeded)
                 return result;
 
             // Post-process.
+            PhaseTimer phase_timer;
             RenderingTimer stopwatch;
             stopwatch.start();
             postprocess();
@@ -236,6 +298,7 @@ struct MasterRenderer::Impl
 
             // Insert post-processing time into frame's render info.
             render_info.insert("post_processing_time", stopwatch.get_seconds());
+            phase_timer.record(render_info, "post_processing");
         }
         catch (const std::bad_alloc&)
         {
@@ -296,11 +359,13 @@ struct MasterRenderer::Impl
             RendererControllerAbortSwitch abort_switch(renderer_controller);
 
             // Expand procedural assemblies before scene entities inputs are bound.
+            PhaseTimer phase_timer;
             if (!m_project.get_scene()->expand_procedural_assemblies(m_project, &abort_switch))
             {
                 renderer_controller.on_rendering_abort();
                 return RenderingResult::Aborted;
             }
+            phase_timer.record(m_project.get_frame()->render_info(), "procedural_expansion");
 
             // Bind scene entities inputs.
             if (!bind_scene_entities_inputs())
@@ -347,21 +412,37 @@ struct MasterRenderer::Impl
         // This is done before creating renderer components because renderer components need
         // to access the scene's render data such as the scene's bounding box.
         OnRenderBeginRecorder recorder;
+        PhaseTimer scene_preparation_timer;
+        RenderingTimer stopwatch;
+        stopwatch.start();
         if (!m_project.get_scene()->on_render_begin(m_project, nullptr, recorder, &abort_switch) ||
             abort_switch.is_aborted())
         {
             recorder.on_render_end(m_project);
             return renderer_controller.get_status();
         }
+        stopwatch.measure();
+        m_project.get_frame()->render_info().insert("scene_preparation_time", stopwatch.get_seconds());
+        scene_preparation_timer.record(m_project.get_frame()->render_info(), "scene_preparation");
+
+        // Find out what changed in the scene since the render device was last initialized.
+        const std::uint32_t scene_changes = m_scene_change_tracker.update(*m_project.get_scene());
+        RENDERER_LOG_DEBUG(
+            "scene changes since last render: %s.",
+            SceneChangeTracker::get_changes_description(scene_changes).c_str());
 
         // Initialize the render device.
         const bool success =
             m_render_device->initialize(
                 m_resource_search_paths,
                 m_tile_callback_factory,
+                scene_changes,
                 abort_switch);
         if (!success || abort_switch.is_aborted())
         {
+            // The render device may be left partially initialized.
+            m_scene_change_tracker.reset();
+
             recorder.on_render_end(m_project);
 
             // If it wasn't an abort, it was a failure.
@@ -386,11 +467,16 @@ struct MasterRenderer::Impl
         else RENDERER_LOG_INFO("using built-in ray tracing kernel.");
 
         // Updating the device scene causes ray tracing acceleration structures to be updated or rebuilt.
+        PhaseTimer acceleration_structure_build_timer;
+        stopwatch.start();
         if (!m_render_device->build_or_update_scene())
         {
             recorder.on_render_end(m_project);
             return IRendererController::AbortRendering;
         }
+        stopwatch.measure();
+        m_project.get_frame()->render_info().insert("acceleration_structure_build_time", stopwatch.get_seconds());
+        acceleration_structure_build_timer.record(m_project.get_frame()->render_info(), "acceleration_structure_build");
 
         // Load the checkpoint if any.
         Frame& frame = *m_project.get_frame();
@@ -452,6 +538,7 @@ struct MasterRenderer::Impl
             m_project.get_light_path_recorder().clear();
 
             // Perform pre-frame actions. Don't proceed if that failed.
+            PhaseTimer frame_preparation_timer;
             OnFrameBeginRecorder recorder;
             if (!m_render_device->on_frame_begin(recorder, &abort_switch) ||
                 !m_project.on_frame_begin(m_project, nullptr, recorder, &abort_switch) ||
@@ -461,13 +548,18 @@ struct MasterRenderer::Impl
                 combined_renderer_controller.on_frame_end();
                 return IRendererController::AbortRendering;
             }
+            frame_preparation_timer.record(m_project.get_frame()->render_info(), "frame_preparation");
 
             // Render the frame.
+            PhaseTimer rendering_timer;
+            global_rendering_metrics().on_frame_begin();
             const IRendererController::Status status =
                 m_render_device->render_frame(
                     m_tile_callback_factory,
                     combined_renderer_controller,
                     abort_switch);
+            global_rendering_metrics().on_frame_end();
+            rendering_timer.record(m_project.get_frame()->render_info(), "rendering");
 
             // Perform post-frame actions.
             recorder.on_frame_end(m_project);
@@ -493,49 +585,15 @@ struct MasterRenderer::Impl
         Frame* frame = m_project.get_frame();
         assert(frame != nullptr);
 
+        PostProcessingPipeline pipeline(*frame, get_rendering_thread_count(m_params));
+
         // Nothing to do if there are no post-processing stages.
-        if (frame->post_processing_stages().empty())
+        if (pipeline.empty())
             return;
 
-        // Collect post-processing stages.
-        std::vector<PostProcessingStage*> ordered_stages;
-        ordered_stages.reserve(frame->post_processing_stages().size());
-        for (PostProcessingStage& stage : frame->post_processing_stages())
-            ordered_stages.push_back(&stage);
-
-        // Sort post-processing stages in increasing order.
-        std::sort(
-            ordered_stages.begin(),
-            ordered_stages.end(),
-            [](PostProcessingStage* lhs, PostProcessingStage* rhs)
-            {
-                return lhs->get_order() < rhs->get_order();
-            });
-
-        // Detect post-processing stages with equal order.
-        size_t previous_stage_index = 0;
-        int previous_order = ordered_stages[0]->get_order();
-        for (size_t i = 1, e = ordered_stages.size(); i < e; ++i)
-        {
-            const int order = ordered_stages[i]->get_order();
-            if (order == previous_order)
-            {
-                RENDERER_LOG_WARNING(
-                    "post-processing stages \"%s\" and \"%s\" have equal order (%d); results will be unpredictable.",
-                    ordered_stages[previous_stage_index]->get_path().c_str(),
-                    ordered_stages[i]->get_path().c_str(),
-                    order);
-            }
-        }
-
         // Execute post-processing stages.
-        for (PostProcessingStage* stage : ordered_stages)
-        {
-            RENDERER_LOG_INFO("executing \"%s\" post-processing stage with order %d on frame \"%s\"...",
-                stage->get_path().c_str(), stage->get_order(), frame->get_path().c_str());
-            stage->execute(*frame);
-            invoke_tile_callbacks(*frame);
-        }
+        pipeline.execute();
+        invoke_tile_callbacks(*frame);
     }
 
     void invoke_tile_callbacks(const Frame& frame)
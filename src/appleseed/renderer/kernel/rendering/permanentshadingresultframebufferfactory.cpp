@@ -39,6 +39,7 @@
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/image.h"
 #include "foundation/image/tile.h"
+#include "foundation/memory/memory.h"
 
 using namespace foundation;
 
@@ -51,13 +52,29 @@ PermanentShadingResultFrameBufferFactory::PermanentShadingResultFrameBufferFacto
     const CanvasProperties& props = frame.image().properties();
     const std::size_t tile_count_x = props.m_tile_count_x;
     const std::size_t tile_count_y = props.m_tile_count_y;
-
-    m_framebuffers.resize(tile_count_x * tile_count_y, nullptr);
+    const std::size_t tile_count = tile_count_x * tile_count_y;
+
+    m_framebuffers.resize(tile_count, nullptr);
+
+    // Framebuffers live for the whole render and are accessed with little locality,
+    // so their pixels are stored in a single block backed by large pages. Pages are
+    // only committed when framebuffers are created. If the block can't be allocated,
+    // framebuffers allocate their own storage.
+    m_framebuffer_size =
+          props.m_tile_width * props.m_tile_height
+        * (ShadingResultFrameBuffer::get_total_channel_count(frame.aov_images().size()) + 1)
+        * sizeof(float);
+    m_storage =
+        static_cast<std::uint8_t*>(
+            large_page_aligned_malloc(m_framebuffer_size * tile_count, 16));
 }
 
 PermanentShadingResultFrameBufferFactory::~PermanentShadingResultFrameBufferFactory()
 {
     clear();
+
+    if (m_storage)
+        aligned_free(m_storage);
 }
 
 void PermanentShadingResultFrameBufferFactory::release()
@@ -74,6 +91,12 @@ void PermanentShadingResultFrameBufferFactory::clear()
     }
 }
 
+bool PermanentShadingResultFrameBufferFactory::supports_sub_tiles() const
+{
+    // All parts of a tile would share the same framebuffer.
+    return false;
+}
+
 ShadingResultFrameBuffer* PermanentShadingResultFrameBufferFactory::create(
     const Frame&                frame,
     const std::size_t           tile_x,
@@ -92,7 +115,8 @@ ShadingResultFrameBuffer* PermanentShadingResultFrameBufferFactory::create(
                 tile.get_width(),
                 tile.get_height(),
                 frame.aov_images().size(),
-                tile_bbox);
+                tile_bbox,
+                m_storage ? m_storage + index * m_framebuffer_size : nullptr);
 
         m_framebuffers[index]->clear();
     }
@@ -37,6 +37,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
 // Forward declarations.
@@ -62,6 +63,8 @@ class PermanentShadingResultFrameBufferFactory
 
     void clear() override;
 
+    bool supports_sub_tiles() const override;
+
     ShadingResultFrameBuffer* create(
         const Frame&                frame,
         const std::size_t           tile_x,
@@ -73,6 +76,8 @@ class PermanentShadingResultFrameBufferFactory
 
   private:
     std::vector<ShadingResultFrameBuffer*> m_framebuffers;
+    std::uint8_t*                           m_storage;              // pixels of all framebuffers, may be nullptr
+    std::size_t                             m_framebuffer_size;     // size in bytes of the pixels of one framebuffer
 };
 
 }   // namespace renderer
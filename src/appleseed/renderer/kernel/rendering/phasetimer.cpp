@@ -0,0 +1,78 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "phasetimer.h"
+
+// appleseed.renderer headers.
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/system.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+PhaseTimer::PhaseTimer()
+{
+    m_wallclock_stopwatch.start();
+    m_processor_stopwatch.start();
+}
+
+void PhaseTimer::record(ParamArray& render_info, const char* phase_name)
+{
+    m_processor_stopwatch.measure();
+    m_wallclock_stopwatch.measure();
+
+    ParamArray& phase = render_info.push("phases").push(phase_name);
+
+    const double wall_time =
+        phase.get_optional<double>("wall_time", 0.0) + m_wallclock_stopwatch.get_seconds();
+    const double cpu_time =
+        phase.get_optional<double>("cpu_time", 0.0) + m_processor_stopwatch.get_seconds();
+    const std::uint64_t peak_memory = System::get_peak_process_virtual_memory_size();
+
+    const size_t core_count = System::get_logical_cpu_core_count();
+    const double thread_utilization =
+        wall_time > 0.0 && core_count > 0
+            ? cpu_time / (wall_time * core_count)
+            : 0.0;
+
+    phase.insert("wall_time", wall_time);
+    phase.insert("cpu_time", cpu_time);
+    phase.insert("peak_memory", peak_memory);
+    phase.insert("thread_utilization", thread_utilization);
+}
+
+}   // namespace renderer
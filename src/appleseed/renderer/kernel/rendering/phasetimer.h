@@ -0,0 +1,75 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/timers.h"
+#include "foundation/utility/stopwatch.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Forward declarations.
+namespace renderer  { class ParamArray; }
+
+namespace renderer
+{
+
+//
+// Measures a phase of a render (scene preparation, acceleration structure build,
+// rendering, etc.) and records it into the "phases" section of a frame's render info.
+//
+// For each phase the following values are recorded:
+//
+//   wall_time              wall clock time in seconds
+//   cpu_time               processor time in seconds, summed over all threads
+//   peak_memory            peak virtual memory in bytes used by the process so far
+//   thread_utilization     cpu_time / (wall_time * number of logical CPU cores)
+//
+// Times of phases that are recorded multiple times (for instance when rendering is
+// reinitialized) are accumulated.
+//
+
+class APPLESEED_DLLSYMBOL PhaseTimer
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor, starts measuring.
+    PhaseTimer();
+
+    // Stop measuring and record the phase into a given render info.
+    void record(ParamArray& render_info, const char* phase_name);
+
+  private:
+    foundation::Stopwatch<foundation::DefaultWallclockTimer>    m_wallclock_stopwatch;
+    foundation::Stopwatch<foundation::DefaultProcessorTimer>    m_processor_stopwatch;
+};
+
+}   // namespace renderer
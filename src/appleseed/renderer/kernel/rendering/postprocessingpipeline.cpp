@@ -0,0 +1,275 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "postprocessingpipeline.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/modeling/postprocessingstage/postprocessingstage.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/utility/api/apistring.h"
+#include "foundation/utility/job/iabortswitch.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    //
+    // Execute a group of post-processing stages on a single tile.
+    //
+
+    class PostProcessTileJob
+      : public IJob
+    {
+      public:
+        PostProcessTileJob(
+            const std::vector<PostProcessingStage*>&    stages,
+            Frame&                                      frame,
+            const size_t                                tile_x,
+            const size_t                                tile_y,
+            IAbortSwitch*                               abort_switch)
+          : m_stages(stages)
+          , m_frame(frame)
+          , m_tile_x(tile_x)
+          , m_tile_y(tile_y)
+          , m_abort_switch(abort_switch)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            for (const PostProcessingStage* stage : m_stages)
+            {
+                if (is_aborted(m_abort_switch))
+                    break;
+
+                stage->execute_tile(m_frame, m_tile_x, m_tile_y);
+            }
+        }
+
+      private:
+        const std::vector<PostProcessingStage*>&        m_stages;
+        Frame&                                          m_frame;
+        const size_t                                    m_tile_x;
+        const size_t                                    m_tile_y;
+        IAbortSwitch*                                   m_abort_switch;
+    };
+}
+
+
+//
+// PostProcessingPipeline class implementation.
+//
+
+PostProcessingPipeline::PostProcessingPipeline(
+    Frame&                                  frame,
+    const size_t                            thread_count)
+  : m_frame(frame)
+  , m_thread_count(std::max<size_t>(thread_count, 1))
+{
+    // Post-processing stages operate on whole images.
+    if (frame.is_out_of_core())
+    {
+        if (!frame.post_processing_stages().empty())
+            RENDERER_LOG_WARNING("post-processing is not supported with out-of-core frames, skipping post-processing stages.");
+        return;
+    }
+
+    // Collect post-processing stages.
+    m_stages.reserve(frame.post_processing_stages().size());
+    for (PostProcessingStage& stage : frame.post_processing_stages())
+        m_stages.push_back(&stage);
+
+    if (m_stages.empty())
+        return;
+
+    // Sort post-processing stages in increasing order.
+    std::sort(
+        m_stages.begin(),
+        m_stages.end(),
+        [](PostProcessingStage* lhs, PostProcessingStage* rhs)
+        {
+            return lhs->get_order() < rhs->get_order();
+        });
+
+    // Detect post-processing stages with equal order.
+    size_t previous_stage_index = 0;
+    int previous_order = m_stages[0]->get_order();
+    for (size_t i = 1, e = m_stages.size(); i < e; ++i)
+    {
+        const int order = m_stages[i]->get_order();
+        if (order == previous_order)
+        {
+            RENDERER_LOG_WARNING(
+                "post-processing stages \"%s\" and \"%s\" have equal order (%d); results will be unpredictable.",
+                m_stages[previous_stage_index]->get_path().c_str(),
+                m_stages[i]->get_path().c_str(),
+                order);
+        }
+    }
+}
+
+bool PostProcessingPipeline::empty() const
+{
+    return m_stages.empty();
+}
+
+void PostProcessingPipeline::execute(IAbortSwitch* abort_switch)
+{
+    const CanvasProperties& props = m_frame.image().properties();
+
+    // Tiles outside the crop window were not rendered, leave them alone.
+    std::vector<size_t> tile_indices;
+    tile_indices.reserve(props.m_tile_count);
+    for (size_t i = 0; i < props.m_tile_count; ++i)
+    {
+        if (m_frame.overlaps_crop_window(i % props.m_tile_count_x, i / props.m_tile_count_x))
+            tile_indices.push_back(i);
+    }
+
+    execute_stages(tile_indices, false, abort_switch);
+}
+
+void PostProcessingPipeline::execute_tiles(
+    const std::vector<size_t>&              tile_indices,
+    IAbortSwitch*                           abort_switch)
+{
+    execute_stages(tile_indices, true, abort_switch);
+}
+
+void PostProcessingPipeline::execute_stages(
+    const std::vector<size_t>&              tile_indices,
+    const bool                              tiled_stages_only,
+    IAbortSwitch*                           abort_switch)
+{
+    std::vector<PostProcessingStage*> group;
+
+    for (size_t i = 0, e = m_stages.size(); i < e; ++i)
+    {
+        PostProcessingStage* stage = m_stages[i];
+
+        if (!stage->supports_tiles() && tiled_stages_only)
+            continue;
+
+        if (!tiled_stages_only)
+        {
+            RENDERER_LOG_INFO("executing \"%s\" post-processing stage with order %d on frame \"%s\"...",
+                stage->get_path().c_str(), stage->get_order(), m_frame.get_path().c_str());
+        }
+
+        if (stage->supports_tiles())
+        {
+            group.push_back(stage);
+
+            // Fuse this stage with the next one if both only access the pixels of the tile being processed.
+            const PostProcessingStage* next_stage = i + 1 < e ? m_stages[i + 1] : nullptr;
+            if (next_stage != nullptr &&
+                next_stage->supports_tiles() &&
+                next_stage->is_pixel_local() &&
+                stage->is_pixel_local())
+                continue;
+
+            execute_tiled_stages(group, tile_indices, abort_switch);
+            group.clear();
+        }
+        else stage->execute(m_frame);
+
+        if (is_aborted(abort_switch))
+            break;
+    }
+}
+
+void PostProcessingPipeline::execute_tiled_stages(
+    const std::vector<PostProcessingStage*>&    stages,
+    const std::vector<size_t>&                  tile_indices,
+    IAbortSwitch*                               abort_switch)
+{
+    assert(!stages.empty());
+
+    // Stages are only fused when they don't read the frame outside of execute_tile(),
+    // so they can all be prepared before any of them runs.
+    for (PostProcessingStage* stage : stages)
+        stage->prepare_tiles(m_frame);
+
+    const CanvasProperties& props = m_frame.image().properties();
+
+    if (m_thread_count == 1 || tile_indices.size() == 1)
+    {
+        for (const size_t tile_index : tile_indices)
+        {
+            PostProcessTileJob job(
+                stages,
+                m_frame,
+                tile_index % props.m_tile_count_x,
+                tile_index / props.m_tile_count_x,
+                abort_switch);
+            job.execute(0);
+        }
+    }
+    else
+    {
+        JobQueue job_queue;
+        JobManager job_manager(global_logger(), job_queue, std::min(m_thread_count, tile_indices.size()));
+
+        for (const size_t tile_index : tile_indices)
+        {
+            assert(tile_index < props.m_tile_count);
+
+            job_queue.schedule(
+                new PostProcessTileJob(
+                    stages,
+                    m_frame,
+                    tile_index % props.m_tile_count_x,
+                    tile_index / props.m_tile_count_x,
+                    abort_switch));
+        }
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+    }
+
+    for (const PostProcessingStage* stage : stages)
+        stage->finish_tiles(m_frame);
+}
+
+}   // namespace renderer
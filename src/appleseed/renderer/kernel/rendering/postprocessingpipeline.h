@@ -0,0 +1,93 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class IAbortSwitch; }
+namespace renderer      { class Frame; }
+namespace renderer      { class PostProcessingStage; }
+
+namespace renderer
+{
+
+//
+// Executes the post-processing stages of a frame in increasing order.
+//
+// Stages that support tiled execution process tiles concurrently. Consecutive stages
+// that only access the pixels of the tile being processed are fused: each tile goes
+// through all of them in a single job while its pixels are still in cache.
+//
+
+class PostProcessingPipeline
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    PostProcessingPipeline(
+        Frame&                              frame,
+        const size_t                        thread_count);
+
+    // Return true if the frame has no post-processing stages.
+    bool empty() const;
+
+    // Execute all post-processing stages on the whole frame.
+    void execute(
+        foundation::IAbortSwitch*           abort_switch = nullptr);
+
+    // Execute the post-processing stages that support tiled execution on a subset of
+    // the tiles of the frame, for instance the tiles refreshed by a progressive update.
+    // Other stages are skipped. Tiles are identified by their index in the frame.
+    void execute_tiles(
+        const std::vector<size_t>&          tile_indices,
+        foundation::IAbortSwitch*           abort_switch = nullptr);
+
+  private:
+    Frame&                                  m_frame;
+    const size_t                            m_thread_count;
+    std::vector<PostProcessingStage*>       m_stages;
+
+    void execute_stages(
+        const std::vector<size_t>&                  tile_indices,
+        const bool                                  tiled_stages_only,
+        foundation::IAbortSwitch*                   abort_switch);
+
+    void execute_tiled_stages(
+        const std::vector<PostProcessingStage*>&    stages,
+        const std::vector<size_t>&                  tile_indices,
+        foundation::IAbortSwitch*                   abort_switch);
+};
+
+}   // namespace renderer
@@ -32,12 +32,17 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
+#include "renderer/kernel/rendering/convergencerenderercontroller.h"
 #include "renderer/kernel/rendering/iframerenderer.h"
 #include "renderer/kernel/rendering/isamplegenerator.h"
 #include "renderer/kernel/rendering/itilecallback.h"
+#include "renderer/kernel/rendering/jobgranularitycontroller.h"
+#include "renderer/kernel/rendering/postprocessingpipeline.h"
 #include "renderer/kernel/rendering/progressive/samplecounter.h"
 #include "renderer/kernel/rendering/progressive/samplecounthistory.h"
 #include "renderer/kernel/rendering/progressive/samplegeneratorjob.h"
+#include "renderer/kernel/rendering/rendercosttracker.h"
+#include "renderer/kernel/rendering/renderercontrollercollection.h"
 #include "renderer/kernel/rendering/sampleaccumulationbuffer.h"
 #include "renderer/kernel/rendering/timedrenderercontroller.h"
 #include "renderer/modeling/frame/frame.h"
@@ -88,6 +93,9 @@ namespace
 {
     using SampleCountHistoryType = SampleCountHistory<128>;
 
+    // Smallest number of samples rendered by a job when job granularity is adaptive.
+    const std::uint64_t MinSamplesPerAdaptiveJob = 32;
+
 
     //
     // Frame display thread.
@@ -103,6 +111,9 @@ namespace
             SampleCountHistoryType&     sample_count_history,
             Spinlock&                   sample_count_history_spinlock,
             ITileCallback*              tile_callback,
+            PostProcessingPipeline*     post_processing_pipeline,
+            const bool                  preview_denoising,
+            const size_t                thread_count,
             const double                max_fps,
             IAbortSwitch&               abort_switch)
           : m_frame(frame)
@@ -110,6 +121,9 @@ namespace
           , m_sample_count_history(sample_count_history)
           , m_sample_count_history_spinlock(sample_count_history_spinlock)
           , m_tile_callback(tile_callback)
+          , m_post_processing_pipeline(post_processing_pipeline)
+          , m_preview_denoising(preview_denoising)
+          , m_thread_count(thread_count)
           , m_min_sample_count(std::min<std::uint64_t>(frame.get_crop_window().volume(), 32 * 32 * 2))
           , m_target_elapsed(1.0 / max_fps)
           , m_abort_switch(abort_switch)
@@ -118,6 +132,8 @@ namespace
             const Vector2u crop_window_extent = frame.get_crop_window().extent();
             const size_t pixel_count = crop_window_extent.x * crop_window_extent.y;
             m_rcp_pixel_count = 1.0 / pixel_count;
+
+            m_dirty_tiles.reserve(frame.image().properties().m_tile_count);
         }
 
         void pause()
@@ -159,7 +175,7 @@ namespace
                         yield();
 
                     // Merge the samples and display the final frame.
-                    develop_and_display();
+                    develop_and_display(true, m_preview_denoising);
                 }
 
                 // Limit display rate.
@@ -171,15 +187,36 @@ namespace
             }
         }
 
-        void develop_and_display()
+        void develop_and_display(
+            const bool                  preview_post_processing,
+            const bool                  denoise)
         {
 #ifdef PRINT_DISPLAY_THREAD_PERFS
             m_stopwatch.measure();
             const double t1 = m_stopwatch.get_seconds();
 #endif
 
-            // Develop the accumulation buffer to the frame.
-            m_buffer.develop_to_frame(m_frame, m_abort_switch);
+            // Develop the tiles of the accumulation buffer that received samples since the last update.
+            m_buffer.develop_dirty_tiles_to_frame(m_frame, m_dirty_tiles, m_abort_switch);
+
+            // Denoise the frame. Only the main image is developed so no auxiliary AOV is used.
+            // Denoising changes all pixels, even those that did not receive new samples.
+            if (denoise)
+            {
+                m_frame.denoise_main_image(m_thread_count, &m_abort_switch);
+
+                const CanvasProperties& frame_props = m_frame.image().properties();
+                m_dirty_tiles.clear();
+                for (size_t i = 0; i < frame_props.m_tile_count; ++i)
+                {
+                    if (m_frame.overlaps_crop_window(i % frame_props.m_tile_count_x, i / frame_props.m_tile_count_x))
+                        m_dirty_tiles.push_back(i);
+                }
+            }
+
+            // Run the post-processing stages that support tiled execution on the developed tiles.
+            if (preview_post_processing && m_post_processing_pipeline != nullptr)
+                m_post_processing_pipeline->execute_tiles(m_dirty_tiles, &m_abort_switch);
 
 #ifdef PRINT_DISPLAY_THREAD_PERFS
             m_stopwatch.measure();
@@ -201,9 +238,11 @@ namespace
                 truncate<std::uint64_t>(m_sample_count_history.get_samples_per_second());
             m_sample_count_history_spinlock.unlock();
 
-            // Present the frame.
-            m_tile_callback->on_progressive_frame_update(
+            // Present the updated tiles.
+            m_tile_callback->on_progressive_tiles_update(
                 m_frame,
+                m_dirty_tiles.data(),
+                m_dirty_tiles.size(),
                 time,
                 samples,
                 samples_per_pixel,
@@ -231,6 +270,10 @@ namespace
         SampleCountHistoryType&             m_sample_count_history;
         Spinlock&                           m_sample_count_history_spinlock;
         ITileCallback*                      m_tile_callback;
+        PostProcessingPipeline*             m_post_processing_pipeline;
+        const bool                          m_preview_denoising;
+        const size_t                        m_thread_count;
+        std::vector<size_t>                 m_dirty_tiles;
         const std::uint64_t                 m_min_sample_count;
         const double                        m_target_elapsed;
         IAbortSwitch&                       m_abort_switch;
@@ -260,6 +303,9 @@ namespace
             const bool                  luminance_stats,
             const Image*                ref_image,
             const double                ref_image_avg_lum,
+            ConvergenceRendererController* convergence_controller,
+            const JobManager&           job_manager,
+            JobGranularityController*   granularity_controller,
             IAbortSwitch&               abort_switch)
           : m_project(project)
           , m_buffer(buffer)
@@ -269,10 +315,22 @@ namespace
           , m_luminance_stats(luminance_stats)
           , m_ref_image(ref_image)
           , m_ref_image_avg_lum(ref_image_avg_lum)
+          , m_convergence_controller(convergence_controller)
+          , m_job_manager(job_manager)
+          , m_granularity_controller(granularity_controller)
+          , m_job_timings(job_manager.get_timings())
           , m_abort_switch(abort_switch)
           , m_rcp_timer_frequency(1.0 / m_timer.frequency())
           , m_timer_start_value(m_timer.read())
         {
+            if (m_luminance_stats || m_ref_image)
+            {
+                m_analysis.reset(
+                    new TiledImageAnalysis(
+                        m_project.get_frame()->image().properties(),
+                        m_ref_image));
+            }
+
             const Vector2u crop_window_extent = m_project.get_frame()->get_crop_window().extent();
             const size_t pixel_count = crop_window_extent.x * crop_window_extent.y;
             m_rcp_pixel_count = 1.0 / pixel_count;
@@ -336,6 +394,12 @@ namespace
 
                     if (m_luminance_stats || m_ref_image)
                         record_and_print_convergence_stats();
+
+                    if (m_convergence_controller)
+                        report_error_estimate();
+
+                    if (m_granularity_controller)
+                        update_job_granularity();
                 }
 
                 sleep(1000, m_abort_switch);
@@ -351,6 +415,10 @@ namespace
         const bool                      m_luminance_stats;
         const Image*                    m_ref_image;
         const double                    m_ref_image_avg_lum;
+        ConvergenceRendererController*  m_convergence_controller;
+        const JobManager&               m_job_manager;
+        JobGranularityController*       m_granularity_controller;
+        JobManager::Timings             m_job_timings;              // job timings at the previous update
         IAbortSwitch&                   m_abort_switch;
         ThreadFlag                      m_pause_flag;
 
@@ -358,6 +426,7 @@ namespace
         double                          m_rcp_timer_frequency;
         std::uint64_t                   m_timer_start_value;
 
+        std::unique_ptr<TiledImageAnalysis> m_analysis;
         double                          m_rcp_pixel_count;
         std::vector<Vector2d>           m_sample_count_records;     // total sample count over time
         std::vector<Vector2d>           m_rmsd_records;             // RMS deviation over time
@@ -387,14 +456,14 @@ namespace
         {
             assert(m_luminance_stats || m_ref_image);
 
-            // Develop the accumulation buffer to the frame.
-            m_buffer.develop_to_frame(*m_project.get_frame(), m_abort_switch);
+            // Only analyze the tiles that received samples since the last update.
+            m_buffer.update_analysis(*m_project.get_frame(), *m_analysis, m_abort_switch);
 
             std::string output;
 
             if (m_luminance_stats)
             {
-                const double avg_lum = compute_average_luminance(m_project.get_frame()->image());
+                const double avg_lum = m_analysis->get_average_luminance();
                 output += "average luminance " + pretty_scalar(avg_lum, 6);
 
                 if (m_ref_image)
@@ -409,7 +478,7 @@ namespace
             if (m_ref_image)
             {
                 const double samples_per_pixel = m_buffer.get_sample_count() * m_rcp_pixel_count;
-                const double rmsd = compute_rms_deviation(m_project.get_frame()->image(), *m_ref_image);
+                const double rmsd = m_analysis->get_rms_deviation();
                 m_rmsd_records.emplace_back(samples_per_pixel, rmsd);
 
                 if (m_luminance_stats)
@@ -419,6 +488,31 @@ namespace
 
             RENDERER_LOG_DEBUG("%s", output.c_str());
         }
+
+        void report_error_estimate()
+        {
+            assert(m_convergence_controller);
+
+            float average_error, max_error;
+            if (m_buffer.get_error_estimate(average_error, max_error))
+                m_convergence_controller->set_error_estimate(average_error, max_error);
+        }
+
+        void update_job_granularity()
+        {
+            assert(m_granularity_controller);
+
+            const JobManager::Timings job_timings = m_job_manager.get_timings();
+
+            if (m_granularity_controller->update(job_timings - m_job_timings))
+            {
+                RENDERER_LOG_DEBUG(
+                    "rendering jobs now render %s samples each.",
+                    pretty_uint(m_granularity_controller->get_job_size()).c_str());
+            }
+
+            m_job_timings = job_timings;
+        }
     };
 
 
@@ -444,7 +538,7 @@ namespace
                     ? m_params.m_max_average_spp * project.get_frame()->get_crop_window().volume()
                     : m_params.m_max_average_spp)
           , m_ref_image_avg_lum(0.0)
-          , m_renderer_controller(m_params.m_time_limit)
+          , m_timed_renderer_controller(m_params.m_time_limit)
         {
             // We must have a generator factory, but it's OK not to have a callback factory.
             assert(generator_factory);
@@ -452,13 +546,47 @@ namespace
             // Create an accumulation buffer.
             m_buffer.reset(generator_factory->create_sample_accumulation_buffer());
 
+            // Create the renderer controllers.
+            m_renderer_controller.insert(&m_timed_renderer_controller);
+            if (m_params.m_noise_target > 0.0f)
+            {
+                float average_error, max_error;
+                m_buffer->enable_error_estimation(project.get_frame()->get_crop_window());
+                if (m_buffer->get_error_estimate(average_error, max_error))
+                {
+                    m_convergence_renderer_controller.reset(
+                        new ConvergenceRendererController(
+                            m_params.m_noise_target,
+                            m_params.m_noise_target_mode));
+                    m_renderer_controller.insert(m_convergence_renderer_controller.get());
+                }
+                else
+                {
+                    RENDERER_LOG_WARNING(
+                        "the sample generator cannot estimate noise levels, ignoring the noise target.");
+                }
+            }
+
+            // Size rendering jobs after their measured duration rather than the sampling profile.
+            if (m_params.m_adaptive_job_granularity)
+            {
+                m_granularity_controller.reset(
+                    new JobGranularityController(
+                        m_params.m_target_job_duration,
+                        MinSamplesPerAdaptiveJob,
+                        m_params.m_sampling_profile.m_max_samples_per_job_in_exponential_phase,
+                        m_params.m_sampling_profile.m_samples_per_job_in_linear_phase));
+            }
+
             // Create and initialize the job manager.
             m_job_manager.reset(
                 new JobManager(
                     global_logger(),
                     m_job_queue,
                     m_params.m_thread_count,
-                    JobManager::KeepRunningOnEmptyQueue));
+                      JobManager::KeepRunningOnEmptyQueue
+                    | (m_granularity_controller ? JobManager::CollectTimings : 0)
+                    | m_params.m_thread_affinity_flags));
 
             // Instantiate sample generators, one per rendering thread.
             m_sample_generators.reserve(m_params.m_thread_count);
@@ -478,6 +606,7 @@ namespace
                         m_sample_generators[i],
                         m_sample_counter,
                         m_params.m_sampling_profile,
+                        m_granularity_controller.get(),
                         m_params.m_spectrum_mode,
                         m_job_queue,
                         i,                              // job index
@@ -529,28 +658,46 @@ namespace
 
         void print_settings() const override
         {
+            std::string noise_target = "off";
+            if (m_convergence_renderer_controller)
+            {
+                noise_target = pretty_scalar(m_params.m_noise_target, 4);
+                noise_target +=
+                    m_params.m_noise_target_mode == ConvergenceRendererController::Mode::Global
+                        ? " (global)"
+                        : " (per tile)";
+            }
+
             RENDERER_LOG_INFO(
                 "progressive frame renderer settings:\n"
                 "  spectrum mode                 %s\n"
                 "  sampling mode                 %s\n"
                 "  rendering threads             %s\n"
+                "  thread affinity               %s\n"
                 "  max average samples per pixel %s\n"
                 "  time limit                    %s\n"
+                "  noise target                  %s\n"
                 "  max fps                       %f\n"
                 "  collect performance stats     %s\n"
-                "  collect luminance stats       %s",
+                "  collect luminance stats       %s\n"
+                "  adaptive job granularity      %s",
                 get_spectrum_mode_name(m_params.m_spectrum_mode).c_str(),
                 get_sampling_context_mode_name(m_params.m_sampling_mode).c_str(),
                 pretty_uint(m_params.m_thread_count).c_str(),
+                get_rendering_thread_affinity_name(m_params.m_thread_affinity_flags).c_str(),
                 m_params.m_max_average_spp == std::numeric_limits<std::uint64_t>::max()
                     ? "unlimited"
                     : pretty_uint(m_params.m_max_average_spp).c_str(),
                 m_params.m_time_limit == std::numeric_limits<double>::max()
                     ? "unlimited"
                     : pretty_time(m_params.m_time_limit).c_str(),
+                noise_target.c_str(),
                 m_params.m_max_fps,
                 m_params.m_perf_stats ? "on" : "off",
-                m_params.m_luminance_stats ? "on" : "off");
+                m_params.m_luminance_stats ? "on" : "off",
+                m_granularity_controller
+                    ? ("on, " + pretty_time(m_params.m_target_job_duration) + " per job").c_str()
+                    : "off");
 
             m_sample_generators.front()->print_settings();
         }
@@ -609,8 +756,11 @@ namespace
                     m_sample_count_history_spinlock,
                     m_params.m_perf_stats,
                     m_params.m_luminance_stats,
-                    m_project.get_frame()->ref_image(),
+                    m_project.get_frame()->has_valid_ref_image() ? m_project.get_frame()->ref_image() : nullptr,
                     m_ref_image_avg_lum,
+                    m_convergence_renderer_controller.get(),
+                    *m_job_manager,
+                    m_granularity_controller.get(),
                     m_abort_switch));
             m_statistics_thread.reset(
                 new boost::thread(
@@ -619,6 +769,12 @@ namespace
             // Create and start the display thread.
             if (m_tile_callback.get() != nullptr && m_display_thread.get() == nullptr)
             {
+                if (m_params.m_preview_post_processing)
+                {
+                    m_post_processing_pipeline.reset(
+                        new PostProcessingPipeline(*m_project.get_frame(), m_params.m_thread_count));
+                }
+
                 m_display_func.reset(
                     new DisplayFunc(
                         *m_project.get_frame(),
@@ -626,6 +782,9 @@ namespace
                         m_sample_count_history,
                         m_sample_count_history_spinlock,
                         m_tile_callback.get(),
+                        m_post_processing_pipeline.get(),
+                        m_params.m_preview_denoising,
+                        m_params.m_thread_count,
                         m_params.m_max_fps,
                         m_display_thread_abort_switch));
                 m_display_thread.reset(
@@ -672,6 +831,11 @@ namespace
             m_job_manager->resume();
         }
 
+        void set_active_thread_count(const size_t thread_count) override
+        {
+            m_job_manager->set_active_thread_count(thread_count);
+        }
+
         void terminate_rendering() override
         {
             // Completely stop rendering.
@@ -697,41 +861,71 @@ namespace
             if (m_display_func.get())
             {
                 // Merge the last samples and display the final frame.
-                m_display_func->develop_and_display();
+                // The final frame is post-processed by the master renderer.
+                m_display_func->develop_and_display(false, true);
                 m_display_func.reset();
+                m_post_processing_pipeline.reset();
             }
             else
             {
                 // Just merge the last samples into the frame.
                 m_buffer->develop_to_frame(*m_project.get_frame(), m_abort_switch);
+                m_project.get_frame()->denoise_main_image(m_params.m_thread_count, &m_abort_switch);
             }
 
             // Merge and print sample generator statistics.
             print_sample_generators_stats();
         }
 
+        StatisticsVector get_statistics() const override
+        {
+            StatisticsVector stats;
+
+            for (auto sample_generator : m_sample_generators)
+                stats.merge(sample_generator->get_statistics());
+
+            if (m_granularity_controller)
+                stats.insert("job granularity (samples)", m_granularity_controller->get_statistics());
+
+            return stats;
+        }
+
       private:
         struct Parameters
         {
             const Spectrum::Mode                    m_spectrum_mode;
             const SamplingContext::Mode             m_sampling_mode;
             const size_t                            m_thread_count;       // number of rendering threads
+            const int                               m_thread_affinity_flags;
             const std::uint64_t                     m_max_average_spp;    // maximum average number of samples to compute per pixel
             const double                            m_time_limit;         // maximum rendering time in seconds
+            const float                             m_noise_target;       // stop rendering when the estimated noise level is below this value, 0 to disable
+            const ConvergenceRendererController::Mode m_noise_target_mode;
             const double                            m_max_fps;            // maximum display frequency in frames/second
             const bool                              m_perf_stats;         // collect and print performance statistics?
             const bool                              m_luminance_stats;    // collect and print luminance statistics?
+            const bool                              m_preview_post_processing;  // post-process progressive updates?
+            const bool                              m_preview_denoising;  // denoise progressive updates?
+            const bool                              m_adaptive_job_granularity;   // size jobs after their measured duration?
+            const double                            m_target_job_duration;  // in seconds
             SampleGeneratorJob::SamplingProfile     m_sampling_profile;
 
             explicit Parameters(const ParamArray& params)
               : m_spectrum_mode(get_spectrum_mode(params))
               , m_sampling_mode(get_sampling_context_mode(params))
               , m_thread_count(get_rendering_thread_count(params))
+              , m_thread_affinity_flags(get_rendering_thread_affinity_flags(params))
               , m_max_average_spp(params.get_optional<std::uint64_t>("max_average_spp", std::numeric_limits<std::uint64_t>::max()))
               , m_time_limit(params.get_optional<double>("time_limit", std::numeric_limits<double>::max()))
+              , m_noise_target(params.get_optional<float>("noise_target", 0.0f))
+              , m_noise_target_mode(ConvergenceRendererController::parse_mode(params.get_optional<std::string>("noise_target_mode", "global")))
               , m_max_fps(params.get_optional<double>("max_fps", 30.0))
               , m_perf_stats(params.get_optional<bool>("performance_statistics", false))
               , m_luminance_stats(params.get_optional<bool>("luminance_statistics", false))
+              , m_preview_post_processing(params.get_optional<bool>("preview_post_processing", false))
+              , m_preview_denoising(params.get_optional<bool>("preview_denoising", true))
+              , m_adaptive_job_granularity(params.get_optional<bool>("adaptive_job_granularity", false))
+              , m_target_job_duration(params.get_optional<double>("target_job_duration", 0.05))
             {
                 const SampleGeneratorJob::SamplingProfile default_sampling_profile;
                 m_sampling_profile.m_samples_in_uninterruptible_phase =
@@ -757,6 +951,7 @@ namespace
         Spinlock                                    m_sample_count_history_spinlock;
 
         std::unique_ptr<SampleAccumulationBuffer>   m_buffer;
+        std::unique_ptr<JobGranularityController>   m_granularity_controller;
 
         JobQueue                                    m_job_queue;
         std::unique_ptr<JobManager>                 m_job_manager;
@@ -767,6 +962,7 @@ namespace
 
         auto_release_ptr<ITileCallback>             m_tile_callback;
 
+        std::unique_ptr<PostProcessingPipeline>     m_post_processing_pipeline;
         std::unique_ptr<DisplayFunc>                m_display_func;
         std::unique_ptr<boost::thread>              m_display_thread;
         AbortSwitch                                 m_display_thread_abort_switch;
@@ -775,18 +971,17 @@ namespace
         std::unique_ptr<StatisticsFunc>             m_statistics_func;
         std::unique_ptr<boost::thread>              m_statistics_thread;
 
-        TimedRendererController                     m_renderer_controller;
+        TimedRendererController                     m_timed_renderer_controller;
+        std::unique_ptr<ConvergenceRendererController> m_convergence_renderer_controller;
+        RendererControllerCollection                m_renderer_controller;
 
         void print_sample_generators_stats() const
         {
             assert(!m_sample_generators.empty());
 
-            StatisticsVector stats;
-
-            for (auto sample_generator : m_sample_generators)
-                stats.merge(sample_generator->get_statistics());
-
+            const StatisticsVector stats = get_statistics();
             RENDERER_LOG_DEBUG("%s", stats.to_string().c_str());
+            RenderCostTracker::print_report(stats);
         }
     };
 }
@@ -826,6 +1021,55 @@ Dictionary ProgressiveFrameRendererFactory::get_params_metadata()
             .insert("label", "Time Limit:")
             .insert("help", "Maximum rendering time"));
 
+    metadata.dictionaries().insert(
+        "noise_target",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.0")
+            .insert("label", "Noise Target")
+            .insert("help", "Stop rendering once the estimated noise level falls below this value (0 to disable)"));
+
+    metadata.dictionaries().insert(
+        "noise_target_mode",
+        Dictionary()
+            .insert("type", "enum")
+            .insert("values", "global|per_tile")
+            .insert("default", "global")
+            .insert("label", "Noise Target Mode")
+            .insert("help", "Compare the noise target to the noise level of the whole frame or of its noisiest block of pixels"));
+
+    metadata.dictionaries().insert(
+        "preview_post_processing",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Preview Post-Processing")
+            .insert("help", "Apply tiled post-processing stages to progressive rendering updates"));
+
+    metadata.dictionaries().insert(
+        "preview_denoising",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "true")
+            .insert("label", "Preview Denoising")
+            .insert("help", "Denoise progressive rendering updates when the frame uses the Open Image Denoise denoiser"));
+
+    metadata.dictionaries().insert(
+        "adaptive_job_granularity",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Adaptive Job Granularity")
+            .insert("help", "Adjust the number of samples per rendering job to the measured duration of jobs"));
+
+    metadata.dictionaries().insert(
+        "target_job_duration",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.05")
+            .insert("label", "Target Job Duration")
+            .insert("help", "Duration in seconds of rendering jobs when adaptive job granularity is enabled"));
+
     return metadata;
 }
 
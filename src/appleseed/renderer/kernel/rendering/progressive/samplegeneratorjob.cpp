@@ -33,7 +33,9 @@
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
 #include "renderer/kernel/rendering/isamplegenerator.h"
+#include "renderer/kernel/rendering/jobgranularitycontroller.h"
 #include "renderer/kernel/rendering/progressive/samplecounter.h"
+#include "renderer/kernel/rendering/renderingmetrics.h"
 #include "renderer/kernel/rendering/sampleaccumulationbuffer.h"
 
 // appleseed.foundation headers.
@@ -42,6 +44,7 @@
 #include "foundation/math/scalar.h"
 #include "foundation/platform/defaulttimers.h"
 #include "foundation/platform/types.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/stopwatch.h"
 
 // Standard headers.
@@ -82,6 +85,7 @@ SampleGeneratorJob::SampleGeneratorJob(
     ISampleGenerator*           sample_generator,
     SampleCounter&              sample_counter,
     const SamplingProfile&      sampling_profile,
+    const JobGranularityController* granularity_controller,
     const Spectrum::Mode        spectrum_mode,
     JobQueue&                   job_queue,
     const size_t                job_index,
@@ -90,6 +94,7 @@ SampleGeneratorJob::SampleGeneratorJob(
   , m_sample_generator(sample_generator)
   , m_sample_counter(sample_counter)
   , m_sampling_profile(sampling_profile)
+  , m_granularity_controller(granularity_controller)
   , m_spectrum_mode(spectrum_mode)
   , m_job_queue(job_queue)
   , m_job_index(job_index)
@@ -99,6 +104,9 @@ SampleGeneratorJob::SampleGeneratorJob(
 
 void SampleGeneratorJob::execute(const size_t thread_index)
 {
+    APPLESEED_TRACE_SCOPE("rendering", "generate samples");
+    ScopedRenderingThread rendering_thread;
+
     // Initialize thread-local variables.
     Spectrum::set_mode(m_spectrum_mode);
 
@@ -108,23 +116,30 @@ void SampleGeneratorJob::execute(const size_t thread_index)
     const double t1 = stopwatch.get_seconds();
 #endif
 
+    // Terminate this job if every pixel has converged.
+    if (m_buffer.is_converged())
+        return;
+
     // We will base the number of samples to be rendered by this job on
     // the number of samples already reserved (not necessarily rendered).
     const std::uint64_t current_sample_count = m_sample_counter.read();
 
+    // The first phase is uninterruptible in order to always have something to
+    // show during navigation. todo: the renderer freezes if it cannot generate
+    // samples during this phase; fix.
+    const bool abortable = current_sample_count > m_sampling_profile.m_samples_in_uninterruptible_phase;
+
     // Reserve a number of samples to be rendered by this job.
-    const std::uint64_t job_sample_count = m_sampling_profile.get_job_sample_count(current_sample_count);
+    const std::uint64_t job_sample_count =
+        m_granularity_controller != nullptr && abortable
+            ? m_granularity_controller->get_job_size()
+            : m_sampling_profile.get_job_sample_count(current_sample_count);
     const std::uint64_t acquired_sample_count = m_sample_counter.reserve(job_sample_count);
 
-    // Terminate this job is there are no more samples to render.
+    // Terminate this job if there are no more samples to render.
     if (acquired_sample_count == 0)
         return;
 
-    // The first phase is uninterruptible in order to always have something to
-    // show during navigation. todo: the renderer freezes if it cannot generate
-    // samples during this phase; fix.
-    const bool abortable = current_sample_count > m_sampling_profile.m_samples_in_uninterruptible_phase;
-
     // Render the samples and store them into the accumulation buffer.
     if (abortable)
     {
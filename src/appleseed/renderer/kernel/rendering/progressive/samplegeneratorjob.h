@@ -41,6 +41,7 @@
 
 // Forward declarations.
 namespace renderer  { class ISampleGenerator; }
+namespace renderer  { class JobGranularityController; }
 namespace renderer  { class SampleAccumulationBuffer; }
 namespace renderer  { class SampleCounter; }
 
@@ -72,12 +73,14 @@ class SampleGeneratorJob
         std::uint64_t get_job_sample_count(const std::uint64_t samples) const;
     };
 
-    // Constructor.
+    // Constructor. If `granularity_controller` is not null, jobs render as many samples as it
+    // dictates once the uninterruptible phase of the sampling profile is over.
     SampleGeneratorJob(
         SampleAccumulationBuffer&   buffer,
         ISampleGenerator*           sample_generator,
         SampleCounter&              sample_counter,
         const SamplingProfile&      sampling_profile,
+        const JobGranularityController* granularity_controller,
         const Spectrum::Mode        spectrum_mode,
         foundation::JobQueue&       job_queue,
         const size_t                job_index,
@@ -91,6 +94,7 @@ class SampleGeneratorJob
     ISampleGenerator*               m_sample_generator;
     SampleCounter&                  m_sample_counter;
     const SamplingProfile           m_sampling_profile;
+    const JobGranularityController* m_granularity_controller;
     const Spectrum::Mode            m_spectrum_mode;
     foundation::JobQueue&           m_job_queue;
     const size_t                    m_job_index;
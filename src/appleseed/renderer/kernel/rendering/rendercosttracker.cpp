@@ -0,0 +1,286 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "rendercosttracker.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/modeling/material/material.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/shadergroup/shadergroup.h"
+
+// appleseed.foundation headers.
+#include "foundation/string/string.h"
+#include "foundation/utility/api/apistring.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    const char* CostStatisticsName = "render cost statistics";
+
+    // Maximum number of entities listed in a breakdown, by decreasing cost.
+    const size_t MaxListedEntities = 10;
+
+    //
+    // A statistics entry holding the costs of a set of entities, identified by name.
+    // Merging two entries sums the costs of entities with the same name.
+    //
+
+    struct CostBreakdownEntry
+      : public Statistics::Entry
+    {
+        typedef std::map<std::string, RenderCostTracker::Cost> CostMap;
+
+        CostMap     m_costs;
+        bool        m_report_rays;
+
+        CostBreakdownEntry(
+            const std::string&  name,
+            const bool          report_rays)
+          : Entry(name)
+          , m_report_rays(report_rays)
+        {
+        }
+
+        std::unique_ptr<Entry> clone() const override
+        {
+            return std::unique_ptr<Entry>(new CostBreakdownEntry(*this));
+        }
+
+        void merge(const Entry* other) override
+        {
+            for (const auto& cost : cast<CostBreakdownEntry>(other)->m_costs)
+                m_costs[cost.first] += cost.second;
+        }
+
+        std::string to_string() const override
+        {
+            typedef std::pair<double, const CostMap::value_type*> SortedCost;
+
+            std::vector<SortedCost> sorted_costs;
+            sorted_costs.reserve(m_costs.size());
+
+            double total_seconds = 0.0;
+            std::uint64_t total_ray_count = 0;
+
+            for (const auto& cost : m_costs)
+            {
+                const double seconds = cost.second.get_estimated_seconds();
+                sorted_costs.emplace_back(seconds, &cost);
+                total_seconds += seconds;
+                total_ray_count += cost.second.m_ray_count;
+            }
+
+            std::sort(
+                sorted_costs.begin(),
+                sorted_costs.end(),
+                [](const SortedCost& lhs, const SortedCost& rhs)
+                {
+                    return lhs.first > rhs.first;
+                });
+
+            std::stringstream sstr;
+            sstr << pretty_time(total_seconds);
+            if (m_report_rays)
+                sstr << ", " << pretty_uint(total_ray_count) << " rays";
+            sstr << " over " << pretty_uint(m_costs.size()) << " " << plural(m_costs.size(), "entity", "entities");
+
+            const size_t listed_count = std::min(sorted_costs.size(), MaxListedEntities);
+
+            for (size_t i = 0; i < listed_count; ++i)
+            {
+                const std::string& name = sorted_costs[i].second->first;
+                const RenderCostTracker::Cost& cost = sorted_costs[i].second->second;
+
+                sstr << std::endl << "    ";
+                sstr << pretty_percent(sorted_costs[i].first, total_seconds) << "%  ";
+                sstr << pretty_time(sorted_costs[i].first);
+                if (m_report_rays)
+                    sstr << ", " << pretty_uint(cost.m_ray_count) << " rays";
+                sstr << ", " << pretty_uint(cost.m_event_count) << " calls";
+                sstr << "  " << name;
+            }
+
+            if (listed_count < sorted_costs.size())
+                sstr << std::endl << "    ...";
+
+            return sstr.str();
+        }
+    };
+
+    std::string get_object_instance_label(const ObjectInstance& object_instance)
+    {
+        std::stringstream sstr;
+        sstr << object_instance.get_path().c_str() << " (id " << RenderCostTracker::get_object_instance_id(object_instance) << ")";
+        return sstr.str();
+    }
+}
+
+
+//
+// RenderCostTracker::Cost class implementation.
+//
+
+RenderCostTracker::Cost::Cost()
+  : m_event_count(0)
+  , m_timed_event_count(0)
+  , m_timed_nanoseconds(0)
+  , m_ray_count(0)
+{
+}
+
+RenderCostTracker::Cost& RenderCostTracker::Cost::operator+=(const Cost& rhs)
+{
+    m_event_count += rhs.m_event_count;
+    m_timed_event_count += rhs.m_timed_event_count;
+    m_timed_nanoseconds += rhs.m_timed_nanoseconds;
+    m_ray_count += rhs.m_ray_count;
+    return *this;
+}
+
+double RenderCostTracker::Cost::get_estimated_seconds() const
+{
+    if (m_timed_event_count == 0)
+        return 0.0;
+
+    const double timed_seconds = static_cast<double>(m_timed_nanoseconds) * 1.0e-9;
+
+    return timed_seconds * (static_cast<double>(m_event_count) / m_timed_event_count);
+}
+
+
+//
+// RenderCostTracker class implementation.
+//
+
+RenderCostTracker::RenderCostTracker(
+    const Intersector&          intersector,
+    const size_t                timing_interval)
+  : m_intersector(intersector)
+  , m_timing_interval(std::max<size_t>(timing_interval, 1))
+  , m_hits_until_timing(1)
+  , m_shader_groups_until_timing(1)
+{
+}
+
+StatisticsVector RenderCostTracker::get_statistics() const
+{
+    std::unique_ptr<CostBreakdownEntry> object_instances(new CostBreakdownEntry("object instances", true));
+    for (const auto& cost : m_object_instance_costs)
+    {
+        const ObjectInstance* object_instance = static_cast<const ObjectInstance*>(cost.first);
+        object_instances->m_costs[get_object_instance_label(*object_instance)] += cost.second;
+    }
+
+    std::unique_ptr<CostBreakdownEntry> materials(new CostBreakdownEntry("materials", true));
+    for (const auto& cost : m_material_costs)
+        materials->m_costs[cost.first->get_path().c_str()] += cost.second;
+
+    std::unique_ptr<CostBreakdownEntry> shader_groups(new CostBreakdownEntry("shader groups", false));
+    for (const auto& cost : m_shader_group_costs)
+        shader_groups->m_costs[cost.first->get_path().c_str()] += cost.second;
+
+    Statistics stats;
+    stats.insert(std::move(object_instances));
+    stats.insert(std::move(materials));
+    stats.insert(std::move(shader_groups));
+
+    return StatisticsVector::make(CostStatisticsName, stats);
+}
+
+void RenderCostTracker::print_report(const StatisticsVector& stats)
+{
+    // Cost attribution is opt-in, so its report is printed even when debug messages are hidden.
+    const Statistics* cost_stats = stats.get(CostStatisticsName);
+
+    if (cost_stats != nullptr)
+        RENDERER_LOG_INFO("%s:\n%s", CostStatisticsName, cost_stats->to_string().c_str());
+}
+
+std::uint32_t RenderCostTracker::get_object_instance_id(const ObjectInstance& object_instance)
+{
+    return static_cast<std::uint32_t>(object_instance.get_uid() + 1);
+}
+
+void RenderCostTracker::record_hit(
+    const ShadingPoint&         shading_point,
+    const std::uint64_t         ray_count,
+    const bool                  timed,
+    const std::uint64_t         nanoseconds)
+{
+    assert(shading_point.hit_surface());
+
+    const ObjectInstance& object_instance = shading_point.get_object_instance();
+    record(m_object_instance_costs[&object_instance], ray_count, timed, nanoseconds);
+
+    const Material* material = shading_point.get_material();
+    if (material != nullptr)
+        record(m_material_costs[material], ray_count, timed, nanoseconds);
+}
+
+void RenderCostTracker::record_shader_group(
+    const ShaderGroup&          shader_group,
+    const bool                  timed,
+    const std::uint64_t         nanoseconds)
+{
+    record(m_shader_group_costs[&shader_group], 0, timed, nanoseconds);
+}
+
+void RenderCostTracker::record(
+    Cost&                       cost,
+    const std::uint64_t         ray_count,
+    const bool                  timed,
+    const std::uint64_t         nanoseconds)
+{
+    ++cost.m_event_count;
+    cost.m_ray_count += ray_count;
+
+    if (timed)
+    {
+        ++cost.m_timed_event_count;
+        cost.m_timed_nanoseconds += nanoseconds;
+    }
+}
+
+}   // namespace renderer
@@ -0,0 +1,269 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/intersection/intersector.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/statistics.h"
+
+// Standard headers.
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// Forward declarations.
+namespace renderer  { class Entity; }
+namespace renderer  { class ObjectInstance; }
+namespace renderer  { class ShaderGroup; }
+namespace renderer  { class ShadingPoint; }
+
+namespace renderer
+{
+
+//
+// Attributes rendering time and ray counts to object instances, materials and OSL
+// shader groups, to find out which parts of a scene make it expensive to render.
+//
+// The cost of a surface hit seen from the camera (or through transparent surfaces)
+// is the time and the number of rays spent shading it, including all the paths
+// traced from it. It is attributed to the object instance and to the material of
+// the hit. The cost of a shader group is the time spent executing it, at any depth.
+//
+// Reading the clock at every event would slow rendering down noticeably, so only one
+// out of every N events is timed, and the time of the other events is extrapolated
+// from the timed ones. Ray counts are exact.
+//
+// There is one tracker per rendering thread. Breakdowns are reported as statistics,
+// merged across threads at the end of the render.
+//
+
+class RenderCostTracker
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    RenderCostTracker(
+        const Intersector&          intersector,
+        const size_t                timing_interval);
+
+    // Measure the cost of shading a surface hit for the lifetime of this object.
+    class HitScope
+      : public foundation::NonCopyable
+    {
+      public:
+        HitScope(
+            RenderCostTracker*      tracker,
+            const ShadingPoint&     shading_point);
+
+        ~HitScope();
+
+      private:
+        RenderCostTracker*          m_tracker;
+        const ShadingPoint&         m_shading_point;
+        std::uint64_t               m_initial_ray_count;
+        std::uint64_t               m_start_time;
+        bool                        m_timed;
+    };
+
+    // Measure the cost of executing a shader group for the lifetime of this object.
+    class ShaderGroupScope
+      : public foundation::NonCopyable
+    {
+      public:
+        ShaderGroupScope(
+            RenderCostTracker*      tracker,
+            const ShaderGroup&      shader_group);
+
+        ~ShaderGroupScope();
+
+      private:
+        RenderCostTracker*          m_tracker;
+        const ShaderGroup&          m_shader_group;
+        std::uint64_t               m_start_time;
+        bool                        m_timed;
+    };
+
+    // Cost of the events attributed to one entity.
+    struct Cost
+    {
+        std::uint64_t               m_event_count;
+        std::uint64_t               m_timed_event_count;
+        std::uint64_t               m_timed_nanoseconds;
+        std::uint64_t               m_ray_count;
+
+        Cost();
+
+        Cost& operator+=(const Cost& rhs);
+
+        // Return the estimated time spent in all events, in seconds.
+        double get_estimated_seconds() const;
+    };
+
+    // Return the cost breakdowns of all events recorded so far.
+    foundation::StatisticsVector get_statistics() const;
+
+    // Print the cost breakdowns found in the merged statistics of a render, if any.
+    static void print_report(const foundation::StatisticsVector& stats);
+
+    // Return the identifier of an object instance in cost reports and in the render cost AOV.
+    // Identifier 0 is reserved for samples that do not hit any surface.
+    static std::uint32_t get_object_instance_id(const ObjectInstance& object_instance);
+
+  private:
+    typedef std::unordered_map<const Entity*, Cost> CostMap;
+
+    const Intersector&              m_intersector;
+    const size_t                    m_timing_interval;
+    size_t                          m_hits_until_timing;
+    size_t                          m_shader_groups_until_timing;
+
+    CostMap                         m_object_instance_costs;
+    CostMap                         m_material_costs;
+    CostMap                         m_shader_group_costs;
+
+    static std::uint64_t read_time();
+
+    bool should_time(size_t& events_until_timing);
+
+    void record_hit(
+        const ShadingPoint&         shading_point,
+        const std::uint64_t         ray_count,
+        const bool                  timed,
+        const std::uint64_t         nanoseconds);
+
+    void record_shader_group(
+        const ShaderGroup&          shader_group,
+        const bool                  timed,
+        const std::uint64_t         nanoseconds);
+
+    static void record(
+        Cost&                       cost,
+        const std::uint64_t         ray_count,
+        const bool                  timed,
+        const std::uint64_t         nanoseconds);
+
+    static foundation::Statistics make_breakdown(
+        const char*                 entity_kind,
+        const CostMap&              costs);
+};
+
+
+//
+// RenderCostTracker class implementation.
+//
+
+inline std::uint64_t RenderCostTracker::read_time()
+{
+    return
+        static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+inline bool RenderCostTracker::should_time(size_t& events_until_timing)
+{
+    if (--events_until_timing > 0)
+        return false;
+
+    events_until_timing = m_timing_interval;
+    return true;
+}
+
+
+//
+// RenderCostTracker::HitScope class implementation.
+//
+
+inline RenderCostTracker::HitScope::HitScope(
+    RenderCostTracker*          tracker,
+    const ShadingPoint&         shading_point)
+  : m_tracker(tracker)
+  , m_shading_point(shading_point)
+  , m_initial_ray_count(0)
+  , m_start_time(0)
+  , m_timed(false)
+{
+    if (m_tracker)
+    {
+        m_initial_ray_count = m_tracker->m_intersector.get_ray_count();
+        m_timed = m_tracker->should_time(m_tracker->m_hits_until_timing);
+        if (m_timed)
+            m_start_time = read_time();
+    }
+}
+
+inline RenderCostTracker::HitScope::~HitScope()
+{
+    if (m_tracker)
+    {
+        m_tracker->record_hit(
+            m_shading_point,
+            m_tracker->m_intersector.get_ray_count() - m_initial_ray_count,
+            m_timed,
+            m_timed ? read_time() - m_start_time : 0);
+    }
+}
+
+
+//
+// RenderCostTracker::ShaderGroupScope class implementation.
+//
+
+inline RenderCostTracker::ShaderGroupScope::ShaderGroupScope(
+    RenderCostTracker*          tracker,
+    const ShaderGroup&          shader_group)
+  : m_tracker(tracker)
+  , m_shader_group(shader_group)
+  , m_start_time(0)
+  , m_timed(false)
+{
+    if (m_tracker)
+    {
+        m_timed = m_tracker->should_time(m_tracker->m_shader_groups_until_timing);
+        if (m_timed)
+            m_start_time = read_time();
+    }
+}
+
+inline RenderCostTracker::ShaderGroupScope::~ShaderGroupScope()
+{
+    if (m_tracker)
+    {
+        m_tracker->record_shader_group(
+            m_shader_group,
+            m_timed,
+            m_timed ? read_time() - m_start_time : 0);
+    }
+}
+
+}   // namespace renderer
@@ -33,6 +33,7 @@
 #include "renderer/global/globallogger.h"
 #include "renderer/kernel/lighting/bdpt/bdptlightingengine.h"
 #include "renderer/kernel/lighting/lighttracing/lighttracingsamplegenerator.h"
+#include "renderer/kernel/lighting/pt/ptpasscallback.h"
 #include "renderer/kernel/lighting/pt/ptlightingengine.h"
 #include "renderer/kernel/lighting/sppm/sppmlightingengine.h"
 #include "renderer/kernel/lighting/sppm/sppmparameters.h"
@@ -50,9 +51,11 @@
 #include "renderer/kernel/rendering/generic/genericsamplerenderer.h"
 #include "renderer/kernel/rendering/generic/generictilerenderer.h"
 #include "renderer/kernel/rendering/permanentshadingresultframebufferfactory.h"
+#include "renderer/kernel/rendering/phasetimer.h"
 #include "renderer/kernel/rendering/progressive/progressiveframerenderer.h"
 #include "renderer/kernel/shading/oslshadingsystem.h"
 #include "renderer/kernel/texturing/oiiotexturesystem.h"
+#include "renderer/modeling/frame/frame.h"
 #include "renderer/modeling/project/project.h"
 #include "renderer/utility/paramarray.h"
 
@@ -62,7 +65,9 @@
 #include "foundation/platform/_endoiioheaders.h"
 
 // Standard headers.
+#include <cassert>
 #include <string>
+#include <utility>
 
 using namespace foundation;
 using namespace OIIO;
@@ -94,6 +99,7 @@ namespace
         copy_param(child, source, "spectrum_mode");
         copy_param(child, source, "sampling_mode");
         copy_param(child, source, "rendering_threads");
+        copy_param(child, source, "rendering_thread_affinity");
         return child;
     }
 }
@@ -111,15 +117,31 @@ RendererComponents::RendererComponents(
   , m_scene(*project.get_scene())
   , m_frame(*project.get_frame())
   , m_trace_context(project.get_trace_context())
+  , m_light_sampler_params(get_child_and_inherit_globals(params, "light_sampler"))
   , m_forward_light_sampler(nullptr)
   , m_backward_light_sampler(nullptr)
   , m_shading_engine(get_child_and_inherit_globals(params, "shading_engine"))
   , m_texture_store(texture_store)
   , m_oiio_texture_system(texture_system)
   , m_osl_shading_system(shading_system)
+  , m_dl_reservoirs(nullptr)
 {
 }
 
+void RendererComponents::reuse_light_samplers(RendererComponents& other)
+{
+    assert(&m_scene == &other.m_scene);
+
+    if (m_light_sampler_params != other.m_light_sampler_params)
+        return;
+
+    if (!m_forward_light_sampler)
+        m_forward_light_sampler = std::move(other.m_forward_light_sampler);
+
+    if (!m_backward_light_sampler)
+        m_backward_light_sampler = std::move(other.m_backward_light_sampler);
+}
+
 bool RendererComponents::create()
 {
     if (!create_shading_result_framebuffer_factory())
@@ -169,9 +191,38 @@ bool RendererComponents::on_frame_begin(
     if (!m_shading_engine.on_frame_begin(m_project, recorder, abort_switch))
         return false;
 
+    if (m_backward_light_sampler)
+        m_backward_light_sampler->refit_light_tree();
+
+    // The camera or the scene may have changed since the last frame.
+    if (m_visibility_buffer)
+        m_visibility_buffer->invalidate();
+    if (m_dl_reservoirs)
+        m_dl_reservoirs->clear();
+
     return true;
 }
 
+void RendererComponents::create_forward_light_sampler()
+{
+    if (!m_forward_light_sampler)
+    {
+        PhaseTimer phase_timer;
+        m_forward_light_sampler.reset(new ForwardLightSampler(m_scene, m_light_sampler_params));
+        phase_timer.record(m_project.get_frame()->render_info(), "light_sampler_build");
+    }
+}
+
+void RendererComponents::create_backward_light_sampler()
+{
+    if (!m_backward_light_sampler)
+    {
+        PhaseTimer phase_timer;
+        m_backward_light_sampler.reset(new BackwardLightSampler(m_scene, m_light_sampler_params));
+        phase_timer.record(m_project.get_frame()->render_info(), "light_sampler_build");
+    }
+}
+
 bool RendererComponents::create_lighting_engine_factory()
 {
     const std::string name = m_params.get_required<std::string>("lighting_engine", "pt");
@@ -182,25 +233,57 @@ bool RendererComponents::create_lighting_engine_factory()
     }
     else if (name == "pt")
     {
-        m_backward_light_sampler.reset(
-            new BackwardLightSampler(
-                m_scene,
-                get_child_and_inherit_globals(m_params, "light_sampler")));
+        create_backward_light_sampler();
+
+        const ParamArray pt_params = get_child_and_inherit_globals(m_params, "pt");    // todo: change to "pt_lighting_engine"?
+
+        SDTree* sd_tree = nullptr;
+        RadianceEstimateGrid* radiance_estimates = nullptr;
+        RadianceCache* radiance_cache = nullptr;
+
+        if (pt_params.get_optional<bool>("enable_path_guiding", false) ||
+            pt_params.get_optional<bool>("enable_adaptive_rr", false) ||
+            pt_params.get_optional<bool>("enable_radiance_cache", false) ||
+            pt_params.get_optional<bool>("enable_dl_resampling", false))
+        {
+            // Path guiding, adaptive Russian Roulette, radiance caching and resampled direct lighting
+            // learn between passes, which only the generic frame renderer has.
+            if (m_params.get_optional<std::string>("frame_renderer", "generic") == "generic")
+            {
+                PTPassCallback* pt_pass_callback =
+                    new PTPassCallback(m_scene, m_frame, pt_params);
+
+                m_pass_callback.reset(pt_pass_callback);
+
+                sd_tree = pt_pass_callback->get_sd_tree();
+                radiance_estimates = pt_pass_callback->get_radiance_estimates();
+                radiance_cache = pt_pass_callback->get_radiance_cache();
+                m_dl_reservoirs = pt_pass_callback->get_dl_reservoirs();
+            }
+            else
+            {
+                RENDERER_LOG_WARNING(
+                    "path guiding, adaptive russian roulette, radiance caching and resampled direct lighting "
+                    "require the generic frame renderer; disabling them.");
+            }
+        }
 
         m_lighting_engine_factory.reset(
             new PTLightingEngineFactory(
+                m_scene,
                 *m_backward_light_sampler,
                 m_project.get_light_path_recorder(),
-                get_child_and_inherit_globals(m_params, "pt")));    // todo: change to "pt_lighting_engine"?
+                sd_tree,
+                radiance_estimates,
+                radiance_cache,
+                m_dl_reservoirs,
+                pt_params));
 
         return true;
     }
     else if (name == "bdpt")
     {
-        m_forward_light_sampler.reset(
-            new ForwardLightSampler(
-                m_scene,
-                get_child_and_inherit_globals(m_params, "light_sampler")));
+        create_forward_light_sampler();
 
         m_lighting_engine_factory.reset(
             new BDPTLightingEngineFactory(
@@ -212,15 +295,9 @@ bool RendererComponents::create_lighting_engine_factory()
     }
     else if (name == "sppm")
     {
-        m_forward_light_sampler.reset(
-            new ForwardLightSampler(
-                m_scene,
-                get_child_and_inherit_globals(m_params, "light_sampler")));
+        create_forward_light_sampler();
 
-        m_backward_light_sampler.reset(
-            new BackwardLightSampler(
-                m_scene,
-                get_child_and_inherit_globals(m_params, "light_sampler")));
+        create_backward_light_sampler();
 
         const SPPMParameters sppm_params(
             get_child_and_inherit_globals(m_params, "sppm"));
@@ -266,6 +343,20 @@ bool RendererComponents::create_sample_renderer_factory()
     }
     else if (name == "generic")
     {
+        const ParamArray params = get_child_and_inherit_globals(m_params, "generic_sample_renderer");
+
+        if (params.get_optional<bool>("rasterize_primary_visibility", false))
+        {
+            // The visibility buffer is rasterized from the active camera only.
+            if (m_frame.get_view_count() > 0)
+            {
+                RENDERER_LOG_WARNING(
+                    "primary visibility rasterization is not supported with multi-view frames; "
+                    "tracing primary rays instead.");
+            }
+            else m_visibility_buffer.reset(new VisibilityBuffer(m_scene, m_frame));
+        }
+
         m_sample_renderer_factory.reset(
             new GenericSampleRendererFactory(
                 m_scene,
@@ -276,7 +367,8 @@ bool RendererComponents::create_sample_renderer_factory()
                 m_shading_engine,
                 m_oiio_texture_system,
                 m_osl_shading_system,
-                get_child_and_inherit_globals(m_params, "generic_sample_renderer")));
+                m_visibility_buffer.get(),
+                params));
         return true;
     }
     else if (name == "blank")
@@ -324,10 +416,13 @@ bool RendererComponents::create_sample_generator_factory()
     }
     else if (name == "lighttracing")
     {
-        m_forward_light_sampler.reset(
-            new ForwardLightSampler(
-                m_scene,
-                get_child_and_inherit_globals(m_params, "light_sampler")));
+        if (m_frame.get_view_count() > 0)
+        {
+            RENDERER_LOG_ERROR("cannot use the light tracing sample generator with multi-view frames.");
+            return false;
+        }
+
+        create_forward_light_sampler();
 
         m_sample_generator_factory.reset(
             new LightTracingSampleGeneratorFactory(
@@ -32,6 +32,7 @@
 #include "renderer/kernel/lighting/backwardlightsampler.h"
 #include "renderer/kernel/lighting/forwardlightsampler.h"
 #include "renderer/kernel/lighting/ilightingengine.h"
+#include "renderer/kernel/rasterization/visibilitybuffer.h"
 #include "renderer/kernel/rendering/iframerenderer.h"
 #include "renderer/kernel/rendering/ipasscallback.h"
 #include "renderer/kernel/rendering/ipixelrenderer.h"
@@ -40,6 +41,7 @@
 #include "renderer/kernel/rendering/ishadingresultframebufferfactory.h"
 #include "renderer/kernel/rendering/itilerenderer.h"
 #include "renderer/kernel/shading/shadingengine.h"
+#include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
 #include "foundation/memory/autoreleaseptr.h"
@@ -49,6 +51,7 @@
 
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
+namespace renderer      { class DirectLightingReservoirs; }
 namespace renderer      { class Frame; }
 namespace renderer      { class IFrameRenderer; }
 namespace renderer      { class ITileCallbackFactory; }
@@ -56,7 +59,6 @@ namespace renderer      { class OIIOTextureSystem; }
 namespace renderer      { class OnFrameBeginRecorder; }
 namespace renderer      { class OnRenderBeginRecorder; }
 namespace renderer      { class OSLShadingSystem; }
-namespace renderer      { class ParamArray; }
 namespace renderer      { class Project; }
 namespace renderer      { class Scene; }
 namespace renderer      { class TextureStore; }
@@ -82,6 +84,11 @@ class RendererComponents
         OIIOTextureSystem&          texture_system,
         OSLShadingSystem&           shading_system);
 
+    // Take over the light samplers of another set of components, if they were built with
+    // the same light sampler parameters. Only valid if lights and geometry did not change
+    // since the other components were created. Must be called before create().
+    void reuse_light_samplers(RendererComponents& other);
+
     // Create all components as specified by the parameters passed at construction.
     bool create();
 
@@ -115,6 +122,7 @@ class RendererComponents
     const Scene&                                        m_scene;
     const Frame&                                        m_frame;
     const TraceContext&                                 m_trace_context;
+    const ParamArray                                    m_light_sampler_params;
     std::unique_ptr<ForwardLightSampler>                m_forward_light_sampler;
     std::unique_ptr<BackwardLightSampler>               m_backward_light_sampler;
     ShadingEngine                                       m_shading_engine;
@@ -124,13 +132,17 @@ class RendererComponents
 
     std::unique_ptr<IShadingResultFrameBufferFactory>   m_shading_result_framebuffer_factory;
     std::unique_ptr<ILightingEngineFactory>             m_lighting_engine_factory;
+    std::unique_ptr<VisibilityBuffer>                   m_visibility_buffer;
     std::unique_ptr<ISampleRendererFactory>             m_sample_renderer_factory;
     std::unique_ptr<ISampleGeneratorFactory>            m_sample_generator_factory;
     std::unique_ptr<IPixelRendererFactory>              m_pixel_renderer_factory;
     std::unique_ptr<ITileRendererFactory>               m_tile_renderer_factory;
     std::unique_ptr<IPassCallback>                      m_pass_callback;
+    DirectLightingReservoirs*                           m_dl_reservoirs;        // owned by m_pass_callback
     foundation::auto_release_ptr<IFrameRenderer>        m_frame_renderer;
 
+    void create_forward_light_sampler();
+    void create_backward_light_sampler();
     bool create_lighting_engine_factory();
     bool create_sample_renderer_factory();
     bool create_sample_generator_factory();
@@ -110,6 +110,17 @@ IRendererController::Status RendererControllerCollection::get_status() const
     return IRendererController::ContinueRendering;
 }
 
+size_t RendererControllerCollection::get_active_thread_count() const
+{
+    for (auto i : impl->m_renderer_controller)
+    {
+        const size_t thread_count = i->get_active_thread_count();
+        if (thread_count > 0)
+            return thread_count;
+    }
+    return 0;
+}
+
 void RendererControllerCollection::insert(IRendererController* renderer_controller)
 {
     impl->m_renderer_controller.push_back(renderer_controller);
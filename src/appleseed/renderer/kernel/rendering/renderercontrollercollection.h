@@ -60,6 +60,7 @@ class APPLESEED_DLLSYMBOL RendererControllerCollection
     void on_frame_end() override;
     void on_progress() override;
     Status get_status() const override;
+    size_t get_active_thread_count() const override;
 
     // Insert a renderer controller into the collection.
     void insert(IRendererController* renderer_controller);
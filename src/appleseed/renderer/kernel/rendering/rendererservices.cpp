@@ -39,16 +39,23 @@
 #include "renderer/modeling/camera/camera.h"
 #include "renderer/modeling/frame/frame.h"
 #include "renderer/modeling/project/project.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/objectinstance.h"
 #include "renderer/modeling/scene/scene.h"
 #include "renderer/modeling/scene/visibilityflags.h"
+#include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/containers/dictionary.h"
 #include "foundation/core/version.h"
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/image.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/foreach.h"
 
 // Standard headers.
 #include <limits>
+#include <vector>
 
 using namespace foundation;
 
@@ -162,6 +169,116 @@ void RendererServices::initialize(TextureStore& texture_store)
     const CanvasProperties& props = m_project.get_frame()->image().properties();
     m_resolution[0] = static_cast<int>(props.m_canvas_width);
     m_resolution[1] = static_cast<int>(props.m_canvas_height);
+
+    // Collect the user attributes of object instances.
+    UserAttributeNameSetType previous_user_attribute_names;
+    previous_user_attribute_names.swap(m_user_attribute_names);
+    m_user_attributes.clear();
+    collect_user_attributes(m_project.get_scene()->assemblies());
+
+    // Shader groups lock the parameters that cannot be bound to user data;
+    // they must be optimized again if the set of user attribute names changed.
+    if (m_user_attribute_names != previous_user_attribute_names)
+        m_project.get_scene()->release_optimized_osl_shader_groups();
+}
+
+void RendererServices::collect_user_attributes(const AssemblyContainer& assemblies)
+{
+    for (const Assembly& assembly : assemblies)
+    {
+        for (const ObjectInstance& object_instance : assembly.object_instances())
+        {
+            const ParamArray& params = object_instance.get_parameters();
+
+            if (!params.dictionaries().exist("user_attributes"))
+                continue;
+
+            const StringDictionary& attributes = params.child("user_attributes").strings();
+
+            for (const_each<StringDictionary> i = attributes; i; ++i)
+            {
+                const OIIO::ustring name(i->key());
+
+                UserAttribute& attribute = m_user_attributes[UserAttributeKey(&object_instance, name)];
+                parse_user_attribute(i->value(), attribute);
+
+                m_user_attribute_names.insert(name);
+            }
+        }
+
+        collect_user_attributes(assembly.assemblies());
+    }
+}
+
+void RendererServices::parse_user_attribute(
+    const char*                 value,
+    UserAttribute&              attribute)
+{
+    std::vector<std::string> tokens;
+    tokenize(value, Blanks, tokens);
+
+    // One or three numbers make a float or a triple; anything else is a string.
+    if (tokens.size() == 1 || tokens.size() == 3)
+    {
+        try
+        {
+            for (size_t i = 0; i < tokens.size(); ++i)
+                attribute.m_values[i] = from_string<float>(tokens[i]);
+
+            if (tokens.size() == 1)
+            {
+                attribute.m_type = OIIO::TypeDesc::TypeFloat;
+                attribute.m_values[1] = attribute.m_values[2] = attribute.m_values[0];
+            }
+            else attribute.m_type = OIIO::TypeDesc::TypeColor;
+
+            return;
+        }
+        catch (const ExceptionStringConversionError&)
+        {
+        }
+    }
+
+    attribute.m_type = OIIO::TypeDesc::TypeString;
+    attribute.m_string = OIIO::ustring(value);
+}
+
+bool RendererServices::get_user_attribute(
+    const UserAttribute&        attribute,
+    bool                        derivatives,
+    OIIO::TypeDesc              type,
+    void*                       val)
+{
+    if (attribute.m_type == OIIO::TypeDesc::TypeString)
+    {
+        if (type != OIIO::TypeDesc::TypeString)
+            return false;
+
+        reinterpret_cast<OIIO::ustring*>(val)[0] = attribute.m_string;
+        return true;
+    }
+
+    if (type == OIIO::TypeDesc::TypeFloat)
+        reinterpret_cast<float*>(val)[0] = attribute.m_values[0];
+    else if (type == OIIO::TypeDesc::TypeInt)
+        reinterpret_cast<int*>(val)[0] = static_cast<int>(attribute.m_values[0]);
+    else if (
+        type == OIIO::TypeDesc::TypeColor  ||
+        type == OIIO::TypeDesc::TypeVector ||
+        type == OIIO::TypeDesc::TypePoint  ||
+        type == OIIO::TypeDesc::TypeNormal)
+    {
+        // Scalars are broadcast to all three components.
+        reinterpret_cast<float*>(val)[0] = attribute.m_values[0];
+        reinterpret_cast<float*>(val)[1] = attribute.m_values[1];
+        reinterpret_cast<float*>(val)[2] = attribute.m_values[2];
+    }
+    else return false;
+
+    if (derivatives)
+        clear_derivatives(type, val);
+
+    return true;
 }
 
 OIIO::TextureSystem* RendererServices::texturesys() const
@@ -606,9 +723,29 @@ bool RendererServices::get_userdata(
         return (this->*(getter))(derivatives, name, type, sg, val);
     }
 
+    // Try user attributes of the current object instance.
+    if (!m_user_attributes.empty())
+    {
+        const ShadingPoint* shading_point =
+            reinterpret_cast<const ShadingPoint*>(sg->renderstate);
+
+        UserAttributeMapType::const_iterator j =
+            m_user_attributes.find(UserAttributeKey(&shading_point->get_object_instance(), name));
+
+        if (j != m_user_attributes.end())
+            return get_user_attribute(j->second, derivatives, type, val);
+    }
+
     return false;
 }
 
+bool RendererServices::has_userdata(OIIO::ustring name) const
+{
+    return
+        m_global_user_data_getters.find(name) != m_global_user_data_getters.end() ||
+        m_user_attribute_names.find(name) != m_user_attribute_names.end();
+}
+
 #define IMPLEMENT_ATTR_GETTER(name)         \
     bool RendererServices::get_attr_##name( \
         OSL::ShaderGlobals*     sg,         \
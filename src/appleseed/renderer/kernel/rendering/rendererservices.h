@@ -29,6 +29,9 @@
 
 #pragma once
 
+// appleseed.renderer headers.
+#include "renderer/modeling/scene/containers.h"
+
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/vector.h"
@@ -46,11 +49,16 @@
 #include "foundation/platform/_endoiioheaders.h"
 
 // Standard headers.
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 // Forward declarations.
 namespace renderer  { class Camera; }
+namespace renderer  { class ObjectInstance; }
 namespace renderer  { class Project; }
 namespace renderer  { class TextureStore; }
 namespace renderer  { class TraceContext; }
@@ -255,6 +263,10 @@ class RendererServices
         OSL::ShaderGlobals*         sg,
         void*                       val) override;
 
+    // Return true if user-data with a given name can be provided to shaders,
+    // either by the renderer itself or by the user attributes of an object instance.
+    bool has_userdata(OIIO::ustring name) const;
+
   private:
     // This code is based on OSL's test renderer.
     typedef bool (RendererServices::*AttrGetterFun)(
@@ -276,9 +288,32 @@ class RendererServices
 
     typedef std::unordered_map<OIIO::ustring, UserDataGetterFun, OIIO::ustringHash> UserDataGetterMapType;
 
+    // A user attribute of an object instance, declared in its "user_attributes" parameters.
+    struct UserAttribute
+    {
+        OIIO::TypeDesc              m_type;         // TypeFloat, TypeColor for triples, or TypeString
+        float                       m_values[3];
+        OIIO::ustring               m_string;
+    };
+
+    typedef std::pair<const ObjectInstance*, OIIO::ustring> UserAttributeKey;
+
+    struct UserAttributeKeyHash
+    {
+        size_t operator()(const UserAttributeKey& key) const
+        {
+            return std::hash<const ObjectInstance*>()(key.first) ^ key.second.hash();
+        }
+    };
+
+    typedef std::unordered_map<UserAttributeKey, UserAttribute, UserAttributeKeyHash> UserAttributeMapType;
+    typedef std::unordered_set<OIIO::ustring, OIIO::ustringHash> UserAttributeNameSetType;
+
     OIIO::TextureSystem&            m_texture_sys;
     AttrGetterMapType               m_global_attr_getters;
     UserDataGetterMapType           m_global_user_data_getters;
+    UserAttributeMapType            m_user_attributes;
+    UserAttributeNameSetType        m_user_attribute_names;
     const Camera*                   m_camera;
     foundation::Vector2i            m_resolution;
     OIIO::ustring                   m_cam_projection_str;
@@ -353,6 +388,19 @@ class RendererServices
 
     #undef DECLARE_USER_DATA_GETTER
 
+    // Collect the user attributes of all object instances of a set of assemblies.
+    void collect_user_attributes(const AssemblyContainer& assemblies);
+
+    static void parse_user_attribute(
+        const char*                 value,
+        UserAttribute&              attribute);
+
+    static bool get_user_attribute(
+        const UserAttribute&        attribute,
+        bool                        derivatives,
+        OIIO::TypeDesc              type,
+        void*                       val);
+
     static void clear_derivatives(
         const OIIO::TypeDesc&       type,
         void*                       val);
@@ -0,0 +1,147 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "renderingmetrics.h"
+
+// Standard headers.
+#include <chrono>
+
+namespace renderer
+{
+
+namespace
+{
+    std::uint64_t read_time()
+    {
+        return
+            static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+}
+
+
+//
+// RenderingMetrics::Snapshot class implementation.
+//
+
+double RenderingMetrics::Snapshot::get_remaining_time() const
+{
+    if (m_total_pixels == 0 || m_rendered_pixels == 0)
+        return -1.0;
+
+    if (m_rendered_pixels >= m_total_pixels)
+        return 0.0;
+
+    const double remaining_pixels = static_cast<double>(m_total_pixels - m_rendered_pixels);
+    return m_elapsed_time * remaining_pixels / static_cast<double>(m_rendered_pixels);
+}
+
+
+//
+// RenderingMetrics class implementation.
+//
+
+RenderingMetrics::RenderingMetrics()
+  : m_rendering(false)
+  , m_begin_time(0)
+  , m_end_time(0)
+  , m_samples(0)
+  , m_rays(0)
+  , m_texture_cache_hits(0)
+  , m_texture_cache_misses(0)
+  , m_rendered_pixels(0)
+  , m_total_pixels(0)
+  , m_active_threads(0)
+{
+}
+
+void RenderingMetrics::on_frame_begin()
+{
+    m_samples = 0;
+    m_rays = 0;
+    m_texture_cache_hits = 0;
+    m_texture_cache_misses = 0;
+    m_rendered_pixels = 0;
+    m_total_pixels = 0;
+
+    m_begin_time = read_time();
+    m_rendering = true;
+}
+
+void RenderingMetrics::on_frame_end()
+{
+    m_end_time = read_time();
+    m_rendering = false;
+}
+
+void RenderingMetrics::set_total_pixels(const std::uint64_t count)
+{
+    m_total_pixels = count;
+}
+
+void RenderingMetrics::on_thread_begin()
+{
+    m_active_threads.fetch_add(1, boost::memory_order_relaxed);
+}
+
+void RenderingMetrics::on_thread_end()
+{
+    m_active_threads.fetch_sub(1, boost::memory_order_relaxed);
+}
+
+RenderingMetrics::Snapshot RenderingMetrics::get_snapshot() const
+{
+    Snapshot snapshot;
+
+    snapshot.m_rendering = m_rendering;
+
+    const std::uint64_t begin_time = m_begin_time;
+    const std::uint64_t end_time = snapshot.m_rendering ? read_time() : m_end_time.load();
+    snapshot.m_elapsed_time =
+        end_time > begin_time ? static_cast<double>(end_time - begin_time) * 1.0e-6 : 0.0;
+
+    snapshot.m_samples = m_samples;
+    snapshot.m_rays = m_rays;
+    snapshot.m_texture_cache_hits = m_texture_cache_hits;
+    snapshot.m_texture_cache_misses = m_texture_cache_misses;
+    snapshot.m_rendered_pixels = m_rendered_pixels;
+    snapshot.m_total_pixels = m_total_pixels;
+    snapshot.m_active_threads = m_active_threads;
+
+    return snapshot;
+}
+
+RenderingMetrics& global_rendering_metrics()
+{
+    static RenderingMetrics metrics;
+    return metrics;
+}
+
+}   // namespace renderer
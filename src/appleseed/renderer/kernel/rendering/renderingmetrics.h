@@ -0,0 +1,174 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+
+namespace renderer
+{
+
+//
+// Live counters describing the frame being rendered, meant to be polled while rendering
+// is in progress, for instance to expose them to a monitoring system.
+//
+// Render threads accumulate counts locally and publish them in batches, so counters
+// lag slightly behind the actual progress of the render.
+//
+
+class APPLESEED_DLLSYMBOL RenderingMetrics
+  : public foundation::NonCopyable
+{
+  public:
+    struct Snapshot
+    {
+        bool            m_rendering;                // is a frame being rendered?
+        double          m_elapsed_time;             // time since the frame began, in seconds
+        std::uint64_t   m_samples;                  // number of camera samples rendered
+        std::uint64_t   m_rays;                     // number of rays traced
+        std::uint64_t   m_texture_cache_hits;
+        std::uint64_t   m_texture_cache_misses;
+        std::uint64_t   m_rendered_pixels;          // number of pixels rendered, across passes
+        std::uint64_t   m_total_pixels;             // number of pixels to render, 0 if unknown
+        size_t          m_active_threads;           // number of threads currently rendering
+
+        // Return the estimated time to completion in seconds, or a negative value if unknown.
+        double get_remaining_time() const;
+    };
+
+    // Constructor.
+    RenderingMetrics();
+
+    // Reset all counters and start timing a new frame.
+    void on_frame_begin();
+
+    // Stop timing the current frame.
+    void on_frame_end();
+
+    // Set the total number of pixels to render, across passes.
+    void set_total_pixels(const std::uint64_t count);
+
+    // Publish counts accumulated by a render thread.
+    void add_samples(const std::uint64_t count);
+    void add_rays(const std::uint64_t count);
+    void add_texture_cache_accesses(
+        const std::uint64_t     hits,
+        const std::uint64_t     misses);
+    void add_rendered_pixels(const std::uint64_t count);
+
+    // Signal that the calling thread starts or stops rendering.
+    void on_thread_begin();
+    void on_thread_end();
+
+    // Return a snapshot of all counters.
+    Snapshot get_snapshot() const;
+
+  private:
+    boost::atomic<bool>             m_rendering;
+    boost::atomic<std::uint64_t>    m_begin_time;   // in microseconds
+    boost::atomic<std::uint64_t>    m_end_time;     // in microseconds
+    boost::atomic<std::uint64_t>    m_samples;
+    boost::atomic<std::uint64_t>    m_rays;
+    boost::atomic<std::uint64_t>    m_texture_cache_hits;
+    boost::atomic<std::uint64_t>    m_texture_cache_misses;
+    boost::atomic<std::uint64_t>    m_rendered_pixels;
+    boost::atomic<std::uint64_t>    m_total_pixels;
+    boost::atomic<size_t>           m_active_threads;
+};
+
+// Return the rendering metrics shared by the whole library.
+APPLESEED_DLLSYMBOL RenderingMetrics& global_rendering_metrics();
+
+
+//
+// Count the calling thread as rendering for the lifetime of this object.
+//
+
+class ScopedRenderingThread
+  : public foundation::NonCopyable
+{
+  public:
+    ScopedRenderingThread();
+    ~ScopedRenderingThread();
+};
+
+
+//
+// RenderingMetrics class implementation.
+//
+
+inline void RenderingMetrics::add_samples(const std::uint64_t count)
+{
+    m_samples.fetch_add(count, boost::memory_order_relaxed);
+}
+
+inline void RenderingMetrics::add_rays(const std::uint64_t count)
+{
+    m_rays.fetch_add(count, boost::memory_order_relaxed);
+}
+
+inline void RenderingMetrics::add_texture_cache_accesses(
+    const std::uint64_t     hits,
+    const std::uint64_t     misses)
+{
+    m_texture_cache_hits.fetch_add(hits, boost::memory_order_relaxed);
+    m_texture_cache_misses.fetch_add(misses, boost::memory_order_relaxed);
+}
+
+inline void RenderingMetrics::add_rendered_pixels(const std::uint64_t count)
+{
+    m_rendered_pixels.fetch_add(count, boost::memory_order_relaxed);
+}
+
+
+//
+// ScopedRenderingThread class implementation.
+//
+
+inline ScopedRenderingThread::ScopedRenderingThread()
+{
+    global_rendering_metrics().on_thread_begin();
+}
+
+inline ScopedRenderingThread::~ScopedRenderingThread()
+{
+    global_rendering_metrics().on_thread_end();
+}
+
+}   // namespace renderer
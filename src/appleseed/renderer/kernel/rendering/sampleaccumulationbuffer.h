@@ -31,14 +31,18 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/memory/memorytracker.h"
 #include "foundation/platform/atomic.h"
 
 // Standard headers.
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
+namespace foundation    { class TiledImageAnalysis; }
 namespace renderer      { class Frame; }
 namespace renderer      { class Sample; }
 
@@ -69,8 +73,47 @@ class SampleAccumulationBuffer
         Frame&                      frame,
         foundation::IAbortSwitch&   abort_switch) = 0;
 
+    // Develop to a frame the tiles that may have changed since the last call to this
+    // method and return their indices in `dirty_tiles`. Thread-safe.
+    virtual void develop_dirty_tiles_to_frame(
+        Frame&                      frame,
+        std::vector<size_t>&        dirty_tiles,
+        foundation::IAbortSwitch&   abort_switch) = 0;
+
+    // Update an analysis of a frame with the tiles that may have changed since the last
+    // call to this method. Tiles are developed to temporary storage, the frame itself is
+    // left untouched. Thread-safe.
+    virtual void update_analysis(
+        const Frame&                    frame,
+        foundation::TiledImageAnalysis& analysis,
+        foundation::IAbortSwitch&       abort_switch) = 0;
+
+    // Return true if the pixel (x, y) no longer needs samples. Thread-safe.
+    virtual bool is_converged(
+        const size_t                x,
+        const size_t                y) const;
+
+    // Return true if no pixel of the buffer needs samples anymore. Thread-safe.
+    virtual bool is_converged() const;
+
+    // Start estimating the relative error of the pixels inside a given crop window.
+    // Buffers that can't estimate errors ignore this call. Not thread-safe.
+    virtual void enable_error_estimation(const foundation::AABB2u& crop_window);
+
+    // Retrieve the latest estimate of the relative error, averaged over the crop window
+    // and in its noisiest block of pixels. Errors are std::numeric_limits<float>::max()
+    // until pixels received enough samples. Return false if errors aren't estimated.
+    // Thread-safe.
+    virtual bool get_error_estimate(
+        float&                      average_error,
+        float&                      max_error) const;
+
   protected:
     boost::atomic<std::uint64_t> m_sample_count;
+    foundation::TrackedMemory    m_tracked_memory;      // memory used by the accumulation tiles
+
+    // Constructor.
+    SampleAccumulationBuffer();
 };
 
 
@@ -78,9 +121,37 @@ class SampleAccumulationBuffer
 // SampleAccumulationBuffer class implementation.
 //
 
+inline SampleAccumulationBuffer::SampleAccumulationBuffer()
+  : m_tracked_memory("framebuffers")
+{
+}
+
 inline std::uint64_t SampleAccumulationBuffer::get_sample_count() const
 {
     return m_sample_count;
 }
 
+inline bool SampleAccumulationBuffer::is_converged(
+    const size_t                    x,
+    const size_t                    y) const
+{
+    return false;
+}
+
+inline bool SampleAccumulationBuffer::is_converged() const
+{
+    return false;
+}
+
+inline void SampleAccumulationBuffer::enable_error_estimation(const foundation::AABB2u& crop_window)
+{
+}
+
+inline bool SampleAccumulationBuffer::get_error_estimate(
+    float&                          average_error,
+    float&                          max_error) const
+{
+    return false;
+}
+
 }   // namespace renderer
@@ -92,13 +92,22 @@ void SampleGeneratorBase::generate_samples(
             m_current_batch_size = 0;
             m_sequence_index += m_stride;
 
-            if (abort_switch.is_aborted())
+            // Also stop if the buffer has converged as no more samples would be accepted.
+            if (abort_switch.is_aborted() || buffer.is_converged())
                 break;
         }
     }
 
-    if (stored > 0)
-        buffer.store_samples(stored, &m_samples[0], abort_switch);
+    flush_samples(m_samples, abort_switch);
+
+    if (!m_samples.empty())
+        buffer.store_samples(m_samples.size(), &m_samples[0], abort_switch);
+}
+
+void SampleGeneratorBase::flush_samples(
+    SampleVector&               samples,
+    IAbortSwitch&               abort_switch)
+{
 }
 
 void SampleGeneratorBase::signal_invalid_sample()
@@ -75,6 +75,13 @@ class SampleGeneratorBase
         const size_t                sequence_index,
         SampleVector&               samples) = 0;
 
+    // Called once all sample indices of a call to generate_samples() have been visited, right
+    // before the samples are stored into the accumulation buffer. Derived classes that defer
+    // the rendering of samples must append them to 'samples' here.
+    virtual void flush_samples(
+        SampleVector&               samples,
+        foundation::IAbortSwitch&   abort_switch);
+
     void signal_invalid_sample();
 
   private:
@@ -0,0 +1,225 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "scenechangetracker.h"
+
+// appleseed.renderer headers.
+#include "renderer/modeling/bsdf/bsdf.h"
+#include "renderer/modeling/bssrdf/bssrdf.h"
+#include "renderer/modeling/camera/camera.h"
+#include "renderer/modeling/color/colorentity.h"
+#include "renderer/modeling/edf/edf.h"
+#include "renderer/modeling/environment/environment.h"
+#include "renderer/modeling/environmentedf/environmentedf.h"
+#include "renderer/modeling/environmentshader/environmentshader.h"
+#include "renderer/modeling/light/light.h"
+#include "renderer/modeling/material/material.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/textureinstance.h"
+#include "renderer/modeling/shadergroup/shadergroup.h"
+#include "renderer/modeling/surfaceshader/surfaceshader.h"
+#include "renderer/modeling/texture/texture.h"
+#include "renderer/modeling/volume/volume.h"
+#include "renderer/utility/paramarray.h"
+
+// Standard headers.
+#include <cstddef>
+
+namespace renderer
+{
+
+//
+// SceneChangeTracker class implementation.
+//
+
+namespace
+{
+    enum Category
+    {
+        CameraCategory,
+        LightsCategory,
+        MaterialsCategory,
+        GeometryCategory,
+        EnvironmentCategory
+    };
+
+    void hash_entity(std::uint64_t& signature, const Entity& entity)
+    {
+        signature = Entity::combine_signatures(signature, entity.compute_signature());
+    }
+
+    template <typename EntityCollection>
+    void hash_entities(std::uint64_t& signature, const EntityCollection& entities)
+    {
+        for (const auto& entity : entities)
+            hash_entity(signature, entity);
+    }
+
+    // Return true if a material may emit light.
+    bool may_emit_light(const Material& material)
+    {
+        const ParamArray& params = material.get_parameters();
+        return
+            !params.get_optional<std::string>("edf", "").empty() ||
+            !params.get_optional<std::string>("osl_surface", "").empty();
+    }
+
+    void hash_base_group(std::uint64_t signatures[], const BaseGroup& base_group);
+
+    void hash_assembly(std::uint64_t signatures[], const Assembly& assembly)
+    {
+        hash_entity(signatures[GeometryCategory], assembly);
+        hash_entities(signatures[GeometryCategory], assembly.objects());
+        hash_entities(signatures[GeometryCategory], assembly.object_instances());
+
+        hash_entities(signatures[LightsCategory], assembly.lights());
+        hash_entities(signatures[LightsCategory], assembly.edfs());
+
+        hash_entities(signatures[MaterialsCategory], assembly.bsdfs());
+        hash_entities(signatures[MaterialsCategory], assembly.bssrdfs());
+        hash_entities(signatures[MaterialsCategory], assembly.surface_shaders());
+        hash_entities(signatures[MaterialsCategory], assembly.volumes());
+
+        for (const Material& material : assembly.materials())
+        {
+            hash_entity(signatures[MaterialsCategory], material);
+
+            if (may_emit_light(material))
+                hash_entity(signatures[LightsCategory], material);
+        }
+
+        hash_base_group(signatures, assembly);
+    }
+
+    void hash_base_group(std::uint64_t signatures[], const BaseGroup& base_group)
+    {
+        // Colors, textures and shader groups may be used by EDFs as well as by BSDFs:
+        // conservatively consider that changing them affects both lights and materials.
+        for (const size_t category : { LightsCategory, MaterialsCategory })
+        {
+            hash_entities(signatures[category], base_group.colors());
+            hash_entities(signatures[category], base_group.textures());
+            hash_entities(signatures[category], base_group.texture_instances());
+            hash_entities(signatures[category], base_group.shader_groups());
+        }
+
+        hash_entities(signatures[GeometryCategory], base_group.assembly_instances());
+
+        for (const Assembly& assembly : base_group.assemblies())
+            hash_assembly(signatures, assembly);
+    }
+}
+
+SceneChangeTracker::SceneChangeTracker()
+{
+    reset();
+}
+
+std::uint32_t SceneChangeTracker::update(const Scene& scene)
+{
+    // Seed all signatures with the scene's unique ID so that replacing the scene changes everything.
+    std::uint64_t signatures[CategoryCount];
+    for (size_t i = 0; i < CategoryCount; ++i)
+        signatures[i] = scene.get_uid();
+
+    hash_entities(signatures[CameraCategory], scene.cameras());
+
+    if (scene.get_environment() != nullptr)
+        hash_entity(signatures[EnvironmentCategory], *scene.get_environment());
+    hash_entities(signatures[EnvironmentCategory], scene.environment_edfs());
+    hash_entities(signatures[EnvironmentCategory], scene.environment_shaders());
+
+    // The scene's version ID is bumped when assemblies are edited.
+    signatures[GeometryCategory] =
+        Entity::combine_signatures(signatures[GeometryCategory], scene.get_version_id());
+
+    hash_base_group(signatures, scene);
+
+    std::uint32_t changes = NoChange;
+
+    for (size_t i = 0; i < CategoryCount; ++i)
+    {
+        if (!m_has_signatures || signatures[i] != m_signatures[i])
+            changes |= 1UL << i;
+
+        m_signatures[i] = signatures[i];
+    }
+
+    m_has_signatures = true;
+
+    return changes;
+}
+
+void SceneChangeTracker::reset()
+{
+    m_has_signatures = false;
+
+    for (size_t i = 0; i < CategoryCount; ++i)
+        m_signatures[i] = 0;
+}
+
+std::string SceneChangeTracker::get_changes_description(const std::uint32_t changes)
+{
+    if (changes == NoChange)
+        return "none";
+
+    if (changes == AllChanged)
+        return "all";
+
+    static const char* CategoryNames[CategoryCount] =
+    {
+        "camera",
+        "lights",
+        "materials",
+        "geometry",
+        "environment"
+    };
+
+    std::string description;
+
+    for (size_t i = 0; i < CategoryCount; ++i)
+    {
+        if (changes & (1UL << i))
+        {
+            if (!description.empty())
+                description += ", ";
+
+            description += CategoryNames[i];
+        }
+    }
+
+    return description;
+}
+
+}   // namespace renderer
@@ -0,0 +1,91 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstdint>
+#include <string>
+
+// Forward declarations.
+namespace renderer  { class Scene; }
+
+namespace renderer
+{
+
+//
+// Track which categories of scene entities changed between two renders.
+//
+// Changes are detected by comparing entity signatures (unique IDs and version IDs),
+// the same way acceleration structures detect geometry changes. Entities replaced
+// by new ones (as when editing them in appleseed.studio) or whose version ID was
+// bumped are reported as changed.
+//
+
+class APPLESEED_DLLSYMBOL SceneChangeTracker
+  : public foundation::NonCopyable
+{
+  public:
+    enum Changes
+    {
+        NoChange            = 0,
+        CameraChanged       = 1UL << 0,     // cameras
+        LightsChanged       = 1UL << 1,     // lights, EDFs and anything that may emit light
+        MaterialsChanged    = 1UL << 2,     // materials, BSDFs, BSSRDFs, surface shaders, volumes, shaders and textures
+        GeometryChanged     = 1UL << 3,     // objects, assemblies and their instances
+        EnvironmentChanged  = 1UL << 4,     // environment, environment EDFs and environment shaders
+        AllChanged          = CameraChanged | LightsChanged | MaterialsChanged | GeometryChanged | EnvironmentChanged
+    };
+
+    // Constructor.
+    SceneChangeTracker();
+
+    // Compare the scene against the one seen by the previous call and return a combination
+    // of Changes flags. The first call (or the first call after reset()) returns AllChanged.
+    std::uint32_t update(const Scene& scene);
+
+    // Forget the scene seen by the previous call.
+    void reset();
+
+    // Return a human-readable description of a combination of Changes flags.
+    static std::string get_changes_description(const std::uint32_t changes);
+
+  private:
+    enum { CategoryCount = 5 };
+
+    bool            m_has_signatures;
+    std::uint64_t   m_signatures[CategoryCount];
+};
+
+}   // namespace renderer
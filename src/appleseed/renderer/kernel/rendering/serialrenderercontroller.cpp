@@ -104,6 +104,11 @@ IRendererController::Status SerialRendererController::get_status() const
     return m_controller->get_status();
 }
 
+size_t SerialRendererController::get_active_thread_count() const
+{
+    return m_controller->get_active_thread_count();
+}
+
 void SerialRendererController::add_on_tiled_frame_begin_callback(
     const Frame*            frame)
 {
@@ -71,6 +71,7 @@ class SerialRendererController
     void on_frame_end() override;
     void on_progress() override;
     Status get_status() const override;
+    size_t get_active_thread_count() const override;
 
     void add_on_tiled_frame_begin_callback(
         const Frame*            frame);
@@ -37,7 +37,6 @@
 // appleseed.foundation headers.
 #include "foundation/image/color.h"
 #include "foundation/image/tile.h"
-#include "foundation/platform/compiler.h"
 
 // Standard headers.
 #include <cassert>
@@ -56,7 +55,6 @@ ShadingResultFrameBuffer::ShadingResultFrameBuffer(
         height,
         get_total_channel_count(aov_count))
   , m_aov_count(aov_count)
-  , m_scratch(get_total_channel_count(aov_count))
 {
 }
 
@@ -64,14 +62,15 @@ ShadingResultFrameBuffer::ShadingResultFrameBuffer(
     const size_t                    width,
     const size_t                    height,
     const size_t                    aov_count,
-    const AABB2u&                   crop_window)
+    const AABB2u&                   crop_window,
+    std::uint8_t*                   storage)
   : AccumulatorTile(
         width,
         height,
         get_total_channel_count(aov_count),
-        crop_window)
+        crop_window,
+        storage)
   , m_aov_count(aov_count)
-  , m_scratch(get_total_channel_count(aov_count))
 {
 }
 
@@ -79,23 +78,16 @@ void ShadingResultFrameBuffer::add(
     const Vector2u&                 pi,
     const ShadingResult&            sample)
 {
-    float* ptr = &m_scratch[0];
+    // Ignore samples outside the crop window.
+    if (!m_crop_window.contains(pi))
+        return;
 
-    *ptr++ = sample.m_main[0];
-    *ptr++ = sample.m_main[1];
-    *ptr++ = sample.m_main[2];
-    *ptr++ = sample.m_main[3];
+    float* ptr = pixel(pi.x, pi.y);
+    *ptr++ += 1.0f;
 
-    for (size_t i = 0, e = m_aov_count; i < e; ++i)
-    {
-        const Color4f& aov = sample.m_aovs[i];
-        *ptr++ = aov[0];
-        *ptr++ = aov[1];
-        *ptr++ = aov[2];
-        *ptr++ = aov[3];
-    }
-
-    AccumulatorTile::add(pi, &m_scratch[0]);
+    // Accumulate the main color and the AOVs directly from the sample, without staging them.
+    scaled_add(ptr, &sample.m_main[0], 1.0f, 4);
+    scaled_add(ptr + 4, &sample.m_aovs[0][0], 1.0f, m_aov_count * 4);
 }
 
 void ShadingResultFrameBuffer::merge(
@@ -108,22 +100,37 @@ void ShadingResultFrameBuffer::merge(
 {
     assert(m_channel_count == source.m_channel_count);
 
-    const float* APPLESEED_RESTRICT source_ptr = source.pixel(source_x, source_y);
-    float* APPLESEED_RESTRICT dest_ptr = pixel(dest_x, dest_y);
-
-    for (size_t i = 0, e = m_channel_count; i < e; ++i)
-        dest_ptr[i] += source_ptr[i] * scaling;
+    scaled_add(
+        pixel(dest_x, dest_y),
+        source.pixel(source_x, source_y),
+        scaling,
+        m_channel_count);
 }
 
 void ShadingResultFrameBuffer::develop_to_tile(
     Tile&                           tile,
     TileStack&                      aov_tiles) const
 {
-    const float* ptr = pixel(0);
+    develop_to_tile(
+        tile,
+        aov_tiles,
+        AABB2u(Vector2u(0, 0), Vector2u(m_width - 1, m_height - 1)));
+}
+
+void ShadingResultFrameBuffer::develop_to_tile(
+    Tile&                           tile,
+    TileStack&                      aov_tiles,
+    const AABB2u&                   rect) const
+{
+    assert(rect.is_valid());
+    assert(rect.max.x < m_width);
+    assert(rect.max.y < m_height);
 
-    for (size_t y = 0, h = m_height; y < h; ++y)
+    for (size_t y = rect.min.y; y <= rect.max.y; ++y)
     {
-        for (size_t x = 0, w = m_width; x < w; ++x)
+        const float* ptr = pixel(rect.min.x, y);
+
+        for (size_t x = rect.min.x; x <= rect.max.x; ++x)
         {
             const float weight = *ptr++;
             const float rcp_weight = weight == 0.0f ? 0.0f : 1.0f / weight;
@@ -36,7 +36,7 @@
 
 // Standard headers.
 #include <cstddef>
-#include <vector>
+#include <cstdint>
 
 // Forward declarations.
 namespace foundation    { class Tile; }
@@ -59,7 +59,8 @@ class ShadingResultFrameBuffer
         const size_t                    width,
         const size_t                    height,
         const size_t                    aov_count,
-        const foundation::AABB2u&       crop_window);
+        const foundation::AABB2u&       crop_window,
+        std::uint8_t*                   storage = nullptr); // if provided, use this memory for pixel storage
 
     static size_t get_total_channel_count(const size_t aov_count);
 
@@ -79,9 +80,14 @@ class ShadingResultFrameBuffer
         foundation::Tile&               tile,
         TileStack&                      aov_tiles) const;
 
+    // Develop a rectangular region (inclusive on all sides) of the framebuffer.
+    void develop_to_tile(
+        foundation::Tile&               tile,
+        TileStack&                      aov_tiles,
+        const foundation::AABB2u&       rect) const;
+
   private:
     const size_t                        m_aov_count;
-    std::vector<float>                  m_scratch;
 };
 
 inline size_t ShadingResultFrameBuffer::get_total_channel_count(const size_t aov_count)
@@ -0,0 +1,746 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "sharedmemorytilecallback.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/modeling/aov/aov.h"
+#include "renderer/modeling/aov/aovcontainer.h"
+#include "renderer/modeling/frame/frame.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/math/scalar.h"
+#include "foundation/platform/thread.h"
+#include "foundation/string/string.h"
+
+// Boost headers.
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+#include "boost/interprocess/exceptions.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+#include "boost/interprocess/shared_memory_object.hpp"
+#include "boost/interprocess/sync/named_semaphore.hpp"
+#include "boost/thread/mutex.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+namespace bip = boost::interprocess;
+
+namespace renderer
+{
+
+namespace
+{
+    const char SharedFrameSignature[8] = "ASFRAME";
+    const std::uint32_t SharedFrameVersion = 1;
+
+    // Pixels of each plane start on a cache line boundary.
+    const size_t PlaneAlignment = 64;
+
+    // The ring holds at least this many events, and at least two per tile of the frame.
+    const size_t MinRingCapacity = 256;
+
+    std::string get_event_name(const std::string& name)
+    {
+        return name + "_event";
+    }
+
+    size_t align_offset(const size_t offset)
+    {
+        return (offset + PlaneAlignment - 1) & ~(PlaneAlignment - 1);
+    }
+}
+
+
+//
+// SharedMemoryFrameWriter class implementation.
+//
+
+class SharedMemoryFrameWriter
+  : public NonCopyable
+{
+  public:
+    SharedMemoryFrameWriter(
+        const char*                 name,
+        const bool                  include_aovs)
+      : m_name(name)
+      , m_include_aovs(include_aovs)
+      , m_header(nullptr)
+    {
+    }
+
+    ~SharedMemoryFrameWriter()
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        if (m_header != nullptr)
+        {
+            close_segment();
+            m_semaphore->post();
+        }
+
+        // Mapped views remain valid after their names are removed; readers still
+        // holding the segment can finish reading the last frame.
+        m_semaphore.reset();
+        bip::named_semaphore::remove(get_event_name(m_name).c_str());
+    }
+
+    void begin_frame(const Frame& frame)
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        if (!ensure_segment(frame))
+            return;
+
+        publish_event(SharedTileEventFrameBegin, 0, 0, m_header->m_frame_width, m_header->m_frame_height);
+    }
+
+    void end_frame(const Frame& frame)
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        if (!ensure_segment(frame))
+            return;
+
+        publish_event(SharedTileEventFrameEnd, 0, 0, m_header->m_frame_width, m_header->m_frame_height);
+    }
+
+    void begin_tile(
+        const Frame&                frame,
+        const size_t                tile_x,
+        const size_t                tile_y)
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        if (!ensure_segment(frame))
+            return;
+
+        const Tile& tile = frame.image().tile(tile_x, tile_y);
+
+        publish_event(
+            SharedTileEventTileBegin,
+            tile_x * m_header->m_tile_width,
+            tile_y * m_header->m_tile_height,
+            tile.get_width(),
+            tile.get_height());
+    }
+
+    void update_tiles(
+        const Frame&                frame,
+        const size_t*               tile_indices,
+        const size_t                tile_count)
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        if (!ensure_segment(frame))
+            return;
+
+        const size_t tile_count_x = frame.image().properties().m_tile_count_x;
+
+        for (size_t i = 0; i < tile_count; ++i)
+        {
+            update_tile_unlocked(
+                frame,
+                tile_indices[i] % tile_count_x,
+                tile_indices[i] / tile_count_x);
+        }
+    }
+
+    void update_tile(
+        const Frame&                frame,
+        const size_t                tile_x,
+        const size_t                tile_y)
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        if (!ensure_segment(frame))
+            return;
+
+        update_tile_unlocked(frame, tile_x, tile_y);
+    }
+
+    void update_frame(const Frame& frame)
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        if (!ensure_segment(frame))
+            return;
+
+        const CanvasProperties& props = frame.image().properties();
+
+        for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+        {
+            for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+                copy_tile(frame, tx, ty);
+        }
+
+        publish_event(SharedTileEventTileUpdate, 0, 0, m_header->m_frame_width, m_header->m_frame_height);
+    }
+
+  private:
+    struct PlaneLayout
+    {
+        std::string                 m_name;
+        size_t                      m_channel_count;
+
+        bool operator==(const PlaneLayout& rhs) const
+        {
+            return m_name == rhs.m_name && m_channel_count == rhs.m_channel_count;
+        }
+    };
+
+    const std::string                           m_name;
+    const bool                                  m_include_aovs;
+    boost::mutex                                m_mutex;
+    std::unique_ptr<bip::shared_memory_object>  m_segment;
+    std::unique_ptr<bip::mapped_region>         m_region;
+    std::unique_ptr<bip::named_semaphore>       m_semaphore;
+    SharedFrameHeader*                          m_header;
+    std::vector<PlaneLayout>                    m_planes;
+
+    void collect_planes(const Frame& frame, std::vector<PlaneLayout>& planes) const
+    {
+        PlaneLayout beauty;
+        beauty.m_name = "beauty";
+        beauty.m_channel_count = frame.image().properties().m_channel_count;
+        planes.push_back(beauty);
+
+        if (m_include_aovs)
+        {
+            for (size_t i = 0, e = frame.aovs().size(); i < e; ++i)
+            {
+                if (planes.size() == SharedFrameHeader::MaxPlaneCount)
+                {
+                    RENDERER_LOG_WARNING(
+                        "shared memory framebuffer \"%s\" only holds %s planes, ignoring remaining aovs.",
+                        m_name.c_str(),
+                        pretty_uint(static_cast<size_t>(SharedFrameHeader::MaxPlaneCount)).c_str());
+                    break;
+                }
+
+                const AOV* aov = frame.aovs().get_by_index(i);
+
+                PlaneLayout plane;
+                plane.m_name = aov->get_name();
+                plane.m_channel_count = aov->get_image().properties().m_channel_count;
+                planes.push_back(plane);
+            }
+        }
+    }
+
+    // Make sure the segment matches the layout of the frame. Return false if there is no usable segment.
+    bool ensure_segment(const Frame& frame)
+    {
+        const CanvasProperties& props = frame.image().properties();
+
+        std::vector<PlaneLayout> planes;
+        collect_planes(frame, planes);
+
+        if (m_header != nullptr &&
+            m_header->m_frame_width == props.m_canvas_width &&
+            m_header->m_frame_height == props.m_canvas_height &&
+            m_header->m_tile_width == props.m_tile_width &&
+            m_header->m_tile_height == props.m_tile_height &&
+            m_planes == planes)
+            return true;
+
+        try
+        {
+            if (!m_semaphore)
+            {
+                bip::named_semaphore::remove(get_event_name(m_name).c_str());
+                m_semaphore.reset(
+                    new bip::named_semaphore(bip::create_only, get_event_name(m_name).c_str(), 0));
+            }
+
+            if (m_header != nullptr)
+            {
+                // Tell readers of the current segment to reopen the framebuffer.
+                close_segment();
+                m_semaphore->post();
+            }
+
+            create_segment(props, planes);
+        }
+        catch (const bip::interprocess_exception& e)
+        {
+            RENDERER_LOG_ERROR(
+                "failed to create shared memory framebuffer \"%s\": %s",
+                m_name.c_str(),
+                e.what());
+
+            m_region.reset();
+            m_segment.reset();
+            m_header = nullptr;
+            return false;
+        }
+
+        return true;
+    }
+
+    void create_segment(
+        const CanvasProperties&         props,
+        const std::vector<PlaneLayout>& planes)
+    {
+        const size_t ring_capacity =
+            std::max(2 * props.m_tile_count, MinRingCapacity);
+
+        // Compute the layout of the segment.
+        const size_t ring_offset = align_offset(sizeof(SharedFrameHeader));
+        size_t size = align_offset(ring_offset + ring_capacity * sizeof(SharedTileEvent));
+        std::vector<size_t> pixel_offsets(planes.size());
+        for (size_t i = 0, e = planes.size(); i < e; ++i)
+        {
+            pixel_offsets[i] = size;
+            size = align_offset(size + props.m_pixel_count * planes[i].m_channel_count * sizeof(float));
+        }
+
+        // Create and map the segment.
+        bip::shared_memory_object::remove(m_name.c_str());
+        m_segment.reset(new bip::shared_memory_object(bip::create_only, m_name.c_str(), bip::read_write));
+        m_segment->truncate(static_cast<bip::offset_t>(size));
+        m_region.reset(new bip::mapped_region(*m_segment, bip::read_write));
+        std::memset(m_region->get_address(), 0, size);
+
+        // Fill in the header.
+        m_header = new (m_region->get_address()) SharedFrameHeader();
+        std::memcpy(m_header->m_signature, SharedFrameSignature, sizeof(SharedFrameSignature));
+        m_header->m_version = SharedFrameVersion;
+        m_header->m_header_size = static_cast<std::uint32_t>(sizeof(SharedFrameHeader));
+        m_header->m_frame_width = static_cast<std::uint32_t>(props.m_canvas_width);
+        m_header->m_frame_height = static_cast<std::uint32_t>(props.m_canvas_height);
+        m_header->m_tile_width = static_cast<std::uint32_t>(props.m_tile_width);
+        m_header->m_tile_height = static_cast<std::uint32_t>(props.m_tile_height);
+        m_header->m_ring_capacity = static_cast<std::uint32_t>(ring_capacity);
+        m_header->m_ring_offset = ring_offset;
+        m_header->m_event_count.store(0, std::memory_order_relaxed);
+        m_header->m_plane_count = static_cast<std::uint32_t>(planes.size());
+
+        for (size_t i = 0, e = planes.size(); i < e; ++i)
+        {
+            SharedFramePlane& plane = m_header->m_planes[i];
+            std::strncpy(plane.m_name, planes[i].m_name.c_str(), sizeof(plane.m_name) - 1);
+            plane.m_channel_count = static_cast<std::uint32_t>(planes[i].m_channel_count);
+            plane.m_pixel_offset = pixel_offsets[i];
+        }
+
+        // Publish the header.
+        m_header->m_state.store(SharedFrameHeader::StateOpen, std::memory_order_release);
+
+        m_planes = planes;
+
+        RENDERER_LOG_INFO(
+            "created shared memory framebuffer \"%s\" (%s x %s, %s %s, %s).",
+            m_name.c_str(),
+            pretty_uint(props.m_canvas_width).c_str(),
+            pretty_uint(props.m_canvas_height).c_str(),
+            pretty_uint(planes.size()).c_str(),
+            plural(planes.size(), "plane").c_str(),
+            pretty_size(size).c_str());
+    }
+
+    void close_segment()
+    {
+        assert(m_header != nullptr);
+
+        m_header->m_state.store(SharedFrameHeader::StateClosed, std::memory_order_release);
+
+        m_region.reset();
+        m_segment.reset();
+        m_header = nullptr;
+        m_planes.clear();
+
+        bip::shared_memory_object::remove(m_name.c_str());
+    }
+
+    void update_tile_unlocked(
+        const Frame&                frame,
+        const size_t                tile_x,
+        const size_t                tile_y)
+    {
+        copy_tile(frame, tile_x, tile_y);
+
+        const Tile& tile = frame.image().tile(tile_x, tile_y);
+
+        publish_event(
+            SharedTileEventTileUpdate,
+            tile_x * m_header->m_tile_width,
+            tile_y * m_header->m_tile_height,
+            tile.get_width(),
+            tile.get_height());
+    }
+
+    void copy_tile(
+        const Frame&                frame,
+        const size_t                tile_x,
+        const size_t                tile_y)
+    {
+        copy_tile(frame.image().tile(tile_x, tile_y), tile_x, tile_y, 0);
+
+        for (size_t i = 1, e = m_planes.size(); i < e; ++i)
+        {
+            const AOV* aov = frame.aovs().get_by_index(i - 1);
+            copy_tile(aov->get_image().tile(tile_x, tile_y), tile_x, tile_y, i);
+        }
+    }
+
+    void copy_tile(
+        const Tile&                 tile,
+        const size_t                tile_x,
+        const size_t                tile_y,
+        const size_t                plane_index)
+    {
+        if (tile.get_pixel_format() != PixelFormatFloat)
+        {
+            const Tile tmp(tile, PixelFormatFloat);
+            copy_tile(tmp, tile_x, tile_y, plane_index);
+            return;
+        }
+
+        const SharedFramePlane& plane = m_header->m_planes[plane_index];
+        const size_t channel_count = plane.m_channel_count;
+        const size_t frame_width = m_header->m_frame_width;
+        const size_t x0 = tile_x * m_header->m_tile_width;
+        const size_t y0 = tile_y * m_header->m_tile_height;
+        const size_t w = tile.get_width();
+        const size_t h = tile.get_height();
+        const size_t row_size = w * channel_count * sizeof(float);
+
+        assert(tile.get_channel_count() == channel_count);
+
+        const std::uint8_t* src = tile.get_storage();
+        std::uint8_t* dest =
+            static_cast<std::uint8_t*>(m_region->get_address()) +
+            plane.m_pixel_offset +
+            (y0 * frame_width + x0) * channel_count * sizeof(float);
+
+        for (size_t y = 0; y < h; ++y)
+        {
+            std::memcpy(dest, src, row_size);
+            src += row_size;
+            dest += frame_width * channel_count * sizeof(float);
+        }
+    }
+
+    void publish_event(
+        const SharedTileEventType   type,
+        const size_t                x,
+        const size_t                y,
+        const size_t                width,
+        const size_t                height)
+    {
+        const std::uint64_t sequence = m_header->m_event_count.load(std::memory_order_relaxed);
+
+        SharedTileEvent* ring =
+            reinterpret_cast<SharedTileEvent*>(
+                static_cast<std::uint8_t*>(m_region->get_address()) + m_header->m_ring_offset);
+
+        SharedTileEvent& event = ring[sequence % m_header->m_ring_capacity];
+        event.m_sequence = sequence;
+        event.m_type = static_cast<std::uint32_t>(type);
+        event.m_x = static_cast<std::uint32_t>(x);
+        event.m_y = static_cast<std::uint32_t>(y);
+        event.m_width = static_cast<std::uint32_t>(width);
+        event.m_height = static_cast<std::uint32_t>(height);
+        event.m_reserved = 0;
+
+        // Make the event and the pixels it refers to visible before announcing it.
+        m_header->m_event_count.store(sequence + 1, std::memory_order_release);
+
+        m_semaphore->post();
+    }
+};
+
+
+//
+// SharedMemoryTileCallback class implementation.
+//
+
+SharedMemoryTileCallback::SharedMemoryTileCallback(
+    const char*                 name,
+    const bool                  include_aovs)
+  : m_writer(std::make_shared<SharedMemoryFrameWriter>(name, include_aovs))
+{
+}
+
+SharedMemoryTileCallback::SharedMemoryTileCallback(const std::shared_ptr<SharedMemoryFrameWriter>& writer)
+  : m_writer(writer)
+{
+}
+
+void SharedMemoryTileCallback::release()
+{
+    delete this;
+}
+
+void SharedMemoryTileCallback::on_tiled_frame_begin(const Frame* frame)
+{
+    m_writer->begin_frame(*frame);
+}
+
+void SharedMemoryTileCallback::on_tiled_frame_end(const Frame* frame)
+{
+    m_writer->end_frame(*frame);
+}
+
+void SharedMemoryTileCallback::on_tile_begin(
+    const Frame*                frame,
+    const size_t                tile_x,
+    const size_t                tile_y,
+    const size_t                thread_index,
+    const size_t                thread_count)
+{
+    m_writer->begin_tile(*frame, tile_x, tile_y);
+}
+
+void SharedMemoryTileCallback::on_tile_end(
+    const Frame*                frame,
+    const size_t                tile_x,
+    const size_t                tile_y)
+{
+    m_writer->update_tile(*frame, tile_x, tile_y);
+}
+
+void SharedMemoryTileCallback::on_progressive_frame_update(
+    const Frame&                frame,
+    const double                time,
+    const std::uint64_t         samples,
+    const double                samples_per_pixel,
+    const std::uint64_t         samples_per_second)
+{
+    m_writer->update_frame(frame);
+}
+
+void SharedMemoryTileCallback::on_progressive_tiles_update(
+    const Frame&                frame,
+    const size_t*               tile_indices,
+    const size_t                tile_count,
+    const double                time,
+    const std::uint64_t         samples,
+    const double                samples_per_pixel,
+    const std::uint64_t         samples_per_second)
+{
+    m_writer->update_tiles(frame, tile_indices, tile_count);
+}
+
+
+//
+// SharedMemoryTileCallbackFactory class implementation.
+//
+
+SharedMemoryTileCallbackFactory::SharedMemoryTileCallbackFactory(
+    const char*                 name,
+    const bool                  include_aovs)
+  : m_writer(std::make_shared<SharedMemoryFrameWriter>(name, include_aovs))
+{
+}
+
+void SharedMemoryTileCallbackFactory::release()
+{
+    delete this;
+}
+
+ITileCallback* SharedMemoryTileCallbackFactory::create()
+{
+    return new SharedMemoryTileCallback(m_writer);
+}
+
+
+//
+// SharedMemoryFrameReader class implementation.
+//
+
+struct SharedMemoryFrameReader::Impl
+{
+    std::unique_ptr<bip::shared_memory_object>  m_segment;
+    std::unique_ptr<bip::mapped_region>         m_region;
+    std::unique_ptr<bip::named_semaphore>       m_semaphore;
+    const SharedFrameHeader*                    m_header;
+    std::uint64_t                               m_next_event;
+};
+
+SharedMemoryFrameReader::SharedMemoryFrameReader(const char* name)
+  : impl(new Impl())
+{
+    try
+    {
+        impl->m_segment.reset(new bip::shared_memory_object(bip::open_only, name, bip::read_only));
+        impl->m_region.reset(new bip::mapped_region(*impl->m_segment, bip::read_only));
+    }
+    catch (const bip::interprocess_exception& e)
+    {
+        delete impl;
+        throw ExceptionIOError(e.what());
+    }
+
+    impl->m_header = static_cast<const SharedFrameHeader*>(impl->m_region->get_address());
+    impl->m_next_event = 0;
+
+    if (impl->m_region->get_size() < sizeof(SharedFrameHeader) ||
+        std::memcmp(impl->m_header->m_signature, SharedFrameSignature, sizeof(SharedFrameSignature)) != 0 ||
+        impl->m_header->m_version != SharedFrameVersion ||
+        impl->m_header->m_state.load(std::memory_order_acquire) == 0)
+    {
+        delete impl;
+        throw ExceptionIOError("not a valid shared memory framebuffer");
+    }
+
+    // Without the event, wait() falls back to polling.
+    try
+    {
+        impl->m_semaphore.reset(
+            new bip::named_semaphore(bip::open_only, get_event_name(name).c_str()));
+    }
+    catch (const bip::interprocess_exception&)
+    {
+    }
+}
+
+SharedMemoryFrameReader::~SharedMemoryFrameReader()
+{
+    delete impl;
+}
+
+const SharedFrameHeader& SharedMemoryFrameReader::get_header() const
+{
+    return *impl->m_header;
+}
+
+bool SharedMemoryFrameReader::is_closed() const
+{
+    return impl->m_header->m_state.load(std::memory_order_acquire) == SharedFrameHeader::StateClosed;
+}
+
+const float* SharedMemoryFrameReader::get_plane_pixels(const size_t plane_index) const
+{
+    assert(plane_index < impl->m_header->m_plane_count);
+
+    return
+        reinterpret_cast<const float*>(
+            static_cast<const std::uint8_t*>(impl->m_region->get_address()) +
+            impl->m_header->m_planes[plane_index].m_pixel_offset);
+}
+
+bool SharedMemoryFrameReader::wait(const double timeout)
+{
+    const auto has_events = [this]()
+    {
+        return
+            impl->m_header->m_event_count.load(std::memory_order_acquire) != impl->m_next_event ||
+            is_closed();
+    };
+
+    if (has_events())
+        return true;
+
+    if (impl->m_semaphore)
+    {
+        const boost::posix_time::ptime deadline =
+            boost::posix_time::microsec_clock::universal_time() +
+            boost::posix_time::microseconds(static_cast<std::int64_t>(timeout * 1.0e6));
+
+        while (!has_events())
+        {
+            if (!impl->m_semaphore->timed_wait(deadline))
+                return has_events();
+        }
+
+        // Consume the notifications of the events that will be read together.
+        while (impl->m_semaphore->try_wait()) {}
+
+        return true;
+    }
+    else
+    {
+        const size_t timeout_ms = static_cast<size_t>(timeout * 1000.0);
+
+        for (size_t elapsed_ms = 0; elapsed_ms < timeout_ms; ++elapsed_ms)
+        {
+            if (has_events())
+                return true;
+
+            foundation::sleep(1);
+        }
+
+        return has_events();
+    }
+}
+
+bool SharedMemoryFrameReader::read_events(std::vector<SharedTileEvent>& events)
+{
+    const SharedFrameHeader& header = *impl->m_header;
+    const std::uint64_t capacity = header.m_ring_capacity;
+    const SharedTileEvent* ring =
+        reinterpret_cast<const SharedTileEvent*>(
+            static_cast<const std::uint8_t*>(impl->m_region->get_address()) + header.m_ring_offset);
+
+    const std::uint64_t count = header.m_event_count.load(std::memory_order_acquire);
+
+    bool complete = true;
+
+    std::uint64_t begin = impl->m_next_event;
+    if (count - begin > capacity)
+    {
+        begin = count - capacity;
+        complete = false;
+    }
+
+    const size_t first = events.size();
+    for (std::uint64_t i = begin; i < count; ++i)
+        events.push_back(ring[i % capacity]);
+
+    // Drop the events the writer may have overwritten while they were being copied.
+    const std::uint64_t new_count = header.m_event_count.load(std::memory_order_acquire);
+    if (new_count - begin >= capacity)
+    {
+        const std::uint64_t first_valid = new_count - capacity + 1;
+        const std::uint64_t dropped = std::min(first_valid, count) - begin;
+        events.erase(events.begin() + first, events.begin() + first + static_cast<size_t>(dropped));
+        complete = false;
+    }
+
+    impl->m_next_event = count;
+
+    return complete;
+}
+
+}   // namespace renderer
@@ -0,0 +1,253 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/itilecallback.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Forward declarations.
+namespace renderer  { class Frame; }
+namespace renderer  { class SharedMemoryFrameWriter; }
+
+namespace renderer
+{
+
+//
+// Shared-memory framebuffer channel.
+//
+// A render publishes its frame into a named shared memory segment that host applications
+// map and read directly, instead of receiving pixels through a byte stream. The segment
+// is laid out as follows (native endianness and alignment):
+//
+//   SharedFrameHeader                          at offset 0
+//   SharedTileEvent[m_ring_capacity]           at offset m_ring_offset
+//   32-bit float pixels of each plane          at offset m_planes[i].m_pixel_offset,
+//                                              row-major, m_channel_count channels per pixel
+//
+// Plane 0 is the beauty image; the other planes, if any, are the AOVs of the frame.
+//
+// Every update of the frame is announced by an event written into the ring, then the
+// number of events published so far (m_event_count) is incremented. Readers remember how
+// many events they've consumed; event N lives in slot N % m_ring_capacity and carries N
+// in its m_sequence field, so readers falling a whole ring behind can detect it and
+// consider the whole frame updated. In addition, a named semaphore, whose name is the
+// name of the segment followed by "_event", is posted after each new event so readers
+// can sleep until something happens.
+//
+// Pixels are updated in place: a reader may see a tile that is being overwritten.
+// When the frame layout changes (new resolution or planes), the writer marks the
+// segment as closed and creates a new one with the same name, which readers must reopen.
+//
+
+enum SharedTileEventType
+{
+    SharedTileEventFrameBegin   = 1,                    // a new frame is being rendered
+    SharedTileEventTileBegin    = 2,                    // a tile is being rendered
+    SharedTileEventTileUpdate   = 3,                    // the pixels of a region of the frame were updated
+    SharedTileEventFrameEnd     = 4                     // the frame is complete
+};
+
+struct SharedTileEvent
+{
+    std::uint64_t               m_sequence;             // index of this event in the stream of events
+    std::uint32_t               m_type;                 // a SharedTileEventType value
+    std::uint32_t               m_x;                    // region of the frame concerned by the event, in pixels
+    std::uint32_t               m_y;
+    std::uint32_t               m_width;
+    std::uint32_t               m_height;
+    std::uint32_t               m_reserved;
+};
+
+struct SharedFramePlane
+{
+    char                        m_name[64];             // null-terminated
+    std::uint32_t               m_channel_count;
+    std::uint32_t               m_reserved;
+    std::uint64_t               m_pixel_offset;         // offset of the pixels from the beginning of the segment
+};
+
+struct SharedFrameHeader
+{
+    enum { MaxPlaneCount = 32 };
+
+    enum State
+    {
+        StateOpen   = 1,
+        StateClosed = 2                                 // superseded or abandoned by the writer
+    };
+
+    char                        m_signature[8];         // "ASFRAME" followed by a null character
+    std::uint32_t               m_version;              // 1
+    std::uint32_t               m_header_size;          // sizeof(SharedFrameHeader)
+    std::atomic<std::uint32_t>  m_state;
+    std::uint32_t               m_frame_width;
+    std::uint32_t               m_frame_height;
+    std::uint32_t               m_tile_width;
+    std::uint32_t               m_tile_height;
+    std::uint32_t               m_ring_capacity;        // in events
+    std::uint64_t               m_ring_offset;
+    std::atomic<std::uint64_t>  m_event_count;          // number of events published so far
+    std::uint32_t               m_plane_count;
+    std::uint32_t               m_reserved;
+    SharedFramePlane            m_planes[MaxPlaneCount];
+};
+
+static_assert(sizeof(std::atomic<std::uint64_t>) == 8, "std::atomic<std::uint64_t> must be layout-compatible with std::uint64_t");
+
+
+//
+// A tile callback publishing the frame into a shared-memory framebuffer.
+//
+
+class APPLESEED_DLLSYMBOL SharedMemoryTileCallback
+  : public ITileCallback
+{
+  public:
+    // Constructor. The segment is created when the first frame is rendered.
+    explicit SharedMemoryTileCallback(
+        const char*             name,
+        const bool              include_aovs = true);
+
+    // Delete this instance.
+    void release() override;
+
+    void on_tiled_frame_begin(const Frame* frame) override;
+
+    void on_tiled_frame_end(const Frame* frame) override;
+
+    void on_tile_begin(
+        const Frame*            frame,
+        const size_t            tile_x,
+        const size_t            tile_y,
+        const size_t            thread_index,
+        const size_t            thread_count) override;
+
+    void on_tile_end(
+        const Frame*            frame,
+        const size_t            tile_x,
+        const size_t            tile_y) override;
+
+    void on_progressive_frame_update(
+        const Frame&            frame,
+        const double            time,
+        const std::uint64_t     samples,
+        const double            samples_per_pixel,
+        const std::uint64_t     samples_per_second) override;
+
+    void on_progressive_tiles_update(
+        const Frame&            frame,
+        const size_t*           tile_indices,
+        const size_t            tile_count,
+        const double            time,
+        const std::uint64_t     samples,
+        const double            samples_per_pixel,
+        const std::uint64_t     samples_per_second) override;
+
+  private:
+    friend class SharedMemoryTileCallbackFactory;
+
+    std::shared_ptr<SharedMemoryFrameWriter> m_writer;
+
+    explicit SharedMemoryTileCallback(const std::shared_ptr<SharedMemoryFrameWriter>& writer);
+};
+
+
+//
+// A factory of tile callbacks all publishing into the same shared-memory framebuffer.
+//
+
+class APPLESEED_DLLSYMBOL SharedMemoryTileCallbackFactory
+  : public ITileCallbackFactory
+{
+  public:
+    // Constructor.
+    explicit SharedMemoryTileCallbackFactory(
+        const char*             name,
+        const bool              include_aovs = true);
+
+    // Delete this instance.
+    void release() override;
+
+    // Return a new tile callback instance.
+    ITileCallback* create() override;
+
+  private:
+    std::shared_ptr<SharedMemoryFrameWriter> m_writer;
+};
+
+
+//
+// Read access to a shared-memory framebuffer, for host applications.
+//
+
+class APPLESEED_DLLSYMBOL SharedMemoryFrameReader
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. Throws foundation::ExceptionIOError if there is no framebuffer of that name.
+    explicit SharedMemoryFrameReader(const char* name);
+
+    // Destructor.
+    ~SharedMemoryFrameReader();
+
+    // Return the header of the framebuffer.
+    const SharedFrameHeader& get_header() const;
+
+    // Return true if the writer has closed the framebuffer; it must then be reopened.
+    bool is_closed() const;
+
+    // Return the pixels of a given plane.
+    const float* get_plane_pixels(const size_t plane_index) const;
+
+    // Wait at most 'timeout' seconds for new events. Return true if events were published.
+    bool wait(const double timeout);
+
+    // Append the events published since the last call to 'events'. Return false if some
+    // events were missed, in which case the whole frame should be considered updated.
+    bool read_events(std::vector<SharedTileEvent>& events);
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}   // namespace renderer
@@ -107,6 +107,28 @@ namespace
             }
         }
 
+        void on_progressive_tiles_update(
+            const Frame&            frame,
+            const size_t*           tile_indices,
+            const size_t            tile_count,
+            const double            time,
+            const std::uint64_t     samples,
+            const double            samples_per_pixel,
+            const std::uint64_t     samples_per_second) override
+        {
+            for (ITileCallback* callback : m_callbacks)
+            {
+                callback->on_progressive_tiles_update(
+                    frame,
+                    tile_indices,
+                    tile_count,
+                    time,
+                    samples,
+                    samples_per_pixel,
+                    samples_per_second);
+            }
+        }
+
       private:
         std::list<ITileCallback*> m_callbacks;
     };
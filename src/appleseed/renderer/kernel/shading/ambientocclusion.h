@@ -76,6 +76,12 @@ double compute_ambient_occlusion(
     ray.m_flags = VisibilityFlags::ProbeRay;
     ray.m_depth = shading_point.get_ray().m_depth + 1;
 
+    // Ambient occlusion rays are traced in batches.
+    const size_t BatchSize = 16;
+    ShadingRay rays[BatchSize];
+    bool occluded[BatchSize];
+    size_t batch_size = 0;
+
     size_t computed_samples = 0;
     size_t occluded_samples = 0;
 
@@ -97,9 +103,34 @@ double compute_ambient_occlusion(
         // Count the number of computed samples.
         ++computed_samples;
 
-        // Trace the ambient occlusion ray and count the number of occluded samples.
-        if (intersector.trace_probe(ray, &shading_point))
-            ++occluded_samples;
+        // Queue the ambient occlusion ray.
+        rays[batch_size++] = ray;
+
+        // Trace the queued rays and count the number of occluded samples.
+        if (batch_size == BatchSize)
+        {
+            intersector.trace_probe_stream(rays, batch_size, occluded, &shading_point);
+
+            for (size_t j = 0; j < batch_size; ++j)
+            {
+                if (occluded[j])
+                    ++occluded_samples;
+            }
+
+            batch_size = 0;
+        }
+    }
+
+    // Trace the remaining rays.
+    if (batch_size > 0)
+    {
+        intersector.trace_probe_stream(rays, batch_size, occluded, &shading_point);
+
+        for (size_t j = 0; j < batch_size; ++j)
+        {
+            if (occluded[j])
+                ++occluded_samples;
+        }
     }
 
     // Compute occlusion as a scalar between 0.0 and 1.0.
@@ -120,14 +120,8 @@ namespace
     {
     }
 
-    typedef int (*closure_get_modes)();
-
-    closure_get_modes g_closure_get_modes_funs[NumClosuresIDs];
-
-    int closure_no_modes()
-    {
-        return 0;
-    }
+    // Scattering modes of each closure type, looked up when closures are added.
+    int g_closure_modes[NumClosuresIDs];
 
     //
     // Closures.
@@ -178,7 +172,7 @@ namespace
             shading_system.register_closure(name(), id(), params, nullptr, nullptr);
 
             g_closure_convert_funs[id()] = &convert_closure;
-            g_closure_get_modes_funs[id()] = &modes;
+            g_closure_modes[id()] = modes();
         }
 
         static void convert_closure(
@@ -273,7 +267,7 @@ namespace
             shading_system.register_closure(name(), id(), params, nullptr, nullptr);
 
             g_closure_convert_funs[id()] = &convert_closure;
-            g_closure_get_modes_funs[id()] = &modes;
+            g_closure_modes[id()] = modes();
         }
 
         static void convert_closure(
@@ -360,7 +354,7 @@ namespace
             shading_system.register_closure(name(), id(), params, nullptr, nullptr);
 
             g_closure_convert_funs[id()] = &convert_closure;
-            g_closure_get_modes_funs[id()] = &modes;
+            g_closure_modes[id()] = modes();
         }
 
         static void convert_closure(
@@ -443,7 +437,7 @@ namespace
             shading_system.register_closure(name(), id(), params, nullptr, nullptr);
 
             g_closure_convert_funs[id()] = &convert_closure;
-            g_closure_get_modes_funs[id()] = &modes;
+            g_closure_modes[id()] = modes();
         }
 
         static void convert_closure(
@@ -586,7 +580,7 @@ namespace
 
             shading_system.register_closure(name(), id(), params, &prepare_closure, nullptr);
             g_closure_convert_funs[id()] = &convert_closure;
-            g_closure_get_modes_funs[id()] = &modes;
+            g_closure_modes[id()] = modes();
         }
 
         static void convert_closure(
@@ -676,7 +670,7 @@ namespace
 
             shading_system.register_closure(name(), id(), params, &prepare_closure, nullptr);
             g_closure_convert_funs[id()] = &convert_closure;
-            g_closure_get_modes_funs[id()] = &modes;
+            g_closure_modes[id()] = modes();
         }
 
         static void convert_closure(
@@ -772,7 +766,7 @@ namespace
 
             shading_system.register_closure(name(), id(), params, nullptr, nullptr);
             g_closure_convert_funs[id()] = &convert_closure;
-            g_closure_get_modes_funs[id()] = &modes;
+            g_closure_modes[id()] = modes();
         }
 
         static void convert_closure(
@@ -925,7 +919,7 @@ namespace
 
             shading_system.register_closure(name(), id(), params, &prepare_closure, nullptr);
             g_closure_convert_funs[id()] = &convert_closure;
-            g_closure_get_modes_funs[id()] = &modes;
+            g_closure_modes[id()] = modes();
         }
 
         static void convert_closure(
@@ -992,7 +986,7 @@ namespace
             shading_system.register_closure(name(), id(), params, nullptr, nullptr);
 
             g_closure_convert_funs[id()] = &convert_closure;
-            g_closure_get_modes_funs[id()] = &modes;
+            g_closure_modes[id()] = modes();
         }
 
         static void convert_closure(
@@ -1057,7 +1051,7 @@ namespace
             shading_system.register_closure(name(), id(), params, nullptr, nullptr);
 
             g_closure_convert_funs[id()] = &convert_closure;
-            g_closure_get_modes_funs[id()] = &modes;
+            g_closure_modes[id()] = modes();
         }
 
         static void convert_closure(
@@ -1133,7 +1127,7 @@ namespace
 
             shading_system.register_closure(name(), id(), params, nullptr, nullptr);
             g_closure_convert_funs[id()] = &convert_closure;
-            g_closure_get_modes_funs[id()] = &modes;
+            g_closure_modes[id()] = modes();
         }
 
         static void convert_closure(
@@ -1200,7 +1194,7 @@ namespace
             shading_system.register_closure(name(), id(), params, nullptr, nullptr);
 
             g_closure_convert_funs[id()] = &convert_closure;
-            g_closure_get_modes_funs[id()] = &modes;
+            g_closure_modes[id()] = modes();
         }
 
         static void convert_closure(
@@ -1262,7 +1256,7 @@ namespace
             shading_system.register_closure(name(), id(), params, nullptr, nullptr);
 
             g_closure_convert_funs[id()] = &convert_closure;
-            g_closure_get_modes_funs[id()] = &modes;
+            g_closure_modes[id()] = modes();
         }
 
         static void convert_closure(
@@ -1560,7 +1554,7 @@ namespace
             shading_system.register_closure(name(), id(), params, nullptr, nullptr);
 
             g_closure_convert_funs[id()] = &convert_closure;
-            g_closure_get_modes_funs[id()] = &modes;
+            g_closure_modes[id()] = modes();
         }
 
         static void convert_closure(
@@ -1744,6 +1738,88 @@ namespace
 }
 
 
+//
+// Closure tree traversal.
+//
+
+namespace
+{
+    // Maximum number of pending subtrees while traversing a closure tree.
+    const size_t MaxClosureTreeStackSize = 128;
+
+    // Visit the components of a closure tree, with their weight, in depth-first order.
+    // The traversal is iterative and uses a fixed-size stack of pending subtrees; it only
+    // recurses in the unlikely case where that stack is full.
+    template <typename Visitor>
+    void visit_closure_tree(
+        const OSL::ClosureColor*    closure,
+        const Color3f&              weight,
+        Visitor&&                   visitor)
+    {
+        struct PendingSubtree
+        {
+            const OSL::ClosureColor*    m_closure;
+            Color3f                     m_weight;
+        };
+
+        PendingSubtree stack[MaxClosureTreeStackSize];
+        size_t stack_size = 0;
+        Color3f w = weight;
+
+        while (true)
+        {
+            if (closure != nullptr)
+            {
+                switch (closure->id)
+                {
+                  case OSL::ClosureColor::MUL:
+                    {
+                        const OSL::ClosureMul* c = reinterpret_cast<const OSL::ClosureMul*>(closure);
+                        w *= Color3f(c->weight);
+                        closure = c->closure;
+                    }
+                    continue;
+
+                  case OSL::ClosureColor::ADD:
+                    {
+                        const OSL::ClosureAdd* c = reinterpret_cast<const OSL::ClosureAdd*>(closure);
+
+                        if APPLESEED_UNLIKELY(stack_size == MaxClosureTreeStackSize)
+                        {
+                            // Out of stack space: visit the first subtree recursively.
+                            visit_closure_tree(c->closureA, w, visitor);
+                            closure = c->closureB;
+                            continue;
+                        }
+
+                        stack[stack_size].m_closure = c->closureB;
+                        stack[stack_size].m_weight = w;
+                        ++stack_size;
+
+                        closure = c->closureA;
+                    }
+                    continue;
+
+                  default:
+                    {
+                        const OSL::ClosureComponent* c = reinterpret_cast<const OSL::ClosureComponent*>(closure);
+                        visitor(c, w * Color3f(c->w));
+                    }
+                    break;
+                }
+            }
+
+            if (stack_size == 0)
+                break;
+
+            --stack_size;
+            closure = stack[stack_size].m_closure;
+            w = stack[stack_size].m_weight;
+        }
+    }
+}
+
+
 //
 // CompositeClosure class implementation.
 //
@@ -1867,6 +1943,7 @@ InputValues* CompositeClosure::do_add_closure(
     else compute_closure_shading_basis(normal, original_shading_basis);
 
     m_closure_types[m_closure_count] = closure_type;
+    m_closure_modes[m_closure_count] = g_closure_modes[closure_type];
 
     InputValues* values = arena.allocate<InputValues>();
     m_input_values[m_closure_count] = values;
@@ -1939,24 +2016,16 @@ int CompositeSurfaceClosure::compute_pdfs(
     const int                   modes,
     float                       pdfs[MaxClosureEntries]) const
 {
-    memset(pdfs, 0, sizeof(float) * MaxClosureEntries);
-
     int num_closures = 0;
     float sum_weights = 0.0f;
 
+    // Closures that do not match the requested modes get a zero probability.
     for (size_t i = 0, e = get_closure_count(); i < e; ++i)
     {
-        const ClosureID cid = m_closure_types[i];
-        const int closure_modes = g_closure_get_modes_funs[cid]();
-
-        if (closure_modes & modes)
-        {
-            pdfs[i] = m_scalar_weights[i];
-            sum_weights += m_scalar_weights[i];
-            ++num_closures;
-        }
-        else
-            pdfs[i] = 0.0f;
+        const int match = (m_closure_modes[i] & modes) != 0 ? 1 : 0;
+        pdfs[i] = m_scalar_weights[i] * static_cast<float>(match);
+        sum_weights += pdfs[i];
+        num_closures += match;
     }
 
     if (sum_weights != 0.0f)
@@ -1975,9 +2044,14 @@ size_t CompositeSurfaceClosure::choose_closure(
     float                       pdfs[MaxClosureEntries]) const
 {
     assert(num_closures > 0);
-    assert(num_closures < MaxClosureEntries);
+    assert(num_closures <= get_closure_count());
+
+    // Matching closures are not necessarily the first ones: search up to the last one.
+    size_t size = get_closure_count();
+    while (pdfs[size - 1] == 0.0f)
+        --size;
 
-    return sample_pdf_linear_search(pdfs, num_closures, w);
+    return sample_pdf_linear_search(pdfs, size, w);
 }
 
 void CompositeSurfaceClosure::add_ior(
@@ -2010,37 +2084,14 @@ void CompositeSurfaceClosure::process_closure_tree(
     const Color3f&              weight,
     Arena&                      arena)
 {
-    if (closure == nullptr)
-        return;
-
-    switch (closure->id)
-    {
-      case OSL::ClosureColor::MUL:
+    visit_closure_tree(
+        closure,
+        weight,
+        [&](const OSL::ClosureComponent* c, const Color3f& w)
         {
-            const OSL::ClosureMul* c = reinterpret_cast<const OSL::ClosureMul*>(closure);
-            const Color3f w = weight * Color3f(c->weight);
-            process_closure_tree(c->closure, original_shading_basis, w, arena);
-        }
-        break;
-
-      case OSL::ClosureColor::ADD:
-        {
-            const OSL::ClosureAdd* c = reinterpret_cast<const OSL::ClosureAdd*>(closure);
-            process_closure_tree(c->closureA, original_shading_basis, weight, arena);
-            process_closure_tree(c->closureB, original_shading_basis, weight, arena);
-        }
-        break;
-
-      default:
-        {
-            const OSL::ClosureComponent* c = reinterpret_cast<const OSL::ClosureComponent*>(closure);
-            const Color3f w = weight * Color3f(c->w);
-
             if (luminance(w) > 0.0f)
                 g_closure_convert_funs[c->id](*this, original_shading_basis, c->data(), w, arena);
-        }
-        break;
-    }
+        });
 }
 
 
@@ -2069,33 +2120,13 @@ void CompositeSubsurfaceClosure::process_closure_tree(
     const Color3f&              weight,
     Arena&                      arena)
 {
-    if (closure == nullptr)
-        return;
-
-    switch (closure->id)
-    {
-      case OSL::ClosureColor::MUL:
+    visit_closure_tree(
+        closure,
+        weight,
+        [&](const OSL::ClosureComponent* c, const Color3f& w)
         {
-            const OSL::ClosureMul* c = reinterpret_cast<const OSL::ClosureMul*>(closure);
-            process_closure_tree(c->closure, original_shading_basis, weight * Color3f(c->weight), arena);
-        }
-        break;
-
-      case OSL::ClosureColor::ADD:
-        {
-            const OSL::ClosureAdd* c = reinterpret_cast<const OSL::ClosureAdd*>(closure);
-            process_closure_tree(c->closureA, original_shading_basis, weight, arena);
-            process_closure_tree(c->closureB, original_shading_basis, weight, arena);
-        }
-        break;
-
-      default:
-        {
-            const OSL::ClosureComponent* c = reinterpret_cast<const OSL::ClosureComponent*>(closure);
-
             if (c->id == SubsurfaceID)
             {
-                const Color3f w = weight * Color3f(c->w);
                 if (luminance(w) > 0.0f)
                 {
                     SubsurfaceClosure::convert_closure(
@@ -2108,7 +2139,6 @@ void CompositeSubsurfaceClosure::process_closure_tree(
             }
             else if (c->id == RandomwalkGlassID)
             {
-                const Color3f w = weight * Color3f(c->w);
                 if (luminance(w) > 0.0f)
                 {
                     RandomwalkGlassClosure::convert_closure(
@@ -2119,9 +2149,7 @@ void CompositeSubsurfaceClosure::process_closure_tree(
                         arena);
                 }
             }
-        }
-        break;
-    }
+        });
 }
 
 
@@ -2158,6 +2186,7 @@ InputValues* CompositeEmissionClosure::add_closure(
     }
 
     m_closure_types[m_closure_count] = closure_type;
+    m_closure_modes[m_closure_count] = g_closure_modes[closure_type];
     m_weights[m_closure_count].set(weight, g_std_lighting_conditions, Spectrum::Reflectance);
     m_pdfs[m_closure_count] = max_weight_component;
 
@@ -2174,36 +2203,16 @@ void CompositeEmissionClosure::process_closure_tree(
     const Color3f&              weight,
     Arena&                      arena)
 {
-    if (closure == nullptr)
-        return;
-
-    switch (closure->id)
-    {
-      case OSL::ClosureColor::MUL:
+    visit_closure_tree(
+        closure,
+        weight,
+        [&](const OSL::ClosureComponent* c, const Color3f& w)
         {
-            const OSL::ClosureMul* c = reinterpret_cast<const OSL::ClosureMul*>(closure);
-            process_closure_tree(c->closure, weight * Color3f(c->weight), arena);
-        }
-        break;
-
-      case OSL::ClosureColor::ADD:
-        {
-            const OSL::ClosureAdd* c = reinterpret_cast<const OSL::ClosureAdd*>(closure);
-            process_closure_tree(c->closureA, weight, arena);
-            process_closure_tree(c->closureB, weight, arena);
-        }
-        break;
-
-      default:
-        {
-            const OSL::ClosureComponent* c = reinterpret_cast<const OSL::ClosureComponent*>(closure);
-
-            const Color3f w = weight * Color3f(c->w);
-            const float max_weight_component = max_value(w);
-
-            if (max_weight_component > 0.0f)
+            if (c->id == EmissionID)
             {
-                if (c->id == EmissionID)
+                const float max_weight_component = max_value(w);
+
+                if (max_weight_component > 0.0f)
                 {
                     EmissionClosure::convert_closure(
                         *this,
@@ -2213,9 +2222,7 @@ void CompositeEmissionClosure::process_closure_tree(
                         arena);
                 }
             }
-        }
-        break;
-    }
+        });
 }
 
 
@@ -2244,6 +2251,7 @@ InputValues* CompositeNPRClosure::add_closure(
     }
 
     m_closure_types[m_closure_count] = closure_type;
+    m_closure_modes[m_closure_count] = g_closure_modes[closure_type];
     m_weights[m_closure_count].set(weight, g_std_lighting_conditions, Spectrum::Reflectance);
 
     InputValues* values = arena.allocate<InputValues>();
@@ -2277,32 +2285,13 @@ void CompositeNPRClosure::process_closure_tree(
     const Color3f&              weight,
     Arena&                      arena)
 {
-    if (closure == nullptr)
-        return;
-
-    switch (closure->id)
-    {
-      case OSL::ClosureColor::MUL:
-        {
-            const OSL::ClosureMul* c = reinterpret_cast<const OSL::ClosureMul*>(closure);
-            process_closure_tree(c->closure, weight * Color3f(c->weight), arena);
-        }
-        break;
-
-      case OSL::ClosureColor::ADD:
-        {
-            const OSL::ClosureAdd* c = reinterpret_cast<const OSL::ClosureAdd*>(closure);
-            process_closure_tree(c->closureA, weight, arena);
-            process_closure_tree(c->closureB, weight, arena);
-        }
-        break;
-
-      default:
+    visit_closure_tree(
+        closure,
+        weight,
+        [&](const OSL::ClosureComponent* c, const Color3f& w)
         {
-            const OSL::ClosureComponent* c = reinterpret_cast<const OSL::ClosureComponent*>(closure);
             if (c->id == NPRShadingID)
             {
-                const Color3f w = weight * Color3f(c->w);
                 NPRShadingClosure::convert_closure(
                     *this,
                     c->data(),
@@ -2311,16 +2300,13 @@ void CompositeNPRClosure::process_closure_tree(
             }
             else if (c->id == NPRContourID)
             {
-                const Color3f w = weight * Color3f(c->w);
                 NPRContourClosure::convert_closure(
                     *this,
                     c->data(),
                     w,
                     arena);
             }
-        }
-        break;
-    }
+        });
 }
 
 
@@ -2334,37 +2320,18 @@ namespace
         const OSL::ClosureColor*    closure,
         const int                   closure_id)
     {
-        if (closure)
-        {
-            switch (closure->id)
-            {
-              case OSL::ClosureColor::MUL:
-                {
-                    const OSL::ClosureMul* c = reinterpret_cast<const OSL::ClosureMul*>(closure);
-                    return Color3f(c->weight) * do_process_closure_id_tree(c->closure, closure_id);
-                }
-                break;
-
-              case OSL::ClosureColor::ADD:
-                {
-                    const OSL::ClosureAdd* c = reinterpret_cast<const OSL::ClosureAdd*>(closure);
-                    return do_process_closure_id_tree(c->closureA, closure_id) +
-                           do_process_closure_id_tree(c->closureB, closure_id);
-                }
-                break;
+        Color3f result(0.0f);
 
-              default:
-                {
-                    const OSL::ClosureComponent* c = reinterpret_cast<const OSL::ClosureComponent*>(closure);
-                    if (c->id == closure_id)
-                        return Color3f(c->w);
-                    else return Color3f(0.0f);
-                }
-                break;
-            }
-        }
+        visit_closure_tree(
+            closure,
+            Color3f(1.0f),
+            [&](const OSL::ClosureComponent* c, const Color3f& w)
+            {
+                if (c->id == closure_id)
+                    result += w;
+            });
 
-        return Color3f(0.0f);
+        return result;
     }
 }
 
@@ -2450,7 +2417,7 @@ void register_closures(OSLShadingSystem& shading_system)
     for (size_t i = 0; i < NumClosuresIDs; ++i)
     {
         g_closure_convert_funs[i] = &convert_closure_nop;
-        g_closure_get_modes_funs[i] = &closure_no_modes;
+        g_closure_modes[i] = 0;
     }
 
     register_closure<AshikhminShirleyClosure>(shading_system);
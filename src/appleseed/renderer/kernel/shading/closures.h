@@ -176,6 +176,7 @@ class APPLESEED_ALIGN(16) CompositeClosure
     size_t                          m_closure_count;
     void*                           m_input_values[MaxClosureEntries];
     ClosureID                       m_closure_types[MaxClosureEntries];
+    int                             m_closure_modes[MaxClosureEntries];
     Spectrum                        m_weights[MaxClosureEntries];
     float                           m_scalar_weights[MaxClosureEntries];
     foundation::Basis3f             m_bases[MaxClosureEntries];
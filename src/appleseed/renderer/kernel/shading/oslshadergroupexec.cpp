@@ -30,6 +30,7 @@
 #include "oslshadergroupexec.h"
 
 // appleseed.renderer headers.
+#include "renderer/kernel/rendering/rendercosttracker.h"
 #include "renderer/kernel/shading/closures.h"
 #include "renderer/kernel/shading/oslshadingsystem.h"
 #include "renderer/kernel/shading/shadingpoint.h"
@@ -49,9 +50,13 @@ namespace renderer
 // OSLShaderGroupExec class implementation.
 //
 
-OSLShaderGroupExec::OSLShaderGroupExec(OSLShadingSystem& shading_system, Arena& arena)
+OSLShaderGroupExec::OSLShaderGroupExec(
+    OSLShadingSystem&               shading_system,
+    Arena&                          arena,
+    RenderCostTracker*              cost_tracker)
   : m_osl_shading_system(shading_system)
   , m_arena(arena)
+  , m_cost_tracker(cost_tracker)
   , m_osl_thread_info(shading_system.create_thread_info())
   , m_osl_shading_context(shading_system.get_context(m_osl_thread_info))
 {
@@ -208,6 +213,8 @@ void OSLShaderGroupExec::do_execute(
     assert(m_osl_shading_context);
     assert(m_osl_thread_info);
 
+    const RenderCostTracker::ShaderGroupScope cost_scope(m_cost_tracker, shader_group);
+
     shading_point.initialize_osl_shader_globals(
         shader_group,
         ray_flags,
@@ -46,6 +46,7 @@
 // Forward declarations.
 namespace foundation    { class Arena; }
 namespace renderer      { class OSLShadingSystem; }
+namespace renderer      { class RenderCostTracker; }
 namespace renderer      { class ShaderGroup; }
 namespace renderer      { class ShadingContext; }
 namespace renderer      { class ShadingPoint; }
@@ -60,7 +61,8 @@ class OSLShaderGroupExec
   public:
     OSLShaderGroupExec(
         OSLShadingSystem&               shading_system,
-        foundation::Arena&              arena);
+        foundation::Arena&              arena,
+        RenderCostTracker*              cost_tracker = nullptr);
 
     ~OSLShaderGroupExec();
 
@@ -70,6 +72,7 @@ class OSLShaderGroupExec
 
     OSLShadingSystem&                   m_osl_shading_system;
     foundation::Arena&                  m_arena;
+    RenderCostTracker*                  m_cost_tracker;
 
     OSL::PerThreadInfo*                 m_osl_thread_info;
     OSL::ShadingContext*                m_osl_shading_context;
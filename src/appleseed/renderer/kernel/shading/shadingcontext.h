@@ -45,6 +45,7 @@ namespace renderer      { class ILightingEngine; }
 namespace renderer      { class Intersector; }
 namespace renderer      { class OIIOTextureSystem; }
 namespace renderer      { class OSLShadingSystem; }
+namespace renderer      { class RenderCostTracker; }
 namespace renderer      { class ShadingPoint; }
 namespace renderer      { class TextureCache; }
 namespace renderer      { class Tracer; }
@@ -85,6 +86,10 @@ class ShadingContext
 
     foundation::Arena& get_arena() const;
 
+    // Return the render cost tracker of the current rendering thread, or nullptr
+    // if render costs are not being tracked.
+    RenderCostTracker* get_cost_tracker() const;
+
     // Return the index of the current rendering thread.
     size_t get_thread_index() const;
 
@@ -182,6 +187,11 @@ inline foundation::Arena& ShadingContext::get_arena() const
     return m_arena;
 }
 
+inline RenderCostTracker* ShadingContext::get_cost_tracker() const
+{
+    return m_shadergroup_exec.m_cost_tracker;
+}
+
 inline size_t ShadingContext::get_thread_index() const
 {
     return m_thread_index;
@@ -33,6 +33,7 @@
 // appleseed.renderer headers.
 #include "renderer/kernel/aov/aovaccumulator.h"
 #include "renderer/kernel/aov/aovcomponents.h"
+#include "renderer/kernel/rendering/rendercosttracker.h"
 #include "renderer/kernel/shading/closures.h"
 #include "renderer/kernel/shading/shadingcomponents.h"
 #include "renderer/kernel/shading/shadingcontext.h"
@@ -54,6 +55,7 @@
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
 #include "foundation/math/vector.h"
+#include "foundation/utility/hardwarecounters.h"
 
 using namespace foundation;
 
@@ -114,6 +116,11 @@ bool ShadingEngine::shade_hit_point(
     AOVAccumulatorContainer&    aov_accumulators,
     ShadingResult&              shading_result) const
 {
+    APPLESEED_HARDWARE_COUNTERS_SCOPE("shading");
+
+    // Attribute the cost of this hit to the intersected object instance and material.
+    const RenderCostTracker::HitScope cost_scope(shading_context.get_cost_tracker(), shading_point);
+
     // Compute the alpha channel of the main output.
     shading_result.m_main.a = shading_point.get_alpha()[0];
 
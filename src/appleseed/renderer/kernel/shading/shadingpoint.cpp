@@ -196,6 +196,40 @@ void ShadingPoint::fetch_triangle_source_geometry() const
     const GScalar frac = static_cast<GScalar>(base_time - base_index);
     const GScalar one_minus_frac = GScalar(1.0) - frac;
 
+    // Copy all attributes from the interleaved shading data if it is available.
+    if (motion_segment_count == 0 && tess.has_shading_data())
+    {
+        const StaticTriangleTess::ShadingData& data = tess.get_shading_data(m_primitive_index);
+
+        m_primitive_pa = data.m_pa;
+
+        m_v0 = data.m_v0;
+        m_v1 = data.m_v1;
+        m_v2 = data.m_v2;
+
+        m_v0_uv = data.m_uv0;
+        m_v1_uv = data.m_uv1;
+        m_v2_uv = data.m_uv2;
+
+        if (data.m_flags & StaticTriangleTess::ShadingData::HasVertexNormals)
+        {
+            m_n0 = data.m_n0;
+            m_n1 = data.m_n1;
+            m_n2 = data.m_n2;
+            m_members |= HasTriangleVertexNormals;
+        }
+
+        if (data.m_flags & StaticTriangleTess::ShadingData::HasVertexTangents)
+        {
+            m_t0 = data.m_t0;
+            m_t1 = data.m_t1;
+            m_t2 = data.m_t2;
+            m_members |= HasTriangleVertexTangents;
+        }
+
+        return;
+    }
+
     // Retrieve the triangle.
     const Triangle& triangle = tess.m_primitives[m_primitive_index];
     assert(triangle.m_v0 != Triangle::None);
@@ -265,9 +299,9 @@ void ShadingPoint::fetch_triangle_source_geometry() const
             // Fetch vertex normals from previous pose.
             if (base_index == 0)
             {
-                m_n0 = tess.m_vertex_normals[triangle.m_n0];
-                m_n1 = tess.m_vertex_normals[triangle.m_n1];
-                m_n2 = tess.m_vertex_normals[triangle.m_n2];
+                m_n0 = tess.get_vertex_normal(triangle.m_n0);
+                m_n1 = tess.get_vertex_normal(triangle.m_n1);
+                m_n2 = tess.get_vertex_normal(triangle.m_n2);
             }
             else
             {
@@ -292,9 +326,9 @@ void ShadingPoint::fetch_triangle_source_geometry() const
         }
         else
         {
-            m_n0 = tess.m_vertex_normals[triangle.m_n0];
-            m_n1 = tess.m_vertex_normals[triangle.m_n1];
-            m_n2 = tess.m_vertex_normals[triangle.m_n2];
+            m_n0 = tess.get_vertex_normal(triangle.m_n0);
+            m_n1 = tess.get_vertex_normal(triangle.m_n1);
+            m_n2 = tess.get_vertex_normal(triangle.m_n2);
         }
 
         assert(is_normalized(m_n0));
@@ -273,6 +273,7 @@ class ShadingPoint
     friend class AssemblyLeafProbeVisitor;
     friend class AssemblyLeafVisitor;
     friend class CurveLeafVisitor;
+    friend class EmbreeInstanceScene;
     friend class EmbreeScene;
     friend class Intersector;
     friend class NPRSurfaceShaderHelper;
@@ -324,6 +325,17 @@ class ShadingPoint
     };
     mutable std::uint32_t               m_members;
 
+    // On-demand intersection results read by almost every shading query. They are
+    // kept next to the primary intersection results so that they share cache lines.
+    mutable foundation::Vector3d        m_point;                        // world space intersection point
+    mutable foundation::Vector3d        m_geometric_normal;             // world space geometric normal, unit-length
+    mutable foundation::Vector3d        m_original_shading_normal;      // original world space shading normal, unit-length
+    mutable foundation::Basis3d         m_shading_basis;                // world space orthonormal basis around shading normal
+    mutable ObjectInstance::Side        m_side;                         // side of the surface that was hit
+    mutable foundation::Vector2f        m_uv;                           // texture coordinates from UV set #0
+    mutable const Material*             m_material;                     // material at intersection point
+    mutable const Material*             m_opposite_material;            // opposite material at intersection point
+
     // Source geometry (derived from primary intersection results).
     mutable const Assembly*             m_assembly;                     // hit assembly
     mutable ObjectInstance*             m_object_instance;              // hit object instance
@@ -334,25 +346,17 @@ class ShadingPoint
     mutable GVector3                    m_n0, m_n1, m_n2;               // object instance space triangle vertex normals
     mutable GVector3                    m_t0, m_t1, m_t2;               // object instance space triangle vertex tangents
 
-    // On-demand intersection results (derived from primary intersection results).
-    mutable foundation::Vector2f        m_uv;                           // texture coordinates from UV set #0
+    // Less frequently used on-demand intersection results (derived from primary intersection results).
     mutable foundation::Vector2f        m_duvdx;                        // screen space partial derivative of the texture coords wrt. X
     mutable foundation::Vector2f        m_duvdy;                        // screen space partial derivative of the texture coords wrt. Y
-    mutable foundation::Vector3d        m_point;                        // world space intersection point
     mutable foundation::Vector3d        m_dpdu;                         // world space partial derivative of the intersection point wrt. U
     mutable foundation::Vector3d        m_dpdv;                         // world space partial derivative of the intersection point wrt. V
     mutable foundation::Vector3d        m_dndu;                         // world space partial derivative of the intersection normal wrt. U
     mutable foundation::Vector3d        m_dndv;                         // world space partial derivative of the intersection normal wrt. V
     mutable foundation::Vector3d        m_dpdx;                         // screen space partial derivative of the intersection point wrt. X
     mutable foundation::Vector3d        m_dpdy;                         // screen space partial derivative of the intersection point wrt. Y
-    mutable foundation::Vector3d        m_geometric_normal;             // world space geometric normal, unit-length
-    mutable foundation::Vector3d        m_original_shading_normal;      // original world space shading normal, unit-length
-    mutable foundation::Basis3d         m_shading_basis;                // world space orthonormal basis around shading normal
-    mutable ObjectInstance::Side        m_side;                         // side of the surface that was hit
     mutable foundation::Vector3d        m_v0_w, m_v1_w, m_v2_w;         // world space triangle vertices
     mutable foundation::Vector3d        m_point_velocity;               // world space point velocity
-    mutable const Material*             m_material;                     // material at intersection point
-    mutable const Material*             m_opposite_material;            // opposite material at intersection point
     mutable Alpha                       m_alpha;                        // opacity at intersection point
     mutable foundation::Color3f         m_color;                        // per-vertex interpolated color at intersection point
 
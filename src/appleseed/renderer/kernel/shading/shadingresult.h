@@ -62,6 +62,9 @@ class ShadingResult
     // The main output and AOVs are cleared to transparent black.
     explicit ShadingResult(const size_t aov_count = 0);
 
+    // Set the number of AOVs and clear the main output and the AOVs to transparent black.
+    void reset(const size_t aov_count);
+
     // Return true if the main output is finite (not NaN, not infinite) and non-negative.
     bool is_main_valid() const;
 
@@ -84,10 +87,16 @@ class ShadingResult
 //
 
 inline ShadingResult::ShadingResult(const size_t aov_count)
-  : m_aov_count(aov_count)
+{
+    reset(aov_count);
+}
+
+inline void ShadingResult::reset(const size_t aov_count)
 {
     assert(aov_count <= MaxAOVCount);
 
+    m_aov_count = aov_count;
+
     m_main.set(0.0f);
 
     for (size_t i = 0, e = m_aov_count; i < e; ++i)
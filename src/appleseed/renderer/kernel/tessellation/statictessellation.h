@@ -34,7 +34,12 @@
 #include "renderer/modeling/object/triangle.h"
 
 // appleseed.foundation headers.
+#include "foundation/containers/alignedvector.h"
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/compressedunitvector.h"
+#include "foundation/math/half.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/memory.h"
 #include "foundation/memory/poolallocator.h"
 #include "foundation/utility/attributeset.h"
 #include "foundation/utility/lazy.h"
@@ -61,14 +66,13 @@ class StaticTessellation
     // Primitive type.
     typedef Primitive PrimitiveType;
 
-    // Vertex and primitive array types.
+    // Vertex and primitive array types. Large arrays are backed by large pages.
     // todo: use paged arrays?
-    typedef std::vector<GVector3> VectorArray;
-    typedef std::vector<PrimitiveType> PrimitiveArray;
+    typedef foundation::AlignedVector<GVector3> VectorArray;
+    typedef foundation::AlignedVector<PrimitiveType> PrimitiveArray;
 
     // Primary features.
     VectorArray                 m_vertices;
-    VectorArray                 m_vertex_normals;
     PrimitiveArray              m_primitives;
 
     // Additional attributes.
@@ -83,17 +87,36 @@ class StaticTessellation
     // Constructor.
     StaticTessellation();
 
+    // Remove all vertices, including their poses, and release their memory.
+    void clear_vertices();
+
+    // Enable or disable compressed storage of vertex normals and tangents (32-bit
+    // octahedral encoding) and of texture coordinates (half precision). This must
+    // be set before any of these attributes are inserted. Vertex poses are not
+    // affected. Attributes are decoded when they are accessed.
+    void set_compressed_vertex_attributes(const bool compressed);
+    bool has_compressed_vertex_attributes() const;
+
+    // Insert and access vertex normals.
+    void reserve_vertex_normals(const size_t count);
+    size_t push_vertex_normal(const GVector3& normal);      // the normal must be unit-length
+    size_t get_vertex_normal_count() const;
+    GVector3 get_vertex_normal(const size_t index) const;
+    void clear_vertex_normals();
+
     // Insert and access texture coordinates.
     void reserve_tex_coords(const size_t count);
     size_t push_tex_coords(const GVector2& uv);
     size_t get_tex_coords_count() const;
     GVector2 get_tex_coords(const size_t index) const;
+    void clear_tex_coords();
 
     // Insert and access vertex tangents.
     void reserve_vertex_tangents(const size_t count);
     size_t push_vertex_tangent(const GVector3& tangent);    // the tangent must be unit-length
     size_t get_vertex_tangent_count() const;
     GVector3 get_vertex_tangent(const size_t index) const;
+    void clear_vertex_tangents();
 
     // Set/get the number of motion segments (the number of motion vectors per vertex).
     void set_motion_segment_count(const size_t count);
@@ -144,7 +167,44 @@ class StaticTessellation
     // Compute the local space bounding box of the tessellation over the shutter interval.
     GAABB3 compute_local_bbox() const;
 
+    // Decoded vertex attributes of a primitive, interleaved in the order in which
+    // shading point construction reads them.
+    struct ShadingData
+    {
+        enum Flags
+        {
+            HasVertexNormals    = 1UL << 0,
+            HasVertexTangents   = 1UL << 1
+        };
+
+        GVector3                m_v0, m_v1, m_v2;           // vertices
+        GVector3                m_n0, m_n1, m_n2;           // vertex normals, if HasVertexNormals is set
+        GVector2                m_uv0, m_uv1, m_uv2;        // texture coordinates, or barycentric coordinates if absent
+        GVector3                m_t0, m_t1, m_t2;           // vertex tangents, if HasVertexTangents is set
+        std::uint32_t           m_pa;                       // primitive attribute index
+        std::uint32_t           m_flags;
+    };
+
+    // Build or remove an interleaved copy of the vertex attributes of all primitives.
+    // It saves several cache misses per shading point at the cost of duplicating
+    // the vertex data. The tessellation must not have motion segments.
+    void build_shading_data();
+    void clear_shading_data();
+    bool has_shading_data() const;
+    const ShadingData& get_shading_data(const size_t primitive_index) const;
+
+    // Return the size (in bytes) of the tessellation in memory.
+    size_t get_memory_size() const;
+
   private:
+    typedef std::vector<foundation::CompressedUnitVector> CompressedVectorArray;
+    typedef foundation::Vector<std::uint16_t, 2> CompressedTexCoords;
+
+    VectorArray                         m_vertex_normals;
+    CompressedVectorArray               m_compressed_vertex_normals;
+    bool                                m_compressed_vertex_attributes;
+    std::vector<ShadingData>            m_shading_data;
+
     foundation::AttributeSet::ChannelID m_uv_0_cid;         // UV coordinates set #0
     foundation::AttributeSet::ChannelID m_tangents_cid;     // per-vertex tangent vectors
     foundation::AttributeSet::ChannelID m_ms_count_cid;     // motion segment count
@@ -178,7 +238,10 @@ typedef foundation::AccessCache<
 
 template <typename Primitive>
 inline StaticTessellation<Primitive>::StaticTessellation()
-  : m_uv_0_cid(foundation::AttributeSet::InvalidChannelID)
+  : m_vertices(foundation::AlignedAllocator<void>(16, true))
+  , m_primitives(foundation::AlignedAllocator<void>(16, true))
+  , m_compressed_vertex_attributes(false)
+  , m_uv_0_cid(foundation::AttributeSet::InvalidChannelID)
   , m_tangents_cid(foundation::AttributeSet::InvalidChannelID)
   , m_ms_count_cid(foundation::AttributeSet::InvalidChannelID)
   , m_vp_cid(foundation::AttributeSet::InvalidChannelID)
@@ -187,6 +250,82 @@ inline StaticTessellation<Primitive>::StaticTessellation()
 {
 }
 
+template <typename Primitive>
+inline void StaticTessellation<Primitive>::clear_vertices()
+{
+    VectorArray(m_vertices.get_allocator()).swap(m_vertices);
+
+    if (m_vp_cid != foundation::AttributeSet::InvalidChannelID)
+        m_vertex_attributes.clear_attributes(m_vp_cid);
+}
+
+template <typename Primitive>
+inline void StaticTessellation<Primitive>::set_compressed_vertex_attributes(const bool compressed)
+{
+    assert(get_vertex_normal_count() == 0);
+    assert(get_vertex_tangent_count() == 0);
+    assert(get_tex_coords_count() == 0);
+
+    m_compressed_vertex_attributes = compressed;
+}
+
+template <typename Primitive>
+inline bool StaticTessellation<Primitive>::has_compressed_vertex_attributes() const
+{
+    return m_compressed_vertex_attributes;
+}
+
+template <typename Primitive>
+inline void StaticTessellation<Primitive>::reserve_vertex_normals(const size_t count)
+{
+    if (m_compressed_vertex_attributes)
+        m_compressed_vertex_normals.reserve(count);
+    else
+        m_vertex_normals.reserve(count);
+}
+
+template <typename Primitive>
+inline size_t StaticTessellation<Primitive>::push_vertex_normal(const GVector3& normal)
+{
+    if (m_compressed_vertex_attributes)
+    {
+        const size_t index = m_compressed_vertex_normals.size();
+        m_compressed_vertex_normals.push_back(foundation::CompressedUnitVector(foundation::Vector3f(normal)));
+        return index;
+    }
+    else
+    {
+        const size_t index = m_vertex_normals.size();
+        m_vertex_normals.push_back(normal);
+        return index;
+    }
+}
+
+template <typename Primitive>
+inline size_t StaticTessellation<Primitive>::get_vertex_normal_count() const
+{
+    return
+        m_compressed_vertex_attributes
+            ? m_compressed_vertex_normals.size()
+            : m_vertex_normals.size();
+}
+
+template <typename Primitive>
+inline GVector3 StaticTessellation<Primitive>::get_vertex_normal(const size_t index) const
+{
+    return
+        m_compressed_vertex_attributes
+            ? GVector3(foundation::Vector3f(m_compressed_vertex_normals[index]))
+            : m_vertex_normals[index];
+}
+
+template <typename Primitive>
+inline void StaticTessellation<Primitive>::clear_vertex_normals()
+{
+    VectorArray().swap(m_vertex_normals);
+    CompressedVectorArray().swap(m_compressed_vertex_normals);
+}
+
 template <typename Primitive>
 inline void StaticTessellation<Primitive>::reserve_tex_coords(const size_t count)
 {
@@ -202,6 +341,16 @@ inline size_t StaticTessellation<Primitive>::push_tex_coords(const GVector2& uv)
     if (m_uv_0_cid == foundation::AttributeSet::InvalidChannelID)
         create_uv_0_attribute();
 
+    if (m_compressed_vertex_attributes)
+    {
+        return
+            m_vertex_attributes.push_attribute(
+                m_uv_0_cid,
+                CompressedTexCoords(
+                    foundation::Half(uv[0]).bits(),
+                    foundation::Half(uv[1]).bits()));
+    }
+
     return m_vertex_attributes.push_attribute(m_uv_0_cid, uv);
 }
 
@@ -219,12 +368,30 @@ inline GVector2 StaticTessellation<Primitive>::get_tex_coords(const size_t index
 {
     assert(m_uv_0_cid != foundation::AttributeSet::InvalidChannelID);
 
+    if (m_compressed_vertex_attributes)
+    {
+        CompressedTexCoords bits;
+        m_vertex_attributes.get_attribute(m_uv_0_cid, index, &bits);
+
+        return
+            GVector2(
+                foundation::Half::from_bits(bits[0]),
+                foundation::Half::from_bits(bits[1]));
+    }
+
     GVector2 uv;
     m_vertex_attributes.get_attribute(m_uv_0_cid, index, &uv);
 
     return uv;
 }
 
+template <typename Primitive>
+inline void StaticTessellation<Primitive>::clear_tex_coords()
+{
+    if (m_uv_0_cid != foundation::AttributeSet::InvalidChannelID)
+        m_vertex_attributes.clear_attributes(m_uv_0_cid);
+}
+
 template <typename Primitive>
 inline void StaticTessellation<Primitive>::reserve_vertex_tangents(const size_t count)
 {
@@ -240,6 +407,14 @@ inline size_t StaticTessellation<Primitive>::push_vertex_tangent(const GVector3&
     if (m_tangents_cid == foundation::AttributeSet::InvalidChannelID)
         create_tangents_attribute();
 
+    if (m_compressed_vertex_attributes)
+    {
+        return
+            m_vertex_attributes.push_attribute(
+                m_tangents_cid,
+                foundation::CompressedUnitVector(foundation::Vector3f(tangent)));
+    }
+
     return m_vertex_attributes.push_attribute(m_tangents_cid, tangent);
 }
 
@@ -257,12 +432,27 @@ inline GVector3 StaticTessellation<Primitive>::get_vertex_tangent(const size_t i
 {
     assert(m_tangents_cid != foundation::AttributeSet::InvalidChannelID);
 
+    if (m_compressed_vertex_attributes)
+    {
+        foundation::CompressedUnitVector compressed_tangent;
+        m_vertex_attributes.get_attribute(m_tangents_cid, index, &compressed_tangent);
+
+        return GVector3(foundation::Vector3f(compressed_tangent));
+    }
+
     GVector3 tangent;
     m_vertex_attributes.get_attribute(m_tangents_cid, index, &tangent);
 
     return tangent;
 }
 
+template <typename Primitive>
+inline void StaticTessellation<Primitive>::clear_vertex_tangents()
+{
+    if (m_tangents_cid != foundation::AttributeSet::InvalidChannelID)
+        m_vertex_attributes.clear_attributes(m_tangents_cid);
+}
+
 template <typename Primitive>
 inline void StaticTessellation<Primitive>::set_motion_segment_count(const size_t count)
 {
@@ -352,7 +542,7 @@ inline void StaticTessellation<Primitive>::set_vertex_normal_pose(
     const size_t    motion_segment_index,
     const GVector3& normal)
 {
-    assert(normal_index < m_vertex_normals.size());
+    assert(normal_index < get_vertex_normal_count());
 
     const size_t motion_segment_count = get_motion_segment_count();
     assert(motion_segment_index < motion_segment_count);
@@ -378,7 +568,7 @@ inline GVector3 StaticTessellation<Primitive>::get_vertex_normal_pose(
     const size_t    motion_segment_index) const
 {
     assert(m_vnp_cid != foundation::AttributeSet::InvalidChannelID);
-    assert(normal_index < m_vertex_normals.size());
+    assert(normal_index < get_vertex_normal_count());
 
     const size_t motion_segment_count = get_motion_segment_count();
     assert(motion_segment_index < motion_segment_count);
@@ -434,7 +624,7 @@ inline GVector3 StaticTessellation<Primitive>::get_vertex_tangent_pose(
     const size_t    motion_segment_index) const
 {
     assert(m_vtp_cid != foundation::AttributeSet::InvalidChannelID);
-    assert(tangent_index < m_vertex_normals.size());
+    assert(tangent_index < get_vertex_tangent_count());
 
     const size_t motion_segment_count = get_motion_segment_count();
     assert(motion_segment_index < motion_segment_count);
@@ -478,24 +668,126 @@ GAABB3 StaticTessellation<Primitive>::compute_local_bbox() const
     return bbox;
 }
 
+template <typename Primitive>
+void StaticTessellation<Primitive>::build_shading_data()
+{
+    assert(get_motion_segment_count() == 0);
+
+    const size_t primitive_count = m_primitives.size();
+    const bool has_tex_coords = get_tex_coords_count() > 0;
+    const bool has_tangents = get_vertex_tangent_count() > 0;
+
+    m_shading_data.resize(primitive_count);
+
+    for (size_t i = 0; i < primitive_count; ++i)
+    {
+        const PrimitiveType& primitive = m_primitives[i];
+        ShadingData& data = m_shading_data[i];
+
+        data.m_v0 = m_vertices[primitive.m_v0];
+        data.m_v1 = m_vertices[primitive.m_v1];
+        data.m_v2 = m_vertices[primitive.m_v2];
+
+        data.m_pa = primitive.m_pa;
+        data.m_flags = 0;
+
+        if (primitive.m_n0 != PrimitiveType::None &&
+            primitive.m_n1 != PrimitiveType::None &&
+            primitive.m_n2 != PrimitiveType::None)
+        {
+            data.m_n0 = get_vertex_normal(primitive.m_n0);
+            data.m_n1 = get_vertex_normal(primitive.m_n1);
+            data.m_n2 = get_vertex_normal(primitive.m_n2);
+            data.m_flags |= ShadingData::HasVertexNormals;
+        }
+
+        const bool has_vertex_attributes = primitive.has_vertex_attributes();
+
+        if (has_vertex_attributes && has_tex_coords)
+        {
+            data.m_uv0 = get_tex_coords(primitive.m_a0);
+            data.m_uv1 = get_tex_coords(primitive.m_a1);
+            data.m_uv2 = get_tex_coords(primitive.m_a2);
+        }
+        else
+        {
+            data.m_uv0 = GVector2(0.0, 0.0);
+            data.m_uv1 = GVector2(1.0, 0.0);
+            data.m_uv2 = GVector2(0.0, 1.0);
+        }
+
+        // Tangents are indexed by vertex.
+        if (has_vertex_attributes && has_tangents)
+        {
+            data.m_t0 = get_vertex_tangent(primitive.m_v0);
+            data.m_t1 = get_vertex_tangent(primitive.m_v1);
+            data.m_t2 = get_vertex_tangent(primitive.m_v2);
+            data.m_flags |= ShadingData::HasVertexTangents;
+        }
+    }
+}
+
+template <typename Primitive>
+void StaticTessellation<Primitive>::clear_shading_data()
+{
+    foundation::clear_release_memory(m_shading_data);
+}
+
+template <typename Primitive>
+inline bool StaticTessellation<Primitive>::has_shading_data() const
+{
+    return !m_shading_data.empty();
+}
+
+template <typename Primitive>
+inline const typename StaticTessellation<Primitive>::ShadingData&
+StaticTessellation<Primitive>::get_shading_data(const size_t primitive_index) const
+{
+    assert(primitive_index < m_shading_data.size());
+    return m_shading_data[primitive_index];
+}
+
+template <typename Primitive>
+size_t StaticTessellation<Primitive>::get_memory_size() const
+{
+    return
+          sizeof(*this)
+        + m_vertices.capacity() * sizeof(GVector3)
+        + m_vertex_normals.capacity() * sizeof(GVector3)
+        + m_compressed_vertex_normals.capacity() * sizeof(foundation::CompressedUnitVector)
+        + m_shading_data.capacity() * sizeof(ShadingData)
+        + m_primitives.capacity() * sizeof(PrimitiveType)
+        + m_tessellation_attributes.get_memory_size()
+        + m_vertex_attributes.get_memory_size()
+        + m_vertex_normal_attributes.get_memory_size()
+        + m_vertex_tangent_attributes.get_memory_size()
+        + m_vertex_tangent_poses.get_memory_size()
+        + m_primitive_attributes.get_memory_size();
+}
+
 template <typename Primitive>
 void StaticTessellation<Primitive>::create_uv_0_attribute()
 {
     m_uv_0_cid =
         m_vertex_attributes.create_channel(
             "uv_0",
-            foundation::NumericType::id<GVector2::ValueType>(),
+            m_compressed_vertex_attributes
+                ? foundation::NumericTypeUInt16
+                : foundation::NumericType::id<GVector2::ValueType>(),
             2);
 }
 
 template <typename Primitive>
 void StaticTessellation<Primitive>::create_tangents_attribute()
 {
+    // Compressed tangents are stored as two 16-bit octahedral coordinates.
     m_tangents_cid =
-        m_vertex_attributes.create_channel(
-            "tangents",
-            foundation::NumericType::id<GVector3::ValueType>(),
-            3);
+        m_compressed_vertex_attributes
+            ? m_vertex_attributes.create_channel("tangents", foundation::NumericTypeInt16, 2)
+            : m_vertex_attributes.create_channel(
+                  "tangents",
+                  foundation::NumericType::id<GVector3::ValueType>(),
+                  3);
 }
 
 }   // namespace renderer
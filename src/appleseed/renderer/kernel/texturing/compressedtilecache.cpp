@@ -0,0 +1,162 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "compressedtilecache.h"
+
+// appleseed.foundation headers.
+#include "foundation/memory/memory.h"
+
+// LZ4 headers.
+#include <lz4.h>
+
+// Standard headers.
+#include <cassert>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// CompressedTile class implementation.
+//
+
+namespace
+{
+    // Gather the i-th byte of every value in the i-th plane of the destination.
+    void shuffle_bytes(
+        const std::uint8_t*     src,
+        std::uint8_t*           dest,
+        const size_t            size,
+        const size_t            value_size)
+    {
+        const size_t value_count = size / value_size;
+
+        for (size_t b = 0; b < value_size; ++b)
+        {
+            for (size_t i = 0; i < value_count; ++i)
+                dest[b * value_count + i] = src[i * value_size + b];
+        }
+    }
+
+    // Inverse of shuffle_bytes().
+    void unshuffle_bytes(
+        const std::uint8_t*     src,
+        std::uint8_t*           dest,
+        const size_t            size,
+        const size_t            value_size)
+    {
+        const size_t value_count = size / value_size;
+
+        for (size_t b = 0; b < value_size; ++b)
+        {
+            for (size_t i = 0; i < value_count; ++i)
+                dest[i * value_size + b] = src[b * value_count + i];
+        }
+    }
+}
+
+bool CompressedTile::compress(
+    const Tile&                 tile,
+    std::vector<std::uint8_t>&  scratch)
+{
+    const size_t size = tile.get_size();
+    const size_t value_size = Pixel::size(tile.get_pixel_format());
+
+    // The scratch buffer holds the shuffled pixels followed by the compressed data.
+    const size_t max_compressed_size =
+        static_cast<size_t>(LZ4_compressBound(static_cast<int>(size)));
+    ensure_minimum_size(scratch, size + max_compressed_size);
+
+    const std::uint8_t* src = tile.get_storage();
+
+    if (value_size > 1)
+    {
+        shuffle_bytes(src, &scratch[0], size, value_size);
+        src = &scratch[0];
+    }
+
+    const int compressed_size =
+        LZ4_compress_default(
+            reinterpret_cast<const char*>(src),
+            reinterpret_cast<char*>(&scratch[size]),
+            static_cast<int>(size),
+            static_cast<int>(max_compressed_size));
+
+    // Keep the tile uncompressed if compression does not save anything.
+    if (compressed_size <= 0 || static_cast<size_t>(compressed_size) >= size)
+        return false;
+
+    m_width = tile.get_width();
+    m_height = tile.get_height();
+    m_channel_count = tile.get_channel_count();
+    m_pixel_format = tile.get_pixel_format();
+    m_uncompressed_memory_size = tile.get_memory_size();
+    m_data.assign(&scratch[size], &scratch[size] + compressed_size);
+
+    return true;
+}
+
+Tile* CompressedTile::decompress(std::vector<std::uint8_t>& scratch) const
+{
+    Tile* tile =
+        new Tile(
+            m_width,
+            m_height,
+            m_channel_count,
+            m_pixel_format);
+
+    const size_t size = tile->get_size();
+    const size_t value_size = Pixel::size(m_pixel_format);
+
+    std::uint8_t* dest = tile->get_storage();
+
+    if (value_size > 1)
+    {
+        ensure_minimum_size(scratch, size);
+        dest = &scratch[0];
+    }
+
+#ifndef NDEBUG
+    const int decompressed_size =
+#endif
+        LZ4_decompress_safe(
+            reinterpret_cast<const char*>(&m_data[0]),
+            reinterpret_cast<char*>(dest),
+            static_cast<int>(m_data.size()),
+            static_cast<int>(size));
+    assert(decompressed_size == static_cast<int>(size));
+
+    if (value_size > 1)
+        unshuffle_bytes(dest, tile->get_storage(), size, value_size);
+
+    return tile;
+}
+
+}   // namespace renderer
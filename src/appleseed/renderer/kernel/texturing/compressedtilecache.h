@@ -0,0 +1,302 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+
+// Boost headers.
+#include "boost/unordered_map.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <utility>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// An LZ4-compressed copy of a texture tile.
+//
+// Channel values are byte-shuffled before compression (all first bytes, then all second
+// bytes, and so on) so that the slowly varying high-order bytes of half and float pixels
+// end up next to each other, which LZ4 compresses much better.
+//
+
+class CompressedTile
+{
+  public:
+    // Compress a tile. `scratch` is temporary storage reused across calls.
+    // Return false if the tile does not compress, in which case this object is unchanged.
+    bool compress(
+        const foundation::Tile&     tile,
+        std::vector<std::uint8_t>&  scratch);
+
+    // Return a new, decompressed copy of the tile. `scratch` is temporary storage reused across calls.
+    foundation::Tile* decompress(std::vector<std::uint8_t>& scratch) const;
+
+    // Return the size in bytes of the compressed data.
+    size_t get_memory_size() const;
+
+    // Return the size in bytes of the tile once decompressed.
+    size_t get_uncompressed_memory_size() const;
+
+  private:
+    size_t                      m_width;
+    size_t                      m_height;
+    size_t                      m_channel_count;
+    foundation::PixelFormat     m_pixel_format;
+    size_t                      m_uncompressed_memory_size;
+    std::vector<std::uint8_t>   m_data;
+};
+
+
+//
+// A cache of compressed texture tiles, used as a second tier behind a cache of decompressed tiles.
+//
+// Tiles evicted from the first tier are inserted here, and are moved back (decompressed) to the
+// first tier when accessed again, which is much cheaper than loading them again from disk.
+// When the memory limit is reached, the tiles that were inserted the longest time ago are
+// discarded. Not thread-safe.
+//
+// The KeyHasher class must conform to the prototype documented in foundation/utility/cache.h.
+//
+
+template <typename Key, typename KeyHasher>
+class CompressedTileCache
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    CompressedTileCache(
+        KeyHasher&                  key_hasher,
+        const size_t                memory_limit);              // in bytes
+
+    // Compress and insert a tile. The tile is left untouched.
+    void insert(const Key& key, const foundation::Tile& tile);
+
+    // Remove a tile from the cache and return it decompressed, or return nullptr if the
+    // cache does not contain this tile. The caller takes ownership of the returned tile.
+    foundation::Tile* extract(const Key& key);
+
+    // Return the number of tiles in the cache.
+    size_t get_tile_count() const;
+
+    // Return the size in bytes of the compressed tiles.
+    size_t get_memory_size() const;
+
+    // Return the peak size in bytes of the compressed tiles.
+    size_t get_peak_memory_size() const;
+
+    // Return the size in bytes the tiles of the cache would take if they were not compressed.
+    size_t get_uncompressed_memory_size() const;
+
+    // Return the number of lookups that found, or did not find, a tile.
+    std::uint64_t get_hit_count() const;
+    std::uint64_t get_miss_count() const;
+
+    // Return the number of tiles that were not inserted because they did not compress.
+    std::uint64_t get_rejected_count() const;
+
+  private:
+    // Queue: stores tiles ordered from most to least recently inserted.
+    struct Line
+    {
+        Key                 m_key;
+        CompressedTile      m_tile;
+    };
+
+    typedef std::list<Line> Queue;
+    typedef typename Queue::iterator QueueIterator;
+
+    // Index: given a key, find the tile in the queue.
+    typedef boost::unordered_map<Key, QueueIterator, KeyHasher, std::equal_to<Key>> Index;
+
+    const size_t                m_memory_limit;
+    Index                       m_index;
+    Queue                       m_queue;
+    size_t                      m_memory_size;
+    size_t                      m_peak_memory_size;
+    size_t                      m_uncompressed_memory_size;
+    std::uint64_t               m_hit_count;
+    std::uint64_t               m_miss_count;
+    std::uint64_t               m_rejected_count;
+    std::vector<std::uint8_t>   m_scratch;
+
+    void erase(const QueueIterator& it);
+};
+
+
+//
+// CompressedTile class implementation.
+//
+
+inline size_t CompressedTile::get_memory_size() const
+{
+    return m_data.size();
+}
+
+inline size_t CompressedTile::get_uncompressed_memory_size() const
+{
+    return m_uncompressed_memory_size;
+}
+
+
+//
+// CompressedTileCache class implementation.
+//
+
+template <typename Key, typename KeyHasher>
+CompressedTileCache<Key, KeyHasher>::CompressedTileCache(
+    KeyHasher&                      key_hasher,
+    const size_t                    memory_limit)
+  : m_memory_limit(memory_limit)
+  , m_index(4, key_hasher)
+  , m_memory_size(0)
+  , m_peak_memory_size(0)
+  , m_uncompressed_memory_size(0)
+  , m_hit_count(0)
+  , m_miss_count(0)
+  , m_rejected_count(0)
+{
+}
+
+template <typename Key, typename KeyHasher>
+void CompressedTileCache<Key, KeyHasher>::insert(const Key& key, const foundation::Tile& tile)
+{
+    // Replace any stale copy of this tile.
+    const typename Index::iterator index_it = m_index.find(key);
+    if (index_it != m_index.end())
+        erase(index_it->second);
+
+    Line line;
+    line.m_key = key;
+
+    if (!line.m_tile.compress(tile, m_scratch) ||
+        line.m_tile.get_memory_size() > m_memory_limit)
+    {
+        ++m_rejected_count;
+        return;
+    }
+
+    // Make room for the new tile.
+    while (m_memory_size + line.m_tile.get_memory_size() > m_memory_limit)
+        erase(std::prev(m_queue.end()));
+
+    m_memory_size += line.m_tile.get_memory_size();
+    m_peak_memory_size = std::max(m_peak_memory_size, m_memory_size);
+    m_uncompressed_memory_size += line.m_tile.get_uncompressed_memory_size();
+
+    m_queue.push_front(std::move(line));
+    m_index[key] = m_queue.begin();
+}
+
+template <typename Key, typename KeyHasher>
+foundation::Tile* CompressedTileCache<Key, KeyHasher>::extract(const Key& key)
+{
+    const typename Index::iterator index_it = m_index.find(key);
+
+    if (index_it == m_index.end())
+    {
+        ++m_miss_count;
+        return nullptr;
+    }
+
+    ++m_hit_count;
+
+    const QueueIterator queue_it = index_it->second;
+    foundation::Tile* tile = queue_it->m_tile.decompress(m_scratch);
+    erase(queue_it);
+
+    return tile;
+}
+
+template <typename Key, typename KeyHasher>
+inline size_t CompressedTileCache<Key, KeyHasher>::get_tile_count() const
+{
+    return m_index.size();
+}
+
+template <typename Key, typename KeyHasher>
+inline size_t CompressedTileCache<Key, KeyHasher>::get_memory_size() const
+{
+    return m_memory_size;
+}
+
+template <typename Key, typename KeyHasher>
+inline size_t CompressedTileCache<Key, KeyHasher>::get_peak_memory_size() const
+{
+    return m_peak_memory_size;
+}
+
+template <typename Key, typename KeyHasher>
+inline size_t CompressedTileCache<Key, KeyHasher>::get_uncompressed_memory_size() const
+{
+    return m_uncompressed_memory_size;
+}
+
+template <typename Key, typename KeyHasher>
+inline std::uint64_t CompressedTileCache<Key, KeyHasher>::get_hit_count() const
+{
+    return m_hit_count;
+}
+
+template <typename Key, typename KeyHasher>
+inline std::uint64_t CompressedTileCache<Key, KeyHasher>::get_miss_count() const
+{
+    return m_miss_count;
+}
+
+template <typename Key, typename KeyHasher>
+inline std::uint64_t CompressedTileCache<Key, KeyHasher>::get_rejected_count() const
+{
+    return m_rejected_count;
+}
+
+template <typename Key, typename KeyHasher>
+void CompressedTileCache<Key, KeyHasher>::erase(const QueueIterator& it)
+{
+    assert(m_memory_size >= it->m_tile.get_memory_size());
+    m_memory_size -= it->m_tile.get_memory_size();
+    m_uncompressed_memory_size -= it->m_tile.get_uncompressed_memory_size();
+
+    m_index.erase(it->m_key);
+    m_queue.erase(it);
+}
+
+}   // namespace renderer
@@ -59,8 +59,19 @@ class TextureCache
     // Constructor.
     explicit TextureCache(TextureStore& store);
 
-    // Get a tile from the cache.
+    // Get a tile of a given MIP level from the cache.
     foundation::Tile& get(
+        const foundation::UniqueID  assembly_uid,
+        const foundation::UniqueID  texture_uid,
+        const size_t                tile_x,
+        const size_t                tile_y,
+        const size_t                level = 0);
+
+    // Return true if tiles can be prefetched in the background.
+    bool is_prefetching_enabled() const;
+
+    // Hint that a tile is likely to be accessed soon.
+    void prefetch(
         const foundation::UniqueID  assembly_uid,
         const foundation::UniqueID  texture_uid,
         const size_t                tile_x,
@@ -103,9 +114,14 @@ class TextureCache
         4                   // number of ways
     > TileCache;
 
+    // Number of recent prefetch hints remembered to avoid forwarding duplicates to the store.
+    static const size_t RecentPrefetchCount = 64;
+
+    TextureStore&           m_store;
     TileKeyHasher           m_tile_key_hasher;
     TileRecordSwapper       m_tile_record_swapper;
     TileCache               m_tile_cache;
+    TileKey                 m_recent_prefetches[RecentPrefetchCount];
 };
 
 
@@ -114,19 +130,45 @@ class TextureCache
 //
 
 inline TextureCache::TextureCache(TextureStore& store)
-  : m_tile_record_swapper(store)
+  : m_store(store)
+  , m_tile_record_swapper(store)
   , m_tile_cache(m_tile_key_hasher, m_tile_record_swapper, TileKey::invalid())
 {
+    for (size_t i = 0; i < RecentPrefetchCount; ++i)
+        m_recent_prefetches[i] = TileKey::invalid();
 }
 
 inline foundation::Tile& TextureCache::get(
+    const foundation::UniqueID      assembly_uid,
+    const foundation::UniqueID      texture_uid,
+    const size_t                    tile_x,
+    const size_t                    tile_y,
+    const size_t                    level)
+{
+    const TileKey key(assembly_uid, texture_uid, tile_x, tile_y, level);
+    return *m_tile_cache.get(key)->m_tile_ptr.get_tile();
+}
+
+inline bool TextureCache::is_prefetching_enabled() const
+{
+    return m_store.is_prefetching_enabled();
+}
+
+inline void TextureCache::prefetch(
     const foundation::UniqueID      assembly_uid,
     const foundation::UniqueID      texture_uid,
     const size_t                    tile_x,
     const size_t                    tile_y)
 {
     const TileKey key(assembly_uid, texture_uid, tile_x, tile_y);
-    return *m_tile_cache.get(key)->m_tile_ptr.get_tile();
+
+    TileKey& recent_key = m_recent_prefetches[m_tile_key_hasher(key) % RecentPrefetchCount];
+
+    if (recent_key != key)
+    {
+        recent_key = key;
+        m_store.prefetch(key);
+    }
 }
 
 inline foundation::StatisticsVector TextureCache::get_statistics() const
@@ -32,6 +32,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
+#include "renderer/kernel/texturing/oiiotexturesystem.h"
 #include "renderer/modeling/scene/assembly.h"
 #include "renderer/modeling/scene/scene.h"
 #include "renderer/modeling/texture/texture.h"
@@ -46,6 +47,8 @@
 #include "foundation/platform/types.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/api/apistring.h"
+#include "foundation/utility/eventtracer.h"
+#include "foundation/utility/job.h"
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
@@ -72,6 +75,30 @@ Dictionary TextureStore::get_params_metadata()
             .insert("label", "Texture Cache Size")
             .insert("help", "Texture cache size in bytes"));
 
+    metadata.dictionaries().insert(
+        "compressed_size",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "0")
+            .insert("label", "Compressed Texture Cache Size")
+            .insert("help", "Size in bytes of the cache keeping evicted texture tiles compressed in memory, 0 to disable it"));
+
+    metadata.dictionaries().insert(
+        "prefetch_thread_count",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "0")
+            .insert("label", "Texture Prefetch Threads")
+            .insert("help", "Number of threads loading texture tiles in the background, 0 to disable prefetching"));
+
+    metadata.dictionaries().insert(
+        "use_oiio_image_cache",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Unified Texture Cache")
+            .insert("help", "Load texture tiles through OpenImageIO's image cache, sharing files and memory budget with OSL textures"));
+
     return metadata;
 }
 
@@ -80,22 +107,255 @@ size_t TextureStore::get_default_size()
     return 1024 * 1024 * 1024;
 }
 
+namespace
+{
+    // Fraction of the budget kept by the store when tiles are loaded through OIIO's image cache.
+    // The store then only holds the working set of converted tiles.
+    const size_t StoreBudgetDivisor = 4;
+
+    bool is_image_cache_enabled(const ParamArray& params)
+    {
+        return params.get_optional<bool>("use_oiio_image_cache", false);
+    }
+
+    size_t get_max_size(const ParamArray& params)
+    {
+        return params.get_optional<size_t>("max_size", TextureStore::get_default_size());
+    }
+
+    size_t get_store_size(const ParamArray& params)
+    {
+        const size_t max_size = get_max_size(params);
+        return is_image_cache_enabled(params) ? max_size / StoreBudgetDivisor : max_size;
+    }
+}
+
+size_t TextureStore::get_image_cache_size(const ParamArray& params)
+{
+    const size_t max_size = get_max_size(params);
+    return is_image_cache_enabled(params) ? max_size - get_store_size(params) : max_size;
+}
+
+namespace
+{
+    // Maximum number of tiles waiting to be prefetched; further hints are dropped.
+    const size_t MaxPendingPrefetchCount = 256;
+}
+
+class TextureStore::TilePrefetchJob
+  : public IJob
+{
+  public:
+    TilePrefetchJob(
+        TextureStore&       store,
+        const TileKey&      key)
+      : m_store(store)
+      , m_key(key)
+    {
+    }
+
+    void execute(const size_t thread_index) override
+    {
+        // Bring the tile into the store without keeping it.
+        m_store.release(m_store.acquire(m_key));
+        m_store.complete_prefetch(m_key);
+    }
+
+  private:
+    TextureStore&   m_store;
+    const TileKey   m_key;
+};
+
 TextureStore::TextureStore(
     const Scene&        scene,
     const ParamArray&   params)
-  : m_tile_swapper(scene, params)
-  , m_tile_cache(m_tile_key_hasher, m_tile_swapper)
+  : m_texture_system(nullptr)
+  , m_prefetch_count(0)
+  , m_dropped_prefetch_count(0)
+  , m_prefetch_job_queue(JobQueue::CentralizedScheduling)
 {
+    const size_t shard_count = std::max<size_t>(params.get_optional<size_t>("shard_count", 16), 1);
+    const size_t prefetch_thread_count = params.get_optional<size_t>("prefetch_thread_count", 0);
+
+    m_shards.reserve(shard_count);
+
+    for (size_t i = 0; i < shard_count; ++i)
+        m_shards.emplace_back(new Shard(scene, params, shard_count, m_tile_key_hasher));
+
+    m_shards[0]->m_tile_swapper.print_settings(shard_count, prefetch_thread_count);
+
+    if (prefetch_thread_count > 0)
+    {
+        m_prefetch_job_manager.reset(
+            new JobManager(
+                global_logger(),
+                m_prefetch_job_queue,
+                prefetch_thread_count,
+                JobManager::KeepRunningOnEmptyQueue));
+        m_prefetch_job_manager->start();
+    }
+}
+
+TextureStore::~TextureStore()
+{
+    // Stop loader threads before the store goes away.
+    if (m_prefetch_job_manager)
+    {
+        m_prefetch_job_manager->stop();
+        m_prefetch_job_manager.reset();
+    }
+
+    m_prefetch_job_queue.clear_scheduled_jobs();
+}
+
+void TextureStore::set_texture_system(OIIOTextureSystem* texture_system)
+{
+    m_texture_system = texture_system;
+
+    for (const std::unique_ptr<Shard>& shard : m_shards)
+    {
+        boost::mutex::scoped_lock lock(shard->m_mutex);
+        shard->m_tile_swapper.set_texture_system(texture_system);
+    }
+}
+
+void TextureStore::prefetch(const TileKey& key)
+{
+    if (!is_prefetching_enabled())
+        return;
+
+    {
+        boost::mutex::scoped_lock lock(m_prefetch_mutex);
+
+        if (m_pending_prefetches.size() >= MaxPendingPrefetchCount)
+        {
+            ++m_dropped_prefetch_count;
+            return;
+        }
+
+        // This tile is already being prefetched.
+        if (!m_pending_prefetches.insert(key).second)
+            return;
+    }
+
+    m_prefetch_job_queue.schedule(new TilePrefetchJob(*this, key));
+}
+
+void TextureStore::complete_prefetch(const TileKey& key)
+{
+    boost::mutex::scoped_lock lock(m_prefetch_mutex);
+
+    m_pending_prefetches.erase(key);
+    ++m_prefetch_count;
 }
 
 StatisticsVector TextureStore::get_statistics() const
 {
-    Statistics stats = make_single_stage_cache_stats(m_tile_cache);
-    stats.insert_size("peak size", m_tile_swapper.get_peak_memory_size());
+    std::uint64_t hit_count = 0;
+    std::uint64_t miss_count = 0;
+    std::uint64_t contention_count = 0;
+    size_t peak_memory_size = 0;
+    std::uint64_t compressed_hit_count = 0;
+    std::uint64_t compressed_miss_count = 0;
+    std::uint64_t rejected_count = 0;
+    size_t compressed_memory_size = 0;
+    size_t compressed_peak_memory_size = 0;
+    size_t uncompressed_memory_size = 0;
+
+    for (const std::unique_ptr<Shard>& shard : m_shards)
+    {
+        hit_count += shard->m_tile_cache.get_hit_count();
+        miss_count += shard->m_tile_cache.get_miss_count();
+        contention_count += shard->m_contention_count;
+        peak_memory_size += shard->m_tile_swapper.get_peak_memory_size();
+
+        if (const CompressedTileTier* compressed_tiles = shard->m_tile_swapper.get_compressed_tiles())
+        {
+            compressed_hit_count += compressed_tiles->get_hit_count();
+            compressed_miss_count += compressed_tiles->get_miss_count();
+            rejected_count += compressed_tiles->get_rejected_count();
+            compressed_memory_size += compressed_tiles->get_memory_size();
+            compressed_peak_memory_size += compressed_tiles->get_peak_memory_size();
+            uncompressed_memory_size += compressed_tiles->get_uncompressed_memory_size();
+        }
+    }
+
+    Statistics stats;
+    stats.insert(
+        std::unique_ptr<cache_impl::CacheStatisticsEntry>(
+            new cache_impl::CacheStatisticsEntry(
+                "performance",
+                hit_count,
+                miss_count)));
+    stats.insert("shards", m_shards.size());
+    stats.insert_percent("contention", contention_count, hit_count + miss_count);
+    stats.insert_size("peak size", peak_memory_size);
+
+    if (m_shards[0]->m_tile_swapper.get_compressed_tiles())
+    {
+        stats.insert(
+            std::unique_ptr<cache_impl::CacheStatisticsEntry>(
+                new cache_impl::CacheStatisticsEntry(
+                    "compressed tier",
+                    compressed_hit_count,
+                    compressed_miss_count)));
+        stats.insert_size("compressed peak size", compressed_peak_memory_size);
+        stats.insert(
+            "compression ratio",
+            compressed_memory_size > 0
+                ? static_cast<double>(uncompressed_memory_size) / compressed_memory_size
+                : 0.0);
+        stats.insert("incompressible tiles", rejected_count);
+    }
+
+    if (is_prefetching_enabled())
+    {
+        stats.insert("prefetched tiles", m_prefetch_count);
+        stats.insert("dropped prefetches", m_dropped_prefetch_count);
+    }
+
+    if (m_shards[0]->m_tile_swapper.uses_image_cache())
+    {
+        const OIIO::ImageCache* image_cache = m_texture_system->imagecache();
+
+        long long image_cache_memory_size = 0;
+        long long image_cache_bytes_read = 0;
+        int image_cache_file_count = 0;
+        image_cache->getattribute("stat:cache_memory_used", OIIO::TypeDesc::INT64, &image_cache_memory_size);
+        image_cache->getattribute("stat:bytes_read", OIIO::TypeDesc::INT64, &image_cache_bytes_read);
+        image_cache->getattribute("stat:unique_files", image_cache_file_count);
+
+        stats.insert_size("image cache size", static_cast<std::uint64_t>(image_cache_memory_size));
+        stats.insert_size("image cache bytes read", static_cast<std::uint64_t>(image_cache_bytes_read));
+        stats.insert("image cache files", static_cast<std::uint64_t>(image_cache_file_count));
+    }
+
     return StatisticsVector::make("texture store statistics", stats);
 }
 
 
+//
+// TextureStore::Shard class implementation.
+//
+
+TextureStore::Shard::Shard(
+    const Scene&        scene,
+    const ParamArray&   params,
+    const size_t        shard_count,
+    TileKeyHasher&      tile_key_hasher)
+  : m_tile_swapper(scene, params, shard_count, tile_key_hasher)
+  , m_tile_cache(tile_key_hasher, m_tile_swapper)
+  , m_contention_count(0)
+{
+}
+
+TextureStore::Shard::~Shard()
+{
+    // Don't compress the tiles that the tile cache unloads when it is destroyed.
+    m_tile_swapper.release_compressed_tiles();
+}
+
+
 //
 // TextureStore::TileSwapper class implementation.
 //
@@ -163,25 +423,47 @@ namespace
 
 TextureStore::TileSwapper::TileSwapper(
     const Scene&        scene,
-    const ParamArray&   params)
+    const ParamArray&   params,
+    const size_t        shard_count,
+    TileKeyHasher&      tile_key_hasher)
   : m_scene(scene)
-  , m_params(params)
+  , m_params(params, shard_count)
   , m_memory_size(0)
   , m_peak_memory_size(0)
+  , m_tracked_memory("textures")
+  , m_tracked_compressed_memory("compressed textures")
+  , m_texture_system(nullptr)
 {
     gather_assemblies(scene.assemblies());
-    print_settings();
+
+    if (m_params.m_compressed_memory_limit > 0)
+    {
+        m_compressed_tiles.reset(
+            new CompressedTileTier(
+                tile_key_hasher,
+                m_params.m_compressed_memory_limit));
+    }
 }
 
-void TextureStore::TileSwapper::print_settings() const
+void TextureStore::TileSwapper::print_settings(
+    const size_t        shard_count,
+    const size_t        prefetch_thread_count) const
 {
     RENDERER_LOG_INFO(
         "texture store settings:\n"
         "  max store size                %s\n"
+        "  compressed tier size          %s\n"
+        "  shards                        %s\n"
+        "  prefetch threads              %s\n"
+        "  use oiio image cache          %s\n"
         "  track store size              %s\n"
         "  track tile loading            %s\n"
         "  track tile unloading          %s",
-        pretty_size(m_params.m_memory_limit).c_str(),
+        pretty_size(m_params.m_memory_limit * shard_count).c_str(),
+        m_compressed_tiles ? pretty_size(m_params.m_compressed_memory_limit * shard_count).c_str() : "off",
+        pretty_uint(shard_count).c_str(),
+        pretty_uint(prefetch_thread_count).c_str(),
+        m_params.m_use_image_cache ? "on" : "off",
         m_params.m_track_store_size ? "on" : "off",
         m_params.m_track_tile_loading ? "on" : "off",
         m_params.m_track_tile_unloading ? "on" : "off");
@@ -189,50 +471,25 @@ void TextureStore::TileSwapper::print_settings() const
 
 void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
 {
-    // Fetch the texture container.
-    const TextureContainer& textures =
-        key.m_assembly_uid == ~UniqueID(0)
-            ? m_scene.textures()
-            : m_assemblies[key.m_assembly_uid]->textures();
+    APPLESEED_TRACE_SCOPE("texturing", "load texture tile");
 
-    // Fetch the texture.
-    Texture* texture = textures.get_by_uid(key.m_texture_uid);
-    assert(texture != nullptr);
-
-    if (m_params.m_track_tile_loading)
+    // Decompress the tile if it was recently evicted, otherwise load it from its texture.
+    Tile* tile = m_compressed_tiles ? m_compressed_tiles->extract(key) : nullptr;
+    if (tile != nullptr)
     {
-        RENDERER_LOG_DEBUG(
-            "loading tile (" FMT_SIZE_T ", " FMT_SIZE_T ") "
-            "from texture \"%s\"...",
-            key.get_tile_x(),
-            key.get_tile_y(),
-            texture->get_path().c_str());
+        record.m_tile_ptr = TilePtr::make_owning(tile);
+        record.m_owners = 0;
+        m_tracked_compressed_memory.set_size(m_compressed_tiles->get_memory_size());
     }
-
-    // Load the tile.
-    record.m_tile_ptr = texture->load_tile(key.get_tile_x(), key.get_tile_y());
-    record.m_owners = 0;
-
-    // Convert the tile to the linear RGB color space.
-    switch (texture->get_color_space())
+    else
     {
-      case ColorSpaceLinearRGB:
-        break;
-
-      case ColorSpaceSRGB:
-        convert_tile_srgb_to_linear_rgb(*record.m_tile_ptr.get_tile());
-        break;
-
-      case ColorSpaceCIEXYZ:
-        convert_tile_ciexyz_to_linear_rgb(*record.m_tile_ptr.get_tile());
-        break;
-
-      assert_otherwise;
+        load_from_texture(key, record);
     }
 
     // Track the amount of memory used by the tile cache.
     m_memory_size += record.m_tile_ptr.get_tile()->get_memory_size();
     m_peak_memory_size = std::max(m_peak_memory_size, m_memory_size);
+    m_tracked_memory.set_size(m_memory_size);
 
     if (m_params.m_track_store_size)
     {
@@ -265,6 +522,7 @@ bool TextureStore::TileSwapper::unload(const TileKey& key, TileRecord& record)
     const size_t tile_memory_size = record.m_tile_ptr.get_tile()->get_memory_size();
     assert(m_memory_size >= tile_memory_size);
     m_memory_size -= tile_memory_size;
+    m_tracked_memory.set_size(m_memory_size);
 
     if (m_params.m_track_tile_unloading)
     {
@@ -296,14 +554,34 @@ bool TextureStore::TileSwapper::unload(const TileKey& key, TileRecord& record)
         }
     }
 
-    // Unload the tile.
+    // Unload the tile, keeping a compressed copy of it. Tiles not owned by the store
+    // live in their texture anyway.
     if (record.m_tile_ptr.has_ownership())
+    {
+        if (m_compressed_tiles)
+        {
+            m_compressed_tiles->insert(key, *record.m_tile_ptr.get_tile());
+            m_tracked_compressed_memory.set_size(m_compressed_tiles->get_memory_size());
+        }
+
         delete record.m_tile_ptr.get_tile();
+    }
 
     // Successfully unloaded the tile.
     return true;
 }
 
+void TextureStore::TileSwapper::set_texture_system(OIIOTextureSystem* texture_system)
+{
+    m_texture_system = texture_system;
+}
+
+void TextureStore::TileSwapper::release_compressed_tiles()
+{
+    m_compressed_tiles.reset();
+    m_tracked_compressed_memory.set_size(0);
+}
+
 void TextureStore::TileSwapper::gather_assemblies(const AssemblyContainer& assemblies)
 {
     for (const Assembly& assembly : assemblies)
@@ -313,13 +591,74 @@ void TextureStore::TileSwapper::gather_assemblies(const AssemblyContainer& assem
     }
 }
 
+void TextureStore::TileSwapper::load_from_texture(const TileKey& key, TileRecord& record)
+{
+    // Fetch the texture container.
+    const TextureContainer& textures =
+        key.m_assembly_uid == ~UniqueID(0)
+            ? m_scene.textures()
+            : m_assemblies[key.m_assembly_uid]->textures();
+
+    // Fetch the texture.
+    Texture* texture = textures.get_by_uid(key.m_texture_uid);
+    assert(texture != nullptr);
+
+    if (m_params.m_track_tile_loading)
+    {
+        RENDERER_LOG_DEBUG(
+            "loading tile (" FMT_SIZE_T ", " FMT_SIZE_T ") of mip level " FMT_SIZE_T " "
+            "from texture \"%s\"...",
+            key.get_tile_x(),
+            key.get_tile_y(),
+            key.get_level(),
+            texture->get_path().c_str());
+    }
+
+    // Load the tile.
+    record.m_tile_ptr =
+        key.get_level() > 0
+            ? texture->load_mip_level_tile(key.get_level(), key.get_tile_x(), key.get_tile_y())
+            : uses_image_cache()
+                ? texture->load_tile_from_image_cache(key.get_tile_x(), key.get_tile_y(), *m_texture_system)
+                : texture->load_tile(key.get_tile_x(), key.get_tile_y());
+    record.m_owners = 0;
+
+    // Convert the tile to the linear RGB color space, unless texels are converted when they are fetched.
+    Tile& tile = *record.m_tile_ptr.get_tile();
+    if (is_converted_on_fetch(texture->get_color_space(), tile.get_pixel_format()))
+        return;
+
+    switch (texture->get_color_space())
+    {
+      case ColorSpaceLinearRGB:
+        break;
+
+      case ColorSpaceSRGB:
+        convert_tile_srgb_to_linear_rgb(tile);
+        break;
+
+      case ColorSpaceCIEXYZ:
+        convert_tile_ciexyz_to_linear_rgb(tile);
+        break;
+
+      assert_otherwise;
+    }
+}
+
 
 //
 // TextureStore::TileSwapper::Parameters class implementation.
 //
 
-TextureStore::TileSwapper::Parameters::Parameters(const ParamArray& params)
-  : m_memory_limit(params.get_optional<size_t>("max_size", TextureStore::get_default_size()))
+TextureStore::TileSwapper::Parameters::Parameters(
+    const ParamArray&   params,
+    const size_t        shard_count)
+  : m_memory_limit(
+        std::max<size_t>(
+            get_store_size(params) / shard_count,
+            1))
+  , m_compressed_memory_limit(params.get_optional<size_t>("compressed_size", 0) / shard_count)
+  , m_use_image_cache(is_image_cache_enabled(params))
   , m_track_tile_loading(params.get_optional<bool>("track_tile_loading", false))
   , m_track_tile_unloading(params.get_optional<bool>("track_tile_unloading", false))
   , m_track_store_size(params.get_optional<bool>("track_store_size", false))
@@ -30,15 +30,20 @@
 #pragma once
 
 // appleseed.renderer headers.
+#include "renderer/kernel/texturing/compressedtilecache.h"
 #include "renderer/modeling/scene/containers.h"
 #include "renderer/modeling/texture/tileptr.h"
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/hash/hash.h"
+#include "foundation/image/colorspace.h"
+#include "foundation/image/pixel.h"
+#include "foundation/memory/memorytracker.h"
 #include "foundation/platform/atomic.h"
 #include "foundation/platform/thread.h"
 #include "foundation/utility/cache.h"
+#include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/uid.h"
 
 // Standard headers.
@@ -46,10 +51,15 @@
 #include <cstddef>
 #include <cstdint>
 #include <map>
+#include <memory>
+#include <set>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class Dictionary; }
+namespace foundation    { class JobManager; }
 namespace foundation    { class StatisticsVector; }
+namespace renderer      { class OIIOTextureSystem; }
 namespace renderer      { class ParamArray; }
 namespace renderer      { class Scene; }
 
@@ -59,6 +69,23 @@ namespace renderer
 //
 // A shared store for texture tiles (the backend of the thread-local texture cache).
 //
+// Tiles are distributed over a number of shards according to the hash of their key.
+// Each shard is an independent LRU cache with its own lock and its own share of the
+// memory budget, so that threads accessing different shards never wait on each other,
+// and eviction is approximately LRU over the whole store.
+//
+// Optionally, a pool of loader threads loads tiles in the background ahead of
+// their first access, following hints given with prefetch().
+//
+// Optionally as well, tiles evicted from a shard are kept LZ4-compressed in a second
+// tier with its own memory budget, from which they are decompressed on their next
+// access instead of being loaded again from disk.
+//
+// Optionally too, tiles are read through the image cache of the OpenImageIO texture
+// system used by OSL shaders. Texture files are then read and cached once per process,
+// the memory budget is split between that image cache and the store (which still keeps
+// tiles converted to linear RGB), and statistics cover both.
+//
 
 class TextureStore
   : public foundation::NonCopyable
@@ -70,6 +97,7 @@ class TextureStore
         foundation::UniqueID    m_assembly_uid;
         foundation::UniqueID    m_texture_uid;
         std::uint32_t           m_tile_xy;
+        std::uint32_t           m_level;
 
         TileKey();
 
@@ -79,6 +107,13 @@ class TextureStore
             const size_t                tile_x,
             const size_t                tile_y);
 
+        TileKey(
+            const foundation::UniqueID  assembly_uid,
+            const foundation::UniqueID  texture_uid,
+            const size_t                tile_x,
+            const size_t                tile_y,
+            const size_t                level);
+
         TileKey(
             const foundation::UniqueID  assembly_uid,
             const foundation::UniqueID  texture_uid,
@@ -88,6 +123,7 @@ class TextureStore
 
         size_t get_tile_x() const;
         size_t get_tile_y() const;
+        size_t get_level() const;
 
         // Return an invalid key.
         static TileKey invalid();
@@ -115,21 +151,51 @@ class TextureStore
     // Return the default texture store size in bytes.
     static size_t get_default_size();
 
+    // Return true if tiles of a given pixel format from textures in a given color space are kept
+    // in that color space by the store, in which case texels are converted to linear RGB when
+    // they are fetched. This is the case of 8-bit sRGB tiles, which would lose much precision
+    // in dark tones if they were converted to linear RGB before being stored in 8 bits again.
+    static bool is_converted_on_fetch(
+        const foundation::ColorSpace    color_space,
+        const foundation::PixelFormat   pixel_format);
+
+    // Return the size in bytes of the OpenImageIO texture cache given texture store parameters.
+    // It is the whole budget unless tiles are loaded through that cache, in which case it
+    // is the part of the budget not used by the store itself.
+    static size_t get_image_cache_size(const ParamArray& params);
+
     // Constructor.
     TextureStore(
         const Scene&        scene,
         const ParamArray&   params = ParamArray());
 
+    // Destructor. Returns once tiles being prefetched are loaded.
+    ~TextureStore();
+
+    // Set the texture system through whose image cache tiles are loaded, if enabled
+    // by the use_oiio_image_cache parameter. Pass nullptr before the texture system
+    // is destroyed. Thread-safe.
+    void set_texture_system(OIIOTextureSystem* texture_system);
+
     // Acquire an element from the store. Thread-safe.
     TileRecord& acquire(const TileKey& key);
 
     // Release a previously-acquired element. Thread-safe.
     void release(TileRecord& record) const;
 
+    // Return true if tiles can be prefetched in the background.
+    bool is_prefetching_enabled() const;
+
+    // Hint that a tile is likely to be accessed soon. The tile is loaded by a loader
+    // thread if prefetching is enabled. Thread-safe, never waits for a tile load.
+    void prefetch(const TileKey& key);
+
     // Retrieve performance statistics.
     foundation::StatisticsVector get_statistics() const;
 
   private:
+    typedef CompressedTileCache<TileKey, TileKeyHasher> CompressedTileTier;
+
     class TileSwapper
       : public foundation::NonCopyable
     {
@@ -137,10 +203,14 @@ class TextureStore
         // Constructor.
         TileSwapper(
             const Scene&        scene,
-            const ParamArray&   params);
+            const ParamArray&   params,
+            const size_t        shard_count,
+            TileKeyHasher&      tile_key_hasher);
 
         // Print tile swapper's settings.
-        void print_settings() const;
+        void print_settings(
+            const size_t        shard_count,
+            const size_t        prefetch_thread_count) const;
 
         // Load a cache line.
         void load(const TileKey& key, TileRecord& record);
@@ -154,26 +224,48 @@ class TextureStore
         // Return the peak memory size in bytes of the tile cache.
         size_t get_peak_memory_size() const;
 
+        // Set the texture system through whose image cache tiles are loaded, or nullptr.
+        void set_texture_system(OIIOTextureSystem* texture_system);
+
+        // Return true if tiles are loaded through the image cache of the texture system.
+        bool uses_image_cache() const;
+
+        // Return the tier of compressed tiles, or nullptr if it is disabled.
+        const CompressedTileTier* get_compressed_tiles() const;
+
+        // Discard the tier of compressed tiles, so that tiles unloaded from now on are not compressed.
+        void release_compressed_tiles();
+
       private:
         struct Parameters
         {
             const size_t    m_memory_limit;
+            const size_t    m_compressed_memory_limit;
+            const bool      m_use_image_cache;
             const bool      m_track_tile_loading;
             const bool      m_track_tile_unloading;
             const bool      m_track_store_size;
 
-            explicit Parameters(const ParamArray& params);
+            Parameters(
+                const ParamArray&   params,
+                const size_t        shard_count);
         };
 
         typedef std::map<foundation::UniqueID, const Assembly*> AssemblyMap;
 
-        const Scene&        m_scene;
-        const Parameters    m_params;
-        size_t              m_memory_size;
-        size_t              m_peak_memory_size;
-        AssemblyMap         m_assemblies;
+        const Scene&                m_scene;
+        const Parameters            m_params;
+        size_t                      m_memory_size;
+        size_t                      m_peak_memory_size;
+        foundation::TrackedMemory   m_tracked_memory;
+        foundation::TrackedMemory   m_tracked_compressed_memory;
+        OIIOTextureSystem*          m_texture_system;
+        AssemblyMap                 m_assemblies;
+        std::unique_ptr<CompressedTileTier> m_compressed_tiles;
 
         void gather_assemblies(const AssemblyContainer& assemblies);
+
+        void load_from_texture(const TileKey& key, TileRecord& record);
     };
 
     typedef foundation::LRUCache<
@@ -183,10 +275,37 @@ class TextureStore
         TileSwapper
     > TileCache;
 
-    boost::mutex            m_mutex;
-    TileKeyHasher           m_tile_key_hasher;
-    TileSwapper             m_tile_swapper;
-    TileCache               m_tile_cache;
+    struct Shard
+      : public foundation::NonCopyable
+    {
+        boost::mutex        m_mutex;
+        TileSwapper         m_tile_swapper;
+        TileCache           m_tile_cache;
+        std::uint64_t       m_contention_count;
+
+        Shard(
+            const Scene&        scene,
+            const ParamArray&   params,
+            const size_t        shard_count,
+            TileKeyHasher&      tile_key_hasher);
+
+        ~Shard();
+    };
+
+    class TilePrefetchJob;
+
+    TileKeyHasher                       m_tile_key_hasher;
+    OIIOTextureSystem*                  m_texture_system;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+
+    boost::mutex                        m_prefetch_mutex;
+    std::set<TileKey>                   m_pending_prefetches;
+    std::uint64_t                       m_prefetch_count;
+    std::uint64_t                       m_dropped_prefetch_count;
+    foundation::JobQueue                m_prefetch_job_queue;
+    std::unique_ptr<foundation::JobManager> m_prefetch_job_manager;
+
+    void complete_prefetch(const TileKey& key);
 };
 
 
@@ -196,9 +315,17 @@ class TextureStore
 
 inline TextureStore::TileRecord& TextureStore::acquire(const TileKey& key)
 {
-    boost::mutex::scoped_lock lock(m_mutex);
+    Shard& shard = *m_shards[m_tile_key_hasher(key) % m_shards.size()];
+
+    boost::mutex::scoped_lock lock(shard.m_mutex, boost::try_to_lock);
 
-    TileRecord& record = m_tile_cache.get(key);
+    if (!lock.owns_lock())
+    {
+        lock.lock();
+        ++shard.m_contention_count;
+    }
+
+    TileRecord& record = shard.m_tile_cache.get(key);
     foundation::atomic_inc(&record.m_owners);
 
     return record;
@@ -210,6 +337,18 @@ inline void TextureStore::release(TileRecord& record) const
     foundation::atomic_dec(&record.m_owners);
 }
 
+inline bool TextureStore::is_converted_on_fetch(
+    const foundation::ColorSpace        color_space,
+    const foundation::PixelFormat       pixel_format)
+{
+    return color_space == foundation::ColorSpaceSRGB && pixel_format == foundation::PixelFormatUInt8;
+}
+
+inline bool TextureStore::is_prefetching_enabled() const
+{
+    return m_prefetch_job_manager != nullptr;
+}
+
 
 //
 // TextureStore::TileKey class implementation.
@@ -224,9 +363,20 @@ inline TextureStore::TileKey::TileKey(
     const foundation::UniqueID  texture_uid,
     const size_t                tile_x,
     const size_t                tile_y)
+  : TileKey(assembly_uid, texture_uid, tile_x, tile_y, 0)
+{
+}
+
+inline TextureStore::TileKey::TileKey(
+    const foundation::UniqueID  assembly_uid,
+    const foundation::UniqueID  texture_uid,
+    const size_t                tile_x,
+    const size_t                tile_y,
+    const size_t                level)
   : m_assembly_uid(assembly_uid)
   , m_texture_uid(texture_uid)
   , m_tile_xy(static_cast<std::uint32_t>((tile_y << 16) | tile_x))
+  , m_level(static_cast<std::uint32_t>(level))
 {
     assert(tile_x < (1UL << 16));
     assert(tile_y < (1UL << 16));
@@ -239,6 +389,7 @@ inline TextureStore::TileKey::TileKey(
   : m_assembly_uid(assembly_uid)
   , m_texture_uid(texture_uid)
   , m_tile_xy(tile_xy)
+  , m_level(0)
 {
 }
 
@@ -246,6 +397,7 @@ inline TextureStore::TileKey::TileKey(const TileKey& rhs)
   : m_assembly_uid(rhs.m_assembly_uid)
   , m_texture_uid(rhs.m_texture_uid)
   , m_tile_xy(rhs.m_tile_xy)
+  , m_level(rhs.m_level)
 {
 }
 
@@ -259,6 +411,11 @@ inline size_t TextureStore::TileKey::get_tile_y() const
     return static_cast<size_t>(m_tile_xy >> 16);
 }
 
+inline size_t TextureStore::TileKey::get_level() const
+{
+    return static_cast<size_t>(m_level);
+}
+
 inline TextureStore::TileKey TextureStore::TileKey::invalid()
 {
     return
@@ -272,6 +429,7 @@ inline bool TextureStore::TileKey::operator==(const TileKey& rhs) const
 {
     return
         m_tile_xy == rhs.m_tile_xy &&
+        m_level == rhs.m_level &&
         m_texture_uid == rhs.m_texture_uid &&
         m_assembly_uid == rhs.m_assembly_uid;
 }
@@ -286,7 +444,9 @@ inline bool TextureStore::TileKey::operator<(const TileKey& rhs) const
     return
         m_assembly_uid == rhs.m_assembly_uid ?
             m_texture_uid == rhs.m_texture_uid ?
-                m_tile_xy < rhs.m_tile_xy :
+                m_level == rhs.m_level ?
+                    m_tile_xy < rhs.m_tile_xy :
+                m_level < rhs.m_level :
             m_texture_uid < rhs.m_texture_uid :
         m_assembly_uid < rhs.m_assembly_uid;
 }
@@ -302,7 +462,8 @@ inline size_t TextureStore::TileKeyHasher::operator()(const TileKey& key) const
         foundation::mix_uint32(
             static_cast<std::uint32_t>(key.m_assembly_uid),
             static_cast<std::uint32_t>(key.m_texture_uid),
-            static_cast<std::uint32_t>(key.m_tile_xy));
+            static_cast<std::uint32_t>(key.m_tile_xy),
+            static_cast<std::uint32_t>(key.m_level));
 }
 
 
@@ -320,4 +481,14 @@ inline size_t TextureStore::TileSwapper::get_peak_memory_size() const
     return m_peak_memory_size;
 }
 
+inline bool TextureStore::TileSwapper::uses_image_cache() const
+{
+    return m_params.m_use_image_cache && m_texture_system != nullptr;
+}
+
+inline const TextureStore::CompressedTileTier* TextureStore::TileSwapper::get_compressed_tiles() const
+{
+    return m_compressed_tiles.get();
+}
+
 }   // namespace renderer
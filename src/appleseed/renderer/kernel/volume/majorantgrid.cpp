@@ -0,0 +1,263 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "majorantgrid.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/kernel/volume/sparsevoxelgrid.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/job.h"
+
+// Standard headers.
+#include <algorithm>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    size_t div_round_up(const size_t a, const size_t b)
+    {
+        return (a + b - 1) / b;
+    }
+
+    //
+    // Compute the majorants of a slab of cells of the finest level.
+    //
+
+    class BuildMajorantSlabJob
+      : public IJob
+    {
+      public:
+        BuildMajorantSlabJob(
+            const VoxelGrid&    voxel_grid,
+            const size_t        density_channel_index,
+            const size_t        block_size,
+            const size_t        xres,
+            const size_t        yres,
+            const size_t        z,
+            float*              majorants)
+          : m_voxel_grid(voxel_grid)
+          , m_density_channel_index(density_channel_index)
+          , m_block_size(block_size)
+          , m_xres(xres)
+          , m_yres(yres)
+          , m_z(z)
+          , m_majorants(majorants)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            for (size_t y = 0; y < m_yres; ++y)
+            {
+                for (size_t x = 0; x < m_xres; ++x)
+                    m_majorants[y * m_xres + x] = compute_block_majorant(x, y, m_z);
+            }
+        }
+
+      private:
+        const VoxelGrid&        m_voxel_grid;
+        const size_t            m_density_channel_index;
+        const size_t            m_block_size;
+        const size_t            m_xres;
+        const size_t            m_yres;
+        const size_t            m_z;
+        float*                  m_majorants;
+
+        float compute_block_majorant(const size_t bx, const size_t by, const size_t bz) const
+        {
+            // Pad the block by one voxel on every side since interpolated
+            // lookups inside the block may reach into neighboring voxels.
+            const size_t x0 = bx * m_block_size;
+            const size_t y0 = by * m_block_size;
+            const size_t z0 = bz * m_block_size;
+            const size_t x_begin = x0 > 0 ? x0 - 1 : 0;
+            const size_t y_begin = y0 > 0 ? y0 - 1 : 0;
+            const size_t z_begin = z0 > 0 ? z0 - 1 : 0;
+            const size_t x_end = std::min(x0 + m_block_size + 1, m_voxel_grid.get_xres());
+            const size_t y_end = std::min(y0 + m_block_size + 1, m_voxel_grid.get_yres());
+            const size_t z_end = std::min(z0 + m_block_size + 1, m_voxel_grid.get_zres());
+
+            float majorant = 0.0f;
+
+            for (size_t z = z_begin; z < z_end; ++z)
+            {
+                for (size_t y = y_begin; y < y_end; ++y)
+                {
+                    for (size_t x = x_begin; x < x_end; ++x)
+                    {
+                        const float* voxel = m_voxel_grid.voxel(x, y, z);
+                        assert(voxel[m_density_channel_index] >= 0.0f);
+
+                        majorant = std::max(majorant, voxel[m_density_channel_index]);
+                    }
+                }
+            }
+
+            return majorant;
+        }
+    };
+}
+
+
+//
+// MajorantGrid class implementation.
+//
+
+MajorantGrid::MajorantGrid(
+    const VoxelGrid&    voxel_grid,
+    const size_t        density_channel_index,
+    const size_t        block_size,
+    const size_t        thread_count)
+{
+    assert(block_size > 0);
+    assert(density_channel_index < voxel_grid.get_channel_count());
+
+    build_finest_level(voxel_grid, density_channel_index, block_size, thread_count);
+    build_coarser_levels();
+}
+
+MajorantGrid::MajorantGrid(const SparseVoxelGrid& sparse_grid)
+{
+    Level level;
+    level.m_xres = sparse_grid.get_brick_xres();
+    level.m_yres = sparse_grid.get_brick_yres();
+    level.m_zres = sparse_grid.get_brick_zres();
+    level.m_majorants.resize(level.m_xres * level.m_yres * level.m_zres);
+
+    for (size_t z = 0; z < level.m_zres; ++z)
+    {
+        for (size_t y = 0; y < level.m_yres; ++y)
+        {
+            for (size_t x = 0; x < level.m_xres; ++x)
+            {
+                level.m_majorants[(z * level.m_yres + y) * level.m_xres + x] =
+                    sparse_grid.get_brick_majorant(x, y, z);
+            }
+        }
+    }
+
+    m_levels.push_back(std::move(level));
+
+    build_coarser_levels();
+}
+
+void MajorantGrid::build_finest_level(
+    const VoxelGrid&    voxel_grid,
+    const size_t        density_channel_index,
+    const size_t        block_size,
+    const size_t        thread_count)
+{
+    Level level;
+    level.m_xres = div_round_up(voxel_grid.get_xres(), block_size);
+    level.m_yres = div_round_up(voxel_grid.get_yres(), block_size);
+    level.m_zres = div_round_up(voxel_grid.get_zres(), block_size);
+    level.m_majorants.resize(level.m_xres * level.m_yres * level.m_zres);
+
+    const size_t slab_size = level.m_xres * level.m_yres;
+    const size_t effective_thread_count = std::min(thread_count, level.m_zres);
+
+    if (effective_thread_count <= 1)
+    {
+        for (size_t z = 0; z < level.m_zres; ++z)
+        {
+            BuildMajorantSlabJob job(
+                voxel_grid,
+                density_channel_index,
+                block_size,
+                level.m_xres,
+                level.m_yres,
+                z,
+                &level.m_majorants[z * slab_size]);
+            job.execute(0);
+        }
+    }
+    else
+    {
+        JobQueue job_queue;
+        JobManager job_manager(global_logger(), job_queue, effective_thread_count);
+
+        for (size_t z = 0; z < level.m_zres; ++z)
+        {
+            job_queue.schedule(
+                new BuildMajorantSlabJob(
+                    voxel_grid,
+                    density_channel_index,
+                    block_size,
+                    level.m_xres,
+                    level.m_yres,
+                    z,
+                    &level.m_majorants[z * slab_size]));
+        }
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+    }
+
+    m_levels.push_back(std::move(level));
+}
+
+void MajorantGrid::build_coarser_levels()
+{
+    while (true)
+    {
+        const Level& fine = m_levels.back();
+
+        if (fine.m_xres == 1 && fine.m_yres == 1 && fine.m_zres == 1)
+            break;
+
+        Level coarse;
+        coarse.m_xres = div_round_up(fine.m_xres, 2);
+        coarse.m_yres = div_round_up(fine.m_yres, 2);
+        coarse.m_zres = div_round_up(fine.m_zres, 2);
+        coarse.m_majorants.assign(coarse.m_xres * coarse.m_yres * coarse.m_zres, 0.0f);
+
+        for (size_t z = 0; z < fine.m_zres; ++z)
+        {
+            for (size_t y = 0; y < fine.m_yres; ++y)
+            {
+                for (size_t x = 0; x < fine.m_xres; ++x)
+                {
+                    float& majorant =
+                        coarse.m_majorants[((z / 2) * coarse.m_yres + y / 2) * coarse.m_xres + x / 2];
+                    majorant = std::max(majorant, fine.get(x, y, z));
+                }
+            }
+        }
+
+        m_levels.push_back(std::move(coarse));
+    }
+}
+
+}   // namespace renderer
@@ -0,0 +1,421 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/volume/volume.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Forward declarations.
+namespace renderer  { class SparseVoxelGrid; }
+
+namespace renderer
+{
+
+//
+// A hierarchy of majorant grids built over the density channel of a voxel grid.
+//
+// Level 0 stores, for each block of block_size^3 voxels, an upper bound on the density
+// obtained by nearest or trilinear lookups anywhere inside the block (the block is
+// padded by one voxel to account for interpolation). Every coarser level stores the
+// maximum of 2x2x2 cells of the level below it; the last level is a single cell holding
+// the global majorant.
+//
+// Like VoxelGrid lookups, traversal works in the unit cube [0,1]^3.
+//
+
+class MajorantGrid
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. Level 0 is built using up to thread_count threads.
+    MajorantGrid(
+        const VoxelGrid&    voxel_grid,
+        const size_t        density_channel_index,
+        const size_t        block_size = 8,
+        const size_t        thread_count = 1);
+
+    // Constructor. Level 0 has one cell per brick of the sparse voxel grid,
+    // and is built from the brick majorants without loading any brick.
+    explicit MajorantGrid(const SparseVoxelGrid& sparse_grid);
+
+    size_t get_level_count() const;
+
+    size_t get_xres(const size_t level) const;
+    size_t get_yres(const size_t level) const;
+    size_t get_zres(const size_t level) const;
+
+    // Return the majorant of a given cell.
+    float get_majorant(
+        const size_t        level,
+        const size_t        x,
+        const size_t        y,
+        const size_t        z) const;
+
+    // Return the majorant of the entire voxel grid.
+    float get_global_majorant() const;
+
+    // Walk the cells of a given level pierced by the ray segment org + t * dir,
+    // t in [tmin, tmax), front to back (3D DDA). Cells with a zero majorant are skipped.
+    // For other cells, visitor(t0, t1, majorant) is called with the parametric extent
+    // of the ray inside the cell; the traversal stops as soon as the visitor returns false.
+    template <typename Visitor>
+    void traverse(
+        const foundation::Vector3d& org,
+        const foundation::Vector3d& dir,
+        const double                tmin,
+        const double                tmax,
+        Visitor&                    visitor,
+        const size_t                level = 0) const;
+
+    // Estimate the integral of density(t) over the ray segment org + t * dir, t in [tmin, tmax),
+    // by midpoint ray marching with steps no longer than max_step. Only cells with a non-zero
+    // majorant are marched; the rest of the segment is known to contribute nothing.
+    template <typename Density>
+    double integrate(
+        const foundation::Vector3d& org,
+        const foundation::Vector3d& dir,
+        const double                tmin,
+        const double                tmax,
+        Density&                    density,
+        const double                max_step,
+        const size_t                level = 0) const;
+
+    // Delta tracking along the ray segment org + t * dir, t in [tmin, tmax). Tentative
+    // collisions are sampled against the majorant of each cell times majorant_scale, and
+    // empty cells are skipped. For every tentative collision, collide(t, local_majorant) is
+    // called; tracking stops as soon as it returns true, in which case t is the distance of
+    // the collision and true is returned. rand() must return uniform numbers in [0,1).
+    template <typename Random, typename Collide>
+    bool track(
+        const foundation::Vector3d& org,
+        const foundation::Vector3d& dir,
+        const double                tmin,
+        const double                tmax,
+        const float                 majorant_scale,
+        Random&                     rand,
+        Collide&                    collide,
+        double&                     t,
+        const size_t                level = 0) const;
+
+  private:
+    struct Level
+    {
+        size_t              m_xres;
+        size_t              m_yres;
+        size_t              m_zres;
+        std::vector<float>  m_majorants;
+
+        float get(const size_t x, const size_t y, const size_t z) const;
+    };
+
+    std::vector<Level>      m_levels;
+
+    void build_finest_level(
+        const VoxelGrid&    voxel_grid,
+        const size_t        density_channel_index,
+        const size_t        block_size,
+        const size_t        thread_count);
+
+    void build_coarser_levels();
+};
+
+
+//
+// MajorantGrid class implementation.
+//
+
+inline size_t MajorantGrid::get_level_count() const
+{
+    return m_levels.size();
+}
+
+inline size_t MajorantGrid::get_xres(const size_t level) const
+{
+    assert(level < m_levels.size());
+    return m_levels[level].m_xres;
+}
+
+inline size_t MajorantGrid::get_yres(const size_t level) const
+{
+    assert(level < m_levels.size());
+    return m_levels[level].m_yres;
+}
+
+inline size_t MajorantGrid::get_zres(const size_t level) const
+{
+    assert(level < m_levels.size());
+    return m_levels[level].m_zres;
+}
+
+inline float MajorantGrid::get_majorant(
+    const size_t            level,
+    const size_t            x,
+    const size_t            y,
+    const size_t            z) const
+{
+    assert(level < m_levels.size());
+    return m_levels[level].get(x, y, z);
+}
+
+inline float MajorantGrid::get_global_majorant() const
+{
+    return m_levels.back().m_majorants[0];
+}
+
+inline float MajorantGrid::Level::get(const size_t x, const size_t y, const size_t z) const
+{
+    assert(x < m_xres);
+    assert(y < m_yres);
+    assert(z < m_zres);
+    return m_majorants[(z * m_yres + y) * m_xres + x];
+}
+
+template <typename Visitor>
+void MajorantGrid::traverse(
+    const foundation::Vector3d& org,
+    const foundation::Vector3d& dir,
+    const double                tmin,
+    const double                tmax,
+    Visitor&                    visitor,
+    const size_t                level) const
+{
+    assert(level < m_levels.size());
+    const Level& l = m_levels[level];
+    const size_t res[3] = { l.m_xres, l.m_yres, l.m_zres };
+
+    // Clip the ray segment against the unit cube.
+    double t0 = tmin;
+    double t1 = tmax;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        if (dir[i] == 0.0)
+        {
+            if (org[i] < 0.0 || org[i] > 1.0)
+                return;
+            continue;
+        }
+
+        const double rcp_dir = 1.0 / dir[i];
+        double t_near = -org[i] * rcp_dir;
+        double t_far = (1.0 - org[i]) * rcp_dir;
+        if (t_near > t_far)
+            std::swap(t_near, t_far);
+
+        t0 = std::max(t0, t_near);
+        t1 = std::min(t1, t_far);
+    }
+
+    if (t0 >= t1)
+        return;
+
+    // Find the entry cell and set up the DDA.
+    const double Infinity = std::numeric_limits<double>::max();
+    std::ptrdiff_t cell[3];
+    std::ptrdiff_t step[3];
+    double t_next[3];
+    double t_delta[3];
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const double n = static_cast<double>(res[i]);
+        const double p = (org[i] + t0 * dir[i]) * n;
+        cell[i] =
+            std::min(
+                std::max(static_cast<std::ptrdiff_t>(std::floor(p)), std::ptrdiff_t(0)),
+                static_cast<std::ptrdiff_t>(res[i]) - 1);
+
+        if (dir[i] > 0.0)
+        {
+            step[i] = 1;
+            t_next[i] = ((cell[i] + 1) / n - org[i]) / dir[i];
+            t_delta[i] = 1.0 / (n * dir[i]);
+        }
+        else if (dir[i] < 0.0)
+        {
+            step[i] = -1;
+            t_next[i] = (cell[i] / n - org[i]) / dir[i];
+            t_delta[i] = -1.0 / (n * dir[i]);
+        }
+        else
+        {
+            step[i] = 0;
+            t_next[i] = Infinity;
+            t_delta[i] = Infinity;
+        }
+    }
+
+    double t = t0;
+    while (t < t1)
+    {
+        // Find the axis along which the ray leaves the current cell.
+        const size_t axis =
+            t_next[0] < t_next[1]
+                ? (t_next[0] < t_next[2] ? 0 : 2)
+                : (t_next[1] < t_next[2] ? 1 : 2);
+        const double t_exit = std::min(t_next[axis], t1);
+
+        const float majorant = l.get(cell[0], cell[1], cell[2]);
+        if (majorant > 0.0f && t_exit > t)
+        {
+            if (!visitor(t, t_exit, majorant))
+                return;
+        }
+
+        t = t_exit;
+
+        // Move to the next cell.
+        cell[axis] += step[axis];
+        if (cell[axis] < 0 || cell[axis] >= static_cast<std::ptrdiff_t>(res[axis]))
+            return;
+        t_next[axis] += t_delta[axis];
+    }
+}
+
+namespace majorant_grid_impl
+{
+    template <typename Density>
+    struct IntegratingVisitor
+    {
+        Density&                    m_density;
+        const double                m_max_step;
+        double                      m_integral;
+
+        IntegratingVisitor(Density& density, const double max_step)
+          : m_density(density)
+          , m_max_step(max_step)
+          , m_integral(0.0)
+        {
+        }
+
+        bool operator()(const double t0, const double t1, const float majorant)
+        {
+            const double length = t1 - t0;
+            const size_t step_count =
+                std::max(static_cast<size_t>(std::ceil(length / m_max_step)), size_t(1));
+            const double step = length / step_count;
+
+            for (size_t i = 0; i < step_count; ++i)
+                m_integral += m_density(t0 + (i + 0.5) * step) * step;
+
+            return true;
+        }
+    };
+
+    template <typename Random, typename Collide>
+    struct TrackingVisitor
+    {
+        const float                 m_majorant_scale;
+        Random&                     m_rand;
+        Collide&                    m_collide;
+        double                      m_t;
+        bool                        m_collided;
+
+        TrackingVisitor(const float majorant_scale, Random& rand, Collide& collide)
+          : m_majorant_scale(majorant_scale)
+          , m_rand(rand)
+          , m_collide(collide)
+          , m_collided(false)
+        {
+        }
+
+        bool operator()(const double t0, const double t1, const float majorant)
+        {
+            const float local_majorant = majorant * m_majorant_scale;
+            if (local_majorant <= 0.0f)
+                return true;
+
+            // Free-flight distances are memoryless, so tracking restarts at each cell boundary.
+            m_t = t0;
+            while (true)
+            {
+                m_t -= std::log(1.0 - static_cast<double>(m_rand())) / local_majorant;
+                if (m_t >= t1)
+                    return true;
+
+                if (m_collide(m_t, local_majorant))
+                {
+                    m_collided = true;
+                    return false;
+                }
+            }
+        }
+    };
+}
+
+template <typename Density>
+double MajorantGrid::integrate(
+    const foundation::Vector3d& org,
+    const foundation::Vector3d& dir,
+    const double                tmin,
+    const double                tmax,
+    Density&                    density,
+    const double                max_step,
+    const size_t                level) const
+{
+    assert(max_step > 0.0);
+
+    majorant_grid_impl::IntegratingVisitor<Density> visitor(density, max_step);
+    traverse(org, dir, tmin, tmax, visitor, level);
+
+    return visitor.m_integral;
+}
+
+template <typename Random, typename Collide>
+bool MajorantGrid::track(
+    const foundation::Vector3d& org,
+    const foundation::Vector3d& dir,
+    const double                tmin,
+    const double                tmax,
+    const float                 majorant_scale,
+    Random&                     rand,
+    Collide&                    collide,
+    double&                     t,
+    const size_t                level) const
+{
+    majorant_grid_impl::TrackingVisitor<Random, Collide> visitor(majorant_scale, rand, collide);
+    traverse(org, dir, tmin, tmax, visitor, level);
+
+    if (visitor.m_collided)
+        t = visitor.m_t;
+
+    return visitor.m_collided;
+}
+
+}   // namespace renderer
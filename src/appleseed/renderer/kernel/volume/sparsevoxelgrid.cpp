@@ -0,0 +1,486 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "sparsevoxelgrid.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/cc.h"
+
+// Standard headers.
+#include <algorithm>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// Sparse voxel grid file format:
+//
+//   header        SparseVoxelGridFileHeader
+//   brick table   one SparseVoxelGridFileBrick per brick, in x, y, z order
+//   brick data    BrickSize^3 floats per non-empty brick, in x, y, z order
+//
+
+namespace
+{
+    const std::uint64_t EmptyBrickOffset = ~std::uint64_t(0);
+
+    struct SparseVoxelGridFileHeader
+    {
+        std::uint32_t   m_id;
+        std::uint32_t   m_xres;
+        std::uint32_t   m_yres;
+        std::uint32_t   m_zres;
+        std::uint32_t   m_brick_size;
+    };
+
+    struct SparseVoxelGridFileBrick
+    {
+        std::uint64_t   m_file_offset;
+        float           m_majorant;
+        std::uint32_t   m_reserved;
+    };
+
+    const std::uint32_t SparseVoxelGridFileId = CC32('S', 'V', 'G', '1');
+
+    size_t div_round_up(const size_t a, const size_t b)
+    {
+        return (a + b - 1) / b;
+    }
+
+    // Compute the maximum value over a brick padded by one voxel on every side,
+    // since interpolated lookups inside the brick may reach into its neighbors.
+    float compute_padded_majorant(
+        const VoxelGrid&    grid,
+        const size_t        channel_index,
+        const size_t        x0,
+        const size_t        y0,
+        const size_t        z0)
+    {
+        const size_t BrickSize = SparseVoxelGrid::BrickSize;
+        const size_t x_begin = x0 > 0 ? x0 - 1 : 0;
+        const size_t y_begin = y0 > 0 ? y0 - 1 : 0;
+        const size_t z_begin = z0 > 0 ? z0 - 1 : 0;
+        const size_t x_end = std::min(x0 + BrickSize + 1, grid.get_xres());
+        const size_t y_end = std::min(y0 + BrickSize + 1, grid.get_yres());
+        const size_t z_end = std::min(z0 + BrickSize + 1, grid.get_zres());
+
+        float majorant = 0.0f;
+
+        for (size_t z = z_begin; z < z_end; ++z)
+        {
+            for (size_t y = y_begin; y < y_end; ++y)
+            {
+                for (size_t x = x_begin; x < x_end; ++x)
+                    majorant = std::max(majorant, grid.voxel(x, y, z)[channel_index]);
+            }
+        }
+
+        return majorant;
+    }
+
+    bool seek(std::FILE* file, const std::uint64_t offset)
+    {
+#ifdef _WIN32
+        return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+        return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+    }
+}
+
+
+//
+// SparseVoxelGrid class implementation.
+//
+
+std::unique_ptr<SparseVoxelGrid> SparseVoxelGrid::open(
+    const char*             filename,
+    BrickCache&             brick_cache)
+{
+    assert(filename);
+
+    std::FILE* file = std::fopen(filename, "rb");
+
+    if (file == nullptr)
+        return std::unique_ptr<SparseVoxelGrid>(nullptr);
+
+    // From here on, the grid owns the file.
+    std::unique_ptr<SparseVoxelGrid> grid(new SparseVoxelGrid(filename, file, brick_cache));
+
+    // Read and check the file header.
+    SparseVoxelGridFileHeader header;
+    if (std::fread(&header, sizeof(SparseVoxelGridFileHeader), 1, file) < 1)
+        return std::unique_ptr<SparseVoxelGrid>(nullptr);
+    if (header.m_id != SparseVoxelGridFileId || header.m_brick_size != BrickSize)
+        return std::unique_ptr<SparseVoxelGrid>(nullptr);
+    if (header.m_xres == 0 || header.m_yres == 0 || header.m_zres == 0)
+        return std::unique_ptr<SparseVoxelGrid>(nullptr);
+
+    grid->m_xres = header.m_xres;
+    grid->m_yres = header.m_yres;
+    grid->m_zres = header.m_zres;
+    grid->m_brick_xres = div_round_up(grid->m_xres, BrickSize);
+    grid->m_brick_yres = div_round_up(grid->m_yres, BrickSize);
+    grid->m_brick_zres = div_round_up(grid->m_zres, BrickSize);
+
+    // Read the brick table.
+    const size_t brick_count = grid->m_brick_xres * grid->m_brick_yres * grid->m_brick_zres;
+    std::vector<SparseVoxelGridFileBrick> file_bricks(brick_count);
+    if (std::fread(&file_bricks[0], sizeof(SparseVoxelGridFileBrick), brick_count, file) < brick_count)
+        return std::unique_ptr<SparseVoxelGrid>(nullptr);
+
+    grid->m_bricks.resize(brick_count);
+
+    for (size_t i = 0; i < brick_count; ++i)
+    {
+        grid->m_bricks[i].m_file_offset = file_bricks[i].m_file_offset;
+        grid->m_bricks[i].m_majorant = file_bricks[i].m_majorant;
+
+        if (file_bricks[i].m_file_offset != EmptyBrickOffset)
+            ++grid->m_stored_brick_count;
+    }
+
+    return grid;
+}
+
+SparseVoxelGrid::SparseVoxelGrid(
+    const char*             filename,
+    std::FILE*              file,
+    BrickCache&             brick_cache)
+  : m_uid(new_guid())
+  , m_filename(filename)
+  , m_brick_cache(brick_cache)
+  , m_file(file)
+  , m_xres(0)
+  , m_yres(0)
+  , m_zres(0)
+  , m_brick_xres(0)
+  , m_brick_yres(0)
+  , m_brick_zres(0)
+  , m_stored_brick_count(0)
+{
+}
+
+SparseVoxelGrid::~SparseVoxelGrid()
+{
+    std::fclose(m_file);
+}
+
+SparseVoxelGrid::BrickPtr SparseVoxelGrid::get_brick(const size_t brick_index) const
+{
+    assert(brick_index < m_bricks.size());
+
+    if (m_bricks[brick_index].m_file_offset == EmptyBrickOffset)
+        return BrickPtr();
+
+    return m_brick_cache.get(*this, brick_index);
+}
+
+SparseVoxelGrid::BrickPtr SparseVoxelGrid::load_brick(const size_t brick_index) const
+{
+    assert(brick_index < m_bricks.size());
+
+    std::shared_ptr<Brick> brick(new Brick(BrickVoxelCount));
+
+    if (!seek(m_file, m_bricks[brick_index].m_file_offset) ||
+        std::fread(&(*brick)[0], sizeof(float), BrickVoxelCount, m_file) < BrickVoxelCount)
+    {
+        RENDERER_LOG_ERROR(
+            "failed to read brick " FMT_SIZE_T " of sparse voxel grid file %s.",
+            brick_index,
+            m_filename.c_str());
+        std::fill(brick->begin(), brick->end(), 0.0f);
+    }
+
+    return brick;
+}
+
+
+//
+// SparseVoxelGrid::Accessor class implementation.
+//
+
+SparseVoxelGrid::Accessor::Accessor(const SparseVoxelGrid& grid)
+  : m_grid(grid)
+  , m_brick_index(~size_t(0))
+{
+}
+
+float SparseVoxelGrid::Accessor::get_voxel(
+    const size_t            x,
+    const size_t            y,
+    const size_t            z)
+{
+    const size_t brick_index =
+        m_grid.get_brick_index(x / BrickSize, y / BrickSize, z / BrickSize);
+
+    if (brick_index != m_brick_index)
+    {
+        m_brick = m_grid.get_brick(brick_index);
+        m_brick_index = brick_index;
+    }
+
+    if (!m_brick)
+        return 0.0f;
+
+    const size_t lx = x % BrickSize;
+    const size_t ly = y % BrickSize;
+    const size_t lz = z % BrickSize;
+
+    return (*m_brick)[(lz * BrickSize + ly) * BrickSize + lx];
+}
+
+float SparseVoxelGrid::Accessor::nearest_lookup(const Vector3d& point)
+{
+    const double max_x = static_cast<double>(m_grid.m_xres - 1);
+    const double max_y = static_cast<double>(m_grid.m_yres - 1);
+    const double max_z = static_cast<double>(m_grid.m_zres - 1);
+
+    const double x = clamp(point.x * m_grid.m_xres, 0.0, max_x);
+    const double y = clamp(point.y * m_grid.m_yres, 0.0, max_y);
+    const double z = clamp(point.z * m_grid.m_zres, 0.0, max_z);
+
+    return
+        get_voxel(
+            truncate<size_t>(x),
+            truncate<size_t>(y),
+            truncate<size_t>(z));
+}
+
+float SparseVoxelGrid::Accessor::linear_lookup(const Vector3d& point)
+{
+    const double x = saturate(point.x) * (m_grid.m_xres - 1);
+    const double y = saturate(point.y) * (m_grid.m_yres - 1);
+    const double z = saturate(point.z) * (m_grid.m_zres - 1);
+    const size_t ix0 = truncate<size_t>(x);
+    const size_t iy0 = truncate<size_t>(y);
+    const size_t iz0 = truncate<size_t>(z);
+    const size_t ix1 = std::min(ix0 + 1, m_grid.m_xres - 1);
+    const size_t iy1 = std::min(iy0 + 1, m_grid.m_yres - 1);
+    const size_t iz1 = std::min(iz0 + 1, m_grid.m_zres - 1);
+
+    // Compute interpolation weights.
+    const float x1 = static_cast<float>(x - ix0);
+    const float y1 = static_cast<float>(y - iy0);
+    const float z1 = static_cast<float>(z - iz0);
+    const float x0 = 1.0f - x1;
+    const float y0 = 1.0f - y1;
+    const float z0 = 1.0f - z1;
+
+    // Blend.
+    return
+        z0 * (y0 * (x0 * get_voxel(ix0, iy0, iz0) + x1 * get_voxel(ix1, iy0, iz0)) +
+              y1 * (x0 * get_voxel(ix0, iy1, iz0) + x1 * get_voxel(ix1, iy1, iz0))) +
+        z1 * (y0 * (x0 * get_voxel(ix0, iy0, iz1) + x1 * get_voxel(ix1, iy0, iz1)) +
+              y1 * (x0 * get_voxel(ix0, iy1, iz1) + x1 * get_voxel(ix1, iy1, iz1)));
+}
+
+
+//
+// Sparse voxel grid I/O.
+//
+
+bool write_sparse_voxel_grid(
+    const char*             filename,
+    const VoxelGrid&        grid,
+    const size_t            channel_index)
+{
+    assert(filename);
+    assert(channel_index < grid.get_channel_count());
+
+    const size_t BrickSize = SparseVoxelGrid::BrickSize;
+    const size_t brick_xres = div_round_up(grid.get_xres(), BrickSize);
+    const size_t brick_yres = div_round_up(grid.get_yres(), BrickSize);
+    const size_t brick_zres = div_round_up(grid.get_zres(), BrickSize);
+    const size_t brick_count = brick_xres * brick_yres * brick_zres;
+
+    std::vector<SparseVoxelGridFileBrick> file_bricks(brick_count);
+    std::vector<float> brick_data;
+
+    std::uint64_t file_offset =
+        sizeof(SparseVoxelGridFileHeader) +
+        brick_count * sizeof(SparseVoxelGridFileBrick);
+
+    for (size_t bz = 0; bz < brick_zres; ++bz)
+    {
+        for (size_t by = 0; by < brick_yres; ++by)
+        {
+            for (size_t bx = 0; bx < brick_xres; ++bx)
+            {
+                const size_t x0 = bx * BrickSize;
+                const size_t y0 = by * BrickSize;
+                const size_t z0 = bz * BrickSize;
+
+                const float majorant =
+                    compute_padded_majorant(grid, channel_index, x0, y0, z0);
+
+                // Gather the voxels of the brick, padding partial bricks with zeros.
+                float brick[SparseVoxelGrid::BrickVoxelCount];
+                bool is_empty = true;
+                for (size_t z = 0; z < BrickSize; ++z)
+                {
+                    for (size_t y = 0; y < BrickSize; ++y)
+                    {
+                        for (size_t x = 0; x < BrickSize; ++x)
+                        {
+                            float value = 0.0f;
+
+                            if (x0 + x < grid.get_xres() &&
+                                y0 + y < grid.get_yres() &&
+                                z0 + z < grid.get_zres())
+                                value = grid.voxel(x0 + x, y0 + y, z0 + z)[channel_index];
+
+                            if (value != 0.0f)
+                                is_empty = false;
+
+                            brick[(z * BrickSize + y) * BrickSize + x] = value;
+                        }
+                    }
+                }
+
+                SparseVoxelGridFileBrick& file_brick = file_bricks[(bz * brick_yres + by) * brick_xres + bx];
+                file_brick.m_majorant = majorant;
+                file_brick.m_reserved = 0;
+
+                if (is_empty)
+                    file_brick.m_file_offset = EmptyBrickOffset;
+                else
+                {
+                    file_brick.m_file_offset = file_offset;
+                    file_offset += sizeof(brick);
+                    brick_data.insert(brick_data.end(), brick, brick + SparseVoxelGrid::BrickVoxelCount);
+                }
+            }
+        }
+    }
+
+    std::FILE* file = std::fopen(filename, "wb");
+
+    if (file == nullptr)
+        return false;
+
+    SparseVoxelGridFileHeader header;
+    header.m_id = SparseVoxelGridFileId;
+    header.m_xres = static_cast<std::uint32_t>(grid.get_xres());
+    header.m_yres = static_cast<std::uint32_t>(grid.get_yres());
+    header.m_zres = static_cast<std::uint32_t>(grid.get_zres());
+    header.m_brick_size = static_cast<std::uint32_t>(BrickSize);
+
+    bool success =
+        std::fwrite(&header, sizeof(SparseVoxelGridFileHeader), 1, file) == 1 &&
+        std::fwrite(&file_bricks[0], sizeof(SparseVoxelGridFileBrick), brick_count, file) == brick_count;
+
+    if (success && !brick_data.empty())
+        success = std::fwrite(&brick_data[0], sizeof(float), brick_data.size(), file) == brick_data.size();
+
+    if (std::fclose(file) != 0)
+        success = false;
+
+    return success;
+}
+
+
+//
+// BrickCache class implementation.
+//
+
+BrickCache::BrickCache(const size_t memory_limit)
+  : m_swapper(memory_limit)
+  , m_cache(m_key_hasher, m_swapper)
+{
+}
+
+SparseVoxelGrid::BrickPtr BrickCache::get(
+    const SparseVoxelGrid&  grid,
+    const size_t            brick_index)
+{
+    BrickKey key;
+    key.m_grid = &grid;
+    key.m_grid_uid = grid.m_uid;
+    key.m_brick_index = brick_index;
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_cache.get(key);
+}
+
+size_t BrickCache::get_hit_count() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return static_cast<size_t>(m_cache.get_hit_count());
+}
+
+size_t BrickCache::get_miss_count() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return static_cast<size_t>(m_cache.get_miss_count());
+}
+
+bool BrickCache::BrickKey::operator==(const BrickKey& rhs) const
+{
+    return m_grid_uid == rhs.m_grid_uid && m_brick_index == rhs.m_brick_index;
+}
+
+size_t BrickCache::BrickKeyHasher::operator()(const BrickKey& key) const
+{
+    return static_cast<size_t>(key.m_grid_uid * 0x9E3779B97F4A7C15ull) ^ key.m_brick_index;
+}
+
+BrickCache::BrickSwapper::BrickSwapper(const size_t memory_limit)
+  : m_max_brick_count(
+        std::max<size_t>(
+            memory_limit / (SparseVoxelGrid::BrickVoxelCount * sizeof(float)),
+            1))
+{
+}
+
+void BrickCache::BrickSwapper::load(const BrickKey& key, SparseVoxelGrid::BrickPtr& brick)
+{
+    brick = key.m_grid->load_brick(key.m_brick_index);
+}
+
+bool BrickCache::BrickSwapper::unload(const BrickKey& key, SparseVoxelGrid::BrickPtr& brick)
+{
+    // Accessors may still hold on to the brick; it is freed when they release it.
+    brick.reset();
+    return true;
+}
+
+bool BrickCache::BrickSwapper::is_full(const size_t element_count) const
+{
+    return element_count > m_max_brick_count;
+}
+
+}   // namespace renderer
@@ -0,0 +1,311 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/kernel/volume/volume.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/thread.h"
+#include "foundation/utility/cache.h"
+#include "foundation/utility/uid.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace renderer
+{
+
+class BrickCache;
+
+//
+// A sparse, single-channel voxel grid.
+//
+// The grid is divided into bricks of BrickSize^3 voxels. Only bricks containing
+// at least one non-zero voxel are stored. Bricks stay on disk and are loaded on
+// demand through a BrickCache of bounded size, which can be shared by any number
+// of grids and threads.
+//
+// Like VoxelGrid lookups, lookups work in the unit cube [0,1]^3.
+//
+
+class SparseVoxelGrid
+  : public foundation::NonCopyable
+{
+  public:
+    static const size_t BrickSize = 8;
+    static const size_t BrickVoxelCount = BrickSize * BrickSize * BrickSize;
+
+    typedef std::vector<float> Brick;
+    typedef std::shared_ptr<const Brick> BrickPtr;
+
+    // Open a sparse voxel grid file. Returns nullptr on failure.
+    static std::unique_ptr<SparseVoxelGrid> open(
+        const char*         filename,
+        BrickCache&         brick_cache);
+
+    // Destructor.
+    ~SparseVoxelGrid();
+
+    size_t get_xres() const;
+    size_t get_yres() const;
+    size_t get_zres() const;
+
+    size_t get_brick_xres() const;
+    size_t get_brick_yres() const;
+    size_t get_brick_zres() const;
+
+    // Return the number of non-empty bricks.
+    size_t get_stored_brick_count() const;
+
+    // Return an upper bound on the values obtained by nearest or trilinear
+    // lookups inside a given brick, including empty bricks.
+    float get_brick_majorant(
+        const size_t        bx,
+        const size_t        by,
+        const size_t        bz) const;
+
+    // Fetch a brick through the brick cache. Returns nullptr for empty bricks. Thread-safe.
+    BrickPtr get_brick(
+        const size_t        bx,
+        const size_t        by,
+        const size_t        bz) const;
+
+    //
+    // Per-thread lookup helper that keeps the last brick it accessed, so that
+    // coherent lookups rarely go through the (locked) brick cache.
+    //
+
+    class Accessor
+    {
+      public:
+        explicit Accessor(const SparseVoxelGrid& grid);
+
+        float get_voxel(
+            const size_t    x,
+            const size_t    y,
+            const size_t    z);
+
+        // Perform an unfiltered lookup of the voxel grid.
+        float nearest_lookup(const foundation::Vector3d& point);
+
+        // Perform a trilinearly interpolated lookup of the voxel grid.
+        float linear_lookup(const foundation::Vector3d& point);
+
+      private:
+        const SparseVoxelGrid&  m_grid;
+        size_t                  m_brick_index;
+        BrickPtr                m_brick;
+    };
+
+  private:
+    friend class BrickCache;
+
+    struct BrickInfo
+    {
+        std::uint64_t       m_file_offset;          // ~0 for empty bricks
+        float               m_majorant;
+    };
+
+    const foundation::UniqueID  m_uid;
+    const std::string           m_filename;
+    BrickCache&                 m_brick_cache;
+    std::FILE*                  m_file;
+    size_t                      m_xres;
+    size_t                      m_yres;
+    size_t                      m_zres;
+    size_t                      m_brick_xres;
+    size_t                      m_brick_yres;
+    size_t                      m_brick_zres;
+    size_t                      m_stored_brick_count;
+    std::vector<BrickInfo>      m_bricks;
+
+    SparseVoxelGrid(
+        const char*         filename,
+        std::FILE*          file,
+        BrickCache&         brick_cache);
+
+    size_t get_brick_index(
+        const size_t        bx,
+        const size_t        by,
+        const size_t        bz) const;
+
+    BrickPtr get_brick(const size_t brick_index) const;
+
+    // Called by the brick cache, with its lock held.
+    BrickPtr load_brick(const size_t brick_index) const;
+};
+
+// Write the given channel of a voxel grid to disk as a sparse voxel grid.
+// Returns true on success.
+bool write_sparse_voxel_grid(
+    const char*             filename,
+    const VoxelGrid&        grid,
+    const size_t            channel_index);
+
+
+//
+// A thread-safe, memory-bounded LRU cache of sparse voxel grid bricks.
+//
+
+class BrickCache
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. memory_limit is in bytes.
+    explicit BrickCache(const size_t memory_limit);
+
+    // Fetch a brick, loading it from disk if necessary. Thread-safe.
+    SparseVoxelGrid::BrickPtr get(
+        const SparseVoxelGrid&  grid,
+        const size_t            brick_index);
+
+    size_t get_hit_count() const;
+    size_t get_miss_count() const;
+
+  private:
+    // Keys are compared by grid UID so that bricks of a destroyed grid are never
+    // mistaken for bricks of a new grid; they simply age out of the cache.
+    struct BrickKey
+    {
+        const SparseVoxelGrid*  m_grid;
+        foundation::UniqueID    m_grid_uid;
+        size_t                  m_brick_index;
+
+        bool operator==(const BrickKey& rhs) const;
+    };
+
+    struct BrickKeyHasher
+    {
+        size_t operator()(const BrickKey& key) const;
+    };
+
+    class BrickSwapper
+      : public foundation::NonCopyable
+    {
+      public:
+        explicit BrickSwapper(const size_t memory_limit);
+
+        void load(const BrickKey& key, SparseVoxelGrid::BrickPtr& brick);
+        bool unload(const BrickKey& key, SparseVoxelGrid::BrickPtr& brick);
+        bool is_full(const size_t element_count) const;
+
+      private:
+        const size_t            m_max_brick_count;
+    };
+
+    typedef foundation::LRUCache<
+        BrickKey,
+        BrickKeyHasher,
+        SparseVoxelGrid::BrickPtr,
+        BrickSwapper
+    > Cache;
+
+    mutable boost::mutex        m_mutex;
+    BrickKeyHasher              m_key_hasher;
+    BrickSwapper                m_swapper;
+    Cache                       m_cache;
+};
+
+
+//
+// SparseVoxelGrid class implementation.
+//
+
+inline size_t SparseVoxelGrid::get_xres() const
+{
+    return m_xres;
+}
+
+inline size_t SparseVoxelGrid::get_yres() const
+{
+    return m_yres;
+}
+
+inline size_t SparseVoxelGrid::get_zres() const
+{
+    return m_zres;
+}
+
+inline size_t SparseVoxelGrid::get_brick_xres() const
+{
+    return m_brick_xres;
+}
+
+inline size_t SparseVoxelGrid::get_brick_yres() const
+{
+    return m_brick_yres;
+}
+
+inline size_t SparseVoxelGrid::get_brick_zres() const
+{
+    return m_brick_zres;
+}
+
+inline size_t SparseVoxelGrid::get_stored_brick_count() const
+{
+    return m_stored_brick_count;
+}
+
+inline size_t SparseVoxelGrid::get_brick_index(
+    const size_t            bx,
+    const size_t            by,
+    const size_t            bz) const
+{
+    assert(bx < m_brick_xres);
+    assert(by < m_brick_yres);
+    assert(bz < m_brick_zres);
+    return (bz * m_brick_yres + by) * m_brick_xres + bx;
+}
+
+inline float SparseVoxelGrid::get_brick_majorant(
+    const size_t            bx,
+    const size_t            by,
+    const size_t            bz) const
+{
+    return m_bricks[get_brick_index(bx, by, bz)].m_majorant;
+}
+
+inline SparseVoxelGrid::BrickPtr SparseVoxelGrid::get_brick(
+    const size_t            bx,
+    const size_t            by,
+    const size_t            bz) const
+{
+    return get_brick(get_brick_index(bx, by, bz));
+}
+
+}   // namespace renderer
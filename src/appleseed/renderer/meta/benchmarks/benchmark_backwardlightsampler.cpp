@@ -0,0 +1,260 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/intersection/tracecontext.h"
+#include "renderer/kernel/lighting/backwardlightsampler.h"
+#include "renderer/kernel/lighting/lightsample.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/edf/diffuseedf.h"
+#include "renderer/modeling/light/light.h"
+#include "renderer/modeling/light/pointlight.h"
+#include "renderer/modeling/material/genericmaterial.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/triangle.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/visibilityflags.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/containers/dictionary.h"
+#include "foundation/math/matrix.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/benchmark.h"
+
+// Standard headers.
+#include <cstddef>
+#include <memory>
+#include <string>
+
+using namespace foundation;
+using namespace renderer;
+
+BENCHMARK_SUITE(Renderer_Kernel_Lighting_BackwardLightSampler)
+{
+    // A receiving plane lit by many point lights and by a finely tessellated emitting grid.
+    struct TestScene
+      : public TestSceneBase
+    {
+        static const size_t PointLightCount = 1024;
+        static const size_t GridSize = 32;
+
+        TestScene()
+        {
+            auto_release_ptr<Assembly> assembly(
+                AssemblyFactory().create("assembly", ParamArray()));
+
+            // Point lights.
+            MersenneTwister rng;
+            for (size_t i = 0; i < PointLightCount; ++i)
+            {
+                const std::string name = "light_" + to_string(i);
+                auto_release_ptr<Light> light(
+                    PointLightFactory().create(
+                        name.c_str(),
+                        ParamArray().insert("intensity", rand_float1(rng, 0.1f, 1.0f))));
+
+                const Vector3d position(
+                    rand_double1(rng, -4.0, 0.0),
+                    rand_double1(rng, -2.0, 2.0),
+                    rand_double1(rng, -2.0, 2.0));
+                light->set_transform(
+                    Transformd::from_local_to_parent(
+                        Matrix4d::make_translation(position)));
+
+                assembly->lights().insert(light);
+            }
+
+            // Emitting grid.
+            assembly->edfs().insert(
+                DiffuseEDFFactory().create("edf", ParamArray().insert("radiance", 1.0f)));
+
+            assembly->materials().insert(
+                GenericMaterialFactory().create("emitting_material", ParamArray().insert("edf", "edf")));
+
+            auto_release_ptr<MeshObject> grid(
+                MeshObjectFactory().create("grid", ParamArray()));
+
+            for (size_t j = 0; j <= GridSize; ++j)
+            {
+                for (size_t i = 0; i <= GridSize; ++i)
+                {
+                    const GScalar u = static_cast<GScalar>(i) / GridSize;
+                    const GScalar v = static_cast<GScalar>(j) / GridSize;
+                    grid->push_vertex(GVector3(4.0f * u - 4.0f, 2.0f, 4.0f * v - 2.0f));
+                }
+            }
+
+            grid->push_vertex_normal(GVector3(0.0f, -1.0f, 0.0f));
+
+            for (size_t j = 0; j < GridSize; ++j)
+            {
+                for (size_t i = 0; i < GridSize; ++i)
+                {
+                    const size_t v0 = j * (GridSize + 1) + i;
+                    const size_t v1 = v0 + 1;
+                    const size_t v2 = v1 + GridSize + 1;
+                    const size_t v3 = v0 + GridSize + 1;
+
+                    grid->push_triangle(Triangle(v0, v1, v2, 0, 0, 0, 0));
+                    grid->push_triangle(Triangle(v2, v3, v0, 0, 0, 0, 0));
+                }
+            }
+
+            grid->push_material_slot("material");
+
+            assembly->objects().insert(auto_release_ptr<Object>(grid.release()));
+
+            StringDictionary material_mappings;
+            material_mappings.insert("material", "emitting_material");
+
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "grid_inst",
+                    ParamArray(),
+                    "grid",
+                    Transformd::identity(),
+                    material_mappings,
+                    material_mappings));
+
+            // Receiving plane.
+            auto_release_ptr<MeshObject> plane(
+                MeshObjectFactory().create("plane", ParamArray()));
+
+            plane->push_vertex(GVector3(0.0f, -0.5f, -0.5f));
+            plane->push_vertex(GVector3(0.0f, +0.5f, -0.5f));
+            plane->push_vertex(GVector3(0.0f, +0.5f, +0.5f));
+            plane->push_vertex(GVector3(0.0f, -0.5f, +0.5f));
+
+            plane->push_vertex_normal(GVector3(-1.0f, 0.0f, 0.0f));
+
+            plane->push_triangle(Triangle(0, 1, 2, 0, 0, 0, 0));
+            plane->push_triangle(Triangle(2, 3, 0, 0, 0, 0, 0));
+
+            assembly->objects().insert(auto_release_ptr<Object>(plane.release()));
+
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "plane_inst",
+                    ParamArray(),
+                    "plane",
+                    Transformd::from_local_to_parent(
+                        Matrix4d::make_translation(Vector3d(2.0, 0.0, 0.0))),
+                    StringDictionary()));
+
+            m_scene.assembly_instances().insert(
+                AssemblyInstanceFactory::create(
+                    "assembly_inst",
+                    ParamArray(),
+                    "assembly"));
+
+            m_scene.assemblies().insert(assembly);
+        }
+    };
+
+    template <bool UseLightTree>
+    struct Fixture
+      : public StaticTestSceneContext<TestScene>
+    {
+        TraceContext                            m_trace_context;
+        TextureStore                            m_texture_store;
+        TextureCache                            m_texture_cache;
+        Intersector                             m_intersector;
+        std::unique_ptr<BackwardLightSampler>   m_light_sampler;
+        ShadingPoint                            m_shading_point;
+        MersenneTwister                         m_rng;
+        double                                  m_dummy;
+
+        Fixture()
+          : m_trace_context(m_scene)
+          , m_texture_store(m_scene)
+          , m_texture_cache(m_texture_store)
+          , m_intersector(m_trace_context, m_texture_cache)
+          , m_light_sampler(
+                new BackwardLightSampler(
+                    m_scene,
+                    ParamArray().insert("algorithm", UseLightTree ? "lighttree" : "cdf")))
+          , m_dummy(0.0)
+        {
+            m_trace_context.update();
+
+            const ShadingRay ray(
+                Vector3d(0.0, 0.1, 0.2),
+                Vector3d(1.0, 0.0, 0.0),
+                0.0,                            // tmin
+                10.0,                           // tmax
+                ShadingRay::Time(),
+                VisibilityFlags::CameraRay,
+                0);                             // depth
+            m_intersector.trace(ray, m_shading_point);
+        }
+
+        void sample_lightset()
+        {
+            const Vector3f s(
+                rand_float2(m_rng),
+                rand_float2(m_rng),
+                rand_float2(m_rng));
+
+            LightSample light_sample;
+            m_light_sampler->sample_lightset(
+                ShadingRay::Time(),
+                s,
+                m_shading_point,
+                light_sample);
+
+            m_dummy += light_sample.m_probability;
+        }
+    };
+
+    BENCHMARK_CASE_F(SampleLightset_CDF, Fixture<false>)
+    {
+        sample_lightset();
+    }
+
+    BENCHMARK_CASE_F(SampleLightset_LightTree, Fixture<true>)
+    {
+        sample_lightset();
+    }
+}
@@ -0,0 +1,354 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/intersection/tracecontext.h"
+#include "renderer/kernel/lighting/scatteringmode.h"
+#include "renderer/kernel/lighting/tracer.h"
+#include "renderer/kernel/rendering/rendererservices.h"
+#include "renderer/kernel/shading/directshadingcomponents.h"
+#include "renderer/kernel/shading/oslshadergroupexec.h"
+#include "renderer/kernel/shading/oslshadingsystem.h"
+#include "renderer/kernel/shading/shadingcontext.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/kernel/texturing/oiiotexturesystem.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/bsdf/ashikhminbrdf.h"
+#include "renderer/modeling/bsdf/blinnbrdf.h"
+#include "renderer/modeling/bsdf/bsdf.h"
+#include "renderer/modeling/bsdf/bsdfsample.h"
+#include "renderer/modeling/bsdf/diffusebtdf.h"
+#include "renderer/modeling/bsdf/disneybrdf.h"
+#include "renderer/modeling/bsdf/glassbsdf.h"
+#include "renderer/modeling/bsdf/glossybrdf.h"
+#include "renderer/modeling/bsdf/hairbsdf.h"
+#include "renderer/modeling/bsdf/kelemenbrdf.h"
+#include "renderer/modeling/bsdf/lambertianbrdf.h"
+#include "renderer/modeling/bsdf/metalbrdf.h"
+#include "renderer/modeling/bsdf/orennayarbrdf.h"
+#include "renderer/modeling/bsdf/plasticbrdf.h"
+#include "renderer/modeling/bsdf/sheenbrdf.h"
+#include "renderer/modeling/bsdf/specularbrdf.h"
+#include "renderer/modeling/bsdf/specularbtdf.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/triangle.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/visibilityflags.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/containers/dictionary.h"
+#include "foundation/math/basis.h"
+#include "foundation/math/dual.h"
+#include "foundation/math/matrix.h"
+#include "foundation/math/sampling/mappings.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/arena.h"
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/benchmark.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+using namespace foundation;
+using namespace renderer;
+
+BENCHMARK_SUITE(Renderer_Modeling_BSDF)
+{
+    // Hair BSDF with a low longitudinal roughness, for which the longitudinal
+    // scattering function is evaluated in log space.
+    struct SmoothHairBSDFFactory
+      : public HairBSDFFactory
+    {
+        DictionaryArray get_input_metadata() const override
+        {
+            DictionaryArray metadata = HairBSDFFactory::get_input_metadata();
+
+            for (size_t i = 0, e = metadata.size(); i < e; ++i)
+            {
+                if (strcmp(metadata[i].get("name"), "beta_M") == 0)
+                    metadata[i].insert("default", "0.05");
+            }
+
+            return metadata;
+        }
+    };
+
+    // A plane facing the -X axis and a BSDF created with its default parameters.
+    template <typename BSDFFactory>
+    struct TestScene
+      : public TestSceneBase
+    {
+        TestScene()
+        {
+            auto_release_ptr<Assembly> assembly(
+                AssemblyFactory().create("assembly", ParamArray()));
+
+            BSDFFactory factory;
+            const DictionaryArray metadata = factory.get_input_metadata();
+
+            ParamArray params;
+            for (size_t i = 0, e = metadata.size(); i < e; ++i)
+            {
+                const Dictionary& input = metadata[i];
+                if (input.strings().exist("default"))
+                    params.insert(input.get("name"), input.get("default"));
+            }
+
+            assembly->bsdfs().insert(factory.create("bsdf", params));
+
+            auto_release_ptr<MeshObject> mesh_object(
+                MeshObjectFactory().create("plane", ParamArray()));
+
+            mesh_object->push_vertex(GVector3(0.0f, -0.5f, -0.5f));
+            mesh_object->push_vertex(GVector3(0.0f, +0.5f, -0.5f));
+            mesh_object->push_vertex(GVector3(0.0f, +0.5f, +0.5f));
+            mesh_object->push_vertex(GVector3(0.0f, -0.5f, +0.5f));
+
+            mesh_object->push_vertex_normal(GVector3(-1.0f, 0.0f, 0.0f));
+
+            mesh_object->push_tex_coords(GVector2(0.0f, 0.0f));
+            mesh_object->push_tex_coords(GVector2(1.0f, 0.0f));
+            mesh_object->push_tex_coords(GVector2(1.0f, 1.0f));
+            mesh_object->push_tex_coords(GVector2(0.0f, 1.0f));
+
+            mesh_object->push_triangle(Triangle(0, 1, 2, 0, 0, 0, 0, 1, 2, 0));
+            mesh_object->push_triangle(Triangle(2, 3, 0, 0, 0, 0, 2, 3, 0, 0));
+
+            assembly->objects().insert(auto_release_ptr<Object>(mesh_object.release()));
+
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "plane_inst",
+                    ParamArray(),
+                    "plane",
+                    Transformd::from_local_to_parent(
+                        Matrix4d::make_translation(Vector3d(2.0, 0.0, 0.0))),
+                    StringDictionary()));
+
+            m_scene.assembly_instances().insert(
+                AssemblyInstanceFactory::create(
+                    "assembly_inst",
+                    ParamArray(),
+                    "assembly"));
+
+            m_scene.assemblies().insert(assembly);
+        }
+    };
+
+    template <typename BSDFFactory>
+    struct Fixture
+      : public StaticTestSceneContext<TestScene<BSDFFactory>>
+    {
+        typedef StaticTestSceneContext<TestScene<BSDFFactory>> Base;
+
+        TraceContext                            m_trace_context;
+        TextureStore                            m_texture_store;
+        TextureCache                            m_texture_cache;
+        Intersector                             m_intersector;
+        std::shared_ptr<OIIOTextureSystem>      m_texture_system;
+        RendererServices                        m_renderer_services;
+        std::shared_ptr<OSLShadingSystem>       m_shading_system;
+        Arena                                   m_arena;
+        OSLShaderGroupExec                      m_shading_group_exec;
+        Tracer                                  m_tracer;
+        ShadingContext                          m_shading_context;
+        ShadingPoint                            m_shading_point;
+        const BSDF*                             m_bsdf;
+        const void*                             m_bsdf_data;
+        BSDF::LocalGeometry                     m_local_geometry;
+        Vector3f                                m_outgoing;
+        SamplingContext::RNGType                m_rng;
+        SamplingContext                         m_sampling_context;
+        float                                   m_dummy;
+
+        Fixture()
+          : m_trace_context(Base::m_scene)
+          , m_texture_store(Base::m_scene)
+          , m_texture_cache(m_texture_store)
+          , m_intersector(m_trace_context, m_texture_cache)
+          , m_texture_system(
+                OIIOTextureSystemFactory::create(),
+                [](OIIOTextureSystem* object) { object->release(); })
+          , m_renderer_services(Base::m_project, *m_texture_system)
+          , m_shading_system(
+                OSLShadingSystemFactory::create(&m_renderer_services, m_texture_system.get()),
+                [](OSLShadingSystem* object) { object->release(); })
+          , m_shading_group_exec(*m_shading_system, m_arena)
+          , m_tracer(Base::m_scene, m_intersector, m_shading_group_exec)
+          , m_shading_context(
+                m_intersector,
+                m_tracer,
+                m_texture_cache,
+                *m_texture_system,
+                m_shading_group_exec,
+                m_arena,
+                0)  // thread index
+          , m_sampling_context(m_rng, SamplingContext::RNGMode)
+          , m_dummy(0.0f)
+        {
+            m_trace_context.update();
+
+            const ShadingRay ray(
+                Vector3d(0.0, 0.1, 0.2),
+                Vector3d(1.0, 0.0, 0.0),
+                0.0,                            // tmin
+                10.0,                           // tmax
+                ShadingRay::Time(),
+                VisibilityFlags::CameraRay,
+                0);                             // depth
+            m_intersector.trace(ray, m_shading_point);
+
+            m_bsdf = Base::m_scene.assemblies().get_by_name("assembly")->bsdfs().get_by_name("bsdf");
+
+            void* data = m_bsdf->evaluate_inputs(m_shading_context, m_shading_point);
+            m_bsdf->prepare_inputs(m_arena, m_shading_point, data);
+            m_bsdf_data = data;
+
+            m_local_geometry.m_shading_point = &m_shading_point;
+            m_local_geometry.m_geometric_normal = Vector3f(m_shading_point.get_geometric_normal());
+            m_local_geometry.m_shading_basis = Basis3f(m_shading_point.get_shading_basis());
+
+            m_outgoing = normalize(Vector3f(-1.0f, 0.3f, 0.2f));
+        }
+
+        void sample()
+        {
+            BSDFSample sample;
+            m_bsdf->sample(
+                m_sampling_context,
+                m_bsdf_data,
+                false,                          // not adjoint
+                true,                           // multiply by |cos(incoming, normal)|
+                m_local_geometry,
+                Dual3f(m_outgoing),
+                ScatteringMode::All,
+                sample);
+            m_dummy += sample.get_probability();
+        }
+
+        void evaluate()
+        {
+            const Vector3f incoming =
+                sample_sphere_uniform(m_sampling_context.next2<Vector2f>());
+
+            DirectShadingComponents value;
+            m_dummy +=
+                m_bsdf->evaluate(
+                    m_bsdf_data,
+                    false,                      // not adjoint
+                    true,                       // multiply by |cos(incoming, normal)|
+                    m_local_geometry,
+                    m_outgoing,
+                    incoming,
+                    ScatteringMode::All,
+                    value);
+        }
+
+        void evaluate_pdf()
+        {
+            const Vector3f incoming =
+                sample_sphere_uniform(m_sampling_context.next2<Vector2f>());
+
+            m_dummy +=
+                m_bsdf->evaluate_pdf(
+                    m_bsdf_data,
+                    false,                      // not adjoint
+                    m_local_geometry,
+                    m_outgoing,
+                    incoming,
+                    ScatteringMode::All);
+        }
+    };
+
+#define BSDF_BENCHMARK_CASES(Name)                                                          \
+    BENCHMARK_CASE_F(Name##_Sample, Fixture<Name##Factory>)                                 \
+    {                                                                                       \
+        sample();                                                                           \
+    }                                                                                       \
+                                                                                            \
+    BENCHMARK_CASE_F(Name##_Evaluate, Fixture<Name##Factory>)                               \
+    {                                                                                       \
+        evaluate();                                                                         \
+    }
+
+    BSDF_BENCHMARK_CASES(AshikhminBRDF)
+    BSDF_BENCHMARK_CASES(BlinnBRDF)
+    BSDF_BENCHMARK_CASES(DiffuseBTDF)
+    BSDF_BENCHMARK_CASES(DisneyBRDF)
+    BSDF_BENCHMARK_CASES(GlassBSDF)
+    BSDF_BENCHMARK_CASES(GlossyBRDF)
+    BSDF_BENCHMARK_CASES(HairBSDF)
+    BSDF_BENCHMARK_CASES(KelemenBRDF)
+    BSDF_BENCHMARK_CASES(LambertianBRDF)
+    BSDF_BENCHMARK_CASES(MetalBRDF)
+    BSDF_BENCHMARK_CASES(OrenNayarBRDF)
+    BSDF_BENCHMARK_CASES(PlasticBRDF)
+    BSDF_BENCHMARK_CASES(SheenBRDF)
+    BSDF_BENCHMARK_CASES(SpecularBRDF)
+    BSDF_BENCHMARK_CASES(SpecularBTDF)
+
+#undef BSDF_BENCHMARK_CASES
+
+    // Hair is shaded very often in groom renders, so also cover its PDF
+    // evaluation and its low roughness code path.
+
+    BENCHMARK_CASE_F(HairBSDF_EvaluatePDF, Fixture<HairBSDFFactory>)
+    {
+        evaluate_pdf();
+    }
+
+    BENCHMARK_CASE_F(SmoothHairBSDF_Sample, Fixture<SmoothHairBSDFFactory>)
+    {
+        sample();
+    }
+
+    BENCHMARK_CASE_F(SmoothHairBSDF_Evaluate, Fixture<SmoothHairBSDFFactory>)
+    {
+        evaluate();
+    }
+
+    BENCHMARK_CASE_F(SmoothHairBSDF_EvaluatePDF, Fixture<SmoothHairBSDFFactory>)
+    {
+        evaluate_pdf();
+    }
+}
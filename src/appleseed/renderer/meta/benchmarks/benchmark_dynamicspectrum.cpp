@@ -30,6 +30,8 @@
 #include "renderer/utility/dynamicspectrum.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/image/colorspace.h"
 #include "foundation/utility/benchmark.h"
 
 using namespace foundation;
@@ -43,17 +45,23 @@ BENCHMARK_SUITE(Renderer_Utility_DynamicSpectrum31f)
         const DynamicSpectrum31f::Mode  m_old_mode;
         DynamicSpectrum31f              m_black;
         DynamicSpectrum31f              m_white;
+        DynamicSpectrum31f              m_result;
+        LightingConditions              m_lighting_conditions;
         bool                            m_is_zero_result;
         float                           m_max_value_result;
+        Color3f                         m_xyz_result;
 
         Fixture()
           : m_old_mode(DynamicSpectrum31f::set_mode(Mode))
+          , m_lighting_conditions(IlluminantCIED65, XYZCMFCIE19312Deg)
           , m_is_zero_result(true)
           , m_max_value_result(0.0f)
+          , m_xyz_result(0.0f)
         {
             // Must be initialized after setting the dynamic spectrum mode.
             m_black = DynamicSpectrum31f(0.0f);
             m_white = DynamicSpectrum31f(1.0f);
+            m_result = DynamicSpectrum31f(0.0f);
         }
 
         ~Fixture()
@@ -82,6 +90,11 @@ BENCHMARK_SUITE(Renderer_Utility_DynamicSpectrum31f)
         m_max_value_result += max_value(m_white);
     }
 
+    BENCHMARK_CASE_F(Copy_RGB, Fixture<DynamicSpectrum31f::RGB>)
+    {
+        m_result = m_white;
+    }
+
     BENCHMARK_CASE_F(IsZero_Black_Spectral, Fixture<DynamicSpectrum31f::Spectral>)
     {
         m_is_zero_result ^= is_zero(m_black);
@@ -101,4 +114,34 @@ BENCHMARK_SUITE(Renderer_Utility_DynamicSpectrum31f)
     {
         m_max_value_result += max_value(m_white);
     }
+
+    BENCHMARK_CASE_F(Copy_Spectral, Fixture<DynamicSpectrum31f::Spectral>)
+    {
+        m_result = m_white;
+    }
+
+    BENCHMARK_CASE_F(Addition_Spectral, Fixture<DynamicSpectrum31f::Spectral>)
+    {
+        m_result += m_white;
+    }
+
+    BENCHMARK_CASE_F(MultiplicationBySpectrum_Spectral, Fixture<DynamicSpectrum31f::Spectral>)
+    {
+        m_result *= m_white;
+    }
+
+    BENCHMARK_CASE_F(MultiplyAdd_Spectral, Fixture<DynamicSpectrum31f::Spectral>)
+    {
+        madd(m_result, m_white, 0.5f);
+    }
+
+    BENCHMARK_CASE_F(Lerp_Spectral, Fixture<DynamicSpectrum31f::Spectral>)
+    {
+        m_result = lerp(m_black, m_white, m_result);
+    }
+
+    BENCHMARK_CASE_F(ConvertToCIEXYZ_Spectral, Fixture<DynamicSpectrum31f::Spectral>)
+    {
+        m_xyz_result += spectrum_to_ciexyz<float>(m_lighting_conditions, m_white);
+    }
 }
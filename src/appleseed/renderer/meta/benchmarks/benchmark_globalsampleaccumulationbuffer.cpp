@@ -0,0 +1,128 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/globalsampleaccumulationbuffer.h"
+#include "renderer/kernel/rendering/sample.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/benchmark.h"
+#include "foundation/utility/job/abortswitch.h"
+
+// Boost headers.
+#include "boost/thread/thread.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+BENCHMARK_SUITE(Renderer_Kernel_Rendering_GlobalSampleAccumulationBuffer)
+{
+    const size_t Width = 512;
+    const size_t Height = 512;
+    const size_t SamplesPerThread = 16 * 1024;
+
+    template <size_t ThreadCount, size_t StripeCount>
+    struct Fixture
+    {
+        GlobalSampleAccumulationBuffer  m_buffer;
+        std::vector<Sample>             m_samples;
+        AbortSwitch                     m_abort_switch;
+
+        Fixture()
+          : m_buffer(Width, Height, StripeCount)
+          , m_samples(ThreadCount * SamplesPerThread)
+        {
+            m_buffer.clear();
+
+            MersenneTwister rng;
+
+            for (Sample& sample : m_samples)
+            {
+                sample.m_pixel_coords.x = rand_int1(rng, 0, static_cast<std::int32_t>(Width - 1));
+                sample.m_pixel_coords.y = rand_int1(rng, 0, static_cast<std::int32_t>(Height - 1));
+                sample.m_color = Color4f(0.5f);
+            }
+        }
+
+        void store_samples()
+        {
+            boost::thread_group threads;
+
+            for (size_t i = 0; i < ThreadCount; ++i)
+            {
+                const Sample* samples = &m_samples[i * SamplesPerThread];
+                threads.create_thread(
+                    [this, samples]()
+                    {
+                        m_buffer.store_samples(SamplesPerThread, samples, m_abort_switch);
+                    });
+            }
+
+            threads.join_all();
+        }
+    };
+
+    typedef Fixture<1, 1> Fixture_1Threads_1Stripes;
+    typedef Fixture<16, 1> Fixture_16Threads_1Stripes;
+    typedef Fixture<16, 16> Fixture_16Threads_16Stripes;
+    typedef Fixture<128, 1> Fixture_128Threads_1Stripes;
+    typedef Fixture<128, 16> Fixture_128Threads_16Stripes;
+
+    BENCHMARK_CASE_F(StoreSamples_1Thread_1Stripe, Fixture_1Threads_1Stripes)
+    {
+        store_samples();
+    }
+
+    BENCHMARK_CASE_F(StoreSamples_16Threads_1Stripe, Fixture_16Threads_1Stripes)
+    {
+        store_samples();
+    }
+
+    BENCHMARK_CASE_F(StoreSamples_16Threads_16Stripes, Fixture_16Threads_16Stripes)
+    {
+        store_samples();
+    }
+
+    BENCHMARK_CASE_F(StoreSamples_128Threads_1Stripe, Fixture_128Threads_1Stripes)
+    {
+        store_samples();
+    }
+
+    BENCHMARK_CASE_F(StoreSamples_128Threads_16Stripes, Fixture_128Threads_16Stripes)
+    {
+        store_samples();
+    }
+}
@@ -0,0 +1,324 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/intersection/tracecontext.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/triangle.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/visibilityflags.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/containers/dictionary.h"
+#include "foundation/math/basis.h"
+#include "foundation/math/matrix.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/utility/benchmark.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+BENCHMARK_SUITE(Renderer_Kernel_Shading_ShadingPoint)
+{
+    struct TestScene
+      : public TestSceneBase
+    {
+        TestScene()
+        {
+            auto_release_ptr<Assembly> assembly(
+                AssemblyFactory().create("assembly", ParamArray()));
+
+            auto_release_ptr<MeshObject> mesh_object(
+                MeshObjectFactory().create("plane", ParamArray()));
+
+            mesh_object->push_vertex(GVector3(0.0f, -0.5f, -0.5f));
+            mesh_object->push_vertex(GVector3(0.0f, +0.5f, -0.5f));
+            mesh_object->push_vertex(GVector3(0.0f, +0.5f, +0.5f));
+            mesh_object->push_vertex(GVector3(0.0f, -0.5f, +0.5f));
+
+            mesh_object->push_vertex_normal(GVector3(-1.0f, 0.0f, 0.0f));
+
+            mesh_object->push_tex_coords(GVector2(0.0f, 0.0f));
+            mesh_object->push_tex_coords(GVector2(1.0f, 0.0f));
+            mesh_object->push_tex_coords(GVector2(1.0f, 1.0f));
+            mesh_object->push_tex_coords(GVector2(0.0f, 1.0f));
+
+            mesh_object->push_triangle(Triangle(0, 1, 2, 0, 0, 0, 0, 1, 2, 0));
+            mesh_object->push_triangle(Triangle(2, 3, 0, 0, 0, 0, 2, 3, 0, 0));
+
+            assembly->objects().insert(auto_release_ptr<Object>(mesh_object.release()));
+
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "plane_inst",
+                    ParamArray(),
+                    "plane",
+                    Transformd::from_local_to_parent(
+                        Matrix4d::make_translation(Vector3d(2.0, 0.0, 0.0))),
+                    StringDictionary()));
+
+            m_scene.assembly_instances().insert(
+                AssemblyInstanceFactory::create(
+                    "assembly_inst",
+                    ParamArray(),
+                    "assembly"));
+
+            m_scene.assemblies().insert(assembly);
+        }
+    };
+
+    struct Fixture
+      : public StaticTestSceneContext<TestScene>
+    {
+        TraceContext    m_trace_context;
+        TextureStore    m_texture_store;
+        TextureCache    m_texture_cache;
+        Intersector     m_intersector;
+        ShadingRay      m_ray;
+        ShadingPoint    m_hit;
+        double          m_dummy;
+
+        Fixture()
+          : m_trace_context(m_scene)
+          , m_texture_store(m_scene)
+          , m_texture_cache(m_texture_store)
+          , m_intersector(m_trace_context, m_texture_cache)
+          , m_ray(
+                Vector3d(0.0, 0.1, 0.2),
+                Vector3d(1.0, 0.0, 0.0),
+                0.0,                            // tmin
+                10.0,                           // tmax
+                ShadingRay::Time(),
+                VisibilityFlags::CameraRay,
+                0)                              // depth
+          , m_dummy(0.0)
+        {
+            m_trace_context.update();
+            m_intersector.trace(m_ray, m_hit);
+        }
+
+        void refine(const ShadingPoint& shading_point)
+        {
+            m_dummy += shading_point.get_point()[0];
+            m_dummy += shading_point.get_geometric_normal()[0];
+            m_dummy += shading_point.get_shading_basis().get_normal()[0];
+            m_dummy += shading_point.get_uv(0)[0];
+        }
+    };
+
+    BENCHMARK_CASE_F(Construct, Fixture)
+    {
+        ShadingPoint shading_point;
+        m_dummy += static_cast<double>(shading_point.is_valid());
+    }
+
+    BENCHMARK_CASE_F(Copy, Fixture)
+    {
+        const ShadingPoint shading_point(m_hit);
+        m_dummy += static_cast<double>(shading_point.get_primitive_index());
+    }
+
+    BENCHMARK_CASE_F(Trace, Fixture)
+    {
+        ShadingPoint shading_point;
+        m_intersector.trace(m_ray, shading_point);
+        m_dummy += static_cast<double>(shading_point.is_valid());
+    }
+
+    BENCHMARK_CASE_F(TraceAndRefine, Fixture)
+    {
+        ShadingPoint shading_point;
+        m_intersector.trace(m_ray, shading_point);
+        refine(shading_point);
+    }
+
+    BENCHMARK_CASE_F(TraceAndComputeDerivatives, Fixture)
+    {
+        ShadingPoint shading_point;
+        m_intersector.trace(m_ray, shading_point);
+        refine(shading_point);
+        m_dummy += shading_point.get_dpdu(0)[0];
+        m_dummy += shading_point.get_dndu(0)[0];
+    }
+}
+
+BENCHMARK_SUITE(Renderer_Kernel_Shading_ShadingPoint_LargeMesh)
+{
+    // A finely tessellated plane whose attributes don't fit in the caches.
+    template <bool InterleavedShadingData>
+    struct TestScene
+      : public TestSceneBase
+    {
+        static const size_t GridSize = 256;
+
+        TestScene()
+        {
+            auto_release_ptr<Assembly> assembly(
+                AssemblyFactory().create("assembly", ParamArray()));
+
+            auto_release_ptr<MeshObject> mesh_object(
+                MeshObjectFactory().create(
+                    "grid",
+                    ParamArray().insert("interleaved_shading_data", InterleavedShadingData)));
+
+            for (size_t j = 0; j <= GridSize; ++j)
+            {
+                for (size_t i = 0; i <= GridSize; ++i)
+                {
+                    const GScalar u = static_cast<GScalar>(i) / GridSize;
+                    const GScalar v = static_cast<GScalar>(j) / GridSize;
+
+                    mesh_object->push_vertex(GVector3(0.0f, u - 0.5f, v - 0.5f));
+                    mesh_object->push_vertex_normal(normalize(GVector3(-1.0f, 0.1f * u, 0.1f * v)));
+                    mesh_object->push_vertex_tangent(GVector3(0.0f, 1.0f, 0.0f));
+                    mesh_object->push_tex_coords(GVector2(u, v));
+                }
+            }
+
+            for (size_t j = 0; j < GridSize; ++j)
+            {
+                for (size_t i = 0; i < GridSize; ++i)
+                {
+                    const size_t v0 = j * (GridSize + 1) + i;
+                    const size_t v1 = v0 + 1;
+                    const size_t v2 = v1 + GridSize + 1;
+                    const size_t v3 = v0 + GridSize + 1;
+
+                    mesh_object->push_triangle(Triangle(v0, v1, v2, v0, v1, v2, v0, v1, v2, 0));
+                    mesh_object->push_triangle(Triangle(v2, v3, v0, v2, v3, v0, v2, v3, v0, 0));
+                }
+            }
+
+            assembly->objects().insert(auto_release_ptr<Object>(mesh_object.release()));
+
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "grid_inst",
+                    ParamArray(),
+                    "grid",
+                    Transformd::identity(),
+                    StringDictionary()));
+
+            m_scene.assembly_instances().insert(
+                AssemblyInstanceFactory::create(
+                    "assembly_inst",
+                    ParamArray(),
+                    "assembly"));
+
+            m_scene.assemblies().insert(assembly);
+        }
+    };
+
+    template <bool InterleavedShadingData>
+    struct Fixture
+      : public StaticTestSceneContext<TestScene<InterleavedShadingData>>
+    {
+        static const size_t HitCount = 4096;
+
+        TraceContext                m_trace_context;
+        TextureStore                m_texture_store;
+        TextureCache                m_texture_cache;
+        Intersector                 m_intersector;
+        std::vector<ShadingPoint>   m_hits;
+        double                      m_dummy;
+
+        Fixture()
+          : m_trace_context(this->m_scene)
+          , m_texture_store(this->m_scene)
+          , m_texture_cache(m_texture_store)
+          , m_intersector(m_trace_context, m_texture_cache)
+          , m_hits(HitCount)
+          , m_dummy(0.0)
+        {
+            m_trace_context.update();
+
+            // Hit the plane at random locations, as incoherent secondary rays would.
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < HitCount; ++i)
+            {
+                const ShadingRay ray(
+                    Vector3d(-1.0, rand_double2(rng) - 0.5, rand_double2(rng) - 0.5),
+                    Vector3d(1.0, 0.0, 0.0),
+                    0.0,                            // tmin
+                    10.0,                           // tmax
+                    ShadingRay::Time(),
+                    VisibilityFlags::CameraRay,
+                    0);                             // depth
+
+                m_intersector.trace(ray, m_hits[i]);
+            }
+        }
+
+        // Construct and refine a shading point for each hit.
+        void refine_all()
+        {
+            for (size_t i = 0; i < HitCount; ++i)
+            {
+                const ShadingPoint shading_point(m_hits[i]);
+                m_dummy += shading_point.get_point()[0];
+                m_dummy += shading_point.get_shading_basis().get_normal()[0];
+                m_dummy += shading_point.get_uv(0)[0];
+            }
+        }
+    };
+
+    typedef Fixture<false> SeparateArraysFixture;
+    typedef Fixture<true> InterleavedShadingDataFixture;
+
+    BENCHMARK_CASE_F(Refine_SeparateArrays, SeparateArraysFixture)
+    {
+        refine_all();
+    }
+
+    BENCHMARK_CASE_F(Refine_InterleavedShadingData, InterleavedShadingDataFixture)
+    {
+        refine_all();
+    }
+}
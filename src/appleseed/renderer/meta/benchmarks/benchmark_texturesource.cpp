@@ -0,0 +1,172 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/input/source.h"
+#include "renderer/modeling/input/sourceinputs.h"
+#include "renderer/modeling/input/texturesource.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/textureinstance.h"
+#include "renderer/modeling/texture/memorytexture2d.h"
+#include "renderer/modeling/texture/texture.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/utility/benchmark.h"
+#include "foundation/utility/uid.h"
+
+// Standard headers.
+#include <cstddef>
+#include <memory>
+
+using namespace foundation;
+using namespace renderer;
+
+BENCHMARK_SUITE(Renderer_Modeling_Input_TextureSource)
+{
+    // A 1024x1024 texture stored in 32x32 tiles, much larger than the texture cache.
+    struct TestScene
+      : public TestSceneBase
+    {
+        static const size_t TextureSize = 1024;
+        static const size_t TileSize = 32;
+
+        TestScene()
+        {
+            auto_release_ptr<Image> image(
+                new Image(TextureSize, TextureSize, TileSize, TileSize, 3, PixelFormatFloat));
+
+            for (size_t y = 0; y < TextureSize; ++y)
+            {
+                for (size_t x = 0; x < TextureSize; ++x)
+                {
+                    image->set_pixel(
+                        x, y,
+                        Color3f(
+                            static_cast<float>(x) / TextureSize,
+                            static_cast<float>(y) / TextureSize,
+                            0.5f));
+                }
+            }
+
+            m_scene.textures().insert(
+                MemoryTexture2dFactory().create(
+                    "texture",
+                    ParamArray().insert("color_space", "linear_rgb"),
+                    image));
+
+            create_texture_instance("texture_inst", "texture");
+        }
+    };
+
+    struct Fixture
+      : public StaticTestSceneContext<TestScene>
+    {
+        static const size_t LookupCount = 64;
+
+        TextureStore                    m_texture_store;
+        TextureCache                    m_texture_cache;
+        std::unique_ptr<TextureSource>  m_source;
+        MersenneTwister                 m_rng;
+        Vector2f                        m_uv;
+        Vector2f                        m_uvs[LookupCount];
+        Color4f                         m_colors[LookupCount];
+        float                           m_dummy;
+
+        Fixture()
+          : m_texture_store(m_scene)
+          , m_texture_cache(m_texture_store)
+          , m_uv(0.0f)
+          , m_dummy(0.0f)
+        {
+            const TextureInstance& texture_instance =
+                *m_scene.texture_instances().get_by_name("texture_inst");
+
+            m_source.reset(
+                static_cast<TextureSource*>(
+                    texture_instance.get_texture().create_source(
+                        ~UniqueID(0),           // the parent is the scene, not an assembly
+                        texture_instance)));
+        }
+
+        void evaluate(const Vector2f& uv)
+        {
+            Color3f color;
+            m_source->evaluate(m_texture_cache, SourceInputs(uv), color);
+            m_dummy += color[0];
+        }
+    };
+
+    // Lookups walking slowly across the texture, as neighboring camera rays would.
+    BENCHMARK_CASE_F(Evaluate_CoherentLookups, Fixture)
+    {
+        m_uv.x += 0.0005f;
+        if (m_uv.x >= 1.0f)
+        {
+            m_uv.x = 0.0f;
+            m_uv.y += 0.01f;
+            if (m_uv.y >= 1.0f)
+                m_uv.y = 0.0f;
+        }
+
+        evaluate(m_uv);
+    }
+
+    // Lookups at random locations, as from incoherent secondary rays.
+    BENCHMARK_CASE_F(Evaluate_IncoherentLookups, Fixture)
+    {
+        evaluate(Vector2f(rand_float2(m_rng), rand_float2(m_rng)));
+    }
+
+    // A batch of lookups clustered in a small region, sharing texture cache accesses.
+    BENCHMARK_CASE_F(SampleTexture_ClusteredLookups, Fixture)
+    {
+        const Vector2f center(rand_float2(m_rng), rand_float2(m_rng));
+
+        for (size_t i = 0; i < LookupCount; ++i)
+        {
+            m_uvs[i].x = center.x + 0.01f * rand_float2(m_rng);
+            m_uvs[i].y = center.y + 0.01f * rand_float2(m_rng);
+        }
+
+        m_source->sample_texture(m_texture_cache, m_uvs, LookupCount, m_colors);
+        m_dummy += m_colors[0][0];
+    }
+}
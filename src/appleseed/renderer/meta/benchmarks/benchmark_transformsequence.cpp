@@ -38,6 +38,9 @@
 #include "foundation/math/vector.h"
 #include "foundation/utility/benchmark.h"
 
+// Standard headers.
+#include <cstddef>
+
 using namespace foundation;
 using namespace renderer;
 
@@ -71,4 +74,77 @@ BENCHMARK_SUITE(Renderer_Utility_TransformSequence)
     {
         m_motion_bbox = m_sequence.to_parent(m_bbox);
     }
+
+    // Simulate the traversal of a set of deformation-blurred assembly instances:
+    // every ray of a path has its own time and enters each instance in turn.
+    struct MotionBlurFixture
+    {
+        static const size_t InstanceCount = 8;
+        static const size_t KeyCount = 16;
+        static const size_t RaysPerPath = 8;
+
+        TransformSequence       m_sequences[InstanceCount];
+        TransformSequenceCache  m_cache;
+        float                   m_time;
+        Vector3d                m_point;
+
+        MotionBlurFixture()
+          : m_time(0.0f)
+          , m_point(0.0)
+        {
+            for (size_t i = 0; i < InstanceCount; ++i)
+            {
+                const Vector3d axis = normalize(Vector3d(0.1 * i, 0.2, 1.0));
+
+                for (size_t j = 0; j < KeyCount; ++j)
+                {
+                    const double t = static_cast<double>(j) / (KeyCount - 1);
+                    m_sequences[i].set_transform(
+                        static_cast<float>(t),
+                        Transformd::from_local_to_parent(
+                            Matrix4d::make_translation(Vector3d(t, 2.0 * t, 0.0)) *
+                            Matrix4d::make_rotation(axis, t * Pi<double>()) *
+                            Matrix4d::make_scaling(Vector3d(1.0 + t))));
+                }
+
+                m_sequences[i].prepare();
+            }
+        }
+
+        void next_path()
+        {
+            m_time += 0.618034f;
+            if (m_time >= 1.0f)
+                m_time -= 1.0f;
+        }
+    };
+
+    BENCHMARK_CASE_F(TraverseMotionBlurredInstances_Uncached, MotionBlurFixture)
+    {
+        next_path();
+
+        for (size_t r = 0; r < RaysPerPath; ++r)
+        {
+            for (size_t i = 0; i < InstanceCount; ++i)
+            {
+                Transformd scratch;
+                const Transformd& xform = m_sequences[i].evaluate(m_time, scratch);
+                m_point += xform.point_to_local(Vector3d(1.0, 2.0, 3.0));
+            }
+        }
+    }
+
+    BENCHMARK_CASE_F(TraverseMotionBlurredInstances_Cached, MotionBlurFixture)
+    {
+        next_path();
+
+        for (size_t r = 0; r < RaysPerPath; ++r)
+        {
+            for (size_t i = 0; i < InstanceCount; ++i)
+            {
+                const Transformd& xform = m_cache.evaluate(m_sequences[i], m_time);
+                m_point += xform.point_to_local(Vector3d(1.0, 2.0, 3.0));
+            }
+        }
+    }
 }
@@ -119,4 +119,33 @@ TEST_SUITE(Renderer_Modeling_Scene_Assembly)
 
         EXPECT_EQ(GAABB3::invalid(), local_bbox);
     }
+
+    TEST_CASE(Merge_MovesEntitiesBuiltInStagingAssembly)
+    {
+        auto_release_ptr<Assembly> assembly(AssemblyFactory().create("assembly", ParamArray()));
+        assembly->objects().insert(
+            auto_release_ptr<Object>(
+                new BoundingBoxObject("object1", GAABB3(GVector3(-1.0), GVector3(1.0)))));
+
+        auto_release_ptr<Assembly> staging(AssemblyFactory().create("staging", ParamArray()));
+        staging->objects().insert(
+            auto_release_ptr<Object>(
+                new BoundingBoxObject("object2", GAABB3(GVector3(-2.0), GVector3(2.0)))));
+        staging->object_instances().insert(
+            ObjectInstanceFactory::create(
+                "object2_inst",
+                ParamArray(),
+                "object2",
+                Transformd::identity(),
+                StringDictionary()));
+
+        assembly->merge(staging.ref());
+
+        EXPECT_TRUE(staging->objects().empty());
+        EXPECT_TRUE(staging->object_instances().empty());
+        ASSERT_EQ(2, assembly->objects().size());
+        ASSERT_EQ(1, assembly->object_instances().size());
+        EXPECT_EQ(assembly.get(), assembly->objects().get_by_name("object2")->get_parent());
+        EXPECT_EQ(assembly.get(), assembly->object_instances().get_by_name("object2_inst")->get_parent());
+    }
 }
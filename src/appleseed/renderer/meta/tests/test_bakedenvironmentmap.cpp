@@ -0,0 +1,91 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/modeling/environmentedf/bakedenvironmentmap.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/regularspectrum.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Modeling_EnvironmentEDF_BakedEnvironmentMap)
+{
+    struct Fixture
+    {
+        BakedEnvironmentMap m_map;
+
+        Fixture()
+          : m_map(8, 4)
+        {
+            for (size_t y = 0; y < m_map.get_height(); ++y)
+            {
+                for (size_t x = 0; x < m_map.get_width(); ++x)
+                    m_map.texel(x, y).set(static_cast<float>(x + 1));
+            }
+
+            m_map.prepare();
+        }
+    };
+
+    TEST_CASE_F(Sample_ReturnsRadianceAndPDFConsistentWithEvaluate, Fixture)
+    {
+        for (size_t i = 0; i < 16; ++i)
+        {
+            const Vector2f s(
+                (static_cast<float>(i % 4) + 0.5f) / 4.0f,
+                (static_cast<float>(i / 4) + 0.5f) / 4.0f);
+
+            Vector3f outgoing;
+            RegularSpectrum31f radiance;
+            float probability;
+            m_map.sample(s, outgoing, radiance, probability);
+
+            RegularSpectrum31f expected_radiance;
+            m_map.evaluate(outgoing, expected_radiance);
+
+            EXPECT_FEQ_EPS(1.0f, norm(outgoing), 1.0e-4f);
+            EXPECT_EQ(expected_radiance[0], radiance[0]);
+            EXPECT_FEQ_EPS(probability, m_map.evaluate_pdf(outgoing), 1.0e-3f * probability);
+        }
+    }
+
+    TEST_CASE_F(Evaluate_GivenTexelDirection_ReturnsTexelRadiance, Fixture)
+    {
+        RegularSpectrum31f radiance;
+        m_map.evaluate(m_map.get_texel_direction(5, 2), radiance);
+
+        EXPECT_EQ(6.0f, radiance[0]);
+    }
+}
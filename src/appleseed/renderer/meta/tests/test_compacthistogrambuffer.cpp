@@ -0,0 +1,106 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/denoising/compacthistogrambuffer.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Denoising_CompactHistogramBuffer)
+{
+    TEST_CASE(Resize_ClearsBinsAndSampleCounts)
+    {
+        CompactHistogramBuffer buffer;
+        buffer.resize(2, 2, 4);
+
+        float bins[4];
+        buffer.get_bins(1, 1, bins);
+
+        EXPECT_EQ(0.0f, bins[0]);
+        EXPECT_EQ(0.0f, bins[3]);
+        EXPECT_EQ(0.0f, buffer.get_sample_count(1, 1));
+    }
+
+    TEST_CASE(Add_AccumulatesBinsAndSampleCounts)
+    {
+        CompactHistogramBuffer buffer;
+        buffer.resize(2, 2, 4);
+
+        const float bins1[4] = { 1.0f, 0.5f, 0.0f, 2.0f };
+        const float bins2[4] = { 3.0f, 0.25f, 0.0f, 1.0f };
+        buffer.add(1, 0, bins1, 2.0f);
+        buffer.add(1, 0, bins2, 3.0f);
+
+        float bins[4];
+        buffer.get_bins(1, 0, bins);
+
+        EXPECT_FEQ_EPS(4.0f, bins[0], 1.0e-3f);
+        EXPECT_FEQ_EPS(0.75f, bins[1], 1.0e-3f);
+        EXPECT_EQ(0.0f, bins[2]);
+        EXPECT_FEQ_EPS(3.0f, bins[3], 1.0e-3f);
+        EXPECT_EQ(5.0f, buffer.get_sample_count(1, 0));
+    }
+
+    TEST_CASE(Add_DoesNotAffectOtherPixels)
+    {
+        CompactHistogramBuffer buffer;
+        buffer.resize(2, 2, 4);
+
+        const float bins1[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        buffer.add(0, 1, bins1, 1.0f);
+
+        float bins[4];
+        buffer.get_bins(1, 1, bins);
+
+        EXPECT_EQ(0.0f, bins[0]);
+        EXPECT_EQ(0.0f, buffer.get_sample_count(1, 1));
+    }
+
+    TEST_CASE(Set_PreservesLargestBinExactly)
+    {
+        CompactHistogramBuffer buffer;
+        buffer.resize(1, 1, 3);
+
+        const float bins1[3] = { 1000.0f, 0.1f, 37.0f };
+        buffer.set(0, 0, bins1, 1000.0f);
+
+        float bins[3];
+        buffer.get_bins(0, 0, bins);
+
+        EXPECT_FEQ(1000.0f, bins[0]);
+        EXPECT_FEQ_EPS(0.1f, bins[1], 1000.0f / 65535.0f);
+        EXPECT_FEQ_EPS(37.0f, bins[2], 1000.0f / 65535.0f);
+    }
+}
@@ -0,0 +1,166 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/texturing/compressedtilecache.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Texturing_CompressedTileCache)
+{
+    struct IntHasher
+    {
+        size_t operator()(const int key) const
+        {
+            return static_cast<size_t>(key);
+        }
+    };
+
+    typedef CompressedTileCache<int, IntHasher> CacheType;
+
+    // Return a float tile with smooth content, which compresses well.
+    std::unique_ptr<Tile> make_tile(const float value)
+    {
+        std::unique_ptr<Tile> tile(new Tile(32, 32, 3, PixelFormatFloat));
+
+        for (size_t y = 0; y < 32; ++y)
+        {
+            for (size_t x = 0; x < 32; ++x)
+                tile->set_pixel(x, y, Color3f(value, value, x < 16 ? value : 0.0f));
+        }
+
+        return tile;
+    }
+
+    bool tiles_equal(const Tile& lhs, const Tile& rhs)
+    {
+        if (lhs.get_width() != rhs.get_width() ||
+            lhs.get_height() != rhs.get_height() ||
+            lhs.get_channel_count() != rhs.get_channel_count() ||
+            lhs.get_pixel_format() != rhs.get_pixel_format())
+            return false;
+
+        const std::uint8_t* lhs_bytes = lhs.get_storage();
+        const std::uint8_t* rhs_bytes = rhs.get_storage();
+
+        for (size_t i = 0, e = lhs.get_size(); i < e; ++i)
+        {
+            if (lhs_bytes[i] != rhs_bytes[i])
+                return false;
+        }
+
+        return true;
+    }
+
+    TEST_CASE(CompressedTile_CompressThenDecompress_ReturnsIdenticalTile)
+    {
+        const std::unique_ptr<Tile> tile = make_tile(0.5f);
+
+        std::vector<std::uint8_t> scratch;
+        CompressedTile compressed_tile;
+        ASSERT_TRUE(compressed_tile.compress(*tile, scratch));
+        EXPECT_LT(tile->get_size(), compressed_tile.get_memory_size());
+
+        const std::unique_ptr<Tile> decompressed_tile(compressed_tile.decompress(scratch));
+        EXPECT_TRUE(tiles_equal(*tile, *decompressed_tile));
+    }
+
+    TEST_CASE(Extract_GivenInsertedTile_ReturnsIdenticalTileAndRemovesIt)
+    {
+        IntHasher hasher;
+        CacheType cache(hasher, 1024 * 1024);
+
+        const std::unique_ptr<Tile> tile = make_tile(0.5f);
+        cache.insert(7, *tile);
+        EXPECT_EQ(1, cache.get_tile_count());
+
+        const std::unique_ptr<Tile> extracted_tile(cache.extract(7));
+        ASSERT_TRUE(extracted_tile != nullptr);
+        EXPECT_TRUE(tiles_equal(*tile, *extracted_tile));
+        EXPECT_EQ(0, cache.get_tile_count());
+        EXPECT_EQ(0, cache.get_memory_size());
+        EXPECT_EQ(1, cache.get_hit_count());
+    }
+
+    TEST_CASE(Extract_GivenUnknownKey_ReturnsNull)
+    {
+        IntHasher hasher;
+        CacheType cache(hasher, 1024 * 1024);
+
+        EXPECT_TRUE(cache.extract(7) == nullptr);
+        EXPECT_EQ(1, cache.get_miss_count());
+    }
+
+    TEST_CASE(Insert_GivenFullCache_DiscardsOldestTiles)
+    {
+        const std::unique_ptr<Tile> tile = make_tile(0.5f);
+
+        std::vector<std::uint8_t> scratch;
+        CompressedTile compressed_tile;
+        ASSERT_TRUE(compressed_tile.compress(*tile, scratch));
+
+        // Leave room for two compressed tiles only.
+        IntHasher hasher;
+        CacheType cache(hasher, 2 * compressed_tile.get_memory_size());
+
+        cache.insert(1, *tile);
+        cache.insert(2, *tile);
+        cache.insert(3, *tile);
+
+        EXPECT_EQ(2, cache.get_tile_count());
+        EXPECT_TRUE(std::unique_ptr<Tile>(cache.extract(1)) == nullptr);
+        EXPECT_TRUE(std::unique_ptr<Tile>(cache.extract(3)) != nullptr);
+    }
+
+    TEST_CASE(Insert_GivenIncompressibleTile_RejectsIt)
+    {
+        // A single pixel cannot shrink.
+        Tile tile(1, 1, 1, PixelFormatUInt8);
+        tile.set_component(0, 0, 0, std::uint8_t(42));
+
+        IntHasher hasher;
+        CacheType cache(hasher, 1024 * 1024);
+        cache.insert(1, tile);
+
+        EXPECT_EQ(0, cache.get_tile_count());
+        EXPECT_EQ(1, cache.get_rejected_count());
+    }
+}
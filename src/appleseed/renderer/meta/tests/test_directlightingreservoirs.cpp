@@ -0,0 +1,125 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/directlightingreservoirs.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_DirectLightingReservoirs)
+{
+    DirectLightingReservoirs::Parameters make_params()
+    {
+        DirectLightingReservoirs::Parameters params;
+        params.m_candidate_count = 16;
+        params.m_spatial_reuse_count = 3;
+        params.m_spatial_reuse_radius = 16.0f;
+        params.m_max_history = 20.0f;
+        return params;
+    }
+
+    DirectLightingReservoir make_reservoir(const float weight)
+    {
+        DirectLightingReservoir reservoir;
+        reservoir.m_shape = reinterpret_cast<const EmittingShape*>(&reservoir);     // only compared to nullptr
+        reservoir.m_param_coords = Vector2f(0.0f);
+        reservoir.m_point = Vector3f(0.0f);
+        reservoir.m_shading_normal = Vector3f(0.0f, 1.0f, 0.0f);
+        reservoir.m_geometric_normal = Vector3f(0.0f, 1.0f, 0.0f);
+        reservoir.m_weight = weight;
+        reservoir.m_sample_count = 16.0f;
+        reservoir.m_surface_point = Vector3f(0.0f);
+        reservoir.m_surface_normal = Vector3f(0.0f, 1.0f, 0.0f);
+        reservoir.m_surface_distance = 1.0f;
+        reservoir.m_surface_two_sided = false;
+        return reservoir;
+    }
+
+    TEST_CASE(GetPrevious_BeforeUpdate_ReturnsNull)
+    {
+        DirectLightingReservoirs reservoirs(4, 3, make_params());
+
+        reservoirs.set_current(1, 2, make_reservoir(1.0f));
+
+        EXPECT_EQ(nullptr, reservoirs.get_previous(1, 2));
+    }
+
+    TEST_CASE(GetPrevious_AfterUpdate_ReturnsStoredReservoir)
+    {
+        DirectLightingReservoirs reservoirs(4, 3, make_params());
+
+        reservoirs.set_current(1, 2, make_reservoir(2.0f));
+        reservoirs.update();
+
+        const DirectLightingReservoir* reservoir = reservoirs.get_previous(1, 2);
+        ASSERT_NEQ(nullptr, reservoir);
+        EXPECT_EQ(2.0f, reservoir->m_weight);
+        EXPECT_EQ(nullptr, reservoirs.get_previous(2, 1));
+    }
+
+    TEST_CASE(GetPrevious_AfterTwoUpdates_ReturnsNull)
+    {
+        DirectLightingReservoirs reservoirs(4, 3, make_params());
+
+        reservoirs.set_current(1, 2, make_reservoir(1.0f));
+        reservoirs.update();
+        reservoirs.update();
+
+        EXPECT_EQ(nullptr, reservoirs.get_previous(1, 2));
+    }
+
+    TEST_CASE(GetPrevious_GivenPixelOutsideBuffers_ReturnsNull)
+    {
+        DirectLightingReservoirs reservoirs(4, 3, make_params());
+
+        EXPECT_EQ(nullptr, reservoirs.get_previous(-1, 0));
+        EXPECT_EQ(nullptr, reservoirs.get_previous(0, -1));
+        EXPECT_EQ(nullptr, reservoirs.get_previous(4, 0));
+        EXPECT_EQ(nullptr, reservoirs.get_previous(0, 3));
+    }
+
+    TEST_CASE(Clear_DiscardsAllReservoirs)
+    {
+        DirectLightingReservoirs reservoirs(4, 3, make_params());
+
+        reservoirs.set_current(0, 0, make_reservoir(1.0f));
+        reservoirs.update();
+        reservoirs.set_current(0, 0, make_reservoir(1.0f));
+        reservoirs.clear();
+        reservoirs.update();
+
+        EXPECT_EQ(nullptr, reservoirs.get_previous(0, 0));
+    }
+}
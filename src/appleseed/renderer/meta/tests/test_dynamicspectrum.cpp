@@ -32,6 +32,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/image/color.h"
+#include "foundation/image/colorspace.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
@@ -73,6 +74,45 @@ TEST_SUITE(Renderer_Utility_DynamicSpectrum31f)
         }
     };
 
+    struct HeroWavelengthFixture
+    {
+        const DynamicSpectrum31f::Mode m_old_mode;
+
+        HeroWavelengthFixture()
+          : m_old_mode(DynamicSpectrum31f::set_mode(DynamicSpectrum31f::HeroWavelength))
+        {
+        }
+
+        ~HeroWavelengthFixture()
+        {
+            DynamicSpectrum31f::set_mode(m_old_mode);
+        }
+    };
+
+    TEST_CASE_F(CopyConstructor_RGB, RGBFixture)
+    {
+        static const float Values[3] = { 1.0f, 2.0f, 3.0f };
+
+        const auto a(DynamicSpectrum31f::from_array(Values));
+        const DynamicSpectrum31f b(a);
+
+        EXPECT_EQ(a, b);
+    }
+
+    TEST_CASE_F(Assignment_Spectral, SpectralFixture)
+    {
+        float values[31];
+
+        for (size_t i = 0; i < 31; ++i)
+            values[i] = static_cast<float>(i + 1);
+
+        DynamicSpectrum31f b(0.0f);
+        b = DynamicSpectrum31f::from_array(values);
+
+        for (size_t i = 0; i < 31; ++i)
+            EXPECT_EQ(values[i], b[i]);
+    }
+
     TEST_CASE_F(Lerp_Spectral, SpectralFixture)
     {
         static const float AValues[31] =
@@ -208,4 +248,70 @@ TEST_SUITE(Renderer_Utility_DynamicSpectrum31f)
         for (size_t i = 0, e = x.size(); i < e; ++i)
             EXPECT_FEQ(std::sqrt(Values[i]), result[i]);
     }
+
+    TEST_CASE_F(SelectBandBlock_HeroWavelength, HeroWavelengthFixture)
+    {
+        DynamicSpectrum31f::select_band_block(0.0f);
+        EXPECT_EQ(0, DynamicSpectrum31f::get_band_offset());
+        EXPECT_EQ(4, DynamicSpectrum31f::size());
+
+        DynamicSpectrum31f::select_band_block(0.5f);
+        EXPECT_EQ(16, DynamicSpectrum31f::get_band_offset());
+        EXPECT_EQ(4, DynamicSpectrum31f::size());
+
+        DynamicSpectrum31f::select_band_block(0.99f);
+        EXPECT_EQ(28, DynamicSpectrum31f::get_band_offset());
+        EXPECT_EQ(3, DynamicSpectrum31f::size());
+
+        EXPECT_EQ(8.0f, DynamicSpectrum31f::get_band_weight());
+    }
+
+    TEST_CASE_F(MultiplyInPlace_HeroWavelength_OnlyModifiesActiveBands, HeroWavelengthFixture)
+    {
+        float values[31];
+
+        for (size_t i = 0; i < 31; ++i)
+            values[i] = static_cast<float>(i + 1);
+
+        DynamicSpectrum31f::set_mode(DynamicSpectrum31f::Spectral);
+        auto s(DynamicSpectrum31f::from_array(values));
+
+        DynamicSpectrum31f::set_mode(DynamicSpectrum31f::HeroWavelength);
+        DynamicSpectrum31f::select_band_block(0.3f);
+        s *= 2.0f;
+
+        DynamicSpectrum31f::set_mode(DynamicSpectrum31f::Spectral);
+
+        for (size_t i = 0; i < 31; ++i)
+            EXPECT_EQ(i >= 8 && i < 12 ? 2.0f * values[i] : values[i], s[i]);
+    }
+
+    TEST_CASE_F(ToCIEXYZ_HeroWavelength_AverageOverBandBlocksMatchesSpectral, HeroWavelengthFixture)
+    {
+        const LightingConditions lighting_conditions(IlluminantCIED65, XYZCMFCIE19312Deg);
+
+        float values[31];
+
+        for (size_t i = 0; i < 31; ++i)
+            values[i] = 0.5f + 0.01f * static_cast<float>(i);
+
+        DynamicSpectrum31f::set_mode(DynamicSpectrum31f::Spectral);
+        const auto s(DynamicSpectrum31f::from_array(values));
+        const Color3f expected = s.to_ciexyz(lighting_conditions);
+
+        DynamicSpectrum31f::set_mode(DynamicSpectrum31f::HeroWavelength);
+
+        Color3f average(0.0f);
+
+        for (size_t i = 0; i < DynamicSpectrum31f::BandBlockCount; ++i)
+        {
+            DynamicSpectrum31f::select_band_block(
+                static_cast<float>(i) / DynamicSpectrum31f::BandBlockCount);
+            average += s.to_ciexyz(lighting_conditions);
+        }
+
+        average /= static_cast<float>(DynamicSpectrum31f::BandBlockCount);
+
+        EXPECT_FEQ_EPS(expected, average, 1.0e-4f);
+    }
 }
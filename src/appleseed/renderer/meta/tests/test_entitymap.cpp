@@ -82,6 +82,24 @@ TEST_SUITE(Renderer_Modeling_Entity_EntityMap)
         EXPECT_EQ(parent2, m2.get_by_name("entity1")->get_parent());
     }
 
+    TEST_CASE(Merge_MovesEntitiesToThisContainerAndFixesParentPointers)
+    {
+        Entity* parent1 = (Entity*)0x123;
+        EntityMap m1(parent1);
+        m1.insert(auto_release_ptr<Entity>(new DummyEntity("entity1")));
+
+        Entity* parent2 = (Entity*)0x456;
+        EntityMap m2(parent2);
+        m2.insert(auto_release_ptr<Entity>(new DummyEntity("entity2")));
+
+        m1.merge(m2);
+
+        EXPECT_TRUE(m2.empty());
+        EXPECT_EQ(2, m1.size());
+        EXPECT_EQ(parent1, m1.get_by_name("entity2")->get_parent());
+        EXPECT_EQ(nullptr, m2.get_by_name("entity2"));
+    }
+
     TEST_CASE(Remove_GivenUID_RemovesEntity)
     {
         auto_release_ptr<Entity> entity(new DummyEntity("entity"));
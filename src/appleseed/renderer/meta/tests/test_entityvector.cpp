@@ -83,6 +83,27 @@ TEST_SUITE(Renderer_Modeling_Entity_EntityVector)
         EXPECT_EQ(parent2, v2.get_by_name("entity1")->get_parent());
     }
 
+    TEST_CASE(Merge_MovesEntitiesToThisContainerAndFixesParentPointers)
+    {
+        Entity* parent1 = (Entity*)0x123;
+        EntityVector v1(parent1);
+        v1.insert(auto_release_ptr<Entity>(new DummyEntity("entity1")));
+
+        Entity* parent2 = (Entity*)0x456;
+        EntityVector v2(parent2);
+        v2.insert(auto_release_ptr<Entity>(new DummyEntity("entity2")));
+        v2.insert(auto_release_ptr<Entity>(new DummyEntity("entity3")));
+
+        v1.merge(v2);
+
+        EXPECT_TRUE(v2.empty());
+        ASSERT_EQ(3, v1.size());
+        EXPECT_EQ(2, v1.get_index("entity3"));
+        EXPECT_EQ(parent1, v1.get_by_name("entity2")->get_parent());
+        EXPECT_EQ(parent1, v1.get_by_name("entity3")->get_parent());
+        EXPECT_EQ(~size_t(0), v2.get_index("entity2"));
+    }
+
     TEST_CASE(Remove_GivenOneItem_RemovesItem)
     {
         auto_release_ptr<Entity> entity(new DummyEntity("entity"));
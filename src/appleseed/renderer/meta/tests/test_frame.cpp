@@ -35,14 +35,20 @@
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/vector.h"
 #include "foundation/memory/autoreleaseptr.h"
 #include "foundation/platform/thread.h"
+#include "foundation/utility/iostreamop.h"
 #include "foundation/utility/test.h"
 
 // Boost headers.
 #include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/path.hpp"
 
+// Standard headers.
+#include <cstddef>
+#include <string>
+
 namespace bf = boost::filesystem;
 using namespace foundation;
 using namespace renderer;
@@ -179,4 +185,27 @@ TEST_SUITE(Renderer_Modeling_Frame_Frame)
         EXPECT_TRUE(bf::exists(m_output_directory / "override.direct_glossy.exr"));         // note: file name overridden and exr extension added
         EXPECT_TRUE(bf::exists(m_output_directory / "override.indirect_glossy.exr"));       // note: file name overridden and exr extension added
     }
+
+    TEST_CASE(GetView_TwoByTwoGrid_ReturnsViewAndPointRelativeToView)
+    {
+        auto_release_ptr<Frame> frame(
+            FrameFactory::create(
+                "beauty",
+                ParamArray()
+                    .insert("resolution", "64 32")
+                    .insert("views", "front back left right")
+                    .insert("view_columns", 2)));
+
+        EXPECT_EQ(4, frame->get_view_count());
+        EXPECT_EQ(2, frame->get_view_column_count());
+        EXPECT_EQ(2, frame->get_view_row_count());
+        EXPECT_EQ(std::string("front"), frame->get_active_camera_name());
+
+        Vector2d view_point;
+        const size_t view_index = frame->get_view(Vector2i(40, 20), Vector2d(0.75, 0.75), view_point);
+
+        EXPECT_EQ(3, view_index);
+        EXPECT_EQ(std::string("right"), frame->get_view_camera_name(view_index));
+        EXPECT_FEQ(Vector2d(0.5, 0.5), view_point);
+    }
 }
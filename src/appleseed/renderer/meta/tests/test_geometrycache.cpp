@@ -0,0 +1,170 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/displacementpatch.h"
+#include "renderer/kernel/intersection/geometrycache.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/ray.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Intersection_DisplacementPatch)
+{
+    std::shared_ptr<const DisplacementPatch> make_unit_square_patch(const float z)
+    {
+        std::vector<GVector3> vertices;
+        vertices.emplace_back(0.0f, 0.0f, z);
+        vertices.emplace_back(1.0f, 0.0f, z);
+        vertices.emplace_back(0.0f, 1.0f, z);
+        vertices.emplace_back(1.0f, 1.0f, z);
+
+        std::vector<GVector2> uvs;
+        uvs.emplace_back(0.0f, 0.0f);
+        uvs.emplace_back(1.0f, 0.0f);
+        uvs.emplace_back(0.0f, 1.0f);
+        uvs.emplace_back(1.0f, 1.0f);
+
+        std::vector<std::uint32_t> indices = { 0, 1, 2, 1, 3, 2 };
+
+        return std::make_shared<DisplacementPatch>(vertices, uvs, indices);
+    }
+
+    TEST_CASE(Intersect_RayHittingPatch_ReturnsClosestHit)
+    {
+        const std::shared_ptr<const DisplacementPatch> patch = make_unit_square_patch(1.0f);
+
+        const Ray3d ray(Vector3d(0.75, 0.75, 0.0), Vector3d(0.0, 0.0, 1.0));
+        DisplacementPatch::Hit hit;
+
+        ASSERT_TRUE(patch->intersect(ray, hit));
+        EXPECT_FEQ(1.0, hit.m_distance);
+        EXPECT_FEQ(GVector2(0.75f, 0.75f), patch->get_uv(hit.m_triangle_index, hit.m_u, hit.m_v));
+        EXPECT_TRUE(patch->intersect(ray));
+    }
+
+    TEST_CASE(Intersect_RayMissingPatch_ReturnsFalse)
+    {
+        const std::shared_ptr<const DisplacementPatch> patch = make_unit_square_patch(1.0f);
+
+        const Ray3d ray(Vector3d(2.0, 0.5, 0.0), Vector3d(0.0, 0.0, 1.0));
+        DisplacementPatch::Hit hit;
+
+        EXPECT_FALSE(patch->intersect(ray, hit));
+        EXPECT_FALSE(patch->intersect(ray));
+    }
+}
+
+TEST_SUITE(Renderer_Kernel_Intersection_GeometryCache)
+{
+    struct TessellateSquare
+    {
+        size_t& m_call_count;
+
+        explicit TessellateSquare(size_t& call_count)
+          : m_call_count(call_count)
+        {
+        }
+
+        GeometryCache::PatchPtr operator()() const
+        {
+            ++m_call_count;
+
+            std::vector<GVector3> vertices(3, GVector3(0.0f));
+            vertices[1] = GVector3(1.0f, 0.0f, 0.0f);
+            vertices[2] = GVector3(0.0f, 1.0f, 0.0f);
+            std::vector<GVector2> uvs(3, GVector2(0.0f));
+            std::vector<std::uint32_t> indices = { 0, 1, 2 };
+
+            return std::make_shared<DisplacementPatch>(vertices, uvs, indices);
+        }
+    };
+
+    TEST_CASE(Get_SameKeyTwice_TessellatesOnce)
+    {
+        GeometryCache cache(1024 * 1024);
+        size_t call_count = 0;
+
+        const GeometryCache::PatchPtr first = cache.get(7, TessellateSquare(call_count));
+        const GeometryCache::PatchPtr second = cache.get(7, TessellateSquare(call_count));
+
+        EXPECT_EQ(1, call_count);
+        EXPECT_EQ(first.get(), second.get());
+        EXPECT_EQ(1, cache.get_hit_count());
+        EXPECT_EQ(1, cache.get_miss_count());
+    }
+
+    TEST_CASE(Get_CacheFull_EvictsLeastRecentlyUsedPatch)
+    {
+        size_t call_count = 0;
+        const size_t patch_size = TessellateSquare(call_count)()->get_memory_size();
+
+        // Room for two patches.
+        GeometryCache cache(patch_size * 2 + patch_size / 2);
+        call_count = 0;
+
+        cache.get(1, TessellateSquare(call_count));
+        cache.get(2, TessellateSquare(call_count));
+        cache.get(1, TessellateSquare(call_count));     // 2 is now the least recently used patch
+        cache.get(3, TessellateSquare(call_count));     // evicts 2
+
+        EXPECT_EQ(3, call_count);
+        EXPECT_EQ(2, cache.get_patch_count());
+        EXPECT_EQ(patch_size * 2, cache.get_memory_size());
+
+        cache.get(1, TessellateSquare(call_count));
+        EXPECT_EQ(3, call_count);
+
+        cache.get(2, TessellateSquare(call_count));
+        EXPECT_EQ(4, call_count);
+    }
+
+    TEST_CASE(Get_EvictedPatchStillReferenced_RemainsValid)
+    {
+        size_t call_count = 0;
+        GeometryCache cache(1);
+
+        const GeometryCache::PatchPtr first = cache.get(1, TessellateSquare(call_count));
+        cache.get(2, TessellateSquare(call_count));
+
+        EXPECT_EQ(1, cache.get_patch_count());
+        EXPECT_EQ(1, first->get_triangle_count());
+    }
+}
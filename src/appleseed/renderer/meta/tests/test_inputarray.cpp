@@ -28,16 +28,25 @@
 //
 
 // appleseed.renderer headers.
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/modeling/input/inputarray.h"
 #include "renderer/modeling/input/scalarsource.h"
 #include "renderer/modeling/input/source.h"
+#include "renderer/modeling/input/sourceinputs.h"
+#include "renderer/modeling/scene/scene.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/platform/compiler.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
+#include <cstdint>
 #include <string>
 
+using namespace foundation;
 using namespace renderer;
 
 TEST_SUITE(Renderer_Modeling_Input_InputArray)
@@ -94,4 +103,94 @@ TEST_SUITE(Renderer_Modeling_Input_InputArray)
 
         EXPECT_EQ(expected_source, source);
     }
+
+    struct UVSource
+      : public Source
+    {
+        UVSource()
+          : Source(false)
+        {
+        }
+
+        std::uint64_t compute_signature() const override
+        {
+            return 0;
+        }
+
+        Hints get_hints() const override
+        {
+            Hints hints;
+            hints.m_width = 1;
+            hints.m_height = 1;
+            return hints;
+        }
+
+        void evaluate(
+            TextureCache&               texture_cache,
+            const SourceInputs&         source_inputs,
+            float&                      scalar) const override
+        {
+            scalar = source_inputs.m_uv_x;
+        }
+    };
+
+    APPLESEED_DECLARE_INPUT_VALUES(InputValues)
+    {
+        float       m_a;
+        float       m_b;
+        float       m_c;
+    };
+
+    struct Fixture
+    {
+        auto_release_ptr<Scene>     m_scene;
+        TextureStore                m_texture_store;
+        TextureCache                m_texture_cache;
+        InputArray                  m_inputs;
+
+        Fixture()
+          : m_scene(SceneFactory::create())
+          , m_texture_store(m_scene.ref())
+          , m_texture_cache(m_texture_store)
+        {
+            m_inputs.declare("a", InputFormatFloat);
+            m_inputs.declare("b", InputFormatFloat);
+            m_inputs.declare("c", InputFormatFloat, "");
+            m_inputs.find("a").bind(new ScalarSource(2.0f));
+            m_inputs.find("b").bind(new UVSource());
+        }
+
+        InputValues evaluate(const float u)
+        {
+            InputValues values;
+            m_inputs.evaluate(m_texture_cache, SourceInputs(Vector2f(u, 0.0f)), &values);
+            return values;
+        }
+    };
+
+    TEST_CASE_F(Evaluate_GivenCompiledInputs_EvaluatesUniformAndVaryingInputs, Fixture)
+    {
+        m_inputs.compile();
+
+        const InputValues values1 = evaluate(0.25f);
+        const InputValues values2 = evaluate(0.75f);
+
+        EXPECT_EQ(2.0f, values1.m_a);
+        EXPECT_EQ(0.25f, values1.m_b);
+        EXPECT_EQ(0.0f, values1.m_c);
+        EXPECT_EQ(2.0f, values2.m_a);
+        EXPECT_EQ(0.75f, values2.m_b);
+        EXPECT_EQ(0.0f, values2.m_c);
+    }
+
+    TEST_CASE_F(Evaluate_GivenSourceBoundAfterCompilation_EvaluatesNewSource, Fixture)
+    {
+        m_inputs.compile();
+        m_inputs.find("a").bind(new ScalarSource(3.0f));
+
+        const InputValues values = evaluate(0.5f);
+
+        EXPECT_EQ(3.0f, values.m_a);
+        EXPECT_EQ(0.5f, values.m_b);
+    }
 }
@@ -35,7 +35,9 @@
 #include "renderer/kernel/shading/shadingray.h"
 #include "renderer/kernel/texturing/texturecache.h"
 #include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/object/meshobject.h"
 #include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/triangle.h"
 #include "renderer/modeling/scene/assembly.h"
 #include "renderer/modeling/scene/assemblyinstance.h"
 #include "renderer/modeling/scene/containers.h"
@@ -51,8 +53,12 @@
 #include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
 #include "foundation/memory/autoreleaseptr.h"
+#include "foundation/utility/iostreamop.h"
 #include "foundation/utility/test.h"
 
+// Standard headers.
+#include <string>
+
 using namespace foundation;
 using namespace renderer;
 
@@ -146,6 +152,23 @@ TEST_SUITE(Renderer_Kernel_Intersection_Intersector)
         EXPECT_FALSE(hit);
     }
 
+    TEST_CASE_F(TraceProbeStream_GivenAssemblyContainingEmptyBoundingBoxAndRaysWithTMaxInsideAssembly_ReturnsFalseForEveryRay, Fixture<false>)
+    {
+        const ShadingRay rays[3] =
+        {
+            ShadingRay(Vector3d(0.0, 0.0, 2.0), Vector3d(0.0, 0.0, -1.0), 0.0, 2.0, ShadingRay::Time(), VisibilityFlags::CameraRay, 0),
+            ShadingRay(Vector3d(0.0, 2.0, 0.0), Vector3d(0.0, -1.0, 0.0), 0.0, 2.0, ShadingRay::Time(), VisibilityFlags::CameraRay, 0),
+            ShadingRay(Vector3d(-2.0, 0.0, 0.0), Vector3d(1.0, 0.0, 0.0), 0.0, 2.0, ShadingRay::Time(), VisibilityFlags::CameraRay, 0)
+        };
+
+        bool occluded[3] = { true, true, true };
+        m_intersector.trace_probe_stream(rays, 3, occluded);
+
+        EXPECT_FALSE(occluded[0]);
+        EXPECT_FALSE(occluded[1]);
+        EXPECT_FALSE(occluded[2]);
+    }
+
 #ifdef APPLESEED_WITH_EMBREE
 
     TEST_CASE_F(Trace_Embree_GivenAssemblyContainingEmptyBoundingBoxAndRayWithTMaxInsideAssembly_ReturnsFalse, Fixture<true>)
@@ -181,5 +204,373 @@ TEST_SUITE(Renderer_Kernel_Intersection_Intersector)
         EXPECT_FALSE(hit);
     }
 
+    struct EmbreeInstancingFixture
+      : public StaticTestSceneContext<TestScene>
+    {
+        TraceContext    m_trace_context;
+        TextureStore    m_texture_store;
+        TextureCache    m_texture_cache;
+        Intersector     m_intersector;
+
+        EmbreeInstancingFixture()
+          : m_trace_context(m_scene)
+          , m_texture_store(m_scene)
+          , m_texture_cache(m_texture_store)
+          , m_intersector(m_trace_context, m_texture_cache)
+        {
+            m_scene.get_parameters().insert_path("acceleration_structure.embree_instancing", true);
+            m_trace_context.set_use_embree(true);
+            m_trace_context.update();
+        }
+    };
+
+    TEST_CASE_F(Trace_EmbreeInstancing_GivenAssemblyContainingEmptyBoundingBoxAndRayWithTMaxInsideAssembly_ReturnsFalse, EmbreeInstancingFixture)
+    {
+        const ShadingRay ray(
+            Vector3d(0.0, 0.0, 2.0),
+            Vector3d(0.0, 0.0, -1.0),
+            0.0,                                // tmin
+            2.0,                                // tmax
+            ShadingRay::Time(),
+            VisibilityFlags::CameraRay,
+            0);                                 // depth
+
+        ShadingPoint shading_point;
+        const bool hit = m_intersector.trace(ray, shading_point);
+
+        EXPECT_FALSE(hit);
+    }
+
+    TEST_CASE_F(TraceProbe_EmbreeInstancing_GivenAssemblyContainingEmptyBoundingBoxAndRayWithTMaxInsideAssembly_ReturnsFalse, EmbreeInstancingFixture)
+    {
+        const ShadingRay ray(
+            Vector3d(0.0, 0.0, 2.0),
+            Vector3d(0.0, 0.0, -1.0),
+            0.0,                                // tmin
+            2.0,                                // tmax
+            ShadingRay::Time(),
+            VisibilityFlags::CameraRay,
+            0);                                 // depth
+
+        const bool hit = m_intersector.trace_probe(ray);
+
+        EXPECT_FALSE(hit);
+    }
+
+#endif  // APPLESEED_WITH_EMBREE
+
+    struct TwoPlanesTestScene
+      : public TestSceneBase
+    {
+        TwoPlanesTestScene()
+        {
+            auto_release_ptr<Assembly> assembly(
+                AssemblyFactory().create("assembly", ParamArray()));
+
+            // A unit square in the YZ plane.
+            auto_release_ptr<MeshObject> mesh_object(
+                MeshObjectFactory().create("plane", ParamArray()));
+            mesh_object->push_vertex(GVector3(0.0f, -0.5f, -0.5f));
+            mesh_object->push_vertex(GVector3(0.0f, +0.5f, -0.5f));
+            mesh_object->push_vertex(GVector3(0.0f, +0.5f, +0.5f));
+            mesh_object->push_vertex(GVector3(0.0f, -0.5f, +0.5f));
+            mesh_object->push_vertex_normal(GVector3(-1.0f, 0.0f, 0.0f));
+            mesh_object->push_triangle(Triangle(0, 1, 2, 0, 0, 0, 0));
+            mesh_object->push_triangle(Triangle(2, 3, 0, 0, 0, 0, 0));
+            assembly->objects().insert(auto_release_ptr<Object>(mesh_object.release()));
+
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "near_plane",
+                    ParamArray(),
+                    "plane",
+                    Transformd::from_local_to_parent(
+                        Matrix4d::make_translation(Vector3d(1.0, 0.0, 0.0))),
+                    StringDictionary()));
+
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "far_plane",
+                    ParamArray(),
+                    "plane",
+                    Transformd::from_local_to_parent(
+                        Matrix4d::make_translation(Vector3d(2.0, 0.0, 0.0))),
+                    StringDictionary()));
+
+            m_scene.assembly_instances().insert(
+                auto_release_ptr<AssemblyInstance>(
+                    AssemblyInstanceFactory::create(
+                        "assembly_instance",
+                        ParamArray(),
+                        "assembly")));
+
+            m_scene.assemblies().insert(assembly);
+        }
+    };
+
+    struct TwoPlanesFixture
+      : public StaticTestSceneContext<TwoPlanesTestScene>
+    {
+        TraceContext    m_trace_context;
+        TextureStore    m_texture_store;
+        TextureCache    m_texture_cache;
+        Intersector     m_intersector;
+
+        TwoPlanesFixture()
+          : m_trace_context(m_scene)
+          , m_texture_store(m_scene)
+          , m_texture_cache(m_texture_store)
+          , m_intersector(m_trace_context, m_texture_cache)
+        {
+            m_trace_context.update();
+        }
+
+        static ShadingRay make_ray(const double origin_x)
+        {
+            return
+                ShadingRay(
+                    Vector3d(origin_x, 0.0, 0.0),
+                    Vector3d(1.0, 0.0, 0.0),
+                    0.0,                        // tmin
+                    10.0,                       // tmax
+                    ShadingRay::Time(),
+                    VisibilityFlags::ProbeRay,
+                    0);                         // depth
+        }
+    };
+
+    TEST_CASE_F(TraceObjectInstance_GivenOccludingObjectInstance_IgnoresIt, TwoPlanesFixture)
+    {
+        // Find a point on the far plane.
+        ShadingPoint reference_point;
+        ASSERT_TRUE(m_intersector.trace(make_ray(1.5), reference_point));
+
+        ShadingPoint shading_point;
+        const bool hit = m_intersector.trace_object_instance(make_ray(0.0), reference_point, shading_point);
+
+        ASSERT_TRUE(hit);
+        EXPECT_FEQ(2.0, shading_point.get_distance());
+        EXPECT_EQ(reference_point.get_object_instance_index(), shading_point.get_object_instance_index());
+    }
+
+    TEST_CASE_F(TraceObjectInstance_GivenRayMissingObjectInstance_ReturnsFalse, TwoPlanesFixture)
+    {
+        // Find a point on the near plane.
+        ShadingPoint reference_point;
+        ASSERT_TRUE(m_intersector.trace(make_ray(0.0), reference_point));
+
+        // The ray starts past the near plane and only the far plane is in front of it.
+        ShadingPoint shading_point;
+        const bool hit = m_intersector.trace_object_instance(make_ray(1.5), reference_point, shading_point);
+
+        EXPECT_FALSE(hit);
+    }
+
+    TEST_CASE_F(TraceProbe_GivenOccluderKey_ReturnsSameResultsAsWithoutOccluderKey, TwoPlanesFixture)
+    {
+        const size_t OccluderKey = 42;
+
+        // Blocked by the near plane, which gets cached.
+        EXPECT_TRUE(m_intersector.trace_probe(make_ray(0.0), nullptr, OccluderKey));
+
+        // Blocked by the cached near plane.
+        EXPECT_TRUE(m_intersector.trace_probe(make_ray(0.0), nullptr, OccluderKey));
+
+        // The cached near plane is behind the ray origin, but the far plane isn't.
+        EXPECT_TRUE(m_intersector.trace_probe(make_ray(1.5), nullptr, OccluderKey));
+
+        // Both planes are behind the ray origin.
+        EXPECT_FALSE(m_intersector.trace_probe(make_ray(2.5), nullptr, OccluderKey));
+    }
+
+    struct InstancedPlanesTestScene
+      : public TestSceneBase
+    {
+        InstancedPlanesTestScene()
+        {
+            auto_release_ptr<Assembly> assembly(
+                AssemblyFactory().create("assembly", ParamArray()));
+
+            // A unit square in the YZ plane.
+            auto_release_ptr<MeshObject> mesh_object(
+                MeshObjectFactory().create("plane", ParamArray()));
+            mesh_object->push_vertex(GVector3(0.0f, -0.5f, -0.5f));
+            mesh_object->push_vertex(GVector3(0.0f, +0.5f, -0.5f));
+            mesh_object->push_vertex(GVector3(0.0f, +0.5f, +0.5f));
+            mesh_object->push_vertex(GVector3(0.0f, -0.5f, +0.5f));
+            mesh_object->push_vertex_normal(GVector3(-1.0f, 0.0f, 0.0f));
+            mesh_object->push_triangle(Triangle(0, 1, 2, 0, 0, 0, 0));
+            mesh_object->push_triangle(Triangle(2, 3, 0, 0, 0, 0, 0));
+            assembly->objects().insert(auto_release_ptr<Object>(mesh_object.release()));
+
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "plane_inst",
+                    ParamArray(),
+                    "plane",
+                    Transformd::identity(),
+                    StringDictionary()));
+
+            m_scene.assemblies().insert(assembly);
+
+            // Two assembly instances share the same placement.
+            insert_assembly_instance("near_assembly_instance", 1.5);
+            insert_assembly_instance("far_assembly_instance_1", 3.0);
+            insert_assembly_instance("far_assembly_instance_2", 3.0);
+        }
+
+        void insert_assembly_instance(const char* name, const double x)
+        {
+            auto_release_ptr<AssemblyInstance> assembly_instance(
+                AssemblyInstanceFactory::create(name, ParamArray(), "assembly"));
+
+            assembly_instance->transform_sequence().set_transform(
+                0.0f,
+                Transformd::from_local_to_parent(
+                    Matrix4d::make_translation(Vector3d(x, 0.0, 0.0))));
+
+            m_scene.assembly_instances().insert(assembly_instance);
+        }
+    };
+
+    struct InstancedPlanesFixture
+      : public StaticTestSceneContext<InstancedPlanesTestScene>
+    {
+        TraceContext    m_trace_context;
+        TextureStore    m_texture_store;
+        TextureCache    m_texture_cache;
+        Intersector     m_intersector;
+
+        InstancedPlanesFixture()
+          : m_trace_context(m_scene)
+          , m_texture_store(m_scene)
+          , m_texture_cache(m_texture_store)
+          , m_intersector(m_trace_context, m_texture_cache)
+        {
+            m_trace_context.update();
+        }
+    };
+
+    TEST_CASE_F(Trace_GivenStaticAssemblyInstances_ReturnsClosestHit, InstancedPlanesFixture)
+    {
+        const ShadingRay ray(
+            Vector3d(0.0, 0.1, 0.2),
+            Vector3d(1.0, 0.0, 0.0),
+            0.0,                        // tmin
+            10.0,                       // tmax
+            ShadingRay::Time(),
+            VisibilityFlags::CameraRay,
+            0);                         // depth
+
+        ShadingPoint shading_point;
+        const bool hit = m_intersector.trace(ray, shading_point);
+
+        ASSERT_TRUE(hit);
+        EXPECT_FEQ(1.5, shading_point.get_distance());
+        EXPECT_EQ("near_assembly_instance", std::string(shading_point.get_assembly_instance().get_name()));
+        EXPECT_FEQ_EPS(Vector3d(1.5, 0.1, 0.2), shading_point.get_point(), 1.0e-6);
+    }
+
+    TEST_CASE_F(Trace_GivenAssemblyInstancesSharingPlacement_ReturnsHit, InstancedPlanesFixture)
+    {
+        const ShadingRay ray(
+            Vector3d(2.0, -0.1, 0.3),
+            Vector3d(1.0, 0.0, 0.0),
+            0.0,                        // tmin
+            10.0,                       // tmax
+            ShadingRay::Time(),
+            VisibilityFlags::CameraRay,
+            0);                         // depth
+
+        ShadingPoint shading_point;
+        const bool hit = m_intersector.trace(ray, shading_point);
+
+        ASSERT_TRUE(hit);
+        EXPECT_FEQ(1.0, shading_point.get_distance());
+        EXPECT_FEQ_EPS(Vector3d(3.0, -0.1, 0.3), shading_point.get_point(), 1.0e-6);
+    }
+
+    TEST_CASE_F(TraceProbeStream_GivenStaticAssemblyInstances_ReturnsSameResultsAsTraceProbe, InstancedPlanesFixture)
+    {
+        // More rays than fit in a single packet.
+        const ShadingRay rays[6] =
+        {
+            ShadingRay(Vector3d(0.0, 0.1, 0.2), Vector3d(1.0, 0.0, 0.0), 0.0, 10.0, ShadingRay::Time(), VisibilityFlags::ShadowRay, 0),
+            ShadingRay(Vector3d(0.0, 0.1, 0.2), Vector3d(1.0, 0.0, 0.0), 0.0, 1.0, ShadingRay::Time(), VisibilityFlags::ShadowRay, 0),
+            ShadingRay(Vector3d(2.0, -0.1, 0.3), Vector3d(1.0, 0.0, 0.0), 0.0, 10.0, ShadingRay::Time(), VisibilityFlags::ShadowRay, 0),
+            ShadingRay(Vector3d(3.5, 0.0, 0.0), Vector3d(1.0, 0.0, 0.0), 0.0, 10.0, ShadingRay::Time(), VisibilityFlags::ShadowRay, 0),
+            ShadingRay(Vector3d(0.0, 0.8, 0.0), Vector3d(1.0, 0.0, 0.0), 0.0, 10.0, ShadingRay::Time(), VisibilityFlags::ShadowRay, 0),
+            ShadingRay(Vector3d(2.0, 0.0, 0.0), Vector3d(-1.0, 0.0, 0.0), 0.0, 10.0, ShadingRay::Time(), VisibilityFlags::ShadowRay, 0)
+        };
+
+        bool occluded[6];
+        m_intersector.trace_probe_stream(rays, 6, occluded);
+
+        EXPECT_TRUE(occluded[0]);
+        EXPECT_FALSE(occluded[1]);
+        EXPECT_TRUE(occluded[2]);
+        EXPECT_FALSE(occluded[3]);
+        EXPECT_FALSE(occluded[4]);
+
+        for (size_t i = 0; i < 6; ++i)
+            EXPECT_EQ(m_intersector.trace_probe(rays[i]), occluded[i]);
+    }
+
+#ifdef APPLESEED_WITH_EMBREE
+
+    struct InstancedPlanesEmbreeInstancingFixture
+      : public StaticTestSceneContext<InstancedPlanesTestScene>
+    {
+        TraceContext    m_trace_context;
+        TextureStore    m_texture_store;
+        TextureCache    m_texture_cache;
+        Intersector     m_intersector;
+
+        InstancedPlanesEmbreeInstancingFixture()
+          : m_trace_context(m_scene)
+          , m_texture_store(m_scene)
+          , m_texture_cache(m_texture_store)
+          , m_intersector(m_trace_context, m_texture_cache)
+        {
+            m_scene.get_parameters().insert_path("acceleration_structure.embree_instancing", true);
+            m_trace_context.set_use_embree(true);
+            m_trace_context.update();
+        }
+    };
+
+    TEST_CASE_F(Trace_EmbreeInstancing_GivenStaticAssemblyInstances_ReturnsClosestHit, InstancedPlanesEmbreeInstancingFixture)
+    {
+        const ShadingRay ray(
+            Vector3d(0.0, 0.1, 0.2),
+            Vector3d(1.0, 0.0, 0.0),
+            0.0,                        // tmin
+            10.0,                       // tmax
+            ShadingRay::Time(),
+            VisibilityFlags::CameraRay,
+            0);                         // depth
+
+        ShadingPoint shading_point;
+        const bool hit = m_intersector.trace(ray, shading_point);
+
+        ASSERT_TRUE(hit);
+        EXPECT_FEQ(1.5, shading_point.get_distance());
+        EXPECT_EQ("near_assembly_instance", std::string(shading_point.get_assembly_instance().get_name()));
+        EXPECT_FEQ_EPS(Vector3d(1.5, 0.1, 0.2), shading_point.get_point(), 1.0e-6);
+    }
+
+    TEST_CASE_F(TraceProbe_EmbreeInstancing_GivenRayEndingBeforeFirstAssemblyInstance_ReturnsFalse, InstancedPlanesEmbreeInstancingFixture)
+    {
+        const ShadingRay ray(
+            Vector3d(0.0, 0.1, 0.2),
+            Vector3d(1.0, 0.0, 0.0),
+            0.0,                        // tmin
+            1.0,                        // tmax
+            ShadingRay::Time(),
+            VisibilityFlags::ShadowRay,
+            0);                         // depth
+
+        EXPECT_FALSE(m_intersector.trace_probe(ray));
+    }
+
 #endif  // APPLESEED_WITH_EMBREE
 }
@@ -0,0 +1,114 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/jobgranularitycontroller.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstdint>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Rendering_JobGranularityController)
+{
+    JobManager::Timings make_timings(
+        const std::uint64_t     job_count,
+        const double            job_duration,
+        const double            wait_duration)
+    {
+        JobManager::Timings timings;
+        timings.m_job_count = job_count;
+        timings.m_job_time = job_count * job_duration;
+        timings.m_wait_time = job_count * wait_duration;
+        return timings;
+    }
+
+    TEST_CASE(Constructor_ClampsInitialJobSize)
+    {
+        JobGranularityController controller(0.1, 10, 100, 1000);
+
+        EXPECT_EQ(100, controller.get_job_size());
+    }
+
+    TEST_CASE(Update_GivenTooFewJobs_KeepsJobSize)
+    {
+        JobGranularityController controller(0.1, 10, 1000, 100);
+
+        EXPECT_FALSE(controller.update(make_timings(2, 0.01, 0.0)));
+        EXPECT_EQ(100, controller.get_job_size());
+    }
+
+    TEST_CASE(Update_GivenShortJobs_GrowsJobs)
+    {
+        JobGranularityController controller(0.1, 10, 1000, 100);
+
+        EXPECT_TRUE(controller.update(make_timings(100, 0.01, 0.0)));
+        EXPECT_EQ(200, controller.get_job_size());
+    }
+
+    TEST_CASE(Update_GivenLongJobs_ShrinksJobs)
+    {
+        JobGranularityController controller(0.1, 10, 1000, 100);
+
+        EXPECT_TRUE(controller.update(make_timings(100, 0.2, 0.0)));
+        EXPECT_EQ(50, controller.get_job_size());
+    }
+
+    TEST_CASE(Update_GivenJobsCloseToTarget_KeepsJobSize)
+    {
+        JobGranularityController controller(0.1, 10, 1000, 100);
+
+        EXPECT_FALSE(controller.update(make_timings(100, 0.11, 0.0)));
+        EXPECT_EQ(100, controller.get_job_size());
+    }
+
+    TEST_CASE(Update_GivenLongJobsAndLongWaits_KeepsJobSize)
+    {
+        JobGranularityController controller(0.1, 10, 1000, 100);
+
+        EXPECT_FALSE(controller.update(make_timings(100, 0.2, 0.05)));
+        EXPECT_EQ(100, controller.get_job_size());
+    }
+
+    TEST_CASE(Update_GivenManyUpdates_ConvergesToTargetDuration)
+    {
+        JobGranularityController controller(0.1, 1, 1000000, 100);
+
+        // Simulate jobs taking 1 ms per 10 units of work.
+        for (size_t i = 0; i < 20; ++i)
+            controller.update(make_timings(100, controller.get_job_size() * 0.0001, 0.0));
+
+        EXPECT_TRUE(controller.get_job_size() > 1000 / 1.25);
+        EXPECT_TRUE(controller.get_job_size() < 1000 * 1.25);
+    }
+}
@@ -0,0 +1,118 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/lightimportancecache.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_LightImportanceCache)
+{
+    struct Fixture
+    {
+        static const size_t LearningSampleCount = 16;
+
+        LightImportanceCache m_cache;
+
+        Fixture()
+          : m_cache(
+                AABB3d(Vector3d(0.0), Vector3d(1.0)),
+                std::vector<float>{ 0.5f, 0.5f },
+                4,
+                LearningSampleCount,
+                0.75f)
+        {
+        }
+    };
+
+    TEST_CASE_F(GetCellIndex_GivenPointOutsideBoundingBox_ReturnsClosestCell, Fixture)
+    {
+        EXPECT_EQ(m_cache.get_cell_index(Vector3d(0.1)), m_cache.get_cell_index(Vector3d(-5.0)));
+        EXPECT_EQ(m_cache.get_cell_index(Vector3d(0.9)), m_cache.get_cell_index(Vector3d(5.0)));
+    }
+
+    TEST_CASE_F(IsReady_GivenTooFewRecordedSamples_ReturnsFalse, Fixture)
+    {
+        const size_t cell_index = m_cache.get_cell_index(Vector3d(0.5));
+
+        for (size_t i = 0; i < LearningSampleCount - 1; ++i)
+            m_cache.record(cell_index, 1, 1.0f);
+
+        EXPECT_FALSE(m_cache.is_ready(cell_index));
+    }
+
+    TEST_CASE_F(Evaluate_GivenOccludedGroup_KeepsDefensiveProbability, Fixture)
+    {
+        const size_t cell_index = m_cache.get_cell_index(Vector3d(0.5));
+
+        for (size_t i = 0; i < LearningSampleCount; ++i)
+            m_cache.record(cell_index, i % 2, i % 2 == 1 ? 1.0f : 0.0f);
+
+        ASSERT_TRUE(m_cache.is_ready(cell_index));
+        EXPECT_FEQ(0.125f, m_cache.evaluate(cell_index, 0));
+        EXPECT_FEQ(0.875f, m_cache.evaluate(cell_index, 1));
+    }
+
+    TEST_CASE_F(Evaluate_GivenNoContribution_ReturnsDefaultProbability, Fixture)
+    {
+        const size_t cell_index = m_cache.get_cell_index(Vector3d(0.5));
+
+        for (size_t i = 0; i < LearningSampleCount; ++i)
+            m_cache.record(cell_index, i % 2, 0.0f);
+
+        ASSERT_TRUE(m_cache.is_ready(cell_index));
+        EXPECT_FEQ(0.5f, m_cache.evaluate(cell_index, 0));
+        EXPECT_FEQ(0.5f, m_cache.evaluate(cell_index, 1));
+    }
+
+    TEST_CASE_F(Sample_GivenReadyCell_RemapsSampleWithinChosenGroup, Fixture)
+    {
+        const size_t cell_index = m_cache.get_cell_index(Vector3d(0.5));
+
+        for (size_t i = 0; i < LearningSampleCount; ++i)
+            m_cache.record(cell_index, 1, 1.0f);
+
+        float s = 0.0625f;
+        float group_prob;
+        const size_t group_index = m_cache.sample(cell_index, s, group_prob);
+
+        EXPECT_EQ(0, group_index);
+        EXPECT_FEQ(0.125f, group_prob);
+        EXPECT_FEQ(0.5f, s);
+    }
+}
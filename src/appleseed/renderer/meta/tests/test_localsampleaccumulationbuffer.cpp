@@ -28,21 +28,29 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/rendering/localsampleaccumulationbuffer.h"
+#include "renderer/kernel/rendering/sample.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
 #include "foundation/image/accumulatortile.h"
+#include "foundation/image/analysis.h"
 #include "foundation/image/color.h"
+#include "foundation/image/image.h"
 #include "foundation/image/tile.h"
 #include "foundation/math/aabb.h"
 #include "foundation/math/rng/distribution.h"
 #include "foundation/math/rng/mersennetwister.h"
 #include "foundation/math/vector.h"
+#include "foundation/memory/autoreleaseptr.h"
 #include "foundation/utility/job.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <vector>
 
 using namespace foundation;
 using namespace renderer;
@@ -136,4 +144,206 @@ TEST_SUITE(Renderer_Kernel_Rendering_LocalSampleAccumulationBuffer)
             EXPECT_TRUE(honors_crop_window(crop_window));
         }
     }
+
+    void store_samples_in_rect(
+        LocalSampleAccumulationBuffer&  buffer,
+        const AABB2u&                   rect,
+        const size_t                    samples_per_pixel,
+        const bool                      noisy)
+    {
+        MersenneTwister rng;
+        AbortSwitch abort_switch;
+
+        std::vector<Sample> samples;
+
+        for (size_t i = 0; i < samples_per_pixel; ++i)
+        {
+            for (size_t y = rect.min.y; y <= rect.max.y; ++y)
+            {
+                for (size_t x = rect.min.x; x <= rect.max.x; ++x)
+                {
+                    const float value = noisy ? 10.0f * rand_float1(rng) : 1.0f;
+
+                    Sample sample;
+                    sample.m_pixel_coords = Vector2i(static_cast<int>(x), static_cast<int>(y));
+                    sample.m_color = Color4f(value, value, value, 1.0f);
+                    samples.push_back(sample);
+                }
+            }
+
+            buffer.store_samples(samples.size(), &samples[0], abort_switch);
+            samples.clear();
+        }
+    }
+
+    TEST_CASE(IsConverged_ConvergenceTrackingIsDisabled_ReturnsFalse)
+    {
+        LocalSampleAccumulationBuffer buffer(64, 64);
+
+        store_samples_in_rect(buffer, AABB2u(Vector2u(0, 0), Vector2u(63, 63)), 32, false);
+
+        EXPECT_FALSE(buffer.is_converged(0, 0));
+        EXPECT_FALSE(buffer.is_converged());
+    }
+
+    TEST_CASE(IsConverged_NoSamples_ReturnsFalse)
+    {
+        LocalSampleAccumulationBuffer buffer(64, 64);
+        buffer.enable_convergence_tracking(AABB2u(Vector2u(0, 0), Vector2u(63, 63)), 0.01f, 4);
+
+        EXPECT_FALSE(buffer.is_converged(0, 0));
+        EXPECT_FALSE(buffer.is_converged());
+    }
+
+    TEST_CASE(IsConverged_ConstantSamples_ReturnsTrue)
+    {
+        const AABB2u crop_window(Vector2u(8, 8), Vector2u(47, 39));
+
+        LocalSampleAccumulationBuffer buffer(64, 64);
+        buffer.enable_convergence_tracking(crop_window, 0.01f, 4);
+
+        store_samples_in_rect(buffer, crop_window, 32, false);
+
+        EXPECT_TRUE(buffer.is_converged(8, 8));
+        EXPECT_TRUE(buffer.is_converged(47, 39));
+        EXPECT_TRUE(buffer.is_converged());
+    }
+
+    TEST_CASE(IsConverged_NoisyBlock_ReturnsFalseForNoisyBlockOnly)
+    {
+        const AABB2u crop_window(Vector2u(0, 0), Vector2u(63, 63));
+
+        LocalSampleAccumulationBuffer buffer(64, 64);
+        buffer.enable_convergence_tracking(crop_window, 0.01f, 4);
+
+        store_samples_in_rect(buffer, AABB2u(Vector2u(0, 0), Vector2u(31, 63)), 32, false);
+        store_samples_in_rect(buffer, AABB2u(Vector2u(32, 0), Vector2u(63, 63)), 32, true);
+
+        EXPECT_TRUE(buffer.is_converged(0, 0));
+        EXPECT_FALSE(buffer.is_converged(63, 63));
+        EXPECT_FALSE(buffer.is_converged());
+    }
+
+    TEST_CASE(Clear_ConvergedBuffer_ResetsConvergence)
+    {
+        const AABB2u crop_window(Vector2u(0, 0), Vector2u(63, 63));
+
+        LocalSampleAccumulationBuffer buffer(64, 64);
+        buffer.enable_convergence_tracking(crop_window, 0.01f, 4);
+
+        store_samples_in_rect(buffer, crop_window, 32, false);
+        buffer.clear();
+
+        EXPECT_FALSE(buffer.is_converged(0, 0));
+        EXPECT_FALSE(buffer.is_converged());
+    }
+
+    TEST_CASE(GetErrorEstimate_ErrorEstimationIsDisabled_ReturnsFalse)
+    {
+        LocalSampleAccumulationBuffer buffer(64, 64);
+
+        float average_error, max_error;
+        EXPECT_FALSE(buffer.get_error_estimate(average_error, max_error));
+    }
+
+    TEST_CASE(GetErrorEstimate_NoSamples_ReturnsMaxErrors)
+    {
+        LocalSampleAccumulationBuffer buffer(64, 64);
+        buffer.enable_error_estimation(AABB2u(Vector2u(0, 0), Vector2u(63, 63)));
+
+        float average_error, max_error;
+        ASSERT_TRUE(buffer.get_error_estimate(average_error, max_error));
+
+        EXPECT_EQ(std::numeric_limits<float>::max(), average_error);
+        EXPECT_EQ(std::numeric_limits<float>::max(), max_error);
+    }
+
+    TEST_CASE(GetErrorEstimate_ConstantSamples_ReturnsZeroErrorsWithoutRetiringBlocks)
+    {
+        const AABB2u crop_window(Vector2u(8, 8), Vector2u(47, 39));
+
+        LocalSampleAccumulationBuffer buffer(64, 64);
+        buffer.enable_error_estimation(crop_window);
+
+        store_samples_in_rect(buffer, crop_window, 32, false);
+
+        float average_error, max_error;
+        ASSERT_TRUE(buffer.get_error_estimate(average_error, max_error));
+
+        EXPECT_EQ(0.0f, average_error);
+        EXPECT_EQ(0.0f, max_error);
+        EXPECT_FALSE(buffer.is_converged(8, 8));
+        EXPECT_FALSE(buffer.is_converged());
+    }
+
+    TEST_CASE(GetErrorEstimate_NoisyBlocks_ReturnsHigherMaxError)
+    {
+        const AABB2u crop_window(Vector2u(0, 0), Vector2u(63, 63));
+
+        LocalSampleAccumulationBuffer buffer(64, 64);
+        buffer.enable_error_estimation(crop_window);
+
+        store_samples_in_rect(buffer, AABB2u(Vector2u(0, 0), Vector2u(31, 63)), 32, false);
+        store_samples_in_rect(buffer, AABB2u(Vector2u(32, 0), Vector2u(63, 63)), 32, true);
+
+        float average_error, max_error;
+        ASSERT_TRUE(buffer.get_error_estimate(average_error, max_error));
+
+        EXPECT_GT(0.0f, average_error);
+        EXPECT_GT(average_error, max_error);
+        EXPECT_LT(std::numeric_limits<float>::max(), max_error);
+    }
+
+    TEST_CASE(DevelopDirtyTilesToFrame_SamplesInOneTile_DevelopsThisTileOnly)
+    {
+        auto_release_ptr<Frame> frame(
+            FrameFactory::create(
+                "frame",
+                ParamArray()
+                    .insert("resolution", "64 64")
+                    .insert("tile_size", "16 16")));
+
+        LocalSampleAccumulationBuffer buffer(64, 64);
+        AbortSwitch abort_switch;
+        std::vector<size_t> dirty_tiles;
+
+        // Enough samples to display the full resolution level, which develops all tiles once.
+        store_samples_in_rect(buffer, AABB2u(Vector2u(0, 0), Vector2u(63, 63)), 1, false);
+        buffer.develop_dirty_tiles_to_frame(frame.ref(), dirty_tiles, abort_switch);
+        EXPECT_EQ(16, dirty_tiles.size());
+
+        store_samples_in_rect(buffer, AABB2u(Vector2u(20, 4), Vector2u(27, 11)), 1, false);
+        buffer.develop_dirty_tiles_to_frame(frame.ref(), dirty_tiles, abort_switch);
+        ASSERT_EQ(1, dirty_tiles.size());
+        EXPECT_EQ(1, dirty_tiles[0]);
+
+        buffer.develop_dirty_tiles_to_frame(frame.ref(), dirty_tiles, abort_switch);
+        EXPECT_TRUE(dirty_tiles.empty());
+    }
+
+    TEST_CASE(UpdateAnalysis_DoesNotConsumeDirtyTilesOfDevelopDirtyTilesToFrame)
+    {
+        auto_release_ptr<Frame> frame(
+            FrameFactory::create(
+                "frame",
+                ParamArray()
+                    .insert("resolution", "64 64")
+                    .insert("tile_size", "16 16")));
+
+        LocalSampleAccumulationBuffer buffer(64, 64);
+        TiledImageAnalysis analysis(frame->image().properties());
+        AbortSwitch abort_switch;
+        std::vector<size_t> dirty_tiles;
+
+        store_samples_in_rect(buffer, AABB2u(Vector2u(0, 0), Vector2u(63, 63)), 1, false);
+        buffer.develop_dirty_tiles_to_frame(frame.ref(), dirty_tiles, abort_switch);
+        buffer.update_analysis(frame.ref(), analysis, abort_switch);
+        EXPECT_FEQ(1.0, analysis.get_average_luminance());
+
+        store_samples_in_rect(buffer, AABB2u(Vector2u(20, 4), Vector2u(27, 11)), 1, false);
+        buffer.update_analysis(frame.ref(), analysis, abort_switch);
+        buffer.develop_dirty_tiles_to_frame(frame.ref(), dirty_tiles, abort_switch);
+        ASSERT_EQ(1, dirty_tiles.size());
+        EXPECT_EQ(1, dirty_tiles[0]);
+    }
 }
@@ -0,0 +1,330 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/volume/majorantgrid.h"
+#include "renderer/kernel/volume/volume.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Volume_MajorantGrid)
+{
+    struct Segment
+    {
+        double  m_t0;
+        double  m_t1;
+        float   m_majorant;
+    };
+
+    struct RecordingVisitor
+    {
+        std::vector<Segment> m_segments;
+
+        bool operator()(const double t0, const double t1, const float majorant)
+        {
+            const Segment segment = { t0, t1, majorant };
+            m_segments.push_back(segment);
+            return true;
+        }
+    };
+
+    struct ConstantDensity
+    {
+        double m_density;
+
+        double operator()(const double t) const
+        {
+            return m_density;
+        }
+    };
+
+    struct ConstantRandom
+    {
+        double m_value;
+
+        double operator()() const
+        {
+            return m_value;
+        }
+    };
+
+    struct CountingCollider
+    {
+        size_t  m_collision_count;
+        bool    m_accept;
+
+        bool operator()(const double t, const float majorant)
+        {
+            ++m_collision_count;
+            return m_accept;
+        }
+    };
+
+    void fill_with_single_dense_voxel(
+        VoxelGrid&          grid,
+        const size_t        x,
+        const size_t        y,
+        const size_t        z,
+        const float         density)
+    {
+        for (size_t iz = 0; iz < grid.get_zres(); ++iz)
+        {
+            for (size_t iy = 0; iy < grid.get_yres(); ++iy)
+            {
+                for (size_t ix = 0; ix < grid.get_xres(); ++ix)
+                    grid.voxel(ix, iy, iz)[0] = 0.0f;
+            }
+        }
+
+        grid.voxel(x, y, z)[0] = density;
+    }
+
+    TEST_CASE(Constructor_BuildsLevelsDownToSingleCell)
+    {
+        VoxelGrid grid(32, 16, 8, 1);
+        fill_with_single_dense_voxel(grid, 0, 0, 0, 1.0f);
+
+        const MajorantGrid majorant_grid(grid, 0, 4);
+
+        ASSERT_EQ(4, majorant_grid.get_level_count());
+        EXPECT_EQ(8, majorant_grid.get_xres(0));
+        EXPECT_EQ(4, majorant_grid.get_yres(0));
+        EXPECT_EQ(2, majorant_grid.get_zres(0));
+        EXPECT_EQ(1, majorant_grid.get_xres(3));
+        EXPECT_EQ(1, majorant_grid.get_yres(3));
+        EXPECT_EQ(1, majorant_grid.get_zres(3));
+    }
+
+    TEST_CASE(Constructor_MultipleThreads_MatchesSingleThreadedBuild)
+    {
+        VoxelGrid grid(16, 16, 16, 1);
+        fill_with_single_dense_voxel(grid, 9, 3, 12, 2.0f);
+
+        const MajorantGrid st_grid(grid, 0, 4, 1);
+        const MajorantGrid mt_grid(grid, 0, 4, 4);
+
+        for (size_t z = 0; z < 4; ++z)
+        {
+            for (size_t y = 0; y < 4; ++y)
+            {
+                for (size_t x = 0; x < 4; ++x)
+                    EXPECT_EQ(st_grid.get_majorant(0, x, y, z), mt_grid.get_majorant(0, x, y, z));
+            }
+        }
+    }
+
+    TEST_CASE(GetMajorant_AccountsForInterpolationIntoNeighboringBlocks)
+    {
+        VoxelGrid grid(16, 16, 16, 1);
+        fill_with_single_dense_voxel(grid, 3, 0, 0, 2.0f);
+
+        const MajorantGrid majorant_grid(grid, 0, 4);
+
+        EXPECT_EQ(2.0f, majorant_grid.get_majorant(0, 0, 0, 0));
+        EXPECT_EQ(2.0f, majorant_grid.get_majorant(0, 1, 0, 0));
+        EXPECT_EQ(0.0f, majorant_grid.get_majorant(0, 2, 0, 0));
+        EXPECT_EQ(2.0f, majorant_grid.get_global_majorant());
+    }
+
+    TEST_CASE(Traverse_RayThroughSingleDenseBlock_VisitsOnlyThatBlock)
+    {
+        VoxelGrid grid(16, 16, 16, 1);
+        fill_with_single_dense_voxel(grid, 9, 9, 9, 1.0f);
+
+        const MajorantGrid majorant_grid(grid, 0, 8);
+
+        RecordingVisitor visitor;
+        majorant_grid.traverse(
+            Vector3d(-1.0, 0.75, 0.75),
+            Vector3d(1.0, 0.0, 0.0),
+            0.0,
+            10.0,
+            visitor);
+
+        ASSERT_EQ(1, visitor.m_segments.size());
+        EXPECT_FEQ(1.5, visitor.m_segments[0].m_t0);
+        EXPECT_FEQ(2.0, visitor.m_segments[0].m_t1);
+        EXPECT_EQ(1.0f, visitor.m_segments[0].m_majorant);
+    }
+
+    TEST_CASE(Traverse_RayMissingUnitCube_VisitsNothing)
+    {
+        VoxelGrid grid(8, 8, 8, 1);
+        fill_with_single_dense_voxel(grid, 4, 4, 4, 1.0f);
+
+        const MajorantGrid majorant_grid(grid, 0, 1);
+
+        RecordingVisitor visitor;
+        majorant_grid.traverse(
+            Vector3d(-1.0, 2.0, 0.5),
+            Vector3d(1.0, 0.0, 0.0),
+            0.0,
+            10.0,
+            visitor);
+
+        EXPECT_TRUE(visitor.m_segments.empty());
+    }
+
+    TEST_CASE(Traverse_DiagonalRayThroughDenseGrid_SegmentsAreContiguous)
+    {
+        VoxelGrid grid(8, 8, 8, 1);
+        for (size_t z = 0; z < 8; ++z)
+        {
+            for (size_t y = 0; y < 8; ++y)
+            {
+                for (size_t x = 0; x < 8; ++x)
+                    grid.voxel(x, y, z)[0] = 1.0f;
+            }
+        }
+
+        const MajorantGrid majorant_grid(grid, 0, 1);
+
+        RecordingVisitor visitor;
+        majorant_grid.traverse(
+            Vector3d(0.01, 0.02, 0.03),
+            normalize(Vector3d(0.3, 0.5, 0.7)),
+            0.0,
+            10.0,
+            visitor);
+
+        ASSERT_FALSE(visitor.m_segments.empty());
+        EXPECT_FEQ(0.0, visitor.m_segments.front().m_t0);
+
+        for (size_t i = 1; i < visitor.m_segments.size(); ++i)
+            EXPECT_FEQ(visitor.m_segments[i - 1].m_t1, visitor.m_segments[i].m_t0);
+    }
+
+    TEST_CASE(Integrate_ConstantDensityInsideDenseGrid_ReturnsDensityTimesLength)
+    {
+        VoxelGrid grid(8, 8, 8, 1);
+        for (size_t z = 0; z < 8; ++z)
+        {
+            for (size_t y = 0; y < 8; ++y)
+            {
+                for (size_t x = 0; x < 8; ++x)
+                    grid.voxel(x, y, z)[0] = 1.0f;
+            }
+        }
+
+        const MajorantGrid majorant_grid(grid, 0, 1);
+
+        ConstantDensity density = { 2.0 };
+        const double integral =
+            majorant_grid.integrate(
+                Vector3d(-1.0, 0.5, 0.5),
+                Vector3d(1.0, 0.0, 0.0),
+                0.0,
+                10.0,
+                density,
+                0.1);
+
+        EXPECT_FEQ(2.0, integral);
+    }
+
+    TEST_CASE(Integrate_RayThroughEmptyCellsOnly_ReturnsZero)
+    {
+        VoxelGrid grid(16, 16, 16, 1);
+        fill_with_single_dense_voxel(grid, 9, 9, 9, 1.0f);
+
+        const MajorantGrid majorant_grid(grid, 0, 8);
+
+        ConstantDensity density = { 2.0 };
+        const double integral =
+            majorant_grid.integrate(
+                Vector3d(-1.0, 0.25, 0.25),
+                Vector3d(1.0, 0.0, 0.0),
+                0.0,
+                10.0,
+                density,
+                0.1);
+
+        EXPECT_EQ(0.0, integral);
+    }
+
+    TEST_CASE(Track_AcceptingFirstCollision_ReturnsCollisionInsideDenseBlock)
+    {
+        VoxelGrid grid(16, 16, 16, 1);
+        fill_with_single_dense_voxel(grid, 9, 9, 9, 1.0f);
+
+        const MajorantGrid majorant_grid(grid, 0, 8);
+
+        ConstantRandom rand = { 0.5 };
+        CountingCollider collider = { 0, true };
+        double t;
+        const bool collided =
+            majorant_grid.track(
+                Vector3d(-1.0, 0.75, 0.75),
+                Vector3d(1.0, 0.0, 0.0),
+                0.0,
+                10.0,
+                1000.0f,
+                rand,
+                collider,
+                t);
+
+        ASSERT_TRUE(collided);
+        EXPECT_EQ(1, collider.m_collision_count);
+        EXPECT_FEQ(1.5 + std::log(2.0) / 1000.0, t);
+    }
+
+    TEST_CASE(Track_RejectingEveryCollision_LeavesSegment)
+    {
+        VoxelGrid grid(16, 16, 16, 1);
+        fill_with_single_dense_voxel(grid, 9, 9, 9, 1.0f);
+
+        const MajorantGrid majorant_grid(grid, 0, 8);
+
+        ConstantRandom rand = { 0.5 };
+        CountingCollider collider = { 0, false };
+        double t;
+        const bool collided =
+            majorant_grid.track(
+                Vector3d(-1.0, 0.75, 0.75),
+                Vector3d(1.0, 0.0, 0.0),
+                0.0,
+                10.0,
+                10.0f,
+                rand,
+                collider,
+                t);
+
+        EXPECT_FALSE(collided);
+        EXPECT_EQ(7, collider.m_collision_count);
+    }
+}
@@ -0,0 +1,102 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/modeling/texture/memorytexture2d.h"
+#include "renderer/modeling/texture/texture.h"
+#include "renderer/modeling/texture/tileptr.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Modeling_Texture_MemoryTexture2d)
+{
+    auto_release_ptr<Texture> create_texture(const bool build_mip_levels)
+    {
+        // 5x3 image stored in 2x2 tiles, with a horizontal gradient.
+        auto_release_ptr<Image> image(new Image(5, 3, 2, 2, 1, PixelFormatFloat));
+
+        for (size_t y = 0; y < 3; ++y)
+        {
+            for (size_t x = 0; x < 5; ++x)
+                image->set_pixel(x, y, Color<float, 1>(static_cast<float>(x)));
+        }
+
+        return
+            MemoryTexture2dFactory().create(
+                "texture",
+                ParamArray()
+                    .insert("color_space", "linear_rgb")
+                    .insert("build_mip_levels", build_mip_levels),
+                image);
+    }
+
+    TEST_CASE(GetMipLevelCount_GivenMipLevelsDisabled_ReturnsOne)
+    {
+        auto_release_ptr<Texture> texture = create_texture(false);
+
+        EXPECT_EQ(1, texture->get_mip_level_count());
+    }
+
+    TEST_CASE(GetMipLevelCount_GivenMipLevelsEnabled_ReturnsLevelCountDownTo1x1)
+    {
+        auto_release_ptr<Texture> texture = create_texture(true);
+
+        // 5x3, 2x1, 1x1.
+        ASSERT_EQ(3, texture->get_mip_level_count());
+
+        EXPECT_EQ(2, texture->mip_level_properties(1).m_canvas_width);
+        EXPECT_EQ(1, texture->mip_level_properties(1).m_canvas_height);
+        EXPECT_EQ(1, texture->mip_level_properties(2).m_canvas_width);
+        EXPECT_EQ(1, texture->mip_level_properties(2).m_canvas_height);
+    }
+
+    TEST_CASE(LoadMipLevelTile_ReturnsBoxFilteredTexels)
+    {
+        auto_release_ptr<Texture> texture = create_texture(true);
+
+        const TilePtr tile = texture->load_mip_level_tile(1, 0, 0);
+
+        Color<float, 1> texel0, texel1;
+        tile.get_tile()->get_pixel(0, 0, texel0);
+        tile.get_tile()->get_pixel(1, 0, texel1);
+
+        EXPECT_FEQ(0.5f, texel0[0]);
+        EXPECT_FEQ(2.5f, texel1[0]);
+    }
+}
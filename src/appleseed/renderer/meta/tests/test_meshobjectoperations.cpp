@@ -0,0 +1,198 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/meshobjectoperations.h"
+#include "renderer/modeling/object/triangle.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Modeling_Object_MeshObjectOperations)
+{
+    // A unit square made of two triangles with per-face-vertex attributes.
+    auto_release_ptr<MeshObject> create_split_square()
+    {
+        auto_release_ptr<MeshObject> object(
+            MeshObjectFactory().create("square", ParamArray()));
+
+        const GVector3 Vertices[] =
+        {
+            GVector3(0.0f, 0.0f, 0.0f), GVector3(1.0f, 0.0f, 0.0f), GVector3(1.0f, 1.0f, 0.0f),
+            GVector3(1.0f, 1.0f, 0.0f), GVector3(0.0f, 1.0f, 0.0f), GVector3(0.0f, 0.0f, 0.0f)
+        };
+
+        for (size_t i = 0; i < 6; ++i)
+        {
+            object->push_vertex(Vertices[i]);
+            object->push_vertex_normal(GVector3(0.0f, 0.0f, 1.0f));
+            object->push_tex_coords(GVector2(Vertices[i][0], Vertices[i][1]));
+        }
+
+        object->push_triangle(Triangle(0, 1, 2, 0, 1, 2, 0, 1, 2, 0));
+        object->push_triangle(Triangle(3, 4, 5, 3, 4, 5, 3, 4, 5, 0));
+
+        return object;
+    }
+
+    TEST_CASE(WeldVertices_GivenSplitVertices_MergesDuplicates)
+    {
+        auto_release_ptr<MeshObject> object = create_split_square();
+
+        weld_vertices(object.ref());
+
+        EXPECT_EQ(4, object->get_vertex_count());
+        EXPECT_EQ(1, object->get_vertex_normal_count());
+        EXPECT_EQ(4, object->get_tex_coords_count());
+    }
+
+    TEST_CASE(WeldVertices_GivenSplitVertices_PreservesTriangleGeometry)
+    {
+        auto_release_ptr<MeshObject> reference = create_split_square();
+        auto_release_ptr<MeshObject> object = create_split_square();
+
+        weld_vertices(object.ref());
+
+        for (size_t i = 0; i < 2; ++i)
+        {
+            const Triangle& ref_triangle = reference->get_triangle(i);
+            const Triangle& triangle = object->get_triangle(i);
+
+            EXPECT_EQ(reference->get_vertex(ref_triangle.m_v0), object->get_vertex(triangle.m_v0));
+            EXPECT_EQ(reference->get_vertex(ref_triangle.m_v1), object->get_vertex(triangle.m_v1));
+            EXPECT_EQ(reference->get_vertex(ref_triangle.m_v2), object->get_vertex(triangle.m_v2));
+            EXPECT_EQ(reference->get_vertex_normal(ref_triangle.m_n0), object->get_vertex_normal(triangle.m_n0));
+            EXPECT_EQ(reference->get_tex_coords(ref_triangle.m_a2), object->get_tex_coords(triangle.m_a2));
+        }
+    }
+
+    TEST_CASE(WeldVertices_GivenVerticesWithDifferentPoses_KeepsThemApart)
+    {
+        auto_release_ptr<MeshObject> object(
+            MeshObjectFactory().create("triangle", ParamArray()));
+
+        object->push_vertex(GVector3(0.0f, 0.0f, 0.0f));
+        object->push_vertex(GVector3(0.0f, 0.0f, 0.0f));
+        object->push_vertex(GVector3(1.0f, 0.0f, 0.0f));
+        object->push_triangle(Triangle(0, 1, 2));
+
+        object->set_motion_segment_count(1);
+        object->set_vertex_pose(0, 0, GVector3(0.0f, 1.0f, 0.0f));
+        object->set_vertex_pose(1, 0, GVector3(0.0f, 2.0f, 0.0f));
+        object->set_vertex_pose(2, 0, GVector3(1.0f, 0.0f, 0.0f));
+
+        weld_vertices(object.ref());
+
+        EXPECT_EQ(3, object->get_vertex_count());
+    }
+
+    // Separate triangles lined up along the X axis, pushed in reverse order, with poses offset along Y.
+    auto_release_ptr<MeshObject> create_reversed_triangle_row()
+    {
+        auto_release_ptr<MeshObject> object(
+            MeshObjectFactory().create("row", ParamArray()));
+
+        const size_t TriangleCount = 4;
+
+        for (size_t i = 0; i < TriangleCount; ++i)
+        {
+            const float x = static_cast<float>(TriangleCount - 1 - i);
+            const size_t base = 3 * i;
+
+            object->push_vertex(GVector3(x, 0.0f, 0.0f));
+            object->push_vertex(GVector3(x + 0.5f, 0.0f, 0.0f));
+            object->push_vertex(GVector3(x, 0.5f, 0.0f));
+            object->push_vertex_normal(GVector3(0.0f, 0.0f, 1.0f));
+            object->push_tex_coords(GVector2(x, 0.0f));
+            object->push_triangle(Triangle(base, base + 1, base + 2, i, i, i, i, i, i, 0));
+        }
+
+        object->set_motion_segment_count(1);
+
+        for (size_t i = 0; i < object->get_vertex_count(); ++i)
+            object->set_vertex_pose(i, 0, object->get_vertex(i) + GVector3(0.0f, 1.0f, 0.0f));
+
+        for (size_t i = 0; i < object->get_vertex_normal_count(); ++i)
+            object->set_vertex_normal_pose(i, 0, object->get_vertex_normal(i));
+
+        return object;
+    }
+
+    TEST_CASE(ReorderSpatially_GivenReversedTriangles_SortsTrianglesAndVertices)
+    {
+        auto_release_ptr<MeshObject> object = create_reversed_triangle_row();
+
+        reorder_spatially(object.ref());
+
+        for (size_t i = 0; i < object->get_triangle_count(); ++i)
+        {
+            const Triangle& triangle = object->get_triangle(i);
+
+            EXPECT_EQ(static_cast<float>(i), object->get_vertex(triangle.m_v0)[0]);
+            EXPECT_EQ(3 * i, triangle.m_v0);
+            EXPECT_EQ(3 * i + 1, triangle.m_v1);
+            EXPECT_EQ(3 * i + 2, triangle.m_v2);
+            EXPECT_EQ(i, triangle.m_n0);
+            EXPECT_EQ(i, triangle.m_a0);
+        }
+    }
+
+    TEST_CASE(ReorderSpatially_PreservesTriangleGeometryAndPoses)
+    {
+        auto_release_ptr<MeshObject> reference = create_reversed_triangle_row();
+        auto_release_ptr<MeshObject> object = create_reversed_triangle_row();
+
+        reorder_spatially(object.ref());
+
+        ASSERT_EQ(reference->get_triangle_count(), object->get_triangle_count());
+        ASSERT_EQ(reference->get_vertex_count(), object->get_vertex_count());
+
+        for (size_t i = 0; i < object->get_triangle_count(); ++i)
+        {
+            // Triangles are reversed, so triangle i comes from the last reference triangles.
+            const Triangle& ref_triangle = reference->get_triangle(object->get_triangle_count() - 1 - i);
+            const Triangle& triangle = object->get_triangle(i);
+
+            EXPECT_EQ(reference->get_vertex(ref_triangle.m_v0), object->get_vertex(triangle.m_v0));
+            EXPECT_EQ(reference->get_vertex(ref_triangle.m_v1), object->get_vertex(triangle.m_v1));
+            EXPECT_EQ(reference->get_vertex(ref_triangle.m_v2), object->get_vertex(triangle.m_v2));
+            EXPECT_EQ(reference->get_vertex_pose(ref_triangle.m_v2, 0), object->get_vertex_pose(triangle.m_v2, 0));
+            EXPECT_EQ(reference->get_vertex_normal_pose(ref_triangle.m_n0, 0), object->get_vertex_normal_pose(triangle.m_n0, 0));
+            EXPECT_EQ(reference->get_tex_coords(ref_triangle.m_a1), object->get_tex_coords(triangle.m_a1));
+        }
+    }
+}
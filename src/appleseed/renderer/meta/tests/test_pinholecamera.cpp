@@ -28,16 +28,31 @@
 //
 
 // appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/shading/shadingray.h"
 #include "renderer/modeling/camera/camera.h"
 #include "renderer/modeling/camera/pinholecamera.h"
+#include "renderer/modeling/entity/onframebeginrecorder.h"
+#include "renderer/modeling/entity/onrenderbeginrecorder.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/modeling/project/project.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
 #include "renderer/utility/projectpoints.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/dual.h"
+#include "foundation/math/matrix.h"
+#include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
 #include "foundation/memory/autoreleaseptr.h"
 #include "foundation/utility/iostreamop.h"
 #include "foundation/utility/test.h"
 
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
 using namespace foundation;
 using namespace renderer;
 
@@ -62,4 +77,84 @@ TEST_SUITE(Renderer_Modeling_Camera_PinholeCamera)
         ASSERT_TRUE(success);
         EXPECT_FEQ(Vector2d(0.5, 0.5), projected);
     }
+
+    TEST_CASE(SpawnRays_MatchesSpawnRay)
+    {
+        auto_release_ptr<Camera> camera(
+            PinholeCameraFactory().create(
+                "camera",
+                ParamArray()
+                    .insert("film_width", "0.025")
+                    .insert("film_height", "0.02")
+                    .insert("focal_length", "0.035")
+                    .insert("shift_x", "0.001")));
+        camera->transform_sequence().set_transform(
+            0.0f,
+            Transformd::from_local_to_parent(
+                Matrix4d::make_translation(Vector3d(1.0, 2.0, 3.0)) *
+                Matrix4d::make_rotation_y(0.5)));
+
+        auto_release_ptr<Scene> scene(SceneFactory::create());
+        scene->cameras().insert(camera);
+
+        auto_release_ptr<Project> project(ProjectFactory::create("test"));
+        project->set_scene(scene);
+        project->set_frame(
+            FrameFactory::create(
+                "frame",
+                ParamArray()
+                    .insert("resolution", "64 64")
+                    .insert("camera", "camera")));
+
+        OnRenderBeginRecorder render_begin_recorder;
+        bool success = project->get_scene()->on_render_begin(project.ref(), nullptr, render_begin_recorder);
+        ASSERT_TRUE(success);
+
+        OnFrameBeginRecorder frame_begin_recorder;
+        success = project->get_scene()->on_frame_begin(project.ref(), nullptr, frame_begin_recorder);
+        ASSERT_TRUE(success);
+
+        const Camera* active_camera = project->get_scene()->get_render_data().m_active_camera;
+
+        const size_t RayCount = 5;
+        const Dual2d ndc[RayCount] =
+        {
+            Dual2d(Vector2d(0.5, 0.5)),
+            Dual2d(Vector2d(0.1, 0.7), Vector2d(0.01, 0.0), Vector2d(0.0, -0.01)),
+            Dual2d(Vector2d(0.9, 0.2)),
+            Dual2d(Vector2d(0.3, 0.4), Vector2d(0.01, 0.0), Vector2d(0.0, -0.01)),
+            Dual2d(Vector2d(1.0, 0.0))
+        };
+
+        SamplingContext::RNGType rng;
+        std::vector<SamplingContext> sampling_contexts;
+        for (size_t i = 0; i < RayCount; ++i)
+            sampling_contexts.emplace_back(rng, SamplingContext::QMCMode, i);
+
+        ShadingRay expected[RayCount];
+        for (size_t i = 0; i < RayCount; ++i)
+        {
+            SamplingContext sampling_context(sampling_contexts[i]);
+            active_camera->spawn_ray(sampling_context, ndc[i], expected[i]);
+        }
+
+        ShadingRay rays[RayCount];
+        active_camera->spawn_rays(&sampling_contexts[0], ndc, RayCount, rays);
+
+        for (size_t i = 0; i < RayCount; ++i)
+        {
+            EXPECT_FEQ(expected[i].m_org, rays[i].m_org);
+            EXPECT_FEQ(expected[i].m_dir, rays[i].m_dir);
+            EXPECT_EQ(expected[i].m_has_differentials, rays[i].m_has_differentials);
+
+            if (expected[i].m_has_differentials)
+            {
+                EXPECT_FEQ(expected[i].m_rx.m_dir, rays[i].m_rx.m_dir);
+                EXPECT_FEQ(expected[i].m_ry.m_dir, rays[i].m_ry.m_dir);
+            }
+        }
+
+        frame_begin_recorder.on_frame_end(project.ref());
+        render_begin_recorder.on_render_end(project.ref());
+    }
 }
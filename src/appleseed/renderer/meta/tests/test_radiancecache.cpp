@@ -0,0 +1,101 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/lighting/radiancecache.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_RadianceCache)
+{
+    const Vector3d Up(0.0, 1.0, 0.0);
+
+    TEST_CASE(Lookup_BeforeUpdate_ReturnsFalse)
+    {
+        RadianceCache cache(AABB3d(Vector3d(0.0), Vector3d(1.0)), 4, 3, 1024 * 1024);
+
+        for (size_t i = 0; i < 100; ++i)
+            cache.record(Vector3d(0.5), Up, Up, Spectrum(1.0f));
+
+        Spectrum radiance;
+        EXPECT_FALSE(cache.lookup(Vector3d(0.5), Up, Up, radiance));
+    }
+
+    TEST_CASE(Lookup_AfterUpdate_ReturnsMeanOfRecordedSamples)
+    {
+        RadianceCache cache(AABB3d(Vector3d(0.0), Vector3d(1.0)), 4, 3, 1024 * 1024);
+
+        for (size_t i = 0; i < 100; ++i)
+            cache.record(Vector3d(0.1), Up, Up, Spectrum((i & 1) == 0 ? 1.0f : 3.0f));
+        cache.update();
+
+        Spectrum radiance;
+        ASSERT_TRUE(cache.lookup(Vector3d(0.15), Up, Up, radiance));
+        EXPECT_FEQ(2.0f, radiance[0]);
+        EXPECT_FEQ(2.0f, radiance[2]);
+    }
+
+    TEST_CASE(Lookup_GivenOppositeNormal_ReturnsFalse)
+    {
+        RadianceCache cache(AABB3d(Vector3d(0.0), Vector3d(1.0)), 4, 3, 1024 * 1024);
+
+        for (size_t i = 0; i < 100; ++i)
+            cache.record(Vector3d(0.5), Up, Up, Spectrum(1.0f));
+        cache.update();
+
+        Spectrum radiance;
+        EXPECT_FALSE(cache.lookup(Vector3d(0.5), -Up, -Up, radiance));
+    }
+
+    TEST_CASE(Record_GivenFullCache_DropsSamples)
+    {
+        // A budget this small only leaves room for a single entry.
+        RadianceCache cache(AABB3d(Vector3d(0.0), Vector3d(1.0)), 4, 3, 1);
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            cache.record(Vector3d(0.1), Up, Up, Spectrum(1.0f));
+            cache.record(Vector3d(0.9), Up, Up, Spectrum(1.0f));
+        }
+        cache.update();
+
+        Spectrum radiance;
+        EXPECT_TRUE(cache.lookup(Vector3d(0.1), Up, Up, radiance));
+        EXPECT_FALSE(cache.lookup(Vector3d(0.9), Up, Up, radiance));
+    }
+}
@@ -0,0 +1,96 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/radianceestimategrid.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_RadianceEstimateGrid)
+{
+    TEST_CASE(LookupOutgoing_BeforeUpdate_ReturnsFalse)
+    {
+        RadianceEstimateGrid grid(AABB3d(Vector3d(0.0), Vector3d(1.0)), 4);
+
+        for (size_t i = 0; i < 100; ++i)
+            grid.record_outgoing(Vector3d(0.5), 1.0f);
+
+        float radiance;
+        EXPECT_FALSE(grid.lookup_outgoing(Vector3d(0.5), radiance));
+    }
+
+    TEST_CASE(LookupOutgoing_GivenTooFewSamples_ReturnsFalse)
+    {
+        RadianceEstimateGrid grid(AABB3d(Vector3d(0.0), Vector3d(1.0)), 4);
+
+        grid.record_outgoing(Vector3d(0.5), 1.0f);
+        grid.update();
+
+        float radiance;
+        EXPECT_FALSE(grid.lookup_outgoing(Vector3d(0.5), radiance));
+    }
+
+    TEST_CASE(LookupOutgoing_AfterUpdate_ReturnsMeanOfRecordedSamples)
+    {
+        RadianceEstimateGrid grid(AABB3d(Vector3d(0.0), Vector3d(1.0)), 4);
+
+        for (size_t i = 0; i < 100; ++i)
+            grid.record_outgoing(Vector3d(0.1), (i & 1) == 0 ? 1.0f : 3.0f);
+        grid.update();
+
+        float radiance;
+        ASSERT_TRUE(grid.lookup_outgoing(Vector3d(0.15), radiance));
+        EXPECT_FEQ(2.0f, radiance);
+    }
+
+    TEST_CASE(LookupPixel_AfterSeveralUpdates_ReturnsMeanOfAllRecordedSamples)
+    {
+        RadianceEstimateGrid grid(AABB3d(Vector3d(0.0), Vector3d(1.0)), 4);
+
+        for (size_t i = 0; i < 50; ++i)
+            grid.record_pixel(Vector3d(0.9), 1.0f);
+        grid.update();
+
+        for (size_t i = 0; i < 50; ++i)
+            grid.record_pixel(Vector3d(0.9), 2.0f);
+        grid.update();
+
+        float value;
+        ASSERT_TRUE(grid.lookup_pixel(Vector3d(0.9), value));
+        EXPECT_FEQ(1.5f, value);
+    }
+}
@@ -0,0 +1,80 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/rendercosttracker.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Rendering_RenderCostTracker)
+{
+    TEST_CASE(CostGetEstimatedSeconds_GivenNoTimedEvent_ReturnsZero)
+    {
+        RenderCostTracker::Cost cost;
+        cost.m_event_count = 10;
+
+        EXPECT_EQ(0.0, cost.get_estimated_seconds());
+    }
+
+    TEST_CASE(CostGetEstimatedSeconds_GivenSomeTimedEvents_ExtrapolatesToAllEvents)
+    {
+        RenderCostTracker::Cost cost;
+        cost.m_event_count = 16;
+        cost.m_timed_event_count = 4;
+        cost.m_timed_nanoseconds = 2000000000;
+
+        EXPECT_FEQ(8.0, cost.get_estimated_seconds());
+    }
+
+    TEST_CASE(CostAddition_SumsAllCounts)
+    {
+        RenderCostTracker::Cost a;
+        a.m_event_count = 1;
+        a.m_timed_event_count = 2;
+        a.m_timed_nanoseconds = 3;
+        a.m_ray_count = 4;
+
+        RenderCostTracker::Cost b;
+        b.m_event_count = 10;
+        b.m_timed_event_count = 20;
+        b.m_timed_nanoseconds = 30;
+        b.m_ray_count = 40;
+
+        a += b;
+
+        EXPECT_EQ(11, a.m_event_count);
+        EXPECT_EQ(22, a.m_timed_event_count);
+        EXPECT_EQ(33, a.m_timed_nanoseconds);
+        EXPECT_EQ(44, a.m_ray_count);
+    }
+}
@@ -110,3 +110,50 @@ TEST_SUITE(Renderer_Modeling_Scene_Scene)
         EXPECT_FEQ(GVector3(+11.0), bbox.max);
     }
 }
+
+TEST_SUITE(Renderer_Modeling_Scene_ObjectInstance)
+{
+    TEST_CASE(SelectLOD_BindsObjectMatchingScreenSize)
+    {
+        auto_release_ptr<Assembly> assembly(
+            AssemblyFactory().create("assembly", ParamArray()));
+
+        assembly->objects().insert(
+            auto_release_ptr<Object>(
+                new BoundingBoxObject(
+                    "high",
+                    GAABB3(GVector3(-1.0), GVector3(+1.0)))));
+
+        assembly->objects().insert(
+            auto_release_ptr<Object>(
+                new BoundingBoxObject(
+                    "low",
+                    GAABB3(GVector3(-1.0), GVector3(+1.0)))));
+
+        assembly->object_instances().insert(
+            ObjectInstanceFactory::create(
+                "object_inst",
+                ParamArray()
+                    .insert("lod_objects", "low")
+                    .insert("lod_screen_sizes", "0.1"),
+                "high",
+                Transformd::identity(),
+                StringDictionary()));
+
+        ObjectInstance& object_instance = *assembly->object_instances().get_by_name("object_inst");
+        object_instance.bind_object(assembly->objects());
+        ASSERT_EQ(2, object_instance.get_lod_count());
+
+        EXPECT_FALSE(object_instance.select_lod(0.5));
+        EXPECT_EQ(0, object_instance.get_selected_lod());
+        EXPECT_EQ("high", std::string(object_instance.get_object().get_name()));
+
+        EXPECT_TRUE(object_instance.select_lod(0.05));
+        EXPECT_EQ(1, object_instance.get_selected_lod());
+        EXPECT_EQ("low", std::string(object_instance.get_object().get_name()));
+
+        EXPECT_TRUE(object_instance.select_lod(0.5));
+        EXPECT_EQ(0, object_instance.get_selected_lod());
+        EXPECT_EQ("high", std::string(object_instance.get_object().get_name()));
+    }
+}
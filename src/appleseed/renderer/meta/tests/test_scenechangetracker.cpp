@@ -0,0 +1,137 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/scenechangetracker.h"
+#include "renderer/modeling/camera/camera.h"
+#include "renderer/modeling/camera/pinholecamera.h"
+#include "renderer/modeling/light/light.h"
+#include "renderer/modeling/light/pointlight.h"
+#include "renderer/modeling/material/genericmaterial.h"
+#include "renderer/modeling/material/material.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstdint>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Rendering_SceneChangeTracker)
+{
+    struct Fixture
+    {
+        auto_release_ptr<Scene>     m_scene;
+        Assembly*                   m_assembly;
+        SceneChangeTracker          m_tracker;
+
+        Fixture()
+          : m_scene(SceneFactory::create())
+        {
+            auto_release_ptr<Assembly> assembly(AssemblyFactory().create("assembly", ParamArray()));
+            m_assembly = assembly.get();
+            m_scene->assemblies().insert(assembly);
+
+            m_tracker.update(m_scene.ref());
+        }
+    };
+
+    TEST_CASE(Update_FirstCall_ReportsAllChanges)
+    {
+        auto_release_ptr<Scene> scene(SceneFactory::create());
+        SceneChangeTracker tracker;
+
+        EXPECT_EQ(SceneChangeTracker::AllChanged, tracker.update(scene.ref()));
+    }
+
+    TEST_CASE_F(Update_GivenUnchangedScene_ReportsNoChange, Fixture)
+    {
+        EXPECT_EQ(SceneChangeTracker::NoChange, m_tracker.update(m_scene.ref()));
+    }
+
+    TEST_CASE_F(Update_AfterReset_ReportsAllChanges, Fixture)
+    {
+        m_tracker.reset();
+
+        EXPECT_EQ(SceneChangeTracker::AllChanged, m_tracker.update(m_scene.ref()));
+    }
+
+    TEST_CASE_F(Update_GivenNewCamera_ReportsCameraChange, Fixture)
+    {
+        m_scene->cameras().insert(PinholeCameraFactory().create("camera", ParamArray()));
+
+        EXPECT_EQ(SceneChangeTracker::CameraChanged, m_tracker.update(m_scene.ref()));
+    }
+
+    TEST_CASE_F(Update_GivenNewLight_ReportsLightChange, Fixture)
+    {
+        m_assembly->lights().insert(PointLightFactory().create("light", ParamArray()));
+
+        EXPECT_EQ(SceneChangeTracker::LightsChanged, m_tracker.update(m_scene.ref()));
+    }
+
+    TEST_CASE_F(Update_GivenNewNonEmittingMaterial_ReportsMaterialChangeOnly, Fixture)
+    {
+        m_assembly->materials().insert(GenericMaterialFactory().create("material", ParamArray()));
+
+        EXPECT_EQ(SceneChangeTracker::MaterialsChanged, m_tracker.update(m_scene.ref()));
+    }
+
+    TEST_CASE_F(Update_GivenNewEmittingMaterial_ReportsMaterialAndLightChanges, Fixture)
+    {
+        m_assembly->materials().insert(
+            GenericMaterialFactory().create("material", ParamArray().insert("edf", "edf")));
+
+        EXPECT_EQ(
+            SceneChangeTracker::MaterialsChanged | SceneChangeTracker::LightsChanged,
+            m_tracker.update(m_scene.ref()));
+    }
+
+    TEST_CASE_F(Update_GivenBumpedAssembly_ReportsGeometryChange, Fixture)
+    {
+        m_assembly->bump_version_id();
+
+        EXPECT_EQ(SceneChangeTracker::GeometryChanged, m_tracker.update(m_scene.ref()));
+    }
+
+    TEST_CASE(GetChangesDescription_ListsChangedCategories)
+    {
+        EXPECT_EQ("none", SceneChangeTracker::get_changes_description(SceneChangeTracker::NoChange));
+        EXPECT_EQ("all", SceneChangeTracker::get_changes_description(SceneChangeTracker::AllChanged));
+        EXPECT_EQ(
+            "lights, geometry",
+            SceneChangeTracker::get_changes_description(
+                SceneChangeTracker::LightsChanged | SceneChangeTracker::GeometryChanged));
+    }
+}
@@ -0,0 +1,108 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/sdtree.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_DTree)
+{
+    TEST_CASE(IsValid_GivenNoRecordedEnergy_ReturnsFalse)
+    {
+        const DTree dtree;
+
+        EXPECT_FALSE(dtree.is_valid());
+    }
+
+    TEST_CASE(Sample_GivenLearnedDistribution_ReturnsPDFConsistentWithEvaluatePDF)
+    {
+        DTree source;
+        for (size_t i = 0; i < 100; ++i)
+            source.record(Vector3f(0.0f, 1.0f, 0.0f), 1.0f);
+        source.record(Vector3f(1.0f, 0.0f, 0.0f), 1.0f);
+
+        // Refine the structure, then record energy into the refined tree.
+        DTree dtree;
+        dtree.build(source, 0.01f, 20, 1000);
+        for (size_t i = 0; i < 100; ++i)
+            dtree.record(Vector3f(0.0f, 1.0f, 0.0f), 1.0f);
+        dtree.record(Vector3f(1.0f, 0.0f, 0.0f), 1.0f);
+
+        ASSERT_TRUE(dtree.is_valid());
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            const Vector2f s(
+                (static_cast<float>(i % 4) + 0.5f) / 4.0f,
+                (static_cast<float>(i / 4) + 0.5f) / 4.0f);
+
+            float pdf;
+            const Vector3f direction = dtree.sample(s, pdf);
+
+            EXPECT_FEQ_EPS(1.0f, norm(direction), 1.0e-4f);
+            EXPECT_FEQ_EPS(pdf, dtree.evaluate_pdf(direction), 1.0e-3f);
+        }
+    }
+}
+
+TEST_SUITE(Renderer_Kernel_Lighting_SDTree)
+{
+    TEST_CASE(GetSamplingDTree_BeforeFirstUpdate_ReturnsNull)
+    {
+        SDTree sd_tree(AABB3d(Vector3d(0.0), Vector3d(1.0)), 100, 1024 * 1024);
+
+        sd_tree.record(Vector3d(0.5), Vector3f(0.0f, 1.0f, 0.0f), 1.0f);
+
+        EXPECT_EQ(nullptr, sd_tree.get_sampling_dtree(Vector3d(0.5)));
+    }
+
+    TEST_CASE(GetSamplingDTree_AfterUpdate_ReturnsValidDTree)
+    {
+        SDTree sd_tree(AABB3d(Vector3d(0.0), Vector3d(1.0)), 100, 1024 * 1024);
+
+        sd_tree.record(Vector3d(0.5), Vector3f(0.0f, 1.0f, 0.0f), 1.0f);
+        sd_tree.update();
+
+        const DTree* dtree = sd_tree.get_sampling_dtree(Vector3d(0.5));
+
+        ASSERT_TRUE(dtree != nullptr);
+        EXPECT_TRUE(dtree->is_valid());
+        EXPECT_EQ(1, sd_tree.get_update_count());
+    }
+}
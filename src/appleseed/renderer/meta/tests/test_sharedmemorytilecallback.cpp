@@ -0,0 +1,170 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/sharedmemorytilecallback.h"
+#include "renderer/modeling/aov/aovcontainer.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/image/tile.h"
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Rendering_SharedMemoryTileCallback)
+{
+    const char* SegmentName = "appleseed_test_sharedmemorytilecallback";
+
+    struct Fixture
+    {
+        auto_release_ptr<Frame>     m_frame;
+
+        Fixture()
+        {
+            m_frame =
+                FrameFactory::create(
+                    "beauty",
+                    ParamArray()
+                        .insert("resolution", "48 32")
+                        .insert("tile_size", "32 32"),
+                    AOVContainer());
+
+            m_frame->clear_main_and_aov_images();
+        }
+    };
+
+    TEST_CASE(Constructor_GivenNonExistentFramebuffer_ThrowsExceptionIOError)
+    {
+        EXPECT_EXCEPTION(ExceptionIOError,
+        {
+            SharedMemoryFrameReader reader("appleseed_test_nonexistent_framebuffer");
+        });
+    }
+
+    TEST_CASE_F(OnTileEnd_PublishesTilePixelsAndEvents, Fixture)
+    {
+        m_frame->image().tile(1, 0).set_pixel(2, 3, Color4f(1.0f, 2.0f, 3.0f, 4.0f));
+
+        auto_release_ptr<ITileCallbackFactory> factory(
+            new SharedMemoryTileCallbackFactory(SegmentName));
+        auto_release_ptr<ITileCallback> callback(factory->create());
+
+        callback->on_tiled_frame_begin(m_frame.get());
+        callback->on_tile_begin(m_frame.get(), 1, 0, 0, 1);
+        callback->on_tile_end(m_frame.get(), 1, 0);
+
+        SharedMemoryFrameReader reader(SegmentName);
+        const SharedFrameHeader& header = reader.get_header();
+
+        EXPECT_EQ(48, header.m_frame_width);
+        EXPECT_EQ(32, header.m_frame_height);
+        EXPECT_EQ(1, header.m_plane_count);
+        EXPECT_EQ(std::string("beauty"), header.m_planes[0].m_name);
+        EXPECT_EQ(4, header.m_planes[0].m_channel_count);
+
+        EXPECT_TRUE(reader.wait(0.0));
+
+        std::vector<SharedTileEvent> events;
+        EXPECT_TRUE(reader.read_events(events));
+
+        ASSERT_EQ(3, events.size());
+        EXPECT_EQ(SharedTileEventFrameBegin, events[0].m_type);
+        EXPECT_EQ(SharedTileEventTileBegin, events[1].m_type);
+        EXPECT_EQ(SharedTileEventTileUpdate, events[2].m_type);
+        EXPECT_EQ(32, events[2].m_x);
+        EXPECT_EQ(0, events[2].m_y);
+        EXPECT_EQ(16, events[2].m_width);
+        EXPECT_EQ(32, events[2].m_height);
+
+        const float* pixel = reader.get_plane_pixels(0) + ((3 * 48) + 32 + 2) * 4;
+        EXPECT_EQ(1.0f, pixel[0]);
+        EXPECT_EQ(4.0f, pixel[3]);
+
+        events.clear();
+        EXPECT_FALSE(reader.wait(0.0));
+        EXPECT_TRUE(reader.read_events(events));
+        EXPECT_TRUE(events.empty());
+    }
+
+    TEST_CASE_F(ReadEvents_GivenOverrunRing_ReturnsFalse, Fixture)
+    {
+        auto_release_ptr<ITileCallbackFactory> factory(
+            new SharedMemoryTileCallbackFactory(SegmentName));
+        auto_release_ptr<ITileCallback> callback(factory->create());
+
+        callback->on_tiled_frame_begin(m_frame.get());
+
+        SharedMemoryFrameReader reader(SegmentName);
+        const size_t capacity = reader.get_header().m_ring_capacity;
+
+        for (size_t i = 0; i < capacity; ++i)
+            callback->on_tile_end(m_frame.get(), 0, 0);
+
+        std::vector<SharedTileEvent> events;
+        EXPECT_FALSE(reader.read_events(events));
+        EXPECT_EQ(capacity, events.size());
+        EXPECT_EQ(1, events.front().m_sequence);
+    }
+
+    TEST_CASE_F(OnTiledFrameBegin_GivenNewResolution_ClosesPreviousFramebuffer, Fixture)
+    {
+        auto_release_ptr<ITileCallbackFactory> factory(
+            new SharedMemoryTileCallbackFactory(SegmentName));
+        auto_release_ptr<ITileCallback> callback(factory->create());
+
+        callback->on_tiled_frame_begin(m_frame.get());
+
+        SharedMemoryFrameReader reader(SegmentName);
+        EXPECT_FALSE(reader.is_closed());
+
+        auto_release_ptr<Frame> other_frame(
+            FrameFactory::create(
+                "beauty",
+                ParamArray().insert("resolution", "16 16"),
+                AOVContainer()));
+
+        callback->on_tiled_frame_begin(other_frame.get());
+
+        EXPECT_TRUE(reader.is_closed());
+
+        SharedMemoryFrameReader new_reader(SegmentName);
+        EXPECT_EQ(16, new_reader.get_header().m_frame_width);
+    }
+}
@@ -0,0 +1,184 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/volume/majorantgrid.h"
+#include "renderer/kernel/volume/sparsevoxelgrid.h"
+#include "renderer/kernel/volume/volume.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <memory>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Volume_SparseVoxelGrid)
+{
+    const char* FileName = "unit tests/outputs/test_sparsevoxelgrid.svg";
+
+    // 20^3 voxels, i.e. 3^3 bricks, with a single dense blob around voxel (2, 2, 2).
+    void fill_grid(VoxelGrid& grid)
+    {
+        for (size_t z = 0; z < grid.get_zres(); ++z)
+        {
+            for (size_t y = 0; y < grid.get_yres(); ++y)
+            {
+                for (size_t x = 0; x < grid.get_xres(); ++x)
+                {
+                    const bool inside = x < 5 && y < 5 && z < 5;
+                    grid.voxel(x, y, z)[0] = inside ? static_cast<float>(x + y + z + 1) : 0.0f;
+                }
+            }
+        }
+    }
+
+    TEST_CASE(Open_GivenWrittenGrid_StoresOnlyNonEmptyBricks)
+    {
+        VoxelGrid grid(20, 20, 20, 1);
+        fill_grid(grid);
+        ASSERT_TRUE(write_sparse_voxel_grid(FileName, grid, 0));
+
+        BrickCache brick_cache(1024 * 1024);
+        const std::unique_ptr<SparseVoxelGrid> sparse_grid(SparseVoxelGrid::open(FileName, brick_cache));
+        ASSERT_TRUE(sparse_grid.get() != nullptr);
+
+        EXPECT_EQ(20, sparse_grid->get_xres());
+        EXPECT_EQ(3, sparse_grid->get_brick_xres());
+        EXPECT_EQ(1, sparse_grid->get_stored_brick_count());
+        EXPECT_TRUE(sparse_grid->get_brick(1, 0, 0).get() == nullptr);
+        EXPECT_EQ(13.0f, sparse_grid->get_brick_majorant(0, 0, 0));
+    }
+
+    TEST_CASE(Open_GivenMissingFile_ReturnsNull)
+    {
+        BrickCache brick_cache(1024 * 1024);
+        const std::unique_ptr<SparseVoxelGrid> sparse_grid(
+            SparseVoxelGrid::open("unit tests/inputs/does_not_exist.svg", brick_cache));
+
+        EXPECT_TRUE(sparse_grid.get() == nullptr);
+    }
+
+    TEST_CASE(LinearLookup_MatchesDenseVoxelGrid)
+    {
+        VoxelGrid grid(20, 20, 20, 1);
+        fill_grid(grid);
+        ASSERT_TRUE(write_sparse_voxel_grid(FileName, grid, 0));
+
+        BrickCache brick_cache(1024 * 1024);
+        const std::unique_ptr<SparseVoxelGrid> sparse_grid(SparseVoxelGrid::open(FileName, brick_cache));
+        ASSERT_TRUE(sparse_grid.get() != nullptr);
+
+        SparseVoxelGrid::Accessor accessor(*sparse_grid);
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            const Vector3d p(
+                rand_double1(rng, 0.0, 0.4),
+                rand_double1(rng, 0.0, 0.4),
+                rand_double1(rng, 0.0, 0.4));
+
+            float expected_linear, expected_nearest;
+            grid.linear_lookup(p, &expected_linear);
+            grid.nearest_lookup(p, &expected_nearest);
+
+            EXPECT_FEQ_EPS(expected_linear, accessor.linear_lookup(p), 1.0e-4f);
+            EXPECT_EQ(expected_nearest, accessor.nearest_lookup(p));
+        }
+    }
+
+    TEST_CASE(Get_GivenTinyCache_KeepsReloadingBricksAndReturnsCorrectValues)
+    {
+        VoxelGrid grid(16, 16, 16, 1);
+        for (size_t z = 0; z < 16; ++z)
+        {
+            for (size_t y = 0; y < 16; ++y)
+            {
+                for (size_t x = 0; x < 16; ++x)
+                    grid.voxel(x, y, z)[0] = static_cast<float>(x + 1);
+            }
+        }
+        ASSERT_TRUE(write_sparse_voxel_grid(FileName, grid, 0));
+
+        // Room for a single brick.
+        BrickCache brick_cache(SparseVoxelGrid::BrickVoxelCount * sizeof(float));
+        const std::unique_ptr<SparseVoxelGrid> sparse_grid(SparseVoxelGrid::open(FileName, brick_cache));
+        ASSERT_TRUE(sparse_grid.get() != nullptr);
+
+        SparseVoxelGrid::Accessor accessor0(*sparse_grid);
+        SparseVoxelGrid::Accessor accessor1(*sparse_grid);
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            EXPECT_EQ(1.0f, accessor0.get_voxel(0, 0, 0));
+            EXPECT_EQ(16.0f, accessor1.get_voxel(15, 15, 15));
+            EXPECT_EQ(9.0f, accessor0.get_voxel(8, 0, 0));
+        }
+
+        EXPECT_EQ(0, brick_cache.get_hit_count());
+        EXPECT_EQ(9, brick_cache.get_miss_count());
+    }
+
+    TEST_CASE(MajorantGrid_GivenSparseGrid_MatchesMajorantGridOfDenseGrid)
+    {
+        VoxelGrid grid(20, 20, 20, 1);
+        fill_grid(grid);
+        ASSERT_TRUE(write_sparse_voxel_grid(FileName, grid, 0));
+
+        BrickCache brick_cache(1024 * 1024);
+        const std::unique_ptr<SparseVoxelGrid> sparse_grid(SparseVoxelGrid::open(FileName, brick_cache));
+        ASSERT_TRUE(sparse_grid.get() != nullptr);
+
+        const MajorantGrid dense_majorants(grid, 0, SparseVoxelGrid::BrickSize);
+        const MajorantGrid sparse_majorants(*sparse_grid);
+
+        ASSERT_EQ(dense_majorants.get_level_count(), sparse_majorants.get_level_count());
+
+        for (size_t z = 0; z < 3; ++z)
+        {
+            for (size_t y = 0; y < 3; ++y)
+            {
+                for (size_t x = 0; x < 3; ++x)
+                {
+                    EXPECT_EQ(
+                        dense_majorants.get_majorant(0, x, y, z),
+                        sparse_majorants.get_majorant(0, x, y, z));
+                }
+            }
+        }
+
+        EXPECT_EQ(0, brick_cache.get_miss_count());
+    }
+}
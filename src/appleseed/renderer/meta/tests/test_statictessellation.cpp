@@ -0,0 +1,111 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/tessellation/statictessellation.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Tessellation_StaticTessellation)
+{
+    TEST_CASE(GetVertexNormal_GivenCompressedVertexAttributes_ReturnsCloseUnitVector)
+    {
+        StaticTriangleTess tess;
+        tess.set_compressed_vertex_attributes(true);
+
+        const GVector3 normal = normalize(GVector3(0.2f, -0.5f, 0.8f));
+        const size_t index = tess.push_vertex_normal(normal);
+
+        EXPECT_EQ(1, tess.get_vertex_normal_count());
+        EXPECT_FEQ_EPS(normal, tess.get_vertex_normal(index), 1.0e-4f);
+    }
+
+    TEST_CASE(GetVertexTangent_GivenCompressedVertexAttributes_ReturnsCloseUnitVector)
+    {
+        StaticTriangleTess tess;
+        tess.set_compressed_vertex_attributes(true);
+
+        const GVector3 tangent = normalize(GVector3(-0.7f, 0.1f, -0.3f));
+        const size_t index = tess.push_vertex_tangent(tangent);
+
+        EXPECT_EQ(1, tess.get_vertex_tangent_count());
+        EXPECT_FEQ_EPS(tangent, tess.get_vertex_tangent(index), 1.0e-4f);
+    }
+
+    TEST_CASE(GetTexCoords_GivenCompressedVertexAttributes_ReturnsHalfPrecisionTexCoords)
+    {
+        StaticTriangleTess tess;
+        tess.set_compressed_vertex_attributes(true);
+
+        const GVector2 uv(0.25f, 0.7f);
+        const size_t index = tess.push_tex_coords(uv);
+
+        EXPECT_EQ(1, tess.get_tex_coords_count());
+        EXPECT_FEQ_EPS(uv, tess.get_tex_coords(index), 1.0e-3f);
+    }
+
+    TEST_CASE(ClearTexCoords_KeepsVertexTangents)
+    {
+        StaticTriangleTess tess;
+
+        const GVector3 tangent(1.0f, 0.0f, 0.0f);
+        tess.push_tex_coords(GVector2(0.25f, 0.7f));
+        tess.push_vertex_tangent(tangent);
+
+        tess.clear_tex_coords();
+        tess.push_tex_coords(GVector2(0.5f, 0.5f));
+
+        EXPECT_EQ(1, tess.get_tex_coords_count());
+        EXPECT_EQ(1, tess.get_vertex_tangent_count());
+        EXPECT_EQ(tangent, tess.get_vertex_tangent(0));
+    }
+
+    TEST_CASE(GetMemorySize_GivenCompressedVertexAttributes_IsSmallerThanUncompressed)
+    {
+        StaticTriangleTess tess;
+        StaticTriangleTess compressed_tess;
+        compressed_tess.set_compressed_vertex_attributes(true);
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            tess.push_vertex_normal(GVector3(0.0f, 1.0f, 0.0f));
+            tess.push_tex_coords(GVector2(0.5f, 0.5f));
+            compressed_tess.push_vertex_normal(GVector3(0.0f, 1.0f, 0.0f));
+            compressed_tess.push_tex_coords(GVector2(0.5f, 0.5f));
+        }
+
+        EXPECT_LT(tess.get_memory_size(), compressed_tess.get_memory_size());
+    }
+}
@@ -45,5 +45,24 @@ TEST_SUITE(Renderer_Kernel_Texturing_TextureStore_TileKey)
         EXPECT_EQ(12345, key.m_texture_uid);
         EXPECT_EQ(32323, key.get_tile_x());
         EXPECT_EQ(56565, key.get_tile_y());
+        EXPECT_EQ(0, key.get_level());
+    }
+
+    TEST_CASE(StoreAndRetrieveMipLevel)
+    {
+        const TextureStore::TileKey key(123, 12345, 32323, 56565, 7);
+
+        EXPECT_EQ(32323, key.get_tile_x());
+        EXPECT_EQ(56565, key.get_tile_y());
+        EXPECT_EQ(7, key.get_level());
+    }
+
+    TEST_CASE(OperatorEqual_GivenKeysThatOnlyDifferByMipLevel_ReturnsFalse)
+    {
+        const TextureStore::TileKey key1(123, 12345, 3, 5, 0);
+        const TextureStore::TileKey key2(123, 12345, 3, 5, 1);
+
+        EXPECT_FALSE(key1 == key2);
+        EXPECT_TRUE(key1 < key2);
     }
 }
@@ -0,0 +1,290 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/rendering/generic/tilejob.h"
+#include "renderer/kernel/rendering/itilecallback.h"
+#include "renderer/kernel/rendering/itilerenderer.h"
+#include "renderer/modeling/aov/aovcontainer.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/image.h"
+#include "foundation/image/tile.h"
+#include "foundation/log/log.h"
+#include "foundation/math/aabb.h"
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/statistics.h"
+#include "foundation/utility/test.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Rendering_Generic_TileJob)
+{
+    const size_t MaxTileCount = 16;
+    const size_t TileSize = 64;
+    const size_t ThreadCount = 4;
+
+    class CountingTileRenderer
+      : public ITileRenderer
+    {
+      public:
+        boost::atomic<size_t>   m_tile_count;
+        boost::atomic<size_t>   m_sub_tile_count;
+        boost::atomic<size_t>   m_pixel_counts[MaxTileCount];
+
+        CountingTileRenderer()
+          : m_tile_count(0)
+          , m_sub_tile_count(0)
+        {
+            for (size_t i = 0; i < MaxTileCount; ++i)
+                m_pixel_counts[i] = 0;
+        }
+
+        void release() override
+        {
+        }
+
+        void print_settings() const override
+        {
+        }
+
+        void render_tile(
+            const Frame&            frame,
+            const size_t            tile_x,
+            const size_t            tile_y,
+            const std::uint32_t     pass_hash,
+            IAbortSwitch&           abort_switch) override
+        {
+            ++m_tile_count;
+            m_pixel_counts[tile_x] += frame.image().tile(tile_x, tile_y).get_pixel_count();
+        }
+
+        bool supports_sub_tiles() const override
+        {
+            return true;
+        }
+
+        void render_sub_tile(
+            const Frame&            frame,
+            const size_t            tile_x,
+            const size_t            tile_y,
+            const AABB2u&           rect,
+            const std::uint32_t     pass_hash,
+            IAbortSwitch&           abort_switch) override
+        {
+            ++m_sub_tile_count;
+            m_pixel_counts[tile_x] += (rect.extent(0) + 1) * (rect.extent(1) + 1);
+        }
+
+        StatisticsVector get_statistics() const override
+        {
+            return StatisticsVector();
+        }
+    };
+
+    class CountingTileCallback
+      : public ITileCallback
+    {
+      public:
+        const CountingTileRenderer& m_renderer;
+        boost::atomic<size_t>       m_begin_counts[MaxTileCount];
+        boost::atomic<size_t>       m_end_counts[MaxTileCount];
+        boost::atomic<size_t>       m_incomplete_tile_count;
+
+        explicit CountingTileCallback(const CountingTileRenderer& renderer)
+          : m_renderer(renderer)
+          , m_incomplete_tile_count(0)
+        {
+            for (size_t i = 0; i < MaxTileCount; ++i)
+            {
+                m_begin_counts[i] = 0;
+                m_end_counts[i] = 0;
+            }
+        }
+
+        void release() override
+        {
+        }
+
+        void on_tiled_frame_begin(const Frame* frame) override
+        {
+        }
+
+        void on_tiled_frame_end(const Frame* frame) override
+        {
+        }
+
+        void on_tile_begin(
+            const Frame*            frame,
+            const size_t            tile_x,
+            const size_t            tile_y,
+            const size_t            thread_index,
+            const size_t            thread_count) override
+        {
+            ++m_begin_counts[tile_x];
+        }
+
+        void on_tile_end(
+            const Frame*            frame,
+            const size_t            tile_x,
+            const size_t            tile_y) override
+        {
+            ++m_end_counts[tile_x];
+
+            // The whole tile must be rendered when the tile ends.
+            if (m_renderer.m_pixel_counts[tile_x] != TileSize * TileSize)
+                ++m_incomplete_tile_count;
+        }
+
+        void on_progressive_frame_update(
+            const Frame&            frame,
+            const double            time,
+            const std::uint64_t     samples,
+            const double            samples_per_pixel,
+            const std::uint64_t     samples_per_second) override
+        {
+        }
+    };
+
+    // Render a row of tiles with one job per tile, letting jobs split tiles.
+    void render_tile_row(
+        const size_t                tile_count,
+        const size_t                sub_tile_count,
+        CountingTileRenderer&       renderer,
+        CountingTileCallback&       callback)
+    {
+        assert(tile_count <= MaxTileCount);
+
+        auto_release_ptr<Frame> frame(
+            FrameFactory::create(
+                "beauty",
+                ParamArray()
+                    .insert("resolution", to_string(tile_count * TileSize) + " " + to_string(TileSize))
+                    .insert("tile_size", to_string(TileSize) + " " + to_string(TileSize)),
+                AOVContainer()));
+
+        const TileJob::TileRendererVector tile_renderers(ThreadCount, &renderer);
+        const TileJob::TileCallbackVector tile_callbacks(ThreadCount, &callback);
+
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, ThreadCount);
+        AbortSwitch abort_switch;
+
+        for (size_t i = 0; i < tile_count; ++i)
+        {
+            job_queue.schedule(
+                new TileJob(
+                    tile_renderers,
+                    tile_callbacks,
+                    frame.ref(),
+                    i,
+                    0,
+                    ThreadCount,
+                    0,
+                    Spectrum::RGB,
+                    &job_queue,
+                    sub_tile_count,
+                    abort_switch));
+        }
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+    }
+
+    TEST_CASE(Execute_GivenTilesSplitForIdleThreads_CallsTileCallbacksOncePerTile)
+    {
+        CountingTileRenderer renderer;
+        CountingTileCallback callback(renderer);
+
+        // Fewer tiles than threads: tiles are split so that idle threads can help.
+        render_tile_row(2, 1, renderer, callback);
+
+        EXPECT_EQ(0, callback.m_incomplete_tile_count);
+
+        for (size_t i = 0; i < 2; ++i)
+        {
+            EXPECT_EQ(TileSize * TileSize, renderer.m_pixel_counts[i]);
+            EXPECT_EQ(1, callback.m_begin_counts[i]);
+            EXPECT_EQ(1, callback.m_end_counts[i]);
+        }
+    }
+
+    TEST_CASE(Execute_GivenSubTileCount_SplitsEveryTileAndCallsTileCallbacksOncePerTile)
+    {
+        CountingTileRenderer renderer;
+        CountingTileCallback callback(renderer);
+
+        // Tiles are split up front, as requested by adaptive job granularity.
+        render_tile_row(8, 4, renderer, callback);
+
+        EXPECT_EQ(0, renderer.m_tile_count);
+        EXPECT_EQ(8 * 4, renderer.m_sub_tile_count);
+        EXPECT_EQ(0, callback.m_incomplete_tile_count);
+
+        for (size_t i = 0; i < 8; ++i)
+        {
+            EXPECT_EQ(TileSize * TileSize, renderer.m_pixel_counts[i]);
+            EXPECT_EQ(1, callback.m_begin_counts[i]);
+            EXPECT_EQ(1, callback.m_end_counts[i]);
+        }
+    }
+
+    TEST_CASE(Execute_GivenSubTilesScheduledAheadOfWholeTiles_EndsEachTileOnceAfterAllItsSubTiles)
+    {
+        CountingTileRenderer renderer;
+        CountingTileCallback callback(renderer);
+
+        // High priority sub-tiles of several tiles are interleaved in the job queue.
+        render_tile_row(MaxTileCount, TileJob::MaxSubTileCount, renderer, callback);
+
+        EXPECT_EQ(0, renderer.m_tile_count);
+        EXPECT_EQ(MaxTileCount * TileJob::MaxSubTileCount, renderer.m_sub_tile_count);
+        EXPECT_EQ(0, callback.m_incomplete_tile_count);
+
+        for (size_t i = 0; i < MaxTileCount; ++i)
+        {
+            EXPECT_EQ(1, callback.m_begin_counts[i]);
+            EXPECT_EQ(1, callback.m_end_counts[i]);
+        }
+    }
+}
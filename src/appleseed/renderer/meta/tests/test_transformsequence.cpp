@@ -381,6 +381,39 @@ TEST_SUITE(Renderer_Utility_TransformSequence)
         EXPECT_FEQ(expected, m_sequence.evaluate(2.0));
     }
 
+    TEST_CASE_F(TransformSequenceCache_Evaluate_GivenSameTimeTwice_HitsCache, TwoTransformsFixture)
+    {
+        TransformSequenceCache cache;
+
+        const Transformd first = cache.evaluate(m_sequence, 2.0f);
+        const Transformd second = cache.evaluate(m_sequence, 2.0f);
+
+        EXPECT_EQ(m_sequence.evaluate(2.0f), first);
+        EXPECT_EQ(first, second);
+        EXPECT_EQ(1, cache.get_hit_count());
+        EXPECT_EQ(1, cache.get_miss_count());
+    }
+
+    TEST_CASE_F(TransformSequenceCache_Evaluate_GivenTimeOutsideSequence_ReturnsEndTransforms, TwoTransformsFixture)
+    {
+        TransformSequenceCache cache;
+
+        EXPECT_EQ(m_expected_first_transform, cache.evaluate(m_sequence, 0.0f));
+        EXPECT_EQ(m_expected_second_transform, cache.evaluate(m_sequence, 4.0f));
+    }
+
+    TEST_CASE_F(TransformSequenceCache_Evaluate_AfterSequenceIsPreparedAgain_ReturnsUpdatedTransform, TwoTransformsFixture)
+    {
+        TransformSequenceCache cache;
+        cache.evaluate(m_sequence, 2.0f);
+
+        m_sequence.set_transform(3.0f, Transformd::identity());
+        m_sequence.prepare();
+
+        EXPECT_EQ(m_sequence.evaluate(2.0f), cache.evaluate(m_sequence, 2.0f));
+        EXPECT_EQ(0, cache.get_hit_count());
+    }
+
     TEST_CASE(Evaluate_GivenTwoTransformsSetInReverseOrder_ReturnsCorrectlyInterpolatedTransform)
     {
         const Transformd ExpectedFirstTransform(
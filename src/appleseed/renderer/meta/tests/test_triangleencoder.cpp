@@ -0,0 +1,192 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
+#include "renderer/kernel/intersection/triangleencoder.h"
+#include "renderer/kernel/intersection/trianglevertexinfo.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/memory/memory.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Intersection_TriangleEncoder)
+{
+    GScalar max_abs_difference(const GVector3& lhs, const GVector3& rhs)
+    {
+        const GVector3 d = lhs - rhs;
+        return std::abs(d[max_abs_index(d)]);
+    }
+
+    struct Fixture
+    {
+        std::vector<TriangleVertexInfo>     m_vertex_infos;
+        std::vector<GVector3>               m_vertices;
+        std::vector<size_t>                 m_indices;
+
+        void add_triangle(
+            const GVector3&                 v0,
+            const GVector3&                 v1,
+            const GVector3&                 v2,
+            const std::uint32_t             vis_flags = ~std::uint32_t(0))
+        {
+            m_indices.push_back(m_vertex_infos.size());
+            m_vertex_infos.push_back(TriangleVertexInfo(m_vertices.size(), 0, vis_flags));
+            m_vertices.push_back(v0);
+            m_vertices.push_back(v1);
+            m_vertices.push_back(v2);
+        }
+
+        bool compute_compressed_size(const GScalar grid_step, size_t& size) const
+        {
+            return
+                TriangleEncoder::compute_compressed_size(
+                    m_vertex_infos,
+                    m_vertices,
+                    m_indices,
+                    0,
+                    m_indices.size(),
+                    grid_step,
+                    size);
+        }
+
+        std::vector<std::uint8_t> encode_compressed(const GScalar grid_step) const
+        {
+            size_t size;
+            compute_compressed_size(grid_step, size);
+
+            std::vector<std::uint8_t> data(size);
+            MemoryWriter writer(&data[0]);
+            TriangleEncoder::encode_compressed(
+                m_vertex_infos,
+                m_vertices,
+                m_indices,
+                0,
+                m_indices.size(),
+                grid_step,
+                writer);
+
+            return data;
+        }
+    };
+
+    TEST_CASE(ComputeGridStep_ReturnsPowerOfTwo)
+    {
+        std::vector<GVector3> vertices;
+        vertices.push_back(GVector3(0.5f, -3.0f, 1.0f));
+
+        const GScalar grid_step = TriangleEncoder::compute_grid_step(vertices);
+
+        int exponent;
+        EXPECT_EQ(GScalar(0.5), std::frexp(grid_step, &exponent));
+        EXPECT_TRUE(GScalar(3.0) / grid_step < GScalar(1 << 20));
+    }
+
+    TEST_CASE_F(EncodeCompressed_GivenTwoTrianglesSharingAnEdge_DecodesVerticesNearOriginalVertices, Fixture)
+    {
+        add_triangle(GVector3(0.1f, 0.2f, 0.3f), GVector3(0.11f, 0.2f, 0.3f), GVector3(0.1f, 0.21f, 0.3f));
+        add_triangle(GVector3(0.11f, 0.2f, 0.3f), GVector3(0.11f, 0.21f, 0.3f), GVector3(0.1f, 0.21f, 0.3f));
+
+        const GScalar grid_step = TriangleEncoder::compute_grid_step(m_vertices);
+        const std::vector<std::uint8_t> data = encode_compressed(grid_step);
+
+        // Header, 6 vertex indices, 4 distinct vertices and padding.
+        EXPECT_EQ(16 + 6 + 4 * 6 + 2, data.size());
+
+        const CompressedTriangleLeafReader reader(&data[0], 2, grid_step);
+        EXPECT_EQ(~std::uint32_t(0), reader.get_vis_flags());
+
+        for (size_t i = 0; i < 2; ++i)
+        {
+            // Vertices are decoded within half a grid step, but rebuilding them from
+            // the edges of the triangle introduces additional rounding errors.
+            const GTriangleType triangle = reader.read_triangle(i);
+            const GVector3 v0 = triangle.m_v0;
+            const GVector3 v1 = triangle.m_v0 + triangle.m_e0;
+            const GVector3 v2 = triangle.m_v0 + triangle.m_e1;
+
+            EXPECT_TRUE(max_abs_difference(m_vertices[i * 3 + 0], v0) <= grid_step / 2);
+            EXPECT_TRUE(max_abs_difference(m_vertices[i * 3 + 1], v1) <= grid_step);
+            EXPECT_TRUE(max_abs_difference(m_vertices[i * 3 + 2], v2) <= grid_step);
+        }
+    }
+
+    TEST_CASE_F(EncodeCompressed_GivenVertexSharedByTwoLeaves_DecodesVertexIdentically, Fixture)
+    {
+        const GVector3 shared(0.7f, -0.3f, 2.1f);
+        add_triangle(shared, GVector3(0.71f, -0.3f, 2.1f), GVector3(0.7f, -0.29f, 2.1f));
+        add_triangle(shared, GVector3(0.7f, -0.31f, 2.1f), GVector3(0.69f, -0.3f, 2.11f));
+
+        const GScalar grid_step = TriangleEncoder::compute_grid_step(m_vertices);
+
+        std::vector<std::uint8_t> data[2];
+        for (size_t i = 0; i < 2; ++i)
+        {
+            size_t size;
+            TriangleEncoder::compute_compressed_size(m_vertex_infos, m_vertices, m_indices, i, 1, grid_step, size);
+            data[i].resize(size);
+            MemoryWriter writer(&data[i][0]);
+            TriangleEncoder::encode_compressed(m_vertex_infos, m_vertices, m_indices, i, 1, grid_step, writer);
+        }
+
+        const GTriangleType triangle0 = CompressedTriangleLeafReader(&data[0][0], 1, grid_step).read_triangle(0);
+        const GTriangleType triangle1 = CompressedTriangleLeafReader(&data[1][0], 1, grid_step).read_triangle(0);
+
+        EXPECT_EQ(triangle0.m_v0, triangle1.m_v0);
+    }
+
+    TEST_CASE_F(ComputeCompressedSize_GivenTrianglesWithDifferentVisibilityFlags_ReturnsFalse, Fixture)
+    {
+        add_triangle(GVector3(0.0f, 0.0f, 0.0f), GVector3(1.0f, 0.0f, 0.0f), GVector3(0.0f, 1.0f, 0.0f), 1);
+        add_triangle(GVector3(0.0f, 0.0f, 0.0f), GVector3(1.0f, 0.0f, 0.0f), GVector3(0.0f, 1.0f, 0.0f), 2);
+
+        size_t size;
+        EXPECT_FALSE(compute_compressed_size(TriangleEncoder::compute_grid_step(m_vertices), size));
+    }
+
+    TEST_CASE_F(ComputeCompressedSize_GivenTriangleSpanningTooManyGridCells_ReturnsFalse, Fixture)
+    {
+        // The grid step is about a millionth of the largest vertex coordinate.
+        add_triangle(GVector3(-1.0f, 0.0f, 0.0f), GVector3(1.0f, 0.0f, 0.0f), GVector3(0.0f, 1.0f, 0.0f));
+
+        size_t size;
+        EXPECT_FALSE(compute_compressed_size(TriangleEncoder::compute_grid_step(m_vertices), size));
+    }
+}
@@ -37,6 +37,8 @@
 #include "renderer/kernel/texturing/oiiotexturesystem.h"
 #include "renderer/kernel/texturing/texturecache.h"
 #include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/kernel/volume/sparsevoxelgrid.h"
+#include "renderer/kernel/volume/volume.h"
 #include "renderer/modeling/entity/onframebeginrecorder.h"
 #include "renderer/modeling/input/scalarsource.h"
 #include "renderer/modeling/scene/assembly.h"
@@ -44,6 +46,7 @@
 #include "renderer/modeling/scene/scene.h"
 #include "renderer/modeling/texture/texture.h"
 #include "renderer/modeling/volume/genericvolume.h"
+#include "renderer/modeling/volume/gridvolume.h"
 #include "renderer/modeling/volume/volume.h"
 #include "renderer/utility/paramarray.h"
 #include "renderer/utility/testutils.h"
@@ -59,6 +62,7 @@
 #include "foundation/utility/test.h"
 
 // Standard headers.
+#include <cmath>
 #include <cstddef>
 #include <memory>
 #include <vector>
@@ -351,4 +355,59 @@ TEST_SUITE(Renderer_Modeling_Volume)
 
         plotfile.write("unit tests/outputs/test_volume_henyey_samples.gnuplot");
     }
+
+    TEST_CASE(GridVolume_ConstantDensity_TransmissionMatchesBeerLambertLaw)
+    {
+        const char* FileName = "unit tests/outputs/test_volume_grid.svg";
+
+        VoxelGrid grid(8, 8, 8, 1);
+        for (size_t z = 0; z < 8; ++z)
+        {
+            for (size_t y = 0; y < 8; ++y)
+            {
+                for (size_t x = 0; x < 8; ++x)
+                    grid.voxel(x, y, z)[0] = 0.5f;
+            }
+        }
+
+        ASSERT_TRUE(write_sparse_voxel_grid(FileName, grid, 0));
+
+        TestSceneBase test_scene;
+
+        auto_release_ptr<Assembly> assembly(
+            AssemblyFactory().create("assembly", ParamArray()));
+
+        auto_release_ptr<Volume> volume =
+            GridVolumeFactory().create("volume",
+                ParamArray()
+                    .insert("filename", FileName)
+                    .insert("bbox_min", "0.0 0.0 0.0")
+                    .insert("bbox_max", "2.0 2.0 2.0")
+                    .insert("absorption", 0.25f)
+                    .insert("scattering", 0.75f));
+        Volume& volume_ref = volume.ref();
+        assembly->volumes().insert(volume);
+
+        test_scene.m_scene.assemblies().insert(assembly);
+
+        VolumeTestSceneContext context(test_scene);
+
+        ShadingRay shading_ray;
+        shading_ray.m_org = Vector3d(-1.0, 1.0, 1.0);
+        shading_ray.m_dir = Vector3d(1.0, 0.0, 0.0);
+        shading_ray.m_tmin = 0.0;
+        shading_ray.m_tmax = 10.0;
+
+        void* data = volume_ref.evaluate_inputs(context.m_shading_context, shading_ray);
+        volume_ref.prepare_inputs(context.m_arena, shading_ray, data);
+
+        // The ray crosses 2 units of media with an extinction coefficient of 0.5.
+        Spectrum transmission;
+        volume_ref.evaluate_transmission(data, shading_ray, transmission);
+        EXPECT_FEQ_EPS(std::exp(-1.0f), transmission[0], 1.0e-3f);
+
+        // Halfway through the media.
+        volume_ref.evaluate_transmission(data, shading_ray, 2.0f, transmission);
+        EXPECT_FEQ_EPS(std::exp(-0.5f), transmission[0], 1.0e-3f);
+    }
 }
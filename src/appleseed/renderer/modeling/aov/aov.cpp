@@ -32,19 +32,25 @@
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
 #include "renderer/kernel/aov/imagestack.h"
+#include "renderer/utility/messagecontext.h"
+#include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
 #include "foundation/image/color.h"
 #include "foundation/image/genericimagefilewriter.h"
 #include "foundation/image/image.h"
 #include "foundation/image/imageattributes.h"
+#include "foundation/math/vector.h"
 #include "foundation/platform/defaulttimers.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/api/apistring.h"
+#include "foundation/utility/makevector.h"
 #include "foundation/utility/stopwatch.h"
 
 // Standard headers.
 #include <exception>
+#include <memory>
+#include <string>
 
 using namespace foundation;
 
@@ -71,6 +77,7 @@ AOV::AOV(
   : Entity(g_class_uid,     params)
   , m_image(nullptr)
   , m_image_index(~size_t(0))
+  , m_crop_window(Vector2u(0, 0), Vector2u(~size_t(0), ~size_t(0)))
 {
     set_name(name);
 }
@@ -85,6 +92,18 @@ Image& AOV::get_image() const
     return *m_image;
 }
 
+PixelFormat AOV::get_storage_format() const
+{
+    const std::string storage_format =
+        m_params.get_optional<std::string>(
+            "storage_format",
+            get_default_storage_format() == PixelFormatHalf ? "half" : "float",
+            make_vector("half", "float"),
+            EntityDefMessageContext("aov", this));
+
+    return storage_format == "half" ? PixelFormatHalf : PixelFormatFloat;
+}
+
 void AOV::post_process_image(const Frame& frame)
 {
 }
@@ -100,7 +119,32 @@ bool AOV::write_images(
     {
         GenericImageFileWriter writer(file_path);
 
-        writer.append_image(&get_image());
+        // Only store the crop window of the image, placed inside the full frame.
+        const CanvasProperties& props = m_image->properties();
+        const AABB2u full_window(
+            Vector2u(0, 0),
+            Vector2u(props.m_canvas_width - 1, props.m_canvas_height - 1));
+        const AABB2u data_window = AABB2u::intersect(m_crop_window, full_window);
+
+        std::unique_ptr<Image> cropped_image;
+        if (data_window.is_valid() && data_window != full_window)
+        {
+            cropped_image.reset(
+                new Image(
+                    *m_image,
+                    data_window,
+                    props.m_tile_width,
+                    props.m_tile_height,
+                    props.m_pixel_format));
+
+            writer.append_image(cropped_image.get());
+            writer.set_image_data_window(
+                data_window.min.x,
+                data_window.min.y,
+                props.m_canvas_width,
+                props.m_canvas_height);
+        }
+        else writer.append_image(m_image);
 
         if (has_color_data())
             writer.set_image_output_format(PixelFormatHalf);
@@ -149,12 +193,17 @@ void AOV::create_image(
         m_image_index = aov_images.append(
             get_name(),
             get_channel_count(),
-            PixelFormatFloat);
+            get_storage_format());
     }
 
     m_image = &aov_images.get_image(m_image_index);
 }
 
+PixelFormat AOV::get_default_storage_format() const
+{
+    return PixelFormatFloat;
+}
+
 
 //
 // ColorAOV class implementation.
@@ -183,7 +232,7 @@ bool ColorAOV::has_color_data() const
 
 void ColorAOV::clear_image()
 {
-    m_image->clear(Color4f(0.0f));
+    m_image->clear(Color4f(0.0f), m_crop_window);
 }
 
 
@@ -219,7 +268,7 @@ bool UnfilteredAOV::has_color_data() const
 
 void UnfilteredAOV::clear_image()
 {
-    m_image->clear(Color3f(0.0f));
+    m_image->clear(Color3f(0.0f), m_crop_window);
 }
 
 void UnfilteredAOV::create_image(
@@ -236,7 +285,7 @@ void UnfilteredAOV::create_image(
             tile_width,
             tile_height,
             get_channel_count(),
-            PixelFormatFloat);
+            get_storage_format());
 
     // We need to clear the image because the default channel value might not be zero.
     clear_image();
@@ -32,6 +32,8 @@
 #include "renderer/modeling/entity/entity.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/pixel.h"
+#include "foundation/math/aabb.h"
 #include "foundation/memory/autoreleaseptr.h"
 #include "foundation/utility/uid.h"
 
@@ -82,6 +84,10 @@ class APPLESEED_DLLSYMBOL AOV
     // Return true if this AOV contains color data.
     virtual bool has_color_data() const = 0;
 
+    // Return the pixel format of the AOV image, as set by the "storage_format"
+    // parameter ("half" or "float") or the default of this AOV otherwise.
+    foundation::PixelFormat get_storage_format() const;
+
     // Return a reference to the AOV image.
     foundation::Image& get_image() const;
 
@@ -102,6 +108,12 @@ class APPLESEED_DLLSYMBOL AOV
 
     foundation::Image*  m_image;
     size_t              m_image_index;
+    foundation::AABB2u  m_crop_window;      // crop window of the frame, only these pixels are cleared and written
+
+    // Return the pixel format of the AOV image when none is specified. Defaults to
+    // single precision; AOVs with a limited range (normals, UVs, albedo) use half
+    // precision to save memory.
+    virtual foundation::PixelFormat get_default_storage_format() const;
 
     // Create an image to store the AOV result.
     virtual void create_image(
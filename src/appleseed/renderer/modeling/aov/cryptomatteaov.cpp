@@ -75,6 +75,7 @@
 #include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <limits>
 #include <map>
 #include <memory>
 #include <sstream>
@@ -273,117 +274,109 @@ namespace
         }
     };
 
-    class WeightMap
+    //
+    // Fixed-capacity set of (ID, weight) pairs for a single pixel.
+    //
+    // Entries live in a slice of a tile-local arena owned by the accumulator, so accumulating
+    // samples never allocates. When all slots are taken, the incoming ID replaces the entry
+    // with the lowest weight (ties broken on the highest ID) and inherits its weight. This
+    // keeps the total weight of the pixel intact and only depends on the order of the samples
+    // within the pixel, which is fixed, so results are identical from one run to the next
+    // regardless of the number of rendering threads.
+    //
+
+    class PixelCoverage
     {
       public:
         struct Entry
         {
             std::uint32_t   m_key;
             float           m_value;
-
-            Entry()
-              : m_key(0)
-              , m_value(0.0f)
-            {
-            }
         };
 
-        explicit WeightMap(const size_t size)
-          : m_size(static_cast<std::uint32_t>(size))
-          , m_index(0)
+        PixelCoverage(
+            Entry*          entries,
+            std::uint32_t&  size,
+            const size_t    capacity)
+          : m_entries(entries)
+          , m_size(size)
+          , m_capacity(capacity)
         {
-            assert(size > 0);
-            m_map = new Entry[size];
+            assert(capacity > 0);
         }
 
-        WeightMap(const WeightMap& other)
-          : m_size(other.m_size)
-          , m_index(other.m_index)
+        void add(const std::uint32_t key, const float value)
         {
-            m_map = new Entry[m_size];
-            for (size_t i = 0; i < m_index; ++i)
-                m_map[i] = other.m_map[i];
-        }
+            size_t lowest = 0;
 
-        WeightMap& operator=(const WeightMap& rhs)
-        {
-            if (m_size != rhs.m_size)
+            for (size_t i = 0; i < m_size; ++i)
             {
-                delete[] m_map;
-                m_map = new Entry[rhs.m_size];
-            }
-
-            m_size = rhs.m_size;
-            m_index = rhs.m_size;
-            for (size_t i = 0; i < m_index; ++i)
-                m_map[i] = rhs.m_map[i];
-
-            return *this;
-        }
-
-        ~WeightMap()
-        {
-            delete[] m_map;
-        }
-
-        void insert(const std::uint32_t key, const float value)
-        {
-            assert(m_map);
-
-            for (size_t i = 0; i < m_index; ++i)
-            {
-                if (m_map[i].m_key == key)
+                if (m_entries[i].m_key == key)
                 {
-                    m_map[i].m_value = value;
+                    m_entries[i].m_value += value;
                     return;
                 }
+
+                if (ranks_before(m_entries[lowest], m_entries[i]))
+                    lowest = i;
             }
 
-            if (m_index < m_size)
+            if (m_size < m_capacity)
             {
-                m_map[m_index].m_key = key;
-                m_map[m_index].m_value = value;
-                ++m_index;
+                m_entries[m_size].m_key = key;
+                m_entries[m_size].m_value = value;
+                ++m_size;
+                return;
             }
+
+            m_entries[lowest].m_key = key;
+            m_entries[lowest].m_value += value;
         }
 
-        float get(const std::uint32_t key) const
+        // Sort entries by decreasing weight, then by increasing ID.
+        void sort()
         {
-            assert(m_map);
-
-            for (size_t i = 0; i < m_index; ++i)
-            {
-                if (m_map[i].m_key == key)
-                    return m_map[i].m_value;
-            }
+            std::sort(m_entries, m_entries + m_size, ranks_before);
+        }
 
-            return 0.0f;
+        bool empty() const
+        {
+            return m_size == 0;
         }
 
-        void clear()
+        size_t size() const
         {
-            m_index = 0;
+            return m_size;
         }
 
-        bool empty() const
+        const Entry& operator[](const size_t i) const
         {
-            return m_index == 0;
+            assert(i < m_size);
+            return m_entries[i];
         }
 
-        Entry* begin() const
+        const Entry* begin() const
         {
-            return m_map;
+            return m_entries;
         }
 
-        Entry* end() const
+        const Entry* end() const
         {
-            return m_map + m_index;
+            return m_entries + m_size;
         }
 
       private:
-        std::uint32_t   m_size;
-        std::uint32_t   m_index;
-        Entry*          m_map;
+        Entry*          m_entries;
+        std::uint32_t&  m_size;
+        const size_t    m_capacity;
+
+        static bool ranks_before(const Entry& lhs, const Entry& rhs)
+        {
+            return
+                lhs.m_value != rhs.m_value
+                    ? lhs.m_value > rhs.m_value
+                    : lhs.m_key < rhs.m_key;
+        }
     };
 
     // Code taken from Cryptomatte specification.
@@ -418,16 +411,27 @@ namespace
       public:
         CryptomatteAOVAccumulator(
             Image&                              aov_image,
-            std::vector<WeightMap>&             pixel_samples,
             NameMap*                            tile_name_array,
             size_t                              num_layers,
             CryptomatteAOV::CryptomatteType     layer_type)
           : m_aov_image(aov_image)
           , m_num_layers(num_layers)
-          , m_pixel_samples(pixel_samples)
+          , m_capacity(std::max<size_t>(num_layers * CoverageSlotsPerLayer, 1))
           , m_tile_name_maps(tile_name_array)
           , m_layer_type(layer_type)
         {
+            // Allocate the tile-local arena once, large enough for the biggest tile.
+            const CanvasProperties& props = m_aov_image.properties();
+            const size_t max_tile_pixel_count = props.m_tile_width * props.m_tile_height;
+            m_arena_entries.resize(max_tile_pixel_count * m_capacity);
+            m_arena_sizes.resize(max_tile_pixel_count, 0);
+            m_pixel_values.resize(3 + m_num_layers * 2);
+        }
+
+        bool supports_sub_tiles() const override
+        {
+            // Pixel samples are ranked over whole tiles in on_tile_end().
+            return false;
         }
 
         void on_tile_begin(
@@ -440,8 +444,8 @@ namespace
             const CanvasProperties& props = frame.image().properties();
             const Tile& tile = frame.image().tile(tile_x, tile_y);
 
-            m_frame_width = props.m_canvas_width;
-            m_tile_index = tile_y * props.m_tile_count_y + tile_x;
+            m_tile_width = props.m_tile_width;
+            m_tile_index = tile_y * props.m_tile_count_x + tile_x;
 
             // Fetch the tile bounds (inclusive).
             m_tile_origin_x = tile_x * props.m_tile_width;
@@ -449,11 +453,7 @@ namespace
             m_tile_end_x = m_tile_origin_x + tile.get_width() - 1;
             m_tile_end_y = m_tile_origin_y + tile.get_height() - 1;
 
-            for (size_t ry = m_tile_origin_y; ry <= m_tile_end_y; ++ry)
-            {
-                for (size_t rx = m_tile_origin_x; rx <= m_tile_end_x; ++rx)
-                    m_pixel_samples[ry * m_frame_width + rx].clear();
-            }
+            std::fill(m_arena_sizes.begin(), m_arena_sizes.end(), 0);
 
             m_crop_window =
                 frame.has_crop_window()
@@ -466,82 +466,65 @@ namespace
             const size_t                tile_x,
             const size_t                tile_y) override
         {
-            std::vector<std::pair<float, std::uint32_t>> ranked_vector;
-            std::vector<float> pixel_values;
             constexpr float uint32_max_rcp = 1.0f / std::numeric_limits<std::uint32_t>::max();
 
             for (size_t ry = m_tile_origin_y; ry <= m_tile_end_y; ++ry)
             {
                 for (size_t rx = m_tile_origin_x; rx <= m_tile_end_x; ++rx)
                 {
-                    const WeightMap& weight_map = m_pixel_samples[ry * m_frame_width + rx];
+                    PixelCoverage coverage = get_pixel_coverage(rx - m_tile_origin_x, ry - m_tile_origin_y);
 
-                    if (!weight_map.empty())
-                    {
-                        clear_keep_memory(ranked_vector);
-                        clear_keep_memory(pixel_values);
-
-                        float total_weight = 0.0f;
-                        for (const auto& item : weight_map)
-                            total_weight += item.m_value;
+                    if (coverage.empty())
+                        continue;
 
-                        if (total_weight == 0.0f)
-                            total_weight = 1.0f;
+                    float total_weight = 0.0f;
+                    for (const auto& item : coverage)
+                        total_weight += item.m_value;
 
-                        for (const auto& item : weight_map)
-                            ranked_vector.push_back(std::make_pair(item.m_value, item.m_key));
+                    if (total_weight == 0.0f)
+                        total_weight = 1.0f;
 
-                        sort(ranked_vector.begin(), ranked_vector.end(),
-                            [](std::pair<float, std::uint32_t> const& a, std::pair<float, std::uint32_t> const& b)
-                            {
-                                return a.first > b.first;
-                            });
+                    coverage.sort();
 
-                        const std::uint32_t m3hash_preview = ranked_vector[0].second;
+                    const std::uint32_t m3hash_preview = coverage[0].m_key;
+                    float* pixel_values = m_pixel_values.data();
 
-                        // Preview channels (deprecated in recent Cryptomatte specification).
-                        float r(0.0f), g(0.0f), b(0.0f);
-                        if (m3hash_preview != 0)
-                        {
-                            r = hash_to_float(m3hash_preview);
-                            g = static_cast<float>(m3hash_preview << 8) * uint32_max_rcp;
-                            b = static_cast<float>(m3hash_preview << 16) * uint32_max_rcp;
-                        }
-                        pixel_values.push_back(r);
-                        pixel_values.push_back(g);
-                        pixel_values.push_back(b);
-
-                        // Remove background contribution.
-                        size_t ranked_vector_start = 0;
-                        if (ranked_vector.size() > 1 && m3hash_preview == 0)
-                            ranked_vector_start = 1;
-
-                        // Ranked channels.
-                        for (size_t i = ranked_vector_start, e = std::min(ranked_vector.size(), m_num_layers); i < e; ++i)
+                    // Preview channels (deprecated in recent Cryptomatte specification).
+                    float r(0.0f), g(0.0f), b(0.0f);
+                    if (m3hash_preview != 0)
+                    {
+                        r = hash_to_float(m3hash_preview);
+                        g = static_cast<float>(m3hash_preview << 8) * uint32_max_rcp;
+                        b = static_cast<float>(m3hash_preview << 16) * uint32_max_rcp;
+                    }
+                    *pixel_values++ = r;
+                    *pixel_values++ = g;
+                    *pixel_values++ = b;
+
+                    // Remove background contribution.
+                    size_t ranked_start = 0;
+                    if (coverage.size() > 1 && m3hash_preview == 0)
+                        ranked_start = 1;
+
+                    // Ranked channels.
+                    const size_t ranked_end = std::min(coverage.size(), ranked_start + m_num_layers);
+                    for (size_t i = ranked_start; i < ranked_end; ++i)
+                    {
+                        const std::uint32_t m3hash = coverage[i].m_key;
+                        float rank(0.0f), weight(0.0f);
+                        if (m3hash != 0)
                         {
-                            const std::uint32_t m3hash = ranked_vector[i].second;
-                            float rank(0.0f), coverage(0.0f);
-                            if (m3hash != 0)
-                            {
-                                rank = hash_to_float(m3hash);
-                                coverage = ranked_vector[i].first / total_weight;
-                            }
-                            pixel_values.push_back(rank);
-                            pixel_values.push_back(coverage);
+                            rank = hash_to_float(m3hash);
+                            weight = coverage[i].m_value / total_weight;
                         }
+                        *pixel_values++ = rank;
+                        *pixel_values++ = weight;
+                    }
 
-                        // Set the remaining channels of the pixel to black.
-                        // This is determined by taking 2 channels per ranked vector plus
-                        // 3 channels for the preview image and subtracting that from the
-                        // total number of AOV channels.
-                        const size_t num_channels = (m_num_layers * 2) + 3;
-                        const size_t filled_channels = (ranked_vector.size() - ranked_vector_start) * 2 + 3;
-
-                        for (size_t i = filled_channels; i < num_channels; ++i)
-                            pixel_values.push_back(0.0f);
+                    // Set the remaining channels of the pixel to black.
+                    std::fill(pixel_values, m_pixel_values.data() + m_pixel_values.size(), 0.0f);
 
-                        m_aov_image.set_pixel(rx, ry, pixel_values.data(), pixel_values.size());
-                    }
+                    m_aov_image.set_pixel(rx, ry, m_pixel_values.data(), m_pixel_values.size());
                 }
             }
         }
@@ -569,8 +552,14 @@ namespace
             const AOVComponents&        aov_components,
             ShadingResult&              shading_result) override
         {
+            const Vector2u pixel_pos(pixel_context.get_pixel_coords());
+
+            // Ignore samples outside the crop window.
+            if (!m_crop_window.contains(pixel_pos))
+                return;
+
             std::uint32_t m3hash = 0;
-            std::string obj_name;
+            const char* obj_name = "";
 
             if (shading_point.hit_surface())
             {
@@ -591,40 +580,48 @@ namespace
                   assert_otherwise;
                 }
 
-                MurmurHash3_x86_32(reinterpret_cast<const unsigned char*>(obj_name.c_str()), static_cast<int>(obj_name.size()), 0, &m3hash);
+                MurmurHash3_x86_32(reinterpret_cast<const unsigned char*>(obj_name), static_cast<int>(std::strlen(obj_name)), 0, &m3hash);
             }
 
-            const Vector2u pixel_pos(pixel_context.get_pixel_coords());
+            // Only record names the first time they are seen in this tile.
+            NameMap& name_map = m_tile_name_maps[m_tile_index];
+            const NameMap::iterator it = name_map.lower_bound(m3hash);
+            if (it == name_map.end() || it->first != m3hash)
+                name_map.emplace_hint(it, m3hash, obj_name);
 
-            // Ignore samples outside the crop window.
-            if (!m_crop_window.contains(pixel_pos))
-                return;
-
-            m_tile_name_maps[m_tile_index][m3hash] = obj_name;
-
-            const size_t x = pixel_pos.x - m_tile_origin_x;
-            const size_t y = pixel_pos.y - m_tile_origin_y;
-
-            WeightMap& weight_map =
-                m_pixel_samples[(m_tile_origin_y + y) * m_frame_width + (m_tile_origin_x + x)];
-
-            const float old_value = weight_map.get(m3hash);
-            weight_map.insert(m3hash, old_value + 1.0f);
+            get_pixel_coverage(pixel_pos.x - m_tile_origin_x, pixel_pos.y - m_tile_origin_y).add(m3hash, 1.0f);
         }
 
       private:
-        size_t                          m_tile_origin_x;
-        size_t                          m_tile_origin_y;
-        size_t                          m_tile_end_x;
-        size_t                          m_tile_end_y;
-        size_t                          m_tile_index;
-        size_t                          m_frame_width;
-        AABB2u                          m_crop_window;
-        Image&                          m_aov_image;
-        size_t                          m_num_layers;
-        std::vector<WeightMap>&         m_pixel_samples;
-        NameMap*                        m_tile_name_maps;
-        CryptomatteAOV::CryptomatteType m_layer_type;
+        // Number of coverage slots kept per pixel for each Cryptomatte layer.
+        // Extra slots beyond the layer count reduce the error of merged weights.
+        enum { CoverageSlotsPerLayer = 2 };
+
+        size_t                              m_tile_origin_x;
+        size_t                              m_tile_origin_y;
+        size_t                              m_tile_end_x;
+        size_t                              m_tile_end_y;
+        size_t                              m_tile_index;
+        size_t                              m_tile_width;
+        AABB2u                              m_crop_window;
+        Image&                              m_aov_image;
+        const size_t                        m_num_layers;
+        const size_t                        m_capacity;
+        std::vector<PixelCoverage::Entry>   m_arena_entries;
+        std::vector<std::uint32_t>          m_arena_sizes;
+        std::vector<float>                  m_pixel_values;
+        NameMap*                            m_tile_name_maps;
+        CryptomatteAOV::CryptomatteType     m_layer_type;
+
+        PixelCoverage get_pixel_coverage(const size_t x, const size_t y)
+        {
+            const size_t pixel_index = y * m_tile_width + x;
+            return
+                PixelCoverage(
+                    &m_arena_entries[pixel_index * m_capacity],
+                    m_arena_sizes[pixel_index],
+                    m_capacity);
+        }
     };
 }
 
@@ -641,7 +638,6 @@ namespace
 
 struct CryptomatteAOV::Impl
 {
-    std::vector<WeightMap>              m_pixel_samples;
     NameMap*                            m_tile_name_maps;
     std::unique_ptr<Image>              m_image;
     size_t                              m_num_layers;
@@ -794,7 +790,6 @@ void CryptomatteAOV::create_image(
             tile_height,
             channel_count,
             PixelFormatFloat));
-    impl->m_pixel_samples.resize(canvas_width * canvas_height, WeightMap(impl->m_num_layers));
     const auto& image_props = impl->m_image->properties();
     impl->m_tile_name_maps = new NameMap[image_props.m_tile_count];
     clear_image();
@@ -807,9 +802,13 @@ void CryptomatteAOV::clear_image()
     const size_t channel_count = impl->get_channel_count();
     const std::vector<float> pixel_values(channel_count, 0.0f);
 
-    for (size_t y = 0, h = image_props.m_canvas_height; y < h; ++y)
+    // Pixels outside the crop window are never rendered, leave their tiles unallocated.
+    const size_t max_x = std::min(m_crop_window.max.x, image_props.m_canvas_width - 1);
+    const size_t max_y = std::min(m_crop_window.max.y, image_props.m_canvas_height - 1);
+
+    for (size_t y = m_crop_window.min.y; y <= max_y; ++y)
     {
-        for (size_t x = 0, w = image_props.m_canvas_width; x < w; ++x)
+        for (size_t x = m_crop_window.min.x; x <= max_x; ++x)
             impl->m_image->set_pixel(x, y, pixel_values.data(), pixel_values.size());
     }
 
@@ -823,7 +822,6 @@ auto_release_ptr<AOVAccumulator> CryptomatteAOV::create_accumulator() const
         auto_release_ptr<AOVAccumulator>(
             new CryptomatteAOVAccumulator(
                 *impl->m_image,
-                impl->m_pixel_samples,
                 impl->m_tile_name_maps,
                 impl->m_num_layers,
                 impl->m_layer_type));
@@ -32,6 +32,7 @@
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
 #include "renderer/kernel/aov/aovaccumulator.h"
+#include "renderer/kernel/denoising/compacthistogrambuffer.h"
 #include "renderer/kernel/rendering/pixelcontext.h"
 #include "renderer/kernel/shading/shadingcomponents.h"
 #include "renderer/kernel/shading/shadingresult.h"
@@ -57,8 +58,10 @@
 #include "boost/filesystem.hpp"
 
 // Standard headers.
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <vector>
 
 using namespace bcd;
 using namespace foundation;
@@ -72,23 +75,25 @@ namespace
     //
     // Denoiser AOV accumulator.
     //
+    // Histograms are accumulated at full precision in a buffer local to the tile being
+    // rendered, and merged into the compact histogram buffer once the tile is complete.
+    //
 
     class DenoiserAOVAccumulator
       : public AOVAccumulator
     {
       public:
         DenoiserAOVAccumulator(
-            const size_t   num_bins,
-            const float    gamma,
-            const float    max_value,
-            Deepimf&       sum_accum,
-            Deepimf&       covariance_accum,
-            Deepimf&       histograms)
+            const size_t                num_bins,
+            const float                 gamma,
+            const float                 max_value,
+            Deepimf&                    sum_accum,
+            Deepimf&                    covariance_accum,
+            CompactHistogramBuffer&     histograms)
           : m_num_bins(num_bins)
           , m_gamma(gamma)
           , m_rcp_gamma(1.0f / gamma)
           , m_max_value(max_value)
-          , m_samples_channel_index(3 * num_bins)
           , m_sum_accum(sum_accum)
           , m_covariance_accum(covariance_accum)
           , m_histograms(histograms)
@@ -110,6 +115,41 @@ namespace
             m_tile_origin_y = static_cast<int>(tile_y * props.m_tile_height);
             m_tile_end_x = static_cast<int>(m_tile_origin_x + tile.get_width() - 1);
             m_tile_end_y = static_cast<int>(m_tile_origin_y + tile.get_height() - 1);
+
+            // Clear the tile histograms.
+            m_tile_width = tile.get_width();
+            m_tile_histograms.assign(tile.get_pixel_count() * 3 * m_num_bins, 0.0f);
+            m_tile_sample_counts.assign(tile.get_pixel_count(), 0.0f);
+        }
+
+        void on_tile_end(
+            const Frame&                frame,
+            const size_t                tile_x,
+            const size_t                tile_y) override
+        {
+            // Merge the tile histograms into the compact histogram buffer. Only pixels
+            // that received samples are merged since tiles may be rendered in parts by
+            // several threads.
+            const size_t tile_height = m_tile_sample_counts.size() / m_tile_width;
+            const size_t bin_count = 3 * m_num_bins;
+
+            for (size_t y = 0; y < tile_height; ++y)
+            {
+                for (size_t x = 0; x < m_tile_width; ++x)
+                {
+                    const size_t pixel_index = y * m_tile_width + x;
+                    const float sample_count = m_tile_sample_counts[pixel_index];
+
+                    if (sample_count > 0.0f)
+                    {
+                        m_histograms.add(
+                            m_tile_origin_x + x,
+                            m_tile_origin_y + y,
+                            &m_tile_histograms[pixel_index * bin_count],
+                            sample_count);
+                    }
+                }
+            }
         }
 
         void on_sample_begin(
@@ -135,8 +175,12 @@ namespace
             // Accumulate unpremultiplied samples.
             m_accum.unpremultiply_in_place();
 
-            // Update the num samples channel.
-            m_histograms.get(pi.y, pi.x, static_cast<int>(m_samples_channel_index)) += 1.0f;
+            // Update the sample count of the pixel.
+            const size_t pixel_index =
+                static_cast<size_t>(pi.y - m_tile_origin_y) * m_tile_width +
+                static_cast<size_t>(pi.x - m_tile_origin_x);
+            m_tile_sample_counts[pixel_index] += 1.0f;
+            float* histogram = &m_tile_histograms[pixel_index * 3 * m_num_bins];
 
             // Update the sum and covariance accumulator.
             m_sum_accum.get(pi.y, pi.x, 0) += m_accum.r;
@@ -202,15 +246,8 @@ namespace
                     floor_bin_weight = 1.0f - ceil_bin_weight;
                 }
 
-                m_histograms.get(
-                    pi.y,
-                    pi.x,
-                    static_cast<int>(start_bin + floor_bin_index)) += floor_bin_weight;
-
-                m_histograms.get(
-                    pi.y,
-                    pi.x,
-                    static_cast<int>(start_bin + ceil_bin_index)) += ceil_bin_weight;
+                histogram[start_bin + floor_bin_index] += floor_bin_weight;
+                histogram[start_bin + ceil_bin_index] += ceil_bin_weight;
             }
         }
 
@@ -232,24 +269,26 @@ namespace
         }
 
       private:
-        Color4f         m_accum;
-        size_t          m_sample_count;
+        Color4f                     m_accum;
+        size_t                      m_sample_count;
 
-        const size_t    m_num_bins;
-        const float     m_gamma;
-        const float     m_rcp_gamma;
-        const float     m_max_value;
-        const size_t    m_samples_channel_index;
+        const size_t                m_num_bins;
+        const float                 m_gamma;
+        const float                 m_rcp_gamma;
+        const float                 m_max_value;
 
-        int             m_tile_origin_x;
-        int             m_tile_origin_y;
-        int             m_tile_end_x;
-        int             m_tile_end_y;
+        int                         m_tile_origin_x;
+        int                         m_tile_origin_y;
+        int                         m_tile_end_x;
+        int                         m_tile_end_y;
+        size_t                      m_tile_width;
 
-        Deepimf&        m_sum_accum;
-        Deepimf&        m_covariance_accum;
+        Deepimf&                    m_sum_accum;
+        Deepimf&                    m_covariance_accum;
 
-        Deepimf&        m_histograms;
+        CompactHistogramBuffer&     m_histograms;
+        std::vector<float>          m_tile_histograms;
+        std::vector<float>          m_tile_sample_counts;
 
         bool outside_tile(const Vector2i& pi) const
         {
@@ -278,7 +317,7 @@ struct DenoiserAOV::Impl
     Deepimf m_sum_accum;
     Deepimf m_covariance_accum;
 
-    Deepimf m_histograms;
+    CompactHistogramBuffer m_histograms;
 };
 
 DenoiserAOV::DenoiserAOV(
@@ -330,7 +369,7 @@ void DenoiserAOV::create_image(
 
     impl->m_sum_accum.resize(w, h, 3);
     impl->m_covariance_accum.resize(w, h, 6);
-    impl->m_histograms.resize(w, h, 3 * bins + 1);
+    impl->m_histograms.resize(canvas_width, canvas_height, 3 * bins);
 
     clear_image();
 }
@@ -339,45 +378,31 @@ void DenoiserAOV::clear_image()
 {
     impl->m_sum_accum.fill(0.0f);
     impl->m_covariance_accum.fill(0.0f);
-    impl->m_histograms.fill(0.0f);
+    impl->m_histograms.clear();
 }
 
 void DenoiserAOV::fill_empty_samples() const
 {
-    const int w = impl->m_histograms.getWidth();
-    const int h = impl->m_histograms.getHeight();
+    const size_t w = impl->m_histograms.get_width();
+    const size_t h = impl->m_histograms.get_height();
+
+    const size_t num_bins = impl->m_num_bins;
 
-    const int num_bins = static_cast<int>(impl->m_num_bins);
-    const int samples_channel_index = num_bins * 3;
+    std::vector<float> bins(3 * num_bins, 0.0f);
+    bins[0] = 1.0f;
+    bins[num_bins] = 1.0f;
+    bins[num_bins * 2] = 1.0f;
 
-    for (int y = 0; y < h; ++y)
+    for (size_t y = 0; y < h; ++y)
     {
-        for (int x = 0; x < w; ++x)
+        for (size_t x = 0; x < w; ++x)
         {
-            const float num_samples =
-                impl->m_histograms.get(y, x, samples_channel_index);
-
-            if (num_samples == 0.0f)
-            {
-                impl->m_histograms.get(y, x, 0) = 1.0f;
-                impl->m_histograms.get(y, x, num_bins) = 1.0f;
-                impl->m_histograms.get(y, x, num_bins * 2) = 1.0f;
-                impl->m_histograms.get(y, x, samples_channel_index) = 1.0f;
-            }
+            if (impl->m_histograms.get_sample_count(x, y) == 0.0f)
+                impl->m_histograms.set(x, y, bins.data(), 1.0f);
         }
     }
 }
 
-const Deepimf& DenoiserAOV::histograms_image() const
-{
-    return impl->m_histograms;
-}
-
-Deepimf& DenoiserAOV::histograms_image()
-{
-    return impl->m_histograms;
-}
-
 const Deepimf& DenoiserAOV::covariance_image() const
 {
     return impl->m_covariance_accum;
@@ -400,28 +425,130 @@ Deepimf& DenoiserAOV::sum_image()
 
 void DenoiserAOV::extract_num_samples_image(bcd::Deepimf& num_samples_image) const
 {
-    const int w = impl->m_histograms.getWidth();
-    const int h = impl->m_histograms.getHeight();
-    const int samples_channel_index = static_cast<int>(impl->m_num_bins * 3);
+    extract_num_samples_image(
+        0,
+        0,
+        static_cast<int>(impl->m_histograms.get_width()),
+        static_cast<int>(impl->m_histograms.get_height()),
+        num_samples_image);
+}
 
-    num_samples_image.resize(w, h, 1);
+void DenoiserAOV::extract_histograms_image(bcd::Deepimf& histograms_image) const
+{
+    extract_histograms_image(
+        0,
+        0,
+        static_cast<int>(impl->m_histograms.get_width()),
+        static_cast<int>(impl->m_histograms.get_height()),
+        histograms_image);
+}
+
+bool DenoiserAOV::set_histograms_image(const bcd::Deepimf& histograms_image)
+{
+    const size_t w = impl->m_histograms.get_width();
+    const size_t h = impl->m_histograms.get_height();
+    const size_t bin_count = impl->m_histograms.get_bin_count();
 
-    for (int y = 0; y < h; ++y)
+    if (static_cast<size_t>(histograms_image.getWidth()) != w ||
+        static_cast<size_t>(histograms_image.getHeight()) != h ||
+        static_cast<size_t>(histograms_image.getDepth()) != bin_count + 1)
+        return false;
+
+    std::vector<float> bins(bin_count);
+
+    for (size_t y = 0; y < h; ++y)
     {
-        for (int x = 0; x < w; ++x)
-            num_samples_image.get(y, x, 0) = impl->m_histograms.get(y, x, samples_channel_index);
+        for (size_t x = 0; x < w; ++x)
+        {
+            const int ix = static_cast<int>(x);
+            const int iy = static_cast<int>(y);
+
+            for (size_t k = 0; k < bin_count; ++k)
+                bins[k] = histograms_image.get(iy, ix, static_cast<int>(k));
+
+            impl->m_histograms.set(
+                x,
+                y,
+                bins.data(),
+                histograms_image.get(iy, ix, static_cast<int>(bin_count)));
+        }
     }
+
+    return true;
 }
 
 void DenoiserAOV::compute_covariances_image(Deepimf& covariances_image) const
 {
-    const int w = impl->m_covariance_accum.getWidth();
-    const int h = impl->m_covariance_accum.getHeight();
+    compute_covariances_image(
+        0,
+        0,
+        impl->m_covariance_accum.getWidth(),
+        impl->m_covariance_accum.getHeight(),
+        covariances_image);
+}
 
-    covariances_image.resize(w, h, 6);
-    covariances_image.fill(0.0f);
+void DenoiserAOV::extract_num_samples_image(
+    const int               x0,
+    const int               y0,
+    const int               width,
+    const int               height,
+    bcd::Deepimf&           num_samples_image) const
+{
+    num_samples_image.resize(width, height, 1);
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            num_samples_image.get(y, x, 0) =
+                impl->m_histograms.get_sample_count(
+                    static_cast<size_t>(x0 + x),
+                    static_cast<size_t>(y0 + y));
+        }
+    }
+}
+
+void DenoiserAOV::extract_histograms_image(
+    const int               x0,
+    const int               y0,
+    const int               width,
+    const int               height,
+    bcd::Deepimf&           histograms_image) const
+{
+    // Decode the compact histograms, followed by the sample count channel expected by BCD.
+    const size_t bin_count = impl->m_histograms.get_bin_count();
 
-    const int samples_channel_index = static_cast<int>(impl->m_num_bins * 3);
+    histograms_image.resize(width, height, static_cast<int>(bin_count + 1));
+
+    std::vector<float> bins(bin_count);
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const size_t sx = static_cast<size_t>(x0 + x);
+            const size_t sy = static_cast<size_t>(y0 + y);
+
+            impl->m_histograms.get_bins(sx, sy, bins.data());
+
+            for (size_t k = 0; k < bin_count; ++k)
+                histograms_image.get(y, x, static_cast<int>(k)) = bins[k];
+
+            histograms_image.get(y, x, static_cast<int>(bin_count)) =
+                impl->m_histograms.get_sample_count(sx, sy);
+        }
+    }
+}
+
+void DenoiserAOV::compute_covariances_image(
+    const int               x0,
+    const int               y0,
+    const int               width,
+    const int               height,
+    Deepimf&                covariances_image) const
+{
+    covariances_image.resize(width, height, 6);
+    covariances_image.fill(0.0f);
 
     const size_t c_xx = static_cast<size_t>(ESymmetricMatrix3x3Data::e_xx);
     const size_t c_yy = static_cast<size_t>(ESymmetricMatrix3x3Data::e_yy);
@@ -430,11 +557,17 @@ void DenoiserAOV::compute_covariances_image(Deepimf& covariances_image) const
     const size_t c_xz = static_cast<size_t>(ESymmetricMatrix3x3Data::e_xz);
     const size_t c_xy = static_cast<size_t>(ESymmetricMatrix3x3Data::e_xy);
 
-    for (int y = 0; y < h; ++y)
+    for (int y = 0; y < height; ++y)
     {
-        for (int x = 0; x < w; ++x)
+        for (int x = 0; x < width; ++x)
         {
-            const float sample_count = impl->m_histograms.get(y, x, samples_channel_index);
+            const int sy = y0 + y;
+            const int sx = x0 + x;
+
+            const float sample_count =
+                impl->m_histograms.get_sample_count(
+                    static_cast<size_t>(sx),
+                    static_cast<size_t>(sy));
 
             if (sample_count != 0.0f)
             {
@@ -447,15 +580,15 @@ void DenoiserAOV::compute_covariances_image(Deepimf& covariances_image) const
                 // Compute the mean.
                 float mean[3];
                 for (int k = 0; k < 3; ++k)
-                    mean[k] = impl->m_sum_accum.get(y, x, k) * rcp_sample_count;
+                    mean[k] = impl->m_sum_accum.get(sy, sx, k) * rcp_sample_count;
 
                 // Compute the covariances.
-                const float xx = impl->m_covariance_accum.get(y, x, c_xx);
-                const float yy = impl->m_covariance_accum.get(y, x, c_yy);
-                const float zz = impl->m_covariance_accum.get(y, x, c_zz);
-                const float yz = impl->m_covariance_accum.get(y, x, c_yz);
-                const float xz = impl->m_covariance_accum.get(y, x, c_xz);
-                const float xy = impl->m_covariance_accum.get(y, x, c_xy);
+                const float xx = impl->m_covariance_accum.get(sy, sx, c_xx);
+                const float yy = impl->m_covariance_accum.get(sy, sx, c_yy);
+                const float zz = impl->m_covariance_accum.get(sy, sx, c_zz);
+                const float yz = impl->m_covariance_accum.get(sy, sx, c_yz);
+                const float xz = impl->m_covariance_accum.get(sy, sx, c_xz);
+                const float xy = impl->m_covariance_accum.get(sy, sx, c_xy);
 
                 covariances_image.get(y, x, c_xx) = (xx * rcp_sample_count - mean[0] * mean[0]) * bias_correction_factor;
                 covariances_image.get(y, x, c_yy) = (yy * rcp_sample_count - mean[1] * mean[1]) * bias_correction_factor;
@@ -483,11 +616,15 @@ bool DenoiserAOV::write_images(
 
     Stopwatch<DefaultWallclockTimer> stopwatch;
 
+    // Decode histograms.
+    Deepimf histograms_image;
+    extract_histograms_image(histograms_image);
+
     // Write histograms.
     stopwatch.start();
     const std::string hist_file_name = base_file_name + ".hist" + extension;
     const std::string hist_file_path = (directory / hist_file_name).string();
-    if (ImageIO::writeMultiChannelsEXR(histograms_image(), hist_file_path.c_str()))
+    if (ImageIO::writeMultiChannelsEXR(histograms_image, hist_file_path.c_str()))
     {
         stopwatch.measure();
         RENDERER_LOG_INFO(
@@ -77,9 +77,6 @@ class DenoiserAOV
 
     void fill_empty_samples() const;
 
-    const bcd::Deepimf& histograms_image() const;
-    bcd::Deepimf& histograms_image();
-
     const bcd::Deepimf& covariance_image() const;
     bcd::Deepimf& covariance_image();
 
@@ -89,6 +86,34 @@ class DenoiserAOV
     void extract_num_samples_image(bcd::Deepimf& num_samples_image) const;
     void compute_covariances_image(bcd::Deepimf& covariances_image) const;
 
+    // Histograms are stored in a compact form and are decoded by the methods below
+    // into the layout expected by BCD: 3 x num_bins bins followed by the sample count.
+    void extract_histograms_image(bcd::Deepimf& histograms_image) const;
+
+    // Replace the histograms, e.g. when resuming from a checkpoint.
+    // Returns false if the image doesn't have the expected dimensions.
+    bool set_histograms_image(const bcd::Deepimf& histograms_image);
+
+    // Same as above but restricted to the pixels [x0, x0 + width) x [y0, y0 + height).
+    void extract_num_samples_image(
+        const int                           x0,
+        const int                           y0,
+        const int                           width,
+        const int                           height,
+        bcd::Deepimf&                       num_samples_image) const;
+    void extract_histograms_image(
+        const int                           x0,
+        const int                           y0,
+        const int                           width,
+        const int                           height,
+        bcd::Deepimf&                       histograms_image) const;
+    void compute_covariances_image(
+        const int                           x0,
+        const int                           y0,
+        const int                           width,
+        const int                           height,
+        bcd::Deepimf&                       covariances_image) const;
+
     bool write_images(
         const char*                         file_path,
         const foundation::ImageAttributes&  image_attributes) const override;
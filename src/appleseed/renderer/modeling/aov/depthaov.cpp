@@ -84,21 +84,18 @@ namespace
             if (!m_cropped_tile_bbox.contains(pi))
                 return;
 
-            float* out =
-                reinterpret_cast<float*>(
-                    m_tile->pixel(
-                        pi.x - m_tile_origin_x,
-                        pi.y - m_tile_origin_y));
+            const size_t x = pi.x - m_tile_origin_x;
+            const size_t y = pi.y - m_tile_origin_y;
 
             if (shading_point.hit_surface())
             {
                 shading_result.m_aovs[0].a = 1.0f;
-                *out = static_cast<float>(shading_point.get_distance());
+                m_tile->set_component(x, y, 0, static_cast<float>(shading_point.get_distance()));
             }
             else
             {
                 shading_result.m_aovs[0].a = 0.0f;
-                *out = 0.0f;
+                m_tile->set_component(x, y, 0, 0.0f);
             }
         }
     };
@@ -142,7 +139,7 @@ namespace
 
         void clear_image() override
         {
-            m_image->clear(Color<float, 2>(0.0f));
+            m_image->clear(Color<float, 2>(0.0f), m_crop_window);
         }
 
       private:
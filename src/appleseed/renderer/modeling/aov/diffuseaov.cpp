@@ -31,15 +31,10 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/aov/aovaccumulator.h"
-#include "renderer/kernel/aov/aovcomponents.h"
-#include "renderer/kernel/shading/shadingcomponents.h"
-#include "renderer/kernel/shading/shadingresult.h"
 #include "renderer/modeling/aov/aov.h"
-#include "renderer/modeling/color/colorspace.h"
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
-#include "foundation/image/color.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 
@@ -53,100 +48,6 @@ namespace renderer
 
 namespace
 {
-    //
-    // Diffuse AOV accumulator.
-    //
-
-    class DiffuseAOVAccumulator
-      : public AOVAccumulator
-    {
-      public:
-        explicit DiffuseAOVAccumulator(const size_t index)
-          : m_index(index)
-        {
-        }
-
-        void write(
-            const PixelContext&         pixel_context,
-            const ShadingPoint&         shading_point,
-            const ShadingComponents&    shading_components,
-            const AOVComponents&        aov_components,
-            ShadingResult&              shading_result) override
-        {
-            shading_result.m_aovs[m_index].rgb() =
-                shading_components.m_diffuse.to_rgb(g_std_lighting_conditions) +
-                shading_components.m_indirect_diffuse.to_rgb(g_std_lighting_conditions);
-
-            shading_result.m_aovs[m_index].a = shading_result.m_main.a;
-        }
-
-      private:
-        const size_t m_index;
-    };
-
-
-    //
-    // Direct Diffuse AOV accumulator.
-    //
-
-    class DirectDiffuseAOVAccumulator
-      : public AOVAccumulator
-    {
-      public:
-        explicit DirectDiffuseAOVAccumulator(const size_t index)
-          : m_index(index)
-        {
-        }
-
-        void write(
-            const PixelContext&         pixel_context,
-            const ShadingPoint&         shading_point,
-            const ShadingComponents&    shading_components,
-            const AOVComponents&        aov_components,
-            ShadingResult&              shading_result) override
-        {
-            shading_result.m_aovs[m_index].rgb() =
-                shading_components.m_diffuse.to_rgb(g_std_lighting_conditions);
-
-            shading_result.m_aovs[m_index].a = shading_result.m_main.a;
-        }
-
-      private:
-        const size_t m_index;
-    };
-
-
-    //
-    // Indirect Diffuse AOV accumulator.
-    //
-
-    class IndirectDiffuseAOVAccumulator
-      : public AOVAccumulator
-    {
-      public:
-        explicit IndirectDiffuseAOVAccumulator(const size_t index)
-          : m_index(index)
-        {
-        }
-
-        void write(
-            const PixelContext&         pixel_context,
-            const ShadingPoint&         shading_point,
-            const ShadingComponents&    shading_components,
-            const AOVComponents&        aov_components,
-            ShadingResult&              shading_result) override
-        {
-            shading_result.m_aovs[m_index].rgb() =
-                shading_components.m_indirect_diffuse.to_rgb(g_std_lighting_conditions);
-
-            shading_result.m_aovs[m_index].a = shading_result.m_main.a;
-        }
-
-      private:
-        const size_t m_index;
-    };
-
-
     //
     // Diffuse AOV.
     //
@@ -176,7 +77,7 @@ namespace
         auto_release_ptr<AOVAccumulator> create_accumulator() const override
         {
             return auto_release_ptr<AOVAccumulator>(
-                new DiffuseAOVAccumulator(m_image_index));
+                new BuiltinAOVAccumulator(AOVWriterKind::Diffuse, m_image_index));
         }
     };
 
@@ -210,7 +111,7 @@ namespace
         auto_release_ptr<AOVAccumulator> create_accumulator() const override
         {
             return auto_release_ptr<AOVAccumulator>(
-                new DirectDiffuseAOVAccumulator(m_image_index));
+                new BuiltinAOVAccumulator(AOVWriterKind::DirectDiffuse, m_image_index));
         }
     };
 
@@ -244,7 +145,7 @@ namespace
         auto_release_ptr<AOVAccumulator> create_accumulator() const override
         {
             return auto_release_ptr<AOVAccumulator>(
-                new IndirectDiffuseAOVAccumulator(m_image_index));
+                new BuiltinAOVAccumulator(AOVWriterKind::IndirectDiffuse, m_image_index));
         }
     };
 }
@@ -31,15 +31,10 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/aov/aovaccumulator.h"
-#include "renderer/kernel/aov/aovcomponents.h"
-#include "renderer/kernel/shading/shadingcomponents.h"
-#include "renderer/kernel/shading/shadingresult.h"
 #include "renderer/modeling/aov/aov.h"
-#include "renderer/modeling/color/colorspace.h"
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
-#include "foundation/image/color.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 
@@ -53,37 +48,6 @@ namespace renderer
 
 namespace
 {
-    //
-    // Emission AOV accumulator.
-    //
-
-    class EmissionAOVAccumulator
-      : public AOVAccumulator
-    {
-      public:
-        explicit EmissionAOVAccumulator(const size_t index)
-          : m_index(index)
-        {
-        }
-
-        void write(
-            const PixelContext&         pixel_context,
-            const ShadingPoint&         shading_point,
-            const ShadingComponents&    shading_components,
-            const AOVComponents&        aov_components,
-            ShadingResult&              shading_result) override
-        {
-            shading_result.m_aovs[m_index].rgb() =
-                shading_components.m_emission.to_rgb(g_std_lighting_conditions);
-
-            shading_result.m_aovs[m_index].a = shading_result.m_main.a;
-        }
-
-      private:
-        const size_t m_index;
-    };
-
-
     //
     // Emission AOV.
     //
@@ -113,7 +77,7 @@ namespace
         auto_release_ptr<AOVAccumulator> create_accumulator() const override
         {
             return auto_release_ptr<AOVAccumulator>(
-                new EmissionAOVAccumulator(m_image_index));
+                new BuiltinAOVAccumulator(AOVWriterKind::Emission, m_image_index));
         }
     };
 }
@@ -31,14 +31,10 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/aov/aovaccumulator.h"
-#include "renderer/kernel/shading/shadingcomponents.h"
-#include "renderer/kernel/shading/shadingresult.h"
 #include "renderer/modeling/aov/aov.h"
-#include "renderer/modeling/color/colorspace.h"
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
-#include "foundation/image/color.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 
@@ -52,100 +48,6 @@ namespace renderer
 
 namespace
 {
-    //
-    // Glossy AOV accumulator.
-    //
-
-    class GlossyAOVAccumulator
-      : public AOVAccumulator
-    {
-      public:
-        explicit GlossyAOVAccumulator(const size_t index)
-          : m_index(index)
-        {
-        }
-
-        void write(
-            const PixelContext&         pixel_context,
-            const ShadingPoint&         shading_point,
-            const ShadingComponents&    shading_components,
-            const AOVComponents&        aov_components,
-            ShadingResult&              shading_result) override
-        {
-            shading_result.m_aovs[m_index].rgb() =
-                shading_components.m_glossy.to_rgb(g_std_lighting_conditions) +
-                shading_components.m_indirect_glossy.to_rgb(g_std_lighting_conditions);
-
-            shading_result.m_aovs[m_index].a = shading_result.m_main.a;
-        }
-
-      private:
-        const size_t m_index;
-    };
-
-
-    //
-    // Direct Glossy AOV accumulator.
-    //
-
-    class DirectGlossyAOVAccumulator
-      : public AOVAccumulator
-    {
-      public:
-        explicit DirectGlossyAOVAccumulator(const size_t index)
-          : m_index(index)
-        {
-        }
-
-        void write(
-            const PixelContext&         pixel_context,
-            const ShadingPoint&         shading_point,
-            const ShadingComponents&    shading_components,
-            const AOVComponents&        aov_components,
-            ShadingResult&              shading_result) override
-        {
-            shading_result.m_aovs[m_index].rgb() =
-                shading_components.m_glossy.to_rgb(g_std_lighting_conditions);
-
-            shading_result.m_aovs[m_index].a = shading_result.m_main.a;
-        }
-
-      private:
-        const size_t m_index;
-    };
-
-
-    //
-    // Indirect Glossy AOV accumulator.
-    //
-
-    class IndirectGlossyAOVAccumulator
-      : public AOVAccumulator
-    {
-      public:
-        explicit IndirectGlossyAOVAccumulator(const size_t index)
-          : m_index(index)
-        {
-        }
-
-        void write(
-            const PixelContext&         pixel_context,
-            const ShadingPoint&         shading_point,
-            const ShadingComponents&    shading_components,
-            const AOVComponents&        aov_components,
-            ShadingResult&              shading_result) override
-        {
-            shading_result.m_aovs[m_index].rgb() =
-                shading_components.m_indirect_glossy.to_rgb(g_std_lighting_conditions);
-
-            shading_result.m_aovs[m_index].a = shading_result.m_main.a;
-        }
-
-      private:
-        const size_t m_index;
-    };
-
-
     //
     // Glossy AOV.
     //
@@ -175,7 +77,7 @@ namespace
         auto_release_ptr<AOVAccumulator> create_accumulator() const override
         {
             return auto_release_ptr<AOVAccumulator>(
-                new GlossyAOVAccumulator(m_image_index));
+                new BuiltinAOVAccumulator(AOVWriterKind::Glossy, m_image_index));
         }
     };
 
@@ -209,7 +111,7 @@ namespace
         auto_release_ptr<AOVAccumulator> create_accumulator() const override
         {
             return auto_release_ptr<AOVAccumulator>(
-                new DirectGlossyAOVAccumulator(m_image_index));
+                new BuiltinAOVAccumulator(AOVWriterKind::DirectGlossy, m_image_index));
         }
     };
 
@@ -243,7 +145,7 @@ namespace
         auto_release_ptr<AOVAccumulator> create_accumulator() const override
         {
             return auto_release_ptr<AOVAccumulator>(
-                new IndirectGlossyAOVAccumulator(m_image_index));
+                new BuiltinAOVAccumulator(AOVWriterKind::IndirectGlossy, m_image_index));
         }
     };
 }
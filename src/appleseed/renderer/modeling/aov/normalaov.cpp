@@ -80,25 +80,15 @@ namespace
             if (!m_cropped_tile_bbox.contains(pi))
                 return;
 
-            float* out =
-                reinterpret_cast<float*>(
-                    m_tile->pixel(
-                        pi.x - m_tile_origin_x,
-                        pi.y - m_tile_origin_y));
+            const size_t x = pi.x - m_tile_origin_x;
+            const size_t y = pi.y - m_tile_origin_y;
 
             if (shading_point.hit_surface())
             {
-                const Vector3d& n = shading_point.get_shading_normal();
-                out[0] = static_cast<float>(n[0]) * 0.5f + 0.5f;
-                out[1] = static_cast<float>(n[1]) * 0.5f + 0.5f;
-                out[2] = static_cast<float>(n[2]) * 0.5f + 0.5f;
-            }
-            else
-            {
-                out[0] = 0.5f;
-                out[1] = 0.5f;
-                out[2] = 0.5f;
+                const Vector3f n(shading_point.get_shading_normal());
+                m_tile->set_pixel(x, y, Color3f(n[0], n[1], n[2]) * 0.5f + Color3f(0.5f));
             }
+            else m_tile->set_pixel(x, y, Color3f(0.5f));
         }
     };
 
@@ -130,10 +120,15 @@ namespace
 
         void clear_image() override
         {
-            m_image->clear(Color3f(0.5f));
+            m_image->clear(Color3f(0.5f), m_crop_window);
         }
 
       private:
+        PixelFormat get_default_storage_format() const override
+        {
+            return PixelFormatHalf;
+        }
+
         auto_release_ptr<AOVAccumulator> create_accumulator() const override
         {
             return auto_release_ptr<AOVAccumulator>(
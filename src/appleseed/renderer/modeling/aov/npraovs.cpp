@@ -31,15 +31,10 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/aov/aovaccumulator.h"
-#include "renderer/kernel/aov/aovcomponents.h"
-#include "renderer/kernel/shading/shadingcomponents.h"
-#include "renderer/kernel/shading/shadingresult.h"
 #include "renderer/modeling/aov/aov.h"
-#include "renderer/modeling/color/colorspace.h"
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
-#include "foundation/image/color.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 
@@ -53,35 +48,6 @@ namespace renderer
 
 namespace
 {
-    //
-    // NPR Shading AOV accumulator.
-    //
-
-    class NPRShadingAOVAccumulator
-      : public AOVAccumulator
-    {
-      public:
-        explicit NPRShadingAOVAccumulator(const size_t index)
-          : m_index(index)
-        {
-        }
-
-        void write(
-            const PixelContext&         pixel_context,
-            const ShadingPoint&         shading_point,
-            const ShadingComponents&    shading_components,
-            const AOVComponents&        aov_components,
-            ShadingResult&              shading_result) override
-        {
-            shading_result.m_aovs[m_index].rgb() = aov_components.m_npr_shading;
-            shading_result.m_aovs[m_index].a = shading_result.m_main.a;
-        }
-
-      private:
-        const size_t m_index;
-    };
-
-
     //
     // NPR Shading AOV.
     //
@@ -111,40 +77,11 @@ namespace
         auto_release_ptr<AOVAccumulator> create_accumulator() const override
         {
             return auto_release_ptr<AOVAccumulator>(
-                new NPRShadingAOVAccumulator(m_image_index));
+                new BuiltinAOVAccumulator(AOVWriterKind::NPRShading, m_image_index));
         }
     };
 
 
-    //
-    // NPR Contour AOV accumulator.
-    //
-
-    class NPRContourAOVAccumulator
-      : public AOVAccumulator
-    {
-      public:
-        explicit NPRContourAOVAccumulator(const size_t index)
-          : m_index(index)
-        {
-        }
-
-        void write(
-            const PixelContext&         pixel_context,
-            const ShadingPoint&         shading_point,
-            const ShadingComponents&    shading_components,
-            const AOVComponents&        aov_components,
-            ShadingResult&              shading_result) override
-        {
-            shading_result.m_aovs[m_index].rgb() = aov_components.m_npr_contour.rgb();
-            shading_result.m_aovs[m_index].a = aov_components.m_npr_contour.a;
-        }
-
-      private:
-        const size_t m_index;
-    };
-
-
     //
     // NPR Contour AOV.
     //
@@ -174,7 +111,7 @@ namespace
         auto_release_ptr<AOVAccumulator> create_accumulator() const override
         {
             return auto_release_ptr<AOVAccumulator>(
-                new NPRContourAOVAccumulator(m_image_index));
+                new BuiltinAOVAccumulator(AOVWriterKind::NPRContour, m_image_index));
         }
     };
 }
@@ -120,13 +120,12 @@ namespace
 
                 const double median = m_samples[mid];
 
-                float* out =
-                    reinterpret_cast<float*>(
-                        m_tile->pixel(
-                            pi.x - m_tile_origin_x,
-                            pi.y - m_tile_origin_y));
+                const size_t x = pi.x - m_tile_origin_x;
+                const size_t y = pi.y - m_tile_origin_y;
 
-                *out += static_cast<float>(median) * m_samples.size();
+                m_tile->set_component(
+                    x, y, 0,
+                    m_tile->get_component<float>(x, y, 0) + static_cast<float>(median) * m_samples.size());
             }
 
             UnfilteredAOVAccumulator::on_pixel_end(pi);
@@ -176,7 +175,7 @@ namespace
 
         void clear_image() override
         {
-            m_image->clear(Color<float, 3>(0.0f));
+            m_image->clear(Color<float, 3>(0.0f), m_crop_window);
         }
 
         void post_process_image(const Frame& frame) override
@@ -80,25 +80,15 @@ namespace
             if (!m_cropped_tile_bbox.contains(pi))
                 return;
 
-            float* out =
-                reinterpret_cast<float*>(
-                    m_tile->pixel(
-                        pi.x - m_tile_origin_x,
-                        pi.y - m_tile_origin_y));
+            const size_t x = pi.x - m_tile_origin_x;
+            const size_t y = pi.y - m_tile_origin_y;
 
             if (shading_point.hit_surface())
             {
-                const Vector3d& p = shading_point.get_point();
-                out[0] = static_cast<float>(p[0]);
-                out[1] = static_cast<float>(p[1]);
-                out[2] = static_cast<float>(p[2]);
-            }
-            else
-            {
-                out[0] = 0.0f;
-                out[1] = 0.0f;
-                out[2] = 0.0f;
+                const Vector3f p(shading_point.get_point());
+                m_tile->set_pixel(x, y, Color3f(p[0], p[1], p[2]));
             }
+            else m_tile->set_pixel(x, y, Color3f(0.0f));
         }
     };
 
@@ -130,7 +120,7 @@ namespace
 
         void clear_image() override
         {
-            m_image->clear(Color3f(0.0f));
+            m_image->clear(Color3f(0.0f), m_crop_window);
         }
 
       private:
@@ -0,0 +1,273 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "rendercostaov.h"
+
+// appleseed.renderer headers.
+#include "renderer/kernel/aov/aovaccumulator.h"
+#include "renderer/kernel/rendering/pixelcontext.h"
+#include "renderer/kernel/rendering/rendercosttracker.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/modeling/aov/aov.h"
+
+// appleseed.foundation headers.
+#include "foundation/containers/dictionary.h"
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/image/tile.h"
+#include "foundation/platform/timers.h"
+#include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+
+    //
+    // Render cost AOV accumulator.
+    //
+    // The time of each sample is attributed to the object instance hit by its primary
+    // ray. Each pixel then stores the object instance that took most of its time.
+    //
+
+    class RenderCostAOVAccumulator
+      : public UnfilteredAOVAccumulator
+    {
+      public:
+        explicit RenderCostAOVAccumulator(Image& image)
+          : UnfilteredAOVAccumulator(image)
+          , m_sample_id(0)
+          , m_sample_id_known(false)
+        {
+        }
+
+        void on_pixel_begin(const Vector2i& pi) override
+        {
+            UnfilteredAOVAccumulator::on_pixel_begin(pi);
+
+            m_pixel_costs.clear();
+        }
+
+        void on_pixel_end(const Vector2i& pi) override
+        {
+            if (m_cropped_tile_bbox.contains(pi) && !m_pixel_costs.empty())
+            {
+                // Find the object instance that took most of the time of this pixel.
+                double total_seconds = 0.0;
+                size_t dominant = 0;
+
+                for (size_t i = 0, e = m_pixel_costs.size(); i < e; ++i)
+                {
+                    total_seconds += m_pixel_costs[i].second;
+
+                    if (m_pixel_costs[i].second > m_pixel_costs[dominant].second)
+                        dominant = i;
+                }
+
+                const size_t x = pi.x - m_tile_origin_x;
+                const size_t y = pi.y - m_tile_origin_y;
+
+                const float pixel_seconds =
+                    m_tile->get_component<float>(x, y, 2) + static_cast<float>(total_seconds);
+                const float dominant_fraction =
+                    total_seconds > 0.0
+                        ? static_cast<float>(m_pixel_costs[dominant].second / total_seconds)
+                        : 1.0f;
+
+                m_tile->set_pixel(
+                    x, y,
+                    Color3f(
+                        static_cast<float>(m_pixel_costs[dominant].first),
+                        dominant_fraction,
+                        pixel_seconds));
+            }
+
+            UnfilteredAOVAccumulator::on_pixel_end(pi);
+        }
+
+        void on_sample_begin(const PixelContext& pixel_context) override
+        {
+            m_sample_id = 0;
+            m_sample_id_known = false;
+            m_stopwatch.start();
+        }
+
+        void on_sample_end(const PixelContext& pixel_context) override
+        {
+            // Only collect samples inside the tile.
+            if (m_cropped_tile_bbox.contains(pixel_context.get_pixel_coords()))
+            {
+                m_stopwatch.measure();
+                add_cost(m_sample_id, m_stopwatch.get_seconds());
+            }
+        }
+
+        void write(
+            const PixelContext&         pixel_context,
+            const ShadingPoint&         shading_point,
+            const ShadingComponents&    shading_components,
+            const AOVComponents&        aov_components,
+            ShadingResult&              shading_result) override
+        {
+            // Only the first hit along the primary ray identifies the sample.
+            if (m_sample_id_known)
+                return;
+
+            if (shading_point.hit_surface())
+                m_sample_id = RenderCostTracker::get_object_instance_id(shading_point.get_object_instance());
+
+            m_sample_id_known = true;
+        }
+
+      private:
+        typedef std::pair<std::uint32_t, double> IdCost;
+
+        Stopwatch<DefaultWallclockTimer>    m_stopwatch;
+        std::vector<IdCost>                 m_pixel_costs;
+        std::uint32_t                       m_sample_id;
+        bool                                m_sample_id_known;
+
+        void add_cost(const std::uint32_t id, const double seconds)
+        {
+            // Pixels rarely see more than a few object instances: a linear search is fine.
+            for (IdCost& cost : m_pixel_costs)
+            {
+                if (cost.first == id)
+                {
+                    cost.second += seconds;
+                    return;
+                }
+            }
+
+            m_pixel_costs.emplace_back(id, seconds);
+        }
+    };
+
+
+    //
+    // Render cost AOV.
+    //
+    // Channels:
+    //
+    //   R      identifier of the object instance that took most of the time of the pixel,
+    //          as listed in the render cost statistics, or 0 if no surface was shaded
+    //   G      fraction of the time of the pixel spent on this object instance
+    //   B      total time spent rendering the pixel, in seconds
+    //
+
+    const char* RenderCostAOVModel = "render_cost_aov";
+
+    class RenderCostAOV
+      : public UnfilteredAOV
+    {
+      public:
+        explicit RenderCostAOV(const ParamArray& params)
+          : UnfilteredAOV("render_cost", params)
+        {
+        }
+
+        void release() override
+        {
+            delete this;
+        }
+
+        const char* get_model() const override
+        {
+            return RenderCostAOVModel;
+        }
+
+        size_t get_channel_count() const override
+        {
+            return 3;
+        }
+
+        const char** get_channel_names() const override
+        {
+            static const char* ChannelNames[] = { "R", "G", "B" };
+            return ChannelNames;
+        }
+
+        void clear_image() override
+        {
+            m_image->clear(Color<float, 3>(0.0f), m_crop_window);
+        }
+
+      private:
+        auto_release_ptr<AOVAccumulator> create_accumulator() const override
+        {
+            return auto_release_ptr<AOVAccumulator>(new RenderCostAOVAccumulator(get_image()));
+        }
+    };
+}
+
+
+//
+// RenderCostAOVFactory class implementation.
+//
+
+void RenderCostAOVFactory::release()
+{
+    delete this;
+}
+
+const char* RenderCostAOVFactory::get_model() const
+{
+    return RenderCostAOVModel;
+}
+
+Dictionary RenderCostAOVFactory::get_model_metadata() const
+{
+    return
+        Dictionary()
+            .insert("name", RenderCostAOVModel)
+            .insert("label", "Render Cost");
+}
+
+DictionaryArray RenderCostAOVFactory::get_input_metadata() const
+{
+    DictionaryArray metadata;
+    return metadata;
+}
+
+auto_release_ptr<AOV> RenderCostAOVFactory::create(const ParamArray& params) const
+{
+    return auto_release_ptr<AOV>(new RenderCostAOV(params));
+}
+
+}   // namespace renderer
@@ -129,25 +129,15 @@ namespace
             if (!m_cropped_tile_bbox.contains(pi))
                 return;
 
-            float* out =
-                reinterpret_cast<float*>(
-                    m_tile->pixel(
-                        pi.x - m_tile_origin_x,
-                        pi.y - m_tile_origin_y));
+            const size_t x = pi.x - m_tile_origin_x;
+            const size_t y = pi.y - m_tile_origin_y;
 
             if (shading_point.hit_surface())
             {
                 const Color3f c = compute_screen_space_velocity_color(shading_point, m_max_displace);
-                out[0] = c[0];
-                out[1] = c[1];
-                out[2] = c[2];
-            }
-            else
-            {
-                out[0] = 0.0f;
-                out[1] = 0.0f;
-                out[2] = 0.0f;
+                m_tile->set_pixel(x, y, c);
             }
+            else m_tile->set_pixel(x, y, Color3f(0.0f));
         }
 
       private:
@@ -183,7 +173,7 @@ namespace
 
         void clear_image() override
         {
-            m_image->clear(Color3f(0.0f));
+            m_image->clear(Color3f(0.0f), m_crop_window);
         }
 
       private:
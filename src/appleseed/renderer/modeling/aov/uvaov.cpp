@@ -80,25 +80,15 @@ namespace
             if (!m_cropped_tile_bbox.contains(pi))
                 return;
 
-            float* out =
-                reinterpret_cast<float*>(
-                    m_tile->pixel(
-                        pi.x - m_tile_origin_x,
-                        pi.y - m_tile_origin_y));
+            const size_t x = pi.x - m_tile_origin_x;
+            const size_t y = pi.y - m_tile_origin_y;
 
             if (shading_point.hit_surface())
             {
                 const Vector2f& uv = shading_point.get_uv(0);
-                out[0] = uv[0];
-                out[1] = uv[1];
-                out[2] = 0.0f;
-            }
-            else
-            {
-                out[0] = 0.0f;
-                out[1] = 0.0f;
-                out[2] = 0.0f;
+                m_tile->set_pixel(x, y, Color3f(uv[0], uv[1], 0.0f));
             }
+            else m_tile->set_pixel(x, y, Color3f(0.0f));
         }
     };
 
@@ -129,6 +119,11 @@ namespace
         }
 
       private:
+        PixelFormat get_default_storage_format() const override
+        {
+            return PixelFormatHalf;
+        }
+
         auto_release_ptr<AOVAccumulator> create_accumulator() const override
         {
             return auto_release_ptr<AOVAccumulator>(
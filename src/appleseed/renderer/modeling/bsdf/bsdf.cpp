@@ -37,7 +37,12 @@
 #include "renderer/modeling/input/sourceinputs.h"
 
 // appleseed.foundation headers.
+#include "foundation/hash/hash.h"
 #include "foundation/memory/arena.h"
+#include "foundation/utility/casts.h"
+
+// Standard headers.
+#include <cstdint>
 
 using namespace foundation;
 
@@ -77,6 +82,26 @@ size_t BSDF::compute_input_data_size() const
     return get_inputs().compute_data_size();
 }
 
+float BSDF::compute_layer_selection_sample(
+    const ShadingPoint&     shading_point)
+{
+    const Vector3f p(shading_point.get_point());
+    const Vector3f d(shading_point.get_ray().m_dir);
+
+    const std::uint32_t h =
+        mix_uint32(
+            mix_uint32(
+                binary_cast<std::uint32_t>(p.x),
+                binary_cast<std::uint32_t>(p.y),
+                binary_cast<std::uint32_t>(p.z)),
+            binary_cast<std::uint32_t>(d.x),
+            binary_cast<std::uint32_t>(d.y),
+            binary_cast<std::uint32_t>(d.z));
+
+    // Use the upper 24 bits so that the result is exactly representable and strictly below 1.
+    return static_cast<float>(h >> 8) * (1.0f / 16777216.0f);
+}
+
 void* BSDF::evaluate_inputs(
     const ShadingContext&   shading_context,
     const ShadingPoint&     shading_point) const
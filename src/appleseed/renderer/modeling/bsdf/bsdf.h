@@ -204,6 +204,12 @@ class APPLESEED_DLLSYMBOL BSDF
         foundation::Vector3f&       direction,
         const foundation::Vector3f& normal);
 
+    // Return a pseudorandom number in [0,1) derived from the position of a shading point
+    // and the direction of the ray that hit it. Used by layered BSDFs to stochastically
+    // select a single layer per shading point when no sampling context is available.
+    static float compute_layer_selection_sample(
+        const ShadingPoint&         shading_point);
+
   private:
     const Type  m_type;
     const int   m_modes;
@@ -37,6 +37,7 @@
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/modeling/bsdf/bsdf.h"
 #include "renderer/modeling/bsdf/bsdfwrapper.h"
+#include "renderer/utility/messagecontext.h"
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
@@ -47,6 +48,7 @@
 #include "foundation/memory/arena.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/makevector.h"
 
 // Standard headers.
 #include <cassert>
@@ -81,6 +83,7 @@ namespace
             const char*                 name,
             const ParamArray&           params)
           : BSDF(name, Reflective, ScatteringMode::All, params)
+          , m_stochastic(false)
         {
             m_inputs.declare("bsdf0", InputFormatEntity);
             m_inputs.declare("bsdf1", InputFormatEntity);
@@ -125,6 +128,15 @@ namespace
             if (m_bsdf[0] == nullptr || m_bsdf[1] == nullptr)
                 return false;
 
+            const OnFrameBeginMessageContext context("bsdf", this);
+
+            m_stochastic =
+                m_params.get_optional<std::string>(
+                    "layer_selection",
+                    "deterministic",
+                    make_vector("deterministic", "stochastic"),
+                    context) == "stochastic";
+
             return true;
         }
 
@@ -140,8 +152,21 @@ namespace
                 static_cast<Values::Inputs*>(
                     BSDF::evaluate_inputs(shading_context, shading_point));
 
-            values->m_child_inputs[0] = m_bsdf[0]->evaluate_inputs(shading_context, shading_point);
-            values->m_child_inputs[1] = m_bsdf[1]->evaluate_inputs(shading_context, shading_point);
+            if (m_stochastic)
+            {
+                // Select a single BSDF with probability equal to its weight
+                // and only evaluate the inputs of that BSDF.
+                const float s = compute_layer_selection_sample(shading_point);
+                const size_t bsdf_index = s < values->m_inputs->m_weight ? 0 : 1;
+                values->m_selected_bsdf = bsdf_index;
+                values->m_child_inputs[bsdf_index] = m_bsdf[bsdf_index]->evaluate_inputs(shading_context, shading_point);
+                values->m_child_inputs[1 - bsdf_index] = nullptr;
+            }
+            else
+            {
+                values->m_child_inputs[0] = m_bsdf[0]->evaluate_inputs(shading_context, shading_point);
+                values->m_child_inputs[1] = m_bsdf[1]->evaluate_inputs(shading_context, shading_point);
+            }
 
             return values;
         }
@@ -161,9 +186,15 @@ namespace
             const Values* values = static_cast<const Values*>(data);
 
             // Choose which of the two BSDFs to sample.
-            sampling_context.split_in_place(1, 1);
-            const float s = sampling_context.next2<float>();
-            const size_t bsdf_index = s < values->m_inputs->m_weight ? 0 : 1;
+            size_t bsdf_index;
+            if (m_stochastic)
+                bsdf_index = values->m_selected_bsdf;
+            else
+            {
+                sampling_context.split_in_place(1, 1);
+                const float s = sampling_context.next2<float>();
+                bsdf_index = s < values->m_inputs->m_weight ? 0 : 1;
+            }
 
             // Sample the chosen BSDF.
             m_bsdf[bsdf_index]->sample(
@@ -191,6 +222,22 @@ namespace
 
             const Values* values = static_cast<const Values*>(data);
 
+            // The selection probability of the chosen BSDF cancels out its weight.
+            if (m_stochastic)
+            {
+                const size_t bsdf_index = values->m_selected_bsdf;
+                return
+                    m_bsdf[bsdf_index]->evaluate(
+                        values->m_child_inputs[bsdf_index],
+                        adjoint,
+                        false,                  // do not multiply by |cos(incoming, normal)|
+                        local_geometry,
+                        outgoing,
+                        incoming,
+                        modes,
+                        value);
+            }
+
             // Retrieve blending weights.
             const float w0 = values->m_inputs->m_weight;
             const float w1 = 1.0f - w0;
@@ -248,6 +295,19 @@ namespace
 
             const Values* values = static_cast<const Values*>(data);
 
+            if (m_stochastic)
+            {
+                const size_t bsdf_index = values->m_selected_bsdf;
+                return
+                    m_bsdf[bsdf_index]->evaluate_pdf(
+                        values->m_child_inputs[bsdf_index],
+                        adjoint,
+                        local_geometry,
+                        outgoing,
+                        incoming,
+                        modes);
+            }
+
             // Retrieve blending weights.
             const float w0 = values->m_inputs->m_weight;
             const float w1 = 1.0f - w0;
@@ -293,9 +353,11 @@ namespace
 
             const Inputs*   m_inputs;
             const void*     m_child_inputs[2];
+            size_t          m_selected_bsdf;            // only used with stochastic layer selection
         };
 
         const BSDF* m_bsdf[2];
+        bool        m_stochastic;
     };
 
     typedef BSDFWrapper<BSDFBlendImpl, false> BSDFBlend;
@@ -356,6 +418,18 @@ DictionaryArray BSDFBlendFactory::get_input_metadata() const
             .insert("use", "required")
             .insert("default", "0.5"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "layer_selection")
+            .insert("label", "Layer Selection")
+            .insert("type", "enumeration")
+            .insert("items",
+                Dictionary()
+                    .insert("Deterministic", "deterministic")
+                    .insert("Stochastic", "stochastic"))
+            .insert("use", "optional")
+            .insert("default", "deterministic"));
+
     return metadata;
 }
 
@@ -112,16 +112,50 @@ void* DisneyLayeredBRDF::evaluate_inputs(
 
     Color3f base_color(0.0f);
 
-    for (size_t i = 0, e = m_parent->get_layer_count(); i < e; ++i)
+    if (m_parent->uses_stochastic_layer_selection())
     {
-        const DisneyMaterialLayer& layer =
-            m_parent->get_layer(i, shading_context.get_thread_index());
-
-        layer.evaluate_expressions(
-            shading_point,
-            shading_context.get_oiio_texture_system(),
-            base_color,
-            *values);
+        // Walk the layers from top to bottom and select a single one with probability
+        // equal to its visible weight. Only the expressions of that layer are evaluated.
+        float s = compute_layer_selection_sample(shading_point);
+
+        for (size_t i = m_parent->get_layer_count(); i-- > 0; )
+        {
+            const DisneyMaterialLayer& layer =
+                m_parent->get_layer(i, shading_context.get_thread_index());
+
+            const float mask =
+                layer.evaluate_mask(
+                    shading_point,
+                    shading_context.get_oiio_texture_system());
+
+            if (s < mask)
+            {
+                layer.evaluate_expressions(
+                    shading_point,
+                    shading_context.get_oiio_texture_system(),
+                    1.0f,
+                    base_color,
+                    *values);
+                break;
+            }
+
+            // Rescale the sample to [0, 1) for the layers below.
+            s = (s - mask) / (1.0f - mask);
+        }
+    }
+    else
+    {
+        for (size_t i = 0, e = m_parent->get_layer_count(); i < e; ++i)
+        {
+            const DisneyMaterialLayer& layer =
+                m_parent->get_layer(i, shading_context.get_thread_index());
+
+            layer.evaluate_expressions(
+                shading_point,
+                shading_context.get_oiio_texture_system(),
+                base_color,
+                *values);
+        }
     }
 
     // Colors in SeExpr are always in the sRGB color space.
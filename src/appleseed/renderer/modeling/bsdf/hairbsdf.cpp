@@ -46,8 +46,10 @@
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/basis.h"
 #include "foundation/math/minmax.h"
+#include "foundation/math/scalar.h"
 #include "foundation/math/sampling/mappings.h"
 #include "foundation/math/specialfunctions.h"
 #include "foundation/math/vector.h"
@@ -58,9 +60,9 @@
 // Standard headers.
 #include <algorithm>
 #include <array>
+#include <cassert>
 #include <cmath>
 #include <cstddef>
-#include <numeric>
 #include <string>
 
 // Forward declarations.
@@ -77,16 +79,55 @@ namespace renderer
 namespace
 {
 
+    //
+    // Table of the logarithm of the modified Bessel function of the first kind.
+    //
+    // The longitudinal scattering function only depends on the roughness through
+    // the argument of the Bessel function and a normalization term, so a single
+    // table built once and shared read-only by all hair BSDFs covers all roughnesses.
+    //
+
+    class LogBesselTable
+      : public NonCopyable
+    {
+      public:
+        LogBesselTable()
+        {
+            for (size_t i = 0; i < TableSize; ++i)
+                m_table[i] = log_bessel(static_cast<float>(i) * (MaxArg / (TableSize - 1)));
+        }
+
+        float get(const float x) const
+        {
+            assert(!(x < 0.0f));
+
+            // Beyond the table, log_bessel() uses a cheap asymptotic expansion.
+            if (!(x < MaxArg))
+                return log_bessel(x);
+
+            const float t = x * ((TableSize - 1) / MaxArg);
+            const size_t i = truncate<size_t>(t);
+            assert(i + 1 < TableSize);
+
+            return lerp(m_table[i], m_table[i + 1], t - static_cast<float>(i));
+        }
+
+      private:
+        static const size_t TableSize = 1025;
+        static constexpr float MaxArg = 12.0f;
+
+        float m_table[TableSize];
+    };
+
+    const LogBesselTable g_log_bessel_table;
+
     //
     // Normalized logistic function over the range [-pi, pi].
     //
 
-    inline float trimmed_logistic_func(const float value, const float scale)
+    inline float trimmed_logistic_func(const float value, const float scale, const float rcp_norm)
     {
-        const float num = logistic(value, scale);
-        const float den = 1.0f - 2.0f * logistic_cdf(-Pi<float>(), scale);
-        assert(den != 0);
-        return num / den;
+        return logistic(value, scale) * rcp_norm;
     }
 
     //
@@ -94,10 +135,10 @@ namespace
     // using random sample in [0, 1].
     //
 
-    inline float sample_trimmed_logistic(const float sample, const float scale)
+    inline float sample_trimmed_logistic(const float sample, const float scale, const float logistic_cdf_pi)
     {
-        const float trimmed_log_cdf = 1.0f - 2.0f * logistic_cdf(-Pi<float>(), scale);
-        const float x = -scale * std::log(1.0f / (sample * trimmed_log_cdf + logistic_cdf(-Pi<float>(), scale)) - 1.0f);
+        const float trimmed_log_cdf = 1.0f - 2.0f * logistic_cdf_pi;
+        const float x = -scale * std::log(1.0f / (sample * trimmed_log_cdf + logistic_cdf_pi) - 1.0f);
         return clamp(x, -Pi<float>(), Pi<float>());
     }
 
@@ -125,37 +166,38 @@ namespace
         return angle;
     }
 
+    //
+    // Logarithm of the normalization term 1 / (2 v sinh(1 / v)) of the longitudinal
+    // scattering function.
+    //
+
+    float longitudinal_log_norm(const float v)
+    {
+        // Low roughness values lead to precision issues
+        // in the longitudinal integral.
+        // https://publons.com/review/414383/
+
+        if (v <= 0.1f)
+            return -(1.0f / v) + 0.6931f + std::log(1.0f / (2.0f * v));
+        else return -std::log(std::sinh(1.0f / v) * 2.0f * v);
+    }
+
     //
     // Longitudinal scattering function.
     //
 
-    float longitudinal(
+    inline float longitudinal(
         const float cos_theta_i,
         const float cos_theta_o,
         const float sin_theta_i,
         const float sin_theta_o,
-        const float v)
+        const float rcp_v,
+        const float log_norm)
     {
-        const float bessel_arg = cos_theta_i * cos_theta_o / v;
-        const float exp_arg = sin_theta_i * sin_theta_o / v;
+        const float bessel_arg = cos_theta_i * cos_theta_o * rcp_v;
+        const float exp_arg = sin_theta_i * sin_theta_o * rcp_v;
 
-        // Low roughness values lead to precision issues
-        // in the longitudinal integral.
-        // https://publons.com/review/414383/
-
-        if (v <= 0.1f)
-        {
-            return
-                (std::exp(log_bessel(bessel_arg) -
-                exp_arg - (1.0f / v) +
-                0.6931f + std::log(1.0f / (2.0f * v))));
-        }
-        else
-        {
-            return
-                (std::exp(-exp_arg) * bessel(bessel_arg)) /
-                (std::sinh(1.0f / v) * 2.0f * v);
-        }
+        return std::exp(g_log_bessel_table.get(bessel_arg) - exp_arg + log_norm);
     }
 
     //
@@ -172,18 +214,6 @@ namespace
         return (-cos_theta * sin_tilt + sin_theta * cos_phi * cos_tilt);
     }
 
-    //
-    // Accumulate sum of luminances for a Spectrum array.
-    //
-
-    static float sum_luminance(const std::array<Spectrum, 4>& retAp)
-    {
-        return std::accumulate(retAp.begin(), retAp.end(), 0.0f, [](float s, const Spectrum& ap)
-        {
-            return s + luminance(ap.to_rgb(g_std_lighting_conditions));
-        });
-    }
-
     //
     // Attenuation function for each component of scattering.
     //
@@ -219,101 +249,126 @@ namespace
     //
 
     void attenuation_pdf(
-        const float             cos_theta_o,
-        const float             eta,
-        const float             h,
-        const Spectrum&         T,
-        std::array<float, 4>&   ret)
+        const std::array<Spectrum, 4>&  ap,
+        std::array<float, 4>&           ret)
     {
+        float sumY = 0.0f;
+        for (int i = 0; i <= 3; i++)
+        {
+            ret[i] = luminance(ap[i].to_rgb(g_std_lighting_conditions));
+            sumY += ret[i];
+        }
 
-        std::array<Spectrum, 4> retAp;
-        attenuation(cos_theta_o, eta, h, T, retAp);
-
-        const float sumY = sum_luminance(retAp);
+        const float rcp_sumY = 1.0f / sumY;
         for (int i = 0; i <= 3; i++)
-            ret[i] = luminance(retAp[i].to_rgb(g_std_lighting_conditions)) / sumY;
+            ret[i] *= rcp_sumY;
     }
 
     //
     // Azimuthal scattering function.
     //
 
-    inline float azimuthal(const float phi, const int p, const float s, const float gamma_o, const float gamma_t)
+    inline float azimuthal(
+        const float phi,
+        const int   p,
+        const float s,
+        const float rcp_norm,
+        const float gamma_o,
+        const float gamma_t)
     {
         const float dphi = wrap_to_pi(phi - calc_phi(p, gamma_o, gamma_t));
-        return trimmed_logistic_func(dphi, s);
+        return trimmed_logistic_func(dphi, s, rcp_norm);
     }
 
     //
-    // BSDF computation function.
+    // Outgoing longitudinal angle tilted by the cuticle scales for the R, TT
+    // and TRT components of scattering.
     //
 
-    void calc_bsdf(
-        const float                 cos_theta_i,
-        const float                 sin_theta_i,
-        const float                 cos_theta_o,
-        const float                 sin_theta_o,
-        const float                 cos_theta_o_R,
-        const float                 sin_theta_o_R,
-        const float                 cos_theta_o_TT,
-        const float                 sin_theta_o_TT,
-        const float                 cos_theta_o_TRT,
-        const float                 sin_theta_o_TRT,
-        const float                 v,
-        const float                 dphi,
-        const float                 s,
-        const float                 gamma_o,
-        const float                 gamma_t,
-        std::array<Spectrum, 4>&    ap,
-        Spectrum&                   bsdf_f)
+    void tilt_outgoing_angle(
+        const HairBSDFInputValues::Precomputed& precomputed,
+        const float                             sin_theta_o,
+        const float                             cos_theta_o,
+        std::array<float, 3>&                   sin_theta_o_p,
+        std::array<float, 3>&                   cos_theta_o_p)
     {
+        for (int p = 0; p < 3; ++p)
+        {
+            sin_theta_o_p[p] = sin_theta_o * precomputed.m_cos_angle[p] + cos_theta_o * precomputed.m_sin_angle[p];
+            cos_theta_o_p[p] = cos_theta_o * precomputed.m_cos_angle[p] - sin_theta_o * precomputed.m_sin_angle[p];
+        }
+    }
 
-        // RR contribution of scattering.
-        bsdf_f +=
-            ap[0] *
-            longitudinal(
-                cos_theta_i,
-                cos_theta_o_R,
-                sin_theta_i,
-                sin_theta_o_R,
-                v) *
-            azimuthal(dphi, 0, s, gamma_o, gamma_t);
-
-        // TT contribution of scattering.
-        bsdf_f +=
-            ap[1] *
-            longitudinal(
-                cos_theta_i,
-                cos_theta_o_TT,
-                sin_theta_i,
-                sin_theta_o_TT,
-                v * 0.25f) *
-            azimuthal(dphi, 1, s, gamma_o, gamma_t);
+    //
+    // Product of the longitudinal and azimuthal scattering functions for each
+    // component of scattering. These products are shared by the BSDF and the
+    // PDF, which only differ by the weights of the components.
+    //
 
+    void calc_lobes(
+        const HairBSDFInputValues::Precomputed& precomputed,
+        const float                             cos_theta_i,
+        const float                             sin_theta_i,
+        const float                             cos_theta_o,
+        const float                             sin_theta_o,
+        const std::array<float, 3>&             cos_theta_o_p,
+        const std::array<float, 3>&             sin_theta_o_p,
+        const float                             dphi,
+        const float                             gamma_o,
+        const float                             gamma_t,
+        std::array<float, 4>&                   lobes)
+    {
+        // Lobe roughnesses are v for R, v / 4 for TT and 4 v for TRT and TRRT+.
+        const float rcp_v[3] =
+        {
+            precomputed.m_rcp_v,
+            precomputed.m_rcp_v * 4.0f,
+            precomputed.m_rcp_v * 0.25f
+        };
 
-        // TRT contribution of scattering.
-        bsdf_f +=
-            ap[2] *
-            longitudinal(
-                cos_theta_i,
-                cos_theta_o_TRT,
-                sin_theta_i,
-                sin_theta_o_TRT,
-                v * 4.0f) *
-            azimuthal(dphi, 2, s, gamma_o, gamma_t);
+        // R, TT and TRT contributions of scattering.
+        for (int p = 0; p < 3; ++p)
+        {
+            lobes[p] =
+                longitudinal(
+                    cos_theta_i,
+                    std::abs(cos_theta_o_p[p]),
+                    sin_theta_i,
+                    sin_theta_o_p[p],
+                    rcp_v[p],
+                    precomputed.m_log_mp_norm[p]) *
+                azimuthal(
+                    dphi,
+                    p,
+                    precomputed.m_s,
+                    precomputed.m_rcp_trimmed_logistic_norm,
+                    gamma_o,
+                    gamma_t);
+        }
 
         // TRRT+ contribution of scattering.
-        bsdf_f +=
-            ap[3] *
+        lobes[3] =
             longitudinal(
                 cos_theta_i,
                 cos_theta_o,
                 sin_theta_i,
                 sin_theta_o,
-                v * 4.0f) *
+                rcp_v[2],
+                precomputed.m_log_mp_norm[2]) *
             RcpTwoPi<float>();
+    }
 
+    //
+    // BSDF computation function.
+    //
 
+    void calc_bsdf(
+        const std::array<float, 4>&     lobes,
+        const std::array<Spectrum, 4>&  ap,
+        Spectrum&                       bsdf_f)
+    {
+        for (int p = 0; p <= 3; ++p)
+            bsdf_f += ap[p] * lobes[p];
     }
 
     //
@@ -321,69 +376,12 @@ namespace
     //
 
     void calc_pdf(
-        const float             cos_theta_i,
-        const float             sin_theta_i,
-        const float             cos_theta_o,
-        const float             sin_theta_o,
-        const float             cos_theta_o_R,
-        const float             sin_theta_o_R,
-        const float             cos_theta_o_TT,
-        const float             sin_theta_o_TT,
-        const float             cos_theta_o_TRT,
-        const float             sin_theta_o_TRT,
-        const float             v,
-        const float             dphi,
-        const float             s,
-        const float             gamma_o,
-        const float             gamma_t,
-        std::array<float, 4>&   ap_pdf,
-        float&                  bsdf_pdf)
+        const std::array<float, 4>&     lobes,
+        const std::array<float, 4>&     ap_pdf,
+        float&                          bsdf_pdf)
     {
-
-        // RR contribution of scattering.
-        bsdf_pdf +=
-            ap_pdf[0] *
-            longitudinal(
-                cos_theta_i,
-                cos_theta_o_R,
-                sin_theta_i,
-                sin_theta_o_R,
-                v) *
-            azimuthal(dphi, 0, s, gamma_o, gamma_t);
-
-        // TT contribution of scattering.
-        bsdf_pdf +=
-            ap_pdf[1] *
-            longitudinal(
-                cos_theta_i,
-                cos_theta_o_TT,
-                sin_theta_i,
-                sin_theta_o_TT,
-                v * 0.25f) *
-            azimuthal(dphi, 1, s, gamma_o, gamma_t);
-
-
-        // TRT contribution of scattering.
-        bsdf_pdf +=
-            ap_pdf[2] *
-            longitudinal(
-                cos_theta_i,
-                cos_theta_o_TRT,
-                sin_theta_i,
-                sin_theta_o_TRT,
-                v * 4.0f) *
-            azimuthal(dphi, 2, s, gamma_o, gamma_t);
-
-        // TRRT+ contribution of scattering.
-        bsdf_pdf +=
-            ap_pdf[3] *
-            longitudinal(
-                cos_theta_i,
-                cos_theta_o,
-                sin_theta_i,
-                sin_theta_o,
-                v * 4.0f) *
-            RcpTwoPi<float>();
+        for (int p = 0; p <= 3; ++p)
+            bsdf_pdf += ap_pdf[p] * lobes[p];
     }
 
     //
@@ -486,6 +484,7 @@ namespace
             new (&values->m_precomputed) InputValues::Precomputed();
 
             values->m_precomputed.m_h = -1.0f + 2.0f * shading_point.get_bary()[0];
+            values->m_precomputed.m_gamma_o = std::asin(clamp(values->m_precomputed.m_h, -1.0f, 1.0f));
             if (is_zero(values->m_reflectance))
                 values->m_precomputed.m_sigma_a =
                 sigma_a_from_melanin(values->m_melanin, values->m_melanin_redness);
@@ -499,6 +498,12 @@ namespace
                 0.812f * values->m_beta_M * values->m_beta_M +
                 3.7f * pow_int(values->m_beta_M, 20);
             values->m_precomputed.m_v *= values->m_precomputed.m_v;
+            values->m_precomputed.m_rcp_v = 1.0f / values->m_precomputed.m_v;
+
+            // Normalization terms of the longitudinal scattering function of the R, TT and TRT lobes.
+            values->m_precomputed.m_log_mp_norm[0] = longitudinal_log_norm(values->m_precomputed.m_v);
+            values->m_precomputed.m_log_mp_norm[1] = longitudinal_log_norm(values->m_precomputed.m_v * 0.25f);
+            values->m_precomputed.m_log_mp_norm[2] = longitudinal_log_norm(values->m_precomputed.m_v * 4.0f);
 
             // Scale factor to convert logistic function to gaussian.
             values->m_precomputed.m_s =
@@ -506,10 +511,20 @@ namespace
                 1.194f * values->m_beta_N * values->m_beta_N +
                 5.372f * pow_int(values->m_beta_N, 22));
 
+            // Normalization term of the logistic function trimmed to [-pi, pi].
+            values->m_precomputed.m_logistic_cdf_pi = logistic_cdf(-Pi<float>(), values->m_precomputed.m_s);
+            const float trimmed_logistic_norm = 1.0f - 2.0f * values->m_precomputed.m_logistic_cdf_pi;
+            assert(trimmed_logistic_norm != 0.0f);
+            values->m_precomputed.m_rcp_trimmed_logistic_norm = 1.0f / trimmed_logistic_norm;
+
+            // Tilts of the R, TT and TRT lobes due to cuticular scales.
             const float ang_in_radians = deg_to_rad<float>(values->m_alpha);
-            values->m_precomputed.m_angle_R = -2.0f * ang_in_radians;
-            values->m_precomputed.m_angle_TT = ang_in_radians;
-            values->m_precomputed.m_angle_TRT = 4.0f * ang_in_radians;
+            const float angles[3] = { -2.0f * ang_in_radians, ang_in_radians, 4.0f * ang_in_radians };
+            for (int p = 0; p < 3; ++p)
+            {
+                values->m_precomputed.m_sin_angle[p] = std::sin(angles[p]);
+                values->m_precomputed.m_cos_angle[p] = std::cos(angles[p]);
+            }
         }
 
         void sample(
@@ -545,7 +560,7 @@ namespace
             const float sin_gamma_t = values->m_precomputed.m_h / eta_p;
             const float cos_gamma_t = std::sqrt(std::max(0.0f, 1.0f - sin_gamma_t * sin_gamma_t));
             const float gamma_t = std::asin(clamp(sin_gamma_t, -1.0f, 1.0f));
-            const float gamma_o = std::asin(clamp(values->m_precomputed.m_h, -1.0f, 1.0f));
+            const float gamma_o = values->m_precomputed.m_gamma_o;
 
             // Compute attenuation for the single path through the hair cylinder.
             const Spectrum T = exp(-values->m_precomputed.m_sigma_a * (( 2.0f * cos_gamma_t) / cos_theta_t));
@@ -554,7 +569,7 @@ namespace
             std::array<Spectrum, 4> ap;
             attenuation(cos_theta_o, values->m_eta, values->m_precomputed.m_h, T, ap);
             std::array<float, 4> ap_pdf;
-            attenuation_pdf(cos_theta_o, values->m_eta, values->m_precomputed.m_h, T, ap_pdf);
+            attenuation_pdf(ap, ap_pdf);
             int p;
             for (p = 0; p < 3; ++p)
             {
@@ -564,91 +579,52 @@ namespace
             }
 
             sample_M[0] = std::max(sample_M[0], float(1e-5));
-            const float theta_o = std::asin(clamp(sin_theta_o, -1.0f, 1.0f));
 
             // Deviation of outgoing angle due to cuticular scales.
-            const float theta_o_R = theta_o + values->m_precomputed.m_angle_R;
-            const float theta_o_TT = theta_o + values->m_precomputed.m_angle_TT;
-            const float theta_o_TRT = theta_o + values->m_precomputed.m_angle_TRT;
+            std::array<float, 3> sin_theta_o_p, cos_theta_o_p;
+            tilt_outgoing_angle(values->m_precomputed, sin_theta_o, cos_theta_o, sin_theta_o_p, cos_theta_o_p);
 
             // Sample longitudinal function for given component of scattering.
-
-            float sin_theta_i;
-            if (p == 0)
-            {
-                sin_theta_i = sample_longitudinal(
-                    std::sin(theta_o_R),
-                    std::cos(theta_o_R),
-                    values->m_precomputed.m_v,
-                    sample_M);
-            }
-            else if (p == 1)
-            {
-                sin_theta_i = sample_longitudinal(
-                    std::sin(theta_o_TT),
-                    std::cos(theta_o_TT),
-                    values->m_precomputed.m_v * 0.25f,
-                    sample_M);
-            }
-            else
-            {
-                sin_theta_i = sample_longitudinal(
-                    std::sin(theta_o_TRT),
-                    std::cos(theta_o_TRT),
-                    values->m_precomputed.m_v * 4.0f,
-                    sample_M);
-            }
+            const float lobe_v =
+                p == 0 ? values->m_precomputed.m_v :
+                p == 1 ? values->m_precomputed.m_v * 0.25f :
+                         values->m_precomputed.m_v * 4.0f;
+            const int tilt_index = std::min(p, 2);
+            const float sin_theta_i = sample_longitudinal(
+                sin_theta_o_p[tilt_index],
+                cos_theta_o_p[tilt_index],
+                lobe_v,
+                sample_M);
             const float cos_theta_i = std::sqrt(std::max(0.0f, 1.0f - sin_theta_i * sin_theta_i));
 
             // Sample azimuthal scattering function to compute change in azimuthal direction.
             float dphi;
             dphi = calc_phi(p, gamma_o, gamma_t) +
-            sample_trimmed_logistic(sample_N[1], values->m_precomputed.m_s);
+            sample_trimmed_logistic(sample_N[1], values->m_precomputed.m_s, values->m_precomputed.m_logistic_cdf_pi);
 
             // Compute wi from sampled hair scattering angles.
             const float phi_i = phi_o + dphi;
             const Vector3f wi = Vector3f(sin_theta_i, cos_theta_i * std::sin(phi_i), cos_theta_i * std::cos(phi_i));
 
-            Spectrum bsdf_f(0.0f);
-            float bsdf_pdf(0.0f);
-
-            calc_bsdf(
+            std::array<float, 4> lobes;
+            calc_lobes(
+                values->m_precomputed,
                 cos_theta_i,
                 sin_theta_i,
                 cos_theta_o,
                 sin_theta_o,
-                std::abs(std::cos(theta_o_R)),
-                std::sin(theta_o_R),
-                std::abs(std::cos(theta_o_TT)),
-                std::sin(theta_o_TT),
-                std::abs(std::cos(theta_o_TRT)),
-                std::sin(theta_o_TRT),
-                values->m_precomputed.m_v,
+                cos_theta_o_p,
+                sin_theta_o_p,
                 dphi,
-                values->m_precomputed.m_s,
                 gamma_o,
                 gamma_t,
-                ap,
-                bsdf_f);
+                lobes);
 
-            calc_pdf(
-                cos_theta_i,
-                sin_theta_i,
-                cos_theta_o,
-                sin_theta_o,
-                std::abs(std::cos(theta_o_R)),
-                std::sin(theta_o_R),
-                std::abs(std::cos(theta_o_TT)),
-                std::sin(theta_o_TT),
-                std::abs(std::cos(theta_o_TRT)),
-                std::sin(theta_o_TRT),
-                values->m_precomputed.m_v,
-                dphi,
-                values->m_precomputed.m_s,
-                gamma_o,
-                gamma_t,
-                ap_pdf,
-                bsdf_pdf);
+            Spectrum bsdf_f(0.0f);
+            float bsdf_pdf(0.0f);
+
+            calc_bsdf(lobes, ap, bsdf_f);
+            calc_pdf(lobes, ap_pdf, bsdf_pdf);
 
             const float angle_bsdf = std::abs(wi.y);
 
@@ -679,87 +655,24 @@ namespace
             // Compute the BRDF value.
             const InputValues* values = static_cast<const InputValues*>(data);
 
-            const Vector3f wo = local_geometry.m_shading_basis.transform_to_local(outgoing);
-            const Vector3f wi = local_geometry.m_shading_basis.transform_to_local(incoming);
-
-            // Compute outgoing terms.
-            const float sin_theta_o = wo.x;
-            const float cos_theta_o = std::sqrt(std::max(0.0f, 1.0f - sin_theta_o * sin_theta_o));
-            const float phi_o = std::atan2(wo.y, wo.z);
-            const float gamma_o = std::asin(clamp(values->m_precomputed.m_h, -1.0f, 1.0f));
-
-            // Compute incoming terms.
-            const float sin_theta_i = wi.x;
-            const float cos_theta_i = std::sqrt(std::max(0.0f, 1.0f - sin_theta_i * sin_theta_i));
-            const float phi_i = std::atan2(wi.y, wi.z);
-
-            // Compute terms for the refracted ray.
-            const float sin_theta_t = sin_theta_o / values->m_eta;
-            const float cos_theta_t = std::sqrt(std::max(0.0f, 1.0f - sin_theta_t * sin_theta_t));
-
-            // Compute the modified refraction coefficient.
-            const float eta_p = std::sqrt(values->m_eta * values->m_eta - sin_theta_o * sin_theta_o) / cos_theta_o;
-            const float sin_gamma_t = values->m_precomputed.m_h / eta_p;
-            const float cos_gamma_t = std::sqrt(std::max(0.0f, 1.0f - sin_gamma_t * sin_gamma_t));
-            const float gamma_t = std::asin(clamp(sin_gamma_t, -1.0f, 1.0f));
-            const float theta_o = std::asin(clamp(sin_theta_o, -1.0f, 1.0f));
-
-            // Deviation of outgoing angle due to cuticular scales.
-            const float theta_o_R = theta_o + values->m_precomputed.m_angle_R;
-            const float theta_o_TT = theta_o + values->m_precomputed.m_angle_TT;
-            const float theta_o_TRT = theta_o + values->m_precomputed.m_angle_TRT;
-
-            // Compute attenuation for the single path through the hair cylinder.
-            const Spectrum T = exp(-values->m_precomputed.m_sigma_a * ((2.0f * cos_gamma_t) / cos_theta_t));
-
-            const float dphi = phi_i - phi_o;
             std::array<Spectrum, 4> ap;
-            attenuation(cos_theta_o, values->m_eta, values->m_precomputed.m_h, T, ap);
             std::array<float, 4> ap_pdf;
-            attenuation_pdf(cos_theta_o, values->m_eta, values->m_precomputed.m_h, T, ap_pdf);
+            std::array<float, 4> lobes;
+            const float angle_bsdf =
+                compute_lobes(
+                    values,
+                    local_geometry,
+                    outgoing,
+                    incoming,
+                    ap,
+                    ap_pdf,
+                    lobes);
 
             Spectrum bsdf_f(0.0f);
             float bsdf_pdf = 0.0f;
 
-            calc_bsdf(
-                cos_theta_i,
-                sin_theta_i,
-                cos_theta_o,
-                sin_theta_o,
-                std::abs(std::cos(theta_o_R)),
-                std::sin(theta_o_R),
-                std::abs(std::cos(theta_o_TT)),
-                std::sin(theta_o_TT),
-                std::abs(std::cos(theta_o_TRT)),
-                std::sin(theta_o_TRT),
-                values->m_precomputed.m_v,
-                dphi,
-                values->m_precomputed.m_s,
-                gamma_o,
-                gamma_t,
-                ap,
-                bsdf_f);
-
-            calc_pdf(
-                cos_theta_i,
-                sin_theta_i,
-                cos_theta_o,
-                sin_theta_o,
-                std::abs(std::cos(theta_o_R)),
-                std::sin(theta_o_R),
-                std::abs(std::cos(theta_o_TT)),
-                std::sin(theta_o_TT),
-                std::abs(std::cos(theta_o_TRT)),
-                std::sin(theta_o_TRT),
-                values->m_precomputed.m_v,
-                dphi,
-                values->m_precomputed.m_s,
-                gamma_o,
-                gamma_t,
-                ap_pdf,
-                bsdf_pdf);
-
-            const float angle_bsdf = std::abs(wi.y);
+            calc_bsdf(lobes, ap, bsdf_f);
+            calc_pdf(lobes, ap_pdf, bsdf_pdf);
 
             if (angle_bsdf > 0)
                 bsdf_f /= angle_bsdf;
@@ -784,6 +697,41 @@ namespace
             // Compute the BRDF value.
             const InputValues* values = static_cast<const InputValues*>(data);
 
+            std::array<Spectrum, 4> ap;
+            std::array<float, 4> ap_pdf;
+            std::array<float, 4> lobes;
+            compute_lobes(
+                values,
+                local_geometry,
+                outgoing,
+                incoming,
+                ap,
+                ap_pdf,
+                lobes);
+
+            float bsdf_pdf = 0.0f;
+
+            calc_pdf(lobes, ap_pdf, bsdf_pdf);
+
+            return bsdf_pdf;
+        }
+
+
+    private:
+        typedef HairBSDFInputValues InputValues;
+
+        // Compute the attenuations and the scattering lobes for a pair of directions.
+        // Return the absolute value of the cosine between the incoming direction and
+        // the normal of the hair.
+        static float compute_lobes(
+            const InputValues*          values,
+            const LocalGeometry&        local_geometry,
+            const Vector3f&             outgoing,
+            const Vector3f&             incoming,
+            std::array<Spectrum, 4>&    ap,
+            std::array<float, 4>&       ap_pdf,
+            std::array<float, 4>&       lobes)
+        {
             const Vector3f wo = local_geometry.m_shading_basis.transform_to_local(outgoing);
             const Vector3f wi = local_geometry.m_shading_basis.transform_to_local(incoming);
 
@@ -791,7 +739,7 @@ namespace
             const float sin_theta_o = wo.x;
             const float cos_theta_o = std::sqrt(std::max(0.0f, 1.0f - sin_theta_o * sin_theta_o));
             const float phi_o = std::atan2(wo.y, wo.z);
-            const float gamma_o = std::asin(clamp(values->m_precomputed.m_h, -1.0f, 1.0f));
+            const float gamma_o = values->m_precomputed.m_gamma_o;
 
             // Compute incoming terms.
             const float sin_theta_i = wi.x;
@@ -807,47 +755,33 @@ namespace
             const float sin_gamma_t = values->m_precomputed.m_h / eta_p;
             const float cos_gamma_t = std::sqrt(std::max(0.0f, 1.0f - sin_gamma_t * sin_gamma_t));
             const float gamma_t = std::asin(clamp(sin_gamma_t, -1.0f, 1.0f));
-            const float theta_o = std::asin(clamp(sin_theta_o, -1.0f, 1.0f));
 
             // Deviation of outgoing angle due to cuticular scales.
-            const float theta_o_R = theta_o + values->m_precomputed.m_angle_R;
-            const float theta_o_TT = theta_o + values->m_precomputed.m_angle_TT;
-            const float theta_o_TRT = theta_o + values->m_precomputed.m_angle_TRT;
+            std::array<float, 3> sin_theta_o_p, cos_theta_o_p;
+            tilt_outgoing_angle(values->m_precomputed, sin_theta_o, cos_theta_o, sin_theta_o_p, cos_theta_o_p);
 
             // Compute attenuation for the single path through the hair cylinder.
             const Spectrum T = exp(-values->m_precomputed.m_sigma_a * ((2.0f * cos_gamma_t) / cos_theta_t));
 
             const float dphi = phi_i - phi_o;
-            std::array<float, 4> ap_pdf;
-            attenuation_pdf(cos_theta_o, values->m_eta, values->m_precomputed.m_h, T, ap_pdf);
-
-            float bsdf_pdf = 0.0f;
+            attenuation(cos_theta_o, values->m_eta, values->m_precomputed.m_h, T, ap);
+            attenuation_pdf(ap, ap_pdf);
 
-            calc_pdf(
+            calc_lobes(
+                values->m_precomputed,
                 cos_theta_i,
                 sin_theta_i,
                 cos_theta_o,
                 sin_theta_o,
-                std::abs(std::cos(theta_o_R)),
-                std::sin(theta_o_R),
-                std::abs(std::cos(theta_o_TT)),
-                std::sin(theta_o_TT),
-                std::abs(std::cos(theta_o_TRT)),
-                std::sin(theta_o_TRT),
-                values->m_precomputed.m_v,
+                cos_theta_o_p,
+                sin_theta_o_p,
                 dphi,
-                values->m_precomputed.m_s,
                 gamma_o,
                 gamma_t,
-                ap_pdf,
-                bsdf_pdf);
+                lobes);
 
-            return bsdf_pdf;
+            return std::abs(wi.y);
         }
-
-
-    private:
-        typedef HairBSDFInputValues InputValues;
     };
 
     typedef BSDFWrapper<HairBSDFImpl> HairBSDF;
@@ -66,11 +66,15 @@ APPLESEED_DECLARE_INPUT_VALUES(HairBSDFInputValues)
     {
         Spectrum    m_sigma_a;
         float       m_h;
+        float       m_gamma_o;
         float       m_v;
+        float       m_rcp_v;
+        float       m_log_mp_norm[3];               // log of the longitudinal normalization terms of the R, TT and TRT lobes
         float       m_s;
-        float       m_angle_R;
-        float       m_angle_TT;
-        float       m_angle_TRT;
+        float       m_logistic_cdf_pi;              // logistic CDF at -pi
+        float       m_rcp_trimmed_logistic_norm;    // reciprocal of the integral of the logistic function over [-pi, pi]
+        float       m_sin_angle[3];                 // sines of the cuticle tilts of the R, TT and TRT lobes
+        float       m_cos_angle[3];                 // cosines of the cuticle tilts of the R, TT and TRT lobes
     };
 
     Precomputed m_precomputed;
@@ -30,11 +30,13 @@
 #include "bssrdf.h"
 
 // appleseed.renderer headers.
+#include "renderer/kernel/intersection/intersector.h"
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/kernel/shading/shadingray.h"
 #include "renderer/modeling/input/inputarray.h"
 #include "renderer/modeling/input/sourceinputs.h"
+#include "renderer/modeling/scene/objectinstance.h"
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
@@ -133,4 +135,32 @@ void BSSRDF::build_cdf_and_pdf(
     cdf[src.size() - 1] = 1.0f;
 }
 
+
+//
+// Subsurface ray tracing.
+//
+
+bool trace_subsurface_ray(
+    const ShadingContext&   shading_context,
+    const ShadingPoint&     outgoing_point,
+    const ShadingRay&       ray,
+    ShadingPoint&           shading_point,
+    const ShadingPoint*     parent_shading_point)
+{
+    const Intersector& intersector = shading_context.get_intersector();
+
+    if (outgoing_point.is_triangle_primitive() &&
+        outgoing_point.get_object_instance().has_own_sss_set())
+    {
+        return
+            intersector.trace_object_instance(
+                ray,
+                outgoing_point,
+                shading_point,
+                parent_shading_point);
+    }
+
+    return intersector.trace(ray, shading_point, parent_shading_point);
+}
+
 }   // namespace renderer
@@ -49,6 +49,7 @@ namespace renderer      { class BSSRDFSample; }
 namespace renderer      { class ParamArray; }
 namespace renderer      { class ShadingContext; }
 namespace renderer      { class ShadingPoint; }
+namespace renderer      { class ShadingRay; }
 
 namespace renderer
 {
@@ -136,4 +137,18 @@ class APPLESEED_DLLSYMBOL BSSRDF
         Spectrum&                   pdf);
 };
 
+
+//
+// Trace a ray looking for surfaces the light scattered below outgoing_point may exit from.
+// When no other object instance can share the SSS set of outgoing_point, the ray is only
+// traced against the object instance of outgoing_point, skipping unrelated geometry.
+//
+
+bool trace_subsurface_ray(
+    const ShadingContext&           shading_context,
+    const ShadingPoint&             outgoing_point,
+    const ShadingRay&               ray,
+    ShadingPoint&                   shading_point,
+    const ShadingPoint*             parent_shading_point = nullptr);
+
 }   // namespace renderer
@@ -30,7 +30,6 @@
 #include "randomwalkbssrdf.h"
 
 // appleseed.renderer headers.
-#include "renderer/kernel/intersection/intersector.h"
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/modeling/bsdf/bsdf.h"
@@ -364,7 +363,9 @@ namespace
                 // Trace the ray up to the sampled distance.
                 new_ray.m_tmax = distance;
                 bssrdf_sample.m_incoming_point.clear();
-                shading_context.get_intersector().trace(
+                trace_subsurface_ray(
+                    shading_context,
+                    outgoing_point,
                     new_ray,
                     bssrdf_sample.m_incoming_point);
                 transmitted = bssrdf_sample.m_incoming_point.hit_surface();
@@ -698,7 +699,9 @@ namespace
                     outgoing_point.get_time(),
                     VisibilityFlags::SubsurfaceRay,
                     outgoing_point.get_ray().m_depth + 1);
-                shading_context.get_intersector().trace(
+                trace_subsurface_ray(
+                    shading_context,
+                    outgoing_point,
                     ray,
                     shading_points[next_point_idx],
                     shading_point_ptr);
@@ -769,7 +772,9 @@ namespace
                 VisibilityFlags::SubsurfaceRay,
                 outgoing_point.get_ray().m_depth + 1);
             bssrdf_sample.m_incoming_point.clear();
-            shading_context.get_intersector().trace(
+            trace_subsurface_ray(
+                shading_context,
+                outgoing_point,
                 ray,
                 bssrdf_sample.m_incoming_point,
                 &outgoing_point);
@@ -30,7 +30,6 @@
 #include "separablebssrdf.h"
 
 // appleseed.renderer headers.
-#include "renderer/kernel/intersection/intersector.h"
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/kernel/shading/shadingray.h"
@@ -243,7 +242,7 @@ namespace
         {
             // Continue tracing the ray.
             ShadingPoint& incoming_point = shading_points[sample_count];
-            if (!shading_context.get_intersector().trace(probe_ray, incoming_point))
+            if (!trace_subsurface_ray(shading_context, outgoing_point, probe_ray, incoming_point))
                 break;
 
             // Move the ray's origin past the hit surface.
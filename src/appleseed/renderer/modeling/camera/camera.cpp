@@ -196,6 +196,16 @@ bool Camera::on_frame_begin(
     return true;
 }
 
+void Camera::spawn_rays(
+    SamplingContext         sampling_contexts[],
+    const Dual2d            ndc[],
+    const size_t            count,
+    ShadingRay              rays[]) const
+{
+    for (size_t i = 0; i < count; ++i)
+        spawn_ray(sampling_contexts[i], ndc[i], rays[i]);
+}
+
 bool Camera::project_point(
     const float             time,
     const Vector3d&         point,
@@ -42,6 +42,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace foundation    { class DictionaryArray; }
 namespace foundation    { class IAbortSwitch; }
@@ -125,6 +128,15 @@ class APPLESEED_DLLSYMBOL Camera
         const foundation::Dual2d&       ndc,
         ShadingRay&                     ray) const = 0;
 
+    // Generate one ray per film point. This is equivalent to calling spawn_ray() for each
+    // point with its own sampling context, but lets camera models share work such as
+    // transform evaluation between rays. The default implementation calls spawn_ray().
+    virtual void spawn_rays(
+        SamplingContext                 sampling_contexts[],
+        const foundation::Dual2d        ndc[],
+        const size_t                    count,
+        ShadingRay                      rays[]) const;
+
     // Connect a vertex to the camera and return the direction vector from the
     // point to the camera, the normalized device coordinates of the projected
     // point on the camera film and the emitted importance. The direction vector
@@ -197,6 +197,15 @@ namespace
             }
         }
 
+        void spawn_rays(
+            SamplingContext         sampling_contexts[],
+            const Dual2d            ndc[],
+            const size_t            count,
+            ShadingRay              rays[]) const override
+        {
+            spawn_rays_through_lens_center(sampling_contexts, ndc, count, rays);
+        }
+
         bool connect_vertex(
             SamplingContext&        sampling_context,
             const float             time,
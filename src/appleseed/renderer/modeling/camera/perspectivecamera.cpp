@@ -31,6 +31,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/rasterization/rasterizationcamera.h"
+#include "renderer/kernel/shading/shadingray.h"
 #include "renderer/modeling/frame/frame.h"
 #include "renderer/modeling/project/project.h"
 #include "renderer/utility/paramarray.h"
@@ -40,13 +41,78 @@
 #include "foundation/image/image.h"
 #include "foundation/math/intersection/planesegment.h"
 #include "foundation/math/scalar.h"
+#include "foundation/math/transform.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
 #include "foundation/utility/api/apistring.h"
 
+// Standard headers.
+#include <cmath>
+
 using namespace foundation;
 
 namespace renderer
 {
 
+namespace
+{
+    // Compute normalize(base + x * dx + y * dy) for each film point (x, y).
+    void compute_directions(
+        const Vector3d&     base,
+        const Vector3d&     dx,
+        const Vector3d&     dy,
+        const Vector2d      points[],
+        const size_t        count,
+        Vector3d            directions[])
+    {
+        size_t i = 0;
+
+#ifdef APPLESEED_USE_SSE
+
+        const __m128d base_x = _mm_set1_pd(base.x);
+        const __m128d base_y = _mm_set1_pd(base.y);
+        const __m128d base_z = _mm_set1_pd(base.z);
+        const __m128d dx_x = _mm_set1_pd(dx.x);
+        const __m128d dx_y = _mm_set1_pd(dx.y);
+        const __m128d dx_z = _mm_set1_pd(dx.z);
+        const __m128d dy_x = _mm_set1_pd(dy.x);
+        const __m128d dy_y = _mm_set1_pd(dy.y);
+        const __m128d dy_z = _mm_set1_pd(dy.z);
+        const __m128d one = _mm_set1_pd(1.0);
+
+        // Two directions at a time.
+        for (; i + 1 < count; i += 2)
+        {
+            const __m128d x = _mm_set_pd(points[i + 1].x, points[i].x);
+            const __m128d y = _mm_set_pd(points[i + 1].y, points[i].y);
+
+            const __m128d d_x = _mm_add_pd(base_x, _mm_add_pd(_mm_mul_pd(x, dx_x), _mm_mul_pd(y, dy_x)));
+            const __m128d d_y = _mm_add_pd(base_y, _mm_add_pd(_mm_mul_pd(x, dx_y), _mm_mul_pd(y, dy_y)));
+            const __m128d d_z = _mm_add_pd(base_z, _mm_add_pd(_mm_mul_pd(x, dx_z), _mm_mul_pd(y, dy_z)));
+
+            const __m128d square_norm =
+                _mm_add_pd(
+                    _mm_mul_pd(d_x, d_x),
+                    _mm_add_pd(_mm_mul_pd(d_y, d_y), _mm_mul_pd(d_z, d_z)));
+            const __m128d rcp_norm = _mm_div_pd(one, _mm_sqrt_pd(square_norm));
+
+            M128Fields n_x, n_y, n_z;
+            n_x.m128d = _mm_mul_pd(d_x, rcp_norm);
+            n_y.m128d = _mm_mul_pd(d_y, rcp_norm);
+            n_z.m128d = _mm_mul_pd(d_z, rcp_norm);
+
+            directions[i + 0] = Vector3d(n_x.f64[0], n_y.f64[0], n_z.f64[0]);
+            directions[i + 1] = Vector3d(n_x.f64[1], n_y.f64[1], n_z.f64[1]);
+        }
+
+#endif
+
+        for (; i < count; ++i)
+            directions[i] = normalize(base + points[i].x * dx + points[i].y * dy);
+    }
+}
+
 //
 // PerspectiveCamera class implementation.
 //
@@ -222,4 +288,81 @@ Vector2d PerspectiveCamera::camera_to_ndc(const Vector3d& point) const
             0.5 + ((point.y * k + m_shift.y) * m_rcp_film_height));
 }
 
+void PerspectiveCamera::spawn_rays_through_lens_center(
+    SamplingContext         sampling_contexts[],
+    const Dual2d            ndc[],
+    const size_t            count,
+    ShadingRay              rays[]) const
+{
+    // Sample ray times first, consuming each sampling context as spawn_ray() would.
+    for (size_t i = 0; i < count; ++i)
+        initialize_ray(sampling_contexts[i], rays[i]);
+
+    // Film points and directions of a chunk of rays, including ray derivatives.
+    const size_t MaxChunkSize = 16;
+    Vector2d points[3 * MaxChunkSize];
+    Vector3d directions[3 * MaxChunkSize];
+
+    size_t begin = 0;
+
+    while (begin < count)
+    {
+        // Process consecutive rays sharing the same time, hence the same camera transform.
+        const float time = rays[begin].m_time.m_absolute;
+        size_t end = begin + 1;
+        while (end < count && end - begin < MaxChunkSize && rays[end].m_time.m_absolute == time)
+            ++end;
+
+        Transformd scratch;
+        const Transformd& transform =
+            m_transform_sequence.evaluate(time, scratch);
+
+        // The world space direction toward film point (x, y), before normalization,
+        // is -ndc_to_camera(x, y) transformed to world space, an affine function of x and y.
+        const Vector3d origin = transform.get_local_to_parent().extract_translation();
+        const Vector3d base =
+            transform.vector_to_parent(
+                Vector3d(
+                    m_shift.x - 0.5 * m_film_dimensions[0],
+                    m_shift.y + 0.5 * m_film_dimensions[1],
+                    -m_focal_length));
+        const Vector3d dx = transform.vector_to_parent(Vector3d(m_film_dimensions[0], 0.0, 0.0));
+        const Vector3d dy = transform.vector_to_parent(Vector3d(0.0, -m_film_dimensions[1], 0.0));
+
+        size_t point_count = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            points[point_count++] = ndc[i].get_value();
+
+            if (ndc[i].has_derivatives())
+            {
+                points[point_count++] = ndc[i].get_value() + ndc[i].get_dx();
+                points[point_count++] = ndc[i].get_value() + ndc[i].get_dy();
+            }
+        }
+
+        compute_directions(base, dx, dy, points, point_count, directions);
+
+        const Vector3d* direction = directions;
+        for (size_t i = begin; i < end; ++i)
+        {
+            ShadingRay& ray = rays[i];
+
+            ray.m_org = origin;
+            ray.m_dir = *direction++;
+
+            if (ndc[i].has_derivatives())
+            {
+                ray.m_rx.m_org = origin;
+                ray.m_ry.m_org = origin;
+                ray.m_rx.m_dir = *direction++;
+                ray.m_ry.m_dir = *direction++;
+                ray.m_has_differentials = true;
+            }
+        }
+
+        begin = end;
+    }
+}
+
 }   // namespace renderer
@@ -32,11 +32,16 @@
 #include "renderer/modeling/camera/camera.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/dual.h"
 #include "foundation/math/vector.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace renderer      { class ParamArray; }
 namespace renderer      { class RasterizationCamera; }
+namespace renderer      { class ShadingRay; }
 
 namespace renderer
 {
@@ -109,6 +114,14 @@ class PerspectiveCamera
     // Project points between NDC and camera spaces.
     foundation::Vector3d ndc_to_camera(const foundation::Vector2d& point) const;
     foundation::Vector2d camera_to_ndc(const foundation::Vector3d& point) const;
+
+    // Batched equivalent of spawning rays that originate at the center of the lens and
+    // pass through the film points, for cameras whose spawn_ray() only samples time.
+    void spawn_rays_through_lens_center(
+        SamplingContext                 sampling_contexts[],
+        const foundation::Dual2d        ndc[],
+        const size_t                    count,
+        ShadingRay                      rays[]) const;
 };
 
 }   // namespace renderer
@@ -351,6 +351,62 @@ namespace
             }
         }
 
+        void spawn_rays(
+            SamplingContext         sampling_contexts[],
+            const Dual2d            ndc[],
+            const size_t            count,
+            ShadingRay              rays[]) const override
+        {
+            Transformd scratch;
+            const Transformd* transform = nullptr;
+            float transform_time = 0.0f;
+            Vector3d focal_base, focal_dx, focal_dy;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                SamplingContext& sampling_context = sampling_contexts[i];
+                ShadingRay& ray = rays[i];
+
+                // Initialize the ray.
+                initialize_ray(sampling_context, ray);
+
+                // Consecutive rays with the same time share the camera transform.
+                if (transform == nullptr || ray.m_time.m_absolute != transform_time)
+                {
+                    transform = &m_transform_sequence.evaluate(ray.m_time.m_absolute, scratch);
+                    transform_time = ray.m_time.m_absolute;
+
+                    // The world space focal point of a film point is an affine function of its NDC.
+                    focal_base = transform->point_to_parent(-m_focal_ratio * ndc_to_camera(Vector2d(0.0)));
+                    focal_dx = transform->vector_to_parent(Vector3d(m_focal_ratio * m_film_dimensions[0], 0.0, 0.0));
+                    focal_dy = transform->vector_to_parent(Vector3d(0.0, -m_focal_ratio * m_film_dimensions[1], 0.0));
+                }
+
+                // Compute lens point in world space.
+                const Vector3d lens_point = transform->point_to_parent(sample_lens(sampling_context));
+
+                // Compute ray origin and direction.
+                const Vector2d& p = ndc[i].get_value();
+                ray.m_org = lens_point;
+                ray.m_dir = normalize(focal_base + p.x * focal_dx + p.y * focal_dy - lens_point);
+
+                // Compute ray derivatives.
+                if (ndc[i].has_derivatives())
+                {
+                    const Vector2d px(p + ndc[i].get_dx());
+                    const Vector2d py(p + ndc[i].get_dy());
+
+                    ray.m_rx.m_org = lens_point;
+                    ray.m_ry.m_org = lens_point;
+
+                    ray.m_rx.m_dir = normalize(focal_base + px.x * focal_dx + px.y * focal_dy - lens_point);
+                    ray.m_ry.m_dir = normalize(focal_base + py.x * focal_dx + py.y * focal_dy - lens_point);
+
+                    ray.m_has_differentials = true;
+                }
+            }
+        }
+
         bool connect_vertex(
             SamplingContext&        sampling_context,
             const float             time,
@@ -31,17 +31,26 @@
 #include "entity.h"
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #include "renderer/modeling/entity/onframebeginrecorder.h"
 #include "renderer/modeling/entity/onrenderbeginrecorder.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/system.h"
 #include "foundation/utility/api/apistring.h"
+#include "foundation/utility/job.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
 
 // OpenImageIO headers.
 #include "foundation/platform/_beginoiioheaders.h"
 #include "OpenImageIO/ustring.h"
 #include "foundation/platform/_endoiioheaders.h"
 
+// Standard headers.
+#include <algorithm>
+
 using namespace foundation;
 
 namespace renderer
@@ -166,4 +175,102 @@ void Entity::on_frame_end(
 {
 }
 
+bool Entity::is_on_frame_begin_thread_safe() const
+{
+    return false;
+}
+
+namespace
+{
+    class OnFrameBeginJob
+      : public IJob
+    {
+      public:
+        OnFrameBeginJob(
+            Entity*                 entity,
+            const Project&          project,
+            const BaseGroup*        parent,
+            OnFrameBeginRecorder&   recorder,
+            IAbortSwitch*           abort_switch,
+            boost::atomic<bool>&    success)
+          : m_entity(entity)
+          , m_project(project)
+          , m_parent(parent)
+          , m_recorder(recorder)
+          , m_abort_switch(abort_switch)
+          , m_success(success)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            // Don't bother preparing this entity if another one has already failed.
+            if (!m_success || is_aborted(m_abort_switch))
+            {
+                m_success = false;
+                return;
+            }
+
+            if (!m_entity->on_frame_begin(m_project, m_parent, m_recorder, m_abort_switch))
+                m_success = false;
+        }
+
+      private:
+        Entity*                     m_entity;
+        const Project&              m_project;
+        const BaseGroup*            m_parent;
+        OnFrameBeginRecorder&       m_recorder;
+        IAbortSwitch*               m_abort_switch;
+        boost::atomic<bool>&        m_success;
+    };
+}
+
+bool invoke_on_frame_begin_concurrently(
+    const std::vector<Entity*>& entities,
+    const Project&              project,
+    const BaseGroup*            parent,
+    OnFrameBeginRecorder&       recorder,
+    IAbortSwitch*               abort_switch)
+{
+    const size_t thread_count =
+        std::min(entities.size(), System::get_logical_cpu_core_count());
+
+    // Spinning up worker threads is not worth it for a single entity.
+    if (thread_count < 2)
+    {
+        for (Entity* entity : entities)
+        {
+            if (is_aborted(abort_switch))
+                return false;
+
+            if (!entity->on_frame_begin(project, parent, recorder, abort_switch))
+                return false;
+        }
+
+        return true;
+    }
+
+    boost::atomic<bool> success(true);
+
+    JobQueue job_queue;
+    JobManager job_manager(global_logger(), job_queue, thread_count);
+
+    for (Entity* entity : entities)
+    {
+        job_queue.schedule(
+            new OnFrameBeginJob(
+                entity,
+                project,
+                parent,
+                recorder,
+                abort_switch,
+                success));
+    }
+
+    job_manager.start();
+    job_queue.wait_until_completion();
+
+    return success && !is_aborted(abort_switch);
+}
+
 }   // namespace renderer
@@ -46,6 +46,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class APIString; }
@@ -167,6 +168,12 @@ class APPLESEED_DLLSYMBOL Entity
         const Project&                  project,
         const BaseGroup*                parent);
 
+    // Return true if `on_frame_begin()` only depends on and modifies data owned by this entity
+    // (besides thread-safe services such as logging), in which case it may be called concurrently
+    // with `on_frame_begin()` of other entities of the same collection. Entities whose preparation
+    // is expensive should override this method. The default implementation returns false.
+    virtual bool is_on_frame_begin_thread_safe() const;
+
   protected:
     struct Impl;
     Impl* impl;
@@ -201,7 +208,8 @@ bool invoke_on_render_begin(
     OnRenderBeginRecorder&              recorder,
     foundation::IAbortSwitch*           abort_switch);
 
-// Utility function to invoke on_frame_begin() on a collection of entities.
+// Utility function to invoke on_frame_begin() on a collection of entities. Entities whose
+// on_frame_begin() is thread-safe are prepared concurrently, after the other ones.
 // Returns true on success, or false if an error occurred or if the abort switch was triggered.
 template <typename EntityCollection>
 bool invoke_on_frame_begin(
@@ -211,6 +219,15 @@ bool invoke_on_frame_begin(
     OnFrameBeginRecorder&               recorder,
     foundation::IAbortSwitch*           abort_switch);
 
+// Invoke on_frame_begin() concurrently on independent entities whose on_frame_begin() is thread-safe.
+// Returns true on success, or false if an error occurred or if the abort switch was triggered.
+APPLESEED_DLLSYMBOL bool invoke_on_frame_begin_concurrently(
+    const std::vector<Entity*>&         entities,
+    const Project&                      project,
+    const BaseGroup*                    parent,
+    OnFrameBeginRecorder&               recorder,
+    foundation::IAbortSwitch*           abort_switch);
+
 
 //
 // Entity class implementation.
@@ -299,16 +316,26 @@ bool invoke_on_frame_begin(
     OnFrameBeginRecorder&               recorder,
     foundation::IAbortSwitch*           abort_switch)
 {
+    std::vector<Entity*> thread_safe_entities;
+
     for (auto& entity : entities)
     {
         if (foundation::is_aborted(abort_switch))
             return false;
 
-        if (!entity.on_frame_begin(project, parent, recorder, abort_switch))
+        if (entity.is_on_frame_begin_thread_safe())
+            thread_safe_entities.push_back(&entity);
+        else if (!entity.on_frame_begin(project, parent, recorder, abort_switch))
             return false;
     }
 
-    return true;
+    return
+        invoke_on_frame_begin_concurrently(
+            thread_safe_entities,
+            project,
+            parent,
+            recorder,
+            abort_switch);
 }
 
 }   // namespace renderer
@@ -31,11 +31,13 @@
 #include "entitymap.h"
 
 // appleseed.foundation headers.
+#include "foundation/hash/hash.h"
 #include "foundation/utility/foreach.h"
 
 // Standard headers.
 #include <cassert>
 #include <map>
+#include <unordered_map>
 
 using namespace foundation;
 
@@ -45,7 +47,11 @@ namespace renderer
 struct EntityMap::Impl
 {
     typedef std::map<UniqueID, Entity*> Storage;
-    typedef std::map<std::string, Entity*> Index;
+
+    // Keys point to the names owned by the entities themselves: entities are
+    // never renamed while they belong to a container, and lookups by name don't
+    // need to allocate a temporary string.
+    typedef std::unordered_map<const char*, Entity*, CStringHash, CStringEqual> Index;
 
     Storage m_storage;
     Index   m_index;
@@ -247,6 +253,36 @@ void EntityMap::swap(EntityMap& rhs)
         i->second->set_parent(rhs.m_parent);
 }
 
+void EntityMap::merge(EntityMap& source)
+{
+    assert(&source != this);
+
+    if (impl->m_storage.empty())
+    {
+        swap(source);
+        return;
+    }
+
+    for (const_each<Impl::Storage> i = source.impl->m_storage; i; ++i)
+    {
+        Entity* entity_ptr = i->second;
+
+        // The entity shouldn't already be in the container.
+        assert(impl->m_storage.find(entity_ptr->get_uid()) == impl->m_storage.end());
+        assert(impl->m_index.find(entity_ptr->get_name()) == impl->m_index.end());
+
+        // Insert the entity into the container.
+        impl->m_storage[entity_ptr->get_uid()] = entity_ptr;
+        impl->m_index[entity_ptr->get_name()] = entity_ptr;
+
+        // Link the entity to its new parent.
+        entity_ptr->set_parent(m_parent);
+    }
+
+    source.impl->m_storage.clear();
+    source.impl->m_index.clear();
+}
+
 void EntityMap::clear()
 {
     for (const_each<Impl::Storage> i = impl->m_storage; i; ++i)
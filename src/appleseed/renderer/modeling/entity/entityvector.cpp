@@ -31,11 +31,12 @@
 #include "entityvector.h"
 
 // appleseed.foundation headers.
+#include "foundation/hash/hash.h"
 #include "foundation/utility/foreach.h"
 
 // Standard headers.
 #include <cassert>
-#include <map>
+#include <unordered_map>
 #include <vector>
 
 using namespace foundation;
@@ -46,8 +47,10 @@ namespace renderer
 struct EntityVector::Impl
 {
     typedef std::vector<Entity*> Storage;
-    typedef std::map<UniqueID, size_t> IDIndex;
-    typedef std::map<std::string, size_t> NameIndex;
+    typedef std::unordered_map<UniqueID, size_t> IDIndex;
+
+    // Keys point to the names owned by the entities themselves (see EntityMap).
+    typedef std::unordered_map<const char*, size_t, CStringHash, CStringEqual> NameIndex;
 
     Storage     m_storage;
     IDIndex     m_id_index;
@@ -251,6 +254,41 @@ void EntityVector::swap(EntityVector& rhs)
         (*i)->set_parent(rhs.m_parent);
 }
 
+void EntityVector::merge(EntityVector& source)
+{
+    assert(&source != this);
+
+    if (impl->m_storage.empty())
+    {
+        swap(source);
+        return;
+    }
+
+    impl->m_storage.reserve(impl->m_storage.size() + source.impl->m_storage.size());
+
+    for (const_each<Impl::Storage> i = source.impl->m_storage; i; ++i)
+    {
+        Entity* entity_ptr = *i;
+
+        // The entity shouldn't already be in the container.
+        assert(impl->m_id_index.find(entity_ptr->get_uid()) == impl->m_id_index.end());
+        assert(impl->m_name_index.find(entity_ptr->get_name()) == impl->m_name_index.end());
+
+        // Insert the entity into the container.
+        const size_t entity_index = impl->m_storage.size();
+        impl->m_storage.push_back(entity_ptr);
+        impl->m_id_index[entity_ptr->get_uid()] = entity_index;
+        impl->m_name_index[entity_ptr->get_name()] = entity_index;
+
+        // Link the entity to its new parent.
+        entity_ptr->set_parent(m_parent);
+    }
+
+    source.impl->m_storage.clear();
+    source.impl->m_id_index.clear();
+    source.impl->m_name_index.clear();
+}
+
 void EntityVector::clear()
 {
     for (const_each<Impl::Storage> i = impl->m_storage; i; ++i)
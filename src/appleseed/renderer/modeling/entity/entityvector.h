@@ -155,6 +155,10 @@ class APPLESEED_DLLSYMBOL EntityVector
     // Swap the content of this container with another container.
     void swap(EntityVector& rhs);
 
+    // Move all entities of another container to this container, leaving the other
+    // container empty. Entities of both containers must have distinct names.
+    void merge(EntityVector& source);
+
     // Remove all entities from the container.
     void clear();
 
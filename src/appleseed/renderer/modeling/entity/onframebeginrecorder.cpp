@@ -32,6 +32,10 @@
 // appleseed.renderer headers.
 #include "renderer/modeling/entity/entity.h"
 
+// Boost headers.
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
+
 // Standard headers.
 #include <cassert>
 #include <stack>
@@ -48,7 +52,8 @@ struct OnFrameBeginRecorder::Impl
         const BaseGroup*    m_parent;
     };
 
-    std::stack<Record> m_records;
+    boost::mutex        m_mutex;
+    std::stack<Record>  m_records;
 };
 
 OnFrameBeginRecorder::OnFrameBeginRecorder()
@@ -67,6 +72,8 @@ void OnFrameBeginRecorder::record(Entity* entity, const BaseGroup* parent)
     Impl::Record record;
     record.m_entity = entity;
     record.m_parent = parent;
+
+    boost::mutex::scoped_lock lock(impl->m_mutex);
     impl->m_records.push(record);
 }
 
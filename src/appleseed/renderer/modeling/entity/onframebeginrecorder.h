@@ -43,6 +43,8 @@ namespace renderer
 // Keep tracks of which entities we have called `on_frame_begin()` on,
 // and allows to call `on_frame_end()` on those entities, in reverse order.
 //
+// Entities may be recorded concurrently, see invoke_on_frame_begin_concurrently().
+//
 
 class APPLESEED_DLLSYMBOL OnFrameBeginRecorder
 {
@@ -50,6 +52,7 @@ class APPLESEED_DLLSYMBOL OnFrameBeginRecorder
     OnFrameBeginRecorder();
     ~OnFrameBeginRecorder();
 
+    // Thread-safe.
     void record(Entity* entity, const BaseGroup* parent);
 
     void on_frame_end(const Project& project);
@@ -0,0 +1,208 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "bakedenvironmentmap.h"
+
+// appleseed.renderer headers.
+#include "renderer/modeling/environmentedf/environmentmapcache.h"
+#include "renderer/modeling/environmentedf/sphericalcoordinates.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/colorspace.h"
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    const size_t ChannelCount = RegularSpectrum31f::Samples;
+}
+
+BakedEnvironmentMap::BakedEnvironmentMap(
+    const size_t                    width,
+    const size_t                    height)
+  : m_width(width)
+  , m_height(height)
+  , m_probability_scale((width * height) / (2.0f * PiSquare<float>()))
+  , m_texels(width * height, RegularSpectrum31f(0.0f))
+{
+    assert(width > 0);
+    assert(height > 0);
+}
+
+Vector3f BakedEnvironmentMap::get_texel_direction(
+    const size_t                    x,
+    const size_t                    y) const
+{
+    float theta, phi;
+    unit_square_to_angles(
+        (x + 0.5f) / m_width,
+        (y + 0.5f) / m_height,
+        theta,
+        phi);
+
+    return Vector3f::make_unit_vector(theta, phi);
+}
+
+void BakedEnvironmentMap::prepare()
+{
+    class TexelSampler
+    {
+      public:
+        explicit TexelSampler(const BakedEnvironmentMap& map)
+          : m_map(map)
+        {
+        }
+
+        void sample(const size_t x, const size_t y, Payload& payload, float& importance) const
+        {
+            const RegularSpectrum31f& radiance = m_map.m_texels[y * m_map.m_width + x];
+            importance = std::max(sum_value(radiance * XYZCMFCIE19312Deg[1]), 0.0f);
+        }
+
+      private:
+        const BakedEnvironmentMap& m_map;
+    };
+
+    TexelSampler sampler(*this);
+    m_importance_sampler.reset(new ImportanceSamplerType(m_width, m_height));
+    m_importance_sampler->rebuild(sampler);
+}
+
+bool BakedEnvironmentMap::load(const std::string& filepath)
+{
+    std::vector<float> values(m_width * m_height * ChannelCount);
+
+    if (!load_environment_map(filepath, m_width, m_height, ChannelCount, &values[0]))
+        return false;
+
+    for (size_t i = 0, e = m_texels.size(); i < e; ++i)
+    {
+        for (size_t c = 0; c < ChannelCount; ++c)
+            m_texels[i][c] = values[i * ChannelCount + c];
+    }
+
+    return true;
+}
+
+void BakedEnvironmentMap::save(const std::string& filepath) const
+{
+    std::vector<float> values(m_width * m_height * ChannelCount);
+
+    for (size_t i = 0, e = m_texels.size(); i < e; ++i)
+    {
+        for (size_t c = 0; c < ChannelCount; ++c)
+            values[i * ChannelCount + c] = m_texels[i][c];
+    }
+
+    save_environment_map(filepath, m_width, m_height, ChannelCount, &values[0]);
+}
+
+void BakedEnvironmentMap::sample(
+    const Vector2f&                 s,
+    Vector3f&                       outgoing,
+    RegularSpectrum31f&             radiance,
+    float&                          probability) const
+{
+    assert(m_importance_sampler);
+
+    size_t x, y;
+    Payload payload;
+    float prob_xy;
+    Vector2f jitter;
+    m_importance_sampler->sample(s, x, y, payload, prob_xy, jitter);
+
+    float theta, phi;
+    unit_square_to_angles(
+        (x + jitter[0]) / m_width,
+        (y + jitter[1]) / m_height,
+        theta,
+        phi);
+
+    const float sin_theta = std::sin(theta);
+
+    outgoing = Vector3f::make_unit_vector(theta, phi);
+    radiance = m_texels[y * m_width + x];
+    probability = sin_theta > 0.0f ? prob_xy * m_probability_scale / sin_theta : 0.0f;
+}
+
+void BakedEnvironmentMap::evaluate(
+    const Vector3f&                 outgoing,
+    RegularSpectrum31f&             radiance) const
+{
+    size_t x, y;
+    float sin_theta;
+    direction_to_texel(outgoing, x, y, sin_theta);
+
+    radiance = m_texels[y * m_width + x];
+}
+
+float BakedEnvironmentMap::evaluate_pdf(const Vector3f& outgoing) const
+{
+    assert(m_importance_sampler);
+
+    size_t x, y;
+    float sin_theta;
+    direction_to_texel(outgoing, x, y, sin_theta);
+
+    const float prob_xy = m_importance_sampler->get_pdf(x, y);
+
+    return prob_xy > 0.0f && sin_theta > 0.0f ? prob_xy * m_probability_scale / sin_theta : 0.0f;
+}
+
+size_t BakedEnvironmentMap::get_memory_size() const
+{
+    return m_texels.capacity() * sizeof(RegularSpectrum31f);
+}
+
+void BakedEnvironmentMap::direction_to_texel(
+    const Vector3f&                 outgoing,
+    size_t&                         x,
+    size_t&                         y,
+    float&                          sin_theta) const
+{
+    float theta, phi;
+    unit_vector_to_angles(outgoing, theta, phi);
+
+    float u, v;
+    angles_to_unit_square(theta, phi, u, v);
+
+    x = std::min(truncate<size_t>(u * m_width), m_width - 1);
+    y = std::min(truncate<size_t>(v * m_height), m_height - 1);
+    sin_theta = std::sin(theta);
+}
+
+}   // namespace renderer
@@ -0,0 +1,193 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/regularspectrum.h"
+#include "foundation/math/sampling/imageimportancesampler.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/job/iabortswitch.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A radiance distribution tabulated over a latitude-longitude map and importance
+// sampled proportionally to its luminance.
+//
+// Analytic environments bake themselves into such a map to replace their per-sample
+// model evaluation by a table lookup and to benefit from importance sampling.
+// Directions are expressed in the local space of the environment. Radiance is
+// piecewise constant over texels, and so is the sampling density in texel space.
+//
+
+class BakedEnvironmentMap
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    BakedEnvironmentMap(
+        const size_t                        width,
+        const size_t                        height);
+
+    // Return the dimensions of the map.
+    size_t get_width() const;
+    size_t get_height() const;
+
+    // Return the direction through the center of a given texel.
+    foundation::Vector3f get_texel_direction(
+        const size_t                        x,
+        const size_t                        y) const;
+
+    // Access the radiance of a given texel.
+    foundation::RegularSpectrum31f& texel(
+        const size_t                        x,
+        const size_t                        y);
+
+    // Build the importance map. Must be called once all texels are set and before sampling.
+    void prepare();
+
+    // Load texels from, or save them to, the environment map cache.
+    bool load(const std::string& filepath);
+    void save(const std::string& filepath) const;
+
+    // Sample a direction and return its radiance and probability density.
+    void sample(
+        const foundation::Vector2f&         s,
+        foundation::Vector3f&               outgoing,
+        foundation::RegularSpectrum31f&     radiance,
+        float&                              probability) const;
+
+    // Return the radiance along a given direction.
+    void evaluate(
+        const foundation::Vector3f&         outgoing,
+        foundation::RegularSpectrum31f&     radiance) const;
+
+    // Return the probability density of a given direction.
+    float evaluate_pdf(const foundation::Vector3f& outgoing) const;
+
+    // Return the size in bytes of the texels of this map.
+    size_t get_memory_size() const;
+
+  private:
+    struct Payload {};
+
+    typedef foundation::ImageImportanceSampler<Payload, float> ImportanceSamplerType;
+
+    const size_t                                    m_width;
+    const size_t                                    m_height;
+    const float                                     m_probability_scale;
+    std::vector<foundation::RegularSpectrum31f>     m_texels;
+    std::unique_ptr<ImportanceSamplerType>          m_importance_sampler;
+
+    void direction_to_texel(
+        const foundation::Vector3f&         outgoing,
+        size_t&                             x,
+        size_t&                             y,
+        float&                              sin_theta) const;
+};
+
+// Create a map by calling radiance_func(direction, radiance) for the center of every texel,
+// or load it from the environment map cache if cache_filepath is not empty. Maps computed
+// from scratch are stored in the cache. Return nullptr if the operation was aborted.
+template <typename RadianceFunc>
+std::unique_ptr<BakedEnvironmentMap> bake_environment_map(
+    const size_t                            width,
+    const size_t                            height,
+    const std::string&                      cache_filepath,
+    RadianceFunc                            radiance_func,
+    bool&                                   loaded_from_cache,
+    foundation::IAbortSwitch*               abort_switch = nullptr);
+
+
+//
+// BakedEnvironmentMap class implementation.
+//
+
+inline size_t BakedEnvironmentMap::get_width() const
+{
+    return m_width;
+}
+
+inline size_t BakedEnvironmentMap::get_height() const
+{
+    return m_height;
+}
+
+inline foundation::RegularSpectrum31f& BakedEnvironmentMap::texel(
+    const size_t                            x,
+    const size_t                            y)
+{
+    assert(x < m_width);
+    assert(y < m_height);
+    return m_texels[y * m_width + x];
+}
+
+template <typename RadianceFunc>
+std::unique_ptr<BakedEnvironmentMap> bake_environment_map(
+    const size_t                            width,
+    const size_t                            height,
+    const std::string&                      cache_filepath,
+    RadianceFunc                            radiance_func,
+    bool&                                   loaded_from_cache,
+    foundation::IAbortSwitch*               abort_switch)
+{
+    std::unique_ptr<BakedEnvironmentMap> map(new BakedEnvironmentMap(width, height));
+
+    loaded_from_cache = !cache_filepath.empty() && map->load(cache_filepath);
+
+    if (!loaded_from_cache)
+    {
+        for (size_t y = 0; y < height; ++y)
+        {
+            if (foundation::is_aborted(abort_switch))
+                return std::unique_ptr<BakedEnvironmentMap>();
+
+            for (size_t x = 0; x < width; ++x)
+                radiance_func(map->get_texel_direction(x, y), map->texel(x, y));
+        }
+
+        if (!cache_filepath.empty())
+            map->save(cache_filepath);
+    }
+
+    map->prepare();
+
+    return map;
+}
+
+}   // namespace renderer
@@ -0,0 +1,261 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "environmentmapcache.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/modeling/input/inputarray.h"
+#include "renderer/modeling/input/source.h"
+#include "renderer/modeling/input/texturesource.h"
+#include "renderer/modeling/scene/textureinstance.h"
+#include "renderer/modeling/texture/texture.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/containers/dictionary.h"
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/hash/murmurhash.h"
+#include "foundation/image/color.h"
+#include "foundation/utility/api/apistring.h"
+#include "foundation/utility/bufferedfile.h"
+#include "foundation/utility/foreach.h"
+#include "foundation/utility/searchpaths.h"
+
+// Boost headers.
+#include "boost/filesystem.hpp"
+
+// Standard headers.
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+using namespace foundation;
+namespace bf = boost::filesystem;
+
+namespace renderer
+{
+
+namespace
+{
+    // Version of the environment map cache file format. Bump whenever the layout
+    // of entries, or the way cached maps are computed, changes.
+    const std::uint16_t EnvironmentMapCacheVersion = 1;
+
+    const char EnvironmentMapCacheSignature[12] =
+        { 'E', 'N', 'V', 'I', 'R', 'O', 'N', 'M', 'E', 'N', 'T', 'M' };
+
+    void hash_params(MurmurHash& hash, const ParamArray& params)
+    {
+        for (const_each<StringDictionary> i = params.strings(); i; ++i)
+        {
+            hash.append(i->key());
+            hash.append(i->value());
+        }
+    }
+
+    bool hash_file(MurmurHash& hash, const std::string& filepath)
+    {
+        BufferedFile file(
+            filepath.c_str(),
+            BufferedFile::BinaryType,
+            BufferedFile::ReadMode);
+
+        if (!file.is_open())
+            return false;
+
+        std::vector<std::uint8_t> buffer(1024 * 1024);
+
+        while (true)
+        {
+            const size_t size = file.read(&buffer[0], buffer.size());
+
+            if (size == 0)
+                break;
+
+            hash.append(&buffer[0], size);
+        }
+
+        return true;
+    }
+}
+
+std::string get_environment_map_cache_filepath(
+    const std::string&              cache_directory,
+    const MurmurHash&               key)
+{
+    return (bf::path(cache_directory) / (key.to_string() + ".envmap")).string();
+}
+
+bool hash_source(
+    MurmurHash&                     hash,
+    const Source&                   source,
+    const SearchPaths&              search_paths)
+{
+    if (source.is_uniform())
+    {
+        float scalar;
+        source.evaluate_uniform(scalar);
+        hash.append(scalar);
+
+        Color3f linear_rgb;
+        source.evaluate_uniform(linear_rgb);
+        hash.append(linear_rgb);
+
+        return true;
+    }
+
+    const TextureSource* texture_source = dynamic_cast<const TextureSource*>(&source);
+    if (texture_source == nullptr)
+        return false;
+
+    const TextureInstance& texture_instance = texture_source->get_texture_instance();
+    hash_params(hash, texture_instance.get_parameters());
+    hash.append(texture_instance.get_transform().get_local_to_parent());
+
+    const Texture& texture = texture_instance.get_texture();
+    hash.append(texture.get_model());
+    hash_params(hash, texture.get_parameters());
+
+    // Only textures backed by a file can be identified across renders.
+    if (!texture.get_parameters().strings().exist("filename"))
+        return false;
+
+    const std::string filepath =
+        search_paths.qualify(texture.get_parameters().get("filename")).c_str();
+
+    return hash_file(hash, filepath);
+}
+
+bool hash_inputs(
+    MurmurHash&                     hash,
+    const InputArray&               inputs,
+    const SearchPaths&              search_paths)
+{
+    for (InputArray::const_iterator i = inputs.begin(), e = inputs.end(); i != e; ++i)
+    {
+        hash.append(i.name());
+
+        if (i.source() && !hash_source(hash, *i.source(), search_paths))
+            return false;
+    }
+
+    return true;
+}
+
+bool load_environment_map(
+    const std::string&              filepath,
+    const size_t                    width,
+    const size_t                    height,
+    const size_t                    channel_count,
+    float*                          values)
+{
+    BufferedFile file(
+        filepath.c_str(),
+        BufferedFile::BinaryType,
+        BufferedFile::ReadMode);
+
+    if (!file.is_open())
+        return false;
+
+    try
+    {
+        char signature[sizeof(EnvironmentMapCacheSignature)];
+        checked_read(file, signature, sizeof(signature));
+        if (memcmp(signature, EnvironmentMapCacheSignature, sizeof(signature)) != 0)
+            return false;
+
+        std::uint16_t version;
+        checked_read(file, version);
+        if (version != EnvironmentMapCacheVersion)
+            return false;
+
+        std::uint64_t file_width, file_height, file_channel_count;
+        checked_read(file, file_width);
+        checked_read(file, file_height);
+        checked_read(file, file_channel_count);
+        if (file_width != width || file_height != height || file_channel_count != channel_count)
+            return false;
+
+        checked_read(file, values, width * height * channel_count * sizeof(float));
+    }
+    catch (const std::exception&)
+    {
+        RENDERER_LOG_WARNING("failed to read environment map cache file %s.", filepath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void save_environment_map(
+    const std::string&              filepath,
+    const size_t                    width,
+    const size_t                    height,
+    const size_t                    channel_count,
+    const float*                    values)
+{
+    // Write to a temporary file first so that concurrent renders never see partial files.
+    const bf::path temp_filepath =
+        bf::path(filepath).parent_path() / bf::unique_path("%%%%-%%%%-%%%%-%%%%.tmp");
+
+    try
+    {
+        bf::create_directories(bf::path(filepath).parent_path());
+
+        {
+            BufferedFile file(
+                temp_filepath.string().c_str(),
+                BufferedFile::BinaryType,
+                BufferedFile::WriteMode);
+
+            if (!file.is_open())
+                throw ExceptionIOError();
+
+            checked_write(file, EnvironmentMapCacheSignature, sizeof(EnvironmentMapCacheSignature));
+            checked_write(file, EnvironmentMapCacheVersion);
+            checked_write(file, static_cast<std::uint64_t>(width));
+            checked_write(file, static_cast<std::uint64_t>(height));
+            checked_write(file, static_cast<std::uint64_t>(channel_count));
+            checked_write(file, values, width * height * channel_count * sizeof(float));
+        }
+
+        bf::rename(temp_filepath, filepath);
+    }
+    catch (const std::exception&)
+    {
+        RENDERER_LOG_WARNING("failed to write environment map cache file %s.", filepath.c_str());
+
+        boost::system::error_code ec;
+        bf::remove(temp_filepath, ec);
+    }
+}
+
+}   // namespace renderer
@@ -0,0 +1,90 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+
+// Forward declarations.
+namespace foundation    { class MurmurHash; }
+namespace foundation    { class SearchPaths; }
+namespace renderer      { class InputArray; }
+namespace renderer      { class Source; }
+
+namespace renderer
+{
+
+//
+// Persistent on-disk cache for tabulated environment maps (importance maps of
+// lat-long maps, baked analytic skies).
+//
+// Entries are named after a hash of everything that affects their content. Writes
+// go to a temporary file that is then renamed, so concurrent renders never read
+// partial entries. Missing, stale or unreadable entries are reported as misses.
+//
+
+// Return the path of the cache entry for a given key.
+std::string get_environment_map_cache_filepath(
+    const std::string&              cache_directory,
+    const foundation::MurmurHash&   key);
+
+// Append to `hash` data identifying the values a source evaluates to, in a way that is
+// stable across renders: the value of uniform sources, or the parameters and the file
+// contents of texture sources. Return false if the source cannot be identified this way.
+bool hash_source(
+    foundation::MurmurHash&         hash,
+    const Source&                   source,
+    const foundation::SearchPaths&  search_paths);
+
+// Append to `hash` the names and sources of all inputs of an entity, see hash_source().
+// Return false if one of the sources cannot be identified across renders.
+bool hash_inputs(
+    foundation::MurmurHash&         hash,
+    const InputArray&               inputs,
+    const foundation::SearchPaths&  search_paths);
+
+// Load a cached map of width x height texels made of channel_count floats each.
+// Return false if the entry is missing or does not match the requested layout.
+bool load_environment_map(
+    const std::string&              filepath,
+    const size_t                    width,
+    const size_t                    height,
+    const size_t                    channel_count,
+    float*                          values);
+
+// Store a map of width x height texels made of channel_count floats each.
+void save_environment_map(
+    const std::string&              filepath,
+    const size_t                    width,
+    const size_t                    height,
+    const size_t                    channel_count,
+    const float*                    values);
+
+}   // namespace renderer
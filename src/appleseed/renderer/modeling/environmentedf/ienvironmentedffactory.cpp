@@ -173,6 +173,31 @@ void IEnvironmentEDFFactory::add_common_sky_input_metadata(DictionaryArray& meta
             .insert("use", "optional")
             .insert("default", "0.0")
             .insert("help", "Shift the horizon vertically"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "bake_resolution")
+            .insert("label", "Bake Resolution")
+            .insert("type", "integer")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "2048")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "0")
+            .insert("help", "Vertical resolution of the lat-long map the sky is baked into (0 to evaluate the sky model directly)"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "cache_directory")
+            .insert("label", "Cache Directory")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("help", "Directory where baked skies are cached across renders"));
 }
 
 }   // namespace renderer
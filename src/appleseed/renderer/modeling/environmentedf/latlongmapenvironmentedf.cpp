@@ -38,6 +38,7 @@
 #include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/modeling/color/colorspace.h"
 #include "renderer/modeling/environmentedf/environmentedf.h"
+#include "renderer/modeling/environmentedf/environmentmapcache.h"
 #include "renderer/modeling/environmentedf/sphericalcoordinates.h"
 #include "renderer/modeling/input/inputarray.h"
 #include "renderer/modeling/input/source.h"
@@ -49,6 +50,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
+#include "foundation/hash/murmurhash.h"
 #include "foundation/image/color.h"
 #include "foundation/image/colorspace.h"
 #include "foundation/math/matrix.h"
@@ -57,6 +59,7 @@
 #include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/types.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/api/apistring.h"
@@ -68,7 +71,10 @@
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 // Forward declarations.
 namespace renderer  { class OnFrameBeginRecorder; }
@@ -106,17 +112,39 @@ namespace
             const Source*   multiplier_source,
             const float     exposure_multiplier,
             const size_t    width,
-            const size_t    height)
+            const size_t    height,
+            Color3f*        texels = nullptr)
           : m_texture_cache(texture_cache)
           , m_radiance_source(radiance_source)
           , m_multiplier_source(multiplier_source)
           , m_exposure_multiplier(exposure_multiplier)
+          , m_width(width)
           , m_rcp_width(1.0f / width)
           , m_rcp_height(1.0f / height)
+          , m_texels(texels)
         {
         }
 
         void sample(const size_t x, const size_t y, Color3f& payload, float& importance)
+        {
+            evaluate(x, y, payload, importance);
+
+            // Record the texel so that it can be stored in the cache.
+            if (m_texels)
+                m_texels[y * m_width + x] = payload;
+        }
+
+      private:
+        TextureCache&   m_texture_cache;
+        const Source*   m_radiance_source;
+        const Source*   m_multiplier_source;
+        const float     m_exposure_multiplier;
+        const size_t    m_width;
+        const float     m_rcp_width;
+        const float     m_rcp_height;
+        Color3f*        m_texels;
+
+        void evaluate(const size_t x, const size_t y, Color3f& payload, float& importance)
         {
             if (m_radiance_source == nullptr)
             {
@@ -144,14 +172,29 @@ namespace
                 importance = 0.0f;
             }
         }
+    };
+
+    // Image sampler reading back texels loaded from the environment map cache.
+    class CachedImageSampler
+    {
+      public:
+        CachedImageSampler(
+            const Color3f*  texels,
+            const size_t    width)
+          : m_texels(texels)
+          , m_width(width)
+        {
+        }
+
+        void sample(const size_t x, const size_t y, Color3f& payload, float& importance) const
+        {
+            payload = m_texels[y * m_width + x];
+            importance = luminance(payload);
+        }
 
       private:
-        TextureCache&   m_texture_cache;
-        const Source*   m_radiance_source;
-        const Source*   m_multiplier_source;
-        const float     m_exposure_multiplier;
-        const float     m_rcp_width;
-        const float     m_rcp_height;
+        const Color3f*  m_texels;
+        const size_t    m_width;
     };
 
     const char* Model = "latlong_map_environment_edf";
@@ -203,7 +246,7 @@ namespace
 
             // Build importance map only if this environment EDF is the active one.
             if (project.get_scene()->get_environment()->get_uncached_environment_edf() == this)
-                build_importance_map(*project.get_scene(), abort_switch);
+                build_importance_map(project, abort_switch);
 
             return true;
         }
@@ -229,14 +272,13 @@ namespace
             size_t x, y;
             Color3f payload;
             float prob_xy;
-            m_importance_sampler->sample(s, x, y, payload, prob_xy);
+            Vector2f jitter;
+            m_importance_sampler->sample(s, x, y, payload, prob_xy, jitter);
             assert(prob_xy >= 0.0f);
 
             // Compute the coordinates in [0,1)^2 of the sample.
-            const float jitter_x = frac(s[0] * m_importance_map_width);
-            const float jitter_y = frac(s[1] * m_importance_map_height);
-            const float u = (x + jitter_x) * m_rcp_importance_map_width;
-            const float v = (y + jitter_y) * m_rcp_importance_map_height;
+            const float u = (x + jitter[0]) * m_rcp_importance_map_width;
+            const float v = (y + jitter[1]) * m_rcp_importance_map_height;
             assert(u >= 0.0f && u < 1.0f);
             assert(v >= 0.0f && v < 1.0f);
 
@@ -383,7 +425,7 @@ namespace
 
         std::unique_ptr<ImageImportanceSamplerType> m_importance_sampler;
 
-        void build_importance_map(const Scene& scene, IAbortSwitch* abort_switch)
+        void build_importance_map(const Project& project, IAbortSwitch* abort_switch)
         {
             Stopwatch<DefaultWallclockTimer> stopwatch;
             stopwatch.start();
@@ -401,29 +443,74 @@ namespace
             const size_t texel_count = m_importance_map_width * m_importance_map_height;
             m_probability_scale = texel_count / (2.0f * PiSquare<float>());
 
-            TextureStore texture_store(scene);
-            TextureCache texture_cache(texture_store);
-            ImageSampler sampler(
-                texture_cache,
-                radiance_source,
-                m_inputs.source("radiance_multiplier"),
-                m_exposure_multiplier,
-                m_importance_map_width,
-                m_importance_map_height);
-
             m_importance_sampler.reset(
                 new ImageImportanceSamplerType(
                     m_importance_map_width,
                     m_importance_map_height));
 
-            RENDERER_LOG_INFO(
-                "building " FMT_SIZE_T "x" FMT_SIZE_T " importance map "
-                "for environment edf \"%s\"...",
-                m_importance_map_width,
-                m_importance_map_height,
-                get_path().c_str());
+            // Look for the environment map texels in the persistent cache.
+            const std::string cache_filepath = get_cache_filepath(project);
+            std::vector<Color3f> texels;
+            bool loaded_from_cache = false;
+            if (!cache_filepath.empty())
+            {
+                texels.resize(texel_count);
+                loaded_from_cache =
+                    load_environment_map(
+                        cache_filepath,
+                        m_importance_map_width,
+                        m_importance_map_height,
+                        3,
+                        &texels[0][0]);
+            }
+
+            if (loaded_from_cache)
+            {
+                CachedImageSampler sampler(&texels[0], m_importance_map_width);
+                m_importance_sampler->rebuild(sampler, abort_switch);
+            }
+            else
+            {
+                RENDERER_LOG_INFO(
+                    "building " FMT_SIZE_T "x" FMT_SIZE_T " importance map "
+                    "for environment edf \"%s\"...",
+                    m_importance_map_width,
+                    m_importance_map_height,
+                    get_path().c_str());
 
-            m_importance_sampler->rebuild(sampler, abort_switch);
+                // Texture caches are not thread-safe: give each thread its own sampler.
+                const size_t thread_count = System::get_logical_cpu_core_count();
+                TextureStore texture_store(*project.get_scene());
+                std::vector<std::unique_ptr<TextureCache>> texture_caches;
+                std::vector<std::unique_ptr<ImageSampler>> samplers;
+                std::vector<ImageSampler*> sampler_ptrs;
+                for (size_t i = 0; i < thread_count; ++i)
+                {
+                    texture_caches.emplace_back(new TextureCache(texture_store));
+                    samplers.emplace_back(
+                        new ImageSampler(
+                            *texture_caches.back(),
+                            radiance_source,
+                            m_inputs.source("radiance_multiplier"),
+                            m_exposure_multiplier,
+                            m_importance_map_width,
+                            m_importance_map_height,
+                            texels.empty() ? nullptr : &texels[0]));
+                    sampler_ptrs.push_back(samplers.back().get());
+                }
+
+                m_importance_sampler->parallel_rebuild(sampler_ptrs, abort_switch);
+
+                if (!cache_filepath.empty() && !is_aborted(abort_switch))
+                {
+                    save_environment_map(
+                        cache_filepath,
+                        m_importance_map_width,
+                        m_importance_map_height,
+                        3,
+                        &texels[0][0]);
+                }
+            }
 
             if (is_aborted(abort_switch))
                 m_importance_sampler.reset();
@@ -432,12 +519,41 @@ namespace
                 stopwatch.measure();
 
                 RENDERER_LOG_INFO(
-                    "built importance map for environment edf \"%s\" in %s.",
+                    "%s importance map for environment edf \"%s\" in %s.",
+                    loaded_from_cache ? "loaded" : "built",
                     get_path().c_str(),
                     pretty_time(stopwatch.get_seconds()).c_str());
             }
         }
 
+        // Return the path of the cache entry for this environment map,
+        // or an empty string if caching is disabled or not possible.
+        std::string get_cache_filepath(const Project& project) const
+        {
+            const std::string cache_directory =
+                m_params.get_optional<std::string>("cache_directory", "");
+
+            if (cache_directory.empty())
+                return std::string();
+
+            MurmurHash key;
+            key.append(std::string(Model));
+            key.append(static_cast<std::uint64_t>(m_importance_map_width));
+            key.append(static_cast<std::uint64_t>(m_importance_map_height));
+            key.append(m_exposure_multiplier);
+
+            if (!hash_inputs(key, m_inputs, project.search_paths()))
+            {
+                RENDERER_LOG_WARNING(
+                    "cannot cache the importance map of environment edf \"%s\" "
+                    "because its inputs cannot be identified across renders.",
+                    get_path().c_str());
+                return std::string();
+            }
+
+            return get_environment_map_cache_filepath(cache_directory, key);
+        }
+
         void lookup_environment_map(
             const ShadingContext&   shading_context,
             const float             u,
@@ -584,6 +700,14 @@ DictionaryArray LatLongMapEnvironmentEDFFactory::get_input_metadata() const
             .insert("use", "optional")
             .insert("help", "Environment texture vertical shift in degrees"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "cache_directory")
+            .insert("label", "Cache Directory")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("help", "Directory where importance maps are cached across renders"));
+
     add_common_input_metadata(metadata);
 
     return metadata;
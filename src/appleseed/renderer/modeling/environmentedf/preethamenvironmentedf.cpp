@@ -31,18 +31,28 @@
 #include "preethamenvironmentedf.h"
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/shading/shadingcontext.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/modeling/color/colorspace.h"
+#include "renderer/modeling/environment/environment.h"
+#include "renderer/modeling/environmentedf/bakedenvironmentmap.h"
 #include "renderer/modeling/environmentedf/environmentedf.h"
+#include "renderer/modeling/environmentedf/environmentmapcache.h"
 #include "renderer/modeling/environmentedf/sphericalcoordinates.h"
 #include "renderer/modeling/input/inputarray.h"
 #include "renderer/modeling/input/source.h"
 #include "renderer/modeling/input/sourceinputs.h"
+#include "renderer/modeling/project/project.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
 #include "renderer/utility/transformsequence.h"
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
+#include "foundation/hash/murmurhash.h"
 #include "foundation/image/color.h"
 #include "foundation/image/colorspace.h"
 #include "foundation/image/regularspectrum.h"
@@ -52,15 +62,21 @@
 #include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/defaulttimers.h"
+#include "foundation/string/string.h"
 #include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/stopwatch.h"
 
 // Standard headers.
 #include <cassert>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
 
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
-namespace renderer      { class Project; }
 
 using namespace foundation;
 
@@ -151,6 +167,13 @@ namespace
                 m_uniform_Y_zenith = compute_zenith_Y(m_uniform_values.m_turbidity, m_sun_theta);
             }
 
+            // Bake the sky into a lat-long map only if this environment EDF is the active one.
+            m_baked_map.reset();
+            const size_t bake_resolution = m_params.get_optional<size_t>("bake_resolution", 0);
+            if (bake_resolution > 0 &&
+                project.get_scene()->get_environment()->get_uncached_environment_edf() == this)
+                bake(project, bake_resolution, abort_switch);
+
             return true;
         }
 
@@ -161,6 +184,20 @@ namespace
             Spectrum&               value,
             float&                  probability) const override
         {
+            if (m_baked_map)
+            {
+                Vector3f local_outgoing;
+                RegularSpectrum31f radiance;
+                m_baked_map->sample(s, local_outgoing, radiance, probability);
+
+                Transformd scratch;
+                const Transformd& transform = m_transform_sequence.evaluate(0.0f, scratch);
+                outgoing = transform.vector_to_parent(local_outgoing);
+
+                value.set(radiance, g_std_lighting_conditions, Spectrum::Illuminance);
+                return;
+            }
+
             const Vector3f local_outgoing = sample_hemisphere_cosine(s);
 
             Transformd scratch;
@@ -170,7 +207,7 @@ namespace
 
             RegularSpectrum31f radiance;
             if (shifted_outgoing.y > 0.0f)
-                compute_sky_radiance(shading_context, shifted_outgoing, radiance);
+                compute_sky_radiance(shading_context.get_texture_cache(), shifted_outgoing, radiance);
             else radiance.set(0.0f);
 
             value.set(radiance, g_std_lighting_conditions, Spectrum::Illuminance);
@@ -188,11 +225,20 @@ namespace
             Transformd scratch;
             const Transformd& transform = m_transform_sequence.evaluate(0.0f, scratch);
             const Vector3f local_outgoing = transform.vector_to_local(outgoing);
+
+            if (m_baked_map)
+            {
+                RegularSpectrum31f radiance;
+                m_baked_map->evaluate(local_outgoing, radiance);
+                value.set(radiance, g_std_lighting_conditions, Spectrum::Illuminance);
+                return;
+            }
+
             const Vector3f shifted_outgoing = shift(local_outgoing);
 
             RegularSpectrum31f radiance;
             if (shifted_outgoing.y > 0.0f)
-                compute_sky_radiance(shading_context, shifted_outgoing, radiance);
+                compute_sky_radiance(shading_context.get_texture_cache(), shifted_outgoing, radiance);
             else radiance.set(0.0f);
 
             value.set(radiance, g_std_lighting_conditions, Spectrum::Illuminance);
@@ -209,11 +255,21 @@ namespace
             Transformd scratch;
             const Transformd& transform = m_transform_sequence.evaluate(0.0f, scratch);
             const Vector3f local_outgoing = transform.vector_to_local(outgoing);
+
+            if (m_baked_map)
+            {
+                RegularSpectrum31f radiance;
+                m_baked_map->evaluate(local_outgoing, radiance);
+                value.set(radiance, g_std_lighting_conditions, Spectrum::Illuminance);
+                probability = m_baked_map->evaluate_pdf(local_outgoing);
+                return;
+            }
+
             const Vector3f shifted_outgoing = shift(local_outgoing);
 
             RegularSpectrum31f radiance;
             if (shifted_outgoing.y > 0.0f)
-                compute_sky_radiance(shading_context, shifted_outgoing, radiance);
+                compute_sky_radiance(shading_context.get_texture_cache(), shifted_outgoing, radiance);
             else radiance.set(0.0f);
 
             value.set(radiance, g_std_lighting_conditions, Spectrum::Illuminance);
@@ -229,6 +285,10 @@ namespace
             Transformd scratch;
             const Transformd& transform = m_transform_sequence.evaluate(0.0f, scratch);
             const Vector3f local_outgoing = transform.vector_to_local(outgoing);
+
+            if (m_baked_map)
+                return m_baked_map->evaluate_pdf(local_outgoing);
+
             const Vector3f shifted_outgoing = shift(local_outgoing);
 
             const float probability = shifted_outgoing.y > 0.0f ? shifted_outgoing.y * RcpPi<float>() : 0.0f;
@@ -258,6 +318,9 @@ namespace
         float                       m_cos_sun_theta;
 
         bool                        m_uniform_turbidity;
+
+        std::unique_ptr<BakedEnvironmentMap>
+                                    m_baked_map;
         float                       m_uniform_x_coeffs[5];
         float                       m_uniform_y_coeffs[5];
         float                       m_uniform_Y_coeffs[5];
@@ -365,7 +428,7 @@ namespace
 
         // Compute the sky radiance along a given direction.
         void compute_sky_radiance(
-            const ShadingContext&   shading_context,
+            TextureCache&           texture_cache,
             const Vector3f&         outgoing,
             RegularSpectrum31f&     radiance) const
         {
@@ -396,7 +459,7 @@ namespace
                 unit_vector_to_angles(outgoing, theta, phi);
                 angles_to_unit_square(theta, phi, u, v);
                 InputValues values;
-                m_inputs.evaluate(shading_context.get_texture_cache(), SourceInputs(Vector2f(u, v)), &values);
+                m_inputs.evaluate(texture_cache, SourceInputs(Vector2f(u, v)), &values);
                 float turbidity = values.m_turbidity;
 
                 // Apply turbidity multiplier and bias.
@@ -454,6 +517,62 @@ namespace
                 * RcpPi<float>();                                   // convert irradiance to radiance
         }
 
+        // Tabulate the sky over a lat-long map of 2*resolution x resolution texels.
+        void bake(
+            const Project&          project,
+            const size_t            resolution,
+            IAbortSwitch*           abort_switch)
+        {
+            Stopwatch<DefaultWallclockTimer> stopwatch;
+            stopwatch.start();
+
+            // Identify the sky by the values of its inputs to look it up in the cache.
+            std::string cache_filepath;
+            const std::string cache_directory = m_params.get_optional<std::string>("cache_directory", "");
+            if (!cache_directory.empty())
+            {
+                MurmurHash key;
+                key.append(Model);
+                key.append(static_cast<std::uint64_t>(resolution));
+
+                if (hash_inputs(key, m_inputs, project.search_paths()))
+                    cache_filepath = get_environment_map_cache_filepath(cache_directory, key);
+            }
+
+            TextureStore texture_store(*project.get_scene());
+            TextureCache texture_cache(texture_store);
+
+            bool loaded_from_cache;
+            m_baked_map =
+                bake_environment_map(
+                    2 * resolution,
+                    resolution,
+                    cache_filepath,
+                    [&](const Vector3f& local_outgoing, RegularSpectrum31f& radiance)
+                    {
+                        const Vector3f shifted_outgoing = shift(local_outgoing);
+                        if (shifted_outgoing.y > 0.0f)
+                            compute_sky_radiance(texture_cache, shifted_outgoing, radiance);
+                        else radiance.set(0.0f);
+                    },
+                    loaded_from_cache,
+                    abort_switch);
+
+            if (m_baked_map)
+            {
+                stopwatch.measure();
+
+                RENDERER_LOG_INFO(
+                    "%s " FMT_SIZE_T "x" FMT_SIZE_T " sky map (%s) for environment edf \"%s\" in %s.",
+                    loaded_from_cache ? "loaded" : "baked",
+                    m_baked_map->get_width(),
+                    m_baked_map->get_height(),
+                    pretty_size(m_baked_map->get_memory_size()).c_str(),
+                    get_path().c_str(),
+                    pretty_time(stopwatch.get_seconds()).c_str());
+            }
+        }
+
         Vector3f shift(Vector3f v) const
         {
             v.y -= m_uniform_values.m_horizon_shift;
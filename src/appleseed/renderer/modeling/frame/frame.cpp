@@ -35,7 +35,11 @@
 #include "renderer/kernel/aov/aovsettings.h"
 #include "renderer/kernel/aov/imagestack.h"
 #include "renderer/kernel/denoising/denoiser.h"
+#ifdef APPLESEED_WITH_OIDN
+#include "renderer/kernel/denoising/oidndenoiser.h"
+#endif
 #include "renderer/kernel/rendering/ishadingresultframebufferfactory.h"
+#include "renderer/kernel/rendering/phasetimer.h"
 #include "renderer/kernel/rendering/shadingresultframebuffer.h"
 #include "renderer/modeling/aov/aov.h"
 #include "renderer/modeling/aov/aovfactoryregistrar.h"
@@ -57,16 +61,22 @@
 #include "foundation/image/genericprogressiveimagefilereader.h"
 #include "foundation/image/image.h"
 #include "foundation/image/imageattributes.h"
+#include "foundation/image/outofcoreimage.h"
 #include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
 #include "foundation/math/filtersamplingtable.h"
 #include "foundation/math/scalar.h"
+#include "foundation/memory/memorytracker.h"
 #include "foundation/platform/defaulttimers.h"
 #include "foundation/platform/path.h"
+#include "foundation/platform/system.h"
+#include "foundation/platform/thread.h"
 #include "foundation/platform/types.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/iostreamop.h"
+#include "foundation/utility/job.h"
 #include "foundation/utility/job/iabortswitch.h"
 #include "foundation/utility/stopwatch.h"
 
@@ -79,6 +89,7 @@
 
 // Standard headers.
 #include <algorithm>
+#include <cstring>
 #include <exception>
 #include <memory>
 #include <string>
@@ -99,6 +110,14 @@ namespace renderer
 namespace
 {
     const UniqueID g_class_uid = new_guid();
+
+    // Return true if a denoising mode relies on the sample statistics of the BCD denoiser.
+    bool uses_denoiser_aov(const Frame::DenoisingMode mode)
+    {
+        return
+            mode == Frame::DenoisingMode::Denoise ||
+            mode == Frame::DenoisingMode::WriteOutputs;
+    }
 }
 
 UniqueID Frame::get_class_uid()
@@ -118,12 +137,18 @@ struct Frame::Impl
     AABB2u                               m_crop_window;
     bool                                 m_enable_dithering;
     std::uint32_t                        m_noise_seed;
+    bool                                 m_out_of_core;
+    std::string                          m_scratch_directory;
     DenoisingMode                        m_denoising_mode;
     bool                                 m_checkpoint_create;
     std::string                          m_checkpoint_create_path;
+    bool                                 m_checkpoint_create_async;
     bool                                 m_checkpoint_resume;
     std::string                          m_checkpoint_resume_path;
     std::string                          m_ref_image_path;
+    std::vector<std::string>             m_view_camera_names;
+    size_t                               m_view_column_count;
+    size_t                               m_view_row_count;
 
     // Child entities.
     AOVContainer                         m_aovs;
@@ -140,13 +165,46 @@ struct Frame::Impl
     std::unique_ptr<FilterSamplingTable> m_filter_sampling_table;
     ParamArray                           m_render_info;
     size_t                               m_initial_pass = 0;
+    std::unique_ptr<boost::thread>       m_checkpoint_writer_thread;
+    TrackedMemory                        m_tracked_memory;
+#ifdef APPLESEED_WITH_OIDN
+    std::unique_ptr<OIDNDenoiser>        m_oidn_denoiser;
+#endif
 
     explicit Impl(Frame* parent)
       : m_aovs(parent)
       , m_internal_aovs(parent)
       , m_post_processing_stages(parent)
+      , m_tracked_memory("framebuffers")
+    {
+    }
+
+    ~Impl()
+    {
+        // The checkpoint writer may still be referencing AOVs.
+        wait_for_checkpoint_writer();
+    }
+
+    void wait_for_checkpoint_writer()
+    {
+        if (m_checkpoint_writer_thread)
+        {
+            m_checkpoint_writer_thread->join();
+            m_checkpoint_writer_thread.reset();
+        }
+    }
+
+#ifdef APPLESEED_WITH_OIDN
+    OIDNDenoiser& get_oidn_denoiser(const size_t thread_count)
     {
+        // The denoiser is expensive to create, so it is created once and reused
+        // for all progressive frame updates.
+        if (!m_oidn_denoiser)
+            m_oidn_denoiser.reset(new OIDNDenoiser(thread_count));
+
+        return *m_oidn_denoiser;
     }
+#endif
 };
 
 Frame::Frame(
@@ -162,14 +220,34 @@ Frame::Frame(
     extract_parameters();
 
     // Create the underlying image.
-    impl->m_image.reset(
-        new Image(
-            impl->m_frame_width,
-            impl->m_frame_height,
-            impl->m_tile_width,
-            impl->m_tile_height,
-            4,
-            PixelFormatFloat));
+    if (impl->m_out_of_core)
+    {
+        // Keep one row of tiles in memory so that images can be traversed in scanline order.
+        const size_t max_cached_tiles =
+            (impl->m_frame_width + impl->m_tile_width - 1) / impl->m_tile_width;
+
+        impl->m_image.reset(
+            new OutOfCoreImage(
+                impl->m_frame_width,
+                impl->m_frame_height,
+                impl->m_tile_width,
+                impl->m_tile_height,
+                4,
+                PixelFormatFloat,
+                make_scratch_file_path(impl->m_scratch_directory).c_str(),
+                max_cached_tiles));
+    }
+    else
+    {
+        impl->m_image.reset(
+            new Image(
+                impl->m_frame_width,
+                impl->m_frame_height,
+                impl->m_tile_width,
+                impl->m_tile_height,
+                4,
+                PixelFormatFloat));
+    }
 
     // Retrieve the image properties.
     m_props = impl->m_image->properties();
@@ -208,6 +286,13 @@ Frame::Frame(
             impl->m_tile_width,
             impl->m_tile_height));
 
+    if (impl->m_out_of_core)
+    {
+        impl->m_aov_images->enable_out_of_core_storage(
+            impl->m_scratch_directory.c_str(),
+            m_props.m_tile_count_x);
+    }
+
     if (aovs.size() > MaxAOVCount)
     {
         RENDERER_LOG_WARNING(
@@ -225,6 +310,7 @@ Frame::Frame(
         assert(aov_factory);
 
         auto_release_ptr<AOV> aov = aov_factory->create(original_aov->get_parameters());
+        aov->m_crop_window = impl->m_crop_window;
 
         aov->create_image(
             impl->m_frame_width,
@@ -237,10 +323,11 @@ Frame::Frame(
     }
 
     // Create internal AOVs.
-    if (impl->m_denoising_mode != DenoisingMode::Off)
+    if (uses_denoiser_aov(impl->m_denoising_mode))
     {
         auto_release_ptr<DenoiserAOV> aov = DenoiserAOVFactory::create();
         aov->set_parent(this);
+        aov->m_crop_window = impl->m_crop_window;
 
         aov->create_image(
             impl->m_frame_width,
@@ -253,6 +340,22 @@ Frame::Frame(
         impl->m_internal_aovs.insert(auto_release_ptr<AOV>(aov));
     }
     else impl->m_denoiser_aov = nullptr;
+
+    // Account for the memory used by the main image and the AOV images.
+    // Out-of-core images only keep a few tiles in memory, and only the tiles
+    // covered by the crop window are ever allocated.
+    if (impl->m_out_of_core)
+        return;
+
+    const size_t pixel_count = impl->m_crop_window.volume();
+
+    size_t image_memory_size = pixel_count * m_props.m_pixel_size;
+    for (size_t i = 0, e = impl->m_aov_images->size(); i < e; ++i)
+    {
+        const CanvasProperties& props = impl->m_aov_images->get_image(i).properties();
+        image_memory_size += pixel_count * props.m_pixel_size;
+    }
+    impl->m_tracked_memory.set_size(image_memory_size);
 }
 
 Frame::~Frame()
@@ -279,10 +382,12 @@ void Frame::print_settings()
         "  crop window                   (%s, %s)-(%s, %s)\n"
         "  dithering                     %s\n"
         "  noise seed                    %s\n"
+        "  out-of-core                   %s\n"
         "  denoising mode                %s\n"
         "  create checkpoint             %s\n"
         "  resume checkpoint             %s\n"
-        "  reference image path          %s",
+        "  reference image path          %s\n"
+        "  views                         %s",
         get_path().c_str(),
         get_uid(),
         camera_name != nullptr ? camera_name : "none",
@@ -298,11 +403,18 @@ void Frame::print_settings()
         pretty_uint(impl->m_crop_window.max[1]).c_str(),
         impl->m_enable_dithering ? "on" : "off",
         pretty_uint(impl->m_noise_seed).c_str(),
+        impl->m_out_of_core ? impl->m_scratch_directory.c_str() : "off",
         impl->m_denoising_mode == DenoisingMode::Off ? "off" :
-        impl->m_denoising_mode == DenoisingMode::WriteOutputs ? "write outputs" : "denoise",
+        impl->m_denoising_mode == DenoisingMode::WriteOutputs ? "write outputs" :
+        impl->m_denoising_mode == DenoisingMode::DenoiseOIDN ? "denoise (open image denoise)" : "denoise",
         impl->m_checkpoint_create ? impl->m_checkpoint_create_path.c_str() : "off",
         impl->m_checkpoint_resume ? impl->m_checkpoint_resume_path.c_str() : "off",
-        impl->m_ref_image_path.empty() ? "n/a" : impl->m_ref_image_path.c_str());
+        impl->m_ref_image_path.empty() ? "n/a" : impl->m_ref_image_path.c_str(),
+        impl->m_view_camera_names.empty()
+            ? "n/a"
+            : (m_params.get_optional<std::string>("views", "") + " (" +
+               pretty_uint(impl->m_view_column_count) + " x " +
+               pretty_uint(impl->m_view_row_count) + ")").c_str());
 }
 
 const AOVContainer& Frame::aovs() const
@@ -317,10 +429,58 @@ PostProcessingStageContainer& Frame::post_processing_stages() const
 
 const char* Frame::get_active_camera_name() const
 {
-    return
-        m_params.strings().exist("camera")
-            ? m_params.strings().get("camera")
-            : nullptr;
+    if (m_params.strings().exist("camera"))
+        return m_params.strings().get("camera");
+
+    if (!impl->m_view_camera_names.empty())
+        return impl->m_view_camera_names[0].c_str();
+
+    return nullptr;
+}
+
+size_t Frame::get_view_count() const
+{
+    return impl->m_view_camera_names.size();
+}
+
+const char* Frame::get_view_camera_name(const size_t view_index) const
+{
+    assert(view_index < impl->m_view_camera_names.size());
+    return impl->m_view_camera_names[view_index].c_str();
+}
+
+size_t Frame::get_view_column_count() const
+{
+    return impl->m_view_column_count;
+}
+
+size_t Frame::get_view_row_count() const
+{
+    return impl->m_view_row_count;
+}
+
+size_t Frame::get_view(
+    const Vector2i&         pixel,
+    const Vector2d&         point,
+    Vector2d&               view_point) const
+{
+    assert(!impl->m_view_camera_names.empty());
+
+    // The view is determined by the pixel rather than by the point, since points
+    // distributed by the reconstruction filter may overflow into neighboring views.
+    const size_t column =
+        std::min(
+            static_cast<size_t>(pixel[0]) * impl->m_view_column_count / impl->m_frame_width,
+            impl->m_view_column_count - 1);
+    const size_t row =
+        std::min(
+            static_cast<size_t>(pixel[1]) * impl->m_view_row_count / impl->m_frame_height,
+            impl->m_view_row_count - 1);
+
+    view_point[0] = point[0] * impl->m_view_column_count - column;
+    view_point[1] = point[1] * impl->m_view_row_count - row;
+
+    return row * impl->m_view_column_count + column;
 }
 
 Image& Frame::image() const
@@ -342,7 +502,11 @@ bool Frame::has_valid_ref_image() const
 
 void Frame::clear_main_and_aov_images()
 {
-    impl->m_image->clear(Color4f(0.0));
+    // Blank out-of-core tiles are zero, there is no need to write them to disk.
+    // Tiles outside the crop window are never rendered, leave them unallocated.
+    if (impl->m_out_of_core)
+        static_cast<OutOfCoreImage*>(impl->m_image.get())->discard_tiles();
+    else impl->m_image->clear(Color4f(0.0), impl->m_crop_window);
 
     for (AOV& aov : impl->m_aovs)
         aov.clear_image();
@@ -356,6 +520,33 @@ ImageStack& Frame::aov_images() const
     return *impl->m_aov_images;
 }
 
+bool Frame::is_out_of_core() const
+{
+    return impl->m_out_of_core;
+}
+
+void Frame::pin_tile(const size_t tile_x, const size_t tile_y) const
+{
+    if (!impl->m_out_of_core)
+        return;
+
+    static_cast<OutOfCoreImage*>(impl->m_image.get())->pin_tile(tile_x, tile_y);
+
+    for (size_t i = 0, e = impl->m_aov_images->size(); i < e; ++i)
+        static_cast<OutOfCoreImage&>(impl->m_aov_images->get_image(i)).pin_tile(tile_x, tile_y);
+}
+
+void Frame::unpin_tile(const size_t tile_x, const size_t tile_y) const
+{
+    if (!impl->m_out_of_core)
+        return;
+
+    static_cast<OutOfCoreImage*>(impl->m_image.get())->unpin_tile(tile_x, tile_y);
+
+    for (size_t i = 0, e = impl->m_aov_images->size(); i < e; ++i)
+        static_cast<OutOfCoreImage&>(impl->m_aov_images->get_image(i)).unpin_tile(tile_x, tile_y);
+}
+
 const FilterSamplingTable& Frame::get_filter_sampling_table() const
 {
     return *impl->m_filter_sampling_table;
@@ -374,6 +565,12 @@ void Frame::reset_crop_window()
             Vector2u(impl->m_frame_width - 1, impl->m_frame_height - 1));
 
     m_params.strings().remove("crop_window");
+
+    for (AOV& aov : impl->m_aovs)
+        aov.m_crop_window = impl->m_crop_window;
+
+    for (AOV& aov : impl->m_internal_aovs)
+        aov.m_crop_window = impl->m_crop_window;
 }
 
 bool Frame::has_crop_window() const
@@ -389,6 +586,12 @@ void Frame::set_crop_window(const AABB2u& crop_window)
 {
     impl->m_crop_window = crop_window;
     m_params.insert("crop_window", crop_window);
+
+    for (AOV& aov : impl->m_aovs)
+        aov.m_crop_window = crop_window;
+
+    for (AOV& aov : impl->m_internal_aovs)
+        aov.m_crop_window = crop_window;
 }
 
 const AABB2u& Frame::get_crop_window() const
@@ -396,6 +599,20 @@ const AABB2u& Frame::get_crop_window() const
     return impl->m_crop_window;
 }
 
+bool Frame::overlaps_crop_window(const size_t tile_x, const size_t tile_y) const
+{
+    const size_t x0 = tile_x * m_props.m_tile_width;
+    const size_t y0 = tile_y * m_props.m_tile_height;
+
+    const AABB2u tile_rect(
+        Vector2u(x0, y0),
+        Vector2u(
+            x0 + m_props.get_tile_width(tile_x) - 1,
+            y0 + m_props.get_tile_height(tile_y) - 1));
+
+    return AABB2u::overlap(tile_rect, impl->m_crop_window);
+}
+
 std::uint32_t Frame::get_noise_seed() const
 {
     return impl->m_noise_seed;
@@ -460,6 +677,48 @@ void Frame::denoise(
     const size_t            thread_count,
     IAbortSwitch*           abort_switch) const
 {
+    PhaseTimer phase_timer;
+    do_denoise(thread_count, abort_switch);
+    phase_timer.record(impl->m_render_info, "denoising");
+}
+
+void Frame::do_denoise(
+    const size_t            thread_count,
+    IAbortSwitch*           abort_switch) const
+{
+    if (impl->m_denoising_mode == DenoisingMode::DenoiseOIDN)
+    {
+#ifdef APPLESEED_WITH_OIDN
+        // Use the albedo and normal AOVs as auxiliary features, if present.
+        const Image* albedo_image = nullptr;
+        const Image* normal_image = nullptr;
+        for (const AOV& aov : impl->m_aovs)
+        {
+            if (std::strcmp(aov.get_model(), "albedo_aov") == 0)
+                albedo_image = &aov.get_image();
+            else if (std::strcmp(aov.get_model(), "normal_aov") == 0)
+                normal_image = &aov.get_image();
+        }
+
+        OIDNDenoiser& denoiser = impl->get_oidn_denoiser(thread_count);
+
+        RENDERER_LOG_INFO("denoising frame \"%s\" using open image denoise...", get_path().c_str());
+        if (!denoiser.denoise(image(), albedo_image, normal_image, abort_switch))
+            return;
+
+        for (const AOV& aov : impl->m_aovs)
+        {
+            if (aov.has_color_data() && &aov.get_image() != albedo_image)
+            {
+                RENDERER_LOG_INFO("denoising aov \"%s\"...", aov.get_path().c_str());
+                if (!denoiser.denoise(aov.get_image(), albedo_image, normal_image, abort_switch))
+                    return;
+            }
+        }
+#endif
+        return;
+    }
+
     DenoiserOptions options;
 
     const bool skip_denoised = m_params.get_optional<bool>("skip_denoised", true);
@@ -494,21 +753,50 @@ void Frame::denoise(
     options.m_mark_invalid_pixels =
         m_params.get_optional<bool>("mark_invalid_pixels", false);
 
+    options.m_tile_size =
+        m_params.get_optional<size_t>(
+            "denoise_tile_size",
+            options.m_tile_size);
+
     assert(impl->m_denoiser_aov);
 
     impl->m_denoiser_aov->fill_empty_samples();
 
+    if (options.m_tile_size > 0)
+    {
+        std::vector<Image*> aov_images;
+
+        for (const AOV& aov : impl->m_aovs)
+        {
+            if (aov.has_color_data())
+                aov_images.push_back(&aov.get_image());
+        }
+
+        RENDERER_LOG_INFO("denoising frame \"%s\" in tiles...", get_path().c_str());
+        denoise_images_tiled(
+            image(),
+            aov_images,
+            *impl->m_denoiser_aov,
+            options,
+            abort_switch);
+
+        return;
+    }
+
     Deepimf num_samples_image;
     impl->m_denoiser_aov->extract_num_samples_image(num_samples_image);
 
     Deepimf covariances_image;
     impl->m_denoiser_aov->compute_covariances_image(covariances_image);
 
+    Deepimf histograms_image;
+    impl->m_denoiser_aov->extract_histograms_image(histograms_image);
+
     RENDERER_LOG_INFO("denoising frame \"%s\"...", get_path().c_str());
     denoise_beauty_image(
         image(),
         num_samples_image,
-        impl->m_denoiser_aov->histograms_image(),
+        histograms_image,
         covariances_image,
         options,
         abort_switch);
@@ -521,7 +809,7 @@ void Frame::denoise(
             denoise_aov_image(
                 aov.get_image(),
                 num_samples_image,
-                impl->m_denoiser_aov->histograms_image(),
+                histograms_image,
                 covariances_image,
                 options,
                 abort_switch);
@@ -529,6 +817,16 @@ void Frame::denoise(
     }
 }
 
+void Frame::denoise_main_image(
+    const size_t            thread_count,
+    IAbortSwitch*           abort_switch) const
+{
+#ifdef APPLESEED_WITH_OIDN
+    if (impl->m_denoising_mode == DenoisingMode::DenoiseOIDN)
+        impl->get_oidn_denoiser(thread_count).denoise(image(), nullptr, nullptr, abort_switch);
+#endif
+}
+
 namespace
 {
     size_t get_checkpoint_total_channel_count(const size_t aov_count)
@@ -708,7 +1006,7 @@ namespace
         }
 
         // Check if denoising is enabled and pass exists.
-        if (frame.get_denoising_mode() != Frame::DenoisingMode::Off)
+        if (uses_denoiser_aov(frame.get_denoising_mode()))
         {
             std::string hist_file_path, cov_file_path, sum_file_path;
             get_denoiser_checkpoint_paths(
@@ -734,7 +1032,7 @@ namespace
         DenoiserAOV*                    denoiser_aov)
     {
         // todo: reload denoiser checkpoint from the same file.
-        Deepimf& histograms_image = denoiser_aov->histograms_image();
+        Deepimf histograms_image;
         Deepimf& covariance_image = denoiser_aov->covariance_image();
         Deepimf& sum_image = denoiser_aov->sum_image();
 
@@ -742,7 +1040,9 @@ namespace
         get_denoiser_checkpoint_paths(checkpoint_path, hist_file_path, cov_file_path, sum_file_path);
 
         // Load histograms.
-        bool result = ImageIO::loadMultiChannelsEXR(histograms_image, hist_file_path.c_str());
+        bool result =
+            ImageIO::loadMultiChannelsEXR(histograms_image, hist_file_path.c_str()) &&
+            denoiser_aov->set_histograms_image(histograms_image);
 
         // Load covariance accumulator.
         result = result && ImageIO::loadMultiChannelsEXR(covariance_image, cov_file_path.c_str());
@@ -758,13 +1058,11 @@ namespace
 
     void save_denoiser_checkpoint(
         const std::string&              checkpoint_path,
-        const DenoiserAOV*              denoiser_aov)
+        const Deepimf&                  histograms_image,
+        const Deepimf&                  covariance_image,
+        const Deepimf&                  sum_image)
     {
         // todo: save denoiser checkpoint in the same file.
-        const Deepimf& histograms_image = denoiser_aov->histograms_image();
-        const Deepimf& covariance_image = denoiser_aov->covariance_image();
-        const Deepimf& sum_image = denoiser_aov->sum_image();
-
         std::string hist_file_path, cov_file_path, sum_file_path;
         get_denoiser_checkpoint_paths(checkpoint_path, hist_file_path, cov_file_path, sum_file_path);
 
@@ -780,6 +1078,182 @@ namespace
         if (!result)
             RENDERER_LOG_ERROR("could not save denoiser checkpoint.");
     }
+
+
+    //
+    // The state of the frame at the end of a given pass, as it must be written to a checkpoint.
+    //
+    // When checkpoints are written in the background, the snapshot owns copies of the rendering
+    // buffers so that the next pass can start accumulating samples while the checkpoint is being
+    // encoded and written to disk. Otherwise it directly references the frame's buffers.
+    //
+
+    struct CheckpointSnapshot
+    {
+        std::string                             m_path;
+        size_t                                  m_pass_index;
+
+        const ICanvas*                          m_beauty_image;
+        const ICanvas*                          m_shading_buffer;
+        std::vector<const AOV*>                 m_aovs;
+        std::vector<const ICanvas*>             m_aov_images;
+
+        const Deepimf*                          m_histograms_image;
+        const Deepimf*                          m_covariance_image;
+        const Deepimf*                          m_sum_image;
+
+        // Storage for the copies of the buffers.
+        std::vector<std::unique_ptr<Image>>     m_image_copies;
+        std::vector<std::unique_ptr<Deepimf>>   m_deep_image_copies;
+
+        CheckpointSnapshot(
+            const std::string&                  path,
+            const size_t                        pass_index)
+          : m_path(path)
+          , m_pass_index(pass_index)
+          , m_beauty_image(nullptr)
+          , m_shading_buffer(nullptr)
+          , m_histograms_image(nullptr)
+          , m_covariance_image(nullptr)
+          , m_sum_image(nullptr)
+        {
+        }
+
+        const ICanvas* copy(const Image& image)
+        {
+            m_image_copies.emplace_back(new Image(image));
+            return m_image_copies.back().get();
+        }
+
+        const ICanvas* copy(const ICanvas& canvas)
+        {
+            const CanvasProperties& props = canvas.properties();
+            std::unique_ptr<Image> image(new Image(props));
+
+            for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+            {
+                for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+                    image->set_tile(tx, ty, new Tile(canvas.tile(tx, ty)));
+            }
+
+            m_image_copies.push_back(std::move(image));
+            return m_image_copies.back().get();
+        }
+
+        const Deepimf* copy(const Deepimf& image)
+        {
+            m_deep_image_copies.emplace_back(new Deepimf(image));
+            return m_deep_image_copies.back().get();
+        }
+    };
+
+    void write_checkpoint(const CheckpointSnapshot& snapshot)
+    {
+        Stopwatch<DefaultWallclockTimer> stopwatch;
+        stopwatch.start();
+
+        try
+        {
+            create_parent_directories(snapshot.m_path.c_str());
+
+            GenericImageFileWriter writer(snapshot.m_path.c_str());
+
+            // Add the beauty image.
+            {
+                writer.append_image(snapshot.m_beauty_image);
+                ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
+                image_attributes.insert("appleseed:LastPass", snapshot.m_pass_index);
+                image_attributes.insert("image_name", "beauty");
+                writer.set_image_attributes(image_attributes);
+            }
+
+            const size_t shading_channel_count = snapshot.m_shading_buffer->properties().m_channel_count;
+
+            // Create channel names.
+            std::vector<std::string> shading_channel_names;
+            std::vector<const char *> shading_channel_names_cstr;
+            {
+                static const std::string channel_name_prefix = "channel_";
+                for (size_t i = 0; i < shading_channel_count; ++i)
+                {
+                    shading_channel_names.push_back(channel_name_prefix + pad_left(to_string(i + 1), '0', 4));
+                    shading_channel_names_cstr.push_back(shading_channel_names[i].c_str());
+                }
+
+                assert(shading_channel_names.size() == shading_channel_count);
+            }
+
+            // Add the shading buffer.
+            {
+                writer.append_image(snapshot.m_shading_buffer);
+                writer.set_image_channels(shading_channel_count, shading_channel_names_cstr.data());
+
+                ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
+                image_attributes.insert("image_name", "appleseed:RenderingBuffer");
+                writer.set_image_attributes(image_attributes);
+            }
+
+            // Add AOV images.
+            assert(snapshot.m_aovs.size() == snapshot.m_aov_images.size());
+            for (size_t i = 0, e = snapshot.m_aovs.size(); i < e; ++i)
+            {
+                const AOV& aov = *snapshot.m_aovs[i];
+                writer.append_image(snapshot.m_aov_images[i]);
+                writer.set_image_channels(aov.get_channel_count(), aov.get_channel_names());
+
+                ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
+                image_attributes.insert("image_name", aov.get_name());
+                writer.set_image_attributes(image_attributes);
+            }
+
+            // Write the file.
+            writer.write();
+        }
+        catch (const std::exception& e)
+        {
+            RENDERER_LOG_ERROR(
+                "failed to write checkpoint file %s: %s.",
+                snapshot.m_path.c_str(),
+                e.what());
+            return;
+        }
+
+        // Add internal AOVs layers (in external files).
+        if (snapshot.m_histograms_image != nullptr)
+        {
+            save_denoiser_checkpoint(
+                snapshot.m_path,
+                *snapshot.m_histograms_image,
+                *snapshot.m_covariance_image,
+                *snapshot.m_sum_image);
+        }
+
+        stopwatch.measure();
+
+        RENDERER_LOG_INFO(
+            "wrote pass %s to checkpoint file %s in %s.",
+            pretty_uint(snapshot.m_pass_index + 1).c_str(),
+            snapshot.m_path.c_str(),
+            pretty_time(stopwatch.get_seconds()).c_str());
+    }
+
+    class CheckpointWriterFunc
+    {
+      public:
+        explicit CheckpointWriterFunc(const std::shared_ptr<CheckpointSnapshot>& snapshot)
+          : m_snapshot(snapshot)
+        {
+        }
+
+        void operator()()
+        {
+            set_current_thread_name("checkpoint_writer");
+            write_checkpoint(*m_snapshot);
+        }
+
+      private:
+        std::shared_ptr<CheckpointSnapshot> m_snapshot;
+    };
 }
 
 bool Frame::load_checkpoint(
@@ -789,6 +1263,9 @@ bool Frame::load_checkpoint(
     if  (!impl->m_checkpoint_resume)
         return true;
 
+    // Don't read a checkpoint that is still being written.
+    impl->wait_for_checkpoint_writer();
+
     bf::path bf_path(impl->m_checkpoint_resume_path.c_str());
 
     // Check if the file exists.
@@ -928,76 +1405,59 @@ void Frame::save_checkpoint(
     if (!impl->m_checkpoint_create)
         return;
 
-    create_parent_directories(impl->m_checkpoint_create_path.c_str());
+    // Only one checkpoint is in flight at any given time.
+    impl->wait_for_checkpoint_writer();
 
-    GenericImageFileWriter writer(impl->m_checkpoint_create_path.c_str());
+    const bool async = impl->m_checkpoint_create_async;
 
-    // Add the beauty image.
-    {
-        writer.append_image(&image());
-        ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
-        image_attributes.insert("appleseed:LastPass", pass_index);
-        image_attributes.insert("image_name", "beauty");
-        writer.set_image_attributes(image_attributes);
-    }
+    std::shared_ptr<CheckpointSnapshot> snapshot(
+        new CheckpointSnapshot(impl->m_checkpoint_create_path, pass_index));
 
     // Buffer containing pixels' weight.
-    ShadingBufferCanvas pixels_weight_buffer(*this, buffer_factory);
-    const size_t shading_channel_count = pixels_weight_buffer.properties().m_channel_count;
+    const ShadingBufferCanvas pixels_weight_buffer(*this, buffer_factory);
 
-    // Create channel names.
-    std::vector<std::string> shading_channel_names;
-    std::vector<const char *> shading_channel_names_cstr;
-    {
-        static const std::string channel_name_prefix = "channel_";
-        for (size_t i = 0; i < shading_channel_count; ++i)
-        {
-            shading_channel_names.push_back(channel_name_prefix + pad_left(to_string(i + 1), '0', 4));
-            shading_channel_names_cstr.push_back(shading_channel_names[i].c_str());
-        }
-
-        assert(shading_channel_names.size() == shading_channel_count);
-    }
-
-    // Add the shading buffer.
-    {
-        writer.append_image(&pixels_weight_buffer);
-        writer.set_image_channels(shading_channel_count, shading_channel_names_cstr.data());
+    // Capture the beauty image and the shading buffer.
+    snapshot->m_beauty_image = async ? snapshot->copy(image()) : &image();
+    snapshot->m_shading_buffer =
+        async
+            ? snapshot->copy(static_cast<const ICanvas&>(pixels_weight_buffer))
+            : &pixels_weight_buffer;
 
-        ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
-        image_attributes.insert("image_name", "appleseed:RenderingBuffer");
-        writer.set_image_attributes(image_attributes);
-    }
-
-    // Add AOV images.
+    // Capture AOV images.
     for (const AOV& aov : aovs())
     {
-        const char* aov_name = aov.get_name();
         const Image& aov_image = aov.get_image();
-        writer.append_image(&aov_image);
-        writer.set_image_channels(aov.get_channel_count(), aov.get_channel_names());
-
-        ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
-        image_attributes.insert("image_name", aov_name);
-        writer.set_image_attributes(image_attributes);
+        snapshot->m_aovs.push_back(&aov);
+        snapshot->m_aov_images.push_back(async ? snapshot->copy(aov_image) : &aov_image);
     }
 
-    // Write the file.
-    writer.write();
-
-    // Add internal AOVs layers (in external files).
+    // Capture internal AOVs.
     for (const AOV& aov : internal_aovs())
     {
-        // Save denoiser checkpoint.
         const DenoiserAOV* denoiser_aov = dynamic_cast<const DenoiserAOV*>(&aov);
         if (denoiser_aov != nullptr)
-            save_denoiser_checkpoint(impl->m_checkpoint_create_path, denoiser_aov);
+        {
+            const Deepimf& covariance_image = denoiser_aov->covariance_image();
+            const Deepimf& sum_image = denoiser_aov->sum_image();
+
+            // Histograms are stored in a compact form and always need to be decoded.
+            std::unique_ptr<Deepimf> histograms_image(new Deepimf());
+            denoiser_aov->extract_histograms_image(*histograms_image);
+            snapshot->m_deep_image_copies.push_back(std::move(histograms_image));
+
+            snapshot->m_histograms_image = snapshot->m_deep_image_copies.back().get();
+            snapshot->m_covariance_image = async ? snapshot->copy(covariance_image) : &covariance_image;
+            snapshot->m_sum_image = async ? snapshot->copy(sum_image) : &sum_image;
+        }
     }
 
-    RENDERER_LOG_INFO(
-        "wrote pass %s to checkpoint file %s.",
-        pretty_uint(pass_index + 1).c_str(),
-        impl->m_checkpoint_create_path.c_str());
+    if (async)
+    {
+        // Rendering resumes while the checkpoint is being written.
+        impl->m_checkpoint_writer_thread.reset(
+            new boost::thread(CheckpointWriterFunc(snapshot)));
+    }
+    else write_checkpoint(*snapshot);
 }
 
 namespace
@@ -1011,6 +1471,25 @@ namespace
         image_attributes.insert("blue_xy_chromaticity",  Vector2f(0.15f, 0.06f));
     }
 
+    // Compute the part of a frame covered by its crop window. Return false if the crop
+    // window covers the whole frame, in which case the whole image must be written.
+    bool get_data_window(const Frame& frame, AABB2u& data_window)
+    {
+        if (!frame.has_crop_window())
+            return false;
+
+        const CanvasProperties& props = frame.image().properties();
+
+        data_window =
+            AABB2u::intersect(
+                frame.get_crop_window(),
+                AABB2u(
+                    Vector2u(0, 0),
+                    Vector2u(props.m_canvas_width - 1, props.m_canvas_height - 1)));
+
+        return data_window.is_valid();
+    }
+
     //
     // Default export formats:
     //
@@ -1028,6 +1507,7 @@ namespace
         const Frame&            frame,
         const char*             file_path,
         const Image&            image,
+        const PixelFormat       pixel_format,
         ImageAttributes         image_attributes)
     {
         assert(file_path);
@@ -1049,22 +1529,32 @@ namespace
         try
         {
             const bool is_linear_format = is_linear_image_file_format(bf_file_path);
+            const CanvasProperties& props = image.properties();
+
+            // OpenEXR files only need to store the crop window, placed inside the full frame.
+            AABB2u data_window;
+            const bool use_data_window = extension == ".exr" && get_data_window(frame, data_window);
 
             std::unique_ptr<Image> transformed_image;
-            if (!is_linear_format && image.properties().m_channel_count == 4)
+            if (!is_linear_format && props.m_channel_count == 4)
             {
-                transformed_image.reset(new Image(image));
+                transformed_image.reset(new Image(image, props.m_tile_width, props.m_tile_height, pixel_format));
                 convert_linear_rgb_to_srgb(*transformed_image);
             }
             else if (extension == ".hdr")
             {
                 // HDR files only support 3 channel.
                 const size_t shuffle_table[4] = { 0, 1, 2, Pixel::SkipChannel };
-                transformed_image.reset(new Image(image, image.properties().m_pixel_format, shuffle_table));
+                transformed_image.reset(new Image(image, pixel_format, shuffle_table));
+            }
+            else if (use_data_window)
+            {
+                transformed_image.reset(
+                    new Image(image, data_window, props.m_tile_width, props.m_tile_height, pixel_format));
             }
             else if (is_linear_format)
             {
-                transformed_image.reset(new Image(image));
+                transformed_image.reset(new Image(image, props.m_tile_width, props.m_tile_height, pixel_format));
             }
             else
             {
@@ -1085,6 +1575,15 @@ namespace
             writer.append_image(transformed_image.get());
             writer.set_image_attributes(image_attributes);
 
+            if (use_data_window)
+            {
+                writer.set_image_data_window(
+                    data_window.min.x,
+                    data_window.min.y,
+                    props.m_canvas_width,
+                    props.m_canvas_height);
+            }
+
             if (extension == ".tiff" || extension == ".tif")
                 writer.set_image_output_format(PixelFormat::PixelFormatUInt16);
 
@@ -1111,22 +1610,178 @@ namespace
 
         return true;
     }
+
+    // Write an out-of-core image to an OpenEXR file in half floats. Tiles are converted
+    // and written one by one, so that the image never needs to be entirely in memory.
+    bool write_out_of_core_image(
+        const Frame&            frame,
+        const char*             file_path,
+        const Image&            image,
+        ImageAttributes         image_attributes)
+    {
+        assert(file_path);
+
+        Stopwatch<DefaultWallclockTimer> stopwatch;
+        stopwatch.start();
+
+        bf::path bf_file_path(file_path);
+        const std::string extension = lower_case(bf_file_path.extension().string());
+
+        if (extension != ".exr")
+        {
+            if (has_extension(bf_file_path))
+            {
+                RENDERER_LOG_WARNING(
+                    "out-of-core frames cannot be saved to %s files; saving to exr file instead.",
+                    extension.substr(1).c_str());
+            }
+
+            bf_file_path.replace_extension(".exr");
+        }
+
+        add_chromaticities_attributes(image_attributes);
+        image_attributes.insert("color_space", "linear");
+
+        try
+        {
+            create_parent_directories(bf_file_path);
+
+            const std::string filename = bf_file_path.string();
+            GenericImageFileWriter writer(filename.c_str());
+
+            writer.append_image(&image);
+            writer.set_image_output_format(PixelFormatHalf);
+            writer.set_image_attributes(image_attributes);
+
+            writer.write();
+        }
+        catch (const std::exception& e)
+        {
+            RENDERER_LOG_ERROR(
+                "failed to write image file %s for frame \"%s\": %s.",
+                bf_file_path.string().c_str(),
+                frame.get_path().c_str(),
+                e.what());
+
+            return false;
+        }
+
+        stopwatch.measure();
+
+        RENDERER_LOG_INFO(
+            "wrote image file %s for frame \"%s\" in %s.",
+            bf_file_path.string().c_str(),
+            frame.get_path().c_str(),
+            pretty_time(stopwatch.get_seconds()).c_str());
+
+        return true;
+    }
+
+    //
+    // Image files are independent of each other: the main image and the AOV images
+    // are written concurrently, each file being converted, encoded and compressed
+    // by its own job.
+    //
+
+    struct ImageWriteRequest
+    {
+        const AOV*              m_aov;          // nullptr for the main image
+        std::string             m_file_path;
+        bool                    m_succeeded;
+
+        ImageWriteRequest(const AOV* aov, const std::string& file_path)
+          : m_aov(aov)
+          , m_file_path(file_path)
+          , m_succeeded(false)
+        {
+        }
+    };
+
+    void execute_image_write_request(const Frame& frame, ImageWriteRequest& request)
+    {
+        if (request.m_aov != nullptr)
+        {
+            const ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
+            request.m_succeeded = request.m_aov->write_images(request.m_file_path.c_str(), image_attributes);
+        }
+        else request.m_succeeded = frame.write_main_image(request.m_file_path.c_str());
+    }
+
+    class ImageWriteJob
+      : public IJob
+    {
+      public:
+        ImageWriteJob(
+            const Frame&            frame,
+            ImageWriteRequest&      request)
+          : m_frame(frame)
+          , m_request(request)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            execute_image_write_request(m_frame, m_request);
+        }
+
+      private:
+        const Frame&                m_frame;
+        ImageWriteRequest&          m_request;
+    };
+
+    bool execute_image_write_requests(
+        const Frame&                        frame,
+        std::vector<ImageWriteRequest>&     requests)
+    {
+        const size_t thread_count =
+            std::min(requests.size(), System::get_logical_cpu_core_count());
+
+        if (thread_count <= 1)
+        {
+            for (ImageWriteRequest& request : requests)
+                execute_image_write_request(frame, request);
+        }
+        else
+        {
+            JobQueue job_queue;
+            JobManager job_manager(global_logger(), job_queue, thread_count);
+
+            for (ImageWriteRequest& request : requests)
+                job_queue.schedule(new ImageWriteJob(frame, request));
+
+            job_manager.start();
+            job_queue.wait_until_completion();
+        }
+
+        bool success = true;
+
+        for (const ImageWriteRequest& request : requests)
+        {
+            if (!request.m_succeeded)
+                success = false;
+        }
+
+        return success;
+    }
 }
 
 bool Frame::write_main_image(const char* file_path) const
 {
+    APPLESEED_TRACE_SCOPE("output", "write main image");
+
     assert(file_path);
 
-    // Convert main image to half floats.
-    const Image& image = *impl->m_image;
-    const CanvasProperties& props = image.properties();
-    const Image half_image(image, props.m_tile_width, props.m_tile_height, PixelFormatHalf);
+    if (impl->m_out_of_core)
+    {
+        ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
+        return write_out_of_core_image(*this, file_path, *impl->m_image, image_attributes);
+    }
 
-    // Write main image.
+    // Write main image, converted to half floats.
     ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
     if (impl->m_enable_dithering)
         image_attributes.insert("dither", 42);  // the value of the dither attribute is a hash seed
-    if (!write_image(*this, file_path, half_image, image_attributes))
+    if (!write_image(*this, file_path, *impl->m_image, PixelFormatHalf, image_attributes))
         return false;
 
     // Write BCD histograms and covariance AOVs if enabled.
@@ -1145,6 +1800,8 @@ bool Frame::write_main_image(const char* file_path) const
 
 bool Frame::write_aov_images(const char* file_path) const
 {
+    APPLESEED_TRACE_SCOPE("output", "write aov images");
+
     assert(file_path);
 
     if (impl->m_aovs.empty())
@@ -1168,7 +1825,8 @@ bool Frame::write_aov_images(const char* file_path) const
     const bf::path directory = bf_file_path.parent_path();
     const std::string base_file_name = bf_file_path.stem().string();
 
-    bool success = true;
+    std::vector<ImageWriteRequest> requests;
+    requests.reserve(impl->m_aovs.size());
 
     for (const AOV& aov : impl->m_aovs)
     {
@@ -1178,30 +1836,28 @@ bool Frame::write_aov_images(const char* file_path) const
         const std::string aov_file_name = base_file_name + "." + safe_aov_name + ".exr";
         const std::string aov_file_path = (directory / aov_file_name).string();
 
-        // Write AOV image.
-        ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
-        if (!aov.write_images(aov_file_path.c_str(), image_attributes))
-            success = false;
+        requests.emplace_back(&aov, aov_file_path);
     }
 
-    return success;
+    // Write AOV images.
+    return execute_image_write_requests(*this, requests);
 }
 
 bool Frame::write_main_and_aov_images() const
 {
-    bool success = true;
+    APPLESEED_TRACE_SCOPE("output", "write main and aov images");
+
+    std::vector<ImageWriteRequest> requests;
+    requests.reserve(impl->m_aovs.size() + 1);
 
-    // Write main image.
+    // Main image.
     {
         const std::string file_path = get_parameters().get_optional<std::string>("output_filename");
         if (!file_path.empty())
-        {
-            if (!write_main_image(file_path.c_str()))
-                success = false;
-        }
+            requests.emplace_back(nullptr, file_path);
     }
 
-    // Write AOV images.
+    // AOV images.
     for (const AOV& aov : impl->m_aovs)
     {
         bf::path bf_file_path = aov.get_parameters().get_optional<std::string>("output_filename");
@@ -1221,13 +1877,12 @@ bool Frame::write_main_and_aov_images() const
                 bf_file_path.replace_extension(".exr");
             }
 
-            ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
-            if (!aov.write_images(bf_file_path.string().c_str(), image_attributes))
-                success = false;
+            requests.emplace_back(&aov, bf_file_path.string());
         }
     }
 
-    return success;
+    // Write all images.
+    return execute_image_write_requests(*this, requests);
 }
 
 void Frame::write_main_and_aov_images_to_multipart_exr(const char* file_path) const
@@ -1239,21 +1894,55 @@ void Frame::write_main_and_aov_images_to_multipart_exr(const char* file_path) co
     add_chromaticities_attributes(image_attributes);
     image_attributes.insert("color_space", "linear");
 
+    // The writer keeps pointers to these images, they must not be moved.
     std::vector<Image> images;
+    images.reserve(impl->m_aovs.size() + 1);
 
     create_parent_directories(file_path);
 
     GenericImageFileWriter writer(file_path);
 
+    // Only the crop window is stored, placed inside the full frame.
+    // Out-of-core frames are always written entirely.
+    AABB2u data_window;
+    const bool use_data_window = !impl->m_out_of_core && get_data_window(*this, data_window);
+
+    // Copy an image (or its crop window) and append it to the writer.
+    const auto append_image_copy = [&](const Image& image, const PixelFormat pixel_format)
+    {
+        const CanvasProperties& props = image.properties();
+
+        if (use_data_window)
+        {
+            images.emplace_back(image, data_window, props.m_tile_width, props.m_tile_height, pixel_format);
+            writer.append_image(&(images.back()));
+            writer.set_image_data_window(
+                data_window.min.x,
+                data_window.min.y,
+                props.m_canvas_width,
+                props.m_canvas_height);
+        }
+        else
+        {
+            images.emplace_back(image, props.m_tile_width, props.m_tile_height, pixel_format);
+            writer.append_image(&(images.back()));
+        }
+    };
+
     // Always save the main image as half floats.
+    // Out-of-core images are converted tile by tile while they are written.
     {
         const Image& image = *impl->m_image;
-        const CanvasProperties& props = image.properties();
-        images.emplace_back(image, props.m_tile_width, props.m_tile_height, PixelFormatHalf);
+
+        if (impl->m_out_of_core)
+        {
+            writer.append_image(&image);
+            writer.set_image_output_format(PixelFormatHalf);
+        }
+        else append_image_copy(image, PixelFormatHalf);
 
         image_attributes.insert("image_name", "beauty");
 
-        writer.append_image(&(images.back()));
         writer.set_image_attributes(image_attributes);
     }
 
@@ -1262,13 +1951,18 @@ void Frame::write_main_and_aov_images_to_multipart_exr(const char* file_path) co
         const std::string aov_name = aov.get_name();
         const Image& image = aov.get_image();
 
-        if (aov.has_color_data())
+        if (aov.has_color_data() && impl->m_out_of_core)
+        {
+            writer.append_image(&image);
+            writer.set_image_output_format(PixelFormatHalf);
+        }
+        else if (aov.has_color_data())
         {
             // If the AOV has color data, assume we can save it as half floats.
-            const CanvasProperties& props = image.properties();
-            images.emplace_back(image, props.m_tile_width, props.m_tile_height, PixelFormatHalf);
-            writer.append_image(&(images.back()));
+            append_image_copy(image, PixelFormatHalf);
         }
+        else if (use_data_window)
+            append_image_copy(image, image.properties().m_pixel_format);
         else writer.append_image(&image);
 
         image_attributes.insert("image_name", aov_name.c_str());
@@ -1302,7 +1996,15 @@ bool Frame::archive(
         *output_path = duplicate_string(file_path.c_str());
 
     ImageAttributes image_attributes = ImageAttributes::create_default_attributes();
-    return write_image(*this, file_path.c_str(), *impl->m_image, image_attributes);
+    return
+        impl->m_out_of_core
+            ? write_out_of_core_image(*this, file_path.c_str(), *impl->m_image, image_attributes)
+            : write_image(
+                  *this,
+                  file_path.c_str(),
+                  *impl->m_image,
+                  impl->m_image->properties().m_pixel_format,
+                  image_attributes);
 }
 
 void Frame::extract_parameters()
@@ -1394,9 +2096,43 @@ void Frame::extract_parameters()
     // Retrieve dithering parameter.
     impl->m_enable_dithering = m_params.get_optional<bool>("enable_dithering", true);
 
+    // Retrieve multi-view parameters.
+    {
+        impl->m_view_camera_names.clear();
+        tokenize(m_params.get_optional<std::string>("views", ""), Blanks, impl->m_view_camera_names);
+
+        const size_t view_count = impl->m_view_camera_names.size();
+        impl->m_view_column_count = std::max<size_t>(view_count, 1);
+        impl->m_view_row_count = 1;
+
+        if (view_count > 0)
+        {
+            const size_t column_count = m_params.get_optional<size_t>("view_columns", view_count);
+
+            if (column_count > 0 && view_count % column_count == 0)
+            {
+                impl->m_view_column_count = column_count;
+                impl->m_view_row_count = view_count / column_count;
+            }
+            else
+            {
+                RENDERER_LOG_ERROR(
+                    "invalid value \"%s\" for parameter \"%s\": the %s views don't fill a whole grid; "
+                    "laying out views in a single row.",
+                    pretty_uint(column_count).c_str(),
+                    "view_columns",
+                    pretty_uint(view_count).c_str());
+            }
+        }
+    }
+
     // Retrieve noise seed.
     impl->m_noise_seed = m_params.get_optional<std::uint32_t>("noise_seed", 0);
 
+    // Retrieve out-of-core parameters.
+    impl->m_out_of_core = m_params.get_optional<bool>("out_of_core", false);
+    impl->m_scratch_directory = m_params.get_optional<std::string>("scratch_directory", "");
+
     // Retrieve denoiser parameters.
     {
         const std::string denoise_mode = m_params.get_optional<std::string>("denoiser", "off");
@@ -1407,6 +2143,15 @@ void Frame::extract_parameters()
             impl->m_denoising_mode = DenoisingMode::Denoise;
         else if (denoise_mode == "write_outputs")
             impl->m_denoising_mode = DenoisingMode::WriteOutputs;
+        else if (denoise_mode == "oidn")
+        {
+#ifdef APPLESEED_WITH_OIDN
+            impl->m_denoising_mode = DenoisingMode::DenoiseOIDN;
+#else
+            RENDERER_LOG_ERROR("this build of appleseed does not support open image denoise, disabling denoising.");
+            impl->m_denoising_mode = DenoisingMode::Off;
+#endif
+        }
         else
         {
             RENDERER_LOG_ERROR(
@@ -1423,6 +2168,7 @@ void Frame::extract_parameters()
         // Create option.
         impl->m_checkpoint_create = m_params.get_optional<bool>("checkpoint_create", false);
         impl->m_checkpoint_create_path = "";
+        impl->m_checkpoint_create_async = m_params.get_optional<bool>("checkpoint_create_async", true);
 
         // Check if the checkpoint create path is valid.
         if (impl->m_checkpoint_create)
@@ -1495,6 +2241,29 @@ void Frame::extract_parameters()
 
     // Retrieve reference image path parameters.
     impl->m_ref_image_path = m_params.get_optional<std::string>("reference_image", "");
+
+    // Operations on whole images are not available with out-of-core images.
+    if (impl->m_out_of_core)
+    {
+        if (impl->m_denoising_mode != DenoisingMode::Off)
+        {
+            RENDERER_LOG_WARNING("denoising is not supported with out-of-core frames, disabling denoising.");
+            impl->m_denoising_mode = DenoisingMode::Off;
+        }
+
+        if (impl->m_checkpoint_create || impl->m_checkpoint_resume)
+        {
+            RENDERER_LOG_WARNING("checkpoints are not supported with out-of-core frames, disabling checkpoints.");
+            impl->m_checkpoint_create = false;
+            impl->m_checkpoint_resume = false;
+        }
+
+        if (!impl->m_ref_image_path.empty())
+        {
+            RENDERER_LOG_WARNING("reference images are not supported with out-of-core frames, ignoring reference image.");
+            impl->m_ref_image_path.clear();
+        }
+    }
 }
 
 AOVContainer& Frame::internal_aovs() const
@@ -1520,6 +2289,27 @@ DictionaryArray FrameFactory::get_input_metadata()
                 Dictionary().insert("camera", "Camera"))
             .insert("use", "optional"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "views")
+            .insert("label", "Views")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("default", "")
+            .insert("help", "Names of the cameras rendered side by side in the frame, separated by spaces"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "view_columns")
+            .insert("label", "View Columns")
+            .insert("type", "integer")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "1")
+                    .insert("type", "hard"))
+            .insert("use", "optional")
+            .insert("help", "Number of columns of the grid of views; all views are in one row by default"));
+
     metadata.push_back(
         Dictionary()
             .insert("name", "resolution")
@@ -1587,6 +2377,26 @@ DictionaryArray FrameFactory::get_input_metadata()
             .insert("use", "optional")
             .insert("default", "true"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "out_of_core")
+            .insert("label", "Out-of-Core")
+            .insert("type", "boolean")
+            .insert("use", "optional")
+            .insert("default", "false")
+            .insert("on_change", "rebuild_form"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "scratch_directory")
+            .insert("label", "Scratch Directory")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("default", "")
+            .insert("visible_if",
+                Dictionary()
+                    .insert("out_of_core", "true")));
+
     metadata.push_back(
         Dictionary()
             .insert("name", "denoiser")
@@ -1596,6 +2406,7 @@ DictionaryArray FrameFactory::get_input_metadata()
                 Dictionary()
                     .insert("Off", "off")
                     .insert("On", "on")
+                    .insert("Open Image Denoise", "oidn")
                     .insert("Write Outputs", "write_outputs"))
             .insert("use", "required")
             .insert("default", "off")
@@ -1702,6 +2513,21 @@ DictionaryArray FrameFactory::get_input_metadata()
                 Dictionary()
                     .insert("denoiser", "on")));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "denoise_tile_size")
+            .insert("label", "Denoise Tile Size")
+            .insert("type", "integer")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0")
+                    .insert("type", "hard"))
+            .insert("use", "optional")
+            .insert("default", "0")
+            .insert("visible_if",
+                Dictionary()
+                    .insert("denoiser", "on")));
+
     return metadata;
 }
 
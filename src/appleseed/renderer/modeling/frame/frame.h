@@ -97,9 +97,30 @@ class APPLESEED_DLLSYMBOL Frame
     // Access the post-processing stages.
     PostProcessingStageContainer& post_processing_stages() const;
 
-    // Return the name of the active camera.
+    // Return the name of the active camera. Multi-view frames without a camera
+    // parameter use the camera of their first view as active camera.
     const char* get_active_camera_name() const;
 
+    // Return the number of views of a multi-view frame, or 0 if the frame is only seen
+    // through the active camera. The views are laid out in a grid of equally sized
+    // cells covering the frame, so that the tiles of all views are rendered together.
+    size_t get_view_count() const;
+
+    // Return the name of the camera of a given view.
+    const char* get_view_camera_name(const size_t view_index) const;
+
+    // Return the number of columns and rows of the grid of views.
+    size_t get_view_column_count() const;
+    size_t get_view_row_count() const;
+
+    // Return the index of the view containing a given pixel, and the position of a point
+    // of that pixel in the normalized device coordinates of that view. `point` is in the
+    // normalized device coordinates of the frame.
+    size_t get_view(
+        const foundation::Vector2i&                     pixel,
+        const foundation::Vector2d&                     point,
+        foundation::Vector2d&                           view_point) const;
+
     // Access the main underlying image.
     foundation::Image& image() const;
 
@@ -109,12 +130,23 @@ class APPLESEED_DLLSYMBOL Frame
     // Returns whether the reference image is compatible with the frame.
     bool has_valid_ref_image() const;
 
-    // Clear the main and AOV images to transparent black.
+    // Clear the main and AOV images to transparent black. Only the tiles overlapping
+    // the crop window are cleared; other tiles are left unallocated.
     void clear_main_and_aov_images();
 
     // Access the AOV images.
     ImageStack& aov_images() const;
 
+    // Return true if the main and AOV images are stored on disk, in which case
+    // only the tiles being rendered are kept in memory. Whole-image operations
+    // (denoising, post-processing, checkpoints) are disabled on such frames.
+    bool is_out_of_core() const;
+
+    // Keep a tile of the main and AOV images in memory while it is being rendered.
+    // These methods do nothing if the frame is not out-of-core.
+    void pin_tile(const size_t tile_x, const size_t tile_y) const;
+    void unpin_tile(const size_t tile_x, const size_t tile_y) const;
+
     // Return the sampling table for the reconstruction filter used by the main image and the AOV images.
     const foundation::FilterSamplingTable& get_filter_sampling_table() const;
 
@@ -128,6 +160,9 @@ class APPLESEED_DLLSYMBOL Frame
     void set_crop_window(const foundation::AABB2u& crop_window);
     const foundation::AABB2u& get_crop_window() const;
 
+    // Return true if a given tile overlaps the crop window.
+    bool overlaps_crop_window(const size_t tile_x, const size_t tile_y) const;
+
     // Get the noise seed.
     std::uint32_t get_noise_seed() const;
 
@@ -170,17 +205,25 @@ class APPLESEED_DLLSYMBOL Frame
     {
         Off,
         WriteOutputs,
-        Denoise
+        Denoise,
+        DenoiseOIDN
     };
 
     // Retrieve the selected denoising mode.
     DenoisingMode get_denoising_mode() const;
 
-    // Run the denoiser on the frame.
+    // Run the denoiser on the frame and record the time spent in the frame's render info.
     void denoise(
         const size_t                                thread_count,
         foundation::IAbortSwitch*                   abort_switch) const;
 
+    // Run the Open Image Denoise denoiser on the main image only, without auxiliary
+    // AOVs. Meant for progressive frame updates. Does nothing unless the denoising
+    // mode is DenoisingMode::DenoiseOIDN.
+    void denoise_main_image(
+        const size_t                                thread_count,
+        foundation::IAbortSwitch*                   abort_switch) const;
+
     // Load a checkpoint file from disk if checkpoint resuming is enabled.
     // Returns true if successful, false otherwise.
     bool load_checkpoint(
@@ -237,6 +280,10 @@ class APPLESEED_DLLSYMBOL Frame
 
     void extract_parameters();
 
+    void do_denoise(
+        const size_t                                thread_count,
+        foundation::IAbortSwitch*                   abort_switch) const;
+
     // Access the internal AOVs.
     AOVContainer& internal_aovs() const;
 };
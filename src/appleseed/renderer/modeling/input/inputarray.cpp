@@ -36,6 +36,7 @@
 #include "renderer/modeling/input/sourceinputs.h"
 
 // appleseed.foundation headers.
+#include "foundation/memory/alignedallocator.h"
 #include "foundation/memory/memory.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/otherwise.h"
@@ -328,11 +329,32 @@ namespace
     };
 
     typedef std::vector<Input> InputVector;
+
+    struct VaryingInput
+    {
+        size_t          m_index;            // index of the input
+        size_t          m_offset;           // offset of the input value in the block of values
+    };
+
+    typedef std::vector<VaryingInput> VaryingInputVector;
 }
 
 struct InputArray::Impl
 {
-    InputVector m_inputs;
+    InputVector         m_inputs;
+
+    // Compiled state.
+    bool                m_compiled;
+    size_t              m_values_size;      // size in bytes of the input values, without trailing padding
+    std::vector<std::uint8_t, AlignedAllocator<std::uint8_t>>
+                        m_uniform_values;   // values of all inputs, with varying inputs left zeroed
+    VaryingInputVector  m_varying_inputs;
+
+    Impl()
+      : m_compiled(false)
+      , m_values_size(0)
+    {
+    }
 };
 
 InputArray::InputArray()
@@ -367,6 +389,7 @@ void InputArray::declare(
     input.m_entity = nullptr;
 
     impl->m_inputs.push_back(input);
+    impl->m_compiled = false;
 }
 
 InputArray::iterator InputArray::begin()
@@ -457,6 +480,40 @@ size_t InputArray::compute_data_size() const
     return size;
 }
 
+void InputArray::compile()
+{
+    impl->m_varying_inputs.clear();
+
+    // Compute the offset of each input value and collect varying inputs.
+    size_t offset = 0;
+    for (size_t i = 0, e = impl->m_inputs.size(); i < e; ++i)
+    {
+        const Input& input = impl->m_inputs[i];
+        const size_t end = input.add_size(offset);
+
+        // add_size() aligns the offset before adding the size of the value,
+        // so the value starts at the end of the input minus the size of the value.
+        if (end > offset && input.m_source && !input.m_source->is_uniform())
+        {
+            VaryingInput varying_input;
+            varying_input.m_index = i;
+            varying_input.m_offset = end - input.add_size(0);
+            impl->m_varying_inputs.push_back(varying_input);
+        }
+
+        offset = end;
+    }
+
+    impl->m_values_size = offset;
+
+    // Evaluate uniform inputs once and for all.
+    impl->m_uniform_values.assign(align(offset, 16), 0);
+    if (!impl->m_uniform_values.empty())
+        evaluate_uniforms(impl->m_uniform_values.data());
+
+    impl->m_compiled = true;
+}
+
 void InputArray::evaluate(
     TextureCache&               texture_cache,
     const SourceInputs&         source_inputs,
@@ -470,8 +527,20 @@ void InputArray::evaluate(
     assert(is_aligned(ptr, 16));
 #endif
 
-    for (const_each<InputVector> i = impl->m_inputs; i; ++i)
-        ptr = i->evaluate(texture_cache, source_inputs, ptr);
+    if (impl->m_compiled)
+    {
+        // Copy the precomputed uniform values, then only evaluate varying inputs.
+        if (impl->m_values_size > 0)
+            std::memcpy(ptr, impl->m_uniform_values.data(), impl->m_values_size);
+
+        for (const_each<VaryingInputVector> i = impl->m_varying_inputs; i; ++i)
+            impl->m_inputs[i->m_index].evaluate(texture_cache, source_inputs, ptr + i->m_offset);
+    }
+    else
+    {
+        for (const_each<InputVector> i = impl->m_inputs; i; ++i)
+            ptr = i->evaluate(texture_cache, source_inputs, ptr);
+    }
 }
 
 void InputArray::evaluate_uniforms(
@@ -621,6 +690,7 @@ void InputArray::iterator::bind(Source* source)
     Input& input = m_input_array->impl->m_inputs[m_input_index];
     delete input.m_source;
     input.m_source = source;
+    m_input_array->impl->m_compiled = false;
 }
 
 void InputArray::iterator::bind(Entity* entity)
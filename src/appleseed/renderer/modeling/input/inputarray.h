@@ -214,6 +214,11 @@ class APPLESEED_DLLSYMBOL InputArray
     // Compute the cumulated size in bytes of the input values.
     size_t compute_data_size() const;
 
+    // Precompute the values of all uniform inputs and the list of varying inputs such
+    // that evaluate() only needs to evaluate varying inputs. Binding a source to an
+    // input discards the compiled state until compile() is called again.
+    void compile();
+
     // Evaluate all inputs into a preallocated block of memory.
     // 'values' must be 16-byte aligned.
     void evaluate(
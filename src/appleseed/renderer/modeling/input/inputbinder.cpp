@@ -548,6 +548,9 @@ void InputBinder::bind_entity_inputs(
 
         ++m_error_count;
     }
+
+    // Fold uniform inputs now that all sources are bound.
+    entity.get_inputs().compile();
 }
 
 bool InputBinder::try_bind_scene_entity_to_input(
@@ -35,8 +35,8 @@
 
 // Standard headers.
 #include <cassert>
-#include <map>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 namespace renderer
@@ -94,7 +94,7 @@ class SymbolTable
     SymbolID lookup(const std::string& name) const;
 
   private:
-    typedef std::map<std::string, SymbolID> SymbolContainer;
+    typedef std::unordered_map<std::string, SymbolID> SymbolContainer;
 
     SymbolContainer m_symbols;
 };
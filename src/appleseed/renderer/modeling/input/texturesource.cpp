@@ -32,16 +32,24 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/modeling/entity/entity.h"
 #include "renderer/modeling/texture/texture.h"
 
 // appleseed.foundation headers.
 #include "foundation/hash/hash.h"
+#include "foundation/image/colorspace.h"
 #include "foundation/image/tile.h"
 #include "foundation/math/scalar.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
+#include "foundation/utility/hardwarecounters.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
 using namespace foundation;
 
@@ -116,27 +124,34 @@ namespace
                 static_cast<size_t>(iy));
     }
 
+    // Sample a tile whose texels are 8-bit sRGB values, converting them to linear RGB.
+    inline void sample_srgb8_tile(
+        const Tile&                 tile,
+        const size_t                pixel_x,
+        const size_t                pixel_y,
+        Color4f&                    sample)
+    {
+        assert(tile.get_pixel_format() == PixelFormatUInt8);
+        assert(tile.get_channel_count() == 3 || tile.get_channel_count() == 4);
+
+        const std::uint8_t* texel = tile.pixel(pixel_x, pixel_y);
+        sample[0] = srgb8_to_linear_rgb(texel[0]);
+        sample[1] = srgb8_to_linear_rgb(texel[1]);
+        sample[2] = srgb8_to_linear_rgb(texel[2]);
+        sample[3] = tile.get_channel_count() == 4 ? texel[3] * (1.0f / 255.0f) : 1.0f;
+    }
+
     // Utility function to sample a tile.
     inline void sample_tile(
-        TextureCache&               texture_cache,
-        const UniqueID              assembly_uid,
-        const UniqueID              texture_uid,
-        const size_t                tile_x,
-        const size_t                tile_y,
+        const Tile&                 tile,
         const size_t                pixel_x,
         const size_t                pixel_y,
+        const ColorSpace            color_space,
         Color4f&                    sample)
     {
-        // Retrieve the tile.
-        const Tile& tile =
-            texture_cache.get(
-                assembly_uid,
-                texture_uid,
-                tile_x,
-                tile_y);
-
-        // Sample the tile.
-        if (tile.get_channel_count() == 3)
+        if (TextureStore::is_converted_on_fetch(color_space, tile.get_pixel_format()))
+            sample_srgb8_tile(tile, pixel_x, pixel_y, sample);
+        else if (tile.get_channel_count() == 3)
         {
             Color3f rgb;
             tile.get_pixel(pixel_x, pixel_y, rgb);
@@ -147,8 +162,96 @@ namespace
         }
         else tile.get_pixel(pixel_x, pixel_y, sample);
     }
+
+    // Blend a 2x2 block of texels given the fractional position within the block.
+    inline Color4f blend_bilinear(
+        const Color4f&              t00,
+        const Color4f&              t10,
+        const Color4f&              t01,
+        const Color4f&              t11,
+        const float                 wx1,
+        const float                 wy1)
+    {
+#ifdef APPLESEED_USE_SSE
+
+        // Process all four channels of a texel per instruction.
+        const __m128 wx = _mm_set1_ps(wx1);
+        const __m128 wy = _mm_set1_ps(wy1);
+
+        const __m128 v00 = _mm_loadu_ps(&t00[0]);
+        const __m128 v10 = _mm_loadu_ps(&t10[0]);
+        const __m128 v01 = _mm_loadu_ps(&t01[0]);
+        const __m128 v11 = _mm_loadu_ps(&t11[0]);
+
+        const __m128 top = _mm_add_ps(v00, _mm_mul_ps(_mm_sub_ps(v10, v00), wx));
+        const __m128 bottom = _mm_add_ps(v01, _mm_mul_ps(_mm_sub_ps(v11, v01), wx));
+
+        Color4f result;
+        _mm_storeu_ps(&result[0], _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), wy)));
+
+        return result;
+
+#else
+
+        const float wx0 = 1.0f - wx1;
+        const float wy0 = 1.0f - wy1;
+
+        Color4f result = t00 * (wx0 * wy0);
+        result += t10 * (wx1 * wy0);
+        result += t01 * (wx0 * wy1);
+        result += t11 * (wx1 * wy1);
+
+        return result;
+
+#endif
+    }
 }
 
+//
+// Retrieve tiles from the texture cache, skipping the cache lookup when the
+// same tile is requested several times in a row.
+//
+
+class TextureSource::TileFetcher
+{
+  public:
+    TileFetcher(
+        TextureCache&               texture_cache,
+        const UniqueID              assembly_uid,
+        const UniqueID              texture_uid)
+      : m_texture_cache(texture_cache)
+      , m_assembly_uid(assembly_uid)
+      , m_texture_uid(texture_uid)
+      , m_tile(nullptr)
+    {
+    }
+
+    const Tile& get(const size_t tile_x, const size_t tile_y)
+    {
+        if (m_tile == nullptr || tile_x != m_tile_x || tile_y != m_tile_y)
+        {
+            m_tile =
+                &m_texture_cache.get(
+                    m_assembly_uid,
+                    m_texture_uid,
+                    tile_x,
+                    tile_y);
+            m_tile_x = tile_x;
+            m_tile_y = tile_y;
+        }
+
+        return *m_tile;
+    }
+
+  private:
+    TextureCache&                   m_texture_cache;
+    const UniqueID                  m_assembly_uid;
+    const UniqueID                  m_texture_uid;
+    const Tile*                     m_tile;
+    size_t                          m_tile_x;
+    size_t                          m_tile_y;
+};
+
 TextureSource::TextureSource(
     const UniqueID              assembly_uid,
     const TextureInstance&      texture_instance)
@@ -157,6 +260,7 @@ TextureSource::TextureSource(
   , m_texture_instance(texture_instance)
   , m_texture_uid(texture_instance.get_texture().get_uid())
   , m_texture_props(texture_instance.get_texture().properties())
+  , m_texture_color_space(texture_instance.get_texture().get_color_space())
   , m_texture_transform(texture_instance.get_transform())
   , m_scalar_canvas_width(static_cast<float>(m_texture_props.m_canvas_width))
   , m_scalar_canvas_height(static_cast<float>(m_texture_props.m_canvas_height))
@@ -191,7 +295,7 @@ Vector2f TextureSource::apply_transform(const Vector2f& uv) const
 }
 
 Color4f TextureSource::get_texel(
-    TextureCache&               texture_cache,
+    TileFetcher&                tile_fetcher,
     const size_t                ix,
     const size_t                iy) const
 {
@@ -226,21 +330,13 @@ Color4f TextureSource::get_texel(
 
     // Sample the tile.
     Color4f sample;
-    sample_tile(
-        texture_cache,
-        m_assembly_uid,
-        m_texture_uid,
-        tile_x,
-        tile_y,
-        pixel_x,
-        pixel_y,
-        sample);
+    sample_tile(tile_fetcher.get(tile_x, tile_y), pixel_x, pixel_y, m_texture_color_space, sample);
 
     return sample;
 }
 
 void TextureSource::get_texels_2x2(
-    TextureCache&               texture_cache,
+    TileFetcher&                tile_fetcher,
     const int                   ix,
     const int                   iy,
     Color4f&                    t00,
@@ -288,10 +384,10 @@ void TextureSource::get_texels_2x2(
         const size_t pixel_y_11 = p11.y - tile_y_11 * m_texture_props.m_tile_height;
 
         // Sample the tile.
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_00, pixel_x_00, pixel_y_00, t00);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_00, pixel_x_11, pixel_y_00, t10);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_11, pixel_x_00, pixel_y_11, t01);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_11, pixel_x_11, pixel_y_11, t11);
+        sample_tile(tile_fetcher.get(tile_x_00, tile_y_00), pixel_x_00, pixel_y_00, m_texture_color_space, t00);
+        sample_tile(tile_fetcher.get(tile_x_11, tile_y_00), pixel_x_11, pixel_y_00, m_texture_color_space, t10);
+        sample_tile(tile_fetcher.get(tile_x_00, tile_y_11), pixel_x_00, pixel_y_11, m_texture_color_space, t01);
+        sample_tile(tile_fetcher.get(tile_x_11, tile_y_11), pixel_x_11, pixel_y_11, m_texture_color_space, t11);
     }
     else
     {
@@ -306,15 +402,17 @@ void TextureSource::get_texels_2x2(
         const size_t pixel_y_11 = p11.y - org_y;
 
         // Retrieve the tile.
-        const Tile& tile =
-            texture_cache.get(
-                m_assembly_uid,
-                m_texture_uid,
-                tile_x_00,
-                tile_y_00);
+        const Tile& tile = tile_fetcher.get(tile_x_00, tile_y_00);
 
         // Sample the tile.
-        if (tile.get_channel_count() == 3)
+        if (TextureStore::is_converted_on_fetch(m_texture_color_space, tile.get_pixel_format()))
+        {
+            sample_srgb8_tile(tile, pixel_x_00, pixel_y_00, t00);
+            sample_srgb8_tile(tile, pixel_x_11, pixel_y_00, t10);
+            sample_srgb8_tile(tile, pixel_x_00, pixel_y_11, t01);
+            sample_srgb8_tile(tile, pixel_x_11, pixel_y_11, t11);
+        }
+        else if (tile.get_channel_count() == 3)
         {
             Color3f rgb;
 
@@ -352,8 +450,85 @@ void TextureSource::get_texels_2x2(
     }
 }
 
+namespace
+{
+    // Fraction of a tile, in each dimension, within which adjacent tiles are prefetched.
+    const double PrefetchMargin = 0.125;
+
+    int compute_prefetch_direction(const double t)
+    {
+        const double f = t - std::floor(t);
+        return f < PrefetchMargin ? -1 : f > 1.0 - PrefetchMargin ? +1 : 0;
+    }
+}
+
+void TextureSource::prefetch_adjacent_tiles(
+    TextureCache&               texture_cache,
+    const float                 x,
+    const float                 y) const
+{
+    const double tx = x * m_texture_props.m_rcp_tile_width;
+    const double ty = y * m_texture_props.m_rcp_tile_height;
+
+    const int dx = compute_prefetch_direction(tx);
+    const int dy = compute_prefetch_direction(ty);
+
+    if (dx == 0 && dy == 0)
+        return;
+
+    const int tile_x = truncate<int>(tx);
+    const int tile_y = truncate<int>(ty);
+    const int tile_count_x = static_cast<int>(m_texture_props.m_tile_count_x);
+    const int tile_count_y = static_cast<int>(m_texture_props.m_tile_count_y);
+
+    for (int j = std::min(dy, 0); j <= std::max(dy, 0); ++j)
+    {
+        for (int i = std::min(dx, 0); i <= std::max(dx, 0); ++i)
+        {
+            const int adjacent_x = tile_x + i;
+            const int adjacent_y = tile_y + j;
+
+            if ((i != 0 || j != 0) &&
+                adjacent_x >= 0 && adjacent_x < tile_count_x &&
+                adjacent_y >= 0 && adjacent_y < tile_count_y)
+            {
+                texture_cache.prefetch(
+                    m_assembly_uid,
+                    m_texture_uid,
+                    static_cast<size_t>(adjacent_x),
+                    static_cast<size_t>(adjacent_y));
+            }
+        }
+    }
+}
+
+void TextureSource::sample_texture(
+    TextureCache&               texture_cache,
+    const Vector2f              uv[],
+    const size_t                count,
+    Color4f                     colors[]) const
+{
+    APPLESEED_HARDWARE_COUNTERS_SCOPE("texture filtering");
+
+    TileFetcher tile_fetcher(texture_cache, m_assembly_uid, m_texture_uid);
+
+    for (size_t i = 0; i < count; ++i)
+        colors[i] = sample_texture(texture_cache, tile_fetcher, uv[i]);
+}
+
+Color4f TextureSource::sample_texture(
+    TextureCache&               texture_cache,
+    const Vector2f&             uv) const
+{
+    APPLESEED_HARDWARE_COUNTERS_SCOPE("texture filtering");
+
+    TileFetcher tile_fetcher(texture_cache, m_assembly_uid, m_texture_uid);
+    return sample_texture(texture_cache, tile_fetcher, uv);
+}
+
 Color4f TextureSource::sample_texture(
     TextureCache&               texture_cache,
+    TileFetcher&                tile_fetcher,
     const Vector2f&             uv) const
 {
     // Start with the transformed input texture coordinates.
@@ -373,7 +548,10 @@ Color4f TextureSource::sample_texture(
             const size_t ix = truncate<size_t>(p.x);
             const size_t iy = truncate<size_t>(p.y);
 
-            return get_texel(texture_cache, ix, iy);
+            if (texture_cache.is_prefetching_enabled())
+                prefetch_adjacent_tiles(texture_cache, p.x, p.y);
+
+            return get_texel(tile_fetcher, ix, iy);
         }
 
       case TextureFilteringBilinear:
@@ -384,31 +562,18 @@ Color4f TextureSource::sample_texture(
             const int ix = truncate<int>(p.x);
             const int iy = truncate<int>(p.y);
 
+            if (texture_cache.is_prefetching_enabled())
+                prefetch_adjacent_tiles(texture_cache, p.x, p.y);
+
             // Retrieve the four surrounding texels.
             Color4f t00, t10, t01, t11;
             get_texels_2x2(
-                texture_cache,
+                tile_fetcher,
                 ix, iy,
                 t00, t10, t01, t11);
 
-            // Compute weights.
-            const float wx1 = p.x - ix;
-            const float wy1 = p.y - iy;
-            const float wx0 = 1.0f - wx1;
-            const float wy0 = 1.0f - wy1;
-
-            // Apply weights.
-            t00 *= wx0 * wy0;
-            t10 *= wx1 * wy0;
-            t01 *= wx0 * wy1;
-            t11 *= wx1 * wy1;
-
-            // Accumulate.
-            t00 += t10;
-            t00 += t01;
-            t00 += t11;
-
-            return t00;
+            // Blend the texels.
+            return blend_bilinear(t00, t10, t01, t11, p.x - ix, p.y - iy);
         }
 
       default:
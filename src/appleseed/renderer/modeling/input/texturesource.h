@@ -39,6 +39,7 @@
 // appleseed.foundation headers.
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/color.h"
+#include "foundation/image/colorspace.h"
 #include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
@@ -104,11 +105,23 @@ class TextureSource
         Spectrum&                           spectrum,
         Alpha&                              alpha) const override;
 
+    // Sample the texture at multiple texture coordinates. Consecutive lookups falling
+    // into the same tile share a single texture cache access, so callers should group
+    // lookups by locality. Return colors in the linear RGB color space.
+    void sample_texture(
+        TextureCache&                       texture_cache,
+        const foundation::Vector2f          uv[],
+        const size_t                        count,
+        foundation::Color4f                 colors[]) const;
+
   private:
+    class TileFetcher;
+
     const foundation::UniqueID              m_assembly_uid;
     const TextureInstance&                  m_texture_instance;
     const foundation::UniqueID              m_texture_uid;
     const foundation::CanvasProperties      m_texture_props;
+    const foundation::ColorSpace            m_texture_color_space;
     const foundation::Transformf            m_texture_transform;
     const float                             m_scalar_canvas_width;
     const float                             m_scalar_canvas_height;
@@ -121,13 +134,13 @@ class TextureSource
 
     // Retrieve a given texel. Return a color in the linear RGB color space.
     foundation::Color4f get_texel(
-        TextureCache&                       texture_cache,
+        TileFetcher&                        tile_fetcher,
         const size_t                        ix,
         const size_t                        iy) const;
 
     // Retrieve a 2x2 block of texels. Texels are expressed in the linear RGB color space.
     void get_texels_2x2(
-        TextureCache&                       texture_cache,
+        TileFetcher&                        tile_fetcher,
         const int                           ix,
         const int                           iy,
         foundation::Color4f&                t00,
@@ -135,10 +148,21 @@ class TextureSource
         foundation::Color4f&                t01,
         foundation::Color4f&                t11) const;
 
+    // Hint the texture cache about the tiles adjacent to a given point in texel space
+    // if that point is close to the edge of its tile.
+    void prefetch_adjacent_tiles(
+        TextureCache&                       texture_cache,
+        const float                         x,
+        const float                         y) const;
+
     // Sample the texture. Return a color in the linear RGB color space.
     foundation::Color4f sample_texture(
         TextureCache&                       texture_cache,
         const foundation::Vector2f&         uv) const;
+    foundation::Color4f sample_texture(
+        TextureCache&                       texture_cache,
+        TileFetcher&                        tile_fetcher,
+        const foundation::Vector2f&         uv) const;
 
     // Compute an alpha value given a linear RGBA color and the alpha mode of the texture instance.
     void evaluate_alpha(
@@ -43,11 +43,15 @@
 #include "foundation/math/scalar.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/foreach.h"
+#include "foundation/utility/makevector.h"
 #include "foundation/utility/seexpr.h"
+#include "foundation/utility/statistics.h"
 #include "foundation/utility/tls.h"
 
 // Standard headers.
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <exception>
 #include <map>
 #include <memory>
@@ -65,6 +69,10 @@ namespace
     // The DisneyLayerParam class wraps an SeAppleseedExpr object to add basic optimizations
     // for straightforward expressions such as a single scalar or a simple texture lookup.
     //
+    // Expressions are parsed and classified once per render. Copies made for rendering
+    // threads only parse again the expressions that need the interpreter, since the
+    // variables of an SeExpr expression cannot be shared between threads.
+    //
 
     class DisneyLayerParam
     {
@@ -76,8 +84,12 @@ namespace
           : m_param_name(name)
           , m_expr(params.get<std::string>(name))
           , m_is_vector(is_vector)
+          , m_is_prepared(false)
+          , m_is_interpreted(false)
           , m_is_constant(false)
           , m_texture_is_srgb(true)
+          , m_evaluation_count(0)
+          , m_evaluation_time(0)
         {
         }
 
@@ -85,11 +97,15 @@ namespace
           : m_param_name(other.m_param_name)
           , m_expr(other.m_expr)
           , m_is_vector(other.m_is_vector)
+          , m_is_prepared(other.m_is_prepared)
+          , m_is_interpreted(other.m_is_interpreted)
           , m_is_constant(other.m_is_constant)
           , m_constant_value(other.m_constant_value)
           , m_texture_filename(other.m_texture_filename)
           , m_texture_options(other.m_texture_options)
           , m_texture_is_srgb(other.m_texture_is_srgb)
+          , m_evaluation_count(0)
+          , m_evaluation_time(0)
         {
         }
 
@@ -105,6 +121,10 @@ namespace
 
         bool prepare()
         {
+            // Constants and simple texture lookups were resolved when the original was prepared.
+            if (m_is_prepared && !m_is_interpreted)
+                return true;
+
             m_expression.setWantVec(m_is_vector);
             m_expression.set_expr(m_expr);
 
@@ -115,6 +135,11 @@ namespace
                 return false;
             }
 
+            m_is_prepared = true;
+
+            if (m_is_interpreted)
+                return true;
+
             // Case of a simple constant.
             m_is_constant = m_expression.isConstant();
             if (m_is_constant)
@@ -124,6 +149,10 @@ namespace
                 return true;
             }
 
+            // Any other expression goes through the interpreter unless it turns out
+            // to be a simple texture lookup.
+            m_is_interpreted = true;
+
             // Case of a simple texture lookup of the form texture("path/to/texture", $u, $v).
             {
                 const std::string expression = trim_both(m_expression.getExpr(), " \r\n");
@@ -149,6 +178,8 @@ namespace
                 if (trim_both(tokens[2]) != "$v")
                     return true;
 
+                m_is_interpreted = false;
+
                 m_texture_filename = OIIO::ustring(trim_both(tokens[0], " \""));
                 m_texture_is_srgb = texture_is_srgb(m_texture_filename);
                 m_texture_options.rwrap = OIIO::TextureOpt::WrapPeriodic;
@@ -200,22 +231,68 @@ namespace
                 return color;
             }
 
-            return
+            const std::uint64_t start_time = read_time();
+
+            const Color3f result =
                 m_expression.update_and_evaluate(
                     shading_point,
                     texture_system);
+
+            ++m_evaluation_count;
+            m_evaluation_time += read_time() - start_time;
+
+            return result;
+        }
+
+        // Add the evaluation statistics of another copy of this parameter to this one.
+        void merge_statistics(const DisneyLayerParam& other)
+        {
+            m_evaluation_count += other.m_evaluation_count;
+            m_evaluation_time += other.m_evaluation_time;
+        }
+
+        // Report the evaluation statistics of this parameter if it goes through the interpreter.
+        // Returns true if statistics were added.
+        bool add_statistics(
+            const std::string&      layer_name,
+            Statistics&             statistics) const
+        {
+            if (!m_is_interpreted || m_evaluation_count == 0)
+                return false;
+
+            const double seconds = m_evaluation_time * 1.0e-9;
+
+            statistics.insert(
+                layer_name + "." + m_param_name,
+                pretty_uint(m_evaluation_count) + " evaluations, " +
+                pretty_time(seconds) + ", " +
+                pretty_time(seconds / m_evaluation_count, 3) + " per evaluation");
+
+            return true;
         }
 
       private:
         const char*                 m_param_name;
         std::string                 m_expr;
         bool                        m_is_vector;
+        bool                        m_is_prepared;
+        bool                        m_is_interpreted;
         bool                        m_is_constant;
         Color3d                     m_constant_value;
         OIIO::ustring               m_texture_filename;
         mutable OIIO::TextureOpt    m_texture_options;
         bool                        m_texture_is_srgb;
         mutable SeAppleseedExpr     m_expression;
+        mutable std::uint64_t       m_evaluation_count;
+        mutable std::uint64_t       m_evaluation_time;  // in nanoseconds
+
+        static std::uint64_t read_time()
+        {
+            return
+                static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
     };
 }
 
@@ -265,6 +342,41 @@ struct DisneyMaterialLayer::Impl
     DisneyLayerParam        m_sheen_tint;
     DisneyLayerParam        m_clearcoat;
     DisneyLayerParam        m_clearcoat_gloss;
+
+    void merge_statistics(const Impl& other)
+    {
+        m_mask.merge_statistics(other.m_mask);
+        m_base_color.merge_statistics(other.m_base_color);
+        m_subsurface.merge_statistics(other.m_subsurface);
+        m_metallic.merge_statistics(other.m_metallic);
+        m_specular.merge_statistics(other.m_specular);
+        m_specular_tint.merge_statistics(other.m_specular_tint);
+        m_anisotropic.merge_statistics(other.m_anisotropic);
+        m_roughness.merge_statistics(other.m_roughness);
+        m_sheen.merge_statistics(other.m_sheen);
+        m_sheen_tint.merge_statistics(other.m_sheen_tint);
+        m_clearcoat.merge_statistics(other.m_clearcoat);
+        m_clearcoat_gloss.merge_statistics(other.m_clearcoat_gloss);
+    }
+
+    // Returns the number of parameters for which statistics were added.
+    size_t add_statistics(Statistics& statistics) const
+    {
+        size_t count = 0;
+        count += m_mask.add_statistics(m_name, statistics) ? 1 : 0;
+        count += m_base_color.add_statistics(m_name, statistics) ? 1 : 0;
+        count += m_subsurface.add_statistics(m_name, statistics) ? 1 : 0;
+        count += m_metallic.add_statistics(m_name, statistics) ? 1 : 0;
+        count += m_specular.add_statistics(m_name, statistics) ? 1 : 0;
+        count += m_specular_tint.add_statistics(m_name, statistics) ? 1 : 0;
+        count += m_anisotropic.add_statistics(m_name, statistics) ? 1 : 0;
+        count += m_roughness.add_statistics(m_name, statistics) ? 1 : 0;
+        count += m_sheen.add_statistics(m_name, statistics) ? 1 : 0;
+        count += m_sheen_tint.add_statistics(m_name, statistics) ? 1 : 0;
+        count += m_clearcoat.add_statistics(m_name, statistics) ? 1 : 0;
+        count += m_clearcoat_gloss.add_statistics(m_name, statistics) ? 1 : 0;
+        return count;
+    }
 };
 
 DisneyMaterialLayer::DisneyMaterialLayer(
@@ -325,14 +437,34 @@ bool DisneyMaterialLayer::prepare_expressions() const
         impl->m_clearcoat_gloss.prepare();
 }
 
+float DisneyMaterialLayer::evaluate_mask(
+    const ShadingPoint&     shading_point,
+    OIIOTextureSystem&      texture_system) const
+{
+    return saturate(impl->m_mask.evaluate(shading_point, texture_system)[0]);
+}
+
 void DisneyMaterialLayer::evaluate_expressions(
     const ShadingPoint&     shading_point,
     OIIOTextureSystem&      texture_system,
     Color3f&                base_color,
     DisneyBRDFInputValues&  values) const
 {
-    const float mask = saturate(impl->m_mask.evaluate(shading_point, texture_system)[0]);
+    evaluate_expressions(
+        shading_point,
+        texture_system,
+        evaluate_mask(shading_point, texture_system),
+        base_color,
+        values);
+}
 
+void DisneyMaterialLayer::evaluate_expressions(
+    const ShadingPoint&     shading_point,
+    OIIOTextureSystem&      texture_system,
+    const float             mask,
+    Color3f&                base_color,
+    DisneyBRDFInputValues&  values) const
+{
     if (mask == 0.0f)
         return;
 
@@ -578,9 +710,11 @@ struct DisneyMaterial::Impl
     DisneyMaterialLayerContainer                m_layers;
     std::unique_ptr<DisneyLayeredBRDF>          m_brdf;
     mutable TLS<DisneyMaterialLayerContainer*>  m_per_thread_layers;
+    bool                                        m_stochastic_layer_selection;
 
     explicit Impl(const DisneyMaterial* parent)
       : m_brdf(new DisneyLayeredBRDF(parent))
+      , m_stochastic_layer_selection(false)
       , m_per_thread_layers(MaxThreadCount)
     {
         for (size_t i = 0; i < MaxThreadCount; ++i)
@@ -593,6 +727,35 @@ struct DisneyMaterial::Impl
             assert(m_per_thread_layers[i] == 0);
     }
 
+    // Report how often and how long the expressions of the layers were interpreted.
+    void report_expression_statistics(const char* material_name)
+    {
+        for (size_t i = 0; i < MaxThreadCount; ++i)
+        {
+            const DisneyMaterialLayerContainer* layers = m_per_thread_layers[i];
+
+            if (layers != nullptr)
+            {
+                for (size_t j = 0, e = m_layers.size(); j < e; ++j)
+                    m_layers[j].impl->merge_statistics(*(*layers)[j].impl);
+            }
+        }
+
+        Statistics statistics;
+        size_t count = 0;
+
+        for (const_each<DisneyMaterialLayerContainer> i = m_layers; i; ++i)
+            count += i->impl->add_statistics(statistics);
+
+        if (count > 0)
+        {
+            RENDERER_LOG_DEBUG("%s",
+                StatisticsVector::make(
+                    std::string("disney material \"") + material_name + "\" expression statistics",
+                    statistics).to_string().c_str());
+        }
+    }
+
     void clear_per_thread_layers()
     {
         for (size_t i = 0; i < MaxThreadCount; ++i)
@@ -687,6 +850,13 @@ bool DisneyMaterial::on_frame_begin(
     m_render_data.m_edf = get_uncached_edf();
     m_render_data.m_basis_modifier = create_basis_modifier(context);
 
+    impl->m_stochastic_layer_selection =
+        m_params.get_optional<std::string>(
+            "layer_selection",
+            "deterministic",
+            make_vector("deterministic", "stochastic"),
+            context) == "stochastic";
+
     if (m_render_data.m_edf && m_render_data.m_alpha_map)
     {
         RENDERER_LOG_WARNING(
@@ -702,6 +872,7 @@ void DisneyMaterial::on_frame_end(
     const Project&          project,
     const BaseGroup*        parent)
 {
+    impl->report_expression_statistics(get_path().c_str());
     impl->clear_per_thread_layers();
     impl->m_layers.clear();
 
@@ -736,6 +907,11 @@ void DisneyMaterial::add_new_default_layer()
     add_layer(DisneyMaterialLayer::get_default_values());
 }
 
+bool DisneyMaterial::uses_stochastic_layer_selection() const
+{
+    return impl->m_stochastic_layer_selection;
+}
+
 size_t DisneyMaterial::get_layer_count() const
 {
     return impl->m_layers.size();
@@ -836,6 +1012,18 @@ DictionaryArray DisneyMaterialFactory::get_input_metadata() const
             .insert("entity_types", Dictionary().insert("edf", "EDF"))
             .insert("use", "optional"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "layer_selection")
+            .insert("label", "Layer Selection")
+            .insert("type", "enumeration")
+            .insert("items",
+                Dictionary()
+                    .insert("Deterministic", "deterministic")
+                    .insert("Stochastic", "stochastic"))
+            .insert("use", "optional")
+            .insert("default", "deterministic"));
+
     add_alpha_map_metadata(metadata);
     add_displacement_metadata(metadata);
 
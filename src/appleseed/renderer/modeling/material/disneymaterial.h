@@ -81,12 +81,26 @@ class APPLESEED_DLLSYMBOL DisneyMaterialLayer
 
     bool prepare_expressions() const;
 
+    // Evaluate the mask of this layer, clamped to [0, 1].
+    float evaluate_mask(
+        const ShadingPoint&             shading_point,
+        OIIOTextureSystem&              texture_system) const;
+
+    // Blend the values of this layer over the given values, using the layer's own mask.
     void evaluate_expressions(
         const ShadingPoint&             shading_point,
         OIIOTextureSystem&              texture_system,
         foundation::Color3f&            base_color,
         DisneyBRDFInputValues&          values) const;
 
+    // Blend the values of this layer over the given values, using a given mask.
+    void evaluate_expressions(
+        const ShadingPoint&             shading_point,
+        OIIOTextureSystem&              texture_system,
+        const float                     mask,
+        foundation::Color3f&            base_color,
+        DisneyBRDFInputValues&          values) const;
+
     static foundation::DictionaryArray get_input_metadata();
     static foundation::Dictionary get_default_values();
 
@@ -148,6 +162,9 @@ class APPLESEED_DLLSYMBOL DisneyMaterial
         const size_t                index,
         const size_t                thread_index = ~size_t(0)) const;
 
+    // Return true if a single layer is selected per shading point instead of blending all layers.
+    bool uses_stochastic_layer_selection() const;
+
   private:
     friend class DisneyMaterialFactory;
 
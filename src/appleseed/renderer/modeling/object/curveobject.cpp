@@ -34,6 +34,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
+#include "foundation/math/compressedbeziercurve.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/otherwise.h"
@@ -59,29 +60,53 @@ namespace
 
 struct CurveObject::Impl
 {
-    CurveBasis               m_basis;
-    size_t                   m_curve_count;
-    std::vector<Curve1Type>  m_curves1;
-    std::vector<Curve3Type>  m_curves3;
-    std::vector<std::string> m_material_slots;
+    CurveBasis                                  m_basis;
+    size_t                                      m_curve_count;
+    bool                                        m_compressed;
+    std::vector<Curve1Type>                     m_curves1;
+    std::vector<Curve3Type>                     m_curves3;
+    CompressedBezierCurveArray<Curve1Type>      m_compressed_curves1;
+    CompressedBezierCurveArray<Curve3Type>      m_compressed_curves3;
+    std::vector<std::string>                    m_material_slots;
 
     Impl()
+      : m_compressed(false)
     {
     }
 
+    size_t get_curve1_count() const
+    {
+        return m_compressed ? m_compressed_curves1.size() : m_curves1.size();
+    }
+
+    size_t get_curve3_count() const
+    {
+        return m_compressed ? m_compressed_curves3.size() : m_curves3.size();
+    }
+
+    Curve1Type get_curve1(const size_t index) const
+    {
+        return m_compressed ? m_compressed_curves1.get(index) : m_curves1[index];
+    }
+
+    Curve3Type get_curve3(const size_t index) const
+    {
+        return m_compressed ? m_compressed_curves3.get(index) : m_curves3[index];
+    }
+
     GAABB3 compute_bounds() const
     {
         GAABB3 bbox;
         bbox.invalidate();
 
-        const size_t curve1_count = m_curves1.size();
-        const size_t curve3_count = m_curves3.size();
+        const size_t curve1_count = get_curve1_count();
+        const size_t curve3_count = get_curve3_count();
 
         for (size_t i = 0; i < curve1_count; ++i)
-            bbox.insert(m_curves1[i].compute_bbox());
+            bbox.insert(get_curve1(i).compute_bbox());
 
         for (size_t i = 0; i < curve3_count; ++i)
-            bbox.insert(m_curves3[i].compute_bbox());
+            bbox.insert(get_curve3(i).compute_bbox());
 
         return bbox;
     }
@@ -93,6 +118,7 @@ CurveObject::CurveObject(
   : Object(name, params)
   , impl(new Impl())
 {
+    impl->m_compressed = m_params.get_optional<bool>("compress_curves", false);
 }
 
 CurveObject::~CurveObject()
@@ -150,24 +176,32 @@ size_t CurveObject::get_curve_count() const
 
 void CurveObject::reserve_curves1(const size_t count)
 {
-    impl->m_curves1.reserve(count);
+    if (impl->m_compressed)
+        impl->m_compressed_curves1.reserve(count);
+    else impl->m_curves1.reserve(count);
 }
 
 void CurveObject::reserve_curves3(const size_t count)
 {
-    impl->m_curves3.reserve(count);
+    if (impl->m_compressed)
+        impl->m_compressed_curves3.reserve(count);
+    else impl->m_curves3.reserve(count);
 }
 
 size_t CurveObject::push_curve1(const Curve1Type& curve)
 {
-    const size_t index = impl->m_curves1.size();
-    impl->m_curves1.push_back(curve);
+    const size_t index = impl->get_curve1_count();
+
+    if (impl->m_compressed)
+        impl->m_compressed_curves1.push_back(curve);
+    else impl->m_curves1.push_back(curve);
+
     return index;
 }
 
 size_t CurveObject::push_curve3(const Curve3Type& curve)
 {
-    const size_t index = impl->m_curves3.size();
+    const size_t index = impl->get_curve3_count();
     Curve3Type t_curve = curve;
 
     switch (get_basis())
@@ -189,31 +223,38 @@ size_t CurveObject::push_curve3(const Curve3Type& curve)
       assert_otherwise;
     }
 
-    impl->m_curves3.push_back(t_curve);
+    if (impl->m_compressed)
+        impl->m_compressed_curves3.push_back(t_curve);
+    else impl->m_curves3.push_back(t_curve);
 
     return index;
 }
 
 size_t CurveObject::get_curve1_count() const
 {
-    return impl->m_curves1.size();
+    return impl->get_curve1_count();
 }
 
 size_t CurveObject::get_curve3_count() const
 {
-    return impl->m_curves3.size();
+    return impl->get_curve3_count();
+}
+
+Curve1Type CurveObject::get_curve1(const size_t index) const
+{
+    assert(index < impl->get_curve1_count());
+    return impl->get_curve1(index);
 }
 
-const Curve1Type& CurveObject::get_curve1(const size_t index) const
+Curve3Type CurveObject::get_curve3(const size_t index) const
 {
-    assert(index < impl->m_curves1.size());
-    return impl->m_curves1[index];
+    assert(index < impl->get_curve3_count());
+    return impl->get_curve3(index);
 }
 
-const Curve3Type& CurveObject::get_curve3(const size_t index) const
+bool CurveObject::has_compressed_curves() const
 {
-    assert(index < impl->m_curves3.size());
-    return impl->m_curves3[index];
+    return impl->m_compressed;
 }
 
 size_t CurveObject::get_material_slot_count() const
@@ -272,6 +313,31 @@ Dictionary CurveObjectFactory::get_model_metadata() const
 DictionaryArray CurveObjectFactory::get_input_metadata() const
 {
     DictionaryArray metadata;
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "compress_curves")
+            .insert("label", "Compress Curves")
+            .insert("type", "boolean")
+            .insert("use", "optional")
+            .insert("default", "false")
+            .insert("help", "Store curves in quantized, half-precision form to reduce memory usage"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "embree_build_quality")
+            .insert("label", "Embree Build Quality")
+            .insert("type", "enumeration")
+            .insert("items",
+                Dictionary()
+                    .insert("Automatic", "auto")
+                    .insert("Low", "low")
+                    .insert("Medium", "medium")
+                    .insert("High", "high"))
+            .insert("use", "optional")
+            .insert("default", "auto")
+            .insert("help", "Quality of the Embree acceleration structure; automatic uses low quality for deforming geometry and high quality otherwise"));
+
     return metadata;
 }
 
@@ -88,8 +88,11 @@ class APPLESEED_DLLSYMBOL CurveObject
     size_t push_curve3(const Curve3Type& curve);
     size_t get_curve1_count() const;
     size_t get_curve3_count() const;
-    const Curve1Type& get_curve1(const size_t index) const;
-    const Curve3Type& get_curve3(const size_t index) const;
+    Curve1Type get_curve1(const size_t index) const;
+    Curve3Type get_curve3(const size_t index) const;
+
+    // Return true if curves are stored in compressed form.
+    bool has_compressed_curves() const;
 
     // Insert and access material slots.
     size_t get_material_slot_count() const override;
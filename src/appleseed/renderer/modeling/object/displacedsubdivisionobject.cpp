@@ -0,0 +1,1004 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// interface header.
+#include "displacedsubdivisionobject.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/kernel/intersection/displacementpatch.h"
+#include "renderer/kernel/intersection/geometrycache.h"
+#include "renderer/kernel/intersection/refining.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/meshobjectreader.h"
+#include "renderer/modeling/object/triangle.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/containers/alignedvector.h"
+#include "foundation/containers/dictionary.h"
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/core/exceptions/exception.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/genericimagefilereader.h"
+#include "foundation/image/image.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/bvh.h"
+#include "foundation/math/intersection/raytrianglemt.h"
+#include "foundation/math/ray.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/defaulttimers.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/searchpaths.h"
+
+// Standard headers.
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// DisplacedSubdivisionObject class implementation.
+//
+
+namespace
+{
+    const char* Model = "displaced_subdivision_object";
+
+    // Each subdivision level splits the edges of a patch in two.
+    const size_t MaxSubdivisionLevel = 10;
+
+    // Level of patches that no ray with differentials has reached yet.
+    const std::uint8_t UnknownLevel = 0xFF;
+
+    typedef bvh::Tree<AlignedVector<bvh::Node<AABB3d>>> PatchTree;
+    typedef bvh::SAHPartitioner<std::vector<AABB3d>> PatchTreePartitioner;
+
+    //
+    // A single-channel displacement map, sampled with bilinear filtering and repeat wrapping.
+    //
+
+    class DisplacementMap
+      : public NonCopyable
+    {
+      public:
+        DisplacementMap()
+          : m_width(0)
+          , m_height(0)
+          , m_max_abs_value(1.0f)
+        {
+        }
+
+        void set_image(const Image& image)
+        {
+            const CanvasProperties& props = image.properties();
+
+            m_width = props.m_canvas_width;
+            m_height = props.m_canvas_height;
+            m_texels.resize(m_width * m_height);
+            m_max_abs_value = 0.0f;
+
+            for (size_t y = 0; y < m_height; ++y)
+            {
+                for (size_t x = 0; x < m_width; ++x)
+                {
+                    float value;
+                    image.get_pixel(x, y, &value, 1);
+                    m_texels[y * m_width + x] = value;
+                    m_max_abs_value = std::max(m_max_abs_value, std::abs(value));
+                }
+            }
+        }
+
+        // Return an upper bound on the absolute value of the samples.
+        float get_max_abs_value() const
+        {
+            return m_max_abs_value;
+        }
+
+        // Without an image, the map is uniformly 1.
+        float sample(const GVector2& uv) const
+        {
+            if (m_texels.empty())
+                return 1.0f;
+
+            const float x = uv[0] * m_width - 0.5f;
+            const float y = (1.0f - uv[1]) * m_height - 0.5f;
+            const float fx = std::floor(x);
+            const float fy = std::floor(y);
+
+            const size_t x0 = wrap(fx, m_width);
+            const size_t x1 = wrap(fx + 1.0f, m_width);
+            const size_t y0 = wrap(fy, m_height);
+            const size_t y1 = wrap(fy + 1.0f, m_height);
+
+            const float wx = x - fx;
+            const float wy = y - fy;
+
+            return
+                lerp(
+                    lerp(texel(x0, y0), texel(x1, y0), wx),
+                    lerp(texel(x0, y1), texel(x1, y1), wx),
+                    wy);
+        }
+
+      private:
+        size_t              m_width;
+        size_t              m_height;
+        std::vector<float>  m_texels;
+        float               m_max_abs_value;
+
+        static size_t wrap(const float i, const size_t n)
+        {
+            const std::int64_t r = static_cast<std::int64_t>(i) % static_cast<std::int64_t>(n);
+            return static_cast<size_t>(r < 0 ? r + static_cast<std::int64_t>(n) : r);
+        }
+
+        float texel(const size_t x, const size_t y) const
+        {
+            return m_texels[y * m_width + x];
+        }
+    };
+}
+
+struct DisplacedSubdivisionObject::Impl
+{
+    // A triangle of the base mesh.
+    struct Patch
+    {
+        GVector3                            m_vertices[3];
+        GVector3                            m_normals[3];
+        GVector2                            m_uvs[3];
+        GVector3                            m_center;
+        GScalar                             m_edge_length;          // length of the longest edge
+        std::uint32_t                       m_material_slot;
+    };
+
+    // Closest intersection with the object.
+    struct Hit
+    {
+        GeometryCache::PatchPtr             m_patch;
+        size_t                              m_patch_index;
+        DisplacementPatch::Hit              m_patch_hit;
+    };
+
+    const double                            m_displacement_amount;
+    const double                            m_tessellation_rate;
+    const size_t                            m_max_level;
+    const size_t                            m_default_level;
+    std::vector<std::string>                m_material_slots;
+    DisplacementMap                         m_displacement_map;
+    std::vector<Patch>                      m_patches;              // in patch tree order
+    PatchTree                               m_patch_tree;
+    std::unique_ptr<std::atomic<std::uint8_t>[]> m_patch_levels;
+    GAABB3                                  m_bbox;
+    double                                  m_refine_eps;
+    mutable GeometryCache                   m_geometry_cache;
+
+    explicit Impl(const ParamArray& params)
+      : m_displacement_amount(params.get_optional<double>("displacement_amount", 0.1))
+      , m_tessellation_rate(params.get_optional<double>("tessellation_rate", 1.0))
+      , m_max_level(std::min(params.get_optional<size_t>("max_subdivision_level", 6), MaxSubdivisionLevel))
+      , m_default_level(std::min(params.get_optional<size_t>("default_subdivision_level", 3), m_max_level))
+      , m_refine_eps(0.0)
+      , m_geometry_cache(params.get_optional<size_t>("geometry_cache_size", 256) * 1024 * 1024)
+    {
+        m_bbox.invalidate();
+    }
+
+    bool load(
+        const char*                         name,
+        const ParamArray&                   params,
+        const SearchPaths&                  search_paths)
+    {
+        // The displacement map must be loaded first since it bounds the patches.
+        if (params.strings().exist("displacement_map"))
+        {
+            const std::string filepath = search_paths.qualify(params.get("displacement_map")).c_str();
+
+            try
+            {
+                GenericImageFileReader reader;
+                std::unique_ptr<Image> image(reader.read(filepath.c_str()));
+                m_displacement_map.set_image(*image);
+            }
+            catch (const Exception& e)
+            {
+                RENDERER_LOG_ERROR(
+                    "failed to load displacement map %s: %s",
+                    filepath.c_str(),
+                    e.what());
+                return false;
+            }
+        }
+
+        MeshObjectArray meshes;
+        if (!MeshObjectReader::read(search_paths, name, params, meshes))
+            return false;
+
+        if (meshes.empty())
+        {
+            RENDERER_LOG_ERROR("no base mesh found for displaced subdivision object \"%s\".", name);
+            return false;
+        }
+
+        if (meshes.size() > 1)
+        {
+            RENDERER_LOG_WARNING(
+                "base mesh of displaced subdivision object \"%s\" contains %s objects, only the first one will be used.",
+                name,
+                pretty_uint(meshes.size()).c_str());
+        }
+
+        collect_patches(*meshes[0]);
+
+        for (size_t i = 0, e = meshes.size(); i < e; ++i)
+            meshes[i]->release();
+
+        build_patch_tree();
+
+        return true;
+    }
+
+    void collect_patches(const MeshObject& mesh)
+    {
+        m_material_slots.clear();
+        for (size_t i = 0, e = mesh.get_material_slot_count(); i < e; ++i)
+            m_material_slots.emplace_back(mesh.get_material_slot(i));
+
+        const size_t vertex_count = mesh.get_vertex_count();
+        const size_t triangle_count = mesh.get_triangle_count();
+
+        // Compute smooth vertex normals for the triangles that don't reference any.
+        std::vector<GVector3> smooth_normals;
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            const Triangle& triangle = mesh.get_triangle(i);
+
+            if (triangle.m_n0 != Triangle::None &&
+                triangle.m_n1 != Triangle::None &&
+                triangle.m_n2 != Triangle::None)
+                continue;
+
+            if (smooth_normals.empty())
+                smooth_normals.assign(vertex_count, GVector3(0.0));
+
+            const GVector3& v0 = mesh.get_vertex(triangle.m_v0);
+            const GVector3& v1 = mesh.get_vertex(triangle.m_v1);
+            const GVector3& v2 = mesh.get_vertex(triangle.m_v2);
+            const GVector3 n = cross(v1 - v0, v2 - v0);
+
+            smooth_normals[triangle.m_v0] += n;
+            smooth_normals[triangle.m_v1] += n;
+            smooth_normals[triangle.m_v2] += n;
+        }
+
+        for (size_t i = 0, e = smooth_normals.size(); i < e; ++i)
+        {
+            const GScalar n = norm(smooth_normals[i]);
+            if (n > GScalar(0.0))
+                smooth_normals[i] /= n;
+        }
+
+        m_patches.resize(triangle_count);
+
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            const Triangle& triangle = mesh.get_triangle(i);
+            const std::uint32_t vertex_indices[3] = { triangle.m_v0, triangle.m_v1, triangle.m_v2 };
+            const std::uint32_t normal_indices[3] = { triangle.m_n0, triangle.m_n1, triangle.m_n2 };
+            const std::uint32_t uv_indices[3] = { triangle.m_a0, triangle.m_a1, triangle.m_a2 };
+
+            Patch& patch = m_patches[i];
+
+            for (size_t j = 0; j < 3; ++j)
+            {
+                patch.m_vertices[j] = mesh.get_vertex(vertex_indices[j]);
+                patch.m_normals[j] =
+                    normal_indices[j] != Triangle::None
+                        ? mesh.get_vertex_normal(normal_indices[j])
+                        : smooth_normals[vertex_indices[j]];
+                patch.m_uvs[j] =
+                    uv_indices[j] != Triangle::None
+                        ? mesh.get_tex_coords(uv_indices[j])
+                        : GVector2(0.0);
+            }
+
+            patch.m_center = (patch.m_vertices[0] + patch.m_vertices[1] + patch.m_vertices[2]) / GScalar(3.0);
+            patch.m_edge_length =
+                std::max(
+                    norm(patch.m_vertices[1] - patch.m_vertices[0]),
+                    std::max(
+                        norm(patch.m_vertices[2] - patch.m_vertices[1]),
+                        norm(patch.m_vertices[0] - patch.m_vertices[2])));
+            patch.m_material_slot = triangle.m_pa != Triangle::None ? triangle.m_pa : 0;
+        }
+    }
+
+    void build_patch_tree()
+    {
+        const size_t patch_count = m_patches.size();
+
+        // Bound each patch by its base triangle grown by the largest displacement.
+        const double max_displacement =
+            std::abs(m_displacement_amount) * m_displacement_map.get_max_abs_value();
+
+        std::vector<AABB3d> patch_bboxes(patch_count);
+        m_bbox.invalidate();
+
+        for (size_t i = 0; i < patch_count; ++i)
+        {
+            AABB3d& bbox = patch_bboxes[i];
+            bbox.invalidate();
+            bbox.insert(Vector3d(m_patches[i].m_vertices[0]));
+            bbox.insert(Vector3d(m_patches[i].m_vertices[1]));
+            bbox.insert(Vector3d(m_patches[i].m_vertices[2]));
+            bbox.grow(Vector3d(max_displacement));
+            m_bbox.insert(GAABB3(bbox));
+        }
+
+        m_patch_levels.reset(new std::atomic<std::uint8_t>[patch_count]);
+        for (size_t i = 0; i < patch_count; ++i)
+            m_patch_levels[i].store(UnknownLevel);
+
+        m_refine_eps = m_bbox.is_valid() ? 1.0e-5 * static_cast<double>(m_bbox.diameter()) : 0.0;
+
+        if (patch_count == 0)
+            return;
+
+        PatchTreePartitioner partitioner(patch_bboxes);
+        bvh::Builder<PatchTree, PatchTreePartitioner> builder;
+        builder.build<DefaultWallclockTimer>(
+            m_patch_tree,
+            partitioner,
+            patch_count,
+            1);
+
+        // Reorder the patches to match the ordering of the tree.
+        const std::vector<size_t>& ordering = partitioner.get_item_ordering();
+        assert(ordering.size() == patch_count);
+
+        std::vector<Patch> reordered_patches(patch_count);
+        for (size_t i = 0; i < patch_count; ++i)
+            reordered_patches[i] = m_patches[ordering[i]];
+
+        m_patches.swap(reordered_patches);
+    }
+
+    // Compute the subdivision level at which the edges of the tessellated patch
+    // roughly match the footprint of the ray at the patch.
+    size_t compute_level(
+        const Patch&                        patch,
+        const ShadingRay&                   ray) const
+    {
+        const Vector3d center(patch.m_center);
+        const double t = std::max(dot(center - ray.m_org, ray.m_dir) / square_norm(ray.m_dir), 0.0);
+
+        const double footprint =
+            std::max(
+                norm((ray.m_rx.m_org - ray.m_org) + t * (ray.m_rx.m_dir - ray.m_dir)),
+                norm((ray.m_ry.m_org - ray.m_org) + t * (ray.m_ry.m_dir - ray.m_dir)));
+
+        const double segment_count = patch.m_edge_length * m_tessellation_rate / footprint;
+
+        if (!(segment_count > 1.0))
+            return 0;
+
+        const double level = std::ceil(std::log2(segment_count));
+
+        return level < m_max_level ? static_cast<size_t>(level) : m_max_level;
+    }
+
+    // Select the subdivision level of a patch. The level of a patch only ever
+    // increases, so that all rays eventually see the same surface, and rays
+    // without differentials (e.g. shadow rays) use the level chosen so far.
+    size_t select_level(
+        const size_t                        patch_index,
+        const ShadingRay*                   ray) const
+    {
+        std::atomic<std::uint8_t>& patch_level = m_patch_levels[patch_index];
+        std::uint8_t level = patch_level.load(std::memory_order_relaxed);
+
+        if (ray != nullptr && ray->m_has_differentials)
+        {
+            const std::uint8_t wanted_level =
+                static_cast<std::uint8_t>(compute_level(m_patches[patch_index], *ray));
+
+            while ((level == UnknownLevel || level < wanted_level) &&
+                   !patch_level.compare_exchange_weak(level, wanted_level, std::memory_order_relaxed))
+                continue;
+
+            if (level == UnknownLevel || level < wanted_level)
+                level = wanted_level;
+        }
+
+        return level == UnknownLevel ? m_default_level : level;
+    }
+
+    GeometryCache::PatchPtr tessellate(
+        const size_t                        patch_index,
+        const size_t                        level) const
+    {
+        const Patch& patch = m_patches[patch_index];
+        const size_t n = size_t(1) << level;
+        const GScalar rcp_n = GScalar(1.0) / n;
+        const GScalar amount = static_cast<GScalar>(m_displacement_amount);
+
+        // Vertices are laid out in rows of decreasing length along the second edge.
+        std::vector<GVector3> vertices;
+        std::vector<GVector2> uvs;
+        vertices.reserve((n + 1) * (n + 2) / 2);
+        uvs.reserve((n + 1) * (n + 2) / 2);
+
+        for (size_t j = 0; j <= n; ++j)
+        {
+            for (size_t i = 0; i <= n - j; ++i)
+            {
+                const GScalar w1 = i * rcp_n;
+                const GScalar w2 = j * rcp_n;
+                const GScalar w0 = GScalar(1.0) - w1 - w2;
+
+                const GVector3 p = w0 * patch.m_vertices[0] + w1 * patch.m_vertices[1] + w2 * patch.m_vertices[2];
+                const GVector2 uv = w0 * patch.m_uvs[0] + w1 * patch.m_uvs[1] + w2 * patch.m_uvs[2];
+
+                GVector3 normal = w0 * patch.m_normals[0] + w1 * patch.m_normals[1] + w2 * patch.m_normals[2];
+                const GScalar normal_norm = norm(normal);
+                if (normal_norm > GScalar(0.0))
+                    normal /= normal_norm;
+
+                vertices.push_back(p + normal * (amount * m_displacement_map.sample(uv)));
+                uvs.push_back(uv);
+            }
+        }
+
+        const auto row_start = [n](const size_t j)
+        {
+            return static_cast<std::uint32_t>(j * (n + 1) - j * (j - 1) / 2);
+        };
+
+        std::vector<std::uint32_t> indices;
+        indices.reserve(n * n * 3);
+
+        for (size_t j = 0; j < n; ++j)
+        {
+            for (size_t i = 0; i < n - j; ++i)
+            {
+                const std::uint32_t a = row_start(j) + static_cast<std::uint32_t>(i);
+                const std::uint32_t b = a + 1;
+                const std::uint32_t c = row_start(j + 1) + static_cast<std::uint32_t>(i);
+
+                indices.push_back(a);
+                indices.push_back(b);
+                indices.push_back(c);
+
+                if (i + 1 < n - j)
+                {
+                    indices.push_back(b);
+                    indices.push_back(c + 1);
+                    indices.push_back(c);
+                }
+            }
+        }
+
+        return std::make_shared<DisplacementPatch>(vertices, uvs, indices);
+    }
+
+    GeometryCache::PatchPtr get_patch(
+        const size_t                        patch_index,
+        const size_t                        level) const
+    {
+        assert(level <= MaxSubdivisionLevel);
+
+        const std::uint64_t key = (static_cast<std::uint64_t>(patch_index) << 4) | level;
+
+        return
+            m_geometry_cache.get(
+                key,
+                [this, patch_index, level]() { return tessellate(patch_index, level); });
+    }
+
+    class PatchVisitor
+      : public NonCopyable
+    {
+      public:
+        PatchVisitor(
+            const Impl&                     impl,
+            const ShadingRay*               shading_ray,
+            Hit&                            hit)
+          : m_impl(impl)
+          , m_shading_ray(shading_ray)
+          , m_hit(hit)
+          , m_found(false)
+        {
+        }
+
+        bool visit(
+            const PatchTree::NodeType&      node,
+            const Ray3d&                    ray,
+            const RayInfo3d&                ray_info,
+            double&                         distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics&     stats
+#endif
+            )
+        {
+            Ray3d patch_ray(ray);
+            if (m_found)
+                patch_ray.m_tmax = m_hit.m_patch_hit.m_distance;
+
+            const size_t begin = node.get_item_index();
+            const size_t end = begin + node.get_item_count();
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const GeometryCache::PatchPtr patch =
+                    m_impl.get_patch(i, m_impl.select_level(i, m_shading_ray));
+
+                DisplacementPatch::Hit patch_hit;
+                if (patch->intersect(patch_ray, patch_hit))
+                {
+                    patch_ray.m_tmax = patch_hit.m_distance;
+                    m_hit.m_patch = patch;
+                    m_hit.m_patch_index = i;
+                    m_hit.m_patch_hit = patch_hit;
+                    m_found = true;
+                }
+            }
+
+            distance = patch_ray.m_tmax;
+            return true;
+        }
+
+        bool found() const
+        {
+            return m_found;
+        }
+
+      private:
+        const Impl&                         m_impl;
+        const ShadingRay*                   m_shading_ray;
+        Hit&                                m_hit;
+        bool                                m_found;
+    };
+
+    class PatchProbeVisitor
+      : public NonCopyable
+    {
+      public:
+        PatchProbeVisitor(
+            const Impl&                     impl,
+            const ShadingRay*               shading_ray)
+          : m_impl(impl)
+          , m_shading_ray(shading_ray)
+          , m_found(false)
+        {
+        }
+
+        bool visit(
+            const PatchTree::NodeType&      node,
+            const Ray3d&                    ray,
+            const RayInfo3d&                ray_info,
+            double&                         distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics&     stats
+#endif
+            )
+        {
+            const size_t begin = node.get_item_index();
+            const size_t end = begin + node.get_item_count();
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const GeometryCache::PatchPtr patch =
+                    m_impl.get_patch(i, m_impl.select_level(i, m_shading_ray));
+
+                if (patch->intersect(ray))
+                {
+                    m_found = true;
+                    return false;
+                }
+            }
+
+            distance = ray.m_tmax;
+            return true;
+        }
+
+        bool found() const
+        {
+            return m_found;
+        }
+
+      private:
+        const Impl&                         m_impl;
+        const ShadingRay*                   m_shading_ray;
+        bool                                m_found;
+    };
+
+    // Find the closest intersection with the object. `shading_ray` provides ray
+    // differentials, if any.
+    bool intersect(
+        const Ray3d&                        ray,
+        const ShadingRay*                   shading_ray,
+        Hit&                                hit) const
+    {
+        if (m_patches.empty())
+            return false;
+
+        PatchVisitor visitor(*this, shading_ray, hit);
+        FOUNDATION_BVH_TRAVERSAL_STATS(bvh::TraversalStatistics stats;)
+        bvh::Intersector<PatchTree, PatchVisitor, Ray3d> intersector;
+        intersector.intersect_no_motion(
+            m_patch_tree,
+            ray,
+            RayInfo3d(ray),
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+
+        return visitor.found();
+    }
+
+    bool intersect(
+        const Ray3d&                        ray,
+        const ShadingRay*                   shading_ray) const
+    {
+        if (m_patches.empty())
+            return false;
+
+        PatchProbeVisitor visitor(*this, shading_ray);
+        FOUNDATION_BVH_TRAVERSAL_STATS(bvh::TraversalStatistics stats;)
+        bvh::Intersector<PatchTree, PatchProbeVisitor, Ray3d> intersector;
+        intersector.intersect_no_motion(
+            m_patch_tree,
+            ray,
+            RayInfo3d(ray),
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+
+        return visitor.found();
+    }
+};
+
+DisplacedSubdivisionObject::DisplacedSubdivisionObject(
+    const char*            name,
+    const ParamArray&      params)
+  : ProceduralObject(name, params)
+  , impl(new Impl(params))
+{
+}
+
+DisplacedSubdivisionObject::~DisplacedSubdivisionObject()
+{
+    delete impl;
+}
+
+void DisplacedSubdivisionObject::release()
+{
+    delete this;
+}
+
+const char* DisplacedSubdivisionObject::get_model() const
+{
+    return Model;
+}
+
+void DisplacedSubdivisionObject::on_frame_end(
+    const Project&         project,
+    const BaseGroup*       parent)
+{
+    const GeometryCache& cache = impl->m_geometry_cache;
+    const std::uint64_t hit_count = cache.get_hit_count();
+    const std::uint64_t miss_count = cache.get_miss_count();
+
+    RENDERER_LOG_DEBUG(
+        "displaced subdivision object \"%s\": %s %s in geometry cache (%s), %s hit rate.",
+        get_path().c_str(),
+        pretty_uint(cache.get_patch_count()).c_str(),
+        cache.get_patch_count() > 1 ? "patches" : "patch",
+        pretty_size(cache.get_memory_size()).c_str(),
+        pretty_percent(hit_count, hit_count + miss_count).c_str());
+
+    ProceduralObject::on_frame_end(project, parent);
+}
+
+GAABB3 DisplacedSubdivisionObject::compute_local_bbox() const
+{
+    return impl->m_bbox;
+}
+
+size_t DisplacedSubdivisionObject::get_material_slot_count() const
+{
+    return impl->m_material_slots.size();
+}
+
+const char* DisplacedSubdivisionObject::get_material_slot(const size_t index) const
+{
+    return impl->m_material_slots[index].c_str();
+}
+
+size_t DisplacedSubdivisionObject::get_patch_count() const
+{
+    return impl->m_patches.size();
+}
+
+void DisplacedSubdivisionObject::intersect(
+    const ShadingRay&      ray,
+    IntersectionResult&    result) const
+{
+    Impl::Hit hit;
+    result.m_hit = impl->intersect(ray, &ray, hit);
+
+    if (result.m_hit)
+    {
+        const DisplacementPatch::Hit& patch_hit = hit.m_patch_hit;
+        const TriangleMT<double> triangle = hit.m_patch->get_triangle(patch_hit.m_triangle_index);
+        const Vector3d n = normalize(cross(triangle.m_e0, triangle.m_e1));
+
+        result.m_distance = patch_hit.m_distance;
+        result.m_geometric_normal = n;
+        result.m_shading_normal = n;
+        result.m_uv = hit.m_patch->get_uv(patch_hit.m_triangle_index, patch_hit.m_u, patch_hit.m_v);
+        result.m_material_slot = impl->m_patches[hit.m_patch_index].m_material_slot;
+    }
+}
+
+bool DisplacedSubdivisionObject::intersect(const ShadingRay& ray) const
+{
+    return impl->intersect(ray, &ray);
+}
+
+void DisplacedSubdivisionObject::refine_and_offset(
+    const Ray3d&        obj_inst_ray,
+    Vector3d&           obj_inst_front_point,
+    Vector3d&           obj_inst_back_point,
+    Vector3d&           obj_inst_geo_normal) const
+{
+    // Find the tessellated triangle containing the hit point by intersecting
+    // a short segment straddling it.
+    const Vector3d dir = normalize(obj_inst_ray.m_dir);
+    const double eps = impl->m_refine_eps;
+    const Ray3d segment(obj_inst_ray.m_org - eps * dir, dir, 0.0, 2.0 * eps);
+
+    Impl::Hit hit;
+    if (impl->intersect(segment, nullptr, hit))
+    {
+        const TriangleMT<double> triangle = hit.m_patch->get_triangle(hit.m_patch_hit.m_triangle_index);
+        const TriangleMTSupportPlane<double> plane(triangle);
+
+        // Handle refining for the ray origin point.
+        const auto intersection_handling = [&plane](const Vector3d& p, const Vector3d& d)
+        {
+            return plane.intersect(p, d);
+        };
+
+        // Refine the location of the intersection point.
+        const Vector3d refined_intersection_point =
+            refine(
+                obj_inst_ray.m_org,
+                obj_inst_ray.m_dir,
+                intersection_handling);
+
+        // Compute the geometric normal to the hit in object instance space.
+        obj_inst_geo_normal = normalize(cross(triangle.m_e0, triangle.m_e1));
+        obj_inst_geo_normal = faceforward(obj_inst_geo_normal, obj_inst_ray.m_dir);
+
+        adaptive_offset(
+            refined_intersection_point,
+            obj_inst_geo_normal,
+            obj_inst_front_point,
+            obj_inst_back_point,
+            intersection_handling);
+    }
+    else
+    {
+        obj_inst_geo_normal = -dir;
+
+        fixed_offset(
+            obj_inst_ray.m_org,
+            obj_inst_geo_normal,
+            obj_inst_front_point,
+            obj_inst_back_point);
+    }
+}
+
+bool DisplacedSubdivisionObject::load(const SearchPaths& search_paths)
+{
+    return impl->load(get_name(), m_params, search_paths);
+}
+
+
+//
+// DisplacedSubdivisionObjectFactory class implementation.
+//
+
+void DisplacedSubdivisionObjectFactory::release()
+{
+    delete this;
+}
+
+const char* DisplacedSubdivisionObjectFactory::get_model() const
+{
+    return Model;
+}
+
+Dictionary DisplacedSubdivisionObjectFactory::get_model_metadata() const
+{
+    return
+        Dictionary()
+            .insert("name", Model)
+            .insert("label", "Displaced Subdivision Object");
+}
+
+DictionaryArray DisplacedSubdivisionObjectFactory::get_input_metadata() const
+{
+    DictionaryArray metadata;
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "filename")
+            .insert("label", "Base Mesh File")
+            .insert("type", "file")
+            .insert("file_picker_mode", "open")
+            .insert("file_picker_type", "mesh")
+            .insert("use", "required"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "displacement_map")
+            .insert("label", "Displacement Map")
+            .insert("type", "file")
+            .insert("file_picker_mode", "open")
+            .insert("file_picker_type", "image")
+            .insert("use", "optional"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "displacement_amount")
+            .insert("label", "Displacement Amount")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "-1.0")
+                    .insert("type", "soft"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "1.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "0.1"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "tessellation_rate")
+            .insert("label", "Tessellation Rate")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0.0")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "4.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "1.0")
+            .insert("help", "Number of tessellated edges per ray footprint"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "max_subdivision_level")
+            .insert("label", "Max Subdivision Level")
+            .insert("type", "integer")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", to_string(MaxSubdivisionLevel))
+                    .insert("type", "hard"))
+            .insert("use", "optional")
+            .insert("default", "6"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "default_subdivision_level")
+            .insert("label", "Default Subdivision Level")
+            .insert("type", "integer")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", to_string(MaxSubdivisionLevel))
+                    .insert("type", "hard"))
+            .insert("use", "optional")
+            .insert("default", "3")
+            .insert("help", "Subdivision level of patches not yet reached by rays with differentials"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "geometry_cache_size")
+            .insert("label", "Geometry Cache Size (MB)")
+            .insert("type", "integer")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "1")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "4096")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "256"));
+
+    return metadata;
+}
+
+auto_release_ptr<Object> DisplacedSubdivisionObjectFactory::create(
+    const char*            name,
+    const ParamArray&      params) const
+{
+    return auto_release_ptr<Object>(new DisplacedSubdivisionObject(name, params));
+}
+
+bool DisplacedSubdivisionObjectFactory::create(
+    const char*            name,
+    const ParamArray&      params,
+    const SearchPaths&     search_paths,
+    const bool             omit_loading_assets,
+    ObjectArray&           objects) const
+{
+    auto_release_ptr<DisplacedSubdivisionObject> object(
+        new DisplacedSubdivisionObject(name, params));
+
+    if (!omit_loading_assets && !object->load(search_paths))
+        return false;
+
+    objects.push_back(object.release());
+    return true;
+}
+
+}   // namespace renderer
@@ -38,6 +38,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
+#include "foundation/memory/memorytracker.h"
 #include "foundation/utility/api/apiarray.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/foreach.h"
@@ -65,6 +66,12 @@ struct MeshObject::Impl
 {
     StaticTriangleTess          m_tess;
     std::vector<std::string>    m_material_slots;
+    TrackedMemory               m_tracked_memory;
+
+    Impl()
+      : m_tracked_memory("geometry")
+    {
+    }
 };
 
 MeshObject::MeshObject(
@@ -74,6 +81,9 @@ MeshObject::MeshObject(
   , impl(new Impl())
 {
     m_inputs.declare("alpha_map", InputFormatFloat, "");
+
+    impl->m_tess.set_compressed_vertex_attributes(
+        m_params.get_optional<bool>("compress_vertex_attributes", false));
 }
 
 MeshObject::~MeshObject()
@@ -91,6 +101,34 @@ const char* MeshObject::get_model() const
     return Model;
 }
 
+bool MeshObject::on_frame_begin(
+    const Project&          project,
+    const BaseGroup*        parent,
+    OnFrameBeginRecorder&   recorder,
+    IAbortSwitch*           abort_switch)
+{
+    if (!Object::on_frame_begin(project, parent, recorder, abort_switch))
+        return false;
+
+    // The tessellation may have been modified since the last frame.
+    const bool interleaved_shading_data =
+        m_params.get_optional<bool>("interleaved_shading_data", false) &&
+        impl->m_tess.get_motion_segment_count() == 0;
+    if (interleaved_shading_data)
+        impl->m_tess.build_shading_data();
+    else
+        impl->m_tess.clear_shading_data();
+
+    impl->m_tracked_memory.set_size(impl->m_tess.get_memory_size());
+
+    return true;
+}
+
+bool MeshObject::is_on_frame_begin_thread_safe() const
+{
+    return true;
+}
+
 const Source* MeshObject::get_uncached_alpha_map() const
 {
     return m_inputs.source("alpha_map");
@@ -117,9 +155,9 @@ void MeshObject::rasterize(ObjectRasterizer& rasterizer) const
         const auto& v2 = impl->m_tess.m_vertices[prim.m_v2];
 
         // todo: check that vertex normals are available.
-        const auto& n0 = impl->m_tess.m_vertex_normals[prim.m_n0];
-        const auto& n1 = impl->m_tess.m_vertex_normals[prim.m_n1];
-        const auto& n2 = impl->m_tess.m_vertex_normals[prim.m_n2];
+        const GVector3 n0 = impl->m_tess.get_vertex_normal(prim.m_n0);
+        const GVector3 n1 = impl->m_tess.get_vertex_normal(prim.m_n1);
+        const GVector3 n2 = impl->m_tess.get_vertex_normal(prim.m_n2);
 
         ObjectRasterizer::Triangle triangle;
 
@@ -175,33 +213,36 @@ const GVector3& MeshObject::get_vertex(const size_t index) const
     return impl->m_tess.m_vertices[index];
 }
 
+void MeshObject::clear_vertices()
+{
+    impl->m_tess.clear_vertices();
+}
+
 void MeshObject::reserve_vertex_normals(const size_t count)
 {
-    impl->m_tess.m_vertex_normals.reserve(count);
+    impl->m_tess.reserve_vertex_normals(count);
 }
 
 size_t MeshObject::push_vertex_normal(const GVector3& normal)
 {
     assert(is_normalized(normal));
 
-    const size_t index = impl->m_tess.m_vertex_normals.size();
-    impl->m_tess.m_vertex_normals.push_back(normal);
-    return index;
+    return impl->m_tess.push_vertex_normal(normal);
 }
 
 size_t MeshObject::get_vertex_normal_count() const
 {
-    return impl->m_tess.m_vertex_normals.size();
+    return impl->m_tess.get_vertex_normal_count();
 }
 
-const GVector3& MeshObject::get_vertex_normal(const size_t index) const
+GVector3 MeshObject::get_vertex_normal(const size_t index) const
 {
-    return impl->m_tess.m_vertex_normals[index];
+    return impl->m_tess.get_vertex_normal(index);
 }
 
 void MeshObject::clear_vertex_normals()
 {
-    impl->m_tess.m_vertex_normals.clear();
+    impl->m_tess.clear_vertex_normals();
 }
 
 void MeshObject::reserve_vertex_tangents(const size_t count)
@@ -224,6 +265,11 @@ GVector3 MeshObject::get_vertex_tangent(const size_t index) const
     return impl->m_tess.get_vertex_tangent(index);
 }
 
+void MeshObject::clear_vertex_tangents()
+{
+    impl->m_tess.clear_vertex_tangents();
+}
+
 void MeshObject::reserve_tex_coords(const size_t count)
 {
     impl->m_tess.reserve_tex_coords(count);
@@ -244,6 +290,11 @@ GVector2 MeshObject::get_tex_coords(const size_t index) const
     return impl->m_tess.get_tex_coords(index);
 }
 
+void MeshObject::clear_tex_coords()
+{
+    impl->m_tess.clear_tex_coords();
+}
+
 void MeshObject::reserve_triangles(const size_t count)
 {
     impl->m_tess.m_primitives.reserve(count);
@@ -438,6 +489,39 @@ DictionaryArray MeshObjectFactory::get_input_metadata() const
                     .insert("type", "hard"))
             .insert("use", "optional"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "compress_vertex_attributes")
+            .insert("label", "Compress Vertex Attributes")
+            .insert("type", "boolean")
+            .insert("use", "optional")
+            .insert("default", "false")
+            .insert("help", "Store vertex normals, tangents and texture coordinates in compressed form to reduce memory usage"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "interleaved_shading_data")
+            .insert("label", "Interleaved Shading Data")
+            .insert("type", "boolean")
+            .insert("use", "optional")
+            .insert("default", "false")
+            .insert("help", "Store a per-triangle copy of the vertex attributes to speed up shading at the cost of memory"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "embree_build_quality")
+            .insert("label", "Embree Build Quality")
+            .insert("type", "enumeration")
+            .insert("items",
+                Dictionary()
+                    .insert("Automatic", "auto")
+                    .insert("Low", "low")
+                    .insert("Medium", "medium")
+                    .insert("High", "high"))
+            .insert("use", "optional")
+            .insert("default", "auto")
+            .insert("help", "Quality of the Embree acceleration structure; automatic uses low quality for deforming geometry and high quality otherwise"));
+
     return metadata;
 }
 
@@ -48,11 +48,15 @@
 // Forward declarations.
 namespace foundation    { class Dictionary; }
 namespace foundation    { class DictionaryArray; }
+namespace foundation    { class IAbortSwitch; }
 namespace foundation    { class SearchPaths; }
 namespace foundation    { class StringArray; }
 namespace foundation    { class StringDictionary; }
+namespace renderer      { class BaseGroup; }
 namespace renderer      { class ObjectRasterizer; }
+namespace renderer      { class OnFrameBeginRecorder; }
 namespace renderer      { class ParamArray; }
+namespace renderer      { class Project; }
 namespace renderer      { class Source; }
 namespace renderer      { class Triangle; }
 
@@ -75,6 +79,15 @@ class APPLESEED_DLLSYMBOL MeshObject
     // Return a string identifying the model of this object.
     const char* get_model() const override;
 
+    bool on_frame_begin(
+        const Project&              project,
+        const BaseGroup*            parent,
+        OnFrameBeginRecorder&       recorder,
+        foundation::IAbortSwitch*   abort_switch = nullptr) override;
+
+    // Only touches the tessellation owned by this mesh.
+    bool is_on_frame_begin_thread_safe() const override;
+
     // Return the source bound to the alpha map input, or 0 if the object doesn't have an alpha map.
     const Source* get_uncached_alpha_map() const override;
 
@@ -92,12 +105,13 @@ class APPLESEED_DLLSYMBOL MeshObject
     size_t push_vertex(const GVector3& vertex);
     size_t get_vertex_count() const;
     const GVector3& get_vertex(const size_t index) const;
+    void clear_vertices();                                  // also removes vertex poses
 
     // Insert and access vertex normals.
     void reserve_vertex_normals(const size_t count);
     size_t push_vertex_normal(const GVector3& normal);      // the normal must be unit-length
     size_t get_vertex_normal_count() const;
-    const GVector3& get_vertex_normal(const size_t index) const;
+    GVector3 get_vertex_normal(const size_t index) const;
     void clear_vertex_normals();
 
     // Insert and access vertex tangents.
@@ -105,12 +119,14 @@ class APPLESEED_DLLSYMBOL MeshObject
     size_t push_vertex_tangent(const GVector3& tangent);    // the tangent must be unit-length
     size_t get_vertex_tangent_count() const;
     GVector3 get_vertex_tangent(const size_t index) const;
+    void clear_vertex_tangents();
 
     // Insert and access texture coordinates.
     void reserve_tex_coords(const size_t count);
     size_t push_tex_coords(const GVector2& tex_coords);
     size_t get_tex_coords_count() const;
     GVector2 get_tex_coords(const size_t index) const;
+    void clear_tex_coords();
 
     // Insert and access triangles.
     void reserve_triangles(const size_t count);
@@ -30,6 +30,7 @@
 #include "meshobjectoperations.h"
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
 #include "renderer/modeling/object/meshobject.h"
 #include "renderer/modeling/object/triangle.h"
@@ -37,11 +38,21 @@
 
 // appleseed.foundation headers.
 #include "foundation/hash/murmurhash.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/system.h"
+#include "foundation/utility/job.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 using namespace foundation;
@@ -49,64 +60,107 @@ using namespace foundation;
 namespace renderer
 {
 
-void compute_smooth_vertex_normals_base_pose(MeshObject& object)
+namespace
 {
-    assert(object.get_vertex_normal_count() == 0);
+    // Below this number of triangles, per-vertex quantities are accumulated on the calling thread.
+    const size_t MinParallelTriangleCount = 256 * 1024;
 
-    const size_t vertex_count = object.get_vertex_count();
-    const size_t triangle_count = object.get_triangle_count();
+    // Number of triangle ranges accumulated into separate per-vertex buffers before they are summed.
+    // It doesn't depend on the number of cores so that results are identical on all machines.
+    const size_t TriangleRangeCount = 8;
 
-    std::vector<GVector3> normals(vertex_count, GVector3(0.0));
+    // Accumulate the contributions of triangles [begin, end) into per-vertex vectors.
+    typedef std::function<void (size_t, size_t, std::vector<GVector3>&)> AccumulateFunction;
 
-    for (size_t i = 0; i < triangle_count; ++i)
+    class AccumulateJob
+      : public IJob
     {
-        Triangle& triangle = object.get_triangle(i);
-        triangle.m_n0 = triangle.m_v0;
-        triangle.m_n1 = triangle.m_v1;
-        triangle.m_n2 = triangle.m_v2;
-
-        const GVector3& v0 = object.get_vertex(triangle.m_v0);
-        const GVector3& v1 = object.get_vertex(triangle.m_v1);
-        const GVector3& v2 = object.get_vertex(triangle.m_v2);
-
-        GVector3 normal = compute_triangle_normal(v0, v1, v2);
-        const GScalar normal_norm = norm(normal);
-
-        if (normal_norm == GScalar(0.0))
-            continue;
-
-        normal /= normal_norm;
-        normals[triangle.m_v0] += normal;
-        normals[triangle.m_v1] += normal;
-        normals[triangle.m_v2] += normal;
+      public:
+        AccumulateJob(
+            const AccumulateFunction&   accumulate,
+            const size_t                begin,
+            const size_t                end,
+            std::vector<GVector3>&      vectors)
+          : m_accumulate(accumulate)
+          , m_begin(begin)
+          , m_end(end)
+          , m_vectors(vectors)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            m_accumulate(m_begin, m_end, m_vectors);
+        }
+
+      private:
+        const AccumulateFunction&   m_accumulate;
+        const size_t                m_begin;
+        const size_t                m_end;
+        std::vector<GVector3>&      m_vectors;
+    };
+
+    // Return per-vertex sums of the contributions of all the triangles of a mesh.
+    // Large meshes are split into triangle ranges accumulated in parallel into
+    // separate buffers, which are then summed in a fixed order.
+    std::vector<GVector3> accumulate_over_triangles(
+        const size_t                triangle_count,
+        const size_t                vertex_count,
+        const AccumulateFunction&   accumulate)
+    {
+        std::vector<GVector3> vectors(vertex_count, GVector3(0.0));
+
+        const size_t thread_count =
+            std::min(System::get_logical_cpu_core_count(), TriangleRangeCount);
+
+        if (triangle_count < MinParallelTriangleCount || thread_count < 2)
+        {
+            accumulate(0, triangle_count, vectors);
+            return vectors;
+        }
+
+        std::vector<std::vector<GVector3>> partial_vectors(
+            TriangleRangeCount - 1,
+            std::vector<GVector3>(vertex_count, GVector3(0.0)));
+
+        JobQueue job_queue;
+        JobManager job_manager(global_logger(), job_queue, thread_count);
+
+        for (size_t i = 0; i < TriangleRangeCount; ++i)
+        {
+            job_queue.schedule(
+                new AccumulateJob(
+                    accumulate,
+                    (triangle_count * i) / TriangleRangeCount,
+                    (triangle_count * (i + 1)) / TriangleRangeCount,
+                    i == 0 ? vectors : partial_vectors[i - 1]));
+        }
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            for (size_t j = 0; j < TriangleRangeCount - 1; ++j)
+                vectors[i] += partial_vectors[j][i];
+        }
+
+        return vectors;
     }
 
-    object.reserve_vertex_normals(vertex_count);
-
-    for (size_t i = 0; i < vertex_count; ++i)
-        object.push_vertex_normal(safe_normalize(normals[i]));
-}
-
-void compute_smooth_vertex_normals_pose(MeshObject& object, const size_t motion_segment_index)
-{
-    const size_t vertex_count = object.get_vertex_count();
-    const size_t triangle_count = object.get_triangle_count();
-
-    std::vector<GVector3> normals(vertex_count, GVector3(0.0));
-
-    for (size_t i = 0; i < triangle_count; ++i)
+    // Accumulate the unit normal of a triangle into the normals of its vertices.
+    void accumulate_triangle_normal(
+        const Triangle&             triangle,
+        const GVector3&             v0,
+        const GVector3&             v1,
+        const GVector3&             v2,
+        std::vector<GVector3>&      normals)
     {
-        const Triangle& triangle = object.get_triangle(i);
-
-        const GVector3& v0 = object.get_vertex_pose(triangle.m_v0, motion_segment_index);
-        const GVector3& v1 = object.get_vertex_pose(triangle.m_v1, motion_segment_index);
-        const GVector3& v2 = object.get_vertex_pose(triangle.m_v2, motion_segment_index);
-
         GVector3 normal = compute_triangle_normal(v0, v1, v2);
         const GScalar normal_norm = norm(normal);
 
         if (normal_norm == GScalar(0.0))
-            continue;
+            return;
 
         normal /= normal_norm;
         normals[triangle.m_v0] += normal;
@@ -114,34 +168,17 @@ void compute_smooth_vertex_normals_pose(MeshObject& object, const size_t motion_
         normals[triangle.m_v2] += normal;
     }
 
-    for (size_t i = 0; i < vertex_count; ++i)
-        object.set_vertex_normal_pose(i, motion_segment_index, safe_normalize(normals[i]));
-}
-
-void compute_smooth_vertex_normals(MeshObject& object)
-{
-    compute_smooth_vertex_normals_base_pose(object);
-
-    for (size_t i = 0, e = object.get_motion_segment_count(); i < e; ++i)
-        compute_smooth_vertex_normals_pose(object, i);
-}
-
-void compute_smooth_vertex_tangents_base_pose(MeshObject& object)
-{
-    assert(object.get_vertex_tangent_count() == 0);
-    assert(object.get_tex_coords_count() > 0);
-
-    const size_t vertex_count = object.get_vertex_count();
-    const size_t triangle_count = object.get_triangle_count();
-
-    std::vector<GVector3> tangents(vertex_count, GVector3(0.0));
-
-    for (size_t i = 0; i < triangle_count; ++i)
+    // Accumulate the unit tangent of a triangle into the tangents of its vertices.
+    void accumulate_triangle_tangent(
+        const MeshObject&           object,
+        const Triangle&             triangle,
+        const GVector3&             v0,
+        const GVector3&             v1,
+        const GVector3&             v2,
+        std::vector<GVector3>&      tangents)
     {
-        const Triangle& triangle = object.get_triangle(i);
-
         if (!triangle.has_vertex_attributes())
-            continue;
+            return;
 
         const GVector2 v0_uv = object.get_tex_coords(triangle.m_a0);
         const GVector2 v1_uv = object.get_tex_coords(triangle.m_a1);
@@ -160,17 +197,16 @@ void compute_smooth_vertex_tangents_base_pose(MeshObject& object)
         const GScalar det = dv1 * du0 - dv0 * du1;
 
         if (det == GScalar(0.0))
-            continue;
+            return;
 
-        const GVector3& v2 = object.get_vertex(triangle.m_v2);
-        const GVector3 dp0 = object.get_vertex(triangle.m_v0) - v2;
-        const GVector3 dp1 = object.get_vertex(triangle.m_v1) - v2;
+        const GVector3 dp0 = v0 - v2;
+        const GVector3 dp1 = v1 - v2;
 
         GVector3 tangent = dv1 * dp0 - dv0 * dp1;
         const GScalar tangent_norm = norm(tangent);
 
         if (tangent_norm == GScalar(0.0))
-            continue;
+            return;
 
         tangent /= tangent_norm;
         tangents[triangle.m_v0] += tangent;
@@ -178,62 +214,727 @@ void compute_smooth_vertex_tangents_base_pose(MeshObject& object)
         tangents[triangle.m_v2] += tangent;
     }
 
-    object.reserve_vertex_tangents(vertex_count);
+    // Below this number of elements, welding keys, sorting keys and reordered vertex streams
+    // are computed on the calling thread.
+    const size_t MinParallelElementCount = 256 * 1024;
 
-    for (size_t i = 0; i < vertex_count; ++i)
-        object.push_vertex_tangent(safe_normalize(tangents[i]));
+    // Process the elements [begin, end) of an array.
+    typedef std::function<void (size_t, size_t)> RangeFunction;
+
+    class RangeJob
+      : public IJob
+    {
+      public:
+        RangeJob(
+            const RangeFunction&        function,
+            const size_t                begin,
+            const size_t                end)
+          : m_function(function)
+          , m_begin(begin)
+          , m_end(end)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            m_function(m_begin, m_end);
+        }
+
+      private:
+        const RangeFunction&        m_function;
+        const size_t                m_begin;
+        const size_t                m_end;
+    };
+
+    typedef std::vector<std::pair<size_t, size_t>> RangeArray;
+
+    // Process a set of ranges in parallel.
+    void run_in_parallel(
+        const RangeArray&           ranges,
+        const size_t                thread_count,
+        const RangeFunction&        function)
+    {
+        JobQueue job_queue;
+        JobManager job_manager(global_logger(), job_queue, thread_count);
+
+        for (const auto& range : ranges)
+            job_queue.schedule(new RangeJob(function, range.first, range.second));
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+    }
+
+    // Process the elements of an array, splitting large arrays into ranges processed in parallel.
+    // The function must not depend on how elements are split into ranges.
+    void for_each_range(const size_t count, const RangeFunction& function)
+    {
+        const size_t thread_count = System::get_logical_cpu_core_count();
+
+        if (count < MinParallelElementCount || thread_count < 2)
+        {
+            function(0, count);
+            return;
+        }
+
+        RangeArray ranges;
+
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            ranges.emplace_back(
+                (count * i) / thread_count,
+                (count * (i + 1)) / thread_count);
+        }
+
+        run_in_parallel(ranges, thread_count, function);
+    }
+
+    // Sort an array of unique values. Large arrays are split into ranges sorted in parallel,
+    // which are then merged pairwise, also in parallel.
+    template <typename T>
+    void sort_in_parallel(std::vector<T>& values)
+    {
+        const size_t count = values.size();
+        const size_t thread_count = System::get_logical_cpu_core_count();
+
+        if (count < MinParallelElementCount || thread_count < 2)
+        {
+            std::sort(values.begin(), values.end());
+            return;
+        }
+
+        // Boundaries of the ranges, which are identified by their index below.
+        std::vector<size_t> bounds(thread_count + 1);
+        for (size_t i = 0; i <= thread_count; ++i)
+            bounds[i] = (count * i) / thread_count;
+
+        RangeArray ranges;
+
+        for (size_t i = 0; i < thread_count; ++i)
+            ranges.emplace_back(i, i + 1);
+
+        run_in_parallel(
+            ranges,
+            thread_count,
+            [&values, &bounds](const size_t begin, const size_t end)
+            {
+                std::sort(values.begin() + bounds[begin], values.begin() + bounds[end]);
+            });
+
+        for (size_t width = 1; width < thread_count; width *= 2)
+        {
+            ranges.clear();
+
+            for (size_t i = 0; i + width < thread_count; i += 2 * width)
+                ranges.emplace_back(i, std::min(i + 2 * width, thread_count));
+
+            run_in_parallel(
+                ranges,
+                thread_count,
+                [&values, &bounds, width](const size_t begin, const size_t end)
+                {
+                    std::inplace_merge(
+                        values.begin() + bounds[begin],
+                        values.begin() + bounds[begin + width],
+                        values.begin() + bounds[end]);
+                });
+        }
+    }
+
+    // Write the scalars identifying an element of a vertex stream (for instance a vertex
+    // position followed by its poses) to a given address.
+    typedef std::function<void (size_t, GScalar*)> GatherFunction;
+
+    // Flattened copy of the elements of a vertex stream along with their hashes.
+    struct WeldKeys
+    {
+        size_t                      m_stride;           // number of scalars per element
+        std::vector<GScalar>        m_values;
+        std::vector<std::uint64_t>  m_hashes;
+
+        const GScalar* get(const size_t index) const
+        {
+            return &m_values[index * m_stride];
+        }
+    };
+
+    void gather_weld_keys(
+        const size_t                count,
+        const size_t                stride,
+        const GatherFunction&       gather,
+        WeldKeys&                   keys)
+    {
+        keys.m_stride = stride;
+        keys.m_values.resize(count * stride);
+        keys.m_hashes.resize(count);
+
+        for_each_range(
+            count,
+            [&gather, &keys, stride](const size_t begin, const size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    GScalar* values = &keys.m_values[i * stride];
+                    gather(i, values);
+
+                    MurmurHash hash;
+                    hash.append(values, stride * sizeof(GScalar));
+                    keys.m_hashes[i] = hash.h1();
+                }
+            });
+    }
+
+    // Find the unique elements of a vertex stream. Elements are compared bitwise.
+    // On return, remap[i] is the new index of element i, and the returned array
+    // holds the original index of each unique element, in increasing order.
+    std::vector<size_t> find_unique_elements(
+        const WeldKeys&             keys,
+        std::vector<std::uint32_t>& remap)
+    {
+        const size_t None = ~size_t(0);
+        const size_t count = keys.m_hashes.size();
+        const size_t key_size = keys.m_stride * sizeof(GScalar);
+
+        std::vector<size_t> sources;
+        std::vector<size_t> next;       // next unique element with the same hash
+        std::unordered_map<std::uint64_t, size_t> first;
+        first.reserve(count);
+
+        remap.resize(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const std::uint64_t hash = keys.m_hashes[i];
+            size_t match = None;
+            size_t last = None;
+
+            const auto it = first.find(hash);
+            if (it != first.end())
+            {
+                for (size_t j = it->second; j != None; j = next[j])
+                {
+                    if (std::memcmp(keys.get(sources[j]), keys.get(i), key_size) == 0)
+                    {
+                        match = j;
+                        break;
+                    }
+
+                    last = j;
+                }
+            }
+
+            if (match == None)
+            {
+                match = sources.size();
+                sources.push_back(i);
+                next.push_back(None);
+
+                if (last != None)
+                    next[last] = match;
+                else first.insert(std::make_pair(hash, match));
+            }
+
+            remap[i] = static_cast<std::uint32_t>(match);
+        }
+
+        return sources;
+    }
+
+    void remap_index(std::uint32_t& index, const std::vector<std::uint32_t>& remap)
+    {
+        if (index != Triangle::None)
+            index = remap[index];
+    }
+
+    // Remap the indices of the triangles of a mesh object. Null remapping tables leave the
+    // corresponding indices unchanged.
+    void remap_triangle_indices(
+        MeshObject&                         object,
+        const std::vector<std::uint32_t>*   vertex_remap,
+        const std::vector<std::uint32_t>*   normal_remap,
+        const std::vector<std::uint32_t>*   tex_coords_remap)
+    {
+        for_each_range(
+            object.get_triangle_count(),
+            [&](const size_t begin, const size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    Triangle& triangle = object.get_triangle(i);
+
+                    if (vertex_remap)
+                    {
+                        remap_index(triangle.m_v0, *vertex_remap);
+                        remap_index(triangle.m_v1, *vertex_remap);
+                        remap_index(triangle.m_v2, *vertex_remap);
+                    }
+
+                    if (normal_remap)
+                    {
+                        remap_index(triangle.m_n0, *normal_remap);
+                        remap_index(triangle.m_n1, *normal_remap);
+                        remap_index(triangle.m_n2, *normal_remap);
+                    }
+
+                    if (tex_coords_remap)
+                    {
+                        remap_index(triangle.m_a0, *tex_coords_remap);
+                        remap_index(triangle.m_a1, *tex_coords_remap);
+                        remap_index(triangle.m_a2, *tex_coords_remap);
+                    }
+                }
+            });
+    }
+
+    // Return the address of the scalars of a given element of a new vertex stream.
+    typedef std::function<const GScalar* (size_t)> ElementFunction;
+
+    // A per-vertex array of a mesh object, flattened together with the arrays that must
+    // be kept in sync with it: its poses and, for vertex positions, vertex tangents.
+    struct VertexStream
+    {
+        size_t                      m_count;
+        size_t                      m_stride;           // number of scalars per element
+        GatherFunction              m_gather;
+
+        // Replace the elements of the stream by a given number of new elements.
+        std::function<void (size_t, const ElementFunction&)> m_store;
+    };
+
+    // Vertex positions and their poses, followed by vertex tangents and their poses if the mesh has them.
+    VertexStream get_vertex_stream(MeshObject& object)
+    {
+        const size_t vertex_count = object.get_vertex_count();
+        const size_t motion_segment_count = object.get_motion_segment_count();
+        const size_t pose_count = 1 + motion_segment_count;
+        const bool has_tangents =
+            vertex_count > 0 && object.get_vertex_tangent_count() == vertex_count;
+
+        VertexStream stream;
+        stream.m_count = vertex_count;
+        stream.m_stride = 3 * pose_count * (has_tangents ? 2 : 1);
+
+        stream.m_gather =
+            [&object, motion_segment_count, has_tangents](const size_t index, GScalar* values)
+            {
+                GVector3* vectors = reinterpret_cast<GVector3*>(values);
+                *vectors++ = object.get_vertex(index);
+                for (size_t j = 0; j < motion_segment_count; ++j)
+                    *vectors++ = object.get_vertex_pose(index, j);
+
+                if (has_tangents)
+                {
+                    *vectors++ = object.get_vertex_tangent(index);
+                    for (size_t j = 0; j < motion_segment_count; ++j)
+                        *vectors++ = object.get_vertex_tangent_pose(index, j);
+                }
+            };
+
+        stream.m_store =
+            [&object, motion_segment_count, pose_count, has_tangents](const size_t count, const ElementFunction& element)
+            {
+                if (has_tangents)
+                {
+                    object.clear_vertex_tangent_poses();
+                    object.clear_vertex_tangents();
+                }
+
+                object.clear_vertices();
+                object.reserve_vertices(count);
+
+                for (size_t i = 0; i < count; ++i)
+                    object.push_vertex(reinterpret_cast<const GVector3*>(element(i))[0]);
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const GVector3* poses = reinterpret_cast<const GVector3*>(element(i)) + 1;
+                    for (size_t j = 0; j < motion_segment_count; ++j)
+                        object.set_vertex_pose(i, j, poses[j]);
+                }
+
+                if (has_tangents)
+                {
+                    object.reserve_vertex_tangents(count);
+
+                    for (size_t i = 0; i < count; ++i)
+                        object.push_vertex_tangent(reinterpret_cast<const GVector3*>(element(i))[pose_count]);
+
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        const GVector3* poses = reinterpret_cast<const GVector3*>(element(i)) + pose_count + 1;
+                        for (size_t j = 0; j < motion_segment_count; ++j)
+                            object.set_vertex_tangent_pose(i, j, poses[j]);
+                    }
+                }
+            };
+
+        return stream;
+    }
+
+    // Vertex normals and their poses.
+    VertexStream get_vertex_normal_stream(MeshObject& object)
+    {
+        const size_t motion_segment_count = object.get_motion_segment_count();
+
+        VertexStream stream;
+        stream.m_count = object.get_vertex_normal_count();
+        stream.m_stride = 3 * (1 + motion_segment_count);
+
+        stream.m_gather =
+            [&object, motion_segment_count](const size_t index, GScalar* values)
+            {
+                GVector3* vectors = reinterpret_cast<GVector3*>(values);
+                *vectors++ = object.get_vertex_normal(index);
+                for (size_t j = 0; j < motion_segment_count; ++j)
+                    *vectors++ = object.get_vertex_normal_pose(index, j);
+            };
+
+        stream.m_store =
+            [&object, motion_segment_count](const size_t count, const ElementFunction& element)
+            {
+                object.clear_vertex_normal_poses();
+                object.clear_vertex_normals();
+                object.reserve_vertex_normals(count);
+
+                for (size_t i = 0; i < count; ++i)
+                    object.push_vertex_normal(reinterpret_cast<const GVector3*>(element(i))[0]);
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const GVector3* poses = reinterpret_cast<const GVector3*>(element(i)) + 1;
+                    for (size_t j = 0; j < motion_segment_count; ++j)
+                        object.set_vertex_normal_pose(i, j, poses[j]);
+                }
+            };
+
+        return stream;
+    }
+
+    // Texture coordinates.
+    VertexStream get_tex_coords_stream(MeshObject& object)
+    {
+        VertexStream stream;
+        stream.m_count = object.get_tex_coords_count();
+        stream.m_stride = 2;
+
+        stream.m_gather =
+            [&object](const size_t index, GScalar* values)
+            {
+                *reinterpret_cast<GVector2*>(values) = object.get_tex_coords(index);
+            };
+
+        stream.m_store =
+            [&object](const size_t count, const ElementFunction& element)
+            {
+                object.clear_tex_coords();
+                object.reserve_tex_coords(count);
+
+                for (size_t i = 0; i < count; ++i)
+                    object.push_tex_coords(*reinterpret_cast<const GVector2*>(element(i)));
+            };
+
+        return stream;
+    }
+
+    // Deduplicate the elements of a vertex stream.
+    bool weld_stream(const VertexStream& stream, std::vector<std::uint32_t>& remap)
+    {
+        WeldKeys keys;
+        gather_weld_keys(stream.m_count, stream.m_stride, stream.m_gather, keys);
+
+        const std::vector<size_t> sources = find_unique_elements(keys, remap);
+
+        if (sources.size() == stream.m_count)
+            return false;
+
+        stream.m_store(
+            sources.size(),
+            [&keys, &sources](const size_t index)
+            {
+                return keys.get(sources[index]);
+            });
+
+        return true;
+    }
+
+    // Reorder the elements of a vertex stream: element i of the result is element sources[i].
+    void permute_stream(const VertexStream& stream, const std::vector<std::uint32_t>& sources)
+    {
+        assert(sources.size() == stream.m_count);
+
+        const size_t stride = stream.m_stride;
+        std::vector<GScalar> values(stream.m_count * stride);
+
+        for_each_range(
+            stream.m_count,
+            [&stream, &sources, &values, stride](const size_t begin, const size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                    stream.m_gather(sources[i], &values[i * stride]);
+            });
+
+        stream.m_store(
+            stream.m_count,
+            [&values, stride](const size_t index)
+            {
+                return &values[index * stride];
+            });
+    }
+
+    // Spread the 21 low bits of an integer so that two zero bits separate consecutive bits.
+    std::uint64_t spread_bits(std::uint64_t x)
+    {
+        x &= 0x1FFFFF;
+        x = (x | x << 32) & 0x001F00000000FFFFULL;
+        x = (x | x << 16) & 0x001F0000FF0000FFULL;
+        x = (x | x << 8)  & 0x100F00F00F00F00FULL;
+        x = (x | x << 4)  & 0x10C30C30C30C30C3ULL;
+        x = (x | x << 2)  & 0x1249249249249249ULL;
+        return x;
+    }
+
+    // Return the triangles of a mesh object in the order of the 63-bit Morton codes of their
+    // centroids in the base pose, quantized over the bounding box of the mesh. Ties are broken
+    // by triangle index so that the order is deterministic.
+    std::vector<std::uint32_t> sort_triangles_along_morton_curve(const MeshObject& object)
+    {
+        const size_t triangle_count = object.get_triangle_count();
+
+        GAABB3 bbox;
+        bbox.invalidate();
+
+        for (size_t i = 0, e = object.get_vertex_count(); i < e; ++i)
+            bbox.insert(object.get_vertex(i));
+
+        const GScalar MaxCoordinate = GScalar((1UL << 21) - 1);
+        const GVector3 extent = bbox.extent();
+
+        GVector3 scale;
+        for (size_t i = 0; i < 3; ++i)
+            scale[i] = extent[i] > GScalar(0.0) ? MaxCoordinate / extent[i] : GScalar(0.0);
+
+        typedef std::pair<std::uint64_t, std::uint32_t> SortKey;
+        std::vector<SortKey> keys(triangle_count);
+
+        for_each_range(
+            triangle_count,
+            [&object, &bbox, &scale, &keys, MaxCoordinate](const size_t begin, const size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const Triangle& triangle = object.get_triangle(i);
+                    const GVector3 centroid =
+                        (object.get_vertex(triangle.m_v0) +
+                         object.get_vertex(triangle.m_v1) +
+                         object.get_vertex(triangle.m_v2)) / GScalar(3.0);
+
+                    std::uint64_t code = 0;
+
+                    for (size_t j = 0; j < 3; ++j)
+                    {
+                        const GScalar x =
+                            clamp((centroid[j] - bbox.min[j]) * scale[j], GScalar(0.0), MaxCoordinate);
+                        code |= spread_bits(truncate<std::uint64_t>(x)) << (2 - j);
+                    }
+
+                    keys[i] = SortKey(code, static_cast<std::uint32_t>(i));
+                }
+            });
+
+        sort_in_parallel(keys);
+
+        std::vector<std::uint32_t> order(triangle_count);
+
+        for (size_t i = 0; i < triangle_count; ++i)
+            order[i] = keys[i].second;
+
+        return order;
+    }
+
+    typedef std::uint32_t Triangle::* const TriangleIndices[3];
+
+    // Number the elements of a vertex stream in the order in which the triangles of a mesh
+    // object first reference them; unreferenced elements go last, in their original order.
+    // On return, remap[i] is the new index of element i and sources[i] is the original index
+    // of the i'th element. Return false if the order is unchanged.
+    bool order_by_first_use(
+        const MeshObject&           object,
+        const size_t                count,
+        const TriangleIndices&      indices,
+        std::vector<std::uint32_t>& remap,
+        std::vector<std::uint32_t>& sources)
+    {
+        const std::uint32_t Unassigned = ~std::uint32_t(0);
+
+        remap.assign(count, Unassigned);
+        sources.clear();
+        sources.reserve(count);
+
+        for (size_t i = 0, e = object.get_triangle_count(); i < e; ++i)
+        {
+            const Triangle& triangle = object.get_triangle(i);
+
+            for (size_t j = 0; j < 3; ++j)
+            {
+                const std::uint32_t index = triangle.*indices[j];
+
+                if (index != Triangle::None && remap[index] == Unassigned)
+                {
+                    remap[index] = static_cast<std::uint32_t>(sources.size());
+                    sources.push_back(index);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (remap[i] == Unassigned)
+            {
+                remap[i] = static_cast<std::uint32_t>(sources.size());
+                sources.push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (remap[i] != i)
+                return true;
+        }
+
+        return false;
+    }
 }
 
-void compute_smooth_vertex_tangents_pose(MeshObject& object, const size_t motion_segment_index)
+void compute_smooth_vertex_normals_base_pose(MeshObject& object)
 {
-    assert(object.get_tex_coords_count() > 0);
+    assert(object.get_vertex_normal_count() == 0);
 
     const size_t vertex_count = object.get_vertex_count();
     const size_t triangle_count = object.get_triangle_count();
 
-    std::vector<GVector3> tangents(vertex_count, GVector3(0.0));
+    const std::vector<GVector3> normals =
+        accumulate_over_triangles(
+            triangle_count,
+            vertex_count,
+            [&object](const size_t begin, const size_t end, std::vector<GVector3>& sums)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    Triangle& triangle = object.get_triangle(i);
+                    triangle.m_n0 = triangle.m_v0;
+                    triangle.m_n1 = triangle.m_v1;
+                    triangle.m_n2 = triangle.m_v2;
+
+                    accumulate_triangle_normal(
+                        triangle,
+                        object.get_vertex(triangle.m_v0),
+                        object.get_vertex(triangle.m_v1),
+                        object.get_vertex(triangle.m_v2),
+                        sums);
+                }
+            });
 
-    for (size_t i = 0; i < triangle_count; ++i)
-    {
-        const Triangle& triangle = object.get_triangle(i);
+    object.reserve_vertex_normals(vertex_count);
 
-        if (!triangle.has_vertex_attributes())
-            continue;
+    for (size_t i = 0; i < vertex_count; ++i)
+        object.push_vertex_normal(safe_normalize(normals[i]));
+}
 
-        const GVector2 v0_uv = object.get_tex_coords(triangle.m_a0);
-        const GVector2 v1_uv = object.get_tex_coords(triangle.m_a1);
-        const GVector2 v2_uv = object.get_tex_coords(triangle.m_a2);
+void compute_smooth_vertex_normals_pose(MeshObject& object, const size_t motion_segment_index)
+{
+    const size_t vertex_count = object.get_vertex_count();
+    const size_t triangle_count = object.get_triangle_count();
 
-        //
-        // Reference:
-        //
-        //   Physically Based Rendering, first edition, pp. 128-129
-        //
+    const std::vector<GVector3> normals =
+        accumulate_over_triangles(
+            triangle_count,
+            vertex_count,
+            [&object, motion_segment_index](const size_t begin, const size_t end, std::vector<GVector3>& sums)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const Triangle& triangle = object.get_triangle(i);
+
+                    accumulate_triangle_normal(
+                        triangle,
+                        object.get_vertex_pose(triangle.m_v0, motion_segment_index),
+                        object.get_vertex_pose(triangle.m_v1, motion_segment_index),
+                        object.get_vertex_pose(triangle.m_v2, motion_segment_index),
+                        sums);
+                }
+            });
 
-        const GScalar du0 = v0_uv[0] - v2_uv[0];
-        const GScalar dv0 = v0_uv[1] - v2_uv[1];
-        const GScalar du1 = v1_uv[0] - v2_uv[0];
-        const GScalar dv1 = v1_uv[1] - v2_uv[1];
-        const GScalar det = dv1 * du0 - dv0 * du1;
+    for (size_t i = 0; i < vertex_count; ++i)
+        object.set_vertex_normal_pose(i, motion_segment_index, safe_normalize(normals[i]));
+}
 
-        if (det == GScalar(0.0))
-            continue;
+void compute_smooth_vertex_normals(MeshObject& object)
+{
+    compute_smooth_vertex_normals_base_pose(object);
 
-        const GVector3& v2 = object.get_vertex_pose(triangle.m_v2, motion_segment_index);
-        const GVector3 dp0 = object.get_vertex_pose(triangle.m_v0, motion_segment_index) - v2;
-        const GVector3 dp1 = object.get_vertex_pose(triangle.m_v1, motion_segment_index) - v2;
+    for (size_t i = 0, e = object.get_motion_segment_count(); i < e; ++i)
+        compute_smooth_vertex_normals_pose(object, i);
+}
 
-        GVector3 tangent = dv1 * dp0 - dv0 * dp1;
-        const GScalar tangent_norm = norm(tangent);
+void compute_smooth_vertex_tangents_base_pose(MeshObject& object)
+{
+    assert(object.get_vertex_tangent_count() == 0);
+    assert(object.get_tex_coords_count() > 0);
 
-        if (tangent_norm == GScalar(0.0))
-            continue;
+    const size_t vertex_count = object.get_vertex_count();
+    const size_t triangle_count = object.get_triangle_count();
 
-        tangent /= tangent_norm;
-        tangents[triangle.m_v0] += tangent;
-        tangents[triangle.m_v1] += tangent;
-        tangents[triangle.m_v2] += tangent;
-    }
+    const std::vector<GVector3> tangents =
+        accumulate_over_triangles(
+            triangle_count,
+            vertex_count,
+            [&object](const size_t begin, const size_t end, std::vector<GVector3>& sums)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const Triangle& triangle = object.get_triangle(i);
+
+                    accumulate_triangle_tangent(
+                        object,
+                        triangle,
+                        object.get_vertex(triangle.m_v0),
+                        object.get_vertex(triangle.m_v1),
+                        object.get_vertex(triangle.m_v2),
+                        sums);
+                }
+            });
+
+    object.reserve_vertex_tangents(vertex_count);
+
+    for (size_t i = 0; i < vertex_count; ++i)
+        object.push_vertex_tangent(safe_normalize(tangents[i]));
+}
+
+void compute_smooth_vertex_tangents_pose(MeshObject& object, const size_t motion_segment_index)
+{
+    assert(object.get_tex_coords_count() > 0);
+
+    const size_t vertex_count = object.get_vertex_count();
+    const size_t triangle_count = object.get_triangle_count();
+
+    const std::vector<GVector3> tangents =
+        accumulate_over_triangles(
+            triangle_count,
+            vertex_count,
+            [&object, motion_segment_index](const size_t begin, const size_t end, std::vector<GVector3>& sums)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const Triangle& triangle = object.get_triangle(i);
+
+                    accumulate_triangle_tangent(
+                        object,
+                        triangle,
+                        object.get_vertex_pose(triangle.m_v0, motion_segment_index),
+                        object.get_vertex_pose(triangle.m_v1, motion_segment_index),
+                        object.get_vertex_pose(triangle.m_v2, motion_segment_index),
+                        sums);
+                }
+            });
 
     for (size_t i = 0; i < vertex_count; ++i)
         object.set_vertex_tangent_pose(i, motion_segment_index, safe_normalize(tangents[i]));
@@ -247,6 +948,87 @@ void compute_smooth_vertex_tangents(MeshObject& object)
         compute_smooth_vertex_tangents_pose(object, i);
 }
 
+void weld_vertices(MeshObject& object)
+{
+    std::vector<std::uint32_t> vertex_remap;
+    const bool welded_vertices = weld_stream(get_vertex_stream(object), vertex_remap);
+
+    std::vector<std::uint32_t> normal_remap;
+    const bool welded_normals = weld_stream(get_vertex_normal_stream(object), normal_remap);
+
+    std::vector<std::uint32_t> tex_coords_remap;
+    const bool welded_tex_coords = weld_stream(get_tex_coords_stream(object), tex_coords_remap);
+
+    if (!welded_vertices && !welded_normals && !welded_tex_coords)
+        return;
+
+    remap_triangle_indices(
+        object,
+        welded_vertices ? &vertex_remap : nullptr,
+        welded_normals ? &normal_remap : nullptr,
+        welded_tex_coords ? &tex_coords_remap : nullptr);
+}
+
+void reorder_spatially(MeshObject& object)
+{
+    const size_t triangle_count = object.get_triangle_count();
+
+    // Sort triangles along a Morton curve.
+    const std::vector<std::uint32_t> order = sort_triangles_along_morton_curve(object);
+    std::vector<Triangle> triangles(triangle_count);
+
+    for_each_range(
+        triangle_count,
+        [&object, &order, &triangles](const size_t begin, const size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                triangles[i] = object.get_triangle(order[i]);
+        });
+
+    for_each_range(
+        triangle_count,
+        [&object, &triangles](const size_t begin, const size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+                object.get_triangle(i) = triangles[i];
+        });
+
+    // Renumber vertex streams in the order in which the sorted triangles use them.
+    static const TriangleIndices VertexIndices = { &Triangle::m_v0, &Triangle::m_v1, &Triangle::m_v2 };
+    static const TriangleIndices NormalIndices = { &Triangle::m_n0, &Triangle::m_n1, &Triangle::m_n2 };
+    static const TriangleIndices TexCoordsIndices = { &Triangle::m_a0, &Triangle::m_a1, &Triangle::m_a2 };
+
+    std::vector<std::uint32_t> vertex_remap, vertex_sources;
+    const bool reordered_vertices =
+        order_by_first_use(object, object.get_vertex_count(), VertexIndices, vertex_remap, vertex_sources);
+
+    std::vector<std::uint32_t> normal_remap, normal_sources;
+    const bool reordered_normals =
+        order_by_first_use(object, object.get_vertex_normal_count(), NormalIndices, normal_remap, normal_sources);
+
+    std::vector<std::uint32_t> tex_coords_remap, tex_coords_sources;
+    const bool reordered_tex_coords =
+        order_by_first_use(object, object.get_tex_coords_count(), TexCoordsIndices, tex_coords_remap, tex_coords_sources);
+
+    if (reordered_vertices)
+        permute_stream(get_vertex_stream(object), vertex_sources);
+
+    if (reordered_normals)
+        permute_stream(get_vertex_normal_stream(object), normal_sources);
+
+    if (reordered_tex_coords)
+        permute_stream(get_tex_coords_stream(object), tex_coords_sources);
+
+    if (!reordered_vertices && !reordered_normals && !reordered_tex_coords)
+        return;
+
+    remap_triangle_indices(
+        object,
+        reordered_vertices ? &vertex_remap : nullptr,
+        reordered_normals ? &normal_remap : nullptr,
+        reordered_tex_coords ? &tex_coords_remap : nullptr);
+}
+
 void compute_signature(MurmurHash& hash, const MeshObject& object)
 {
     // Static attributes.
@@ -47,6 +47,18 @@ APPLESEED_DLLSYMBOL void compute_smooth_vertex_normals(MeshObject& object);
 // The mesh object must have texture coordinates.
 APPLESEED_DLLSYMBOL void compute_smooth_vertex_tangents(MeshObject& object);
 
+// Merge the vertices, vertex normals and texture coordinates of a mesh object that
+// are exact duplicates of each other, and remap the triangles accordingly. Vertex
+// tangents and poses are taken into account: vertices only merge if they match
+// over the whole shutter interval.
+APPLESEED_DLLSYMBOL void weld_vertices(MeshObject& object);
+
+// Improve the memory locality of a mesh object: sort its triangles along a Morton curve
+// through their centroids, then renumber vertices, vertex normals and texture coordinates
+// in the order in which the sorted triangles first use them. Tangents and poses follow
+// their vertices. The geometry of the mesh is unchanged.
+APPLESEED_DLLSYMBOL void reorder_spatially(MeshObject& object);
+
 // Compute a hash for a mesh object.
 APPLESEED_DLLSYMBOL void compute_signature(foundation::MurmurHash& hash, const MeshObject& object);
 
@@ -138,6 +138,21 @@ namespace
             reset_mesh_stats();
         }
 
+        void reserve_mesh(
+            const size_t        vertex_count,
+            const size_t        vertex_normal_count,
+            const size_t        tex_coords_count,
+            const size_t        face_count) override
+        {
+            MeshObject* object = m_objects.back();
+            object->reserve_vertices(vertex_count);
+            object->reserve_vertex_normals(vertex_normal_count);
+            object->reserve_tex_coords(tex_coords_count);
+
+            // Polygonal faces yield more than one triangle, this is only a lower bound.
+            object->reserve_triangles(face_count);
+        }
+
         void end_mesh() override
         {
             // Print the number of faces that could not be triangulated, if any.
@@ -427,6 +442,12 @@ namespace
                 reader.get_obj_options() | OBJMeshFileReader::FavorSpeedOverPrecision);
         }
 
+        if (params.get_optional<bool>("obj_parallel_parsing", false))
+        {
+            reader.set_obj_options(
+                reader.get_obj_options() | OBJMeshFileReader::ParallelParsing);
+        }
+
         MeshObjectBuilder builder(params, base_object_name);
 
         Stopwatch<DefaultWallclockTimer> stopwatch;
@@ -767,6 +788,37 @@ namespace
         return true;
     }
 
+    void weld_duplicate_vertices(MeshObject& object)
+    {
+        const size_t vertex_count = object.get_vertex_count();
+        const size_t normal_count = object.get_vertex_normal_count();
+        const size_t tex_coords_count = object.get_tex_coords_count();
+        const size_t memory_size = object.get_static_triangle_tess().get_memory_size();
+
+        weld_vertices(object);
+
+        const size_t welded_memory_size = object.get_static_triangle_tess().get_memory_size();
+
+        RENDERER_LOG_INFO(
+            "welded mesh object \"%s\": removed %s vertices, %s vertex normals and %s texture coordinates, saved %s.",
+            object.get_path().c_str(),
+            pretty_uint(vertex_count - object.get_vertex_count()).c_str(),
+            pretty_uint(normal_count - object.get_vertex_normal_count()).c_str(),
+            pretty_uint(tex_coords_count - object.get_tex_coords_count()).c_str(),
+            pretty_size(memory_size > welded_memory_size ? memory_size - welded_memory_size : 0).c_str());
+    }
+
+    void reorder_mesh_spatially(MeshObject& object)
+    {
+        RENDERER_LOG_INFO(
+            "spatially reordering mesh object \"%s\" (%s %s)...",
+            object.get_path().c_str(),
+            pretty_uint(object.get_triangle_count()).c_str(),
+            plural(object.get_triangle_count(), "triangle").c_str());
+
+        reorder_spatially(object);
+    }
+
     void compute_smooth_normals(MeshObject& object)
     {
         if (object.get_vertex_normal_count() > 0)
@@ -890,6 +942,18 @@ bool MeshObjectReader::read(
         }
     }
 
+    // Weld duplicate vertices.
+    if (params.strings().exist("weld_vertices"))
+    {
+        const RegExFilter filter(params.get("weld_vertices"));
+        for (size_t i = 0, e = objects.size(); i < e; ++i)
+        {
+            MeshObject& object = *objects[i];
+            if (filter.accepts(object.get_name()))
+                weld_duplicate_vertices(object);
+        }
+    }
+
     // Compute smooth normals.
     if (params.strings().exist("compute_smooth_normals"))
     {
@@ -914,6 +978,18 @@ bool MeshObjectReader::read(
         }
     }
 
+    // Reorder triangles and vertices for memory locality, once all vertex streams exist.
+    if (params.strings().exist("reorder_spatially"))
+    {
+        const RegExFilter filter(params.get("reorder_spatially"));
+        for (size_t i = 0, e = objects.size(); i < e; ++i)
+        {
+            MeshObject& object = *objects[i];
+            if (filter.accepts(object.get_name()))
+                reorder_mesh_spatially(object);
+        }
+    }
+
     return true;
 }
 
@@ -169,7 +169,8 @@ namespace
 bool MeshObjectWriter::write(
     const MeshObject&   object,
     const char*         object_name,
-    const char*         filename)
+    const char*         filename,
+    const size_t        thread_count)
 {
     assert(filename);
 
@@ -178,7 +179,7 @@ bool MeshObjectWriter::write(
 
     try
     {
-        GenericMeshFileWriter writer(filename);
+        GenericMeshFileWriter writer(filename, thread_count);
         MeshObjectWalker walker(object, object_name);
         writer.write(walker);
     }
@@ -32,6 +32,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace renderer  { class MeshObject; }
 
@@ -45,12 +48,13 @@ namespace renderer
 class APPLESEED_DLLSYMBOL MeshObjectWriter
 {
   public:
-    // Write a mesh object to disk.
+    // Write a mesh object to disk, compressing it using thread_count threads (0 for one per core).
     // Return true on success, false otherwise.
     static bool write(
         const MeshObject&   object,
         const char*         object_name,
-        const char*         filename);
+        const char*         filename,
+        const std::size_t   thread_count = 0);
 };
 
 }   // namespace renderer
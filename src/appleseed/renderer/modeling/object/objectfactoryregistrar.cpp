@@ -33,8 +33,10 @@
 #include "renderer/modeling/entity/entityfactoryregistrar.h"
 #include "renderer/modeling/object/curveobject.h"
 #include "renderer/modeling/object/diskobject.h"
+#include "renderer/modeling/object/displacedsubdivisionobject.h"
 #include "renderer/modeling/object/meshobject.h"
 #include "renderer/modeling/object/objecttraits.h"
+#include "renderer/modeling/object/particlesetobject.h"
 #include "renderer/modeling/object/rectangleobject.h"
 #include "renderer/modeling/object/sphereobject.h"
 
@@ -63,7 +65,9 @@ ObjectFactoryRegistrar::ObjectFactoryRegistrar(const SearchPaths& search_paths)
     // Register built-in factories.
     impl->register_factory(auto_release_ptr<FactoryType>(new CurveObjectFactory()));
     impl->register_factory(auto_release_ptr<FactoryType>(new DiskObjectFactory()));
+    impl->register_factory(auto_release_ptr<FactoryType>(new DisplacedSubdivisionObjectFactory()));
     impl->register_factory(auto_release_ptr<FactoryType>(new MeshObjectFactory()));
+    impl->register_factory(auto_release_ptr<FactoryType>(new ParticleSetObjectFactory()));
     impl->register_factory(auto_release_ptr<FactoryType>(new RectangleObjectFactory()));
     impl->register_factory(auto_release_ptr<FactoryType>(new SphereObjectFactory()));
 }
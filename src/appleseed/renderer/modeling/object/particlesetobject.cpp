@@ -0,0 +1,711 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// interface header.
+#include "particlesetobject.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/kernel/intersection/refining.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/utility/messagecontext.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/containers/alignedvector.h"
+#include "foundation/containers/dictionary.h"
+#include "foundation/containers/soavector.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/basis.h"
+#include "foundation/math/bvh.h"
+#include "foundation/math/intersection/raydisk.h"
+#include "foundation/math/intersection/raysphere.h"
+#include "foundation/math/ray.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/job/iabortswitch.h"
+#include "foundation/utility/makevector.h"
+#include "foundation/utility/searchpaths.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// ParticleSetObject class implementation.
+//
+
+namespace
+{
+    const char* Model = "particle_set_object";
+
+    // Maximum number of particles per leaf, tested simultaneously.
+    const size_t MaxParticlesPerLeaf = 8;
+
+    enum ParticleShape
+    {
+        ParticleShapeSphere,
+        ParticleShapeDisk
+    };
+
+    enum ParticleField
+    {
+        CenterX, CenterY, CenterZ,
+        NormalX, NormalY, NormalZ,
+        Radius
+    };
+
+    typedef SoAVector<float, float, float, float, float, float, float> ParticleVector;
+
+    typedef bvh::Node<AABB3f> ParticleNode;
+    typedef AlignedVector<ParticleNode> ParticleNodeVector;
+
+    class ParticleTree
+      : public bvh::Tree<ParticleNodeVector>
+    {
+      public:
+        const ParticleNodeVector& get_nodes() const
+        {
+            return m_nodes;
+        }
+    };
+
+    AABB3f compute_particle_bbox(
+        const ParticleVector&   particles,
+        const ParticleShape     shape,
+        const size_t            index)
+    {
+        const Vector3f center(
+            particles.get<CenterX>(index),
+            particles.get<CenterY>(index),
+            particles.get<CenterZ>(index));
+        const float radius = particles.get<Radius>(index);
+
+        if (shape == ParticleShapeSphere)
+            return AABB3f(center - Vector3f(radius), center + Vector3f(radius));
+
+        // Tight bounding box of a disk: its extent along axis i is radius * sqrt(1 - n_i^2).
+        const Vector3f n(
+            particles.get<NormalX>(index),
+            particles.get<NormalY>(index),
+            particles.get<NormalZ>(index));
+        const Vector3f extent(
+            radius * std::sqrt(std::max(1.0f - n.x * n.x, 0.0f)),
+            radius * std::sqrt(std::max(1.0f - n.y * n.y, 0.0f)),
+            radius * std::sqrt(std::max(1.0f - n.z * n.z, 0.0f)));
+        return AABB3f(center - extent, center + extent);
+    }
+
+    // Intersect a ray with the particles [begin, begin + count), 8 at a time.
+    // Return the index of the closest hit particle or ~size_t(0).
+    size_t intersect_particles(
+        const ParticleVector&   particles,
+        const ParticleShape     shape,
+        Ray3f&                  ray,
+        const size_t            begin,
+        const size_t            count)
+    {
+        size_t closest_index = ~size_t(0);
+
+        for (size_t i = begin, e = begin + count; i < e; i += MaxParticlesPerLeaf)
+        {
+            const size_t n = std::min(e - i, MaxParticlesPerLeaf);
+
+            float t;
+            const size_t hit_index =
+                shape == ParticleShapeSphere
+                    ? intersect_spheres_x8(
+                          ray,
+                          particles.column<CenterX>() + i,
+                          particles.column<CenterY>() + i,
+                          particles.column<CenterZ>() + i,
+                          particles.column<Radius>() + i,
+                          n,
+                          t)
+                    : intersect_disks_x8(
+                          ray,
+                          particles.column<CenterX>() + i,
+                          particles.column<CenterY>() + i,
+                          particles.column<CenterZ>() + i,
+                          particles.column<NormalX>() + i,
+                          particles.column<NormalY>() + i,
+                          particles.column<NormalZ>() + i,
+                          particles.column<Radius>() + i,
+                          n,
+                          t);
+
+            if (hit_index != ~size_t(0))
+            {
+                ray.m_tmax = t;
+                closest_index = i + hit_index;
+            }
+        }
+
+        return closest_index;
+    }
+
+    class ParticleLeafVisitor
+      : public NonCopyable
+    {
+      public:
+        ParticleLeafVisitor(
+            const ParticleVector&   particles,
+            const ParticleShape     shape,
+            Ray3f&                  ray,
+            const bool              closest_hit)
+          : m_particles(particles)
+          , m_shape(shape)
+          , m_ray(ray)
+          , m_closest_hit(closest_hit)
+          , m_hit_index(~size_t(0))
+        {
+        }
+
+        bool visit(
+            const ParticleNode&     node,
+            const Ray3f&            ray,
+            const RayInfo3f&        ray_info,
+            float&                  distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            const size_t hit_index =
+                intersect_particles(
+                    m_particles,
+                    m_shape,
+                    m_ray,
+                    node.get_item_index(),
+                    node.get_item_count());
+
+            if (hit_index != ~size_t(0))
+            {
+                m_hit_index = hit_index;
+                distance = m_ray.m_tmax;
+
+                // Stop traversal at the first hit for occlusion queries.
+                if (!m_closest_hit)
+                    return false;
+            }
+
+            return true;
+        }
+
+        size_t get_hit_index() const
+        {
+            return m_hit_index;
+        }
+
+      private:
+        const ParticleVector&       m_particles;
+        const ParticleShape         m_shape;
+        Ray3f&                      m_ray;
+        const bool                  m_closest_hit;
+        size_t                      m_hit_index;
+    };
+
+    typedef bvh::Intersector<
+        ParticleTree,
+        ParticleLeafVisitor,
+        Ray3f
+    > ParticleTreeIntersector;
+}
+
+struct ParticleSetObject::Impl
+{
+    ParticleShape       m_shape;
+    ParticleVector      m_particles;
+    ParticleTree        m_tree;
+    bool                m_tree_is_dirty;
+
+    Impl()
+      : m_shape(ParticleShapeSphere)
+      , m_tree_is_dirty(true)
+    {
+    }
+
+    size_t intersect(Ray3f& ray, const bool closest_hit) const
+    {
+        if (m_particles.empty())
+            return ~size_t(0);
+
+        assert(!m_tree_is_dirty);
+
+        ParticleLeafVisitor visitor(m_particles, m_shape, ray, closest_hit);
+        ParticleTreeIntersector intersector;
+        intersector.intersect_no_motion(
+            m_tree,
+            ray,
+            RayInfo3f(ray),
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics()
+#endif
+            );
+
+        return visitor.get_hit_index();
+    }
+
+    // Find the particle whose surface is the closest to a given point.
+    size_t find_closest_particle(const Vector3f& p) const
+    {
+        const ParticleNodeVector& nodes = m_tree.get_nodes();
+
+        size_t closest_index = ~size_t(0);
+        float closest_distance = std::numeric_limits<float>::max();
+
+        size_t stack[64];
+        size_t stack_size = 0;
+        stack[stack_size++] = 0;
+
+        while (stack_size > 0)
+        {
+            const ParticleNode& node = nodes[stack[--stack_size]];
+
+            if (node.is_interior())
+            {
+                // Points on the surface of particles lie on the boundary of their bounding box.
+                const size_t child = node.get_child_node_index();
+                if (contains_with_tolerance(node.get_left_bbox(), p) && stack_size < 64)
+                    stack[stack_size++] = child;
+                if (contains_with_tolerance(node.get_right_bbox(), p) && stack_size < 64)
+                    stack[stack_size++] = child + 1;
+            }
+            else
+            {
+                for (size_t i = node.get_item_index(), e = i + node.get_item_count(); i < e; ++i)
+                {
+                    const float d = std::abs(compute_surface_distance(i, p));
+                    if (closest_distance > d)
+                    {
+                        closest_distance = d;
+                        closest_index = i;
+                    }
+                }
+            }
+        }
+
+        return closest_index;
+    }
+
+    static bool contains_with_tolerance(const AABB3f& bbox, const Vector3f& p)
+    {
+        const float eps = 1.0e-4f * max_value(bbox.extent()) + 1.0e-6f;
+        return AABB3f(bbox.min - Vector3f(eps), bbox.max + Vector3f(eps)).contains(p);
+    }
+
+    Vector3f get_center(const size_t index) const
+    {
+        return Vector3f(
+            m_particles.get<CenterX>(index),
+            m_particles.get<CenterY>(index),
+            m_particles.get<CenterZ>(index));
+    }
+
+    Vector3f get_normal(const size_t index) const
+    {
+        return Vector3f(
+            m_particles.get<NormalX>(index),
+            m_particles.get<NormalY>(index),
+            m_particles.get<NormalZ>(index));
+    }
+
+    // Signed distance from a point to the surface of a particle, along its normal.
+    float compute_surface_distance(const size_t index, const Vector3f& p) const
+    {
+        const Vector3f v = p - get_center(index);
+        const float radius = m_particles.get<Radius>(index);
+
+        if (m_shape == ParticleShapeSphere)
+            return norm(v) - radius;
+
+        const float d = dot(v, get_normal(index));
+        const float r = norm(v - d * get_normal(index));
+        return r > radius ? d + (r - radius) : d;
+    }
+
+    void build_tree()
+    {
+        const size_t particle_count = m_particles.size();
+
+        m_tree.clear();
+
+        if (particle_count > 0)
+        {
+            std::vector<AABB3f> bboxes(particle_count);
+            for (size_t i = 0; i < particle_count; ++i)
+                bboxes[i] = compute_particle_bbox(m_particles, m_shape, i);
+
+            typedef bvh::SAHPartitioner<std::vector<AABB3f>> Partitioner;
+            typedef bvh::Builder<ParticleTree, Partitioner> Builder;
+
+            Partitioner partitioner(bboxes, MaxParticlesPerLeaf);
+            Builder builder;
+            builder.build<DefaultWallclockTimer>(
+                m_tree,
+                partitioner,
+                particle_count,
+                MaxParticlesPerLeaf,
+                System::get_logical_cpu_core_count());
+
+            // Store the particles in the order of the leaves of the tree.
+            const std::vector<size_t>& ordering = partitioner.get_item_ordering();
+            ParticleVector ordered_particles;
+            ordered_particles.reserve(particle_count);
+            for (size_t i = 0; i < particle_count; ++i)
+            {
+                const size_t j = ordering[i];
+                ordered_particles.push_back(
+                    m_particles.get<CenterX>(j),
+                    m_particles.get<CenterY>(j),
+                    m_particles.get<CenterZ>(j),
+                    m_particles.get<NormalX>(j),
+                    m_particles.get<NormalY>(j),
+                    m_particles.get<NormalZ>(j),
+                    m_particles.get<Radius>(j));
+            }
+            m_particles.swap(ordered_particles);
+
+            RENDERER_LOG_DEBUG(
+                "built particle tree of %s %s in %s.",
+                pretty_uint(particle_count).c_str(),
+                particle_count > 1 ? "particles" : "particle",
+                pretty_time(builder.get_build_time()).c_str());
+        }
+
+        m_tree_is_dirty = false;
+    }
+};
+
+ParticleSetObject::ParticleSetObject(
+    const char*            name,
+    const ParamArray&      params)
+  : ProceduralObject(name, params)
+  , impl(new Impl())
+{
+}
+
+ParticleSetObject::~ParticleSetObject()
+{
+    delete impl;
+}
+
+void ParticleSetObject::release()
+{
+    delete this;
+}
+
+const char* ParticleSetObject::get_model() const
+{
+    return Model;
+}
+
+bool ParticleSetObject::on_frame_begin(
+    const Project&         project,
+    const BaseGroup*       parent,
+    OnFrameBeginRecorder&  recorder,
+    IAbortSwitch*          abort_switch)
+{
+    if (!ProceduralObject::on_frame_begin(project, parent, recorder, abort_switch))
+        return false;
+
+    const EntityDefMessageContext context("object", this);
+
+    const std::string shape =
+        m_params.get_optional<std::string>(
+            "particle_shape",
+            "sphere",
+            make_vector("sphere", "disk"),
+            context);
+    const ParticleShape particle_shape =
+        shape == "disk" ? ParticleShapeDisk : ParticleShapeSphere;
+
+    if (particle_shape != impl->m_shape)
+    {
+        impl->m_shape = particle_shape;
+        impl->m_tree_is_dirty = true;
+    }
+
+    if (impl->m_tree_is_dirty)
+        impl->build_tree();
+
+    return true;
+}
+
+bool ParticleSetObject::is_on_frame_begin_thread_safe() const
+{
+    return true;
+}
+
+GAABB3 ParticleSetObject::compute_local_bbox() const
+{
+    // The shape may not be known yet, sphere bounding boxes also enclose disks.
+    GAABB3 bbox;
+    bbox.invalidate();
+
+    for (size_t i = 0, e = impl->m_particles.size(); i < e; ++i)
+        bbox.insert(compute_particle_bbox(impl->m_particles, ParticleShapeSphere, i));
+
+    return bbox;
+}
+
+size_t ParticleSetObject::get_material_slot_count() const
+{
+    return 1;
+}
+
+const char* ParticleSetObject::get_material_slot(const size_t index) const
+{
+    return "default";
+}
+
+void ParticleSetObject::clear_particles()
+{
+    impl->m_particles.clear_release_memory();
+    impl->m_tree_is_dirty = true;
+}
+
+void ParticleSetObject::reserve_particles(const size_t count)
+{
+    impl->m_particles.reserve(count);
+}
+
+size_t ParticleSetObject::push_particle(
+    const GVector3&        center,
+    const GScalar          radius,
+    const GVector3&        normal)
+{
+    assert(radius >= GScalar(0.0));
+    assert(is_normalized(normal));
+
+    const size_t index = impl->m_particles.size();
+    impl->m_particles.push_back(
+        center.x, center.y, center.z,
+        normal.x, normal.y, normal.z,
+        radius);
+    impl->m_tree_is_dirty = true;
+
+    return index;
+}
+
+size_t ParticleSetObject::get_particle_count() const
+{
+    return impl->m_particles.size();
+}
+
+GVector3 ParticleSetObject::get_particle_center(const size_t index) const
+{
+    return impl->get_center(index);
+}
+
+GScalar ParticleSetObject::get_particle_radius(const size_t index) const
+{
+    return impl->m_particles.get<Radius>(index);
+}
+
+GVector3 ParticleSetObject::get_particle_normal(const size_t index) const
+{
+    return impl->get_normal(index);
+}
+
+void ParticleSetObject::intersect(
+    const ShadingRay&      ray,
+    IntersectionResult&    result) const
+{
+    Ray3f ray_f(ray);
+    const size_t index = impl->intersect(ray_f, true);
+
+    result.m_hit = index != ~size_t(0);
+
+    if (result.m_hit)
+    {
+        result.m_distance = ray_f.m_tmax;
+
+        const Vector3f p = ray_f.point_at(ray_f.m_tmax);
+        const Vector3f v = p - impl->get_center(index);
+        const float radius = impl->m_particles.get<Radius>(index);
+
+        if (impl->m_shape == ParticleShapeSphere)
+        {
+            const Vector3f n = normalize(v);
+            result.m_geometric_normal = Vector3d(n);
+            result.m_shading_normal = Vector3d(n);
+
+            result.m_uv[0] = std::atan2(-n.z, n.x) * RcpTwoPi<float>();
+            result.m_uv[1] = 1.0f - (std::acos(clamp(n.y, -1.0f, 1.0f)) * RcpPi<float>());
+        }
+        else
+        {
+            const Basis3f basis(impl->get_normal(index));
+            result.m_geometric_normal = Vector3d(basis.get_normal());
+            result.m_shading_normal = Vector3d(basis.get_normal());
+
+            float phi = std::atan2(dot(v, basis.get_tangent_u()), dot(v, basis.get_tangent_v()));
+            if (phi < 0.0f)
+                phi += TwoPi<float>();
+            result.m_uv[0] = phi * RcpTwoPi<float>();
+            result.m_uv[1] = radius > 0.0f ? 1.0f - std::min(norm(v) / radius, 1.0f) : 0.0f;
+        }
+
+        result.m_material_slot = 0;
+    }
+}
+
+bool ParticleSetObject::intersect(const ShadingRay& ray) const
+{
+    Ray3f ray_f(ray);
+    return impl->intersect(ray_f, false) != ~size_t(0);
+}
+
+void ParticleSetObject::refine_and_offset(
+    const Ray3d&        obj_inst_ray,
+    Vector3d&           obj_inst_front_point,
+    Vector3d&           obj_inst_back_point,
+    Vector3d&           obj_inst_geo_normal) const
+{
+    const size_t index = impl->find_closest_particle(Vector3f(obj_inst_ray.m_org));
+    assert(index != ~size_t(0));
+
+    const Vector3d center(impl->get_center(index));
+    const double radius = impl->m_particles.get<Radius>(index);
+    const Vector3d normal(impl->get_normal(index));
+    const bool is_sphere = impl->m_shape == ParticleShapeSphere;
+
+    // Always intersect the supporting surface of the particle.
+    const auto intersection_handling = [&](const Vector3d& p, const Vector3d& dir)
+    {
+        if (is_sphere)
+        {
+            const double a = dot(dir, dir);
+            const Vector3d v = center - p;
+            const double b = dot(dir, v);
+            const double d = std::max(square(b) - a * (dot(v, v) - square(radius)), 0.0);
+
+            const double sqrt_d = std::sqrt(d);
+            const double t1 = (b - sqrt_d) / a;
+            const double t2 = (b + sqrt_d) / a;
+
+            return std::abs(t1) < std::abs(t2) ? t1 : t2;
+        }
+        else return dot(center - p, normal) / dot(dir, normal);
+    };
+
+    // Refine the location of the intersection point.
+    const Vector3d refined_intersection_point =
+        refine(
+            obj_inst_ray.m_org,
+            obj_inst_ray.m_dir,
+            intersection_handling);
+
+    // Compute the geometric normal to the hit in object instance space.
+    obj_inst_geo_normal = is_sphere ? refined_intersection_point - center : normal;
+    obj_inst_geo_normal = faceforward(obj_inst_geo_normal, obj_inst_ray.m_dir);
+
+    adaptive_offset(
+        refined_intersection_point,
+        obj_inst_geo_normal,
+        obj_inst_front_point,
+        obj_inst_back_point,
+        intersection_handling);
+}
+
+
+//
+// ParticleSetObjectFactory class implementation.
+//
+
+void ParticleSetObjectFactory::release()
+{
+    delete this;
+}
+
+const char* ParticleSetObjectFactory::get_model() const
+{
+    return Model;
+}
+
+Dictionary ParticleSetObjectFactory::get_model_metadata() const
+{
+    return
+        Dictionary()
+            .insert("name", Model)
+            .insert("label", "Particle Set Object");
+}
+
+DictionaryArray ParticleSetObjectFactory::get_input_metadata() const
+{
+    DictionaryArray metadata;
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "particle_shape")
+            .insert("label", "Particle Shape")
+            .insert("type", "enumeration")
+            .insert("items",
+                Dictionary()
+                    .insert("Sphere", "sphere")
+                    .insert("Disk", "disk"))
+            .insert("use", "optional")
+            .insert("default", "sphere"));
+
+    return metadata;
+}
+
+auto_release_ptr<Object> ParticleSetObjectFactory::create(
+    const char*            name,
+    const ParamArray&      params) const
+{
+    return auto_release_ptr<Object>(new ParticleSetObject(name, params));
+}
+
+bool ParticleSetObjectFactory::create(
+    const char*            name,
+    const ParamArray&      params,
+    const SearchPaths&     search_paths,
+    const bool             omit_loading_assets,
+    ObjectArray&           objects) const
+{
+    objects.push_back(create(name, params).release());
+    return true;
+}
+
+}   // namespace renderer
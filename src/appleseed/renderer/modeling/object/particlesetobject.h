@@ -0,0 +1,161 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/modeling/object/iobjectfactory.h"
+#include "renderer/modeling/object/proceduralobject.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/ray.h"
+#include "foundation/math/vector.h"
+#include "foundation/memory/autoreleaseptr.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class IAbortSwitch; }
+namespace foundation    { class SearchPaths; }
+namespace renderer      { class BaseGroup; }
+namespace renderer      { class OnFrameBeginRecorder; }
+namespace renderer      { class ParamArray; }
+namespace renderer      { class Project; }
+namespace renderer      { class ShadingRay; }
+
+namespace renderer
+{
+
+//
+// A particle set object.
+//
+// A large set of spheres or disks, stored as a structure of arrays and intersected
+// through a bounding volume hierarchy whose leaves hold up to 8 particles that are
+// tested simultaneously.
+//
+// Particles are reordered when the object is prepared for rendering.
+//
+
+class APPLESEED_DLLSYMBOL ParticleSetObject
+  : public ProceduralObject
+{
+  public:
+    void release() override;
+
+    const char* get_model() const override;
+
+    bool on_frame_begin(
+        const Project&              project,
+        const BaseGroup*            parent,
+        OnFrameBeginRecorder&       recorder,
+        foundation::IAbortSwitch*   abort_switch) override;
+
+    // Only touches the particle tree owned by this object.
+    bool is_on_frame_begin_thread_safe() const override;
+
+    GAABB3 compute_local_bbox() const override;
+
+    size_t get_material_slot_count() const override;
+
+    const char* get_material_slot(const size_t index) const override;
+
+    // Particle insertion and retrieval.
+    // The normal of a particle is only used when particles are rendered as disks.
+    void clear_particles();
+    void reserve_particles(const size_t count);
+    size_t push_particle(
+        const GVector3&             center,
+        const GScalar               radius,
+        const GVector3&             normal = GVector3(0.0f, 1.0f, 0.0f));
+    size_t get_particle_count() const;
+    GVector3 get_particle_center(const size_t index) const;
+    GScalar get_particle_radius(const size_t index) const;
+    GVector3 get_particle_normal(const size_t index) const;
+
+    void intersect(
+        const ShadingRay&           ray,
+        IntersectionResult&         result) const override;
+
+    bool intersect(const ShadingRay& ray) const override;
+
+    void refine_and_offset(
+        const foundation::Ray3d&    obj_inst_ray,
+        foundation::Vector3d&       obj_inst_front_point,
+        foundation::Vector3d&       obj_inst_back_point,
+        foundation::Vector3d&       obj_inst_geo_normal) const override;
+
+  private:
+    friend class ParticleSetObjectFactory;
+
+    struct Impl;
+    Impl* impl;
+
+    // Constructor.
+    ParticleSetObject(
+        const char*                 name,
+        const ParamArray&           params);
+
+    // Destructor.
+    ~ParticleSetObject() override;
+};
+
+
+//
+// Particle set object factory.
+//
+
+class APPLESEED_DLLSYMBOL ParticleSetObjectFactory
+  : public IObjectFactory
+{
+  public:
+    void release() override;
+
+    const char* get_model() const override;
+
+    foundation::Dictionary get_model_metadata() const override;
+
+    foundation::DictionaryArray get_input_metadata() const override;
+
+    foundation::auto_release_ptr<Object> create(
+        const char*                     name,
+        const ParamArray&               params) const override;
+
+    bool create(
+        const char*                     name,
+        const ParamArray&               params,
+        const foundation::SearchPaths&  search_paths,
+        const bool                      omit_loading_assets,
+        ObjectArray&                    objects) const override;
+};
+
+}   // namespace renderer
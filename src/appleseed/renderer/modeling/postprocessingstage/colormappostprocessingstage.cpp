@@ -202,28 +202,7 @@ namespace
         void execute(Frame& frame) const override
         {
             float min_luminance, max_luminance;
-
-            if (m_auto_range)
-            {
-                m_color_map.find_min_max_relative_luminance(
-                    frame.image(),
-                    frame.get_crop_window(),
-                    min_luminance,
-                    max_luminance);
-            }
-            else
-            {
-                min_luminance = m_range_min;
-                max_luminance = m_range_max;
-            }
-
-            RENDERER_LOG_INFO(
-                "post-processing stage \"%s\":\n"
-                "  min luminance                 %f\n"
-                "  max luminance                 %f",
-                get_path().c_str(),
-                min_luminance,
-                max_luminance);
+            compute_luminance_range(frame, min_luminance, max_luminance);
 
             SegmentVector isoline_segments;
 
@@ -236,11 +215,59 @@ namespace
                 min_luminance,
                 max_luminance);
 
+            draw_overlays(frame, isoline_segments, min_luminance, max_luminance);
+        }
+
+        bool supports_tiles() const override
+        {
+            return true;
+        }
+
+        bool is_pixel_local() const override
+        {
+            return !m_auto_range && !m_render_isolines && !m_add_legend_bar;
+        }
+
+        void prepare_tiles(const Frame& frame) override
+        {
+            compute_luminance_range(frame, m_min_luminance, m_max_luminance);
+
+            // Isolines are found on the original image, before it gets remapped.
+            m_isoline_segments.clear();
+
             if (m_render_isolines)
-                render_isoline_segments(frame, isoline_segments);
+                collect_isoline_segments(m_isoline_segments, frame, m_min_luminance, m_max_luminance);
+        }
 
-            if (m_add_legend_bar)
-                add_legend_bar(frame, min_luminance, max_luminance);
+        void execute_tile(
+            Frame&                  frame,
+            const size_t            tile_x,
+            const size_t            tile_y) const override
+        {
+            const CanvasProperties& props = frame.image().properties();
+            const Vector2u origin(tile_x * props.m_tile_width, tile_y * props.m_tile_height);
+            const AABB2u tile_bbox(
+                origin,
+                Vector2u(
+                    origin.x + props.get_tile_width(tile_x) - 1,
+                    origin.y + props.get_tile_height(tile_y) - 1));
+
+            const AABB2u& crop_window = frame.get_crop_window();
+            if (!AABB2u::overlap(crop_window, tile_bbox))
+                return;
+
+            const AABB2u rect = AABB2u::intersect(crop_window, tile_bbox);
+
+            m_color_map.remap_relative_luminance(
+                frame.image().tile(tile_x, tile_y),
+                AABB2u(rect.min - origin, rect.max - origin),
+                m_min_luminance,
+                m_max_luminance);
+        }
+
+        void finish_tiles(Frame& frame) const override
+        {
+            draw_overlays(frame, m_isoline_segments, m_min_luminance, m_max_luminance);
         }
 
       private:
@@ -279,6 +306,52 @@ namespace
         bool                m_render_isolines;
         float               m_line_thickness;
 
+        // Tiled execution state.
+        float               m_min_luminance;
+        float               m_max_luminance;
+        SegmentVector       m_isoline_segments;
+
+        void compute_luminance_range(
+            const Frame&                frame,
+            float&                      min_luminance,
+            float&                      max_luminance) const
+        {
+            if (m_auto_range)
+            {
+                m_color_map.find_min_max_relative_luminance(
+                    frame.image(),
+                    frame.get_crop_window(),
+                    min_luminance,
+                    max_luminance);
+            }
+            else
+            {
+                min_luminance = m_range_min;
+                max_luminance = m_range_max;
+            }
+
+            RENDERER_LOG_INFO(
+                "post-processing stage \"%s\":\n"
+                "  min luminance                 %f\n"
+                "  max luminance                 %f",
+                get_path().c_str(),
+                min_luminance,
+                max_luminance);
+        }
+
+        void draw_overlays(
+            Frame&                      frame,
+            const SegmentVector&        isoline_segments,
+            const float                 min_luminance,
+            const float                 max_luminance) const
+        {
+            if (m_render_isolines)
+                render_isoline_segments(frame, isoline_segments);
+
+            if (m_add_legend_bar)
+                add_legend_bar(frame, min_luminance, max_luminance);
+        }
+
         void set_palette_from_image_file(const std::string& file_path)
         {
             GenericImageFileReader reader;
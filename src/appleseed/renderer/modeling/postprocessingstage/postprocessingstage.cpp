@@ -33,6 +33,9 @@
 #include "renderer/utility/messagecontext.h"
 #include "renderer/utility/paramarray.h"
 
+// Standard headers.
+#include <cassert>
+
 using namespace foundation;
 
 namespace renderer
@@ -64,4 +67,30 @@ PostProcessingStage::PostProcessingStage(
     m_order = m_params.get_required<int>("order", 0, context);
 }
 
+bool PostProcessingStage::supports_tiles() const
+{
+    return false;
+}
+
+bool PostProcessingStage::is_pixel_local() const
+{
+    return false;
+}
+
+void PostProcessingStage::prepare_tiles(const Frame& frame)
+{
+}
+
+void PostProcessingStage::execute_tile(
+    Frame&              frame,
+    const size_t        tile_x,
+    const size_t        tile_y) const
+{
+    assert(!"This post-processing stage does not support tiled execution.");
+}
+
+void PostProcessingStage::finish_tiles(Frame& frame) const
+{
+}
+
 }   // namespace renderer
@@ -34,6 +34,9 @@
 // appleseed.foundation headers.
 #include "foundation/utility/uid.h"
 
+// Standard headers.
+#include <cstddef>
+
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
@@ -66,6 +69,32 @@ class APPLESEED_DLLSYMBOL PostProcessingStage
     virtual void execute(
         Frame&                  frame) const = 0;
 
+    // Return true if this stage can be executed tile by tile. Such stages are executed
+    // by calling prepare_tiles() once, then execute_tile() on every tile, possibly
+    // concurrently, then finish_tiles() once. The default implementation returns false.
+    virtual bool supports_tiles() const;
+
+    // Return true if the tiled execution of this stage only accesses the pixels of the
+    // tile being processed, i.e. prepare_tiles() and finish_tiles() don't touch the pixels
+    // of the frame. Consecutive stages with this property are executed in a single pass
+    // over the tiles. The default implementation returns false.
+    virtual bool is_pixel_local() const;
+
+    // Gather the frame-wide data needed by execute_tile().
+    virtual void prepare_tiles(
+        const Frame&            frame);
+
+    // Execute this post-processing stage on a single tile of a given frame.
+    virtual void execute_tile(
+        Frame&                  frame,
+        const size_t            tile_x,
+        const size_t            tile_y) const;
+
+    // Complete the tiled execution of this post-processing stage, for instance by
+    // drawing overlays that span several tiles.
+    virtual void finish_tiles(
+        Frame&                  frame) const;
+
   private:
     int m_order;
 };
@@ -93,7 +93,7 @@ Dictionary Configuration::get_metadata()
         "spectrum_mode",
         Dictionary()
             .insert("type", "enum")
-            .insert("values", "rgb|spectral")
+            .insert("values", "rgb|spectral|hero_wavelength")
             .insert("default", "rgb")
             .insert("label", "Color Pipeline")
             .insert("help", "Color pipeline used throughout the renderer")
@@ -109,13 +109,18 @@ Dictionary Configuration::get_metadata()
                     "spectral",
                     Dictionary()
                         .insert("label", "Spectral")
-                        .insert("help", "Spectral pipeline using 31 equidistant components in the 400-700 nm range"))));
+                        .insert("help", "Spectral pipeline using 31 equidistant components in the 400-700 nm range"))
+                .insert(
+                    "hero_wavelength",
+                    Dictionary()
+                        .insert("label", "Hero Wavelength")
+                        .insert("help", "Spectral pipeline where each path carries a random block of 4 adjacent components"))));
 
     metadata.insert(
         "sampling_mode",
         Dictionary()
             .insert("type", "enum")
-            .insert("values", "rng|qmc")
+            .insert("values", "rng|qmc|sobol")
             .insert("default", "qmc")
             .insert("label", "Sampler")
             .insert("help", "Sampling algorithm used in Monte Carlo integration")
@@ -131,7 +136,12 @@ Dictionary Configuration::get_metadata()
                         "qmc",
                         Dictionary()
                             .insert("label", "QMC")
-                            .insert("help", "Quasi Monte Carlo sampler"))));
+                            .insert("help", "Quasi Monte Carlo sampler"))
+                    .insert(
+                        "sobol",
+                        Dictionary()
+                            .insert("label", "Sobol")
+                            .insert("help", "Quasi Monte Carlo sampler using Owen-scrambled Sobol points"))));
 
     metadata.dictionaries().insert(
         "passes",
@@ -170,6 +180,33 @@ Dictionary Configuration::get_metadata()
             .insert("label", "Render Threads")
             .insert("help", "Number of threads to use for rendering"));
 
+    metadata.insert(
+        "rendering_thread_affinity",
+        Dictionary()
+            .insert("type", "enum")
+            .insert("values", "none|core|numa_node")
+            .insert("default", "none")
+            .insert("label", "Render Thread Affinity")
+            .insert("help", "Restrict rendering threads to specific CPU cores or NUMA nodes")
+            .insert(
+                "options",
+                Dictionary()
+                    .insert(
+                        "none",
+                        Dictionary()
+                            .insert("label", "None")
+                            .insert("help", "Let the operating system schedule rendering threads"))
+                    .insert(
+                        "core",
+                        Dictionary()
+                            .insert("label", "CPU Core")
+                            .insert("help", "Pin each rendering thread to a logical CPU core"))
+                    .insert(
+                        "numa_node",
+                        Dictionary()
+                            .insert("label", "NUMA Node")
+                            .insert("help", "Distribute rendering threads across NUMA nodes and pin them to their node"))));
+
 #ifdef APPLESEED_WITH_EMBREE
 
     metadata.insert(
@@ -325,6 +362,10 @@ auto_release_ptr<Configuration> BaseConfigurationFactory::create_base_interactiv
 
     parameters.insert("frame_renderer", "progressive");
     parameters.insert("sample_generator", "generic");
+    parameters.dictionaries().insert(
+        "generic_sample_generator",
+        ParamArray()
+            .insert("progressive_resolution", true));
     parameters.insert("sample_renderer", "generic");
     parameters.insert("lighting_engine", "pt");
 
@@ -64,7 +64,9 @@
 #include "renderer/modeling/material/imaterialfactory.h"
 #include "renderer/modeling/material/material.h"
 #include "renderer/modeling/material/materialfactoryregistrar.h"
+#include "renderer/modeling/object/curveobject.h"
 #include "renderer/modeling/object/iobjectfactory.h"
+#include "renderer/modeling/object/meshobject.h"
 #include "renderer/modeling/object/object.h"
 #include "renderer/modeling/object/objectfactoryregistrar.h"
 #include "renderer/modeling/postprocessingstage/ipostprocessingstagefactory.h"
@@ -102,7 +104,9 @@
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/core/exceptions/exceptionunsupportedfileformat.h"
+#include "foundation/hash/siphash.h"
 #include "foundation/log/log.h"
 #include "foundation/math/aabb.h"
 #include "foundation/math/matrix.h"
@@ -112,19 +116,26 @@
 #include "foundation/memory/memory.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/types.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/api/apiarray.h"
 #include "foundation/utility/api/apistring.h"
+#include "foundation/utility/bufferedfile.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/iterators.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/otherwise.h"
 #include "foundation/utility/searchpaths.h"
 #include "foundation/utility/stopwatch.h"
+#include "foundation/utility/virtualfilesystem.h"
 #include "foundation/utility/xercesc.h"
 #include "foundation/utility/zip.h"
 
 // Xerces-C++ headers.
+#include "xercesc/framework/MemBufInputSource.hpp"
 #include "xercesc/sax2/Attributes.hpp"
 #include "xercesc/sax2/SAX2XMLReader.hpp"
 #include "xercesc/sax2/XMLReaderFactory.hpp"
@@ -138,6 +149,7 @@
 // Standard headers.
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <map>
 #include <memory>
@@ -206,6 +218,244 @@ namespace
     };
 
 
+    //
+    // Create objects using a given object factory, reporting errors to the log.
+    // Return false if the objects could not be created.
+    //
+
+    bool create_objects(
+        const IObjectFactory&   factory,
+        const std::string&      name,
+        const ParamArray&       params,
+        const SearchPaths&      search_paths,
+        const bool              omit_loading_assets,
+        ObjectArray&            objects)
+    {
+        try
+        {
+            return
+                factory.create(
+                    name.c_str(),
+                    params,
+                    search_paths,
+                    omit_loading_assets,
+                    objects);
+        }
+        catch (const ExceptionDictionaryKeyNotFound& e)
+        {
+            RENDERER_LOG_ERROR(
+                "while defining object \"%s\": required parameter \"%s\" missing.",
+                name.c_str(),
+                e.string());
+        }
+        catch (const ExceptionUnknownEntity& e)
+        {
+            RENDERER_LOG_ERROR(
+                "while defining object \"%s\": unknown entity \"%s\".",
+                name.c_str(),
+                e.string());
+        }
+        catch (const Exception& e)
+        {
+            RENDERER_LOG_ERROR(
+                "while defining object \"%s\": %s",
+                name.c_str(),
+                e.what());
+        }
+
+        return false;
+    }
+
+
+    //
+    // Reads geometry files on worker threads while the project file is being parsed.
+    //
+    // Objects are created as usual by their factory but they are only inserted into
+    // their assembly once join() is called, after the whole project file was parsed.
+    //
+
+    class GeometryLoader
+      : public NonCopyable
+    {
+      public:
+        struct Request
+        {
+            const IObjectFactory*   m_factory;
+            std::string             m_name;
+            ParamArray              m_params;
+            SearchPaths             m_search_paths;
+            Assembly*               m_assembly;         // assembly the objects will be inserted into
+            ObjectArray             m_objects;
+            bool                    m_succeeded;
+        };
+
+        explicit GeometryLoader(const size_t thread_count)
+          : m_thread_count(thread_count)
+          , m_job_queue(JobQueue::CentralizedScheduling)
+        {
+        }
+
+        ~GeometryLoader()
+        {
+            stop();
+
+            for (Request* request : m_requests)
+            {
+                for (size_t i = 0, e = request->m_objects.size(); i < e; ++i)
+                    delete_object(request->m_objects[i]);
+                delete request;
+            }
+        }
+
+        // Return true if geometry files of a given object model can be read by this loader.
+        static bool is_supported_model(const std::string& model)
+        {
+            return
+                model == MeshObjectFactory().get_model() ||
+                model == CurveObjectFactory().get_model();
+        }
+
+        // Schedule the creation of objects. The returned request is owned by the loader.
+        Request* load(
+            const IObjectFactory&   factory,
+            const std::string&      name,
+            const ParamArray&       params,
+            const SearchPaths&      search_paths)
+        {
+            if (!m_job_manager)
+            {
+                m_job_manager.reset(
+                    new JobManager(
+                        global_logger(),
+                        m_job_queue,
+                        m_thread_count,
+                        JobManager::KeepRunningOnEmptyQueue));
+                m_job_manager->start();
+                m_stopwatch.start();
+            }
+
+            Request* request = new Request();
+            request->m_factory = &factory;
+            request->m_name = name;
+            request->m_params = params;
+            request->m_search_paths = search_paths;
+            request->m_assembly = nullptr;
+            request->m_succeeded = false;
+            m_requests.push_back(request);
+
+            m_job_queue.schedule(new LoadJob(*request));
+
+            return request;
+        }
+
+        // Wait until all geometry files are read, then insert objects into their assembly,
+        // in the order in which they were scheduled. Objects are discarded if insert_objects
+        // is false or if their assembly could not be created.
+        void join(
+            const bool              insert_objects,
+            EventCounters&          event_counters)
+        {
+            if (m_requests.empty())
+                return;
+
+            m_stopwatch.measure();
+            const double parsing_time = m_stopwatch.get_seconds();
+
+            m_job_queue.wait_until_completion();
+            stop();
+
+            m_stopwatch.measure();
+
+            RENDERER_LOG_INFO(
+                "read geometry of %s %s using %s %s in %s (%s after end of parsing).",
+                pretty_uint(m_requests.size()).c_str(),
+                m_requests.size() > 1 ? "objects" : "object",
+                pretty_uint(m_thread_count).c_str(),
+                m_thread_count > 1 ? "threads" : "thread",
+                pretty_time(m_stopwatch.get_seconds()).c_str(),
+                pretty_time(m_stopwatch.get_seconds() - parsing_time).c_str());
+
+            for (Request* request : m_requests)
+            {
+                if (!request->m_succeeded)
+                    event_counters.signal_error();
+
+                for (size_t i = 0, e = request->m_objects.size(); i < e; ++i)
+                {
+                    auto_release_ptr<Object> object(request->m_objects[i]);
+
+                    if (object.get() == nullptr || !insert_objects || request->m_assembly == nullptr)
+                        continue;
+
+                    ObjectContainer& objects = request->m_assembly->objects();
+
+                    if (objects.get_by_name(object->get_name()) != nullptr)
+                    {
+                        RENDERER_LOG_ERROR(
+                            "an entity with the path \"%s\" already exists.",
+                            object->get_path().c_str());
+                        event_counters.signal_error();
+                        continue;
+                    }
+
+                    objects.insert(object);
+                }
+
+                delete request;
+            }
+
+            m_requests.clear();
+        }
+
+      private:
+        static void delete_object(Object* object)
+        {
+            if (object != nullptr)
+                object->release();
+        }
+
+        class LoadJob
+          : public IJob
+        {
+          public:
+            explicit LoadJob(Request& request)
+              : m_request(request)
+            {
+            }
+
+            void execute(const size_t thread_index) override
+            {
+                m_request.m_succeeded =
+                    create_objects(
+                        *m_request.m_factory,
+                        m_request.m_name,
+                        m_request.m_params,
+                        m_request.m_search_paths,
+                        false,
+                        m_request.m_objects);
+            }
+
+          private:
+            Request& m_request;
+        };
+
+        const size_t                    m_thread_count;
+        JobQueue                        m_job_queue;
+        std::unique_ptr<JobManager>     m_job_manager;
+        std::vector<Request*>           m_requests;
+        Stopwatch<DefaultWallclockTimer> m_stopwatch;
+
+        void stop()
+        {
+            if (m_job_manager)
+            {
+                m_job_manager->stop();
+                m_job_manager.reset();
+            }
+        }
+    };
+
+
     //
     // A set of objects that is passed to all element handlers.
     //
@@ -220,6 +470,7 @@ namespace
           : m_project(project)
           , m_options(options)
           , m_event_counters(event_counters)
+          , m_geometry_loader(System::get_logical_cpu_core_count())
         {
         }
 
@@ -228,6 +479,11 @@ namespace
             return m_project;
         }
 
+        GeometryLoader& get_geometry_loader()
+        {
+            return m_geometry_loader;
+        }
+
         int get_options() const
         {
             return m_options;
@@ -242,6 +498,7 @@ namespace
         Project&            m_project;
         const int           m_options;
         EventCounters&      m_event_counters;
+        GeometryLoader      m_geometry_loader;
     };
 
 
@@ -1538,6 +1795,7 @@ namespace
             ParametrizedElementHandler::start_element(attrs);
 
             clear_keep_memory(m_objects);
+            m_request = nullptr;
 
             m_name = get_value(attrs, "name");
             m_model = get_value(attrs, "model");
@@ -1547,57 +1805,45 @@ namespace
         {
             ParametrizedElementHandler::end_element();
 
-            try
-            {
-                const IObjectFactory* factory =
-                    m_context.get_project().get_factory_registrar<Object>().lookup(m_model.c_str());
+            const IObjectFactory* factory =
+                m_context.get_project().get_factory_registrar<Object>().lookup(m_model.c_str());
 
-                if (factory)
-                {
-                    ObjectArray objects;
-                    if (!factory->create(
-                            m_name.c_str(),
-                            m_params,
-                            m_context.get_project().search_paths(),
-                            m_context.get_options() & ProjectFileReader::OmitReadingMeshFiles,
-                            objects))
-                        m_context.get_event_counters().signal_error();
-
-                    m_objects = array_vector<ObjectVector>(objects);
-                }
-                else
-                {
-                    RENDERER_LOG_ERROR(
-                        "while defining object \"%s\": invalid model \"%s\".",
-                        m_name.c_str(),
-                        m_model.c_str());
-                    m_context.get_event_counters().signal_error();
-                }
-            }
-            catch (const ExceptionDictionaryKeyNotFound& e)
+            if (factory == nullptr)
             {
                 RENDERER_LOG_ERROR(
-                    "while defining object \"%s\": required parameter \"%s\" missing.",
+                    "while defining object \"%s\": invalid model \"%s\".",
                     m_name.c_str(),
-                    e.string());
+                    m_model.c_str());
                 m_context.get_event_counters().signal_error();
+                return;
             }
-            catch (const ExceptionUnknownEntity& e)
+
+            const int options = m_context.get_options();
+
+            // Read geometry files in the background if possible.
+            if (!(options & (ProjectFileReader::OmitReadingMeshFiles | ProjectFileReader::OmitParallelGeometryLoading)) &&
+                GeometryLoader::is_supported_model(m_model))
             {
-                RENDERER_LOG_ERROR(
-                    "while defining object \"%s\": unknown entity \"%s\".",
-                    m_name.c_str(),
-                    e.string());
-                m_context.get_event_counters().signal_error();
+                m_request =
+                    m_context.get_geometry_loader().load(
+                        *factory,
+                        m_name,
+                        m_params,
+                        m_context.get_project().search_paths());
+                return;
             }
-            catch (const Exception& e)
-            {
-                RENDERER_LOG_ERROR(
-                    "while defining object \"%s\": %s",
-                    m_name.c_str(),
-                    e.what());
+
+            ObjectArray objects;
+            if (!create_objects(
+                    *factory,
+                    m_name,
+                    m_params,
+                    m_context.get_project().search_paths(),
+                    (options & ProjectFileReader::OmitReadingMeshFiles) != 0,
+                    objects))
                 m_context.get_event_counters().signal_error();
-            }
+
+            m_objects = array_vector<ObjectVector>(objects);
         }
 
         const ObjectVector& get_objects() const
@@ -1605,11 +1851,18 @@ namespace
             return m_objects;
         }
 
+        // Return the pending load request if objects are being created in the background.
+        GeometryLoader::Request* get_request() const
+        {
+            return m_request;
+        }
+
       private:
-        ParseContext&   m_context;
-        ObjectVector    m_objects;
-        std::string     m_name;
-        std::string     m_model;
+        ParseContext&               m_context;
+        ObjectVector                m_objects;
+        GeometryLoader::Request*    m_request;
+        std::string                 m_name;
+        std::string                 m_model;
     };
 
 
@@ -2095,6 +2348,7 @@ namespace
             m_surface_shaders.clear();
             m_textures.clear();
             m_texture_instances.clear();
+            m_pending_requests.clear();
 
             m_name = get_value(attrs, "name");
             m_model = get_value(attrs, "model", AssemblyFactory().get_model());
@@ -2126,6 +2380,10 @@ namespace
                 m_assembly->surface_shaders().swap(m_surface_shaders);
                 m_assembly->textures().swap(m_textures);
                 m_assembly->texture_instances().swap(m_texture_instances);
+
+                // Objects still being loaded will be inserted into the assembly later.
+                for (GeometryLoader::Request* request : m_pending_requests)
+                    request->m_assembly = m_assembly.get();
             }
             else
             {
@@ -2192,8 +2450,13 @@ namespace
                 break;
 
               case ElementObject:
-                for (Object* object : static_cast<ObjectElementHandler*>(handler)->get_objects())
-                    insert(m_objects, auto_release_ptr<Object>(object));
+                {
+                    ObjectElementHandler* object_handler = static_cast<ObjectElementHandler*>(handler);
+                    for (Object* object : object_handler->get_objects())
+                        insert(m_objects, auto_release_ptr<Object>(object));
+                    if (object_handler->get_request())
+                        m_pending_requests.push_back(object_handler->get_request());
+                }
                 break;
 
               case ElementObjectInstance:
@@ -2262,6 +2525,7 @@ namespace
         SurfaceShaderContainer      m_surface_shaders;
         TextureContainer            m_textures;
         TextureInstanceContainer    m_texture_instances;
+        std::vector<GeometryLoader::Request*> m_pending_requests;
     };
 
 
@@ -3128,6 +3392,53 @@ namespace
 
 namespace
 {
+    // Version of the project cache. Bump whenever the way projects are parsed changes
+    // in a way that would make the events recorded by older versions invalid.
+    const std::uint64_t ProjectCacheVersion = 1;
+
+    // Combine a 64-bit hash of the contents of a file into a key. Return false on i/o errors.
+    bool hash_file_contents(const char* filepath, std::uint64_t& key)
+    {
+        BufferedFile file(filepath, BufferedFile::BinaryType, BufferedFile::ReadMode);
+
+        if (!file.is_open())
+            return false;
+
+        std::vector<char> buffer(1024 * 1024);
+        std::uint64_t chunk_index = 0;
+
+        while (true)
+        {
+            const size_t bytes = file.read(buffer.data(), buffer.size());
+            if (bytes == 0)
+                break;
+
+            key = siphash24(buffer.data(), bytes, key, chunk_index++);
+        }
+
+        return true;
+    }
+
+    // Compute the key identifying the parsing results of a given project file.
+    bool compute_project_cache_key(
+        const char*     project_filepath,
+        const char*     schema_filepath,
+        const int       options,
+        std::uint64_t&  key)
+    {
+        const bool validate = !(options & ProjectFileReader::OmitProjectSchemaValidation);
+
+        key = siphash24(&ProjectCacheVersion, sizeof(ProjectCacheVersion), validate ? 1 : 0, 0);
+
+        if (!hash_file_contents(project_filepath, key))
+            return false;
+
+        if (validate && !hash_file_contents(schema_filepath, key))
+            return false;
+
+        return true;
+    }
+
     bool is_builtin_project(const std::string& project_filepath, std::string& project_name)
     {
         const std::string BuiltInPrefix = "builtin:";
@@ -3152,15 +3463,27 @@ namespace
         return files.size() == 1 ? files[0] : std::string();
     }
 
-    std::string unpack_project(
+    // Mount a packed project at its unpacked directory so that the project file
+    // and the geometry files it references are read directly from the archive.
+    // The other files, such as textures, are read by third-party libraries that
+    // can only access the disk: these files only are extracted.
+    std::string mount_packed_project(
         const std::string& project_filepath,
         const std::string& project_name,
-        const bf::path& unpacked_project_directory)
+        const bf::path& unpacked_project_directory,
+        std::unique_ptr<ScopedZipArchiveMount>& mount)
     {
         if (bf::exists(unpacked_project_directory))
             bf::remove_all(unpacked_project_directory);
 
-        unzip(project_filepath, unpacked_project_directory.string());
+        std::vector<std::string> excluded_extensions;
+        excluded_extensions.push_back(".appleseed");
+        excluded_extensions.push_back(".binarycurve");
+        excluded_extensions.push_back(".binarymesh");
+
+        unzip(project_filepath, unpacked_project_directory.string(), excluded_extensions);
+
+        mount.reset(new ScopedZipArchiveMount(project_filepath, unpacked_project_directory.string()));
 
         return (unpacked_project_directory / project_name).string().c_str();
     }
@@ -3180,6 +3503,7 @@ auto_release_ptr<Project> ProjectFileReader::read(
 
     // Handle packed projects.
     std::string actual_project_filepath;
+    std::unique_ptr<ScopedZipArchiveMount> mount;
     if (is_zip_file(project_filepath))
     {
         const std::string project_filename = get_project_filename_from_archive(project_filepath);
@@ -3195,15 +3519,16 @@ auto_release_ptr<Project> ProjectFileReader::read(
             bf::path(project_filepath).replace_extension(".unpacked").string();
 
         RENDERER_LOG_INFO(
-            "%s appears to be a packed project; unpacking to %s...",
+            "%s appears to be a packed project; mounting it at %s...",
             project_filepath,
             unpacked_project_directory.c_str());
 
         actual_project_filepath =
-            unpack_project(
+            mount_packed_project(
                 project_filepath,
                 project_filename,
-                unpacked_project_directory);
+                unpacked_project_directory,
+                mount);
 
         project_filepath = actual_project_filepath.data();
     }
@@ -3254,6 +3579,7 @@ auto_release_ptr<Assembly> ProjectFileReader::read_archive(
 
     // Handle packed archives.
     std::string actual_archive_filepath;
+    std::unique_ptr<ScopedZipArchiveMount> mount;
     if (is_zip_file(archive_filepath))
     {
         const std::string archive_name = get_project_filename_from_archive(archive_filepath);
@@ -3269,10 +3595,11 @@ auto_release_ptr<Assembly> ProjectFileReader::read_archive(
             bf::path(archive_filepath).replace_extension(".unpacked").string();
 
         actual_archive_filepath =
-            unpack_project(
+            mount_packed_project(
                 archive_filepath,
                 archive_name,
-                unpacked_archive_directory);
+                unpacked_archive_directory,
+                mount);
 
         archive_filepath = actual_archive_filepath.data();
     }
@@ -3357,6 +3684,16 @@ auto_release_ptr<Project> ProjectFileReader::load_builtin(
     return event_counters.has_errors() ? auto_release_ptr<Project>(nullptr) : project;
 }
 
+std::string ProjectFileReader::get_project_cache_filepath(const char* project_filepath)
+{
+    return std::string(project_filepath) + ".cache";
+}
+
+std::string ProjectFileReader::get_search_path_cache_filepath(const char* project_filepath)
+{
+    return std::string(project_filepath) + ".searchpaths";
+}
+
 auto_release_ptr<Project> ProjectFileReader::load_project_file(
     const char*                     project_filepath,
     const char*                     schema_filepath,
@@ -3379,6 +3716,20 @@ auto_release_ptr<Project> ProjectFileReader::load_project_file(
         project->search_paths() = *search_paths;
     }
 
+    // Resolve files from directory listings while the project is being loaded.
+    // Listings persisted by a previous load spare file system queries entirely,
+    // which matters when many render tasks load the same project from network storage.
+    const std::string search_path_cache_filepath = get_search_path_cache_filepath(project_filepath);
+    bool search_path_cache_loaded = false;
+    if (options & UseSearchPathCache)
+    {
+        search_path_cache_loaded =
+            project->search_paths().load_resolution_cache(search_path_cache_filepath.c_str());
+
+        if (search_path_cache_loaded)
+            RENDERER_LOG_DEBUG("using search path cache %s.", search_path_cache_filepath.c_str());
+    }
+
     // Create the error handler.
     std::unique_ptr<ErrorLogger> error_handler(
         new ErrorLoggerAndCounter(
@@ -3413,14 +3764,51 @@ auto_release_ptr<Project> ProjectFileReader::load_project_file(
         parser->setFeature(XMLUni::fgXercesSchema, false);       // disable the parser's schema support
     }
 
+    // Record parsing events so that they can be saved to the project cache.
+    SAX2EventCache event_cache;
+    SAX2EventRecorder event_recorder(*content_handler, event_cache);
+
     parser->setErrorHandler(error_handler.get());
-    parser->setContentHandler(content_handler.get());
+    parser->setContentHandler(
+        options & UseProjectCache
+            ? static_cast<xercesc::ContentHandler*>(&event_recorder)
+            : static_cast<xercesc::ContentHandler*>(content_handler.get()));
+
+    // Look for valid parsing results in the project cache.
+    const std::string cache_filepath = get_project_cache_filepath(project_filepath);
+    std::uint64_t cache_key = 0;
+    bool use_cache = false;
+    bool cache_hit = false;
+    if (options & UseProjectCache)
+    {
+        use_cache =
+            compute_project_cache_key(
+                project_filepath,
+                schema_filepath,
+                options,
+                cache_key);
+        cache_hit = use_cache && event_cache.load(cache_filepath, cache_key);
+    }
 
     // Load the project file.
     RENDERER_LOG_INFO("loading project file %s...", project_filepath);
     try
     {
-        parser->parse(project_filepath);
+        if (cache_hit)
+        {
+            RENDERER_LOG_DEBUG("using project cache %s.", cache_filepath.c_str());
+            event_cache.replay(*content_handler);
+        }
+        else
+        {
+            // Parse the project file from memory if it lives in a mounted archive.
+            std::vector<std::uint8_t> buffer;
+            const std::uint8_t* data;
+            size_t size;
+            if (read_virtual_file(project_filepath, data, size, buffer))
+                parser->parse(MemBufInputSource(data, size, project_filepath));
+            else parser->parse(project_filepath);
+        }
     }
     catch (const XMLException&)
     {
@@ -3431,6 +3819,31 @@ auto_release_ptr<Project> ProjectFileReader::load_project_file(
         return auto_release_ptr<Project>(nullptr);
     }
 
+    // Only cache the results of clean parses so that diagnostics are reported again next time.
+    if (use_cache && !cache_hit &&
+        error_handler->get_warning_count() == 0 &&
+        error_handler->get_error_count() == 0 &&
+        error_handler->get_fatal_error_count() == 0)
+    {
+        if (!event_cache.save(cache_filepath, cache_key))
+            RENDERER_LOG_WARNING("failed to write project cache %s.", cache_filepath.c_str());
+    }
+
+    // Wait for geometry files read in the background. Objects are only inserted
+    // if parsing succeeded since their assemblies might not exist otherwise.
+    context.get_geometry_loader().join(!event_counters.has_errors(), event_counters);
+
+    // Files may change once the project is loaded, stop relying on directory listings.
+    if (options & UseSearchPathCache)
+    {
+        if (!search_path_cache_loaded &&
+            !event_counters.has_errors() &&
+            !project->search_paths().save_resolution_cache(search_path_cache_filepath.c_str()))
+            RENDERER_LOG_WARNING("failed to write search path cache %s.", search_path_cache_filepath.c_str());
+
+        project->search_paths().set_resolution_cache_enabled(false);
+    }
+
     // Report a failure in case of warnings or errors.
     if (error_handler->get_warning_count() > 0 ||
         error_handler->get_error_count() > 0 ||
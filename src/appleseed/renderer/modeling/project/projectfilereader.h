@@ -36,6 +36,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <string>
+
 // Forward declarations.
 namespace renderer  { class Assembly; }
 namespace renderer  { class EventCounters; }
@@ -57,9 +60,18 @@ class APPLESEED_DLLSYMBOL ProjectFileReader
         OmitReadingMeshFiles        = 1UL << 0,     // do not read mesh files from disk
         OmitProjectFileUpdate       = 1UL << 1,     // do not update the project file format to the latest revision
         OmitSearchPaths             = 1UL << 2,     // do not read search paths from the project
-        OmitProjectSchemaValidation = 1UL << 3      // do not validate project against schema
+        OmitProjectSchemaValidation = 1UL << 3,     // do not validate project against schema
+        OmitParallelGeometryLoading = 1UL << 4,     // read mesh and curve files on the parsing thread
+        UseProjectCache             = 1UL << 5,     // replay parsing results from a binary cache next to the project file
+        UseSearchPathCache          = 1UL << 6      // resolve files from directory listings persisted next to the project file
     };
 
+    // Return the path to the binary cache of a given project file.
+    static std::string get_project_cache_filepath(const char* project_filepath);
+
+    // Return the path to the search path resolution cache of a given project file.
+    static std::string get_search_path_cache_filepath(const char* project_filepath);
+
     // Read a project from disk (or load a built-in project).
     // Return 0 if reading or parsing the file failed.
     foundation::auto_release_ptr<Project> read(
@@ -31,6 +31,7 @@
 #include "projectfilewriter.h"
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #include "renderer/modeling/aov/aov.h"
 #include "renderer/modeling/bsdf/bsdf.h"
 #include "renderer/modeling/bssrdf/bssrdf.h"
@@ -54,6 +55,7 @@
 #include "renderer/modeling/project/configuration.h"
 #include "renderer/modeling/project/configurationcontainer.h"
 #include "renderer/modeling/project/project.h"
+#include "renderer/modeling/project/projectfilereader.h"
 #include "renderer/modeling/scene/assembly.h"
 #include "renderer/modeling/scene/assemblyinstance.h"
 #include "renderer/modeling/scene/containers.h"
@@ -75,9 +77,11 @@
 #include "foundation/core/appleseed.h"
 #include "foundation/math/transform.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/string/string.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/indenter.h"
+#include "foundation/utility/job.h"
 #include "foundation/utility/searchpaths.h"
 #include "foundation/utility/stopwatch.h"
 #include "foundation/utility/xmlelement.h"
@@ -115,6 +119,31 @@ namespace
     const char* MatrixFormat     = "%.17f";
     const char* ColorValueFormat = "%.9f";
 
+    // Deferred write of a geometry file, given the number of threads it may use.
+    typedef std::function<void (const size_t thread_count)> GeometryFileWriter;
+
+    class WriteGeometryFileJob
+      : public IJob
+    {
+      public:
+        WriteGeometryFileJob(
+            const GeometryFileWriter&   writer,
+            const size_t                thread_count)
+          : m_writer(writer)
+          , m_thread_count(thread_count)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            m_writer(m_thread_count);
+        }
+
+      private:
+        const GeometryFileWriter&       m_writer;
+        const size_t                    m_thread_count;
+    };
+
     class Writer
     {
       public:
@@ -150,11 +179,49 @@ namespace
             write_configurations(project);
         }
 
+        // Write to disk the geometry files referenced by the elements written so far.
+        // Files are written in parallel; the cores are shared among the files being
+        // written at the same time, so a lone large mesh still gets compressed by all.
+        void write_geometry_files()
+        {
+            const size_t file_count = m_geometry_file_writers.size();
+            if (file_count == 0)
+                return;
+
+            const size_t core_count = System::get_logical_cpu_core_count();
+            const size_t thread_count = std::min(core_count, file_count);
+
+            if (thread_count > 1)
+            {
+                JobQueue job_queue;
+                JobManager job_manager(global_logger(), job_queue, thread_count);
+
+                for (const GeometryFileWriter& writer : m_geometry_file_writers)
+                {
+                    job_queue.schedule(
+                        new WriteGeometryFileJob(
+                            writer,
+                            std::max<size_t>(core_count / thread_count, 1)));
+                }
+
+                job_manager.start();
+                job_queue.wait_until_completion();
+            }
+            else
+            {
+                for (const GeometryFileWriter& writer : m_geometry_file_writers)
+                    writer(core_count);
+            }
+
+            m_geometry_file_writers.clear();
+        }
+
       private:
-        const filesystem::path  m_project_new_root_dir;
-        FILE*                   m_file;
-        const int               m_options;
-        Indenter                m_indenter;
+        const filesystem::path          m_project_new_root_dir;
+        FILE*                           m_file;
+        const int                       m_options;
+        Indenter                        m_indenter;
+        std::vector<GeometryFileWriter> m_geometry_file_writers;
 
         // Return a lexicographically-sorted vector of references to entities.
         template <typename Collection>
@@ -680,9 +747,13 @@ namespace
 
             if (!(m_options & ProjectFileWriter::OmitWritingGeometryFiles))
             {
-                // Write the mesh file to disk.
+                // Write the mesh file to disk, once the project file is written.
                 const std::string filepath = (m_project_new_root_dir / filename).string();
-                MeshObjectWriter::write(object, object_name.c_str(), filepath.c_str());
+                m_geometry_file_writers.emplace_back(
+                    [&object, object_name, filepath](const size_t thread_count)
+                    {
+                        MeshObjectWriter::write(object, object_name.c_str(), filepath.c_str(), thread_count);
+                    });
             }
 
             // Write the <object> element.
@@ -712,9 +783,13 @@ namespace
 
                 if (!(m_options & ProjectFileWriter::OmitWritingGeometryFiles))
                 {
-                    // Write the curve file to disk.
+                    // Write the curve file to disk, once the project file is written.
                     const std::string filepath = (m_project_new_root_dir / filename).string();
-                    CurveObjectWriter::write(object, filepath.c_str());
+                    m_geometry_file_writers.emplace_back(
+                        [&object, filepath](const size_t thread_count)
+                        {
+                            CurveObjectWriter::write(object, filepath.c_str());
+                        });
                 }
 
                 // Add a file path parameter to the object.
@@ -998,6 +1073,14 @@ bool ProjectFileWriter::write_plain_project_file(
     // Close the file.
     fclose(file);
 
+    // Write the geometry files of the objects that don't have one yet.
+    writer.write_geometry_files();
+
+    // The project cache, if any, no longer matches the project file: remove it.
+    // It will be rebuilt the next time the project is read with the cache enabled.
+    boost::system::error_code ec;
+    bf::remove(ProjectFileReader::get_project_cache_filepath(filepath), ec);
+
     stopwatch.measure();
 
     RENDERER_LOG_INFO(
@@ -204,6 +204,21 @@ void Assembly::clear()
     impl->m_volumes.clear();
 }
 
+void Assembly::merge(Assembly& source)
+{
+    BaseGroup::merge(source);
+
+    impl->m_bsdfs.merge(source.impl->m_bsdfs);
+    impl->m_bssrdfs.merge(source.impl->m_bssrdfs);
+    impl->m_edfs.merge(source.impl->m_edfs);
+    impl->m_surface_shaders.merge(source.impl->m_surface_shaders);
+    impl->m_materials.merge(source.impl->m_materials);
+    impl->m_lights.merge(source.impl->m_lights);
+    impl->m_objects.merge(source.impl->m_objects);
+    impl->m_object_instances.merge(source.impl->m_object_instances);
+    impl->m_volumes.merge(source.impl->m_volumes);
+}
+
 GAABB3 Assembly::compute_local_bbox() const
 {
     GAABB3 bbox = compute_non_hierarchical_local_bbox();
@@ -123,6 +123,10 @@ class APPLESEED_DLLSYMBOL Assembly
     // Clear the assembly contents.
     void clear();
 
+    // Move the contents of another assembly into this one, leaving the other one empty.
+    // See BaseGroup::merge() for how this allows building assemblies in parallel.
+    void merge(Assembly& source);
+
     // Compute the local space bounding box of the assembly, including all child assemblies,
     // over the shutter interval.
     GAABB3 compute_local_bbox() const;
@@ -31,6 +31,7 @@
 #include "basegroup.h"
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #include "renderer/kernel/shading/oslshadingsystem.h"
 #include "renderer/modeling/color/colorentity.h"
 #include "renderer/modeling/scene/assembly.h"
@@ -41,6 +42,13 @@
 
 // appleseed.foundation headers.
 #include "foundation/utility/job/abortswitch.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
+
+// Standard headers.
+#include <algorithm>
+#include <vector>
 
 using namespace foundation;
 
@@ -107,33 +115,137 @@ void BaseGroup::clear()
     impl->m_assembly_instances.clear();
 }
 
+void BaseGroup::merge(BaseGroup& source)
+{
+    impl->m_colors.merge(source.impl->m_colors);
+    impl->m_textures.merge(source.impl->m_textures);
+    impl->m_texture_instances.merge(source.impl->m_texture_instances);
+    impl->m_shader_groups.merge(source.impl->m_shader_groups);
+    impl->m_assemblies.merge(source.impl->m_assemblies);
+    impl->m_assembly_instances.merge(source.impl->m_assembly_instances);
+}
+
+namespace
+{
+    // Create the OSL shader groups of a group and of its assemblies that are not valid yet,
+    // and collect the newly created ones.
+    bool create_osl_shader_groups(
+        BaseGroup&                  group,
+        OSLShadingSystem&           shading_system,
+        const ShaderCompiler*       shader_compiler,
+        IAbortSwitch*               abort_switch,
+        std::vector<ShaderGroup*>&  created_shader_groups)
+    {
+        for (Assembly& assembly : group.assemblies())
+        {
+            if (is_aborted(abort_switch))
+                return false;
+
+            if (!create_osl_shader_groups(
+                    assembly,
+                    shading_system,
+                    shader_compiler,
+                    abort_switch,
+                    created_shader_groups))
+                return false;
+        }
+
+        for (ShaderGroup& shader_group : group.shader_groups())
+        {
+            if (is_aborted(abort_switch))
+                return false;
+
+            if (shader_group.is_valid())
+                continue;
+
+            if (!shader_group.create_osl_shader_group(
+                    shading_system,
+                    shader_compiler,
+                    abort_switch))
+                return false;
+
+            if (shader_group.is_valid())
+                created_shader_groups.push_back(&shader_group);
+        }
+
+        return true;
+    }
+
+    class OptimizeShaderGroupJob
+      : public IJob
+    {
+      public:
+        OptimizeShaderGroupJob(
+            OSLShadingSystem&       shading_system,
+            ShaderGroup&            shader_group,
+            IAbortSwitch*           abort_switch)
+          : m_shading_system(shading_system)
+          , m_shader_group(shader_group)
+          , m_abort_switch(abort_switch)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            if (!is_aborted(m_abort_switch))
+                m_shader_group.optimize_osl_shader_group(m_shading_system);
+        }
+
+      private:
+        OSLShadingSystem&   m_shading_system;
+        ShaderGroup&        m_shader_group;
+        IAbortSwitch*       m_abort_switch;
+    };
+}
+
 bool BaseGroup::create_optimized_osl_shader_groups(
     OSLShadingSystem&           shading_system,
     const ShaderCompiler*       shader_compiler,
-    IAbortSwitch*               abort_switch)
+    IAbortSwitch*               abort_switch,
+    const size_t                thread_count)
 {
-    for (Assembly& assembly : assemblies())
+    // Building shader groups relies on state held by the shading system: do it serially.
+    std::vector<ShaderGroup*> created_shader_groups;
+    if (!create_osl_shader_groups(
+            *this,
+            shading_system,
+            shader_compiler,
+            abort_switch,
+            created_shader_groups))
+        return false;
+
+    // Optimizing and JIT-compiling shader groups is where the time goes: do it in parallel.
+    const size_t actual_thread_count = std::min(thread_count, created_shader_groups.size());
+
+    if (actual_thread_count > 1)
     {
-        if (is_aborted(abort_switch))
-            return false;
-
-        if (!assembly.create_optimized_osl_shader_groups(
-                shading_system,
-                shader_compiler,
-                abort_switch))
-            return false;
+        JobQueue job_queue(JobQueue::CentralizedScheduling);
+
+        for (ShaderGroup* shader_group : created_shader_groups)
+            job_queue.schedule(new OptimizeShaderGroupJob(shading_system, *shader_group, abort_switch));
+
+        JobManager job_manager(global_logger(), job_queue, actual_thread_count);
+        job_manager.start();
+        job_queue.wait_until_completion();
     }
+    else
+    {
+        for (ShaderGroup* shader_group : created_shader_groups)
+        {
+            if (is_aborted(abort_switch))
+                break;
 
-    for (ShaderGroup& shader_group : shader_groups())
+            shader_group->optimize_osl_shader_group(shading_system);
+        }
+    }
+
+    if (is_aborted(abort_switch))
     {
-        if (is_aborted(abort_switch))
-            return false;
-
-        if (!shader_group.create_optimized_osl_shader_group(
-                shading_system,
-                shader_compiler,
-                abort_switch))
-            return false;
+        // Some shader groups may not be optimized: recreate them all next time.
+        for (ShaderGroup* shader_group : created_shader_groups)
+            shader_group->release_optimized_osl_shader_group();
+
+        return false;
     }
 
     return true;
@@ -71,11 +71,18 @@ class APPLESEED_DLLSYMBOL BaseGroup
     // Clear the base group contents.
     void clear();
 
-    // Create OSL shader groups and optimize them.
+    // Move the contents of another base group into this one, leaving the other one empty.
+    // Entity containers are not thread-safe, but exporters can build separate staging
+    // groups in parallel, one per thread, then merge them from a single thread.
+    // Entities of a given type must have distinct names across both groups.
+    void merge(BaseGroup& source);
+
+    // Create OSL shader groups and optimize them, using up to thread_count threads.
     bool create_optimized_osl_shader_groups(
         OSLShadingSystem&           shading_system,
         const ShaderCompiler*       shader_compiler,
-        foundation::IAbortSwitch*   abort_switch = nullptr);
+        foundation::IAbortSwitch*   abort_switch = nullptr,
+        const size_t                thread_count = 1);
 
     // Release internal OSL shader groups.
     void release_optimized_osl_shader_groups();
@@ -42,6 +42,8 @@
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/api/apistring.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/makevector.h"
 
@@ -51,7 +53,9 @@
 #include "foundation/platform/_endoiioheaders.h"
 
 // Standard headers.
+#include <cstring>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 
@@ -114,6 +118,26 @@ bool has_participating_media(const MaterialArray& materials)
     return false;
 }
 
+bool has_subsurface_scattering(const MaterialArray& materials)
+{
+    for (size_t i = 0, e = materials.size(); i < e; ++i)
+    {
+        if (materials[i])
+        {
+            if (materials[i]->get_uncached_bssrdf() != nullptr)
+                return true;
+
+            if (const ShaderGroup* sg = materials[i]->get_uncached_osl_surface())
+            {
+                if (sg->has_subsurface())
+                    return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 
 //
 // ObjectInstance::RenderData class implementation.
@@ -152,6 +176,17 @@ struct ObjectInstance::Impl
     StringDictionary        m_front_material_mappings;
     StringDictionary        m_back_material_mappings;
     OIIO::ustring           m_sss_set_identifier;
+    std::vector<std::string> m_lod_object_names;    // LOD 1 and beyond
+    std::vector<double>     m_lod_screen_sizes;     // decreasing screen sizes below which each LOD is used
+    size_t                  m_selected_lod;
+
+    const std::string& get_selected_object_name() const
+    {
+        return
+            m_selected_lod == 0
+                ? m_object_name
+                : m_lod_object_names[m_selected_lod - 1];
+    }
 };
 
 ObjectInstance::ObjectInstance(
@@ -185,6 +220,29 @@ ObjectInstance::ObjectInstance(
     // Retrieve flip normals flag.
     m_flip_normals = params.get_optional<bool>("flip_normals");
 
+    // Retrieve levels of detail.
+    tokenize(params.get_optional<std::string>("lod_objects", ""), Blanks, impl->m_lod_object_names);
+    std::vector<std::string> lod_screen_sizes;
+    tokenize(params.get_optional<std::string>("lod_screen_sizes", ""), Blanks, lod_screen_sizes);
+    try
+    {
+        for (const std::string& screen_size : lod_screen_sizes)
+            impl->m_lod_screen_sizes.push_back(from_string<double>(screen_size));
+    }
+    catch (const ExceptionStringConversionError&)
+    {
+        impl->m_lod_screen_sizes.clear();
+    }
+    if (impl->m_lod_object_names.size() != impl->m_lod_screen_sizes.size())
+    {
+        RENDERER_LOG_ERROR(
+            "%s\"lod_objects\" and \"lod_screen_sizes\" must have the same number of valid entries; disabling levels of detail.",
+            context.get());
+        impl->m_lod_object_names.clear();
+        impl->m_lod_screen_sizes.clear();
+    }
+    impl->m_selected_lod = 0;
+
     // No bound object yet.
     m_object = nullptr;
 }
@@ -225,6 +283,11 @@ bool ObjectInstance::is_in_same_sss_set(const ObjectInstance& other) const
     return impl->m_sss_set_identifier == other.impl->m_sss_set_identifier;
 }
 
+bool ObjectInstance::has_own_sss_set() const
+{
+    return impl->m_sss_set_identifier.empty();
+}
+
 const Transformd& ObjectInstance::get_transform() const
 {
     return impl->m_transform;
@@ -241,7 +304,7 @@ Object* ObjectInstance::find_object() const
 
         Object* object =
             static_cast<const Assembly*>(parent)
-                ->objects().get_by_name(impl->m_object_name.c_str());
+                ->objects().get_by_name(impl->get_selected_object_name().c_str());
 
         if (object)
             return object;
@@ -267,6 +330,66 @@ GAABB3 ObjectInstance::compute_parent_bbox() const
             : GAABB3::invalid();
 }
 
+size_t ObjectInstance::get_lod_count() const
+{
+    return impl->m_lod_object_names.size() + 1;
+}
+
+size_t ObjectInstance::get_selected_lod() const
+{
+    return impl->m_selected_lod;
+}
+
+namespace
+{
+    bool have_same_material_slots(const Object& lhs, const Object& rhs)
+    {
+        if (lhs.get_material_slot_count() != rhs.get_material_slot_count())
+            return false;
+
+        for (size_t i = 0, e = lhs.get_material_slot_count(); i < e; ++i)
+        {
+            if (strcmp(lhs.get_material_slot(i), rhs.get_material_slot(i)) != 0)
+                return false;
+        }
+
+        return true;
+    }
+}
+
+bool ObjectInstance::select_lod(const double screen_size)
+{
+    size_t lod = 0;
+    while (lod < impl->m_lod_screen_sizes.size() && screen_size < impl->m_lod_screen_sizes[lod])
+        ++lod;
+
+    if (lod == impl->m_selected_lod || m_object == nullptr)
+        return false;
+
+    const size_t previous_lod = impl->m_selected_lod;
+    impl->m_selected_lod = lod;
+
+    Object* object = find_object();
+
+    if (object == nullptr || !have_same_material_slots(*object, *m_object))
+    {
+        RENDERER_LOG_WARNING(
+            "object instance \"%s\": cannot use object \"%s\" as level of detail %s "
+            "because it does not exist or does not have the same material slots as object \"%s\".",
+            get_path().c_str(),
+            impl->get_selected_object_name().c_str(),
+            pretty_uint(lod).c_str(),
+            m_object->get_name());
+        impl->m_selected_lod = previous_lod;
+        return false;
+    }
+
+    m_object = object;
+    bump_version_id();
+
+    return true;
+}
+
 void ObjectInstance::clear_front_materials()
 {
     impl->m_front_material_mappings.clear();
@@ -351,13 +474,13 @@ void ObjectInstance::unbind_object()
 void ObjectInstance::bind_object(const ObjectContainer& objects)
 {
     if (m_object == nullptr)
-        m_object = objects.get_by_name(impl->m_object_name.c_str());
+        m_object = objects.get_by_name(impl->get_selected_object_name().c_str());
 }
 
 void ObjectInstance::check_object() const
 {
     if (m_object == nullptr)
-        throw ExceptionUnknownEntity(impl->m_object_name.c_str(), this);
+        throw ExceptionUnknownEntity(impl->get_selected_object_name().c_str(), this);
 }
 
 namespace
@@ -460,6 +583,13 @@ bool ObjectInstance::has_participating_media() const
         renderer::has_participating_media(m_front_materials);
 }
 
+bool ObjectInstance::has_subsurface_scattering() const
+{
+    return
+        renderer::has_subsurface_scattering(m_back_materials) ||
+        renderer::has_subsurface_scattering(m_front_materials);
+}
+
 bool ObjectInstance::uses_alpha_mapping() const
 {
     if (renderer::uses_alpha_mapping(get_object()))
@@ -563,6 +693,24 @@ DictionaryArray ObjectInstanceFactory::get_input_metadata()
             .insert("use", "optional")
             .insert("default", ""));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "lod_objects")
+            .insert("label", "LOD Objects")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("default", "")
+            .insert("help", "Names of lower detail variants of the object, from most to least detailed"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "lod_screen_sizes")
+            .insert("label", "LOD Screen Sizes")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("default", "")
+            .insert("help", "Decreasing fractions of the frame below which each LOD object is used"));
+
     return metadata;
 }
 
@@ -112,12 +112,26 @@ class APPLESEED_DLLSYMBOL ObjectInstance
     // Check if this object instance is in the same SSS set as another.
     bool is_in_same_sss_set(const ObjectInstance& other) const;
 
+    // Return true if no other object instance can be in the same SSS set as this one.
+    bool has_own_sss_set() const;
+
     // Find the object bound to this instance.
     Object* find_object() const;
 
     // Compute the parent space bounding box of the instance.
     GAABB3 compute_parent_bbox() const;
 
+    // Levels of detail. LOD 0 is the instantiated object; the "lod_objects" parameter
+    // lists lower detail variants of it, used when the instance covers less than the
+    // matching fraction of the frame listed in the "lod_screen_sizes" parameter.
+    size_t get_lod_count() const;
+    size_t get_selected_lod() const;
+
+    // Select the level of detail matching the fraction of the frame covered by the
+    // instance and bind the corresponding object. Returns true if the bound object
+    // changed. Variants must have the same material slots as the instantiated object.
+    bool select_lod(const double screen_size);
+
     // Sides of this object instance's surface.
     enum Side
     {
@@ -169,6 +183,10 @@ class APPLESEED_DLLSYMBOL ObjectInstance
     // has a volume assigned to it.
     bool has_participating_media() const;
 
+    // Return true if at least one of the material referenced by this instance
+    // has a BSSRDF or an OSL surface shader with subsurface scattering.
+    bool has_subsurface_scattering() const;
+
     // Return true if at least one of the material referenced by this instance has an alpha map set.
     bool uses_alpha_mapping() const;
 
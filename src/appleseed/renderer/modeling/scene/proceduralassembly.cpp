@@ -105,6 +105,11 @@ bool ProceduralAssembly::expand_contents(
     return true;
 }
 
+bool ProceduralAssembly::supports_concurrent_expansion() const
+{
+    return false;
+}
+
 void ProceduralAssembly::swap_contents(Assembly& assembly)
 {
     assemblies().swap(assembly.assemblies());
@@ -56,6 +56,11 @@ class APPLESEED_DLLSYMBOL ProceduralAssembly
         const Assembly*             parent,
         foundation::IAbortSwitch*   abort_switch = nullptr);
 
+    // Return true if the contents of this assembly can be expanded concurrently with
+    // the contents of other procedural assemblies. Expansion must then only modify this
+    // assembly and only read the project and the parent assembly. The default is false.
+    virtual bool supports_concurrent_expansion() const;
+
   protected:
     // Constructor.
     ProceduralAssembly(
@@ -31,6 +31,7 @@
 #include "scene.h"
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #ifdef APPLESEED_WITH_EMBREE
 #include "renderer/kernel/intersection/embreescene.h"
 #endif
@@ -52,15 +53,32 @@
 #include "renderer/modeling/surfaceshader/surfaceshader.h"
 #include "renderer/modeling/texture/texture.h"
 #include "renderer/utility/bbox.h"
+#include "renderer/utility/transformsequence.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/system.h"
+#include "foundation/string/string.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/foreach.h"
+#include "foundation/utility/job.h"
 #include "foundation/utility/job/abortswitch.h"
 
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+
 // Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
 #include <set>
+#include <utility>
+#include <vector>
 
 using namespace foundation;
 
@@ -89,6 +107,7 @@ struct Scene::Impl
     EnvironmentEDFContainer         m_environment_edfs;
     EnvironmentShaderContainer      m_environment_shaders;
     auto_release_ptr<SurfaceShader> m_default_surface_shader;
+    std::vector<Camera*>            m_view_cameras;
 #ifdef APPLESEED_WITH_EMBREE
     EmbreeDevice                    m_embree_device;
 #endif
@@ -132,6 +151,13 @@ void Scene::clear_render_data()
     m_render_data.m_diameter = GScalar(0.0);
     m_render_data.m_safe_diameter = GScalar(0.0);
     m_render_data.m_active_camera = nullptr;
+    impl->m_view_cameras.clear();
+}
+
+Camera* Scene::get_view_camera(const size_t view_index) const
+{
+    assert(view_index < impl->m_view_cameras.size());
+    return impl->m_view_cameras[view_index];
 }
 
 CameraContainer& Scene::cameras() const
@@ -309,28 +335,91 @@ void Scene::update_asset_paths(const StringDictionary& mappings)
 
 namespace
 {
-    bool invoke_procedural_expand(
-        Assembly&               assembly,
-        const Project&          project,
-        const Assembly*         parent,
-        IAbortSwitch*           abort_switch)
+    typedef std::vector<std::pair<Assembly*, const Assembly*>> AssemblyParentVector;
+
+    class ExpandProceduralAssemblyJob
+      : public IJob
     {
-        ProceduralAssembly* proc_assembly =
-            dynamic_cast<ProceduralAssembly*>(&assembly);
+      public:
+        ExpandProceduralAssemblyJob(
+            ProceduralAssembly&     assembly,
+            const Project&          project,
+            const Assembly*         parent,
+            IAbortSwitch*           abort_switch,
+            std::uint8_t&           success,
+            boost::atomic<size_t>&  expanded_count,
+            const size_t            total_count)
+          : m_assembly(assembly)
+          , m_project(project)
+          , m_parent(parent)
+          , m_abort_switch(abort_switch)
+          , m_success(success)
+          , m_expanded_count(expanded_count)
+          , m_total_count(total_count)
+        {
+        }
 
-        if (proc_assembly)
+        void execute(const size_t thread_index) override
         {
-            if (!proc_assembly->expand_contents(project, parent, abort_switch))
-                return false;
+            if (is_aborted(m_abort_switch))
+                return;
+
+            m_success = m_assembly.expand_contents(m_project, m_parent, m_abort_switch) ? 1 : 0;
+
+            const size_t expanded_count = ++m_expanded_count;
+            RENDERER_LOG_INFO(
+                "expanded %s of %s procedural assemblies.",
+                pretty_uint(expanded_count).c_str(),
+                pretty_uint(m_total_count).c_str());
         }
 
-        for (each<AssemblyContainer> i = assembly.assemblies(); i; ++i)
+      private:
+        ProceduralAssembly&         m_assembly;
+        const Project&              m_project;
+        const Assembly*             m_parent;
+        IAbortSwitch*               m_abort_switch;
+        std::uint8_t&               m_success;
+        boost::atomic<size_t>&      m_expanded_count;
+        const size_t                m_total_count;
+    };
+
+    bool expand_concurrently(
+        const AssemblyParentVector& assemblies,
+        const Project&              project,
+        IAbortSwitch*               abort_switch)
+    {
+        const size_t thread_count =
+            std::min(System::get_logical_cpu_core_count(), assemblies.size());
+
+        RENDERER_LOG_INFO(
+            "expanding %s procedural assemblies using %s %s...",
+            pretty_uint(assemblies.size()).c_str(),
+            pretty_uint(thread_count).c_str(),
+            plural(thread_count, "thread").c_str());
+
+        std::vector<std::uint8_t> success(assemblies.size(), 0);
+        boost::atomic<size_t> expanded_count(0);
+
+        JobQueue job_queue;
+        JobManager job_manager(global_logger(), job_queue, thread_count);
+
+        for (size_t i = 0, e = assemblies.size(); i < e; ++i)
         {
-            if (!invoke_procedural_expand(*i, project, &assembly, abort_switch))
-                return false;
+            job_queue.schedule(
+                new ExpandProceduralAssemblyJob(
+                    *static_cast<ProceduralAssembly*>(assemblies[i].first),
+                    project,
+                    assemblies[i].second,
+                    abort_switch,
+                    success[i],
+                    expanded_count,
+                    assemblies.size()));
         }
 
-        return true;
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        return std::find(success.begin(), success.end(), 0) == success.end();
     }
 }
 
@@ -338,15 +427,193 @@ bool Scene::expand_procedural_assemblies(
     const Project&          project,
     IAbortSwitch*           abort_switch)
 {
+    // Procedural assemblies only depend on their parent, so the scene is expanded one level
+    // of the assembly hierarchy at a time: the children of an assembly exist once it has been
+    // expanded, and assemblies of the same level that allow it are expanded concurrently.
+    AssemblyParentVector level;
     for (each<AssemblyContainer> i = assemblies(); i; ++i)
+        level.emplace_back(&*i, nullptr);
+
+    while (!level.empty())
     {
-        if (!invoke_procedural_expand(*i, project, nullptr, abort_switch))
+        AssemblyParentVector concurrent;
+
+        for (const_each<AssemblyParentVector> i = level; i; ++i)
+        {
+            ProceduralAssembly* proc_assembly = dynamic_cast<ProceduralAssembly*>(i->first);
+
+            if (proc_assembly == nullptr)
+                continue;
+
+            if (proc_assembly->supports_concurrent_expansion())
+                concurrent.push_back(*i);
+            else if (!proc_assembly->expand_contents(project, i->second, abort_switch))
+                return false;
+        }
+
+        if (concurrent.size() == 1)
+        {
+            ProceduralAssembly* proc_assembly = static_cast<ProceduralAssembly*>(concurrent[0].first);
+            if (!proc_assembly->expand_contents(project, concurrent[0].second, abort_switch))
+                return false;
+        }
+        else if (concurrent.size() > 1)
+        {
+            if (!expand_concurrently(concurrent, project, abort_switch))
+                return false;
+        }
+
+        if (is_aborted(abort_switch))
             return false;
+
+        AssemblyParentVector next_level;
+        for (const_each<AssemblyParentVector> i = level; i; ++i)
+        {
+            for (each<AssemblyContainer> j = i->first->assemblies(); j; ++j)
+                next_level.emplace_back(&*j, i->first);
+        }
+
+        level.swap(next_level);
     }
 
     return true;
 }
 
+namespace
+{
+    typedef std::map<const ObjectInstance*, double> ScreenSizeMap;
+
+    // Return the largest extent of the projection of a camera space bounding box onto the
+    // film, as a fraction of the frame, or infinity if the box can't be entirely projected.
+    double compute_screen_size(const Camera& camera, const AABB3d& camera_space_bbox)
+    {
+        AABB2d ndc_bbox;
+        ndc_bbox.invalidate();
+
+        for (size_t i = 0; i < 8; ++i)
+        {
+            Vector2d ndc;
+            if (!camera.project_camera_space_point(camera_space_bbox.compute_corner(i), ndc))
+                return std::numeric_limits<double>::infinity();
+            ndc_bbox.insert(ndc);
+        }
+
+        return max_value(ndc_bbox.extent());
+    }
+
+    // Record the largest screen size of each object instance with levels of detail,
+    // over all the assembly instances through which it is rendered.
+    void collect_screen_sizes(
+        const Camera&                       camera,
+        const Transformd&                   world_to_camera,
+        const float                         time,
+        const AssemblyInstanceContainer&    assembly_instances,
+        const TransformSequence&            parent_transform_seq,
+        ScreenSizeMap&                      screen_sizes)
+    {
+        for (const AssemblyInstance& assembly_instance : assembly_instances)
+        {
+            const Assembly& assembly = assembly_instance.get_assembly();
+
+            TransformSequence cumulated_transform_seq =
+                assembly_instance.transform_sequence() * parent_transform_seq;
+            cumulated_transform_seq.prepare();
+
+            collect_screen_sizes(
+                camera,
+                world_to_camera,
+                time,
+                assembly.assembly_instances(),
+                cumulated_transform_seq,
+                screen_sizes);
+
+            const Transformd assembly_to_camera =
+                cumulated_transform_seq.evaluate(time) * world_to_camera;
+
+            for (const ObjectInstance& object_instance : assembly.object_instances())
+            {
+                if (object_instance.get_lod_count() < 2)
+                    continue;
+
+                const GAABB3 bbox = object_instance.compute_parent_bbox();
+                if (!bbox.is_valid())
+                    continue;
+
+                const double screen_size =
+                    compute_screen_size(camera, assembly_to_camera.to_parent(AABB3d(bbox)));
+
+                double& max_screen_size = screen_sizes[&object_instance];
+                max_screen_size = std::max(max_screen_size, screen_size);
+            }
+        }
+    }
+
+    size_t apply_screen_sizes(
+        AssemblyContainer&                  assemblies,
+        const ScreenSizeMap&                screen_sizes)
+    {
+        size_t changed_count = 0;
+
+        for (Assembly& assembly : assemblies)
+        {
+            bool assembly_changed = false;
+
+            for (ObjectInstance& object_instance : assembly.object_instances())
+            {
+                const ScreenSizeMap::const_iterator it = screen_sizes.find(&object_instance);
+                if (it != screen_sizes.end() && object_instance.select_lod(it->second))
+                {
+                    assembly_changed = true;
+                    ++changed_count;
+                }
+            }
+
+            // Have acceleration structures rebuilt with the newly selected objects.
+            if (assembly_changed)
+                assembly.bump_version_id();
+
+            changed_count += apply_screen_sizes(assembly.assemblies(), screen_sizes);
+        }
+
+        return changed_count;
+    }
+}
+
+void Scene::select_object_instance_lods()
+{
+    const Camera* camera = m_render_data.m_active_camera;
+    if (camera == nullptr)
+        return;
+
+    // The camera's transform sequence is only prepared in on_frame_begin().
+    const float time = camera->get_shutter_middle_time();
+    TransformSequence camera_transform_seq(camera->transform_sequence());
+    camera_transform_seq.prepare();
+    const Transformd camera_transform = camera_transform_seq.evaluate(time);
+    const Transformd world_to_camera(
+        camera_transform.get_parent_to_local(),
+        camera_transform.get_local_to_parent());
+
+    ScreenSizeMap screen_sizes;
+    collect_screen_sizes(
+        *camera,
+        world_to_camera,
+        time,
+        assembly_instances(),
+        TransformSequence(),
+        screen_sizes);
+
+    if (screen_sizes.empty())
+        return;
+
+    const size_t changed_count = apply_screen_sizes(assemblies(), screen_sizes);
+
+    RENDERER_LOG_DEBUG(
+        "level of detail changed for %s object instance%s.",
+        pretty_uint(changed_count).c_str(),
+        changed_count > 1 ? "s" : "");
+}
+
 bool Scene::on_render_begin(
     const Project&          project,
     const BaseGroup*        parent,
@@ -366,6 +633,27 @@ bool Scene::on_render_begin(
     m_render_data.m_safe_diameter = m_render_data.m_diameter * GScalar(1.01);
     m_render_data.m_active_camera = project.get_uncached_active_camera();
 
+    // Retrieve the cameras of the views of a multi-view frame.
+    if (const Frame* frame = project.get_frame())
+    {
+        for (size_t i = 0, e = frame->get_view_count(); i < e; ++i)
+        {
+            const char* camera_name = frame->get_view_camera_name(i);
+            Camera* camera = cameras().get_by_name(camera_name);
+
+            if (camera == nullptr)
+            {
+                RENDERER_LOG_ERROR(
+                    "cannot find camera \"%s\" of view #%s of the frame.",
+                    camera_name,
+                    pretty_uint(i).c_str());
+                return false;
+            }
+
+            impl->m_view_cameras.push_back(camera);
+        }
+    }
+
     if (!BaseGroup::on_render_begin(project, parent, recorder, abort_switch))
         return false;
 
@@ -377,6 +665,10 @@ bool Scene::on_render_begin(
         success = success && impl->m_environment->on_render_begin(project, this, recorder, abort_switch);
     success = success && invoke_on_render_begin(cameras(), project, this, recorder, abort_switch);
 
+    // Levels of detail must be selected before acceleration structures are built.
+    if (success)
+        select_object_instance_lods();
+
     return success;
 }
 
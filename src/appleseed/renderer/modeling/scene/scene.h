@@ -152,6 +152,10 @@ class APPLESEED_DLLSYMBOL Scene
     // Render-time data are available between on_render_begin() and on_render_end() calls.
     const RenderData& get_render_data() const;
 
+    // Return the camera of a given view of a multi-view frame (see Frame::get_view_count()).
+    // Like render data, view cameras are available between on_render_begin() and on_render_end() calls.
+    Camera* get_view_camera(const size_t view_index) const;
+
   private:
     friend class SceneFactory;
 
@@ -167,6 +171,9 @@ class APPLESEED_DLLSYMBOL Scene
     ~Scene() override;
 
     void clear_render_data();
+
+    // Select the levels of detail of object instances from their size in the active camera.
+    void select_object_instance_lods();
 };
 
 
@@ -31,6 +31,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
+#include "renderer/kernel/rendering/rendererservices.h"
 #include "renderer/kernel/shading/oslshadingsystem.h"
 #include "renderer/modeling/shadergroup/shadercompiler.h"
 #include "renderer/modeling/shadergroup/shaderparamparser.h"
@@ -42,9 +43,16 @@
 #include "foundation/utility/searchpaths.h"
 #include "foundation/utility/uid.h"
 
+// OSL headers.
+#include "foundation/platform/_beginoslheaders.h"
+#include "OSL/oslquery.h"
+#include "foundation/platform/_endoslheaders.h"
+
 // Standard headers.
 #include <cassert>
+#include <cstddef>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 
@@ -221,6 +229,89 @@ struct Shader::Impl
             }
         }
     }
+
+    // Return true if a shader parameter is declared with [[ int lockgeom = 0 ]].
+    static bool is_lockgeom_disabled(const OSL::OSLQuery::Parameter& param)
+    {
+        for (const OSL::OSLQuery::Parameter& metadata : param.metadata)
+        {
+            if (metadata.name == "lockgeom" &&
+                metadata.type == OSL::TypeDesc::TypeInt &&
+                !metadata.idefault.empty())
+                return metadata.idefault[0] == 0;
+        }
+
+        return false;
+    }
+
+    // Parameters declared with lockgeom = 0 may vary per object through user data, which
+    // prevents OSL's runtime optimizer from constant folding them. Explicitly set their
+    // default values, marked as constant for the render, when they were not set by the
+    // user and the renderer has no user data by that name to bind to them anyway.
+    // Returns the number of parameters that were locked this way.
+    size_t lock_unbound_params(OSLShadingSystem& shading_system) const
+    {
+        OSL::OSLQuery query;
+
+        if (!m_byte_code.empty())
+        {
+            if (!query.open_bytecode(m_byte_code))
+                return 0;
+        }
+        else
+        {
+            std::string search_path;
+            shading_system.getattribute("searchpath:shader", search_path);
+
+            if (!query.open(m_shader, search_path))
+                return 0;
+        }
+
+        const RendererServices* renderer_services =
+            static_cast<const RendererServices*>(shading_system.renderer());
+
+        size_t locked_param_count = 0;
+
+        for (size_t i = 0, e = query.nparams(); i < e; ++i)
+        {
+            const OSL::OSLQuery::Parameter& param = *query.getparam(i);
+
+            // Only consider plain input parameters with a known default value.
+            if (param.isoutput || param.isclosure || param.isstruct || !param.validdefault)
+                continue;
+
+            if (param.type.arraylen != 0)
+                continue;
+
+            if (!is_lockgeom_disabled(param))
+                continue;
+
+            if (m_params.get_by_name(param.name.c_str()) != nullptr)
+                continue;
+
+            if (renderer_services != nullptr && renderer_services->has_userdata(param.name))
+                continue;
+
+            const void* value = nullptr;
+            const char* string_value = nullptr;
+
+            if (param.type.basetype == OSL::TypeDesc::FLOAT && param.fdefault.size() >= param.type.aggregate)
+                value = param.fdefault.data();
+            else if (param.type.basetype == OSL::TypeDesc::INT && !param.idefault.empty())
+                value = param.idefault.data();
+            else if (param.type.basetype == OSL::TypeDesc::STRING && !param.sdefault.empty())
+            {
+                string_value = param.sdefault[0].c_str();
+                value = &string_value;
+            }
+            else continue;
+
+            if (shading_system.Parameter(param.name, param.type, value, true))
+                ++locked_param_count;
+        }
+
+        return locked_param_count;
+    }
 };
 
 Shader::Shader(
@@ -320,6 +411,18 @@ bool Shader::add(OSLShadingSystem& shading_system)
             return false;
     }
 
+    const size_t locked_param_count = impl->lock_unbound_params(shading_system);
+
+    if (locked_param_count > 0)
+    {
+        RENDERER_LOG_DEBUG(
+            "made %s %s of shader %s, layer = %s, constant for the render.",
+            pretty_uint(locked_param_count).c_str(),
+            plural(locked_param_count, "parameter").c_str(),
+            get_shader(),
+            get_layer());
+    }
+
     if (!impl->m_byte_code.empty())
     {
         if (!shading_system.LoadMemoryCompiledShader(impl->m_shader, impl->m_byte_code))
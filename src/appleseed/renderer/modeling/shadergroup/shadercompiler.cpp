@@ -30,26 +30,132 @@
 #include "shadercompiler.h"
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #include "renderer/kernel/rendering/oiioerrorhandler.h"
 
 // appleseed.foundation headers.
+#include "foundation/hash/murmurhash.h"
 #include "foundation/utility/api/apistring.h"
 
 // OSL headers.
 #include "foundation/platform/_beginoslheaders.h"
 #include "OSL/oslcomp.h"
+#include "OSL/oslversion.h"
 #include "foundation/platform/_endoslheaders.h"
 
+// Boost headers.
+#include "boost/filesystem.hpp"
+
 // Standard headers.
+#include <cstdint>
+#include <exception>
+#include <fstream>
 #include <memory>
+#include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 
 using namespace foundation;
+namespace bf = boost::filesystem;
 
 namespace renderer
 {
 
+namespace
+{
+    // Bump this number when the cache key computation changes.
+    const std::uint32_t ShaderCacheVersion = 2;
+
+    bool read_text_file(const std::string& filepath, std::string& contents)
+    {
+        std::ifstream file(filepath.c_str(), std::ios::in | std::ios::binary);
+
+        if (!file.is_open())
+            return false;
+
+        std::stringstream sstr;
+        sstr << file.rdbuf();
+
+        if (file.bad())
+            return false;
+
+        contents = sstr.str();
+        return true;
+    }
+
+    struct IncludeDirective
+    {
+        std::string     m_filename;
+        bool            m_quoted;           // "file" rather than <file>
+    };
+
+    // Collect the #include directives of a shader source. Directives inside comments or
+    // disabled conditional blocks are collected too, which can only make the key stricter.
+    void collect_include_directives(
+        const std::string&              source,
+        std::vector<IncludeDirective>&  directives)
+    {
+        std::istringstream sstr(source);
+        std::string line;
+
+        while (std::getline(sstr, line))
+        {
+            size_t i = line.find_first_not_of(" \t");
+            if (i == std::string::npos || line[i] != '#')
+                continue;
+
+            i = line.find_first_not_of(" \t", i + 1);
+            if (i == std::string::npos || line.compare(i, 7, "include") != 0)
+                continue;
+
+            i = line.find_first_not_of(" \t", i + 7);
+            if (i == std::string::npos || (line[i] != '"' && line[i] != '<'))
+                continue;
+
+            const char closing = line[i] == '"' ? '"' : '>';
+            const size_t end = line.find(closing, i + 1);
+            if (end == std::string::npos)
+                continue;
+
+            IncludeDirective directive;
+            directive.m_filename = line.substr(i + 1, end - i - 1);
+            directive.m_quoted = closing == '"';
+            directives.push_back(directive);
+        }
+    }
+
+    void write_text_file_atomically(const std::string& filepath, const std::string& contents)
+    {
+        // Write to a temporary file first so that concurrent renders never see partial files.
+        const bf::path temp_filepath =
+            bf::path(filepath).parent_path() / bf::unique_path("%%%%-%%%%-%%%%-%%%%.tmp");
+
+        try
+        {
+            bf::create_directories(bf::path(filepath).parent_path());
+
+            {
+                std::ofstream file(temp_filepath.string().c_str(), std::ios::out | std::ios::binary);
+                file.write(contents.data(), contents.size());
+                file.close();
+
+                if (!file)
+                    throw std::ios_base::failure("write failed");
+            }
+
+            bf::rename(temp_filepath, filepath);
+        }
+        catch (const std::exception&)
+        {
+            RENDERER_LOG_WARNING("failed to write shader cache file %s.", filepath.c_str());
+
+            boost::system::error_code ec;
+            bf::remove(temp_filepath, ec);
+        }
+    }
+}
+
 //
 // ShaderCompiler class implementation.
 //
@@ -59,15 +165,120 @@ struct ShaderCompiler::Impl
     std::string                         m_stdosl_path;
     std::unique_ptr<OIIOErrorHandler>   m_error_handler;
     std::vector<std::string>            m_options;
+    std::string                         m_cache_directory;
+    std::string                         m_stdosl_contents;
+    bool                                m_stdosl_contents_loaded;
 
     explicit Impl(const char* stdosl_path)
       : m_stdosl_path(stdosl_path)
+      , m_stdosl_contents_loaded(false)
     {
         m_error_handler.reset(new OIIOErrorHandler());
     #ifndef NDEBUG
         m_error_handler->verbosity(OIIO::ErrorHandler::VERBOSE);
     #endif
     }
+
+    // Return the directories searched for included files, in search order.
+    std::vector<bf::path> get_include_directories() const
+    {
+        std::vector<bf::path> directories;
+
+        for (size_t i = 0, e = m_options.size(); i < e; ++i)
+        {
+            const std::string& option = m_options[i];
+
+            if (option == "-I" && i + 1 < e)
+                directories.push_back(m_options[++i]);
+            else if (option.compare(0, 2, "-I") == 0 && option.size() > 2)
+                directories.push_back(option.substr(2));
+        }
+
+        // The compiler also searches the directory of stdosl.h.
+        directories.push_back(bf::path(m_stdosl_path).parent_path());
+
+        return directories;
+    }
+
+    // Append the path and contents of every file transitively included by a shader source
+    // to a hash. Return false if an included file cannot be found.
+    bool hash_included_files(
+        const std::string&              source,
+        const bf::path&                 source_directory,
+        const std::vector<bf::path>&    include_directories,
+        std::set<std::string>&          visited_files,
+        MurmurHash&                     hash) const
+    {
+        std::vector<IncludeDirective> directives;
+        collect_include_directives(source, directives);
+
+        for (const IncludeDirective& directive : directives)
+        {
+            // Quoted includes are first searched next to the including file.
+            bf::path filepath;
+            if (directive.m_quoted && bf::exists(source_directory / directive.m_filename))
+                filepath = source_directory / directive.m_filename;
+            else
+            {
+                for (const bf::path& directory : include_directories)
+                {
+                    if (bf::exists(directory / directive.m_filename))
+                    {
+                        filepath = directory / directive.m_filename;
+                        break;
+                    }
+                }
+            }
+
+            if (filepath.empty())
+                return false;
+
+            const std::string canonical_filepath = bf::absolute(filepath).lexically_normal().string();
+            if (!visited_files.insert(canonical_filepath).second)
+                continue;
+
+            std::string contents;
+            if (!read_text_file(canonical_filepath, contents))
+                return false;
+
+            hash.append(canonical_filepath);
+            hash.append(contents);
+
+            if (!hash_included_files(contents, filepath.parent_path(), include_directories, visited_files, hash))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Compute the path of the cache file holding the compiled version of a given source shader.
+    // The key covers everything that affects the output of the compiler, including the files
+    // the shader includes. Return an empty string if the shader cannot be cached because one
+    // of its included files cannot be found.
+    std::string get_cache_filepath(const char* source_code)
+    {
+        if (!m_stdosl_contents_loaded)
+        {
+            read_text_file(m_stdosl_path, m_stdosl_contents);
+            m_stdosl_contents_loaded = true;
+        }
+
+        MurmurHash hash;
+        hash.append(ShaderCacheVersion);
+        hash.append(OSL_LIBRARY_VERSION_STRING);
+        hash.append(m_stdosl_contents);
+
+        for (const std::string& option : m_options)
+            hash.append(option);
+
+        hash.append(source_code);
+
+        std::set<std::string> visited_files;
+        if (!hash_included_files(source_code, bf::path(), get_include_directories(), visited_files, hash))
+            return std::string();
+
+        return (bf::path(m_cache_directory) / (hash.to_string() + ".oso")).string();
+    }
 };
 
 ShaderCompiler::ShaderCompiler(const char* stdosl_path)
@@ -95,10 +306,29 @@ void ShaderCompiler::add_option(const char* option)
     impl->m_options.push_back(option);
 }
 
+void ShaderCompiler::set_cache_directory(const char* path)
+{
+    impl->m_cache_directory = path;
+}
+
 bool ShaderCompiler::compile_buffer(
     const char* source_code,
     APIString&  result) const
 {
+    // Look for a previously compiled version of this shader in the cache.
+    std::string cache_filepath;
+    if (!impl->m_cache_directory.empty())
+    {
+        cache_filepath = impl->get_cache_filepath(source_code);
+
+        std::string buffer;
+        if (!cache_filepath.empty() && read_text_file(cache_filepath, buffer) && !buffer.empty())
+        {
+            RENDERER_LOG_DEBUG("loaded compiled shader from %s.", cache_filepath.c_str());
+            result = APIString(buffer.c_str());
+            return true;
+        }
+    }
 
     OSL::OSLCompiler compiler(impl->m_error_handler.get());
 
@@ -110,8 +340,14 @@ bool ShaderCompiler::compile_buffer(
             impl->m_options,
             impl->m_stdosl_path.c_str());
     if (ok)
+    {
         result = APIString(buffer.c_str());
 
+        // Store the compiled shader in the cache for later renders.
+        if (!cache_filepath.empty())
+            write_text_file_atomically(cache_filepath, buffer);
+    }
+
     return ok;
 }
 
@@ -56,6 +56,11 @@ class APPLESEED_DLLSYMBOL ShaderCompiler
 
     void add_option(const char* option);
 
+    // Set the directory where compiled shaders are cached across renders.
+    // Compiled shaders are not cached if the path is empty (the default), nor if
+    // one of the files they include cannot be found.
+    void set_cache_directory(const char* path);
+
     bool compile_buffer(
         const char*             source_code,
         foundation::APIString&  result) const;
@@ -40,6 +40,7 @@
 // appleseed.foundation headers.
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/job/abortswitch.h"
 #include "foundation/utility/uid.h"
 
@@ -47,6 +48,7 @@
 #include "boost/unordered/unordered_map.hpp"
 
 // Standard headers.
+#include <cassert>
 #include <exception>
 #include <utility>
 
@@ -192,6 +194,26 @@ bool ShaderGroup::create_optimized_osl_shader_group(
     const ShaderCompiler*   shader_compiler,
     IAbortSwitch*           abort_switch)
 {
+    if (is_valid())
+        return true;
+
+    if (!create_osl_shader_group(shading_system, shader_compiler, abort_switch))
+        return false;
+
+    // The shader group is not valid if its creation was aborted.
+    if (is_valid())
+        optimize_osl_shader_group(shading_system);
+
+    return true;
+}
+
+bool ShaderGroup::create_osl_shader_group(
+    OSLShadingSystem&       shading_system,
+    const ShaderCompiler*   shader_compiler,
+    IAbortSwitch*           abort_switch)
+{
+    APPLESEED_TRACE_SCOPE("shading", "compile shader group");
+
     if (is_valid())
         return true;
 
@@ -242,6 +264,25 @@ bool ShaderGroup::create_optimized_osl_shader_group(
 
         impl->m_shader_group_ref = shader_group_ref;
 
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        RENDERER_LOG_ERROR("failed to setup shader group \"%s\": %s.", get_path().c_str(), e.what());
+        return false;
+    }
+}
+
+void ShaderGroup::optimize_osl_shader_group(OSLShadingSystem& shading_system)
+{
+    APPLESEED_TRACE_SCOPE("shading", "optimize shader group");
+
+    assert(is_valid());
+
+    try
+    {
+        shading_system.optimize_group(impl->m_shader_group_ref.get(), nullptr);
+
         get_shadergroup_closures_info(shading_system);
         report_has_closure("bsdf", HasBSDFs);
         report_has_closure(g_emission_str.c_str(), HasEmission);
@@ -254,13 +295,10 @@ bool ShaderGroup::create_optimized_osl_shader_group(
 
         get_shadergroup_globals_info(shading_system);
         report_uses_global("dPdtime", UsesdPdTime);
-
-        return true;
     }
     catch (const std::exception& e)
     {
-        RENDERER_LOG_ERROR("failed to setup shader group \"%s\": %s.", get_path().c_str(), e.what());
-        return false;
+        RENDERER_LOG_ERROR("failed to optimize shader group \"%s\": %s.", get_path().c_str(), e.what());
     }
 }
 
@@ -100,6 +100,17 @@ class APPLESEED_DLLSYMBOL ShaderGroup
         const ShaderCompiler*       shader_compiler,
         foundation::IAbortSwitch*   abort_switch = nullptr);
 
+    // Create internal OSL shader group without optimizing it.
+    // Shader groups must be created one at a time.
+    bool create_osl_shader_group(
+        OSLShadingSystem&           shading_system,
+        const ShaderCompiler*       shader_compiler,
+        foundation::IAbortSwitch*   abort_switch = nullptr);
+
+    // Optimize and JIT-compile a valid internal OSL shader group.
+    // Different shader groups can be optimized concurrently.
+    void optimize_osl_shader_group(OSLShadingSystem& shading_system);
+
     // Release internal OSL shader group.
     void release_optimized_osl_shader_group();
 
@@ -349,7 +349,8 @@ auto_release_ptr<ShaderParam> ShaderParam::create_string_param(
 
 bool ShaderParam::add(OSLShadingSystem& shading_system)
 {
-    if (!shading_system.Parameter(get_name(), impl->m_type_desc, get_value()))
+    // Values set on a shader are constant for the whole render (lockgeom).
+    if (!shading_system.Parameter(get_name(), impl->m_type_desc, get_value(), true))
     {
         RENDERER_LOG_ERROR("error adding parameter %s.", get_path().c_str());
         return false;
@@ -65,7 +65,7 @@ void NPRSurfaceShaderHelper::evaluate(
 
 #ifdef APPLESEED_WITH_SPECTRAL_SUPPORT
     // For now, we only work in RGB mode.
-    if (shading_components.m_beauty.get_mode() == Spectrum::Spectral)
+    if (shading_components.m_beauty.get_mode() != Spectrum::RGB)
         return;
 #endif
 
@@ -32,6 +32,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
+#include "renderer/kernel/texturing/oiiotexturesystem.h"
 #include "renderer/modeling/input/source.h"
 #include "renderer/modeling/input/texturesource.h"
 #include "renderer/modeling/texture/texture.h"
@@ -53,8 +54,15 @@
 #include "foundation/utility/searchpaths.h"
 #include "foundation/utility/uid.h"
 
+// OpenImageIO headers.
+#include "foundation/platform/_beginoiioheaders.h"
+#include "OpenImageIO/imagecache.h"
+#include "OpenImageIO/ustring.h"
+#include "foundation/platform/_endoiioheaders.h"
+
 // Standard headers.
 #include <cstddef>
+#include <memory>
 #include <string>
 
 using namespace foundation;
@@ -64,6 +72,21 @@ namespace renderer
 
 namespace
 {
+    OIIO::TypeDesc convert_pixel_format(const PixelFormat format)
+    {
+        switch (format)
+        {
+          case PixelFormatUInt8: return OIIO::TypeDesc::UINT8;
+          case PixelFormatUInt16: return OIIO::TypeDesc::UINT16;
+          case PixelFormatUInt32: return OIIO::TypeDesc::UINT32;
+          case PixelFormatHalf: return OIIO::TypeDesc::HALF;
+          case PixelFormatFloat: return OIIO::TypeDesc::FLOAT;
+          case PixelFormatDouble: return OIIO::TypeDesc::DOUBLE;
+          default: return OIIO::TypeDesc::UNKNOWN;
+        }
+    }
+
+
     //
     // 2D on-disk texture.
     //
@@ -166,6 +189,56 @@ namespace
             return TilePtr::make_owning(m_reader.read_tile(tile_x, tile_y));
         }
 
+        TilePtr load_tile_from_image_cache(
+            const size_t            tile_x,
+            const size_t            tile_y,
+            OIIOTextureSystem&      texture_system) override
+        {
+            // Tiles keep the layout and pixel format of the file, as with the file reader.
+            const CanvasProperties& props = properties();
+            const size_t x0 = tile_x * props.m_tile_width;
+            const size_t y0 = tile_y * props.m_tile_height;
+            const size_t tile_width = props.get_tile_width(tile_x);
+            const size_t tile_height = props.get_tile_height(tile_y);
+
+            std::unique_ptr<Tile> tile(
+                new Tile(
+                    tile_width,
+                    tile_height,
+                    props.m_channel_count,
+                    props.m_pixel_format));
+
+            // The image cache is thread-safe: no need to hold the texture's lock.
+            OIIO::ImageCache* image_cache = texture_system.imagecache();
+            const OIIO::ustring filename(m_filepath);
+
+            OIIO::ImageSpec spec;
+            if (image_cache->get_imagespec(filename, spec) &&
+                image_cache->get_pixels(
+                    filename,
+                    0,                                  // subimage
+                    0,                                  // miplevel
+                    spec.x + static_cast<int>(x0),
+                    spec.x + static_cast<int>(x0 + tile_width),
+                    spec.y + static_cast<int>(y0),
+                    spec.y + static_cast<int>(y0 + tile_height),
+                    0,                                  // zbegin
+                    1,                                  // zend
+                    convert_pixel_format(props.m_pixel_format),
+                    tile->get_storage()))
+                return TilePtr::make_owning(tile.release());
+
+            RENDERER_LOG_WARNING(
+                "failed to load tile (" FMT_SIZE_T ", " FMT_SIZE_T ") of texture file %s through oiio's image cache: %s; "
+                "falling back to reading the file directly.",
+                tile_x,
+                tile_y,
+                m_filepath.c_str(),
+                image_cache->geterror().c_str());
+
+            return load_tile(tile_x, tile_y);
+        }
+
       private:
         std::string                         m_filepath;
         ColorSpace                          m_color_space;
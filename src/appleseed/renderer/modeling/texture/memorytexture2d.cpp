@@ -30,6 +30,7 @@
 #include "memorytexture2d.h"
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #include "renderer/modeling/input/source.h"
 #include "renderer/modeling/input/texturesource.h"
 #include "renderer/modeling/texture/texture.h"
@@ -42,8 +43,12 @@
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/color.h"
 #include "foundation/image/colorspace.h"
+#include "foundation/image/image.h"
 #include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
+#include "foundation/platform/system.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/makevector.h"
@@ -51,9 +56,13 @@
 
 // Standard headers.
 #include <cassert>
+#include <algorithm>
 #include <cstddef>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 
@@ -62,6 +71,90 @@ namespace renderer
 
 namespace
 {
+    //
+    // Compute one tile of a MIP level by 2x2 box filtering of the previous level.
+    //
+
+    void downsample_tile(
+        const Image&            source,
+        Image&                  dest,
+        const size_t            tile_x,
+        const size_t            tile_y)
+    {
+        const CanvasProperties& source_props = source.properties();
+        const CanvasProperties& dest_props = dest.properties();
+        const size_t channel_count = dest_props.m_channel_count;
+
+        std::vector<float> texel(channel_count);
+        std::vector<float> sum(channel_count);
+
+        Tile& tile = dest.tile(tile_x, tile_y);
+        const size_t origin_x = tile_x * dest_props.m_tile_width;
+        const size_t origin_y = tile_y * dest_props.m_tile_height;
+
+        for (size_t py = 0, ph = tile.get_height(); py < ph; ++py)
+        {
+            const size_t y = origin_y + py;
+            const size_t sy0 = std::min(2 * y, source_props.m_canvas_height - 1);
+            const size_t sy1 = std::min(2 * y + 1, source_props.m_canvas_height - 1);
+
+            for (size_t px = 0, pw = tile.get_width(); px < pw; ++px)
+            {
+                const size_t x = origin_x + px;
+                const size_t sx0 = std::min(2 * x, source_props.m_canvas_width - 1);
+                const size_t sx1 = std::min(2 * x + 1, source_props.m_canvas_width - 1);
+
+                std::fill(sum.begin(), sum.end(), 0.0f);
+
+                const size_t sx[4] = { sx0, sx1, sx0, sx1 };
+                const size_t sy[4] = { sy0, sy0, sy1, sy1 };
+
+                for (size_t i = 0; i < 4; ++i)
+                {
+                    source.get_pixel(sx[i], sy[i], &texel[0], channel_count);
+
+                    for (size_t c = 0; c < channel_count; ++c)
+                        sum[c] += texel[c];
+                }
+
+                for (size_t c = 0; c < channel_count; ++c)
+                    sum[c] *= 0.25f;
+
+                tile.set_pixel(px, py, &sum[0], channel_count);
+            }
+        }
+    }
+
+    //
+    // Compute all tiles of a MIP level, distributing tiles over multiple threads.
+    //
+
+    void downsample_image(
+        const Image&            source,
+        Image&                  dest,
+        const size_t            thread_count)
+    {
+        const size_t tile_count = dest.properties().m_tile_count;
+        const size_t tile_count_x = dest.properties().m_tile_count_x;
+
+        // Distinct tiles of an image can safely be written concurrently.
+        auto worker = [&source, &dest, tile_count, tile_count_x, thread_count](const size_t first_tile)
+        {
+            for (size_t i = first_tile; i < tile_count; i += thread_count)
+                downsample_tile(source, dest, i % tile_count_x, i / tile_count_x);
+        };
+
+        boost::thread_group threads;
+
+        for (size_t i = 1; i < std::min(thread_count, tile_count); ++i)
+            threads.create_thread(std::bind(worker, i));
+
+        worker(0);
+
+        threads.join_all();
+    }
+
+
     //
     // 2D in-memory texture.
     //
@@ -89,6 +182,23 @@ namespace
           , m_image(image)
         {
             extract_parameters();
+
+            // Build the MIP pyramid in the background while the scene is being set up.
+            if (m_image.get() && m_build_mip_levels)
+            {
+                allocate_mip_levels();
+
+                if (!m_mip_levels.empty())
+                {
+                    m_mip_builder_thread.reset(
+                        new boost::thread([this]() { build_mip_levels(); }));
+                }
+            }
+        }
+
+        ~MemoryTexture2d() override
+        {
+            wait_for_mip_levels();
         }
 
         void release() override
@@ -142,6 +252,10 @@ namespace
             const size_t            tile_x,
             const size_t            tile_y) override
         {
+            // Tiles are converted to linear RGB in place once loaded, wait until
+            // the MIP levels have been computed from the original texels.
+            wait_for_mip_levels();
+
             Tile* tile =
                 m_image.get()
                     ? &m_image->tile(tile_x, tile_y)
@@ -149,6 +263,37 @@ namespace
             return TilePtr::make_non_owning(tile);  // the tile is owned by `m_image`
         }
 
+        size_t get_mip_level_count() override
+        {
+            return m_mip_levels.size() + 1;
+        }
+
+        const CanvasProperties& mip_level_properties(const size_t level) override
+        {
+            assert(level <= m_mip_levels.size());
+
+            return
+                level == 0
+                    ? properties()
+                    : m_mip_levels[level - 1]->properties();
+        }
+
+        TilePtr load_mip_level_tile(
+            const size_t            level,
+            const size_t            tile_x,
+            const size_t            tile_y) override
+        {
+            assert(level <= m_mip_levels.size());
+
+            if (level == 0)
+                return load_tile(tile_x, tile_y);
+
+            wait_for_mip_levels();
+
+            Tile* tile = &m_mip_levels[level - 1]->tile(tile_x, tile_y);
+            return TilePtr::make_non_owning(tile);  // the tile is owned by `m_mip_levels`
+        }
+
       private:
         struct DummyTexture
         {
@@ -163,9 +308,13 @@ namespace
             }
         };
 
-        std::unique_ptr<DummyTexture>    m_dummy_texture;
-        auto_release_ptr<Image>          m_image;
-        ColorSpace                       m_color_space;
+        std::unique_ptr<DummyTexture>           m_dummy_texture;
+        auto_release_ptr<Image>                 m_image;
+        ColorSpace                              m_color_space;
+        bool                                    m_build_mip_levels;
+        std::vector<std::unique_ptr<Image>>     m_mip_levels;
+        std::unique_ptr<boost::thread>          m_mip_builder_thread;
+        std::once_flag                          m_mip_builder_joined;
 
         void extract_parameters()
         {
@@ -183,6 +332,57 @@ namespace
             else if (color_space == "srgb")
                 m_color_space = ColorSpaceSRGB;
             else m_color_space = ColorSpaceCIEXYZ;
+
+            // Retrieve whether MIP levels should be built.
+            m_build_mip_levels = m_params.get_optional<bool>("build_mip_levels", true, context);
+        }
+
+        void allocate_mip_levels()
+        {
+            const CanvasProperties& props = m_image->properties();
+
+            size_t width = props.m_canvas_width;
+            size_t height = props.m_canvas_height;
+
+            while (width > 1 || height > 1)
+            {
+                width = std::max<size_t>(width / 2, 1);
+                height = std::max<size_t>(height / 2, 1);
+
+                m_mip_levels.emplace_back(
+                    new Image(
+                        width,
+                        height,
+                        props.m_tile_width,
+                        props.m_tile_height,
+                        props.m_channel_count,
+                        props.m_pixel_format));
+            }
+        }
+
+        void build_mip_levels()
+        {
+            const size_t thread_count = System::get_logical_cpu_core_count();
+
+            const Image* source = m_image.get();
+
+            for (const auto& level : m_mip_levels)
+            {
+                downsample_image(*source, *level, thread_count);
+                source = level.get();
+            }
+
+            RENDERER_LOG_DEBUG(
+                "built " FMT_SIZE_T " mip level%s for in-memory 2d texture \"%s\".",
+                m_mip_levels.size(),
+                m_mip_levels.size() > 1 ? "s" : "",
+                get_path().c_str());
+        }
+
+        void wait_for_mip_levels()
+        {
+            if (m_mip_builder_thread)
+                std::call_once(m_mip_builder_joined, [this]() { m_mip_builder_thread->join(); });
         }
     };
 }
@@ -227,6 +427,15 @@ DictionaryArray MemoryTexture2dFactory::get_input_metadata() const
             .insert("use", "required")
             .insert("default", "srgb"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "build_mip_levels")
+            .insert("label", "Build MIP Levels")
+            .insert("type", "boolean")
+            .insert("use", "optional")
+            .insert("default", "true")
+            .insert("help", "Build a tiled MIP pyramid of the texture in the background"));
+
     return metadata;
 }
 
@@ -45,6 +45,7 @@
 // Forward declarations.
 namespace foundation    { class CanvasProperties; }
 namespace foundation    { class Tile; }
+namespace renderer      { class OIIOTextureSystem; }
 namespace renderer      { class ParamArray; }
 namespace renderer      { class Source; }
 namespace renderer      { class TextureInstance; }
@@ -87,6 +88,29 @@ class APPLESEED_DLLSYMBOL Texture
     virtual TilePtr load_tile(
         const size_t                tile_x,
         const size_t                tile_y) = 0;
+
+    // Load a given tile through the image cache of an OpenImageIO texture system, so that
+    // files also sampled by OSL shaders are read once and share the same memory budget.
+    // The default implementation ignores the texture system and calls load_tile().
+    virtual TilePtr load_tile_from_image_cache(
+        const size_t                tile_x,
+        const size_t                tile_y,
+        OIIOTextureSystem&          texture_system);
+
+    // Return the number of MIP levels of this texture, including the full resolution level.
+    // The default implementation returns 1.
+    virtual size_t get_mip_level_count();
+
+    // Access canvas properties of a given MIP level. Level 0 is the full resolution level.
+    // The default implementation only supports level 0 and returns properties().
+    virtual const foundation::CanvasProperties& mip_level_properties(const size_t level);
+
+    // Load a given tile of a given MIP level.
+    // The default implementation only supports level 0 and calls load_tile().
+    virtual TilePtr load_mip_level_tile(
+        const size_t                level,
+        const size_t                tile_x,
+        const size_t                tile_y);
 };
 
 }   // namespace renderer
@@ -0,0 +1,764 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2020 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "gridvolume.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/kernel/volume/majorantgrid.h"
+#include "renderer/kernel/volume/sparsevoxelgrid.h"
+#include "renderer/modeling/input/inputarray.h"
+#include "renderer/modeling/project/project.h"
+#include "renderer/modeling/volume/volume.h"
+#include "renderer/utility/messagecontext.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/containers/dictionary.h"
+#include "foundation/math/phasefunction.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/api/apistring.h"
+#include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/makevector.h"
+#include "foundation/utility/searchpaths.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string>
+
+using namespace foundation;
+
+namespace renderer
+{
+
+namespace
+{
+    const char* Model = "grid_volume";
+
+    const size_t DefaultBrickCacheSize = 256;   // in megabytes
+}
+
+//
+// Grid volume.
+//
+// The density grid spans the bounding box [bbox_min, bbox_max] in world space, and is
+// zero outside of it. Distances along volume rays are parametric distances, as in the
+// rest of the volume rendering code.
+//
+
+class GridVolume
+  : public Volume
+{
+  public:
+    GridVolume(
+        const char*         name,
+        const ParamArray&   params)
+      : Volume(name, params)
+    {
+        m_inputs.declare("absorption", InputFormatSpectralReflectance);
+        m_inputs.declare("absorption_multiplier", InputFormatFloat, "1.0");
+        m_inputs.declare("scattering", InputFormatSpectralReflectance);
+        m_inputs.declare("scattering_multiplier", InputFormatFloat, "1.0");
+        m_inputs.declare("average_cosine", InputFormatFloat, "0.0");
+    }
+
+    void release() override
+    {
+        delete this;
+    }
+
+    const char* get_model() const override
+    {
+        return Model;
+    }
+
+    void collect_asset_paths(StringArray& paths) const override
+    {
+        if (m_params.strings().exist("filename"))
+        {
+            const char* filename = m_params.get("filename");
+            if (!is_empty_string(filename))
+                paths.push_back(filename);
+        }
+    }
+
+    void update_asset_paths(const StringDictionary& mappings) override
+    {
+        m_params.set("filename", mappings.get(m_params.get("filename")));
+    }
+
+    bool on_frame_begin(
+        const Project&          project,
+        const BaseGroup*        parent,
+        OnFrameBeginRecorder&   recorder,
+        IAbortSwitch*           abort_switch) override
+    {
+        if (!Volume::on_frame_begin(project, parent, recorder, abort_switch))
+            return false;
+
+        const OnFrameBeginMessageContext context("volume", this);
+
+        const std::string phase_function =
+            m_params.get_required<std::string>(
+                "phase_function_model",
+                "isotropic",
+                make_vector("isotropic", "henyey"),
+                context);
+
+        if (phase_function == "isotropic")
+            m_phase_function.reset(new IsotropicPhaseFunction());
+        else if (phase_function == "henyey")
+        {
+            const float g =
+                clamp(
+                    m_params.get_optional<float>("average_cosine", 0.0f),
+                    -0.99f, +0.99f);
+            m_phase_function.reset(new HenyeyPhaseFunction(g));
+        }
+        else return false;
+
+        const Vector3d bbox_min = m_params.get_required<Vector3d>("bbox_min", Vector3d(0.0), context);
+        const Vector3d bbox_max = m_params.get_required<Vector3d>("bbox_max", Vector3d(1.0), context);
+        for (size_t i = 0; i < 3; ++i)
+        {
+            if (bbox_max[i] <= bbox_min[i])
+            {
+                RENDERER_LOG_ERROR("%sinvalid bounding box.", context.get());
+                return false;
+            }
+        }
+
+        const std::string filepath =
+            to_string(
+                project.search_paths().qualify(
+                    m_params.get_required<std::string>("filename", "", context)));
+
+        const size_t brick_cache_size =
+            m_params.get_optional<size_t>("brick_cache_size", DefaultBrickCacheSize, context);
+
+        m_brick_cache.reset(new BrickCache(brick_cache_size * 1024 * 1024));
+        m_grid = SparseVoxelGrid::open(filepath.c_str(), *m_brick_cache);
+        if (!m_grid)
+        {
+            RENDERER_LOG_ERROR(
+                "%scannot open sparse voxel grid file \"%s\".",
+                context.get(),
+                filepath.c_str());
+            m_brick_cache.reset();
+            return false;
+        }
+
+        m_majorant_grid.reset(new MajorantGrid(*m_grid));
+
+        const size_t res[3] = { m_grid->get_xres(), m_grid->get_yres(), m_grid->get_zres() };
+        const size_t brick_res[3] = { m_grid->get_brick_xres(), m_grid->get_brick_yres(), m_grid->get_brick_zres() };
+
+        m_bbox_min = bbox_min;
+        m_max_step = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const double extent = bbox_max[i] - bbox_min[i];
+            m_rcp_extent[i] = 1.0 / extent;
+
+            // Lookups map the unit cube onto voxel centers while majorant cells cover whole
+            // bricks, so the majorant grid is traversed in its own, slightly scaled space.
+            m_cell_scale[i] =
+                static_cast<double>(res[i] - 1) /
+                static_cast<double>(SparseVoxelGrid::BrickSize * brick_res[i]);
+
+            // Ray marching takes at least one density sample per voxel.
+            m_max_step = std::min(m_max_step, extent / res[i]);
+        }
+
+        return true;
+    }
+
+    void on_frame_end(
+        const Project&          project,
+        const BaseGroup*        parent) override
+    {
+        m_majorant_grid.reset();
+        m_grid.reset();
+        m_brick_cache.reset();
+
+        Volume::on_frame_end(project, parent);
+    }
+
+    bool is_on_frame_begin_thread_safe() const override
+    {
+        return true;
+    }
+
+    bool is_homogeneous() const override
+    {
+        return false;
+    }
+
+    size_t compute_input_data_size() const override
+    {
+        return sizeof(InputValues);
+    }
+
+    void prepare_inputs(
+        Arena&              arena,
+        const ShadingRay&   volume_ray,
+        void*               data) const override
+    {
+        InputValues* values = static_cast<InputValues*>(data);
+
+        values->m_absorption *= values->m_absorption_multiplier;
+        values->m_scattering *= values->m_scattering_multiplier;
+
+        // Precompute extinction, and coefficients at the maximum density of the grid.
+        const float max_density = m_majorant_grid->get_global_majorant();
+        values->m_precomputed.m_extinction = values->m_absorption + values->m_scattering;
+        values->m_precomputed.m_max_absorption = values->m_absorption * max_density;
+        values->m_precomputed.m_max_scattering = values->m_scattering * max_density;
+        values->m_precomputed.m_max_extinction = values->m_precomputed.m_extinction * max_density;
+    }
+
+    float sample(
+        SamplingContext&    sampling_context,
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Vector3f&           incoming) const override
+    {
+        sampling_context.split_in_place(2, 1);
+        const Vector2f s = sampling_context.next2<Vector2f>();
+
+        const Vector3f outgoing(normalize(volume_ray.m_dir));
+        return m_phase_function->sample(outgoing, s, incoming);
+    }
+
+    float evaluate(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        const Vector3f&     incoming) const override
+    {
+        const Vector3f outgoing = Vector3f(normalize(volume_ray.m_dir));
+        return m_phase_function->evaluate(outgoing, incoming);
+    }
+
+    void evaluate_transmission(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+
+        const GridRay ray(*this, volume_ray);
+        double t0 = 0.0, t1 = distance;
+        const double optical_depth =
+            ray.clip(t0, t1)
+                ? integrate_density(ray, t0, t1, m_max_step / norm(volume_ray.m_dir))
+                : 0.0;
+
+        for (size_t i = 0, e = Spectrum::size(); i < e; ++i)
+            spectrum[i] = std::exp(static_cast<float>(-optical_depth) * values->m_precomputed.m_extinction[i]);
+    }
+
+    void evaluate_transmission(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        Spectrum&           spectrum) const override
+    {
+        // Unlike homogeneous media, the density is zero outside of the bounding box,
+        // so the transmission of infinite rays is well defined.
+        evaluate_transmission(
+            data,
+            volume_ray,
+            static_cast<float>(std::min(volume_ray.m_tmax, static_cast<double>(std::numeric_limits<float>::max()))),
+            spectrum);
+    }
+
+    bool sample_distance(
+        SamplingContext&    sampling_context,
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        float&              distance,
+        Spectrum&           weight) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+
+        weight.set(1.0f);
+
+        const GridRay ray(*this, volume_ray);
+        double t0 = 0.0, t1 = volume_ray.m_tmax;
+        if (!ray.clip(t0, t1))
+            return false;
+
+        // Spectral delta tracking.
+        // Reference: "Monte Carlo Methods for Volumetric Light Transport Simulation",
+        // Novák et al., Computer Graphics Forum 2018, section 5.2.
+        SparseVoxelGrid::Accessor accessor(*m_grid);
+        Random rand(sampling_context);
+        Collider collider(*values, ray, accessor, rand, weight);
+        double t;
+        const bool collided =
+            m_majorant_grid->track(
+                ray.m_cell_org,
+                ray.m_cell_dir,
+                t0,
+                t1,
+                max_value(values->m_precomputed.m_extinction),
+                rand,
+                collider,
+                t);
+
+        if (!collided || collider.m_absorbed)
+            return false;
+
+        distance = static_cast<float>(t);
+        return true;
+    }
+
+    void scattering_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        spectrum = values->m_scattering;
+        spectrum *= lookup_density(volume_ray, distance);
+    }
+
+    // Return the scattering coefficient at the maximum density of the grid.
+    // Callers only use it as an upper bound, e.g. to build sampling proposals.
+    const Spectrum& scattering_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        return values->m_precomputed.m_max_scattering;
+    }
+
+    void absorption_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        spectrum = values->m_absorption;
+        spectrum *= lookup_density(volume_ray, distance);
+    }
+
+    // Return the absorption coefficient at the maximum density of the grid.
+    const Spectrum& absorption_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        return values->m_precomputed.m_max_absorption;
+    }
+
+    void extinction_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray,
+        const float         distance,
+        Spectrum&           spectrum) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        spectrum = values->m_precomputed.m_extinction;
+        spectrum *= lookup_density(volume_ray, distance);
+    }
+
+    // Return the extinction coefficient at the maximum density of the grid.
+    const Spectrum& extinction_coefficient(
+        const void*         data,
+        const ShadingRay&   volume_ray) const override
+    {
+        const InputValues* values = static_cast<const InputValues*>(data);
+        return values->m_precomputed.m_max_extinction;
+    }
+
+  private:
+    typedef GridVolumeInputValues InputValues;
+
+    // A volume ray expressed in lookup space (the unit cube) and in majorant grid space.
+    struct GridRay
+    {
+        Vector3d    m_org;
+        Vector3d    m_dir;
+        Vector3d    m_cell_org;
+        Vector3d    m_cell_dir;
+
+        GridRay(const GridVolume& volume, const ShadingRay& ray)
+        {
+            for (size_t i = 0; i < 3; ++i)
+            {
+                m_org[i] = (ray.m_org[i] - volume.m_bbox_min[i]) * volume.m_rcp_extent[i];
+                m_dir[i] = ray.m_dir[i] * volume.m_rcp_extent[i];
+                m_cell_org[i] = m_org[i] * volume.m_cell_scale[i];
+                m_cell_dir[i] = m_dir[i] * volume.m_cell_scale[i];
+            }
+        }
+
+        // Clip [t0, t1] against the unit cube. Return false if nothing is left.
+        bool clip(double& t0, double& t1) const
+        {
+            for (size_t i = 0; i < 3; ++i)
+            {
+                if (m_dir[i] == 0.0)
+                {
+                    if (m_org[i] < 0.0 || m_org[i] > 1.0)
+                        return false;
+                    continue;
+                }
+
+                double t_near = -m_org[i] / m_dir[i];
+                double t_far = (1.0 - m_org[i]) / m_dir[i];
+                if (t_near > t_far)
+                    std::swap(t_near, t_far);
+
+                t0 = std::max(t0, t_near);
+                t1 = std::min(t1, t_far);
+            }
+
+            return t0 < t1;
+        }
+
+        Vector3d point_at(const double t) const
+        {
+            return m_org + t * m_dir;
+        }
+    };
+
+    struct Density
+    {
+        const GridRay&              m_ray;
+        SparseVoxelGrid::Accessor&  m_accessor;
+
+        Density(const GridRay& ray, SparseVoxelGrid::Accessor& accessor)
+          : m_ray(ray)
+          , m_accessor(accessor)
+        {
+        }
+
+        double operator()(const double t) const
+        {
+            return m_accessor.linear_lookup(m_ray.point_at(t));
+        }
+    };
+
+    struct Random
+    {
+        SamplingContext&            m_sampling_context;
+
+        explicit Random(SamplingContext& sampling_context)
+          : m_sampling_context(sampling_context)
+        {
+        }
+
+        float operator()()
+        {
+            m_sampling_context.split_in_place(1, 1);
+            return m_sampling_context.next2<float>();
+        }
+    };
+
+    // Decide between scattering and null collisions at tentative collisions,
+    // and update the throughput weight of the tracked path accordingly.
+    struct Collider
+    {
+        const InputValues&          m_values;
+        const GridRay&              m_ray;
+        SparseVoxelGrid::Accessor&  m_accessor;
+        Random&                     m_rand;
+        Spectrum&                   m_weight;
+        bool                        m_absorbed;
+
+        Collider(
+            const InputValues&          values,
+            const GridRay&              ray,
+            SparseVoxelGrid::Accessor&  accessor,
+            Random&                     rand,
+            Spectrum&                   weight)
+          : m_values(values)
+          , m_ray(ray)
+          , m_accessor(accessor)
+          , m_rand(rand)
+          , m_weight(weight)
+          , m_absorbed(false)
+        {
+        }
+
+        bool operator()(const double t, const float majorant)
+        {
+            const float density = m_accessor.linear_lookup(m_ray.point_at(t));
+
+            Spectrum scattering = m_values.m_scattering;
+            scattering *= density;
+
+            Spectrum null_collision = m_values.m_precomputed.m_extinction;
+            for (size_t i = 0, e = null_collision.size(); i < e; ++i)
+                null_collision[i] = std::max(majorant - density * m_values.m_precomputed.m_extinction[i], 0.0f);
+
+            // Choose the event proportionally to the average scattering and null collision coefficients.
+            const float scattering_avg = average_value(scattering);
+            const float null_collision_avg = average_value(null_collision);
+            const float sum = scattering_avg + null_collision_avg;
+            if (sum <= 0.0f)
+            {
+                // Purely absorbing point: the path ends here.
+                m_weight.set(0.0f);
+                m_absorbed = true;
+                return true;
+            }
+
+            const float scattering_prob = scattering_avg / sum;
+            if (m_rand() < scattering_prob)
+            {
+                m_weight *= scattering;
+                m_weight /= majorant * scattering_prob;
+                return true;
+            }
+
+            m_weight *= null_collision;
+            m_weight /= majorant * (1.0f - scattering_prob);
+            return false;
+        }
+    };
+
+    std::unique_ptr<PhaseFunction>      m_phase_function;
+    std::unique_ptr<BrickCache>         m_brick_cache;
+    std::unique_ptr<SparseVoxelGrid>    m_grid;
+    std::unique_ptr<MajorantGrid>       m_majorant_grid;
+    Vector3d                            m_bbox_min;
+    Vector3d                            m_rcp_extent;
+    Vector3d                            m_cell_scale;
+    double                              m_max_step;
+
+    float lookup_density(
+        const ShadingRay&   volume_ray,
+        const float         distance) const
+    {
+        const GridRay ray(*this, volume_ray);
+        const Vector3d p = ray.point_at(distance);
+        for (size_t i = 0; i < 3; ++i)
+        {
+            if (p[i] < 0.0 || p[i] > 1.0)
+                return 0.0f;
+        }
+
+        SparseVoxelGrid::Accessor accessor(*m_grid);
+        return accessor.linear_lookup(p);
+    }
+
+    double integrate_density(
+        const GridRay&      ray,
+        const double        t0,
+        const double        t1,
+        const double        max_step) const
+    {
+        SparseVoxelGrid::Accessor accessor(*m_grid);
+        Density density(ray, accessor);
+        return
+            m_majorant_grid->integrate(
+                ray.m_cell_org,
+                ray.m_cell_dir,
+                t0,
+                t1,
+                density,
+                max_step);
+    }
+};
+
+//
+// GridVolumeFactory class implementation.
+//
+
+void GridVolumeFactory::release()
+{
+    delete this;
+}
+
+const char* GridVolumeFactory::get_model() const
+{
+    return Model;
+}
+
+Dictionary GridVolumeFactory::get_model_metadata() const
+{
+    return
+        Dictionary()
+            .insert("name", Model)
+            .insert("label", "Grid Volume");
+}
+
+DictionaryArray GridVolumeFactory::get_input_metadata() const
+{
+    DictionaryArray metadata;
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "filename")
+            .insert("label", "Density Grid File")
+            .insert("type", "file")
+            .insert("file_picker_mode", "open")
+            .insert("use", "required"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "bbox_min")
+            .insert("label", "Bounding Box Min")
+            .insert("type", "text")
+            .insert("use", "required")
+            .insert("default", "0.0 0.0 0.0")
+            .insert("help", "World space corner of the density grid"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "bbox_max")
+            .insert("label", "Bounding Box Max")
+            .insert("type", "text")
+            .insert("use", "required")
+            .insert("default", "1.0 1.0 1.0")
+            .insert("help", "World space corner of the density grid, opposite to the min corner"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "brick_cache_size")
+            .insert("label", "Brick Cache Size")
+            .insert("type", "integer")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "1")
+                    .insert("type", "hard"))
+            .insert("use", "optional")
+            .insert("default", "256")
+            .insert("help", "Memory budget for density grid bricks, in megabytes"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "absorption")
+            .insert("label", "Absorption Coefficient at Unit Density")
+            .insert("type", "colormap")
+            .insert("entity_types",
+                Dictionary().insert("color", "Colors"))
+            .insert("use", "required")
+            .insert("default", "0.5"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "absorption_multiplier")
+            .insert("label", "Absorption Coefficient Multiplier")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0.0")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "200.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "1.0"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "scattering")
+            .insert("label", "Scattering Coefficient at Unit Density")
+            .insert("type", "colormap")
+            .insert("entity_types",
+                Dictionary().insert("color", "Colors"))
+            .insert("use", "required")
+            .insert("default", "0.5"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "scattering_multiplier")
+            .insert("label", "Scattering Coefficient Multiplier")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "0.0")
+                    .insert("type", "hard"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "200.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "1.0"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "phase_function_model")
+            .insert("label", "Phase Function Model")
+            .insert("type", "enumeration")
+            .insert("items",
+                Dictionary()
+                    .insert("Isotropic", "isotropic")
+                    .insert("Henyey-Greenstein", "henyey"))
+            .insert("use", "required")
+            .insert("default", "isotropic")
+            .insert("on_change", "rebuild_form"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "average_cosine")
+            .insert("label", "Average Cosine (g)")
+            .insert("type", "numeric")
+            .insert("min",
+                Dictionary()
+                    .insert("value", "-1.0")
+                    .insert("type", "soft"))
+            .insert("max",
+                Dictionary()
+                    .insert("value", "1.0")
+                    .insert("type", "soft"))
+            .insert("use", "optional")
+            .insert("default", "0.0")
+            .insert("visible_if",
+                Dictionary().insert("phase_function_model", "henyey")));
+
+    return metadata;
+}
+
+auto_release_ptr<Volume> GridVolumeFactory::create(
+    const char*         name,
+    const ParamArray&   params) const
+{
+    return auto_release_ptr<Volume>(new GridVolume(name, params));
+}
+
+}   // namespace renderer
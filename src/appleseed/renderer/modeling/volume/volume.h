@@ -117,6 +117,19 @@ class APPLESEED_DLLSYMBOL Volume
         const ShadingRay&           volume_ray,                 // ray used for marching inside the volume
         Spectrum&                   spectrum) const = 0;        // resulting spectrum
 
+    // Sample the distance to the next scattering event along the ray in heterogeneous media
+    // (e.g. by delta tracking). Return true if a scattering event occurs before the end of the
+    // ray, in which case weight is the scattering coefficient times the transmission up to the
+    // sampled point divided by the probability density of that point. Otherwise, return false
+    // and set weight to the transmission of the ray divided by the probability of escaping it.
+    // By default, scattering events are never sampled and weight is the transmission of the entire ray.
+    virtual bool sample_distance(
+        SamplingContext&            sampling_context,
+        const void*                 data,                       // input values
+        const ShadingRay&           volume_ray,                 // ray used for marching inside the volume
+        float&                      distance,                   // distance to the scattering event
+        Spectrum&                   weight) const;              // throughput weight
+
     // Get the scattering coefficient (spectrum) at a given point.
     virtual void scattering_coefficient(
         const void*                 data,                       // input values
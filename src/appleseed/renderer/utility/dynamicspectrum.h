@@ -52,6 +52,11 @@ namespace renderer
 //
 // Internal working spectrum type, either RGB or spectral depending on the thread-local spectrum mode.
 //
+// In hero wavelength mode, spectra are stored with all their bands but all operations only
+// apply to the block of adjacent bands selected for the current path with select_band_block().
+// Values computed in spectral mode, such as uniform inputs, remain valid for every block.
+//
+//
 
 template <typename T, size_t N>
 class DynamicSpectrum
@@ -67,9 +72,15 @@ class DynamicSpectrum
     enum Mode
     {
         RGB = 0,            // DynamicSpectrum stores and operates on RGB triplets
-        Spectral = 1        // DynamicSpectrum stores and operates on spectra
+        Spectral = 1,       // DynamicSpectrum stores and operates on spectra
+        HeroWavelength = 2  // DynamicSpectrum stores spectra but operates on one block of adjacent bands
     };
 
+    // In hero wavelength mode, the bands are grouped in blocks of adjacent bands that fill
+    // one SIMD register. Each path carries a single block chosen at random.
+    static const size_t BandBlockSize = 4;
+    static const size_t BandBlockCount = (N + BandBlockSize - 1) / BandBlockSize;
+
     enum Intent
     {
         Reflectance = 0,    // this spectrum represents a reflectance in [0, 1]^N
@@ -85,6 +96,17 @@ class DynamicSpectrum
     // Return the number of active color channels for the current spectrum mode.
     static size_t size();
 
+    // Return the index of the band stored in the first active color channel.
+    static size_t get_band_offset();
+
+    // Return the inverse of the probability that the active color channels are the ones
+    // carried by the current path: 1 except in hero wavelength mode.
+    static ValueType get_band_weight();
+
+    // In hero wavelength mode, make the band block selected by a uniform sample in [0, 1)
+    // the active color channels of the current thread. Do nothing in other modes.
+    static void select_band_block(const ValueType s);
+
     // Constructors.
 #ifdef APPLESEED_USE_SSE
     DynamicSpectrum();                                      // leave all components uninitialized
@@ -105,6 +127,11 @@ class DynamicSpectrum
         const foundation::LightingConditions&               lighting_conditions,
         const Intent                                        intent);
 
+    // Copy constructor and assignment operator. Only the active color channels are copied,
+    // so that in RGB mode copies move 16 bytes instead of the whole sample array.
+    DynamicSpectrum(const DynamicSpectrum& rhs);
+    DynamicSpectrum& operator=(const DynamicSpectrum& rhs);
+
     // Construct a spectrum from another spectrum of a different type.
     template <typename U>
     DynamicSpectrum(const DynamicSpectrum<U, N>& rhs);
@@ -142,6 +169,7 @@ class DynamicSpectrum
   private:
     static APPLESEED_TLS Mode       s_mode;
     static APPLESEED_TLS size_t     s_size;
+    static APPLESEED_TLS size_t     s_offset;
 
     APPLESEED_SIMD4_ALIGN ValueType m_samples[StoredSamples];
 };
@@ -283,13 +311,17 @@ APPLESEED_TLS typename DynamicSpectrum<T, N>::Mode DynamicSpectrum<T, N>::s_mode
 template <typename T, size_t N>
 APPLESEED_TLS size_t DynamicSpectrum<T, N>::s_size = 3;
 
+template <typename T, size_t N>
+APPLESEED_TLS size_t DynamicSpectrum<T, N>::s_offset = 0;
+
 template <typename T, size_t N>
 typename DynamicSpectrum<T, N>::Mode DynamicSpectrum<T, N>::set_mode(const Mode mode)
 {
     const Mode old_mode = s_mode;
 
     s_mode = mode;
-    s_size = mode == RGB ? 3 : N;
+    s_size = mode == RGB ? 3 : mode == Spectral ? N : std::min(BandBlockSize, N);
+    s_offset = 0;
 
     return old_mode;
 }
@@ -306,12 +338,40 @@ inline size_t DynamicSpectrum<T, N>::size()
     return s_size;
 }
 
+template <typename T, size_t N>
+inline size_t DynamicSpectrum<T, N>::get_band_offset()
+{
+    return s_offset;
+}
+
+template <typename T, size_t N>
+inline T DynamicSpectrum<T, N>::get_band_weight()
+{
+    return s_mode == HeroWavelength ? static_cast<T>(BandBlockCount) : T(1.0);
+}
+
+template <typename T, size_t N>
+inline void DynamicSpectrum<T, N>::select_band_block(const ValueType s)
+{
+    assert(s >= T(0.0) && s < T(1.0));
+
+    if (s_mode == HeroWavelength)
+    {
+        const size_t block =
+            std::min(foundation::truncate<size_t>(s * BandBlockCount), BandBlockCount - 1);
+
+        // The last block may be partial.
+        s_offset = block * BandBlockSize;
+        s_size = std::min(BandBlockSize, N - s_offset);
+    }
+}
+
 #ifdef APPLESEED_USE_SSE
 
 template <typename T, size_t N>
 inline DynamicSpectrum<T, N>::DynamicSpectrum()
 {
-    m_samples[s_size] = T(0.0);
+    m_samples[s_offset + s_size] = T(0.0);
 }
 
 #endif
@@ -322,7 +382,7 @@ inline DynamicSpectrum<T, N>::DynamicSpectrum(const ValueType val)
     set(val);
 
 #ifdef APPLESEED_USE_SSE
-    m_samples[s_size] = T(0.0);
+    m_samples[s_offset + s_size] = T(0.0);
 #endif
 }
 
@@ -335,7 +395,7 @@ inline DynamicSpectrum<T, N>::DynamicSpectrum(
     set(rgb, lighting_conditions, intent);
 
 #ifdef APPLESEED_USE_SSE
-    m_samples[s_size] = T(0.0);
+    m_samples[s_offset + s_size] = T(0.0);
 #endif
 }
 
@@ -348,19 +408,60 @@ inline DynamicSpectrum<T, N>::DynamicSpectrum(
     set(spectrum, lighting_conditions, intent);
 
 #ifdef APPLESEED_USE_SSE
-    m_samples[s_size] = T(0.0);
+    m_samples[s_offset + s_size] = T(0.0);
 #endif
 }
 
+template <typename T, size_t N>
+inline DynamicSpectrum<T, N>::DynamicSpectrum(const DynamicSpectrum& rhs)
+{
+    *this = rhs;
+}
+
+template <typename T, size_t N>
+inline DynamicSpectrum<T, N>& DynamicSpectrum<T, N>::operator=(const DynamicSpectrum& rhs)
+{
+    // Also copy the padding sample that follows the active channels.
+    const size_t end = std::min(s_offset + s_size + 1, StoredSamples);
+
+    for (size_t i = s_offset; i < end; ++i)
+        m_samples[i] = rhs.m_samples[i];
+
+    return *this;
+}
+
+#ifdef APPLESEED_USE_SSE
+
+template <>
+APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& DynamicSpectrum<float, 31>::operator=(const DynamicSpectrum& rhs)
+{
+    _mm_store_ps(&m_samples[s_offset], _mm_load_ps(&rhs.m_samples[s_offset]));
+
+    if (s_size > BandBlockSize)
+    {
+        _mm_store_ps(&m_samples[ 4], _mm_load_ps(&rhs.m_samples[ 4]));
+        _mm_store_ps(&m_samples[ 8], _mm_load_ps(&rhs.m_samples[ 8]));
+        _mm_store_ps(&m_samples[12], _mm_load_ps(&rhs.m_samples[12]));
+        _mm_store_ps(&m_samples[16], _mm_load_ps(&rhs.m_samples[16]));
+        _mm_store_ps(&m_samples[20], _mm_load_ps(&rhs.m_samples[20]));
+        _mm_store_ps(&m_samples[24], _mm_load_ps(&rhs.m_samples[24]));
+        _mm_store_ps(&m_samples[28], _mm_load_ps(&rhs.m_samples[28]));
+    }
+
+    return *this;
+}
+
+#endif  // APPLESEED_USE_SSE
+
 template <typename T, size_t N>
 template <typename U>
 inline DynamicSpectrum<T, N>::DynamicSpectrum(const DynamicSpectrum<U, N>& rhs)
 {
     for (size_t i = 0; i < s_size; ++i)
-        m_samples[i] = static_cast<ValueType>(rhs[i]);
+        m_samples[s_offset + i] = static_cast<ValueType>(rhs[i]);
 
 #ifdef APPLESEED_USE_SSE
-    m_samples[s_size] = T(0.0);
+    m_samples[s_offset + s_size] = T(0.0);
 #endif
 }
 
@@ -372,7 +473,7 @@ inline DynamicSpectrum<T, N> DynamicSpectrum<T, N>::from_array(const ValueType*
     DynamicSpectrum result;
 
     for (size_t i = 0; i < s_size; ++i)
-        result.m_samples[i] = rhs[i];
+        result.m_samples[s_offset + i] = rhs[i];
 
     return result;
 }
@@ -381,7 +482,7 @@ template <typename T, size_t N>
 inline void DynamicSpectrum<T, N>::set(const ValueType val)
 {
     for (size_t i = 0; i < s_size; ++i)
-        m_samples[i] = val;
+        m_samples[s_offset + i] = val;
 }
 
 #ifdef APPLESEED_USE_SSE
@@ -391,9 +492,9 @@ APPLESEED_FORCE_INLINE void DynamicSpectrum<float, 31>::set(const float val)
 {
     const __m128 mval = _mm_set1_ps(val);
 
-    _mm_store_ps(&m_samples[ 0], mval);
+    _mm_store_ps(&m_samples[s_offset], mval);
 
-    if (s_size > 3)
+    if (s_size > BandBlockSize)
     {
         _mm_store_ps(&m_samples[ 4], mval);
         _mm_store_ps(&m_samples[ 8], mval);
@@ -419,7 +520,7 @@ void DynamicSpectrum<T, N>::set(
         m_samples[1] = rgb[1];
         m_samples[2] = rgb[2];
     }
-    else
+    else if (s_mode == Spectral)
     {
         if (intent == Reflectance)
         {
@@ -434,6 +535,18 @@ void DynamicSpectrum<T, N>::set(
                 reinterpret_cast<foundation::RegularSpectrum<T, N>&>(m_samples[0]));
         }
     }
+    else
+    {
+        foundation::RegularSpectrum<T, N> spectrum;
+
+        if (intent == Reflectance)
+            foundation::linear_rgb_reflectance_to_spectrum(rgb, spectrum);
+        else
+            foundation::linear_rgb_illuminance_to_spectrum(rgb, spectrum);
+
+        for (size_t i = 0; i < s_size; ++i)
+            m_samples[s_offset + i] = spectrum[s_offset + i];
+    }
 }
 
 template <typename T, size_t N>
@@ -447,6 +560,11 @@ void DynamicSpectrum<T, N>::set(
         for (size_t i = 0; i < N; ++i)
             m_samples[i] = spectrum[i];
     }
+    else if (s_mode == HeroWavelength)
+    {
+        for (size_t i = 0; i < s_size; ++i)
+            m_samples[s_offset + i] = spectrum[s_offset + i];
+    }
     else
     {
         reinterpret_cast<foundation::Color<T, 3>&>(m_samples[0]) =
@@ -459,14 +577,14 @@ template <typename T, size_t N>
 inline T& DynamicSpectrum<T, N>::operator[](const size_t i)
 {
     assert(i < s_size);
-    return m_samples[i];
+    return m_samples[s_offset + i];
 }
 
 template <typename T, size_t N>
 inline const T& DynamicSpectrum<T, N>::operator[](const size_t i) const
 {
     assert(i < s_size);
-    return m_samples[i];
+    return m_samples[s_offset + i];
 }
 
 template <typename T, size_t N>
@@ -476,19 +594,31 @@ inline foundation::Color<T, 3> DynamicSpectrum<T, N>::to_rgb(
     return
         s_mode == RGB
             ? foundation::Color<T, 3>(m_samples[0], m_samples[1], m_samples[2])
-            : foundation::ciexyz_to_linear_rgb(
-                  foundation::spectrum_to_ciexyz<T>(lighting_conditions, *this));
+            : foundation::ciexyz_to_linear_rgb(to_ciexyz(lighting_conditions));
 }
 
 template <typename T, size_t N>
 inline foundation::Color<T, 3> DynamicSpectrum<T, N>::to_ciexyz(
     const foundation::LightingConditions& lighting_conditions) const
 {
-    return
-        s_mode == RGB
-            ? linear_rgb_to_ciexyz(
-                  foundation::Color<T, 3>(m_samples[0], m_samples[1], m_samples[2]))
-            : foundation::spectrum_to_ciexyz<T>(lighting_conditions, *this);
+    if (s_mode == RGB)
+    {
+        return
+            linear_rgb_to_ciexyz(
+                foundation::Color<T, 3>(m_samples[0], m_samples[1], m_samples[2]));
+    }
+
+    if (s_mode == Spectral)
+        return foundation::spectrum_to_ciexyz<T>(lighting_conditions, *this);
+
+    // In hero wavelength mode, the active bands weighted by the inverse of their
+    // probability are an unbiased estimate of the whole spectrum.
+    foundation::RegularSpectrum<T, N> spectrum(T(0.0));
+
+    for (size_t i = 0; i < s_size; ++i)
+        spectrum[s_offset + i] = m_samples[s_offset + i] * static_cast<T>(BandBlockCount);
+
+    return foundation::spectrum_to_ciexyz<T>(lighting_conditions, spectrum);
 }
 
 template <typename T, size_t N>
@@ -624,9 +754,20 @@ inline DynamicSpectrum<T, N>& operator+=(DynamicSpectrum<T, N>& lhs, const Dynam
 template <>
 APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator+=(DynamicSpectrum<float, 31>& lhs, const DynamicSpectrum<float, 31>& rhs)
 {
+#ifdef APPLESEED_USE_AVX
+    if (DynamicSpectrum<float, 31>::size() > 4)
+    {
+        _mm256_storeu_ps(&lhs[ 0], _mm256_add_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&rhs[ 0])));
+        _mm256_storeu_ps(&lhs[ 8], _mm256_add_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&rhs[ 8])));
+        _mm256_storeu_ps(&lhs[16], _mm256_add_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&rhs[16])));
+        _mm256_storeu_ps(&lhs[24], _mm256_add_ps(_mm256_loadu_ps(&lhs[24]), _mm256_loadu_ps(&rhs[24])));
+    }
+    else
+        _mm_store_ps(&lhs[0], _mm_add_ps(_mm_load_ps(&lhs[0]), _mm_load_ps(&rhs[0])));
+#else
     _mm_store_ps(&lhs[ 0], _mm_add_ps(_mm_load_ps(&lhs[ 0]), _mm_load_ps(&rhs[ 0])));
 
-    if (DynamicSpectrum<float, 31>::size() > 3)
+    if (DynamicSpectrum<float, 31>::size() > 4)
     {
         _mm_store_ps(&lhs[ 4], _mm_add_ps(_mm_load_ps(&lhs[ 4]), _mm_load_ps(&rhs[ 4])));
         _mm_store_ps(&lhs[ 8], _mm_add_ps(_mm_load_ps(&lhs[ 8]), _mm_load_ps(&rhs[ 8])));
@@ -636,6 +777,7 @@ APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator+=(DynamicSpectrum<fl
         _mm_store_ps(&lhs[24], _mm_add_ps(_mm_load_ps(&lhs[24]), _mm_load_ps(&rhs[24])));
         _mm_store_ps(&lhs[28], _mm_add_ps(_mm_load_ps(&lhs[28]), _mm_load_ps(&rhs[28])));
     }
+#endif
 
     return lhs;
 }
@@ -665,11 +807,24 @@ inline DynamicSpectrum<T, N>& operator*=(DynamicSpectrum<T, N>& lhs, const T rhs
 template <>
 APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator*=(DynamicSpectrum<float, 31>& lhs, const float rhs)
 {
+#ifdef APPLESEED_USE_AVX
+    const __m256 mrhs = _mm256_set1_ps(rhs);
+
+    if (DynamicSpectrum<float, 31>::size() > 4)
+    {
+        _mm256_storeu_ps(&lhs[ 0], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 0]), mrhs));
+        _mm256_storeu_ps(&lhs[ 8], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 8]), mrhs));
+        _mm256_storeu_ps(&lhs[16], _mm256_mul_ps(_mm256_loadu_ps(&lhs[16]), mrhs));
+        _mm256_storeu_ps(&lhs[24], _mm256_mul_ps(_mm256_loadu_ps(&lhs[24]), mrhs));
+    }
+    else
+        _mm_store_ps(&lhs[0], _mm_mul_ps(_mm_load_ps(&lhs[0]), _mm_set1_ps(rhs)));
+#else
     const __m128 mrhs = _mm_set1_ps(rhs);
 
     _mm_store_ps(&lhs[ 0], _mm_mul_ps(_mm_load_ps(&lhs[ 0]), mrhs));
 
-    if (DynamicSpectrum<float, 31>::size() > 3)
+    if (DynamicSpectrum<float, 31>::size() > 4)
     {
         _mm_store_ps(&lhs[ 4], _mm_mul_ps(_mm_load_ps(&lhs[ 4]), mrhs));
         _mm_store_ps(&lhs[ 8], _mm_mul_ps(_mm_load_ps(&lhs[ 8]), mrhs));
@@ -679,6 +834,7 @@ APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator*=(DynamicSpectrum<fl
         _mm_store_ps(&lhs[24], _mm_mul_ps(_mm_load_ps(&lhs[24]), mrhs));
         _mm_store_ps(&lhs[28], _mm_mul_ps(_mm_load_ps(&lhs[28]), mrhs));
     }
+#endif
 
     return lhs;
 }
@@ -699,9 +855,20 @@ inline DynamicSpectrum<T, N>& operator*=(DynamicSpectrum<T, N>& lhs, const Dynam
 template <>
 APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator*=(DynamicSpectrum<float, 31>& lhs, const DynamicSpectrum<float, 31>& rhs)
 {
+#ifdef APPLESEED_USE_AVX
+    if (DynamicSpectrum<float, 31>::size() > 4)
+    {
+        _mm256_storeu_ps(&lhs[ 0], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&rhs[ 0])));
+        _mm256_storeu_ps(&lhs[ 8], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&rhs[ 8])));
+        _mm256_storeu_ps(&lhs[16], _mm256_mul_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&rhs[16])));
+        _mm256_storeu_ps(&lhs[24], _mm256_mul_ps(_mm256_loadu_ps(&lhs[24]), _mm256_loadu_ps(&rhs[24])));
+    }
+    else
+        _mm_store_ps(&lhs[0], _mm_mul_ps(_mm_load_ps(&lhs[0]), _mm_load_ps(&rhs[0])));
+#else
     _mm_store_ps(&lhs[ 0], _mm_mul_ps(_mm_load_ps(&lhs[ 0]), _mm_load_ps(&rhs[ 0])));
 
-    if (DynamicSpectrum<float, 31>::size() > 3)
+    if (DynamicSpectrum<float, 31>::size() > 4)
     {
         _mm_store_ps(&lhs[ 4], _mm_mul_ps(_mm_load_ps(&lhs[ 4]), _mm_load_ps(&rhs[ 4])));
         _mm_store_ps(&lhs[ 8], _mm_mul_ps(_mm_load_ps(&lhs[ 8]), _mm_load_ps(&rhs[ 8])));
@@ -711,6 +878,7 @@ APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator*=(DynamicSpectrum<fl
         _mm_store_ps(&lhs[24], _mm_mul_ps(_mm_load_ps(&lhs[24]), _mm_load_ps(&rhs[24])));
         _mm_store_ps(&lhs[28], _mm_mul_ps(_mm_load_ps(&lhs[28]), _mm_load_ps(&rhs[28])));
     }
+#endif
 
     return lhs;
 }
@@ -781,9 +949,20 @@ APPLESEED_FORCE_INLINE void madd(
     const DynamicSpectrum<float, 31>&       b,
     const DynamicSpectrum<float, 31>&       c)
 {
+#ifdef APPLESEED_USE_AVX
+    if (DynamicSpectrum<float, 31>::size() > 4)
+    {
+        _mm256_storeu_ps(&a[ 0], _mm256_add_ps(_mm256_loadu_ps(&a[ 0]), _mm256_mul_ps(_mm256_loadu_ps(&b[ 0]), _mm256_loadu_ps(&c[ 0]))));
+        _mm256_storeu_ps(&a[ 8], _mm256_add_ps(_mm256_loadu_ps(&a[ 8]), _mm256_mul_ps(_mm256_loadu_ps(&b[ 8]), _mm256_loadu_ps(&c[ 8]))));
+        _mm256_storeu_ps(&a[16], _mm256_add_ps(_mm256_loadu_ps(&a[16]), _mm256_mul_ps(_mm256_loadu_ps(&b[16]), _mm256_loadu_ps(&c[16]))));
+        _mm256_storeu_ps(&a[24], _mm256_add_ps(_mm256_loadu_ps(&a[24]), _mm256_mul_ps(_mm256_loadu_ps(&b[24]), _mm256_loadu_ps(&c[24]))));
+    }
+    else
+        _mm_store_ps(&a[0], _mm_add_ps(_mm_load_ps(&a[0]), _mm_mul_ps(_mm_load_ps(&b[0]), _mm_load_ps(&c[0]))));
+#else
     _mm_store_ps(&a[0], _mm_add_ps(_mm_load_ps(&a[0]), _mm_mul_ps(_mm_load_ps(&b[0]), _mm_load_ps(&c[0]))));
 
-    if (DynamicSpectrum<float, 31>::size() > 3)
+    if (DynamicSpectrum<float, 31>::size() > 4)
     {
         _mm_store_ps(&a[ 4], _mm_add_ps(_mm_load_ps(&a[ 4]), _mm_mul_ps(_mm_load_ps(&b[ 4]), _mm_load_ps(&c[ 4]))));
         _mm_store_ps(&a[ 8], _mm_add_ps(_mm_load_ps(&a[ 8]), _mm_mul_ps(_mm_load_ps(&b[ 8]), _mm_load_ps(&c[ 8]))));
@@ -793,6 +972,7 @@ APPLESEED_FORCE_INLINE void madd(
         _mm_store_ps(&a[24], _mm_add_ps(_mm_load_ps(&a[24]), _mm_mul_ps(_mm_load_ps(&b[24]), _mm_load_ps(&c[24]))));
         _mm_store_ps(&a[28], _mm_add_ps(_mm_load_ps(&a[28]), _mm_mul_ps(_mm_load_ps(&b[28]), _mm_load_ps(&c[28]))));
     }
+#endif
 }
 
 template <>
@@ -801,11 +981,24 @@ APPLESEED_FORCE_INLINE void madd(
     const DynamicSpectrum<float, 31>&       b,
     const float                             c)
 {
+#ifdef APPLESEED_USE_AVX
+    if (DynamicSpectrum<float, 31>::size() > 4)
+    {
+        const __m256 k = _mm256_set1_ps(c);
+
+        _mm256_storeu_ps(&a[ 0], _mm256_add_ps(_mm256_loadu_ps(&a[ 0]), _mm256_mul_ps(_mm256_loadu_ps(&b[ 0]), k)));
+        _mm256_storeu_ps(&a[ 8], _mm256_add_ps(_mm256_loadu_ps(&a[ 8]), _mm256_mul_ps(_mm256_loadu_ps(&b[ 8]), k)));
+        _mm256_storeu_ps(&a[16], _mm256_add_ps(_mm256_loadu_ps(&a[16]), _mm256_mul_ps(_mm256_loadu_ps(&b[16]), k)));
+        _mm256_storeu_ps(&a[24], _mm256_add_ps(_mm256_loadu_ps(&a[24]), _mm256_mul_ps(_mm256_loadu_ps(&b[24]), k)));
+    }
+    else
+        _mm_store_ps(&a[0], _mm_add_ps(_mm_load_ps(&a[0]), _mm_mul_ps(_mm_load_ps(&b[0]), _mm_set1_ps(c))));
+#else
     const __m128 k = _mm_set_ps1(c);
 
     _mm_store_ps(&a[0], _mm_add_ps(_mm_load_ps(&a[0]), _mm_mul_ps(_mm_load_ps(&b[0]), k)));
 
-    if (DynamicSpectrum<float, 31>::size() > 3)
+    if (DynamicSpectrum<float, 31>::size() > 4)
     {
         _mm_store_ps(&a[ 4], _mm_add_ps(_mm_load_ps(&a[ 4]), _mm_mul_ps(_mm_load_ps(&b[ 4]), k)));
         _mm_store_ps(&a[ 8], _mm_add_ps(_mm_load_ps(&a[ 8]), _mm_mul_ps(_mm_load_ps(&b[ 8]), k)));
@@ -815,6 +1008,7 @@ APPLESEED_FORCE_INLINE void madd(
         _mm_store_ps(&a[24], _mm_add_ps(_mm_load_ps(&a[24]), _mm_mul_ps(_mm_load_ps(&b[24]), k)));
         _mm_store_ps(&a[28], _mm_add_ps(_mm_load_ps(&a[28]), _mm_mul_ps(_mm_load_ps(&b[28]), k)));
     }
+#endif
 }
 
 #endif  // APPLESEED_USE_SSE
@@ -824,6 +1018,19 @@ APPLESEED_FORCE_INLINE void madd(
 namespace foundation
 {
 
+#ifdef APPLESEED_USE_SSE
+
+template <>
+inline Color3f spectrum_to_ciexyz<float, renderer::DynamicSpectrum31f>(
+    const LightingConditions&                   lighting,
+    const renderer::DynamicSpectrum31f&         spectrum)
+{
+    // Only called in spectral mode, where all 32 stored samples are valid.
+    return spectrum31f_to_ciexyz(lighting, &spectrum[0]);
+}
+
+#endif  // APPLESEED_USE_SSE
+
 template <typename T, size_t N>
 inline bool is_zero(const renderer::DynamicSpectrum<T, N>& s)
 {
@@ -916,7 +1123,7 @@ APPLESEED_FORCE_INLINE renderer::DynamicSpectrum<float, 31> sqrt(const renderer:
 
     _mm_store_ps(&result[ 0], _mm_sqrt_ps(_mm_load_ps(&s[ 0])));
 
-    if (renderer::DynamicSpectrum<float, 31>::size() > 3)
+    if (renderer::DynamicSpectrum<float, 31>::size() > 4)
     {
         _mm_store_ps(&result[ 4], _mm_sqrt_ps(_mm_load_ps(&s[ 4])));
         _mm_store_ps(&result[ 8], _mm_sqrt_ps(_mm_load_ps(&s[ 8])));
@@ -1097,6 +1304,27 @@ APPLESEED_FORCE_INLINE renderer::DynamicSpectrum<float, 31> lerp(
 {
     renderer::DynamicSpectrum<float, 31> result;
 
+#ifdef APPLESEED_USE_AVX
+    if (renderer::DynamicSpectrum<float, 31>::size() > 4)
+    {
+        const __m256 one8 = _mm256_set1_ps(1.0f);
+
+        for (size_t i = 0; i < a.StoredSamples; i += 8)
+        {
+            const __m256 t8 = _mm256_loadu_ps(&t[i]);
+            const __m256 x = _mm256_mul_ps(_mm256_loadu_ps(&a[i]), _mm256_sub_ps(one8, t8));
+            const __m256 y = _mm256_mul_ps(_mm256_loadu_ps(&b[i]), t8);
+            _mm256_storeu_ps(&result[i], _mm256_add_ps(x, y));
+        }
+    }
+    else
+    {
+        const __m128 t4 = _mm_load_ps(&t[0]);
+        const __m128 x = _mm_mul_ps(_mm_load_ps(&a[0]), _mm_sub_ps(_mm_set1_ps(1.0f), t4));
+        const __m128 y = _mm_mul_ps(_mm_load_ps(&b[0]), t4);
+        _mm_store_ps(&result[0], _mm_add_ps(x, y));
+    }
+#else
     __m128 one4 = _mm_set1_ps(1.0f);
     __m128 t4 = _mm_load_ps(&t[0]);
     __m128 one_minus_t4 = _mm_sub_ps(one4, t4);
@@ -1104,7 +1332,7 @@ APPLESEED_FORCE_INLINE renderer::DynamicSpectrum<float, 31> lerp(
     __m128 y = _mm_mul_ps(_mm_load_ps(&b[0]), t4);
     _mm_store_ps(&result[0], _mm_add_ps(x, y));
 
-    if (renderer::DynamicSpectrum<float, 31>::size() > 3)
+    if (renderer::DynamicSpectrum<float, 31>::size() > 4)
     {
         for (size_t i = 4; i < a.StoredSamples; i += 4)
         {
@@ -1115,6 +1343,7 @@ APPLESEED_FORCE_INLINE renderer::DynamicSpectrum<float, 31> lerp(
             _mm_store_ps(&result[i], _mm_add_ps(x, y));
         }
     }
+#endif
 
     return result;
 }
@@ -1143,6 +1372,9 @@ inline float min_value(const renderer::DynamicSpectrum<float, 31>& s)
     if (renderer::DynamicSpectrum<float, 31>::size() == 3)
         return std::min(std::min(s[0], s[1]), s[2]);
 
+    if (renderer::DynamicSpectrum<float, 31>::size() == 4)
+        return std::min(std::min(s[0], s[1]), std::min(s[2], s[3]));
+
     const __m128 m1 = _mm_min_ps(_mm_load_ps(&s[ 0]), _mm_load_ps(&s[ 4]));
     const __m128 m2 = _mm_min_ps(_mm_load_ps(&s[ 8]), _mm_load_ps(&s[12]));
     const __m128 m3 = _mm_min_ps(_mm_load_ps(&s[16]), _mm_load_ps(&s[20]));
@@ -1182,6 +1414,9 @@ inline float max_value(const renderer::DynamicSpectrum<float, 31>& s)
     if (renderer::DynamicSpectrum<float, 31>::size() == 3)
         return std::max(std::max(s[0], s[1]), s[2]);
 
+    if (renderer::DynamicSpectrum<float, 31>::size() == 4)
+        return std::max(std::max(s[0], s[1]), std::max(s[2], s[3]));
+
     const __m128 m1 = _mm_max_ps(_mm_load_ps(&s[ 0]), _mm_load_ps(&s[ 4]));
     const __m128 m2 = _mm_max_ps(_mm_load_ps(&s[ 8]), _mm_load_ps(&s[12]));
     const __m128 m3 = _mm_max_ps(_mm_load_ps(&s[16]), _mm_load_ps(&s[20]));
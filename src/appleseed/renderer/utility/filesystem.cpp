@@ -60,4 +60,12 @@ void create_parent_directories(const char* file_path)
     create_parent_directories(bf::path(file_path));
 }
 
+std::string make_scratch_file_path(const std::string& directory)
+{
+    const bf::path base_path =
+        directory.empty() ? bf::temp_directory_path() : bf::path(directory);
+
+    return (base_path / bf::unique_path("appleseed-%%%%-%%%%-%%%%-%%%%.scratch")).string();
+}
+
 }       // namespace renderer
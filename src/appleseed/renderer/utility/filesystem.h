@@ -32,6 +32,9 @@
 // Boost headers.
 #include "boost/filesystem.hpp"
 
+// Standard headers.
+#include <string>
+
 namespace renderer
 {
 
@@ -39,6 +42,10 @@ void create_parent_directories(const boost::filesystem::path& file_path);
 
 void create_parent_directories(const char* file_path);
 
+// Return the path to a new, unique scratch file in a given directory.
+// The system's temporary directory is used if the directory is empty.
+std::string make_scratch_file_path(const std::string& directory);
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_UTILITY_FILESYSTEM_H
@@ -29,18 +29,53 @@
 // Interface header.
 #include "oiiomaketexture.h"
 
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/modeling/project/project.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/basegroup.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/texture/disktexture2d.h"
+#include "renderer/modeling/texture/texture.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/hash/siphash.h"
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/platform/system.h"
+#include "foundation/string/string.h"
+#include "foundation/utility/bufferedfile.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
+#include "foundation/utility/searchpaths.h"
+
 // OIIO headers.
 #include "foundation/platform/_beginoiioheaders.h"
 #include "OpenImageIO/imagebufalgo.h"
+#include "OpenImageIO/imageio.h"
 #include "foundation/platform/_endoiioheaders.h"
 
+// Boost headers.
+#include "boost/filesystem.hpp"
+#include "boost/system/error_code.hpp"
+
 // Standard headers.
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 using namespace foundation;
 using namespace OIIO;
+namespace bf = boost::filesystem;
 
 namespace renderer
 {
@@ -85,4 +120,282 @@ bool oiio_make_texture(
     return success;
 }
 
+namespace
+{
+    // Version of the texture conversion cache. Bump whenever the way files are converted
+    // changes, so that files converted by older versions are not reused.
+    const std::uint64_t TextureConversionCacheVersion = 1;
+
+    struct TextureConversion
+    {
+        std::string                             m_source_filepath;
+        std::string                             m_cache_directory;
+        std::string                             m_converted_filepath;
+        std::vector<std::pair<BaseGroup*, Texture*>> m_textures;
+        bool                                    m_needs_conversion;
+        bool                                    m_succeeded;
+        std::string                             m_error;
+    };
+
+    typedef std::map<std::string, TextureConversion> TextureConversionMap;
+
+    void collect_disk_textures(
+        BaseGroup&              group,
+        const SearchPaths&      search_paths,
+        const std::string&      cache_directory,
+        TextureConversionMap&   conversions)
+    {
+        for (Texture& texture : group.textures())
+        {
+            if (strcmp(texture.get_model(), DiskTexture2dFactory().get_model()) != 0 ||
+                !texture.get_parameters().strings().exist("filename"))
+                continue;
+
+            const std::string source_filepath =
+                to_string(search_paths.qualify(texture.get_parameters().get("filename")));
+
+            TextureConversion& conversion = conversions[source_filepath];
+            conversion.m_source_filepath = source_filepath;
+            conversion.m_cache_directory = cache_directory;
+            conversion.m_textures.emplace_back(&group, &texture);
+        }
+
+        for (Assembly& assembly : group.assemblies())
+            collect_disk_textures(assembly, search_paths, cache_directory, conversions);
+    }
+
+    // Return true if a file can be opened and is not both tiled and mipmapped.
+    bool needs_conversion(const std::string& filepath)
+    {
+        auto input = ImageInput::open(filepath);
+        if (!input)
+            return false;
+
+        ImageSpec spec = input->spec();
+        const bool tiled = spec.tile_width > 0;
+        const bool mipmapped = input->seek_subimage(0, 1, spec);
+        input->close();
+
+#if OIIO_VERSION < 20000
+        ImageInput::destroy(input);
+#endif
+
+        return !tiled || !mipmapped;
+    }
+
+    // Compute the name of the converted version of a file from its contents.
+    bool compute_converted_filename(const std::string& filepath, std::string& filename)
+    {
+        BufferedFile file(filepath.c_str(), BufferedFile::BinaryType, BufferedFile::ReadMode);
+
+        if (!file.is_open())
+            return false;
+
+        std::uint64_t key =
+            siphash24(&TextureConversionCacheVersion, sizeof(TextureConversionCacheVersion), 0, 0);
+
+        std::vector<char> buffer(1024 * 1024);
+        std::uint64_t chunk_index = 0;
+
+        while (true)
+        {
+            const size_t bytes = file.read(buffer.data(), buffer.size());
+            if (bytes == 0)
+                break;
+
+            key = siphash24(buffer.data(), bytes, key, chunk_index++);
+        }
+
+        std::stringstream sstr;
+        sstr << std::hex << std::setfill('0') << std::setw(16) << key << ".tx";
+        filename = sstr.str();
+
+        return true;
+    }
+
+    class TextureConversionJob
+      : public IJob
+    {
+      public:
+        explicit TextureConversionJob(TextureConversion& conversion)
+          : m_conversion(conversion)
+        {
+        }
+
+        void execute(const size_t thread_index) override
+        {
+            m_conversion.m_needs_conversion = needs_conversion(m_conversion.m_source_filepath);
+            if (!m_conversion.m_needs_conversion)
+            {
+                m_conversion.m_succeeded = true;
+                return;
+            }
+
+            std::string converted_filename;
+            if (!compute_converted_filename(m_conversion.m_source_filepath, converted_filename))
+            {
+                m_conversion.m_succeeded = false;
+                m_conversion.m_error = "failed to read the file";
+                return;
+            }
+
+            const bf::path converted_filepath =
+                bf::path(m_conversion.m_cache_directory) / converted_filename;
+            m_conversion.m_converted_filepath = converted_filepath.string();
+
+            // The file was already converted, maybe by another render or another machine.
+            boost::system::error_code ec;
+            if (bf::exists(converted_filepath, ec))
+            {
+                m_conversion.m_succeeded = true;
+                return;
+            }
+
+            RENDERER_LOG_INFO(
+                "converting texture file %s to %s...",
+                m_conversion.m_source_filepath.c_str(),
+                m_conversion.m_converted_filepath.c_str());
+
+            // Convert to a temporary file then rename it, so that other processes never see
+            // partially written files. Pixels are left untouched: the color space, channels
+            // and resolution of the texture remain valid.
+            const bf::path temp_filepath =
+                converted_filepath.string() + bf::unique_path(".%%%%-%%%%-%%%%.tmp").string();
+
+            const ImageSpec spec;
+            std::stringstream errors;
+            if (!ImageBufAlgo::make_texture(
+                    ImageBufAlgo::MakeTxTexture,
+                    m_conversion.m_source_filepath,
+                    temp_filepath.string(),
+                    spec,
+                    &errors))
+            {
+                bf::remove(temp_filepath, ec);
+                m_conversion.m_succeeded = false;
+                m_conversion.m_error = errors.str();
+                return;
+            }
+
+            bf::rename(temp_filepath, converted_filepath, ec);
+            if (ec)
+            {
+                bf::remove(temp_filepath, ec);
+                m_conversion.m_succeeded = bf::exists(converted_filepath, ec);
+                m_conversion.m_error = "failed to move the converted file to the cache directory";
+                return;
+            }
+
+            m_conversion.m_succeeded = true;
+        }
+
+      private:
+        TextureConversion& m_conversion;
+    };
+
+    void replace_texture(
+        BaseGroup&              group,
+        Texture*                texture,
+        const std::string&      converted_filepath,
+        const SearchPaths&      search_paths)
+    {
+        const std::string name = texture->get_name();
+
+        ParamArray params = texture->get_parameters();
+        params.insert("filename", converted_filepath);
+
+        auto_release_ptr<Texture> converted_texture(
+            DiskTexture2dFactory().create(name.c_str(), params, search_paths));
+
+        group.textures().remove(texture);
+        group.textures().insert(converted_texture);
+    }
+}
+
+bool convert_untiled_textures(
+    Project&                project,
+    const char*             cache_directory,
+    const size_t            thread_count)
+{
+    Scene* scene = project.get_scene();
+    if (scene == nullptr)
+        return true;
+
+    boost::system::error_code ec;
+    bf::create_directories(cache_directory, ec);
+    if (ec)
+    {
+        RENDERER_LOG_ERROR(
+            "failed to create texture cache directory %s: %s.",
+            cache_directory,
+            ec.message().c_str());
+        return false;
+    }
+
+    TextureConversionMap conversions;
+    collect_disk_textures(*scene, project.search_paths(), cache_directory, conversions);
+
+    if (conversions.empty())
+        return true;
+
+    // Inspect, hash and convert files in parallel.
+    {
+        JobQueue job_queue(JobQueue::CentralizedScheduling);
+
+        for (auto& entry : conversions)
+            job_queue.schedule(new TextureConversionJob(entry.second));
+
+        JobManager job_manager(
+            global_logger(),
+            job_queue,
+            std::min(
+                thread_count > 0 ? thread_count : System::get_logical_cpu_core_count(),
+                conversions.size()));
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+    }
+
+    bool success = true;
+    size_t converted_file_count = 0;
+
+    for (const auto& entry : conversions)
+    {
+        const TextureConversion& conversion = entry.second;
+
+        if (!conversion.m_needs_conversion)
+            continue;
+
+        if (!conversion.m_succeeded)
+        {
+            RENDERER_LOG_ERROR(
+                "failed to convert texture file %s: %s",
+                conversion.m_source_filepath.c_str(),
+                trim_both(conversion.m_error).c_str());
+            success = false;
+            continue;
+        }
+
+        for (const auto& texture : conversion.m_textures)
+        {
+            replace_texture(
+                *texture.first,
+                texture.second,
+                conversion.m_converted_filepath,
+                project.search_paths());
+        }
+
+        ++converted_file_count;
+    }
+
+    RENDERER_LOG_INFO(
+        "%s of %s texture %s now tiled and mipmapped in %s.",
+        pretty_uint(converted_file_count).c_str(),
+        pretty_uint(conversions.size()).c_str(),
+        conversions.size() > 1 ? "files" : "file",
+        cache_directory);
+
+    return success;
+}
+
 }
@@ -34,6 +34,12 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace renderer  { class Project; }
+
 namespace renderer
 {
 
@@ -44,4 +50,15 @@ APPLESEED_DLLSYMBOL bool oiio_make_texture(
     const char*             out_depth,
     foundation::APIString&  error_msg);
 
+// Convert the files of the disk textures of a project that are not tiled or not mipmapped
+// to tiled, mipmapped .tx files, using thread_count threads (0 for one per core), and make
+// the textures use the converted files. Converted files are stored in cache_directory under
+// a name derived from the contents of the source file, so that the directory can be shared
+// by successive and concurrent renders, including on other machines. Return false if some
+// files could not be converted; textures using these files are left untouched.
+APPLESEED_DLLSYMBOL bool convert_untiled_textures(
+    Project&                project,
+    const char*             cache_directory,
+    const size_t            thread_count = 0);
+
 }
@@ -84,6 +84,13 @@ class RGBSpectrum
     // Return the number of active color channels for the current spectrum mode.
     static size_t size();
 
+    // Return the index of the band stored in the first active color channel.
+    static size_t get_band_offset();
+
+    // Return the inverse of the probability that the active color channels are the ones
+    // carried by the current path.
+    static ValueType get_band_weight();
+
     // Constructors.
 #ifdef APPLESEED_USE_SSE
     RGBSpectrum();                                          // leave all components uninitialized
@@ -293,6 +300,18 @@ inline size_t RGBSpectrum<T>::size()
     return 3;
 }
 
+template <typename T>
+inline size_t RGBSpectrum<T>::get_band_offset()
+{
+    return 0;
+}
+
+template <typename T>
+inline T RGBSpectrum<T>::get_band_weight()
+{
+    return T(1.0);
+}
+
 #ifdef APPLESEED_USE_SSE
 
 template <typename T>
@@ -37,6 +37,7 @@
 #include "foundation/containers/dictionary.h"
 #include "foundation/platform/system.h"
 #include "foundation/string/string.h"
+#include "foundation/utility/job/jobmanager.h"
 #include "foundation/utility/makevector.h"
 
 // Standard headers.
@@ -67,19 +68,20 @@ Spectrum::Mode get_spectrum_mode(const ParamArray& params)
         params.get_required<std::string>(
             "spectrum_mode",
             "rgb",
-            make_vector("rgb", "spectral"));
+            make_vector("rgb", "spectral", "hero_wavelength"));
 
 #ifdef APPLESEED_WITH_SPECTRAL_SUPPORT
     return
-        spectrum_mode == "rgb"
-            ? Spectrum::RGB
-            : Spectrum::Spectral;
+        spectrum_mode == "rgb" ? Spectrum::RGB :
+        spectrum_mode == "spectral" ? Spectrum::Spectral :
+        Spectrum::HeroWavelength;
 #else
-    if (spectrum_mode == "spectral")
+    if (spectrum_mode != "rgb")
     {
         RENDERER_LOG_WARNING(
-            "color pipeline set the \"spectral\" but spectral color support "
-            "was not enabled when building appleseed; rgb will be used instead");
+            "color pipeline set the \"%s\" but spectral color support "
+            "was not enabled when building appleseed; rgb will be used instead",
+            spectrum_mode.c_str());
     }
 
     return Spectrum::RGB;
@@ -93,6 +95,7 @@ std::string get_spectrum_mode_name(const Spectrum::Mode mode)
     {
       case Spectrum::RGB: return "rgb";
       case Spectrum::Spectral: return "spectral";
+      case Spectrum::HeroWavelength: return "hero wavelength";
       default: return "unknown";
     }
 #else
@@ -100,18 +103,27 @@ std::string get_spectrum_mode_name(const Spectrum::Mode mode)
 #endif
 }
 
+Spectrum::Mode get_shared_data_spectrum_mode(const Spectrum::Mode mode)
+{
+#ifdef APPLESEED_WITH_SPECTRAL_SUPPORT
+    return mode == Spectrum::HeroWavelength ? Spectrum::Spectral : mode;
+#else
+    return mode;
+#endif
+}
+
 SamplingContext::Mode get_sampling_context_mode(const ParamArray& params)
 {
     const std::string sampling_mode =
         params.get_required<std::string>(
             "sampling_mode",
             "qmc",
-            make_vector("rng", "qmc"));
+            make_vector("rng", "qmc", "sobol"));
 
     return
-        sampling_mode == "rng"
-            ? SamplingContext::RNGMode
-            : SamplingContext::QMCMode;
+        sampling_mode == "rng"   ? SamplingContext::RNGMode :
+        sampling_mode == "sobol" ? SamplingContext::SobolMode :
+                                   SamplingContext::QMCMode;
 }
 
 std::string get_sampling_context_mode_name(const SamplingContext::Mode mode)
@@ -120,6 +132,7 @@ std::string get_sampling_context_mode_name(const SamplingContext::Mode mode)
     {
       case SamplingContext::RNGMode: return "rng";
       case SamplingContext::QMCMode: return "qmc";
+      case SamplingContext::SobolMode: return "sobol";
       default: return "unknown";
     }
 }
@@ -171,4 +184,26 @@ size_t get_rendering_thread_count(const ParamArray& params)
     return thread_count;
 }
 
+int get_rendering_thread_affinity_flags(const ParamArray& params)
+{
+    const std::string affinity =
+        params.get_optional<std::string>(
+            "rendering_thread_affinity",
+            "none",
+            make_vector("none", "core", "numa_node"));
+
+    return
+        affinity == "core" ? JobManager::PinThreadsToCPUCores :
+        affinity == "numa_node" ? JobManager::PinThreadsToNUMANodes :
+        0;
+}
+
+std::string get_rendering_thread_affinity_name(const int flags)
+{
+    return
+        (flags & JobManager::PinThreadsToCPUCores) ? "core" :
+        (flags & JobManager::PinThreadsToNUMANodes) ? "numa_node" :
+        "none";
+}
+
 }   // namespace renderer
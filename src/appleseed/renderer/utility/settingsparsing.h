@@ -51,6 +51,10 @@ std::string get_render_device(const ParamArray& params);
 APPLESEED_DLLSYMBOL Spectrum::Mode get_spectrum_mode(const ParamArray& params);
 std::string get_spectrum_mode_name(const Spectrum::Mode mode);
 
+// Spectrum mode of the threads computing data shared by all paths, such as uniform
+// input values or photons: spectral in hero wavelength mode, `mode` otherwise.
+Spectrum::Mode get_shared_data_spectrum_mode(const Spectrum::Mode mode);
+
 // Sampling mode.
 APPLESEED_DLLSYMBOL SamplingContext::Mode get_sampling_context_mode(const ParamArray& params);
 std::string get_sampling_context_mode_name(const SamplingContext::Mode mode);
@@ -58,4 +62,8 @@ std::string get_sampling_context_mode_name(const SamplingContext::Mode mode);
 // Rendering threads.
 APPLESEED_DLLSYMBOL size_t get_rendering_thread_count(const ParamArray& params);
 
+// Rendering thread affinity, as a combination of foundation::JobManager::Flags.
+int get_rendering_thread_affinity_flags(const ParamArray& params);
+std::string get_rendering_thread_affinity_name(const int flags);
+
 }   // namespace renderer
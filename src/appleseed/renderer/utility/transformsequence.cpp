@@ -54,6 +54,7 @@ TransformSequence::TransformSequence()
   , m_interpolators(nullptr)
   , m_can_swap_handedness(false)
   , m_all_swap_handedness(false)
+  , m_version(0)
 {
 }
 
@@ -69,6 +70,7 @@ TransformSequence::TransformSequence(TransformSequence&& rhs) APPLESEED_NOEXCEPT
   , m_interpolators(rhs.m_interpolators)
   , m_can_swap_handedness(rhs.m_can_swap_handedness)
   , m_all_swap_handedness(rhs.m_all_swap_handedness)
+  , m_version(rhs.m_version)
 {
     rhs.m_keys = nullptr;
     rhs.m_interpolators = nullptr;
@@ -93,6 +95,7 @@ TransformSequence& TransformSequence::operator=(TransformSequence&& rhs) APPLESE
     std::swap(m_interpolators, rhs.m_interpolators);
     m_can_swap_handedness = rhs.m_can_swap_handedness;
     m_all_swap_handedness = rhs.m_all_swap_handedness;
+    m_version = rhs.m_version;
     rhs.clear();
     return *this;
 }
@@ -207,6 +210,8 @@ bool TransformSequence::prepare()
     delete[] m_interpolators;
     m_interpolators = nullptr;
 
+    m_version = new_guid();
+
     bool success = true;
 
     if (m_size > 1)
@@ -326,6 +331,7 @@ void TransformSequence::copy_from(const TransformSequence& rhs)
 
     m_can_swap_handedness = rhs.m_can_swap_handedness;
     m_all_swap_handedness = rhs.m_all_swap_handedness;
+    m_version = rhs.m_version;
 }
 
 void TransformSequence::interpolate(
@@ -30,9 +30,13 @@
 #pragma once
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/hash/hash.h"
 #include "foundation/math/aabb.h"
 #include "foundation/math/transform.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/utility/casts.h"
+#include "foundation/utility/uid.h"
 
 // appleseed.main headers.
 #include "main/dllsymbol.h"
@@ -40,6 +44,7 @@
 // Standard headers.
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 
 namespace renderer
 {
@@ -99,6 +104,10 @@ class APPLESEED_DLLSYMBOL TransformSequence
     // Returns true on success, false otherwise.
     bool prepare();
 
+    // Return an identifier for the current state of the sequence. A new identifier is
+    // assigned each time prepare() is called; copies of a sequence share its identifier.
+    foundation::UniqueID get_version() const;
+
     // Return true if at least one of the transforms in the sequence swaps the handedness.
     // This method can only be called after prepare() has been called.
     bool can_swap_handedness() const;
@@ -143,6 +152,7 @@ class APPLESEED_DLLSYMBOL TransformSequence
     foundation::TransformInterpolatord* m_interpolators;
     bool                                m_can_swap_handedness;
     bool                                m_all_swap_handedness;
+    foundation::UniqueID                m_version;
 
     void copy_from(const TransformSequence& rhs);
 
@@ -157,6 +167,52 @@ class APPLESEED_DLLSYMBOL TransformSequence
 };
 
 
+//
+// A small direct-mapped cache of interpolated transforms, keyed by sequence and time.
+//
+// All the rays of a given path share the same time value, so with motion blur the
+// same assembly instances are entered at the same time over and over again. This
+// cache avoids interpolating their transforms repeatedly. It is not thread-safe:
+// each rendering thread must own its own instance.
+//
+
+class TransformSequenceCache
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    TransformSequenceCache();
+
+    // Equivalent to sequence.evaluate(time, scratch), except that interpolated
+    // transforms are retrieved from the cache whenever possible. The returned
+    // reference remains valid until the next call to evaluate() or clear().
+    const foundation::Transformd& evaluate(
+        const TransformSequence&        sequence,
+        const float                     time);
+
+    // Remove all entries from the cache.
+    void clear();
+
+    // Return cache performance statistics.
+    std::uint64_t get_hit_count() const;
+    std::uint64_t get_miss_count() const;
+
+  private:
+    enum { Lines = 16 };
+
+    struct Line
+    {
+        foundation::UniqueID            m_version;
+        float                           m_time;
+        foundation::Transformd          m_transform;
+    };
+
+    Line                                m_lines[Lines];
+    std::uint64_t                       m_hit_count;
+    std::uint64_t                       m_miss_count;
+};
+
+
 //
 // TransformSequence class implementation.
 //
@@ -176,6 +232,11 @@ inline bool TransformSequence::can_swap_handedness() const
     return m_can_swap_handedness;
 }
 
+inline foundation::UniqueID TransformSequence::get_version() const
+{
+    return m_version;
+}
+
 inline foundation::Transformd TransformSequence::evaluate(const float time) const
 {
     foundation::Transformd scratch;
@@ -235,4 +296,69 @@ foundation::AABB<T, 3> TransformSequence::to_parent(const foundation::AABB<T, 3>
     return result;
 }
 
+
+//
+// TransformSequenceCache class implementation.
+//
+
+inline TransformSequenceCache::TransformSequenceCache()
+{
+    clear();
+}
+
+inline const foundation::Transformd& TransformSequenceCache::evaluate(
+    const TransformSequence&            sequence,
+    const float                         time)
+{
+    // Static and empty sequences are not worth caching.
+    if (sequence.size() < 2)
+        return sequence.evaluate(time, m_lines[0].m_transform);
+
+    const foundation::UniqueID version = sequence.get_version();
+    const std::uint64_t h =
+        foundation::mix_uint64(version, foundation::binary_cast<std::uint32_t>(time));
+    Line& line = m_lines[h % Lines];
+
+    if (line.m_version == version && line.m_time == time)
+    {
+        ++m_hit_count;
+        return line.m_transform;
+    }
+
+    ++m_miss_count;
+
+    // The line gets overwritten: invalidate it until we know the result is cacheable.
+    line.m_version = ~foundation::UniqueID(0);
+
+    const foundation::Transformd& result = sequence.evaluate(time, line.m_transform);
+
+    // Transforms at or beyond the end keys are returned by reference and need no caching.
+    if (&result == &line.m_transform)
+    {
+        line.m_version = version;
+        line.m_time = time;
+    }
+
+    return result;
+}
+
+inline void TransformSequenceCache::clear()
+{
+    for (size_t i = 0; i < Lines; ++i)
+        m_lines[i].m_version = ~foundation::UniqueID(0);
+
+    m_hit_count = 0;
+    m_miss_count = 0;
+}
+
+inline std::uint64_t TransformSequenceCache::get_hit_count() const
+{
+    return m_hit_count;
+}
+
+inline std::uint64_t TransformSequenceCache::get_miss_count() const
+{
+    return m_miss_count;
+}
+
 }   // namespace renderer